@@ -506,6 +506,28 @@ class Cursor(Structure):
         Cursor_visit(self, Cursor_visit_callback(visitor), children)
         return iter(children)
 
+    def export_tree(self):
+        """
+        Return the cursors of the subtree rooted at this cursor as a list of
+        CursorTreeNode objects, this cursor first and the others in the order
+        in which a recursive walk of get_children() would visit them.
+
+        The whole subtree is gathered by one call into CIndex, which is much
+        faster than querying it one cursor at a time.
+        """
+        tree = Cursor_export_tree(self)
+        if not tree:
+            return []
+        try:
+            count = CursorTree_num_nodes(tree)
+            nodes = CursorTree_nodes(tree)
+            size = c_uint()
+            strings = string_at(CursorTree_strings(tree, byref(size)),
+                                size.value)
+            return [CursorTreeNode(nodes[i], strings) for i in xrange(count)]
+        finally:
+            CursorTree_dispose(tree)
+
     @staticmethod
     def from_result(res, fn, args):
         assert isinstance(res, Cursor)
@@ -514,6 +536,38 @@ class Cursor(Structure):
             return None
         return res
 
+class _CXCursorTreeNode(Structure):
+    """Helper for reading the nodes of an exported cursor tree."""
+
+    _fields_ = [("kind", c_int), ("parent", c_uint), ("usr", c_uint),
+                ("spelling", c_uint), ("file", c_uint),
+                ("begin_line", c_uint), ("begin_column", c_uint),
+                ("begin_offset", c_uint), ("end_line", c_uint),
+                ("end_column", c_uint), ("end_offset", c_uint)]
+
+class CursorTreeNode(object):
+    """
+    A CursorTreeNode describes one cursor of a tree returned by
+    Cursor.export_tree(). The extent is given by the file name and the
+    (line, column, offset) of its start and of its end.
+    """
+
+    def __init__(self, node, strings):
+        def string(offset):
+            return strings[offset:strings.index('\0', offset)]
+
+        self.kind = CursorKind.from_id(node.kind)
+        self.parent = None if node.parent == 0xFFFFFFFF else node.parent
+        self.usr = string(node.usr)
+        self.spelling = string(node.spelling)
+        self.file = string(node.file) if node.file else None
+        self.start = (node.begin_line, node.begin_column, node.begin_offset)
+        self.end = (node.end_line, node.end_column, node.end_offset)
+
+    def __repr__(self):
+        return "<CursorTreeNode %s %r, parent %r>" % (self.kind, self.spelling,
+                                                      self.parent)
+
 ## CIndex Objects ##
 
 # CIndex objects (derived from ClangObject) are essentially lightweight
@@ -874,6 +928,25 @@ Cursor_visit = lib.clang_visitChildren
 Cursor_visit.argtypes = [Cursor, Cursor_visit_callback, py_object]
 Cursor_visit.restype = c_uint
 
+Cursor_export_tree = lib.clang_exportCursorTree
+Cursor_export_tree.argtypes = [Cursor]
+Cursor_export_tree.restype = c_void_p
+
+CursorTree_num_nodes = lib.clang_getCursorTreeNumNodes
+CursorTree_num_nodes.argtypes = [c_void_p]
+CursorTree_num_nodes.restype = c_uint
+
+CursorTree_nodes = lib.clang_getCursorTreeNodes
+CursorTree_nodes.argtypes = [c_void_p]
+CursorTree_nodes.restype = POINTER(_CXCursorTreeNode)
+
+CursorTree_strings = lib.clang_getCursorTreeStrings
+CursorTree_strings.argtypes = [c_void_p, POINTER(c_uint)]
+CursorTree_strings.restype = c_void_p
+
+CursorTree_dispose = lib.clang_disposeCursorTree
+CursorTree_dispose.argtypes = [c_void_p]
+
 # Index Functions
 Index_create = lib.clang_createIndex
 Index_create.argtypes = [c_int]
@@ -930,4 +1003,5 @@ File_time.restype = c_uint
 ###
 
 __all__ = ['Index', 'TranslationUnit', 'Cursor', 'CursorKind',
-           'Diagnostic', 'FixIt', 'SourceRange', 'SourceLocation', 'File']
+           'CursorTreeNode', 'Diagnostic', 'FixIt', 'SourceRange',
+           'SourceLocation', 'File']
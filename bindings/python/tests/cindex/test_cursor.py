@@ -57,3 +57,22 @@ def test_get_children():
     assert tu_nodes[2].kind == CursorKind.FUNCTION_DECL
     assert tu_nodes[2].spelling == 'f0'
     assert tu_nodes[2].is_definition() == True
+
+def test_export_tree():
+    index = Index.create()
+    tu = index.parse('t.c', unsaved_files = [('t.c',kInput)])
+
+    nodes = tu.cursor.export_tree()
+    assert nodes[0].kind == CursorKind.TRANSLATION_UNIT
+    assert nodes[0].parent is None
+
+    s0 = [i for i, n in enumerate(nodes) if n.spelling == 's0'][0]
+    assert nodes[s0].kind == CursorKind.STRUCT_DECL
+    assert nodes[s0].parent == 0
+    assert nodes[s0].file == 't.c'
+    assert nodes[s0].start[:2] == (4, 1)
+
+    fields = [n for n in nodes if n.parent == s0]
+    assert [n.spelling for n in fields] == ['a', 'b']
+    assert fields[0].kind == CursorKind.FIELD_DECL
+    assert fields[0].usr != '' and fields[0].usr != fields[1].usr
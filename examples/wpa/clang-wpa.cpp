@@ -16,6 +16,7 @@
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Index/CallEdges.h"
 #include "clang/Index/CallGraph.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
@@ -23,7 +24,31 @@ using namespace clang;
 using namespace idx;
 
 static llvm::cl::list<std::string>
-InputFilenames(llvm::cl::Positional, llvm::cl::desc("<input AST files>"));
+InputFilenames(llvm::cl::Positional, llvm::cl::desc("<input files>"));
+
+static llvm::cl::opt<bool>
+EmitCallEdges("emit-call-edges",
+              llvm::cl::desc("Write the call edges of each input AST file to "
+                             "<input>.cge"));
+
+static llvm::cl::opt<bool>
+MergeCallEdges("merge-call-edges",
+               llvm::cl::desc("Merge the input call edge files into the call "
+                              "graph given by -o"));
+
+static llvm::cl::opt<std::string>
+FindCallers("find-callers",
+            llvm::cl::desc("Print the callers of the given function in the "
+                           "input call graph"),
+            llvm::cl::value_desc("name"));
+
+static llvm::cl::opt<std::string>
+OutputFilename("o", llvm::cl::desc("Output file"),
+               llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<unsigned>
+NumThreads("j", llvm::cl::desc("Number of threads used to merge call edges"),
+           llvm::cl::init(1));
 
 int main(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(argc, argv, "clang-wpa");
@@ -33,10 +58,64 @@ int main(int argc, char **argv) {
   if (InputFilenames.empty())
     return 0;
 
+  if (MergeCallEdges) {
+    if (OutputFilename.empty()) {
+      llvm::errs() << "error: -merge-call-edges requires -o\n";
+      return 1;
+    }
+
+    std::string ErrorInfo;
+    if (MergeCallEdgeFiles(InputFilenames, OutputFilename, NumThreads,
+                           ErrorInfo)) {
+      llvm::errs() << "error: " << ErrorInfo << '\n';
+      return 1;
+    }
+    return 0;
+  }
+
+  if (!FindCallers.empty()) {
+    std::string ErrorInfo;
+    llvm::OwningPtr<PersistentCallGraph> G(
+      PersistentCallGraph::Load(InputFilenames[0], ErrorInfo));
+    if (!G) {
+      llvm::errs() << "error: '" << InputFilenames[0] << "': " << ErrorInfo
+                   << '\n';
+      return 1;
+    }
+
+    unsigned F;
+    if (!G->lookup(FindCallers, F)) {
+      llvm::errs() << "error: no function named '" << FindCallers << "'\n";
+      return 1;
+    }
+    for (unsigned i = 0, e = G->getNumCallers(F); i != e; ++i)
+      llvm::outs() << G->getName(G->getCaller(F, i)) << '\n';
+    return 0;
+  }
+
   DiagnosticOptions DiagOpts;
   llvm::OwningPtr<Diagnostic> Diags(
     CompilerInstance::createDiagnostics(DiagOpts, argc, argv));
 
+  if (EmitCallEdges) {
+    // Only one AST is loaded at a time.
+    for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
+      const std::string &InFile = InputFilenames[i];
+      llvm::OwningPtr<ASTUnit> AST(ASTUnit::LoadFromPCHFile(InFile, *Diags));
+      if (!AST)
+        return 1;
+
+      CallEdgeWriter Writer;
+      Writer.addTU(AST->getASTContext());
+      std::string ErrorInfo;
+      if (Writer.write(InFile + ".cge", ErrorInfo)) {
+        llvm::errs() << "error: " << ErrorInfo << '\n';
+        return 1;
+      }
+    }
+    return 0;
+  }
+
   for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
     const std::string &InFile = InputFilenames[i];
     llvm::OwningPtr<ASTUnit> AST(ASTUnit::LoadFromPCHFile(InFile, *Diags));
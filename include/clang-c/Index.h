@@ -130,6 +130,46 @@ CINDEX_LINKAGE const char *clang_getCString(CXString string);
  */
 CINDEX_LINKAGE void clang_disposeString(CXString string);
 
+/**
+ * \brief An arena from which the strings returned by the clang_ functions can
+ * be allocated, so that they are released together.
+ */
+typedef void *CXStringArena;
+
+/**
+ * \brief Create an empty string arena.
+ */
+CINDEX_LINKAGE CXStringArena clang_createStringArena(void);
+
+/**
+ * \brief Allocate the strings that the clang_ functions return to the
+ * calling thread from \p arena, or, if \p arena is NULL, allocate each of
+ * them separately again.
+ *
+ * While an arena is installed, the strings that need storage of their own
+ * are carved from it rather than allocated one at a time, and
+ * clang_disposeString() does nothing for them.  They remain valid until the
+ * arena is reset or disposed.  Other threads are not affected.
+ *
+ * \returns the arena that was installed on the calling thread before.
+ */
+CINDEX_LINKAGE CXStringArena clang_setStringArena(CXStringArena arena);
+
+/**
+ * \brief Release all of the strings allocated from \p arena at once, keeping
+ * its memory for the strings allocated next.
+ */
+CINDEX_LINKAGE void clang_resetStringArena(CXStringArena arena);
+
+/**
+ * \brief Release \p arena and all of the strings allocated from it.
+ *
+ * If \p arena is installed on the calling thread, it is uninstalled first.
+ * Any other thread that \p arena is installed on must uninstall it with
+ * clang_setStringArena() before it is disposed.
+ */
+CINDEX_LINKAGE void clang_disposeStringArena(CXStringArena arena);
+
 /**
  * @}
  */
@@ -170,6 +210,13 @@ CINDEX_LINKAGE void clang_disposeString(CXString string);
  * This process of creating the 'pch', loading it separately, and using it (via
  * -include-pch) allows 'excludeDeclsFromPCH' to remove redundant callbacks
  * (which gives the indexer the same performance benefit as the compiler).
+ *
+ * Threading: translation units can be created from one index on several
+ * threads at once, and each one can then be used on any thread.  The options
+ * of an index must be set before it is shared between threads.  A
+ * translation unit, with the cursors, strings, tokens and diagnostics
+ * obtained from it, must only be used by one thread at a time.  Indexes must
+ * not be created or destroyed while another thread uses the library.
  */
 CINDEX_LINKAGE CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
                                          int displayDiagnostics);
@@ -194,6 +241,33 @@ CINDEX_LINKAGE void clang_disposeIndex(CXIndex index);
  */
 CINDEX_LINKAGE void clang_setUseExternalASTGeneration(CXIndex index,
                                                       int value);
+
+/**
+ * \brief Request that translation units created from source files skip over
+ * the bodies of function definitions instead of parsing them.
+ *
+ * This is much faster when only declarations are needed, e.g. for indexing.
+ * Skipped functions get an empty body.
+ *
+ * \param index - The index to update.
+ * \param value - The new flag value.
+ */
+CINDEX_LINKAGE void clang_setSkipFunctionBodies(CXIndex index, int value);
+
+/**
+ * \brief Request that translation units created from source files precompile
+ * the preamble of their main file, the comments and preprocessor directives
+ * it starts with, so that clang_reparseTranslationUnit() only has to parse
+ * the rest of the main file again.
+ *
+ * The precompiled preamble is kept in a temporary file for as long as the
+ * translation unit lives, and is rebuilt when the preamble or one of the
+ * files it includes changes.
+ *
+ * \param index - The index to update.
+ * \param value - The new flag value.
+ */
+CINDEX_LINKAGE void clang_setPrecompilePreamble(CXIndex index, int value);
 /**
  * \defgroup CINDEX_FILES File manipulation routines
  *
@@ -625,6 +699,50 @@ CINDEX_LINKAGE CXString
 clang_getDiagnosticFixItReplacement(CXDiagnostic Diagnostic, unsigned FixIt,
                                     CXSourceRange *Range);
 
+/**
+ * \brief A queue onto which the diagnostics of translation units are
+ * streamed while they are parsed.
+ */
+typedef void *CXDiagnosticQueue;
+
+/**
+ * \brief Create an empty diagnostic queue.
+ */
+CINDEX_LINKAGE CXDiagnosticQueue clang_createDiagnosticQueue(void);
+
+/**
+ * \brief Destroy a diagnostic queue and the diagnostics taken from it.  No
+ * translation unit may be being created from an index that uses the queue.
+ */
+CINDEX_LINKAGE void clang_disposeDiagnosticQueue(CXDiagnosticQueue Queue);
+
+/**
+ * \brief Stream the diagnostics of the translation units created from source
+ * with \p CIdx onto \p Queue, or, if \p Queue is NULL, stop doing so.
+ *
+ * Each diagnostic is pushed onto the queue as soon as it is produced, from
+ * the thread that parses the translation unit, whether the translation unit
+ * is parsed in-process or by an external clang process.  Translation units
+ * created on several threads may share a queue; pushing does not take a
+ * lock.  The diagnostics are still reported through the translation unit as
+ * well.
+ */
+CINDEX_LINKAGE void clang_setDiagnosticQueue(CXIndex CIdx,
+                                             CXDiagnosticQueue Queue);
+
+/**
+ * \brief Take the next diagnostic pushed onto \p Queue.
+ *
+ * Diagnostics are taken in the order they were produced within each
+ * translation unit.  Only one thread at a time may take diagnostics from a
+ * queue.
+ *
+ * \returns the diagnostic, which must be released with
+ * clang_disposeDiagnostic() and remains valid until the queue is disposed,
+ * or NULL if no diagnostic is ready.
+ */
+CINDEX_LINKAGE CXDiagnostic clang_takeQueuedDiagnostic(CXDiagnosticQueue Queue);
+
 /**
  * @}
  */
@@ -697,6 +815,85 @@ CINDEX_LINKAGE CXTranslationUnit clang_createTranslationUnit(CXIndex,
  * \brief Destroy the specified CXTranslationUnit object.
  */
 CINDEX_LINKAGE void clang_disposeTranslationUnit(CXTranslationUnit);
+
+/**
+ * \brief Parse a translation unit created from a source file again, from the
+ * files as they are now.
+ *
+ * The unsaved files are parsed from memory; they are never written to disk.
+ * Files that did not change since the previous parse are not read again.
+ * All cursors, source locations and diagnostics obtained from the translation
+ * unit before it was reparsed are invalidated.
+ *
+ * \param TU - The translation unit to reparse.
+ *
+ * \param num_unsaved_files - The number of unsaved file entries in
+ * \p unsaved_files.
+ *
+ * \param unsaved_files - The files that have not yet been saved to disk but
+ * may be required for parsing, including the contents of those files.
+ *
+ * \returns zero on success; nonzero if the translation unit could not be
+ * parsed, in which case it must be disposed of.
+ */
+CINDEX_LINKAGE int clang_reparseTranslationUnit(CXTranslationUnit TU,
+                                                unsigned num_unsaved_files,
+                                         struct CXUnsavedFile *unsaved_files);
+
+/**
+ * \brief Determine how many of the calls to clang_reparseTranslationUnit()
+ * only had to parse the body of one function again, because the changes to
+ * the main file were all within that body.
+ */
+CINDEX_LINKAGE unsigned clang_getNumFunctionBodyReparses(CXTranslationUnit TU);
+
+/**
+ * \brief The parts of a translation unit whose memory use is reported by
+ * clang_getTranslationUnitMemoryUsage().
+ */
+enum CXTUMemoryUsageKind {
+  /** \brief AST nodes and the lists of top-level declarations. */
+  CXTUMemoryUsage_AST = 1,
+  /** \brief The contents of the source files and memory buffers. */
+  CXTUMemoryUsage_SourceFiles = 2,
+  /** \brief The line number tables computed for the source files. */
+  CXTUMemoryUsage_LineTables = 3,
+  /** \brief The tables of the source locations of files and macros. */
+  CXTUMemoryUsage_SourceManager = 4,
+  /** \brief Macro definitions and the token caches of the preprocessor. */
+  CXTUMemoryUsage_Preprocessor = 5,
+  /** \brief The precompiled header the AST is read from, and its tables. */
+  CXTUMemoryUsage_PCH = 6,
+  /** \brief The diagnostics stored with the translation unit. */
+  CXTUMemoryUsage_Diagnostics = 7,
+
+  CXTUMemoryUsage_First = CXTUMemoryUsage_AST,
+  CXTUMemoryUsage_Last = CXTUMemoryUsage_Diagnostics
+};
+
+/**
+ * \brief Return the number of bytes used by one part of a translation unit.
+ */
+CINDEX_LINKAGE unsigned long
+clang_getTranslationUnitMemoryUsage(CXTranslationUnit TU,
+                                    enum CXTUMemoryUsageKind kind);
+
+/**
+ * \brief Retrieve a name for a kind of memory use of a translation unit.
+ */
+CINDEX_LINKAGE CXString
+clang_getTUMemoryUsageKindSpelling(enum CXTUMemoryUsageKind kind);
+
+/**
+ * \brief Free the memory of the caches of a translation unit that are
+ * rebuilt when they are next needed, such as line number tables and the
+ * preprocessor's token caches.
+ *
+ * This also drops the diagnostics stored with the translation unit:
+ * clang_getNumDiagnostics() returns zero afterwards, and the diagnostics
+ * obtained before must not be used.
+ */
+CINDEX_LINKAGE void clang_trimTranslationUnitMemory(CXTranslationUnit TU);
  
 /**
  * @}
@@ -1085,6 +1282,122 @@ CINDEX_LINKAGE unsigned clang_visitChildren(CXCursor parent,
                                             CXCursorVisitor visitor,
                                             CXClientData client_data);
 
+/**
+ * \brief Visit the top-level declarations that lexically appear in one file
+ * of a translation unit.
+ *
+ * This behaves like clang_visitChildren() on the translation unit cursor,
+ * except that only the declarations written in \p file are visited, one
+ * inclusion of the file after the other.  It does not go through the
+ * declarations of the other files, so it is much faster for showing the
+ * outline of a file.
+ *
+ * \param tu the translation unit.
+ *
+ * \param file the file whose declarations are visited.
+ *
+ * \param visitor the visitor function that will be invoked for each
+ * declaration.
+ *
+ * \param client_data pointer data supplied by the client, which will
+ * be passed to the visitor each time it is invoked.
+ *
+ * \returns a non-zero value if the traversal was terminated
+ * prematurely by the visitor returning \c CXChildVisit_Break.
+ */
+CINDEX_LINKAGE unsigned clang_visitChildrenInFile(CXTranslationUnit tu,
+                                                  CXFile file,
+                                                  CXCursorVisitor visitor,
+                                                  CXClientData client_data);
+
+/**
+ * \brief A cursor of a tree exported by clang_exportCursorTree().
+ *
+ * Strings are given as offsets into the string table of the tree, which
+ * holds NUL-terminated strings; offset zero is the empty string.
+ */
+typedef struct {
+  /**
+   * \brief The kind of the cursor.
+   */
+  enum CXCursorKind kind;
+
+  /**
+   * \brief The index of the parent of the cursor in the tree, or
+   * (unsigned)-1 for the root.
+   */
+  unsigned parent;
+
+  /**
+   * \brief The offsets of the USR and of the spelling of the cursor.  Only
+   * declarations have a USR.
+   */
+  unsigned usr;
+  unsigned spelling;
+
+  /**
+   * \brief The offset of the name of the file that contains the start of
+   * the extent of the cursor, or zero if it is not in a file.
+   */
+  unsigned file;
+
+  /**
+   * \brief The extent of the cursor, as with clang_getCursorExtent() and
+   * clang_getInstantiationLocation().
+   */
+  unsigned begin_line, begin_column, begin_offset;
+  unsigned end_line, end_column, end_offset;
+} CXCursorTreeNode;
+
+/**
+ * \brief A cursor tree exported by clang_exportCursorTree().
+ */
+typedef void *CXCursorTree;
+
+/**
+ * \brief Export the cursors of the subtree rooted at \p root in a single
+ * traversal.
+ *
+ * The cursors visited by clang_visitChildren() when always recursing are
+ * stored, \p root first and in the order they would be visited, in one
+ * flat array along with a table of their strings.  Clients that would
+ * otherwise query each cursor separately, such as bindings for scripting
+ * languages, can read the whole tree with a handful of calls.
+ *
+ * \returns the tree, which must be released with clang_disposeCursorTree(),
+ * or NULL if \p root is a null cursor.
+ */
+CINDEX_LINKAGE CXCursorTree clang_exportCursorTree(CXCursor root);
+
+/**
+ * \brief Retrieve the number of cursors in an exported cursor tree.
+ */
+CINDEX_LINKAGE unsigned clang_getCursorTreeNumNodes(CXCursorTree tree);
+
+/**
+ * \brief Retrieve the cursors of an exported cursor tree.
+ *
+ * \returns an array of clang_getCursorTreeNumNodes() nodes, valid until the
+ * tree is disposed.
+ */
+CINDEX_LINKAGE const CXCursorTreeNode *
+clang_getCursorTreeNodes(CXCursorTree tree);
+
+/**
+ * \brief Retrieve the string table of an exported cursor tree.
+ *
+ * \param size if non-NULL, set to the size of the table in bytes.
+ *
+ * \returns the table, valid until the tree is disposed.
+ */
+CINDEX_LINKAGE const char *clang_getCursorTreeStrings(CXCursorTree tree,
+                                                      unsigned *size);
+
+/**
+ * \brief Release a tree exported by clang_exportCursorTree().
+ */
+CINDEX_LINKAGE void clang_disposeCursorTree(CXCursorTree tree);
+
 /**
  * @}
  */
@@ -1164,6 +1477,110 @@ CINDEX_LINKAGE CXCursor clang_getCursorDefinition(CXCursor);
  */
 CINDEX_LINKAGE unsigned clang_isCursorDefinition(CXCursor);
 
+/**
+ * @}
+ */
+
+/**
+ * \defgroup CINDEX_SYMBOL_INDEX Persistent symbol indexes
+ *
+ * A symbol index is a file that maps the USR of each entity of a program to
+ * its declarations, definitions and references, by file and offset.  It is
+ * queried without loading any translation unit, so finding the references
+ * to an entity does not depend on the number of translation units in the
+ * program.
+ *
+ * Each translation unit writes its own index file, so translation units can
+ * be indexed in parallel, and the per-translation unit files are then merged
+ * into the index of the program.  Merging is incremental: re-indexing a
+ * translation unit and merging its file into the program index replaces the
+ * occurrences it contributed to each file, based on the modification times
+ * of the files when they were indexed.
+ *
+ * Occurrences within functions, such as those of local variables and
+ * parameters, are not indexed.
+ *
+ * @{
+ */
+
+/**
+ * \brief Describes how an entity occurs in a symbol index.
+ */
+enum CXSymbolOccurrenceKind {
+  CXSymbolOccurrence_Declaration = 0,
+  CXSymbolOccurrence_Definition = 1,
+  CXSymbolOccurrence_Reference = 2
+};
+
+/**
+ * \brief A symbol index loaded by clang_loadSymbolIndex().
+ */
+typedef void *CXSymbolIndex;
+
+/**
+ * \brief Write the symbol index of a translation unit.
+ *
+ * \param TU the translation unit whose declarations and references are
+ * indexed.
+ *
+ * \param index_path the file the index is written to.  The file is replaced
+ * atomically.
+ *
+ * \returns zero on success, non-zero otherwise.
+ */
+CINDEX_LINKAGE int clang_writeSymbolIndex(CXTranslationUnit TU,
+                                          const char *index_path);
+
+/**
+ * \brief Merge symbol indexes into the symbol index at \p index_path.
+ *
+ * The existing contents of \p index_path, if any, are merged with the
+ * inputs.  For each file, the occurrences are taken from the index that saw
+ * the most recent version of that file; when several did, later inputs take
+ * precedence.
+ *
+ * \returns zero on success, non-zero if an input could not be read or the
+ * result could not be written.
+ */
+CINDEX_LINKAGE int clang_mergeSymbolIndexes(const char *index_path,
+                                            unsigned num_inputs,
+                                            const char * const *inputs);
+
+/**
+ * \brief Map the symbol index at \p index_path into memory.
+ *
+ * \returns the loaded index, or NULL if the file does not exist or is not a
+ * symbol index.  The index must be released with clang_disposeSymbolIndex().
+ */
+CINDEX_LINKAGE CXSymbolIndex clang_loadSymbolIndex(const char *index_path);
+
+/**
+ * \brief Release a symbol index loaded by clang_loadSymbolIndex().
+ */
+CINDEX_LINKAGE void clang_disposeSymbolIndex(CXSymbolIndex index);
+
+/**
+ * \brief Visitor invoked for each occurrence found by
+ * clang_findSymbolOccurrences().
+ *
+ * The file name is absolute and only valid until the index is disposed.
+ */
+typedef void (*CXSymbolOccurrenceVisitor)(enum CXSymbolOccurrenceKind kind,
+                                          const char *filename,
+                                          unsigned offset,
+                                          CXClientData client_data);
+
+/**
+ * \brief Visit the occurrences of the entity with the given USR, ordered by
+ * file name and offset.
+ *
+ * \returns the number of occurrences visited.
+ */
+CINDEX_LINKAGE unsigned clang_findSymbolOccurrences(CXSymbolIndex index,
+                                                const char *usr,
+                                                CXSymbolOccurrenceVisitor visitor,
+                                                CXClientData client_data);
+
 /**
  * @}
  */
@@ -1293,6 +1710,38 @@ CINDEX_LINKAGE void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
 CINDEX_LINKAGE void clang_annotateTokens(CXTranslationUnit TU,
                                          CXToken *Tokens, unsigned NumTokens,
                                          CXCursor *Cursors);
+
+/**
+ * \brief Tokenize the source code described by the given range and retrieve
+ * the cursor at each token.
+ *
+ * The cursor of a token is the one clang_getCursor() would return at the
+ * location of the token, e.g., the CallExpr for the parentheses of a call.
+ * Unlike calling clang_getCursor() for each token, the cursors of all the
+ * tokens are found with a single walk over the AST, which makes this
+ * suitable for syntax highlighting.  The kind of each token is available
+ * through clang_getTokenKind().
+ *
+ * \param TU the translation unit whose text is being tokenized.
+ *
+ * \param Range the source range in which text should be tokenized, as for
+ * clang_tokenize().
+ *
+ * \param Tokens this pointer will be set to point to the array of tokens
+ * that occur within the given source range.  The returned pointer must be
+ * freed with clang_disposeTokens() before the translation unit is destroyed.
+ *
+ * \param Cursors this pointer will be set to point to the cursor of each
+ * token.  It is freed along with \p Tokens by clang_disposeTokens().
+ *
+ * \param NumTokens will be set to the number of tokens in the \c *Tokens
+ * and \c *Cursors arrays.
+ */
+CINDEX_LINKAGE void clang_tokenizeWithCursors(CXTranslationUnit TU,
+                                              CXSourceRange Range,
+                                              CXToken **Tokens,
+                                              CXCursor **Cursors,
+                                              unsigned *NumTokens);
   
 /**
  * \brief Free the given set of tokens.
@@ -1708,6 +2157,96 @@ CXCodeCompleteResults *clang_codeComplete(CXIndex CIdx,
                                           unsigned complete_line,
                                           unsigned complete_column);
 
+/**
+ * \brief Perform code completion at a given location in a translation unit
+ * that was parsed from source, without running a separate compiler process.
+ *
+ * This function reparses the translation unit in-process, with the command
+ * line it was created from. The first completion in the main file
+ * precompiles the preamble of the main file, i.e., the comments and
+ * preprocessor directives it starts with, and later completions reuse it
+ * until the preamble or one of the files it includes changes, so that only
+ * the rest of the main file is parsed again. The preamble is not reused
+ * when files other than the main file are passed in \p unsaved_files.
+ *
+ * \param TU the translation unit, as returned by
+ * \c clang_createTranslationUnitFromSourceFile() for an index that does not
+ * use external AST generation.
+ *
+ * \param complete_filename the name of the source file where code completion
+ * should be performed.
+ *
+ * \param complete_line the line at which code-completion should occur.
+ *
+ * \param complete_column the column at which code-completion should occur.
+ *
+ * \param unsaved_files the files that have not yet been saved to disk,
+ * including their current contents.
+ *
+ * \param num_unsaved_files the number of unsaved file entries in \p
+ * unsaved_files.
+ *
+ * \returns if successful, a new CXCodeCompleteResults structure
+ * containing code-completion results, which should eventually be
+ * freed with \c clang_disposeCodeCompleteResults(). If \p TU was not parsed
+ * from source in-process, returns NULL.
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
+                                            const char *complete_filename,
+                                            unsigned complete_line,
+                                            unsigned complete_column,
+                                           struct CXUnsavedFile *unsaved_files,
+                                            unsigned num_unsaved_files);
+
+/**
+ * \brief Perform code completion at a given location in a source file, as
+ * \c clang_codeComplete() does, but only produce the results that the client
+ * would keep.
+ *
+ * Results whose typed text does not start with \p prefix, ignoring case, are
+ * dropped before their completion strings are built. When \p max_results is
+ * nonzero, at most that many results are produced, keeping the most relevant
+ * ones: names that match \p prefix with the same case first, then local
+ * declarations, members, global declarations, macros, and keywords.
+ *
+ * \param prefix the text of the token being completed, which lies between
+ * the code-completion location and the cursor. NULL or the empty string keeps
+ * every result.
+ *
+ * \param max_results the maximum number of results, or zero for no limit.
+ *
+ * The other parameters are the same as for \c clang_codeComplete().
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *clang_codeCompleteWithFilter(CXIndex CIdx,
+                                          const char *source_filename,
+                                          int num_command_line_args,
+                                          const char **command_line_args,
+                                          unsigned num_unsaved_files,
+                                          struct CXUnsavedFile *unsaved_files,
+                                          const char *complete_filename,
+                                          unsigned complete_line,
+                                          unsigned complete_column,
+                                          const char *prefix,
+                                          unsigned max_results);
+
+/**
+ * \brief Perform code completion at a given location in a translation unit,
+ * as \c clang_codeCompleteAt() does, but only produce the results whose
+ * typed text starts with \p prefix, and at most \p max_results of them, as
+ * described for \c clang_codeCompleteWithFilter().
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *clang_codeCompleteAtWithFilter(CXTranslationUnit TU,
+                                            const char *complete_filename,
+                                            unsigned complete_line,
+                                            unsigned complete_column,
+                                           struct CXUnsavedFile *unsaved_files,
+                                            unsigned num_unsaved_files,
+                                            const char *prefix,
+                                            unsigned max_results);
+
 /**
  * \brief Free the given set of code-completion results.
  */
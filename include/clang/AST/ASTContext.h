@@ -37,6 +37,7 @@ namespace llvm {
 
 namespace clang {
   class FileManager;
+  class ImplicitMemberDeclarator;
   class ASTRecordLayout;
   class BlockExpr;
   class CharUnits;
@@ -112,7 +113,22 @@ class ASTContext {
   llvm::DenseMap<const RecordDecl*, const ASTRecordLayout*> ASTRecordLayouts;
   llvm::DenseMap<const ObjCContainerDecl*, const ASTRecordLayout*> ObjCLayouts;
 
-  /// KeyFunctions - A cache mapping from CXXRecordDecls to key functions.
+  /// MemoizedTypeInfo - A cache mapping from types to their size and
+  /// alignment.  Types are uniqued and never change once they are complete,
+  /// so the entries stay valid for the lifetime of the context.
+  typedef llvm::DenseMap<const Type*, std::pair<uint64_t, unsigned> >
+    TypeInfoMap;
+  TypeInfoMap MemoizedTypeInfo;
+  unsigned NumTypeInfoQueries, NumCachedTypeInfoQueries;
+
+  /// ElidedTypeSourceInfos - The type source information without locations
+  /// of each type, shared by all declarations whose type locations are
+  /// elided.
+  llvm::DenseMap<void*, TypeSourceInfo*> ElidedTypeSourceInfos;
+  unsigned NumElidedTypeSourceInfos;
+
+  /// KeyFunctions - A cache mapping from CXXRecordDecls to key functions,
+  /// or to null for the classes known to have none.
   llvm::DenseMap<const CXXRecordDecl*, const CXXMethodDecl*> KeyFunctions;
   
   /// \brief Mapping from ObjCContainers to their ObjCImplementations.
@@ -156,11 +172,22 @@ class ASTContext {
   /// \brief Type for the Block descriptor for Blocks CodeGen.
   RecordDecl *BlockDescriptorExtendedType;
 
+public:
+  /// \brief The attributes of a declaration, along with a mask with bit N
+  /// set if one of them has attribute kind N.
+  struct DeclAttrList {
+    Attr *Attrs;
+    uint64_t Kinds;
+
+    DeclAttrList() : Attrs(0), Kinds(0) {}
+  };
+
+private:
   /// \brief Keeps track of all declaration attributes.
   ///
   /// Since so few decls have attrs, we keep them in a hash map instead of
   /// wasting space in the Decl class.
-  llvm::DenseMap<const Decl*, Attr*> DeclAttrs;
+  llvm::DenseMap<const Decl*, DeclAttrList> DeclAttrs;
 
   /// \brief Keeps track of the static data member templates from which
   /// static data members of class template specializations were instantiated.
@@ -219,6 +246,70 @@ class ASTContext {
 
   llvm::DenseMap<FieldDecl *, FieldDecl *> InstantiatedFromUnnamedFieldDecl;
 
+  /// \brief The methods that each virtual member function overrides.
+  ///
+  /// This mapping is kept per context, so that translation units can be built
+  /// on several threads at once.
+  llvm::DenseMap<const CXXMethodDecl *, std::vector<const CXXMethodDecl *> >
+    OverriddenMethods;
+
+  /// \brief The braces around the bodies of functions that were skipped
+  /// instead of being parsed.
+  llvm::DenseMap<const FunctionDecl *, SourceRange> SkippedFunctionBodies;
+
+  /// \brief Incremented whenever a declaration is made visible to, or removed
+  /// from, name lookup into a declaration context.
+  unsigned LookupGeneration;
+
+  /// \brief Incremented whenever the declarations found by name lookup into
+  /// a class, or into one of its bases, may have changed.
+  unsigned RecordLookupGeneration;
+
+  /// \brief Incremented whenever a declaration is made visible to, or removed
+  /// from, name lookup into a namespace or the translation unit.
+  unsigned NamespaceLookupGeneration;
+
+  /// \brief Incremented whenever the members, protocols, categories or
+  /// superclass of an Objective-C class, category or protocol change.
+  unsigned ObjCLookupGeneration;
+
+public:
+  /// \brief The kinds of Objective-C lookups cached by ASTContext.
+  enum ObjCLookupKind {
+    ObjCInstanceMethodLookup,
+    ObjCClassMethodLookup,
+    ObjCIvarLookup,
+    ObjCPropertyLookup
+  };
+
+  /// \brief The result of an Objective-C lookup through the categories,
+  /// protocols and superclasses of a class: the declaration found, if any,
+  /// and the class that declares it.
+  struct ObjCLookupResult {
+    NamedDecl *Found;
+    ObjCInterfaceDecl *Owner;
+  };
+
+  /// \brief Return the cached result of looking up the name \arg Name (the
+  /// opaque pointer of a selector or identifier) in \arg Container, or null
+  /// if it was not looked up since the last change to Objective-C
+  /// declarations.
+  const ObjCLookupResult *findObjCLookup(const Decl *Container, void *Name,
+                                         ObjCLookupKind Kind);
+
+  /// \brief Cache the result of an Objective-C lookup.
+  void addObjCLookup(const Decl *Container, void *Name, ObjCLookupKind Kind,
+                     NamedDecl *Found, ObjCInterfaceDecl *Owner = 0);
+
+private:
+  typedef std::pair<const Decl *, std::pair<void *, unsigned> > ObjCLookupKey;
+
+  /// \brief The results of Objective-C lookups, which are only valid for
+  /// ObjCLookupsGeneration.
+  llvm::DenseMap<ObjCLookupKey, ObjCLookupResult> ObjCLookups;
+  unsigned ObjCLookupsGeneration;
+  unsigned NumObjCLookups, NumCachedObjCLookups;
+
   TranslationUnitDecl *TUDecl;
 
   /// SourceMgr - The associated SourceManager object.
@@ -237,10 +328,29 @@ class ASTContext {
   llvm::MallocAllocator MallocAlloc;
   llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief Whether the statements of each function body are allocated from
+  /// an allocator of their own, which \c ReleaseFunctionBody frees.
+  bool ReleaseFunctionBodies;
+
+  /// \brief The allocator for the statements of the function body being
+  /// parsed, or null if statements come from \c BumpAlloc.
+  llvm::BumpPtrAllocator *StmtAlloc;
+
+  /// \brief The allocators holding the statements of the function bodies
+  /// that have been parsed but not released.
+  llvm::DenseMap<const FunctionDecl *, llvm::BumpPtrAllocator *>
+    FunctionBodyAllocs;
+  unsigned NumReleasedFunctionBodies;
+  uint64_t NumReleasedFunctionBodyBytes;
+
   /// \brief Mapping from declarations to their comments, once we have
   /// already looked up the comment associated with a given declaration.
   llvm::DenseMap<const Decl *, std::string> DeclComments;
 
+  /// \brief A number that identifies this ASTContext among all of those
+  /// created by the process.  Unlike its address, it is never reused.
+  unsigned UniqueID;
+
 public:
   const TargetInfo &Target;
   IdentifierTable &Idents;
@@ -248,6 +358,11 @@ public:
   Builtin::Context &BuiltinInfo;
   DeclarationNameTable DeclarationNames;
   llvm::OwningPtr<ExternalASTSource> ExternalSource;
+
+  /// \brief Declares the implicit members that classes deferred, or null if
+  /// there is nothing to declare them any longer.
+  ImplicitMemberDeclarator *ImplicitMembers;
+
   clang::PrintingPolicy PrintingPolicy;
 
   // Typedefs which may be provided defining the structure of Objective-C
@@ -262,6 +377,7 @@ public:
 
   SourceManager& getSourceManager() { return SourceMgr; }
   const SourceManager& getSourceManager() const { return SourceMgr; }
+  unsigned getUniqueID() const { return UniqueID; }
   void *Allocate(unsigned Size, unsigned Align = 8) {
     return FreeMemory ? MallocAlloc.Allocate(Size, Align) :
                         BumpAlloc.Allocate(Size, Align);
@@ -270,6 +386,14 @@ public:
     if (FreeMemory)
       MallocAlloc.Deallocate(Ptr);
   }
+
+  /// \brief Allocate memory for a statement or an expression, which belongs
+  /// to the function body being parsed if there is one.
+  void *AllocateStmt(unsigned Size, unsigned Align) {
+    return StmtAlloc ? StmtAlloc->Allocate(Size, Align)
+                     : Allocate(Size, Align);
+  }
+
   const LangOptions& getLangOptions() const { return LangOpts; }
 
   FullSourceLoc getFullLoc(SourceLocation Loc) const {
@@ -277,7 +401,7 @@ public:
   }
 
   /// \brief Retrieve the attributes for the given declaration.
-  Attr*& getDeclAttrs(const Decl *D) { return DeclAttrs[D]; }
+  DeclAttrList &getDeclAttrs(const Decl *D) { return DeclAttrs[D]; }
 
   /// \brief Erase the attributes corresponding to the given declaration.
   void eraseDeclAttrs(const Decl *D) { DeclAttrs.erase(D); }
@@ -310,11 +434,71 @@ public:
 
   void setInstantiatedFromUnnamedFieldDecl(FieldDecl *Inst, FieldDecl *Tmpl);
 
+  typedef const CXXMethodDecl **overridden_cxx_method_iterator;
+
+  /// \brief Return the methods that \p Method overrides, or null if it does
+  /// not override any.
+  overridden_cxx_method_iterator
+  overridden_methods_begin(const CXXMethodDecl *Method);
+  overridden_cxx_method_iterator
+  overridden_methods_end(const CXXMethodDecl *Method);
+
+  /// \brief Note that \p Method overrides \p Overridden.
+  void addOverriddenMethod(const CXXMethodDecl *Method,
+                           const CXXMethodDecl *Overridden);
+
+  /// \brief If the body of the given function was skipped by the parser,
+  /// return the range from its '{' to its '}', which can be lexed again to
+  /// parse the body later.  Otherwise, return an invalid range.
+  SourceRange getSkippedFunctionBody(const FunctionDecl *FD) const {
+    return SkippedFunctionBodies.lookup(FD);
+  }
+
+  /// \brief Note that the body of the given function was skipped, or, given
+  /// an invalid range, that it has been parsed after all.
+  void setSkippedFunctionBody(const FunctionDecl *FD, SourceRange Braces) {
+    if (Braces.isValid())
+      SkippedFunctionBodies[FD] = Braces;
+    else
+      SkippedFunctionBodies.erase(FD);
+  }
+
+  /// \brief Return a number that changes whenever the declarations found by
+  /// name lookup into some declaration context change.
+  unsigned getLookupGeneration() const { return LookupGeneration; }
+
+  /// \brief Note that the declarations visible in a declaration context have
+  /// changed.
+  void bumpLookupGeneration() { ++LookupGeneration; }
+
+  /// \brief Return a number that changes whenever the declarations found by
+  /// name lookup into some class, or through its base classes, change.
+  unsigned getRecordLookupGeneration() const { return RecordLookupGeneration; }
+
+  /// \brief Note that the members or the bases of a class have changed.
+  void bumpRecordLookupGeneration() { ++RecordLookupGeneration; }
+
+  /// \brief Return a number that changes whenever the declarations found by
+  /// name lookup into some namespace, or the translation unit, change.
+  unsigned getNamespaceLookupGeneration() const {
+    return NamespaceLookupGeneration;
+  }
+
+  /// \brief Note that the declarations visible in a namespace have changed.
+  void bumpNamespaceLookupGeneration() { ++NamespaceLookupGeneration; }
+
+  /// \brief Note that an Objective-C class, category or protocol changed.
+  void bumpObjCLookupGeneration() { ++ObjCLookupGeneration; }
+
   TranslationUnitDecl *getTranslationUnitDecl() const { return TUDecl; }
 
 
   const char *getCommentForDecl(const Decl *D);
 
+  /// \brief Add the comments of the external AST source to Comments, unless
+  /// they have already been loaded.
+  void ReadExternalComments();
+
   // Builtin Types.
   CanQualType VoidTy;
   CanQualType BoolTy;
@@ -354,6 +538,40 @@ public:
   void PrintStats() const;
   const std::vector<Type*>& getTypes() const { return Types; }
 
+  /// \brief Return the number of bytes allocated for the AST, not counting
+  /// the memory of the external AST source.
+  size_t getASTAllocatedMemory() const { return BumpAlloc.getTotalMemory(); }
+
+  /// \brief Free the information that is recomputed when it is next asked
+  /// for, such as the comments found for declarations.
+  void releaseCaches() {
+    llvm::DenseMap<const Decl *, std::string>().swap(DeclComments);
+  }
+
+  /// \brief Allocate the statements of every function body from an allocator
+  /// of its own, so that \c ReleaseFunctionBody can free them.  This has no
+  /// effect when memory is freed one object at a time.
+  void setReleaseFunctionBodies(bool Release) {
+    ReleaseFunctionBodies = Release && !FreeMemory;
+  }
+
+  /// \brief Note that the body of a function definition is about to be
+  /// parsed.
+  void StartFunctionBody();
+
+  /// \brief Note that the body of \p FD has been parsed; the statements
+  /// created from now on do not belong to it.
+  void FinishFunctionBody(const FunctionDecl *FD);
+
+  /// \brief Free the statements of the body of \p FD, which nothing may
+  /// refer to anymore, leaving it an empty body.
+  ///
+  /// Only the statements built while the body was parsed are freed, not the
+  /// declarations in it; once this has been called, the initializers of its
+  /// local variables and the size expressions of its variably modified
+  /// types must not be used.
+  void ReleaseFunctionBody(FunctionDecl *FD);
+
   //===--------------------------------------------------------------------===//
   //                           Type Constructors
   //===--------------------------------------------------------------------===//
@@ -806,6 +1024,9 @@ public:
   /// getTypeInfo - Get the size and alignment of the specified complete type in
   /// bits.
   std::pair<uint64_t, unsigned> getTypeInfo(const Type *T);
+private:
+  std::pair<uint64_t, unsigned> getTypeInfoImpl(const Type *T);
+public:
   std::pair<uint64_t, unsigned> getTypeInfo(QualType T) {
     return getTypeInfo(T.getTypePtr());
   }
@@ -861,6 +1082,17 @@ public:
   /// position information.
   const ASTRecordLayout &getASTRecordLayout(const RecordDecl *D);
 
+  /// record_layout_iterator - Walks the record layouts that have been
+  /// computed so far.
+  typedef llvm::DenseMap<const RecordDecl*, const ASTRecordLayout*>
+    ::const_iterator record_layout_iterator;
+  record_layout_iterator record_layouts_begin() const {
+    return ASTRecordLayouts.begin();
+  }
+  record_layout_iterator record_layouts_end() const {
+    return ASTRecordLayouts.end();
+  }
+
   /// getASTObjCInterfaceLayout - Get or compute information about the
   /// layout of the specified Objective-C interface.
   const ASTRecordLayout &getASTObjCInterfaceLayout(const ObjCInterfaceDecl *D);
@@ -1196,6 +1428,11 @@ public:
   TypeSourceInfo *
   getTrivialTypeSourceInfo(QualType T, SourceLocation Loc = SourceLocation());
 
+  /// \brief Return the TypeSourceInfo without locations of the given type,
+  /// which is shared by every declaration of that type that does not keep
+  /// its own type locations (see LangOptions::ElideTypeLocs).
+  TypeSourceInfo *getElidedTypeSourceInfo(QualType T);
+
 private:
   ASTContext(const ASTContext&); // DO NOT IMPLEMENT
   void operator=(const ASTContext&); // DO NOT IMPLEMENT
@@ -1220,7 +1457,8 @@ private:
   // but we include it here so that ASTContext can quickly deallocate them.
   std::vector<void*> SDMs; 
   friend class DeclContext;
-  void *CreateStoredDeclsMap();
+  /// \brief Create a lookup table with room for \p NumEntries names.
+  void *CreateStoredDeclsMap(unsigned NumEntries = 0);
   void ReleaseDeclContextMaps();
 };
   
@@ -38,6 +38,7 @@ namespace clang {
   class ASTImporter {
   public:
     typedef llvm::DenseSet<std::pair<Decl *, Decl *> > NonEquivalentDeclSet;
+    typedef llvm::DenseSet<std::pair<Decl *, Decl *> > EquivalentDeclSet;
     
   private:
     /// \brief The contexts we're importing to and from.
@@ -72,6 +73,10 @@ namespace clang {
     /// \brief Declaration (from, to) pairs that are known not to be equivalent
     /// (which we have already complained about).
     NonEquivalentDeclSet NonEquivalentDecls;
+
+    /// \brief Declaration (from, to) pairs that are known to be equivalent,
+    /// so that later imports need not check them again.
+    EquivalentDeclSet EquivalentDecls;
     
   public:
     ASTImporter(Diagnostic &Diags,
@@ -224,6 +229,9 @@ namespace clang {
     
     /// \brief Return the set of declarations that we know are not equivalent.
     NonEquivalentDeclSet &getNonEquivalentDecls() { return NonEquivalentDecls; }
+
+    /// \brief Return the set of declarations that we know are equivalent.
+    EquivalentDeclSet &getEquivalentDecls() { return EquivalentDecls; }
     
     /// \brief Note that we have imported the "from" declaration by mapping it
     /// to the (potentially-newly-created) "to" declaration.
@@ -38,7 +38,10 @@ void operator delete(void *Ptr, clang::ASTContext &C, size_t)
 
 namespace clang {
 
-/// Attr - This represents one attribute.
+/// Attr - This represents one attribute.  Each concrete attribute class
+/// provides its kind as StaticKind, which Decl::getAttr uses to check the
+/// mask of attribute kinds a declaration has.  There must be at most 64
+/// kinds.
 class Attr {
 public:
   enum Kind {
@@ -178,6 +181,7 @@ public:                                                                 \
   virtual Attr *clone(ASTContext &C) const;                             \
   static bool classof(const Attr *A) { return A->getKind() == ATTR; }   \
   static bool classof(const ATTR##Attr *A) { return true; }             \
+  static const Kind StaticKind = ATTR;                                  \
 }
 
 DEF_SIMPLE_ATTR(Packed);
@@ -198,6 +202,7 @@ public:
     return A->getKind() == PragmaPack;
   }
   static bool classof(const PragmaPackAttr *A) { return true; }
+  static const Kind StaticKind = PragmaPack;
 };
 
 class AlignedAttr : public Attr {
@@ -225,6 +230,7 @@ public:
     return A->getKind() == Aligned;
   }
   static bool classof(const AlignedAttr *A) { return true; }
+  static const Kind StaticKind = Aligned;
 };
 
 class AnnotateAttr : public AttrWithString {
@@ -241,6 +247,7 @@ public:
     return A->getKind() == Annotate;
   }
   static bool classof(const AnnotateAttr *A) { return true; }
+  static const Kind StaticKind = Annotate;
 };
 
 class AsmLabelAttr : public AttrWithString {
@@ -257,6 +264,7 @@ public:
     return A->getKind() == AsmLabel;
   }
   static bool classof(const AsmLabelAttr *A) { return true; }
+  static const Kind StaticKind = AsmLabel;
 };
 
 DEF_SIMPLE_ATTR(AlwaysInline);
@@ -273,6 +281,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Alias; }
   static bool classof(const AliasAttr *A) { return true; }
+  static const Kind StaticKind = Alias;
 };
 
 class ConstructorAttr : public Attr {
@@ -287,6 +296,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Constructor; }
   static bool classof(const ConstructorAttr *A) { return true; }
+  static const Kind StaticKind = Constructor;
 };
 
 class DestructorAttr : public Attr {
@@ -301,6 +311,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Destructor; }
   static bool classof(const DestructorAttr *A) { return true; }
+  static const Kind StaticKind = Destructor;
 };
 
 class IBOutletAttr : public Attr {
@@ -314,6 +325,7 @@ public:
     return A->getKind() == IBOutletKind;
   }
   static bool classof(const IBOutletAttr *A) { return true; }
+  static const Kind StaticKind = IBOutletKind;
 };
 
 class IBActionAttr : public Attr {
@@ -327,6 +339,7 @@ public:
     return A->getKind() == IBActionKind;
   }
   static bool classof(const IBActionAttr *A) { return true; }
+  static const Kind StaticKind = IBActionKind;
 };
 
 DEF_SIMPLE_ATTR(AnalyzerNoReturn);
@@ -350,6 +363,7 @@ public:
     return A->getKind() == Section;
   }
   static bool classof(const SectionAttr *A) { return true; }
+  static const Kind StaticKind = Section;
 };
 
 DEF_SIMPLE_ATTR(Unavailable);
@@ -382,6 +396,7 @@ public:
 
   static bool classof(const Attr *A) { return A->getKind() == NonNull; }
   static bool classof(const NonNullAttr *A) { return true; }
+  static const Kind StaticKind = NonNull;
 };
 
 class FormatAttr : public AttrWithString {
@@ -400,6 +415,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Format; }
   static bool classof(const FormatAttr *A) { return true; }
+  static const Kind StaticKind = Format;
 };
 
 class FormatArgAttr : public Attr {
@@ -413,6 +429,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == FormatArg; }
   static bool classof(const FormatArgAttr *A) { return true; }
+  static const Kind StaticKind = FormatArg;
 };
 
 class SentinelAttr : public Attr {
@@ -428,6 +445,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Sentinel; }
   static bool classof(const SentinelAttr *A) { return true; }
+  static const Kind StaticKind = Sentinel;
 };
 
 class VisibilityAttr : public Attr {
@@ -451,6 +469,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Visibility; }
   static bool classof(const VisibilityAttr *A) { return true; }
+  static const Kind StaticKind = Visibility;
 };
 
 DEF_SIMPLE_ATTR(FastCall);
@@ -470,6 +489,7 @@ public:
 
   static bool classof(const Attr *A) { return A->getKind() == Overloadable; }
   static bool classof(const OverloadableAttr *) { return true; }
+  static const Kind StaticKind = Overloadable;
 };
 
 class BlocksAttr : public Attr {
@@ -489,6 +509,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Blocks; }
   static bool classof(const BlocksAttr *A) { return true; }
+  static const Kind StaticKind = Blocks;
 };
 
 class FunctionDecl;
@@ -506,6 +527,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Cleanup; }
   static bool classof(const CleanupAttr *A) { return true; }
+  static const Kind StaticKind = Cleanup;
 };
 
 DEF_SIMPLE_ATTR(NoDebug);
@@ -525,6 +547,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == Regparm; }
   static bool classof(const RegparmAttr *A) { return true; }
+  static const Kind StaticKind = Regparm;
 };
 
 class ReqdWorkGroupSizeAttr : public Attr {
@@ -544,6 +567,7 @@ public:
     return A->getKind() == ReqdWorkGroupSize;
   }
   static bool classof(const ReqdWorkGroupSizeAttr *A) { return true; }
+  static const Kind StaticKind = ReqdWorkGroupSize;
 };
 
 // Checker-specific attributes.
@@ -574,6 +598,7 @@ public:
   // Implement isa/cast/dyncast/etc.
   static bool classof(const Attr *A) { return A->getKind() == MSP430Interrupt; }
   static bool classof(const MSP430InterruptAttr *A) { return true; }
+  static const Kind StaticKind = MSP430Interrupt;
 };
 
 DEF_SIMPLE_ATTR(X86ForceAlignArgPointer);
@@ -1033,6 +1033,12 @@ public:
   void setBody(Stmt *B);
   void setLazyBody(uint64_t Offset) { Body = Offset; }
 
+  /// \brief The offset of the body of this declaration in the external AST
+  /// source, or 0 if it has no body or the body is already deserialized.
+  uint64_t getLazyBodyOffset() const {
+    return Body.isOffset() ? Body.getOffset() : 0;
+  }
+
   /// Whether this function is marked as virtual explicitly.
   bool isVirtualAsWritten() const { return IsVirtualAsWritten; }
   void setVirtualAsWritten(bool V) { IsVirtualAsWritten = V; }
@@ -255,8 +255,19 @@ public:
   void swapAttrs(Decl *D);
   void invalidateAttrs();
 
+  /// hasAttrKind - Return true if one of the attributes of this declaration
+  /// has the given kind.
+  bool hasAttrKind(unsigned K) const {
+    if (!HasAttrs) return false;  // common case, no attributes.
+    return (getAttrKindsImpl() >> K) & 1;
+  }
+
   template<typename T> const T *getAttr() const {
-    for (const Attr *attr = getAttrs(); attr; attr = attr->getNext())
+    // Most queries are for attributes the declaration does not have; the
+    // mask of attribute kinds answers those without walking the list.
+    if (!hasAttrKind(T::StaticKind))
+      return 0;
+    for (const Attr *attr = getAttrsImpl(); attr; attr = attr->getNext())
       if (const T *V = dyn_cast<T>(attr))
         return V;
     return 0;
@@ -498,6 +509,7 @@ public:
 
 private:
   const Attr *getAttrsImpl() const;
+  uint64_t getAttrKindsImpl() const;
 
 };
 
@@ -623,6 +635,14 @@ public:
     return DeclKind == Decl::TranslationUnit || DeclKind == Decl::Namespace;
   }
 
+  /// isObjCLookupContext - Whether this is an Objective-C class, category or
+  /// protocol, whose members are found by the Objective-C lookups that
+  /// ASTContext caches.
+  bool isObjCLookupContext() const {
+    return DeclKind == Decl::ObjCInterface || DeclKind == Decl::ObjCCategory ||
+           DeclKind == Decl::ObjCProtocol;
+  }
+
   bool isTranslationUnit() const {
     return DeclKind == Decl::TranslationUnit;
   }
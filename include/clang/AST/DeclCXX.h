@@ -174,6 +174,18 @@ public:
   QualType getType() const { return BaseType; }
 };
 
+/// ImplicitMemberDeclarator - Declares the deferred implicit special members
+/// of a class (see CXXRecordDecl::hasDeferredImplicitMembers) when they are
+/// first looked up.  Semantic analysis provides it through the ASTContext.
+class ImplicitMemberDeclarator {
+public:
+  virtual ~ImplicitMemberDeclarator();
+
+  /// DeclareImplicitMembers - Declare the implicit members of \arg Record,
+  /// which has deferred them.
+  virtual void DeclareImplicitMembers(CXXRecordDecl *Record) = 0;
+};
+
 /// CXXRecordDecl - Represents a C++ struct/union/class.
 /// FIXME: This class will disappear once we've properly taught RecordDecl
 /// to deal with C++-specific things.
@@ -268,6 +280,10 @@ class CXXRecordDecl : public RecordDecl {
     /// ComputedVisibleConversions - True when visible conversion functions are
     /// already computed and are available.
     bool ComputedVisibleConversions : 1;
+
+    /// DeferredImplicitMembers - True when the implicitly-declared special
+    /// members of this class have not been declared yet.
+    bool DeferredImplicitMembers : 1;
   
     /// Bases - Base classes of this class.
     /// FIXME: This is wasted space for a union.
@@ -648,6 +664,18 @@ public:
   // (C++ [class.dtor]p3)
   void setHasTrivialDestructor(bool TC) { data().HasTrivialDestructor = TC; }
 
+  /// hasDeferredImplicitMembers - Whether the implicitly-declared special
+  /// members of this class are only declared when the name of a special
+  /// member is first looked up in it, by the ImplicitMemberDeclarator of the
+  /// ASTContext.
+  bool hasDeferredImplicitMembers() const {
+    return DefinitionData && data().DeferredImplicitMembers;
+  }
+
+  void setDeferredImplicitMembers(bool D) {
+    data().DeferredImplicitMembers = D;
+  }
+
   /// \brief If this record is an instantiation of a member class,
   /// retrieves the member class from which it was instantiated.
   ///
@@ -454,6 +454,8 @@ class ObjCInterfaceDecl : public ObjCContainerDecl {
 
   virtual ~ObjCInterfaceDecl() {}
 
+  ObjCMethodDecl *lookupMethodUncached(Selector Sel, bool isInstance) const;
+
 public:
 
   /// Destroy - Call destructors and release memory.
@@ -505,9 +507,7 @@ public:
   /// setProtocolList - Set the list of protocols that this interface
   /// implements.
   void setProtocolList(ObjCProtocolDecl *const* List, unsigned Num,
-                       const SourceLocation *Locs, ASTContext &C) {
-    ReferencedProtocols.set(List, Num, Locs, C);
-  }
+                       const SourceLocation *Locs, ASTContext &C);
 
   /// mergeClassExtensionProtocolList - Merge class extension's protocol list
   /// into the protocol list for this class.
@@ -520,12 +520,10 @@ public:
   void setForwardDecl(bool val) { ForwardDecl = val; }
 
   ObjCInterfaceDecl *getSuperClass() const { return SuperClass; }
-  void setSuperClass(ObjCInterfaceDecl * superCls) { SuperClass = superCls; }
+  void setSuperClass(ObjCInterfaceDecl * superCls);
 
   ObjCCategoryDecl* getCategoryList() const { return CategoryList; }
-  void setCategoryList(ObjCCategoryDecl *category) {
-    CategoryList = category;
-  }
+  void setCategoryList(ObjCCategoryDecl *category);
 
   /// isSuperClassOf - Return true if this class is the specified class or is a
   /// super class of the specified interface class.
@@ -731,9 +729,7 @@ public:
   /// setProtocolList - Set the list of protocols that this interface
   /// implements.
   void setProtocolList(ObjCProtocolDecl *const*List, unsigned Num,
-                       const SourceLocation *Locs, ASTContext &C) {
-    ReferencedProtocols.set(List, Num, Locs, C);
-  }
+                       const SourceLocation *Locs, ASTContext &C);
 
   ObjCProtocolDecl *lookupProtocolNamed(IdentifierInfo *PName);
 
@@ -918,9 +914,7 @@ public:
   /// setProtocolList - Set the list of protocols that this interface
   /// implements.
   void setProtocolList(ObjCProtocolDecl *const*List, unsigned Num,
-                       const SourceLocation *Locs, ASTContext &C) {
-    ReferencedProtocols.set(List, Num, Locs, C);
-  }
+                       const SourceLocation *Locs, ASTContext &C);
 
   const ObjCProtocolList &getReferencedProtocols() const {
     return ReferencedProtocols;
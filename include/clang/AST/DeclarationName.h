@@ -311,7 +311,7 @@ inline bool operator>=(DeclarationName LHS, DeclarationName RHS) {
 /// retrieved using its member functions (e.g.,
 /// getCXXConstructorName).
 class DeclarationNameTable {
-  void *CXXSpecialNamesImpl; // Actually a FoldingSet<CXXSpecialName> *
+  void *CXXSpecialNamesImpl; // Actually a CXXSpecialNameTable *
   CXXOperatorIdName *CXXOperatorNames; // Operator names
   void *CXXLiteralOperatorNames; // Actually a FoldingSet<...> *
 
@@ -359,6 +359,10 @@ public:
   /// getCXXLiteralOperatorName - Get the name of the literal operator function
   /// with II as the identifier.
   DeclarationName getCXXLiteralOperatorName(IdentifierInfo *II);
+
+  /// PrintStats - Print how often the names of special members were looked
+  /// up, and how many of them there are.
+  void PrintStats() const;
 };
 
 /// Insertion operator for diagnostics.  This allows sending DeclarationName's
@@ -2419,8 +2419,11 @@ public:
 /// return NULL, indicating that the current initializer list also
 /// serves as its syntactic form.
 class InitListExpr : public Expr {
-  // FIXME: Eliminate this vector in favor of ASTContext allocation
-  std::vector<Stmt *> InitExprs;
+  /// InitExprs - The initializers, allocated from the ASTContext.  The
+  /// syntactic form is allocated at its exact size; the semantic form grows
+  /// as the initializers of its subobjects are filled in.
+  Stmt **InitExprs;
+  unsigned NumInits, InitCapacity;
   SourceLocation LBraceLoc, RBraceLoc;
 
   /// Contains the initializer list that describes the syntactic form
@@ -2435,14 +2438,22 @@ class InitListExpr : public Expr {
   /// designator in it. This is a temporary marker used by CodeGen.
   bool HadArrayRangeDesignator;
 
+  /// \brief Make room for at least MinCapacity initializers.
+  void growInits(ASTContext &C, unsigned MinCapacity);
+
+protected:
+  virtual void DoDestroy(ASTContext &C);
+
 public:
-  InitListExpr(SourceLocation lbraceloc, Expr **initexprs, unsigned numinits,
-               SourceLocation rbraceloc);
+  InitListExpr(ASTContext &C, SourceLocation lbraceloc, Expr **initexprs,
+               unsigned numinits, SourceLocation rbraceloc);
 
   /// \brief Build an empty initializer list.
-  explicit InitListExpr(EmptyShell Empty) : Expr(InitListExprClass, Empty) { }
+  explicit InitListExpr(EmptyShell Empty)
+    : Expr(InitListExprClass, Empty), InitExprs(0), NumInits(0),
+      InitCapacity(0) { }
 
-  unsigned getNumInits() const { return InitExprs.size(); }
+  unsigned getNumInits() const { return NumInits; }
 
   const Expr* getInit(unsigned Init) const {
     assert(Init < getNumInits() && "Initializer access out of range!");
@@ -2460,7 +2471,7 @@ public:
   }
 
   /// \brief Reserve space for some number of initializers.
-  void reserveInits(unsigned NumInits);
+  void reserveInits(ASTContext &C, unsigned NumInits);
 
   /// @brief Specify the number of initializers
   ///
@@ -2477,7 +2488,7 @@ public:
   /// When @p Init is out of range for this initializer list, the
   /// initializer list will be extended with NULL expressions to
   /// accomodate the new entry.
-  Expr *updateInit(unsigned Init, Expr *expr);
+  Expr *updateInit(ASTContext &C, unsigned Init, Expr *expr);
 
   /// \brief If this initializes a union, specifies which field in the
   /// union to initialize.
@@ -2523,13 +2534,13 @@ public:
   virtual child_iterator child_begin();
   virtual child_iterator child_end();
 
-  typedef std::vector<Stmt *>::iterator iterator;
-  typedef std::vector<Stmt *>::reverse_iterator reverse_iterator;
+  typedef Stmt **iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
 
-  iterator begin() { return InitExprs.begin(); }
-  iterator end() { return InitExprs.end(); }
-  reverse_iterator rbegin() { return InitExprs.rbegin(); }
-  reverse_iterator rend() { return InitExprs.rend(); }
+  iterator begin() { return InitExprs; }
+  iterator end() { return InitExprs + NumInits; }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
 };
 
 /// @brief Represents a C99 designated initializer expression.
@@ -22,9 +22,12 @@
 namespace clang {
 
 class ASTConsumer;
+class ASTRecordLayout;
 class Decl;
 class DeclContext;
 class ExternalSemaSource; // layering violation required for downcasting
+class FunctionDecl;
+class RecordDecl;
 class Stmt;
 
 /// \brief The deserialized representation of a set of declarations
@@ -82,6 +85,22 @@ public:
   /// LazyOffsetPtr.
   virtual Stmt *GetDeclStmt(uint64_t Offset) = 0;
 
+  /// \brief Deserialize the bodies of the given functions, which are
+  /// about to be needed.
+  ///
+  /// This is only a hint: bodies are still read on demand by
+  /// FunctionDecl::getBody(). An external source may read all of them
+  /// at once, in the order in which they are stored.
+  virtual void PrefetchFunctionBodies(const FunctionDecl * const *Begin,
+                                      const FunctionDecl * const *End) { }
+
+  /// \brief Retrieve the layout of the given record definition, if the
+  /// external source stores it.
+  ///
+  /// \returns a newly allocated layout, which the ASTContext takes over, or
+  /// NULL if the layout has to be computed.
+  virtual const ASTRecordLayout *GetRecordLayout(const RecordDecl *D);
+
   /// \brief Read all of the declarations lexically stored in a
   /// declaration context.
   ///
@@ -120,6 +139,10 @@ public:
   /// \brief Print any statistics that have been gathered regarding
   /// the external AST source.
   virtual void PrintStats();
+
+  /// \brief Return the number of bytes used by the external AST source for
+  /// its own buffers and tables.
+  virtual size_t getMemoryUsage() const;
 };
 
 /// \brief A lazy pointer to an AST node (of base type T) that resides
@@ -170,6 +193,13 @@ public:
   /// \brief Whether this pointer is currently stored as an offset.
   bool isOffset() const { return Ptr & 0x01; }
 
+  /// \brief Retrieve the offset of the AST node within the external AST
+  /// source, which is only available while isOffset().
+  uint64_t getOffset() const {
+    assert(isOffset() && "AST node has already been deserialized");
+    return Ptr >> 1;
+  }
+
   /// \brief Retrieve the pointer to the AST node that this lazy pointer
   ///
   /// \param Source the external AST source.
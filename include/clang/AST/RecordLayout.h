@@ -127,6 +127,8 @@ private:
 
   friend class ASTContext;
   friend class ASTRecordLayoutBuilder;
+  friend class PCHReader;
+  friend class PCHWriter;
 
   ASTRecordLayout(uint64_t size, unsigned alignment, unsigned datasize,
                   const uint64_t *fieldoffsets, unsigned fieldcount)
@@ -59,8 +59,14 @@ protected:
   /// If there is only one declaration, it is <pointer to self, true>
   DeclLink RedeclLink;
 
+  /// \brief The first declaration of the chain, so that it and, through its
+  /// RedeclLink, the latest declaration are found without walking the chain.
+  decl_type *FirstRedecl;
+
 public:
-  Redeclarable() : RedeclLink(LatestDeclLink(static_cast<decl_type*>(this))) { }
+  Redeclarable()
+    : RedeclLink(LatestDeclLink(static_cast<decl_type*>(this))),
+      FirstRedecl(static_cast<decl_type*>(this)) { }
 
   /// \brief Return the previous declaration of this declaration or NULL if this
   /// is the first declaration.
@@ -76,30 +82,20 @@ public:
 
   /// \brief Return the first declaration of this declaration or itself if this
   /// is the only declaration.
-  decl_type *getFirstDeclaration() {
-    decl_type *D = static_cast<decl_type*>(this);
-    while (D->getPreviousDeclaration())
-      D = D->getPreviousDeclaration();
-    return D;
-  }
+  decl_type *getFirstDeclaration() { return FirstRedecl; }
 
   /// \brief Return the first declaration of this declaration or itself if this
   /// is the only declaration.
-  const decl_type *getFirstDeclaration() const {
-    const decl_type *D = static_cast<const decl_type*>(this);
-    while (D->getPreviousDeclaration())
-      D = D->getPreviousDeclaration();
-    return D;
-  }
+  const decl_type *getFirstDeclaration() const { return FirstRedecl; }
 
   /// \brief Returns the most recent (re)declaration of this declaration.
   decl_type *getMostRecentDeclaration() {
-    return getFirstDeclaration()->RedeclLink.getNext();
+    return FirstRedecl->RedeclLink.getNext();
   }
 
   /// \brief Returns the most recent (re)declaration of this declaration.
   const decl_type *getMostRecentDeclaration() const {
-    return getFirstDeclaration()->RedeclLink.getNext();
+    return FirstRedecl->RedeclLink.getNext();
   }
   
   /// \brief Set the previous declaration. If PrevDecl is NULL, set this as the
@@ -122,6 +118,7 @@ public:
 
     // First one will point to this one as latest.
     First->RedeclLink = LatestDeclLink(static_cast<decl_type*>(this));
+    FirstRedecl = First;
   }
 
   /// \brief Iterates through all the redeclarations of the same decl.
@@ -127,12 +127,12 @@ public:
   // or by doing a placement new.
   void* operator new(size_t bytes, ASTContext& C,
                      unsigned alignment = 16) throw() {
-    return ::operator new(bytes, C, alignment);
+    return C.AllocateStmt(bytes, alignment);
   }
 
   void* operator new(size_t bytes, ASTContext* C,
                      unsigned alignment = 16) throw() {
-    return ::operator new(bytes, *C, alignment);
+    return C->AllocateStmt(bytes, alignment);
   }
 
   void* operator new(size_t bytes, void* mem) throw() {
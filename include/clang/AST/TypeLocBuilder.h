@@ -17,6 +17,7 @@
 
 #include "clang/AST/TypeLoc.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "clang/AST/ASTContext.h"
 
 namespace clang {
@@ -42,13 +43,18 @@ class TypeLocBuilder {
   /// The inline buffer.
   char InlineBuffer[InlineCapacity];
 
+  /// The allocator larger buffers come from, or null to use the heap.  It
+  /// must outlive the builder; its buffers are never freed by the builder.
+  llvm::BumpPtrAllocator *Scratch;
+
  public:
-  TypeLocBuilder()
-    : Buffer(InlineBuffer), Capacity(InlineCapacity), Index(InlineCapacity)
+  explicit TypeLocBuilder(llvm::BumpPtrAllocator *Scratch = 0)
+    : Buffer(InlineBuffer), Capacity(InlineCapacity), Index(InlineCapacity),
+      Scratch(Scratch)
   {}
 
   ~TypeLocBuilder() {
-    if (Buffer != InlineBuffer)
+    if (Buffer != InlineBuffer && !Scratch)
       delete[] Buffer;
   }
 
@@ -114,13 +120,18 @@ private:
     assert(NewCapacity > Capacity);
 
     // Allocate the new buffer and copy the old data into it.
-    char *NewBuffer = new char[NewCapacity];
+    char *NewBuffer;
+    if (Scratch)
+      NewBuffer = static_cast<char*>(
+                Scratch->Allocate(NewCapacity, llvm::AlignOf<void*>::Alignment));
+    else
+      NewBuffer = new char[NewCapacity];
     unsigned NewIndex = Index + NewCapacity - Capacity;
     memcpy(&NewBuffer[NewIndex],
            &Buffer[Index],
            Capacity - Index);
 
-    if (Buffer != InlineBuffer)
+    if (Buffer != InlineBuffer && !Scratch)
       delete[] Buffer;
 
     Buffer = NewBuffer;
@@ -16,6 +16,7 @@
 #define LLVM_CLANG_FPRINTF_FORMAT_H
 
 #include "clang/AST/CanonicalType.h"
+#include <vector>
 
 namespace clang {
 
@@ -40,6 +41,8 @@ public:
 
   bool isValid() const { return K != InvalidTy; }
 
+  Kind getKind() const { return K; }
+
   const QualType *getSpecificType() const {
     return K == SpecificTy ? &T : 0;
   }
@@ -274,6 +277,52 @@ public:
 bool ParseFormatString(FormatStringHandler &H,
                        const char *beg, const char *end);
 
+/// \brief The callbacks that ParseFormatString made for a format string,
+/// recorded so that they can be replayed to the handlers of other calls that
+/// use the same format string without parsing it again.  The specifiers point
+/// into the parsed characters, which must outlive this object.
+class ParsedFormatString : public FormatStringHandler {
+  struct Callback {
+    enum Kind { IncompleteSpecifier, NullChar, InvalidConversion, Specifier };
+    Kind K;
+    FormatSpecifier FS;
+    const char *Start;
+    unsigned Length;
+  };
+  std::vector<Callback> Callbacks;
+  bool Parsed;
+  bool Stopped;
+
+  void AddCallback(Callback::Kind K, const FormatSpecifier &FS,
+                   const char *Start, unsigned Length);
+
+public:
+  ParsedFormatString() : Parsed(false), Stopped(false) {}
+
+  bool isParsed() const { return Parsed; }
+
+  /// \brief Parse the format string [beg, end) and record its callbacks.
+  void Parse(const char *beg, const char *end);
+
+  /// \brief Make the recorded callbacks to H, stopping where
+  /// ParseFormatString would have, and return what it would have returned.
+  bool Replay(FormatStringHandler &H) const;
+
+  virtual void HandleIncompleteFormatSpecifier(const char *startSpecifier,
+                                               unsigned specifierLen);
+
+  virtual void HandleNullChar(const char *nullCharacter);
+
+  virtual void
+    HandleInvalidConversionSpecifier(const analyze_printf::FormatSpecifier &FS,
+                                     const char *startSpecifier,
+                                     unsigned specifierLen);
+
+  virtual bool HandleFormatSpecifier(const analyze_printf::FormatSpecifier &FS,
+                                     const char *startSpecifier,
+                                     unsigned specifierLen);
+};
+
 } // end printf namespace
 } // end clang namespace
 #endif
@@ -46,10 +46,15 @@ class AnalysisContext {
   llvm::DenseMap<const BlockDecl*,void*> *ReferencedBlockVars;
   llvm::BumpPtrAllocator A;
   bool AddEHEdges;
+
+  /// CFGArena - If not null, the allocator the CFG is built in.  It is shared
+  /// with other contexts and outlives this one.
+  llvm::BumpPtrAllocator *CFGArena;
 public:
-  AnalysisContext(const Decl *d, bool addehedges = false)
+  AnalysisContext(const Decl *d, bool addehedges = false,
+                  llvm::BumpPtrAllocator *cfgArena = 0)
     : D(d), cfg(0), liveness(0), PM(0), ReferencedBlockVars(0),
-      AddEHEdges(addehedges) {}
+      AddEHEdges(addehedges), CFGArena(cfgArena) {}
 
   ~AnalysisContext();
 
@@ -65,6 +70,14 @@ public:
   ParentMap &getParentMap();
   LiveVariables *getLiveVariables();
 
+  /// hasCFG - Return true if the CFG has been built.
+  bool hasCFG() const { return cfg != 0; }
+
+  /// getTotalMemory - Return the number of bytes allocated for the CFG and
+  /// the lists of variables referenced by blocks.  A CFG built in a shared
+  /// arena is not counted.
+  size_t getTotalMemory();
+
   typedef const VarDecl * const * referenced_decls_iterator;
 
   std::pair<referenced_decls_iterator, referenced_decls_iterator>
@@ -78,13 +91,34 @@ public:
 class AnalysisContextManager {
   typedef llvm::DenseMap<const Decl*, AnalysisContext*> ContextMap;
   ContextMap Contexts;
+
+  /// CFGArena - The allocator the CFGs of all contexts are built in, so that
+  /// building many small CFGs does not start a fresh slab for each one.
+  llvm::BumpPtrAllocator CFGArena;
+
+  /// NumReuses - The number of times a context whose CFG had already been
+  /// built was handed out again.
+  unsigned NumReuses;
 public:
+  AnalysisContextManager() : NumReuses(0) {}
   ~AnalysisContextManager();
 
   AnalysisContext *getContext(const Decl *D);
   
-  // Discard all previously created AnalysisContexts.
+  // Discard all previously created AnalysisContexts, and release the memory
+  // of their CFGs for reuse.
   void clear();
+
+  /// getNumContexts - Return the number of contexts created so far.
+  unsigned getNumContexts() const { return Contexts.size(); }
+
+  /// getNumReuses - Return the number of times a context with a CFG was
+  /// handed out again rather than rebuilt.
+  unsigned getNumReuses() const { return NumReuses; }
+
+  /// getTotalMemory - Return the number of bytes allocated by the CFGs of
+  /// the contexts, and the number of CFGs, in rg NumCFGs.
+  size_t getTotalMemory(unsigned &NumCFGs) const;
 };
 
 class LocationContext : public llvm::FoldingSetNode {
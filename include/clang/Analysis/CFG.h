@@ -22,6 +22,7 @@
 #include "clang/Analysis/Support/BumpVector.h"
 #include "clang/Basic/SourceLocation.h"
 #include <cassert>
+#include <vector>
 
 namespace llvm {
   class raw_ostream;
@@ -285,10 +286,13 @@ public:
   //===--------------------------------------------------------------------===//
 
   /// buildCFG - Builds a CFG from an AST.  The responsibility to free the
-  ///   constructed CFG belongs to the caller.
+  ///   constructed CFG belongs to the caller.  If Arena is not null, the
+  ///   blocks and statement lists are allocated from it rather than from an
+  ///   allocator owned by the CFG, and the arena must outlive the CFG.
   static CFG* buildCFG(const Decl *D, Stmt* AST, ASTContext *C,
                        bool AddEHEdges = false,
-                       bool AddScopes = false);
+                       bool AddScopes = false,
+                       llvm::BumpPtrAllocator *Arena = 0);
 
   /// createBlock - Create a new block in the CFG.  The CFG owns the block;
   ///  the caller should not directly free it.
@@ -378,14 +382,19 @@ public:
   // Internal: constructors and data.
   //===--------------------------------------------------------------------===//
 
-  CFG() : Entry(NULL), Exit(NULL), IndirectGotoBlock(NULL), NumBlockIDs(0),
-          BlkExprMap(NULL), Blocks(BlkBVC, 10) {}
+  explicit CFG(llvm::BumpPtrAllocator *Arena = 0)
+    : Entry(NULL), Exit(NULL), IndirectGotoBlock(NULL), NumBlockIDs(0),
+      BlkExprMap(NULL), BlkBVC(Arena), Blocks(BlkBVC, 10) {}
 
   ~CFG();
 
   llvm::BumpPtrAllocator& getAllocator() {
     return BlkBVC.getAllocator();
   }
+
+  /// ownsAllocator - Return true if the memory of the CFG is its own rather
+  ///  than that of an arena shared with other CFGs.
+  bool ownsAllocator() const { return BlkBVC.ownsAllocator(); }
   
   BumpVectorContext &getBumpVectorContext() {
     return BlkBVC;
@@ -408,6 +417,57 @@ private:
   CFGBlockListTy Blocks;
 
 };
+
+/// LinearCFG - A read-only copy of the shape of a CFG, with its blocks stored
+///  in one array in reverse postorder and their edges as lists of indices
+///  into that array.  The blocks that cannot be reached from the entry come
+///  last, in the order of their IDs.  Null successors are left out.  This
+///  suits dataflow solvers, which visit the blocks in this order and can keep
+///  their per-block state in arrays indexed by position.
+class LinearCFG {
+public:
+  struct Block {
+    const CFGBlock *B;
+    /// The successors and predecessors of the block, as ranges of Edges.
+    unsigned SuccBegin, SuccEnd, PredBegin, PredEnd;
+  };
+
+  typedef const unsigned *edge_iterator;
+
+  explicit LinearCFG(const CFG &cfg);
+
+  /// size - Return the number of blocks of the CFG.
+  unsigned size() const { return Blocks.size(); }
+
+  /// getNumReachable - Return the number of blocks that can be reached from
+  ///  the entry; they are the first ones.
+  unsigned getNumReachable() const { return NumReachable; }
+
+  const Block &operator[](unsigned I) const { return Blocks[I]; }
+
+  /// getPosition - Return the position of the block with the given ID.
+  unsigned getPosition(unsigned BlockID) const { return Positions[BlockID]; }
+  unsigned getPosition(const CFGBlock *B) const;
+
+  edge_iterator succ_begin(unsigned I) const {
+    return &Edges[0] + Blocks[I].SuccBegin;
+  }
+  edge_iterator succ_end(unsigned I) const {
+    return &Edges[0] + Blocks[I].SuccEnd;
+  }
+  edge_iterator pred_begin(unsigned I) const {
+    return &Edges[0] + Blocks[I].PredBegin;
+  }
+  edge_iterator pred_end(unsigned I) const {
+    return &Edges[0] + Blocks[I].PredEnd;
+  }
+
+private:
+  std::vector<Block> Blocks;
+  std::vector<unsigned> Edges;
+  std::vector<unsigned> Positions;
+  unsigned NumReachable;
+};
 } // end namespace clang
 
 //===----------------------------------------------------------------------===//
@@ -17,29 +17,70 @@
 #include "clang/Analysis/CFG.h"
 #include "clang/Analysis/ProgramPoint.h"
 #include "clang/Analysis/FlowSensitive/DataflowValues.h"
-#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/BitVector.h"
 #include "functional" // STL
+#include <queue>
+#include <vector>
 
 namespace clang {
 
 //===----------------------------------------------------------------------===//
 /// DataflowWorkListTy - Data structure representing the worklist used for
-///  dataflow algorithms.
+///  dataflow algorithms.  Blocks are dequeued in the order set by setOrder,
+///  or by block ID if no order was set.
 //===----------------------------------------------------------------------===//
 
 class DataflowWorkListTy {
-  typedef llvm::SmallPtrSet<const CFGBlock*,20> BlockSet;
-  BlockSet wlist;
+  typedef std::pair<unsigned, const CFGBlock*> Entry;
+  typedef std::priority_queue<Entry, std::vector<Entry>,
+                              std::greater<Entry> > BlockQueue;
+  BlockQueue wlist;
+  llvm::BitVector Enqueued;
+
+  /// Order - The position of each block in the order of the worklist,
+  ///  indexed by block ID.
+  std::vector<unsigned> Order;
+
+  unsigned getOrder(const CFGBlock* B) const {
+    unsigned ID = B->getBlockID();
+    return ID < Order.size() ? Order[ID] : ID;
+  }
+
 public:
+  /// setOrder - Dequeue the blocks of a CFG in reverse postorder, in which a
+  ///  forward analysis sees the predecessors of a block before the block, or
+  ///  in postorder for a backward analysis.  The blocks that cannot be
+  ///  reached from the entry come last.
+  void setOrder(const CFG& cfg, bool PostOrder) {
+    LinearCFG Linear(cfg);
+    unsigned NumReachable = Linear.getNumReachable();
+    Order.assign(cfg.getNumBlockIDs(), ~0U);
+    for (unsigned I = 0, N = Linear.size(); I != N; ++I) {
+      unsigned Pos = I;
+      if (PostOrder && I < NumReachable)
+        Pos = NumReachable - 1 - I;
+      Order[Linear[I].B->getBlockID()] = Pos;
+    }
+  }
+
   /// enqueue - Add a block to the worklist.  Blocks already on the
   ///  worklist are not added a second time.
-  void enqueue(const CFGBlock* B) { wlist.insert(B); }
+  void enqueue(const CFGBlock* B) {
+    unsigned ID = B->getBlockID();
+    if (ID >= Enqueued.size())
+      Enqueued.resize(ID + 1);
+    if (Enqueued[ID])
+      return;
+    Enqueued.set(ID);
+    wlist.push(Entry(getOrder(B), B));
+  }
 
-  /// dequeue - Remove a block from the worklist.
+  /// dequeue - Remove the first block in order from the worklist.
   const CFGBlock* dequeue() {
     assert (!wlist.empty());
-    const CFGBlock* B = *wlist.begin();
-    wlist.erase(B);
+    const CFGBlock* B = wlist.top().second;
+    wlist.pop();
+    Enqueued.reset(B->getBlockID());
     return B;
   }
 
@@ -188,6 +229,10 @@ private:
   /// SolveDataflowEquations - Perform the actual worklist algorithm
   ///  to compute dataflow values.
   void SolveDataflowEquations(CFG& cfg, bool recordStmtValues) {
+    // Visit the blocks in the order that makes the values converge in the
+    // fewest passes over loops.
+    WorkList.setOrder(cfg, isBackward(AnalysisDirTag()));
+
     // Enqueue all blocks to ensure the dataflow values are computed
     // for every block.  Not all blocks are guaranteed to reach the exit block.
     for (CFG::iterator I=cfg.begin(), E=cfg.end(); I!=E; ++I)
@@ -201,6 +246,9 @@ private:
     }
   }
 
+  static bool isBackward(dataflow::forward_analysis_tag) { return false; }
+  static bool isBackward(dataflow::backward_analysis_tag) { return true; }
+
   void ProcessMerge(CFG& cfg, const CFGBlock* B) {
     ValTy& V = TF.getVal();
     TF.SetTopValue(V);
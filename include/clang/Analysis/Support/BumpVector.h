@@ -37,6 +37,15 @@ public:
   /// BumpPtrAllocator.  This BumpPtrAllocator is not destroyed when the
   /// BumpVectorContext object is destroyed.
   BumpVectorContext(llvm::BumpPtrAllocator &A) : Alloc(&A, 0) {}
+
+  /// Construct a new BumpVectorContext that reuses \p A if it is not null,
+  /// and creates and owns a new BumpPtrAllocator otherwise.
+  explicit BumpVectorContext(llvm::BumpPtrAllocator *A)
+    : Alloc(A ? A : new llvm::BumpPtrAllocator(), A == 0) {}
+
+  /// ownsAllocator - Return true if the BumpPtrAllocator is destroyed along
+  /// with this BumpVectorContext.
+  bool ownsAllocator() const { return Alloc.getInt(); }
   
   ~BumpVectorContext() {
     if (Alloc.getInt())
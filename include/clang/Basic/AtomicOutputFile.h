@@ -0,0 +1,67 @@
+//===--- AtomicOutputFile.h - Files replaced in a single step ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the AtomicOutputFile interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_ATOMICOUTPUTFILE_H
+#define LLVM_CLANG_BASIC_ATOMICOUTPUTFILE_H
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/Path.h"
+#include <string>
+
+namespace llvm {
+  class raw_fd_ostream;
+  class raw_ostream;
+}
+
+namespace clang {
+
+/// \brief A file that is written to a temporary file next to it and renamed
+/// into place once it was written completely.
+///
+/// Caches shared between concurrent compilations are written this way, so
+/// that readers see either the old file or the new one, never a partially
+/// written one.  Nothing replaces the file unless every byte written to the
+/// stream made it to the disk; a short write leaves the old file alone.
+/// The temporary file is removed unless commit() succeeds.
+class AtomicOutputFile {
+  std::string Path;
+  llvm::sys::Path TempPath;
+  llvm::OwningPtr<llvm::raw_fd_ostream> Out;
+
+  AtomicOutputFile(const AtomicOutputFile &); // do not implement
+  AtomicOutputFile &operator=(const AtomicOutputFile &); // do not implement
+
+public:
+  explicit AtomicOutputFile(llvm::StringRef Path);
+  ~AtomicOutputFile();
+
+  /// \brief Create the temporary file.
+  ///
+  /// \returns true on error, with a description in \p ErrorInfo.
+  bool open(std::string &ErrorInfo);
+
+  /// \brief The stream writing to the temporary file, once it is open.
+  llvm::raw_ostream &getStream();
+
+  /// \brief Close the temporary file and, if everything written to it made
+  /// it to the disk, rename it over the file.
+  ///
+  /// \returns true on error, with a description in \p ErrorInfo.  The file
+  /// is left as it was in that case.
+  bool commit(std::string &ErrorInfo);
+};
+
+} // end namespace clang
+
+#endif
@@ -15,7 +15,9 @@
 #ifndef LLVM_CLANG_BASIC_BUILTINS_H
 #define LLVM_CLANG_BASIC_BUILTINS_H
 
+#include "llvm/ADT/StringRef.h"
 #include <cstring>
+#include <vector>
 
 // VC++ defines 'alloca' as an object-like macro, which interferes with our
 // builtins.
@@ -56,17 +58,30 @@ struct Info {
 class Context {
   const Info *TSRecords;
   unsigned NumTSRecords;
+
+  /// NameTable - Open-addressed hash table from builtin names to builtin IDs,
+  /// with 0 marking an empty slot.  Its size is a power of two, and it is
+  /// built on the first call to getBuiltinID().
+  mutable std::vector<unsigned short> NameTable;
+
+  void BuildNameTable() const;
 public:
   Context(const TargetInfo &Target);
 
   /// InitializeBuiltins - Mark the identifiers for all the builtins with their
   /// appropriate builtin ID # and mark any non-portable builtin identifiers as
-  /// such.
+  /// such.  The identifiers are not created here; the table looks up the
+  /// builtin ID of each identifier when it is first created.
   void InitializeBuiltins(IdentifierTable &Table, bool NoBuiltins = false);
 
+  /// getBuiltinID - Return the ID of the builtin with the given name, or 0 if
+  /// there is none.  If \arg NoBuiltins is set, predefined library functions
+  /// are not recognized.
+  unsigned getBuiltinID(llvm::StringRef Name, bool NoBuiltins) const;
+
   /// \brief Popular the vector with the names of all of the builtins.
   void GetBuiltinNames(llvm::SmallVectorImpl<const char *> &Names,
-                       bool NoBuiltins);
+                       bool NoBuiltins) const;
 
   /// Builtin::GetName - Return the identifier name for the specified builtin,
   /// e.g. "__builtin_abs".
@@ -135,6 +150,9 @@ public:
 
 private:
   const Info &GetRecord(unsigned ID) const;
+
+  /// isEnabled - Return true if the builtin with the given ID is recognized.
+  bool isEnabled(unsigned ID, bool NoBuiltins) const;
 };
 
 }
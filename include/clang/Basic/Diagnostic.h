@@ -212,6 +212,7 @@ private:
 
   unsigned NumDiagnostics;    // Number of diagnostics reported
   unsigned NumErrors;         // Number of diagnostics that are errors
+  unsigned NumDropped;        // Number of diagnostics dropped at Report time
 
   /// CustomDiagInfo - Information for uniquing and looking up custom diags.
   diag::CustomDiagInfo *CustomDiagInfo;
@@ -327,6 +328,9 @@ public:
   unsigned getNumErrors() const { return NumErrors; }
   unsigned getNumDiagnostics() const { return NumDiagnostics; }
 
+  /// PrintStats - Print some statistics about the diagnostics reported.
+  void PrintStats() const;
+
   /// getCustomDiagID - Return an ID for a diagnostic with the specified message
   /// and level.  If this is the first request for this diagnosic, it is
   /// registered and created, otherwise the existing ID is returned.
@@ -442,6 +446,10 @@ private:
   /// This is set to ~0U when there is no diagnostic in flight.
   unsigned CurDiagID;
 
+  /// CurDiagLevel - The level of the current diagnostic, as determined by
+  /// ClassifyDiag when it was reported.
+  Diagnostic::Level CurDiagLevel;
+
   enum {
     /// MaxArguments - The maximum number of arguments we can hold. We currently
     /// only support up to 10 arguments (%0-%9).  A single diagnostic with more
@@ -483,6 +491,15 @@ private:
   /// to insert, remove, or modify at a particular position.
   CodeModificationHint CodeModificationHints[MaxCodeModificationHints];
 
+  /// ClassifyDiag - Determine the level of the diagnostic that was just
+  /// reported and update the state that depends on it.  This happens before
+  /// any arguments are added, so diagnostics that will be ignored never have
+  /// their arguments, ranges and hints stored.
+  ///
+  /// \returns true if the diagnostic will be emitted, false if it will be
+  /// suppressed.
+  bool ClassifyDiag();
+
   /// ProcessDiag - This is the method used to report a diagnostic that is
   /// finally fully formed.
   ///
@@ -685,6 +702,14 @@ inline DiagnosticBuilder Diagnostic::Report(FullSourceLoc Loc, unsigned DiagID){
   assert(CurDiagID == ~0U && "Multiple diagnostics in flight at once!");
   CurDiagLoc = Loc;
   CurDiagID = DiagID;
+
+  // Hand out an inert builder for diagnostics that will be dropped, so that
+  // their arguments are never stored.
+  if (!ClassifyDiag()) {
+    ++NumDropped;
+    Clear();
+    return DiagnosticBuilder(DiagnosticBuilder::Suppress);
+  }
   return DiagnosticBuilder(this);
 }
 inline DiagnosticBuilder Diagnostic::Report(unsigned DiagID) {
@@ -809,6 +834,10 @@ public:
   StoredDiagnostic();
   StoredDiagnostic(Diagnostic::Level Level, const DiagnosticInfo &Info);
   StoredDiagnostic(Diagnostic::Level Level, llvm::StringRef Message);
+  StoredDiagnostic(Diagnostic::Level Level, const FullSourceLoc &Loc,
+                   llvm::StringRef Message,
+                   const SourceRange *Ranges, unsigned NumRanges,
+                   const CodeModificationHint *FixIts, unsigned NumFixIts);
   ~StoredDiagnostic();
 
   /// \brief Evaluates true when this object stores a diagnostic.
@@ -827,19 +856,6 @@ public:
   fixit_iterator fixit_begin() const { return FixIts.begin(); }
   fixit_iterator fixit_end() const { return FixIts.end(); }
   unsigned fixit_size() const { return FixIts.size(); }
-
-  /// Serialize - Serialize the given diagnostic (with its diagnostic
-  /// level) to the given stream. Serialization is a lossy operation,
-  /// since the specific diagnostic ID and any macro-instantiation
-  /// information is lost.
-  void Serialize(llvm::raw_ostream &OS) const;
-
-  /// Deserialize - Deserialize the first diagnostic within the memory
-  /// [Memory, MemoryEnd), producing a new diagnostic builder describing the
-  /// deserialized diagnostic. If the memory does not contain a
-  /// diagnostic, returns a diagnostic builder with no diagnostic ID.
-  static StoredDiagnostic Deserialize(FileManager &FM, SourceManager &SM, 
-                                   const char *&Memory, const char *MemoryEnd);
 };
 
 /// DiagnosticClient - This is an abstract interface implemented by clients of
@@ -14,6 +14,7 @@
 #ifndef LLVM_CLANG_FILEMANAGER_H
 #define LLVM_CLANG_FILEMANAGER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
@@ -24,6 +25,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+namespace llvm {
+  class MemoryBuffer;
+}
+
 namespace clang {
 class FileManager;
 
@@ -127,6 +132,51 @@ public:
   virtual int stat(const char *path, struct stat *buf);
 };
 
+/// \brief A stat cache that answers for files and directories that only exist
+/// in memory, and forwards every other query down the chain.
+///
+/// Clients register the contents of files by path; the directories leading to
+/// them are registered implicitly.  Header search finds these files through
+/// FileManager as if they were on disk, and a SourceManager given the overlay
+/// takes their contents from it instead of reading them.  Paths are matched
+/// exactly as spelled, so they should be registered the way they will be
+/// looked up.
+class VirtualFileOverlay : public StatSysCallCache {
+  struct Node {
+    /// \brief The contents of the file, or null for a directory.
+    const llvm::MemoryBuffer *Buffer;
+    time_t ModTime;
+    ino_t Inode;
+
+    Node() : Buffer(0), ModTime(0), Inode(0) {}
+  };
+
+  llvm::StringMap<Node, llvm::BumpPtrAllocator> Nodes;
+  ino_t NextInode;
+
+  void addNode(llvm::StringRef Path, const llvm::MemoryBuffer *Buffer,
+               time_t ModTime);
+
+public:
+  VirtualFileOverlay() : NextInode(1) {}
+  ~VirtualFileOverlay();
+
+  /// \brief Register a file with the given contents, along with its parent
+  /// directories.  Takes ownership of \p Buffer.  A file that was already
+  /// registered under this path is replaced.
+  void addFile(llvm::StringRef Path, const llvm::MemoryBuffer *Buffer,
+               time_t ModTime = 0);
+
+  /// \brief Return true if \p Path names a registered file or directory.
+  bool contains(llvm::StringRef Path) const;
+
+  /// \brief Return the contents of the file registered as \p Path, or null
+  /// if there is none.  The overlay keeps ownership of the buffer.
+  const llvm::MemoryBuffer *getBuffer(llvm::StringRef Path) const;
+
+  virtual int stat(const char *path, struct stat *buf);
+};
+
 /// FileManager - Implements support for file system lookup, file system
 /// caching, and directory search management.  This also handles more advanced
 /// properties, such as uniquing files based on "inode", so that a file with two
@@ -136,6 +186,7 @@ class FileManager {
 
   class UniqueDirContainer;
   class UniqueFileContainer;
+  struct DirectoryListing;
 
   /// UniqueDirs/UniqueFiles - Cache for existing directories/files.
   ///
@@ -155,17 +206,40 @@ class FileManager {
   /// \brief The virtual files that we have allocated.
   llvm::SmallVector<FileEntry *, 4> VirtualFileEntries;
 
+  /// \brief Whether negative lookups are answered from the contents of the
+  /// directory, read once with readdir, instead of with a stat call.
+  bool CacheDirListings;
+
+  /// \brief The contents of each directory read so far, if directory
+  /// listings are cached.
+  llvm::DenseMap<const DirectoryEntry *, DirectoryListing *> DirListings;
+
   // Statistics.
   unsigned NumDirLookups, NumFileLookups;
   unsigned NumDirCacheMisses, NumFileCacheMisses;
+  unsigned NumDirListingsRead, NumListingMisses;
 
   // Caching.
   llvm::OwningPtr<StatSysCallCache> StatCache;
 
+  /// \brief The overlay of in-memory files, if any.  It is owned by the
+  /// chain of stat caches.
+  VirtualFileOverlay *Overlay;
+
+  /// \brief The stat cache kept at the end of the chain, if any.  It is
+  /// owned by the chain of stat caches.
+  StatSysCallCache *FallbackStatCache;
+
   int stat_cached(const char* path, struct stat* buf) {
     return StatCache.get() ? StatCache->stat(path, buf) : stat(path, buf);
   }
 
+  /// \brief Return true if the cached listing of \p Dir shows that it has no
+  /// entry called \p Name.
+  bool isKnownMissing(const DirectoryEntry *Dir, llvm::StringRef Name);
+
+  void clearDirectoryListings();
+
 public:
   FileManager();
   ~FileManager();
@@ -180,12 +254,46 @@ public:
   ///
   /// \param AtBeginning whether this new stat cache must be installed at the
   /// beginning of the chain of stat caches. Otherwise, it will be added to
-  /// the end of the chain.
+  /// the end of the chain, before the fallback stat cache if there is one.
   void addStatCache(StatSysCallCache *statCache, bool AtBeginning = false);
 
   /// \brief Removes the provided StatSysCallCache object from the file manager.
   void removeStatCache(StatSysCallCache *statCache);
+
+  /// \brief Installs \p C at the end of the chain of stat caches and keeps it
+  /// there, so that it only answers the queries every other stat cache,
+  /// including those added later, passes on.  Ownership is transferred to the
+  /// FileManager.
+  void setFallbackStatCache(StatSysCallCache *C);
   
+  /// \brief Installs \p O at the beginning of the chain of stat caches, so
+  /// that the files and directories registered with it are found without
+  /// touching the disk.  Ownership is transferred to the FileManager.
+  void setVirtualFileOverlay(VirtualFileOverlay *O);
+
+  /// \brief Retrieve the overlay of in-memory files, if one was installed.
+  VirtualFileOverlay *getVirtualFileOverlay() const { return Overlay; }
+
+  /// \brief Answer lookups of paths that do not exist from the contents of
+  /// their directory, read once per directory, instead of with a stat call
+  /// per path.  This pays off when most lookups miss, as they do for header
+  /// search with many search paths.
+  ///
+  /// Names are compared without regard to case, so case-insensitive file
+  /// systems never see a false negative.
+  void setCacheDirectoryListings(bool Cache);
+
+  /// \brief Check whether any directory with a cached listing was modified
+  /// since it was read.  If so, forget the listings along with every lookup
+  /// that found nothing, so that files created since then are found.
+  void revalidateDirectoryListings();
+
+  /// \brief Take over the directory listings of \p Old, a file manager that
+  /// earlier lookups of the same files went through, if this one caches
+  /// listings.  The listings are revalidated first, so that files created
+  /// since they were read are found.
+  void takeDirectoryListings(FileManager &Old);
+
   /// getDirectory - Lookup, cache, and verify the specified directory.  This
   /// returns null if the directory doesn't exist.
   ///
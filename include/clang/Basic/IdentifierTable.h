@@ -31,7 +31,9 @@ namespace llvm {
 namespace clang {
   class LangOptions;
   class IdentifierInfo;
+  namespace Builtin { class Context; }
   class IdentifierTable;
+  class SharedIdentifierTable;
   class SourceLocation;
   class MultiKeywordSelector; // private class used by Selector
   class DeclarationName;      // AST class that stores declaration names
@@ -66,6 +68,7 @@ class IdentifierInfo {
   void operator=(const IdentifierInfo&);  // NONASSIGNABLE.
 
   friend class IdentifierTable;
+  friend class SharedIdentifierTable;
 
 public:
   IdentifierInfo();
@@ -254,6 +257,82 @@ public:
   virtual IdentifierInfo *GetIdentifier(unsigned ID) = 0;
 };
 
+/// SharedIdentifierTable - An immutable table of identifiers that any number
+/// of IdentifierTables, possibly on different threads, can use as their base.
+/// It is filled in through an ordinary IdentifierTable (the seed), which
+/// already holds the keywords of the language it was created for; clients
+/// typically add the builtins and the identifiers of a common PCH file to it.
+/// freeze() then copies out the names and the keyword and builtin bits of
+/// each identifier and discards the seed.
+///
+/// Once frozen, the table is only ever read, so lookups need no locking.
+/// IdentifierTables built on top of it skip adding the keywords and builtins
+/// themselves, and only create an IdentifierInfo for the shared identifiers
+/// their translation unit actually uses.
+class SharedIdentifierTable {
+public:
+  /// SharedIdentifierInfo - The parts of an IdentifierInfo that are the same
+  /// for every translation unit.
+  struct SharedIdentifierInfo {
+    unsigned TokenID           : 8;
+    unsigned ObjCOrBuiltinID   :10;
+    bool IsExtension           : 1;
+    bool IsCPPOperatorKeyword  : 1;
+  };
+
+private:
+  typedef llvm::StringMap<SharedIdentifierInfo, llvm::BumpPtrAllocator>
+    HashTableTy;
+  HashTableTy HashTable;
+
+  /// Seed - The table the identifiers are added to until freeze() is called.
+  llvm::OwningPtr<IdentifierTable> Seed;
+
+  /// KeywordLangBits - The language options that determine the keywords,
+  /// as computed by getKeywordLangBits().
+  unsigned KeywordLangBits;
+
+  /// NumBuiltins - The number of identifiers marked as builtins.
+  unsigned NumBuiltins;
+
+  SharedIdentifierTable(const SharedIdentifierTable&); // DO NOT IMPLEMENT
+  void operator=(const SharedIdentifierTable&);        // DO NOT IMPLEMENT
+public:
+  explicit SharedIdentifierTable(const LangOptions &LangOpts);
+  ~SharedIdentifierTable();
+
+  /// getSeed - Return the table to add identifiers to before freezing.
+  IdentifierTable &getSeed() {
+    assert(Seed.get() && "Shared identifier table is already frozen");
+    return *Seed;
+  }
+
+  /// freeze - Make the table immutable.  This must happen before it is used
+  /// as the base of any IdentifierTable.
+  void freeze();
+  bool isFrozen() const { return Seed.get() == 0; }
+
+  /// isCompatibleWith - Return true if the table has the same keywords as a
+  /// table created for \arg LangOpts would have.
+  bool isCompatibleWith(const LangOptions &LangOpts) const;
+
+  /// lookup - Return the shared information for the given identifier, or null
+  /// if the table does not know it.  Safe to call from any thread.
+  const SharedIdentifierInfo *lookup(llvm::StringRef Name) const {
+    assert(isFrozen() && "Shared identifier table used before freezing");
+    HashTableTy::const_iterator I = HashTable.find(Name);
+    return I == HashTable.end() ? 0 : &I->getValue();
+  }
+
+  /// getBuiltinID - Return the builtin ID of the given identifier, or 0.
+  unsigned getBuiltinID(llvm::StringRef Name) const;
+
+  unsigned getNumBuiltins() const { return NumBuiltins; }
+  unsigned size() const { return HashTable.size(); }
+
+  static unsigned getKeywordLangBits(const LangOptions &LangOpts);
+};
+
 /// IdentifierTable - This table implements an efficient mapping from strings to
 /// IdentifierInfo nodes.  It has no other purpose, but this is an
 /// extremely performance-critical piece of the code, as each occurrance of
@@ -266,11 +345,52 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// SharedBase - The frozen table that provides the keywords, and possibly
+  /// the builtins, of this table, or null.
+  const SharedIdentifierTable *SharedBase;
+
+  /// UseSharedBuiltins - True if the builtin IDs of SharedBase apply to this
+  /// table; see adoptSharedBuiltins().
+  bool UseSharedBuiltins;
+
+  /// NumSharedMaterialized - The number of IdentifierInfos created from the
+  /// shared base.
+  unsigned NumSharedMaterialized;
+
+  /// BuiltinLookup - The builtins to recognize as identifiers are created,
+  /// or null; see setBuiltinLookup().
+  const Builtin::Context *BuiltinLookup;
+  bool NoBuiltins;
+
+  /// CreateEntry - Create the IdentifierInfo for a string that has no entry
+  /// yet, initializing it from the shared base if that knows the string.
+  IdentifierInfo &CreateEntry(llvm::StringMapEntry<IdentifierInfo*> &Entry);
+
 public:
   /// IdentifierTable ctor - Create the identifier table, populating it with
   /// info about the language keywords for the language specified by LangOpts.
+  /// If \arg sharedBase is compatible with LangOpts, the keywords come from it
+  /// instead, as each of them is first used.
   IdentifierTable(const LangOptions &LangOpts,
-                  IdentifierInfoLookup* externalLookup = 0);
+                  IdentifierInfoLookup* externalLookup = 0,
+                  const SharedIdentifierTable *sharedBase = 0);
+
+  /// getSharedBase - Return the shared table this table is built on, if any.
+  const SharedIdentifierTable *getSharedBase() const { return SharedBase; }
+
+  /// adoptSharedBuiltins - Take the builtin IDs of identifiers from the
+  /// shared base, which must hold exactly the builtins this table would
+  /// otherwise be initialized with.
+  void adoptSharedBuiltins();
+
+  /// setBuiltinLookup - Give each identifier created from now on the ID of
+  /// the builtin in \arg Builtins it names, if any, and do the same for the
+  /// identifiers already in the table.
+  void setBuiltinLookup(const Builtin::Context *Builtins, bool NoBuiltins);
+
+  /// materializeBuiltins - Create the identifiers for all of the builtins
+  /// that the table only recognizes when they are first used.
+  void materializeBuiltins();
 
   /// \brief Set the external identifier lookup mechanism.
   void setExternalIdentifierLookup(IdentifierInfoLookup *IILookup) {
@@ -301,15 +421,7 @@ public:
     }
 
     // Lookups failed, make a new IdentifierInfo.
-    void *Mem = getAllocator().Allocate<IdentifierInfo>();
-    II = new (Mem) IdentifierInfo();
-    Entry.setValue(II);
-
-    // Make sure getName() knows how to find the IdentifierInfo
-    // contents.
-    II->Entry = &Entry;
-
-    return *II;
+    return CreateEntry(Entry);
   }
 
   /// \brief Creates a new IdentifierInfo from the given string.
@@ -325,19 +437,8 @@ public:
     llvm::StringMapEntry<IdentifierInfo*> &Entry =
       HashTable.GetOrCreateValue(NameStart, NameEnd);
 
-    IdentifierInfo *II = Entry.getValue();
-    assert(!II && "IdentifierInfo already exists");
-
-    // Lookups failed, make a new IdentifierInfo.
-    void *Mem = getAllocator().Allocate<IdentifierInfo>();
-    II = new (Mem) IdentifierInfo();
-    Entry.setValue(II);
-
-    // Make sure getName() knows how to find the IdentifierInfo
-    // contents.
-    II->Entry = &Entry;
-
-    return *II;
+    assert(!Entry.getValue() && "IdentifierInfo already exists");
+    return CreateEntry(Entry);
   }
   IdentifierInfo &CreateIdentifierInfo(llvm::StringRef Name) {
     return CreateIdentifierInfo(Name.begin(), Name.end());
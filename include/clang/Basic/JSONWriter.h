@@ -0,0 +1,31 @@
+//===--- JSONWriter.h - Helpers for writing JSON output ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file declares the helpers shared by the writers of JSON reports.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_JSONWRITER_H
+#define LLVM_CLANG_BASIC_JSONWRITER_H
+
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+
+/// \brief Write \p Str to \p OS as a quoted JSON string, escaping quotes,
+/// backslashes and control characters.
+void WriteJSONString(llvm::raw_ostream &OS, llvm::StringRef Str);
+
+} // end namespace clang
+
+#endif
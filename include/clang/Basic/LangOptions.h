@@ -100,6 +100,14 @@ public:
   unsigned CatchUndefined    : 1; // Generate code to check for undefined ops.
   unsigned DumpVtableLayouts : 1; // Dump the layouts of all the emitted 
                                   // vtables.
+  unsigned NoSystemHeaderAccessControl : 1; // Skip C++ access checks in
+                                            // system headers.
+  unsigned ElideTypeLocs     : 1; // Share location-free type source info
+                                  // for instantiated and system header
+                                  // declarations.
+  unsigned NoSystemHeaderInstantiations : 1; // Don't instantiate bodies of
+                                             // system header templates at
+                                             // the end of the TU.
 private:
   unsigned GC : 2;                // Objective-C Garbage Collection modes.  We
                                   // declare this enum as unsigned because MSVC
@@ -113,6 +121,9 @@ private:
 
 public:
   unsigned InstantiationDepth;    // Maximum template instantiation depth.
+  unsigned TypoCorrectionLimit;   // Maximum number of typo corrections, or 0.
+  unsigned TypoCandidateLimit;    // Maximum number of names to compare with
+                                  // each typo, or 0.
 
   std::string ObjCConstantStringClass;
 
@@ -157,6 +168,8 @@ public:
     ObjCGCBitmapPrint = 0;
 
     InstantiationDepth = 99;
+    TypoCorrectionLimit = 20;
+    TypoCandidateLimit = 0;
 
     Optimize = 0;
     OptimizeSize = 0;
@@ -171,6 +184,9 @@ public:
     ShortWChar = 0;
     CatchUndefined = 0;
     DumpVtableLayouts = 0;
+    NoSystemHeaderAccessControl = 0;
+    ElideTypeLocs = 0;
+    NoSystemHeaderInstantiations = 0;
   }
 
   GCMode getGCMode() const { return (GCMode) GC; }
@@ -14,13 +14,16 @@
 #ifndef LLVM_CLANG_BASIC_ON_DISK_HASH_TABLE_H
 #define LLVM_CLANG_BASIC_ON_DISK_HASH_TABLE_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/System/DataTypes.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Host.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <vector>
 
 namespace clang {
 
@@ -335,6 +338,245 @@ public:
   }
 };
 
+/// \brief Compute the slot of a key with the given 64-bit hash in an on-disk
+/// perfect hash table, for the displacement of its group.
+inline unsigned GetPerfectHashSlot(uint64_t Hash, uint32_t Displacement,
+                                   unsigned NumSlots) {
+  uint32_t X = (uint32_t)Hash ^ ((uint32_t)(Hash >> 32) * 0x85EBCA6BU) ^
+               (Displacement * 0x9E3779B9U);
+  X ^= X >> 16;
+  X *= 0x85EBCA6BU;
+  X ^= X >> 13;
+  return X % NumSlots;
+}
+
+/// \brief Generates an on-disk hash table in which every key is found with a
+/// single probe.
+///
+/// The keys are split into groups by the upper half of their 64-bit hash.
+/// Each group gets a displacement, chosen so that the slots of its keys,
+/// given by GetPerfectHashSlot(), are distinct and not used by any other
+/// group; there are as many slots as distinct hashes.  Largest groups are
+/// placed first, while most slots are still free (the "hash and displace"
+/// construction).
+///
+/// Each slot holds the lower half of the hash of its key, so that most misses
+/// are rejected without reading the key, and the offset of its entries.  Keys
+/// with the same 64-bit hash share a slot and follow one another there, each
+/// written by the Info object as in OnDiskChainedHashTableGenerator.
+template<typename Info>
+class OnDiskPerfectHashTableGenerator {
+  struct Item {
+    typename Info::key_type key;
+    typename Info::data_type data;
+    uint64_t hash;
+
+    Item(typename Info::key_type_ref k, typename Info::data_type_ref d)
+      : key(k), data(d), hash(Info::ComputeHash(k)) {}
+
+    bool operator<(const Item &RHS) const { return hash < RHS.hash; }
+  };
+
+  std::vector<Item> Items;
+
+  /// \brief Try to place the keys in NumSlots slots, filling in the
+  /// displacements and the index of the key in each slot.
+  bool Place(const std::vector<uint64_t> &Hashes, unsigned NumSlots,
+             std::vector<uint32_t> &Displacements,
+             std::vector<unsigned> &SlotKeys) {
+    unsigned NumGroups = Displacements.size();
+    std::vector<std::vector<unsigned> > Groups(NumGroups);
+    for (unsigned I = 0, N = Hashes.size(); I != N; ++I)
+      Groups[(Hashes[I] >> 32) % NumGroups].push_back(I);
+
+    std::vector<std::pair<unsigned, unsigned> > Order;
+    for (unsigned G = 0; G != NumGroups; ++G)
+      if (!Groups[G].empty())
+        Order.push_back(std::make_pair(~0U - (unsigned)Groups[G].size(), G));
+    std::sort(Order.begin(), Order.end());
+
+    SlotKeys.assign(NumSlots, ~0U);
+    llvm::SmallVector<unsigned, 8> Slots;
+    for (unsigned O = 0, OEnd = Order.size(); O != OEnd; ++O) {
+      const std::vector<unsigned> &Group = Groups[Order[O].second];
+      // The last groups have a single key and few free slots left, so allow
+      // enough attempts to find one of them.
+      uint32_t MaxDisplacement = 64 * NumSlots + 1024;
+      uint32_t D = 0;
+      for (; D != MaxDisplacement; ++D) {
+        Slots.clear();
+        unsigned K = 0, KEnd = Group.size();
+        for (; K != KEnd; ++K) {
+          unsigned Slot = GetPerfectHashSlot(Hashes[Group[K]], D, NumSlots);
+          if (SlotKeys[Slot] != ~0U ||
+              std::find(Slots.begin(), Slots.end(), Slot) != Slots.end())
+            break;
+          Slots.push_back(Slot);
+        }
+        if (K == KEnd)
+          break;
+      }
+      if (D == MaxDisplacement)
+        return false;
+
+      Displacements[Order[O].second] = D;
+      for (unsigned K = 0, KEnd = Group.size(); K != KEnd; ++K)
+        SlotKeys[Slots[K]] = Group[K];
+    }
+    return true;
+  }
+
+public:
+  void insert(typename Info::key_type_ref key,
+              typename Info::data_type_ref data) {
+    Items.push_back(Item(key, data));
+  }
+
+  io::Offset Emit(llvm::raw_ostream &out, Info &InfoObj) {
+    using namespace clang::io;
+
+    // Group the items by hash, in insertion order within each hash.
+    std::stable_sort(Items.begin(), Items.end());
+    std::vector<uint64_t> Hashes;
+    std::vector<unsigned> FirstItems;
+    for (unsigned I = 0, N = Items.size(); I != N; ++I)
+      if (Hashes.empty() || Hashes.back() != Items[I].hash) {
+        Hashes.push_back(Items[I].hash);
+        FirstItems.push_back(I);
+      }
+    FirstItems.push_back(Items.size());
+
+    // An average of four keys per group keeps the table of displacements
+    // small.  Placing the keys only fails in the rare case where the last
+    // groups cannot find free slots; a few more slots then make room.
+    unsigned NumKeys = Hashes.size();
+    unsigned NumSlots = NumKeys ? NumKeys : 1;
+    std::vector<uint32_t> Displacements(NumKeys / 4 + 1, 0);
+    std::vector<unsigned> SlotKeys;
+    while (!Place(Hashes, NumSlots, Displacements, SlotKeys))
+      NumSlots += NumSlots / 64 + 1;
+
+    // Emit the payload of the table.
+    std::vector<Offset> KeyOffsets(NumKeys);
+    for (unsigned K = 0; K != NumKeys; ++K) {
+      KeyOffsets[K] = out.tell();
+      assert(KeyOffsets[K] &&
+             "Cannot write a slot at offset 0. Please add padding.");
+
+      // Write out the number of items with this hash, then the items.
+      Emit16(out, FirstItems[K + 1] - FirstItems[K]);
+      for (unsigned I = FirstItems[K], E = FirstItems[K + 1]; I != E; ++I) {
+        const std::pair<unsigned, unsigned>& Len =
+          InfoObj.EmitKeyDataLength(out, Items[I].key, Items[I].data);
+        InfoObj.EmitKey(out, Items[I].key, Len.first);
+        InfoObj.EmitData(out, Items[I].key, Items[I].data, Len.second);
+      }
+    }
+
+    // Emit the displacements and the slots.
+    Pad(out, 4);
+    io::Offset TableOff = out.tell();
+    Emit32(out, NumSlots);
+    Emit32(out, Displacements.size());
+    for (unsigned G = 0, N = Displacements.size(); G != N; ++G)
+      Emit32(out, Displacements[G]);
+    for (unsigned Slot = 0; Slot != NumSlots; ++Slot) {
+      unsigned K = SlotKeys[Slot];
+      Emit32(out, K == ~0U ? 0 : (uint32_t)Hashes[K]);
+      Emit32(out, K == ~0U ? 0 : KeyOffsets[K]);
+    }
+
+    return TableOff;
+  }
+};
+
+/// \brief An on-disk hash table written by OnDiskPerfectHashTableGenerator.
+///
+/// The Info class is the same as for OnDiskChainedHashTable, except that
+/// ComputeHash() returns a 64-bit hash.
+template<typename Info>
+class OnDiskPerfectHashTable {
+  const unsigned NumSlots;
+  const unsigned NumDisplacements;
+  const unsigned char* const Displacements;
+  const unsigned char* const Slots;
+  const unsigned char* const Base;
+  Info InfoObj;
+
+public:
+  typedef typename Info::internal_key_type internal_key_type;
+  typedef typename Info::external_key_type external_key_type;
+  typedef typename Info::data_type         data_type;
+  typedef typename OnDiskChainedHashTable<Info>::iterator iterator;
+
+  OnDiskPerfectHashTable(unsigned numSlots, unsigned numDisplacements,
+                         const unsigned char* displacements,
+                         const unsigned char* base,
+                         const Info &InfoObj = Info())
+    : NumSlots(numSlots), NumDisplacements(numDisplacements),
+      Displacements(displacements),
+      Slots(displacements + sizeof(uint32_t)*numDisplacements), Base(base),
+      InfoObj(InfoObj) {
+    assert((reinterpret_cast<uintptr_t>(displacements) & 0x3) == 0 &&
+           "'displacements' must have a 4-byte alignment");
+  }
+
+  iterator find(const external_key_type& eKey, Info *InfoPtr = 0) {
+    if (!InfoPtr)
+      InfoPtr = &InfoObj;
+
+    using namespace io;
+    const internal_key_type& iKey = Info::GetInternalKey(eKey);
+    uint64_t key_hash = Info::ComputeHash(iKey);
+
+    const unsigned char* D = Displacements +
+      sizeof(uint32_t)*((key_hash >> 32) % NumDisplacements);
+    uint32_t Displacement = ReadLE32(D);
+    const unsigned char* Slot = Slots + 2*sizeof(uint32_t)*
+      GetPerfectHashSlot(key_hash, Displacement, NumSlots);
+
+    // A key that is not in the table almost always lands on a slot with a
+    // different hash, or on an empty one.
+    uint32_t slot_hash = ReadLE32(Slot);
+    unsigned offset = ReadLE32(Slot);
+    if (offset == 0 || slot_hash != (uint32_t)key_hash)
+      return iterator();
+
+    const unsigned char* Items = Base + offset;
+    unsigned len = ReadUnalignedLE16(Items);
+    for (unsigned i = 0; i < len; ++i) {
+      // Determine the length of the key and the data.
+      const std::pair<unsigned, unsigned>& L = Info::ReadKeyDataLength(Items);
+
+      // Read the key.
+      const internal_key_type& X =
+        InfoPtr->ReadKey((const unsigned char* const) Items, L.first);
+      if (Info::EqualKey(X, iKey))
+        return iterator(X, Items + L.first, L.second, InfoPtr);
+
+      Items += L.first + L.second;
+    }
+
+    return iterator();
+  }
+
+  iterator end() const { return iterator(); }
+
+  static OnDiskPerfectHashTable* Create(const unsigned char* table,
+                                        const unsigned char* const base,
+                                        const Info &InfoObj = Info()) {
+    using namespace io;
+    assert(table > base);
+    assert((reinterpret_cast<uintptr_t>(table) & 0x3) == 0 &&
+           "table should be 4-byte aligned.");
+
+    unsigned numSlots = ReadLE32(table);
+    unsigned numDisplacements = ReadLE32(table);
+    return new OnDiskPerfectHashTable<Info>(numSlots, numDisplacements, table,
+                                            base, InfoObj);
+  }
+};
+
 } // end namespace clang
 
 #endif
@@ -0,0 +1,188 @@
+//===--- PhaseStatistics.h - Per-phase timers and counters ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the PhaseStatistics and PhaseRegion interfaces.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_PHASESTATISTICS_H
+#define LLVM_CLANG_BASIC_PHASESTATISTICS_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/DataTypes.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+
+/// \brief A tree of timers and counters describing where a compilation
+/// spends its time, written out as JSON with one record per translation unit.
+///
+/// Every phase of a translation unit (parsing, PCH loading, template
+/// instantiation, code generation, ...) is a node in the tree, nested under
+/// the phase that was running when it started.  A phase may carry a detail
+/// string, such as the name of a header or of a template specialization, so
+/// the same kind of phase is broken down by the entity it worked on.  Each
+/// node accumulates how often it ran, its wall, user and system time and the
+/// growth of the heap while it was running.
+///
+/// At most one PhaseStatistics object is active at a time.  Instrumented code
+/// checks getActive() first, so a compilation that does not ask for phase
+/// statistics only pays for a load and a branch at each instrumented point.
+class PhaseStatistics {
+public:
+  /// \brief A node in the tree of phases.
+  struct Phase {
+    const char *Name;
+    std::string Detail;
+    Phase *Parent;
+    std::vector<Phase*> Children;
+
+    /// \brief The number of times this phase ran.
+    unsigned Count;
+
+    /// \brief The total time spent in this phase, in seconds, including the
+    /// time spent in nested phases.
+    double WallTime, UserTime, SystemTime;
+
+    /// \brief The total number of bytes by which the heap grew while this
+    /// phase was running.
+    int64_t MemoryGrowth;
+
+    Phase(const char *Name, llvm::StringRef Detail, Phase *Parent)
+      : Name(Name), Detail(Detail), Parent(Parent), Count(0), WallTime(0),
+        UserTime(0), SystemTime(0), MemoryGrowth(0) {}
+  };
+
+private:
+  static PhaseStatistics *Active;
+
+  /// \brief A running phase and the resource usage when it started.
+  struct Activation {
+    Phase *P;
+    double WallStart, UserStart, SystemStart;
+    size_t MemoryStart;
+  };
+
+  /// \brief The root of the current translation unit, or null between
+  /// translation units.
+  Phase *Root;
+
+  /// \brief Every phase of the current translation unit, owned here.
+  std::vector<Phase*> Phases;
+
+  /// \brief The running phases, innermost last.
+  std::vector<Activation> Running;
+
+  /// \brief Finds the child of a phase with a given name and detail.
+  typedef std::pair<Phase*, std::pair<std::string, std::string> > ChildKey;
+  std::map<ChildKey, Phase*> ChildMap;
+
+  /// \brief The counters of the current translation unit.
+  llvm::StringMap<uint64_t> Counters;
+
+  /// \brief The JSON records of the translation units finished so far.
+  std::vector<std::string> Records;
+
+  void startActivation(Phase *P);
+  void stopActivations(unsigned NewSize);
+  void reset();
+
+  PhaseStatistics(const PhaseStatistics&); // DO NOT IMPLEMENT
+  void operator=(const PhaseStatistics&);  // DO NOT IMPLEMENT
+public:
+  PhaseStatistics() : Root(0) {}
+  ~PhaseStatistics();
+
+  /// \brief Return the object that instrumented code reports to, or null if
+  /// phase statistics are disabled.
+  static PhaseStatistics *getActive() { return Active; }
+
+  /// \brief Make \p Stats the object that instrumented code reports to.
+  /// Pass null to disable phase statistics.
+  static void setActive(PhaseStatistics *Stats) { Active = Stats; }
+
+  /// \brief Start collecting statistics for the translation unit built from
+  /// \p File.
+  void beginTranslationUnit(llvm::StringRef File);
+
+  /// \brief Stop every running phase and turn the statistics of the current
+  /// translation unit into a JSON record.
+  void endTranslationUnit();
+
+  /// \brief Start a phase nested within the innermost running phase.
+  /// Returns the phase, to be passed to exitPhase().
+  Phase *enterPhase(const char *Name, llvm::StringRef Detail = "");
+
+  /// \brief Stop \p P, along with any phases nested in it that are still
+  /// running.  Does nothing if \p P is not running.
+  void exitPhase(Phase *P);
+
+  /// \brief Stop the innermost running phase called \p Name, along with any
+  /// phases nested in it.  Does nothing if there is no such phase.
+  void exitPhase(const char *Name);
+
+  /// \brief Add \p Value to the counter \p Name of the current translation
+  /// unit.
+  void addCounter(llvm::StringRef Name, uint64_t Value) {
+    Counters[Name] += Value;
+  }
+
+  /// \brief Write the records of all finished translation units to \p OS, as
+  /// a JSON array.
+  void WriteJSON(llvm::raw_ostream &OS) const;
+};
+
+/// \brief Runs a phase for as long as the object lives, if phase statistics
+/// are enabled.
+class PhaseRegion {
+  PhaseStatistics *Stats;
+  PhaseStatistics::Phase *P;
+
+  PhaseRegion(const PhaseRegion&); // DO NOT IMPLEMENT
+  void operator=(const PhaseRegion&); // DO NOT IMPLEMENT
+public:
+  /// \brief Create a region that does not run a phase until enter() is
+  /// called.  This lets a caller build the detail string only when phase
+  /// statistics are enabled.
+  PhaseRegion() : Stats(0), P(0) {}
+
+  explicit PhaseRegion(const char *Name)
+    : Stats(PhaseStatistics::getActive()), P(0) {
+    if (Stats)
+      P = Stats->enterPhase(Name);
+  }
+
+  ~PhaseRegion() { exit(); }
+
+  /// \brief Start the phase \p Name for the entity \p Detail.
+  void enter(const char *Name, llvm::StringRef Detail) {
+    assert(!Stats && "Region is already running a phase!");
+    Stats = PhaseStatistics::getActive();
+    if (Stats)
+      P = Stats->enterPhase(Name, Detail);
+  }
+
+  /// \brief Stop the phase before the region goes out of scope.
+  void exit() {
+    if (Stats)
+      Stats->exitPhase(P);
+    Stats = 0;
+  }
+};
+
+} // end namespace clang
+
+#endif
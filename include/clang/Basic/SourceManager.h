@@ -30,8 +30,10 @@ namespace clang {
 class SourceManager;
 class FileManager;
 class FileEntry;
+class VirtualFileOverlay;
 class IdentifierTokenInfo;
 class LineTableInfo;
+struct LineEntry;
 
 /// SrcMgr - Public enums and private classes that are part of the
 /// SourceManager implementation.
@@ -48,21 +50,36 @@ namespace SrcMgr {
   };
 
   /// ContentCache - Once instance of this struct is kept for every file
-  /// loaded or used.  This object owns the MemoryBuffer object.
+  /// loaded or used.  This object owns the MemoryBuffer object, unless the
+  /// buffer comes from the shared file buffer pool.
   class ContentCache {
     /// Buffer - The actual buffer containing the characters from the input
-    /// file.  This is owned by the ContentCache object.
+    /// file.  This is owned by the ContentCache object, or holds a reference
+    /// to a buffer in the shared file buffer pool if IsBufferShared is set.
     mutable const llvm::MemoryBuffer *Buffer;
 
+    /// IsBufferShared - True if the buffer for this file is obtained from the
+    /// process-wide pool of file buffers, which lets identical files share
+    /// one buffer between SourceManagers and lets the buffer be released and
+    /// paged back in on demand.
+    mutable bool IsBufferShared;
+
+    /// WasReleased - True if the shared buffer has been released at least
+    /// once, so that reloading it must check that the file has not changed.
+    mutable bool WasReleased;
+
+    /// BufferOverridden - True if the buffer was given by replaceBuffer(), so
+    /// that it need not hold the contents of the file on disk.
+    bool BufferOverridden;
+
   public:
     /// Reference to the file entry.  This reference does not own
     /// the FileEntry object.  It is possible for this to be NULL if
     /// the ContentCache encapsulates an imaginary text buffer.
     const FileEntry *Entry;
 
-    /// SourceLineCache - A bump pointer allocated array of offsets for each
-    /// source line.  This is lazily computed.  This is owned by the
-    /// SourceManager BumpPointerAllocator object.
+    /// SourceLineCache - An array of offsets for each source line.  This is
+    /// lazily computed, and freed by SourceManager::releaseLineTables().
     unsigned *SourceLineCache;
 
     /// NumLines - The number of lines in this ContentCache.  This is only valid
@@ -94,15 +111,32 @@ namespace SrcMgr {
     /// with the given buffer.
     void replaceBuffer(const llvm::MemoryBuffer *B);
 
-    ContentCache(const FileEntry *Ent = 0)
-      : Buffer(0), Entry(Ent), SourceLineCache(0), NumLines(0) {}
+    /// releaseBuffer - If this ContentCache holds a shared file buffer, drop
+    /// the reference to it.  The buffer is paged back in by the next call to
+    /// getBuffer.  Returns the size of the released buffer, or 0 if nothing
+    /// was released.
+    unsigned releaseBuffer();
+
+    /// isBufferShared - Return true if the buffer of this file comes from
+    /// the shared file buffer pool.
+    bool isBufferShared() const { return IsBufferShared; }
+
+    /// isBufferOverridden - Return true if the contents of this file were
+    /// replaced, so that they may differ from the file on disk.
+    bool isBufferOverridden() const { return BufferOverridden; }
+
+    ContentCache(const FileEntry *Ent = 0, bool ShareBuffer = false)
+      : Buffer(0), IsBufferShared(ShareBuffer && Ent), WasReleased(false),
+        BufferOverridden(false), Entry(Ent), SourceLineCache(0), NumLines(0) {}
 
     ~ContentCache();
 
     /// The copy ctor does not allow copies where source object has either
     ///  a non-NULL Buffer or SourceLineCache.  Ownership of allocated memory
     ///  is not transfered, so this is a logical error.
-    ContentCache(const ContentCache &RHS) : Buffer(0), SourceLineCache(0) {
+    ContentCache(const ContentCache &RHS)
+      : Buffer(0), IsBufferShared(RHS.IsBufferShared), WasReleased(false),
+        BufferOverridden(false), SourceLineCache(0) {
       Entry = RHS.Entry;
 
       assert (RHS.Buffer == 0 && RHS.SourceLineCache == 0
@@ -263,6 +297,14 @@ public:
 
   /// \brief Read the source location entry with index ID.
   virtual void ReadSLocEntry(unsigned ID) = 0;
+
+  /// \brief Retrieve the offsets of the lines of the given file, if they
+  /// are known without scanning its contents, as they are on disk.
+  ///
+  /// \returns true if Offsets was filled in with the offset of the start of
+  /// each line.
+  virtual bool ReadLineOffsets(const FileEntry *File,
+                               std::vector<unsigned> &Offsets);
 };
 
 /// SourceManager - This file handles loading and caching of source files into
@@ -287,7 +329,8 @@ class SourceManager {
 
   /// MemBufferInfos - Information about various memory buffers that we have
   /// read in.  All FileEntry* within the stored ContentCache objects are NULL,
-  /// as they do not refer to a file.
+  /// as they do not refer to a file, except for the edited versions of files
+  /// made by createFileIDForEditedFile.
   std::vector<SrcMgr::ContentCache*> MemBufferInfos;
 
   /// SLocEntryTable - This is an array of SLocEntry's that we have created.
@@ -305,11 +348,27 @@ class SourceManager {
   /// \brief An external source for source location entries.
   ExternalSLocEntrySource *ExternalSLocEntries;
 
+  /// \brief The offsets at which the preallocated source location entries
+  /// start, if the external source provides them, indexed by ID - 1.  This
+  /// lets getFileID search the preallocated entries without loading them.
+  const uint32_t *PreallocatedSLocOffsets;
+
   /// LastFileIDLookup - This is a one-entry cache to speed up getFileID.
   /// LastFileIDLookup records the last FileID looked up or created, because it
   /// is very common to look up many tokens from the same file.
   mutable FileID LastFileIDLookup;
 
+  /// FileSLocOffsets/FileSLocIDs - The start offsets and IDs of the file
+  /// entries in SLocEntryTable at or after FirstIndexedSLocEntry, in
+  /// increasing order.  A file location can only be in a file entry, so
+  /// getFileIDSlow finds it by searching this compact index instead of the
+  /// whole table, which is mostly instantiation entries in macro-heavy code.
+  /// Entries before FirstIndexedSLocEntry (e.g. those preallocated for a PCH
+  /// file) are not indexed, since they are loaded lazily and out of order.
+  std::vector<unsigned> FileSLocOffsets;
+  std::vector<unsigned> FileSLocIDs;
+  unsigned FirstIndexedSLocEntry;
+
   /// LineTable - This holds information for #line directives.  It is referenced
   /// by indices from SLocEntryTable.
   LineTableInfo *LineTable;
@@ -321,11 +380,29 @@ class SourceManager {
   mutable unsigned LastLineNoFilePos;
   mutable unsigned LastLineNoResult;
 
+  /// TokenLengths - The lengths of the tokens measured by
+  /// Lexer::MeasureTokenLength, keyed by the raw encoding of their file
+  /// location and by the language options they were lexed with.
+  /// Diagnostics, rewriters and CIndex measure the same tokens over and over
+  /// to find the ends of source ranges.
+  mutable llvm::DenseMap<std::pair<unsigned, unsigned>, unsigned> TokenLengths;
+
   /// MainFileID - The file ID for the main source file of the translation unit.
   FileID MainFileID;
 
+  /// ShareFileBuffers - Whether the buffers of files created from now on come
+  /// from the process-wide shared file buffer pool.
+  bool ShareFileBuffers;
+
+  /// FileOverlay - The in-memory files whose contents are taken from the
+  /// overlay instead of being read from disk.  Not owned.
+  const VirtualFileOverlay *FileOverlay;
+
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
+  mutable unsigned NumFileIndexLookups, NumFileIndexProbes;
+  mutable unsigned NumTokenLengthLookups, NumTokenLengthsCached;
+  unsigned NumBuffersReleased;
 
   // Cache results for the isBeforeInTranslationUnit method.
   mutable FileID LastLFIDForBeforeTUCheck;
@@ -337,14 +414,73 @@ class SourceManager {
   void operator=(const SourceManager&);
 public:
   SourceManager()
-    : ExternalSLocEntries(0), LineTable(0), NumLinearScans(0), 
-      NumBinaryProbes(0) {
+    : ExternalSLocEntries(0), PreallocatedSLocOffsets(0), LineTable(0),
+      ShareFileBuffers(false), FileOverlay(0),
+      NumLinearScans(0), NumBinaryProbes(0), NumFileIndexLookups(0),
+      NumFileIndexProbes(0), NumTokenLengthLookups(0),
+      NumTokenLengthsCached(0), NumBuffersReleased(0) {
     clearIDTables();
   }
   ~SourceManager();
 
   void clearIDTables();
 
+  /// setShareFileBuffers - Control whether the contents of files loaded from
+  /// now on are shared with other SourceManagers in the process.  Shared
+  /// buffers are keyed on the identity, modification time and size of the
+  /// file, and can be released with releaseFileBuffers.  This is intended
+  /// for long-lived hosts that keep many translation units alive.
+  void setShareFileBuffers(bool Share) { ShareFileBuffers = Share; }
+
+  /// setFileOverlay - Take the contents of the files registered with the
+  /// given overlay from it, instead of reading them from disk.  The overlay
+  /// must outlive the SourceManager.
+  void setFileOverlay(const VirtualFileOverlay *O) { FileOverlay = O; }
+
+  /// getCachedTokenLength - Return true and set Length if the length of the
+  /// token at the file location Loc was recorded by setCachedTokenLength for
+  /// the same Options.  Options is an opaque summary, computed by the lexer,
+  /// of the language options that the length of a token depends on.
+  bool getCachedTokenLength(SourceLocation Loc, unsigned Options,
+                            unsigned &Length) const {
+    ++NumTokenLengthLookups;
+    llvm::DenseMap<std::pair<unsigned, unsigned>, unsigned>::const_iterator I
+      = TokenLengths.find(std::make_pair(Loc.getRawEncoding(), Options));
+    if (I == TokenLengths.end())
+      return false;
+    ++NumTokenLengthsCached;
+    Length = I->second;
+    return true;
+  }
+
+  void setCachedTokenLength(SourceLocation Loc, unsigned Options,
+                            unsigned Length) const {
+    TokenLengths[std::make_pair(Loc.getRawEncoding(), Options)] = Length;
+  }
+
+  /// releaseFileBuffers - Drop the references this SourceManager holds to
+  /// shared file buffers, e.g. in response to memory pressure.  A buffer is
+  /// unmapped once no SourceManager references it, and is paged back in if it
+  /// is needed again (for a diagnostic or a token spelling, say).  Line
+  /// number tables are kept, since the contents of a reloaded file are
+  /// checked against the original.  This must not be called while any lexer
+  /// is reading from this SourceManager.  Returns the number of bytes
+  /// released.
+  unsigned releaseFileBuffers();
+
+  /// acquireSharedFileBuffer - Load \arg FE into the shared file buffer pool,
+  /// or take another reference to it if it is already there.  This may be
+  /// called from any thread, e.g. to read headers ahead of the preprocessor.
+  /// The file must still match the stat information in \arg FE.  Returns
+  /// null on error.
+  static const llvm::MemoryBuffer *
+  acquireSharedFileBuffer(const FileEntry *FE, std::string *ErrorStr = 0);
+
+  /// releaseSharedFileBuffer - Drop a reference taken with
+  /// acquireSharedFileBuffer.
+  static void releaseSharedFileBuffer(const FileEntry *FE,
+                                      const llvm::MemoryBuffer *Buffer);
+
   //===--------------------------------------------------------------------===//
   // MainFileID creation and querying methods.
   //===--------------------------------------------------------------------===//
@@ -388,6 +524,13 @@ public:
                         SrcMgr::C_User, PreallocatedID, Offset);
   }
 
+  /// createFileIDForEditedFile - Create a new FileID for a newer version of
+  /// the contents of the given file, held in the given memory buffer.  The
+  /// FileIDs already created for the file keep the contents they had.  This
+  /// takes ownership of the MemoryBuffer.
+  FileID createFileIDForEditedFile(const FileEntry *SourceFile,
+                                   const llvm::MemoryBuffer *Buffer);
+
   /// createMainFileIDForMembuffer - Create the FileID for a memory buffer
   ///  that will represent the FileID for the main source.  One example
   ///  of when this would be used is when the main source is read from STDIN.
@@ -459,7 +602,7 @@ public:
     if (isOffsetInFileID(LastFileIDLookup, SLocOffset))
       return LastFileIDLookup;
 
-    return getFileIDSlow(SLocOffset);
+    return getFileIDSlow(SLocOffset, SpellingLoc.isFileID());
   }
 
   /// getLocForStartOfFile - Return the source location corresponding to the
@@ -576,6 +719,11 @@ public:
   /// about to emit a diagnostic.
   unsigned getLineNumber(FileID FID, unsigned FilePos) const;
 
+  /// getLineOffsets - Return the offsets of the start of each line of the
+  /// given content, computing them if needed, and their number in NumLines.
+  const unsigned *getLineOffsets(const SrcMgr::ContentCache *Content,
+                                 unsigned &NumLines) const;
+
   unsigned getInstantiationLineNumber(SourceLocation Loc) const;
   unsigned getSpellingLineNumber(SourceLocation Loc) const;
 
@@ -642,6 +790,11 @@ public:
                    bool IsFileEntry, bool IsFileExit,
                    bool IsSystemHeader, bool IsExternCHeader);
 
+  /// AddLineEntries - Give FID the line table entries that the line markers
+  /// of another buffer with the same contents produced.  FID must not have
+  /// any line table entries yet.
+  void AddLineEntries(FileID FID, const std::vector<LineEntry> &Entries);
+
   /// \brief Determine if the source manager has a line table.
   bool hasLineTable() const { return LineTable != 0; }
 
@@ -677,6 +830,22 @@ public:
   ///
   void PrintStats() const;
 
+  /// getContentBytes - Return the number of bytes of file and memory buffer
+  /// contents that are loaded.
+  size_t getContentBytes() const;
+
+  /// getLineTableBytes - Return the number of bytes used by the line number
+  /// tables computed for the loaded buffers.
+  size_t getLineTableBytes() const;
+
+  /// getDataStructureBytes - Return the number of bytes used by the tables
+  /// of source location entries and the content caches.
+  size_t getDataStructureBytes() const;
+
+  /// releaseLineTables - Free the line number tables of all the buffers.
+  /// They are computed again when a line number is next asked for.
+  void releaseLineTables();
+
   unsigned sloc_entry_size() const { return SLocEntryTable.size(); }
   
   // FIXME: Exposing this is a little gross; what we want is a good way
@@ -697,6 +866,15 @@ public:
     return getSLocEntry(FID.ID);
   }
 
+  /// \brief Return the offset at which the source location entry with the
+  /// given ID starts, without loading it if it is preallocated.
+  unsigned getSLocEntryOffset(unsigned ID) const {
+    if (PreallocatedSLocOffsets && ID < SLocEntryLoaded.size() &&
+        !SLocEntryLoaded[ID])
+      return PreallocatedSLocOffsets[ID - 1];
+    return getSLocEntry(ID).getOffset();
+  }
+
   unsigned getNextOffset() const { return NextOffset; }
 
   /// \brief Preallocate some number of source location entries, which
@@ -705,6 +883,13 @@ public:
                               unsigned NumSLocEntries,
                               unsigned NextOffset);
 
+  /// \brief Provide the offsets at which the preallocated source location
+  /// entries start, in ID order.  The array must outlive the preallocated
+  /// entries.
+  void setPreallocatedSLocOffsets(const uint32_t *Offsets) {
+    PreallocatedSLocOffsets = Offsets;
+  }
+
   /// \brief Clear out any preallocated source location entries that
   /// haven't already been loaded.
   void ClearPreallocatedSLocEntries();
@@ -713,15 +898,14 @@ private:
   /// isOffsetInFileID - Return true if the specified FileID contains the
   /// specified SourceLocation offset.  This is a very hot method.
   inline bool isOffsetInFileID(FileID FID, unsigned SLocOffset) const {
-    const SrcMgr::SLocEntry &Entry = getSLocEntry(FID);
     // If the entry is after the offset, it can't contain it.
-    if (SLocOffset < Entry.getOffset()) return false;
+    if (SLocOffset < getSLocEntryOffset(FID.ID)) return false;
 
     // If this is the last entry than it does.  Otherwise, the entry after it
     // has to not include it.
     if (FID.ID+1 == SLocEntryTable.size()) return true;
 
-    return SLocOffset < getSLocEntry(FileID::get(FID.ID+1)).getOffset();
+    return SLocOffset < getSLocEntryOffset(FID.ID+1);
   }
 
   /// createFileID - Create a new fileID for the specified ContentCache and
@@ -741,7 +925,8 @@ private:
   const SrcMgr::ContentCache*
   createMemBufferContentCache(const llvm::MemoryBuffer *Buf);
 
-  FileID getFileIDSlow(unsigned SLocOffset) const;
+  FileID getFileIDSlow(unsigned SLocOffset, bool IsFileLoc) const;
+  FileID getFileIDFromIndex(unsigned SLocOffset) const;
 
   SourceLocation getInstantiationLocSlowCase(SourceLocation Loc) const;
   SourceLocation getSpellingLocSlowCase(SourceLocation Loc) const;
@@ -0,0 +1,102 @@
+//===--- StatSnapshot.h - Shared snapshot of stat() results -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the StatSnapshotCache and StatSnapshotWriter interfaces.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_STATSNAPSHOT_H
+#define LLVM_CLANG_BASIC_STATSNAPSHOT_H
+
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+  class MemoryBuffer;
+}
+
+namespace clang {
+
+/// \brief A stat cache that answers stat() calls from a memory-mapped
+/// snapshot file.
+///
+/// A snapshot maps absolute paths to the result of calling stat() on them,
+/// including negative results.  It is meant to be produced by a long-lived,
+/// build-wide process that watches the file system (e.g. through inotify or
+/// FSEvents) and publishes a new snapshot with StatSnapshotWriter whenever
+/// something changes.  Because snapshots are replaced atomically, every
+/// compilation sees one consistent snapshot for its whole lifetime, and all
+/// concurrent compilations share the same pages of the mapped file.
+///
+/// Relative paths and paths missing from the snapshot are forwarded to the
+/// next stat cache in the chain.
+class StatSnapshotCache : public StatSysCallCache {
+  const llvm::MemoryBuffer *Buf;
+  void *Table;
+
+  unsigned NumHits, NumMisses;
+
+  StatSnapshotCache(const llvm::MemoryBuffer *Buf, void *Table)
+    : Buf(Buf), Table(Table), NumHits(0), NumMisses(0) {}
+
+public:
+  // The current snapshot file version.
+  enum { Version = 1 };
+
+  ~StatSnapshotCache();
+
+  /// \brief Map the snapshot file at \p Path.  Returns null if it cannot be
+  /// read or is not a valid snapshot.
+  static StatSnapshotCache *Create(llvm::StringRef Path);
+
+  virtual int stat(const char *path, struct stat *buf);
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+};
+
+/// \brief Builds stat snapshot files for StatSnapshotCache.
+class StatSnapshotWriter {
+  /// \brief The recorded stat() results, keyed by absolute path.  A result
+  /// of -1 marks a path that does not exist.
+  llvm::StringMap<MemorizeStatCalls::StatResult> Entries;
+
+public:
+  /// \brief Record that \p Path exists with the given stat information.
+  void addStat(llvm::StringRef Path, const struct stat &StatBuf);
+
+  /// \brief Record that \p Path does not exist.
+  void addMissing(llvm::StringRef Path);
+
+  /// \brief Remove any record for \p Path.
+  void remove(llvm::StringRef Path) { Entries.erase(Path); }
+
+  /// \brief Write the snapshot to \p Path.  The snapshot is written to a
+  /// temporary file and moved into place, so readers never observe a partial
+  /// snapshot.  Returns true on error.
+  bool Write(llvm::StringRef Path);
+};
+
+/// \brief A stat cache that records the result of every stat() call on an
+/// absolute path, so that a snapshot of the file system queries of a
+/// compilation can be written.
+class StatSnapshotRecorder : public StatSysCallCache {
+  StatSnapshotWriter Writer;
+
+public:
+  virtual int stat(const char *path, struct stat *buf);
+
+  /// \brief Retrieve the writer holding the results recorded so far.
+  StatSnapshotWriter &getWriter() { return Writer; }
+};
+
+}  // end namespace clang
+
+#endif
@@ -255,12 +255,19 @@ public:
 //===----------------------------------------------------------------------===//
 
 class BugReporterData {
+  /// NumReports - The number of reports flushed by the BugReporters using
+  ///  this object.
+  unsigned NumReports;
 public:
+  BugReporterData() : NumReports(0) {}
   virtual ~BugReporterData();
   virtual Diagnostic& getDiagnostic() = 0;
   virtual PathDiagnosticClient* getPathDiagnosticClient() = 0;
   virtual ASTContext& getASTContext() = 0;
   virtual SourceManager& getSourceManager() = 0;
+
+  unsigned getNumReports() const { return NumReports; }
+  void NoteReport() { ++NumReports; }
 };
 
 class BugReporter {
@@ -286,6 +293,10 @@ public:
 
   void FlushReports();
 
+  /// DiscardReports - Throw away the reports emitted so far without
+  ///  reporting them.
+  void DiscardReports();
+
   Kind getKind() const { return kind; }
 
   Diagnostic& getDiagnostic() {
@@ -32,12 +32,14 @@ class ObjCImplementationDecl;
 class LangOptions;
 class GRExprEngine;
 class TranslationUnitDecl;
+class RetainSummaryTable;
 
 void CheckDeadStores(CFG &cfg, LiveVariables &L, ParentMap &map, 
                      BugReporter& BR);
 
 GRTransferFuncs* MakeCFRefCountTF(ASTContext& Ctx, bool GCEnabled,
-                                  const LangOptions& lopts);
+                                  const LangOptions& lopts,
+                                  RetainSummaryTable *Summaries = 0);
 
 void CheckObjCDealloc(const ObjCImplementationDecl* D, const LangOptions& L,
                       BugReporter& BR);
@@ -56,6 +58,7 @@ void CheckSecuritySyntaxOnly(const Decl *D, BugReporter &BR);
 void CheckSizeofPointer(const Decl *D, BugReporter &BR);
 
 void RegisterCallInliner(GRExprEngine &Eng);
+void RegisterCallSummarizer(GRExprEngine &Eng);
 } // end namespace clang
 
 #endif
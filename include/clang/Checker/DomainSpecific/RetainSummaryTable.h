@@ -0,0 +1,70 @@
+//===- RetainSummaryTable.h - Persistent retain/release summaries -*- C++ -*--//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines RetainSummaryTable, an on-disk table of the retain/release
+//  summaries of functions and methods declared in system headers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_CHECKER_DS_RETAINSUMMARYTABLE
+#define LLVM_CLANG_CHECKER_DS_RETAINSUMMARYTABLE
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+namespace llvm {
+  class MemoryBuffer;
+}
+
+namespace clang {
+
+/// \brief A memory-mapped table of encoded retain/release summaries.
+///
+/// The summaries of the functions and methods of the system frameworks only
+/// depend on their declarations, which are the same for every translation
+/// unit built against one SDK.  The retain/release checker looks them up
+/// here before deriving them from naming conventions and attributes, and
+/// records the summaries it had to derive, so that one table per SDK fills
+/// up as translation units are analyzed.  Summaries of user code are never
+/// stored.
+///
+/// Keys and data are opaque to the table; the checker defines both.
+class RetainSummaryTable {
+  std::string Path;
+  llvm::OwningPtr<const llvm::MemoryBuffer> Buf;
+  void *Table;
+
+  /// \brief The summaries added since the table was loaded.
+  llvm::StringMap<std::string> Added;
+
+public:
+  // The current table file version.
+  enum { Version = 1 };
+
+  /// \brief Load the table stored at \p Path, if there is a valid one.
+  explicit RetainSummaryTable(llvm::StringRef Path);
+  ~RetainSummaryTable();
+
+  /// \brief Look up the summary stored for \p Key.  Returns false if there
+  /// is none.
+  bool lookup(llvm::StringRef Key, llvm::StringRef &Data) const;
+
+  /// \brief Record the summary of \p Key, to be stored by write().
+  void add(llvm::StringRef Key, llvm::StringRef Data);
+
+  /// \brief Store the loaded and added summaries back to the file, if any
+  /// were added.  Failures are ignored; the table is only an optimization.
+  void write();
+};
+
+} // end clang namespace
+
+#endif
@@ -18,9 +18,36 @@
 #include "clang/Analysis/AnalysisContext.h"
 #include "clang/Checker/BugReporter/BugReporter.h"
 #include "clang/Checker/BugReporter/PathDiagnostic.h"
+#include "clang/Checker/PathSensitive/GRWorkList.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace clang {
 
+class FunctionDecl;
+
+/// FunctionSummary - What the path-sensitive analysis of a function on its
+/// own found about the values it returns, which holds for every call to it.
+struct FunctionSummary {
+  enum Kind {
+    /// The summary is being computed.
+    InProgress,
+    /// No path analyzed so far returns.
+    NoReturns,
+    /// Nothing is known about the returned value.
+    Unknown,
+    /// Every path returns Value.
+    Constant,
+    /// Every path returns a value that is not zero or null.
+    NonZero
+  };
+
+  Kind K;
+  llvm::APSInt Value;
+
+  FunctionSummary() : K(InProgress) {}
+};
+
 class AnalysisManager : public BugReporterData {
   AnalysisContextManager AnaCtxMgr;
   LocationContextManager LocCtxMgr;
@@ -34,6 +61,7 @@ class AnalysisManager : public BugReporterData {
   // Configurable components creators.
   StoreManagerCreator CreateStoreMgr;
   ConstraintManagerCreator CreateConstraintMgr;
+  GRWorkListCreator CreateWorkList;
 
   enum AnalysisScope { ScopeTU, ScopeDecl } AScope;
 
@@ -51,18 +79,41 @@ class AnalysisManager : public BugReporterData {
   bool EagerlyAssume;
   bool TrimGraph;
 
+  /// The budget of the path-sensitive analysis of each function: the number
+  /// of nodes in its graph, the number of milliseconds and the number of
+  /// megabytes it may use.  Zero means no limit.
+  unsigned MaxNodes;
+  unsigned MaxTime;
+  unsigned MaxMemory;
+
+  /// ReclaimInterval - The number of nodes created between removals of the
+  ///  nodes on straight-line paths that only record subexpression values
+  ///  from the exploded graph, or zero if they are kept.
+  unsigned ReclaimInterval;
+
+public:
+  typedef llvm::DenseMap<const FunctionDecl*, FunctionSummary> SummaryMap;
+
+private:
+  /// Summaries - The functions summarized so far by the call summarizer.
+  SummaryMap Summaries;
+
 public:
   AnalysisManager(ASTContext &ctx, Diagnostic &diags, 
                   const LangOptions &lang, PathDiagnosticClient *pd,
                   StoreManagerCreator storemgr,
                   ConstraintManagerCreator constraintmgr,
-                  bool vizdot, bool vizubi, bool purge, bool eager, bool trim)
+                  bool vizdot, bool vizubi, bool purge, bool eager, bool trim,
+                  unsigned maxnodes = 0, unsigned maxtime = 0,
+                  unsigned maxmemory = 0, unsigned reclaim = 0,
+                  GRWorkListCreator worklist = GRWorkList::MakeBFS)
 
     : Ctx(ctx), Diags(diags), LangInfo(lang), PD(pd),
       CreateStoreMgr(storemgr), CreateConstraintMgr(constraintmgr),
-      AScope(ScopeDecl),
+      CreateWorkList(worklist), AScope(ScopeDecl),
       VisualizeEGDot(vizdot), VisualizeEGUbi(vizubi), PurgeDead(purge),
-      EagerlyAssume(eager), TrimGraph(trim) {}
+      EagerlyAssume(eager), TrimGraph(trim), MaxNodes(maxnodes),
+      MaxTime(maxtime), MaxMemory(maxmemory), ReclaimInterval(reclaim) {}
   
   ~AnalysisManager() { FlushDiagnostics(); }
   
@@ -71,6 +122,15 @@ public:
     AnaCtxMgr.clear();
   }
 
+  /// ClearLocationContexts - Discard the location contexts of the analyses
+  /// run so far, but keep the AnalysisContexts, so that the CFGs and
+  /// liveness of the functions already seen are not built again.
+  void ClearLocationContexts() {
+    LocCtxMgr.clear();
+  }
+
+  AnalysisContextManager &getAnalysisContextManager() { return AnaCtxMgr; }
+
   StoreManagerCreator getStoreManagerCreator() {
     return CreateStoreMgr;
   }
@@ -79,6 +139,10 @@ public:
     return CreateConstraintMgr;
   }
 
+  GRWorkListCreator getWorkListCreator() {
+    return CreateWorkList;
+  }
+
   virtual ASTContext &getASTContext() {
     return Ctx;
   }
@@ -118,6 +182,16 @@ public:
 
   bool shouldEagerlyAssume() const { return EagerlyAssume; }
 
+  unsigned getMaxNodes() const { return MaxNodes; }
+
+  unsigned getMaxTime() const { return MaxTime; }
+
+  unsigned getMaxMemory() const { return MaxMemory; }
+
+  unsigned getReclaimInterval() const { return ReclaimInterval; }
+
+  SummaryMap &getSummaries() { return Summaries; }
+
   CFG *getCFG(Decl const *D) {
     return AnaCtxMgr.getContext(D)->getCFG();
   }
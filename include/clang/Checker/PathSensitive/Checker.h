@@ -250,6 +250,12 @@ public:
   virtual ~Checker();
   virtual void _PreVisit(CheckerContext &C, const Stmt *S) {}
   virtual void _PostVisit(CheckerContext &C, const Stmt *S) {}
+
+  /// WantsVisit - Returns true if _PreVisit (or _PostVisit) should be called
+  ///  for the statements of class K.  The engine asks once for each class
+  ///  when the checker is registered.
+  virtual bool WantsVisit(Stmt::StmtClass K, bool isPrevisit) { return true; }
+
   virtual void VisitLocation(CheckerContext &C, const Stmt *S, SVal location) {}
   virtual void PreVisitBind(CheckerContext &C, const Stmt *AssignE,
                             const Stmt *StoreE, SVal location, SVal val) {}
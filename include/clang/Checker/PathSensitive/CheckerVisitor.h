@@ -35,6 +35,40 @@ public:
     PostVisit(C, S);
   }
 
+  virtual bool WantsVisit(Stmt::StmtClass K, bool isPrevisit) {
+    if (isPrevisit) {
+      switch (K) {
+        default:
+          return false;
+
+        case Stmt::ImplicitCastExprClass:
+        case Stmt::CStyleCastExprClass:
+          return ImplementsPreVisitCastExpr();
+
+        case Stmt::CompoundAssignOperatorClass:
+          return ImplementsPreVisitBinaryOperator();
+
+#define PREVISIT(NAME, FALLBACK) \
+case Stmt::NAME ## Class:\
+return ImplementsPreVisit ## NAME();
+#include "clang/Checker/PathSensitive/CheckerVisitor.def"
+      }
+    }
+
+    switch (K) {
+      default:
+        return false;
+
+      case Stmt::CompoundAssignOperatorClass:
+        return ImplementsPostVisitBinaryOperator();
+
+#define POSTVISIT(NAME, FALLBACK) \
+case Stmt::NAME ## Class:\
+return ImplementsPostVisit ## NAME();
+#include "clang/Checker/PathSensitive/CheckerVisitor.def"
+    }
+  }
+
   void PreVisit(CheckerContext &C, const Stmt *S) {
     switch (S->getStmtClass()) {
       default:
@@ -95,6 +129,38 @@ void PostVisit ## NAME(CheckerContext &C, const NAME* S) {\
   static_cast<ImplClass*>(this)->PostVisit ## FALLBACK(C, S);\
 }
 #include "clang/Checker/PathSensitive/CheckerVisitor.def"
+
+private:
+  /// isImplemented - Tells a visit method declared by ImplClass apart from
+  ///  the default one it inherits from CheckerVisitor, which only forwards
+  ///  to the fallback.
+  template <typename F, typename C>
+  static bool isImplemented(F C::*) { return true; }
+  template <typename F>
+  static bool isImplemented(F CheckerVisitor::*) { return false; }
+
+  static bool ImplementsPreVisitStmt() {
+    return isImplemented(&ImplClass::PreVisitStmt);
+  }
+  static bool ImplementsPostVisitStmt() {
+    return isImplemented(&ImplClass::PostVisitStmt);
+  }
+  static bool ImplementsPreVisitCastExpr() {
+    return isImplemented(&ImplClass::PreVisitCastExpr) ||
+           ImplementsPreVisitStmt();
+  }
+
+#define PREVISIT(NAME, FALLBACK) \
+static bool ImplementsPreVisit ## NAME() {\
+  return isImplemented(&ImplClass::PreVisit ## NAME) ||\
+         ImplementsPreVisit ## FALLBACK();\
+}
+#define POSTVISIT(NAME, FALLBACK) \
+static bool ImplementsPostVisit ## NAME() {\
+  return isImplemented(&ImplClass::PostVisit ## NAME) ||\
+         ImplementsPostVisit ## FALLBACK();\
+}
+#include "clang/Checker/PathSensitive/CheckerVisitor.def"
 };
 
 } // end clang namespace
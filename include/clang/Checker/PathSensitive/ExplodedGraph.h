@@ -27,6 +27,7 @@
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/Support/Casting.h"
 #include "clang/Analysis/Support/BumpVector.h"
+#include <vector>
 
 namespace clang {
 
@@ -80,6 +81,8 @@ class ExplodedNode : public llvm::FoldingSetNode {
 
     void addNode(ExplodedNode* N, ExplodedGraph &G);
 
+    void replaceNode(ExplodedNode *N);
+
     void setFlag() {
       assert(P == 0);
       P = AuxFlag;
@@ -242,6 +245,19 @@ protected:
   /// NumNodes - The number of nodes in the graph.
   unsigned NumNodes;
 
+  /// ReclaimInterval - The number of nodes created between attempts to
+  /// reclaim nodes, or zero if nodes are never reclaimed.
+  unsigned ReclaimInterval;
+
+  /// RecentNodes - The nodes created since nodes were last reclaimed.
+  std::vector<ExplodedNode*> RecentNodes;
+
+  /// FreeNodes - Reclaimed nodes, whose memory is reused by getNode.
+  std::vector<ExplodedNode*> FreeNodes;
+
+  bool shouldReclaim(ExplodedNode *N);
+  void reclaimNode(ExplodedNode *N);
+
 public:
   /// getNode - Retrieve the node associated with a (Location,State) pair,
   ///  where the 'Location' is a ProgramPoint in the CFG.  If no node for
@@ -267,7 +283,8 @@ public:
     return V;
   }
 
-  ExplodedGraph(ASTContext& ctx) : Ctx(ctx), NumNodes(0) {}
+  ExplodedGraph(ASTContext& ctx)
+    : Ctx(ctx), NumNodes(0), ReclaimInterval(0) {}
 
   ~ExplodedGraph() {}
 
@@ -311,10 +328,21 @@ public:
 
   const_eop_iterator eop_end() const { return EndNodes.end(); }
 
+  /// enableNodeReclamation - Every \arg Interval new nodes, remove the
+  ///  recently created nodes that are in the middle of a straight-line path
+  ///  and record nothing but the value of a subexpression.  Paths through
+  ///  them are kept by linking their predecessors and successors.
+  void enableNodeReclamation(unsigned Interval) { ReclaimInterval = Interval; }
+
+  /// reclaimRecentNodes - Reclaim what can be of the nodes created since
+  ///  the last call, if there are enough of them.  It must only be called
+  ///  when no node builder is active.
+  void reclaimRecentNodes();
+
   llvm::BumpPtrAllocator & getAllocator() { return BVC.getAllocator(); }
   BumpVectorContext &getNodeAllocator() { return BVC; }
 
-  ASTContext& getContext() { return Ctx; }
+  ASTContext& getContext() const { return Ctx; }
 
   typedef llvm::DenseMap<const ExplodedNode*, ExplodedNode*> NodeMap;
 
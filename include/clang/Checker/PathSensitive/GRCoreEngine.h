@@ -41,6 +41,17 @@ class GRCoreEngine {
   friend class GRSwitchNodeBuilder;
   friend class GREndPathNodeBuilder;
 
+public:
+  /// BudgetKind - The budgets ExecuteWorkList can run out of.
+  enum BudgetKind {
+    NoBudget,
+    StepBudget,
+    NodeBudget,
+    TimeBudget,
+    MemoryBudget
+  };
+
+private:
   GRSubEngine& SubEngine;
 
   /// G - The simulation graph.  Each node is a (location,state) pair.
@@ -56,6 +67,14 @@ class GRCoreEngine {
   ///   number of times different CFGBlocks have been visited along a path.
   GRBlockCounter::Factory BCounterFactory;
 
+  /// ExceededBudget - The budget that stopped the last ExecuteWorkList, if
+  ///  any.
+  BudgetKind ExceededBudget;
+
+  /// DroppedPaths - Whether a path was abandoned because it entered a block
+  ///  too often.
+  bool DroppedPaths;
+
   void GenerateNode(const ProgramPoint& Loc, const GRState* State,
                     ExplodedNode* Pred);
 
@@ -100,14 +119,16 @@ public:
   GRCoreEngine(ASTContext& ctx, GRSubEngine& subengine)
     : SubEngine(subengine), G(new ExplodedGraph(ctx)),
       WList(GRWorkList::MakeBFS()),
-      BCounterFactory(G->getAllocator()) {}
+      BCounterFactory(G->getAllocator()), ExceededBudget(NoBudget),
+      DroppedPaths(false) {}
 
   /// Construct a GRCoreEngine object to analyze the provided CFG and to
   ///  use the provided worklist object to execute the worklist algorithm.
   ///  The GRCoreEngine object assumes ownership of 'wlist'.
   GRCoreEngine(ASTContext& ctx, GRWorkList* wlist, GRSubEngine& subengine)
     : SubEngine(subengine), G(new ExplodedGraph(ctx)), WList(wlist),
-      BCounterFactory(G->getAllocator()) {}
+      BCounterFactory(G->getAllocator()), ExceededBudget(NoBudget),
+      DroppedPaths(false) {}
 
   ~GRCoreEngine() {
     delete WList;
@@ -121,8 +142,21 @@ public:
   ExplodedGraph* takeGraph() { return G.take(); }
 
   /// ExecuteWorkList - Run the worklist algorithm for a maximum number of
-  ///  steps.  Returns true if there is still simulation state on the worklist.
-  bool ExecuteWorkList(const LocationContext *L, unsigned Steps);
+  ///  steps, and, for each of them that is not zero, until the graph has
+  ///  MaxNodes nodes, MaxMillis milliseconds have passed or MaxMB megabytes
+  ///  have been allocated.  Returns true if there is still simulation state
+  ///  on the worklist.
+  bool ExecuteWorkList(const LocationContext *L, unsigned Steps,
+                       unsigned MaxNodes = 0, unsigned MaxMillis = 0,
+                       unsigned MaxMB = 0);
+
+  /// getExceededBudget - Returns the budget that stopped the last
+  ///  ExecuteWorkList before the worklist was empty, or NoBudget.
+  BudgetKind getExceededBudget() const { return ExceededBudget; }
+
+  /// hasDroppedPaths - Returns true if a path was abandoned before its end
+  ///  because it went around a loop too often.
+  bool hasDroppedPaths() const { return DroppedPaths; }
 };
 
 class GRStmtNodeBuilder {
@@ -83,6 +83,21 @@ class GRExprEngine : public GRSubEngine {
   typedef std::vector<std::pair<void *, Checker*> > CheckersOrdered;
   CheckersOrdered Checkers;
 
+  /// CheckerCallback - The kinds of callbacks made to the checkers.
+  enum CheckerCallback {
+    PreVisitCallback, PostVisitCallback, LocationCallback, BindCallback,
+    DeadSymbolsCallback, EndPathCallback, BranchConditionCallback,
+    NilReceiverCallback, EvalCallCallback, AssumeCallback, NumCheckerCallbacks
+  };
+
+  /// CallbackCheckers - The checkers that override each kind of callback, in
+  ///  the order they were registered.  The others are not called for it.
+  CheckersOrdered CallbackCheckers[NumCheckerCallbacks];
+
+  /// VisitCheckers - The checkers that visit each class of statement before
+  ///  it is evaluated, at index 2 * class + 1, and after, at 2 * class.
+  std::vector<CheckersOrdered> VisitCheckers;
+
   /// BR - The BugReporter associated with this engine.  It is important that
   //   this object be placed at the very end of member variables so that its
   //   destructor is called before the rest of the GRExprEngine is destroyed.
@@ -96,9 +111,20 @@ public:
   ~GRExprEngine();
 
   void ExecuteWorkList(const LocationContext *L, unsigned Steps = 150000) {
-    CoreEngine.ExecuteWorkList(L, Steps);
+    CoreEngine.ExecuteWorkList(L, Steps, AMgr.getMaxNodes(),
+                               AMgr.getMaxTime(), AMgr.getMaxMemory());
+  }
+
+  /// getExceededBudget - Returns the budget that stopped the analysis before
+  ///  every path was explored, or GRCoreEngine::NoBudget.
+  GRCoreEngine::BudgetKind getExceededBudget() const {
+    return CoreEngine.getExceededBudget();
   }
 
+  /// hasDroppedPaths - Returns true if a path was abandoned before its end
+  ///  because it went around a loop too often.
+  bool hasDroppedPaths() const { return CoreEngine.hasDroppedPaths(); }
+
   /// getContext - Return the ASTContext associated with this analysis.
   ASTContext& getContext() const { return G.getContext(); }
 
@@ -130,11 +156,41 @@ public:
 
   template <typename CHECKER>
   void registerCheck(CHECKER *check) {
-    unsigned entry = Checkers.size();
-    void *tag = CHECKER::getTag();
-    Checkers.push_back(std::make_pair(tag, check));
-    CheckerM[tag] = entry;
+    unsigned Callbacks = 0;
+    if (overridesCallback(&CHECKER::_PreVisit))
+      Callbacks |= 1 << PreVisitCallback;
+    if (overridesCallback(&CHECKER::_PostVisit))
+      Callbacks |= 1 << PostVisitCallback;
+    if (overridesCallback(&CHECKER::VisitLocation))
+      Callbacks |= 1 << LocationCallback;
+    if (overridesCallback(&CHECKER::PreVisitBind))
+      Callbacks |= 1 << BindCallback;
+    if (overridesCallback(&CHECKER::EvalDeadSymbols))
+      Callbacks |= 1 << DeadSymbolsCallback;
+    if (overridesCallback(&CHECKER::EvalEndPath))
+      Callbacks |= 1 << EndPathCallback;
+    if (overridesCallback(&CHECKER::VisitBranchCondition))
+      Callbacks |= 1 << BranchConditionCallback;
+    if (overridesCallback(&CHECKER::EvalNilReceiver))
+      Callbacks |= 1 << NilReceiverCallback;
+    if (overridesCallback(&CHECKER::EvalCallExpr))
+      Callbacks |= 1 << EvalCallCallback;
+    if (overridesCallback(&CHECKER::EvalAssume))
+      Callbacks |= 1 << AssumeCallback;
+    addChecker(CHECKER::getTag(), check, Callbacks);
   }
+
+private:
+  /// overridesCallback - Used by registerCheck to tell a callback declared by
+  ///  a checker apart from the default one it inherits from Checker.
+  template <typename F, typename C>
+  static bool overridesCallback(F C::*) { return true; }
+  template <typename F>
+  static bool overridesCallback(F Checker::*) { return false; }
+
+  void addChecker(void *tag, Checker *check, unsigned Callbacks);
+
+public:
   
   Checker *lookupChecker(void *tag) const;
 
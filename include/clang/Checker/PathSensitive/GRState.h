@@ -406,6 +406,10 @@ private:
   ///  a particular function.  This is used to unique states.
   llvm::FoldingSet<GRState> StateSet;
 
+  /// NumStateLookups - The number of states looked up in StateSet, whether
+  ///  or not they were already there.
+  unsigned NumStateLookups;
+
   /// ValueMgr - Object that manages the data for all created SVals.
   ValueManager ValueMgr;
 
@@ -420,6 +424,7 @@ public:
                  GRSubEngine &subeng)
     : EnvMgr(alloc),
       GDMFactory(alloc),
+      NumStateLookups(0),
       ValueMgr(alloc, Ctx, *this),
       Alloc(alloc) {
     StoreMgr.reset((*CreateStoreManager)(*this));
@@ -482,6 +487,10 @@ public:
 
   const GRState* getPersistentState(GRState& Impl);
 
+  /// PrintStats - Print how many states were created, how much of them they
+  ///  share, and how many versions of each generic data map entry there are.
+  void PrintStats() const;
+
   bool isEqual(const GRState* state, const Expr* Ex, const llvm::APSInt& V);
   bool isEqual(const GRState* state, const Expr* Ex, uint64_t);
 
@@ -74,6 +74,9 @@ public:
   static GRWorkList *MakeDFS();
   static GRWorkList *MakeBFS();
   static GRWorkList *MakeBFSBlockDFSContents();
+  static GRWorkList *MakeCoverageGuided();
 };
+
+typedef GRWorkList *(*GRWorkListCreator)();
 } // end clang namespace
 #endif
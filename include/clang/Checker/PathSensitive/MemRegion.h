@@ -226,14 +226,34 @@ public:
 /// SubRegion - A region that subsets another larger region.  Most regions
 ///  are subclasses of SubRegion.
 class SubRegion : public MemRegion {
+  friend class MemRegion;
+
+  // The super region of a region never changes, so the answers to the
+  // queries that walk the chain of super regions are computed once, when the
+  // region is created.
+
+  /// BaseRegion - What getBaseRegion() returns for this region.
+  const MemRegion *BaseRegion;
+
+  /// Space - The memory space at the end of the chain of super regions.
+  const MemSpaceRegion *Space;
+
+  /// Depth - The number of regions in the chain from this region to its
+  ///  memory space, not counting the memory space.
+  unsigned Depth;
+
 protected:
   const MemRegion* superRegion;
-  SubRegion(const MemRegion* sReg, Kind k) : MemRegion(k), superRegion(sReg) {}
+  SubRegion(const MemRegion* sReg, Kind k);
 public:
   const MemRegion* getSuperRegion() const {
     return superRegion;
   }
 
+  /// getDepth - Return the number of super regions of this region that are
+  ///  not memory spaces, plus one.
+  unsigned getDepth() const { return Depth; }
+
   MemRegionManager* getMemRegionManager() const;
 
   bool isSubRegionOf(const MemRegion* R) const;
@@ -721,12 +741,23 @@ class ElementRegion : public TypedRegion {
   QualType ElementType;
   SVal Index;
 
+  /// HasConstantIndex - Whether Index is a concrete integer that fits in
+  ///  ConstantIndex.
+  bool HasConstantIndex;
+  int64_t ConstantIndex;
+
   ElementRegion(QualType elementType, SVal Idx, const MemRegion* sReg)
     : TypedRegion(sReg, ElementRegionKind),
-      ElementType(elementType), Index(Idx) {
+      ElementType(elementType), Index(Idx), HasConstantIndex(false),
+      ConstantIndex(0) {
     assert((!isa<nonloc::ConcreteInt>(&Idx) ||
            cast<nonloc::ConcreteInt>(&Idx)->getValue().isSigned()) &&
            "The index must be signed");
+    if (nonloc::ConcreteInt *CI = dyn_cast<nonloc::ConcreteInt>(&Idx))
+      if (CI->getValue().getMinSignedBits() <= 64) {
+        HasConstantIndex = true;
+        ConstantIndex = CI->getValue().getSExtValue();
+      }
   }
 
   static void ProfileRegion(llvm::FoldingSetNodeID& ID, QualType elementType,
@@ -736,6 +767,15 @@ public:
 
   SVal getIndex() const { return Index; }
 
+  /// hasConstantIndex - Return true if the index is a concrete integer, which
+  ///  getConstantIndex() returns without going through the SVal.
+  bool hasConstantIndex() const { return HasConstantIndex; }
+
+  int64_t getConstantIndex() const {
+    assert(HasConstantIndex && "The index is not a constant");
+    return ConstantIndex;
+  }
+
   QualType getValueType(ASTContext&) const {
     return ElementType;
   }
@@ -37,6 +37,10 @@ public:
                                   /// internal state before optimizations are
                                   /// done.
   unsigned DisableRedZone    : 1; /// Set when -mno-red-zone is enabled.
+  unsigned LazyRecordTypes   : 1; /// Only lay out the records that are only
+                                  /// pointed to once their body is needed.
+  unsigned LimitDebugInfo    : 1; /// Only describe the classes whose vtable
+                                  /// is emitted here, and the used methods.
   unsigned MergeAllConstants : 1; /// Merge identical constants.
   unsigned NoCommon          : 1; /// Set when -fno-common or C++ is enabled.
   unsigned NoImplicitFloat   : 1; /// Set when -mno-implicit-float is enabled.
@@ -45,7 +49,11 @@ public:
                                   /// 2.0 runtime.
   unsigned OptimizationLevel : 3; /// The -O[0-4] option specified.
   unsigned OptimizeSize      : 1; /// If -Os is specified.
+  unsigned ReleaseFunctionBodies : 1; /// Free the statements of each function
+                                      /// once its code has been generated.
   unsigned SoftFloat         : 1; /// -soft-float.
+  unsigned StreamingCodeGen  : 1; /// Emit machine code for each function as
+                                  /// soon as it has been generated, at -O0.
   unsigned TimePasses        : 1; /// Set when -ftime-report is enabled.
   unsigned UnitAtATime       : 1; /// Unused. For mirroring GCC optimization
                                   /// selection.
@@ -54,6 +62,10 @@ public:
   unsigned VerifyModule      : 1; /// Control whether the module should be run
                                   /// through the LLVM Verifier.
 
+  /// Functions with more instructions than this, once generated, get a
+  /// cheaper per-function pipeline and are never inlined; 0 means no limit.
+  unsigned HugeFunctionThreshold;
+
   /// The code model to use (-mcmodel).
   std::string CodeModel;
 
@@ -64,6 +76,11 @@ public:
   /// non-empty.
   std::string DwarfDebugFlags;
 
+  /// The directory of the registry of inline functions and template
+  /// instantiations emitted by the other translation units of the build, if
+  /// non-empty.
+  std::string EmittedDefinitionsDir;
+
   /// The ABI to use for passing floating point arguments.
   std::string FloatABI;
 
@@ -88,6 +105,8 @@ public:
     DisableFPElim = 0;
     DisableLLVMOpts = 0;
     DisableRedZone = 0;
+    LazyRecordTypes = 0;
+    LimitDebugInfo = 0;
     MergeAllConstants = 1;
     NoCommon = 0;
     NoImplicitFloat = 0;
@@ -95,13 +114,16 @@ public:
     ObjCLegacyDispatch = 0;
     OptimizationLevel = 0;
     OptimizeSize = 0;
+    ReleaseFunctionBodies = 0;
     SoftFloat = 0;
+    StreamingCodeGen = 0;
     TimePasses = 0;
     UnitAtATime = 1;
     UnrollLoops = 0;
     UnwindTables = 0;
     VerifyModule = 1;
 
+    HugeFunctionThreshold = 0;
     Inlining = NoInlining;
     RelocationModel = "pic";
   }
@@ -56,6 +56,14 @@ class Compilation {
   /// Result files which should be removed on failure.
   ArgStringList ResultFiles;
 
+  /// Whether a clang -cc1 command has already run in the driver's process.
+  mutable bool RanCC1InProcess;
+
+  /// ExecuteCommandInDirectory - Execute a command in the current working
+  /// directory; see ExecuteCommand.
+  int ExecuteCommandInDirectory(const Command &C,
+                                const Command *&FailingCommand) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               InputArgList *Args);
@@ -115,7 +123,8 @@ public:
   void PrintJob(llvm::raw_ostream &OS, const Job &J,
                 const char *Terminator, bool Quote) const;
 
-  /// ExecuteCommand - Execute an actual command.
+  /// ExecuteCommand - Execute an actual command, in its directory if it has
+  /// one.
   ///
   /// \param FailingCommand - For non-zero results, this will be set to the
   /// Command which failed, if any.
@@ -128,6 +137,18 @@ public:
   /// Command which failed.
   /// \return The accumulated result code of the job.
   int ExecuteJob(const Job &J, const Command *&FailingCommand) const;
+
+  /// ExecuteCommandsInParallel - Execute a list of commands, running up to
+  /// \arg MaxParallel of them at once.  A command is only started once the
+  /// commands producing its inputs have finished, and no more commands are
+  /// started once one has failed.  The standard error of each command is
+  /// printed when it finishes, in the order of the list.
+  ///
+  /// \param FailingCommand - For non-zero results, this will be set to the
+  /// first Command in the list which failed.
+  /// \return The result code of the failing command.
+  int ExecuteCommandsInParallel(const JobList &Jobs, unsigned MaxParallel,
+                                const Command *&FailingCommand) const;
 };
 
 } // end namespace driver
@@ -0,0 +1,66 @@
+//===--- CompilationDatabase.h - Recorded Compiler Commands -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_DRIVER_COMPILATIONDATABASE_H_
+#define CLANG_DRIVER_COMPILATIONDATABASE_H_
+
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+namespace driver {
+
+/// CompilationDatabaseEntry - A compiler command recorded in a compilation
+/// database, written by -ccc-record-commands and run by -ccc-run-commands.
+///
+/// A compilation database has one entry per line, each a JSON object with
+/// the string fields "directory", "executable" and "output", and the string
+/// array fields "arguments" and "inputs".  Fields of other names are
+/// ignored.
+struct CompilationDatabaseEntry {
+  /// Directory - The working directory of the command.
+  std::string Directory;
+
+  /// Executable - The program to run.
+  std::string Executable;
+
+  /// Arguments - The arguments of the program, not including the program
+  /// itself.
+  std::vector<std::string> Arguments;
+
+  /// Inputs - The source files read by the command.
+  std::vector<std::string> Inputs;
+
+  /// Output - The file written by the command, or empty if there is none.
+  std::string Output;
+};
+
+/// WriteCompilationDatabaseEntry - Write \arg Entry as a line of a
+/// compilation database.
+void WriteCompilationDatabaseEntry(llvm::raw_ostream &OS,
+                                   const CompilationDatabaseEntry &Entry);
+
+/// ParseCompilationDatabase - Parse the entries of the compilation database
+/// \arg Buffer, skipping empty lines.
+///
+/// \param ErrorLine - On error, the line of the malformed entry.
+/// \return True on error.
+bool ParseCompilationDatabase(llvm::StringRef Buffer,
+                              std::vector<CompilationDatabaseEntry> &Entries,
+                              unsigned &ErrorLine);
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
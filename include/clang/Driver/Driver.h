@@ -29,6 +29,7 @@ namespace llvm {
 namespace clang {
 namespace driver {
   class Action;
+  class Arg;
   class ArgList;
   class Compilation;
   class HostInfo;
@@ -36,6 +37,7 @@ namespace driver {
   class InputInfo;
   class JobAction;
   class OptTable;
+  class PathProbeCache;
   class PipedJob;
   class ToolChain;
 
@@ -89,6 +91,14 @@ public:
   /// Only print tool bindings, don't build any jobs.
   unsigned CCCPrintBindings : 1;
 
+  /// Run a clang -cc1 command by calling CC1Main instead of starting a
+  /// process for it.
+  unsigned CCCIntegratedCC1 : 1;
+
+  /// CC1Main - The entry point of clang -cc1 in this executable, taking the
+  /// arguments after -cc1, or null if there is none.
+  int (*CC1Main)(const char **ArgBegin, const char **ArgEnd);
+
 private:
   /// Whether to check that input files exist when constructing compilation
   /// jobs.
@@ -116,9 +126,15 @@ private:
   /// Certain options suppress the 'no input files' warning.
   bool SuppressMissingInputWarning : 1;
 
+  /// The number of independent commands to run at once (-j).
+  unsigned NumParallelJobs;
+
   std::list<std::string> TempFiles;
   std::list<std::string> ResultFiles;
 
+  /// The cache of tool chain path probes named by CCC_PATH_CACHE, or null.
+  PathProbeCache *ProbeCache;
+
 public:
   Driver(llvm::StringRef _Name, llvm::StringRef _Dir,
          llvm::StringRef _DefaultHostTriple,
@@ -177,6 +193,23 @@ public:
   /// \arg C - The compilation that is being built.
   void BuildJobs(Compilation &C) const;
 
+  /// BuildJobsFromDatabase - Build the list of jobs to run from the commands
+  /// of a compilation database, instead of from the inputs.  With
+  /// -ccc-analyze-commands, the jobs analyze the sources of the compilations
+  /// instead of compiling them.
+  ///
+  /// \arg C - The compilation that is being built.
+  /// \arg A - The -ccc-run-commands argument naming the database.
+  void BuildJobsFromDatabase(Compilation &C, const Arg &A) const;
+
+  /// RecordCommands - Append the clang -cc1 commands of a compilation to a
+  /// compilation database.  Commands writing to temporary files are left
+  /// out, as their outputs do not outlive the driver.
+  ///
+  /// \arg C - The compilation whose commands are recorded.
+  /// \arg File - The compilation database to append to.
+  void RecordCommands(const Compilation &C, const char *File) const;
+
   /// ExecuteCompilation - Execute the compilation according to the command line
   /// arguments and return an appropriate exit code.
   ///
@@ -224,6 +257,11 @@ public:
   std::string GetProgramPath(const char *Name, const ToolChain &TC,
                               bool WantFile = false) const;
 
+  /// PathExists, PathCanExecute - Probe a tool chain path, through the cache
+  /// of probes if there is one.
+  bool PathExists(llvm::StringRef Path) const;
+  bool PathCanExecute(llvm::StringRef Path) const;
+
   /// HandleImmediateArgs - Handle any arguments which should be
   /// treated before building actions or binding tools.
   ///
@@ -66,6 +66,10 @@ class Command : public Job {
   /// argument, which will be the executable).
   ArgStringList Arguments;
 
+  /// The directory to run the executable in, or null for the driver's
+  /// working directory.
+  const char *Directory;
+
 public:
   Command(const Action &_Source, const Tool &_Creator, const char *_Executable,
           const ArgStringList &_Arguments);
@@ -80,6 +84,9 @@ public:
 
   const ArgStringList &getArguments() const { return Arguments; }
 
+  const char *getDirectory() const { return Directory; }
+  void setDirectory(const char *Value) { Directory = Value; }
+
   static bool classof(const Job *J) {
     return J->getKind() == CommandClass;
   }
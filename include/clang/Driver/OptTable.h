@@ -75,6 +75,16 @@ namespace options {
     /// special option like 'input' or 'unknown', and is not an option group).
     unsigned FirstSearchableIndex;
 
+    /// The hash table of the names of the searchable options, holding the
+    /// index + 1 of the first option with each name, or 0 in empty buckets.
+    unsigned *NameIndex;
+
+    /// The number of buckets of NameIndex, a power of two.
+    unsigned NameIndexSize;
+
+    /// The length of the longest option name.
+    unsigned MaxNameLength;
+
   private:
     const Info &getInfo(OptSpecifier Opt) const {
       unsigned id = Opt.getID();
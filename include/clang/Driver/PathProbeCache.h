@@ -0,0 +1,68 @@
+//===--- PathProbeCache.h - Persistent Tool Chain Probes --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_DRIVER_PATHPROBECACHE_H_
+#define CLANG_DRIVER_PATHPROBECACHE_H_
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/DataTypes.h"
+#include <string>
+
+namespace clang {
+namespace driver {
+
+/// PathProbeCache - A file recording which of the paths the tool chains
+/// probe for libraries, startup files and programs exist, so that driver
+/// invocations do not go back to a slow file system, such as an NFS mounted
+/// tool chain root, for each of them.
+///
+/// Each answer is recorded along with the modification time of the
+/// directory of the path, and is only used while the directory has not
+/// changed; each directory is checked once per driver invocation.
+class PathProbeCache {
+  struct Entry {
+    uint64_t DirTime;
+    signed char Exists, Executable; // -1 if not probed yet.
+  };
+
+  std::string File;
+  llvm::StringMap<Entry> Entries;
+
+  /// DirTimes - The modification times of the directories checked by this
+  /// invocation, zero for the ones that do not exist.
+  llvm::StringMap<uint64_t> DirTimes;
+
+  bool Dirty;
+
+  uint64_t getDirTime(llvm::StringRef Dir);
+  bool probe(llvm::StringRef Path, bool Executable);
+
+public:
+  // The current cache file version.
+  enum { Version = 1 };
+
+  /// \brief Load the cache stored in \p File, if there is a valid one.
+  explicit PathProbeCache(llvm::StringRef File);
+
+  /// \brief Store the cache back to its file if new answers were probed.
+  /// Failures are ignored; the cache is only an optimization.
+  ~PathProbeCache();
+
+  /// exists - Return true if Path names an existing file.
+  bool exists(llvm::StringRef Path) { return probe(Path, false); }
+
+  /// canExecute - Return true if Path names an executable file.
+  bool canExecute(llvm::StringRef Path) { return probe(Path, true); }
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
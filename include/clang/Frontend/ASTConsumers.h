@@ -29,6 +29,7 @@ class CodeGenOptions;
 class Diagnostic;
 class FileManager;
 class LangOptions;
+class PCHCache;
 class Preprocessor;
 class TargetOptions;
 
@@ -44,6 +45,11 @@ ASTConsumer *CreateASTPrinter(llvm::raw_ostream *OS);
 // but the implementation is still incomplete.
 ASTConsumer *CreateASTPrinterXML(llvm::raw_ostream *OS);
 
+// AST exporter: writes the declarations and statements of each top-level
+// declaration to a compact bitstream as soon as it is parsed.  The format is
+// described in ASTExport.h, which also declares a reader for it.
+ASTConsumer *CreateASTExporter(llvm::raw_ostream *OS);
+
 // AST dumper: dumps the raw AST in human-readable form to stderr; this is
 // intended for debugging.
 ASTConsumer *CreateASTDumper();
@@ -61,6 +67,11 @@ ASTConsumer *CreateDeclContextPrinter();
 // in the translation unit; this is intended for debugging.
 ASTConsumer *CreateRecordLayoutDumper();
 
+// Unused include printer: lists the #includes of the main file that provide
+// no declaration, type or macro that the rest of the translation unit uses.
+ASTConsumer *CreateUnusedIncludesPrinter(llvm::raw_ostream *OS,
+                                         Preprocessor &PP);
+
 // ObjC rewriter: attempts tp rewrite ObjC constructs into pure C code.
 // This is considered experimental, and only works with Apple's ObjC runtime.
 ASTConsumer *CreateObjCRewriter(const std::string &InFile,
@@ -97,10 +108,14 @@ ASTConsumer *CreateHTMLPrinter(llvm::raw_ostream *OS, Preprocessor &PP,
 
 // PCH generator: generates a precompiled header file; this file can be used
 // later with the PCHReader (clang -cc1 option -include-pch) to speed up compile
-// times.
+// times.  With HashInputFiles, the hashes of the input files are recorded too.
+// If a Cache is given, the generator takes ownership of it and installs the PCH
+// file in it.
 ASTConsumer *CreatePCHGenerator(const Preprocessor &PP,
                                 llvm::raw_ostream *OS,
-                                const char *isysroot = 0);
+                                const char *isysroot = 0,
+                                bool HashInputFiles = false,
+                                PCHCache *Cache = 0);
 
 // Inheritance viewer: for C++ code, creates a graph of the inheritance
 // tree for the given class and displays it with "dotty".
@@ -0,0 +1,122 @@
+//===--- ASTExport.h - Streaming binary export of ASTs ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the format of the AST export streams written by
+// CreateASTExporter, and a reader for them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_AST_EXPORT_H
+#define LLVM_CLANG_FRONTEND_AST_EXPORT_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/BitCodes.h"
+
+namespace clang {
+
+namespace ast_export {
+  /// \brief The version of the AST export format.
+  const unsigned VERSION_MAJOR = 1;
+
+  /// \brief The block IDs of an AST export stream.
+  ///
+  /// A stream starts with the signature 'ASTX', a block info block and a
+  /// META block, followed by one DECL block per top-level declaration.  Each
+  /// DECL block is complete on its own, so a reader can stop at any block
+  /// boundary.
+  enum BlockIDs {
+    /// \brief Holds the VERSION record.
+    META_BLOCK_ID = llvm::bitc::FIRST_APPLICATION_BLOCKID,
+
+    /// \brief Holds a top-level declaration, the declarations within it and
+    /// their statements.
+    DECL_BLOCK_ID
+  };
+
+  /// \brief The records of an AST export stream.
+  ///
+  /// A source location is written as three fields: a file ID, a line and a
+  /// column.  File ID 0 denotes an invalid location; other file IDs are
+  /// defined by a FILENAME record before their first use.  Declaration and
+  /// statement kinds are those of the compiler that wrote the stream, and
+  /// are named by a DECL_KIND or STMT_KIND record before their first use.
+  ///
+  /// Declarations and statements are numbered from 1 in the order of their
+  /// records, separately, over the whole stream.  A parent of 0 is the
+  /// translation unit for a declaration, and the owning declaration for a
+  /// statement.
+  enum RecordIDs {
+    /// \brief [version]
+    RECORD_VERSION = 1,
+
+    /// \brief [file ID, name blob]
+    RECORD_FILENAME = 2,
+
+    /// \brief [kind, name blob]
+    RECORD_DECL_KIND = 3,
+
+    /// \brief [kind, name blob]
+    RECORD_STMT_KIND = 4,
+
+    /// \brief [parent declaration, kind, location, blob].  The blob is the
+    /// name of the declaration, a NUL, and its type, if it has one.
+    RECORD_DECL = 5,
+
+    /// \brief [owning declaration, parent statement, kind, location]
+    RECORD_STMT = 6
+  };
+}
+
+/// \brief The file, line and column of a location in an AST export
+/// stream.  An invalid location has an empty file name.
+struct ExportedLocation {
+  llvm::StringRef File;
+  unsigned Line, Column;
+};
+
+/// \brief A declaration read from an AST export stream.  The strings are
+/// only valid during the call to ASTExportVisitor::VisitDecl.
+struct ExportedDecl {
+  unsigned ID, Parent;
+  unsigned Kind;
+  llvm::StringRef KindName, Name, Type;
+  ExportedLocation Loc;
+};
+
+/// \brief A statement read from an AST export stream.  The strings are only
+/// valid during the call to ASTExportVisitor::VisitStmt.
+struct ExportedStmt {
+  unsigned ID, Owner, Parent;
+  unsigned Kind;
+  llvm::StringRef KindName;
+  ExportedLocation Loc;
+};
+
+/// \brief The client of ReadASTExport, which sees every declaration and
+/// statement in the order of the stream: a declaration before the ones
+/// within it and its statements, a statement before its children.
+class ASTExportVisitor {
+public:
+  virtual ~ASTExportVisitor();
+
+  virtual void VisitDecl(const ExportedDecl &D) { }
+  virtual void VisitStmt(const ExportedStmt &S) { }
+};
+
+/// \brief Read the AST export stream in \p Buffer, handing its declarations
+/// and statements to \p Visitor.  Nothing but the names of files and kinds
+/// is kept while scanning, so streams of any size can be read.
+///
+/// \returns true if the stream is malformed or truncated.  The records up
+/// to that point have still been visited.
+bool ReadASTExport(llvm::StringRef Buffer, ASTExportVisitor &Visitor);
+
+} // end namespace clang
+
+#endif
@@ -15,6 +15,7 @@
 #define LLVM_CLANG_FRONTEND_ASTUNIT_H
 
 #include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Index/ASTLocation.h"
@@ -30,30 +31,58 @@ namespace llvm {
 }
 
 namespace clang {
+class ASTConsumer;
 class ASTContext;
+class CodeCompleteConsumer;
 class CompilerInvocation;
 class Decl;
 class Diagnostic;
+class DiagnosticClient;
 class FileEntry;
 class FileManager;
+class FunctionDecl;
 class HeaderSearch;
 class Preprocessor;
+class PreprocessorOptions;
+class SkippedBodyParser;
 class SourceManager;
 class TargetInfo;
 
 using namespace idx;
 
+/// \brief Data that a client computes from an ASTUnit and keeps with it, such
+/// as an index of its cursors.  It is destroyed whenever the AST changes.
+///
+/// Each kind of data is attached under its own key, usually the address of
+/// a static variable of the client, so that independent clients do not
+/// evict each other's data.
+class ASTUnitClientData {
+public:
+  virtual ~ASTUnitClientData();
+};
+
 /// \brief Utility class for loading a ASTContext from a PCH file.
 ///
 class ASTUnit {
-  FileManager FileMgr;
+public:
+  /// \brief A mapping from a file name to the memory buffer that stores the
+  /// remapped contents of that file.
+  typedef std::pair<std::string, const llvm::MemoryBuffer *> RemappedFile;
 
-  SourceManager                     SourceMgr;
+private:
+  llvm::OwningPtr<FileManager>      FileMgr;
+  llvm::OwningPtr<SourceManager>    SourceMgr;
   llvm::OwningPtr<HeaderSearch>     HeaderInfo;
   llvm::OwningPtr<TargetInfo>       Target;
   llvm::OwningPtr<Preprocessor>     PP;
   llvm::OwningPtr<ASTContext>       Ctx;
 
+  /// The consumer and parser of a translation unit parsed with
+  /// SkipFunctionBodies, kept to parse the skipped bodies on demand.  They
+  /// refer to the preprocessor and context, so they are destroyed first.
+  llvm::OwningPtr<ASTConsumer>       Consumer;
+  llvm::OwningPtr<SkippedBodyParser> BodyParser;
+
   /// Optional owned invocation, just used to make the invocation used in
   /// LoadFromCommandLine available.
   llvm::OwningPtr<CompilerInvocation> Invocation;
@@ -66,6 +95,13 @@ class ASTUnit {
   /// Track whether the main file was loaded from an AST or not.
   bool MainFileIsAST;
 
+  /// Whether each parse captures the diagnostics it produces.
+  bool CaptureDiagnostics;
+
+  /// Whether the preamble of the main file is precompiled, so that reparsing
+  /// the translation unit only parses the rest of the main file again.
+  bool PrecompilePreamble;
+
   /// Track the top-level decls which appeared in an ASTUnit which was loaded
   /// from a source file.
   //
@@ -75,12 +111,23 @@ class ASTUnit {
   // more scalable search mechanisms.
   std::vector<Decl*> TopLevelDecls;
 
+  /// \brief The top-level declarations that lexically appear in each file, in
+  /// order.
+  llvm::DenseMap<FileID, std::vector<Decl*> > FileDecls;
+
+  /// \brief Whether FileDecls also holds the top-level declarations that were
+  /// loaded from a PCH file.
+  bool FileDeclsHavePCHDecls;
+
   /// The name of the original source file used to generate this ASTUnit.
   std::string OriginalSourceFile;
 
   // Critical optimization when using clang_getCursor().
   ASTLocation LastLoc;
 
+  /// \brief The data clients attached to this unit, by key.
+  llvm::DenseMap<const void *, ASTUnitClientData *> ClientData;
+
   /// \brief The set of diagnostics produced when creating this
   /// translation unit.
   llvm::SmallVector<StoredDiagnostic, 4> Diagnostics;
@@ -88,7 +135,69 @@ class ASTUnit {
   /// \brief Temporary files that should be removed when the ASTUnit is 
   /// destroyed.
   llvm::SmallVector<llvm::sys::Path, 4> TemporaryFiles;
-  
+
+  /// \brief The text of the preamble of the main file, i.e., the comments and
+  /// preprocessor directives it starts with, that PreamblePCH was built from.
+  std::string PreambleText;
+
+  /// \brief The PCH file that code completion reuses the preamble from, or
+  /// empty if no preamble has been built.
+  llvm::sys::Path PreamblePCH;
+
+  /// \brief The files that the preamble includes, with their modification
+  /// times when PreamblePCH was built.
+  std::vector<std::pair<std::string, time_t> > PreambleDependencies;
+
+  /// \brief The current text of the main file when the last Reparse() only
+  /// gave one function a new body, or empty.  SourceMgr still holds the main
+  /// file as it was when the translation unit was last parsed in full.
+  std::string EditedMainText;
+
+  /// \brief The function whose body was replaced, and the offsets of the
+  /// braces of that body in EditedMainText.
+  FunctionDecl *EditedFunction;
+  unsigned EditedBodyBegin;
+  unsigned EditedBodyEnd;
+
+  /// \brief The FileID that the body of EditedFunction was lexed from, which
+  /// has the offsets of EditedMainText.
+  FileID EditedBodyFID;
+
+  /// \brief The number of calls to Reparse() that only gave one function a
+  /// new body.
+  unsigned NumFunctionBodyReparses;
+
+  /// \brief Bring the translation unit up to date with \p RemappedFiles by
+  /// giving a new body to the one function whose body they changed, if the
+  /// only change is within the body of a function.  Returns false if the
+  /// change is anything else, in which case the translation unit must be
+  /// parsed again and the caller still owns \p RemappedFiles.
+  bool ReparseFunctionBody(RemappedFile *RemappedFiles,
+                           unsigned NumRemappedFiles);
+
+  /// \brief Make PreamblePCH hold the preamble \p Text of the main file,
+  /// rebuilding it if the text or one of the files it includes changed.
+  /// Returns false if no usable preamble could be built.
+  bool UpdatePreamble(llvm::StringRef Text);
+
+  /// \brief Add \p RemappedFiles to \p PPOpts, which then owns the buffers.
+  ///
+  /// If \p UsePreamble is true, the preamble of the main file is taken from
+  /// PreamblePCH, which is rebuilt if needed.  \p Line and \p Column, if
+  /// nonzero, are a location in the main file that the preamble must end
+  /// before.
+  void AddRemappedFiles(PreprocessorOptions &PPOpts,
+                        RemappedFile *RemappedFiles, unsigned NumRemappedFiles,
+                        bool UsePreamble, unsigned Line, unsigned Column);
+
+  /// \brief Parse the translation unit described by Invocation into this
+  /// ASTUnit.  Returns true on error.
+  ///
+  /// If \p DiagObserver is non-null, it is shown each diagnostic of the parse
+  /// as it is produced, in addition to the diagnostics being stored.
+  bool Parse(Diagnostic &Diags, RemappedFile *RemappedFiles,
+             unsigned NumRemappedFiles, DiagnosticClient *DiagObserver);
+
   ASTUnit(const ASTUnit&); // DO NOT IMPLEMENT
   ASTUnit &operator=(const ASTUnit &); // DO NOT IMPLEMENT
 
@@ -98,8 +207,8 @@ public:
 
   bool isMainFileAST() const { return MainFileIsAST; }
 
-  const SourceManager &getSourceManager() const { return SourceMgr; }
-        SourceManager &getSourceManager()       { return SourceMgr; }
+  const SourceManager &getSourceManager() const { return *SourceMgr.get(); }
+        SourceManager &getSourceManager()       { return *SourceMgr.get(); }
 
   const Preprocessor &getPreprocessor() const { return *PP.get(); }
         Preprocessor &getPreprocessor()       { return *PP.get(); }
@@ -107,12 +216,27 @@ public:
   const ASTContext &getASTContext() const { return *Ctx.get(); }
         ASTContext &getASTContext()       { return *Ctx.get(); }
 
-  const FileManager &getFileManager() const { return FileMgr; }
-        FileManager &getFileManager()       { return FileMgr; }
+  const FileManager &getFileManager() const { return *FileMgr.get(); }
+        FileManager &getFileManager()       { return *FileMgr.get(); }
 
   const std::string &getOriginalSourceFileName();
   const std::string &getPCHFileName();
 
+  /// \brief Get the source location for the given file:line:col triplet.
+  ///
+  /// Unlike SourceManager::getLocation(), this takes into account the edits
+  /// made to the main file by Reparse() without parsing it again in full: a
+  /// position within the body of the function edited last is found in the
+  /// new text of that body.
+  SourceLocation getLocation(const FileEntry *File, unsigned Line,
+                             unsigned Column) const;
+
+  /// \brief Get the number of calls to Reparse() that only had to parse the
+  /// body of one function again.
+  unsigned getNumFunctionBodyReparses() const {
+    return NumFunctionBodyReparses;
+  }
+
   /// \brief Add a temporary file that the ASTUnit depends on.
   ///
   /// This file will be erased when the ASTUnit is destroyed.
@@ -125,6 +249,43 @@ public:
   void setLastASTLocation(ASTLocation ALoc) { LastLoc = ALoc; }
   ASTLocation getLastASTLocation() const { return LastLoc; }
 
+  /// \brief Return the data attached to this unit under \p Key, or null if
+  /// there is none or the AST changed since it was attached.
+  ASTUnitClientData *getClientData(const void *Key) const;
+
+  /// \brief Attach \p Data to this unit under \p Key, which takes ownership
+  /// of it.  Any data previously attached under \p Key is destroyed.
+  void setClientData(const void *Key, ASTUnitClientData *Data);
+
+  /// \brief Destroy all the data attached to this unit.
+  void clearClientData();
+
+  /// \brief The number of bytes used by an ASTUnit, by subsystem.
+  struct MemoryUsage {
+    size_t AST;           ///< AST nodes and the lists of top-level decls.
+    size_t SourceFiles;   ///< Contents of the source files and buffers.
+    size_t LineTables;    ///< Line number tables of the source files.
+    size_t SourceManager; ///< Tables of source location entries.
+    size_t Preprocessor;  ///< Macro definitions and token caches.
+    size_t PCH;           ///< The PCH file read from, and its tables.
+    size_t Diagnostics;   ///< The stored diagnostics.
+  };
+
+  /// \brief Compute the memory used by this unit.
+  void getMemoryUsage(MemoryUsage &Usage) const;
+
+  /// \brief Free the caches that are rebuilt when they are next needed: line
+  /// number tables, file buffers, comment and preprocessor caches and client
+  /// data.  The stored diagnostics are dropped as well.
+  void releaseCaches();
+
+  /// \brief If the body of \p FD was skipped when the translation unit was
+  /// parsed, parse it now.
+  ///
+  /// Clients call this before looking into a function body so that bodies
+  /// are only parsed where they are needed.
+  void ParseSkippedFunctionBody(FunctionDecl *FD);
+
   std::vector<Decl*> &getTopLevelDecls() {
     assert(!isMainFileAST() && "Invalid call for AST based ASTUnit!");
     return TopLevelDecls;
@@ -134,6 +295,14 @@ public:
     return TopLevelDecls;
   }
 
+  /// \brief Note that the top-level declaration \p D was parsed.
+  void addFileLevelDecl(Decl *D);
+
+  /// \brief Append to \p Decls the top-level declarations that lexically
+  /// appear in \p File, in order, one inclusion of the file after the other.
+  void getFileLevelDecls(const FileEntry *File,
+                         llvm::SmallVectorImpl<Decl*> &Decls);
+
   // Retrieve the diagnostics associated with this AST
   typedef const StoredDiagnostic * diag_iterator;
   diag_iterator diag_begin() const { return Diagnostics.begin(); }
@@ -143,10 +312,6 @@ public:
     return Diagnostics; 
   }
 
-  /// \brief A mapping from a file name to the memory buffer that stores the
-  /// remapped contents of that file.
-  typedef std::pair<std::string, const llvm::MemoryBuffer *> RemappedFile;
-  
   /// \brief Create a ASTUnit from a PCH file.
   ///
   /// \param Filename - The PCH file to load.
@@ -170,13 +335,22 @@ public:
   ///
   /// \param Diags - The diagnostics engine to use for reporting errors; its
   /// lifetime is expected to extend past that of the returned ASTUnit.
+  ///
+  /// \param PrecompilePreamble - Precompile the preamble of the main file, so
+  /// that Reparse() only parses the rest of it again.
+  ///
+  /// \param DiagObserver - If non-null, a client that is shown each captured
+  /// diagnostic while the translation unit is parsed, as it is produced.  It
+  /// is not used after this call returns.
   //
   // FIXME: Move OnlyLocalDecls, UseBumpAllocator to setters on the ASTUnit, we
   // shouldn't need to specify them at construction time.
   static ASTUnit *LoadFromCompilerInvocation(CompilerInvocation *CI,
                                              Diagnostic &Diags,
                                              bool OnlyLocalDecls = false,
-                                             bool CaptureDiagnostics = false);
+                                             bool CaptureDiagnostics = false,
+                                             bool PrecompilePreamble = false,
+                                          DiagnosticClient *DiagObserver = 0);
 
   /// LoadFromCommandLine - Create an ASTUnit from a vector of command line
   /// arguments, which must specify exactly one source file.
@@ -189,6 +363,16 @@ public:
   /// lifetime is expected to extend past that of the returned ASTUnit.
   ///
   /// \param ResourceFilesPath - The path to the compiler resource files.
+  ///
+  /// \param SkipFunctionBodies - Skip over function bodies instead of parsing
+  /// them; the range of each skipped body is recorded in the ASTContext.
+  ///
+  /// \param PrecompilePreamble - Precompile the preamble of the main file, so
+  /// that Reparse() only parses the rest of it again.
+  ///
+  /// \param DiagObserver - If non-null, a client that is shown each captured
+  /// diagnostic while the translation unit is parsed, as it is produced.  It
+  /// is not used after this call returns.
   //
   // FIXME: Move OnlyLocalDecls, UseBumpAllocator to setters on the ASTUnit, we
   // shouldn't need to specify them at construction time.
@@ -199,7 +383,59 @@ public:
                                       bool OnlyLocalDecls = false,
                                       RemappedFile *RemappedFiles = 0,
                                       unsigned NumRemappedFiles = 0,
-                                      bool CaptureDiagnostics = false);
+                                      bool CaptureDiagnostics = false,
+                                      bool SkipFunctionBodies = false,
+                                      bool PrecompilePreamble = false,
+                                      DiagnosticClient *DiagObserver = 0);
+
+  /// \brief Parse the translation unit again, from the files as they are now.
+  /// The buffers of files that did not change are reused.
+  ///
+  /// If the ASTUnit was created with PrecompilePreamble, the preamble of the
+  /// main file is reused from a PCH file for as long as it and the files it
+  /// includes do not change; diagnostics within the preamble are then only
+  /// reported by the parse that built it.  All declarations, locations and
+  /// diagnostics of the previous parse are invalidated.
+  ///
+  /// If the ASTUnit was created with SkipFunctionBodies and the only change
+  /// is an edit to the main file within the body of one function, that keeps
+  /// the lines of the file where they were, only the body of that function
+  /// is lexed again, to be parsed when it is next asked for.  The rest of the
+  /// translation unit is kept, and so are its declarations and diagnostics.
+  /// The locations of the new body are in a FileID of their own for the main
+  /// file, with the lines and columns of the edited text.
+  ///
+  /// \param RemappedFiles - The current contents of the files that differ
+  /// from the ones on disk.  The ASTUnit takes ownership of the buffers.
+  ///
+  /// \returns true if the translation unit could not be parsed.
+  bool Reparse(Diagnostic &Diags, RemappedFile *RemappedFiles = 0,
+               unsigned NumRemappedFiles = 0);
+
+  /// \brief Perform code completion at the given location, reparsing the
+  /// translation unit in-process.
+  ///
+  /// The first completion in the main file precompiles its preamble, the
+  /// comments and preprocessor directives it starts with, into a PCH file
+  /// that later completions reuse for as long as the preamble and the files
+  /// it includes do not change.  Only the rest of the main file is parsed
+  /// again for each completion.
+  ///
+  /// \param RemappedFiles - The current contents of the files that differ
+  /// from the ones on disk.  The buffers are owned by SourceMgr afterwards.
+  ///
+  /// \param Consumer - Receives the code-completion results.
+  ///
+  /// \param FileMgr, SourceMgr - The file and source managers to parse with.
+  /// They must outlive the stored diagnostics.
+  ///
+  /// \returns false if the translation unit was not parsed from source, so
+  /// that it cannot be reparsed.
+  bool CodeComplete(llvm::StringRef File, unsigned Line, unsigned Column,
+                    RemappedFile *RemappedFiles, unsigned NumRemappedFiles,
+                    CodeCompleteConsumer &Consumer, Diagnostic &Diags,
+                    FileManager &FileMgr, SourceManager &SourceMgr,
+                    llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiagnostics);
 };
 
 } // namespace clang
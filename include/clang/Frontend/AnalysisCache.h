@@ -0,0 +1,54 @@
+//===--- AnalysisCache.h - Cache of clean analysis results ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the AnalysisCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_ANALYSISCACHE_H
+#define LLVM_CLANG_FRONTEND_ANALYSISCACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/Path.h"
+#include <string>
+
+namespace clang {
+
+/// AnalysisCache - A directory recording the declarations in which the
+/// analyzer found no bugs, so that analyzing them again with the same inputs
+/// can be skipped.
+///
+/// The key of a declaration is everything its analysis depends on: the
+/// compiler version and analyzer configuration, the source of the
+/// translation unit and the source of the declaration itself.  An entry is
+/// named by a hash of the key and holds the key, to tell apart keys that
+/// hash to the same name.  Only declarations without reports are recorded,
+/// so the reports of the others are always produced afresh.  Entries are
+/// written to a temporary file and renamed into place, so any number of
+/// analyzers may use the cache at the same time.
+class AnalysisCache {
+  /// Dir - The directory holding the entries.
+  llvm::sys::Path Dir;
+
+  llvm::sys::Path getEntryPath(llvm::StringRef Key) const;
+
+public:
+  explicit AnalysisCache(llvm::StringRef Dir) : Dir(Dir) {}
+
+  /// lookup - Return true if an analysis with this \arg Key found no bugs.
+  bool lookup(llvm::StringRef Key) const;
+
+  /// store - Record that an analysis with this \arg Key found no bugs.
+  ///  Failing to do so is not an error.
+  void store(llvm::StringRef Key) const;
+};
+
+}  // end namespace clang
+
+#endif
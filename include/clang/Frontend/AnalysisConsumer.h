@@ -45,6 +45,13 @@ enum AnalysisConstraints {
 NumConstraints
 };
 
+/// AnalysisWorkLists - Set of available orders of exploring paths.
+enum AnalysisWorkLists {
+#define ANALYSIS_WORKLIST(NAME, CMDFLAG, DESC, CREATFN) NAME##WorkList,
+#include "clang/Frontend/Analyses.def"
+NumWorkLists
+};
+
 /// AnalysisDiagClients - Set of available diagnostic clients for rendering
 ///  analysis results.
 enum AnalysisDiagClients {
@@ -58,8 +65,31 @@ public:
   std::vector<Analyses> AnalysisList;
   AnalysisStores AnalysisStoreOpt;
   AnalysisConstraints AnalysisConstraintsOpt;
+  AnalysisWorkLists AnalysisWorkListOpt;
   AnalysisDiagClients AnalysisDiagOpt;
   std::string AnalyzeSpecificFunction;
+  /// The analyzed code is split into AnalyzerShards shards, of which only
+  /// the one numbered AnalyzerShardIndex is analyzed.
+  unsigned AnalyzerShards;
+  unsigned AnalyzerShardIndex;
+  /// The budget of the path-sensitive analysis of each function, in nodes,
+  /// milliseconds and megabytes; zero means no limit.
+  unsigned MaxNodes;
+  unsigned MaxTime;
+  unsigned MaxMemory;
+  /// The number of exploded graph nodes created between reclamations of
+  /// nodes on straight-line paths; zero means nodes are never reclaimed.
+  unsigned ReclaimInterval;
+  /// The directory recording the functions in which earlier analyses with
+  /// the same inputs found no bugs; empty if there is none.
+  std::string CacheDir;
+  /// The file summarizing the reports and the analysis of each function, for
+  /// comparing runs without reading their reports; empty if there is none.
+  std::string StatsFile;
+  /// The table of retain/release summaries of the functions and methods
+  /// declared in system headers, shared by the analyses against one SDK;
+  /// empty if there is none.
+  std::string RetainSummaryFile;
   unsigned AnalyzeAll : 1;
   unsigned AnalyzerDisplayProgress : 1;
   unsigned AnalyzeNestedBlocks : 1;
@@ -70,11 +100,20 @@ public:
   unsigned VisualizeEGUbi : 1;
   unsigned EnableExperimentalChecks : 1;
   unsigned EnableExperimentalInternalChecks : 1;
+  unsigned SummarizeCalls : 1;
+  unsigned StateStats : 1;
 public:
   AnalyzerOptions() {
     AnalysisStoreOpt = BasicStoreModel;
     AnalysisConstraintsOpt = RangeConstraintsModel;
+    AnalysisWorkListOpt = BFSWorkList;
     AnalysisDiagOpt = PD_HTML;
+    AnalyzerShards = 1;
+    AnalyzerShardIndex = 0;
+    MaxNodes = 0;
+    MaxTime = 0;
+    MaxMemory = 0;
+    ReclaimInterval = 0;
     AnalyzeAll = 0;
     AnalyzerDisplayProgress = 0;
     AnalyzeNestedBlocks = 0;
@@ -85,6 +124,8 @@ public:
     VisualizeEGUbi = 0;
     EnableExperimentalChecks = 0;
     EnableExperimentalInternalChecks = 0;
+    SummarizeCalls = 0;
+    StateStats = 0;
   }
 };
 
@@ -33,7 +33,11 @@ class DiagnosticClient;
 class ExternalASTSource;
 class FileManager;
 class FrontendAction;
+class IncludeCostReport;
+class InstantiationProfile;
+class PhaseStatistics;
 class Preprocessor;
+class SharedIdentifierTable;
 class Source;
 class SourceManager;
 class TargetInfo;
@@ -72,6 +76,10 @@ class CompilerInstance {
   /// The target being compiled for.
   llvm::OwningPtr<TargetInfo> Target;
 
+  /// The keywords and builtins the identifier tables of all inputs are built
+  /// on, if requested.  It outlives the preprocessor.
+  llvm::OwningPtr<SharedIdentifierTable> SharedIdentifiers;
+
   /// The file manager.
   llvm::OwningPtr<FileManager> FileMgr;
 
@@ -81,6 +89,13 @@ class CompilerInstance {
   /// The preprocessor.
   llvm::OwningPtr<Preprocessor> PP;
 
+  /// The include cost report attached to the preprocessor, if requested.  The
+  /// preprocessor owns it.
+  IncludeCostReport *IncludeCosts;
+
+  /// The stream the include cost reports are written to.
+  llvm::OwningPtr<llvm::raw_ostream> IncludeCostStream;
+
   /// The AST context.
   llvm::OwningPtr<ASTContext> Context;
 
@@ -93,6 +108,12 @@ class CompilerInstance {
   /// The frontend timer
   llvm::OwningPtr<llvm::Timer> FrontendTimer;
 
+  /// The per-phase timers and counters, if requested.
+  llvm::OwningPtr<PhaseStatistics> PhaseStats;
+
+  /// The per-template instantiation profile, if requested.
+  llvm::OwningPtr<InstantiationProfile> TemplateProfile;
+
   /// The list of active output files.
   std::list< std::pair<std::string, llvm::raw_ostream*> > OutputFiles;
 
@@ -353,6 +374,12 @@ public:
   /// takes ownership of \arg Value.
   void setPreprocessor(Preprocessor *Value);
 
+  bool hasIncludeCostReport() const { return IncludeCosts != 0; }
+
+  /// WriteIncludeCostReport - Write the include cost report of the current
+  /// preprocessor to the file named by the frontend options.
+  void WriteIncludeCostReport();
+
   /// }
   /// @name ASTContext
   /// {
@@ -424,6 +451,28 @@ public:
     return *FrontendTimer;
   }
 
+  /// }
+  /// @name Phase statistics
+  /// {
+
+  bool hasPhaseStatistics() const { return PhaseStats != 0; }
+
+  PhaseStatistics &getPhaseStatistics() const {
+    assert(PhaseStats && "Compiler instance has no phase statistics!");
+    return *PhaseStats;
+  }
+
+  /// }
+  /// @name Template instantiation profile
+  /// {
+
+  bool hasInstantiationProfile() const { return TemplateProfile != 0; }
+
+  InstantiationProfile &getInstantiationProfile() const {
+    assert(TemplateProfile && "Compiler instance has no template profile!");
+    return *TemplateProfile;
+  }
+
   /// }
   /// @name Output Files
   /// {
@@ -476,6 +525,11 @@ public:
   /// Create the file manager and replace any existing one with it.
   void createFileManager();
 
+  /// Install an overlay in the file manager that serves the files given by
+  /// the frontend options from memory.  Files that cannot be read are
+  /// diagnosed and left out.
+  void createVirtualFileOverlay();
+
   /// Create the source manager and replace any existing one with it.
   void createSourceManager();
 
@@ -528,6 +582,27 @@ public:
   /// Create the frontend timer and replace any existing one with it.
   void createFrontendTimer();
 
+  /// Create the per-phase timers and counters, replacing any existing ones,
+  /// and make them the ones instrumented code reports to.
+  void createPhaseStatistics();
+
+  /// Write the per-phase timers and counters collected so far to the file
+  /// named by the frontend options.
+  void WritePhaseStatistics();
+
+  /// Create the template instantiation profile, replacing any existing one,
+  /// and make it the one instrumented code reports to.
+  void createInstantiationProfile();
+
+  /// Write the template instantiation profile collected so far to the files
+  /// named by the frontend options.
+  void WriteInstantiationProfile();
+
+  /// Create a frozen table of the keywords and builtins of the current
+  /// language and target, replacing any existing one, and have the
+  /// preprocessors created from now on build their identifier tables on it.
+  void createSharedIdentifierTable();
+
   /// Create the default output file (from the invocation's options) and add it
   /// to the list of tracked output files.
   ///
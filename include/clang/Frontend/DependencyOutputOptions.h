@@ -27,6 +27,14 @@ public:
   /// The file to write depencency output to.
   std::string OutputFile;
 
+  /// The file to write the manifest of the files read, with the sizes and
+  /// hashes of their contents, to.
+  std::string HeaderManifestFile;
+
+  /// The file to write the macros from outside each guarded header that the
+  /// header depends on to.
+  std::string HeaderMacroDepsFile;
+
   /// A list of names to use as the targets in the dependency file; this list
   /// must contain at least one entry.
   std::vector<std::string> Targets;
@@ -34,9 +34,8 @@ public:
   unsigned VerifyDiagnostics: 1; /// Check that diagnostics match the expected
                                  /// diagnostics, indicated by markers in the
                                  /// input source file.
-  unsigned BinaryOutput : 1;     /// Emit diagnostics via the diagnostic 
-                                 /// binary serialization mechanism, to be
-                                 /// deserialized by, e.g., the CIndex library.
+  unsigned BinaryOutput : 1;     /// Emit diagnostics as a bitstream, to be
+                                 /// read back by, e.g., the CIndex library.
 
   /// The distance between tab stops.
   unsigned TabStop;
@@ -18,6 +18,8 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Rewrite/Rewriter.h"
 #include "llvm/ADT/SmallVector.h"
+#include <string>
+#include <vector>
 
 namespace clang {
 
@@ -55,6 +57,23 @@ class FixItRewriter : public DiagnosticClient {
   /// When empty, perform fix-it modifications everywhere.
   llvm::SmallVector<RequestedSourceLocation, 4> FixItLocations;
 
+  /// \brief An edit made by a fix-it, in terms of the original contents of
+  /// the file it was made to.
+  struct EditRecord {
+    std::string File;
+    unsigned Offset;
+    unsigned Length;
+    std::string Replacement;
+  };
+
+  /// \brief The edits made by the fix-its applied so far.
+  std::vector<EditRecord> Records;
+
+  /// \brief Add the record of an edit replacing the \p Length characters at
+  /// \p Loc with \p Replacement to \p Edits.
+  void AddEditRecord(std::vector<EditRecord> &Edits, SourceLocation Loc,
+                     unsigned Length, llvm::StringRef Replacement);
+
 public:
   /// \brief Initialize a new fix-it rewriter.
   FixItRewriter(Diagnostic &Diags, SourceManager &SourceMgr,
@@ -75,6 +94,20 @@ public:
   bool WriteFixedFile(const std::string &InFileName,
                       const std::string &OutFileName = std::string());
 
+  /// \brief Append the records of the edits made by the fix-its, to any of
+  /// the files of the translation unit, to \p RecordFileName.
+  ///
+  /// Each record is a line holding a JSON object with the absolute path of
+  /// the edited file, and the offset, length and replacement of the text
+  /// replaced in its original contents.  Insertions have a length of zero;
+  /// an insertion goes before the text inserted at the same offset by the
+  /// records before it.  The records of a translation unit are appended with
+  /// a single write, so that compilers running at the same time can share
+  /// a file.
+  ///
+  /// \returns true if there was an error, false otherwise.
+  bool WriteFixItRecords(const std::string &RecordFileName);
+
   /// IncludeInDiagnosticCounts - This method (whose default implementation
   ///  returns true) indicates whether the diagnostics handled by this
   ///  DiagnosticClient should be included in the number of diagnostics
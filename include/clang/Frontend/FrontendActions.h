@@ -45,6 +45,12 @@ protected:
                                          llvm::StringRef InFile);
 };
 
+class ASTExportAction : public ASTFrontendAction {
+protected:
+  virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
+                                         llvm::StringRef InFile);
+};
+
 class ASTViewAction : public ASTFrontendAction {
 protected:
   virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
@@ -85,13 +91,22 @@ public:
 };
 
 class GeneratePCHAction : public ASTFrontendAction {
+  /// Whether the PCH file was taken from the PCH cache, so that there is
+  /// nothing to parse.
+  bool UsedCachedPCH;
+
 protected:
   virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
                                          llvm::StringRef InFile);
 
+  virtual void ExecuteAction();
+
   virtual bool usesCompleteTranslationUnit() { return false; }
 
   virtual bool hasASTSupport() const { return false; }
+
+public:
+  GeneratePCHAction() : UsedCachedPCH(false) {}
 };
 
 class HTMLPrintAction : public ASTFrontendAction {
@@ -106,6 +121,12 @@ protected:
                                          llvm::StringRef InFile);
 };
 
+class PrintUnusedIncludesAction : public ASTFrontendAction {
+protected:
+  virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
+                                         llvm::StringRef InFile);
+};
+
 class RewriteObjCAction : public ASTFrontendAction {
 protected:
   virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
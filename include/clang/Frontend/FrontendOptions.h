@@ -20,6 +20,7 @@ namespace clang {
 namespace frontend {
   enum ActionKind {
     ASTDump,                ///< Parse ASTs and dump them.
+    ASTExport,              ///< Parse ASTs and export them in binary form.
     ASTPrint,               ///< Parse ASTs and print them.
     ASTPrintXML,            ///< Parse ASTs and print them in XML.
     ASTView,                ///< Parse ASTs and view them in Graphviz.
@@ -28,6 +29,7 @@ namespace frontend {
     DumpTokens,             ///< Dump out preprocessed tokens.
     EmitAssembly,           ///< Emit a .s file.
     EmitBC,                 ///< Emit a .bc file.
+    EmitCallEdges,          ///< Emit a call edge file.
     EmitHTML,               ///< Translate input source into HTML.
     EmitLLVM,               ///< Emit a .ll file.
     EmitLLVMOnly,           ///< Generate LLVM IR, but do not
@@ -40,8 +42,10 @@ namespace frontend {
     ParsePrintCallbacks,    ///< Parse and print each callback.
     ParseSyntaxOnly,        ///< Parse and perform semantic analysis.
     PluginAction,           ///< Run a plugin action, \see ActionName.
+    PrintCallEdges,         ///< Print the call edges of the input.
     PrintDeclContext,       ///< Print DeclContext and their Decls.
     PrintPreprocessedInput, ///< -E mode.
+    PrintUnusedIncludes,    ///< List the #includes nothing uses.
     RewriteMacros,          ///< Expand macros but not #includes.
     RewriteObjC,            ///< ObjC->C Rewriter.
     RewriteTest,            ///< Rewriter playground
@@ -68,15 +72,25 @@ public:
     IK_AST
   };
 
+  unsigned CacheDirectoryListings : 1;     ///< Answer lookups of missing files
+                                           /// from directory listings.
   unsigned DebugCodeCompletionPrinter : 1; ///< Use the debug printer for code
                                            /// completion results.
   unsigned DisableFree : 1;                ///< Disable memory freeing on exit.
   unsigned EmptyInputOnly : 1;             ///< Force input files to be treated
                                            /// as if they were empty, for timing
                                            /// the frontend startup.
+  unsigned PCHCacheReadOnly : 1;           ///< Use the PCH cache without
+                                           /// adding entries to it.
+  unsigned PCHContentHashes : 1;           ///< When generating PCH files,
+                                           /// record the content hashes of the
+                                           /// input files.
   unsigned RelocatablePCH : 1;             ///< When generating PCH files,
                                            /// instruct the PCH writer to create
                                            /// relocatable PCH files.
+  unsigned ShareIdentifiers : 1;           ///< Build the identifier tables of
+                                           /// all inputs on one table of
+                                           /// keywords and builtins.
   unsigned ShowHelp : 1;                   ///< Show the -help text.
   unsigned ShowMacrosInCodeCompletion : 1; ///< Show macros in code completion
                                            /// results.
@@ -85,6 +99,10 @@ public:
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
   unsigned ShowVersion : 1;                ///< Show the -version text.
+  unsigned SkipFunctionBodies : 1;         ///< Skip over function bodies
+                                           /// instead of parsing them.
+  unsigned FastSyntaxOnly : 1;             ///< Drop the work -fsyntax-only
+                                           /// does not need for diagnostics.
 
   /// The input files and their types.
   std::vector<std::pair<InputKind, std::string> > Inputs;
@@ -92,15 +110,63 @@ public:
   /// The output file, if any.
   std::string OutputFile;
 
+  /// If given, a stat snapshot used to answer file system queries.
+  std::string StatSnapshotFile;
+
+  /// If given, the file to write a stat snapshot of the file system queries
+  /// of the compilation to.
+  std::string StatSnapshotOutputFile;
+
+  /// The files to serve from memory, as pairs of the path they are looked up
+  /// by and the file their contents are read from.
+  std::vector<std::pair<std::string, std::string> > OverlayFiles;
+
+  /// If given, the file to write per-phase timings and counters to, as JSON.
+  std::string PhaseStatsFile;
+
+  /// If given, the file to write the cost of each #included file to.
+  std::string IncludeCostFile;
+
+  /// If given, the file to write the cost of each template pattern to.
+  std::string TemplateProfileFile;
+
+  /// If given, the file to write a trace of every template instantiation and
+  /// deduction to.
+  std::string TemplateProfileTraceFile;
+
+  /// If given, a PTH file whose cached files should be carried over into the
+  /// PTH file being generated.
+  std::string PTHMergeFile;
+
   /// If given, the name for a C++ class to view the inheritance of.
   std::string ViewClassInheritance;
 
   /// A list of locations to apply fix-its at.
   std::vector<ParsedSourceLocation> FixItLocations;
 
+  /// If given, the file to append the fix-its to as records of the edits to
+  /// each file, rather than writing the fixed main file.
+  std::string FixItRecordFile;
+
   /// If given, enable code completion at the provided location.
   ParsedSourceLocation CodeCompletionAt;
 
+  /// If given, only the code-completion results whose names start with this
+  /// prefix are produced.
+  std::string CodeCompletionPrefix;
+
+  /// The maximum number of code-completion results to produce, keeping the
+  /// most relevant ones, or zero for no limit.
+  unsigned CodeCompletionMaxResults;
+
+  /// If given, the directory to cache the code-completion results for the
+  /// global declarations of the PCH file in.
+  std::string CodeCompletionCacheDir;
+
+  /// If given, the directory of PCH files shared by identical invocations
+  /// that generate a PCH file.
+  std::string PCHCacheDir;
+
   /// The frontend action to perform.
   frontend::ActionKind ProgramAction;
 
@@ -115,17 +181,24 @@ public:
 
 public:
   FrontendOptions() {
+    CacheDirectoryListings = 0;
+    CodeCompletionMaxResults = 0;
     DebugCodeCompletionPrinter = 1;
     DisableFree = 0;
     EmptyInputOnly = 0;
     ProgramAction = frontend::ParseSyntaxOnly;
     ActionName = "";
+    PCHCacheReadOnly = 0;
+    PCHContentHashes = 0;
     RelocatablePCH = 0;
+    ShareIdentifiers = 0;
     ShowHelp = 0;
     ShowMacrosInCodeCompletion = 0;
     ShowStats = 0;
     ShowTimers = 0;
     ShowVersion = 0;
+    SkipFunctionBodies = 0;
+    FastSyntaxOnly = 0;
   }
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
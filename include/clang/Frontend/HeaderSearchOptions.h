@@ -65,6 +65,14 @@ public:
   /// etc.).
   std::string ResourceDir;
 
+  /// If non-empty, the file used to share #include lookup results between
+  /// compilations with the same search paths.
+  std::string LookupCacheFile;
+
+  /// If non-empty, the file used to share the include guards found by the
+  /// multiple-include optimization between compilations.
+  std::string GuardDatabaseFile;
+
   /// Include the compiler builtin includes.
   unsigned UseBuiltinIncludes : 1;
 
@@ -0,0 +1,80 @@
+//===--- IncludeCostReport.h - Measure the cost of each #include -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the IncludeCostReport interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_INCLUDECOSTREPORT_H
+#define LLVM_CLANG_FRONTEND_INCLUDECOSTREPORT_H
+
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Lex/PPCallbacks.h"
+#include <vector>
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+
+class ASTContext;
+class Preprocessor;
+
+/// IncludeCostReport - Preprocessor callbacks that measure what each file
+/// entered by the preprocessor costs, to help decide which headers belong in
+/// a precompiled header and which should not be #included at all.
+///
+/// Every time a file is entered, the report records the wall time until the
+/// preprocessor leaves it again, which covers preprocessing, parsing and
+/// semantic analysis of its contents.  When the report is written it also
+/// counts the raw tokens and bytes of each file and the declarations written
+/// in it.  Each figure is given both inclusive and exclusive of the files
+/// #included from the file, summed over every time the file was entered.
+class IncludeCostReport : public PPCallbacks {
+  Preprocessor &PP;
+
+  /// Entry - One visit of the preprocessor to a file.
+  struct Entry {
+    FileID FID;
+
+    /// Parent - The index of the entry this file was #included from, or -1
+    /// for the main file.
+    int Parent;
+
+    /// StartTime, EndTime - When the file was entered and left, in seconds.
+    double StartTime, EndTime;
+
+    Entry(FileID FID, int Parent, double StartTime)
+      : FID(FID), Parent(Parent), StartTime(StartTime), EndTime(StartTime) {}
+  };
+
+  /// Entries - Every visit so far, in the order the files were entered.
+  std::vector<Entry> Entries;
+
+  /// Stack - The indices of the entries of the files being lexed.
+  std::vector<unsigned> Stack;
+
+  void PopEntry(double Now);
+
+public:
+  explicit IncludeCostReport(Preprocessor &PP) : PP(PP) {}
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType);
+
+  /// WriteReport - Write the cost of each file to \arg OS, most expensive
+  /// first.  Declarations are only counted if \arg Ctx is given, and it does
+  /// not come from an external AST source.
+  void WriteReport(llvm::raw_ostream &OS, ASTContext *Ctx);
+};
+
+}  // end namespace clang
+
+#endif
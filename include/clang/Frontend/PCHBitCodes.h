@@ -30,10 +30,10 @@ namespace clang {
     /// designed for the previous version could not support reading
     /// the new version), this number should be increased.
     ///
-    /// Version 3 of PCH files also requires that the version control branch and
-    /// revision match exactly, since there is no backward compatibility of
-    /// PCH files at this time.
-    const unsigned VERSION_MAJOR = 3;
+    /// Version 3 and later of PCH files also require that the version control
+    /// branch and revision match exactly, since there is no backward
+    /// compatibility of PCH files at this time.
+    const unsigned VERSION_MAJOR = 4;
 
     /// \brief PCH minor version number supported by this version of
     /// Clang.
@@ -43,7 +43,20 @@ namespace clang {
     /// for the previous version could still support reading the new
     /// version by ignoring new kinds of subblocks), this number
     /// should be increased.
-    const unsigned VERSION_MINOR = 0;
+    const unsigned VERSION_MINOR = 3;
+
+    /// \brief Compute the 64-bit FNV-1a hash of a range of bytes.
+    ///
+    /// PCH files use it for the names in the identifier table and, when
+    /// built with -pch-content-hashes, for the contents of input files.
+    inline uint64_t HashBytes(const char *Start, const char *End) {
+      uint64_t Hash = 14695981039346656037ULL;
+      for (; Start != End; ++Start) {
+        Hash ^= (unsigned char)*Start;
+        Hash *= 1099511628211ULL;
+      }
+      return Hash;
+    }
 
     /// \brief An ID number that refers to a declaration in a PCH file.
     ///
@@ -150,6 +163,10 @@ namespace clang {
       /// between offsets (for unresolved identifier IDs) and
       /// IdentifierInfo pointers (for already-resolved identifier
       /// IDs).
+      ///
+      /// The blob is also an OnDiskPerfectHashTable from the names of
+      /// the identifiers to their data, and the record contains the
+      /// offset of that table within the blob.
       IDENTIFIER_TABLE = 6,
 
       /// \brief Record code for the array of external definitions.
@@ -224,14 +241,33 @@ namespace clang {
       VERSION_CONTROL_BRANCH_REVISION = 21,
       
       /// \brief Record code for the array of unused static functions.
-      UNUSED_STATIC_FUNCS = 22
+      UNUSED_STATIC_FUNCS = 22,
+
+      /// \brief Record code for the table of the offsets at which the
+      /// source location entries start, in the order of the table in
+      /// SOURCE_LOCATION_OFFSETS.
+      ///
+      /// This table lets the source manager find the entry containing a
+      /// source location without loading the entries it passes over.
+      SOURCE_LOCATION_ENTRY_STARTS = 23,
+
+      /// \brief Record code for the layouts of the records that were laid
+      /// out while the PCH file was built.
+      ///
+      /// Each layout is stored as the ID of the record, the number of values
+      /// that follow, and then the size, data size, alignment and field
+      /// offsets of the record, followed by the C++-specific information when
+      /// the record is a C++ class.
+      RECORD_LAYOUTS = 24
       
     };
 
     /// \brief Record types used within a source manager block.
     enum SourceManagerRecordTypes {
       /// \brief Describes a source location entry (SLocEntry) for a
-      /// file.
+      /// file: [Offset, IncludeLoc, Characteristic, HasLineDirectives, Size,
+      /// ModTime, ContentHash], where ContentHash is 0 unless the PCH file
+      /// was built with -pch-content-hashes.
       SM_SLOC_FILE_ENTRY = 1,
       /// \brief Describes a source location entry (SLocEntry) for a
       /// buffer.
@@ -248,7 +284,11 @@ namespace clang {
       SM_LINE_TABLE = 5,
       /// \brief Describes one header file info [isImport, DirInfo, NumIncludes]
       /// ControllingMacro is optional.
-      SM_HEADER_FILE_INFO = 6
+      SM_HEADER_FILE_INFO = 6,
+      /// \brief Describes a blob with the offsets of the lines of a file, as
+      /// 32-bit little-endian integers.  This kind of record may directly
+      /// follow the first SM_SLOC_FILE_ENTRY record of each file.
+      SM_SLOC_FILE_LINES = 7
     };
 
     /// \brief Record types used within a preprocessor block.
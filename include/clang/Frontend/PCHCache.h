@@ -0,0 +1,64 @@
+//===--- PCHCache.h - Shared cache of generated PCH files -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the PCHCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_PCHCACHE_H
+#define LLVM_CLANG_FRONTEND_PCHCACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/Path.h"
+#include <string>
+
+namespace clang {
+
+class CompilerInvocation;
+class SourceManager;
+
+/// PCHCache - A directory of PCH files shared by the compilers that generate
+/// them, so that identical invocations only build a PCH file once.
+///
+/// The entry of an invocation is named by a hash of its arguments, with the
+/// output file left out.  Next to the PCH file, the entry records the size
+/// and the hash of the contents of every file the PCH file was built from;
+/// it is only used while all of them are unchanged.  Entries are written to
+/// a temporary file and renamed into place, so any number of compilers, on
+/// one machine or sharing the directory over the network, may use the cache
+/// at the same time.
+class PCHCache {
+  /// Key - The arguments of the invocation, which are stored in the entry to
+  /// tell apart invocations whose keys hash to the same name.
+  std::string Key;
+
+  /// EntryPath - The file holding the entry of the invocation.
+  llvm::sys::Path EntryPath;
+
+  /// ReadOnly - Whether new entries are never stored.
+  bool ReadOnly;
+
+public:
+  PCHCache(llvm::StringRef Dir, const CompilerInvocation &Invocation,
+           bool ReadOnly);
+
+  bool isReadOnly() const { return ReadOnly; }
+
+  /// lookup - If the cache holds a PCH file for this invocation whose input
+  /// files are unchanged, store it in \arg PCH and return true.
+  bool lookup(std::string &PCH) const;
+
+  /// store - Install \arg PCH, which was built from the files of \arg SM, as
+  /// the entry for this invocation.  Failing to do so is not an error.
+  void store(const SourceManager &SM, llvm::StringRef PCH) const;
+};
+
+}  // end namespace clang
+
+#endif
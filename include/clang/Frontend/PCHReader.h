@@ -188,6 +188,10 @@ private:
   /// \brief The cursor to the start of the preprocessor block, which stores
   /// all of the macro definitions.
   llvm::BitstreamCursor MacroCursor;
+
+  /// \brief The offsets of the macro records for the identifiers that are
+  /// macros whose definitions have not been read yet.
+  llvm::DenseMap<IdentifierInfo *, uint64_t> UnreadMacroRecordOffsets;
       
   /// DeclsCursor - This is a cursor to the start of the DECLS_BLOCK block.  It
   /// has read all the abbreviations at the start of the block and is ready to
@@ -199,7 +203,15 @@ private:
 
   /// \brief The memory buffer that stores the data associated with
   /// this PCH file.
-  llvm::OwningPtr<llvm::MemoryBuffer> Buffer;
+  ///
+  /// Unless the PCH file is read from standard input, the buffer comes from
+  /// the shared file buffer pool, so all the readers of one PCH file in the
+  /// process map it once and share the offset tables that point into it.
+  const llvm::MemoryBuffer *Buffer;
+
+  /// \brief The file whose shared buffer is Buffer, or null if Buffer is
+  /// owned by this reader.
+  const FileEntry *SharedBufferFile;
 
   /// \brief Offset type for all of the source location entries in the
   /// PCH file.
@@ -319,6 +331,23 @@ private:
   /// PCH file.
   llvm::SmallVector<uint64_t, 4> ExtVectorDecls;
 
+  /// \brief The layouts of the records that were laid out while the PCH
+  /// file was built, in the format of the RECORD_LAYOUTS record.
+  llvm::SmallVector<uint64_t, 16> RecordLayouts;
+
+  /// \brief Maps the IDs of the records whose layouts are stored, and which
+  /// have not been loaded yet, to the start of the layout in RecordLayouts.
+  llvm::DenseMap<pch::DeclID, unsigned> RecordLayoutOffsets;
+
+  /// \brief Maps the loaded records whose layouts are stored to the start of
+  /// the layout in RecordLayouts.
+  llvm::DenseMap<const RecordDecl *, unsigned> LoadedRecordLayouts;
+
+  /// \brief Maps the files whose lines are stored to the blob of their
+  /// SM_SLOC_FILE_LINES record.
+  llvm::DenseMap<const FileEntry *, std::pair<const char *, unsigned> >
+    FileLineOffsets;
+
   /// \brief The set of Objective-C category definitions stored in the
   /// the PCH file.
   llvm::SmallVector<uint64_t, 4> ObjCCategoryImpls;
@@ -374,8 +403,9 @@ private:
   /// \brief The number of macros de-serialized from the PCH file.
   unsigned NumMacrosRead;
 
-  /// \brief The number of method pool entries that have been read.
-  unsigned NumMethodPoolSelectorsRead;
+  /// \brief The number of method lists, either the instance or the factory
+  /// methods of a selector, that have been read from the method pool.
+  unsigned NumMethodPoolListsRead;
 
   /// \brief The number of times we have looked into the global method
   /// pool and not found anything.
@@ -390,6 +420,16 @@ private:
   /// Number of visible decl contexts read/total.
   unsigned NumVisibleDeclContextsRead, TotalVisibleDeclContexts;
 
+  /// \brief The number of function bodies de-serialized from the PCH file.
+  unsigned NumFunctionBodiesRead;
+
+  /// \brief The total number of function bodies stored in the PCH file.
+  unsigned TotalNumFunctionBodies;
+
+  /// \brief The number of record layouts read from the PCH file, and the
+  /// number stored in it.
+  unsigned NumRecordLayoutsRead, TotalNumRecordLayouts;
+
   /// \brief When a type or declaration is being loaded from the PCH file, an
   /// instantance of this RAII object will be available on the stack to
   /// indicate when we are in a recursive-loading situation.
@@ -445,6 +485,10 @@ private:
   /// \brief Length of the predefines buffer in the PCH file.
   unsigned PCHPredefinesLen;
 
+  /// \brief The predefines of all of the layers of a PCH file that was built
+  /// on top of another PCH file, which PCHPredefines then points into.
+  std::string LayeredPredefines;
+
   /// \brief Suggested contents of the predefines buffer, after this
   /// PCH file has been processed.
   ///
@@ -581,6 +625,15 @@ public:
   /// LazyOffsetPtr (which is used by Decls for the body of functions, etc).
   virtual Stmt *GetDeclStmt(uint64_t Offset);
 
+  /// \brief Read the bodies of the given functions in the order in which
+  /// they are stored in the PCH file.
+  virtual void PrefetchFunctionBodies(const FunctionDecl * const *Begin,
+                                      const FunctionDecl * const *End);
+
+  /// \brief Read the layout of the given record, if it was laid out while
+  /// the PCH file was built.
+  virtual const ASTRecordLayout *GetRecordLayout(const RecordDecl *D);
+
   /// ReadBlockAbbrevs - Enter a subblock of the specified BlockID with the
   /// specified cursor.  Read the abbreviations that are at the top of the block
   /// and then leave the cursor pointing into the block.
@@ -631,6 +684,10 @@ public:
   /// \brief Print some statistics about PCH usage.
   virtual void PrintStats();
 
+  /// \brief Return the number of bytes of the PCH file and of the tables of
+  /// entities loaded from it.
+  virtual size_t getMemoryUsage() const;
+
   /// \brief Initialize the semantic source with the Sema instance
   /// being used to perform semantic analysis on the abstract syntax
   /// tree.
@@ -650,13 +707,17 @@ public:
     return get(Name.begin(), Name.end());
   }
 
-  /// \brief Load the contents of the global method pool for a given
-  /// selector.
+  /// \brief Load the instance or the factory methods of the global method
+  /// pool for a given selector.
   ///
-  /// \returns a pair of Objective-C methods lists containing the
-  /// instance and factory methods, respectively, with this selector.
-  virtual std::pair<ObjCMethodList, ObjCMethodList>
-    ReadMethodPool(Selector Sel);
+  /// \returns the list of instance methods, if \p isInstance, or factory
+  /// methods with this selector.
+  virtual ObjCMethodList ReadMethodPool(Selector Sel, bool isInstance);
+
+  /// \brief Load all of the identifiers of the PCH file and return all of
+  /// its selectors.
+  virtual void ReadAllIdentifiersAndSelectors(
+                                   llvm::SmallVectorImpl<Selector> &Sels);
 
   void SetIdentifierInfo(unsigned ID, IdentifierInfo *II);
   void SetGloballyVisibleDecls(IdentifierInfo *II,
@@ -682,6 +743,11 @@ public:
   /// \brief Read the source location entry with index ID.
   virtual void ReadSLocEntry(unsigned ID);
 
+  /// \brief Retrieve the offsets of the lines of a file that were stored
+  /// when the PCH file was built.
+  virtual bool ReadLineOffsets(const FileEntry *File,
+                               std::vector<unsigned> &Offsets);
+
   Selector DecodeSelector(unsigned Idx);
 
   Selector GetSelector(const RecordData &Record, unsigned &Idx) {
@@ -721,9 +787,17 @@ public:
   /// \brief Reads the macro record located at the given offset.
   void ReadMacroRecord(uint64_t Offset);
 
+  /// \brief Note that the given identifier is a macro whose definition is
+  /// the macro record at the given offset, which is read on first use.
+  void SetIdentifierIsMacro(IdentifierInfo *II, uint64_t Offset);
+
   /// \brief Read the set of macros defined by this external macro source.
   virtual void ReadDefinedMacros();
 
+  /// \brief Read the definition of a macro of the PCH file that has not
+  /// been read yet.
+  virtual void LoadMacroDefinition(IdentifierInfo *II);
+
   /// \brief Retrieve the AST context that this PCH reader
   /// supplements.
   ASTContext *getContext() { return Context; }
@@ -58,6 +58,38 @@ struct UnsafeQualTypeDenseMapInfo {
   }
 };
 
+/// \brief The number and the size of the records of each kind written to
+/// the declarations and types block of a PCH file, along with how many of
+/// them were written with an abbreviation.
+class PCHRecordStats {
+  struct CodeStats {
+    CodeStats() : Name(0), NumRecords(0), NumAbbreviated(0), NumBits(0) { }
+
+    const char *Name;
+    unsigned NumRecords;
+    unsigned NumAbbreviated;
+    uint64_t NumBits;
+  };
+
+  std::map<unsigned, CodeStats> Codes;
+
+public:
+  /// \brief Name the records with the given code in the printed statistics.
+  void setName(unsigned Code, const char *Name) { Codes[Code].Name = Name; }
+
+  /// \brief Note a record of NumBits bits with the given code.
+  void noteRecord(unsigned Code, uint64_t NumBits, bool Abbreviated) {
+    CodeStats &Stats = Codes[Code];
+    ++Stats.NumRecords;
+    Stats.NumBits += NumBits;
+    if (Abbreviated)
+      ++Stats.NumAbbreviated;
+  }
+
+  /// \brief Print the statistics to stderr, largest record kinds first.
+  void print() const;
+};
+
 /// \brief Writes a precompiled header containing the contents of a
 /// translation unit.
 ///
@@ -73,6 +105,9 @@ private:
   /// \brief The bitstream writer used to emit this precompiled header.
   llvm::BitstreamWriter &Stream;
 
+  /// \brief Whether to record the content hashes of the input files.
+  bool HashInputFiles;
+
   /// \brief Stores a declaration or a type to be written to the PCH file.
   class DeclOrType {
   public:
@@ -198,6 +233,9 @@ private:
   /// file.
   unsigned NumVisibleDeclContexts;
 
+  /// \brief The number of function bodies written to the PCH file.
+  unsigned NumFunctionBodies;
+
   void WriteBlockInfoBlock();
   void WriteMetadata(ASTContext &Context, const char *isysroot);
   void WriteLanguageOptions(const LangOptions &LangOpts);
@@ -210,19 +248,30 @@ private:
   void WriteType(QualType T);
   uint64_t WriteDeclContextLexicalBlock(ASTContext &Context, DeclContext *DC);
   uint64_t WriteDeclContextVisibleBlock(ASTContext &Context, DeclContext *DC);
+  void WriteRecordLayouts(ASTContext &Context);
 
   void WriteMethodPool(Sema &SemaRef);
   void WriteIdentifierTable(Preprocessor &PP);
   void WriteAttributeRecord(const Attr *Attr);
 
+  /// \brief The statistics of the records of the declarations and types
+  /// block.
+  PCHRecordStats RecordStats;
+
   unsigned ParmVarDeclAbbrev;
+  unsigned DeclRefExprAbbrev;
+  unsigned ImplicitCastExprAbbrev;
   void WriteDeclsBlockAbbrevs();
   void WriteDecl(ASTContext &Context, Decl *D);
   
 public:
   /// \brief Create a new precompiled header writer that outputs to
   /// the given bitstream.
-  PCHWriter(llvm::BitstreamWriter &Stream);
+  ///
+  /// \param HashInputFiles whether to record the hashes of the contents of
+  /// the input files, which let a reader accept the files when only their
+  /// modification times changed.
+  PCHWriter(llvm::BitstreamWriter &Stream, bool HashInputFiles = false);
 
   /// \brief Write a precompiled header for the given semantic analysis.
   ///
@@ -327,7 +376,20 @@ public:
   /// or may not have been emitted yet.
   unsigned GetLabelID(LabelStmt *S);
 
+  /// \brief Emit a record of the declarations and types block, noting it
+  /// in the record statistics.
+  void EmitDeclTypesRecord(unsigned Code, RecordData &Record,
+                           unsigned Abbrev = 0);
+
+  /// \brief Retrieve the statistics of the records written to the
+  /// declarations and types block.
+  const PCHRecordStats &getRecordStats() const { return RecordStats; }
+
   unsigned getParmVarDeclAbbrev() const { return ParmVarDeclAbbrev; }
+  unsigned getDeclRefExprAbbrev() const { return DeclRefExprAbbrev; }
+  unsigned getImplicitCastExprAbbrev() const {
+    return ImplicitCastExprAbbrev;
+  }
 };
 
 } // end namespace clang
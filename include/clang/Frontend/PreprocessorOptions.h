@@ -24,6 +24,7 @@ namespace clang {
 
 class Preprocessor;
 class LangOptions;
+class SharedIdentifierTable;
 
 /// PreprocessorOptions - This class is used for passing the various options
 /// used in preprocessor initialization to InitializePreprocessor().
@@ -39,6 +40,10 @@ public:
   /// The implicit PCH included at the start of the translation unit, or empty.
   std::string ImplicitPCHInclude;
 
+  /// The number of bytes at the start of the main file that are not lexed,
+  /// because ImplicitPCHInclude was built from them.
+  unsigned PrecompiledPreambleBytes;
+
   /// The implicit PTH input included at the start of the translation unit, or
   /// empty.
   std::string ImplicitPTHInclude;
@@ -46,6 +51,20 @@ public:
   /// If given, a PTH cache file to use for speeding up header parsing.
   std::string TokenCache;
 
+  /// If given, a directory holding the target and language predefined macros
+  /// of each configuration already split into tokens, so that they do not
+  /// have to be lexed by every compilation.
+  std::string PredefinesCacheDir;
+
+  /// The number of threads used to read and scan #included files ahead of
+  /// the preprocessor, or 0 to not read ahead.
+  unsigned IncludePrefetchThreads;
+
+  /// \brief A frozen identifier table, shared with other translation units,
+  /// that the identifier table of the preprocessor is built on, or null.  It
+  /// is not owned by the options.
+  const SharedIdentifierTable *SharedIdentifiers;
+
   /// \brief The set of file remappings, which take existing files on
   /// the system (the first part of each pair) and gives them the
   /// contents of other files on the system (the second part of each
@@ -77,7 +96,8 @@ public:
   }
   
 public:
-  PreprocessorOptions() : UsePredefines(true) {}
+  PreprocessorOptions() : UsePredefines(true), PrecompiledPreambleBytes(0),
+                          IncludePrefetchThreads(0), SharedIdentifiers(0) {}
 
   void addMacroDef(llvm::StringRef Name) {
     Macros.push_back(std::make_pair(Name, false));
@@ -0,0 +1,160 @@
+//===--- SerializedDiagnostics.h - Binary diagnostic stream -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a diagnostic client that writes diagnostics to a compact
+// bitstream, and a reader for that stream.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_SERIALIZED_DIAGNOSTICS_H
+#define LLVM_CLANG_FRONTEND_SERIALIZED_DIAGNOSTICS_H
+
+#include "clang/Basic/Diagnostic.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/BitCodes.h"
+#include "llvm/Bitcode/BitstreamWriter.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+
+class FileEntry;
+class FileManager;
+class SourceManager;
+
+namespace serialized_diags {
+  /// \brief The version of the serialized diagnostics format.
+  const unsigned VERSION_MAJOR = 1;
+
+  /// \brief The block IDs of a serialized diagnostics stream.
+  ///
+  /// A stream starts with the signature 'DIAG', a block info block and a
+  /// META block, followed by one DIAG block per diagnostic.  Each DIAG block
+  /// is complete on its own, so a reader can stop at any block boundary.
+  enum BlockIDs {
+    /// \brief Holds the VERSION record.
+    META_BLOCK_ID = llvm::bitc::FIRST_APPLICATION_BLOCKID,
+
+    /// \brief Holds a single diagnostic.
+    DIAG_BLOCK_ID
+  };
+
+  /// \brief The records of a serialized diagnostics stream.
+  ///
+  /// A source location is written as three fields: a file ID, a line and a
+  /// column.  File ID 0 denotes an invalid location; other file IDs are
+  /// defined by a FILENAME record before their first use.
+  enum RecordIDs {
+    /// \brief [version]
+    RECORD_VERSION = 1,
+
+    /// \brief [file ID, name blob]
+    RECORD_FILENAME = 2,
+
+    /// \brief [begin location, end location]
+    RECORD_SOURCE_RANGE = 3,
+
+    /// \brief [remove begin location, remove end location, insertion
+    /// location, code blob]
+    RECORD_FIXIT = 4,
+
+    /// \brief [level, location, message blob].  This is the last record of
+    /// a DIAG block; the ranges and fix-its before it belong to it.
+    RECORD_DIAG = 5
+  };
+}
+
+/// \brief A diagnostic client that serializes diagnostics to a bitstream, in
+/// the same encoding as PCH files.
+///
+/// Diagnostics keep their source ranges and fix-its, with every location
+/// turned into a file, line and column.  Files are named once per stream.
+/// Complete diagnostics are collected in memory and written to the output
+/// stream in batches, unless the printer is streaming.
+class SerializedDiagnosticPrinter : public DiagnosticClient {
+  llvm::raw_ostream &OS;
+
+  /// \brief Whether each diagnostic is written out as soon as it is complete.
+  bool Streaming;
+
+  std::vector<unsigned char> Buffer;
+  llvm::BitstreamWriter Stream;
+
+  /// \brief The IDs given to the files named in the stream so far.
+  llvm::DenseMap<const FileEntry *, unsigned> FileIDs;
+
+  unsigned DiagAbbrev, RangeAbbrev, FixItAbbrev, FileNameAbbrev;
+
+  typedef llvm::SmallVector<uint64_t, 32> RecordData;
+
+  void EmitPreamble();
+  void AddLocation(const SourceManager *SM, SourceLocation Loc,
+                   RecordData &Record);
+  void FlushBuffer(bool Force);
+
+public:
+  /// \brief Create a printer writing to \p OS.  If \p Streaming is set,
+  /// every diagnostic is written and flushed as soon as it is complete, so
+  /// that a reader at the other end of a pipe sees it right away.
+  explicit SerializedDiagnosticPrinter(llvm::raw_ostream &OS,
+                                       bool Streaming = false);
+  ~SerializedDiagnosticPrinter();
+
+  virtual void EndSourceFile();
+
+  virtual void HandleDiagnostic(Diagnostic::Level DiagLevel,
+                                const DiagnosticInfo &Info);
+};
+
+/// \brief Read the diagnostics serialized by a SerializedDiagnosticPrinter
+/// from \p Buffer, resolving their locations against \p FM and \p SM.
+///
+/// \returns true if the stream is malformed or truncated.  The diagnostics
+/// read up to that point are still added to \p Diags.
+bool ReadSerializedDiagnostics(llvm::StringRef Buffer, FileManager &FM,
+                               SourceManager &SM,
+                               llvm::SmallVectorImpl<StoredDiagnostic> &Diags);
+
+/// \brief Reads a serialized diagnostics stream while it is being written,
+/// turning each diagnostic into a StoredDiagnostic once all of it arrived.
+class SerializedDiagnosticStreamReader {
+  FileManager &FM;
+  SourceManager &SM;
+
+  /// \brief The start of the stream, up to its first diagnostic, which the
+  /// rest of the stream is read after; empty until all of it arrived.
+  std::string Header;
+
+  /// \brief The bytes received after Header that are not part of a complete
+  /// diagnostic yet.
+  std::string Pending;
+
+  /// \brief The files named in the stream so far, indexed by file ID.
+  std::vector<const FileEntry *> Files;
+
+public:
+  /// \brief Create a reader resolving locations against \p FM and \p SM.
+  SerializedDiagnosticStreamReader(FileManager &FM, SourceManager &SM)
+    : FM(FM), SM(SM) {}
+
+  /// \brief Add the next bytes of the stream, and the diagnostics that they
+  /// complete to \p Diags.
+  void Append(llvm::StringRef Data,
+              llvm::SmallVectorImpl<StoredDiagnostic> &Diags);
+};
+
+} // end namespace clang
+
+#endif
@@ -16,6 +16,8 @@
 
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
 
 namespace llvm {
 class Triple;
@@ -84,9 +86,28 @@ bool CheckDiagnostics(Preprocessor &PP);
 void AttachDependencyFileGen(Preprocessor &PP,
                              const DependencyOutputOptions &Opts);
 
+/// AttachHeaderManifestGen - Create a header manifest generator writing to
+/// Opts.HeaderManifestFile, and attach it to the given preprocessor.
+void AttachHeaderManifestGen(Preprocessor &PP,
+                             const DependencyOutputOptions &Opts);
+
+/// AttachHeaderMacroDepsGen - Create a generator writing the macro
+/// dependencies of each guarded header to Opts.HeaderMacroDepsFile, and
+/// attach it to the given preprocessor.
+void AttachHeaderMacroDepsGen(Preprocessor &PP,
+                              const DependencyOutputOptions &Opts);
+
+/// AttachIncludePrefetcher - Read the files the given preprocessor is likely
+/// to #include ahead of time on \arg NumThreads worker threads.  This does
+/// nothing if threads are not available.
+void AttachIncludePrefetcher(Preprocessor &PP, unsigned NumThreads);
+
 /// CacheTokens - Cache tokens for use with PCH. Note that this requires
-/// a seekable stream.
-void CacheTokens(Preprocessor &PP, llvm::raw_fd_ostream* OS);
+/// a seekable stream.  The files named in \arg MergedFiles are cached as
+/// well, and the result is marked as a PTH store shared between translation
+/// units.
+void CacheTokens(Preprocessor &PP, llvm::raw_fd_ostream* OS,
+                 const std::vector<std::string> &MergedFiles);
 
 }  // end namespace clang
 
@@ -0,0 +1,175 @@
+//===--- CallEdges.h - Persistent whole-program call graphs -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the interfaces used to build a whole-program call graph
+// without keeping every translation unit in memory: the call edges of each
+// translation unit are written to a call edge file while it is parsed, and
+// the edge files are later merged into one persistent call graph.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_CALLEDGES_H
+#define LLVM_CLANG_INDEX_CALLEDGES_H
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+  class MemoryBuffer;
+  class raw_fd_ostream;
+  class raw_ostream;
+}
+
+namespace clang {
+  class ASTConsumer;
+  class ASTContext;
+  class DeclContext;
+  class Diagnostic;
+  class FunctionDecl;
+
+namespace idx {
+
+/// \brief Get the name that identifies a function in call edge files.
+///
+/// Functions with external linkage are named by their qualified name, so that
+/// the same function gets the same name in every translation unit.  Functions
+/// with internal linkage are prefixed with the name of the main file of the
+/// translation unit they belong to, which keeps static functions of different
+/// translation units apart.  In C++, the parameter types are appended to tell
+/// overloads apart.
+std::string getCallGraphName(const FunctionDecl *FD, ASTContext &Ctx);
+
+/// \brief Collects the direct call edges of one or more translation units and
+/// writes them to a call edge file.
+///
+/// A call edge file holds the names of the functions defined or called in the
+/// translation units and one (caller, callee) pair of name indices per
+/// distinct call.
+class CallEdgeWriter {
+  /// \brief The names of the functions seen so far, by index.
+  std::vector<std::string> Names;
+
+  /// \brief The index of each name in Names.
+  llvm::StringMap<unsigned> NameIDs;
+
+  /// \brief The (caller, callee) pairs seen so far.  Duplicates are removed
+  /// when the file is written.
+  std::vector<std::pair<unsigned, unsigned> > Edges;
+
+  void addDeclContext(DeclContext *DC, ASTContext &Ctx);
+  void addFunction(FunctionDecl *FD, ASTContext &Ctx);
+
+public:
+  /// \brief Get the index of the given function name, adding it if needed.
+  unsigned getNameID(llvm::StringRef Name);
+
+  /// \brief Record a call from one function to another.
+  void addEdge(unsigned Caller, unsigned Callee) {
+    Edges.push_back(std::make_pair(Caller, Callee));
+  }
+
+  /// \brief Add the call edges of every function defined in the given
+  /// translation unit, including those in namespaces and classes and the
+  /// instantiations of templates.
+  void addTU(ASTContext &Ctx);
+
+  /// \brief Write the edges collected so far to the given stream in the call
+  /// edge file format.
+  void write(llvm::raw_ostream &Out);
+
+  /// \brief Write the edges collected so far to the given file.
+  ///
+  /// \returns true on error, with a description in \p ErrorInfo.
+  bool write(llvm::StringRef Path, std::string &ErrorInfo);
+
+  /// \brief Print the edges collected so far as "caller -> callee" lines,
+  /// sorted by name.
+  void print(llvm::raw_ostream &Out) const;
+};
+
+/// \brief Create an AST consumer that writes the call edges of the translation
+/// unit it sees to the given stream once it has been parsed.
+///
+/// Errors writing the stream are reported through \p Diags, naming the output
+/// \p OutFile.
+ASTConsumer *CreateCallEdgeWriter(llvm::raw_fd_ostream *OS,
+                                  llvm::StringRef OutFile, Diagnostic &Diags);
+
+/// \brief Create an AST consumer that prints the call edges of the translation
+/// unit it sees to the given stream, one "caller -> callee" line per edge.
+ASTConsumer *CreateCallEdgePrinter(llvm::raw_ostream *OS);
+
+/// \brief Merge call edge files into one persistent call graph.
+///
+/// The edge files are read and sorted in runs of bounded size by up to
+/// \p NumThreads threads.  The runs are written to temporary files next to
+/// \p OutFile and then merged, so the memory needed does not depend on the
+/// total size of the edge files, only on the number of distinct functions and
+/// edges in the resulting graph.
+///
+/// \returns true on error, with a description in \p ErrorInfo.
+bool MergeCallEdgeFiles(const std::vector<std::string> &InFiles,
+                        llvm::StringRef OutFile, unsigned NumThreads,
+                        std::string &ErrorInfo);
+
+/// \brief A call graph written by MergeCallEdgeFiles and mapped back into
+/// memory.
+///
+/// Functions are numbered in the order of their names.  The callees and the
+/// callers of each function are stored in compressed sparse row form, so both
+/// directions can be walked without reading the rest of the graph.
+class PersistentCallGraph {
+  llvm::OwningPtr<llvm::MemoryBuffer> Buffer;
+  unsigned NumFunctions;
+  unsigned NumEdges;
+  const unsigned char *NameOffsets;
+  const unsigned char *CalleeOffsets;
+  const unsigned char *Callees;
+  const unsigned char *CallerOffsets;
+  const unsigned char *Callers;
+  const char *Names;
+
+  PersistentCallGraph();
+  PersistentCallGraph(const PersistentCallGraph &); // do not implement
+  void operator=(const PersistentCallGraph &); // do not implement
+
+public:
+  ~PersistentCallGraph();
+
+  /// \brief Load a call graph from the given file.
+  ///
+  /// \returns the call graph, or null with a description of the problem in
+  /// \p ErrorInfo if the file could not be read or is not a call graph.
+  static PersistentCallGraph *Load(llvm::StringRef Path,
+                                   std::string &ErrorInfo);
+
+  /// \brief Get the name of the given function, as by getCallGraphName().
+  llvm::StringRef getName(unsigned Function) const;
+
+  /// \brief Find the function with the given name.
+  ///
+  /// \returns true and the function in \p Function if it is in the graph.
+  bool lookup(llvm::StringRef Name, unsigned &Function) const;
+
+  unsigned getNumCallees(unsigned Function) const;
+  unsigned getCallee(unsigned Function, unsigned I) const;
+
+  unsigned getNumCallers(unsigned Function) const;
+  unsigned getCaller(unsigned Function, unsigned I) const;
+};
+
+} // end namespace idx
+
+} // end namespace clang
+
+#endif
@@ -17,7 +17,8 @@
 
 #include "clang/Index/ASTLocation.h"
 #include "clang/Index/STLExtras.h"
-#include <map>
+#include <functional>
+#include <vector>
 
 namespace clang {
   class ASTContext;
@@ -32,7 +33,9 @@ class DeclReferenceMap {
 public:
   explicit DeclReferenceMap(ASTContext &Ctx);
 
-  typedef std::multimap<NamedDecl*, ASTLocation> MapTy;
+  /// \brief The references, sorted by the decl they refer to once the
+  /// traversal of the AST is done.
+  typedef std::vector<std::pair<NamedDecl*, ASTLocation> > MapTy;
   typedef pair_value_iterator<MapTy::iterator> astlocation_iterator;
 
   astlocation_iterator refs_begin(NamedDecl *D) const;
@@ -40,6 +43,11 @@ public:
   bool refs_empty(NamedDecl *D) const;
 
 private:
+  typedef pair_first_compare<MapTy::value_type, std::less<NamedDecl*> >
+    CompareTy;
+
+  std::pair<MapTy::iterator, MapTy::iterator> getRefs(NamedDecl *D) const;
+
   mutable MapTy Map;
 };
 
@@ -19,6 +19,7 @@
 #include "clang/Index/GlobalSelector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/System/Mutex.h"
 #include <map>
 
 namespace clang {
@@ -29,32 +30,62 @@ namespace idx {
   class TranslationUnit;
 
 /// \brief Maps information to TranslationUnits.
+///
+/// Translation units can be indexed on several threads at once.  The entity
+/// and selector tables are split into shards by hash, each with its own
+/// lock, so that threads indexing different translation units rarely wait
+/// for each other.
 class Indexer : public IndexProvider {
 public:
   typedef llvm::SmallPtrSet<TranslationUnit *, 4> TUSetTy;
   typedef llvm::DenseMap<ASTContext *, TranslationUnit *> CtxTUMapTy;
+  typedef llvm::DenseMap<TranslationUnit *, ASTContext *> TUCtxMapTy;
   typedef std::map<Entity, TUSetTy> MapTy;
   typedef std::map<GlobalSelector, TUSetTy> SelMapTy;
 
+  /// \brief The number of shards of the entity and selector tables.
+  enum { NumShards = 64 };
+
   explicit Indexer(Program &prog) :
     Prog(prog) { }
 
   Program &getProgram() const { return Prog; }
 
   /// \brief Find all Entities and map them to the given translation unit.
+  ///
+  /// This can be called for different translation units concurrently.
   void IndexAST(TranslationUnit *TU);
 
+  /// \brief Forget the ASTContext of a translation unit that has been
+  /// indexed, so that the client can destroy it.
+  ///
+  /// The entities and selectors of \p TU stay mapped to it, so
+  /// GetTranslationUnitsFor() keeps reporting it and the client can load its
+  /// AST again when it is handed back.  Only the entities internal to \p TU
+  /// are no longer mapped, since they refer to the Decls of the ASTContext.
+  void UnloadAST(TranslationUnit *TU);
+
   virtual void GetTranslationUnitsFor(Entity Ent,
                                       TranslationUnitHandler &Handler);
   virtual void GetTranslationUnitsFor(GlobalSelector Sel,
                                       TranslationUnitHandler &Handler);
 
 private:
+  /// \brief One shard of the entity and selector tables.
+  struct Shard {
+    llvm::sys::Mutex Lock;
+    MapTy Map;
+    SelMapTy SelMap;
+  };
+
   Program &Prog;
 
-  MapTy Map;
+  Shard Shards[NumShards];
+
+  /// \brief Guards CtxTUMap and TUCtxMap.
+  llvm::sys::Mutex CtxLock;
   CtxTUMapTy CtxTUMap;
-  SelMapTy SelMap;
+  TUCtxMapTy TUCtxMap;
 };
 
 } // namespace idx
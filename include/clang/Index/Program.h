@@ -36,6 +36,14 @@ public:
 
   /// \brief Traverses the AST and passes all the entities to the Handler.
   void FindEntities(ASTContext &Ctx, EntityHandler &Handler);
+
+  /// \brief Forget the Decls that entities were resolved to in \p Ctx.
+  ///
+  /// Entity::getDecl() remembers the Decl it finds for each ASTContext, so
+  /// this should be called before an ASTContext that Entities were resolved
+  /// in is destroyed, to release them.  The Decls of a destroyed ASTContext
+  /// are never handed out for a new ASTContext at the same address.
+  void ForgetASTContext(ASTContext &Ctx);
 };
 
 } // namespace idx
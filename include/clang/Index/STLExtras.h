@@ -56,6 +56,30 @@ public:
   }
 };
 
+/// \brief Orders pairs by their first objects, using \p KeyCompare.
+///
+/// A vector of pairs that is stable_sort'ed with this comparator can stand in
+/// for a multimap: std::equal_range() with the same comparator returns the
+/// pairs with a given key, in the order they were added.  The vector costs
+/// no allocation per element and keeps the elements of a key together.
+template <typename PairTy, typename KeyCompare>
+class pair_first_compare {
+  KeyCompare Comp;
+
+public:
+  typedef typename PairTy::first_type key_type;
+
+  bool operator()(const PairTy &L, const PairTy &R) const {
+    return Comp(L.first, R.first);
+  }
+  bool operator()(const PairTy &L, const key_type &R) const {
+    return Comp(L.first, R);
+  }
+  bool operator()(const key_type &L, const PairTy &R) const {
+    return Comp(L, R.first);
+  }
+};
+
 } // end idx namespace
 
 } // end clang namespace
@@ -18,7 +18,8 @@
 #include "clang/Index/ASTLocation.h"
 #include "clang/Index/STLExtras.h"
 #include "clang/Basic/IdentifierTable.h"
-#include <map>
+#include <functional>
+#include <vector>
 
 namespace clang {
   class ASTContext;
@@ -33,8 +34,10 @@ class SelectorMap {
 public:
   explicit SelectorMap(ASTContext &Ctx);
 
-  typedef std::multimap<Selector, ObjCMethodDecl *> SelMethMapTy;
-  typedef std::multimap<Selector, ASTLocation> SelRefMapTy;
+  /// \brief The methods and references, sorted by selector once the
+  /// traversal of the AST is done.
+  typedef std::vector<std::pair<Selector, ObjCMethodDecl *> > SelMethMapTy;
+  typedef std::vector<std::pair<Selector, ASTLocation> > SelRefMapTy;
 
   typedef pair_value_iterator<SelMethMapTy::iterator> method_iterator;
   typedef pair_value_iterator<SelRefMapTy::iterator> astlocation_iterator;
@@ -46,6 +49,18 @@ public:
   astlocation_iterator refs_end(Selector Sel) const;
 
 private:
+  /// \brief Orders selectors by their opaque pointer values.
+  struct SelectorLess {
+    bool operator()(Selector LHS, Selector RHS) const {
+      return std::less<void*>()(LHS.getAsOpaquePtr(), RHS.getAsOpaquePtr());
+    }
+  };
+
+  typedef pair_first_compare<SelMethMapTy::value_type, SelectorLess>
+    MethCompareTy;
+  typedef pair_first_compare<SelRefMapTy::value_type, SelectorLess>
+    RefCompareTy;
+
   mutable SelMethMapTy SelMethMap;
   mutable SelRefMapTy SelRefMap;
 };
@@ -15,6 +15,8 @@
 #define LLVM_CLANG_LEX_EXTERNAL_PREPROCESSOR_SOURCE_H
 
 namespace clang {
+
+class IdentifierInfo;
   
 /// \brief Abstract interface for external sources of preprocessor 
 /// information.
@@ -27,6 +29,10 @@ public:
   
   /// \brief Read the set of macros defined by this external macro source.
   virtual void ReadDefinedMacros() = 0;
+
+  /// \brief Read the definition of a macro that the source has only marked
+  /// as defined, when the preprocessor first needs it.
+  virtual void LoadMacroDefinition(IdentifierInfo *II) = 0;
 };
   
 }
@@ -0,0 +1,102 @@
+//===--- HeaderGuardDatabase.h - Persistent header guard table --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the HeaderGuardDatabase interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERGUARDDATABASE_H
+#define LLVM_CLANG_LEX_HEADERGUARDDATABASE_H
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/DataTypes.h"
+#include <map>
+#include <string>
+
+namespace llvm {
+  class MemoryBuffer;
+}
+
+namespace clang {
+
+class FileEntry;
+
+/// HeaderGuardDatabase - An on-disk table of the headers that the
+/// multiple-include optimization found to be wrapped in an include guard,
+/// shared by every compilation that uses the same file.  Each entry maps the
+/// identity of a header (device, inode, modification time and size) to the
+/// name of its controlling macro, so a header that changes on disk no longer
+/// matches its entry.
+///
+/// A compilation that #includes a header listed in the table, with the guard
+/// macro already defined, can skip the header without ever reading it, even
+/// if this is the first time the compilation sees the header.
+class HeaderGuardDatabase {
+public:
+  /// FileKey - The identity of a header file.
+  struct FileKey {
+    uint64_t Device, Inode, ModTime, Size;
+
+    explicit FileKey(const FileEntry *FE);
+    FileKey(uint64_t Device, uint64_t Inode, uint64_t ModTime, uint64_t Size)
+      : Device(Device), Inode(Inode), ModTime(ModTime), Size(Size) {}
+
+    bool operator<(const FileKey &RHS) const {
+      if (Device != RHS.Device) return Device < RHS.Device;
+      if (Inode != RHS.Inode) return Inode < RHS.Inode;
+      if (ModTime != RHS.ModTime) return ModTime < RHS.ModTime;
+      return Size < RHS.Size;
+    }
+  };
+
+private:
+  /// Buf - The contents of the database file read at startup, if any.
+  llvm::OwningPtr<const llvm::MemoryBuffer> Buf;
+
+  /// Table - The on-disk hash table within Buf, hidden behind a void* to keep
+  /// the trait out of this header.
+  void *Table;
+
+  /// NewEntries - Guards found by this compilation that were not already in
+  /// the on-disk table, or that differ from it.
+  std::map<FileKey, std::string> NewEntries;
+
+  HeaderGuardDatabase(const HeaderGuardDatabase&); // DO NOT IMPLEMENT
+  void operator=(const HeaderGuardDatabase&);      // DO NOT IMPLEMENT
+public:
+  // The current database file version.
+  enum { Version = 1 };
+
+  /// HeaderGuardDatabase - Read the database file at \arg Path.  If it does
+  /// not exist or cannot be read, the database starts out empty.
+  explicit HeaderGuardDatabase(llvm::StringRef Path);
+  ~HeaderGuardDatabase();
+
+  /// lookup - Return the name of the controlling macro recorded for \arg File,
+  /// or an empty string if there is none.
+  llvm::StringRef lookup(const FileEntry *File);
+
+  /// record - Remember that \arg File is guarded by the macro \arg Macro.
+  void record(const FileEntry *File, llvm::StringRef Macro);
+
+  /// hasNewEntries - Return true if this compilation found guards that are
+  /// not in the on-disk table yet.
+  bool hasNewEntries() const { return !NewEntries.empty(); }
+
+  /// Write - Write the merged contents of the on-disk table and the new
+  /// entries to \arg Path.  The file is written to a temporary and moved into
+  /// place so concurrent readers never see a partial file.  Returns true on
+  /// error.
+  bool Write(llvm::StringRef Path);
+};
+
+}  // end namespace clang
+
+#endif
@@ -15,6 +15,7 @@
 #define LLVM_CLANG_LEX_HEADERSEARCH_H
 
 #include "clang/Lex/DirectoryLookup.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringMap.h"
 #include <vector>
 
@@ -23,7 +24,10 @@ namespace clang {
 class ExternalIdentifierLookup;
 class FileEntry;
 class FileManager;
+class HeaderGuardDatabase;
+class HeaderSearchCache;
 class IdentifierInfo;
+class IdentifierTable;
 
 /// HeaderFileInfo - The preprocessor keeps track of this information for each
 /// file that is #included.
@@ -95,6 +99,19 @@ class HeaderSearch {
   /// query.
   llvm::StringMap<std::pair<unsigned, unsigned> > LookupFileCache;
 
+  /// PersistentLookupCache - If non-null, an on-disk cache of LookupFile
+  /// results shared with other compilations using the same search paths.  It
+  /// is consulted whenever LookupFileCache has no matching entry.
+  llvm::OwningPtr<HeaderSearchCache> PersistentLookupCache;
+  std::string PersistentLookupCacheFile;
+
+  /// GuardDatabase - If non-null, an on-disk table of the include guards
+  /// found by earlier compilations.  It lets the multiple-include
+  /// optimization skip a guarded header the first time it is #included.
+  /// GuardIdentifiers is used to turn the names it holds into identifiers.
+  llvm::OwningPtr<HeaderGuardDatabase> GuardDatabase;
+  std::string GuardDatabaseFile;
+  IdentifierTable *GuardIdentifiers;
 
   /// FrameworkMap - This is a collection mapping a framework or subframework
   /// name like "Carbon" to the Carbon.framework directory.
@@ -112,6 +129,8 @@ class HeaderSearch {
   unsigned NumIncluded;
   unsigned NumMultiIncludeFileOptzn;
   unsigned NumFrameworkLookups, NumSubFrameworkLookups;
+  unsigned NumPersistentCacheHits, NumPersistentCacheMisses;
+  unsigned NumGuardDatabaseHits, NumGuardDatabaseOptzn;
 
   // HeaderSearch doesn't support default or copy construction.
   explicit HeaderSearch();
@@ -133,6 +152,24 @@ public:
     //LookupFileCache.clear();
   }
 
+  /// SetPersistentLookupCache - Use the on-disk lookup cache in the file
+  /// \arg Path to satisfy LookupFile queries.  This must be called after the
+  /// search paths have been set, since the cache is only used if it was
+  /// written for the same search path configuration.
+  void SetPersistentLookupCache(llvm::StringRef Path);
+
+  /// WritePersistentLookupCache - Write any lookups performed since the
+  /// persistent lookup cache was loaded back to disk.
+  void WritePersistentLookupCache();
+
+  /// SetGuardDatabase - Use and update the include guard database in the file
+  /// \arg Path.  Controlling macros read from it are interned in \arg Idents.
+  void SetGuardDatabase(llvm::StringRef Path, IdentifierTable &Idents);
+
+  /// WriteGuardDatabase - Write any include guards found since the guard
+  /// database was loaded back to disk.
+  void WriteGuardDatabase();
+
   /// ClearFileInfo - Forget everything we know about headers so far.
   void ClearFileInfo() {
     FileInfo.clear();
@@ -204,8 +241,12 @@ public:
   /// macro.  This is used by the multiple-include optimization to eliminate
   /// no-op #includes.
   void SetFileControllingMacro(const FileEntry *File,
-                               const IdentifierInfo *ControllingMacro) {
-    getFileInfo(File).ControllingMacro = ControllingMacro;
+                               const IdentifierInfo *ControllingMacro);
+
+  /// getFileControllingMacro - Return the macro that guards the specified
+  /// file against multiple inclusion, if it is known to have one.
+  const IdentifierInfo *getFileControllingMacro(const FileEntry *File) {
+    return getFileInfo(File).getControllingMacro(ExternalLookup);
   }
 
   /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -0,0 +1,102 @@
+//===--- HeaderSearchCache.h - Persistent #include lookup cache -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the HeaderSearchCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERSEARCHCACHE_H
+#define LLVM_CLANG_LEX_HEADERSEARCHCACHE_H
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class MemoryBuffer;
+}
+
+namespace clang {
+
+class DirectoryLookup;
+
+/// HeaderSearchCache - An on-disk cache of the results of
+/// HeaderSearch::LookupFile, shared by every compilation that uses the same
+/// search path configuration.  Each entry maps a filename and the index of
+/// the search directory the lookup started from to the index of the search
+/// directory that satisfied it, or to the number of search directories if
+/// none did.
+///
+/// The cache file records a description of the search directories, including
+/// their modification times, and is ignored if that description does not
+/// match the current configuration.  Adding or removing a header directly
+/// inside a search directory therefore invalidates the cache, but changes in
+/// a subdirectory of a search directory (e.g. to "sys/foo.h") are not
+/// detected.
+class HeaderSearchCache {
+  /// Buf - The contents of the cache file read at startup, if any.
+  llvm::OwningPtr<const llvm::MemoryBuffer> Buf;
+
+  /// Table - The on-disk hash table within Buf.  This is an
+  /// OnDiskChainedHashTable, hidden behind a void* to keep the trait out of
+  /// this header.
+  void *Table;
+
+  /// Configuration - The description of the search path configuration that
+  /// this cache is valid for.
+  std::string Configuration;
+
+  /// NewEntries - Lookups performed by this compilation that were not already
+  /// in the on-disk cache, or that produced a different result.  The key is
+  /// the start index followed by the filename.
+  llvm::StringMap<unsigned> NewEntries;
+
+  HeaderSearchCache(const HeaderSearchCache&); // DO NOT IMPLEMENT
+  void operator=(const HeaderSearchCache&);    // DO NOT IMPLEMENT
+public:
+  // The current cache file version.
+  enum { Version = 1 };
+
+  /// HeaderSearchCache - Read the cache file at \arg Path.  If it does not
+  /// exist or was written for a different \arg Configuration the cache
+  /// starts out empty.
+  HeaderSearchCache(llvm::StringRef Path, llvm::StringRef Configuration);
+  ~HeaderSearchCache();
+
+  /// ComputeConfiguration - Build the description of a search path
+  /// configuration that is used to decide whether a cache file applies.
+  static std::string
+  ComputeConfiguration(const std::vector<DirectoryLookup> &SearchDirs,
+                       unsigned SystemDirIdx);
+
+  /// lookup - If a lookup of \arg Filename starting at search directory
+  /// \arg StartIdx has been recorded, set \arg FoundIdx to its result and
+  /// return true.
+  bool lookup(llvm::StringRef Filename, unsigned StartIdx, unsigned &FoundIdx);
+
+  /// record - Remember that looking up \arg Filename starting at search
+  /// directory \arg StartIdx was satisfied by directory \arg FoundIdx.
+  void record(llvm::StringRef Filename, unsigned StartIdx, unsigned FoundIdx);
+
+  /// hasNewEntries - Return true if this compilation recorded lookups that
+  /// are not in the on-disk cache yet.
+  bool hasNewEntries() const { return !NewEntries.empty(); }
+
+  /// Write - Write the merged contents of the on-disk cache and the new
+  /// entries to \arg Path.  The file is written to a temporary and moved into
+  /// place so concurrent readers never see a partial file.  Returns true on
+  /// error.
+  bool Write(llvm::StringRef Path);
+};
+
+}  // end namespace clang
+
+#endif
@@ -149,6 +149,12 @@ public:
     return BufferPtr == BufferEnd;
   }
 
+  /// SkipExcludedLines - Advance past the text of a skipped conditional block
+  /// without forming tokens, stopping at the start of the first line that
+  /// could hold a preprocessor directive.  This must only be called in raw
+  /// mode, between tokens.
+  void SkipExcludedLines();
+
   /// isKeepWhitespaceMode - Return true if the lexer should return tokens for
   /// every character in the file, including whitespace and comments.  This
   /// should only be used in raw mode, as the preprocessor is not prepared to
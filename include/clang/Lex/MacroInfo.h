@@ -22,6 +22,7 @@
 
 namespace clang {
   class Preprocessor;
+  class SourceManager;
 
 /// MacroInfo - Each identifier that is #define'd has an instance of this class
 /// associated with it, used to implement macro expansion.
@@ -44,6 +45,11 @@ class MacroInfo {
   /// to.
   llvm::SmallVector<Token, 8> ReplacementTokens;
 
+  /// DefinitionLength - The length of the replacement list as spelled in the
+  /// source, or 0 if it is not spelled contiguously in one file.  This is
+  /// computed lazily; see getDefinitionLength.
+  mutable unsigned DefinitionLength;
+
   /// IsFunctionLike - True if this macro is a function-like macro, false if it
   /// is an object-like macro.
   bool IsFunctionLike : 1;
@@ -62,6 +68,9 @@ class MacroInfo {
   /// it has not yet been redefined or undefined.
   bool IsBuiltinMacro : 1;
 
+  /// IsDefinitionLengthCached - True if DefinitionLength has been computed.
+  mutable bool IsDefinitionLengthCached : 1;
+
 private:
   //===--------------------------------------------------------------------===//
   // State that changes as the macro is used.
@@ -108,6 +117,15 @@ public:
   ///
   SourceLocation getDefinitionEndLoc() const { return EndLocation; }
 
+  /// getDefinitionLength - Return the number of characters from the start of
+  /// the first replacement token to the end of the last one, or 0 if the
+  /// replacement list is empty or not spelled contiguously in a single file.
+  unsigned getDefinitionLength(SourceManager &SM) const {
+    if (IsDefinitionLengthCached)
+      return DefinitionLength;
+    return getDefinitionLengthSlow(SM);
+  }
+
   /// isIdenticalTo - Return true if the specified macro definition is equal to
   /// this macro in spelling, arguments, and whitespace.  This is used to emit
   /// duplicate definition warnings.  This implements the rules in C99 6.10.3.
@@ -211,6 +229,9 @@ public:
     assert(!IsDisabled && "Cannot disable an already-disabled macro!");
     IsDisabled = true;
   }
+
+private:
+  unsigned getDefinitionLengthSlow(SourceManager &SM) const;
 };
 
 }  // end namespace clang
@@ -62,6 +62,12 @@ public:
   virtual void MacroExpands(const Token &Id, const MacroInfo* MI) {
   }
 
+  /// MacroTested - This is called when #ifdef, #ifndef or defined() asks
+  /// whether a macro is defined, and when an identifier that is not a macro
+  /// appears in a #if expression.  MI is null if the macro is not defined.
+  virtual void MacroTested(const Token &Id, const MacroInfo *MI) {
+  }
+
   /// MacroDefined - This hook is called whenever a macro definition is seen.
   virtual void MacroDefined(const IdentifierInfo *II, const MacroInfo *MI) {
   }
@@ -106,6 +112,11 @@ public:
     Second->MacroExpands(Id, MI);
   }
 
+  virtual void MacroTested(const Token &Id, const MacroInfo *MI) {
+    First->MacroTested(Id, MI);
+    Second->MacroTested(Id, MI);
+  }
+
   virtual void MacroDefined(const IdentifierInfo *II, const MacroInfo *MI) {
     First->MacroDefined(II, MI);
     Second->MacroDefined(II, MI);
@@ -21,6 +21,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Allocator.h"
 #include <string>
+#include <vector>
 
 namespace llvm {
   class MemoryBuffer;
@@ -74,12 +75,20 @@ class PTHManager : public IdentifierInfoLookup {
   ///  if the file (if any) that was to used to generate the PTH cache.
   const char* OriginalSourceFile;
 
+  /// Flags - The PTHFlags the file was written with.
+  unsigned Flags;
+
+  /// NumLexers, NumLexerMisses - The number of files lexed from the cached
+  ///  tokens, and the number of files that had to be lexed from source.
+  unsigned NumLexers, NumLexerMisses;
+
   /// This constructor is intended to only be called by the static 'Create'
   /// method.
   PTHManager(const llvm::MemoryBuffer* buf, void* fileLookup,
              const unsigned char* idDataTable, IdentifierInfo** perIDCache,
              void* stringIdLookup, unsigned numIds,
-             const unsigned char* spellingBase, const char *originalSourceFile);
+             const unsigned char* spellingBase, const char *originalSourceFile,
+             unsigned flags);
 
   // Do not implement.
   PTHManager();
@@ -101,7 +110,17 @@ class PTHManager : public IdentifierInfoLookup {
 
 public:
   // The current PTH version.
-  enum { Version = 9 };
+  enum { Version = 10 };
+
+  /// PTHFlags - Properties of a PTH file, stored in its prologue.
+  enum PTHFlags {
+    /// SharedStore - The file caches the files of several translation units
+    /// and is updated incrementally (see -pth-merge), so some of the files
+    /// it caches may have changed since.  The stat information it records is
+    /// not used to answer stat() calls, and the tokens of files whose
+    /// modification time or size no longer match are ignored.
+    SharedStore = 0x1
+  };
 
   ~PTHManager();
 
@@ -131,8 +150,18 @@ public:
   /// createStatCache - Returns a StatSysCallCache object for use with
   ///  FileManager objects.  These objects use the PTH data to speed up
   ///  calls to stat by memoizing their results from when the PTH file
-  ///  was generated.
+  ///  was generated.  Returns null for shared stores, whose stat data may be
+  ///  out of date.
   StatSysCallCache *createStatCache();
+
+  /// PrintStats - Print statistics about the use of the PTH file to stderr.
+  void PrintStats() const;
+
+  /// getCachedFiles - Add the names of the files whose tokens are cached in
+  ///  the PTH file \arg file to \arg Files.  Returns true if the file could
+  ///  not be read.
+  static bool getCachedFiles(const std::string &file,
+                             std::vector<std::string> &Files);
 };
 
 }  // end namespace clang
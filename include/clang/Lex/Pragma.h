@@ -14,8 +14,8 @@
 #ifndef LLVM_CLANG_PRAGMA_H
 #define LLVM_CLANG_PRAGMA_H
 
+#include "llvm/ADT/DenseMap.h"
 #include <cassert>
-#include <vector>
 
 namespace clang {
   class Preprocessor;
@@ -51,9 +51,10 @@ public:
 /// are "#pragma GCC", "#pragma STDC", and "#pragma omp", but any namespaces may
 /// be (potentially recursively) defined.
 class PragmaNamespace : public PragmaHandler {
-  /// Handlers - This is the list of handlers in this namespace.
-  ///
-  std::vector<PragmaHandler*> Handlers;
+  /// Handlers - This is the table of handlers in this namespace, keyed by the
+  /// name of each handler.  The handler for the null identifier, if any, is
+  /// stored under a null key.
+  llvm::DenseMap<const IdentifierInfo *, PragmaHandler *> Handlers;
 public:
   PragmaNamespace(const IdentifierInfo *Name) : PragmaHandler(Name) {}
   virtual ~PragmaNamespace();
@@ -68,7 +69,7 @@ public:
   /// AddPragma - Add a pragma to this namespace.
   ///
   void AddPragma(PragmaHandler *Handler) {
-    Handlers.push_back(Handler);
+    Handlers[Handler->getName()] = Handler;
   }
 
   /// RemovePragmaHandler - Remove the given handler from the
@@ -81,6 +82,10 @@ public:
 
   virtual void HandlePragma(Preprocessor &PP, Token &FirstToken);
 
+  /// DispatchPragma - Pass a pragma to the handler for its name, given that
+  /// the name has already been lexed into Tok.
+  void DispatchPragma(Preprocessor &PP, Token &Tok);
+
   virtual PragmaNamespace *getIfNamespace() { return this; }
 };
 
@@ -0,0 +1,116 @@
+//===--- PrecomputedPredefines.h - Predefines without lexing ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the PrecomputedPredefines interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_PRECOMPUTEDPREDEFINES_H
+#define LLVM_CLANG_LEX_PRECOMPUTEDPREDEFINES_H
+
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class Preprocessor;
+
+/// PrecomputedPredefines - The macros defined by a block of predefines text,
+/// such as the target and language macros at the start of the predefines
+/// buffer, already split into tokens.  Installing them into a preprocessor
+/// gives the same macro table, line markers and callbacks as lexing the text,
+/// so the preprocessor can skip over the text instead of lexing it.
+///
+/// The text only depends on the target and the language options, so the
+/// result can be cached on disk and shared by every compilation with the same
+/// configuration.  A cache file stores the text it was computed from and is
+/// only used for exactly that text.
+class PrecomputedPredefines {
+public:
+  /// BodyToken - A token in the body of a macro.  Identifiers keep their
+  /// name; every other token is spelled from the text.
+  struct BodyToken {
+    unsigned Offset, Length;
+    unsigned char Kind, Flags;
+    std::string Identifier;
+  };
+
+  /// Macro - A macro that is still defined at the end of the text.
+  struct Macro {
+    std::string Name;
+    unsigned Offset, EndOffset;
+    bool IsFunctionLike, IsC99Varargs, IsGNUVarargs;
+    std::vector<std::string> Args;
+    std::vector<BodyToken> Body;
+  };
+
+  /// LineNote - An entry the line markers of the text made in the line table.
+  struct LineNote {
+    unsigned Offset, LineNo, IncludeOffset;
+    unsigned char FileKind;
+    bool HasFilename;
+    std::string Filename;
+  };
+
+  /// FileChange - A FileChanged callback made by the line markers of the
+  /// text.
+  struct FileChange {
+    unsigned Offset;
+    unsigned char Reason, FileKind;
+  };
+
+private:
+  std::string Text;
+  std::vector<Macro> Macros;
+  std::vector<LineNote> LineNotes;
+  std::vector<FileChange> FileChanges;
+
+  explicit PrecomputedPredefines(llvm::StringRef Text) : Text(Text) {}
+
+  friend class PredefinesRecorder;
+public:
+  // The current cache file version.
+  enum { Version = 1 };
+
+  /// getText - Return the text these macros were computed from.
+  llvm::StringRef getText() const { return Text; }
+
+  /// Compute - Lex \arg Text with a scratch preprocessor configured like
+  /// \arg PP and record the macros it defines.  Returns null if the text could
+  /// not be processed without errors.
+  static PrecomputedPredefines *Compute(Preprocessor &PP, llvm::StringRef Text);
+
+  /// Read - Read the cache file at \arg Path.  Returns null if it does not
+  /// exist, is damaged or was computed from a text other than \arg Text.
+  static PrecomputedPredefines *Read(llvm::StringRef Path,
+                                     llvm::StringRef Text);
+
+  /// Write - Write these macros to the cache file at \arg Path.  The file is
+  /// written to a temporary and moved into place so concurrent readers never
+  /// see a partial file.  Returns true on error.
+  bool Write(llvm::StringRef Path) const;
+
+  /// getCacheFileName - Return the name of the cache file for \arg Text
+  /// within a cache directory.
+  static std::string getCacheFileName(llvm::StringRef Text);
+
+  /// canInstall - Return true if the predefines of \arg PP start with the
+  /// text and none of the macros is defined yet, e.g. by a PCH file.
+  bool canInstall(Preprocessor &PP) const;
+
+  /// Install - Define the macros in \arg PP as if the text at the start of
+  /// the predefines buffer \arg FID had been lexed.
+  void Install(Preprocessor &PP, FileID FID) const;
+};
+
+}  // end namespace clang
+
+#endif
@@ -43,6 +43,7 @@ class ScratchBuffer;
 class TargetInfo;
 class PPCallbacks;
 class DirectoryLookup;
+class PrecomputedPredefines;
   
 /// Preprocessor - This object engages in a tight little dance with the lexer to
 /// efficiently preprocess tokens.  Lexers know only about tokens within a
@@ -81,6 +82,8 @@ class Preprocessor {
   IdentifierInfo *Ident__has_builtin;              // __has_builtin
   IdentifierInfo *Ident__has_include;              // __has_include
   IdentifierInfo *Ident__has_include_next;         // __has_include_next
+  IdentifierInfo *Ident_Pragma_once;               // #pragma once
+  IdentifierInfo *Ident_Pragma_mark;               // #pragma mark
 
   SourceLocation DATELoc, TIMELoc;
   unsigned CounterValue;  // Next __COUNTER__ value.
@@ -187,9 +190,14 @@ class Preprocessor {
   /// FIXME: why not use a singly linked list?
   std::vector<MacroInfo*> MICache;
   
-  /// MacroArgCache - This is a "freelist" of MacroArg objects that can be
-  /// reused for quick allocation.
-  MacroArgs *MacroArgCache;
+  /// MacroArgCache - These are "freelists" of MacroArg objects that can be
+  /// reused for quick allocation, bucketed by capacity: the objects in bucket
+  /// N have room for exactly 2^N argument tokens.  The objects themselves are
+  /// allocated out of MacroArgAllocator and only destroyed with the
+  /// preprocessor.
+  enum { NumMacroArgBuckets = 32 };
+  MacroArgs *MacroArgCache[NumMacroArgBuckets];
+  llvm::BumpPtrAllocator MacroArgAllocator;
   friend class MacroArgs;
 
   // Various statistics we track for performance analysis.
@@ -199,15 +207,32 @@ class Preprocessor {
   unsigned NumMacroExpanded, NumFnMacroExpanded, NumBuiltinMacroExpanded;
   unsigned NumFastMacroExpanded, NumTokenPaste, NumFastTokenPaste;
   unsigned NumSkipped;
+  unsigned NumMacroArgsAllocated, NumMacroArgsReused;
+  unsigned NumTokenLexersAllocated, NumTokenLexersReused;
+  unsigned NumBacktracks, NumBacktrackedTokens, MaxCachedTokens;
+  unsigned NumDisambiguations, NumMemoizedDisambiguations;
+  mutable unsigned NumCleanedSpellings;
+
+  /// CleanedSpellingAllocator - Holds the spellings of tokens that needed
+  /// cleaning, as handed out by getSpellingRef.
+  mutable llvm::BumpPtrAllocator CleanedSpellingAllocator;
 
   /// Predefines - This string is the predefined macros that preprocessor
   /// should use from the command line etc.
   std::string Predefines;
 
-  /// TokenLexerCache - Cache macro expanders to reduce malloc traffic.
-  enum { TokenLexerCacheSize = 8 };
-  unsigned NumCachedTokenLexers;
-  TokenLexer *TokenLexerCache[TokenLexerCacheSize];
+  /// Precomputed - The macros defined by the start of Predefines, installed
+  /// instead of lexing that part of the predefines buffer, or null.
+  llvm::OwningPtr<PrecomputedPredefines> Precomputed;
+
+  /// SkipMainFilePreambleBytes - The number of bytes at the start of the main
+  /// file that are not lexed, because a precompiled preamble provides them.
+  unsigned SkipMainFilePreambleBytes;
+
+  /// TokenLexerCache - Cache macro expanders to reduce malloc traffic.  Every
+  /// dead expander is kept, so deeply nested expansions never go back to
+  /// malloc once the cache has grown to the maximum nesting depth.
+  std::vector<TokenLexer*> TokenLexerCache;
 
 private:  // Cached tokens state.
   typedef llvm::SmallVector<Token, 1> CachedTokensTy;
@@ -227,12 +252,21 @@ private:  // Cached tokens state.
   /// invoked (at which point the last position is popped).
   std::vector<CachedTokensTy::size_type> BacktrackPositions;
 
+  /// DisambiguationMemo - The results of tentative parses that started at one
+  /// of the cached tokens, keyed by the kind of query and the location of the
+  /// token, with the generation of name lookup each was computed in.  It is
+  /// cleared with the cached tokens, so a result is only reused while the
+  /// tokens it was computed from can still be backtracked over.
+  llvm::DenseMap<std::pair<unsigned, unsigned>,
+                 std::pair<unsigned, unsigned> > DisambiguationMemo;
+
 public:
   Preprocessor(Diagnostic &diags, const LangOptions &opts,
                const TargetInfo &target,
                SourceManager &SM, HeaderSearch &Headers,
                IdentifierInfoLookup *IILookup = 0,
-               bool OwnsHeaderSearch = false);
+               bool OwnsHeaderSearch = false,
+               const SharedIdentifierTable *SharedIdentifiers = 0);
 
   ~Preprocessor();
 
@@ -300,7 +334,13 @@ public:
   /// getMacroInfo - Given an identifier, return the MacroInfo it is #defined to
   /// or null if it isn't #define'd.
   MacroInfo *getMacroInfo(IdentifierInfo *II) const {
-    return II->hasMacroDefinition() ? Macros.find(II)->second : 0;
+    if (!II->hasMacroDefinition())
+      return 0;
+    llvm::DenseMap<IdentifierInfo*, MacroInfo*>::const_iterator Pos
+      = Macros.find(II);
+    if (Pos != Macros.end())
+      return Pos->second;
+    return LoadExternalMacro(II);
   }
 
   /// setMacroInfo - Specify a macro for this identifier.
@@ -320,6 +360,17 @@ public:
   void setPredefines(const char *P) { Predefines = P; }
   void setPredefines(const std::string &P) { Predefines = P; }
 
+  /// setPrecomputedPredefines - Install the macros of \arg P, instead of
+  /// lexing their definitions, if the predefines start with the text P was
+  /// computed from.  The preprocessor takes ownership of P.
+  void setPrecomputedPredefines(PrecomputedPredefines *P);
+
+  /// setSkipMainFilePreambleBytes - Start lexing the main file \arg Bytes
+  /// into its buffer, because the implicit PCH holds its preamble.
+  void setSkipMainFilePreambleBytes(unsigned Bytes) {
+    SkipMainFilePreambleBytes = Bytes;
+  }
+
   /// getIdentifierInfo - Return information about the specified preprocessor
   /// identifier token.  The version of this method that takes two character
   /// pointers is preferred unless the identifier is already available as a
@@ -412,6 +463,35 @@ public:
   /// caching of tokens is on.
   bool isBacktrackEnabled() const { return !BacktrackPositions.empty(); }
 
+  /// LookupDisambiguation - If a tentative parse of kind \arg Kind already
+  /// started at \arg Loc since the cached tokens were last cleared, in the
+  /// same nonzero \arg Generation of name lookup, set \arg Result to what it
+  /// recorded and return true.  A tentative parse depends on which names are
+  /// types, so its result is stale once a declaration changes that.
+  bool LookupDisambiguation(unsigned Kind, SourceLocation Loc,
+                            unsigned Generation, unsigned &Result) {
+    ++NumDisambiguations;
+    llvm::DenseMap<std::pair<unsigned, unsigned>,
+                   std::pair<unsigned, unsigned> >::iterator I
+      = DisambiguationMemo.find(std::make_pair(Kind, Loc.getRawEncoding()));
+    if (!Generation || I == DisambiguationMemo.end() ||
+        I->second.first != Generation)
+      return false;
+    ++NumMemoizedDisambiguations;
+    Result = I->second.second;
+    return true;
+  }
+
+  /// RecordDisambiguation - Remember the result of a tentative parse of kind
+  /// \arg Kind that started at \arg Loc in the given \arg Generation of name
+  /// lookup, for as long as the tokens it backtracked over stay cached.
+  void RecordDisambiguation(unsigned Kind, SourceLocation Loc,
+                            unsigned Generation, unsigned Result) {
+    if (Generation && !CachedTokens.empty())
+      DisambiguationMemo[std::make_pair(Kind, Loc.getRawEncoding())]
+        = std::make_pair(Generation, Result);
+  }
+
   /// Lex - To lex a token from the preprocessor, just pull a token from the
   /// current lexer or macro object.
   void Lex(Token &Result) {
@@ -479,6 +559,7 @@ public:
   void EnterToken(const Token &Tok) {
     EnterCachingLexMode();
     CachedTokens.insert(CachedTokens.begin()+CachedLexPos, Tok);
+    noteCachedTokens();
   }
 
   /// AnnotateCachedTokens - We notify the Preprocessor that if it is caching
@@ -570,6 +651,15 @@ public:
   /// if an internal buffer is returned.
   unsigned getSpelling(const Token &Tok, const char *&Buffer) const;
 
+  /// getSpellingRef - Return the spelling of the Tok token without copying it
+  /// whenever possible.  Identifiers return their name in the identifier
+  /// table, and tokens that need no cleaning return a reference into the
+  /// source buffer.  Only tokens with trigraphs or escaped newlines in them
+  /// are copied, into memory owned by the preprocessor.  The result is
+  /// followed by at least one readable character, so literal parsers may
+  /// overread by one.
+  llvm::StringRef getSpellingRef(const Token &Tok) const;
+
   /// getSpellingOfSingleCharacterNumericConstant - Tok is a numeric constant
   /// with length 1, return the character.
   char getSpellingOfSingleCharacterNumericConstant(const Token &Tok) const {
@@ -632,6 +722,19 @@ public:
 
   void PrintStats();
 
+  /// getTotalMemory - Return the number of bytes allocated for macro
+  /// definitions, macro expansion and the token caches.
+  size_t getTotalMemory() const;
+
+  /// releaseCaches - Free the macro expanders, macro argument lists and
+  /// cached tokens that are kept for reuse but not in use.  They are
+  /// allocated again when the preprocessor needs them.
+  void releaseCaches();
+
+  /// getNumBacktrackedTokens - Return how many cached tokens have been lexed
+  /// again because the parser backtracked over them.
+  unsigned getNumBacktrackedTokens() const { return NumBacktrackedTokens; }
+
   /// HandleMicrosoftCommentPaste - When the macro expander pastes together a
   /// comment (/##/) in microsoft mode, this method handles updating the current
   /// state, returning the token on the next source line.
@@ -750,6 +853,10 @@ private:
   ///  be reused for allocating new MacroInfo objects.
   void ReleaseMacroInfo(MacroInfo* MI);
 
+  /// LoadExternalMacro - Have the external source read the definition of a
+  /// macro that it marked as defined without reading it.
+  MacroInfo *LoadExternalMacro(IdentifierInfo *II) const;
+
   /// ReadMacroName - Lex and validate a macro name, which occurs after a
   /// #define or #undef.  This emits a diagnostic, sets the token kind to eom,
   /// and discards the rest of the macro line if the macro name is invalid.
@@ -846,6 +953,11 @@ private:
       RemoveTopOfLexerStack();
   }
   const Token &PeekAhead(unsigned N);
+  void TrimCachedTokens();
+  void noteCachedTokens() {
+    if (CachedTokens.size() > MaxCachedTokens)
+      MaxCachedTokens = CachedTokens.size();
+  }
   void AnnotatePreviousCachedTokens(const Token &Tok);
 
   //===--------------------------------------------------------------------===//
@@ -60,6 +60,18 @@ class TokenLexer {
   /// instantiated.
   SourceLocation InstantiateLocStart, InstantiateLocEnd;
 
+  /// MacroDefStart/MacroDefLength - The source range of the replacement list
+  /// of the macro being expanded, if it is spelled contiguously in one file.
+  /// MacroDefLength is 0 otherwise.
+  SourceLocation MacroDefStart;
+  unsigned MacroDefLength;
+
+  /// MacroExpansionStart - An instantiation location covering the whole
+  /// replacement list from MacroDefStart.  Tokens from the macro body get
+  /// their location by offset from it, instead of each getting its own
+  /// instantiation SLocEntry.
+  SourceLocation MacroExpansionStart;
+
   /// Lexical information about the expansion point of the macro: the identifier
   /// that the macro expanded from had these properties.
   bool AtStartOfLine : 1;
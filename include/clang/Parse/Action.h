@@ -213,6 +213,13 @@ public:
                               bool isClassName = false,
                               TypeTy *ObjectType = 0) = 0;
 
+  /// getNameLookupGeneration - Return a number that changes whenever a
+  /// declaration becomes visible to, or is hidden from, name lookup.  While it
+  /// stays the same, the parser may assume that getTypeName() keeps returning
+  /// NULL for a name it returned NULL for before.  The default implementation
+  /// returns 0, which means results must not be reused.
+  virtual unsigned getNameLookupGeneration() { return 0; }
+
   /// isTagName() - This method is called *for error recovery purposes only*
   /// to determine if the specified name is a valid tag name ("struct foo").  If
   /// so, this returns the TST for the tag corresponding to it (TST_enum,
@@ -532,6 +539,30 @@ public:
     return Decl;
   }
 
+  /// ActOnSkippedFunctionBody - This is called instead of
+  /// ActOnFinishFunctionBody when the parser skipped over a function body
+  /// without parsing it.  The body lies between the braces at LBraceLoc and
+  /// RBraceLoc.
+  virtual DeclPtrTy ActOnSkippedFunctionBody(DeclPtrTy Decl,
+                                             SourceLocation LBraceLoc,
+                                             SourceLocation RBraceLoc) {
+    return Decl;
+  }
+
+  /// ActOnStartOfSkippedFunctionBody - This is called when the parser is
+  /// about to parse a skipped function body, after the whole translation unit
+  /// has been parsed.  FnBodyScope is the scope of the body.  Returning a null
+  /// decl tells the parser not to parse the body.
+  virtual DeclPtrTy ActOnStartOfSkippedFunctionBody(Scope *FnBodyScope,
+                                                    DeclPtrTy Decl) {
+    return DeclPtrTy();
+  }
+
+  /// ActOnFinishSkippedFunctionBody - This is called after a skipped function
+  /// body has been parsed and ActOnFinishFunctionBody has been called for it.
+  virtual void ActOnFinishSkippedFunctionBody(DeclPtrTy Decl) {
+  }
+
   virtual DeclPtrTy ActOnFileScopeAsmDecl(SourceLocation Loc,
                                           ExprArg AsmString) {
     return DeclPtrTy();
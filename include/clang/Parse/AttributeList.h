@@ -17,11 +17,53 @@
 #include "clang/Parse/Ownership.h"
 #include "clang/Basic/SourceLocation.h"
 #include <cassert>
+#include <cstddef>
 
 namespace clang {
   class IdentifierInfo;
   class Action;
 
+/// AttributeListPool - Recycles the memory of the AttributeLists created by
+/// one parser, and of their argument arrays.  Nearly every declaration in the
+/// system headers carries a few attributes, which are freed as soon as the
+/// declaration has been handed to the actions, so the next declaration can
+/// reuse their memory instead of going back to malloc.
+class AttributeListPool {
+  /// FreeNode - A free block, linked into the free list for its size.
+  struct FreeNode { FreeNode *Next; };
+
+  /// FreeLists - The free AttributeLists, in slot 0, and the free argument
+  /// arrays of 1 to MaxPooledArgs arguments.
+  enum { MaxPooledArgs = 4 };
+  FreeNode *FreeLists[MaxPooledArgs + 1];
+
+  unsigned NumAttrAllocations, NumAttrsReused;
+  unsigned NumArgAllocations, NumArgsReused;
+
+  AttributeListPool(const AttributeListPool &); // DO NOT IMPLEMENT
+  void operator=(const AttributeListPool &); // DO NOT IMPLEMENT
+
+  void *allocate(unsigned Slot, size_t Size);
+  void deallocate(unsigned Slot, void *Ptr);
+
+public:
+  AttributeListPool();
+  ~AttributeListPool();
+
+  /// AllocateAttr - Allocate memory for an AttributeList of Size bytes,
+  /// preceded by a pointer back to this pool.
+  void *AllocateAttr(size_t Size);
+  void DeallocateAttr(void *Ptr) {
+    deallocate(0, static_cast<AttributeListPool **>(Ptr) - 1);
+  }
+
+  /// AllocateArgs - Allocate an array of NumArgs argument expressions.
+  ActionBase::ExprTy **AllocateArgs(unsigned NumArgs);
+  void DeallocateArgs(ActionBase::ExprTy **Args, unsigned NumArgs);
+
+  void PrintStats() const;
+};
+
 /// AttributeList - Represents GCC's __attribute__ declaration. There are
 /// 4 forms of this construct...they are:
 ///
@@ -43,7 +85,27 @@ class AttributeList {
   bool DeclspecAttribute, CXX0XAttribute;
   AttributeList(const AttributeList &); // DO NOT IMPLEMENT
   void operator=(const AttributeList &); // DO NOT IMPLEMENT
+
+  /// getPool - Return the pool this attribute was allocated from, which
+  /// operator new stored in front of it.
+  AttributeListPool &getPool() const {
+    return *reinterpret_cast<AttributeListPool *const *>(this)[-1];
+  }
+
 public:
+  /// Every AttributeList is allocated from the pool of its parser, and
+  /// deleting it returns its memory, and that of its arguments, to the pool.
+  void *operator new(size_t Size, AttributeListPool &Pool) {
+    return Pool.AllocateAttr(Size);
+  }
+  void operator delete(void *Ptr, AttributeListPool &Pool) {
+    Pool.DeallocateAttr(Ptr);
+  }
+  void operator delete(void *Ptr) {
+    if (Ptr)
+      (reinterpret_cast<AttributeListPool **>(Ptr)[-1])->DeallocateAttr(Ptr);
+  }
+
   AttributeList(IdentifierInfo *AttrName, SourceLocation AttrLoc,
                 IdentifierInfo *ScopeName, SourceLocation ScopeLoc,
                 IdentifierInfo *ParmName, SourceLocation ParmLoc,
@@ -18,6 +18,8 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Parse/Action.h"
 #include "clang/Parse/DeclSpec.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/OwningPtr.h"
 #include <stack>
 #include <list>
@@ -78,6 +80,10 @@ class Parser {
   unsigned NumCachedScopes;
   Scope *ScopeCache[ScopeCacheSize];
 
+  /// AttrPool - Recycles the attribute lists of the declarations once the
+  /// declarations have been handed to the actions.
+  AttributeListPool AttrPool;
+
   /// Ident_super - IdentifierInfo for "super", to support fast
   /// comparison.
   IdentifierInfo *Ident_super;
@@ -107,15 +113,52 @@ class Parser {
   /// The "depth" of the template parameters currently being parsed.
   unsigned TemplateParameterDepth;
 
+  /// SkipFunctionBodies - When this is true, the bodies of function
+  /// definitions are skipped by matching braces instead of being parsed.
+  bool SkipFunctionBodies;
+
+  /// CacheSkippedFunctionBodies - When this is true, the tokens of skipped
+  /// function bodies are kept in SkippedBodyTokens, so that the bodies can be
+  /// parsed later by ParseSkippedFunctionBody.
+  bool CacheSkippedFunctionBodies;
+  llvm::DenseMap<void *, CachedTokens *> SkippedBodyTokens;
+
+  /// NonTypeName - An identifier, the scope it was looked up in and the
+  /// nested-name-specifier it was qualified with, if any.
+  typedef std::pair<std::pair<IdentifierInfo *, Scope *>, void *> NonTypeName;
+
+  /// NonTypeNames - The names TryAnnotateTypeOrScopeToken found not to be
+  /// types, so that backtracking over them does not repeat the lookup.  The
+  /// set is emptied when NonTypeNamesGeneration no longer matches the
+  /// actions' name lookup generation, and whenever a scope is exited, since
+  /// the Scope object may be reused for another scope.
+  llvm::DenseSet<NonTypeName> NonTypeNames;
+  unsigned NonTypeNamesGeneration;
+
+  /// isKnownNonTypeName - Return true if getTypeName() already returned NULL
+  /// for this name, and no declaration has become visible since.
+  bool isKnownNonTypeName(const NonTypeName &Name);
+
 public:
-  Parser(Preprocessor &PP, Action &Actions);
+  Parser(Preprocessor &PP, Action &Actions, bool SkipFunctionBodies = false);
   ~Parser();
 
+  void setCacheSkippedFunctionBodies(bool Cache) {
+    CacheSkippedFunctionBodies = Cache;
+  }
+
+  /// ignoreComments - Stop passing comments to the action, for clients that
+  /// will never look at them.
+  void ignoreComments();
+
   const LangOptions &getLang() const { return PP.getLangOptions(); }
   const TargetInfo &getTargetInfo() const { return PP.getTargetInfo(); }
   Preprocessor &getPreprocessor() const { return PP; }
   Action &getActions() const { return Actions; }
 
+  /// PrintStats - Print statistics about the parser to stderr.
+  void PrintStats() const;
+
   const Token &getCurToken() const { return Tok; }
 
   // Type forwarding.  All of these are statically 'void*', but they may all be
@@ -179,6 +222,19 @@ public:
 
   DeclGroupPtrTy RetrievePendingObjCImpDecl();
 
+  /// ParseSkippedFunctionBody - Parse the body of the given function
+  /// definition, which was skipped and cached, now that the translation unit
+  /// has been parsed.  Returns true if there is no body to parse.
+  bool ParseSkippedFunctionBody(DeclPtrTy Decl);
+
+  /// ReplaceSkippedFunctionBody - Lex the given file, which holds nothing but
+  /// a new body for the given function definition, and cache its tokens as
+  /// the skipped body of the function.  On success, returns false and the
+  /// range of the braces of the new body in BodyRange; returns true if the
+  /// file is not a single compound statement.
+  bool ReplaceSkippedFunctionBody(DeclPtrTy Decl, FileID BodyFile,
+                                  SourceRange &BodyRange);
+
 private:
   //===--------------------------------------------------------------------===//
   // Low-Level token peeking and consumption methods.
@@ -1252,6 +1308,19 @@ private:
     return isCXXTypeId(Context, isAmbiguous);
   }
 
+  /// TentativeParseKind - The disambiguation queries whose tentative parses
+  /// are memoized by the preprocessor, see Preprocessor::LookupDisambiguation.
+  /// Nested declarators make TryParseDeclarator run isCXXFunctionDeclarator
+  /// for the same '(' during every enclosing tentative parse, and once more
+  /// when the declarator is really parsed.
+  enum TentativeParseKind {
+    TPK_SimpleDeclaration,
+    TPK_ConditionDeclaration,
+    TPK_TypeIdInParens,
+    TPK_TypeIdAsTemplateArgument,
+    TPK_FunctionDeclarator
+  };
+
   /// TPResult - Used as the result value for functions whose purpose is to
   /// disambiguate C++ constructs by "tentatively parsing" them.
   /// This is a class instead of a simple enum because the implicit enum-to-bool
@@ -17,12 +17,14 @@
 
 #include "clang/Basic/SourceLocation.h"
 #include <string>
+#include <vector>
 
 namespace clang {
 
 class Rewriter;
 class RewriteBuffer;
 class Preprocessor;
+class Token;
 
 namespace html {
 
@@ -75,6 +77,42 @@ namespace html {
   /// reasonably close.
   void HighlightMacros(Rewriter &R, FileID FID, const Preprocessor &PP);
 
+  /// Highlight - A range of file offsets to enclose in a pair of tags.
+  struct Highlight {
+    unsigned Begin, End;
+    const char *StartTag;
+    std::string EndTag;
+  };
+
+  /// LexRawTokens - Lex the specified FileID in raw mode, keeping comments,
+  /// into \arg Tokens, which ends with the eof token.  The same tokens can be
+  /// given to FindSyntaxHighlights and FindMacroHighlights, rather than each
+  /// of them lexing the file.
+  void LexRawTokens(FileID FID, const Preprocessor &PP,
+                    std::vector<Token> &Tokens);
+
+  /// FindSyntaxHighlights - Append the highlights that SyntaxHighlight would
+  /// insert to \arg Highlights.  They can then be applied to any number of
+  /// rewrites of the file without relexing it.
+  void FindSyntaxHighlights(FileID FID, const Preprocessor &PP,
+                            std::vector<Highlight> &Highlights);
+  void FindSyntaxHighlights(FileID FID, const Preprocessor &PP,
+                            const std::vector<Token> &RawTokens,
+                            std::vector<Highlight> &Highlights);
+
+  /// FindMacroHighlights - Append the highlights that HighlightMacros would
+  /// insert to \arg Highlights.  This is the costly part of highlighting a
+  /// file, as it preprocesses the file again.
+  void FindMacroHighlights(FileID FID, const Preprocessor &PP,
+                           std::vector<Highlight> &Highlights);
+  void FindMacroHighlights(FileID FID, const Preprocessor &PP,
+                           const std::vector<Token> &RawTokens,
+                           std::vector<Highlight> &Highlights);
+
+  /// ApplyHighlights - Insert the tags of \arg Highlights, in order.
+  void ApplyHighlights(Rewriter &R, FileID FID,
+                       const std::vector<Highlight> &Highlights);
+
 } // end html namespace
 } // end clang namespace
 
@@ -47,11 +47,59 @@ class RewriteBuffer {
   /// instead.
   typedef RewriteRope BufferTy;
   BufferTy Buffer;
+
+  /// PendingEdit - An edit made in batch mode whose text has not been applied
+  /// to Buffer yet.  The deltas of an edit are recorded when it is made, so
+  /// offsets are mapped the same way whether or not it has been applied.
+  struct PendingEdit {
+    enum EditKind { InsertBefore, InsertAfter, Replace };
+
+    EditKind Kind;
+
+    /// OrigOffset - The offset of the edit in the original SourceBuffer.
+    unsigned OrigOffset;
+
+    /// RealOffset - The offset of the edit in the RewriteBuffer, once the
+    /// edits made before it have been applied.
+    unsigned RealOffset;
+
+    /// RemoveLength - The number of characters that a Replace removes.
+    unsigned RemoveLength;
+
+    /// Text - The text inserted by the edit.
+    std::string Text;
+  };
+  std::vector<PendingEdit> PendingEdits;
+
+  /// PendingSizeChange - The change in size of Buffer once the pending edits
+  /// are applied.
+  int PendingSizeChange;
+
+  /// BatchEdits - Whether the text of edits is applied lazily.
+  bool BatchEdits;
+
 public:
+  RewriteBuffer() : PendingSizeChange(0), BatchEdits(false) {}
+
   typedef BufferTy::const_iterator iterator;
-  iterator begin() const { return Buffer.begin(); }
-  iterator end() const { return Buffer.end(); }
-  unsigned size() const { return Buffer.size(); }
+  iterator begin() const {
+    const_cast<RewriteBuffer*>(this)->CommitPendingEdits();
+    return Buffer.begin();
+  }
+  iterator end() const {
+    const_cast<RewriteBuffer*>(this)->CommitPendingEdits();
+    return Buffer.end();
+  }
+  unsigned size() const { return Buffer.size() + PendingSizeChange; }
+
+  /// setBatchEdits - In batch mode, the text of the edits made to the buffer
+  /// is not applied to it until its contents are next read.  The edits made
+  /// in between are then applied in a single pass over the buffer, instead of
+  /// with a rope operation each.
+  void setBatchEdits(bool Batch);
+
+  /// CommitPendingEdits - Apply the text of the edits made in batch mode.
+  void CommitPendingEdits();
 
   /// RemoveText - Remove the specified text.
   void RemoveText(unsigned OrigOffset, unsigned Size);
@@ -87,6 +135,16 @@ public:
 
 private:  // Methods only usable by Rewriter.
 
+  void AddPendingEdit(PendingEdit::EditKind Kind, unsigned OrigOffset,
+                      unsigned RealOffset, unsigned RemoveLength,
+                      const llvm::StringRef &Str);
+
+  /// RebuildWithPendingEdits - Apply all of the pending edits by copying the
+  /// buffer once.  Returns false, leaving the buffer alone, if an edit
+  /// overlaps the text removed by another, which only applying the edits in
+  /// order gets right.
+  bool RebuildWithPendingEdits();
+
   /// Initialize - Start this rewrite buffer out with a copy of the unmodified
   /// input buffer.
   void Initialize(const char *BufStart, const char *BufEnd) {
@@ -124,10 +182,11 @@ class Rewriter {
   SourceManager *SourceMgr;
   const LangOptions *LangOpts;
   std::map<FileID, RewriteBuffer> RewriteBuffers;
+  bool BatchEdits;
 public:
   explicit Rewriter(SourceManager &SM, const LangOptions &LO)
-    : SourceMgr(&SM), LangOpts(&LO) {}
-  explicit Rewriter() : SourceMgr(0), LangOpts(0) {}
+    : SourceMgr(&SM), LangOpts(&LO), BatchEdits(false) {}
+  explicit Rewriter() : SourceMgr(0), LangOpts(0), BatchEdits(false) {}
 
   void setSourceMgr(SourceManager &SM, const LangOptions &LO) {
     SourceMgr = &SM;
@@ -136,6 +195,13 @@ public:
   SourceManager &getSourceMgr() { return *SourceMgr; }
   const LangOptions &getLangOpts() { return *LangOpts; }
 
+  /// setBatchEdits - Put the rewrite buffers in batch mode, where the text of
+  /// their edits is applied when the rewritten text is next needed, all at
+  /// once.  This pays off for clients that make many edits between reading
+  /// the rewritten text; locations are mapped and ranges measured without
+  /// applying the edits.
+  void setBatchEdits(bool Batch);
+
   /// isRewritable - Return true if this location is a raw file location, which
   /// is rewritable.  Locations from macros, etc are not rewritable.
   static bool isRewritable(SourceLocation Loc) {
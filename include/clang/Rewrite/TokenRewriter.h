@@ -16,28 +16,29 @@
 #define LLVM_CLANG_TOKENREWRITER_H
 
 #include "clang/Basic/SourceLocation.h"
+#include "clang/Lex/Token.h"
 #include "llvm/ADT/OwningPtr.h"
-#include <list>
-#include <map>
+#include <iterator>
+#include <vector>
 
 namespace clang {
-  class Token;
   class LangOptions;
   class ScratchBuffer;
 
   class TokenRewriter {
-    /// TokenList - This is the list of raw tokens that make up this file.  Each
-    /// of these tokens has a unique SourceLocation, which is a FileID.
-    std::list<Token> TokenList;
-
-    /// TokenRefTy - This is the type used to refer to a token in the TokenList.
-    typedef std::list<Token>::iterator TokenRefTy;
-
-    /// TokenAtLoc - This map indicates which token exists at a specific
-    /// SourceLocation.  Since each token has a unique SourceLocation, this is a
-    /// one to one map.  The token can return its own location directly, to map
-    /// backwards.
-    std::map<SourceLocation, TokenRefTy> TokenAtLoc;
+    /// TokenEntry - A token of the file, linked to its neighbors.  Entries are
+    /// only ever appended to Entries, so the index of a token never changes,
+    /// and the tokens of an unedited file are stored and visited in order.
+    struct TokenEntry {
+      Token Tok;
+      unsigned Prev, Next;
+    };
+
+    /// Entries - The tokens that make up this file, followed by the tokens
+    /// added to it.  Entry 0 is a sentinel standing for the end of the file;
+    /// its Next is the first token and its Prev the last one.  Each of the
+    /// raw tokens has a unique SourceLocation, which is a FileID.
+    std::vector<TokenEntry> Entries;
 
     /// ScratchBuf - This is the buffer that we create scratch tokens from.
     ///
@@ -51,9 +52,56 @@ namespace clang {
     TokenRewriter(FileID FID, SourceManager &SM, const LangOptions &LO);
     ~TokenRewriter();
 
-    typedef std::list<Token>::const_iterator token_iterator;
-    token_iterator token_begin() const { return TokenList.begin(); }
-    token_iterator token_end() const { return TokenList.end(); }
+    class token_iterator;
+    friend class token_iterator;
+
+    /// token_iterator - Refers to a token by its index in Entries, so it
+    /// stays valid as other tokens are added.
+    class token_iterator
+      : public std::iterator<std::bidirectional_iterator_tag, const Token> {
+      const TokenRewriter *Rewriter;
+      unsigned Idx;
+
+      friend class TokenRewriter;
+      token_iterator(const TokenRewriter *R, unsigned I)
+        : Rewriter(R), Idx(I) {}
+    public:
+      token_iterator() : Rewriter(0), Idx(0) {}
+
+      const Token &operator*() const { return Rewriter->Entries[Idx].Tok; }
+      const Token *operator->() const { return &Rewriter->Entries[Idx].Tok; }
+
+      token_iterator &operator++() {
+        Idx = Rewriter->Entries[Idx].Next;
+        return *this;
+      }
+      token_iterator operator++(int) {
+        token_iterator Tmp = *this;
+        ++*this;
+        return Tmp;
+      }
+      token_iterator &operator--() {
+        Idx = Rewriter->Entries[Idx].Prev;
+        return *this;
+      }
+      token_iterator operator--(int) {
+        token_iterator Tmp = *this;
+        --*this;
+        return Tmp;
+      }
+
+      bool operator==(const token_iterator &RHS) const {
+        return Idx == RHS.Idx;
+      }
+      bool operator!=(const token_iterator &RHS) const {
+        return Idx != RHS.Idx;
+      }
+    };
+
+    token_iterator token_begin() const {
+      return token_iterator(this, Entries[0].Next);
+    }
+    token_iterator token_end() const { return token_iterator(this, 0); }
 
 
     token_iterator AddTokenBefore(token_iterator I, const char *Val);
@@ -63,13 +111,9 @@ namespace clang {
     }
 
   private:
-    /// RemapIterator - Convert from token_iterator (a const iterator) to
-    /// TokenRefTy (a non-const iterator).
-    TokenRefTy RemapIterator(token_iterator I);
-
-    /// AddToken - Add the specified token into the Rewriter before the other
-    /// position.
-    TokenRefTy AddToken(const Token &T, TokenRefTy Where);
+    /// AddToken - Add the specified token into the Rewriter before the entry
+    /// with index Where, and return its index.
+    unsigned AddToken(const Token &T, unsigned Where);
   };
 
 
@@ -17,6 +17,7 @@
 #include "llvm/ADT/StringRef.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace llvm {
 class raw_ostream;
@@ -249,8 +250,36 @@ protected:
   /// \brief Whether the output format for the code-completion consumer is
   /// binary.
   bool OutputIsBinary;
+
+  /// \brief If non-empty, the path, without the suffix for the completion
+  /// context, of the files that the results for the global declarations of
+  /// the PCH file are cached in.
+  std::string GlobalResultsCachePath;
+
+  /// \brief Identifies the PCH file that the cached results belong to.
+  std::string GlobalResultsCacheKey;
+
+  /// \brief If non-empty, the text typed so far; only the results whose
+  /// names start with it, ignoring case, are produced.
+  std::string FilterPrefix;
+
+  /// \brief The maximum number of results to produce, keeping the most
+  /// relevant ones, or zero if there is no limit.
+  unsigned MaxResults;
   
 public:
+  /// \brief Describes who provides the results for the global declarations of
+  /// the PCH file.
+  enum GlobalResultsCacheState {
+    /// \brief Sema provides the results itself.
+    GRC_None,
+    /// \brief The consumer has the results cached, so Sema leaves them out.
+    GRC_Cached,
+    /// \brief The consumer caches the results but does not have them yet.
+    /// Sema leaves them out and hands them to CacheGlobalResults() instead.
+    GRC_Missing
+  };
+
   /// \brief Captures a result of code completion.
   struct Result {
     /// \brief Describes the kind of result generated.
@@ -418,22 +447,63 @@ public:
                                                 Sema &S) const;    
   };
   
-  CodeCompleteConsumer() : IncludeMacros(false), OutputIsBinary(false) { }
+  CodeCompleteConsumer()
+    : IncludeMacros(false), OutputIsBinary(false), MaxResults(0) { }
   
   CodeCompleteConsumer(bool IncludeMacros, bool OutputIsBinary)
-    : IncludeMacros(IncludeMacros), OutputIsBinary(OutputIsBinary) { }
+    : IncludeMacros(IncludeMacros), OutputIsBinary(OutputIsBinary),
+      MaxResults(0) { }
   
   /// \brief Whether the code-completion consumer wants to see macros.
   bool includeMacros() const { return IncludeMacros; }
 
   /// \brief Determine whether the output of this consumer is binary.
   bool isOutputBinary() const { return OutputIsBinary; }
+
+  /// \brief Cache the results for the global declarations of the PCH file in
+  /// the files whose names start with \p Path.  \p Key identifies the PCH
+  /// file.  Consumers that do not support caching ignore it.
+  void setGlobalResultsCache(llvm::StringRef Path, llvm::StringRef Key) {
+    GlobalResultsCachePath = Path;
+    GlobalResultsCacheKey = Key;
+  }
   
+  /// \brief Only produce the results whose names start with \p Prefix, and
+  /// at most \p MaxResults of them if it is nonzero.
+  void setResultFilter(llvm::StringRef Prefix, unsigned MaxResults) {
+    FilterPrefix = Prefix;
+    this->MaxResults = MaxResults;
+  }
+
+  /// \brief Retrieve the text that the names of results must start with.
+  llvm::StringRef getFilterPrefix() const { return FilterPrefix; }
+
+  /// \brief Retrieve the maximum number of results, or zero.
+  unsigned getMaxResults() const { return MaxResults; }
+
+  /// \brief Determine whether \p Name starts with the filter prefix,
+  /// ignoring case.
+  bool matchesFilterPrefix(llvm::StringRef Name) const {
+    return Name.size() >= FilterPrefix.size() &&
+      Name.substr(0, FilterPrefix.size()).equals_lower(FilterPrefix);
+  }
+
   /// \brief Deregisters and destroys this code-completion consumer.
   virtual ~CodeCompleteConsumer();
 
   /// \name Code-completion callbacks
   //@{
+  /// \brief Determine who provides the results for the global declarations of
+  /// the PCH file, when completing ordinary names in the given
+  /// Action::CodeCompletionContext.
+  virtual GlobalResultsCacheState
+  getGlobalResultsCacheState(unsigned CompletionContext) { return GRC_None; }
+
+  /// \brief Cache the results for the global declarations of the PCH file,
+  /// after getGlobalResultsCacheState() returned GRC_Missing.
+  virtual void CacheGlobalResults(Sema &S, Result *Results,
+                                  unsigned NumResults) { }
+
   /// \brief Process the finalized code-completion results.
   virtual void ProcessCodeCompleteResults(Sema &S, Result *Results,
                                           unsigned NumResults) { }
@@ -479,6 +549,29 @@ public:
 class CIndexCodeCompleteConsumer : public CodeCompleteConsumer {
   /// \brief The raw output stream.
   llvm::raw_ostream &OS;
+
+  /// \brief A cached result for a global declaration of the PCH file.
+  struct CachedResult {
+    /// \brief The name of the declaration.
+    std::string Name;
+
+    /// \brief The CXCursorKind that describes the declaration.
+    unsigned CursorKind;
+
+    /// \brief The serialized code-completion string.
+    std::string Completion;
+  };
+
+  /// \brief The results for the global declarations of the PCH file in the
+  /// current completion context, printed after the other results.
+  std::vector<CachedResult> CachedGlobalResults;
+
+  /// \brief The file the results in CachedGlobalResults are cached in.
+  std::string GlobalResultsCacheFile;
+
+  /// \brief Write CachedGlobalResults to GlobalResultsCacheFile.  Returns
+  /// true on failure.
+  bool WriteGlobalResultsCache() const;
   
 public:
   /// \brief Create a new CIndex code-completion consumer that prints its
@@ -486,6 +579,12 @@ public:
   /// library.
   CIndexCodeCompleteConsumer(bool IncludeMacros, llvm::raw_ostream &OS)
     : CodeCompleteConsumer(IncludeMacros, true), OS(OS) { }
+
+  virtual GlobalResultsCacheState
+  getGlobalResultsCacheState(unsigned CompletionContext);
+
+  virtual void CacheGlobalResults(Sema &S, Result *Results,
+                                  unsigned NumResults);
   
   /// \brief Prints the finalized code-completion results.
   virtual void ProcessCodeCompleteResults(Sema &S, Result *Results, 
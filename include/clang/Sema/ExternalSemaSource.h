@@ -37,16 +37,28 @@ public:
   /// \brief Inform the semantic consumer that Sema is no longer available.
   virtual void ForgetSema() {}
 
-  /// \brief Load the contents of the global method pool for a given
-  /// selector.
+  /// \brief Load the instance or the factory methods of the global method
+  /// pool for a given selector.
   ///
-  /// \returns a pair of Objective-C methods lists containing the
-  /// instance and factory methods, respectively, with this selector.
-  virtual std::pair<ObjCMethodList, ObjCMethodList>
-  ReadMethodPool(Selector Sel) {
-    return std::pair<ObjCMethodList, ObjCMethodList>();
+  /// The two lists are loaded separately, so that looking up the instance
+  /// methods with a selector does not deserialize its factory methods, and
+  /// conversely.
+  ///
+  /// \returns the list of instance methods, if \p isInstance, or factory
+  /// methods with this selector.
+  virtual ObjCMethodList ReadMethodPool(Selector Sel, bool isInstance) {
+    return ObjCMethodList();
   }
 
+  /// \brief Load all of the identifiers of the source, along with the
+  /// declarations and macros attached to them, and return all of its
+  /// selectors.
+  ///
+  /// This is used before a precompiled header is written on top of the
+  /// source, since only what has been loaded is serialized again.
+  virtual void ReadAllIdentifiersAndSelectors(
+                                   llvm::SmallVectorImpl<Selector> &Sels) {}
+
   // isa/cast/dyn_cast support
   static bool classof(const ExternalASTSource *Source) {
     return Source->SemaSource;
@@ -0,0 +1,144 @@
+//===--- InstantiationProfile.h - Instantiation costs -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the InstantiationProfile and InstantiationProfileRegion
+//  interfaces.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_INSTANTIATIONPROFILE_H
+#define LLVM_CLANG_SEMA_INSTANTIATIONPROFILE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+
+class NamedDecl;
+
+/// \brief Measures how often each template pattern is instantiated and how
+/// much time goes into it, to find the templates that make a translation unit
+/// slow to compile.
+///
+/// Time is charged to the pattern being worked on: the class, function or
+/// variable template for an instantiation, or the function template or
+/// partial specialization for template argument deduction.  The inclusive
+/// time of an entry covers everything done on its behalf, including any
+/// instantiations it triggered; the exclusive time leaves out the time of the
+/// nested entries.  Recursive instantiations of the same pattern are only
+/// counted once in its inclusive time.
+///
+/// At most one InstantiationProfile object is active at a time.  Instrumented
+/// code checks getActive() first, so a compilation that does not ask for a
+/// profile only pays for a load and a branch at each instrumented point.
+class InstantiationProfile {
+public:
+  /// \brief The kind of work an entry measures.
+  enum Activity {
+    Instantiation,
+    Deduction,
+    PendingInstantiations
+  };
+
+private:
+  static InstantiationProfile *Active;
+
+  /// \brief The total cost of one activity on one pattern.
+  struct Entry {
+    Activity Kind;
+    std::string Name;
+    unsigned Count;
+    double Inclusive, Exclusive;
+
+    /// \brief The number of activations of this entry that are running.
+    unsigned Depth;
+  };
+
+  /// \brief A running entry, when it started and the time spent so far in
+  /// the entries nested within it.
+  struct Activation {
+    unsigned Index;
+    double Start, ChildTime;
+  };
+
+  /// \brief One finished activation, recorded for the trace file.
+  struct TraceEvent {
+    unsigned Index;
+    double Start, Duration;
+  };
+
+  std::vector<Entry> Entries;
+  llvm::DenseMap<std::pair<unsigned, const NamedDecl *>, unsigned> EntryMap;
+  std::vector<Activation> Running;
+
+  bool RecordTrace;
+  double TraceStart;
+  std::vector<TraceEvent> Trace;
+
+  InstantiationProfile(const InstantiationProfile&); // DO NOT IMPLEMENT
+  void operator=(const InstantiationProfile&);       // DO NOT IMPLEMENT
+public:
+  /// \brief Create a profile.  If \p RecordTrace is true, every activation is
+  /// kept so it can be written out by WriteTrace().
+  explicit InstantiationProfile(bool RecordTrace);
+  ~InstantiationProfile();
+
+  /// \brief Return the profile that instrumented code reports to, or null if
+  /// profiling is disabled.
+  static InstantiationProfile *getActive() { return Active; }
+
+  /// \brief Make \p Profile the one instrumented code reports to.  Pass null
+  /// to disable profiling.
+  static void setActive(InstantiationProfile *Profile) { Active = Profile; }
+
+  /// \brief Start \p Kind on \p Pattern, nested within the innermost running
+  /// entry.  \p Pattern may be null for work that has no single pattern.
+  void enter(Activity Kind, const NamedDecl *Pattern);
+
+  /// \brief Stop the innermost running entry.
+  void exit();
+
+  /// \brief Write the cost of each pattern to \p OS, most expensive first.
+  void WriteReport(llvm::raw_ostream &OS) const;
+
+  /// \brief Write every activation to \p OS in the trace event format read
+  /// by chrome://tracing.
+  void WriteTrace(llvm::raw_ostream &OS) const;
+};
+
+/// \brief Charges the time the object lives to a template pattern, if
+/// instantiation profiling is enabled.
+class InstantiationProfileRegion {
+  InstantiationProfile *Profile;
+
+  InstantiationProfileRegion(
+                      const InstantiationProfileRegion&); // DO NOT IMPLEMENT
+  void operator=(const InstantiationProfileRegion&); // DO NOT IMPLEMENT
+public:
+  InstantiationProfileRegion(InstantiationProfile::Activity Kind,
+                             const NamedDecl *Pattern)
+    : Profile(InstantiationProfile::getActive()) {
+    if (Profile)
+      Profile->enter(Kind, Pattern);
+  }
+
+  ~InstantiationProfileRegion() {
+    if (Profile)
+      Profile->exit();
+  }
+};
+
+} // end namespace clang
+
+#endif
@@ -14,13 +14,40 @@
 #ifndef LLVM_CLANG_SEMA_PARSEAST_H
 #define LLVM_CLANG_SEMA_PARSEAST_H
 
+#include "clang/Basic/SourceLocation.h"
+
 namespace clang {
   class Preprocessor;
   class ASTConsumer;
   class ASTContext;
   class CodeCompleteConsumer;
+  class FunctionDecl;
   class Sema;
 
+  /// \brief The parser and semantic analyzer of a translation unit parsed
+  /// with SkipFunctionBodies, kept alive so that the skipped bodies can be
+  /// parsed on demand.
+  ///
+  /// The preprocessor, AST context and consumer of the translation unit must
+  /// outlive this object.
+  class SkippedBodyParser {
+  public:
+    virtual ~SkippedBodyParser();
+
+    /// \brief Parse the skipped body of \p FD, in the scope of the complete
+    /// translation unit.  Does nothing if the body of \p FD was not skipped,
+    /// or cannot be parsed on its own, such as the body of a template.
+    virtual void ParseBody(FunctionDecl *FD) = 0;
+
+    /// \brief Make the file \p BodyFile, which holds nothing but a compound
+    /// statement, the skipped body of \p FD in place of its current body,
+    /// whether that was parsed or not.
+    ///
+    /// \returns true if \p FD cannot take a new body or \p BodyFile is not
+    /// a single compound statement, in which case \p FD is left as it was.
+    virtual bool ReplaceBody(FunctionDecl *FD, FileID BodyFile) = 0;
+  };
+
   /// \brief Parse the entire file specified, notifying the ASTConsumer as
   /// the file is parsed.
   ///
@@ -33,10 +60,23 @@ namespace clang {
   ///
   /// \param CompletionConsumer If given, an object to consume code completion
   /// results.
+  ///
+  /// \param SkipFunctionBodies When true, the bodies of function definitions
+  /// are skipped instead of parsed; only declarations are built.
+  ///
+  /// \param BodyParser If given along with SkipFunctionBodies, the tokens of
+  /// the skipped bodies are kept and this receives a new object, owned by the
+  /// caller, which can parse them later.
+  ///
+  /// \param RecordComments When false, comments are not recorded in the
+  /// ASTContext.
   void ParseAST(Preprocessor &pp, ASTConsumer *C,
                 ASTContext &Ctx, bool PrintStats = false,
                 bool CompleteTranslationUnit = true,
-                CodeCompleteConsumer *CompletionConsumer = 0);
+                CodeCompleteConsumer *CompletionConsumer = 0,
+                bool SkipFunctionBodies = false,
+                SkippedBodyParser **BodyParser = 0,
+                bool RecordComments = true);
 
 }  // end namespace clang
 
@@ -27,6 +27,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Atomic.h"
 #include "RecordLayoutBuilder.h"
 
 using namespace clang;
@@ -35,6 +36,9 @@ enum FloatingRank {
   FloatRank, DoubleRank, LongDoubleRank
 };
 
+/// \brief The unique ID of the last ASTContext created.
+static volatile llvm::sys::cas_flag LastASTContextID = 0;
+
 ASTContext::ASTContext(const LangOptions& LOpts, SourceManager &SM,
                        const TargetInfo &t,
                        IdentifierTable &idents, SelectorTable &sels,
@@ -44,13 +48,22 @@ ASTContext::ASTContext(const LangOptions& LOpts, SourceManager &SM,
   ObjCFastEnumerationStateTypeDecl(0), FILEDecl(0), jmp_bufDecl(0),
   sigjmp_bufDecl(0), BlockDescriptorType(0), BlockDescriptorExtendedType(0),
   SourceMgr(SM), LangOpts(LOpts),
-  LoadedExternalComments(false), FreeMemory(FreeMem), Target(t),
+  LoadedExternalComments(false), FreeMemory(FreeMem),
+  ReleaseFunctionBodies(false), StmtAlloc(0), NumReleasedFunctionBodies(0),
+  NumReleasedFunctionBodyBytes(0),
+  UniqueID(llvm::sys::AtomicIncrement(&LastASTContextID)), Target(t),
   Idents(idents), Selectors(sels),
-  BuiltinInfo(builtins), ExternalSource(0), PrintingPolicy(LOpts) {
+  BuiltinInfo(builtins), ExternalSource(0), ImplicitMembers(0),
+  PrintingPolicy(LOpts) {
   ObjCIdRedefinitionType = QualType();
   ObjCClassRedefinitionType = QualType();
   ObjCSelRedefinitionType = QualType();
   if (size_reserve > 0) Types.reserve(size_reserve);
+  LookupGeneration = RecordLookupGeneration = NamespaceLookupGeneration = 0;
+  ObjCLookupGeneration = ObjCLookupsGeneration = 0;
+  NumObjCLookups = NumCachedObjCLookups = 0;
+  NumTypeInfoQueries = NumCachedTypeInfoQueries = 0;
+  NumElidedTypeSourceInfos = 0;
   TUDecl = TranslationUnitDecl::Create(*this);
   InitBuiltinTypes();
 }
@@ -102,6 +115,12 @@ ASTContext::~ASTContext() {
     GlobalNestedNameSpecifier->Destroy(*this);
 
   TUDecl->Destroy(*this);
+
+  for (llvm::DenseMap<const FunctionDecl *, llvm::BumpPtrAllocator *>::iterator
+       I = FunctionBodyAllocs.begin(), E = FunctionBodyAllocs.end();
+       I != E; ++I)
+    delete I->second;
+  delete StmtAlloc;
 }
 
 void
@@ -136,6 +155,19 @@ void ASTContext::PrintStats() const {
 #include "clang/AST/TypeNodes.def"
 
   fprintf(stderr, "Total bytes = %d\n", int(TotalBytes));
+  fprintf(stderr, "%u type size queries, %u answered from the cache.\n",
+          NumTypeInfoQueries, NumCachedTypeInfoQueries);
+  fprintf(stderr, "%u Objective-C lookups, %u answered from the cache.\n",
+          NumObjCLookups, NumCachedObjCLookups);
+  DeclarationNames.PrintStats();
+  if (LangOpts.ElideTypeLocs)
+    fprintf(stderr, "%u declarations with elided type locations, sharing %u "
+            "type source infos.\n", NumElidedTypeSourceInfos,
+            ElidedTypeSourceInfos.size());
+  if (ReleaseFunctionBodies)
+    fprintf(stderr, "%u function bodies released (%llu bytes).\n",
+            NumReleasedFunctionBodies,
+            (unsigned long long)NumReleasedFunctionBodyBytes);
 
   if (ExternalSource.get()) {
     fprintf(stderr, "\n");
@@ -144,6 +176,49 @@ void ASTContext::PrintStats() const {
 }
 
 
+void ASTContext::StartFunctionBody() {
+  // A body that was not attached to a function keeps its allocator, and the
+  // next body shares it.
+  if (ReleaseFunctionBodies && !StmtAlloc)
+    StmtAlloc = new llvm::BumpPtrAllocator;
+}
+
+void ASTContext::FinishFunctionBody(const FunctionDecl *FD) {
+  if (!StmtAlloc || !FD)
+    return;
+
+  // A function whose body is parsed again no longer refers to the
+  // statements of the old one.
+  llvm::BumpPtrAllocator *&Alloc = FunctionBodyAllocs[FD];
+  delete Alloc;
+  Alloc = StmtAlloc;
+  StmtAlloc = 0;
+}
+
+void ASTContext::ReleaseFunctionBody(FunctionDecl *FD) {
+  llvm::DenseMap<const FunctionDecl *, llvm::BumpPtrAllocator *>::iterator
+    Pos = FunctionBodyAllocs.find(FD);
+  if (Pos == FunctionBodyAllocs.end())
+    return;
+
+  // Leave an empty body behind, allocated for the lifetime of the context, so
+  // that the function is still a definition.
+  SourceLocation LBraceLoc, RBraceLoc;
+  if (Stmt *Body = FD->getBody()) {
+    LBraceLoc = Body->getLocStart();
+    RBraceLoc = Body->getLocEnd();
+  }
+  llvm::BumpPtrAllocator *CurStmtAlloc = StmtAlloc;
+  StmtAlloc = 0;
+  FD->setBody(new (*this) CompoundStmt(*this, 0, 0, LBraceLoc, RBraceLoc));
+  StmtAlloc = CurStmtAlloc;
+
+  ++NumReleasedFunctionBodies;
+  NumReleasedFunctionBodyBytes += Pos->second->getTotalMemory();
+  delete Pos->second;
+  FunctionBodyAllocs.erase(Pos);
+}
+
 void ASTContext::InitBuiltinType(CanQualType &R, BuiltinType::Kind K) {
   BuiltinType *Ty = new (*this, TypeAlignment) BuiltinType(K);
   R = CanQualType::CreateUnsafe(QualType(Ty, 0));
@@ -319,6 +394,33 @@ void ASTContext::setInstantiatedFromUnnamedFieldDecl(FieldDecl *Inst,
   InstantiatedFromUnnamedFieldDecl[Inst] = Tmpl;
 }
 
+ASTContext::overridden_cxx_method_iterator
+ASTContext::overridden_methods_begin(const CXXMethodDecl *Method) {
+  llvm::DenseMap<const CXXMethodDecl *,
+                 std::vector<const CXXMethodDecl *> >::iterator Pos
+    = OverriddenMethods.find(Method);
+  if (Pos == OverriddenMethods.end() || Pos->second.empty())
+    return 0;
+
+  return &Pos->second[0];
+}
+
+ASTContext::overridden_cxx_method_iterator
+ASTContext::overridden_methods_end(const CXXMethodDecl *Method) {
+  llvm::DenseMap<const CXXMethodDecl *,
+                 std::vector<const CXXMethodDecl *> >::iterator Pos
+    = OverriddenMethods.find(Method);
+  if (Pos == OverriddenMethods.end() || Pos->second.empty())
+    return 0;
+
+  return &Pos->second[0] + Pos->second.size();
+}
+
+void ASTContext::addOverriddenMethod(const CXXMethodDecl *Method,
+                                     const CXXMethodDecl *Overridden) {
+  OverriddenMethods[Method].push_back(Overridden);
+}
+
 namespace {
   class BeforeInTranslationUnit
     : std::binary_function<SourceRange, SourceRange, bool> {
@@ -362,6 +464,20 @@ isDoxygenComment(SourceManager &SourceMgr, SourceRange Comment,
   return (Start[3] == '<') == Member;
 }
 
+void ASTContext::ReadExternalComments() {
+  if (!ExternalSource || LoadedExternalComments)
+    return;
+
+  std::vector<SourceRange> LoadedComments;
+  ExternalSource->ReadComments(LoadedComments);
+
+  if (!LoadedComments.empty())
+    Comments.insert(Comments.begin(), LoadedComments.begin(),
+                    LoadedComments.end());
+
+  LoadedExternalComments = true;
+}
+
 /// \brief Retrieve the comment associated with the given declaration, if
 /// it has one.
 const char *ASTContext::getCommentForDecl(const Decl *D) {
@@ -377,16 +493,7 @@ const char *ASTContext::getCommentForDecl(const Decl *D) {
 
   // If we have an external AST source and have not yet loaded comments from
   // that source, do so now.
-  if (ExternalSource && !LoadedExternalComments) {
-    std::vector<SourceRange> LoadedComments;
-    ExternalSource->ReadComments(LoadedComments);
-
-    if (!LoadedComments.empty())
-      Comments.insert(Comments.begin(), LoadedComments.begin(),
-                      LoadedComments.end());
-
-    LoadedExternalComments = true;
-  }
+  ReadExternalComments();
 
   // If there are no comments anywhere, we won't find anything.
   if (Comments.empty())
@@ -568,14 +675,33 @@ CharUnits ASTContext::getDeclAlign(const Decl *D, bool RefAsPointee) {
   return CharUnits::fromQuantity(Align / Target.getCharWidth());
 }
 
-/// getTypeSize - Return the size of the specified type, in bits.  This method
-/// does not work on incomplete types.
+/// getTypeInfo - Return the size and alignment of the specified type, in bits,
+/// computing them only the first time they are asked for.  This method does
+/// not work on incomplete types.
+std::pair<uint64_t, unsigned>
+ASTContext::getTypeInfo(const Type *T) {
+  ++NumTypeInfoQueries;
+  TypeInfoMap::iterator Known = MemoizedTypeInfo.find(T);
+  if (Known != MemoizedTypeInfo.end()) {
+    ++NumCachedTypeInfoQueries;
+    return Known->second;
+  }
+
+  // Computing the size of T may add the sizes of its components to the
+  // cache, so look T up again to insert it.
+  std::pair<uint64_t, unsigned> Info = getTypeInfoImpl(T);
+  MemoizedTypeInfo[T] = Info;
+  return Info;
+}
+
+/// getTypeInfoImpl - Compute the size and alignment of the specified type, in
+/// bits.
 ///
 /// FIXME: Pointers into different addr spaces could have different sizes and
 /// alignment requirements: getPointerInfo should take an AddrSpace, this
 /// should take a QualType, &c.
 std::pair<uint64_t, unsigned>
-ASTContext::getTypeInfo(const Type *T) {
+ASTContext::getTypeInfoImpl(const Type *T) {
   uint64_t Width=0;
   unsigned Align=8;
   switch (T->getTypeClass()) {
@@ -1060,6 +1186,14 @@ TypeSourceInfo *ASTContext::getTrivialTypeSourceInfo(QualType T,
   return DI;
 }
 
+TypeSourceInfo *ASTContext::getElidedTypeSourceInfo(QualType T) {
+  ++NumElidedTypeSourceInfos;
+  TypeSourceInfo *&DI = ElidedTypeSourceInfos[T.getAsOpaquePtr()];
+  if (!DI)
+    DI = getTrivialTypeSourceInfo(T);
+  return DI;
+}
+
 /// getInterfaceLayoutImpl - Get or compute information about the
 /// layout of the given interface.
 ///
@@ -1117,25 +1251,66 @@ const ASTRecordLayout &ASTContext::getASTRecordLayout(const RecordDecl *D) {
   const ASTRecordLayout *Entry = ASTRecordLayouts[D];
   if (Entry) return *Entry;
 
-  const ASTRecordLayout *NewEntry =
-    ASTRecordLayoutBuilder::ComputeLayout(*this, D);
+  // Records that come from a PCH file may have been laid out already.
+  const ASTRecordLayout *NewEntry = 0;
+  if (ExternalSource)
+    NewEntry = ExternalSource->GetRecordLayout(D);
+  if (!NewEntry)
+    NewEntry = ASTRecordLayoutBuilder::ComputeLayout(*this, D);
   ASTRecordLayouts[D] = NewEntry;
 
   return *NewEntry;
 }
 
+const ASTContext::ObjCLookupResult *
+ASTContext::findObjCLookup(const Decl *Container, void *Name,
+                           ObjCLookupKind Kind) {
+  ++NumObjCLookups;
+  if (ObjCLookupsGeneration != ObjCLookupGeneration)
+    return 0;
+
+  llvm::DenseMap<ObjCLookupKey, ObjCLookupResult>::iterator
+    Pos = ObjCLookups.find(std::make_pair(Container,
+                                          std::make_pair(Name, Kind)));
+  if (Pos == ObjCLookups.end())
+    return 0;
+
+  ++NumCachedObjCLookups;
+  return &Pos->second;
+}
+
+void ASTContext::addObjCLookup(const Decl *Container, void *Name,
+                               ObjCLookupKind Kind, NamedDecl *Found,
+                               ObjCInterfaceDecl *Owner) {
+  if (ObjCLookupsGeneration != ObjCLookupGeneration) {
+    ObjCLookups.clear();
+    ObjCLookupsGeneration = ObjCLookupGeneration;
+  }
+
+  ObjCLookupResult &Result
+    = ObjCLookups[std::make_pair(Container, std::make_pair(Name, Kind))];
+  Result.Found = Found;
+  Result.Owner = Owner;
+}
+
 const CXXMethodDecl *ASTContext::getKeyFunction(const CXXRecordDecl *RD) {
   RD = cast<CXXRecordDecl>(RD->getDefinition());
   assert(RD && "Cannot get key function for forward declarations!");
   
-  const CXXMethodDecl *&Entry = KeyFunctions[RD];
-  if (!Entry) 
-    Entry = ASTRecordLayoutBuilder::ComputeKeyFunction(RD);
-  else
-    assert(Entry == ASTRecordLayoutBuilder::ComputeKeyFunction(RD) &&
+  // Classes without a key function are cached too: CodeGen asks about them
+  // for every virtual member function it emits.
+  llvm::DenseMap<const CXXRecordDecl*, const CXXMethodDecl*>::iterator
+    Pos = KeyFunctions.find(RD);
+  if (Pos != KeyFunctions.end()) {
+    assert(Pos->second == ASTRecordLayoutBuilder::ComputeKeyFunction(RD) &&
            "Key function changed!");
-  
-  return Entry;
+    return Pos->second;
+  }
+
+  const CXXMethodDecl *KeyFunction
+    = ASTRecordLayoutBuilder::ComputeKeyFunction(RD);
+  KeyFunctions[RD] = KeyFunction;
+  return KeyFunction;
 }
 
 //===----------------------------------------------------------------------===//
@@ -4684,8 +4859,15 @@ QualType ASTContext::getCorrespondingUnsignedType(QualType T) {
 
 ExternalASTSource::~ExternalASTSource() { }
 
+const ASTRecordLayout *
+ExternalASTSource::GetRecordLayout(const RecordDecl *D) {
+  return 0;
+}
+
 void ExternalASTSource::PrintStats() { }
 
+size_t ExternalASTSource::getMemoryUsage() const { return 0; }
+
 
 //===----------------------------------------------------------------------===//
 //                          Builtin Type Computation
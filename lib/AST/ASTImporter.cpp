@@ -137,6 +137,11 @@ namespace {
     /// \brief Declaration (from, to) pairs that are known not to be equivalent
     /// (which we have already complained about).
     llvm::DenseSet<std::pair<Decl *, Decl *> > &NonEquivalentDecls;
+
+    /// \brief Declaration (from, to) pairs that are known to be equivalent,
+    /// which is extended with the tentative equivalences once they have all
+    /// been verified.
+    llvm::DenseSet<std::pair<Decl *, Decl *> > &EquivalentDecls;
     
     /// \brief Whether we're being strict about the spelling of types when 
     /// unifying two types.
@@ -145,8 +150,10 @@ namespace {
     StructuralEquivalenceContext(ASTContext &C1, ASTContext &C2,
                                  Diagnostic &Diags,
                llvm::DenseSet<std::pair<Decl *, Decl *> > &NonEquivalentDecls,
+               llvm::DenseSet<std::pair<Decl *, Decl *> > &EquivalentDecls,
                                  bool StrictTypeSpelling = false)
       : C1(C1), C2(C2), Diags(Diags), NonEquivalentDecls(NonEquivalentDecls),
+        EquivalentDecls(EquivalentDecls),
         StrictTypeSpelling(StrictTypeSpelling) { }
 
     /// \brief Determine whether the two declarations are structurally
@@ -863,13 +870,13 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
 /// \brief Determine structural equivalence of two declarations.
 static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
                                      Decl *D1, Decl *D2) {
-  // FIXME: Check for known structural equivalences via a callback of some sort.
-  
-  // Check whether we already know that these two declarations are not
+  // Check whether we already know whether these two declarations are
   // structurally equivalent.
-  if (Context.NonEquivalentDecls.count(std::make_pair(D1->getCanonicalDecl(),
-                                                      D2->getCanonicalDecl())))
+  std::pair<Decl *, Decl *> P(D1->getCanonicalDecl(), D2->getCanonicalDecl());
+  if (Context.NonEquivalentDecls.count(P))
     return false;
+  if (Context.EquivalentDecls.count(P))
+    return true;
   
   // Determine whether we've already produced a tentative equivalence for D1.
   Decl *&EquivToD1 = Context.TentativeEquivalences[D1->getCanonicalDecl()];
@@ -966,7 +973,12 @@ bool StructuralEquivalenceContext::Finish() {
     }
     // FIXME: Check other declaration kinds!
   }
-  
+
+  // Every tentative equivalence has held up.
+  for (llvm::DenseMap<Decl *, Decl *>::iterator
+         I = TentativeEquivalences.begin(), E = TentativeEquivalences.end();
+       I != E; ++I)
+    EquivalentDecls.insert(*I);
   return false;
 }
 
@@ -1370,7 +1382,8 @@ bool ASTNodeImporter::IsStructuralMatch(RecordDecl *FromRecord,
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
                                    Importer.getDiags(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(),
+                                   Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(FromRecord, ToRecord);
 }
 
@@ -1378,7 +1391,8 @@ bool ASTNodeImporter::IsStructuralMatch(EnumDecl *FromEnum, EnumDecl *ToEnum) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
                                    Importer.getDiags(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(),
+                                   Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(FromEnum, ToEnum);
 }
 
@@ -2922,6 +2936,6 @@ bool ASTImporter::IsStructurallyEquivalent(QualType From, QualType To) {
     return true;
       
   StructuralEquivalenceContext Ctx(FromContext, ToContext, Diags, 
-                                   NonEquivalentDecls);
+                                   NonEquivalentDecls, EquivalentDecls);
   return Ctx.IsStructurallyEquivalent(From, To);
 }
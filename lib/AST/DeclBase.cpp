@@ -294,10 +294,12 @@ unsigned Decl::getIdentifierNamespaceForKind(Kind DeclKind) {
 }
 
 void Decl::addAttr(Attr *NewAttr) {
-  Attr *&ExistingAttr = getASTContext().getDeclAttrs(this);
+  assert(NewAttr->getKind() < 64 && "Attribute kind does not fit the mask");
+  ASTContext::DeclAttrList &Existing = getASTContext().getDeclAttrs(this);
 
-  NewAttr->setNext(ExistingAttr);
-  ExistingAttr = NewAttr;
+  NewAttr->setNext(Existing.Attrs);
+  Existing.Attrs = NewAttr;
+  Existing.Kinds |= uint64_t(1) << NewAttr->getKind();
 
   HasAttrs = true;
 }
@@ -311,7 +313,12 @@ void Decl::invalidateAttrs() {
 
 const Attr *Decl::getAttrsImpl() const {
   assert(HasAttrs && "getAttrs() should verify this!");
-  return getASTContext().getDeclAttrs(this);
+  return getASTContext().getDeclAttrs(this).Attrs;
+}
+
+uint64_t Decl::getAttrKindsImpl() const {
+  assert(HasAttrs && "hasAttrKind() should verify this!");
+  return getASTContext().getDeclAttrs(this).Kinds;
 }
 
 void Decl::swapAttrs(Decl *RHS) {
@@ -334,8 +341,9 @@ void Decl::swapAttrs(Decl *RHS) {
   }
 
   // Otherwise, LHS has an attr and RHS doesn't.
-  Context.getDeclAttrs(RHS) = Context.getDeclAttrs(this);
+  ASTContext::DeclAttrList LHSAttrs = Context.getDeclAttrs(this);
   Context.eraseDeclAttrs(this);
+  Context.getDeclAttrs(RHS) = LHSAttrs;
   this->HasAttrs = false;
   RHS->HasAttrs = true;
 }
@@ -344,7 +352,7 @@ void Decl::swapAttrs(Decl *RHS) {
 void Decl::Destroy(ASTContext &C) {
   // Free attributes for this decl.
   if (HasAttrs) {
-    C.getDeclAttrs(this)->Destroy(C);
+    C.getDeclAttrs(this).Attrs->Destroy(C);
     invalidateAttrs();
     HasAttrs = false;
   }
@@ -644,7 +652,7 @@ DeclContext::LoadVisibleDeclsFromExternalStorage() const {
   // context.
   assert(!LookupPtr && "Have a lookup map before de-serialization?");
   StoredDeclsMap *Map =
-    (StoredDeclsMap*) getParentASTContext().CreateStoredDeclsMap();
+    (StoredDeclsMap*) getParentASTContext().CreateStoredDeclsMap(Decls.size());
   LookupPtr = Map;
   for (unsigned I = 0, N = Decls.size(); I != N; ++I) {
     (*Map)[Decls[I].Name].setFromDeclIDs(Decls[I].Declarations);
@@ -711,6 +719,13 @@ void DeclContext::removeDecl(Decl *D) {
     StoredDeclsMap::iterator Pos = Map->find(ND->getDeclName());
     assert(Pos != Map->end() && "no lookup entry for decl");
     Pos->second.remove(ND);
+    getParentASTContext().bumpLookupGeneration();
+    if (isRecord())
+      getParentASTContext().bumpRecordLookupGeneration();
+    else if (isFileContext())
+      getParentASTContext().bumpNamespaceLookupGeneration();
+    else if (isObjCLookupContext())
+      getParentASTContext().bumpObjCLookupGeneration();
   }
 }
 
@@ -735,6 +750,30 @@ void DeclContext::addDecl(Decl *D) {
     ND->getDeclContext()->makeDeclVisibleInContext(ND);
 }
 
+/// MinPresizedLookupDecls - The number of named declarations above which
+/// lookup() sizes the lookup data structure of a context before building it.
+static const unsigned MinPresizedLookupDecls = 48;
+
+/// countLookupDecls - Count the named declarations buildLookup will insert
+/// into the lookup data structure of DCtx.  Some of them may share a name,
+/// so this is an upper bound on the number of entries.
+static unsigned countLookupDecls(DeclContext *DCtx) {
+  unsigned NumDecls = 0;
+  for (; DCtx; DCtx = DCtx->getNextContext()) {
+    for (DeclContext::decl_iterator D = DCtx->decls_begin(),
+                                 DEnd = DCtx->decls_end();
+         D != DEnd; ++D) {
+      if (isa<NamedDecl>(*D))
+        ++NumDecls;
+
+      if (DeclContext *InnerCtx = dyn_cast<DeclContext>(*D))
+        if (InnerCtx->isTransparentContext())
+          NumDecls += countLookupDecls(InnerCtx->getPrimaryContext());
+    }
+  }
+  return NumDecls;
+}
+
 /// buildLookup - Build the lookup data structure with all of the
 /// declarations in DCtx (and any other contexts linked to it or
 /// transparent contexts nested within it).
@@ -775,10 +814,29 @@ DeclContext::lookup(DeclarationName Name) {
   if (hasExternalVisibleStorage())
     LoadVisibleDeclsFromExternalStorage();
 
+  // Declare the implicit special members of a class the first time one of
+  // them is looked up.
+  if (CXXRecordDecl *Record = dyn_cast<CXXRecordDecl>(this)) {
+    if (Record->hasDeferredImplicitMembers() &&
+        (Name.getNameKind() == DeclarationName::CXXConstructorName ||
+         Name.getNameKind() == DeclarationName::CXXDestructorName ||
+         Name.getCXXOverloadedOperator() == OO_Equal)) {
+      if (ImplicitMemberDeclarator *IMD
+            = getParentASTContext().ImplicitMembers)
+        IMD->DeclareImplicitMembers(Record);
+    }
+  }
+
   /// If there is no lookup data structure, build one now by walking
   /// all of the linked DeclContexts (in declaration order!) and
   /// inserting their values.
   if (!LookupPtr) {
+    // Large contexts, such as namespaces holding generated code, would
+    // otherwise rehash the table many times while it is built.
+    unsigned NumDecls = countLookupDecls(this);
+    if (NumDecls > MinPresizedLookupDecls)
+      LookupPtr = getParentASTContext().CreateStoredDeclsMap(NumDecls);
+
     buildLookup(this);
 
     if (!LookupPtr)
@@ -829,6 +887,14 @@ void DeclContext::makeDeclVisibleInContext(NamedDecl *D, bool Recoverable) {
     return;
   }
 
+  getParentASTContext().bumpLookupGeneration();
+  if (isRecord())
+    getParentASTContext().bumpRecordLookupGeneration();
+  else if (isFileContext())
+    getParentASTContext().bumpNamespaceLookupGeneration();
+  else if (isObjCLookupContext())
+    getParentASTContext().bumpObjCLookupGeneration();
+
   // If we already have a lookup data structure, perform the insertion
   // into it. Otherwise, be lazy and don't build that structure until
   // someone asks for it.
@@ -929,8 +995,13 @@ void StoredDeclsList::materializeDecls(ASTContext &Context) {
 // Creation and Destruction of StoredDeclsMaps.                               //
 //===----------------------------------------------------------------------===//
 
-void *ASTContext::CreateStoredDeclsMap() {
-  StoredDeclsMap *M = new StoredDeclsMap();
+void *ASTContext::CreateStoredDeclsMap(unsigned NumEntries) {
+  // The map grows when it is three quarters full; start out big enough to
+  // hold NumEntries names without growing.
+  unsigned NumBuckets = 64;
+  while (NumBuckets * 3 <= NumEntries * 4)
+    NumBuckets <<= 1;
+  StoredDeclsMap *M = new StoredDeclsMap(NumBuckets);
   SDMs.push_back(M);
   return M;
 }
@@ -89,17 +89,16 @@ ObjCContainerDecl::getMethod(Selector Sel, bool isInstance) const {
   return 0;
 }
 
-/// FindPropertyDeclaration - Finds declaration of the property given its name
-/// in 'PropertyId' and returns it. It returns 0, if not found.
-/// FIXME: Convert to DeclContext lookup...
-///
-ObjCPropertyDecl *
-ObjCContainerDecl::FindPropertyDeclaration(IdentifierInfo *PropertyId) const {
-  for (prop_iterator I = prop_begin(), E = prop_end(); I != E; ++I)
+/// FindPropertyInContainer - Does the work of FindPropertyDeclaration.
+static ObjCPropertyDecl *
+FindPropertyInContainer(const ObjCContainerDecl *CD,
+                        IdentifierInfo *PropertyId) {
+  for (ObjCContainerDecl::prop_iterator I = CD->prop_begin(),
+       E = CD->prop_end(); I != E; ++I)
     if ((*I)->getIdentifier() == PropertyId)
       return *I;
 
-  const ObjCProtocolDecl *PID = dyn_cast<ObjCProtocolDecl>(this);
+  const ObjCProtocolDecl *PID = dyn_cast<ObjCProtocolDecl>(CD);
   if (PID) {
     for (ObjCProtocolDecl::protocol_iterator I = PID->protocol_begin(),
          E = PID->protocol_end(); I != E; ++I)
@@ -107,7 +106,7 @@ ObjCContainerDecl::FindPropertyDeclaration(IdentifierInfo *PropertyId) const {
         return P;
   }
 
-  if (const ObjCInterfaceDecl *OID = dyn_cast<ObjCInterfaceDecl>(this)) {
+  if (const ObjCInterfaceDecl *OID = dyn_cast<ObjCInterfaceDecl>(CD)) {
     // Look through categories.
     for (ObjCCategoryDecl *Category = OID->getCategoryList();
          Category; Category = Category->getNextClassCategory()) {
@@ -123,7 +122,7 @@ ObjCContainerDecl::FindPropertyDeclaration(IdentifierInfo *PropertyId) const {
     }
     if (OID->getSuperClass())
       return OID->getSuperClass()->FindPropertyDeclaration(PropertyId);
-  } else if (const ObjCCategoryDecl *OCD = dyn_cast<ObjCCategoryDecl>(this)) {
+  } else if (const ObjCCategoryDecl *OCD = dyn_cast<ObjCCategoryDecl>(CD)) {
     // Look through protocols.
     if (!OCD->IsClassExtension())
       for (ObjCInterfaceDecl::protocol_iterator I = OCD->protocol_begin(),
@@ -135,6 +134,29 @@ ObjCContainerDecl::FindPropertyDeclaration(IdentifierInfo *PropertyId) const {
   return 0;
 }
 
+/// FindPropertyDeclaration - Finds declaration of the property given its name
+/// in 'PropertyId' and returns it. It returns 0, if not found.  The results
+/// for classes, which search their categories, protocols and superclasses,
+/// are cached by the ASTContext.
+/// FIXME: Convert to DeclContext lookup...
+///
+ObjCPropertyDecl *
+ObjCContainerDecl::FindPropertyDeclaration(IdentifierInfo *PropertyId) const {
+  if (!isa<ObjCInterfaceDecl>(this))
+    return FindPropertyInContainer(this, PropertyId);
+
+  ASTContext &Context = getASTContext();
+  if (const ASTContext::ObjCLookupResult *Result
+        = Context.findObjCLookup(this, PropertyId,
+                                 ASTContext::ObjCPropertyLookup))
+    return cast_or_null<ObjCPropertyDecl>(Result->Found);
+
+  ObjCPropertyDecl *Property = FindPropertyInContainer(this, PropertyId);
+  Context.addObjCLookup(this, PropertyId, ASTContext::ObjCPropertyLookup,
+                        Property);
+  return Property;
+}
+
 /// FindPropertyVisibleInPrimaryClass - Finds declaration of the property
 /// with name 'PropertyId' in the primary class; including those in protocols
 /// (direct or indirect) used by the promary class.
@@ -202,16 +224,45 @@ void ObjCInterfaceDecl::mergeClassExtensionProtocolList(
   setProtocolList(ProtocolRefs.data(), NumProtoRefs, ProtocolLocs.data(), C);
 }
 
+void ObjCInterfaceDecl::setProtocolList(ObjCProtocolDecl *const* List,
+                                        unsigned Num,
+                                        const SourceLocation *Locs,
+                                        ASTContext &C) {
+  ReferencedProtocols.set(List, Num, Locs, C);
+  C.bumpObjCLookupGeneration();
+}
+
+void ObjCInterfaceDecl::setSuperClass(ObjCInterfaceDecl *superCls) {
+  SuperClass = superCls;
+  getASTContext().bumpObjCLookupGeneration();
+}
+
+void ObjCInterfaceDecl::setCategoryList(ObjCCategoryDecl *category) {
+  CategoryList = category;
+  getASTContext().bumpObjCLookupGeneration();
+}
+
 ObjCIvarDecl *ObjCInterfaceDecl::lookupInstanceVariable(IdentifierInfo *ID,
                                               ObjCInterfaceDecl *&clsDeclared) {
+  ASTContext &Context = getASTContext();
+  if (const ASTContext::ObjCLookupResult *Result
+        = Context.findObjCLookup(this, ID, ASTContext::ObjCIvarLookup)) {
+    if (Result->Found)
+      clsDeclared = Result->Owner;
+    return cast_or_null<ObjCIvarDecl>(Result->Found);
+  }
+
   ObjCInterfaceDecl* ClassDecl = this;
   while (ClassDecl != NULL) {
     if (ObjCIvarDecl *I = ClassDecl->getIvarDecl(ID)) {
       clsDeclared = ClassDecl;
+      Context.addObjCLookup(this, ID, ASTContext::ObjCIvarLookup, I,
+                            ClassDecl);
       return I;
     }
     ClassDecl = ClassDecl->getSuperClass();
   }
+  Context.addObjCLookup(this, ID, ASTContext::ObjCIvarLookup, 0);
   return NULL;
 }
 
@@ -233,6 +284,21 @@ ObjCInterfaceDecl *ObjCInterfaceDecl::lookupInheritedClass(
 /// the class, its categories, and its super classes (using a linear search).
 ObjCMethodDecl *ObjCInterfaceDecl::lookupMethod(Selector Sel,
                                                 bool isInstance) const {
+  ASTContext &Context = getASTContext();
+  ASTContext::ObjCLookupKind Kind = isInstance
+    ? ASTContext::ObjCInstanceMethodLookup : ASTContext::ObjCClassMethodLookup;
+  if (const ASTContext::ObjCLookupResult *Result
+        = Context.findObjCLookup(this, Sel.getAsOpaquePtr(), Kind))
+    return cast_or_null<ObjCMethodDecl>(Result->Found);
+
+  ObjCMethodDecl *MethodDecl = lookupMethodUncached(Sel, isInstance);
+  Context.addObjCLookup(this, Sel.getAsOpaquePtr(), Kind, MethodDecl);
+  return MethodDecl;
+}
+
+/// lookupMethodUncached - Does the work of lookupMethod.
+ObjCMethodDecl *ObjCInterfaceDecl::lookupMethodUncached(Selector Sel,
+                                                        bool isInstance) const {
   const ObjCInterfaceDecl* ClassDecl = this;
   ObjCMethodDecl *MethodDecl = 0;
 
@@ -562,6 +628,14 @@ void ObjCProtocolDecl::Destroy(ASTContext &C) {
   ObjCContainerDecl::Destroy(C);
 }
 
+void ObjCProtocolDecl::setProtocolList(ObjCProtocolDecl *const*List,
+                                       unsigned Num,
+                                       const SourceLocation *Locs,
+                                       ASTContext &C) {
+  ReferencedProtocols.set(List, Num, Locs, C);
+  C.bumpObjCLookupGeneration();
+}
+
 ObjCProtocolDecl *ObjCProtocolDecl::lookupProtocolNamed(IdentifierInfo *Name) {
   ObjCProtocolDecl *PDecl = this;
 
@@ -688,6 +762,14 @@ ObjCCategoryImplDecl *ObjCCategoryDecl::getImplementation() const {
                                            const_cast<ObjCCategoryDecl*>(this));
 }
 
+void ObjCCategoryDecl::setProtocolList(ObjCProtocolDecl *const*List,
+                                       unsigned Num,
+                                       const SourceLocation *Locs,
+                                       ASTContext &C) {
+  ReferencedProtocols.set(List, Num, Locs, C);
+  C.bumpObjCLookupGeneration();
+}
+
 void ObjCCategoryDecl::setImplementation(ObjCCategoryImplDecl *ImplD) {
   getASTContext().setObjCImplementation(this, ImplD);
 }
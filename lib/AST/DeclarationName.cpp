@@ -18,6 +18,7 @@
 #include "clang/Basic/IdentifierTable.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
 #include <cstdio>
 using namespace clang;
 
@@ -25,8 +26,7 @@ namespace clang {
 /// CXXSpecialName - Records the type associated with one of the
 /// "special" kinds of declaration names in C++, e.g., constructors,
 /// destructors, and conversion functions.
-class CXXSpecialName
-  : public DeclarationNameExtra, public llvm::FoldingSetNode {
+class CXXSpecialName : public DeclarationNameExtra {
 public:
   /// Type - The type associated with this declaration name.
   QualType Type;
@@ -34,11 +34,29 @@ public:
   /// FETokenInfo - Extra information associated with this declaration
   /// name that can be used by the front end.
   void *FETokenInfo;
+};
 
-  void Profile(llvm::FoldingSetNodeID &ID) {
-    ID.AddInteger(ExtraKindOrNumArgs);
-    ID.AddPointer(Type.getAsOpaquePtr());
-  }
+/// CXXSpecialNameTable - The constructor, destructor and conversion function
+/// names of each canonical type, which are found with a single lookup of the
+/// type.  Instantiating a class template asks for these names over and over.
+class CXXSpecialNameTable {
+public:
+  /// TypeNames - The names of one type, indexed by the kind of the name less
+  /// DeclarationName::CXXConstructorName.
+  struct TypeNames {
+    CXXSpecialName *Names[3];
+    TypeNames() { Names[0] = Names[1] = Names[2] = 0; }
+  };
+
+  /// Names - The names of each type, keyed by the opaque canonical type.
+  llvm::DenseMap<void *, TypeNames> Names;
+
+  /// Allocator - The names are freed all at once with the table.
+  llvm::BumpPtrAllocator Allocator;
+
+  unsigned NumLookups, NumCreated;
+
+  CXXSpecialNameTable() : NumLookups(0), NumCreated(0) { }
 };
 
 /// CXXOperatorIdName - Contains extra information for the name of an
@@ -373,7 +391,7 @@ void DeclarationName::dump() const {
 }
 
 DeclarationNameTable::DeclarationNameTable() {
-  CXXSpecialNamesImpl = new llvm::FoldingSet<CXXSpecialName>;
+  CXXSpecialNamesImpl = new CXXSpecialNameTable;
   CXXLiteralOperatorNames = new llvm::FoldingSet<CXXLiteralOperatorIdName>;
 
   // Initialize the overloaded operator names.
@@ -386,17 +404,6 @@ DeclarationNameTable::DeclarationNameTable() {
 }
 
 DeclarationNameTable::~DeclarationNameTable() {
-  llvm::FoldingSet<CXXSpecialName> *SpecialNames =
-    static_cast<llvm::FoldingSet<CXXSpecialName>*>(CXXSpecialNamesImpl);
-  llvm::FoldingSetIterator<CXXSpecialName>
-                           SI = SpecialNames->begin(), SE = SpecialNames->end();
-
-  while (SI != SE) {
-    CXXSpecialName *n = &*SI++;
-    delete n;
-  }
-
-
   llvm::FoldingSet<CXXLiteralOperatorIdName> *LiteralNames
     = static_cast<llvm::FoldingSet<CXXLiteralOperatorIdName>*>
                                                       (CXXLiteralOperatorNames);
@@ -408,7 +415,7 @@ DeclarationNameTable::~DeclarationNameTable() {
     delete n;
   }
 
-  delete SpecialNames;
+  delete static_cast<CXXSpecialNameTable*>(CXXSpecialNamesImpl);
   delete LiteralNames;
   delete [] CXXOperatorNames;
 }
@@ -419,8 +426,8 @@ DeclarationNameTable::getCXXSpecialName(DeclarationName::NameKind Kind,
   assert(Kind >= DeclarationName::CXXConstructorName &&
          Kind <= DeclarationName::CXXConversionFunctionName &&
          "Kind must be a C++ special name kind");
-  llvm::FoldingSet<CXXSpecialName> *SpecialNames
-    = static_cast<llvm::FoldingSet<CXXSpecialName>*>(CXXSpecialNamesImpl);
+  CXXSpecialNameTable *SpecialNames
+    = static_cast<CXXSpecialNameTable*>(CXXSpecialNamesImpl);
 
   DeclarationNameExtra::ExtraKind EKind;
   switch (Kind) {
@@ -439,24 +446,30 @@ DeclarationNameTable::getCXXSpecialName(DeclarationName::NameKind Kind,
     return DeclarationName();
   }
 
-  // Unique selector, to guarantee there is one per name.
-  llvm::FoldingSetNodeID ID;
-  ID.AddInteger(EKind);
-  ID.AddPointer(Ty.getAsOpaquePtr());
-
-  void *InsertPos = 0;
-  if (CXXSpecialName *Name = SpecialNames->FindNodeOrInsertPos(ID, InsertPos))
-    return DeclarationName(Name);
-
-  CXXSpecialName *SpecialName = new CXXSpecialName;
+  // Unique the name, to guarantee there is one per kind and type.
+  ++SpecialNames->NumLookups;
+  CXXSpecialName *&SpecialName
+    = SpecialNames->Names[Ty.getAsOpaquePtr()]
+                   .Names[Kind - DeclarationName::CXXConstructorName];
+  if (SpecialName)
+    return DeclarationName(SpecialName);
+
+  ++SpecialNames->NumCreated;
+  SpecialName = new (SpecialNames->Allocator.Allocate<CXXSpecialName>())
+                  CXXSpecialName;
   SpecialName->ExtraKindOrNumArgs = EKind;
   SpecialName->Type = Ty;
   SpecialName->FETokenInfo = 0;
-
-  SpecialNames->InsertNode(SpecialName, InsertPos);
   return DeclarationName(SpecialName);
 }
 
+void DeclarationNameTable::PrintStats() const {
+  CXXSpecialNameTable *SpecialNames
+    = static_cast<CXXSpecialNameTable*>(CXXSpecialNamesImpl);
+  fprintf(stderr, "%u special member name lookups, %u names created.\n",
+          SpecialNames->NumLookups, SpecialNames->NumCreated);
+}
+
 DeclarationName
 DeclarationNameTable::getCXXOperatorName(OverloadedOperatorKind Op) {
   return DeclarationName(&CXXOperatorNames[(unsigned)Op]);
@@ -713,10 +713,11 @@ OverloadedOperatorKind BinaryOperator::getOverloadedOperator(Opcode Opc) {
   return OverOps[Opc];
 }
 
-InitListExpr::InitListExpr(SourceLocation lbraceloc,
+InitListExpr::InitListExpr(ASTContext &C, SourceLocation lbraceloc,
                            Expr **initExprs, unsigned numInits,
                            SourceLocation rbraceloc)
-  : Expr(InitListExprClass, QualType(), false, false),
+  : Expr(InitListExprClass, QualType(), false, false), InitExprs(0),
+    NumInits(0), InitCapacity(0),
     LBraceLoc(lbraceloc), RBraceLoc(rbraceloc), SyntacticForm(0),
     UnionFieldInit(0), HadArrayRangeDesignator(false) 
 {      
@@ -726,26 +727,54 @@ InitListExpr::InitListExpr(SourceLocation lbraceloc,
     if (initExprs[I]->isValueDependent())
       ValueDependent = true;
   }
-      
-  InitExprs.insert(InitExprs.end(), initExprs, initExprs+numInits);
+
+  if (numInits) {
+    growInits(C, numInits);
+    std::copy(initExprs, initExprs + numInits, InitExprs);
+    NumInits = numInits;
+  }
 }
 
-void InitListExpr::reserveInits(unsigned NumInits) {
-  if (NumInits > InitExprs.size())
-    InitExprs.reserve(NumInits);
+void InitListExpr::DoDestroy(ASTContext &C) {
+  DestroyChildren(C);
+  if (InitExprs) C.Deallocate(InitExprs);
+  this->~InitListExpr();
+  C.Deallocate(this);
 }
 
-void InitListExpr::resizeInits(ASTContext &Context, unsigned NumInits) {
-  for (unsigned Idx = NumInits, LastIdx = InitExprs.size();
-       Idx < LastIdx; ++Idx)
-    InitExprs[Idx]->Destroy(Context);
-  InitExprs.resize(NumInits, 0);
+void InitListExpr::growInits(ASTContext &C, unsigned MinCapacity) {
+  if (MinCapacity <= InitCapacity)
+    return;
+
+  Stmt **NewInitExprs = new (C) Stmt*[MinCapacity];
+  std::copy(InitExprs, InitExprs + NumInits, NewInitExprs);
+  if (InitExprs) C.Deallocate(InitExprs);
+  InitExprs = NewInitExprs;
+  InitCapacity = MinCapacity;
+}
+
+void InitListExpr::reserveInits(ASTContext &C, unsigned NumInits) {
+  growInits(C, NumInits);
 }
 
-Expr *InitListExpr::updateInit(unsigned Init, Expr *expr) {
-  if (Init >= InitExprs.size()) {
-    InitExprs.insert(InitExprs.end(), Init - InitExprs.size() + 1, 0);
-    InitExprs.back() = expr;
+void InitListExpr::resizeInits(ASTContext &Context, unsigned NumInits) {
+  for (unsigned Idx = NumInits, LastIdx = this->NumInits;
+       Idx < LastIdx; ++Idx)
+    if (InitExprs[Idx])
+      InitExprs[Idx]->Destroy(Context);
+  growInits(Context, NumInits);
+  for (unsigned Idx = this->NumInits; Idx < NumInits; ++Idx)
+    InitExprs[Idx] = 0;
+  this->NumInits = NumInits;
+}
+
+Expr *InitListExpr::updateInit(ASTContext &C, unsigned Init, Expr *expr) {
+  if (Init >= NumInits) {
+    // Appending one initializer at a time must not copy the list each time.
+    growInits(C, std::max(Init + 1, 2 * InitCapacity));
+    std::fill(InitExprs + NumInits, InitExprs + Init, (Stmt *)0);
+    InitExprs[Init] = expr;
+    NumInits = Init + 1;
     return 0;
   }
 
@@ -2587,10 +2616,10 @@ Stmt::child_iterator VAArgExpr::child_end() { return &Val+1; }
 
 // InitListExpr
 Stmt::child_iterator InitListExpr::child_begin() {
-  return InitExprs.size() ? &InitExprs[0] : 0;
+  return InitExprs;
 }
 Stmt::child_iterator InitListExpr::child_end() {
-  return InitExprs.size() ? &InitExprs[0] + InitExprs.size() : 0;
+  return InitExprs + NumInits;
 }
 
 // DesignatedInitExpr
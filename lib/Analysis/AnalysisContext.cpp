@@ -29,6 +29,7 @@ void AnalysisContextManager::clear() {
   for (ContextMap::iterator I = Contexts.begin(), E = Contexts.end(); I!=E; ++I)
     delete I->second;
   Contexts.clear();
+  CFGArena.Reset();
 }
 
 Stmt *AnalysisContext::getBody() {
@@ -54,7 +55,8 @@ const ImplicitParamDecl *AnalysisContext::getSelfDecl() const {
 
 CFG *AnalysisContext::getCFG() {
   if (!cfg)
-    cfg = CFG::buildCFG(D, getBody(), &D->getASTContext(), AddEHEdges);
+    cfg = CFG::buildCFG(D, getBody(), &D->getASTContext(), AddEHEdges,
+                        /*AddScopes=*/false, CFGArena);
   return cfg;
 }
 
@@ -81,11 +83,24 @@ LiveVariables *AnalysisContext::getLiveVariables() {
 AnalysisContext *AnalysisContextManager::getContext(const Decl *D) {
   AnalysisContext *&AC = Contexts[D];
   if (!AC)
-    AC = new AnalysisContext(D);
+    AC = new AnalysisContext(D, false, &CFGArena);
+  else if (AC->hasCFG())
+    ++NumReuses;
 
   return AC;
 }
 
+size_t AnalysisContextManager::getTotalMemory(unsigned &NumCFGs) const {
+  size_t Bytes = 0;
+  NumCFGs = 0;
+  for (ContextMap::const_iterator I = Contexts.begin(), E = Contexts.end();
+       I != E; ++I) {
+    NumCFGs += I->second->hasCFG();
+    Bytes += I->second->getTotalMemory();
+  }
+  return Bytes + CFGArena.getTotalMemory();
+}
+
 //===----------------------------------------------------------------------===//
 // FoldingSet profiling.
 //===----------------------------------------------------------------------===//
@@ -276,6 +291,13 @@ AnalysisContext::getReferencedBlockVars(const BlockDecl *BD) {
 // Cleanup.
 //===----------------------------------------------------------------------===//
 
+size_t AnalysisContext::getTotalMemory() {
+  size_t Bytes = A.getTotalMemory();
+  if (cfg && cfg->ownsAllocator())
+    Bytes += cfg->getAllocator().getTotalMemory();
+  return Bytes;
+}
+
 AnalysisContext::~AnalysisContext() {
   delete cfg;
   delete liveness;
@@ -22,6 +22,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/OwningPtr.h"
 
 using namespace clang;
@@ -87,11 +88,12 @@ class CFGBuilder {
   LabelSetTy AddressTakenLabels;
 
 public:
-  explicit CFGBuilder() : cfg(new CFG()), // crew a new CFG
-                          Block(NULL), Succ(NULL),
-                          ContinueTargetBlock(NULL), BreakTargetBlock(NULL),
-                          SwitchTerminatedBlock(NULL), DefaultCaseBlock(NULL),
-                          TryTerminatedBlock(NULL) {}
+  explicit CFGBuilder(llvm::BumpPtrAllocator *Arena = 0)
+    : cfg(new CFG(Arena)), // crew a new CFG
+      Block(NULL), Succ(NULL),
+      ContinueTargetBlock(NULL), BreakTargetBlock(NULL),
+      SwitchTerminatedBlock(NULL), DefaultCaseBlock(NULL),
+      TryTerminatedBlock(NULL) {}
 
   // buildCFG - Used by external clients to construct the CFG.
   CFG* buildCFG(const Decl *D, Stmt *Statement, ASTContext *C, bool AddEHEdges,
@@ -1741,8 +1743,9 @@ CFGBlock* CFG::createBlock() {
 /// buildCFG - Constructs a CFG from an AST.  Ownership of the returned
 ///  CFG is returned to the caller.
 CFG* CFG::buildCFG(const Decl *D, Stmt* Statement, ASTContext *C,
-                   bool AddEHEdges, bool AddScopes) {
-  CFGBuilder Builder;
+                   bool AddEHEdges, bool AddScopes,
+                   llvm::BumpPtrAllocator *Arena) {
+  CFGBuilder Builder(Arena);
   return Builder.buildCFG(D, Statement, C, AddEHEdges, AddScopes);
 }
 
@@ -1853,6 +1856,77 @@ CFG::~CFG() {
   delete reinterpret_cast<const BlkExprMapTy*>(BlkExprMap);
 }
 
+//===----------------------------------------------------------------------===//
+// LinearCFG: blocks in reverse postorder.
+//===----------------------------------------------------------------------===//
+
+LinearCFG::LinearCFG(const CFG &cfg) : NumReachable(0) {
+  unsigned NumBlockIDs = cfg.getNumBlockIDs();
+  const unsigned Unvisited = ~0U;
+  Positions.assign(NumBlockIDs, Unvisited);
+
+  // Number the blocks in postorder with an iterative depth-first search
+  // from the entry, then flip the numbers.
+  std::vector<const CFGBlock*> PostOrder;
+  PostOrder.reserve(NumBlockIDs);
+  llvm::SmallVector<std::pair<const CFGBlock*,
+                              CFGBlock::const_succ_iterator>, 20> Stack;
+  const CFGBlock *Entry = &cfg.getEntry();
+  Positions[Entry->getBlockID()] = 0;
+  Stack.push_back(std::make_pair(Entry, Entry->succ_begin()));
+  while (!Stack.empty()) {
+    const CFGBlock *B = Stack.back().first;
+    CFGBlock::const_succ_iterator &I = Stack.back().second;
+    if (I == B->succ_end()) {
+      PostOrder.push_back(B);
+      Stack.pop_back();
+      continue;
+    }
+    const CFGBlock *Succ = *I++;
+    if (Succ && Positions[Succ->getBlockID()] == Unvisited) {
+      Positions[Succ->getBlockID()] = 0;
+      Stack.push_back(std::make_pair(Succ, Succ->succ_begin()));
+    }
+  }
+
+  NumReachable = PostOrder.size();
+  Blocks.resize(NumBlockIDs);
+  for (unsigned I = 0; I != NumReachable; ++I) {
+    unsigned Pos = NumReachable - 1 - I;
+    Blocks[Pos].B = PostOrder[I];
+    Positions[PostOrder[I]->getBlockID()] = Pos;
+  }
+
+  // The blocks that cannot be reached go last.
+  unsigned Pos = NumReachable;
+  for (CFG::const_iterator I = cfg.begin(), E = cfg.end(); I != E; ++I)
+    if (Positions[(*I)->getBlockID()] == Unvisited) {
+      Blocks[Pos].B = *I;
+      Positions[(*I)->getBlockID()] = Pos++;
+    }
+  Blocks.resize(Pos);
+
+  // Lay out the edges of each block next to each other.
+  for (unsigned I = 0, N = Blocks.size(); I != N; ++I) {
+    Block &LB = Blocks[I];
+    LB.SuccBegin = Edges.size();
+    for (CFGBlock::const_succ_iterator S = LB.B->succ_begin(),
+         SE = LB.B->succ_end(); S != SE; ++S)
+      if (*S)
+        Edges.push_back(Positions[(*S)->getBlockID()]);
+    LB.SuccEnd = LB.PredBegin = Edges.size();
+    for (CFGBlock::const_pred_iterator P = LB.B->pred_begin(),
+         PE = LB.B->pred_end(); P != PE; ++P)
+      if (*P)
+        Edges.push_back(Positions[(*P)->getBlockID()]);
+    LB.PredEnd = Edges.size();
+  }
+}
+
+unsigned LinearCFG::getPosition(const CFGBlock *B) const {
+  return getPosition(B->getBlockID());
+}
+
 //===----------------------------------------------------------------------===//
 // CFG pretty printing
 //===----------------------------------------------------------------------===//
@@ -19,6 +19,7 @@ using clang::analyze_printf::FormatSpecifier;
 using clang::analyze_printf::OptionalAmount;
 using clang::analyze_printf::ArgTypeResult;
 using clang::analyze_printf::FormatStringHandler;
+using clang::analyze_printf::ParsedFormatString;
 using namespace clang;
 
 namespace {
@@ -271,6 +272,75 @@ bool clang::analyze_printf::ParseFormatString(FormatStringHandler &H,
 
 FormatStringHandler::~FormatStringHandler() {}
 
+//===----------------------------------------------------------------------===//
+// Methods on ParsedFormatString.
+//===----------------------------------------------------------------------===//
+
+void ParsedFormatString::Parse(const char *beg, const char *end) {
+  Callbacks.clear();
+  Stopped = ParseFormatString(*this, beg, end);
+  Parsed = true;
+}
+
+bool ParsedFormatString::Replay(FormatStringHandler &H) const {
+  for (std::vector<Callback>::const_iterator I = Callbacks.begin(),
+       E = Callbacks.end(); I != E; ++I) {
+    switch (I->K) {
+      case Callback::IncompleteSpecifier:
+        H.HandleIncompleteFormatSpecifier(I->Start, I->Length);
+        break;
+      case Callback::NullChar:
+        H.HandleNullChar(I->Start);
+        break;
+      case Callback::InvalidConversion:
+        H.HandleInvalidConversionSpecifier(I->FS, I->Start, I->Length);
+        break;
+      case Callback::Specifier:
+        if (!H.HandleFormatSpecifier(I->FS, I->Start, I->Length))
+          return true;
+        break;
+    }
+  }
+  return Stopped;
+}
+
+void ParsedFormatString::AddCallback(Callback::Kind K,
+                                     const FormatSpecifier &FS,
+                                     const char *Start, unsigned Length) {
+  Callbacks.push_back(Callback());
+  Callback &C = Callbacks.back();
+  C.K = K;
+  C.FS = FS;
+  C.Start = Start;
+  C.Length = Length;
+}
+
+void ParsedFormatString::HandleIncompleteFormatSpecifier(
+                                                    const char *startSpecifier,
+                                                    unsigned specifierLen) {
+  AddCallback(Callback::IncompleteSpecifier, FormatSpecifier(),
+              startSpecifier, specifierLen);
+}
+
+void ParsedFormatString::HandleNullChar(const char *nullCharacter) {
+  AddCallback(Callback::NullChar, FormatSpecifier(), nullCharacter, 0);
+}
+
+void ParsedFormatString::HandleInvalidConversionSpecifier(
+                                                  const FormatSpecifier &FS,
+                                                  const char *startSpecifier,
+                                                  unsigned specifierLen) {
+  AddCallback(Callback::InvalidConversion, FS, startSpecifier, specifierLen);
+}
+
+bool ParsedFormatString::HandleFormatSpecifier(const FormatSpecifier &FS,
+                                               const char *startSpecifier,
+                                               unsigned specifierLen) {
+  // Record every specifier; whether to go on is up to the handler replayed to.
+  AddCallback(Callback::Specifier, FS, startSpecifier, specifierLen);
+  return true;
+}
+
 //===----------------------------------------------------------------------===//
 // Methods on ArgTypeResult.
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,71 @@
+//===--- AtomicOutputFile.cpp - Files replaced in a single step -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the AtomicOutputFile interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/AtomicOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace clang;
+
+AtomicOutputFile::AtomicOutputFile(llvm::StringRef P) : Path(P.str()) { }
+
+AtomicOutputFile::~AtomicOutputFile() {
+  if (!Out)
+    return;
+
+  // The file was not committed; throw away whatever was written.
+  Out->close();
+  Out->clear_error();
+  Out.reset();
+  TempPath.eraseFromDisk();
+}
+
+bool AtomicOutputFile::open(std::string &ErrorInfo) {
+  assert(!Out && "Temporary file is already open");
+  TempPath = llvm::sys::Path(Path);
+  TempPath.appendSuffix("tmp");
+  if (TempPath.makeUnique(/*reuse_current=*/false, &ErrorInfo))
+    return true;
+
+  Out.reset(new llvm::raw_fd_ostream(TempPath.c_str(), ErrorInfo,
+                                     llvm::raw_fd_ostream::F_Binary));
+  if (!ErrorInfo.empty()) {
+    Out.reset();
+    TempPath.eraseFromDisk();
+    return true;
+  }
+  return false;
+}
+
+llvm::raw_ostream &AtomicOutputFile::getStream() {
+  assert(Out && "Temporary file is not open");
+  return *Out;
+}
+
+bool AtomicOutputFile::commit(std::string &ErrorInfo) {
+  assert(Out && "Temporary file is not open");
+  Out->close();
+  bool Failed = Out->has_error();
+  Out->clear_error();
+  Out.reset();
+
+  if (Failed) {
+    ErrorInfo = "error writing '" + TempPath.str() + "'";
+    TempPath.eraseFromDisk();
+    return true;
+  }
+
+  if (TempPath.renamePathOnDisk(llvm::sys::Path(Path), &ErrorInfo)) {
+    TempPath.eraseFromDisk();
+    return true;
+  }
+  return false;
+}
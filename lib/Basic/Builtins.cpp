@@ -37,42 +37,92 @@ Builtin::Context::Context(const TargetInfo &Target) {
   Target.getTargetBuiltins(TSRecords, NumTSRecords);
 }
 
+bool Builtin::Context::isEnabled(unsigned ID, bool NoBuiltins) const {
+  const Info &Record = GetRecord(ID);
+  return !Record.Suppressed &&
+         (!NoBuiltins ||
+          (Record.Attributes && !strchr(Record.Attributes, 'f')));
+}
+
 /// InitializeBuiltins - Mark the identifiers for all the builtins with their
 /// appropriate builtin ID # and mark any non-portable builtin identifiers as
 /// such.
 void Builtin::Context::InitializeBuiltins(IdentifierTable &Table,
                                           bool NoBuiltins) {
-  // Step #1: mark all target-independent builtins with their ID's.
-  for (unsigned i = Builtin::NotBuiltin+1; i != Builtin::FirstTSBuiltin; ++i)
-    if (!BuiltinInfo[i].Suppressed &&
-        (!NoBuiltins || !strchr(BuiltinInfo[i].Attributes, 'f')))
-      Table.get(BuiltinInfo[i].Name).setBuiltinID(i);
-
-  // Step #2: Register target-specific builtins.
-  for (unsigned i = 0, e = NumTSRecords; i != e; ++i)
-    if (!TSRecords[i].Suppressed &&
-        (!NoBuiltins ||
-         (TSRecords[i].Attributes &&
-          !strchr(TSRecords[i].Attributes, 'f'))))
-      Table.get(TSRecords[i].Name).setBuiltinID(i+Builtin::FirstTSBuiltin);
+  unsigned LastID = Builtin::FirstTSBuiltin + NumTSRecords;
+
+  // If the shared base of the table already carries exactly these builtins,
+  // take them from there instead of creating an identifier for each one.
+  // Checking only reads the base, so it does not allocate anything.
+  if (const SharedIdentifierTable *Shared = Table.getSharedBase()) {
+    bool Matches = true;
+    unsigned NumMatched = 0;
+    for (unsigned i = Builtin::NotBuiltin+1; Matches && i != LastID; ++i)
+      if (isEnabled(i, NoBuiltins)) {
+        Matches = Shared->getBuiltinID(GetRecord(i).Name) == i;
+        ++NumMatched;
+      }
+
+    if (Matches && NumMatched == Shared->getNumBuiltins()) {
+      Table.adoptSharedBuiltins();
+      return;
+    }
+  }
+
+  // A translation unit only uses a few of the builtins, so rather than
+  // creating an identifier for each of them, let the table look up the
+  // builtin ID of every identifier it creates.
+  Table.setBuiltinLookup(this, NoBuiltins);
+}
+
+/// HashBuiltinName - The Bernstein hash of a builtin name.
+static unsigned HashBuiltinName(llvm::StringRef Name) {
+  unsigned Result = 0;
+  for (const char *P = Name.begin(), *E = Name.end(); P != E; ++P)
+    Result = Result * 33 + (unsigned char)*P;
+  return Result + (Result >> 5);
+}
+
+void Builtin::Context::BuildNameTable() const {
+  unsigned LastID = Builtin::FirstTSBuiltin + NumTSRecords;
+  unsigned Size = 16;
+  while (Size < 2 * LastID)
+    Size *= 2;
+  NameTable.assign(Size, 0);
+
+  for (unsigned i = Builtin::NotBuiltin+1; i != LastID; ++i) {
+    llvm::StringRef Name = GetRecord(i).Name;
+    unsigned Slot = HashBuiltinName(Name) & (Size - 1);
+    // A later builtin of the same name replaces the earlier one, just like
+    // target-specific builtins override target-independent ones.
+    while (NameTable[Slot] && Name != GetRecord(NameTable[Slot]).Name)
+      Slot = (Slot + 1) & (Size - 1);
+    NameTable[Slot] = i;
+  }
+}
+
+unsigned Builtin::Context::getBuiltinID(llvm::StringRef Name,
+                                        bool NoBuiltins) const {
+  if (NameTable.empty())
+    BuildNameTable();
+
+  unsigned Mask = NameTable.size() - 1;
+  for (unsigned Slot = HashBuiltinName(Name) & Mask; NameTable[Slot];
+       Slot = (Slot + 1) & Mask) {
+    unsigned ID = NameTable[Slot];
+    if (Name == GetRecord(ID).Name)
+      return isEnabled(ID, NoBuiltins) ? ID : 0;
+  }
+  return 0;
 }
 
 void
 Builtin::Context::GetBuiltinNames(llvm::SmallVectorImpl<const char *> &Names,
-                                  bool NoBuiltins) {
-  // Final all target-independent names
-  for (unsigned i = Builtin::NotBuiltin+1; i != Builtin::FirstTSBuiltin; ++i)
-    if (!BuiltinInfo[i].Suppressed &&
-        (!NoBuiltins || !strchr(BuiltinInfo[i].Attributes, 'f')))
-      Names.push_back(BuiltinInfo[i].Name);
-
-  // Find target-specific names.
-  for (unsigned i = 0, e = NumTSRecords; i != e; ++i)
-    if (!TSRecords[i].Suppressed &&
-        (!NoBuiltins ||
-         (TSRecords[i].Attributes &&
-          !strchr(TSRecords[i].Attributes, 'f'))))
-      Names.push_back(TSRecords[i].Name);
+                                  bool NoBuiltins) const {
+  for (unsigned i = Builtin::NotBuiltin+1,
+         e = Builtin::FirstTSBuiltin + NumTSRecords; i != e; ++i)
+    if (isEnabled(i, NoBuiltins))
+      Names.push_back(GetRecord(i).Name);
 }
 
 bool
@@ -21,7 +21,6 @@
 #include "clang/Analysis/AnalysisDiagnostic.h"
 #include "clang/Driver/DriverDiagnostic.h"
 
-#include "clang/Basic/FileManager.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
@@ -215,6 +214,7 @@ Diagnostic::Diagnostic(DiagnosticClient *client) : Client(client) {
   NumDiagnostics = 0;
   
   NumErrors = 0;
+  NumDropped = 0;
   CustomDiagInfo = 0;
   CurDiagID = ~0U;
   LastDiagLevel = Ignored;
@@ -445,9 +445,9 @@ bool Diagnostic::setDiagnosticGroupMapping(const char *Group,
 }
 
 
-/// ProcessDiag - This is the method used to report a diagnostic that is
-/// finally fully formed.
-bool Diagnostic::ProcessDiag() {
+/// ClassifyDiag - Determine the level of the diagnostic that was just
+/// reported, and whether it will be emitted at all.
+bool Diagnostic::ClassifyDiag() {
   DiagnosticInfo Info(this);
 
   if (SuppressAllDiagnostics)
@@ -518,6 +518,17 @@ bool Diagnostic::ProcessDiag() {
     return false;
   }
 
+  CurDiagLevel = DiagLevel;
+  return true;
+}
+
+/// ProcessDiag - This is the method used to report a diagnostic that is
+/// finally fully formed.  ClassifyDiag already decided that it is to be
+/// emitted.
+bool Diagnostic::ProcessDiag() {
+  DiagnosticInfo Info(this);
+  Diagnostic::Level DiagLevel = CurDiagLevel;
+
   if (DiagLevel >= Diagnostic::Error) {
     ErrorOccurred = true;
     ++NumErrors;
@@ -532,6 +543,15 @@ bool Diagnostic::ProcessDiag() {
   return true;
 }
 
+/// PrintStats - Print some statistics about the diagnostics reported.
+void Diagnostic::PrintStats() const {
+  llvm::errs() << "\n*** Diagnostic Stats:\n";
+  llvm::errs() << "  " << NumDiagnostics << " diagnostics emitted, "
+               << NumErrors << " errors.\n";
+  llvm::errs() << "  " << NumDropped
+               << " diagnostics constructed but dropped.\n";
+}
+
 
 DiagnosticClient::~DiagnosticClient() {}
 
@@ -925,6 +945,16 @@ StoredDiagnostic::StoredDiagnostic(Diagnostic::Level Level,
                                    llvm::StringRef Message)
   : Level(Level), Loc(), Message(Message) { }
 
+StoredDiagnostic::StoredDiagnostic(Diagnostic::Level Level,
+                                   const FullSourceLoc &Loc,
+                                   llvm::StringRef Message,
+                                   const SourceRange *Ranges,
+                                   unsigned NumRanges,
+                                   const CodeModificationHint *FixIts,
+                                   unsigned NumFixIts)
+  : Level(Level), Loc(Loc), Message(Message), Ranges(Ranges, Ranges+NumRanges),
+    FixIts(FixIts, FixIts+NumFixIts) { }
+
 StoredDiagnostic::StoredDiagnostic(Diagnostic::Level Level, 
                                    const DiagnosticInfo &Info)
   : Level(Level), Loc(Info.getLocation()) 
@@ -944,222 +974,6 @@ StoredDiagnostic::StoredDiagnostic(Diagnostic::Level Level,
 
 StoredDiagnostic::~StoredDiagnostic() { }
 
-static void WriteUnsigned(llvm::raw_ostream &OS, unsigned Value) {
-  OS.write((const char *)&Value, sizeof(unsigned));
-}
-
-static void WriteString(llvm::raw_ostream &OS, llvm::StringRef String) {
-  WriteUnsigned(OS, String.size());
-  OS.write(String.data(), String.size());
-}
-
-static void WriteSourceLocation(llvm::raw_ostream &OS, 
-                                SourceManager *SM,
-                                SourceLocation Location) {
-  if (!SM || Location.isInvalid()) {
-    // If we don't have a source manager or this location is invalid,
-    // just write an invalid location.
-    WriteUnsigned(OS, 0);
-    WriteUnsigned(OS, 0);
-    WriteUnsigned(OS, 0);
-    return;
-  }
-
-  Location = SM->getInstantiationLoc(Location);
-  std::pair<FileID, unsigned> Decomposed = SM->getDecomposedLoc(Location);
-  
-  WriteString(OS, SM->getFileEntryForID(Decomposed.first)->getName());
-  WriteUnsigned(OS, SM->getLineNumber(Decomposed.first, Decomposed.second));
-  WriteUnsigned(OS, SM->getColumnNumber(Decomposed.first, Decomposed.second));
-}
-
-void StoredDiagnostic::Serialize(llvm::raw_ostream &OS) const {
-  SourceManager *SM = 0;
-  if (getLocation().isValid())
-    SM = &const_cast<SourceManager &>(getLocation().getManager());
-
-  // Write the diagnostic level and location.
-  WriteUnsigned(OS, (unsigned)Level);
-  WriteSourceLocation(OS, SM, getLocation());
-
-  // Write the diagnostic message.
-  llvm::SmallString<64> Message;
-  WriteString(OS, getMessage());
-  
-  // Count the number of ranges that don't point into macros, since
-  // only simple file ranges serialize well.
-  unsigned NumNonMacroRanges = 0;
-  for (range_iterator R = range_begin(), REnd = range_end(); R != REnd; ++R) {
-    if (R->getBegin().isMacroID() || R->getEnd().isMacroID())
-      continue;
-
-    ++NumNonMacroRanges;
-  }
-
-  // Write the ranges.
-  WriteUnsigned(OS, NumNonMacroRanges);
-  if (NumNonMacroRanges) {
-    for (range_iterator R = range_begin(), REnd = range_end(); R != REnd; ++R) {
-      if (R->getBegin().isMacroID() || R->getEnd().isMacroID())
-        continue;
-      
-      WriteSourceLocation(OS, SM, R->getBegin());
-      WriteSourceLocation(OS, SM, R->getEnd());
-    }
-  }
-
-  // Determine if all of the fix-its involve rewrites with simple file
-  // locations (not in macro instantiations). If so, we can write
-  // fix-it information.
-  unsigned NumFixIts = 0;
-  for (fixit_iterator F = fixit_begin(), FEnd = fixit_end(); F != FEnd; ++F) {
-    if (F->RemoveRange.isValid() &&
-        (F->RemoveRange.getBegin().isMacroID() ||
-         F->RemoveRange.getEnd().isMacroID())) {
-      NumFixIts = 0;
-      break;
-    }
-
-    if (F->InsertionLoc.isValid() && F->InsertionLoc.isMacroID()) {
-      NumFixIts = 0;
-      break;
-    }
-
-    ++NumFixIts;
-  }
-
-  // Write the fix-its.
-  WriteUnsigned(OS, NumFixIts);
-  for (fixit_iterator F = fixit_begin(), FEnd = fixit_end(); F != FEnd; ++F) {
-    WriteSourceLocation(OS, SM, F->RemoveRange.getBegin());
-    WriteSourceLocation(OS, SM, F->RemoveRange.getEnd());
-    WriteSourceLocation(OS, SM, F->InsertionLoc);
-    WriteString(OS, F->CodeToInsert);
-  }
-}
-
-static bool ReadUnsigned(const char *&Memory, const char *MemoryEnd,
-                         unsigned &Value) {
-  if (Memory + sizeof(unsigned) > MemoryEnd)
-    return true;
-
-  memmove(&Value, Memory, sizeof(unsigned));
-  Memory += sizeof(unsigned);
-  return false;
-}
-
-static bool ReadSourceLocation(FileManager &FM, SourceManager &SM,
-                               const char *&Memory, const char *MemoryEnd,
-                               SourceLocation &Location) {
-  // Read the filename.
-  unsigned FileNameLen = 0;
-  if (ReadUnsigned(Memory, MemoryEnd, FileNameLen) || 
-      Memory + FileNameLen > MemoryEnd)
-    return true;
-
-  llvm::StringRef FileName(Memory, FileNameLen);
-  Memory += FileNameLen;
-
-  // Read the line, column.
-  unsigned Line = 0, Column = 0;
-  if (ReadUnsigned(Memory, MemoryEnd, Line) ||
-      ReadUnsigned(Memory, MemoryEnd, Column))
-    return true;
-
-  if (FileName.empty()) {
-    Location = SourceLocation();
-    return false;
-  }
-
-  const FileEntry *File = FM.getFile(FileName);
-  if (!File)
-    return true;
-
-  // Make sure that this file has an entry in the source manager.
-  if (!SM.hasFileInfo(File))
-    SM.createFileID(File, SourceLocation(), SrcMgr::C_User);
-
-  Location = SM.getLocation(File, Line, Column);
-  return false;
-}
-
-StoredDiagnostic 
-StoredDiagnostic::Deserialize(FileManager &FM, SourceManager &SM, 
-                              const char *&Memory, const char *MemoryEnd) {
-  if (Memory == MemoryEnd)
-    return StoredDiagnostic();
-
-  // Read the severity level.
-  unsigned Level = 0;
-  if (ReadUnsigned(Memory, MemoryEnd, Level) || Level > Diagnostic::Fatal)
-    return StoredDiagnostic();
-
-  // Read the source location.
-  SourceLocation Location;
-  if (ReadSourceLocation(FM, SM, Memory, MemoryEnd, Location))
-    return StoredDiagnostic();
-
-  // Read the diagnostic text.
-  if (Memory == MemoryEnd)
-    return StoredDiagnostic();
-
-  unsigned MessageLen = 0;
-  if (ReadUnsigned(Memory, MemoryEnd, MessageLen) ||
-      Memory + MessageLen > MemoryEnd)
-    return StoredDiagnostic();
-  
-  llvm::StringRef Message(Memory, MessageLen);
-  Memory += MessageLen;
-
-
-  // At this point, we have enough information to form a diagnostic. Do so.
-  StoredDiagnostic Diag;
-  Diag.Level = (Diagnostic::Level)Level;
-  Diag.Loc = FullSourceLoc(Location, SM);
-  Diag.Message = Message;
-  if (Memory == MemoryEnd)
-    return Diag;
-
-  // Read the source ranges.
-  unsigned NumSourceRanges = 0;
-  if (ReadUnsigned(Memory, MemoryEnd, NumSourceRanges))
-    return Diag;
-  for (unsigned I = 0; I != NumSourceRanges; ++I) {
-    SourceLocation Begin, End;
-    if (ReadSourceLocation(FM, SM, Memory, MemoryEnd, Begin) ||
-        ReadSourceLocation(FM, SM, Memory, MemoryEnd, End))
-      return Diag;
-
-    Diag.Ranges.push_back(SourceRange(Begin, End));
-  }
-
-  // Read the fix-it hints.
-  unsigned NumFixIts = 0;
-  if (ReadUnsigned(Memory, MemoryEnd, NumFixIts))
-    return Diag;
-  for (unsigned I = 0; I != NumFixIts; ++I) {
-    SourceLocation RemoveBegin, RemoveEnd, InsertionLoc;
-    unsigned InsertLen = 0;
-    if (ReadSourceLocation(FM, SM, Memory, MemoryEnd, RemoveBegin) ||
-        ReadSourceLocation(FM, SM, Memory, MemoryEnd, RemoveEnd) ||
-        ReadSourceLocation(FM, SM, Memory, MemoryEnd, InsertionLoc) ||
-        ReadUnsigned(Memory, MemoryEnd, InsertLen) ||
-        Memory + InsertLen > MemoryEnd) {
-      Diag.FixIts.clear();
-      return Diag;
-    }
-
-    CodeModificationHint Hint;
-    Hint.RemoveRange = SourceRange(RemoveBegin, RemoveEnd);
-    Hint.InsertionLoc = InsertionLoc;
-    Hint.CodeToInsert.assign(Memory, Memory + InsertLen);
-    Memory += InsertLen;
-    Diag.FixIts.push_back(Hint);
-  }
-
-  return Diag;
-}
-
 /// IncludeInDiagnosticCounts - This method (whose default implementation
 ///  returns true) indicates whether the diagnostics handled by this
 ///  DiagnosticClient should be included in the number of diagnostics
@@ -10,18 +10,16 @@
 //  This file implements the FileManager interface.
 //
 //===----------------------------------------------------------------------===//
-//
-// TODO: This should index all interesting directories with dirent calls.
-//  getdirentries ?
-//  opendir/readdir_r/closedir ?
-//
-//===----------------------------------------------------------------------===//
 
 #include "clang/Basic/FileManager.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Path.h"
 #include "llvm/Config/config.h"
+#include <cctype>
+#include <cstring>
+#include <ctime>
 #include <map>
 #include <set>
 #include <string>
@@ -38,6 +36,16 @@ using namespace clang;
 /// represent a dir name that doesn't exist on the disk.
 #define NON_EXISTENT_DIR reinterpret_cast<DirectoryEntry*>((intptr_t)-1)
 
+/// LowercaseName - Return the given file name in lowercase, the form in which
+/// directory listings keep their names.
+static llvm::StringRef LowercaseName(llvm::StringRef Name,
+                                     llvm::SmallVectorImpl<char> &Buffer) {
+  Buffer.clear();
+  for (unsigned i = 0, e = Name.size(); i != e; ++i)
+    Buffer.push_back(tolower((unsigned char) Name[i]));
+  return llvm::StringRef(Buffer.data(), Buffer.size());
+}
+
 //===----------------------------------------------------------------------===//
 // Windows.
 //===----------------------------------------------------------------------===//
@@ -92,6 +100,14 @@ public:
   size_t size() { return UniqueFiles.size(); }
 };
 
+/// ReadDirectory - Read the names of the entries of the given directory.
+/// Without readdir, no directory can be read, so every lookup is answered
+/// with a stat call.
+static bool ReadDirectory(const char *Name, llvm::StringMap<char> &Names,
+                          time_t &ModTime) {
+  return false;
+}
+
 //===----------------------------------------------------------------------===//
 // Unix-like Systems.
 //===----------------------------------------------------------------------===//
@@ -100,6 +116,8 @@ public:
 
 #define IS_DIR_SEPARATOR_CHAR(x) ((x) == '/')
 
+#include <dirent.h>
+
 class FileManager::UniqueDirContainer {
   /// UniqueDirs - Cache from ID's to existing directories/files.
   ///
@@ -130,21 +148,63 @@ public:
   size_t size() { return UniqueFiles.size(); }
 };
 
+/// ReadDirectory - Read the names of the entries of the given directory, in
+/// lowercase, along with the modification time of the directory.  Returns
+/// false if the directory cannot be read.
+static bool ReadDirectory(const char *Name, llvm::StringMap<char> &Names,
+                          time_t &ModTime) {
+  struct stat StatBuf;
+  if (::stat(Name, &StatBuf))
+    return false;
+  ModTime = StatBuf.st_mtime;
+
+  DIR *Dir = opendir(Name);
+  if (!Dir)
+    return false;
+
+  llvm::SmallString<64> Buffer;
+  while (struct dirent *Entry = readdir(Dir))
+    Names[LowercaseName(Entry->d_name, Buffer)] = 1;
+  closedir(Dir);
+  return true;
+}
+
 #endif
 
 //===----------------------------------------------------------------------===//
 // Common logic.
 //===----------------------------------------------------------------------===//
 
+/// DirectoryListing - The names in a directory, as read by ReadDirectory.
+struct FileManager::DirectoryListing {
+  llvm::StringMap<char> Names;
+
+  /// ModTime - The modification time of the directory when it was read.
+  time_t ModTime;
+
+  /// ReadTime - When the directory was read.  A change made within the same
+  /// second as ModTime does not show in the modification time.
+  time_t ReadTime;
+
+  /// Complete - Whether the directory could be read.  If not, no name is
+  /// known to be missing from it.
+  bool Complete;
+
+  DirectoryListing() : ModTime(0), ReadTime(0), Complete(false) {}
+};
+
 FileManager::FileManager()
   : UniqueDirs(*new UniqueDirContainer),
     UniqueFiles(*new UniqueFileContainer),
-    DirEntries(64), FileEntries(64), NextFileUID(0) {
+    DirEntries(64), FileEntries(64), NextFileUID(0), CacheDirListings(false),
+    Overlay(0), FallbackStatCache(0) {
   NumDirLookups = NumFileLookups = 0;
   NumDirCacheMisses = NumFileCacheMisses = 0;
+  NumDirListingsRead = NumListingMisses = 0;
 }
 
 FileManager::~FileManager() {
+  clearDirectoryListings();
   delete &UniqueDirs;
   delete &UniqueFiles;
   for (llvm::SmallVectorImpl<FileEntry *>::iterator
@@ -157,22 +217,30 @@ FileManager::~FileManager() {
 
 void FileManager::addStatCache(StatSysCallCache *statCache, bool AtBeginning) {
   assert(statCache && "No stat cache provided?");
-  if (AtBeginning || StatCache.get() == 0) {
+  if (AtBeginning || StatCache.get() == 0 ||
+      StatCache.get() == FallbackStatCache) {
     statCache->setNextStatCache(StatCache.take());
     StatCache.reset(statCache);
     return;
   }
   
   StatSysCallCache *LastCache = StatCache.get();
-  while (LastCache->getNextStatCache())
+  while (LastCache->getNextStatCache() &&
+         LastCache->getNextStatCache() != FallbackStatCache)
     LastCache = LastCache->getNextStatCache();
   
+  statCache->setNextStatCache(LastCache->takeNextStatCache());
   LastCache->setNextStatCache(statCache);
 }
 
 void FileManager::removeStatCache(StatSysCallCache *statCache) {
   if (!statCache)
     return;
+
+  if (statCache == Overlay)
+    Overlay = 0;
+  if (statCache == FallbackStatCache)
+    FallbackStatCache = 0;
   
   if (StatCache.get() == statCache) {
     // This is the first stat cache.
@@ -185,11 +253,78 @@ void FileManager::removeStatCache(StatSysCallCache *statCache) {
   while (PrevCache && PrevCache->getNextStatCache() != statCache)
     PrevCache = PrevCache->getNextStatCache();
   if (PrevCache)
-    PrevCache->setNextStatCache(statCache->getNextStatCache());
+    PrevCache->setNextStatCache(statCache->takeNextStatCache());
   else
     assert(false && "Stat cache not found for removal");
 }
 
+void FileManager::setVirtualFileOverlay(VirtualFileOverlay *O) {
+  if (Overlay)
+    removeStatCache(Overlay);
+  addStatCache(O, /*AtBeginning=*/true);
+  Overlay = O;
+}
+
+void FileManager::setFallbackStatCache(StatSysCallCache *C) {
+  if (FallbackStatCache)
+    removeStatCache(FallbackStatCache);
+  addStatCache(C);
+  FallbackStatCache = C;
+}
+
+void FileManager::setCacheDirectoryListings(bool Cache) {
+  CacheDirListings = Cache;
+  if (!Cache)
+    clearDirectoryListings();
+}
+
+void FileManager::clearDirectoryListings() {
+  for (llvm::DenseMap<const DirectoryEntry *, DirectoryListing *>::iterator
+         I = DirListings.begin(), E = DirListings.end(); I != E; ++I)
+    delete I->second;
+  DirListings.clear();
+}
+
+bool FileManager::isKnownMissing(const DirectoryEntry *Dir,
+                                 llvm::StringRef Name) {
+  DirectoryListing *&Listing = DirListings[Dir];
+  if (!Listing) {
+    Listing = new DirectoryListing();
+    Listing->ReadTime = time(0);
+    Listing->Complete = ReadDirectory(Dir->getName(), Listing->Names,
+                                      Listing->ModTime);
+    ++NumDirListingsRead;
+  }
+
+  if (!Listing->Complete)
+    return false;
+
+  llvm::SmallString<64> Buffer;
+  if (Listing->Names.count(LowercaseName(Name, Buffer)))
+    return false;
+
+  // The listing comes from the disk; in-memory files are not in it.
+  if (Overlay) {
+    llvm::SmallString<128> Path(Dir->getName());
+    Path += '/';
+    Path += Name;
+    if (Overlay->contains(Path.str()))
+      return false;
+  }
+
+  ++NumListingMisses;
+  return true;
+}
+
+/// \brief Return the last component of the given path.
+static llvm::StringRef getLastComponent(const char *NameStart,
+                                        const char *NameEnd) {
+  const char *Start = NameEnd;
+  while (Start != NameStart && !IS_DIR_SEPARATOR_CHAR(Start[-1]))
+    --Start;
+  return llvm::StringRef(Start, NameEnd - Start);
+}
+
 /// \brief Retrieve the directory that the given file name resides in.
 static const DirectoryEntry *getDirectoryFromFile(FileManager &FileMgr,
                                                   const char *NameStart,
@@ -242,6 +377,18 @@ const DirectoryEntry *FileManager::getDirectory(const char *NameStart,
   // DirEntries map.
   const char *InterndDirName = NamedDirEnt.getKeyData();
 
+  // If the listing of the parent directory shows the directory is not there,
+  // don't stat it.  This is what prunes the framework directories that are
+  // missing from most -F paths.
+  if (CacheDirListings) {
+    llvm::StringRef Leaf = getLastComponent(NameStart, NameEnd);
+    if (!Leaf.empty() && Leaf != "." && Leaf != "..")
+      if (const DirectoryEntry *Parent
+            = getDirectoryFromFile(*this, NameStart, NameEnd))
+        if (isKnownMissing(Parent, Leaf))
+          return 0;
+  }
+
   // Check to see if the directory exists.
   struct stat StatBuf;
   if (stat_cached(InterndDirName, &StatBuf) ||   // Error stat'ing.
@@ -297,8 +444,11 @@ const FileEntry *FileManager::getFile(const char *NameStart,
   if (DirInfo == 0)  // Directory doesn't exist, file can't exist.
     return 0;
 
-  // FIXME: Use the directory info to prune this, before doing the stat syscall.
-  // FIXME: This will reduce the # syscalls.
+  // If the listing of the directory shows the file is not there, don't stat
+  // it.
+  if (CacheDirListings &&
+      isKnownMissing(DirInfo, getLastComponent(NameStart, NameEnd)))
+    return 0;
 
   // Nope, there isn't.  Check to see if the file exists.
   struct stat StatBuf;
@@ -330,6 +480,71 @@ const FileEntry *FileManager::getFile(const char *NameStart,
   return &UFE;
 }
 
+void FileManager::revalidateDirectoryListings() {
+  bool Changed = false;
+  for (llvm::DenseMap<const DirectoryEntry *, DirectoryListing *>::iterator
+         I = DirListings.begin(), E = DirListings.end(); I != E; ++I) {
+    if (!I->second->Complete)
+      continue;
+
+    // A directory that was modified in the second it was read in may have
+    // changed after it was read without its modification time showing it.
+    struct stat StatBuf;
+    if (::stat(I->first->getName(), &StatBuf) ||
+        StatBuf.st_mtime != I->second->ModTime ||
+        I->second->ModTime >= I->second->ReadTime) {
+      Changed = true;
+      break;
+    }
+  }
+
+  if (!Changed)
+    return;
+
+  clearDirectoryListings();
+
+  // The failed lookups may have been answered from the stale listings.
+  for (llvm::StringMap<FileEntry*, llvm::BumpPtrAllocator>::iterator
+         I = FileEntries.begin(), E = FileEntries.end(); I != E; ) {
+    llvm::StringMap<FileEntry*, llvm::BumpPtrAllocator>::iterator Cur = I++;
+    if (Cur->getValue() == NON_EXISTENT_FILE)
+      FileEntries.erase(Cur);
+  }
+  for (llvm::StringMap<DirectoryEntry*, llvm::BumpPtrAllocator>::iterator
+         I = DirEntries.begin(), E = DirEntries.end(); I != E; ) {
+    llvm::StringMap<DirectoryEntry*, llvm::BumpPtrAllocator>::iterator Cur
+      = I++;
+    if (Cur->getValue() == NON_EXISTENT_DIR)
+      DirEntries.erase(Cur);
+  }
+}
+
+void FileManager::takeDirectoryListings(FileManager &Old) {
+  if (!CacheDirListings)
+    return;
+
+  Old.revalidateDirectoryListings();
+
+  // Find the directories without consulting the listings of their parents:
+  // those are about to be taken over as well.
+  CacheDirListings = false;
+  for (llvm::DenseMap<const DirectoryEntry *, DirectoryListing *>::iterator
+         I = Old.DirListings.begin(), E = Old.DirListings.end(); I != E; ++I) {
+    if (!I->second->Complete)
+      continue;
+
+    const DirectoryEntry *Dir = getDirectory(I->first->getName());
+    if (!Dir || DirListings.count(Dir))
+      continue;
+
+    DirListings[Dir] = I->second;
+    I->second = 0;
+  }
+  CacheDirListings = true;
+
+  Old.clearDirectoryListings();
+}
+
 const FileEntry *
 FileManager::getVirtualFile(const llvm::StringRef &Filename,
                             off_t Size, time_t ModificationTime) {
@@ -376,10 +591,97 @@ void FileManager::PrintStats() const {
                << NumDirCacheMisses << " dir cache misses.\n";
   llvm::errs() << NumFileLookups << " file lookups, "
                << NumFileCacheMisses << " file cache misses.\n";
+  if (CacheDirListings)
+    llvm::errs() << NumDirListingsRead << " directory listings read, "
+                 << NumListingMisses << " lookups answered from them.\n";
 
   //llvm::errs() << PagesMapped << BytesOfPagesMapped << FSLookups;
 }
 
+VirtualFileOverlay::~VirtualFileOverlay() {
+  for (llvm::StringMap<Node, llvm::BumpPtrAllocator>::iterator
+         I = Nodes.begin(), E = Nodes.end(); I != E; ++I)
+    delete I->getValue().Buffer;
+}
+
+/// \brief Strip the trailing separators from a path, except for a lone root.
+static llvm::StringRef StripTrailingSeparators(llvm::StringRef Path) {
+  while (Path.size() > 1 && IS_DIR_SEPARATOR_CHAR(Path.back()))
+    Path = Path.substr(0, Path.size() - 1);
+  return Path;
+}
+
+void VirtualFileOverlay::addNode(llvm::StringRef Path,
+                                 const llvm::MemoryBuffer *Buffer,
+                                 time_t ModTime) {
+  Path = StripTrailingSeparators(Path);
+  if (Path.empty())
+    return;
+
+  // Register the parent directories first, keeping any that already exist.
+  for (size_t I = Path.size() - 1; I > 0; --I) {
+    if (!IS_DIR_SEPARATOR_CHAR(Path[I]))
+      continue;
+    llvm::StringRef Parent = StripTrailingSeparators(Path.substr(0, I));
+    llvm::StringMapEntry<Node> &Entry = Nodes.GetOrCreateValue(Parent);
+    if (!Entry.getValue().Inode) {
+      Entry.getValue().Buffer = 0;
+      Entry.getValue().ModTime = ModTime;
+      Entry.getValue().Inode = NextInode++;
+    }
+  }
+
+  llvm::StringMapEntry<Node> &Entry = Nodes.GetOrCreateValue(Path);
+  Node &N = Entry.getValue();
+  if (N.Inode) {
+    // Keep the inode of a replaced file, so that FileManager still sees the
+    // same file.
+    delete N.Buffer;
+  } else
+    N.Inode = NextInode++;
+  N.Buffer = Buffer;
+  N.ModTime = ModTime;
+}
+
+void VirtualFileOverlay::addFile(llvm::StringRef Path,
+                                 const llvm::MemoryBuffer *Buffer,
+                                 time_t ModTime) {
+  assert(Buffer && "No contents for the virtual file?");
+  addNode(Path, Buffer, ModTime);
+}
+
+bool VirtualFileOverlay::contains(llvm::StringRef Path) const {
+  return Nodes.count(StripTrailingSeparators(Path));
+}
+
+const llvm::MemoryBuffer *
+VirtualFileOverlay::getBuffer(llvm::StringRef Path) const {
+  llvm::StringMap<Node, llvm::BumpPtrAllocator>::const_iterator I
+    = Nodes.find(Path);
+  return I == Nodes.end() ? 0 : I->getValue().Buffer;
+}
+
+int VirtualFileOverlay::stat(const char *path, struct stat *buf) {
+  llvm::StringMap<Node, llvm::BumpPtrAllocator>::const_iterator I
+    = Nodes.find(StripTrailingSeparators(path));
+  if (I == Nodes.end())
+    return StatSysCallCache::stat(path, buf);
+
+  // The device number only has to keep the inodes of the overlay apart from
+  // those of real files.
+  const Node &N = I->getValue();
+  memset(buf, 0, sizeof(*buf));
+  buf->st_dev = (dev_t) -1;
+  buf->st_ino = N.Inode;
+  buf->st_mtime = N.ModTime;
+  if (N.Buffer) {
+    buf->st_mode = S_IFREG | 0444;
+    buf->st_size = N.Buffer->getBufferSize();
+  } else
+    buf->st_mode = S_IFDIR | 0555;
+  return 0;
+}
+
 int MemorizeStatCalls::stat(const char *path, struct stat *buf) {
   int result = StatSysCallCache::stat(path, buf);
   
@@ -13,9 +13,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/Builtins.h"
 #include "clang/Basic/LangOptions.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
 
@@ -46,15 +48,142 @@ IdentifierInfoLookup::~IdentifierInfoLookup() {}
 ExternalIdentifierLookup::~ExternalIdentifierLookup() {}
 
 IdentifierTable::IdentifierTable(const LangOptions &LangOpts,
-                                 IdentifierInfoLookup* externalLookup)
+                                 IdentifierInfoLookup* externalLookup,
+                                 const SharedIdentifierTable *sharedBase)
   : HashTable(8192), // Start with space for 8K identifiers.
-    ExternalLookup(externalLookup) {
+    ExternalLookup(externalLookup), SharedBase(0), UseSharedBuiltins(false),
+    NumSharedMaterialized(0), BuiltinLookup(0), NoBuiltins(false) {
+
+  // A shared base made for a language with different keywords is no use.
+  if (sharedBase && sharedBase->isCompatibleWith(LangOpts)) {
+    SharedBase = sharedBase;
+    return;
+  }
 
   // Populate the identifier table with info about keywords for the current
   // language.
   AddKeywords(LangOpts);
 }
 
+IdentifierInfo &
+IdentifierTable::CreateEntry(llvm::StringMapEntry<IdentifierInfo*> &Entry) {
+  void *Mem = getAllocator().Allocate<IdentifierInfo>();
+  IdentifierInfo *II = new (Mem) IdentifierInfo();
+  Entry.setValue(II);
+
+  // Make sure getName() knows how to find the IdentifierInfo
+  // contents.
+  II->Entry = &Entry;
+
+  llvm::StringRef Name(Entry.getKeyData(), Entry.getKeyLength());
+  if (const SharedIdentifierTable::SharedIdentifierInfo *Shared =
+        SharedBase ? SharedBase->lookup(Name) : 0) {
+    ++NumSharedMaterialized;
+    II->setTokenID((tok::TokenKind) Shared->TokenID);
+    if (Shared->IsExtension)
+      II->setIsExtensionToken(true);
+    if (Shared->IsCPPOperatorKeyword)
+      II->setIsCPlusPlusOperatorKeyword();
+
+    // Objective-C keywords follow the language, which the base matches.
+    // Builtins also depend on the target, so only take them if asked to.
+    unsigned ObjCOrBuiltinID = Shared->ObjCOrBuiltinID;
+    if (ObjCOrBuiltinID < tok::NUM_OBJC_KEYWORDS || UseSharedBuiltins)
+      II->setObjCOrBuiltinID(ObjCOrBuiltinID);
+  }
+
+  if (BuiltinLookup)
+    if (unsigned ID = BuiltinLookup->getBuiltinID(Name, NoBuiltins))
+      II->setBuiltinID(ID);
+  return *II;
+}
+
+void IdentifierTable::adoptSharedBuiltins() {
+  assert(SharedBase && "No shared base to take builtins from");
+  UseSharedBuiltins = true;
+
+  // Identifiers created before now missed out on their builtin IDs.
+  for (HashTableTy::iterator I = HashTable.begin(), E = HashTable.end();
+       I != E; ++I)
+    if (unsigned ID = SharedBase->getBuiltinID(I->getKey()))
+      I->getValue()->setBuiltinID(ID);
+}
+
+void IdentifierTable::setBuiltinLookup(const Builtin::Context *Builtins,
+                                       bool noBuiltins) {
+  BuiltinLookup = Builtins;
+  NoBuiltins = noBuiltins;
+
+  for (HashTableTy::iterator I = HashTable.begin(), E = HashTable.end();
+       I != E; ++I)
+    if (unsigned ID = Builtins->getBuiltinID(I->getKey(), NoBuiltins))
+      I->getValue()->setBuiltinID(ID);
+}
+
+void IdentifierTable::materializeBuiltins() {
+  if (!BuiltinLookup)
+    return;
+
+  llvm::SmallVector<const char *, 32> Names;
+  BuiltinLookup->GetBuiltinNames(Names, NoBuiltins);
+  for (unsigned I = 0, N = Names.size(); I != N; ++I)
+    get(Names[I]);
+}
+
+//===----------------------------------------------------------------------===//
+// SharedIdentifierTable Implementation
+//===----------------------------------------------------------------------===//
+
+SharedIdentifierTable::SharedIdentifierTable(const LangOptions &LangOpts)
+  : Seed(new IdentifierTable(LangOpts)),
+    KeywordLangBits(getKeywordLangBits(LangOpts)), NumBuiltins(0) {}
+
+SharedIdentifierTable::~SharedIdentifierTable() {}
+
+void SharedIdentifierTable::freeze() {
+  assert(!isFrozen() && "Shared identifier table is already frozen");
+
+  // The base has to carry every builtin its seed recognizes, not only the
+  // ones that happen to have been used.
+  Seed->materializeBuiltins();
+  for (IdentifierTable::iterator I = Seed->begin(), E = Seed->end();
+       I != E; ++I) {
+    const IdentifierInfo &II = *I->getValue();
+    SharedIdentifierInfo Info;
+    Info.TokenID = II.TokenID;
+    Info.ObjCOrBuiltinID = II.ObjCOrBuiltinID;
+    Info.IsExtension = II.IsExtension;
+    Info.IsCPPOperatorKeyword = II.IsCPPOperatorKeyword;
+    HashTable.GetOrCreateValue(I->getKey(), Info);
+
+    if (II.getBuiltinID())
+      ++NumBuiltins;
+  }
+  Seed.reset();
+}
+
+bool SharedIdentifierTable::isCompatibleWith(const LangOptions &LangOpts)
+  const {
+  return isFrozen() && KeywordLangBits == getKeywordLangBits(LangOpts);
+}
+
+unsigned SharedIdentifierTable::getBuiltinID(llvm::StringRef Name) const {
+  const SharedIdentifierInfo *Info = lookup(Name);
+  if (!Info || Info->ObjCOrBuiltinID < tok::NUM_OBJC_KEYWORDS)
+    return 0;
+  return Info->ObjCOrBuiltinID - tok::NUM_OBJC_KEYWORDS;
+}
+
+/// getKeywordLangBits - Pack the language options that AddKeywords looks at
+/// into a single word.
+unsigned SharedIdentifierTable::getKeywordLangBits(const LangOptions &LangOpts){
+  return (LangOpts.CPlusPlus << 0) | (LangOpts.CPlusPlus0x << 1) |
+         (LangOpts.C99 << 2) | (LangOpts.GNUMode << 3) |
+         (LangOpts.Microsoft << 4) | (LangOpts.Bool << 5) |
+         (LangOpts.AltiVec << 6) | (LangOpts.CXXOperatorNames << 7) |
+         (LangOpts.ObjC1 << 8) | (LangOpts.ObjC2 << 9);
+}
+
 //===----------------------------------------------------------------------===//
 // Language Keyword Implementation
 //===----------------------------------------------------------------------===//
@@ -219,6 +348,9 @@ void IdentifierTable::PrintStats() const {
   fprintf(stderr, "Ave identifier length: %f\n",
           (AverageIdentifierSize/(double)NumIdentifiers));
   fprintf(stderr, "Max identifier length: %d\n", MaxIdentifierLength);
+  if (SharedBase)
+    fprintf(stderr, "Identifiers created from the shared base: %d of %d\n",
+            NumSharedMaterialized, SharedBase->size());
 
   // Compute statistics about the memory allocated for identifiers.
   HashTable.getAllocator().PrintStats();
@@ -0,0 +1,181 @@
+//===--- PhaseStatistics.cpp - Per-phase timers and counters --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the PhaseStatistics interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/PhaseStatistics.h"
+#include "clang/Basic/JSONWriter.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Process.h"
+#include "llvm/System/TimeValue.h"
+#include <cstring>
+using namespace clang;
+
+PhaseStatistics *PhaseStatistics::Active = 0;
+
+static double getSeconds(const llvm::sys::TimeValue &T) {
+  return T.seconds() + T.microseconds() / 1000000.0;
+}
+
+PhaseStatistics::~PhaseStatistics() {
+  if (Active == this)
+    Active = 0;
+  reset();
+}
+
+void PhaseStatistics::reset() {
+  for (unsigned i = 0, e = Phases.size(); i != e; ++i)
+    delete Phases[i];
+  Phases.clear();
+  Running.clear();
+  ChildMap.clear();
+  Counters.clear();
+  Root = 0;
+}
+
+void PhaseStatistics::startActivation(Phase *P) {
+  llvm::sys::TimeValue Wall, User, System;
+  llvm::sys::Process::GetTimeUsage(Wall, User, System);
+
+  Activation A;
+  A.P = P;
+  A.WallStart = getSeconds(Wall);
+  A.UserStart = getSeconds(User);
+  A.SystemStart = getSeconds(System);
+  A.MemoryStart = llvm::sys::Process::GetMallocUsage();
+  Running.push_back(A);
+}
+
+void PhaseStatistics::stopActivations(unsigned NewSize) {
+  if (NewSize >= Running.size())
+    return;
+
+  llvm::sys::TimeValue Wall, User, System;
+  llvm::sys::Process::GetTimeUsage(Wall, User, System);
+  double WallNow = getSeconds(Wall), UserNow = getSeconds(User);
+  double SystemNow = getSeconds(System);
+  size_t MemoryNow = llvm::sys::Process::GetMallocUsage();
+
+  while (Running.size() != NewSize) {
+    const Activation &A = Running.back();
+    ++A.P->Count;
+    A.P->WallTime += WallNow - A.WallStart;
+    A.P->UserTime += UserNow - A.UserStart;
+    A.P->SystemTime += SystemNow - A.SystemStart;
+    A.P->MemoryGrowth += (int64_t) MemoryNow - (int64_t) A.MemoryStart;
+    Running.pop_back();
+  }
+}
+
+void PhaseStatistics::beginTranslationUnit(llvm::StringRef File) {
+  reset();
+  Root = new Phase("Translation unit", File, 0);
+  Phases.push_back(Root);
+  startActivation(Root);
+}
+
+PhaseStatistics::Phase *PhaseStatistics::enterPhase(const char *Name,
+                                                    llvm::StringRef Detail) {
+  if (!Root)
+    return 0;
+
+  Phase *Parent = Running.empty() ? Root : Running.back().P;
+  Phase *&P = ChildMap[ChildKey(Parent, std::make_pair(std::string(Name),
+                                                       Detail.str()))];
+  if (!P) {
+    P = new Phase(Name, Detail, Parent);
+    Phases.push_back(P);
+    Parent->Children.push_back(P);
+  }
+
+  startActivation(P);
+  return P;
+}
+
+void PhaseStatistics::exitPhase(Phase *P) {
+  for (unsigned i = Running.size(); i != 0; --i)
+    if (Running[i-1].P == P) {
+      stopActivations(i-1);
+      return;
+    }
+}
+
+void PhaseStatistics::exitPhase(const char *Name) {
+  // The root stays running until the end of the translation unit.
+  for (unsigned i = Running.size(); i > 1; --i)
+    if (strcmp(Running[i-1].P->Name, Name) == 0) {
+      stopActivations(i-1);
+      return;
+    }
+}
+
+static void WritePhase(llvm::raw_ostream &OS, const PhaseStatistics::Phase &P,
+                       unsigned Indent) {
+  OS.indent(Indent) << "{ \"name\": ";
+  WriteJSONString(OS, P.Name);
+  if (!P.Detail.empty()) {
+    OS << ", \"detail\": ";
+    WriteJSONString(OS, P.Detail);
+  }
+  OS << ", \"count\": " << P.Count
+     << llvm::format(", \"wall\": %.6f, \"user\": %.6f, \"system\": %.6f",
+                     P.WallTime, P.UserTime, P.SystemTime)
+     << ", \"memory\": " << P.MemoryGrowth;
+
+  if (!P.Children.empty()) {
+    OS << ",\n";
+    OS.indent(Indent + 2) << "\"children\": [\n";
+    for (unsigned i = 0, e = P.Children.size(); i != e; ++i) {
+      if (i)
+        OS << ",\n";
+      WritePhase(OS, *P.Children[i], Indent + 4);
+    }
+    OS << "\n";
+    OS.indent(Indent + 2) << "]";
+  }
+  OS << " }";
+}
+
+void PhaseStatistics::endTranslationUnit() {
+  if (!Root)
+    return;
+
+  stopActivations(0);
+
+  std::string Record;
+  llvm::raw_string_ostream OS(Record);
+  OS << "  {\n    \"file\": ";
+  WriteJSONString(OS, Root->Detail);
+  OS << ",\n    \"counters\": {";
+  bool First = true;
+  for (llvm::StringMap<uint64_t>::const_iterator I = Counters.begin(),
+       E = Counters.end(); I != E; ++I) {
+    OS << (First ? " " : ", ");
+    WriteJSONString(OS, I->getKey());
+    OS << ": " << I->getValue();
+    First = false;
+  }
+  OS << " },\n    \"phases\":\n";
+  WritePhase(OS, *Root, 4);
+  OS << "\n  }";
+  OS.flush();
+
+  Records.push_back(Record);
+  reset();
+}
+
+void PhaseStatistics::WriteJSON(llvm::raw_ostream &OS) const {
+  OS << "[\n";
+  for (unsigned i = 0, e = Records.size(); i != e; ++i)
+    OS << Records[i] << (i + 1 != e ? ",\n" : "\n");
+  OS << "]\n";
+}
@@ -15,20 +15,156 @@
 #include "clang/Basic/SourceManagerInternals.h"
 #include "clang/Basic/FileManager.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Mutex.h"
 #include "llvm/System/Path.h"
 #include <algorithm>
+#include <map>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 using namespace clang;
 using namespace SrcMgr;
 using llvm::MemoryBuffer;
 
+//===----------------------------------------------------------------------===//
+// Shared File Buffer Pool
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// FileBufferPool - The process-wide pool of file buffers used by
+/// SourceManagers that share file buffers.  Files are identified by device,
+/// inode, modification time and size, so a file that changes on disk never
+/// shares a buffer with its older contents.  Buffers are reference counted
+/// and deleted (unmapping large files) when the last reference goes away.
+class FileBufferPool {
+  struct FileKey {
+    dev_t Device;
+    ino_t Inode;
+    time_t ModTime;
+    off_t Size;
+
+    explicit FileKey(const FileEntry *FE)
+      : Device(FE->getDevice()), Inode(FE->getInode()),
+        ModTime(FE->getModificationTime()), Size(FE->getSize()) {}
+
+    bool operator<(const FileKey &RHS) const {
+      if (Device != RHS.Device) return Device < RHS.Device;
+      if (Inode != RHS.Inode) return Inode < RHS.Inode;
+      if (ModTime != RHS.ModTime) return ModTime < RHS.ModTime;
+      return Size < RHS.Size;
+    }
+  };
+
+  struct PoolEntry {
+    const MemoryBuffer *Buffer;
+    unsigned RefCount;
+  };
+
+  std::map<FileKey, PoolEntry> Buffers;
+  llvm::sys::Mutex Lock;
+
+public:
+  ~FileBufferPool() {
+    for (std::map<FileKey, PoolEntry>::iterator I = Buffers.begin(),
+         E = Buffers.end(); I != E; ++I)
+      delete I->second.Buffer;
+  }
+
+  /// acquire - Return a reference to the buffer for the given file, loading
+  /// it if no SourceManager holds it.  If \arg Verify is set, a newly loaded
+  /// file must still match the modification time and size recorded in the
+  /// FileEntry.  Returns null on error.  The file is read without holding the
+  /// lock, so several threads can load different files at once.
+  const MemoryBuffer *acquire(const FileEntry *FE, bool Verify,
+                              std::string *ErrorStr) {
+    FileKey Key(FE);
+    {
+      llvm::sys::ScopedLock Guard(Lock);
+      std::map<FileKey, PoolEntry>::iterator I = Buffers.find(Key);
+      if (I != Buffers.end()) {
+        ++I->second.RefCount;
+        return I->second.Buffer;
+      }
+    }
+
+    if (Verify) {
+      struct stat StatBuf;
+      if (::stat(FE->getName(), &StatBuf) != 0 ||
+          StatBuf.st_mtime != FE->getModificationTime() ||
+          StatBuf.st_size != FE->getSize()) {
+        if (ErrorStr)
+          *ErrorStr = "file has been modified since it was first read";
+        return 0;
+      }
+    }
+
+    const MemoryBuffer *Buffer =
+      MemoryBuffer::getFile(FE->getName(), ErrorStr, FE->getSize());
+    if (!Buffer)
+      return 0;
+
+    llvm::sys::ScopedLock Guard(Lock);
+    std::map<FileKey, PoolEntry>::iterator I = Buffers.find(Key);
+    if (I != Buffers.end()) {
+      // Another thread loaded the file while we were reading it.
+      delete Buffer;
+      ++I->second.RefCount;
+      return I->second.Buffer;
+    }
+
+    PoolEntry &Entry = Buffers[Key];
+    Entry.Buffer = Buffer;
+    Entry.RefCount = 1;
+    return Buffer;
+  }
+
+  /// release - Drop a reference to the buffer for the given file.
+  void release(const FileEntry *FE, const MemoryBuffer *Buffer) {
+    llvm::sys::ScopedLock Guard(Lock);
+    std::map<FileKey, PoolEntry>::iterator I = Buffers.find(FileKey(FE));
+    assert(I != Buffers.end() && I->second.Buffer == Buffer &&
+           "Releasing a buffer that is not in the pool!");
+    (void)Buffer;
+    if (--I->second.RefCount == 0) {
+      delete I->second.Buffer;
+      Buffers.erase(I);
+    }
+  }
+};
+} // end anonymous namespace
+
+static llvm::ManagedStatic<FileBufferPool> SharedFileBuffers;
+
+const MemoryBuffer *
+SourceManager::acquireSharedFileBuffer(const FileEntry *FE,
+                                       std::string *ErrorStr) {
+  return SharedFileBuffers->acquire(FE, /*Verify=*/true, ErrorStr);
+}
+
+void SourceManager::releaseSharedFileBuffer(const FileEntry *FE,
+                                            const MemoryBuffer *Buffer) {
+  SharedFileBuffers->release(FE, Buffer);
+}
+
 //===----------------------------------------------------------------------===//
 // SourceManager Helper Classes
 //===----------------------------------------------------------------------===//
 
 ContentCache::~ContentCache() {
-  delete Buffer;
+  delete [] SourceLineCache;
+  if (IsBufferShared && Buffer)
+    SharedFileBuffers->release(Entry, Buffer);
+  else
+    delete Buffer;
 }
 
 /// getSizeBytesMapped - Returns the number of bytes actually mapped for
@@ -49,14 +185,35 @@ unsigned ContentCache::getSize() const {
 void ContentCache::replaceBuffer(const llvm::MemoryBuffer *B) {
   assert(B != Buffer);
   
-  delete Buffer;
+  if (IsBufferShared) {
+    if (Buffer)
+      SharedFileBuffers->release(Entry, Buffer);
+    IsBufferShared = false;
+  } else
+    delete Buffer;
   Buffer = B;
+  BufferOverridden = true;
+}
+
+unsigned ContentCache::releaseBuffer() {
+  if (!IsBufferShared || !Buffer)
+    return 0;
+
+  unsigned Size = Buffer->getBufferSize();
+  SharedFileBuffers->release(Entry, Buffer);
+  Buffer = 0;
+  WasReleased = true;
+  return Size;
 }
 
 const llvm::MemoryBuffer *ContentCache::getBuffer(std::string *ErrorStr) const {
   // Lazily create the Buffer for ContentCaches that wrap files.
   if (!Buffer && Entry) {
-    Buffer = MemoryBuffer::getFile(Entry->getName(), ErrorStr,Entry->getSize());
+    if (IsBufferShared)
+      Buffer = SharedFileBuffers->acquire(Entry, WasReleased, ErrorStr);
+    else
+      Buffer = MemoryBuffer::getFile(Entry->getName(), ErrorStr,
+                                     Entry->getSize());
 
     // If we were unable to open the file, then we are in an inconsistent
     // situation where the content cache referenced a file which no longer
@@ -69,6 +226,8 @@ const llvm::MemoryBuffer *ContentCache::getBuffer(std::string *ErrorStr) const {
     // that we are in an inconsistent situation and error out as quickly as
     // possible.
     if (!Buffer) {
+      // The replacement buffer is owned by this ContentCache.
+      IsBufferShared = false;
       const llvm::StringRef FillStr("<<<MISSING SOURCE FILE>>>\n");
       Buffer = MemoryBuffer::getNewMemBuffer(Entry->getSize(), "<invalid>");
       char *Ptr = const_cast<char*>(Buffer->getBufferStart());
@@ -251,6 +410,16 @@ void SourceManager::AddLineNote(SourceLocation Loc, unsigned LineNo,
                          EntryExit, FileKind);
 }
 
+void SourceManager::AddLineEntries(FileID FID,
+                                   const std::vector<LineEntry> &Entries) {
+  const SrcMgr::FileInfo &FileInfo = getSLocEntry(FID).getFile();
+
+  // Remember that this file has #line directives now if it doesn't already.
+  const_cast<SrcMgr::FileInfo&>(FileInfo).setHasLineDirectives();
+
+  getLineTable().AddEntry(FID.ID, Entries);
+}
+
 LineTableInfo &SourceManager::getLineTable() {
   if (LineTable == 0)
     LineTable = new LineTableInfo();
@@ -281,9 +450,13 @@ SourceManager::~SourceManager() {
 void SourceManager::clearIDTables() {
   MainFileID = FileID();
   SLocEntryTable.clear();
+  FileSLocOffsets.clear();
+  FileSLocIDs.clear();
+  FirstIndexedSLocEntry = 0;
   LastLineNoFileIDQuery = FileID();
   LastLineNoContentCache = 0;
   LastFileIDLookup = FileID();
+  TokenLengths.clear();
 
   if (LineTable)
     LineTable->clear();
@@ -309,7 +482,18 @@ SourceManager::getOrCreateContentCache(const FileEntry *FileEnt) {
   unsigned EntryAlign = llvm::AlignOf<ContentCache>::Alignment;
   EntryAlign = std::max(8U, EntryAlign);
   Entry = ContentCacheAlloc.Allocate<ContentCache>(1, EntryAlign);
-  new (Entry) ContentCache(FileEnt);
+
+  // Files that only exist in memory are never read or shared; the content
+  // cache gets its own view of the overlay's buffer.
+  const MemoryBuffer *Virtual
+    = FileOverlay ? FileOverlay->getBuffer(FileEnt->getName()) : 0;
+  new (Entry) ContentCache(FileEnt, ShareFileBuffers && !Virtual);
+  if (Virtual) {
+    const char *Name = Virtual->getBufferIdentifier();
+    Entry->replaceBuffer(MemoryBuffer::getMemBuffer(Virtual->getBufferStart(),
+                                                  Virtual->getBufferEnd(),
+                                                  Name));
+  }
   return Entry;
 }
 
@@ -330,14 +514,33 @@ SourceManager::createMemBufferContentCache(const MemoryBuffer *Buffer) {
   return Entry;
 }
 
+unsigned SourceManager::releaseFileBuffers() {
+  unsigned NumBytes = 0;
+  for (llvm::DenseMap<const FileEntry*, SrcMgr::ContentCache*>::iterator
+       I = FileInfos.begin(), E = FileInfos.end(); I != E; ++I) {
+    if (unsigned Size = I->second->releaseBuffer()) {
+      NumBytes += Size;
+      ++NumBuffersReleased;
+    }
+  }
+  return NumBytes;
+}
+
 void SourceManager::PreallocateSLocEntries(ExternalSLocEntrySource *Source,
                                            unsigned NumSLocEntries,
                                            unsigned NextOffset) {
   ExternalSLocEntries = Source;
+  PreallocatedSLocOffsets = 0;
   this->NextOffset = NextOffset;
   SLocEntryLoaded.resize(NumSLocEntries + 1);
   SLocEntryLoaded[0] = true;
   SLocEntryTable.resize(SLocEntryTable.size() + NumSLocEntries);
+
+  // The preallocated entries are filled in lazily, so only index the entries
+  // created after them.
+  FileSLocOffsets.clear();
+  FileSLocIDs.clear();
+  FirstIndexedSLocEntry = SLocEntryTable.size();
 }
 
 void SourceManager::ClearPreallocatedSLocEntries() {
@@ -354,6 +557,10 @@ void SourceManager::ClearPreallocatedSLocEntries() {
   SLocEntryTable.resize(I);
   SLocEntryLoaded.clear();
   ExternalSLocEntries = 0;
+  PreallocatedSLocOffsets = 0;
+  FileSLocOffsets.clear();
+  FileSLocIDs.clear();
+  FirstIndexedSLocEntry = SLocEntryTable.size();
 }
 
 
@@ -387,6 +594,8 @@ FileID SourceManager::createFileID(const ContentCache *File,
   SLocEntryTable.push_back(SLocEntry::get(NextOffset,
                                           FileInfo::get(IncludePos, File,
                                                         FileCharacter)));
+  FileSLocOffsets.push_back(NextOffset);
+  FileSLocIDs.push_back(SLocEntryTable.size()-1);
   unsigned FileSize = File->getSize();
   assert(NextOffset+FileSize+1 > NextOffset && "Ran out of source locations!");
   NextOffset += FileSize+1;
@@ -441,9 +650,20 @@ bool SourceManager::overrideFileContents(const FileEntry *SourceFile,
     return true;
 
   const_cast<SrcMgr::ContentCache *>(IR)->replaceBuffer(Buffer);
+  TokenLengths.clear();
   return false;
 }
 
+FileID SourceManager::createFileIDForEditedFile(const FileEntry *SourceFile,
+                                               const MemoryBuffer *Buffer) {
+  // The content cache is not the one of the file, which the FileIDs created
+  // for it so far share, but it still names the file.
+  ContentCache *Entry
+    = const_cast<ContentCache *>(createMemBufferContentCache(Buffer));
+  Entry->Entry = SourceFile;
+  return createFileID(Entry, SourceLocation(), SrcMgr::C_User, 0, 0);
+}
+
 /// getBufferData - Return a pointer to the start and end of the source buffer
 /// data for the specified FileID.
 std::pair<const char*, const char*>
@@ -462,9 +682,16 @@ SourceManager::getBufferData(FileID FID) const {
 /// SourceLocation object.  It is responsible for finding the entry in
 /// SLocEntryTable which contains the specified location.
 ///
-FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
+FileID SourceManager::getFileIDSlow(unsigned SLocOffset,
+                                    bool IsFileLoc) const {
   assert(SLocOffset && "Invalid FileID");
 
+  // File locations can only be in file entries.  If the entry is in the
+  // indexed part of the table, search the index of file entries.
+  if (IsFileLoc && FirstIndexedSLocEntry < SLocEntryTable.size() &&
+      SLocEntryTable[FirstIndexedSLocEntry].getOffset() <= SLocOffset)
+    return getFileIDFromIndex(SLocOffset);
+
   // After the first and second level caches, I see two common sorts of
   // behavior: 1) a lot of searched FileID's are "near" the cached file location
   // or are "near" the cached instantiation location.  2) others are just
@@ -491,20 +718,20 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
   unsigned NumProbes = 0;
   while (1) {
     --I;
-    if (ExternalSLocEntries)
-      getSLocEntry(FileID::get(I - SLocEntryTable.begin()));
-    if (I->getOffset() <= SLocOffset) {
+    // Only the entry that is found is loaded from an external source.
+    unsigned Index = I - SLocEntryTable.begin();
+    if (getSLocEntryOffset(Index) <= SLocOffset) {
 #if 0
       printf("lin %d -> %d [%s] %d %d\n", SLocOffset,
              I-SLocEntryTable.begin(),
              I->isInstantiation() ? "inst" : "file",
              LastFileIDLookup.ID,  int(SLocEntryTable.end()-I));
 #endif
-      FileID Res = FileID::get(I-SLocEntryTable.begin());
+      FileID Res = FileID::get(Index);
 
       // If this isn't an instantiation, remember it.  We have good locality
       // across FileID lookups.
-      if (!I->isInstantiation())
+      if (!getSLocEntry(Res).isInstantiation())
         LastFileIDLookup = Res;
       NumLinearScans += NumProbes+1;
       return Res;
@@ -523,7 +750,7 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
   NumProbes = 0;
   while (1) {
     unsigned MiddleIndex = (GreaterIndex-LessIndex)/2+LessIndex;
-    unsigned MidOffset = getSLocEntry(FileID::get(MiddleIndex)).getOffset();
+    unsigned MidOffset = getSLocEntryOffset(MiddleIndex);
 
     ++NumProbes;
 
@@ -546,7 +773,7 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
 
       // If this isn't an instantiation, remember it.  We have good locality
       // across FileID lookups.
-      if (!I->isInstantiation())
+      if (!getSLocEntry(Res).isInstantiation())
         LastFileIDLookup = Res;
       NumBinaryProbes += NumProbes;
       return Res;
@@ -557,6 +784,31 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
   }
 }
 
+/// getFileIDFromIndex - Return the FileID of the file entry containing the
+/// file location at \arg SLocOffset, which must be at or after
+/// FirstIndexedSLocEntry.
+FileID SourceManager::getFileIDFromIndex(unsigned SLocOffset) const {
+  assert(!FileSLocOffsets.empty() && FileSLocOffsets[0] <= SLocOffset &&
+         "File location is not in the indexed part of the table");
+
+  // Find the last file entry that starts at or before SLocOffset.
+  unsigned Low = 0, High = FileSLocOffsets.size();
+  while (High - Low > 1) {
+    unsigned Middle = Low + (High - Low) / 2;
+    if (FileSLocOffsets[Middle] <= SLocOffset)
+      Low = Middle;
+    else
+      High = Middle;
+    ++NumFileIndexProbes;
+  }
+  ++NumFileIndexLookups;
+
+  FileID Res = FileID::get(FileSLocIDs[Low]);
+  assert(isOffsetInFileID(Res, SLocOffset) && "File index is out of date");
+  LastFileIDLookup = Res;
+  return Res;
+}
+
 SourceLocation SourceManager::
 getInstantiationLocSlowCase(SourceLocation Loc) const {
   do {
@@ -680,6 +932,14 @@ const char *SourceManager::getCharacterData(SourceLocation SL) const {
 /// getColumnNumber - Return the column # for the specified file position.
 /// this is significantly cheaper to compute than the line number.
 unsigned SourceManager::getColumnNumber(FileID FID, unsigned FilePos) const {
+  // If the line of this position was just looked up, it starts at the offset
+  // in the line table, and the buffer need not be paged in.
+  if (LastLineNoFileIDQuery == FID && LastLineNoContentCache &&
+      LastLineNoContentCache->SourceLineCache &&
+      LastLineNoFilePos == FilePos+1)
+    return FilePos -
+           LastLineNoContentCache->SourceLineCache[LastLineNoResult-1] + 1;
+
   const char *Buf = getBuffer(FID)->getBufferStart();
 
   unsigned LineStart = FilePos;
@@ -702,16 +962,62 @@ unsigned SourceManager::getInstantiationColumnNumber(SourceLocation Loc) const {
 
 
 
-static DISABLE_INLINE void ComputeLineNumbers(ContentCache* FI,
-                                              llvm::BumpPtrAllocator &Alloc);
-static void ComputeLineNumbers(ContentCache* FI, llvm::BumpPtrAllocator &Alloc){
-  // Note that calling 'getBuffer()' may lazily page in the file.
-  const MemoryBuffer *Buffer = FI->getBuffer();
+/// SkipLineContents - Skip over characters other than '\n', '\r' and nul
+/// starting at Buf, 16 bytes at a time.  Never reads at or past End, so the
+/// caller's scalar loop still sees the nul terminator and the tail of the
+/// buffer.  When no vector unit is available, Buf is returned unchanged.
+static inline const unsigned char *SkipLineContents(const unsigned char *Buf,
+                                                    const unsigned char *End) {
+#if defined(__SSE2__)
+  const __m128i Zero = _mm_setzero_si128();
+  const __m128i NewLine = _mm_set1_epi8('\n'), Return = _mm_set1_epi8('\r');
+  while (Buf+16 <= End) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)Buf);
+    __m128i Stop = _mm_or_si128(_mm_cmpeq_epi8(Chunk, Zero),
+                                _mm_or_si128(_mm_cmpeq_epi8(Chunk, NewLine),
+                                             _mm_cmpeq_epi8(Chunk, Return)));
+    if (unsigned Mask = _mm_movemask_epi8(Stop))
+      return Buf + llvm::CountTrailingZeros_32(Mask);
+    Buf += 16;
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  while (Buf+16 <= End) {
+    uint8x16_t Chunk = vld1q_u8(Buf);
+    uint8x16_t Stop = vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8(0)),
+                               vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8('\n')),
+                                        vceqq_u8(Chunk, vdupq_n_u8('\r'))));
+    uint64x2_t Lanes = vreinterpretq_u64_u8(Stop);
+    if (vgetq_lane_u64(Lanes, 0) | vgetq_lane_u64(Lanes, 1))
+      break;
+    Buf += 16;
+  }
+#endif
+  return Buf;
+}
 
+static DISABLE_INLINE void ComputeLineNumbers(ContentCache* FI,
+                                         ExternalSLocEntrySource *External);
+static void ComputeLineNumbers(ContentCache* FI,
+                               ExternalSLocEntrySource *External) {
   // Find the file offsets of all of the *physical* source lines.  This does
   // not look at trigraphs, escaped newlines, or anything else tricky.
   std::vector<unsigned> LineOffsets;
 
+  // The external source may know the lines of the file as it is on disk
+  // (e.g. the PCH file that includes it), which saves reading and scanning it.
+  if (External && FI->Entry && !FI->isBufferOverridden() &&
+      External->ReadLineOffsets(FI->Entry, LineOffsets) &&
+      !LineOffsets.empty()) {
+    FI->NumLines = LineOffsets.size();
+    FI->SourceLineCache = new unsigned[LineOffsets.size()];
+    std::copy(LineOffsets.begin(), LineOffsets.end(), FI->SourceLineCache);
+    return;
+  }
+  LineOffsets.clear();
+
+  // Note that calling 'getBuffer()' may lazily page in the file.
+  const MemoryBuffer *Buffer = FI->getBuffer();
+
   // Line #1 starts at char 0.
   LineOffsets.push_back(0);
 
@@ -719,10 +1025,9 @@ static void ComputeLineNumbers(ContentCache* FI, llvm::BumpPtrAllocator &Alloc){
   const unsigned char *End = (const unsigned char *)Buffer->getBufferEnd();
   unsigned Offs = 0;
   while (1) {
-    // Skip over the contents of the line.
-    // TODO: Vectorize this?  This is very performance sensitive for programs
-    // with lots of diagnostics and in -E mode.
-    const unsigned char *NextBuf = (const unsigned char *)Buf;
+    // Skip over the contents of the line.  This is very performance sensitive
+    // for programs with lots of diagnostics and in -E mode.
+    const unsigned char *NextBuf = SkipLineContents(Buf, End);
     while (*NextBuf != '\n' && *NextBuf != '\r' && *NextBuf != '\0')
       ++NextBuf;
     Offs += NextBuf-Buf;
@@ -744,10 +1049,20 @@ static void ComputeLineNumbers(ContentCache* FI, llvm::BumpPtrAllocator &Alloc){
 
   // Copy the offsets into the FileInfo structure.
   FI->NumLines = LineOffsets.size();
-  FI->SourceLineCache = Alloc.Allocate<unsigned>(LineOffsets.size());
+  FI->SourceLineCache = new unsigned[LineOffsets.size()];
   std::copy(LineOffsets.begin(), LineOffsets.end(), FI->SourceLineCache);
 }
 
+const unsigned *
+SourceManager::getLineOffsets(const ContentCache *Content,
+                              unsigned &NumLines) const {
+  ContentCache *C = const_cast<ContentCache *>(Content);
+  if (C->SourceLineCache == 0)
+    ComputeLineNumbers(C, ExternalSLocEntries);
+  NumLines = C->NumLines;
+  return C->SourceLineCache;
+}
+
 /// getLineNumber - Given a SourceLocation, return the spelling line number
 /// for the position indicated.  This requires building and caching a table of
 /// line offsets for the MemoryBuffer, so this is not cheap: use only when
@@ -763,7 +1078,7 @@ unsigned SourceManager::getLineNumber(FileID FID, unsigned FilePos) const {
   // If this is the first use of line information for this buffer, compute the
   /// SourceLineCache for it on demand.
   if (Content->SourceLineCache == 0)
-    ComputeLineNumbers(Content, ContentCacheAlloc);
+    ComputeLineNumbers(Content, ExternalSLocEntries);
 
   // Okay, we know we have a line number table.  Do a binary search to find the
   // line number that this character position lands on.
@@ -978,7 +1293,7 @@ SourceLocation SourceManager::getLocation(const FileEntry *SourceFile,
   // If this is the first use of line information for this buffer, compute the
   /// SourceLineCache for it on demand.
   if (Content->SourceLineCache == 0)
-    ComputeLineNumbers(Content, ContentCacheAlloc);
+    ComputeLineNumbers(Content, ExternalSLocEntries);
 
   if (Line > Content->NumLines)
     return SourceLocation();
@@ -1126,15 +1441,76 @@ void SourceManager::PrintStats() const {
 
   unsigned NumLineNumsComputed = 0;
   unsigned NumFileBytesMapped = 0;
+  unsigned NumSharedBuffers = 0;
   for (fileinfo_iterator I = fileinfo_begin(), E = fileinfo_end(); I != E; ++I){
     NumLineNumsComputed += I->second->SourceLineCache != 0;
     NumFileBytesMapped  += I->second->getSizeBytesMapped();
+    NumSharedBuffers    += I->second->isBufferShared();
   }
 
   llvm::errs() << NumFileBytesMapped << " bytes of files mapped, "
                << NumLineNumsComputed << " files with line #'s computed.\n";
+  llvm::errs() << NumSharedBuffers << " files with shared buffers, "
+               << NumBuffersReleased << " shared buffers released.\n";
   llvm::errs() << "FileID scans: " << NumLinearScans << " linear, "
                << NumBinaryProbes << " binary.\n";
+  llvm::errs() << FileSLocIDs.size() << " file entries indexed, "
+               << NumFileIndexLookups << " file index lookups, "
+               << NumFileIndexProbes << " probes.\n";
+  llvm::errs() << NumTokenLengthLookups << " token lengths measured, "
+               << NumTokenLengthsCached << " answered from the cache.\n";
+}
+
+size_t SourceManager::getContentBytes() const {
+  size_t Bytes = 0;
+  for (fileinfo_iterator I = fileinfo_begin(), E = fileinfo_end(); I != E; ++I)
+    Bytes += I->second->getSizeBytesMapped();
+  for (unsigned i = 0, e = MemBufferInfos.size(); i != e; ++i)
+    Bytes += MemBufferInfos[i]->getSizeBytesMapped();
+  return Bytes;
+}
+
+static size_t getLineTableBytes(const ContentCache *Content) {
+  return Content->SourceLineCache ? Content->NumLines * sizeof(unsigned) : 0;
+}
+
+size_t SourceManager::getLineTableBytes() const {
+  size_t Bytes = 0;
+  for (fileinfo_iterator I = fileinfo_begin(), E = fileinfo_end(); I != E; ++I)
+    Bytes += ::getLineTableBytes(I->second);
+  for (unsigned i = 0, e = MemBufferInfos.size(); i != e; ++i)
+    Bytes += ::getLineTableBytes(MemBufferInfos[i]);
+  return Bytes;
+}
+
+size_t SourceManager::getDataStructureBytes() const {
+  return ContentCacheAlloc.getTotalMemory() +
+         SLocEntryTable.capacity() * sizeof(SrcMgr::SLocEntry) +
+         (FileSLocOffsets.capacity() + FileSLocIDs.capacity()) *
+           sizeof(unsigned) +
+         SLocEntryLoaded.capacity() / 8;
+}
+
+static void releaseLineTable(ContentCache *Content) {
+  delete [] Content->SourceLineCache;
+  Content->SourceLineCache = 0;
+  Content->NumLines = 0;
+}
+
+void SourceManager::releaseLineTables() {
+  for (fileinfo_iterator I = fileinfo_begin(), E = fileinfo_end(); I != E; ++I)
+    releaseLineTable(I->second);
+  for (unsigned i = 0, e = MemBufferInfos.size(); i != e; ++i)
+    releaseLineTable(MemBufferInfos[i]);
+
+  // The cache of the last line number query points into the tables.
+  LastLineNoFileIDQuery = FileID();
+  LastLineNoContentCache = 0;
 }
 
 ExternalSLocEntrySource::~ExternalSLocEntrySource() { }
+
+bool ExternalSLocEntrySource::ReadLineOffsets(const FileEntry *File,
+                                              std::vector<unsigned> &Offsets) {
+  return false;
+}
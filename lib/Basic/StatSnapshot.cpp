@@ -0,0 +1,249 @@
+//===--- StatSnapshot.cpp - Shared snapshot of stat() results -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the StatSnapshotCache, StatSnapshotWriter and
+//  StatSnapshotRecorder interfaces.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/StatSnapshot.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <cstring>
+using namespace clang;
+using namespace clang::io;
+
+//===----------------------------------------------------------------------===//
+// On-disk format.
+//===----------------------------------------------------------------------===//
+//
+// A snapshot file is laid out as follows:
+//
+//   "cfe-stat" <version:32> <hash table payload> <hash table buckets>
+//   <bucket table offset:32>
+//
+// Keys are absolute paths.  The data of a path that exists holds its inode,
+// device, mode, modification time and size; the data of a path that does not
+// exist is empty.
+
+namespace {
+class StatSnapshotData {
+public:
+  bool Exists;
+  uint64_t Ino, Dev, MTime, Size;
+  uint32_t Mode;
+
+  StatSnapshotData() : Exists(false), Ino(0), Dev(0), MTime(0), Size(0),
+                       Mode(0) {}
+};
+
+class StatSnapshotLookupTrait {
+public:
+  typedef llvm::StringRef external_key_type;
+  typedef llvm::StringRef internal_key_type;
+  typedef StatSnapshotData data_type;
+
+  static unsigned ComputeHash(internal_key_type K) {
+    return llvm::HashString(K);
+  }
+
+  static internal_key_type GetInternalKey(external_key_type K) { return K; }
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = *d++;
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    return llvm::StringRef((const char*) d, n);
+  }
+
+  static data_type ReadData(internal_key_type, const unsigned char *d,
+                            unsigned n) {
+    StatSnapshotData Data;
+    if (n == 0)
+      return Data;
+
+    Data.Exists = true;
+    Data.Ino = ReadUnalignedLE64(d);
+    Data.Dev = ReadUnalignedLE64(d);
+    Data.MTime = ReadUnalignedLE64(d);
+    Data.Size = ReadUnalignedLE64(d);
+    Data.Mode = ReadUnalignedLE32(d);
+    return Data;
+  }
+};
+
+class StatSnapshotWriterTrait {
+public:
+  typedef llvm::StringRef key_type;
+  typedef llvm::StringRef key_type_ref;
+  typedef const MemorizeStatCalls::StatResult *data_type;
+  typedef data_type data_type_ref;
+
+  static unsigned ComputeHash(key_type_ref K) {
+    return llvm::HashString(K);
+  }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(llvm::raw_ostream &Out, key_type_ref K, data_type_ref D) {
+    unsigned DataLen = D->first == 0 ? 8 * 4 + 4 : 0;
+    Emit16(Out, K.size());
+    Emit8(Out, DataLen);
+    return std::make_pair(K.size(), DataLen);
+  }
+
+  static void EmitKey(llvm::raw_ostream &Out, key_type_ref K, unsigned) {
+    Out.write(K.data(), K.size());
+  }
+
+  static void EmitData(llvm::raw_ostream &Out, key_type_ref, data_type_ref D,
+                       unsigned DataLen) {
+    if (DataLen == 0)
+      return;
+
+    const struct stat &StatBuf = D->second;
+    Emit64(Out, (uint64_t) StatBuf.st_ino);
+    Emit64(Out, (uint64_t) StatBuf.st_dev);
+    Emit64(Out, (uint64_t) StatBuf.st_mtime);
+    Emit64(Out, (uint64_t) StatBuf.st_size);
+    Emit32(Out, (uint32_t) StatBuf.st_mode);
+  }
+};
+} // end anonymous namespace
+
+typedef OnDiskChainedHashTable<StatSnapshotLookupTrait> StatSnapshotTable;
+
+//===----------------------------------------------------------------------===//
+// StatSnapshotCache Implementation
+//===----------------------------------------------------------------------===//
+
+StatSnapshotCache::~StatSnapshotCache() {
+  delete (StatSnapshotTable*) Table;
+  delete Buf;
+}
+
+StatSnapshotCache *StatSnapshotCache::Create(llvm::StringRef Path) {
+  // Large files are memory mapped, so all of the compilations using the same
+  // snapshot share its pages.
+  llvm::OwningPtr<llvm::MemoryBuffer>
+    File(llvm::MemoryBuffer::getFile(Path.str().c_str()));
+  if (!File)
+    return 0;
+
+  const unsigned char *BufBeg = (const unsigned char*) File->getBufferStart();
+  const unsigned char *BufEnd = (const unsigned char*) File->getBufferEnd();
+  const unsigned MagicLen = sizeof("cfe-stat") - 1;
+
+  if (BufEnd - BufBeg < (signed) (MagicLen + 4 + 8 + 4) ||
+      memcmp(BufBeg, "cfe-stat", MagicLen) != 0)
+    return 0;
+
+  const unsigned char *p = BufBeg + MagicLen;
+  if (ReadUnalignedLE32(p) != Version)
+    return 0;
+
+  const unsigned char *Trailer = BufEnd - 4;
+  const unsigned char *Buckets = BufBeg + ReadUnalignedLE32(Trailer);
+  if (Buckets < p || Buckets + 8 > BufEnd - 4 ||
+      ((uintptr_t) Buckets & 0x3) != 0)
+    return 0;
+
+  StatSnapshotTable *Table = StatSnapshotTable::Create(Buckets, BufBeg);
+  return new StatSnapshotCache(File.take(), Table);
+}
+
+int StatSnapshotCache::stat(const char *path, struct stat *buf) {
+  // Relative paths depend on the working directory of the compilation, which
+  // the snapshot knows nothing about.
+  if (!llvm::sys::Path(path).isAbsolute())
+    return StatSysCallCache::stat(path, buf);
+
+  StatSnapshotTable &T = *(StatSnapshotTable*) Table;
+  StatSnapshotTable::iterator I = T.find(llvm::StringRef(path));
+  if (I == T.end()) {
+    ++NumMisses;
+    return StatSysCallCache::stat(path, buf);
+  }
+
+  ++NumHits;
+  const StatSnapshotData &Data = *I;
+  if (!Data.Exists)
+    return 1;
+
+  memset(buf, 0, sizeof(*buf));
+  buf->st_ino = (ino_t) Data.Ino;
+  buf->st_dev = (dev_t) Data.Dev;
+  buf->st_mode = (mode_t) Data.Mode;
+  buf->st_mtime = (time_t) Data.MTime;
+  buf->st_size = (off_t) Data.Size;
+  return 0;
+}
+
+//===----------------------------------------------------------------------===//
+// StatSnapshotWriter Implementation
+//===----------------------------------------------------------------------===//
+
+void StatSnapshotWriter::addStat(llvm::StringRef Path,
+                                 const struct stat &StatBuf) {
+  Entries[Path] = MemorizeStatCalls::StatResult(0, StatBuf);
+}
+
+void StatSnapshotWriter::addMissing(llvm::StringRef Path) {
+  struct stat StatBuf;
+  memset(&StatBuf, 0, sizeof(StatBuf));
+  Entries[Path] = MemorizeStatCalls::StatResult(-1, StatBuf);
+}
+
+bool StatSnapshotWriter::Write(llvm::StringRef Path) {
+  OnDiskChainedHashTableGenerator<StatSnapshotWriterTrait> Generator;
+  for (llvm::StringMap<MemorizeStatCalls::StatResult>::iterator
+         I = Entries.begin(), E = Entries.end(); I != E; ++I)
+    Generator.insert(I->getKey(), &I->getValue());
+
+  AtomicOutputFile File(Path);
+  std::string ErrMsg;
+  if (File.open(ErrMsg))
+    return true;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << "cfe-stat";
+  Emit32(Out, StatSnapshotCache::Version);
+  Offset TableOff = Generator.Emit(Out);
+  Emit32(Out, TableOff);
+  return File.commit(ErrMsg);
+}
+
+//===----------------------------------------------------------------------===//
+// StatSnapshotRecorder Implementation
+//===----------------------------------------------------------------------===//
+
+int StatSnapshotRecorder::stat(const char *path, struct stat *buf) {
+  int Result = StatSysCallCache::stat(path, buf);
+
+  // Like the snapshot itself, only record paths that do not depend on the
+  // working directory.
+  if (llvm::sys::Path(path).isAbsolute()) {
+    if (Result == 0)
+      Writer.addStat(path, *buf);
+    else
+      Writer.addMissing(path);
+  }
+  return Result;
+}
@@ -1313,6 +1313,13 @@ GRBugReporter::getStateManager() { return Eng.getStateManager(); }
 
 BugReporter::~BugReporter() { FlushReports(); }
 
+void BugReporter::DiscardReports() {
+  for (BugTypesTy::iterator I=BugTypes.begin(), E=BugTypes.end(); I!=E; ++I)
+    delete const_cast<BugType*>(*I);
+
+  BugTypes = F.GetEmptySet();
+}
+
 void BugReporter::FlushReports() {
   if (BugTypes.isEmpty())
     return;
@@ -1354,46 +1361,24 @@ MakeReportGraph(const ExplodedGraph* G,
                 const ExplodedNode** NStart,
                 const ExplodedNode** NEnd) {
 
-  // Create the trimmed graph.  It will contain the shortest paths from the
-  // error nodes to the root.  In the new graph we should only have one
-  // error node unless there are two or more error nodes with the same minimum
-  // path length.
-  ExplodedGraph* GTrim;
-  InterExplodedGraphMap* NMap;
-
-  llvm::DenseMap<const void*, const void*> InverseMap;
-  llvm::tie(GTrim, NMap) = G->Trim(NStart, NEnd, &InverseMap);
-
-  // Create owning pointers for GTrim and NMap just to ensure that they are
-  // released when this function exists.
-  llvm::OwningPtr<ExplodedGraph> AutoReleaseGTrim(GTrim);
-  llvm::OwningPtr<InterExplodedGraphMap> AutoReleaseNMap(NMap);
-
-  // Find the (first) error node in the trimmed graph.  We just need to consult
-  // the node map (NMap) which maps from nodes in the original graph to nodes
-  // in the new graph.
-
+  // Perform a reverse BFS from the error nodes, stopping at the first root
+  // reached.  This finds the shortest path from a root to one of the error
+  // nodes while visiting only the nodes closer to an error node than that
+  // root, rather than the whole graph.
   std::queue<const ExplodedNode*> WS;
   typedef llvm::DenseMap<const ExplodedNode*, unsigned> IndexMapTy;
   IndexMapTy IndexMap;
 
-  for (const ExplodedNode** I = NStart; I != NEnd; ++I)
-    if (const ExplodedNode *N = NMap->getMappedNode(*I)) {
-      unsigned NodeIndex = (I - NStart) / sizeof(*I);
-      WS.push(N);
-      IndexMap[*I] = NodeIndex;
-    }
-
-  assert(!WS.empty() && "No error node found in the trimmed graph.");
+  for (const ExplodedNode** I = NStart; I != NEnd; ++I) {
+    WS.push(*I);
+    IndexMap[*I] = I - NStart;
+  }
 
-  // Create a new (third!) graph with a single path.  This is the graph
-  // that will be returned to the caller.
-  ExplodedGraph *GNew = new ExplodedGraph(GTrim->getContext());
+  assert(!WS.empty() && "No error node found.");
 
-  // Sometimes the trimmed graph can contain a cycle.  Perform a reverse BFS
-  // to the root node, and then construct a new graph that contains only
-  // a single path.
-  llvm::DenseMap<const void*,unsigned> Visited;
+  // Sometimes the graph can contain a cycle, so the nodes are numbered in
+  // the order they are visited.
+  llvm::DenseMap<const ExplodedNode*, unsigned> Visited;
 
   unsigned cnt = 0;
   const ExplodedNode* Root = 0;
@@ -1419,25 +1404,23 @@ MakeReportGraph(const ExplodedGraph* G,
 
   assert(Root);
 
+  // Create a new graph with a single path.  This is the graph that will be
+  // returned to the caller.
+  ExplodedGraph *GNew = new ExplodedGraph(G->getContext());
+
   // Now walk from the root down the BFS path, always taking the successor
-  // with the lowest number.
+  // with the lowest number.  Every visited node but the error nodes was
+  // reached from a successor with a lower number, so the walk ends at an
+  // error node.
   ExplodedNode *Last = 0, *First = 0;
   NodeBackMap *BM = new NodeBackMap();
   unsigned NodeIndex = 0;
 
   for ( const ExplodedNode *N = Root ;;) {
-    // Lookup the number associated with the current node.
-    llvm::DenseMap<const void*,unsigned>::iterator I = Visited.find(N);
-    assert(I != Visited.end());
-
     // Create the equivalent node in the new graph with the same state
-    // and location.
+    // and location, and store the mapping to the original node.
     ExplodedNode* NewN = GNew->getNode(N->getLocation(), N->getState());
-
-    // Store the mapping to the original node.
-    llvm::DenseMap<const void*, const void*>::iterator IMitr=InverseMap.find(N);
-    assert(IMitr != InverseMap.end() && "No mapping to original node.");
-    (*BM)[NewN] = (const ExplodedNode*) IMitr->second;
+    (*BM)[NewN] = N;
 
     // Link up the new node with the previous node.
     if (Last)
@@ -1446,8 +1429,7 @@ MakeReportGraph(const ExplodedGraph* G,
     Last = NewN;
 
     // Are we at the final node?
-    IndexMapTy::iterator IMI =
-      IndexMap.find((const ExplodedNode*)(IMitr->second));
+    IndexMapTy::iterator IMI = IndexMap.find(N);
     if (IMI != IndexMap.end()) {
       First = NewN;
       NodeIndex = IMI->second;
@@ -1455,14 +1437,14 @@ MakeReportGraph(const ExplodedGraph* G,
     }
 
     // Find the next successor node.  We choose the node that is marked
-    // with the lowest DFS number.
+    // with the lowest BFS number.
     ExplodedNode::const_succ_iterator SI = N->succ_begin();
     ExplodedNode::const_succ_iterator SE = N->succ_end();
     N = 0;
 
     for (unsigned MinVal = 0; SI != SE; ++SI) {
-
-      I = Visited.find(*SI);
+      llvm::DenseMap<const ExplodedNode*, unsigned>::iterator
+        I = Visited.find(*SI);
 
       if (I == Visited.end())
         continue;
@@ -1578,28 +1560,26 @@ void GRBugReporter::GeneratePathDiagnostic(PathDiagnostic& PD,
                                            BugReportEquivClass& EQ) {
 
   std::vector<const ExplodedNode*> Nodes;
+  std::vector<BugReport*> Reports;
 
   for (BugReportEquivClass::iterator I=EQ.begin(), E=EQ.end(); I!=E; ++I) {
     const ExplodedNode* N = I->getEndNode();
-    if (N) Nodes.push_back(N);
+    if (N) {
+      Nodes.push_back(N);
+      Reports.push_back(*I);
+    }
   }
 
   if (Nodes.empty())
     return;
 
-  // Construct a new graph that contains only a single path from the error
-  // node to a root.
+  // Construct a new graph that contains only the shortest path from one of
+  // the error nodes to a root, and find the report ending at that node.
   const std::pair<std::pair<ExplodedGraph*, NodeBackMap*>,
   std::pair<ExplodedNode*, unsigned> >&
   GPair = MakeReportGraph(&getGraph(), &Nodes[0], &Nodes[0] + Nodes.size());
 
-  // Find the BugReport with the original location.
-  BugReport *R = 0;
-  unsigned i = 0;
-  for (BugReportEquivClass::iterator I=EQ.begin(), E=EQ.end(); I!=E; ++I, ++i)
-    if (i == GPair.second.second) { R = *I; break; }
-
-  assert(R && "No original report found for sliced graph.");
+  BugReport *R = Reports[GPair.second.second];
 
   llvm::OwningPtr<ExplodedGraph> ReportGraph(GPair.first.first);
   llvm::OwningPtr<NodeBackMap> BackMap(GPair.first.second);
@@ -1750,12 +1730,11 @@ namespace {
 class DiagCacheItem : public llvm::FoldingSetNode {
   llvm::FoldingSetNodeID ID;
 public:
-  DiagCacheItem(BugReport *R, PathDiagnostic *PD) {
+  DiagCacheItem(BugReport *R) {
     ID.AddString(R->getBugType().getName());
     ID.AddString(R->getBugType().getCategory());
     ID.AddString(R->getDescription());
     ID.AddInteger(R->getLocation().getRawEncoding());
-    PD->Profile(ID);    
   }
   
   void Profile(llvm::FoldingSetNodeID &id) {
@@ -1766,7 +1745,10 @@ public:
 };
 }
 
-static bool IsCachedDiagnostic(BugReport *R, PathDiagnostic *PD) {
+/// IsCachedDiagnostic - Returns true if a report of the same bug at the same
+///  location was already emitted.  The path is left out of the key, so that
+///  duplicates are found before their paths are built.
+static bool IsCachedDiagnostic(BugReport *R) {
   // FIXME: Eventually this diagnostic cache should reside in something
   // like AnalysisManager instead of being a static variable.  This is
   // really unsafe in the long term.
@@ -1774,7 +1756,7 @@ static bool IsCachedDiagnostic(BugReport *R, PathDiagnostic *PD) {
   static DiagnosticCache DC;
   
   void *InsertPos;
-  DiagCacheItem *Item = new DiagCacheItem(R, PD);
+  DiagCacheItem *Item = new DiagCacheItem(R);
   
   if (DC.FindNodeOrInsertPos(Item->getID(), InsertPos)) {
     delete Item;
@@ -1790,7 +1772,23 @@ void BugReporter::FlushReport(BugReportEquivClass& EQ) {
 
   if (!R)
     return;
-  
+
+  // Count the report even if it turns out to duplicate an earlier one; its
+  // declaration has a bug either way.
+  D.NoteReport();
+
+  // Drop the duplicates and the reports whose warnings would be suppressed
+  // before building their paths, which is the costly part of the report.
+  Diagnostic& Diag = getDiagnostic();
+  SourceManager &SM = getSourceManager();
+  SourceLocation Loc = R->getLocation();
+  if (Diag.getSuppressSystemWarnings() && Loc.isValid() &&
+      SM.isInSystemHeader(SM.getInstantiationLoc(Loc)))
+    return;
+
+  if (IsCachedDiagnostic(R))
+    return;
+
   PathDiagnosticClient* PD = getPathDiagnosticClient();
 
   // FIXME: Make sure we use the 'R' for the path that was actually used.
@@ -1805,9 +1803,6 @@ void BugReporter::FlushReport(BugReportEquivClass& EQ) {
 
   GeneratePathDiagnostic(*D.get(), EQ);
 
-  if (IsCachedDiagnostic(R, D.get()))
-    return;
-  
   // Get the meta data.
   std::pair<const char**, const char**> Meta = R->getExtraDescriptiveText();
   for (const char** s = Meta.first; s != Meta.second; ++s)
@@ -1816,8 +1811,7 @@ void BugReporter::FlushReport(BugReportEquivClass& EQ) {
   // Emit a summary diagnostic to the regular Diagnostics engine.
   const SourceRange *Beg = 0, *End = 0;
   R->getRanges(Beg, End);
-  Diagnostic& Diag = getDiagnostic();
-  FullSourceLoc L(R->getLocation(), getSourceManager());
+  FullSourceLoc L(Loc, SM);
   
   // Search the description for '%', as that will be interpretted as a
   // format character by FormatDiagnostics.
@@ -21,6 +21,7 @@
 #include "clang/Checker/BugReporter/PathDiagnostic.h"
 #include "clang/Checker/Checkers/LocalCheckers.h"
 #include "clang/Checker/DomainSpecific/CocoaConventions.h"
+#include "clang/Checker/DomainSpecific/RetainSummaryTable.h"
 #include "clang/Checker/PathSensitive/CheckerVisitor.h"
 #include "clang/Checker/PathSensitive/GRExprEngineBuilders.h"
 #include "clang/Checker/PathSensitive/GRStateTrait.h"
@@ -125,6 +126,10 @@ public:
     return index;
   }
 
+  /// getRawIndex - Returns the index of an Alias effect, and zero for the
+  ///  other kinds.
+  unsigned getRawIndex() const { return index; }
+
   bool isOwned() const {
     return K == OwnedSymbol || K == OwnedAllocatedSymbol ||
            K == OwnedWhenTrackedReceiver;
@@ -154,6 +159,13 @@ public:
     return RetEffect(NoRet);
   }
 
+  /// MakeRaw - Rebuild an effect from its kind, object kind and raw index.
+  static RetEffect MakeRaw(Kind k, ObjKind o, unsigned idx) {
+    RetEffect E(k, o);
+    E.index = idx;
+    return E;
+  }
+
   void Profile(llvm::FoldingSetNodeID& ID) const {
     ID.AddInteger((unsigned)K);
     ID.AddInteger((unsigned)O);
@@ -427,6 +439,10 @@ public:
     return DefaultArgEffect;
   }
 
+  /// getDefaultArgEffect - Returns the effect on the arguments that do not
+  ///  have an entry in Args.
+  ArgEffect getDefaultArgEffect() const { return DefaultArgEffect; }
+
   /// setDefaultArgEffect - Set the default argument effect.
   void setDefaultArgEffect(ArgEffect E) {
     DefaultArgEffect = E;
@@ -652,6 +668,10 @@ class RetainSummaryManager {
   /// GCEnabled - Records whether or not the analyzed code runs in GC mode.
   const bool GCEnabled;
 
+  /// SummaryTable - The stored summaries of the functions and methods
+  ///  declared in system headers, or null if there is none.
+  RetainSummaryTable *SummaryTable;
+
   /// FuncSummaries - A map from FunctionDecls to summaries.
   FuncSummariesTy FuncSummaries;
 
@@ -693,6 +713,20 @@ class RetainSummaryManager {
 
   enum UnaryFuncKind { cfretain, cfrelease, cfmakecollectable };
 
+  /// getStoredSummaryKey - Compute the key of the summary of FD or MD in
+  ///  SummaryTable.  Returns false if its summary is not stored, because
+  ///  there is no table or the declaration is not in a system header.
+  bool getStoredSummaryKey(const FunctionDecl *FD, std::string &Key);
+  bool getStoredSummaryKey(const ObjCMethodDecl *MD, Selector S,
+                           QualType RetTy, std::string &Key);
+
+  /// getStoredSummary - Decode the summary stored for Key, or return null
+  ///  if there is none.
+  RetainSummary *getStoredSummary(llvm::StringRef Key);
+
+  /// storeSummary - Record Summ as the summary of Key in SummaryTable.
+  void storeSummary(llvm::StringRef Key, const RetainSummary &Summ);
+
 public:
   RetEffect getObjAllocRetEffect() const { return ObjCAllocRetE; }
 
@@ -809,10 +843,11 @@ private:
 
 public:
 
-  RetainSummaryManager(ASTContext& ctx, bool gcenabled)
+  RetainSummaryManager(ASTContext& ctx, bool gcenabled,
+                       RetainSummaryTable *summaryTable)
    : Ctx(ctx),
      CFDictionaryCreateII(&ctx.Idents.get("CFDictionaryCreate")),
-     GCEnabled(gcenabled), AF(BPAlloc), ScratchArgs(AF.GetEmptyMap()),
+     GCEnabled(gcenabled), SummaryTable(summaryTable), AF(BPAlloc), ScratchArgs(AF.GetEmptyMap()),
      ObjCAllocRetE(gcenabled ? RetEffect::MakeGCNotOwned()
                              : RetEffect::MakeOwned(RetEffect::ObjC, true)),
      ObjCInitRetE(gcenabled ? RetEffect::MakeGCNotOwned()
@@ -919,6 +954,106 @@ RetainSummaryManager::getPersistentSummary(ArgEffects AE, RetEffect RetEff,
   return Summ;
 }
 
+//===----------------------------------------------------------------------===//
+// Stored summaries.
+//===----------------------------------------------------------------------===//
+
+// A stored summary is encoded as one byte each for the default argument
+// effect, the receiver effect, the end-of-path flag, and the kind, object
+// kind and index of the return effect, followed by two bytes for each
+// argument with its own effect: its index and its effect.
+
+bool RetainSummaryManager::getStoredSummaryKey(const FunctionDecl *FD,
+                                               std::string &Key) {
+  if (!SummaryTable || !FD->getIdentifier() ||
+      !Ctx.getSourceManager().isInSystemHeader(FD->getLocation()))
+    return false;
+
+  // The summary also depends on the type of the function and on whether GC
+  // is enabled.
+  Key = GCEnabled ? "gc:f:" : "f:";
+  Key += FD->getNameAsString();
+  Key += ':';
+  Key += FD->getType().getAsString();
+  return true;
+}
+
+bool RetainSummaryManager::getStoredSummaryKey(const ObjCMethodDecl *MD,
+                                               Selector S, QualType RetTy,
+                                               std::string &Key) {
+  if (!SummaryTable || !MD ||
+      !Ctx.getSourceManager().isInSystemHeader(MD->getLocation()))
+    return false;
+
+  // Name the method after its container; categories are qualified by the
+  // class they extend.
+  const ObjCContainerDecl *CD = dyn_cast<ObjCContainerDecl>(
+                                                       MD->getDeclContext());
+  if (!CD)
+    return false;
+
+  Key = GCEnabled ? "gc:" : "";
+  Key += MD->isInstanceMethod() ? "-[" : "+[";
+  if (const ObjCCategoryDecl *Cat = dyn_cast<ObjCCategoryDecl>(CD)) {
+    if (const ObjCInterfaceDecl *ID = Cat->getClassInterface())
+      Key += ID->getNameAsString();
+    Key += '(';
+    Key += Cat->getNameAsString();
+    Key += ')';
+  }
+  else
+    Key += CD->getNameAsString();
+  Key += ' ';
+  Key += S.getAsString();
+  Key += "]:";
+  Key += RetTy.getAsString();
+  return true;
+}
+
+RetainSummary *RetainSummaryManager::getStoredSummary(llvm::StringRef Key) {
+  llvm::StringRef Data;
+  if (!SummaryTable->lookup(Key, Data) || Data.size() < 6 ||
+      Data.size() % 2 != 0)
+    return 0;
+
+  const unsigned char *P = (const unsigned char*) Data.data();
+  ArgEffect DefaultEff = (ArgEffect) P[0];
+  ArgEffect ReceiverEff = (ArgEffect) P[1];
+  bool EndPath = P[2];
+  RetEffect RetEff = RetEffect::MakeRaw((RetEffect::Kind) P[3],
+                                        (RetEffect::ObjKind) P[4], P[5]);
+
+  ArgEffects AE = AF.GetEmptyMap();
+  for (unsigned I = 6, N = Data.size(); I != N; I += 2)
+    AE = AF.Add(AE, P[I], (ArgEffect) P[I + 1]);
+
+  return getPersistentSummary(AE, RetEff, ReceiverEff, DefaultEff, EndPath);
+}
+
+void RetainSummaryManager::storeSummary(llvm::StringRef Key,
+                                        const RetainSummary &Summ) {
+  RetEffect RetEff = Summ.getRetEffect();
+  std::string Data;
+  Data += (char) Summ.getDefaultArgEffect();
+  Data += (char) Summ.getReceiverEffect();
+  Data += (char) Summ.isEndPath();
+  Data += (char) RetEff.getKind();
+  Data += (char) RetEff.getObjKind();
+  if (RetEff.getRawIndex() > 0xFF)
+    return;
+  Data += (char) RetEff.getRawIndex();
+
+  for (RetainSummary::ExprIterator I = Summ.begin_args(),
+         E = Summ.end_args(); I != E; ++I) {
+    if (I.getKey() > 0xFF)
+      return;
+    Data += (char) I.getKey();
+    Data += (char) I.getData();
+  }
+
+  SummaryTable->add(Key, Data);
+}
+
 //===----------------------------------------------------------------------===//
 // Summary creation for functions (largely uses of Core Foundation).
 //===----------------------------------------------------------------------===//
@@ -937,6 +1072,15 @@ RetainSummary* RetainSummaryManager::getSummary(FunctionDecl* FD) {
   if (I != FuncSummaries.end())
     return I->second;
 
+  // Functions declared in system headers may have a stored summary.
+  std::string Key;
+  bool IsStored = getStoredSummaryKey(FD, Key);
+  if (IsStored)
+    if (RetainSummary *S = getStoredSummary(Key)) {
+      FuncSummaries[FD] = S;
+      return S;
+    }
+
   // No summary?  Generate one.
   RetainSummary *S = 0;
 
@@ -1120,6 +1264,9 @@ RetainSummary* RetainSummaryManager::getSummary(FunctionDecl* FD) {
   assert(S);
   updateSummaryFromAnnotations(*S, FD);
 
+  if (IsStored)
+    storeSummary(Key, *S);
+
   FuncSummaries[FD] = S;
   return S;
 }
@@ -1395,6 +1542,13 @@ RetainSummaryManager::getInstanceMethodSummary(Selector S,
   if (!Summ) {
     assert(ScratchArgs.isEmpty());
 
+    std::string Key;
+    bool IsStored = getStoredSummaryKey(MD, S, RetTy, Key);
+    if (IsStored && (Summ = getStoredSummary(Key))) {
+      ObjCMethodSummaries[ObjCSummaryKey(ID, ClsName, S)] = Summ;
+      return Summ;
+    }
+
     // "initXXX": pass-through for receiver.
     if (cocoa::deriveNamingConvention(S) == cocoa::InitRule)
       Summ = getInitMethodSummary(RetTy);
@@ -1404,6 +1558,9 @@ RetainSummaryManager::getInstanceMethodSummary(Selector S,
     // Annotations override defaults.
     updateSummaryFromAnnotations(*Summ, MD);
 
+    if (IsStored)
+      storeSummary(Key, *Summ);
+
     // Memoize the summary.
     ObjCMethodSummaries[ObjCSummaryKey(ID, ClsName, S)] = Summ;
   }
@@ -1421,9 +1578,19 @@ RetainSummaryManager::getClassMethodSummary(Selector S, IdentifierInfo *ClsName,
   RetainSummary *Summ = ObjCClassMethodSummaries.find(ID, ClsName, S);
 
   if (!Summ) {
+    std::string Key;
+    bool IsStored = getStoredSummaryKey(MD, S, RetTy, Key);
+    if (IsStored && (Summ = getStoredSummary(Key))) {
+      ObjCClassMethodSummaries[ObjCSummaryKey(ID, ClsName, S)] = Summ;
+      return Summ;
+    }
+
     Summ = getCommonMethodSummary(MD, S, RetTy);
     // Annotations override defaults.
     updateSummaryFromAnnotations(*Summ, MD);
+
+    if (IsStored)
+      storeSummary(Key, *Summ);
     // Memoize the summary.
     ObjCClassMethodSummaries[ObjCSummaryKey(ID, ClsName, S)] = Summ;
   }
@@ -1699,8 +1866,9 @@ private:
                                       ExplodedNode *Pred = 0);
 
 public:
-  CFRefCount(ASTContext& Ctx, bool gcenabled, const LangOptions& lopts)
-    : Summaries(Ctx, gcenabled),
+  CFRefCount(ASTContext& Ctx, bool gcenabled, const LangOptions& lopts,
+             RetainSummaryTable *SummaryTable)
+    : Summaries(Ctx, gcenabled, SummaryTable),
       LOpts(lopts), useAfterRelease(0), releaseNotOwned(0),
       deallocGC(0), deallocNotOwned(0),
       leakWithinFunction(0), leakAtReturn(0), overAutorelease(0),
@@ -3530,6 +3698,7 @@ void CFRefCount::RegisterChecks(GRExprEngine& Eng) {
 }
 
 GRTransferFuncs* clang::MakeCFRefCountTF(ASTContext& Ctx, bool GCEnabled,
-                                         const LangOptions& lopts) {
-  return new CFRefCount(Ctx, GCEnabled, lopts);
+                                         const LangOptions& lopts,
+                                         RetainSummaryTable *Summaries) {
+  return new CFRefCount(Ctx, GCEnabled, lopts, Summaries);
 }
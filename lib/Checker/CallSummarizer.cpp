@@ -0,0 +1,185 @@
+//===--- CallSummarizer.cpp - Transfer function applying callee summaries -===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the checker that summarizes the values returned by
+//  the functions defined in the translation unit, and applies the summaries
+//  to the calls to them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Checker/PathSensitive/CheckerVisitor.h"
+#include "clang/Checker/PathSensitive/GRState.h"
+#include "clang/Checker/PathSensitive/GRTransferFuncs.h"
+#include "clang/Checker/Checkers/LocalCheckers.h"
+
+using namespace clang;
+
+namespace {
+class CallSummarizer : public CheckerVisitor<CallSummarizer> {
+  /// Summary - The summary of the function analyzed by the engine, if the
+  ///  engine is computing it.
+  FunctionSummary *Summary;
+
+public:
+  explicit CallSummarizer(FunctionSummary *S) : Summary(S) {}
+
+  static void *getTag() {
+    static int x;
+    return &x;
+  }
+
+  void PreVisitReturnStmt(CheckerContext &C, const ReturnStmt *RS);
+  void PostVisitCallExpr(CheckerContext &C, const CallExpr *CE);
+
+private:
+  const FunctionSummary &getSummary(AnalysisManager &Mgr,
+                                    const FunctionDecl *FD);
+};
+}
+
+void clang::RegisterCallSummarizer(GRExprEngine &Eng) {
+  Eng.registerCheck(new CallSummarizer(0));
+}
+
+static bool isSameValue(const llvm::APSInt &X, const llvm::APSInt &Y) {
+  return X.getBitWidth() == Y.getBitWidth() &&
+         X.isUnsigned() == Y.isUnsigned() && X == Y;
+}
+
+/// PreVisitReturnStmt - Merge the value returned on this path into the
+///  summary being computed.
+void CallSummarizer::PreVisitReturnStmt(CheckerContext &C,
+                                        const ReturnStmt *RS) {
+  // Only the top-level function of the engine is being summarized.
+  if (!Summary || Summary->K == FunctionSummary::Unknown ||
+      C.getPredecessor()->getLocationContext()->getParent())
+    return;
+
+  const Expr *RetE = RS->getRetValue();
+  if (!RetE) {
+    Summary->K = FunctionSummary::Unknown;
+    return;
+  }
+
+  const GRState *state = C.getState();
+  SVal V = state->getSVal(RetE);
+
+  const llvm::APSInt *Value = 0;
+  if (const nonloc::ConcreteInt *CI = dyn_cast<nonloc::ConcreteInt>(&V))
+    Value = &CI->getValue();
+  else if (const loc::ConcreteInt *CI = dyn_cast<loc::ConcreteInt>(&V))
+    Value = &CI->getValue();
+
+  // The value is non-zero if it cannot be assumed to be zero.
+  bool IsNonZero;
+  if (Value)
+    IsNonZero = Value->getBoolValue();
+  else if (DefinedSVal *DV = dyn_cast<DefinedSVal>(&V))
+    IsNonZero = !state->Assume(*DV, false);
+  else
+    IsNonZero = false;
+
+  switch (Summary->K) {
+  default:
+    assert(0 && "Unexpected summary kind.");
+    break;
+  case FunctionSummary::NoReturns:
+    if (Value) {
+      Summary->K = FunctionSummary::Constant;
+      Summary->Value = *Value;
+    }
+    else
+      Summary->K = IsNonZero ? FunctionSummary::NonZero
+                             : FunctionSummary::Unknown;
+    break;
+  case FunctionSummary::Constant:
+    if (Value && isSameValue(*Value, Summary->Value))
+      break;
+    Summary->K = IsNonZero && Summary->Value.getBoolValue()
+                   ? FunctionSummary::NonZero : FunctionSummary::Unknown;
+    break;
+  case FunctionSummary::NonZero:
+    if (!IsNonZero)
+      Summary->K = FunctionSummary::Unknown;
+    break;
+  }
+}
+
+/// getSummary - Returns the summary of FD, analyzing it on its own first if
+///  this is the first call to it.
+const FunctionSummary &CallSummarizer::getSummary(AnalysisManager &Mgr,
+                                                  const FunctionDecl *FD) {
+  AnalysisManager::SummaryMap &Summaries = Mgr.getSummaries();
+  AnalysisManager::SummaryMap::iterator I = Summaries.find(FD);
+  if (I != Summaries.end())
+    return I->second;
+
+  // Mark the summary as in progress, so that recursive calls to FD do not
+  // use it.
+  Summaries[FD] = FunctionSummary();
+
+  FunctionSummary S;
+  S.K = FunctionSummary::NoReturns;
+  if (!Mgr.getLiveVariables(FD))
+    S.K = FunctionSummary::Unknown;
+  else {
+    // Only the checks that prune infeasible paths are run.  The bugs found
+    // are reported when FD itself is analyzed, so they are thrown away here.
+    GRExprEngine Eng(Mgr, new GRTransferFuncs());
+    Eng.registerCheck(new CallSummarizer(&S));
+    Eng.ExecuteWorkList(Mgr.getStackFrame(FD));
+    Eng.getBugReporter().DiscardReports();
+
+    // The values returned on the paths that were not explored are unknown.
+    if (Eng.getExceededBudget() != GRCoreEngine::NoBudget ||
+        Eng.hasDroppedPaths())
+      S.K = FunctionSummary::Unknown;
+  }
+
+  // The analysis may have added entries, so look FD up again.
+  return Summaries[FD] = S;
+}
+
+/// PostVisitCallExpr - Constrain the value of a call to a function defined
+///  in the translation unit by the summary of the function.
+void CallSummarizer::PostVisitCallExpr(CheckerContext &C,
+                                       const CallExpr *CE) {
+  const GRState *state = C.getState();
+  const FunctionDecl *FD = state->getSVal(CE->getCallee()).getAsFunctionDecl();
+  const FunctionDecl *Def;
+  if (!FD || !FD->getBody(Def))
+    return;
+
+  const FunctionSummary &S = getSummary(C.getAnalysisManager(), Def);
+  QualType T = CE->getType();
+  SVal V = state->getSVal(CE);
+
+  switch (S.K) {
+  default:
+    return;
+
+  case FunctionSummary::Constant:
+    if (T->isIntegerType()) {
+      state = state->BindExpr(CE, C.getValueManager().makeIntVal(S.Value));
+      break;
+    }
+    // A pointer that is always null or never is.
+    if (DefinedSVal *DV = dyn_cast<DefinedSVal>(&V))
+      state = state->Assume(*DV, S.Value.getBoolValue());
+    break;
+
+  case FunctionSummary::NonZero:
+    if (DefinedSVal *DV = dyn_cast<DefinedSVal>(&V))
+      state = state->Assume(*DV, true);
+    break;
+  }
+
+  if (state)
+    C.addTransition(state);
+}
@@ -13,6 +13,7 @@
 #include "clang/Checker/PathSensitive/GRState.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
 #include "llvm/ADT/ImmutableMap.h"
+#include "llvm/ADT/SmallVector.h"
 
 using namespace clang;
 
@@ -111,26 +112,31 @@ EnvironmentManager::RemoveDeadBindings(Environment Env, const Stmt *S,
 
   CFG &C = *Env.getAnalysisContext().getCFG();
 
-  // We construct a new Environment object entirely, as this is cheaper than
-  // individually removing all the subexpression bindings (which will greatly
-  // outnumber block-level expression bindings).
-  Environment NewEnv = getInitialEnvironment(&Env.getAnalysisContext());
+  // The bindings to keep and the ones to drop.  Most statements only kill a
+  // few bindings, the subexpressions of the previous statement and the block
+  // expressions that just died, so the new Environment is usually built by
+  // removing those from the old one, which shares all the rest.  Otherwise,
+  // building it from the kept bindings is cheaper.
+  llvm::SmallVector<std::pair<const Stmt*, SVal>, 16> Kept;
+  llvm::SmallVector<const Stmt*, 16> Dropped;
 
-  // Iterate over the block-expr bindings.
+  // Iterate over the bindings.
   for (Environment::iterator I = Env.begin(), E = Env.end();
        I != E; ++I) {
 
     const Stmt *BlkExpr = I.getKey();
 
-    // Not a block-level expression?
-    if (!C.isBlkExpr(BlkExpr))
+    // Subexpression bindings are always dropped.
+    if (!C.isBlkExpr(BlkExpr)) {
+      Dropped.push_back(BlkExpr);
       continue;
+    }
 
     const SVal &X = I.getData();
 
     if (SymReaper.isLive(S, BlkExpr)) {
       // Copy the binding to the new map.
-      NewEnv.ExprBindings = F.Add(NewEnv.ExprBindings, BlkExpr, X);
+      Kept.push_back(std::make_pair(BlkExpr, X));
 
       // If the block expr's value is a memory region, then mark that region.
       if (isa<loc::MemRegionVal>(X)) {
@@ -157,8 +163,21 @@ EnvironmentManager::RemoveDeadBindings(Environment Env, const Stmt *S,
     // beginning of itself, but we need its UndefinedVal to determine its
     // SVal.
     if (X.isUndef() && cast<UndefinedVal>(X).getData())
-      NewEnv.ExprBindings = F.Add(NewEnv.ExprBindings, BlkExpr, X);
+      Kept.push_back(std::make_pair(BlkExpr, X));
+    else
+      Dropped.push_back(BlkExpr);
   }
 
+  if (Dropped.size() <= Kept.size()) {
+    Environment::BindingsTy B = Env.ExprBindings;
+    for (unsigned I = 0, N = Dropped.size(); I != N; ++I)
+      B = F.Remove(B, Dropped[I]);
+    return Environment(B, Env.ACtx);
+  }
+
+  Environment NewEnv = getInitialEnvironment(&Env.getAnalysisContext());
+  for (unsigned I = 0, N = Kept.size(); I != N; ++I)
+    NewEnv.ExprBindings = F.Add(NewEnv.ExprBindings, Kept[I].first,
+                                Kept[I].second);
   return NewEnv;
 }
@@ -14,7 +14,9 @@
 
 #include "clang/Checker/PathSensitive/ExplodedGraph.h"
 #include "clang/Checker/PathSensitive/GRState.h"
+#include "clang/AST/ExprObjC.h"
 #include "clang/AST/Stmt.h"
+#include "clang/Analysis/CFG.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
@@ -85,6 +87,12 @@ void ExplodedNode::NodeGroup::addNode(ExplodedNode* N, ExplodedGraph &G) {
   }
 }
 
+void ExplodedNode::NodeGroup::replaceNode(ExplodedNode *N) {
+  assert((reinterpret_cast<uintptr_t>(N) & Mask) == 0x0);
+  assert(getKind() == Size1 && getNode() && "Group must hold one node");
+  P = reinterpret_cast<uintptr_t>(N);
+}
+
 unsigned ExplodedNode::NodeGroup::size() const {
   if (getFlag())
     return 0;
@@ -128,8 +136,13 @@ ExplodedNode *ExplodedGraph::getNode(const ProgramPoint& L,
   NodeTy* V = Nodes.FindNodeOrInsertPos(profile, InsertPos);
 
   if (!V) {
-    // Allocate a new node.
-    V = (NodeTy*) getAllocator().Allocate<NodeTy>();
+    // Allocate a new node, reusing the memory of a reclaimed one if we can.
+    if (!FreeNodes.empty()) {
+      V = FreeNodes.back();
+      FreeNodes.pop_back();
+    }
+    else
+      V = (NodeTy*) getAllocator().Allocate<NodeTy>();
     new (V) NodeTy(L, State);
 
     // Insert the node into the node set and return it.
@@ -137,6 +150,9 @@ ExplodedNode *ExplodedGraph::getNode(const ProgramPoint& L,
 
     ++NumNodes;
 
+    if (ReclaimInterval)
+      RecentNodes.push_back(V);
+
     if (IsNew) *IsNew = true;
   }
   else
@@ -145,6 +161,67 @@ ExplodedNode *ExplodedGraph::getNode(const ProgramPoint& L,
   return V;
 }
 
+//===----------------------------------------------------------------------===//
+// Node reclamation.
+//===----------------------------------------------------------------------===//
+
+/// shouldReclaim - Return true if N is in the middle of a straight-line path
+///  and only adds the value of a subexpression to the state of its
+///  predecessor, so that no checker or bug report can need it.
+bool ExplodedGraph::shouldReclaim(ExplodedNode *N) {
+  if (N->pred_size() != 1 || N->succ_size() != 1)
+    return false;
+
+  ExplodedNode *Pred = *N->pred_begin();
+  ExplodedNode *Succ = *N->succ_begin();
+  if (Pred->succ_size() != 1 || Succ->pred_size() != 1)
+    return false;
+
+  // Loads, stores, lvalues and the nodes of checkers all mean something to
+  // the bug reporter's visitors, so only plain, untagged PostStmts go.
+  ProgramPoint Loc = N->getLocation();
+  if (Loc.getKind() != ProgramPoint::PostStmtKind || Loc.getTag() ||
+      Loc.getLocationContext() != Pred->getLocationContext())
+    return false;
+
+  // The store and the checker state must be those of the predecessor.
+  const GRState *State = N->getState(), *PredState = Pred->getState();
+  if (State->getStore() != PredState->getStore() ||
+      State->getGDM() != PredState->getGDM())
+    return false;
+
+  // Block-level expressions end up in the path diagnostics, and the summary
+  // of a call is looked up by its node.
+  const Stmt *S = cast<PostStmt>(Loc).getStmt();
+  if (N->getCFG().isBlkExpr(S) || isa<CallExpr>(S) || isa<ObjCMessageExpr>(S))
+    return false;
+
+  return true;
+}
+
+void ExplodedGraph::reclaimNode(ExplodedNode *N) {
+  ExplodedNode *Pred = *N->pred_begin();
+  ExplodedNode *Succ = *N->succ_begin();
+  Pred->Succs.replaceNode(Succ);
+  Succ->Preds.replaceNode(Pred);
+
+  Nodes.RemoveNode(N);
+  --NumNodes;
+  N->~ExplodedNode();
+  FreeNodes.push_back(N);
+}
+
+void ExplodedGraph::reclaimRecentNodes() {
+  if (!ReclaimInterval || RecentNodes.size() < ReclaimInterval)
+    return;
+
+  for (unsigned I = 0, E = RecentNodes.size(); I != E; ++I)
+    if (shouldReclaim(RecentNodes[I]))
+      reclaimNode(RecentNodes[I]);
+
+  RecentNodes.clear();
+}
+
 std::pair<ExplodedGraph*, InterExplodedGraphMap*>
 ExplodedGraph::Trim(const NodeTy* const* NBeg, const NodeTy* const* NEnd,
                llvm::DenseMap<const void*, const void*> *InverseMap) const {
@@ -6,30 +6,177 @@
 // License. See LICENSE.TXT for details.
 //
 //===----------------------------------------------------------------------===//
+//
+//  This file defines FlatStoreManager, a store model that keeps all bindings
+//  in one sorted map keyed by (base region, bit offset, bit width).  Fields
+//  and elements with known offsets are folded into the bits of their base
+//  region, so no region is created or walked to find a binding.  It trades
+//  some of RegionStore's precision (symbolic offsets, unions) for much less
+//  memory per state.
+//
+//===----------------------------------------------------------------------===//
 
 #include "clang/Checker/PathSensitive/GRState.h"
-#include "llvm/ADT/ImmutableIntervalMap.h"
-#include "llvm/Support/ErrorHandling.h"
+#include "clang/AST/RecordLayout.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/ImmutableMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <limits>
 
 using namespace clang;
-using llvm::Interval;
+
+//===----------------------------------------------------------------------===//
+// Representation of binding keys.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// FlatBindingKey - The bits [Offset, Offset + Width) of a base region.  A
+///  direct binding gives the value of exactly those bits.  A default binding
+///  gives the value of any part of them that has no direct binding, and
+///  default bindings over smaller ranges take precedence.
+class FlatBindingKey {
+public:
+  enum Kind { Direct = 0x0, Default = 0x1 };
+
+  /// WholeRegion - The width of a range that extends to the end of its base
+  ///  region, used when the size of the region is not known.
+  static const uint64_t WholeRegion = ~0ULL;
+
+  /// MinOffset, MaxOffset - The bounds of the offsets within a region.
+  static int64_t MinOffset() { return std::numeric_limits<int64_t>::min(); }
+  static int64_t MaxOffset() { return std::numeric_limits<int64_t>::max(); }
+
+private:
+  llvm::PointerIntPair<const MemRegion*, 1> P;
+  int64_t Offset;
+  uint64_t Width;
+
+public:
+  FlatBindingKey() : Offset(0), Width(0) {}
+
+  FlatBindingKey(const MemRegion *base, int64_t offset, uint64_t width,
+                 Kind k)
+    : P(base, (unsigned) k), Offset(offset), Width(width) { assert(base); }
+
+  const MemRegion *getBase() const { return P.getPointer(); }
+  int64_t getOffset() const { return Offset; }
+  uint64_t getWidth() const { return Width; }
+
+  /// getEnd - Return the offset just past the range.
+  int64_t getEnd() const {
+    if (Width == WholeRegion || Offset + (int64_t) Width < Offset)
+      return MaxOffset();
+    return Offset + (int64_t) Width;
+  }
+
+  bool isDirect() const { return P.getInt() == Direct; }
+  bool isDefault() const { return P.getInt() == Default; }
+
+  FlatBindingKey withKind(Kind k) const {
+    return FlatBindingKey(getBase(), Offset, Width, k);
+  }
+
+  bool sameRange(const FlatBindingKey &X) const {
+    return getBase() == X.getBase() && Offset == X.Offset && Width == X.Width;
+  }
+
+  bool contains(const FlatBindingKey &X) const {
+    return getBase() == X.getBase() && Offset <= X.Offset &&
+           X.getEnd() <= getEnd();
+  }
+
+  void Profile(llvm::FoldingSetNodeID& ID) const {
+    ID.AddPointer(P.getOpaqueValue());
+    ID.AddInteger(Offset);
+    ID.AddInteger(Width);
+  }
+
+  bool operator<(const FlatBindingKey &X) const {
+    if (getBase() != X.getBase())
+      return getBase() < X.getBase();
+    if (Offset != X.Offset)
+      return Offset < X.Offset;
+    if (Width != X.Width)
+      return Width < X.Width;
+    return P.getInt() < X.P.getInt();
+  }
+
+  bool operator==(const FlatBindingKey &X) const {
+    return P.getOpaqueValue() == X.P.getOpaqueValue() &&
+           Offset == X.Offset && Width == X.Width;
+  }
+};
+} // end anonymous namespace
+
+namespace llvm {
+  static inline
+  llvm::raw_ostream& operator<<(llvm::raw_ostream& os, FlatBindingKey K) {
+    os << '(' << K.getBase() << ',' << K.getOffset() << ',';
+    if (K.getWidth() == FlatBindingKey::WholeRegion)
+      os << '*';
+    else
+      os << K.getWidth();
+    os << ',' << (K.isDirect() ? "direct" : "default") << ')';
+    return os;
+  }
+} // end llvm namespace
 
 // The actual store type.
-typedef llvm::ImmutableIntervalMap<SVal> BindingVal;
-typedef llvm::ImmutableMap<const MemRegion *, BindingVal> RegionBindings;
+typedef llvm::ImmutableMap<FlatBindingKey, SVal> RegionBindings;
+typedef std::pair<FlatBindingKey, SVal> FlatBinding;
+
+//===----------------------------------------------------------------------===//
+// Utility functions.
+//===----------------------------------------------------------------------===//
+
+static bool IsAnyPointerOrIntptr(QualType ty, ASTContext &Ctx) {
+  if (ty->isAnyPointerType())
+    return true;
+
+  return ty->isIntegerType() && ty->isScalarType() &&
+         Ctx.getTypeSize(ty) == Ctx.getTypeSize(Ctx.VoidPtrTy);
+}
+
+/// GetTypeWidth - Set W to the size of T in bits, if T has a fixed size.
+static bool GetTypeWidth(ASTContext &Ctx, QualType T, uint64_t &W) {
+  if (T.isNull() || T->isIncompleteType() || T->isFunctionType() ||
+      !T->isConstantSizeType())
+    return false;
+  W = Ctx.getTypeSize(T);
+  return true;
+}
+
+static unsigned GetFieldIndex(const FieldDecl *FD) {
+  const RecordDecl *RD = FD->getParent();
+  unsigned Index = 0;
+  for (RecordDecl::field_iterator I = RD->field_begin(), E = RD->field_end();
+       I != E && *I != FD; ++I)
+    ++Index;
+  return Index;
+}
+
+//===----------------------------------------------------------------------===//
+// Main FlatStore logic.
+//===----------------------------------------------------------------------===//
 
 namespace {
+
+class FlatStoreSubRegionMap : public SubRegionMap {
+public:
+  bool iterSubRegions(const MemRegion* R, Visitor& V) const {
+    return true; // Do nothing.  Bindings are not kept per region.
+  }
+};
+
 class FlatStoreManager : public StoreManager {
   RegionBindings::Factory RBFactory;
-  BindingVal::Factory BVFactory;
 
 public:
-  FlatStoreManager(GRStateManager &mgr) 
-    : StoreManager(mgr), 
-      RBFactory(mgr.getAllocator()), 
-      BVFactory(mgr.getAllocator()) {}
+  FlatStoreManager(GRStateManager &mgr)
+    : StoreManager(mgr),
+      RBFactory(mgr.getAllocator()) {}
 
-  SVal Retrieve(Store store, Loc L, QualType T);
+  SVal Retrieve(Store store, Loc L, QualType T = QualType());
   Store Bind(Store store, Loc L, SVal val);
   Store Remove(Store St, Loc L);
   Store BindCompoundLiteral(Store store, const CompoundLiteralExpr* cl,
@@ -40,25 +187,36 @@ public:
   }
 
   SubRegionMap *getSubRegionMap(Store store) {
-    return 0;
+    return new FlatStoreSubRegionMap();
   }
 
   SVal ArrayToPointer(Loc Array);
+  SVal EvalBinOp(BinaryOperator::Opcode Op, Loc L, NonLoc R,
+                 QualType resultTy);
+
   Store RemoveDeadBindings(Store store, Stmt* Loc, SymbolReaper& SymReaper,
-                         llvm::SmallVectorImpl<const MemRegion*>& RegionRoots){
-    return store;
-  }
+                          llvm::SmallVectorImpl<const MemRegion*>& RegionRoots);
 
   Store BindDecl(Store store, const VarRegion *VR, SVal initVal);
 
-  Store BindDeclWithNoInit(Store store, const VarRegion *VR);
+  Store BindDeclWithNoInit(Store store, const VarRegion *VR) {
+    return store;
+  }
 
   typedef llvm::DenseSet<SymbolRef> InvalidatedSymbols;
-  
-  Store InvalidateRegion(Store store, const MemRegion *R, const Expr *E, 
-                         unsigned Count, InvalidatedSymbols *IS);
 
-  void print(Store store, llvm::raw_ostream& Out, const char* nl, 
+  Store InvalidateRegion(Store store, const MemRegion *R, const Expr *E,
+                         unsigned Count, InvalidatedSymbols *IS) {
+    return InvalidateRegions(store, &R, &R + 1, E, Count, IS);
+  }
+
+  Store InvalidateRegions(Store store,
+                          const MemRegion * const *Begin,
+                          const MemRegion * const *End,
+                          const Expr *E, unsigned Count,
+                          InvalidatedSymbols *IS);
+
+  void print(Store store, llvm::raw_ostream& Out, const char* nl,
              const char *sep);
   void iterBindings(Store store, BindingsHandler& f);
 
@@ -67,9 +225,32 @@ private:
     return RegionBindings(static_cast<const RegionBindings::TreeTy*>(store));
   }
 
-  Interval RegionToInterval(const MemRegion *R);
+  bool getOffsetInSuper(const SubRegion *R, int64_t &Offset);
+  uint64_t getWidth(const MemRegion *R);
+  bool getBindingKey(const MemRegion *R, FlatBindingKey &K);
+
+  void collectBindings(const RegionBindings::TreeTy *T,
+                       const FlatBindingKey &K,
+                       llvm::SmallVectorImpl<FlatBinding> &Out);
+  void collectBindings(Store store, const FlatBindingKey &K,
+                       llvm::SmallVectorImpl<FlatBinding> &Out) {
+    collectBindings(getRegionBindings(store).getRoot(), K, Out);
+  }
+
+  RegionBindings removeRange(RegionBindings B, const FlatBindingKey &K);
+  Store killRange(Store store, const FlatBindingKey &K, SVal V);
+
+  const ElementRegion *getElementZeroRegion(const MemRegion *R, QualType T);
 
-  SVal RetrieveRegionWithNoBinding(const MemRegion *R, QualType T);
+  SVal RetrieveScalar(Store store, const TypedRegion *R, QualType Ty);
+  SVal RetrieveLazy(const nonloc::LazyCompoundVal &LCV,
+                    const FlatBindingKey &K, const TypedRegion *R,
+                    QualType Ty);
+  SVal RetrieveUnbound(const TypedRegion *R, QualType Ty);
+
+  Store BindAggregate(Store store, const TypedRegion *R, SVal V);
+  Store BindString(Store store, const TypedRegion *R, QualType ElementTy,
+                   const StringRegion *Str);
 };
 } // end anonymous namespace
 
@@ -77,90 +258,866 @@ StoreManager *clang::CreateFlatStoreManager(GRStateManager &StMgr) {
   return new FlatStoreManager(StMgr);
 }
 
+//===----------------------------------------------------------------------===//
+// Binding keys of regions.
+//===----------------------------------------------------------------------===//
+
+/// getOffsetInSuper - Set Offset to the bit offset of R within its super
+///  region, if it is known.  Union members are given no offset, so that
+///  their bindings are never read back as another member.
+bool FlatStoreManager::getOffsetInSuper(const SubRegion *R, int64_t &Offset) {
+  if (const ElementRegion *ER = dyn_cast<ElementRegion>(R)) {
+    uint64_t W;
+    if (!ER->hasConstantIndex() || !GetTypeWidth(Ctx, ER->getElementType(), W))
+      return false;
+    Offset = ER->getConstantIndex() * (int64_t) W;
+    return true;
+  }
+
+  const FieldDecl *FD = cast<FieldRegion>(R)->getDecl();
+  const RecordDecl *RD = FD->getParent()->getDefinition();
+  if (!RD || RD->isUnion())
+    return false;
+  const ASTRecordLayout &Layout = Ctx.getASTRecordLayout(RD);
+  Offset = Layout.getFieldOffset(GetFieldIndex(FD));
+  return true;
+}
+
+/// getWidth - Return the number of bits of R, or WholeRegion if R has no
+///  fixed size.
+uint64_t FlatStoreManager::getWidth(const MemRegion *R) {
+  if (const FieldRegion *FR = dyn_cast<FieldRegion>(R))
+    if (FR->getDecl()->isBitField())
+      return FR->getDecl()->getBitWidth()->EvaluateAsInt(Ctx).getZExtValue();
+
+  uint64_t W;
+  if (const TypedRegion *TR = dyn_cast<TypedRegion>(R))
+    if (GetTypeWidth(Ctx, TR->getValueType(Ctx), W))
+      return W;
+
+  return FlatBindingKey::WholeRegion;
+}
+
+/// getBindingKey - Compute the bits of its base region that R covers.  If a
+///  region between R and its base has an unknown offset, K is instead the
+///  range of the innermost region enclosing R whose offset is known, and
+///  false is returned.
+bool FlatStoreManager::getBindingKey(const MemRegion *R, FlatBindingKey &K) {
+  const MemRegion *Base = R->getBaseRegion();
+  const MemRegion *Start = R;
+  int64_t Offset = 0;
+  bool Exact = true;
+
+  for (const MemRegion *I = R; I != Base;
+       I = cast<SubRegion>(I)->getSuperRegion()) {
+    int64_t Delta;
+    if (getOffsetInSuper(cast<SubRegion>(I), Delta)) {
+      Offset += Delta;
+      continue;
+    }
+    Start = cast<SubRegion>(I)->getSuperRegion();
+    Offset = 0;
+    Exact = false;
+  }
+
+  K = FlatBindingKey(Base, Offset, getWidth(Start), FlatBindingKey::Direct);
+  return Exact;
+}
+
+/// collectBindings - Add to Out the bindings of the base region of K that
+///  overlap the range of K.  The map is ordered by base region and then by
+///  offset, so only the bindings of that region that start before the end
+///  of the range are visited.
+void FlatStoreManager::collectBindings(const RegionBindings::TreeTy *T,
+                                       const FlatBindingKey &K,
+                                       llvm::SmallVectorImpl<FlatBinding> &Out) {
+  while (T) {
+    const FlatBindingKey &X = T->getValue().first;
+    if (X.getBase() < K.getBase()) {
+      T = T->getRight();
+      continue;
+    }
+    if (K.getBase() < X.getBase() || X.getOffset() >= K.getEnd()) {
+      T = T->getLeft();
+      continue;
+    }
+
+    collectBindings(T->getLeft(), K, Out);
+    if (X.getEnd() > K.getOffset())
+      Out.push_back(T->getValue());
+    T = T->getRight();
+  }
+}
+
+/// removeRange - Remove the direct bindings overlapping the range of K and
+///  the default bindings within it.  What a removed direct binding said about
+///  the bits outside the range is no longer known.
+RegionBindings FlatStoreManager::removeRange(RegionBindings B,
+                                             const FlatBindingKey &K) {
+  llvm::SmallVector<FlatBinding, 8> Overlaps;
+  collectBindings(B.getRoot(), K, Overlaps);
+
+  for (unsigned I = 0, N = Overlaps.size(); I != N; ++I) {
+    const FlatBindingKey &X = Overlaps[I].first;
+    if (X.isDefault() && !K.contains(X))
+      continue;
+    B = RBFactory.Remove(B, X);
+    if (X.isDirect() && !K.contains(X))
+      B = RBFactory.Add(B, X.withKind(FlatBindingKey::Default), UnknownVal());
+  }
+  return B;
+}
+
+/// killRange - Replace whatever is known about the range of K by the default
+///  value V.
+Store FlatStoreManager::killRange(Store store, const FlatBindingKey &K,
+                                  SVal V) {
+  RegionBindings B = removeRange(getRegionBindings(store), K);
+  return RBFactory.Add(B, K.withKind(FlatBindingKey::Default), V).getRoot();
+}
+
+const ElementRegion *
+FlatStoreManager::getElementZeroRegion(const MemRegion *R, QualType T) {
+  assert(!T.isNull());
+  return MRMgr.getElementRegion(T, ValMgr.makeZeroArrayIndex(), R, Ctx);
+}
+
+//===----------------------------------------------------------------------===//
+// Loading values from regions.
+//===----------------------------------------------------------------------===//
+
 SVal FlatStoreManager::Retrieve(Store store, Loc L, QualType T) {
-  const MemRegion *R = cast<loc::MemRegionVal>(L).getRegion();
-  Interval I = RegionToInterval(R);
-  RegionBindings B = getRegionBindings(store);
-  const BindingVal *BV = B.lookup(R);
-  if (BV) {
-    const SVal *V = BVFactory.Lookup(*BV, I);
-    if (V)
-      return *V;
+  if (isa<UnknownVal>(L))
+    return UnknownVal();
+
+  // FIXME: Is this even possible?  Shouldn't this be treated as a null
+  //  dereference at a higher level?
+  if (isa<loc::ConcreteInt>(L))
+    return UndefinedVal();
+
+  if (!isa<loc::MemRegionVal>(L))
+    return UnknownVal();
+
+  const MemRegion *MR = cast<loc::MemRegionVal>(L).getRegion();
+
+  if (isa<AllocaRegion>(MR) || isa<SymbolicRegion>(MR)) {
+    if (T.isNull())
+      return UnknownVal();
+    MR = getElementZeroRegion(MR, T);
+  }
+
+  if (isa<CodeTextRegion>(MR) || !isa<TypedRegion>(MR))
+    return UnknownVal();
+
+  const TypedRegion *R = cast<TypedRegion>(MR);
+  QualType RTy = R->getValueType(Ctx);
+
+  // Aggregates are read lazily; their parts are looked up when used.
+  if (RTy->isStructureType() || RTy->isArrayType())
+    return ValMgr.makeLazyCompoundVal(store, R);
+
+  // FIXME: Handle unions and vectors.
+  if (RTy->isUnionType() || RTy->isVectorType())
+    return UnknownVal();
+
+  // Elements of string literals are known.
+  if (const ElementRegion *ER = dyn_cast<ElementRegion>(R))
+    if (const StringRegion *StrR =
+          dyn_cast<StringRegion>(ER->getSuperRegion())) {
+      QualType CharTy = Ctx.getCanonicalType(
+        Ctx.getAsArrayType(StrR->getValueType(Ctx))->getElementType());
+      if (ER->hasConstantIndex() &&
+          CharTy == Ctx.getCanonicalType(ER->getElementType())) {
+        const StringLiteral *Str = StrR->getStringLiteral();
+        int64_t i = ER->getConstantIndex();
+        int64_t byteLength = Str->getByteLength();
+        if (i < 0 || i > byteLength)
+          return UnknownVal();
+        char c = (i == byteLength) ? '\0' : Str->getStrData()[i];
+        return ValMgr.makeIntVal(c, CharTy);
+      }
+    }
+
+  return CastRetrievedVal(RetrieveScalar(store, R, RTy), R, T, false);
+}
+
+/// RetrieveScalar - Return the value of a region of scalar type: a direct
+///  binding of exactly its bits, or else what the innermost default binding
+///  covering it implies.  Any other overlapping binding means the bits were
+///  written as something else, and the value is unknown.
+SVal FlatStoreManager::RetrieveScalar(Store store, const TypedRegion *R,
+                                      QualType Ty) {
+  FlatBindingKey K;
+  bool Exact = getBindingKey(R, K);
+
+  llvm::SmallVector<FlatBinding, 8> Overlaps;
+  collectBindings(store, K, Overlaps);
+  if (Overlaps.empty())
+    return RetrieveUnbound(R, Ty);
+
+  const FlatBinding *Default = 0;
+  for (unsigned I = 0, N = Overlaps.size(); I != N; ++I) {
+    const FlatBindingKey &X = Overlaps[I].first;
+    if (X.isDirect()) {
+      if (Exact && X.sameRange(K))
+        return Overlaps[I].second;
+      return UnknownVal();
+    }
+    if (!X.contains(K))
+      return UnknownVal();
+    if (!Default || Default->first.contains(X))
+      Default = &Overlaps[I];
+  }
+
+  SVal D = Default->second;
+  // With an unknown offset, only a value for the whole enclosing range says
+  // anything about R.
+  if (!Exact && !Default->first.sameRange(K))
+    return UnknownVal();
+
+  if (const nonloc::LazyCompoundVal *LCV =
+        dyn_cast<nonloc::LazyCompoundVal>(&D))
+    return RetrieveLazy(*LCV, Default->first, R, Ty);
+
+  if (SymbolRef parentSym = D.getAsSymbol())
+    return ValMgr.getDerivedRegionValueSymbolVal(parentSym, R);
+
+  if (D.isZeroConstant())
+    return ValMgr.makeZeroVal(Ty);
+
+  if (D.isUndef())
+    return D;
+
+  return UnknownVal();
+}
+
+/// RetrieveLazy - Read R from the copy of an aggregate bound lazily to the
+///  range of K, by finding the same part of the aggregate that was copied.
+SVal FlatStoreManager::RetrieveLazy(const nonloc::LazyCompoundVal &LCV,
+                                    const FlatBindingKey &K,
+                                    const TypedRegion *R, QualType Ty) {
+  const TypedRegion *From = LCV.getRegion();
+  QualType FromTy = Ctx.getCanonicalType(From->getValueType(Ctx));
+
+  // Find the region the aggregate was copied to, which covers K and has the
+  // type of the copied aggregate.
+  llvm::SmallVector<const SubRegion*, 8> Path;
+  const MemRegion *To = R;
+  while (true) {
+    FlatBindingKey ToK;
+    if (const TypedRegion *TR = dyn_cast<TypedRegion>(To))
+      if (getBindingKey(To, ToK) && ToK.sameRange(K) &&
+          Ctx.getCanonicalType(TR->getValueType(Ctx)) == FromTy)
+        break;
+    if (!isa<FieldRegion>(To) && !isa<ElementRegion>(To))
+      return UnknownVal();
+    Path.push_back(cast<SubRegion>(To));
+    To = Path.back()->getSuperRegion();
+  }
+
+  // Rebuild the path from that region to R on top of the source.
+  const MemRegion *NewR = From;
+  while (!Path.empty()) {
+    const SubRegion *SR = Path.pop_back_val();
+    if (const ElementRegion *ER = dyn_cast<ElementRegion>(SR))
+      NewR = MRMgr.getElementRegionWithSuper(ER, NewR);
     else
-      return RetrieveRegionWithNoBinding(R, T);
+      NewR = MRMgr.getFieldRegionWithSuper(cast<FieldRegion>(SR), NewR);
   }
-  return RetrieveRegionWithNoBinding(R, T);
+
+  return Retrieve(LCV.getStore(), loc::MemRegionVal(NewR), Ty);
 }
 
-SVal FlatStoreManager::RetrieveRegionWithNoBinding(const MemRegion *R,
-                                                   QualType T) {
-  if (R->hasStackNonParametersStorage())
+/// RetrieveUnbound - Return the value of a region that was never written:
+///  the value it had on entry to the analyzed function.
+SVal FlatStoreManager::RetrieveUnbound(const TypedRegion *R, QualType Ty) {
+  if (const VarRegion *VR = dyn_cast<VarRegion>(R)) {
+    const VarDecl *VD = VR->getDecl();
+    const MemSpaceRegion *MS = VR->getMemorySpace();
+
+    if (isa<UnknownSpaceRegion>(MS) || isa<StackArgumentsSpaceRegion>(MS))
+      return ValMgr.getRegionValueSymbolVal(R, Ty);
+
+    if (isa<GlobalsSpaceRegion>(MS)) {
+      if (VD->isFileVarDecl())
+        return ValMgr.getRegionValueSymbolVal(R, Ty);
+
+      if (Ty->isIntegerType())
+        return ValMgr.makeIntVal(0, Ty);
+      if (Ty->isPointerType())
+        return ValMgr.makeNull();
+
+      return UnknownVal();
+    }
+
+    return UndefinedVal();
+  }
+
+  if (R->hasStackNonParametersStorage()) {
+    // Currently we don't reason specially about Clang-style vectors.
+    if (const ElementRegion *ER = dyn_cast<ElementRegion>(R))
+      if (const TypedRegion *SuperR =
+            dyn_cast<TypedRegion>(ER->getSuperRegion()))
+        if (SuperR->getValueType(Ctx)->isVectorType())
+          return UnknownVal();
+
     return UndefinedVal();
-  else
-    return ValMgr.getRegionValueSymbolVal(R, T);
+  }
+
+  // All other values are symbolic.
+  return ValMgr.getRegionValueSymbolVal(R, Ty);
 }
 
-Store FlatStoreManager::Bind(Store store, Loc L, SVal val) {
+//===----------------------------------------------------------------------===//
+// Binding values to regions.
+//===----------------------------------------------------------------------===//
+
+Store FlatStoreManager::Bind(Store store, Loc L, SVal V) {
+  if (!isa<loc::MemRegionVal>(L))
+    return store;
+
   const MemRegion *R = cast<loc::MemRegionVal>(L).getRegion();
-  RegionBindings B = getRegionBindings(store);
-  const BindingVal *V = B.lookup(R);
 
-  BindingVal BV = BVFactory.GetEmptyMap();
-  if (V)
-    BV = *V;
+  if (const TypedRegion *TR = dyn_cast<TypedRegion>(R)) {
+    QualType T = TR->getValueType(Ctx);
+    if (T->isStructureType() || T->isArrayType())
+      return BindAggregate(store, TR, V);
+  }
 
-  Interval I = RegionToInterval(R);
-  BV = BVFactory.Add(BV, I, val);
-  B = RBFactory.Add(B, R, BV);
-  return B.getRoot();
+  // Special case: the current region represents a cast and it and the super
+  // region both have pointer types or intptr_t types.  If so, perform the
+  // bind to the super region.
+  // This is needed to support OSAtomicCompareAndSwap and friends or other
+  // loads that treat integers as pointers and vis versa.
+  if (const ElementRegion *ER = dyn_cast<ElementRegion>(R)) {
+    if (ER->hasConstantIndex() && ER->getConstantIndex() == 0)
+      if (const TypedRegion *superR =
+            dyn_cast<TypedRegion>(ER->getSuperRegion())) {
+        QualType superTy = superR->getValueType(Ctx);
+        QualType erTy = ER->getValueType(Ctx);
+
+        if (IsAnyPointerOrIntptr(superTy, Ctx) &&
+            IsAnyPointerOrIntptr(erTy, Ctx)) {
+          V = ValMgr.getSValuator().EvalCast(V, superTy, erTy);
+          return Bind(store, loc::MemRegionVal(superR), V);
+        }
+      }
+  }
+  else if (const SymbolicRegion *SR = dyn_cast<SymbolicRegion>(R)) {
+    // Binding directly to a symbolic region should be treated as binding
+    // to element 0.
+    QualType T = SR->getSymbol()->getType(Ctx);
+    if (const PointerType *PT = T->getAs<PointerType>())
+      T = PT->getPointeeType();
+    else if (const ReferenceType *RT = T->getAs<ReferenceType>())
+      T = RT->getPointeeType();
+    else
+      T = QualType();
+
+    if (!T.isNull() && !T->isVoidType())
+      R = getElementZeroRegion(SR, T);
+  }
+
+  FlatBindingKey K;
+  if (!getBindingKey(R, K))
+    return killRange(store, K, UnknownVal());
+
+  RegionBindings B = removeRange(getRegionBindings(store), K);
+  return RBFactory.Add(B, K, V).getRoot();
 }
 
-Store FlatStoreManager::Remove(Store store, Loc L) {
+/// BindAggregate - Bind a struct or array region.  A copy of another
+///  aggregate becomes one lazy default binding over the range; its parts are
+///  read from the source when they are used.
+Store FlatStoreManager::BindAggregate(Store store, const TypedRegion *R,
+                                      SVal V) {
+  QualType T = Ctx.getCanonicalType(R->getValueType(Ctx));
+
+  if (const RecordType *RT = T->getAs<RecordType>())
+    if (!RT->getDecl()->getDefinition())
+      return store;
+
+  FlatBindingKey K;
+  if (!getBindingKey(R, K))
+    return killRange(store, K, UnknownVal());
+
+  if (isa<nonloc::LazyCompoundVal>(V))
+    return killRange(store, K, V);
+
+  const ArrayType *AT = dyn_cast<ArrayType>(T);
+  if (AT && isa<loc::MemRegionVal>(V))
+    if (const StringRegion *Str =
+          dyn_cast<StringRegion>(cast<loc::MemRegionVal>(V).getRegion()))
+      return BindString(store, R, AT->getElementType(), Str);
+
+  // We may get non-CompoundVal accidentally due to imprecise cast logic.
+  // Ignore them and kill the values of the parts.
+  if (!isa<nonloc::CompoundVal>(V))
+    return killRange(store, K, UnknownVal());
+
+  nonloc::CompoundVal& CV = cast<nonloc::CompoundVal>(V);
+  nonloc::CompoundVal::iterator VI = CV.begin(), VE = CV.end();
+
+  // Parts the init list leaves out, or sets to zero, are covered by a zero
+  // default value rather than a binding each.
+  uint64_t NumInits = 0, NumParts = 0;
+  bool ZeroDefault = false;
+  for (nonloc::CompoundVal::iterator I = VI; I != VE; ++I, ++NumInits)
+    if (I->isZeroConstant())
+      ZeroDefault = true;
+
+  if (AT) {
+    if (const ConstantArrayType *CAT = dyn_cast<ConstantArrayType>(AT))
+      NumParts = CAT->getSize().getZExtValue();
+    else
+      NumParts = NumInits;
+  } else {
+    const RecordDecl *RD = T->getAs<RecordType>()->getDecl()->getDefinition();
+    for (RecordDecl::field_iterator FI = RD->field_begin(),
+         FE = RD->field_end(); FI != FE; ++FI)
+      ++NumParts;
+  }
+  if (NumInits < NumParts)
+    ZeroDefault = true;
+
+  store = killRange(store, K, ZeroDefault ? ValMgr.makeIntVal(0, false)
+                                          : SVal(UnknownVal()));
+
+  if (AT) {
+    QualType ElementTy = AT->getElementType();
+    for (uint64_t i = 0; i < NumParts && VI != VE; ++i, ++VI) {
+      if (ZeroDefault && VI->isZeroConstant())
+        continue;
+      const ElementRegion *ER =
+        MRMgr.getElementRegion(ElementTy, ValMgr.makeArrayIndex(i), R, Ctx);
+      store = Bind(store, ValMgr.makeLoc(ER), *VI);
+    }
+    return store;
+  }
+
+  const RecordDecl *RD = T->getAs<RecordType>()->getDecl()->getDefinition();
+  for (RecordDecl::field_iterator FI = RD->field_begin(), FE = RD->field_end();
+       FI != FE && VI != VE; ++FI, ++VI) {
+    if (ZeroDefault && VI->isZeroConstant())
+      continue;
+    const FieldRegion *FR = MRMgr.getFieldRegion(*FI, R);
+    store = Bind(store, ValMgr.makeLoc(FR), *VI);
+  }
   return store;
 }
 
+/// BindString - Copy the bytes of a string literal into a char array.  The
+///  bytes past the literal, and the NUL bytes within it, are left to a zero
+///  default value.
+Store FlatStoreManager::BindString(Store store, const TypedRegion *R,
+                                   QualType ElementTy,
+                                   const StringRegion *Str) {
+  FlatBindingKey K;
+  getBindingKey(R, K);
+
+  const StringLiteral *S = Str->getStringLiteral();
+  const char *str = S->getStrData();
+  uint64_t len = S->getByteLength();
+  uint64_t size = len;
+  if (const ConstantArrayType *CAT = Ctx.getAsConstantArrayType(
+                                                   R->getValueType(Ctx)))
+    size = CAT->getSize().getZExtValue();
+
+  store = killRange(store, K, ValMgr.makeIntVal(0, false));
+  for (uint64_t i = 0; i < size && i < len; ++i) {
+    if (str[i] == '\0')
+      continue;
+    const ElementRegion *ER =
+      MRMgr.getElementRegion(ElementTy, ValMgr.makeArrayIndex(i), R, Ctx);
+    store = Bind(store, loc::MemRegionVal(ER),
+                 ValMgr.makeIntVal(str[i], sizeof(char)*8, true));
+  }
+  return store;
+}
+
+Store FlatStoreManager::Remove(Store store, Loc L) {
+  if (!isa<loc::MemRegionVal>(L))
+    return store;
+
+  FlatBindingKey K;
+  const MemRegion *R = cast<loc::MemRegionVal>(L).getRegion();
+  if (!getBindingKey(R, K))
+    return killRange(store, K, UnknownVal());
+  return removeRange(getRegionBindings(store), K).getRoot();
+}
+
 Store FlatStoreManager::BindCompoundLiteral(Store store,
                                             const CompoundLiteralExpr* cl,
                                             const LocationContext *LC,
                                             SVal v) {
-  return store;
+  return Bind(store, loc::MemRegionVal(MRMgr.getCompoundLiteralRegion(cl, LC)),
+              v);
+}
+
+Store FlatStoreManager::BindDecl(Store store, const VarRegion *VR,
+                                 SVal initVal) {
+  return Bind(store, ValMgr.makeLoc(VR), initVal);
 }
 
+//===----------------------------------------------------------------------===//
+// Arrays and pointer arithmetic.
+//===----------------------------------------------------------------------===//
+
 SVal FlatStoreManager::ArrayToPointer(Loc Array) {
-  return Array;
+  if (!isa<loc::MemRegionVal>(Array))
+    return UnknownVal();
+
+  const TypedRegion* ArrayR =
+    dyn_cast<TypedRegion>(cast<loc::MemRegionVal>(Array).getRegion());
+  if (!ArrayR)
+    return UnknownVal();
+
+  const ArrayType *AT = Ctx.getAsArrayType(ArrayR->getValueType(Ctx));
+  if (!AT)
+    return UnknownVal();
+
+  return loc::MemRegionVal(getElementZeroRegion(ArrayR, AT->getElementType()));
 }
 
-Store FlatStoreManager::BindDecl(Store store, const VarRegion *VR, 
-                                 SVal initVal) {
-  return store;
+SVal FlatStoreManager::EvalBinOp(BinaryOperator::Opcode Op, Loc L, NonLoc R,
+                                 QualType resultTy) {
+  if (!isa<loc::MemRegionVal>(L))
+    return UnknownVal();
+
+  const MemRegion* MR = cast<loc::MemRegionVal>(L).getRegion();
+  const ElementRegion *ER = dyn_cast<ElementRegion>(MR);
+
+  if (const SymbolicRegion *SR = dyn_cast<SymbolicRegion>(MR)) {
+    QualType T = SR->getSymbol()->getType(Ctx);
+    QualType EleTy;
+    if (const PointerType *PT = T->getAs<PointerType>())
+      EleTy = PT->getPointeeType();
+    else if (const ObjCObjectPointerType *OPT =
+               T->getAs<ObjCObjectPointerType>())
+      EleTy = OPT->getPointeeType();
+    else
+      return UnknownVal();
+    ER = getElementZeroRegion(SR, EleTy);
+  }
+  else if (isa<AllocaRegion>(MR)) {
+    ER = getElementZeroRegion(MR, Ctx.CharTy);
+  }
+
+  if (!ER)
+    return UnknownVal();
+
+  // For now, only support:
+  //  (a) concrete integer indices that can easily be resolved
+  //  (b) 0 + symbolic index
+  SVal Idx = ER->getIndex();
+  if (nonloc::ConcreteInt *Base = dyn_cast<nonloc::ConcreteInt>(&Idx)) {
+    if (nonloc::ConcreteInt *Offset = dyn_cast<nonloc::ConcreteInt>(&R)) {
+      SVal NewIdx =
+        Base->evalBinOp(ValMgr, Op,
+                cast<nonloc::ConcreteInt>(ValMgr.convertToArrayIndex(*Offset)));
+      return ValMgr.makeLoc(MRMgr.getElementRegion(ER->getElementType(), NewIdx,
+                                                   ER->getSuperRegion(), Ctx));
+    }
+    if (0 == Base->getValue())
+      return ValMgr.makeLoc(MRMgr.getElementRegion(ER->getElementType(), R,
+                                                   ER->getSuperRegion(), Ctx));
+  }
+
+  return UnknownVal();
 }
 
-Store FlatStoreManager::BindDeclWithNoInit(Store store, const VarRegion *VR) {
-  return store;
+//===----------------------------------------------------------------------===//
+// Binding invalidation.
+//===----------------------------------------------------------------------===//
+
+Store FlatStoreManager::InvalidateRegions(Store store,
+                                          const MemRegion * const *I,
+                                          const MemRegion * const *E,
+                                          const Expr *Ex, unsigned Count,
+                                          InvalidatedSymbols *IS) {
+  // Everything reachable from the invalidated regions through their
+  // bindings is invalidated too, one base region at a time.
+  llvm::SmallVector<const MemRegion*, 10> WL;
+  llvm::DenseSet<const MemRegion*> Visited;
+  for ( ; I != E; ++I)
+    WL.push_back((*I)->StripCasts()->getBaseRegion());
+
+  RegionBindings B = getRegionBindings(store);
+
+  while (!WL.empty()) {
+    const MemRegion *baseR = WL.pop_back_val();
+    if (Visited.count(baseR))
+      continue;
+    Visited.insert(baseR);
+
+    FlatBindingKey All(baseR, FlatBindingKey::MinOffset(),
+                       FlatBindingKey::WholeRegion,
+                       FlatBindingKey::Direct);
+    llvm::SmallVector<FlatBinding, 8> Bindings;
+    collectBindings(B.getRoot(), All, Bindings);
+
+    // Visit the old bindings, and the bindings of the aggregates they copy.
+    unsigned NumOwn = Bindings.size();
+    for (unsigned Idx = 0; Idx != Bindings.size(); ++Idx) {
+      SVal V = Bindings[Idx].second;
+      if (Idx < NumOwn)
+        B = RBFactory.Remove(B, Bindings[Idx].first);
+
+      if (const nonloc::LazyCompoundVal *LCV =
+            dyn_cast<nonloc::LazyCompoundVal>(&V)) {
+        FlatBindingKey K;
+        getBindingKey(LCV->getRegion(), K);
+        collectBindings(LCV->getStore(), K, Bindings);
+        continue;
+      }
+
+      if (IS)
+        if (SymbolRef Sym = V.getAsSymbol())
+          IS->insert(Sym);
+
+      if (const MemRegion *R = V.getAsRegion())
+        WL.push_back(R->getBaseRegion());
+    }
+
+    // Symbolic region?  Mark that symbol touched by the invalidation.
+    if (IS)
+      if (const SymbolicRegion *SR = dyn_cast<SymbolicRegion>(baseR))
+        IS->insert(SR->getSymbol());
+
+    // BlockDataRegion?  If so, invalidate captured variables that are passed
+    // by reference.
+    if (const BlockDataRegion *BR = dyn_cast<BlockDataRegion>(baseR)) {
+      for (BlockDataRegion::referenced_vars_iterator
+           BI = BR->referenced_vars_begin(), BE = BR->referenced_vars_end() ;
+           BI != BE; ++BI) {
+        const VarRegion *VR = *BI;
+        const VarDecl *VD = VR->getDecl();
+        if (VD->getAttr<BlocksAttr>() || !VD->hasLocalStorage())
+          WL.push_back(VR);
+      }
+      continue;
+    }
+
+    FlatBindingKey K;
+    getBindingKey(baseR, K);
+
+    if (isa<AllocaRegion>(baseR) || isa<SymbolicRegion>(baseR)) {
+      // Invalidate the region by setting its default value to
+      // conjured symbol. The type of the symbol is irrelavant.
+      DefinedOrUnknownSVal V = ValMgr.getConjuredSymbolVal(baseR, Ex, Ctx.IntTy,
+                                                           Count);
+      B = RBFactory.Add(B, K.withKind(FlatBindingKey::Default), V);
+      continue;
+    }
+
+    if (!baseR->isBoundable())
+      continue;
+
+    QualType T = cast<TypedRegion>(baseR)->getValueType(Ctx);
+
+    if (const RecordType *RT = T->getAsStructureType()) {
+      // No record definition.  There is nothing we can do.
+      if (!RT->getDecl()->getDefinition())
+        continue;
+
+      DefinedOrUnknownSVal V = ValMgr.getConjuredSymbolVal(baseR, Ex, Ctx.IntTy,
+                                                           Count);
+      B = RBFactory.Add(B, K.withKind(FlatBindingKey::Default), V);
+      continue;
+    }
+
+    if (const ArrayType *AT = Ctx.getAsArrayType(T)) {
+      // Set the default value of the array to conjured symbol.
+      DefinedOrUnknownSVal V =
+        ValMgr.getConjuredSymbolVal(baseR, Ex, AT->getElementType(), Count);
+      B = RBFactory.Add(B, K.withKind(FlatBindingKey::Default), V);
+      continue;
+    }
+
+    DefinedOrUnknownSVal V = ValMgr.getConjuredSymbolVal(baseR, Ex, T, Count);
+    assert(SymbolManager::canSymbolicate(T) || V.isUnknown());
+    B = RBFactory.Add(B, K, V);
+  }
+
+  return B.getRoot();
 }
 
-Store FlatStoreManager::InvalidateRegion(Store store, const MemRegion *R,
-                                         const Expr *E, unsigned Count,
-                                         InvalidatedSymbols *IS) {
-  return store;
+//===----------------------------------------------------------------------===//
+// State pruning.
+//===----------------------------------------------------------------------===//
+
+Store FlatStoreManager::RemoveDeadBindings(Store store, Stmt* Loc,
+                                           SymbolReaper& SymReaper,
+                           llvm::SmallVectorImpl<const MemRegion*>& RegionRoots)
+{
+  // Liveness is tracked per base region.  A node is a base region together
+  // with the store its bindings are read from, which differs from 'store'
+  // for the sources of lazy copies.
+  typedef std::pair<Store, const MemRegion *> RBDNode;
+  llvm::SmallVector<RBDNode, 10> WorkList;
+  llvm::SmallVector<RBDNode, 10> Postponed;
+  llvm::DenseSet<RBDNode> Visited;
+
+  RegionBindings B = getRegionBindings(store);
+
+  // The roots are the live variables, and the symbolic regions of live
+  // symbols.  Regions nested in them share their fate.
+  const MemRegion *LastBase = 0;
+  for (RegionBindings::iterator I = B.begin(), E = B.end(); I != E; ++I) {
+    const MemRegion *Base = I.getKey().getBase();
+    if (Base == LastBase)
+      continue;
+    LastBase = Base;
+
+    for (const MemRegion *R = Base; ; R = cast<SubRegion>(R)->getSuperRegion()) {
+      if (const VarRegion *VR = dyn_cast<VarRegion>(R)) {
+        if (SymReaper.isLive(Loc, VR))
+          WorkList.push_back(std::make_pair(store, Base));
+        break;
+      }
+      if (const SymbolicRegion *SR = dyn_cast<SymbolicRegion>(R)) {
+        if (SymReaper.isLive(SR->getSymbol()))
+          WorkList.push_back(std::make_pair(store, Base));
+        else
+          Postponed.push_back(std::make_pair(store, Base));
+        break;
+      }
+      if (!isa<SubRegion>(R) || isa<MemSpaceRegion>(
+                                  cast<SubRegion>(R)->getSuperRegion()))
+        break;
+    }
+  }
+
+  for (llvm::SmallVectorImpl<const MemRegion*>::iterator I=RegionRoots.begin(),
+       E=RegionRoots.end(); I!=E; ++I)
+    WorkList.push_back(std::make_pair(store, (*I)->getBaseRegion()));
+  RegionRoots.clear();
+
+tryAgain:
+  while (!WorkList.empty()) {
+    RBDNode N = WorkList.pop_back_val();
+    if (Visited.count(N))
+      continue;
+    Visited.insert(N);
+
+    const MemRegion *Base = N.second;
+    Store store_N = N.first;
+
+    // Keep tracking the symbols of the symbolic regions this one is in.
+    for (const MemRegion *R = Base; isa<SubRegion>(R);
+         R = cast<SubRegion>(R)->getSuperRegion())
+      if (const SymbolicRegion *SymR = dyn_cast<SymbolicRegion>(R))
+        SymReaper.markLive(SymR->getSymbol());
+
+    // For BlockDataRegions, enqueue the VarRegions for variables marked
+    // with __block (passed-by-reference).
+    if (const BlockDataRegion *BD = dyn_cast<BlockDataRegion>(Base)) {
+      for (BlockDataRegion::referenced_vars_iterator
+            RI = BD->referenced_vars_begin(), RE = BD->referenced_vars_end();
+           RI != RE; ++RI) {
+        if ((*RI)->getDecl()->getAttr<BlocksAttr>())
+          WorkList.push_back(std::make_pair(store_N, *RI));
+      }
+      continue;
+    }
+
+    FlatBindingKey All(Base, FlatBindingKey::MinOffset(),
+                       FlatBindingKey::WholeRegion,
+                       FlatBindingKey::Direct);
+    llvm::SmallVector<FlatBinding, 8> Bindings;
+    collectBindings(store_N, All, Bindings);
+
+    for (unsigned I = 0, E = Bindings.size(); I != E; ++I) {
+      SVal V = Bindings[I].second;
+
+      if (const nonloc::LazyCompoundVal *LCV =
+            dyn_cast<nonloc::LazyCompoundVal>(&V)) {
+        WorkList.push_back(std::make_pair(LCV->getStore(),
+                                          LCV->getRegion()->getBaseRegion()));
+        continue;
+      }
+
+      // Update the set of live symbols.
+      for (SVal::symbol_iterator SI = V.symbol_begin(), SE = V.symbol_end();
+           SI != SE; ++SI)
+        SymReaper.markLive(*SI);
+
+      // If V is a region, then its bindings are live as well.
+      if (const MemRegion *RX = V.getAsRegion())
+        WorkList.push_back(std::make_pair(store, RX->getBaseRegion()));
+    }
+  }
+
+  // See if any postponed SymbolicRegions are actually live now, after
+  // having done a scan.
+  for (llvm::SmallVectorImpl<RBDNode>::iterator I = Postponed.begin(),
+       E = Postponed.end() ; I != E ; ++I) {
+    if (!I->second)
+      continue;
+    for (const MemRegion *R = I->second; isa<SubRegion>(R);
+         R = cast<SubRegion>(R)->getSuperRegion())
+      if (const SymbolicRegion *SR = dyn_cast<SymbolicRegion>(R)) {
+        if (SymReaper.isLive(SR->getSymbol())) {
+          WorkList.push_back(*I);
+          I->second = NULL;
+        }
+        break;
+      }
+  }
+
+  if (!WorkList.empty())
+    goto tryAgain;
+
+  // Remove the bindings of the dead base regions, and update the set of
+  // symbols that are now dead.
+  RegionBindings NewB = B;
+  for (RegionBindings::iterator I = B.begin(), E = B.end(); I != E; ++I) {
+    const MemRegion *Base = I.getKey().getBase();
+    if (Visited.count(std::make_pair(store, Base)))
+      continue;
+
+    NewB = RBFactory.Remove(NewB, I.getKey());
+
+    if (const SymbolicRegion *SymR = dyn_cast<SymbolicRegion>(Base))
+      SymReaper.maybeDead(SymR->getSymbol());
+
+    SVal X = I.getData();
+    for (SVal::symbol_iterator SI = X.symbol_begin(), SE = X.symbol_end();
+         SI != SE; ++SI)
+      SymReaper.maybeDead(*SI);
+  }
+
+  return NewB.getRoot();
 }
 
-void FlatStoreManager::print(Store store, llvm::raw_ostream& Out, 
+//===----------------------------------------------------------------------===//
+// Utility methods.
+//===----------------------------------------------------------------------===//
+
+void FlatStoreManager::print(Store store, llvm::raw_ostream& Out,
                              const char* nl, const char *sep) {
+  RegionBindings B = getRegionBindings(store);
+  Out << "Store (flat bindings):" << nl;
+
+  for (RegionBindings::iterator I = B.begin(), E = B.end(); I != E; ++I)
+    Out << ' ' << I.getKey() << " : " << I.getData() << nl;
 }
 
+/// iterBindings - Hand each binding to f with a region standing for its
+///  range: the base region itself, or the char element at its byte offset.
 void FlatStoreManager::iterBindings(Store store, BindingsHandler& f) {
-}
+  RegionBindings B = getRegionBindings(store);
 
-Interval FlatStoreManager::RegionToInterval(const MemRegion *R) { 
-  switch (R->getKind()) {
-  case MemRegion::VarRegionKind: {
-    QualType T = cast<VarRegion>(R)->getValueType(Ctx);
-    uint64_t Size = Ctx.getTypeSize(T);
-    return Interval(0, Size-1);
-  }
-  default:
-    llvm_unreachable("Region kind unhandled.");
-    return Interval(0, 0);
+  for (RegionBindings::iterator I = B.begin(), E = B.end(); I != E; ++I) {
+    const FlatBindingKey &K = I.getKey();
+    const MemRegion *R = K.getBase();
+    uint64_t CharWidth = Ctx.getTypeSize(Ctx.CharTy);
+    if (K.getOffset() > 0 && K.getOffset() % (int64_t) CharWidth == 0)
+      R = MRMgr.getElementRegion(Ctx.CharTy,
+                                 ValMgr.makeArrayIndex(K.getOffset() /
+                                                       (int64_t) CharWidth),
+                                 R, Ctx);
+    if (!f.HandleBinding(*this, store, R, I.getData()))
+      return;
   }
 }
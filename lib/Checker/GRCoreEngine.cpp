@@ -17,10 +17,13 @@
 #include "clang/AST/Expr.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/System/Process.h"
+#include "llvm/System/TimeValue.h"
 #include <vector>
 #include <queue>
 
 using llvm::cast;
+using llvm::dyn_cast;
 using llvm::isa;
 using namespace clang;
 
@@ -115,6 +118,91 @@ GRWorkList* GRWorkList::MakeBFSBlockDFSContents() {
   return new BFSBlockDFSContents();
 }
 
+namespace {
+  /// CoverageGuided - Like BFSBlockDFSContents, processes basic blocks to
+  ///  completion, but picks the next block to enter by how often blocks have
+  ///  been entered: first on any path, so that unexplored blocks come first,
+  ///  and then on the path itself, so that leaving a loop comes before going
+  ///  around it again.  Paths that rank the same are taken in order.
+  class CoverageGuided : public GRWorkList {
+    struct Entry {
+      GRWorkListUnit U;
+      const CFGBlock *Block;
+      unsigned Visits, PathVisits, Order;
+
+      Entry(const GRWorkListUnit &u, const CFGBlock *B, unsigned V,
+            unsigned Idx)
+        : U(u), Block(B), Visits(V),
+          PathVisits(u.getBlockCounter().getNumVisited(B->getBlockID())),
+          Order(Idx) {}
+
+      /// operator< - Returns true if this entry ranks below RHS.
+      bool operator<(const Entry &RHS) const {
+        if (Visits != RHS.Visits)
+          return Visits > RHS.Visits;
+        if (PathVisits != RHS.PathVisits)
+          return PathVisits > RHS.PathVisits;
+        return Order > RHS.Order;
+      }
+    };
+
+    std::priority_queue<Entry> Queue;
+    llvm::SmallVector<GRWorkListUnit,20> Stack;
+
+    /// Visits - The number of times each block has been entered.
+    llvm::DenseMap<const CFGBlock*, unsigned> Visits;
+
+    unsigned NumEnqueued;
+
+  public:
+    CoverageGuided() : NumEnqueued(0) {}
+
+    virtual bool hasWork() const {
+      return !Queue.empty() || !Stack.empty();
+    }
+
+    virtual void Enqueue(const GRWorkListUnit& U) {
+      ProgramPoint Loc = U.getNode()->getLocation();
+      if (const BlockEntrance *BE = dyn_cast<BlockEntrance>(&Loc)) {
+        const CFGBlock *B = BE->getBlock();
+        Queue.push(Entry(U, B, Visits.lookup(B), NumEnqueued++));
+      }
+      else
+        Stack.push_back(U);
+    }
+
+    virtual GRWorkListUnit Dequeue() {
+      if (!Stack.empty()) {
+        const GRWorkListUnit& U = Stack.back();
+        Stack.pop_back(); // This technically "invalidates" U, but we are fine.
+        return U;
+      }
+
+      assert(!Queue.empty());
+      for (;;) {
+        Entry E = Queue.top();
+        Queue.pop();
+
+        // The block may have been entered since the entry was queued; if so,
+        // rank it again.
+        unsigned &V = Visits[E.Block];
+        if (V != E.Visits && !Queue.empty()) {
+          E.Visits = V;
+          Queue.push(E);
+          continue;
+        }
+
+        ++V;
+        return E.U;
+      }
+    }
+  };
+} // end anonymous namespace
+
+GRWorkList* GRWorkList::MakeCoverageGuided() {
+  return new CoverageGuided();
+}
+
 //===----------------------------------------------------------------------===//
 // Core analysis engine.
 //===----------------------------------------------------------------------===//
@@ -145,7 +233,15 @@ void GRCoreEngine::ProcessSwitch(GRSwitchNodeBuilder& Builder) {
 }
 
 /// ExecuteWorkList - Run the worklist algorithm for a maximum number of steps.
-bool GRCoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps) {
+bool GRCoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
+                                   unsigned MaxNodes, unsigned MaxMillis,
+                                   unsigned MaxMB) {
+  ExceededBudget = NoBudget;
+  llvm::sys::TimeValue Deadline = llvm::sys::TimeValue::now() +
+    llvm::sys::TimeValue(MaxMillis / 1000, (MaxMillis % 1000) *
+                         llvm::sys::TimeValue::NANOSECONDS_PER_MILLISECOND);
+  size_t MemoryLimit = llvm::sys::Process::GetMallocUsage() +
+                       (size_t)MaxMB * 1024 * 1024;
 
   if (G->num_roots() == 0) { // Initialize the analysis by constructing
     // the root if none exists.
@@ -172,8 +268,30 @@ bool GRCoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps) {
     GenerateNode(StartLoc, getInitialState(L), 0);
   }
 
-  while (Steps && WList->hasWork()) {
-    --Steps;
+  for (unsigned Step = 0; WList->hasWork(); ++Step) {
+    // No node builder is alive between steps.
+    G->reclaimRecentNodes();
+
+    if (Step == Steps) {
+      ExceededBudget = StepBudget;
+      break;
+    }
+    if (MaxNodes && G->size() >= MaxNodes) {
+      ExceededBudget = NodeBudget;
+      break;
+    }
+    // Reading the clock and the heap size is too slow to do at every step.
+    if (Step % 256 == 0) {
+      if (MaxMillis && llvm::sys::TimeValue::now() >= Deadline) {
+        ExceededBudget = TimeBudget;
+        break;
+      }
+      if (MaxMB && llvm::sys::Process::GetMallocUsage() >= MemoryLimit) {
+        ExceededBudget = MemoryBudget;
+        break;
+      }
+    }
+
     const GRWorkListUnit& WU = WList->Dequeue();
 
     // Set the current block counter.
@@ -230,6 +348,8 @@ void GRCoreEngine::HandleBlockEdge(const BlockEdge& L, ExplodedNode* Pred) {
 
   if (ProcessBlockEntrance(Blk, Pred->State, WList->getBlockCounter()))
     GenerateNode(BlockEntrance(Blk, Pred->getLocationContext()), Pred->State, Pred);
+  else
+    DroppedPaths = true;
 }
 
 void GRCoreEngine::HandleBlockEntrance(const BlockEntrance& L,
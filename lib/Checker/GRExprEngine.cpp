@@ -158,10 +158,40 @@ public:
 // Checker worklist routines.
 //===----------------------------------------------------------------------===//
 
+void GRExprEngine::addChecker(void *tag, Checker *check, unsigned Callbacks) {
+  CheckerM[tag] = Checkers.size();
+  Checkers.push_back(std::make_pair(tag, check));
+
+  for (unsigned K = 0; K != NumCheckerCallbacks; ++K)
+    if (Callbacks & (1 << K))
+      CallbackCheckers[K].push_back(std::make_pair(tag, check));
+
+  // Ask the checker which statements it visits now, so that CheckerVisit
+  // only calls the checkers that do something for the statement at hand.
+  if (!(Callbacks & (1 << PreVisitCallback | 1 << PostVisitCallback)))
+    return;
+  if (VisitCheckers.empty())
+    VisitCheckers.resize(2 * (Stmt::lastExprConstant + 1));
+  for (unsigned K = 0; K <= Stmt::lastExprConstant; ++K) {
+    Stmt::StmtClass SC = Stmt::StmtClass(K);
+    if (Callbacks & (1 << PostVisitCallback) && check->WantsVisit(SC, false))
+      VisitCheckers[2 * K].push_back(std::make_pair(tag, check));
+    if (Callbacks & (1 << PreVisitCallback) && check->WantsVisit(SC, true))
+      VisitCheckers[2 * K + 1].push_back(std::make_pair(tag, check));
+  }
+}
+
 void GRExprEngine::CheckerVisit(Stmt *S, ExplodedNodeSet &Dst,
                                 ExplodedNodeSet &Src, bool isPrevisit) {
 
-  if (Checkers.empty()) {
+  if (VisitCheckers.empty()) {
+    Dst.insert(Src);
+    return;
+  }
+
+  const CheckersOrdered &VisitList =
+    VisitCheckers[2 * S->getStmtClass() + isPrevisit];
+  if (VisitList.empty()) {
     Dst.insert(Src);
     return;
   }
@@ -169,7 +199,8 @@ void GRExprEngine::CheckerVisit(Stmt *S, ExplodedNodeSet &Dst,
   ExplodedNodeSet Tmp;
   ExplodedNodeSet *PrevSet = &Src;
 
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end(); I!=E;++I){
+  for (CheckersOrdered::const_iterator I = VisitList.begin(),
+         E = VisitList.end(); I != E; ++I) {
     ExplodedNodeSet *CurrSet = 0;
     if (I+1 == E)
       CurrSet = &Dst;
@@ -196,8 +227,9 @@ void GRExprEngine::CheckerEvalNilReceiver(const ObjCMessageExpr *ME,
                                           ExplodedNode *Pred) {
   bool Evaluated = false;
   ExplodedNodeSet DstTmp;
+  const CheckersOrdered &List = CallbackCheckers[NilReceiverCallback];
 
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end();I!=E;++I) {
+  for (CheckersOrdered::const_iterator I=List.begin(),E=List.end();I!=E;++I) {
     void *tag = I->first;
     Checker *checker = I->second;
 
@@ -224,8 +256,9 @@ bool GRExprEngine::CheckerEvalCall(const CallExpr *CE,
                                    ExplodedNode *Pred) {
   bool Evaluated = false;
   ExplodedNodeSet DstTmp;
+  const CheckersOrdered &List = CallbackCheckers[EvalCallCallback];
 
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end();I!=E;++I) {
+  for (CheckersOrdered::const_iterator I=List.begin(),E=List.end();I!=E;++I) {
     void *tag = I->first;
     Checker *checker = I->second;
 
@@ -252,7 +285,8 @@ void GRExprEngine::CheckerVisitBind(const Stmt *AssignE, const Stmt *StoreE,
                                     ExplodedNodeSet &Src,
                                     SVal location, SVal val, bool isPrevisit) {
 
-  if (Checkers.empty()) {
+  const CheckersOrdered &List = CallbackCheckers[BindCallback];
+  if (List.empty()) {
     Dst.insert(Src);
     return;
   }
@@ -260,7 +294,7 @@ void GRExprEngine::CheckerVisitBind(const Stmt *AssignE, const Stmt *StoreE,
   ExplodedNodeSet Tmp;
   ExplodedNodeSet *PrevSet = &Src;
 
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end(); I!=E; ++I)
+  for (CheckersOrdered::const_iterator I=List.begin(),E=List.end(); I!=E; ++I)
   {
     ExplodedNodeSet *CurrSet = 0;
     if (I+1 == E)
@@ -322,7 +356,7 @@ static void RegisterInternalChecks(GRExprEngine &Eng) {
 
 GRExprEngine::GRExprEngine(AnalysisManager &mgr, GRTransferFuncs *tf)
   : AMgr(mgr),
-    CoreEngine(mgr.getASTContext(), *this),
+    CoreEngine(mgr.getASTContext(), mgr.getWorkListCreator()(), *this),
     G(CoreEngine.getGraph()),
     Builder(NULL),
     StateMgr(G.getContext(), mgr.getStoreManagerCreator(),
@@ -335,6 +369,8 @@ GRExprEngine::GRExprEngine(AnalysisManager &mgr, GRTransferFuncs *tf)
     NSExceptionII(NULL), NSExceptionInstanceRaiseSelectors(NULL),
     RaiseSel(GetNullarySelector("raise", G.getContext())),
     BR(mgr, *this), TF(tf) {
+  G.enableNodeReclamation(mgr.getReclaimInterval());
+
   // Register internal checks.
   RegisterInternalChecks(*this);
 
@@ -436,7 +472,8 @@ const GRState* GRExprEngine::getInitialState(const LocationContext *InitLoc) {
 ///  logic for handling assumptions on symbolic values.
 const GRState *GRExprEngine::ProcessAssume(const GRState *state, SVal cond,
                                            bool assumption) {
-  for (CheckersOrdered::iterator I = Checkers.begin(), E = Checkers.end();
+  const CheckersOrdered &List = CallbackCheckers[AssumeCallback];
+  for (CheckersOrdered::const_iterator I = List.begin(), E = List.end();
         I != E; ++I) {
 
     if (!state)
@@ -489,12 +526,13 @@ void GRExprEngine::ProcessStmt(CFGElement CE, GRStmtNodeBuilder& builder) {
     getTF().EvalDeadSymbols(Tmp2, *this, *Builder, EntryNode, CurrentStmt,
                             CleanedState, SymReaper);
 
-    if (Checkers.empty())
+    const CheckersOrdered &List = CallbackCheckers[DeadSymbolsCallback];
+    if (List.empty())
       Tmp.insert(Tmp2);
     else {
       ExplodedNodeSet Tmp3;
       ExplodedNodeSet *SrcSet = &Tmp2;
-      for (CheckersOrdered::iterator I = Checkers.begin(), E = Checkers.end();
+      for (CheckersOrdered::const_iterator I = List.begin(), E = List.end();
            I != E; ++I) {
         ExplodedNodeSet *DstSet = 0;
         if (I+1 == E)
@@ -1060,7 +1098,8 @@ void GRExprEngine::ProcessBranch(Stmt* Condition, Stmt* Term,
                                 Condition->getLocStart(),
                                 "Error evaluating branch");
 
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end();I!=E;++I) {
+  const CheckersOrdered &List = CallbackCheckers[BranchConditionCallback];
+  for (CheckersOrdered::const_iterator I=List.begin(),E=List.end();I!=E;++I) {
     void *tag = I->first;
     Checker *checker = I->second;
     checker->VisitBranchCondition(builder, *this, Condition, tag);
@@ -1187,7 +1226,8 @@ void GRExprEngine::VisitGuardedExpr(Expr* Ex, Expr* L, Expr* R,
 void GRExprEngine::ProcessEndPath(GREndPathNodeBuilder& builder) {
   getTF().EvalEndPath(*this, builder);
   StateMgr.EndPath(builder.getState());
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end(); I!=E;++I){
+  const CheckersOrdered &List = CallbackCheckers[EndPathCallback];
+  for (CheckersOrdered::const_iterator I=List.begin(),E=List.end(); I!=E;++I){
     void *tag = I->first;
     Checker *checker = I->second;
     checker->EvalEndPath(builder, tag, *this);
@@ -1641,7 +1681,8 @@ void GRExprEngine::EvalLocation(ExplodedNodeSet &Dst, Stmt *S,
                                 const GRState* state, SVal location,
                                 const void *tag, bool isLoad) {
   // Early checks for performance reason.
-  if (location.isUnknown() || Checkers.empty()) {
+  const CheckersOrdered &List = CallbackCheckers[LocationCallback];
+  if (location.isUnknown() || List.empty()) {
     Dst.Add(Pred);
     return;
   }
@@ -1650,7 +1691,7 @@ void GRExprEngine::EvalLocation(ExplodedNodeSet &Dst, Stmt *S,
   Src.Add(Pred);
   ExplodedNodeSet *PrevSet = &Src;
 
-  for (CheckersOrdered::iterator I=Checkers.begin(),E=Checkers.end(); I!=E; ++I)
+  for (CheckersOrdered::const_iterator I=List.begin(),E=List.end(); I!=E; ++I)
   {
     ExplodedNodeSet *CurrSet = 0;
     if (I+1 == E)
@@ -15,6 +15,7 @@
 #include "clang/Checker/PathSensitive/GRState.h"
 #include "clang/Checker/PathSensitive/GRTransferFuncs.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
@@ -111,6 +112,7 @@ const GRState* GRStateManager::getPersistentState(GRState& State) {
   llvm::FoldingSetNodeID ID;
   State.Profile(ID);
   void* InsertPos;
+  ++NumStateLookups;
 
   if (GRState* I = StateSet.FindNodeOrInsertPos(ID, InsertPos))
     return I;
@@ -216,6 +218,47 @@ GRStateManager::FindGDMContext(void* K,
   return p.first;
 }
 
+void GRStateManager::PrintStats() const {
+  typedef llvm::DenseMap<void*, std::pair<unsigned, llvm::DenseSet<void*> > >
+          GDMStatsTy;
+  llvm::DenseSet<const void*> Stores, GDMs;
+  GDMStatsTy GDMStats;
+  unsigned NumStates = 0, NumEnvBindings = 0;
+
+  for (llvm::FoldingSet<GRState>::const_iterator I = StateSet.begin(),
+         E = StateSet.end(); I != E; ++I) {
+    ++NumStates;
+    for (Environment::iterator EI = I->Env.begin(), EE = I->Env.end();
+         EI != EE; ++EI)
+      ++NumEnvBindings;
+    Stores.insert(I->St);
+    if (!GDMs.insert(I->GDM.getRoot()).second)
+      continue;
+    for (GRState::GenericDataMap::iterator GI = I->GDM.begin(),
+           GE = I->GDM.end(); GI != GE; ++GI) {
+      std::pair<unsigned, llvm::DenseSet<void*> > &S = GDMStats[GI.getKey()];
+      ++S.first;
+      S.second.insert(GI.getData());
+    }
+  }
+
+  llvm::errs() << "\n*** GRState Stats:\n";
+  llvm::errs() << NumStates << " states created, " << NumStateLookups
+               << " state lookups, "
+               << llvm::format("%.2f", NumStates ? double(NumStateLookups) /
+                                                   NumStates : 0.0)
+               << " lookups per state.\n";
+  llvm::errs() << NumStates * sizeof(GRState) << " bytes of states, "
+               << NumEnvBindings << " environment bindings.\n";
+  llvm::errs() << Stores.size() << " distinct stores, " << GDMs.size()
+               << " distinct generic data maps.\n";
+  for (GDMStatsTy::const_iterator I = GDMStats.begin(), E = GDMStats.end();
+       I != E; ++I)
+    llvm::errs() << "Generic data map entry " << I->first << ": in "
+                 << I->second.first << " data maps, "
+                 << I->second.second.size() << " distinct values.\n";
+}
+
 const GRState* GRStateManager::addGDM(const GRState* St, void* Key, void* Data){
   GRState::GenericDataMap M1 = St->getGDM();
   GRState::GenericDataMap M2 = GDMFactory.Add(M1, Key, Data);
@@ -140,29 +140,39 @@ MemRegionManager::~MemRegionManager() {
 // Basic methods.
 //===----------------------------------------------------------------------===//
 
-bool SubRegion::isSubRegionOf(const MemRegion* R) const {
-  const MemRegion* r = getSuperRegion();
-  while (r != 0) {
-    if (r == R)
-      return true;
-    if (const SubRegion* sr = dyn_cast<SubRegion>(r))
-      r = sr->getSuperRegion();
-    else
-      break;
+SubRegion::SubRegion(const MemRegion* sReg, Kind k)
+  : MemRegion(k), superRegion(sReg) {
+  // Elements and fields share the base region of their super region.
+  bool IsPartOfSuper = k == ElementRegionKind || k == FieldRegionKind;
+  if (const SubRegion *SR = dyn_cast<SubRegion>(sReg)) {
+    BaseRegion = IsPartOfSuper ? SR->BaseRegion : this;
+    Space = SR->Space;
+    Depth = SR->Depth + 1;
+  } else {
+    BaseRegion = IsPartOfSuper ? sReg : this;
+    Space = cast<MemSpaceRegion>(sReg);
+    Depth = 1;
   }
-  return false;
+}
+
+bool SubRegion::isSubRegionOf(const MemRegion* R) const {
+  const SubRegion *SR = dyn_cast_or_null<SubRegion>(R);
+  if (!SR)
+    return R == Space;
+
+  // Only a region higher up in the same memory space can be a super region;
+  // walk up to its depth and compare.
+  if (SR->Depth >= Depth || SR->Space != Space)
+    return false;
+  const SubRegion *r = this;
+  for (unsigned I = Depth - SR->Depth; I != 1; --I)
+    r = cast<SubRegion>(r->getSuperRegion());
+  return r->getSuperRegion() == R;
 }
 
 MemRegionManager* SubRegion::getMemRegionManager() const {
-  const SubRegion* r = this;
-  do {
-    const MemRegion *superRegion = r->getSuperRegion();
-    if (const SubRegion *sr = dyn_cast<SubRegion>(superRegion)) {
-      r = sr;
-      continue;
-    }
-    return superRegion->getMemRegionManager();
-  } while (1);
+  const MemRegion *MS = Space;
+  return MS->getMemRegionManager();
 }
 
 const StackFrameContext *VarRegion::getStackFrame() const {
@@ -613,15 +623,9 @@ MemRegionManager::getAllocaRegion(const Expr* E, unsigned cnt,
 }
 
 const MemSpaceRegion *MemRegion::getMemorySpace() const {
-  const MemRegion *R = this;
-  const SubRegion* SR = dyn_cast<SubRegion>(this);
-
-  while (SR) {
-    R = SR->getSuperRegion();
-    SR = dyn_cast<SubRegion>(R);
-  }
-
-  return dyn_cast<MemSpaceRegion>(R);
+  if (const SubRegion *SR = dyn_cast<SubRegion>(this))
+    return SR->Space;
+  return cast<MemSpaceRegion>(this);
 }
 
 bool MemRegion::hasStackStorage() const {
@@ -645,19 +649,9 @@ bool MemRegion::hasGlobalsOrParametersStorage() const {
 // getBaseRegion strips away all elements and fields, and get the base region
 // of them.
 const MemRegion *MemRegion::getBaseRegion() const {
-  const MemRegion *R = this;
-  while (true) {
-    if (const ElementRegion *ER = dyn_cast<ElementRegion>(R)) {
-      R = ER->getSuperRegion();
-      continue;
-    }
-    if (const FieldRegion *FR = dyn_cast<FieldRegion>(R)) {
-      R = FR->getSuperRegion();
-      continue;
-    }
-    break;
-  }
-  return R;
+  if (const SubRegion *SR = dyn_cast<SubRegion>(this))
+    return SR->BaseRegion;
+  return this;
 }
 
 //===----------------------------------------------------------------------===//
@@ -671,12 +665,9 @@ const MemRegion *MemRegion::StripCasts() const {
       // FIXME: generalize.  Essentially we want to strip away ElementRegions
       // that were layered on a symbolic region because of casts.  We only
       // want to strip away ElementRegions, however, where the index is 0.
-      SVal index = ER->getIndex();
-      if (nonloc::ConcreteInt *CI = dyn_cast<nonloc::ConcreteInt>(&index)) {
-        if (CI->getValue().getSExtValue() == 0) {
-          R = ER->getSuperRegion();
-          continue;
-        }
+      if (ER->hasConstantIndex() && ER->getConstantIndex() == 0) {
+        R = ER->getSuperRegion();
+        continue;
       }
     }
     break;
@@ -707,10 +698,9 @@ RegionRawOffset ElementRegion::getAsRawOffset() const {
     superR = ER->getSuperRegion();
 
     // FIXME: generalize to symbolic offsets.
-    SVal index = ER->getIndex();
-    if (nonloc::ConcreteInt *CI = dyn_cast<nonloc::ConcreteInt>(&index)) {
+    if (ER->hasConstantIndex()) {
       // Update the offset.
-      int64_t i = CI->getValue().getSExtValue();
+      int64_t i = ER->getConstantIndex();
 
       if (i != 0) {
         QualType elemType = ER->getElementType();
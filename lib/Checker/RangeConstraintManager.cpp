@@ -18,6 +18,7 @@
 #include "clang/Checker/PathSensitive/GRTransferFuncs.h"
 #include "clang/Checker/ManagerRegistry.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
 #include "llvm/Support/raw_ostream.h"
@@ -90,6 +91,16 @@ public:
 
   bool isEmpty() const { return ranges.isEmpty(); }
 
+  /// getMin, getMax - The smallest and the largest value in the set, which
+  ///  must not be empty.
+  const llvm::APSInt &getMin() const { return begin()->From(); }
+  const llvm::APSInt &getMax() const {
+    const Range *Last = 0;
+    for (iterator i = begin(), e = end(); i != e; ++i)
+      Last = &*i;
+    return Last->To();
+  }
+
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
     : ranges(F.Add(F.GetEmptySet(), Range(from, to))) {}
@@ -108,6 +119,10 @@ public:
   /// AddEQ - Create a new RangeSet with the additional constraint that the
   ///  value be equal to V.
   RangeSet AddEQ(BasicValueFactory &BV, Factory &F, const llvm::APSInt &V) {
+    // A symbol already known to equal 'V' keeps its set.
+    if (const llvm::APSInt *C = getConcreteValue())
+      return *C == V ? *this : RangeSet(F);
+
     // Search for a range that includes 'V'.  If so, return a new RangeSet
     // representing { [V, V] }.
     for (PrimRangeSet::iterator i = begin(), e = end(); i!=e; ++i)
@@ -144,6 +159,13 @@ public:
   /// AddNE - Create a new RangeSet with the additional constraint that the
   ///  value be less than V.
   RangeSet AddLT(BasicValueFactory &BV, Factory &F, const llvm::APSInt &V) {
+    // The common cases of a constraint that removes nothing or everything
+    // need no new set.
+    if (isEmpty() || getMax() < V)
+      return *this;
+    if (getMin() >= V)
+      return RangeSet(F);
+
     PrimRangeSet newRanges = F.GetEmptySet();
 
     for (iterator i = begin(), e = end() ; i != e ; ++i) {
@@ -157,6 +179,11 @@ public:
   }
 
   RangeSet AddLE(BasicValueFactory &BV, Factory &F, const llvm::APSInt &V) {
+    if (isEmpty() || getMax() <= V)
+      return *this;
+    if (getMin() > V)
+      return RangeSet(F);
+
     PrimRangeSet newRanges = F.GetEmptySet();
 
     for (iterator i = begin(), e = end(); i != e; ++i) {
@@ -172,6 +199,11 @@ public:
   }
 
   RangeSet AddGT(BasicValueFactory &BV, Factory &F, const llvm::APSInt &V) {
+    if (isEmpty() || getMin() > V)
+      return *this;
+    if (getMax() <= V)
+      return RangeSet(F);
+
     PrimRangeSet newRanges = F.GetEmptySet();
 
     for (PrimRangeSet::iterator i = begin(), e = end(); i != e; ++i) {
@@ -185,6 +217,11 @@ public:
   }
 
   RangeSet AddGE(BasicValueFactory &BV, Factory &F, const llvm::APSInt &V) {
+    if (isEmpty() || getMin() >= V)
+      return *this;
+    if (getMax() < V)
+      return RangeSet(F);
+
     PrimRangeSet newRanges = F.GetEmptySet();
 
     for (PrimRangeSet::iterator i = begin(), e = end(); i != e; ++i) {
@@ -233,6 +270,13 @@ struct GRStateTrait<ConstraintRange>
 namespace {
 class RangeConstraintManager : public SimpleConstraintManager{
   RangeSet GetRange(const GRState *state, SymbolRef sym);
+
+  enum AssumeKind {
+    AssumeEQ, AssumeNE, AssumeLT, AssumeGT, AssumeLE, AssumeGE
+  };
+
+  const GRState *AssumeRange(const GRState *state, SymbolRef sym,
+                             const llvm::APSInt &V, AssumeKind K);
 public:
   RangeConstraintManager(GRSubEngine &subengine)
     : SimpleConstraintManager(subengine) {}
@@ -270,6 +314,14 @@ public:
 
 private:
   RangeSet::Factory F;
+
+  /// AssumeCache - The results of the assumptions made so far.  States are
+  ///  uniqued and immutable, so an assumption about the same symbol and
+  ///  value in the same state always has the same result.  The value is
+  ///  the one uniqued by the BasicValueFactory.
+  typedef std::pair<std::pair<const GRState*, SymbolRef>,
+                    std::pair<const llvm::APSInt*, unsigned> > AssumeKey;
+  llvm::DenseMap<AssumeKey, const GRState*> AssumeCache;
 };
 
 } // end anonymous namespace
@@ -323,12 +375,46 @@ RangeConstraintManager::GetRange(const GRState *state, SymbolRef sym) {
 // AssumeSymX methods: public interface for RangeConstraintManager.
 //===------------------------------------------------------------------------===/
 
+const GRState *
+RangeConstraintManager::AssumeRange(const GRState *state, SymbolRef sym,
+                                    const llvm::APSInt &V, AssumeKind K) {
+  BasicValueFactory &BV = state->getBasicVals();
+  const llvm::APSInt &UniqueV = BV.getValue(V);
+  AssumeKey Key(std::make_pair(state, sym), std::make_pair(&UniqueV, K));
+  llvm::DenseMap<AssumeKey, const GRState*>::iterator I =
+    AssumeCache.find(Key);
+  if (I != AssumeCache.end())
+    return I->second;
+
+  RangeSet Old = GetRange(state, sym);
+  RangeSet R = Old;
+  switch (K) {
+  case AssumeEQ: R = Old.AddEQ(BV, F, UniqueV); break;
+  case AssumeNE: R = Old.AddNE(BV, F, UniqueV); break;
+  case AssumeLT: R = Old.AddLT(BV, F, UniqueV); break;
+  case AssumeGT: R = Old.AddGT(BV, F, UniqueV); break;
+  case AssumeLE: R = Old.AddLE(BV, F, UniqueV); break;
+  case AssumeGE: R = Old.AddGE(BV, F, UniqueV); break;
+  }
+
+  // An assumption that does not narrow the range leaves the state alone.
+  const GRState *Result;
+  if (R.isEmpty())
+    Result = NULL;
+  else if (R == Old)
+    Result = state;
+  else
+    Result = state->set<ConstraintRange>(sym, R);
+
+  AssumeCache[Key] = Result;
+  return Result;
+}
+
 #define AssumeX(OP)\
 const GRState*\
 RangeConstraintManager::AssumeSym ## OP(const GRState* state, SymbolRef sym,\
   const llvm::APSInt& V){\
-  const RangeSet& R = GetRange(state, sym).Add##OP(state->getBasicVals(), F, V);\
-  return !R.isEmpty() ? state->set<ConstraintRange>(sym, R) : NULL;\
+  return AssumeRange(state, sym, V, Assume ## OP);\
 }
 
 AssumeX(EQ)
@@ -1118,9 +1118,8 @@ SVal RegionStoreManager::RetrieveElement(Store store,
       return UnknownVal();
     
     const StringLiteral *Str = StrR->getStringLiteral();
-    SVal Idx = R->getIndex();
-    if (nonloc::ConcreteInt *CI = dyn_cast<nonloc::ConcreteInt>(&Idx)) {
-      int64_t i = CI->getValue().getSExtValue();
+    if (R->hasConstantIndex()) {
+      int64_t i = R->getConstantIndex();
       int64_t byteLength = Str->getByteLength();
       if (i > byteLength) {
         // Buffer overflow checking in GRExprEngine should handle this case,
@@ -1486,6 +1485,12 @@ Store RegionStoreManager::BindArray(Store store, const TypedRegion* R,
     // We assume that string constants are bound to
     // constant arrays.
     uint64_t size = Size.getValue();
+
+    // The trailing bytes, and the NUL bytes within the literal, are covered
+    // by a zero default value rather than a binding each.
+    bool ZeroDefault = len < size;
+    if (ZeroDefault)
+      store = setImplicitDefaultValue(store, R, ElementTy);
     
     for (uint64_t i = 0; i < size; ++i, ++j) {
       if (j >= len)
@@ -1495,6 +1500,10 @@ Store RegionStoreManager::BindArray(Store store, const TypedRegion* R,
       const ElementRegion* ER = MRMgr.getElementRegion(ElementTy, Idx, R,
                                                        getContext());
 
+      if (ZeroDefault && str[j] == '\0' &&
+          !Lookup(GetRegionBindings(store), ER, BindingKey::Direct))
+        continue;
+
       SVal V = ValMgr.makeIntVal(str[j], sizeof(char)*8, true);
       store = Bind(store, loc::MemRegionVal(ER), V);
     }
@@ -1515,6 +1524,22 @@ Store RegionStoreManager::BindArray(Store store, const TypedRegion* R,
   nonloc::CompoundVal::iterator VI = CV.begin(), VE = CV.end();
   uint64_t i = 0;
 
+  // If the init list is shorter than the array length, or sets scalar
+  // elements to zero, set the array default value.  The elements set to zero
+  // then need no bindings of their own, which keeps large zero-filled
+  // buffers down to a handful of bindings.
+  bool ZeroDefault = false;
+  if (Size.hasValue()) {
+    uint64_t NumInits = 0;
+    for (nonloc::CompoundVal::iterator I = VI; I != VE; ++I, ++NumInits)
+      if (I->isZeroConstant())
+        ZeroDefault = true;
+    if (NumInits < Size.getValue())
+      ZeroDefault = true;
+  }
+  if (ZeroDefault)
+    store = setImplicitDefaultValue(store, R, ElementTy);
+
   for (; Size.hasValue() ? i < Size.getValue() : true ; ++i, ++VI) {
     // The init list might be shorter than the array length.
     if (VI == VE)
@@ -1525,15 +1550,11 @@ Store RegionStoreManager::BindArray(Store store, const TypedRegion* R,
 
     if (ElementTy->isStructureType())
       store = BindStruct(store, ER, *VI);
-    else
+    else if (!ZeroDefault || !VI->isZeroConstant() ||
+             Lookup(GetRegionBindings(store), ER, BindingKey::Direct))
       store = Bind(store, ValMgr.makeLoc(ER), *VI);
   }
 
-  // If the init list is shorter than the array length, set the
-  // array default value.
-  if (Size.hasValue() && i < Size.getValue())
-    store = setImplicitDefaultValue(store, R, ElementTy);
-
   return store;
 }
 
@@ -1566,6 +1587,24 @@ Store RegionStoreManager::BindStruct(Store store, const TypedRegion* R,
 
   RecordDecl::field_iterator FI, FE;
 
+  // There may be fewer values in the initialize list than the fields of
+  // struct, or some of them may be zero.  Either way the struct gets a zero
+  // default value, and the scalar fields set to zero are left to it.
+  bool ZeroDefault = false;
+  unsigned NumInits = 0, NumFields = 0;
+  for (nonloc::CompoundVal::iterator I = VI; I != VE; ++I, ++NumInits)
+    if (I->isZeroConstant())
+      ZeroDefault = true;
+  for (FI = RD->field_begin(), FE = RD->field_end(); FI != FE; ++FI)
+    ++NumFields;
+  if (NumInits < NumFields)
+    ZeroDefault = true;
+  if (ZeroDefault) {
+    RegionBindings B = GetRegionBindings(store);
+    B = Add(B, R, BindingKey::Default, ValMgr.makeIntVal(0, false));
+    store = B.getRoot();
+  }
+
   for (FI = RD->field_begin(), FE = RD->field_end(); FI != FE; ++FI, ++VI) {
 
     if (VI == VE)
@@ -1578,17 +1617,11 @@ Store RegionStoreManager::BindStruct(Store store, const TypedRegion* R,
       store = BindArray(store, FR, *VI);
     else if (FTy->isStructureType())
       store = BindStruct(store, FR, *VI);
-    else
+    else if (!ZeroDefault || !VI->isZeroConstant() ||
+             Lookup(GetRegionBindings(store), FR, BindingKey::Direct))
       store = Bind(store, ValMgr.makeLoc(FR), *VI);
   }
 
-  // There may be fewer values in the initialize list than the fields of struct.
-  if (FI != FE) {
-    RegionBindings B = GetRegionBindings(store);
-    B = Add(B, R, BindingKey::Default, ValMgr.makeIntVal(0, false));
-    store = B.getRoot();
-  }
-
   return store;
 }
 
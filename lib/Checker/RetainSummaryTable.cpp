@@ -0,0 +1,209 @@
+//===--- RetainSummaryTable.cpp - Persistent retain/release summaries -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements RetainSummaryTable.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Checker/DomainSpecific/RetainSummaryTable.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <cstring>
+using namespace clang;
+using namespace clang::io;
+
+//===----------------------------------------------------------------------===//
+// On-disk format.
+//===----------------------------------------------------------------------===//
+//
+// A table file is laid out as follows:
+//
+//   "cfe-rsum" <version:32> <hash table payload> <hash table buckets>
+//   <bucket table offset:32>
+//
+// Each entry has a key of up to 64K bytes and data of up to 255 bytes.
+
+namespace {
+class RetainSummaryLookupTrait {
+public:
+  typedef llvm::StringRef external_key_type;
+  typedef llvm::StringRef internal_key_type;
+  typedef llvm::StringRef data_type;
+
+  static unsigned ComputeHash(internal_key_type K) {
+    return llvm::HashString(K);
+  }
+
+  static internal_key_type GetInternalKey(external_key_type K) { return K; }
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = *d++;
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    return llvm::StringRef((const char*) d, n);
+  }
+
+  static data_type ReadData(internal_key_type, const unsigned char *d,
+                            unsigned n) {
+    return llvm::StringRef((const char*) d, n);
+  }
+};
+
+class RetainSummaryWriterTrait {
+public:
+  typedef llvm::StringRef key_type;
+  typedef llvm::StringRef key_type_ref;
+  typedef llvm::StringRef data_type;
+  typedef llvm::StringRef data_type_ref;
+
+  static unsigned ComputeHash(key_type_ref K) {
+    return llvm::HashString(K);
+  }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(llvm::raw_ostream &Out, key_type_ref K, data_type_ref D) {
+    Emit16(Out, K.size());
+    Emit8(Out, D.size());
+    return std::make_pair(K.size(), D.size());
+  }
+
+  static void EmitKey(llvm::raw_ostream &Out, key_type_ref K, unsigned) {
+    Out.write(K.data(), K.size());
+  }
+
+  static void EmitData(llvm::raw_ostream &Out, key_type_ref, data_type_ref D,
+                       unsigned) {
+    Out.write(D.data(), D.size());
+  }
+};
+} // end anonymous namespace
+
+typedef OnDiskChainedHashTable<RetainSummaryLookupTrait> SummaryTable;
+
+static const char Magic[] = "cfe-rsum";
+
+RetainSummaryTable::RetainSummaryTable(llvm::StringRef path)
+  : Path(path), Table(0) {
+  // Large files are memory mapped, so all of the analyses using the same
+  // table share its pages.
+  llvm::OwningPtr<llvm::MemoryBuffer>
+    File(llvm::MemoryBuffer::getFile(Path.c_str()));
+  if (!File)
+    return;
+
+  const unsigned char *BufBeg = (const unsigned char*) File->getBufferStart();
+  const unsigned char *BufEnd = (const unsigned char*) File->getBufferEnd();
+  const unsigned MagicLen = sizeof(Magic) - 1;
+
+  if (BufEnd - BufBeg < (signed) (MagicLen + 4 + 8 + 4) ||
+      memcmp(BufBeg, Magic, MagicLen) != 0)
+    return;
+
+  const unsigned char *p = BufBeg + MagicLen;
+  if (ReadUnalignedLE32(p) != Version)
+    return;
+
+  const unsigned char *Trailer = BufEnd - 4;
+  const unsigned char *Buckets = BufBeg + ReadUnalignedLE32(Trailer);
+  if (Buckets < p || Buckets + 8 > BufEnd - 4 ||
+      ((uintptr_t) Buckets & 0x3) != 0)
+    return;
+
+  Table = SummaryTable::Create(Buckets, BufBeg);
+  Buf.reset(File.take());
+}
+
+RetainSummaryTable::~RetainSummaryTable() {
+  delete (SummaryTable*) Table;
+}
+
+bool RetainSummaryTable::lookup(llvm::StringRef Key,
+                                llvm::StringRef &Data) const {
+  llvm::StringMap<std::string>::const_iterator A = Added.find(Key);
+  if (A != Added.end()) {
+    Data = A->getValue();
+    return true;
+  }
+
+  if (!Table)
+    return false;
+
+  SummaryTable &T = *(SummaryTable*) Table;
+  SummaryTable::iterator I = T.find(Key);
+  if (I == T.end())
+    return false;
+
+  Data = *I;
+  return true;
+}
+
+void RetainSummaryTable::add(llvm::StringRef Key, llvm::StringRef Data) {
+  if (Key.size() > 0xFFFF || Data.size() > 0xFF)
+    return;
+  Added[Key] = Data;
+}
+
+void RetainSummaryTable::write() {
+  if (Added.empty())
+    return;
+
+  OnDiskChainedHashTableGenerator<RetainSummaryWriterTrait> Generator;
+  for (llvm::StringMap<std::string>::iterator I = Added.begin(),
+         E = Added.end(); I != E; ++I)
+    Generator.insert(I->getKey(), I->getValue());
+
+  // Carry over the entries of the loaded table, which stays mapped until the
+  // new one is written.
+  if (Table) {
+    SummaryTable &T = *(SummaryTable*) Table;
+    const unsigned char *Bucket = T.getBuckets();
+    for (unsigned B = 0, NB = T.getNumBuckets(); B != NB; ++B) {
+      unsigned Offset = ReadLE32(Bucket);
+      if (Offset == 0)
+        continue;
+
+      const unsigned char *Items = T.getBase() + Offset;
+      unsigned Len = ReadUnalignedLE16(Items);
+      for (unsigned I = 0; I != Len; ++I) {
+        Items += 4; // Skip the hash.
+        std::pair<unsigned, unsigned> L =
+          RetainSummaryLookupTrait::ReadKeyDataLength(Items);
+        llvm::StringRef Key((const char*) Items, L.first);
+        llvm::StringRef Data((const char*) Items + L.first, L.second);
+        if (!Added.count(Key))
+          Generator.insert(Key, Data);
+        Items += L.first + L.second;
+      }
+    }
+  }
+
+  AtomicOutputFile File(Path);
+  std::string ErrMsg;
+  if (File.open(ErrMsg))
+    return;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << Magic;
+  Emit32(Out, Version);
+  Offset TableOff = Generator.Emit(Out);
+  Emit32(Out, TableOff);
+  File.commit(ErrMsg);
+}
@@ -11,6 +11,7 @@
 #define CLANG_CODEGEN_ABIINFO_H
 
 #include "clang/AST/Type.h"
+#include "llvm/ADT/DenseMap.h"
 
 #include <cassert>
 
@@ -128,6 +129,43 @@ namespace clang {
     void dump() const;
   };
 
+  /// ABIArgInfoCache - The classifications computed so far by a target, keyed
+  /// by type.  Calls keep passing and returning the same small records, and
+  /// classifying one walks all of its fields.
+  class ABIArgInfoCache {
+    llvm::DenseMap<const Type *, ABIArgInfo> Infos;
+
+  public:
+    /// getKey - Return the key of \arg Ty: its canonical type, as qualifiers
+    /// do not change how a value is passed.  Returns null if \arg Ty is
+    /// incomplete, as it is classified differently once completed.
+    static const Type *getKey(QualType Ty) {
+      if (Ty->isIncompleteType())
+        return 0;
+      return Ty->getCanonicalTypeInternal().getTypePtr();
+    }
+
+    /// lookup - Set \arg Info to the classification recorded for \arg Ty
+    /// and return true, or return false if there is none.
+    bool lookup(QualType Ty, ABIArgInfo &Info) const {
+      const Type *Key = getKey(Ty);
+      if (!Key)
+        return false;
+      llvm::DenseMap<const Type *, ABIArgInfo>::const_iterator
+        it = Infos.find(Key);
+      if (it == Infos.end())
+        return false;
+      Info = it->second;
+      return true;
+    }
+
+    /// insert - Record \arg Info as the classification of \arg Ty.
+    void insert(QualType Ty, const ABIArgInfo &Info) {
+      if (const Type *Key = getKey(Ty))
+        Infos[Key] = Info;
+    }
+  };
+
   /// ABIInfo - Target specific hooks for defining how a type should be
   /// passed or returned from functions.
   class ABIInfo {
@@ -59,11 +59,15 @@ CodeGenModule::GetAddrOfCXXConstructor(const CXXConstructorDecl *D,
 
 const char *CodeGenModule::getMangledCXXCtorName(const CXXConstructorDecl *D,
                                                  CXXCtorType Type) {
+  const char *&Str = MangledDeclNames[GlobalDecl(D, Type)];
+  if (Str)
+    return Str;
+
   llvm::SmallString<256> Name;
   getMangleContext().mangleCXXCtor(D, Type, Name);
 
   Name += '\0';
-  return UniqueMangledName(Name.begin(), Name.end());
+  return Str = UniqueMangledName(Name.begin(), Name.end());
 }
 
 void CodeGenModule::EmitCXXDestructors(const CXXDestructorDecl *D) {
@@ -96,11 +100,15 @@ CodeGenModule::GetAddrOfCXXDestructor(const CXXDestructorDecl *D,
 
 const char *CodeGenModule::getMangledCXXDtorName(const CXXDestructorDecl *D,
                                                  CXXDtorType Type) {
+  const char *&Str = MangledDeclNames[GlobalDecl(D, Type)];
+  if (Str)
+    return Str;
+
   llvm::SmallString<256> Name;
   getMangleContext().mangleCXXDtor(D, Type, Name);
 
   Name += '\0';
-  return UniqueMangledName(Name.begin(), Name.end());
+  return Str = UniqueMangledName(Name.begin(), Name.end());
 }
 
 llvm::Constant *
@@ -221,15 +221,28 @@ const CGFunctionInfo &CodeGenTypes::getFunctionInfo(QualType ResTy,
     return *FI;
 
   // Construct the function info.
-  FI = new CGFunctionInfo(CC, NoReturn, ResTy, ArgTys);
+  FI = CGFunctionInfo::Create(FunctionInfoAllocator, CC, NoReturn, ResTy,
+                              ArgTys);
   FunctionInfos.InsertNode(FI, InsertPos);
 
-  // Compute ABI information.
+  // Compute ABI information, once for each unique signature.
   getABIInfo().computeInfo(*FI, getContext(), TheModule.getContext());
 
   return *FI;
 }
 
+CGFunctionInfo *
+CGFunctionInfo::Create(llvm::BumpPtrAllocator &Allocator,
+                       unsigned CallingConvention,
+                       bool NoReturn,
+                       QualType ResTy,
+                       const llvm::SmallVector<QualType, 16> &ArgTys) {
+  void *Mem = Allocator.Allocate(sizeof(CGFunctionInfo) +
+                                   (1 + ArgTys.size()) * sizeof(ArgInfo),
+                                 llvm::AlignOf<CGFunctionInfo>::Alignment);
+  return new (Mem) CGFunctionInfo(CallingConvention, NoReturn, ResTy, ArgTys);
+}
+
 CGFunctionInfo::CGFunctionInfo(unsigned _CallingConvention,
                                bool _NoReturn,
                                QualType ResTy,
@@ -239,10 +252,13 @@ CGFunctionInfo::CGFunctionInfo(unsigned _CallingConvention,
     NoReturn(_NoReturn)
 {
   NumArgs = ArgTys.size();
-  Args = new ArgInfo[1 + NumArgs];
+  ArgInfo *Args = getArgs();
+  new (&Args[0]) ArgInfo();
   Args[0].type = ResTy;
-  for (unsigned i = 0; i < NumArgs; ++i)
+  for (unsigned i = 0; i < NumArgs; ++i) {
+    new (&Args[1 + i]) ArgInfo();
     Args[1 + i].type = ArgTys[i];
+  }
 }
 
 /***/
@@ -525,6 +541,13 @@ void CodeGenModule::ConstructAttributeList(const CGFunctionInfo &FI,
   if (TargetDecl) {
     if (TargetDecl->hasAttr<NoThrowAttr>())
       FuncAttrs |= llvm::Attribute::NoUnwind;
+    // Neither can a function declared throw(), so calls to it need no
+    // landing pad.
+    if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(TargetDecl))
+      if (const FunctionProtoType *FPT =
+            FD->getType()->getAs<FunctionProtoType>())
+        if (FPT->hasEmptyExceptionSpec())
+          FuncAttrs |= llvm::Attribute::NoUnwind;
     if (TargetDecl->hasAttr<NoReturnAttr>())
       FuncAttrs |= llvm::Attribute::NoReturn;
     if (TargetDecl->hasAttr<ConstAttr>())
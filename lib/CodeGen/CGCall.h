@@ -16,6 +16,7 @@
 #define CLANG_CODEGEN_CGCALL_H
 
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Value.h"
 #include "clang/AST/Type.h"
 
@@ -54,7 +55,8 @@ namespace CodeGen {
                             16> FunctionArgList;
 
   /// CGFunctionInfo - Class to encapsulate the information about a
-  /// function definition.
+  /// function definition.  The information about the return value and the
+  /// arguments is allocated right after the object.
   class CGFunctionInfo : public llvm::FoldingSetNode {
     struct ArgInfo {
       QualType type;
@@ -73,22 +75,33 @@ namespace CodeGen {
     bool NoReturn;
 
     unsigned NumArgs;
-    ArgInfo *Args;
 
-  public:
-    typedef const ArgInfo *const_arg_iterator;
-    typedef ArgInfo *arg_iterator;
+    ArgInfo *getArgs() { return reinterpret_cast<ArgInfo *>(this + 1); }
+    const ArgInfo *getArgs() const {
+      return reinterpret_cast<const ArgInfo *>(this + 1);
+    }
 
     CGFunctionInfo(unsigned CallingConvention,
                    bool NoReturn,
                    QualType ResTy,
                    const llvm::SmallVector<QualType, 16> &ArgTys);
-    ~CGFunctionInfo() { delete[] Args; }
 
-    const_arg_iterator arg_begin() const { return Args + 1; }
-    const_arg_iterator arg_end() const { return Args + 1 + NumArgs; }
-    arg_iterator arg_begin() { return Args + 1; }
-    arg_iterator arg_end() { return Args + 1 + NumArgs; }
+  public:
+    typedef const ArgInfo *const_arg_iterator;
+    typedef ArgInfo *arg_iterator;
+
+    /// Create - Allocate the function info in \arg Allocator, which owns it
+    /// from then on; it is never destroyed.
+    static CGFunctionInfo *Create(llvm::BumpPtrAllocator &Allocator,
+                                  unsigned CallingConvention,
+                                  bool NoReturn,
+                                  QualType ResTy,
+                               const llvm::SmallVector<QualType, 16> &ArgTys);
+
+    const_arg_iterator arg_begin() const { return getArgs() + 1; }
+    const_arg_iterator arg_end() const { return getArgs() + 1 + NumArgs; }
+    arg_iterator arg_begin() { return getArgs() + 1; }
+    arg_iterator arg_end() { return getArgs() + 1 + NumArgs; }
 
     unsigned  arg_size() const { return NumArgs; }
 
@@ -107,10 +120,10 @@ namespace CodeGen {
       EffectiveCallingConvention = Value;
     }
 
-    QualType getReturnType() const { return Args[0].type; }
+    QualType getReturnType() const { return getArgs()[0].type; }
 
-    ABIArgInfo &getReturnInfo() { return Args[0].info; }
-    const ABIArgInfo &getReturnInfo() const { return Args[0].info; }
+    ABIArgInfo &getReturnInfo() { return getArgs()[0].info; }
+    const ABIArgInfo &getReturnInfo() const { return getArgs()[0].info; }
 
     void Profile(llvm::FoldingSetNodeID &ID) {
       ID.AddInteger(getCallingConvention());
@@ -650,6 +650,12 @@ CollectCXXMemberFunctions(const CXXRecordDecl *RD, llvm::DICompileUnit Unit,
     if (Method->isImplicit() && !Method->isUsed())
       continue;
 
+    // With -flimit-debug-info, the methods neither used, defined here nor
+    // virtual are left out, along with the types only they refer to.
+    if (CGM.getCodeGenOpts().LimitDebugInfo && !Method->isUsed() &&
+        !Method->isVirtual() && !Method->getBody())
+      continue;
+
     EltTys.push_back(CreateCXXMemberFunction(Method, Unit, RecordTy));
   }
 }                                 
@@ -809,6 +815,15 @@ llvm::DIType CGDebugInfo::CreateType(const RecordType *Ty,
   if (!RD->getDefinition())
     return FwdDecl;
 
+  // So is a class described by the translation unit emitting its vtable.
+  if (const CXXRecordDecl *CXXRD =
+        dyn_cast<CXXRecordDecl>(RD->getDefinition())) {
+    if (isDescribedElsewhere(CXXRD)) {
+      DeclaredClasses[CXXRD->getCanonicalDecl()] = FwdDecl.getNode();
+      return FwdDecl;
+    }
+  }
+
   llvm::TrackingVH<llvm::MDNode> FwdDeclNode = FwdDecl.getNode();
   // Otherwise, insert it into the TypeCache so that recursive uses will find
   // it.
@@ -859,6 +874,36 @@ llvm::DIType CGDebugInfo::CreateType(const RecordType *Ty,
   return RealDecl;
 }
 
+bool CGDebugInfo::isDescribedElsewhere(const CXXRecordDecl *RD) {
+  if (!CGM.getCodeGenOpts().LimitDebugInfo || !RD->isDynamicClass())
+    return false;
+
+  const CXXMethodDecl *KeyFunction = CGM.getContext().getKeyFunction(RD);
+  return KeyFunction && !KeyFunction->getBody();
+}
+
+void CGDebugInfo::CompleteDeclaredClass(const CXXMethodDecl *MD) {
+  if (DeclaredClasses.empty())
+    return;
+
+  const CXXRecordDecl *RD = MD->getParent();
+  llvm::DenseMap<const CXXRecordDecl *, llvm::WeakVH>::iterator
+    it = DeclaredClasses.find(RD->getCanonicalDecl());
+  if (it == DeclaredClasses.end() || isDescribedElsewhere(RD))
+    return;
+
+  llvm::WeakVH FwdDecl = it->second;
+  DeclaredClasses.erase(it);
+  if (!&*FwdDecl)
+    return;
+
+  QualType Ty(RD->getTypeForDecl(), 0);
+  llvm::DIType RealDecl =
+    CreateTypeNode(Ty, getOrCreateCompileUnit(RD->getLocation()));
+  TypeCache[Ty.getAsOpaquePtr()] = RealDecl.getNode();
+  llvm::DIDerivedType(cast<llvm::MDNode>(FwdDecl)).replaceAllUsesWith(RealDecl);
+}
+
 /// CreateType - get objective-c interface type.
 llvm::DIType CGDebugInfo::CreateType(const ObjCInterfaceType *Ty,
                                      llvm::DICompileUnit Unit) {
@@ -1178,7 +1223,7 @@ llvm::DIType CGDebugInfo::getOrCreateType(QualType Ty,
   Ty = UnwrapTypeForDebugInfo(Ty);
   
   // Check for existing entry.
-  std::map<void *, llvm::WeakVH>::iterator it =
+  llvm::DenseMap<void *, llvm::WeakVH>::iterator it =
     TypeCache.find(Ty.getAsOpaquePtr());
   if (it != TypeCache.end()) {
     // Verify that the debug info still exists.
@@ -1279,6 +1324,9 @@ void CGDebugInfo::EmitFunctionStart(GlobalDecl GD, QualType FnType,
 
   const Decl *D = GD.getDecl();
   if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(FD))
+      CompleteDeclaredClass(MD);
+
     // If there is a DISubprogram for  this function available then use it.
     llvm::DenseMap<const FunctionDecl *, llvm::WeakVH>::iterator
       FI = SPCache.find(FD);
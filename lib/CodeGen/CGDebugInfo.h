@@ -21,7 +21,6 @@
 #include "llvm/Analysis/DebugInfo.h"
 #include "llvm/Support/ValueHandle.h"
 #include "llvm/Support/Allocator.h"
-#include <map>
 
 #include "CGBuilder.h"
 
@@ -54,8 +53,12 @@ class CGDebugInfo {
   llvm::DenseMap<unsigned, llvm::DICompileUnit> CompileUnitCache;
 
   /// TypeCache - Cache of previously constructed Types.
-  // FIXME: Eliminate this map.  Be careful of iterator invalidation.
-  std::map<void *, llvm::WeakVH> TypeCache;
+  llvm::DenseMap<void *, llvm::WeakVH> TypeCache;
+
+  /// DeclaredClasses - With -flimit-debug-info, the classes only described
+  /// by a forward declaration so far, because the translation unit emitting
+  /// their vtable describes them in full.
+  llvm::DenseMap<const CXXRecordDecl *, llvm::WeakVH> DeclaredClasses;
 
   bool BlockLiteralGenericSet;
   llvm::DIType BlockLiteralGeneric;
@@ -118,6 +121,16 @@ class CGDebugInfo {
                          llvm::DICompileUnit Unit,
                          llvm::SmallVectorImpl<llvm::DIDescriptor> &EltTys);
 
+  /// isDescribedElsewhere - Return true if, with -flimit-debug-info, the class
+  /// is only declared in this translation unit: its key function, and so its
+  /// vtable, is defined in another one, which describes the class in full.
+  bool isDescribedElsewhere(const CXXRecordDecl *RD);
+
+  /// CompleteDeclaredClass - Replace the forward declaration of the class of
+  /// \arg MD by its full description once this translation unit turns out to
+  /// define its key function.
+  void CompleteDeclaredClass(const CXXMethodDecl *MD);
+
 public:
   CGDebugInfo(CodeGenModule &CGM);
   ~CGDebugInfo();
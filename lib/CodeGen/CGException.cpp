@@ -673,6 +673,19 @@ void CodeGenFunction::EmitCXXTryStmt(const CXXTryStmt &S) {
   EmitBlock(FinallyEnd);
 }
 
+CodeGenFunction::EHCleanupBlock::EHCleanupBlock(CodeGenFunction &cgf)
+  : CGF(cgf), Cont(CGF.createBasicBlock("cont")),
+    CleanupHandler(CGF.createBasicBlock("ehcleanup")),
+    CleanupEntryBB(CGF.createBasicBlock("ehcleanup.rest")),
+    PreviousInvokeDest(CGF.getInvokeDest()) {
+  CGF.EmitBranch(Cont);
+  llvm::BasicBlock *TerminateHandler = CGF.getTerminateHandler();
+  // Every block emitted from here on belongs to the cleanup.
+  LastBlockBefore = &CGF.CurFn->back();
+  CGF.Builder.SetInsertPoint(CleanupEntryBB);
+  CGF.setInvokeDest(TerminateHandler);
+}
+
 CodeGenFunction::EHCleanupBlock::~EHCleanupBlock() {
   llvm::BasicBlock *Cont1 = CGF.createBasicBlock("cont");
   CGF.EmitBranch(Cont1);
@@ -706,25 +719,77 @@ CodeGenFunction::EHCleanupBlock::~EHCleanupBlock() {
   Args.push_back(Null);
   CGF.Builder.CreateCall(llvm_eh_selector, Args.begin(), Args.end());
 
+  // The exception goes through a slot shared by all the EH cleanups, so that
+  // the enclosing ones can pick it up.
+  if (!CGF.EHCleanupExnSlot)
+    CGF.EHCleanupExnSlot = CGF.CreateTempAlloca(PtrToInt8Ty, "cleanup.exn");
+  CGF.Builder.CreateStore(Exc, CGF.EHCleanupExnSlot);
+
   CGF.EmitBlock(CleanupEntryBB);
 
   CGF.EmitBlock(Cont1);
 
-  if (CGF.getInvokeDest()) {
-    llvm::BasicBlock *Cont = CGF.createBasicBlock("invoke.cont");
-    CGF.Builder.CreateInvoke(getUnwindResumeOrRethrowFn(CGF), Cont,
-                             CGF.getInvokeDest(), Exc);
-    CGF.EmitBlock(Cont);
-  } else
-    CGF.Builder.CreateCall(getUnwindResumeOrRethrowFn(CGF), Exc);
+  // If the exception would unwind into the landing pad of an enclosing EH
+  // cleanup, branch straight to that cleanup instead of rethrowing it only to
+  // catch it again.  All the nested cleanups then share one rethrow.
+  llvm::DenseMap<llvm::BasicBlock *, llvm::BasicBlock *>::iterator
+    Enclosing = CGF.EHCleanupEntries.find(CGF.getInvokeDest());
+  if (Enclosing != CGF.EHCleanupEntries.end()) {
+    CGF.Builder.CreateBr(Enclosing->second);
+  } else {
+    Exc = CGF.Builder.CreateLoad(CGF.EHCleanupExnSlot, "exc");
+    if (CGF.getInvokeDest()) {
+      llvm::BasicBlock *Cont = CGF.createBasicBlock("invoke.cont");
+      CGF.Builder.CreateInvoke(getUnwindResumeOrRethrowFn(CGF), Cont,
+                               CGF.getInvokeDest(), Exc);
+      CGF.EmitBlock(Cont);
+    } else
+      CGF.Builder.CreateCall(getUnwindResumeOrRethrowFn(CGF), Exc);
+
+    CGF.Builder.CreateUnreachable();
+  }
+  CGF.Builder.ClearInsertionPoint();
 
-  CGF.Builder.CreateUnreachable();
+  EHCleanupInfo Info(CleanupHandler, CleanupEntryBB);
+  llvm::Function::iterator BB = LastBlockBefore, E = CGF.CurFn->end();
+  for (++BB; BB != E; ++BB)
+    Info.Blocks.push_back(BB);
+  CGF.EHCleanups.push_back(Info);
+  CGF.EHCleanupEntries[CleanupHandler] = CleanupEntryBB;
 
   CGF.EmitBlock(Cont);
   if (CGF.Exceptions)
     CGF.setInvokeDest(CleanupHandler);
 }
 
+/// EraseUnusedEHCleanups - The code of an EH cleanup is emitted before the
+/// scope it protects, so whether any call in the scope can unwind is only
+/// known once the function is done.  Erase the cleanups whose landing pad
+/// ended up unused, innermost first, as the landing pads of inner cleanups
+/// branch into the enclosing ones, and then the terminate handler if nothing
+/// is left to use it.
+void CodeGenFunction::EraseUnusedEHCleanups() {
+  for (unsigned I = EHCleanups.size(); I != 0; --I) {
+    EHCleanupInfo &Info = EHCleanups[I - 1];
+    if (!Info.Handler->use_empty() ||
+        Info.Entry->getSinglePredecessor() != Info.Handler)
+      continue;
+
+    for (unsigned J = 0, N = Info.Blocks.size(); J != N; ++J)
+      Info.Blocks[J]->dropAllReferences();
+    for (unsigned J = 0, N = Info.Blocks.size(); J != N; ++J)
+      Info.Blocks[J]->eraseFromParent();
+  }
+
+  EHCleanups.clear();
+  EHCleanupEntries.clear();
+
+  if (TerminateHandler && TerminateHandler->use_empty()) {
+    TerminateHandler->eraseFromParent();
+    TerminateHandler = 0;
+  }
+}
+
 llvm::BasicBlock *CodeGenFunction::getTerminateHandler() {
   if (TerminateHandler)
     return TerminateHandler;
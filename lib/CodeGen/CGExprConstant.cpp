@@ -585,6 +585,51 @@ public:
     return Visit(DAE->getExpr());
   }
 
+  /// EmitIntegerLiteralElement - Emit the array element \arg E of the LLVM
+  /// type \arg ElemTy without going through the constant evaluator, if it is
+  /// an integer or character literal, possibly negated and converted to an
+  /// integer type.  This is what large tables are mostly made of.  Returns
+  /// null for any other element.
+  llvm::Constant *EmitIntegerLiteralElement(Expr *E,
+                                            const llvm::Type *ElemTy) {
+    const llvm::IntegerType *ITy = dyn_cast<llvm::IntegerType>(ElemTy);
+    QualType DestType = E->getType();
+    if (!ITy || !DestType->isIntegerType() || DestType->isBooleanType())
+      return 0;
+
+    E = E->IgnoreParenImpCasts();
+    bool Negate = false;
+    if (UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+      if (UO->getOpcode() != UnaryOperator::Minus)
+        return 0;
+      Negate = true;
+      E = UO->getSubExpr()->IgnoreParens();
+    }
+
+    ASTContext &Context = CGM.getContext();
+    llvm::APSInt Value;
+    if (IntegerLiteral *IL = dyn_cast<IntegerLiteral>(E))
+      Value = llvm::APSInt(IL->getValue(),
+                           IL->getType()->isUnsignedIntegerType());
+    else if (CharacterLiteral *CL = dyn_cast<CharacterLiteral>(E))
+      Value = Context.MakeIntValue(CL->getValue(), CL->getType());
+    else
+      return 0;
+
+    // The negation happens in the type of the literal, since nothing was
+    // skipped between the two.
+    if (Negate)
+      Value = llvm::APSInt(llvm::APInt(Value.getBitWidth(), 0) - Value,
+                           Value.isUnsigned());
+
+    llvm::APInt Result(Value);
+    if (Value.isUnsigned())
+      Result = Result.zextOrTrunc(ITy->getBitWidth());
+    else
+      Result = Result.sextOrTrunc(ITy->getBitWidth());
+    return llvm::ConstantInt::get(VMContext, Result);
+  }
+
   llvm::Constant *EmitArrayInitialization(InitListExpr *ILE) {
     std::vector<llvm::Constant*> Elts;
     const llvm::ArrayType *AType =
@@ -605,11 +650,14 @@ public:
     unsigned NumInitableElts = std::min(NumInitElements, NumElements);
 
     // Copy initializer elements.
+    Elts.reserve(NumElements);
     unsigned i = 0;
     bool RewriteType = false;
     for (; i < NumInitableElts; ++i) {
       Expr *Init = ILE->getInit(i);
-      llvm::Constant *C = CGM.EmitConstantExpr(Init, Init->getType(), CGF);
+      llvm::Constant *C = EmitIntegerLiteralElement(Init, ElemTy);
+      if (!C)
+        C = CGM.EmitConstantExpr(Init, Init->getType(), CGF);
       if (!C)
         return 0;
       RewriteType |= (C->getType() != ElemTy);
@@ -652,3 +652,12 @@ void CodeGenFunction::EmitObjCAtSynchronizedStmt(
 }
 
 CGObjCRuntime::~CGObjCRuntime() {}
+
+const std::string &
+CGObjCRuntime::GetMethodEncoding(CodeGen::CodeGenModule &CGM,
+                                 const ObjCMethodDecl *MD) {
+  std::string &TypeStr = MethodEncodings[MD];
+  if (TypeStr.empty())
+    CGM.getContext().getObjCEncodingForMethodDecl(MD, TypeStr);
+  return TypeStr;
+}
@@ -354,23 +354,17 @@ llvm::Value *CGObjCGNU::GetSelector(CGBuilderTy &Builder, const ObjCMethodDecl
     *Method) {
 
   std::string SelName = Method->getSelector().getAsString();
-  std::string SelTypes;
-  CGM.getContext().getObjCEncodingForMethodDecl(Method, SelTypes);
   // Typed selectors
   TypedSelector Selector = TypedSelector(SelName,
-          SelTypes);
+          GetMethodEncoding(CGM, Method));
 
-  // If it's already cached, return it.
-  if (TypedSelectors[Selector]) {
-    return Builder.CreateLoad(TypedSelectors[Selector]);
-  }
-
-  // If it isn't, cache it.
-  llvm::GlobalAlias *Sel = new llvm::GlobalAlias(
+  // If it isn't already cached, cache it.
+  llvm::GlobalAlias *&Sel = TypedSelectors[Selector];
+  if (!Sel)
+    Sel = new llvm::GlobalAlias(
           llvm::PointerType::getUnqual(SelectorTy),
           llvm::GlobalValue::PrivateLinkage, ".objc_selector_alias" + SelName,
           NULL, &TheModule);
-  TypedSelectors[Selector] = Sel;
 
   return Builder.CreateLoad(Sel);
 }
@@ -908,7 +902,6 @@ llvm::Constant *CGObjCGNU::GenerateEmptyProtocol(
 }
 
 void CGObjCGNU::GenerateProtocol(const ObjCProtocolDecl *PD) {
-  ASTContext &Context = CGM.getContext();
   std::string ProtocolName = PD->getNameAsString();
   llvm::SmallVector<std::string, 16> Protocols;
   for (ObjCProtocolDecl::protocol_iterator PI = PD->protocol_begin(),
@@ -920,8 +913,7 @@ void CGObjCGNU::GenerateProtocol(const ObjCProtocolDecl *PD) {
   llvm::SmallVector<llvm::Constant*, 16> OptionalInstanceMethodTypes;
   for (ObjCProtocolDecl::instmeth_iterator iter = PD->instmeth_begin(),
        E = PD->instmeth_end(); iter != E; iter++) {
-    std::string TypeStr;
-    Context.getObjCEncodingForMethodDecl(*iter, TypeStr);
+    const std::string &TypeStr = GetMethodEncoding(CGM, *iter);
     if ((*iter)->getImplementationControl() == ObjCMethodDecl::Optional) {
       InstanceMethodNames.push_back(
           MakeConstantString((*iter)->getSelector().getAsString()));
@@ -940,8 +932,7 @@ void CGObjCGNU::GenerateProtocol(const ObjCProtocolDecl *PD) {
   for (ObjCProtocolDecl::classmeth_iterator
          iter = PD->classmeth_begin(), endIter = PD->classmeth_end();
        iter != endIter ; iter++) {
-    std::string TypeStr;
-    Context.getObjCEncodingForMethodDecl((*iter),TypeStr);
+    const std::string &TypeStr = GetMethodEncoding(CGM, *iter);
     if ((*iter)->getImplementationControl() == ObjCMethodDecl::Optional) {
       ClassMethodNames.push_back(
           MakeConstantString((*iter)->getSelector().getAsString()));
@@ -989,8 +980,7 @@ void CGObjCGNU::GenerateProtocol(const ObjCProtocolDecl *PD) {
                 property->getPropertyAttributes()));
     Fields.push_back(llvm::ConstantInt::get(Int8Ty, 0));
     if (ObjCMethodDecl *getter = property->getGetterMethodDecl()) {
-      std::string TypeStr;
-      Context.getObjCEncodingForMethodDecl(getter,TypeStr);
+      const std::string &TypeStr = GetMethodEncoding(CGM, getter);
       llvm::Constant *TypeEncoding = MakeConstantString(TypeStr);
       InstanceMethodTypes.push_back(TypeEncoding);
       Fields.push_back(MakeConstantString(getter->getSelector().getAsString()));
@@ -1000,8 +990,7 @@ void CGObjCGNU::GenerateProtocol(const ObjCProtocolDecl *PD) {
       Fields.push_back(NULLPtr);
     }
     if (ObjCMethodDecl *setter = property->getSetterMethodDecl()) {
-      std::string TypeStr;
-      Context.getObjCEncodingForMethodDecl(setter,TypeStr);
+      const std::string &TypeStr = GetMethodEncoding(CGM, setter);
       llvm::Constant *TypeEncoding = MakeConstantString(TypeStr);
       InstanceMethodTypes.push_back(TypeEncoding);
       Fields.push_back(MakeConstantString(setter->getSelector().getAsString()));
@@ -1128,8 +1117,7 @@ void CGObjCGNU::GenerateCategory(const ObjCCategoryImplDecl *OCD) {
          iter = OCD->instmeth_begin(), endIter = OCD->instmeth_end();
        iter != endIter ; iter++) {
     InstanceMethodSels.push_back((*iter)->getSelector());
-    std::string TypeStr;
-    CGM.getContext().getObjCEncodingForMethodDecl(*iter,TypeStr);
+    const std::string &TypeStr = GetMethodEncoding(CGM, *iter);
     InstanceMethodTypes.push_back(MakeConstantString(TypeStr));
   }
 
@@ -1140,8 +1128,7 @@ void CGObjCGNU::GenerateCategory(const ObjCCategoryImplDecl *OCD) {
          iter = OCD->classmeth_begin(), endIter = OCD->classmeth_end();
        iter != endIter ; iter++) {
     ClassMethodSels.push_back((*iter)->getSelector());
-    std::string TypeStr;
-    CGM.getContext().getObjCEncodingForMethodDecl(*iter,TypeStr);
+    const std::string &TypeStr = GetMethodEncoding(CGM, *iter);
     ClassMethodTypes.push_back(MakeConstantString(TypeStr));
   }
 
@@ -1175,7 +1162,6 @@ void CGObjCGNU::GenerateCategory(const ObjCCategoryImplDecl *OCD) {
 llvm::Constant *CGObjCGNU::GeneratePropertyList(const ObjCImplementationDecl *OID,
         llvm::SmallVectorImpl<Selector> &InstanceMethodSels,
         llvm::SmallVectorImpl<llvm::Constant*> &InstanceMethodTypes) {
-  ASTContext &Context = CGM.getContext();
   //
   // Property metadata: name, attributes, isSynthesized, setter name, setter
   // types, getter name, getter types.
@@ -1201,8 +1187,7 @@ llvm::Constant *CGObjCGNU::GeneratePropertyList(const ObjCImplementationDecl *OI
                 ObjCPropertyImplDecl::Synthesize));
     if (ObjCMethodDecl *getter = property->getGetterMethodDecl()) {
       InstanceMethodSels.push_back(getter->getSelector());
-      std::string TypeStr;
-      Context.getObjCEncodingForMethodDecl(getter,TypeStr);
+      const std::string &TypeStr = GetMethodEncoding(CGM, getter);
       llvm::Constant *TypeEncoding = MakeConstantString(TypeStr);
       InstanceMethodTypes.push_back(TypeEncoding);
       Fields.push_back(MakeConstantString(getter->getSelector().getAsString()));
@@ -1213,8 +1198,7 @@ llvm::Constant *CGObjCGNU::GeneratePropertyList(const ObjCImplementationDecl *OI
     }
     if (ObjCMethodDecl *setter = property->getSetterMethodDecl()) {
       InstanceMethodSels.push_back(setter->getSelector());
-      std::string TypeStr;
-      Context.getObjCEncodingForMethodDecl(setter,TypeStr);
+      const std::string &TypeStr = GetMethodEncoding(CGM, setter);
       llvm::Constant *TypeEncoding = MakeConstantString(TypeStr);
       InstanceMethodTypes.push_back(TypeEncoding);
       Fields.push_back(MakeConstantString(setter->getSelector().getAsString()));
@@ -1321,8 +1305,7 @@ void CGObjCGNU::GenerateClass(const ObjCImplementationDecl *OID) {
          iter = OID->instmeth_begin(), endIter = OID->instmeth_end();
        iter != endIter ; iter++) {
     InstanceMethodSels.push_back((*iter)->getSelector());
-    std::string TypeStr;
-    Context.getObjCEncodingForMethodDecl((*iter),TypeStr);
+    const std::string &TypeStr = GetMethodEncoding(CGM, *iter);
     InstanceMethodTypes.push_back(MakeConstantString(TypeStr));
   }
 
@@ -1337,8 +1320,7 @@ void CGObjCGNU::GenerateClass(const ObjCImplementationDecl *OID) {
          iter = OID->classmeth_begin(), endIter = OID->classmeth_end();
        iter != endIter ; iter++) {
     ClassMethodSels.push_back((*iter)->getSelector());
-    std::string TypeStr;
-    Context.getObjCEncodingForMethodDecl((*iter),TypeStr);
+    const std::string &TypeStr = GetMethodEncoding(CGM, *iter);
     ClassMethodTypes.push_back(MakeConstantString(TypeStr));
   }
   // Collect the names of referenced protocols
@@ -3485,9 +3485,7 @@ llvm::Constant *CGObjCCommonMac::GetMethodVarType(const FieldDecl *Field) {
 }
 
 llvm::Constant *CGObjCCommonMac::GetMethodVarType(const ObjCMethodDecl *D) {
-  std::string TypeStr;
-  CGM.getContext().getObjCEncodingForMethodDecl(const_cast<ObjCMethodDecl*>(D),
-                                                TypeStr);
+  const std::string &TypeStr = GetMethodEncoding(CGM, D);
 
   llvm::GlobalVariable *&Entry = MethodVarTypes[TypeStr];
 
@@ -16,6 +16,7 @@
 #ifndef CLANG_CODEGEN_OBCJRUNTIME_H
 #define CLANG_CODEGEN_OBCJRUNTIME_H
 #include "clang/Basic/IdentifierTable.h" // Selector
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "clang/AST/DeclObjC.h"
 #include <string>
@@ -88,6 +89,16 @@ protected:
                                   unsigned CVRQualifiers,
                                   llvm::Value *Offset);
 
+  /// Return the type encoding of the given method.  Message sends, selectors
+  /// and method lists all need it, so it is only computed once per method;
+  /// the result is valid until the next call.
+  const std::string &GetMethodEncoding(CodeGen::CodeGenModule &CGM,
+                                       const ObjCMethodDecl *MD);
+
+private:
+  /// The type encodings returned by GetMethodEncoding.
+  llvm::DenseMap<const ObjCMethodDecl *, std::string> MethodEncodings;
+
 public:
   virtual ~CGObjCRuntime();
 
@@ -21,6 +21,7 @@
 #include "llvm/InlineAsm.h"
 #include "llvm/Intrinsics.h"
 #include "llvm/Target/TargetData.h"
+#include <algorithm>
 using namespace clang;
 using namespace CodeGen;
 
@@ -660,7 +661,8 @@ void CodeGenFunction::EmitContinueStmt(const ContinueStmt &S) {
 
 /// EmitCaseStmtRange - If case statement range is not too big then
 /// add multiple cases to switch instruction, one for each value within
-/// the range. If range is too big then emit "if" condition check.
+/// the range. If range is too big then record it for the range tests that
+/// the switch's default leads to.
 void CodeGenFunction::EmitCaseStmtRange(const CaseStmt &S) {
   assert(S.getRHS() && "Expected RHS value in CaseStmt");
 
@@ -689,33 +691,56 @@ void CodeGenFunction::EmitCaseStmtRange(const CaseStmt &S) {
     return;
   }
 
-  // The range is too big. Emit "if" condition into a new block,
-  // making sure to save and restore the current insertion point.
-  llvm::BasicBlock *RestoreBB = Builder.GetInsertBlock();
-
-  // Push this test onto the chain of range checks (which terminates
-  // in the default basic block). The switch's default will be changed
-  // to the top of this chain after switch emission is complete.
-  llvm::BasicBlock *FalseDest = CaseRangeBlock;
-  CaseRangeBlock = createBasicBlock("sw.caserange");
-
-  CurFn->getBasicBlockList().push_back(CaseRangeBlock);
-  Builder.SetInsertPoint(CaseRangeBlock);
-
-  // Emit range check.
-  llvm::Value *Diff =
-    Builder.CreateSub(SwitchInsn->getCondition(),
-                      llvm::ConstantInt::get(VMContext, LHS),  "tmp");
-  llvm::Value *Cond =
-    Builder.CreateICmpULE(Diff,
-                          llvm::ConstantInt::get(VMContext, Range), "tmp");
-  Builder.CreateCondBr(Cond, CaseDest, FalseDest);
-
-  // Restore the appropriate insertion point.
-  if (RestoreBB)
-    Builder.SetInsertPoint(RestoreBB);
-  else
-    Builder.ClearInsertionPoint();
+  CaseRanges->push_back(CaseRange(LHS, Range, CaseDest));
+}
+
+/// EmitCaseRangeTests - Emit the tests of the sorted case ranges
+/// [Begin, End), which branch to Default when the switch condition is in
+/// none of them, and return the block to enter them through.  A few ranges
+/// are checked one after the other; more are split in two halves by a
+/// comparison with the first value of the middle range, so that a switch
+/// with many big ranges only does a logarithmic number of tests.
+llvm::BasicBlock *
+CodeGenFunction::EmitCaseRangeTests(const CaseRange *Begin,
+                                    const CaseRange *End,
+                                    llvm::BasicBlock *Default) {
+  llvm::Value *CondV = SwitchInsn->getCondition();
+
+  if (End - Begin > 3) {
+    const CaseRange *Mid = Begin + (End - Begin) / 2;
+    llvm::BasicBlock *LowBlock = EmitCaseRangeTests(Begin, Mid, Default);
+    llvm::BasicBlock *HighBlock = EmitCaseRangeTests(Mid, End, Default);
+
+    llvm::BasicBlock *SplitBlock = createBasicBlock("sw.caserange.split");
+    CurFn->getBasicBlockList().push_back(SplitBlock);
+    Builder.SetInsertPoint(SplitBlock);
+    llvm::Value *Low = llvm::ConstantInt::get(VMContext, Mid->Low);
+    llvm::Value *Cond = Mid->Low.isSigned() ?
+      Builder.CreateICmpSLT(CondV, Low, "tmp") :
+      Builder.CreateICmpULT(CondV, Low, "tmp");
+    Builder.CreateCondBr(Cond, LowBlock, HighBlock);
+    return SplitBlock;
+  }
+
+  // Chain the tests, from the last one to the first.
+  llvm::BasicBlock *FalseDest = Default;
+  for (const CaseRange *R = End; R != Begin; ) {
+    --R;
+    llvm::BasicBlock *RangeBlock = createBasicBlock("sw.caserange");
+    CurFn->getBasicBlockList().push_back(RangeBlock);
+    Builder.SetInsertPoint(RangeBlock);
+
+    // Emit range check.
+    llvm::Value *Diff =
+      Builder.CreateSub(CondV, llvm::ConstantInt::get(VMContext, R->Low),
+                        "tmp");
+    llvm::Value *Cond =
+      Builder.CreateICmpULE(Diff, llvm::ConstantInt::get(VMContext, R->Size),
+                            "tmp");
+    Builder.CreateCondBr(Cond, R->Dest, FalseDest);
+    FalseDest = RangeBlock;
+  }
+  return FalseDest;
 }
 
 void CodeGenFunction::EmitCaseStmt(const CaseStmt &S) {
@@ -762,6 +787,124 @@ void CodeGenFunction::EmitDefaultStmt(const DefaultStmt &S) {
   EmitStmt(S.getSubStmt());
 }
 
+/// EmitSwitchAsLookupTable - If every case of the switch S only returns a
+/// constant, and the case values are dense enough, emit the switch as a load
+/// from a constant table indexed by the condition instead.  Returns false,
+/// without emitting anything, if the switch does not have that form.
+bool CodeGenFunction::EmitSwitchAsLookupTable(const SwitchStmt &S,
+                                              llvm::Value *CondV) {
+  // The cases' statements would not get their stop points.
+  if (getDebugInfo() || S.getConditionVariable() || !ReturnValue ||
+      !FnRetTy->isIntegerType() || FnRetTy->isBooleanType())
+    return false;
+
+  const CompoundStmt *Body = dyn_cast<CompoundStmt>(S.getBody());
+  if (!Body)
+    return false;
+
+  llvm::SmallVector<std::pair<llvm::APSInt, llvm::APSInt>, 16> Cases;
+  llvm::APSInt DefaultVal;
+  bool HasDefault = false;
+  for (CompoundStmt::const_body_iterator I = Body->body_begin(),
+         E = Body->body_end(); I != E; ++I) {
+    // Collect the labels of this statement.
+    const Stmt *Sub = *I;
+    unsigned FirstCase = Cases.size();
+    bool IsDefault = false;
+    for (;;) {
+      if (const CaseStmt *CS = dyn_cast<CaseStmt>(Sub)) {
+        if (CS->getRHS())
+          return false;
+        llvm::APSInt CaseVal = CS->getLHS()->EvaluateAsInt(getContext());
+        Cases.push_back(std::make_pair(CaseVal, llvm::APSInt()));
+        Sub = CS->getSubStmt();
+      } else if (const DefaultStmt *DS = dyn_cast<DefaultStmt>(Sub)) {
+        IsDefault = true;
+        Sub = DS->getSubStmt();
+      } else
+        break;
+    }
+
+    const ReturnStmt *RS = dyn_cast<ReturnStmt>(Sub);
+    if ((FirstCase == Cases.size() && !IsDefault) || !RS ||
+        !RS->getRetValue())
+      return false;
+
+    llvm::APSInt Val;
+    if (!RS->getRetValue()->isIntegerConstantExpr(Val, getContext()))
+      return false;
+    Val.extOrTrunc(getContext().getTypeSize(FnRetTy));
+
+    for (unsigned C = FirstCase, N = Cases.size(); C != N; ++C)
+      Cases[C].second = Val;
+    if (IsDefault) {
+      HasDefault = true;
+      DefaultVal = Val;
+    }
+  }
+
+  // FIXME: parameters such as this should not be hardcoded.
+  const unsigned MinLookupTableCases = 4;
+  if (!HasDefault || Cases.size() < MinLookupTableCases)
+    return false;
+
+  // Only use a table at most twice as big as the number of cases.
+  llvm::APSInt Min = Cases[0].first, Max = Cases[0].first;
+  for (unsigned C = 1, N = Cases.size(); C != N; ++C) {
+    if (Cases[C].first < Min)
+      Min = Cases[C].first;
+    if (Max < Cases[C].first)
+      Max = Cases[C].first;
+  }
+  llvm::APInt Span = Max - Min;
+  if (Span.getActiveBits() > 31 || Span.getZExtValue() >= 2 * Cases.size())
+    return false;
+
+  unsigned TableSize = Span.getZExtValue() + 1;
+  std::vector<llvm::Constant*> Elts(TableSize,
+                                    llvm::ConstantInt::get(VMContext,
+                                                           DefaultVal));
+  for (unsigned C = 0, N = Cases.size(); C != N; ++C)
+    Elts[(Cases[C].first - Min).getZExtValue()]
+      = llvm::ConstantInt::get(VMContext, Cases[C].second);
+
+  const llvm::ArrayType *TableTy =
+    llvm::ArrayType::get(ConvertType(FnRetTy), TableSize);
+  llvm::GlobalVariable *Table =
+    new llvm::GlobalVariable(CGM.getModule(), TableTy, true,
+                             llvm::GlobalValue::InternalLinkage,
+                             llvm::ConstantArray::get(TableTy, Elts),
+                             "switch.table");
+
+  // Branch to the default unless the condition indexes the table.
+  llvm::Value *Index =
+    Builder.CreateSub(CondV, llvm::ConstantInt::get(VMContext, Min),
+                      "switch.index");
+  llvm::Value *InRange =
+    Builder.CreateICmpULT(Index,
+                          llvm::ConstantInt::get(CondV->getType(), TableSize),
+                          "switch.inrange");
+  llvm::BasicBlock *LookupBlock = createBasicBlock("switch.lookup");
+  llvm::BasicBlock *DefaultBlock = createBasicBlock("sw.default");
+  Builder.CreateCondBr(InRange, LookupBlock, DefaultBlock);
+
+  EmitBlock(LookupBlock);
+  llvm::Value *Indices[] = {
+    llvm::ConstantInt::get(llvm::Type::getInt32Ty(VMContext), 0),
+    Index
+  };
+  llvm::Value *Addr = Builder.CreateInBoundsGEP(Table, Indices, Indices + 2,
+                                                "switch.gep");
+  Builder.CreateStore(Builder.CreateLoad(Addr, "switch.load"), ReturnValue);
+  EmitBranchThroughCleanup(ReturnBlock);
+
+  EmitBlock(DefaultBlock);
+  Builder.CreateStore(llvm::ConstantInt::get(VMContext, DefaultVal),
+                      ReturnValue);
+  EmitBranchThroughCleanup(ReturnBlock);
+  return true;
+}
+
 void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
   CleanupScope ConditionScope(*this);
 
@@ -770,9 +913,13 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
 
   llvm::Value *CondV = EmitScalarExpr(S.getCond());
 
+  // A switch that only picks the value to return becomes a table lookup.
+  if (EmitSwitchAsLookupTable(S, CondV))
+    return;
+
   // Handle nested switch statements.
   llvm::SwitchInst *SavedSwitchInsn = SwitchInsn;
-  llvm::BasicBlock *SavedCRBlock = CaseRangeBlock;
+  llvm::SmallVector<CaseRange, 4> *SavedCaseRanges = CaseRanges;
 
   // Create basic block to hold stuff that comes after switch
   // statement. We also need to create a default block now so that
@@ -781,7 +928,8 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
   llvm::BasicBlock *NextBlock = createBasicBlock("sw.epilog");
   llvm::BasicBlock *DefaultBlock = createBasicBlock("sw.default");
   SwitchInsn = Builder.CreateSwitch(CondV, DefaultBlock);
-  CaseRangeBlock = DefaultBlock;
+  llvm::SmallVector<CaseRange, 4> Ranges;
+  CaseRanges = &Ranges;
 
   // Clear the insertion point to indicate we are in unreachable code.
   Builder.ClearInsertionPoint();
@@ -800,9 +948,22 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
 
   BreakContinueStack.pop_back();
 
-  // Update the default block in case explicit case range tests have
-  // been chained on top.
-  SwitchInsn->setSuccessor(0, CaseRangeBlock);
+  // Send the values of the switch that are not cases on to the tests of the
+  // big case ranges, making sure to save and restore the current insertion
+  // point.
+  if (!Ranges.empty()) {
+    llvm::BasicBlock *RestoreBB = Builder.GetInsertBlock();
+
+    std::sort(Ranges.begin(), Ranges.end());
+    SwitchInsn->setSuccessor(0, EmitCaseRangeTests(Ranges.begin(),
+                                                   Ranges.end(),
+                                                   DefaultBlock));
+
+    if (RestoreBB)
+      Builder.SetInsertPoint(RestoreBB);
+    else
+      Builder.ClearInsertionPoint();
+  }
 
   // If a default was never emitted then reroute any jumps to it and
   // discard.
@@ -815,7 +976,7 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
   EmitBlock(NextBlock, true);
 
   SwitchInsn = SavedSwitchInsn;
-  CaseRangeBlock = SavedCRBlock;
+  CaseRanges = SavedCaseRanges;
 }
 
 static std::string
@@ -163,7 +163,10 @@ private:
 
   typedef llvm::DenseMap<GlobalDecl, AdjustmentVectorTy> SavedAdjustmentsTy;
   SavedAdjustmentsTy SavedAdjustments;
-  llvm::DenseSet<const CXXRecordDecl*> SavedAdjustmentRecords;
+
+  /// VtableInfoRecords - The records whose saved adjustments and virtual base
+  /// offset indices have been computed.
+  llvm::DenseSet<const CXXRecordDecl*> VtableInfoRecords;
 
   typedef llvm::DenseMap<ClassPairTy, uint64_t> SubVTTIndiciesTy;
   SubVTTIndiciesTy SubVTTIndicies;
@@ -173,6 +176,10 @@ private:
   uint64_t getNumVirtualFunctionPointers(const CXXRecordDecl *RD);
   
   void ComputeMethodVtableIndices(const CXXRecordDecl *RD);
+
+  /// ComputeVtableInfo - Lay out the vtable of \arg RD once, to fill in both
+  /// its SavedAdjustments and its VirtualBaseClassIndicies.
+  void ComputeVtableInfo(const CXXRecordDecl *RD);
   
   /// GenerateClassData - Generate all the class data requires to be generated
   /// upon definition of a KeyFunction.  This includes the vtable, the
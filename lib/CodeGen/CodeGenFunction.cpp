@@ -14,6 +14,7 @@
 #include "CodeGenFunction.h"
 #include "CodeGenModule.h"
 #include "CGDebugInfo.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
@@ -29,7 +30,7 @@ CodeGenFunction::CodeGenFunction(CodeGenModule &cgm)
     Target(CGM.getContext().Target),
     Builder(cgm.getModule().getContext()),
     DebugInfo(0), IndirectBranch(0),
-    SwitchInsn(0), CaseRangeBlock(0), InvokeDest(0),
+    SwitchInsn(0), CaseRanges(0), InvokeDest(0), EHCleanupExnSlot(0),
     CXXThisDecl(0), CXXThisValue(0), CXXVTTDecl(0), CXXVTTValue(0),
     ConditionalBranchLevel(0), TerminateHandler(0), TrapBB(0),
     UniqueAggrDestructorCount(0) {
@@ -143,6 +144,8 @@ void CodeGenFunction::FinishFunction(SourceLocation EndLoc) {
     Builder.ClearInsertionPoint();
   }
   
+  EraseUnusedEHCleanups();
+
   // Remove the AllocaInsertPt instruction, which is just a convenience for us.
   llvm::Instruction *Ptr = AllocaInsertPt;
   AllocaInsertPt = 0;
@@ -320,6 +323,12 @@ void CodeGenFunction::GenerateBody(GlobalDecl GD, llvm::Function *Fn,
 
 void CodeGenFunction::GenerateCode(GlobalDecl GD, llvm::Function *Fn) {
   const FunctionDecl *FD = cast<FunctionDecl>(GD.getDecl());
+
+  // The function is named as in the LLVM backend phases, so that the time
+  // spent on it can be followed from IR generation to machine code.
+  PhaseRegion Phase;
+  if (PhaseStatistics::getActive())
+    Phase.enter("Generate function", Fn->getName());
   
   // Check if we should generate debug info for this function.
   if (CGM.getDebugInfo() && !FD->hasAttr<NoDebugAttr>())
@@ -365,13 +374,20 @@ void CodeGenFunction::GenerateCode(GlobalDecl GD, llvm::Function *Fn) {
   if (Stmt *Body = FD->getBody()) BodyRange = Body->getSourceRange();
 
   // Emit the standard function prologue.
+  PhaseRegion ProloguePhase("Prologue");
   StartFunction(GD, FD->getResultType(), Fn, Args, BodyRange.getBegin());
+  ProloguePhase.exit();
 
   // Generate the body of the function.
+  PhaseRegion BodyPhase("Body");
   GenerateBody(GD, Fn, Args);
+  BodyPhase.exit();
 
-  // Emit the standard function epilogue.
+  // Emit the standard function epilogue, along with the cleanups of the
+  // function scope.
+  PhaseRegion EpiloguePhase("Epilogue");
   FinishFunction(BodyRange.getEnd());
+  EpiloguePhase.exit();
 
   // Destroy the 'this' declaration.
   if (CXXThisDecl)
@@ -156,17 +156,10 @@ public:
     llvm::BasicBlock *CleanupHandler;
     llvm::BasicBlock *CleanupEntryBB;
     llvm::BasicBlock *PreviousInvokeDest;
+    /// LastBlockBefore - The last block of the function before the cleanup.
+    llvm::BasicBlock *LastBlockBefore;
   public:
-    EHCleanupBlock(CodeGenFunction &cgf) 
-      : CGF(cgf), Cont(CGF.createBasicBlock("cont")),
-        CleanupHandler(CGF.createBasicBlock("ehcleanup")),
-        CleanupEntryBB(CGF.createBasicBlock("ehcleanup.rest")),
-        PreviousInvokeDest(CGF.getInvokeDest()) {
-      CGF.EmitBranch(Cont);
-      llvm::BasicBlock *TerminateHandler = CGF.getTerminateHandler();
-      CGF.Builder.SetInsertPoint(CleanupEntryBB);
-      CGF.setInvokeDest(TerminateHandler);
-    }
+    EHCleanupBlock(CodeGenFunction &cgf);
     ~EHCleanupBlock();
   };
 
@@ -320,9 +313,24 @@ private:
   /// current context is not in a switch.
   llvm::SwitchInst *SwitchInsn;
 
-  /// CaseRangeBlock - This block holds if condition check for last case
-  /// statement range in current switch instruction.
-  llvm::BasicBlock *CaseRangeBlock;
+  /// CaseRange - A case statement range of the current switch that is too
+  /// big to be added to the switch instruction one value at a time.
+  struct CaseRange {
+    CaseRange(const llvm::APSInt &low, const llvm::APInt &size,
+              llvm::BasicBlock *dest)
+      : Low(low), Size(size), Dest(dest) {}
+
+    llvm::APSInt Low;
+    llvm::APInt Size;   // High - Low.
+    llvm::BasicBlock *Dest;
+
+    bool operator<(const CaseRange &RHS) const { return Low < RHS.Low; }
+  };
+
+  /// CaseRanges - The big case ranges of the current switch.  They are
+  /// tested by a binary search emitted once the switch body is done, which
+  /// the switch instruction's default destination leads to.
+  llvm::SmallVector<CaseRange, 4> *CaseRanges;
 
   /// InvokeDest - This is the nearest exception target for calls
   /// which can unwind, when exceptions are being used.
@@ -374,6 +382,37 @@ private:
   /// CleanupEntries - Stack of cleanup entries.
   llvm::SmallVector<CleanupEntry, 8> CleanupEntries;
 
+  /// EHCleanupInfo - The blocks emitted for an EHCleanupBlock.
+  struct EHCleanupInfo {
+    /// Handler - The landing pad of the cleanup.
+    llvm::BasicBlock *Handler;
+
+    /// Entry - The block performing the cleanup, which the landing pads of
+    /// the cleanups it encloses branch to.
+    llvm::BasicBlock *Entry;
+
+    /// Blocks - All the blocks of the cleanup, including the above.
+    llvm::SmallVector<llvm::BasicBlock *, 4> Blocks;
+
+    EHCleanupInfo(llvm::BasicBlock *Handler, llvm::BasicBlock *Entry)
+      : Handler(Handler), Entry(Entry) {}
+  };
+
+  /// EHCleanups - The EH cleanups of the function, outermost first.
+  llvm::SmallVector<EHCleanupInfo, 4> EHCleanups;
+
+  /// EHCleanupEntries - Map from the landing pad of each EH cleanup to the
+  /// block performing the cleanup.
+  llvm::DenseMap<llvm::BasicBlock *, llvm::BasicBlock *> EHCleanupEntries;
+
+  /// EHCleanupExnSlot - The exception being propagated through EH cleanups,
+  /// or null if no EH cleanup was emitted yet.
+  llvm::Value *EHCleanupExnSlot;
+
+  /// EraseUnusedEHCleanups - Erase the EH cleanups, and the terminate
+  /// handler, that nothing can unwind into.
+  void EraseUnusedEHCleanups();
+
   typedef llvm::DenseMap<llvm::BasicBlock*, size_t> BlockScopeMap;
 
   /// BlockScopes - Map of which "cleanup scope" scope basic blocks have.
@@ -920,6 +959,10 @@ public:
   void EmitDefaultStmt(const DefaultStmt &S);
   void EmitCaseStmt(const CaseStmt &S);
   void EmitCaseStmtRange(const CaseStmt &S);
+  bool EmitSwitchAsLookupTable(const SwitchStmt &S, llvm::Value *CondV);
+  llvm::BasicBlock *EmitCaseRangeTests(const CaseRange *Begin,
+                                       const CaseRange *End,
+                                       llvm::BasicBlock *Default);
   void EmitAsmStmt(const AsmStmt &S);
 
   void EmitObjCForCollectionStmt(const ObjCForCollectionStmt &S);
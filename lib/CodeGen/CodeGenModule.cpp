@@ -23,7 +23,9 @@
 #include "clang/AST/CharUnits.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/DeclCXX.h"
+#include "clang/AST/ExternalASTSource.h"
 #include "clang/AST/RecordLayout.h"
+#include "clang/Basic/AtomicOutputFile.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/SourceManager.h"
@@ -34,7 +36,13 @@
 #include "llvm/Intrinsics.h"
 #include "llvm/LLVMContext.h"
 #include "llvm/Target/TargetData.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <cstdio>
 using namespace clang;
 using namespace CodeGen;
 
@@ -45,7 +53,8 @@ CodeGenModule::CodeGenModule(ASTContext &C, const CodeGenOptions &CGO,
   : BlockModule(C, M, TD, Types, *this), Context(C),
     Features(C.getLangOptions()), CodeGenOpts(CGO), TheModule(M),
     TheTargetData(TD), TheTargetCodeGenInfo(0), Diags(diags),
-    Types(C, M, TD, getTargetCodeGenInfo().getABIInfo()),
+    Types(C, M, TD, getTargetCodeGenInfo().getABIInfo(),
+          CGO.LazyRecordTypes),
     MangleCtx(C), VtableInfo(*this), Runtime(0),
     MemCpyFn(0), MemMoveFn(0), MemSetFn(0), CFConstantStringClassRef(0),
     VMContext(M.getContext()) {
@@ -181,10 +190,17 @@ const char *CodeGenModule::getMangledName(const NamedDecl *ND) {
     return ND->getNameAsCString();
   }
 
+  // Constructors and destructors are cached under their type by
+  // getMangledCXXCtorName and getMangledCXXDtorName.
+  const char *&Str = MangledDeclNames[GlobalDecl::getFromOpaquePtr(
+                                                 const_cast<NamedDecl *>(ND))];
+  if (Str)
+    return Str;
+
   llvm::SmallString<256> Name;
   getMangleContext().mangleName(ND, Name);
   Name += '\0';
-  return UniqueMangledName(Name.begin(), Name.end());
+  return Str = UniqueMangledName(Name.begin(), Name.end());
 }
 
 const char *CodeGenModule::UniqueMangledName(const char *NameStart,
@@ -474,29 +490,147 @@ void CodeGenModule::EmitLLVMUsed() {
   GV->setSection("llvm.metadata");
 }
 
+/// PrefetchDeferredBodies - If the body of FD still has to be read from the
+/// external AST source, let the source read the bodies of all of the deferred
+/// functions at once rather than one at a time.  The first Prefetched entries
+/// of Deferred were offered to the source before and are skipped; on return,
+/// all of them have been.
+static void PrefetchDeferredBodies(ASTContext &Context, const FunctionDecl *FD,
+                                   const std::vector<GlobalDecl> &Deferred,
+                                   unsigned &Prefetched) {
+  ExternalASTSource *Source = Context.getExternalSource();
+  if (!Source || !FD->getLazyBodyOffset())
+    return;
+
+  llvm::SmallVector<const FunctionDecl *, 16> Functions;
+  Functions.push_back(FD);
+  for (unsigned I = Prefetched, N = Deferred.size(); I != N; ++I)
+    if (const FunctionDecl *D = dyn_cast<FunctionDecl>(Deferred[I].getDecl()))
+      Functions.push_back(D);
+  Prefetched = Deferred.size();
+  Source->PrefetchFunctionBodies(Functions.begin(), Functions.end());
+}
+
 void CodeGenModule::EmitDeferred() {
   // Emit code for any potentially referenced deferred decls.  Since a
   // previously unused static decl may become used during the generation of code
   // for a static function, iterate until no  changes are made.
+  //
+  // The list is used as a stack, so the decls below Prefetched have not been
+  // popped since their bodies were last prefetched.  Only the decls pushed
+  // since then have to be looked at again, which keeps the prefetching
+  // linear when emitting one instantiation defers the next.
+  unsigned Prefetched = 0;
   while (!DeferredDeclsToEmit.empty()) {
     GlobalDecl D = DeferredDeclsToEmit.back();
     DeferredDeclsToEmit.pop_back();
+    Prefetched = std::min(Prefetched, (unsigned)DeferredDeclsToEmit.size());
 
     // The mangled name for the decl must have been emitted in GlobalDeclMap.
     // Look it up to see if it was defined with a stronger definition (e.g. an
     // extern inline function with a strong function redefinition).  If so,
     // just ignore the deferred decl.
-    llvm::GlobalValue *CGRef = GlobalDeclMap[getMangledName(D)];
+    const char *MangledName = getMangledName(D);
+    llvm::GlobalValue *CGRef = GlobalDeclMap[MangledName];
     assert(CGRef && "Deferred decl wasn't referenced?");
 
     if (!CGRef->isDeclaration())
       continue;
 
+    // Leave the definitions other translation units have claimed to them.
+    bool Owned = false;
+    const FunctionDecl *FD = dyn_cast<FunctionDecl>(D.getDecl());
+    if (FD && !CodeGenOpts.EmittedDefinitionsDir.empty() &&
+        !ClaimDefinition(FD, MangledName, Owned))
+      continue;
+
+    if (FD)
+      PrefetchDeferredBodies(Context, FD, DeferredDeclsToEmit, Prefetched);
+
     // Otherwise, emit the definition and move on to the next one.
     EmitGlobalDefinition(D);
+
+    // The other translation units rely on the claimed definition, so it must
+    // be kept even if every use of it here is inlined.
+    llvm::GlobalValue *GV = GlobalDeclMap[MangledName];
+    if (Owned && GV->getLinkage() == llvm::GlobalValue::LinkOnceODRLinkage)
+      GV->setLinkage(llvm::GlobalValue::WeakODRLinkage);
   }
 }
 
+/// ClaimDefinition - The registry is a directory with one small file per
+/// claimed definition, named by a hash of its key.  The key is the mangled
+/// name together with a hash of the source text of the function the
+/// definition was instantiated from, so that a definition edited since
+/// another translation unit claimed it is not mistaken for the claimed one.
+/// The file holds the key and the name of the claiming module.  Claims are
+/// written to a temporary file and renamed into place; when two translation
+/// units race for a claim both define the function, which only costs the
+/// redundant work.  Since the registry can not tell a claim of this build
+/// from a stale one, it must be emptied before each build.
+bool CodeGenModule::ClaimDefinition(const FunctionDecl *FD,
+                                    const char *MangledName, bool &Owned) {
+  GVALinkage Linkage = GetLinkageForFunction(getContext(), FD, Features);
+  if (Linkage != GVA_CXXInline && Linkage != GVA_TemplateInstantiation)
+    return true;
+
+  const FunctionDecl *Pattern = FD->getTemplateInstantiationPattern();
+  if (!Pattern)
+    Pattern = FD;
+  SourceManager &SM = getContext().getSourceManager();
+  SourceLocation Begin = SM.getInstantiationLoc(
+                                          Pattern->getSourceRange().getBegin());
+  SourceLocation End = SM.getInstantiationLoc(
+                                            Pattern->getSourceRange().getEnd());
+  // Implicit members have no source text to hash; emit them locally.
+  if (Begin.isInvalid() || End.isInvalid() ||
+      SM.getFileID(Begin) != SM.getFileID(End) ||
+      SM.getFileOffset(End) < SM.getFileOffset(Begin))
+    return true;
+  const char *Text = SM.getCharacterData(Begin);
+  llvm::StringRef Body(Text, SM.getCharacterData(End) - Text + 1);
+
+  std::string Key(MangledName);
+  Key += '\0';
+  Key += llvm::utohexstr(llvm::HashString(Body));
+  std::string Owner = getModule().getModuleIdentifier();
+
+  char Name[32];
+  snprintf(Name, sizeof(Name), "def-%08x", llvm::HashString(Key));
+  llvm::sys::Path EntryPath(CodeGenOpts.EmittedDefinitionsDir);
+  EntryPath.appendComponent(Name);
+
+  std::string Entry("cfe-def");
+  Entry += '\0';
+  Entry += Key;
+  Entry += '\0';
+
+  llvm::OwningPtr<llvm::MemoryBuffer> Buffer(
+                                llvm::MemoryBuffer::getFile(EntryPath.str()));
+  if (Buffer) {
+    // A different key hashing to the same name leaves the definition to be
+    // emitted locally.
+    llvm::StringRef Contents(Buffer->getBufferStart(),
+                             Buffer->getBufferSize());
+    if (!Contents.startswith(Entry))
+      return true;
+    Owned = Contents.substr(Entry.size()) == Owner;
+    return Owned;
+  }
+
+  // An entry that was not written completely must not claim the definition
+  // for this module, or every other module would leave it out.
+  AtomicOutputFile File(EntryPath.str());
+  std::string ErrorInfo;
+  if (File.open(ErrorInfo))
+    return true;
+
+  File.getStream() << Entry << Owner;
+  if (!File.commit(ErrorInfo))
+    Owned = true;
+  return true;
+}
+
 /// EmitAnnotateAttr - Generate the llvm::ConstantStruct which contains the
 /// annotation information for a given GlobalValue.  The annotation struct is
 /// {i8 *, i8 *, i8 *, i32}.  The first field is a constant expression, the
@@ -1274,6 +1408,9 @@ void CodeGenModule::EmitGlobalFunctionDefinition(GlobalDecl GD) {
     AddGlobalCtor(Fn, CA->getPriority());
   if (const DestructorAttr *DA = D->getAttr<DestructorAttr>())
     AddGlobalDtor(Fn, DA->getPriority());
+
+  if (CodeGenOpts.ReleaseFunctionBodies)
+    Context.ReleaseFunctionBody(const_cast<FunctionDecl *>(D));
 }
 
 void CodeGenModule::EmitAliasDefinition(const ValueDecl *D) {
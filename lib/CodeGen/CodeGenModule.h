@@ -29,6 +29,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/ValueHandle.h"
 #include <list>
 
@@ -117,12 +118,13 @@ class CodeGenModule : public BlockModule {
   /// pointer lookups instead of full string lookups.
   llvm::DenseMap<const char*, llvm::GlobalValue*> GlobalDeclMap;
 
-  /// \brief Contains the strings used for mangled names.
-  ///
-  /// FIXME: Eventually, this should map from the semantic/canonical
-  /// declaration for each global entity to its mangled name (if it
-  /// has one).
-  llvm::StringSet<> MangledNames;
+  /// \brief Contains the strings used for mangled names.  They live as long
+  /// as the module, so they are all allocated together.
+  llvm::StringSet<llvm::BumpPtrAllocator> MangledNames;
+
+  /// \brief Maps each declaration, with its constructor or destructor type,
+  /// to its uniqued mangled name, so that each is only mangled once.
+  llvm::DenseMap<GlobalDecl, const char*> MangledDeclNames;
 
   /// DeferredDecls - This contains all the decls which have definitions but
   /// which are deferred for emission and therefore should only be output if
@@ -507,6 +509,15 @@ private:
   /// was deferred.
   void EmitDeferred(void);
 
+  /// ClaimDefinition - Consult the registry of emitted definitions for the
+  /// inline function or template instantiation \arg FD, whose mangled name is
+  /// \arg MangledName.  Returns false if another translation unit of the
+  /// build has claimed its definition, so that only a declaration need be
+  /// emitted.  Otherwise sets \arg Owned if this translation unit now holds
+  /// the claim.
+  bool ClaimDefinition(const FunctionDecl *FD, const char *MangledName,
+                       bool &Owned);
+
   /// EmitLLVMUsed - Emit the llvm.used metadata used to force
   /// references to global which may otherwise be optimized out.
   void EmitLLVMUsed(void);
@@ -20,6 +20,7 @@
 #include "llvm/DerivedTypes.h"
 #include "llvm/Module.h"
 #include "llvm/Target/TargetData.h"
+#include <cstdio>
 
 #include "CGCall.h"
 #include "CGRecordLayoutBuilder.h"
@@ -28,9 +29,12 @@ using namespace clang;
 using namespace CodeGen;
 
 CodeGenTypes::CodeGenTypes(ASTContext &Ctx, llvm::Module& M,
-                           const llvm::TargetData &TD, const ABIInfo &Info)
+                           const llvm::TargetData &TD, const ABIInfo &Info,
+                           bool LazyRecords)
   : Context(Ctx), Target(Ctx.Target), TheModule(M), TheTargetData(TD),
-    TheABIInfo(Info) {
+    TheABIInfo(Info), LazyRecords(LazyRecords), NumConversions(0),
+    NumPointeesReused(0), NumPointeesDeferred(0), NumRecordLayouts(0),
+    NumLazyRecords(0), NumRefinements(0) {
 }
 
 CodeGenTypes::~CodeGenTypes() {
@@ -38,10 +42,17 @@ CodeGenTypes::~CodeGenTypes() {
          I = CGRecordLayouts.begin(), E = CGRecordLayouts.end();
       I != E; ++I)
     delete I->second;
+}
 
-  for (llvm::FoldingSet<CGFunctionInfo>::iterator
-       I = FunctionInfos.begin(), E = FunctionInfos.end(); I != E; )
-    delete &*I++;
+void CodeGenTypes::PrintStats() const {
+  fprintf(stderr, "*** CodeGen Type Stats:\n");
+  fprintf(stderr, "  %u types converted, %u opaque types refined.\n",
+          NumConversions, NumRefinements);
+  fprintf(stderr, "  %u pointees reused, %u pointees deferred.\n",
+          NumPointeesReused, NumPointeesDeferred);
+  fprintf(stderr, "  %u records laid out, %u records kept opaque",
+          NumRecordLayouts, NumLazyRecords);
+  fprintf(stderr, " (%u still opaque).\n", LazyRecordTypes.size());
 }
 
 /// ConvertType - Convert the specified type to its LLVM form.
@@ -60,6 +71,7 @@ const llvm::Type *CodeGenTypes::ConvertType(QualType T) {
     // opqaue type away will invalidate P.second, but we don't mind :).
     const llvm::Type *NT = ConvertTypeForMemRecursive(P.first);
     P.second->refineAbstractTypeTo(NT);
+    ++NumRefinements;
   }
 
   return Result;
@@ -138,12 +150,14 @@ void CodeGenTypes::UpdateCompletedType(const TagDecl *TD) {
 
   // Remove it from TagDeclTypes so that it will be regenerated.
   TagDeclTypes.erase(TDTI);
+  LazyRecordTypes.erase(Key);
 
   // Generate the new type.
   const llvm::Type *NT = ConvertTagDeclType(TD);
 
   // Refine the old opaque type to its new definition.
   cast<llvm::OpaqueType>(OpaqueHolder.get())->refineAbstractTypeTo(NT);
+  ++NumRefinements;
 
   // Since we just completed a tag type, check to see if any function types
   // were completed along with the tag type.
@@ -161,6 +175,7 @@ void CodeGenTypes::UpdateCompletedType(const TagDecl *TD) {
       llvm::PATypeHolder OpaqueHolder = i->second;
       const llvm::Type *NFT = ConvertNewType(QualType(i->first, 0));
       cast<llvm::OpaqueType>(OpaqueHolder.get())->refineAbstractTypeTo(NFT);
+      ++NumRefinements;
       FunctionTypes.erase(i);
     }
   }
@@ -182,8 +197,70 @@ static const llvm::Type* getTypeForFormat(llvm::LLVMContext &VMContext,
   return 0;
 }
 
+/// GetTagTypeName - Return the name of the LLVM type of the tag type \arg T,
+/// declared by \arg TD.
+static std::string GetTagTypeName(const TagDecl *TD, QualType T) {
+  std::string TypeName(TD->getKindName());
+  TypeName += '.';
+
+  // Name the codegen type after the typedef name
+  // if there is no tag type name available
+  if (TD->getIdentifier())
+    // FIXME: We should not have to check for a null decl context here.
+    // Right now we do it because the implicit Obj-C decls don't have one.
+    TypeName += TD->getDeclContext() ? TD->getQualifiedNameAsString() :
+      TD->getNameAsString();
+  else if (const TypedefType *TdT = dyn_cast<TypedefType>(T))
+    // FIXME: We should not have to check for a null decl context here.
+    // Right now we do it because the implicit Obj-C decls don't have one.
+    TypeName += TdT->getDecl()->getDeclContext() ? 
+      TdT->getDecl()->getQualifiedNameAsString() :
+      TdT->getDecl()->getNameAsString();
+  else
+    TypeName += "anon";
+  return TypeName;
+}
+
+const llvm::Type *CodeGenTypes::ConvertPointeeType(QualType T) {
+  const Type *Key = Context.getCanonicalType(T).getTypePtr();
+
+  // A type that has been converted before is not part of a cycle that is
+  // still being converted, so there is nothing to defer.
+  if (TypeCache.count(const_cast<Type *>(Key))) {
+    ++NumPointeesReused;
+    return ConvertTypeForMemRecursive(T);
+  }
+
+  // A record that is only pointed to needs no layout; give it an opaque type
+  // now, which ConvertTagDeclType refines once the body is needed.
+  if (LazyRecords && isa<RecordType>(Key)) {
+    const RecordDecl *RD = cast<RecordType>(Key)->getDecl();
+    const Type *TagKey = Context.getTagDeclType(RD).getTypePtr();
+    llvm::DenseMap<const Type*, llvm::PATypeHolder>::iterator TDTI =
+      TagDeclTypes.find(TagKey);
+    if (TDTI != TagDeclTypes.end()) {
+      ++NumPointeesReused;
+      return TDTI->second;
+    }
+    if (RD->isDefinition()) {
+      llvm::Type *ResultType = llvm::OpaqueType::get(getLLVMContext());
+      TagDeclTypes.insert(std::make_pair(TagKey, ResultType));
+      LazyRecordTypes.insert(TagKey);
+      TheModule.addTypeName(GetTagTypeName(RD, T), ResultType);
+      ++NumLazyRecords;
+      return ResultType;
+    }
+  }
+
+  llvm::OpaqueType *PointeeType = llvm::OpaqueType::get(getLLVMContext());
+  PointersToResolve.push_back(std::make_pair(T, PointeeType));
+  ++NumPointeesDeferred;
+  return PointeeType;
+}
+
 const llvm::Type *CodeGenTypes::ConvertNewType(QualType T) {
   const clang::Type &Ty = *Context.getCanonicalType(T).getTypePtr();
+  ++NumConversions;
 
   switch (Ty.getTypeClass()) {
 #define TYPE(Class, Base)
@@ -260,16 +337,14 @@ const llvm::Type *CodeGenTypes::ConvertNewType(QualType T) {
   case Type::RValueReference: {
     const ReferenceType &RTy = cast<ReferenceType>(Ty);
     QualType ETy = RTy.getPointeeType();
-    llvm::OpaqueType *PointeeType = llvm::OpaqueType::get(getLLVMContext());
-    PointersToResolve.push_back(std::make_pair(ETy, PointeeType));
-    return llvm::PointerType::get(PointeeType, ETy.getAddressSpace());
+    return llvm::PointerType::get(ConvertPointeeType(ETy),
+                                  ETy.getAddressSpace());
   }
   case Type::Pointer: {
     const PointerType &PTy = cast<PointerType>(Ty);
     QualType ETy = PTy.getPointeeType();
-    llvm::OpaqueType *PointeeType = llvm::OpaqueType::get(getLLVMContext());
-    PointersToResolve.push_back(std::make_pair(ETy, PointeeType));
-    return llvm::PointerType::get(PointeeType, ETy.getAddressSpace());
+    return llvm::PointerType::get(ConvertPointeeType(ETy),
+                                  ETy.getAddressSpace());
   }
 
   case Type::VariableArray: {
@@ -343,34 +418,14 @@ const llvm::Type *CodeGenTypes::ConvertNewType(QualType T) {
     const TagDecl *TD = cast<TagType>(Ty).getDecl();
     const llvm::Type *Res = ConvertTagDeclType(TD);
 
-    std::string TypeName(TD->getKindName());
-    TypeName += '.';
-
-    // Name the codegen type after the typedef name
-    // if there is no tag type name available
-    if (TD->getIdentifier())
-      // FIXME: We should not have to check for a null decl context here.
-      // Right now we do it because the implicit Obj-C decls don't have one.
-      TypeName += TD->getDeclContext() ? TD->getQualifiedNameAsString() :
-        TD->getNameAsString();
-    else if (const TypedefType *TdT = dyn_cast<TypedefType>(T))
-      // FIXME: We should not have to check for a null decl context here.
-      // Right now we do it because the implicit Obj-C decls don't have one.
-      TypeName += TdT->getDecl()->getDeclContext() ? 
-        TdT->getDecl()->getQualifiedNameAsString() :
-        TdT->getDecl()->getNameAsString();
-    else
-      TypeName += "anon";
-
-    TheModule.addTypeName(TypeName, Res);
+    TheModule.addTypeName(GetTagTypeName(TD, T), Res);
     return Res;
   }
 
   case Type::BlockPointer: {
     const QualType FTy = cast<BlockPointerType>(Ty).getPointeeType();
-    llvm::OpaqueType *PointeeType = llvm::OpaqueType::get(getLLVMContext());
-    PointersToResolve.push_back(std::make_pair(FTy, PointeeType));
-    return llvm::PointerType::get(PointeeType, FTy.getAddressSpace());
+    return llvm::PointerType::get(ConvertPointeeType(FTy),
+                                  FTy.getAddressSpace());
   }
 
   case Type::MemberPointer: {
@@ -407,8 +462,19 @@ const llvm::Type *CodeGenTypes::ConvertTagDeclType(const TagDecl *TD) {
     TagDeclTypes.find(Key);
 
   // If we've already compiled this tag type, use the previous definition.
-  if (TDTI != TagDeclTypes.end())
-    return TDTI->second;
+  if (TDTI != TagDeclTypes.end()) {
+    if (!LazyRecordTypes.erase(Key))
+      return TDTI->second;
+
+    // The body of a record that was only pointed to is needed now; lay it
+    // out and refine the opaque type standing for it.
+    llvm::PATypeHolder OpaqueHolder = TDTI->second;
+    TagDeclTypes.erase(TDTI);
+    const llvm::Type *NT = ConvertTagDeclType(TD);
+    cast<llvm::OpaqueType>(OpaqueHolder.get())->refineAbstractTypeTo(NT);
+    ++NumRefinements;
+    return OpaqueHolder.get();
+  }
 
   // If this is still a forward declaration, just define an opaque
   // type to use for this tagged decl.
@@ -451,11 +517,13 @@ const llvm::Type *CodeGenTypes::ConvertTagDeclType(const TagDecl *TD) {
 
   CGRecordLayouts[Key] = Layout;
   const llvm::Type *ResultType = Layout->getLLVMType();
+  ++NumRecordLayouts;
 
   // Refine our Opaque type to ResultType.  This can invalidate ResultType, so
   // make sure to read the result out of the holder.
   cast<llvm::OpaqueType>(ResultHolder.get())
     ->refineAbstractTypeTo(ResultType);
+  ++NumRefinements;
 
   return ResultHolder.get();
 }
@@ -466,6 +534,10 @@ unsigned CodeGenTypes::getLLVMFieldNo(const FieldDecl *FD) {
   assert(!FD->isBitField() && "Don't use getLLVMFieldNo on bit fields!");
 
   llvm::DenseMap<const FieldDecl*, unsigned>::iterator I = FieldInfo.find(FD);
+  if (I == FieldInfo.end()) {
+    ConvertTagDeclType(FD->getParent());
+    I = FieldInfo.find(FD);
+  }
   assert (I != FieldInfo.end()  && "Unable to find field info");
   return I->second;
 }
@@ -479,6 +551,10 @@ void CodeGenTypes::addFieldInfo(const FieldDecl *FD, unsigned No) {
 CodeGenTypes::BitFieldInfo CodeGenTypes::getBitFieldInfo(const FieldDecl *FD) {
   llvm::DenseMap<const FieldDecl *, BitFieldInfo>::iterator
     I = BitFields.find(FD);
+  if (I == BitFields.end()) {
+    ConvertTagDeclType(FD->getParent());
+    I = BitFields.find(FD);
+  }
   assert (I != BitFields.end()  && "Unable to find bitfield info");
   return I->second;
 }
@@ -491,8 +567,10 @@ void CodeGenTypes::addBitFieldInfo(const FieldDecl *FD, unsigned FieldNo,
 
 /// getCGRecordLayout - Return record layout info for the given llvm::Type.
 const CGRecordLayout &
-CodeGenTypes::getCGRecordLayout(const TagDecl *TD) const {
+CodeGenTypes::getCGRecordLayout(const TagDecl *TD) {
   const Type *Key = Context.getTagDeclType(TD).getTypePtr();
+  if (LazyRecordTypes.count(Key))
+    ConvertTagDeclType(TD);
   llvm::DenseMap<const Type*, CGRecordLayout *>::const_iterator I
     = CGRecordLayouts.find(Key);
   assert (I != CGRecordLayouts.end()
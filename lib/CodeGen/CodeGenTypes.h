@@ -16,6 +16,7 @@
 
 #include "llvm/Module.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include <vector>
 
@@ -116,6 +117,21 @@ class CodeGenTypes {
   /// FunctionInfos - Hold memoized CGFunctionInfo results.
   llvm::FoldingSet<CGFunctionInfo> FunctionInfos;
 
+  /// FunctionInfoAllocator - Owns the CGFunctionInfos in FunctionInfos.
+  llvm::BumpPtrAllocator FunctionInfoAllocator;
+
+  /// LazyRecords - Whether a record that is only pointed to is converted to
+  /// an opaque type, and only laid out once its body is needed.
+  bool LazyRecords;
+
+  /// LazyRecordTypes - The records whose entry in TagDeclTypes is an opaque
+  /// type standing for a definition that has not been laid out yet.
+  llvm::SmallPtrSet<const Type*, 16> LazyRecordTypes;
+
+  /// Statistics about type conversion, for -print-stats.
+  unsigned NumConversions, NumPointeesReused, NumPointeesDeferred;
+  unsigned NumRecordLayouts, NumLazyRecords, NumRefinements;
+
 public:
   struct BitFieldInfo {
     BitFieldInfo(unsigned FieldNo,
@@ -142,11 +158,20 @@ private:
   /// is available only for ConvertType(). CovertType() is preferred
   /// interface to convert type T into a llvm::Type.
   const llvm::Type *ConvertNewType(QualType T);
+
+  /// ConvertPointeeType - Convert the pointee type T of a pointer, reference
+  /// or block pointer type.  A type that has not been converted yet may be
+  /// part of a cycle, so it is left to an opaque type that ConvertType
+  /// resolves once the outermost type is done.
+  const llvm::Type *ConvertPointeeType(QualType T);
 public:
   CodeGenTypes(ASTContext &Ctx, llvm::Module &M, const llvm::TargetData &TD,
-               const ABIInfo &Info);
+               const ABIInfo &Info, bool LazyRecords = false);
   ~CodeGenTypes();
 
+  /// PrintStats - Print statistics about type conversion.
+  void PrintStats() const;
+
   const llvm::TargetData &getTargetData() const { return TheTargetData; }
   const TargetInfo &getTarget() const { return Target; }
   ASTContext &getContext() const { return Context; }
@@ -174,7 +199,9 @@ public:
   /// and/or incomplete argument types, this will return the opaque type.
   const llvm::Type *GetFunctionTypeForVtable(const CXXMethodDecl *MD);
                                                      
-  const CGRecordLayout &getCGRecordLayout(const TagDecl*) const;
+  /// getCGRecordLayout - Return the record layout info of \arg TD, laying it
+  /// out first if it has only been pointed to so far.
+  const CGRecordLayout &getCGRecordLayout(const TagDecl *TD);
 
   /// getLLVMFieldNo - Return llvm::StructType element number
   /// that corresponds to the field FD.
@@ -57,6 +57,14 @@ namespace {
       TD.reset(new llvm::TargetData(Ctx->Target.getTargetDescription()));
       Builder.reset(new CodeGen::CodeGenModule(Context, CodeGenOpts,
                                                *M, *TD, Diags));
+
+      // In C, nothing looks at the body of a function once its code has been
+      // generated.  C++ and Objective-C revisit bodies, to instantiate
+      // templates or synthesize methods, so they keep them.
+      if (CodeGenOpts.ReleaseFunctionBodies &&
+          !Context.getLangOptions().CPlusPlus &&
+          !Context.getLangOptions().ObjC1)
+        Context.setReleaseFunctionBodies(true);
     }
 
     virtual void HandleTopLevelDecl(DeclGroupRef DG) {
@@ -89,6 +97,11 @@ namespace {
 
       Builder->EmitTentativeDefinition(D);
     }
+
+    virtual void PrintStats() {
+      if (Builder)
+        Builder->getTypes().PrintStats();
+    }
   };
 }
 
@@ -286,6 +286,10 @@ class X86_32ABIInfo : public ABIInfo {
   bool IsDarwinVectorABI;
   bool IsSmallStructInRegABI;
 
+  /// ReturnInfos, ArgumentInfos - The classifications of the return and
+  /// argument types seen so far.
+  mutable ABIArgInfoCache ReturnInfos, ArgumentInfos;
+
   static bool isRegisterSize(unsigned Size) {
     return (Size == 8 || Size == 16 || Size == 32 || Size == 64);
   }
@@ -305,13 +309,7 @@ public:
                                   llvm::LLVMContext &VMContext) const;
 
   virtual void computeInfo(CGFunctionInfo &FI, ASTContext &Context,
-                           llvm::LLVMContext &VMContext) const {
-    FI.getReturnInfo() = classifyReturnType(FI.getReturnType(), Context,
-                                            VMContext);
-    for (CGFunctionInfo::arg_iterator it = FI.arg_begin(), ie = FI.arg_end();
-         it != ie; ++it)
-      it->info = classifyArgumentType(it->type, Context, VMContext);
-  }
+                           llvm::LLVMContext &VMContext) const;
 
   virtual llvm::Value *EmitVAArg(llvm::Value *VAListAddr, QualType Ty,
                                  CodeGenFunction &CGF) const;
@@ -491,6 +489,23 @@ unsigned X86_32ABIInfo::getIndirectArgumentAlignment(QualType Ty,
   return 0;
 }
 
+void X86_32ABIInfo::computeInfo(CGFunctionInfo &FI, ASTContext &Context,
+                                llvm::LLVMContext &VMContext) const {
+  QualType RetTy = FI.getReturnType();
+  if (!ReturnInfos.lookup(RetTy, FI.getReturnInfo())) {
+    FI.getReturnInfo() = classifyReturnType(RetTy, Context, VMContext);
+    ReturnInfos.insert(RetTy, FI.getReturnInfo());
+  }
+
+  for (CGFunctionInfo::arg_iterator it = FI.arg_begin(), ie = FI.arg_end();
+       it != ie; ++it) {
+    if (!ArgumentInfos.lookup(it->type, it->info)) {
+      it->info = classifyArgumentType(it->type, Context, VMContext);
+      ArgumentInfos.insert(it->type, it->info);
+    }
+  }
+}
+
 ABIArgInfo X86_32ABIInfo::classifyArgumentType(QualType Ty,
                                                ASTContext &Context,
                                            llvm::LLVMContext &VMContext) const {
@@ -582,6 +597,20 @@ class X86_64ABIInfo : public ABIInfo {
     Memory
   };
 
+  /// ArgumentInfo - The classification of an argument type, with the number
+  /// of integer and SSE registers it needs.
+  struct ArgumentInfo {
+    ABIArgInfo Info;
+    unsigned NeededInt;
+    unsigned NeededSSE;
+  };
+
+  /// ReturnInfos, ArgumentInfos - The classifications of the return and
+  /// argument types seen so far; the latter are keyed by
+  /// ABIArgInfoCache::getKey.
+  mutable ABIArgInfoCache ReturnInfos;
+  mutable llvm::DenseMap<const Type *, ArgumentInfo> ArgumentInfos;
+
   /// merge - Implement the X86_64 ABI merging algorithm.
   ///
   /// Merge an accumulating classification \arg Accum with a field
@@ -645,6 +674,12 @@ class X86_64ABIInfo : public ABIInfo {
                                   unsigned &neededInt,
                                   unsigned &neededSSE) const;
 
+  /// getArgumentInfo - Like classifyArgumentType, but only classifies each
+  /// type once.
+  ABIArgInfo getArgumentInfo(QualType Ty, ASTContext &Context,
+                             llvm::LLVMContext &VMContext,
+                             unsigned &neededInt, unsigned &neededSSE) const;
+
 public:
   virtual void computeInfo(CGFunctionInfo &FI, ASTContext &Context,
                            llvm::LLVMContext &VMContext) const;
@@ -1190,10 +1225,38 @@ ABIArgInfo X86_64ABIInfo::classifyArgumentType(QualType Ty, ASTContext &Context,
   return getCoerceResult(Ty, ResType, Context);
 }
 
+ABIArgInfo X86_64ABIInfo::getArgumentInfo(QualType Ty, ASTContext &Context,
+                                          llvm::LLVMContext &VMContext,
+                                          unsigned &neededInt,
+                                          unsigned &neededSSE) const {
+  const Type *Key = ABIArgInfoCache::getKey(Ty);
+  if (Key) {
+    llvm::DenseMap<const Type *, ArgumentInfo>::iterator
+      it = ArgumentInfos.find(Key);
+    if (it != ArgumentInfos.end()) {
+      neededInt = it->second.NeededInt;
+      neededSSE = it->second.NeededSSE;
+      return it->second.Info;
+    }
+  }
+
+  ArgumentInfo AI;
+  AI.Info = classifyArgumentType(Ty, Context, VMContext, AI.NeededInt,
+                                 AI.NeededSSE);
+  if (Key)
+    ArgumentInfos[Key] = AI;
+  neededInt = AI.NeededInt;
+  neededSSE = AI.NeededSSE;
+  return AI.Info;
+}
+
 void X86_64ABIInfo::computeInfo(CGFunctionInfo &FI, ASTContext &Context,
                                 llvm::LLVMContext &VMContext) const {
-  FI.getReturnInfo() = classifyReturnType(FI.getReturnType(),
-                                          Context, VMContext);
+  QualType RetTy = FI.getReturnType();
+  if (!ReturnInfos.lookup(RetTy, FI.getReturnInfo())) {
+    FI.getReturnInfo() = classifyReturnType(RetTy, Context, VMContext);
+    ReturnInfos.insert(RetTy, FI.getReturnInfo());
+  }
 
   // Keep track of the number of assigned registers.
   unsigned freeIntRegs = 6, freeSSERegs = 8;
@@ -1208,8 +1271,8 @@ void X86_64ABIInfo::computeInfo(CGFunctionInfo &FI, ASTContext &Context,
   for (CGFunctionInfo::arg_iterator it = FI.arg_begin(), ie = FI.arg_end();
        it != ie; ++it) {
     unsigned neededInt, neededSSE;
-    it->info = classifyArgumentType(it->type, Context, VMContext,
-                                    neededInt, neededSSE);
+    it->info = getArgumentInfo(it->type, Context, VMContext,
+                               neededInt, neededSSE);
 
     // AMD64-ABI 3.2.3p3: If there are no registers available for any
     // eightbyte of an argument, the whole argument is passed on the
@@ -1535,6 +1598,10 @@ public:
 private:
   ABIKind Kind;
 
+  /// ReturnInfos, ArgumentInfos - The classifications of the return and
+  /// argument types seen so far.
+  mutable ABIArgInfoCache ReturnInfos, ArgumentInfos;
+
 public:
   ARMABIInfo(ABIKind _Kind) : Kind(_Kind) {}
 
@@ -1566,11 +1633,18 @@ public:
 
 void ARMABIInfo::computeInfo(CGFunctionInfo &FI, ASTContext &Context,
                              llvm::LLVMContext &VMContext) const {
-  FI.getReturnInfo() = classifyReturnType(FI.getReturnType(), Context,
-                                          VMContext);
+  QualType RetTy = FI.getReturnType();
+  if (!ReturnInfos.lookup(RetTy, FI.getReturnInfo())) {
+    FI.getReturnInfo() = classifyReturnType(RetTy, Context, VMContext);
+    ReturnInfos.insert(RetTy, FI.getReturnInfo());
+  }
+
   for (CGFunctionInfo::arg_iterator it = FI.arg_begin(), ie = FI.arg_end();
        it != ie; ++it) {
-    it->info = classifyArgumentType(it->type, Context, VMContext);
+    if (!ArgumentInfos.lookup(it->type, it->info)) {
+      it->info = classifyArgumentType(it->type, Context, VMContext);
+      ArgumentInfos.insert(it->type, it->info);
+    }
   }
 
   // ARM always overrides the calling convention.
@@ -14,18 +14,29 @@
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
+#include "clang/Driver/Tool.h"
 #include "clang/Driver/ToolChain.h"
 
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Program.h"
+#include <deque>
 #include <sys/stat.h>
 #include <errno.h>
+#ifdef LLVM_ON_WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
 using namespace clang::driver;
 
 Compilation::Compilation(const Driver &D,
                          const ToolChain &_DefaultToolChain,
                          InputArgList *_Args)
-  : TheDriver(D), DefaultToolChain(_DefaultToolChain), Args(_Args) {
+  : TheDriver(D), DefaultToolChain(_DefaultToolChain), Args(_Args),
+    RanCC1InProcess(false) {
 }
 
 Compilation::~Compilation() {
@@ -115,17 +126,94 @@ bool Compilation::CleanupFileList(const ArgStringList &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
-  llvm::sys::Path Prog(C.getExecutable());
+/// BuildArgv - Build the null terminated argument vector for a command. The
+/// caller owns the result.
+static const char **BuildArgv(const Command &C) {
   const char **Argv = new const char*[C.getArguments().size() + 2];
   Argv[0] = C.getExecutable();
   std::copy(C.getArguments().begin(), C.getArguments().end(), Argv+1);
   Argv[C.getArguments().size() + 1] = 0;
+  return Argv;
+}
+
+static int ChangeDirectory(const char *Dir) {
+#ifdef LLVM_ON_WIN32
+  return ::_chdir(Dir);
+#else
+  return ::chdir(Dir);
+#endif
+}
+
+/// EnterCommandDirectory - Make the directory of rg C, if it has one, the
+/// working directory while it is started, saving the previous one in
+/// rg Saved.
+///
+/// 
+eturn True, after reporting an error, if the directory cannot be
+/// entered.
+static bool EnterCommandDirectory(const Driver &D, const Command &C,
+                                  std::string &Saved) {
+  Saved.clear();
+  if (!C.getDirectory())
+    return false;
+
+  Saved = llvm::sys::Path::GetCurrentDirectory().str();
+  if (ChangeDirectory(C.getDirectory()) == 0)
+    return false;
+
+  D.Diag(clang::diag::err_drv_command_failure)
+    << std::string("cannot enter directory '") + C.getDirectory() + "'";
+  Saved.clear();
+  return true;
+}
+
+/// LeaveCommandDirectory - Return to the working directory saved by
+/// EnterCommandDirectory.
+static void LeaveCommandDirectory(const std::string &Saved) {
+  if (!Saved.empty())
+    ChangeDirectory(Saved.c_str());
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  std::string SavedDirectory;
+  if (EnterCommandDirectory(getDriver(), C, SavedDirectory)) {
+    FailingCommand = &C;
+    return 1;
+  }
+
+  int Res = ExecuteCommandInDirectory(C, FailingCommand);
+  LeaveCommandDirectory(SavedDirectory);
+  return Res;
+}
+
+int Compilation::ExecuteCommandInDirectory(const Command &C,
+                                           const Command *&FailingCommand)
+                                           const {
+  llvm::sys::Path Prog(C.getExecutable());
+  const char **Argv = BuildArgv(C);
 
   if (getDriver().CCCEcho || getArgs().hasArg(options::OPT_v))
     PrintJob(llvm::errs(), C, "\n", false);
 
+  // With -ccc-integrated-cc1, call into clang -cc1 instead of starting it
+  // again.  Only the first such command runs in process: the compiler leaves
+  // global state behind, such as the occurrences of LLVM command line
+  // options, and a crash takes the driver down with it.
+  const ArgStringList &CmdArgs = C.getArguments();
+  if (getDriver().CCCIntegratedCC1 && getDriver().CC1Main &&
+      !RanCC1InProcess &&
+      llvm::StringRef(C.getCreator().getName()) == "clang" &&
+      !CmdArgs.empty() && llvm::StringRef(CmdArgs[0]) == "-cc1") {
+    RanCC1InProcess = true;
+    int Res = getDriver().CC1Main(Argv + 2, Argv + CmdArgs.size() + 1);
+    if (Res)
+      FailingCommand = &C;
+
+    delete[] Argv;
+    return Res;
+  }
+
   std::string Error;
   int Res =
     llvm::sys::Program::ExecuteAndWait(Prog, Argv,
@@ -144,6 +232,148 @@ int Compilation::ExecuteCommand(const Command &C,
   return Res;
 }
 
+/// CollectActions - Add A and the actions it is built from to Actions.
+static void CollectActions(const Action *A,
+                           llvm::SmallPtrSet<const Action*, 16> &Actions) {
+  if (!Actions.insert(A))
+    return;
+
+  for (Action::const_iterator it = A->begin(), ie = A->end(); it != ie; ++it)
+    CollectActions(*it, Actions);
+}
+
+namespace {
+/// RunningCommand - A command started by ExecuteCommandsInParallel.
+struct RunningCommand {
+  unsigned Index;
+  llvm::sys::Program *Program;
+
+  /// ErrorFile - The file holding the standard error of the command, which
+  /// is empty if the command writes to the standard error directly.
+  std::string ErrorFile;
+};
+}
+
+int Compilation::ExecuteCommandsInParallel(const JobList &Jobs,
+                                           unsigned MaxParallel,
+                                           const Command *&FailingCommand)
+                                           const {
+  // A command depends on the earlier commands whose actions it is built
+  // from, directly or not.  It also waits for the earlier precompiled
+  // headers, which it may include without saying so.
+  std::vector<const Command*> Commands;
+  std::vector<std::vector<unsigned> > Deps;
+  for (JobList::const_iterator it = Jobs.begin(), ie = Jobs.end(); it != ie;
+       ++it) {
+    const Command *C = cast<Command>(*it);
+    llvm::SmallPtrSet<const Action*, 16> Actions;
+    CollectActions(&C->getSource(), Actions);
+
+    Deps.push_back(std::vector<unsigned>());
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      if (Actions.count(&Commands[i]->getSource()) ||
+          isa<PrecompileJobAction>(Commands[i]->getSource()))
+        Deps.back().push_back(i);
+    Commands.push_back(C);
+  }
+
+  std::vector<bool> Finished(Commands.size());
+  std::deque<RunningCommand> Running;
+  unsigned Next = 0, End = Commands.size();
+  int Res = 0;
+
+  while (true) {
+    // Start commands in order until enough are running or the next one waits
+    // for the results of a running one, unless one has failed.
+    while (!Res && Next != End && Running.size() < MaxParallel) {
+      const std::vector<unsigned> &D = Deps[Next];
+      bool Ready = true;
+      for (unsigned i = 0, e = D.size(); Ready && i != e; ++i)
+        Ready = Finished[D[i]];
+      if (!Ready)
+        break;
+
+      const Command &C = *Commands[Next];
+      const char **Argv = BuildArgv(C);
+
+      if (getDriver().CCCEcho || getArgs().hasArg(options::OPT_v))
+        PrintJob(llvm::errs(), C, "\n", false);
+
+      // Unless it is the only command, buffer the standard error of the
+      // command so that the diagnostics of concurrent commands are printed
+      // in order, and not interleaved.
+      RunningCommand R;
+      R.Index = Next;
+      llvm::sys::Path ErrorPath;
+      const llvm::sys::Path *Redirects[3] = { 0, 0, 0 };
+      if (End > 1) {
+        R.ErrorFile = getDriver().GetTemporaryPath("txt");
+        ErrorPath = llvm::sys::Path(R.ErrorFile);
+        Redirects[2] = &ErrorPath;
+      }
+
+      // The command inherits the working directory when it is started.
+      std::string Error, SavedDirectory;
+      bool Started = false;
+      R.Program = new llvm::sys::Program();
+      if (!EnterCommandDirectory(getDriver(), C, SavedDirectory)) {
+        Started = R.Program->Execute(llvm::sys::Path(C.getExecutable()),
+                                     Argv, /*env*/0, Redirects,
+                                     /*memoryLimit*/0, &Error);
+        if (!Started)
+          getDriver().Diag(clang::diag::err_drv_command_failure) << Error;
+        LeaveCommandDirectory(SavedDirectory);
+      }
+      delete[] Argv;
+      if (!Started) {
+        delete R.Program;
+        if (!R.ErrorFile.empty())
+          ErrorPath.eraseFromDisk();
+        Res = 1;
+        FailingCommand = &C;
+        break;
+      }
+      Running.push_back(R);
+      ++Next;
+    }
+
+    if (Running.empty())
+      break;
+
+    // Wait for the commands in the order they were started, so the first
+    // failure seen is the first one in the list, and the diagnostics are
+    // printed in the order of the list.
+    RunningCommand R = Running.front();
+    Running.pop_front();
+    const Command &C = *Commands[R.Index];
+
+    std::string Error;
+    int CmdRes = R.Program->Wait(llvm::sys::Path(C.getExecutable()),
+                                 /*secondsToWait*/0, &Error);
+    delete R.Program;
+    Finished[R.Index] = true;
+
+    if (!R.ErrorFile.empty()) {
+      if (llvm::MemoryBuffer *Buf =
+            llvm::MemoryBuffer::getFile(R.ErrorFile.c_str())) {
+        llvm::errs().write(Buf->getBufferStart(), Buf->getBufferSize());
+        delete Buf;
+      }
+      llvm::sys::Path(R.ErrorFile).eraseFromDisk();
+    }
+
+    if (!Error.empty())
+      getDriver().Diag(clang::diag::err_drv_command_failure) << Error;
+
+    if (CmdRes && !Res) {
+      Res = CmdRes;
+      FailingCommand = &C;
+    }
+  }
+
+  return Res;
+}
+
 int Compilation::ExecuteJob(const Job &J,
                             const Command *&FailingCommand) const {
   if (const Command *C = dyn_cast<Command>(&J)) {
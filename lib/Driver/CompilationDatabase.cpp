@@ -0,0 +1,250 @@
+//===--- CompilationDatabase.cpp - Recorded Compiler Commands -----------*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Driver/CompilationDatabase.h"
+
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+using namespace clang::driver;
+
+static void WriteJSONString(llvm::raw_ostream &OS, llvm::StringRef Str) {
+  OS << '"';
+  for (unsigned i = 0, e = Str.size(); i != e; ++i) {
+    unsigned char C = Str[i];
+    switch (C) {
+    case '"':  OS << "\\\""; break;
+    case '\\': OS << "\\\\"; break;
+    case '\n': OS << "\\n"; break;
+    case '\r': OS << "\\r"; break;
+    case '\t': OS << "\\t"; break;
+    default:
+      if (C < 0x20) {
+        char Escape[8];
+        snprintf(Escape, sizeof(Escape), "\\u%04x", C);
+        OS << Escape;
+      } else
+        OS << char(C);
+    }
+  }
+  OS << '"';
+}
+
+static void WriteJSONStrings(llvm::raw_ostream &OS,
+                             const std::vector<std::string> &Strs) {
+  OS << '[';
+  for (unsigned i = 0, e = Strs.size(); i != e; ++i) {
+    if (i)
+      OS << ", ";
+    WriteJSONString(OS, Strs[i]);
+  }
+  OS << ']';
+}
+
+void clang::driver::WriteCompilationDatabaseEntry(
+                                     llvm::raw_ostream &OS,
+                                     const CompilationDatabaseEntry &Entry) {
+  OS << "{\"directory\": ";
+  WriteJSONString(OS, Entry.Directory);
+  OS << ", \"executable\": ";
+  WriteJSONString(OS, Entry.Executable);
+  OS << ", \"arguments\": ";
+  WriteJSONStrings(OS, Entry.Arguments);
+  OS << ", \"inputs\": ";
+  WriteJSONStrings(OS, Entry.Inputs);
+  OS << ", \"output\": ";
+  WriteJSONString(OS, Entry.Output);
+  OS << "}\n";
+}
+
+namespace {
+/// EntryParser - Parse a line of a compilation database.  Only the subset of
+/// JSON used by the entries is accepted: an object whose values are strings
+/// or arrays of strings.
+class EntryParser {
+  llvm::StringRef Line;
+  unsigned Pos;
+
+public:
+  explicit EntryParser(llvm::StringRef _Line) : Line(_Line), Pos(0) {}
+
+  bool ParseEntry(CompilationDatabaseEntry &Entry);
+
+private:
+  void SkipSpace() {
+    while (Pos != Line.size() && (Line[Pos] == ' ' || Line[Pos] == '\t' ||
+                                  Line[Pos] == '\r'))
+      ++Pos;
+  }
+
+  bool Consume(char C) {
+    SkipSpace();
+    if (Pos == Line.size() || Line[Pos] != C)
+      return false;
+    ++Pos;
+    return true;
+  }
+
+  bool ParseHexDigits(unsigned &Value);
+  bool ParseString(std::string &Str);
+  bool ParseStrings(std::vector<std::string> &Strs);
+};
+}
+
+bool EntryParser::ParseHexDigits(unsigned &Value) {
+  if (Line.size() - Pos < 4)
+    return false;
+  Value = 0;
+  for (unsigned i = 0; i != 4; ++i) {
+    char C = Line[Pos++];
+    Value <<= 4;
+    if (C >= '0' && C <= '9')
+      Value |= C - '0';
+    else if (C >= 'a' && C <= 'f')
+      Value |= C - 'a' + 10;
+    else if (C >= 'A' && C <= 'F')
+      Value |= C - 'A' + 10;
+    else
+      return false;
+  }
+  return true;
+}
+
+bool EntryParser::ParseString(std::string &Str) {
+  if (!Consume('"'))
+    return false;
+
+  Str.clear();
+  while (Pos != Line.size()) {
+    char C = Line[Pos++];
+    if (C == '"')
+      return true;
+    if (C != '\\') {
+      Str += C;
+      continue;
+    }
+
+    if (Pos == Line.size())
+      return false;
+    switch (Line[Pos++]) {
+    case '"':  Str += '"'; break;
+    case '\\': Str += '\\'; break;
+    case '/':  Str += '/'; break;
+    case 'b':  Str += '\b'; break;
+    case 'f':  Str += '\f'; break;
+    case 'n':  Str += '\n'; break;
+    case 'r':  Str += '\r'; break;
+    case 't':  Str += '\t'; break;
+    case 'u': {
+      // Encode the code point in UTF-8; surrogates are not combined.
+      unsigned Value;
+      if (!ParseHexDigits(Value))
+        return false;
+      if (Value < 0x80)
+        Str += char(Value);
+      else if (Value < 0x800) {
+        Str += char(0xC0 | (Value >> 6));
+        Str += char(0x80 | (Value & 0x3F));
+      } else {
+        Str += char(0xE0 | (Value >> 12));
+        Str += char(0x80 | ((Value >> 6) & 0x3F));
+        Str += char(0x80 | (Value & 0x3F));
+      }
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return false;
+}
+
+bool EntryParser::ParseStrings(std::vector<std::string> &Strs) {
+  if (!Consume('['))
+    return false;
+
+  Strs.clear();
+  if (Consume(']'))
+    return true;
+  do {
+    Strs.push_back(std::string());
+    if (!ParseString(Strs.back()))
+      return false;
+  } while (Consume(','));
+  return Consume(']');
+}
+
+bool EntryParser::ParseEntry(CompilationDatabaseEntry &Entry) {
+  if (!Consume('{'))
+    return false;
+
+  if (!Consume('}')) {
+    do {
+      std::string Key;
+      if (!ParseString(Key) || !Consume(':'))
+        return false;
+
+      if (Key == "arguments" || Key == "inputs") {
+        std::vector<std::string> &Strs =
+          Key == "arguments" ? Entry.Arguments : Entry.Inputs;
+        if (!ParseStrings(Strs))
+          return false;
+        continue;
+      }
+
+      std::vector<std::string> Ignored;
+      std::string Value;
+      SkipSpace();
+      if (Pos != Line.size() && Line[Pos] == '[') {
+        if (!ParseStrings(Ignored))
+          return false;
+      } else if (!ParseString(Value))
+        return false;
+
+      if (Key == "directory")
+        Entry.Directory = Value;
+      else if (Key == "executable")
+        Entry.Executable = Value;
+      else if (Key == "output")
+        Entry.Output = Value;
+    } while (Consume(','));
+
+    if (!Consume('}'))
+      return false;
+  }
+
+  SkipSpace();
+  return Pos == Line.size();
+}
+
+static bool IsBlank(llvm::StringRef Line) {
+  for (unsigned i = 0, e = Line.size(); i != e; ++i)
+    if (Line[i] != ' ' && Line[i] != '\t' && Line[i] != '\r')
+      return false;
+  return true;
+}
+
+bool clang::driver::ParseCompilationDatabase(
+                                llvm::StringRef Buffer,
+                                std::vector<CompilationDatabaseEntry> &Entries,
+                                unsigned &ErrorLine) {
+  for (unsigned LineNo = 1; !Buffer.empty(); ++LineNo) {
+    std::pair<llvm::StringRef, llvm::StringRef> Split = Buffer.split('\n');
+    Buffer = Split.second;
+    if (IsBlank(Split.first))
+      continue;
+
+    CompilationDatabaseEntry Entry;
+    if (!EntryParser(Split.first).ParseEntry(Entry)) {
+      ErrorLine = LineNo;
+      return true;
+    }
+    Entries.push_back(Entry);
+  }
+  return false;
+}
@@ -12,21 +12,26 @@
 #include "clang/Driver/Action.h"
 #include "clang/Driver/Arg.h"
 #include "clang/Driver/ArgList.h"
+#include "clang/Driver/CC1Options.h"
 #include "clang/Driver/Compilation.h"
+#include "clang/Driver/CompilationDatabase.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/HostInfo.h"
 #include "clang/Driver/Job.h"
 #include "clang/Driver/OptTable.h"
 #include "clang/Driver/Option.h"
 #include "clang/Driver/Options.h"
+#include "clang/Driver/PathProbeCache.h"
 #include "clang/Driver/Tool.h"
 #include "clang/Driver/ToolChain.h"
 #include "clang/Driver/Types.h"
 
 #include "clang/Basic/Version.h"
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Path.h"
@@ -34,6 +39,7 @@
 
 #include "InputInfo.h"
 
+#include <cstdlib> // ::getenv
 #include <map>
 
 using namespace clang::driver;
@@ -51,9 +57,10 @@ Driver::Driver(llvm::StringRef _Name, llvm::StringRef _Dir,
     DefaultImageName(_DefaultImageName),
     Host(0),
     CCCGenericGCCName("gcc"), CCCIsCXX(false), CCCEcho(false),
-    CCCPrintBindings(false), CheckInputsExist(true), CCCUseClang(true),
+    CCCPrintBindings(false), CCCIntegratedCC1(false), CC1Main(0),
+    CheckInputsExist(true), CCCUseClang(true),
     CCCUseClangCXX(true), CCCUseClangCPP(true), CCCUsePCH(true),
-    SuppressMissingInputWarning(false) {
+    SuppressMissingInputWarning(false), NumParallelJobs(1), ProbeCache(0) {
   if (IsProduction) {
     // In a "production" build, only use clang on architectures we expect to
     // work, and don't use clang C++.
@@ -75,11 +82,18 @@ Driver::Driver(llvm::StringRef _Name, llvm::StringRef _Dir,
   P.appendComponent("clang");
   P.appendComponent(CLANG_VERSION_STRING);
   ResourceDir = P.str();
+
+  // Tool chain roots on slow file systems can have the probes of their paths
+  // remembered across invocations.
+  if (const char *CacheFile = ::getenv("CCC_PATH_CACHE"))
+    if (*CacheFile)
+      ProbeCache = new PathProbeCache(CacheFile);
 }
 
 Driver::~Driver() {
   delete Opts;
   delete Host;
+  delete ProbeCache;
 }
 
 InputArgList *Driver::ParseArgStrings(const char **ArgBegin,
@@ -138,6 +152,15 @@ Compilation *Driver::BuildCompilation(int argc, const char **argv) {
   CCCPrintBindings = Args->hasArg(options::OPT_ccc_print_bindings);
   CCCIsCXX = Args->hasArg(options::OPT_ccc_cxx) || CCCIsCXX;
   CCCEcho = Args->hasArg(options::OPT_ccc_echo);
+  CCCIntegratedCC1 = Args->hasArg(options::OPT_ccc_integrated_cc1);
+  if (const Arg *A = Args->getLastArg(options::OPT_j)) {
+    llvm::StringRef Value = A->getValue(*Args);
+    if (Value.getAsInteger(10, NumParallelJobs) || NumParallelJobs == 0) {
+      Diag(clang::diag::err_drv_invalid_int_value)
+        << A->getAsString(*Args) << Value;
+      NumParallelJobs = 1;
+    }
+  }
   if (const Arg *A = Args->getLastArg(options::OPT_ccc_gcc_name))
     CCCGenericGCCName = A->getValue(*Args);
   CCCUseClangCXX = Args->hasFlag(options::OPT_ccc_clang_cxx,
@@ -186,6 +209,12 @@ Compilation *Driver::BuildCompilation(int argc, const char **argv) {
   if (!HandleImmediateArgs(*C))
     return C;
 
+  // Run the commands of a compilation database instead of compiling inputs.
+  if (const Arg *A = C->getArgs().getLastArg(options::OPT_ccc_run_commands)) {
+    BuildJobsFromDatabase(*C, *A);
+    return C;
+  }
+
   // Construct the list of abstract actions to perform for this compilation. We
   // avoid passing a Compilation here simply to enforce the abstraction that
   // pipelining is not host or toolchain dependent (other than the driver driver
@@ -216,8 +245,23 @@ int Driver::ExecuteCompilation(const Compilation &C) const {
   if (getDiags().getNumErrors())
     return 1;
 
+  if (const Arg *A = C.getArgs().getLastArg(options::OPT_ccc_record_commands))
+    RecordCommands(C, A->getValue(C.getArgs()));
+
+  // The commands that do not use each other's outputs can run at the same
+  // time; piped jobs are always run on their own.
+  bool RunInParallel = NumParallelJobs > 1;
+  for (JobList::const_iterator it = C.getJobs().begin(),
+         ie = C.getJobs().end(); RunInParallel && it != ie; ++it)
+    RunInParallel = isa<Command>(*it);
+
   const Command *FailingCommand = 0;
-  int Res = C.ExecuteJob(C.getJobs(), FailingCommand);
+  int Res;
+  if (RunInParallel)
+    Res = C.ExecuteCommandsInParallel(C.getJobs(), NumParallelJobs,
+                                      FailingCommand);
+  else
+    Res = C.ExecuteJob(C.getJobs(), FailingCommand);
 
   // Remove temp files.
   C.CleanupFileList(C.getTempFiles());
@@ -253,6 +297,224 @@ int Driver::ExecuteCompilation(const Compilation &C) const {
   return Res;
 }
 
+/// CollectCommands - Add the commands of the job \arg J to \arg Commands.
+static void CollectCommands(const Job &J,
+                            std::vector<const Command*> &Commands) {
+  if (const Command *C = dyn_cast<Command>(&J)) {
+    Commands.push_back(C);
+  } else if (const PipedJob *PJ = dyn_cast<PipedJob>(&J)) {
+    for (PipedJob::const_iterator it = PJ->begin(), ie = PJ->end();
+         it != ie; ++it)
+      Commands.push_back(*it);
+  } else {
+    const JobList *Jobs = cast<JobList>(&J);
+    for (JobList::const_iterator it = Jobs->begin(), ie = Jobs->end();
+         it != ie; ++it)
+      CollectCommands(**it, Commands);
+  }
+}
+
+void Driver::RecordCommands(const Compilation &C, const char *File) const {
+  std::vector<const Command*> Commands;
+  CollectCommands(C.getJobs(), Commands);
+
+  std::string WorkingDir = llvm::sys::Path::GetCurrentDirectory().str();
+  llvm::OwningPtr<OptTable> CC1Opts(createCC1OptTable());
+  std::string Records;
+  llvm::raw_string_ostream RecordsOS(Records);
+  for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+    const Command &Cmd = *Commands[i];
+    const ArgStringList &CmdArgs = Cmd.getArguments();
+    if (llvm::StringRef(Cmd.getCreator().getName()) != "clang" ||
+        CmdArgs.empty() || llvm::StringRef(CmdArgs[0]) != "-cc1")
+      continue;
+
+    // Find the inputs and output of the command from its arguments.
+    CompilationDatabaseEntry Entry;
+    unsigned MissingArgIndex, MissingArgCount;
+    llvm::OwningPtr<InputArgList> Args(
+      CC1Opts->ParseArgs((const char**) CmdArgs.begin() + 1,
+                         (const char**) CmdArgs.end(),
+                         MissingArgIndex, MissingArgCount));
+    for (arg_iterator it = Args->filtered_begin(cc1options::OPT_INPUT),
+           ie = Args->filtered_end(); it != ie; ++it)
+      Entry.Inputs.push_back((*it)->getValue(*Args));
+    if (const Arg *A = Args->getLastArg(cc1options::OPT_o))
+      Entry.Output = A->getValue(*Args);
+
+    bool WritesTempFile = false;
+    for (ArgStringList::const_iterator it = C.getTempFiles().begin(),
+           ie = C.getTempFiles().end(); !WritesTempFile && it != ie; ++it)
+      WritesTempFile = Entry.Output == *it;
+    if (WritesTempFile)
+      continue;
+
+    Entry.Directory = Cmd.getDirectory() ? Cmd.getDirectory() : WorkingDir;
+    Entry.Executable = Cmd.getExecutable();
+    Entry.Arguments.assign(CmdArgs.begin(), CmdArgs.end());
+    WriteCompilationDatabaseEntry(RecordsOS, Entry);
+  }
+  RecordsOS.flush();
+  if (Records.empty())
+    return;
+
+  // Write the records at once, so that the records of drivers running at
+  // the same time are not interleaved.
+  std::string Error;
+  llvm::raw_fd_ostream OS(File, Error, llvm::raw_fd_ostream::F_Append);
+  if (!Error.empty()) {
+    Diag(clang::diag::err_drv_unable_to_write_compilation_database)
+      << File << Error;
+    return;
+  }
+  OS.SetUnbuffered();
+  OS << Records;
+}
+
+/// BuildAnalysisArguments - Build the arguments of a clang -cc1 command that
+/// analyzes the sources of the recorded compilation \arg Entry, writing its
+/// reports to \arg ResultsDir.  The analysis options are those of --analyze;
+/// the action of the compilation and the files it writes are left out.
+static void BuildAnalysisArguments(const InputArgList &Args,
+                                   const OptTable &CC1Opts,
+                                   const CompilationDatabaseEntry &Entry,
+                                   const char *ResultsDir, unsigned Index,
+                                   ArgStringList &CmdArgs) {
+  std::vector<const char*> Argv;
+  for (unsigned i = 0, e = Entry.Arguments.size(); i != e; ++i)
+    if (i != 0 || Entry.Arguments[i] != "-cc1")
+      Argv.push_back(Entry.Arguments[i].c_str());
+
+  unsigned MissingArgIndex, MissingArgCount;
+  llvm::OwningPtr<InputArgList> EntryArgs(
+    CC1Opts.ParseArgs(Argv.empty() ? 0 : &Argv[0],
+                      Argv.empty() ? 0 : &Argv[0] + Argv.size(),
+                      MissingArgIndex, MissingArgCount));
+
+  ArgStringList Rendered;
+  for (ArgList::const_iterator it = EntryArgs->begin(), ie = EntryArgs->end();
+       it != ie; ++it) {
+    const Option &O = (*it)->getOption();
+    if (O.matches(cc1options::OPT_Action_Group) ||
+        O.matches(cc1options::OPT_o) ||
+        O.matches(cc1options::OPT_dependency_file) ||
+        O.matches(cc1options::OPT_MT) ||
+        O.matches(cc1options::OPT_MP) ||
+        O.matches(cc1options::OPT_sys_header_deps) ||
+        O.matches(cc1options::OPT_header_manifest) ||
+        O.matches(cc1options::OPT_header_macro_deps))
+      continue;
+    (*it)->render(*EntryArgs, Rendered);
+  }
+
+  CmdArgs.push_back("-cc1");
+  for (unsigned i = 0, e = Rendered.size(); i != e; ++i)
+    CmdArgs.push_back(Args.MakeArgString(Rendered[i]));
+
+  CmdArgs.push_back("-analyze");
+  CmdArgs.push_back("-analyzer-store=region");
+  CmdArgs.push_back("-analyzer-opt-analyze-nested-blocks");
+  if (!Args.hasArg(options::OPT__analyzer_no_default_checks)) {
+    CmdArgs.push_back("-analyzer-check-dead-stores");
+    CmdArgs.push_back("-analyzer-check-security-syntactic");
+    CmdArgs.push_back("-analyzer-check-objc-mem");
+    CmdArgs.push_back("-analyzer-eagerly-assume");
+    CmdArgs.push_back("-analyzer-check-objc-methodsigs");
+    CmdArgs.push_back("-analyzer-check-objc-unused-ivars");
+  }
+
+  // HTML reports go straight into the results directory.  The other formats
+  // write one file per command, which is named after its entry.
+  llvm::StringRef Format = "html";
+  if (Arg *A = Args.getLastArg(options::OPT__analyzer_output))
+    Format = A->getValue(Args);
+  CmdArgs.push_back("-analyzer-output");
+  CmdArgs.push_back(Args.MakeArgString(Format));
+  Args.AddAllArgValues(CmdArgs, options::OPT_Xanalyzer);
+
+  CmdArgs.push_back("-o");
+  if (Format == "html") {
+    CmdArgs.push_back(ResultsDir);
+  } else {
+    llvm::sys::Path Report(ResultsDir);
+    Report.appendComponent("report-" + llvm::utostr(Index) + ".plist");
+    CmdArgs.push_back(Args.MakeArgString(Report.str()));
+  }
+}
+
+void Driver::BuildJobsFromDatabase(Compilation &C, const Arg &A) const {
+  const char *File = A.getValue(C.getArgs());
+  llvm::OwningPtr<llvm::MemoryBuffer> Buffer(
+                                           llvm::MemoryBuffer::getFile(File));
+  if (!Buffer) {
+    Diag(clang::diag::err_drv_no_such_file) << File;
+    return;
+  }
+
+  std::vector<CompilationDatabaseEntry> Entries;
+  unsigned ErrorLine;
+  if (ParseCompilationDatabase(llvm::StringRef(Buffer->getBufferStart(),
+                                               Buffer->getBufferSize()),
+                               Entries, ErrorLine)) {
+    Diag(clang::diag::err_drv_invalid_compilation_database)
+      << File << ErrorLine;
+    return;
+  }
+
+  // The actions of the commands only tell precompiled headers, which later
+  // commands wait for, from other compilations, and pick the clang tool as
+  // their creator.  Their common input is the -ccc-run-commands argument.
+  Action *Input = new InputAction(A, types::TY_PP_C);
+  C.getActions().push_back(Input);
+
+  // With -ccc-analyze-commands, the compilations are analyzed instead, and
+  // the reports of all of them are written to one directory.
+  const InputArgList &Args = C.getArgs();
+  const char *ResultsDir = 0;
+  llvm::OwningPtr<OptTable> CC1Opts;
+  if (const Arg *RA = Args.getLastArg(options::OPT_ccc_analyze_commands)) {
+    ResultsDir = RA->getValue(Args);
+    CC1Opts.reset(createCC1OptTable());
+    std::string Error;
+    if (llvm::sys::Path(ResultsDir).createDirectoryOnDisk(true, &Error)) {
+      Diag(clang::diag::err_drv_unable_to_create_results_dir)
+        << ResultsDir << Error;
+      return;
+    }
+  }
+
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    const CompilationDatabaseEntry &Entry = Entries[i];
+    bool IsPrecompile = false;
+    ArgStringList CmdArgs;
+    for (unsigned j = 0, je = Entry.Arguments.size(); j != je; ++j) {
+      const std::string &Value = Entry.Arguments[j];
+      IsPrecompile |= Value == "-emit-pch" || Value == "-emit-pth";
+      CmdArgs.push_back(Args.MakeArgString(Value));
+    }
+
+    JobAction *JA;
+    if (IsPrecompile) {
+      // Analyses need the precompiled headers of their compilations too.
+      JA = new PrecompileJobAction(Input, types::TY_Nothing);
+    } else if (ResultsDir) {
+      JA = new AnalyzeJobAction(Input, types::TY_Plist);
+      CmdArgs.clear();
+      BuildAnalysisArguments(Args, *CC1Opts, Entry, ResultsDir, i, CmdArgs);
+    } else {
+      JA = new CompileJobAction(Input, types::TY_Nothing);
+    }
+    C.getActions().push_back(JA);
+
+    const Tool &T = C.getDefaultToolChain().SelectTool(C, *JA);
+    Command *Cmd = new Command(*JA, T, Args.MakeArgString(Entry.Executable),
+                               CmdArgs);
+    if (!Entry.Directory.empty())
+      Cmd->setDirectory(Args.MakeArgString(Entry.Directory));
+    C.getJobs().addJob(Cmd);
+  }
+}
+
 void Driver::PrintOptions(const ArgList &Args) const {
   unsigned i = 0;
   for (ArgList::const_iterator it = Args.begin(), ie = Args.end();
@@ -979,7 +1241,10 @@ void Driver::BuildJobsForAction(Compilation &C,
     //
     // FIXME: Is there a better way to handle this?
     if (AtTopLevel) {
-      if (isa<PreprocessJobAction>(A) && !C.getArgs().hasArg(options::OPT_o))
+      // With -j, each of several preprocessed inputs is written to its own
+      // file instead, so they can be preprocessed at the same time.
+      if (isa<PreprocessJobAction>(A) && !C.getArgs().hasArg(options::OPT_o) &&
+          (NumParallelJobs == 1 || C.getActions().size() == 1))
         OutputToPipe = true;
     } else if (UsePipes)
       OutputToPipe = true;
@@ -1089,7 +1354,7 @@ std::string Driver::GetFilePath(const char *Name, const ToolChain &TC) const {
          it = List.begin(), ie = List.end(); it != ie; ++it) {
     llvm::sys::Path P(*it);
     P.appendComponent(Name);
-    if (P.exists())
+    if (PathExists(P.str()))
       return P.str();
   }
 
@@ -1103,7 +1368,7 @@ std::string Driver::GetProgramPath(const char *Name, const ToolChain &TC,
          it = List.begin(), ie = List.end(); it != ie; ++it) {
     llvm::sys::Path P(*it);
     P.appendComponent(Name);
-    if (WantFile ? P.exists() : P.canExecute())
+    if (WantFile ? PathExists(P.str()) : PathCanExecute(P.str()))
       return P.str();
   }
 
@@ -1115,6 +1380,18 @@ std::string Driver::GetProgramPath(const char *Name, const ToolChain &TC,
   return Name;
 }
 
+bool Driver::PathExists(llvm::StringRef Path) const {
+  if (ProbeCache)
+    return ProbeCache->exists(Path);
+  return llvm::sys::Path(Path).exists();
+}
+
+bool Driver::PathCanExecute(llvm::StringRef Path) const {
+  if (ProbeCache)
+    return ProbeCache->canExecute(Path);
+  return llvm::sys::Path(Path).canExecute();
+}
+
 std::string Driver::GetTemporaryPath(const char *Suffix) const {
   // FIXME: This is lame; sys::Path should provide this function (in particular,
   // it should know how to find the temporary files dir).
@@ -17,7 +17,7 @@ Job::~Job() {}
 Command::Command(const Action &_Source, const Tool &_Creator,
                  const char *_Executable, const ArgStringList &_Arguments)
   : Job(CommandClass), Source(_Source), Creator(_Creator),
-    Executable(_Executable), Arguments(_Arguments)
+    Executable(_Executable), Arguments(_Arguments), Directory(0)
 {
 }
 
@@ -11,9 +11,11 @@
 #include "clang/Driver/Arg.h"
 #include "clang/Driver/ArgList.h"
 #include "clang/Driver/Option.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <map>
 using namespace clang::driver;
 using namespace clang::driver::options;
@@ -59,15 +61,15 @@ static inline bool operator<(const OptTable::Info &A, const OptTable::Info &B) {
          "Unexpected classes for options with same name.");
   return B.Kind == Option::JoinedClass;
 }
-
-// Support lower_bound between info and an option name.
-static inline bool operator<(const OptTable::Info &I, const char *Name) {
-  return StrCmpOptionName(I.Name, Name) == -1;
-}
-static inline bool operator<(const char *Name, const OptTable::Info &I) {
-  return StrCmpOptionName(Name, I.Name) == -1;
 }
 }
+
+// The FNV-1a hash of option names, computed a character at a time so that
+// the hashes of all the prefixes of an argument take a single pass.
+static const unsigned OptionNameHashSeed = 2166136261U;
+
+static inline unsigned HashOptionNameChar(unsigned Hash, char C) {
+  return (Hash ^ (unsigned char) C) * 16777619U;
 }
 
 //
@@ -79,7 +81,8 @@ OptSpecifier::OptSpecifier(const Option *Opt) : ID(Opt->getID()) {}
 OptTable::OptTable(const Info *_OptionInfos, unsigned _NumOptionInfos)
   : OptionInfos(_OptionInfos), NumOptionInfos(_NumOptionInfos),
     Options(new Option*[NumOptionInfos]),
-    TheInputOption(0), TheUnknownOption(0), FirstSearchableIndex(0)
+    TheInputOption(0), TheUnknownOption(0), FirstSearchableIndex(0),
+    NameIndex(0), NameIndexSize(1), MaxNameLength(0)
 {
   // Explicitly zero initialize the error to work around a bug in array
   // value-initialization on MinGW with gcc 4.3.5.
@@ -101,6 +104,29 @@ OptTable::OptTable(const Info *_OptionInfos, unsigned _NumOptionInfos)
   }
   assert(FirstSearchableIndex != 0 && "No searchable options?");
 
+  // Index the names of the searchable options, so that ParseOneArg can look
+  // up the options prefixing an argument instead of scanning the table.
+  while (NameIndexSize < 2 * getNumOptions())
+    NameIndexSize *= 2;
+  NameIndex = new unsigned[NameIndexSize];
+  memset(NameIndex, 0, sizeof(*NameIndex) * NameIndexSize);
+  for (unsigned i = FirstSearchableIndex, e = getNumOptions(); i != e; ++i) {
+    // Options with the same name are adjacent; only the first is indexed.
+    const char *Name = OptionInfos[i].Name;
+    if (i != FirstSearchableIndex && strcmp(Name, OptionInfos[i - 1].Name) == 0)
+      continue;
+
+    unsigned Length = strlen(Name), Hash = OptionNameHashSeed;
+    for (unsigned j = 0; j != Length; ++j)
+      Hash = HashOptionNameChar(Hash, Name[j]);
+    MaxNameLength = std::max(MaxNameLength, Length);
+
+    unsigned Bucket = Hash & (NameIndexSize - 1);
+    while (NameIndex[Bucket])
+      Bucket = (Bucket + 1) & (NameIndexSize - 1);
+    NameIndex[Bucket] = i + 1;
+  }
+
 #ifndef NDEBUG
   // Check that everything after the first searchable option is a
   // regular option class.
@@ -126,6 +152,7 @@ OptTable::~OptTable() {
   for (unsigned i = 0, e = getNumOptions(); i != e; ++i)
     delete Options[i];
   delete[] Options;
+  delete[] NameIndex;
 }
 
 Option *OptTable::CreateOption(unsigned id) const {
@@ -188,35 +215,38 @@ Arg *OptTable::ParseOneArg(const InputArgList &Args, unsigned &Index) const {
   if (Str[0] != '-' || Str[1] == '\0')
     return new PositionalArg(TheInputOption, Index++);
 
-  const Info *Start = OptionInfos + FirstSearchableIndex;
-  const Info *End = OptionInfos + getNumOptions();
-
-  // Search for the first next option which could be a prefix.
-  Start = std::lower_bound(Start, End, Str);
+  // Hash the prefixes of the argument which could name an option.
+  llvm::SmallVector<unsigned, 64> PrefixHashes;
+  unsigned Hash = OptionNameHashSeed;
+  PrefixHashes.push_back(Hash);
+  for (unsigned L = 0; L != MaxNameLength && Str[L]; ++L) {
+    Hash = HashOptionNameChar(Hash, Str[L]);
+    PrefixHashes.push_back(Hash);
+  }
 
-  // Options are stored in sorted order, with '\0' at the end of the
-  // alphabet. Since the only options which can accept a string must
-  // prefix it, we iteratively search for the next option which could
-  // be a prefix.
-  //
-  // FIXME: This is searching much more than necessary, but I am
-  // blanking on the simplest way to make it fast. We can solve this
-  // problem when we move to TableGen.
-  for (; Start != End; ++Start) {
-    // Scan for first option which is a proper prefix.
-    for (; Start != End; ++Start)
-      if (memcmp(Str, Start->Name, strlen(Start->Name)) == 0)
-        break;
-    if (Start == End)
+  // Only the options which prefix the argument can accept it.  Try them in
+  // the order of the table: longest name first and, for options with the
+  // same name, the less permissive first.
+  for (unsigned L = PrefixHashes.size() - 1; L != 0; --L) {
+    for (unsigned Bucket = PrefixHashes[L] & (NameIndexSize - 1);
+         NameIndex[Bucket]; Bucket = (Bucket + 1) & (NameIndexSize - 1)) {
+      unsigned i = NameIndex[Bucket] - 1;
+      const char *Name = OptionInfos[i].Name;
+      if (strncmp(Name, Str, L) != 0 || Name[L] != '\0')
+        continue;
+
+      for (; i != getNumOptions() && strcmp(OptionInfos[i].Name, Name) == 0;
+           ++i) {
+        // See if this option matches.
+        if (Arg *A = getOption(i + 1)->accept(Args, Index))
+          return A;
+
+        // Otherwise, see if this argument was missing values.
+        if (Prev != Index)
+          return 0;
+      }
       break;
-
-    // See if this option matches.
-    if (Arg *A = getOption(Start - OptionInfos + 1)->accept(Args, Index))
-      return A;
-
-    // Otherwise, see if this argument was missing values.
-    if (Prev != Index)
-      return 0;
+    }
   }
 
   return new PositionalArg(TheUnknownOption, Index++);
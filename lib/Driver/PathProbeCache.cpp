@@ -0,0 +1,123 @@
+//===--- PathProbeCache.cpp - Persistent Tool Chain Probes ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A cache file starts with a "cfe-pathcache <version>" line, followed by a
+// line per path: the modification time of its directory, whether it exists
+// and whether it is executable ('1', '0', or '?' if not probed), and the
+// path itself, separated by single spaces.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Driver/PathProbeCache.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+using namespace clang::driver;
+
+static const char Magic[] = "cfe-pathcache";
+
+static signed char DecodeAnswer(llvm::StringRef S) {
+  if (S == "1") return 1;
+  if (S == "0") return 0;
+  return -1;
+}
+
+static char EncodeAnswer(signed char A) {
+  return A < 0 ? '?' : A ? '1' : '0';
+}
+
+PathProbeCache::PathProbeCache(llvm::StringRef file)
+  : File(file), Dirty(false) {
+  llvm::OwningPtr<llvm::MemoryBuffer>
+    Buf(llvm::MemoryBuffer::getFile(File.c_str()));
+  if (!Buf)
+    return;
+
+  llvm::StringRef Rest(Buf->getBufferStart(), Buf->getBufferSize());
+  std::pair<llvm::StringRef, llvm::StringRef> Line = Rest.split('\n');
+  if (Line.first != std::string(Magic) + " " + llvm::utostr(Version))
+    return;
+
+  for (Rest = Line.second; !Rest.empty(); Rest = Line.second) {
+    Line = Rest.split('\n');
+    std::pair<llvm::StringRef, llvm::StringRef> Time = Line.first.split(' ');
+    std::pair<llvm::StringRef, llvm::StringRef> Ex = Time.second.split(' ');
+    std::pair<llvm::StringRef, llvm::StringRef> X = Ex.second.split(' ');
+
+    Entry E;
+    unsigned long long DirTime;
+    if (Time.first.getAsInteger(10, DirTime) || X.second.empty())
+      continue;
+    E.DirTime = DirTime;
+    E.Exists = DecodeAnswer(Ex.first);
+    E.Executable = DecodeAnswer(X.first);
+    Entries[X.second] = E;
+  }
+}
+
+PathProbeCache::~PathProbeCache() {
+  if (!Dirty)
+    return;
+
+  clang::AtomicOutputFile CacheFile(File);
+  std::string ErrMsg;
+  if (CacheFile.open(ErrMsg))
+    return;
+
+  llvm::raw_ostream &Out = CacheFile.getStream();
+  Out << Magic << ' ' << Version << '\n';
+  for (llvm::StringMap<Entry>::const_iterator I = Entries.begin(),
+         E = Entries.end(); I != E; ++I)
+    Out << I->getValue().DirTime << ' '
+        << EncodeAnswer(I->getValue().Exists) << ' '
+        << EncodeAnswer(I->getValue().Executable) << ' '
+        << I->getKey() << '\n';
+  CacheFile.commit(ErrMsg);
+}
+
+uint64_t PathProbeCache::getDirTime(llvm::StringRef Dir) {
+  llvm::StringMap<uint64_t>::iterator I = DirTimes.find(Dir);
+  if (I != DirTimes.end())
+    return I->getValue();
+
+  // Sub-second times catch the files added right after a probe, where the
+  // file system keeps them; zero is kept for missing directories.
+  uint64_t Time = 0;
+  llvm::sys::Path P(Dir);
+  if (const llvm::sys::FileStatus *Status = P.getFileStatus())
+    if (Status->isDir)
+      Time = Status->getTimestamp().toEpochTime() * 1000000000ULL +
+             Status->getTimestamp().nanoseconds() + 1;
+  DirTimes[Dir] = Time;
+  return Time;
+}
+
+bool PathProbeCache::probe(llvm::StringRef Path, bool Executable) {
+  llvm::sys::Path P(Path);
+  uint64_t DirTime = getDirTime(P.getDirname());
+
+  // Nothing exists in a missing directory.
+  if (DirTime == 0)
+    return false;
+
+  Entry Unknown = { DirTime, -1, -1 };
+  Entry &E = Entries.GetOrCreateValue(Path, Unknown).getValue();
+  if (E.DirTime != DirTime)
+    E = Unknown;
+
+  signed char &Answer = Executable ? E.Executable : E.Exists;
+  if (Answer < 0) {
+    Answer = Executable ? P.canExecute() : P.exists();
+    Dirty = true;
+  }
+  return Answer;
+}
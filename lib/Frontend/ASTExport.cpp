@@ -0,0 +1,499 @@
+//===--- ASTExport.cpp - Streaming binary export of ASTs ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the AST consumer that exports declarations and
+// statements to a compact bitstream as they are parsed, and the reader for
+// the streams it produces.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/ASTExport.h"
+#include "clang/Frontend/ASTConsumers.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclGroup.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/Expr.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+using namespace clang;
+using namespace clang::ast_export;
+
+//===----------------------------------------------------------------------===//
+// ASTExporter Implementation
+//===----------------------------------------------------------------------===//
+
+/// The number of bytes of complete DECL blocks collected before they are
+/// written out.
+static const unsigned FlushThreshold = 65536;
+
+namespace {
+/// ASTExporter - Writes each top-level declaration to the output stream as
+/// soon as it has been parsed; nothing is kept about it afterwards.
+class ASTExporter : public ASTConsumer {
+  llvm::raw_ostream &OS;
+
+  std::vector<unsigned char> Buffer;
+  llvm::BitstreamWriter Stream;
+
+  SourceManager *SM;
+
+  /// FileIDs - The IDs given to the files named in the stream so far.
+  llvm::DenseMap<const FileEntry *, unsigned> FileIDs;
+
+  /// DeclKindsNamed, StmtKindsNamed - Whether the stream names each kind.
+  std::vector<bool> DeclKindsNamed, StmtKindsNamed;
+
+  unsigned NumDecls, NumStmts;
+
+  unsigned FileNameAbbrev, DeclKindAbbrev, StmtKindAbbrev, DeclAbbrev;
+  unsigned StmtAbbrev;
+
+  typedef llvm::SmallVector<uint64_t, 16> RecordData;
+
+  void EmitPreamble();
+  void AddLocation(SourceLocation Loc, RecordData &Record);
+  void NameKind(unsigned Code, unsigned Abbrev, std::vector<bool> &Named,
+                unsigned Kind, llvm::StringRef Name);
+  void WriteDecl(Decl *D, unsigned Parent);
+  void WriteStmt(Stmt *S, unsigned Owner, unsigned Parent);
+  void FlushBuffer(bool Force);
+
+public:
+  explicit ASTExporter(llvm::raw_ostream &OS)
+    : OS(OS), Stream(Buffer), SM(0), NumDecls(0), NumStmts(0) {
+    EmitPreamble();
+  }
+
+  ~ASTExporter() {
+    FlushBuffer(/*Force=*/true);
+  }
+
+  virtual void Initialize(ASTContext &Context) {
+    SM = &Context.getSourceManager();
+  }
+
+  virtual void HandleTopLevelDecl(DeclGroupRef DG);
+
+  virtual void HandleTranslationUnit(ASTContext &Context) {
+    FlushBuffer(/*Force=*/true);
+  }
+};
+} // end anonymous namespace
+
+/// AddLocationAbbrevOps - Add the operands for a source location to an
+/// abbreviation.
+static void AddLocationAbbrevOps(llvm::BitCodeAbbrev *Abbrev) {
+  using llvm::BitCodeAbbrevOp;
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // File ID
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Line
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Column
+}
+
+/// AddNameAbbrev - Define the abbreviation of a record of an ID and a name.
+static unsigned AddNameAbbrev(llvm::BitstreamWriter &Stream, unsigned Code) {
+  using llvm::BitCodeAbbrev;
+  using llvm::BitCodeAbbrevOp;
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(Code));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // ID
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Name
+  return Stream.EmitBlockInfoAbbrev(DECL_BLOCK_ID, Abbrev);
+}
+
+void ASTExporter::EmitPreamble() {
+  using llvm::BitCodeAbbrev;
+  using llvm::BitCodeAbbrevOp;
+
+  Stream.Emit((unsigned)'A', 8);
+  Stream.Emit((unsigned)'S', 8);
+  Stream.Emit((unsigned)'T', 8);
+  Stream.Emit((unsigned)'X', 8);
+
+  // The abbreviations for the records of a DECL block are shared by all of
+  // them, so they live in the block info block.
+  Stream.EnterSubblock(llvm::bitc::BLOCKINFO_BLOCK_ID, 3);
+
+  FileNameAbbrev = AddNameAbbrev(Stream, RECORD_FILENAME);
+  DeclKindAbbrev = AddNameAbbrev(Stream, RECORD_DECL_KIND);
+  StmtKindAbbrev = AddNameAbbrev(Stream, RECORD_STMT_KIND);
+
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_DECL));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Parent
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Kind
+  AddLocationAbbrevOps(Abbrev);
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Name and type
+  DeclAbbrev = Stream.EmitBlockInfoAbbrev(DECL_BLOCK_ID, Abbrev);
+
+  Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_STMT));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Owner
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Parent
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Kind
+  AddLocationAbbrevOps(Abbrev);
+  StmtAbbrev = Stream.EmitBlockInfoAbbrev(DECL_BLOCK_ID, Abbrev);
+
+  Stream.ExitBlock();
+
+  RecordData Record;
+  Stream.EnterSubblock(META_BLOCK_ID, 3);
+  Record.push_back(VERSION_MAJOR);
+  Stream.EmitRecord(RECORD_VERSION, Record);
+  Stream.ExitBlock();
+}
+
+/// AddLocation - Add the file, line and column of the instantiation location
+/// of \p Loc to \p Record, naming the file first if it is new to the stream.
+void ASTExporter::AddLocation(SourceLocation Loc, RecordData &Record) {
+  const FileEntry *File = 0;
+  unsigned Line = 0, Column = 0;
+  if (SM && Loc.isValid()) {
+    std::pair<FileID, unsigned> Decomposed =
+      SM->getDecomposedLoc(SM->getInstantiationLoc(Loc));
+    File = SM->getFileEntryForID(Decomposed.first);
+    if (File) {
+      Line = SM->getLineNumber(Decomposed.first, Decomposed.second);
+      Column = SM->getColumnNumber(Decomposed.first, Decomposed.second);
+    }
+  }
+
+  if (!File) {
+    Record.push_back(0);
+    Record.push_back(0);
+    Record.push_back(0);
+    return;
+  }
+
+  unsigned &ID = FileIDs[File];
+  if (ID == 0) {
+    ID = FileIDs.size();
+    RecordData FileRecord;
+    FileRecord.push_back(RECORD_FILENAME);
+    FileRecord.push_back(ID);
+    Stream.EmitRecordWithBlob(FileNameAbbrev, FileRecord, File->getName());
+  }
+
+  Record.push_back(ID);
+  Record.push_back(Line);
+  Record.push_back(Column);
+}
+
+/// NameKind - Emit the record naming a declaration or statement kind, unless
+/// the stream already names it.
+void ASTExporter::NameKind(unsigned Code, unsigned Abbrev,
+                           std::vector<bool> &Named, unsigned Kind,
+                           llvm::StringRef Name) {
+  if (Kind >= Named.size())
+    Named.resize(Kind + 1);
+  if (Named[Kind])
+    return;
+
+  Named[Kind] = true;
+  RecordData Record;
+  Record.push_back(Code);
+  Record.push_back(Kind);
+  Stream.EmitRecordWithBlob(Abbrev, Record, Name);
+}
+
+void ASTExporter::WriteDecl(Decl *D, unsigned Parent) {
+  NameKind(RECORD_DECL_KIND, DeclKindAbbrev, DeclKindsNamed, D->getKind(),
+           D->getDeclKindName());
+
+  std::string Blob;
+  if (NamedDecl *ND = dyn_cast<NamedDecl>(D))
+    Blob = ND->getNameAsString();
+  Blob += '\0';
+  if (ValueDecl *VD = dyn_cast<ValueDecl>(D))
+    Blob += VD->getType().getAsString();
+  else if (TypedefDecl *TD = dyn_cast<TypedefDecl>(D))
+    Blob += TD->getUnderlyingType().getAsString();
+
+  RecordData Record;
+  Record.push_back(RECORD_DECL);
+  Record.push_back(Parent);
+  Record.push_back(D->getKind());
+  AddLocation(D->getLocation(), Record);
+  Stream.EmitRecordWithBlob(DeclAbbrev, Record, Blob);
+  unsigned ID = ++NumDecls;
+
+  // Only definitions have their parameters in their DeclContext, so the
+  // parameters are always written from the parameter list instead.
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    for (FunctionDecl::param_iterator P = FD->param_begin(),
+           PEnd = FD->param_end(); P != PEnd; ++P)
+      WriteDecl(*P, ID);
+    if (FD->isThisDeclarationADefinition())
+      WriteStmt(FD->getBody(), ID, 0);
+  } else if (ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(D)) {
+    for (ObjCMethodDecl::param_iterator P = MD->param_begin(),
+           PEnd = MD->param_end(); P != PEnd; ++P)
+      WriteDecl(*P, ID);
+    if (MD->isThisDeclarationADefinition())
+      WriteStmt(MD->getBody(), ID, 0);
+  } else if (VarDecl *VD = dyn_cast<VarDecl>(D)) {
+    if (Expr *Init = VD->getInit())
+      WriteStmt(Init, ID, 0);
+  }
+
+  if (DeclContext *DC = dyn_cast<DeclContext>(D))
+    for (DeclContext::decl_iterator I = DC->decls_begin(),
+           E = DC->decls_end(); I != E; ++I)
+      if (!isa<ParmVarDecl>(*I))
+        WriteDecl(*I, ID);
+}
+
+void ASTExporter::WriteStmt(Stmt *S, unsigned Owner, unsigned Parent) {
+  NameKind(RECORD_STMT_KIND, StmtKindAbbrev, StmtKindsNamed,
+           S->getStmtClass(), S->getStmtClassName());
+
+  RecordData Record;
+  Record.push_back(RECORD_STMT);
+  Record.push_back(Owner);
+  Record.push_back(Parent);
+  Record.push_back(S->getStmtClass());
+  AddLocation(S->getLocStart(), Record);
+  Stream.EmitRecordWithAbbrev(StmtAbbrev, Record);
+  unsigned ID = ++NumStmts;
+
+  for (Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+       I != E; ++I)
+    if (*I)
+      WriteStmt(*I, Owner, ID);
+}
+
+void ASTExporter::HandleTopLevelDecl(DeclGroupRef DG) {
+  for (DeclGroupRef::iterator I = DG.begin(), E = DG.end(); I != E; ++I) {
+    Stream.EnterSubblock(DECL_BLOCK_ID, 4);
+    WriteDecl(*I, 0);
+    Stream.ExitBlock();
+  }
+
+  FlushBuffer(/*Force=*/false);
+}
+
+/// FlushBuffer - Write the blocks collected so far to the output stream, if
+/// there are enough of them or \p Force is set.  This is only called between
+/// blocks, where the bitstream is word-aligned and nothing refers back into
+/// the buffer.
+void ASTExporter::FlushBuffer(bool Force) {
+  if (Buffer.empty() || (!Force && Buffer.size() < FlushThreshold))
+    return;
+
+  OS.write((const char *)&Buffer.front(), Buffer.size());
+  OS.flush();
+  Buffer.clear();
+}
+
+ASTConsumer *clang::CreateASTExporter(llvm::raw_ostream *OS) {
+  return new ASTExporter(*OS);
+}
+
+//===----------------------------------------------------------------------===//
+// Reader Implementation
+//===----------------------------------------------------------------------===//
+
+ASTExportVisitor::~ASTExportVisitor() { }
+
+namespace {
+/// ASTExportReader - Hands the records of an AST export stream to a visitor.
+class ASTExportReader {
+  ASTExportVisitor &Visitor;
+
+  /// Files, DeclKinds, StmtKinds - The names given by the stream so far,
+  /// indexed by ID.
+  std::vector<std::string> Files, DeclKinds, StmtKinds;
+
+  unsigned NumDecls, NumStmts;
+
+  typedef llvm::SmallVector<uint64_t, 16> RecordData;
+
+  bool ReadLocation(const RecordData &Record, unsigned &Idx,
+                    ExportedLocation &Loc);
+  bool ReadDeclBlock(llvm::BitstreamCursor &Stream);
+
+public:
+  explicit ASTExportReader(ASTExportVisitor &Visitor)
+    : Visitor(Visitor), NumDecls(0), NumStmts(0) { }
+
+  bool Read(llvm::StringRef Buffer);
+};
+} // end anonymous namespace
+
+/// SetName - Record \p Name as the one of \p ID in \p Names.
+static void SetName(std::vector<std::string> &Names, uint64_t ID,
+                    const char *BlobStart, unsigned BlobLen) {
+  if (ID >= Names.size())
+    Names.resize(ID + 1);
+  Names[ID].assign(BlobStart, BlobLen);
+}
+
+/// GetName - The name of \p ID in \p Names, or the empty string.
+static llvm::StringRef GetName(const std::vector<std::string> &Names,
+                               uint64_t ID) {
+  if (ID >= Names.size())
+    return llvm::StringRef();
+  return Names[ID];
+}
+
+/// ReadLocation - Read a location, returning true if it is truncated.
+bool ASTExportReader::ReadLocation(const RecordData &Record, unsigned &Idx,
+                                   ExportedLocation &Loc) {
+  if (Idx + 3 > Record.size())
+    return true;
+
+  Loc.File = GetName(Files, Record[Idx++]);
+  Loc.Line = Record[Idx++];
+  Loc.Column = Record[Idx++];
+  return false;
+}
+
+/// ReadDeclBlock - Read a DECL block, visiting its records.  Returns true if
+/// the block is malformed.
+bool ASTExportReader::ReadDeclBlock(llvm::BitstreamCursor &Stream) {
+  if (Stream.EnterSubBlock(DECL_BLOCK_ID))
+    return true;
+
+  RecordData Record;
+  while (true) {
+    // A stream that ends inside a block was cut short.
+    if (Stream.AtEndOfStream())
+      return true;
+
+    unsigned Code = Stream.ReadCode();
+    if (Code == llvm::bitc::END_BLOCK)
+      return Stream.ReadBlockEnd();
+
+    if (Code == llvm::bitc::ENTER_SUBBLOCK) {
+      // No known subblocks, always skip them.
+      Stream.ReadSubBlockID();
+      if (Stream.SkipBlock())
+        return true;
+      continue;
+    }
+
+    if (Code == llvm::bitc::DEFINE_ABBREV) {
+      Stream.ReadAbbrevRecord();
+      continue;
+    }
+
+    Record.clear();
+    const char *BlobStart = 0;
+    unsigned BlobLen = 0;
+    unsigned RecCode = Stream.ReadRecord(Code, Record, &BlobStart, &BlobLen);
+    switch (RecCode) {
+    default:  // Default behavior: ignore unknown records.
+      break;
+
+    case RECORD_FILENAME:
+    case RECORD_DECL_KIND:
+    case RECORD_STMT_KIND:
+      if (Record.empty() || !BlobStart)
+        return true;
+      SetName(RecCode == RECORD_FILENAME ? Files :
+              RecCode == RECORD_DECL_KIND ? DeclKinds : StmtKinds,
+              Record[0], BlobStart, BlobLen);
+      break;
+
+    case RECORD_DECL: {
+      if (Record.size() < 2 || !BlobStart)
+        return true;
+      ExportedDecl D;
+      D.ID = ++NumDecls;
+      D.Parent = Record[0];
+      D.Kind = Record[1];
+      D.KindName = GetName(DeclKinds, D.Kind);
+      unsigned Idx = 2;
+      if (ReadLocation(Record, Idx, D.Loc))
+        return true;
+      llvm::StringRef Blob(BlobStart, BlobLen);
+      std::pair<llvm::StringRef, llvm::StringRef> NameAndType
+        = Blob.split('\0');
+      D.Name = NameAndType.first;
+      D.Type = NameAndType.second;
+      Visitor.VisitDecl(D);
+      break;
+    }
+
+    case RECORD_STMT: {
+      if (Record.size() < 3)
+        return true;
+      ExportedStmt S;
+      S.ID = ++NumStmts;
+      S.Owner = Record[0];
+      S.Parent = Record[1];
+      S.Kind = Record[2];
+      S.KindName = GetName(StmtKinds, S.Kind);
+      unsigned Idx = 3;
+      if (ReadLocation(Record, Idx, S.Loc))
+        return true;
+      Visitor.VisitStmt(S);
+      break;
+    }
+    }
+  }
+}
+
+bool ASTExportReader::Read(llvm::StringRef Buffer) {
+  // The bitstream reader only deals in whole words; anything after the last
+  // one is part of a block that was cut short anyway.
+  unsigned Size = Buffer.size() & ~3U;
+  if (Size < 4)
+    return true;
+
+  llvm::BitstreamReader StreamFile;
+  StreamFile.init((const unsigned char *)Buffer.data(),
+                  (const unsigned char *)Buffer.data() + Size);
+  llvm::BitstreamCursor Stream;
+  Stream.init(StreamFile);
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'A' ||
+      Stream.Read(8) != 'S' ||
+      Stream.Read(8) != 'T' ||
+      Stream.Read(8) != 'X')
+    return true;
+
+  while (!Stream.AtEndOfStream()) {
+    unsigned Code = Stream.ReadCode();
+    if (Code != llvm::bitc::ENTER_SUBBLOCK)
+      return true;
+
+    switch (Stream.ReadSubBlockID()) {
+    case llvm::bitc::BLOCKINFO_BLOCK_ID:
+      if (Stream.ReadBlockInfoBlock())
+        return true;
+      break;
+
+    case DECL_BLOCK_ID:
+      if (ReadDeclBlock(Stream))
+        return true;
+      break;
+
+    default:
+      // The META block, and anything added in later versions.
+      if (Stream.SkipBlock())
+        return true;
+      break;
+    }
+  }
+
+  return false;
+}
+
+bool clang::ReadASTExport(llvm::StringRef Buffer, ASTExportVisitor &Visitor) {
+  return ASTExportReader(Visitor).Read(Buffer);
+}
@@ -27,22 +27,100 @@
 #include "clang/Frontend/FrontendOptions.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Sema/ParseAST.h"
 #include "clang/Basic/TargetOptions.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Diagnostic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/System/Host.h"
 #include "llvm/System/Path.h"
+#include <algorithm>
+#include <cctype>
 using namespace clang;
 
+ASTUnitClientData::~ASTUnitClientData() { }
+
 ASTUnit::ASTUnit(bool _MainFileIsAST)
-  : MainFileIsAST(_MainFileIsAST) {
+  : FileMgr(new FileManager), SourceMgr(new SourceManager),
+    MainFileIsAST(_MainFileIsAST), CaptureDiagnostics(false),
+    PrecompilePreamble(false), FileDeclsHavePCHDecls(false),
+    EditedFunction(0), EditedBodyBegin(0), EditedBodyEnd(0),
+    NumFunctionBodyReparses(0) {
+  // Hosts tend to keep many ASTUnits alive at once, most of which include the
+  // same headers; share their contents.
+  SourceMgr->setShareFileBuffers(true);
 }
 ASTUnit::~ASTUnit() {
+  clearClientData();
   for (unsigned I = 0, N = TemporaryFiles.size(); I != N; ++I)
     TemporaryFiles[I].eraseFromDisk();
 }
 
+void ASTUnit::ParseSkippedFunctionBody(FunctionDecl *FD) {
+  if (!BodyParser || Ctx->getSkippedFunctionBody(FD).isInvalid())
+    return;
+
+  BodyParser->ParseBody(FD);
+
+  // The cached location and the client's data may now have a more precise
+  // answer.
+  LastLoc = ASTLocation();
+  clearClientData();
+}
+
+ASTUnitClientData *ASTUnit::getClientData(const void *Key) const {
+  llvm::DenseMap<const void *, ASTUnitClientData *>::const_iterator Pos
+    = ClientData.find(Key);
+  return Pos == ClientData.end() ? 0 : Pos->second;
+}
+
+void ASTUnit::setClientData(const void *Key, ASTUnitClientData *Data) {
+  ASTUnitClientData *&Slot = ClientData[Key];
+  if (Slot != Data)
+    delete Slot;
+  Slot = Data;
+}
+
+void ASTUnit::clearClientData() {
+  for (llvm::DenseMap<const void *, ASTUnitClientData *>::iterator
+         I = ClientData.begin(), E = ClientData.end(); I != E; ++I)
+    delete I->second;
+  ClientData.clear();
+}
+
+void ASTUnit::getMemoryUsage(MemoryUsage &Usage) const {
+  Usage.AST = Ctx->getASTAllocatedMemory() +
+              TopLevelDecls.capacity() * sizeof(Decl*);
+  for (llvm::DenseMap<FileID, std::vector<Decl*> >::const_iterator
+         I = FileDecls.begin(), E = FileDecls.end(); I != E; ++I)
+    Usage.AST += I->second.capacity() * sizeof(Decl*);
+
+  Usage.SourceFiles = SourceMgr->getContentBytes();
+  Usage.LineTables = SourceMgr->getLineTableBytes();
+  Usage.SourceManager = SourceMgr->getDataStructureBytes();
+  Usage.Preprocessor = PP ? PP->getTotalMemory() : 0;
+  Usage.PCH = 0;
+  if (ExternalASTSource *Source = Ctx->getExternalSource())
+    Usage.PCH = Source->getMemoryUsage();
+
+  Usage.Diagnostics = Diagnostics.size() * sizeof(StoredDiagnostic);
+  for (unsigned I = 0, N = Diagnostics.size(); I != N; ++I)
+    Usage.Diagnostics += Diagnostics[I].getMessage().size() +
+      Diagnostics[I].range_size() * sizeof(SourceRange) +
+      Diagnostics[I].fixit_size() * sizeof(CodeModificationHint);
+}
+
+void ASTUnit::releaseCaches() {
+  clearClientData();
+  LastLoc = ASTLocation();
+  SourceMgr->releaseLineTables();
+  SourceMgr->releaseFileBuffers();
+  if (PP)
+    PP->releaseCaches();
+  Ctx->releaseCaches();
+  llvm::SmallVector<StoredDiagnostic, 4>().swap(Diagnostics);
+}
+
 namespace {
 
 /// \brief Gathers information from PCHReader that will be used to initialize
@@ -92,11 +170,14 @@ public:
 
 class StoredDiagnosticClient : public DiagnosticClient {
   llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiags;
+
+  /// \brief A client that is shown each diagnostic as it is stored, or null.
+  DiagnosticClient *Observer;
   
 public:
-  explicit StoredDiagnosticClient(
-                          llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiags)
-    : StoredDiags(StoredDiags) { }
+  StoredDiagnosticClient(llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiags,
+                         DiagnosticClient *Observer)
+    : StoredDiags(StoredDiags), Observer(Observer) { }
   
   virtual void HandleDiagnostic(Diagnostic::Level Level,
                                 const DiagnosticInfo &Info);
@@ -111,8 +192,10 @@ class CaptureDroppedDiagnostics {
 
 public:
   CaptureDroppedDiagnostics(bool RequestCapture, Diagnostic &Diags, 
-                           llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiags)
-    : Diags(Diags), Client(StoredDiags), PreviousClient(Diags.getClient()) 
+                           llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiags,
+                           DiagnosticClient *Observer = 0)
+    : Diags(Diags), Client(StoredDiags, Observer),
+      PreviousClient(Diags.getClient()) 
   {
     if (RequestCapture || Diags.getClient() == 0)
       Diags.setClient(&Client);
@@ -128,6 +211,46 @@ public:
 void StoredDiagnosticClient::HandleDiagnostic(Diagnostic::Level Level,
                                               const DiagnosticInfo &Info) {
   StoredDiags.push_back(StoredDiagnostic(Level, Info));
+  if (Observer)
+    Observer->HandleDiagnostic(Level, Info);
+}
+
+void ASTUnit::addFileLevelDecl(Decl *D) {
+  SourceLocation Loc = D->getLocation();
+  if (Loc.isInvalid())
+    return;
+
+  FileDecls[SourceMgr->getFileID(SourceMgr->getInstantiationLoc(Loc))]
+    .push_back(D);
+}
+
+void ASTUnit::getFileLevelDecls(const FileEntry *File,
+                                llvm::SmallVectorImpl<Decl*> &Decls) {
+  // The declarations loaded from a PCH file were never parsed; bucket them
+  // the first time they are asked for.
+  if (!FileDeclsHavePCHDecls && Ctx && Ctx->getExternalSource()) {
+    TranslationUnitDecl *TU = Ctx->getTranslationUnitDecl();
+    for (DeclContext::decl_iterator D = TU->decls_begin(),
+                                 DEnd = TU->decls_end();
+         D != DEnd; ++D)
+      if ((*D)->getPCHLevel() > 0)
+        addFileLevelDecl(*D);
+  }
+  FileDeclsHavePCHDecls = true;
+
+  llvm::SmallVector<FileID, 4> Files;
+  for (llvm::DenseMap<FileID, std::vector<Decl*> >::iterator
+         F = FileDecls.begin(), FEnd = FileDecls.end();
+       F != FEnd; ++F)
+    if (SourceMgr->getFileEntryForID(F->first) == File)
+      Files.push_back(F->first);
+
+  // FileIDs are handed out in the order the files are entered.
+  std::sort(Files.begin(), Files.end());
+  for (unsigned I = 0, N = Files.size(); I != N; ++I) {
+    const std::vector<Decl*> &FileLevelDecls = FileDecls[Files[I]];
+    Decls.append(FileLevelDecls.begin(), FileLevelDecls.end());
+  }
 }
 
 const std::string &ASTUnit::getOriginalSourceFileName() {
@@ -139,6 +262,31 @@ const std::string &ASTUnit::getPCHFileName() {
   return static_cast<PCHReader *>(Ctx->getExternalSource())->getFileName();
 }
 
+SourceLocation ASTUnit::getLocation(const FileEntry *File, unsigned Line,
+                                    unsigned Column) const {
+  // The main FileID still holds the main file as it was parsed in full, whose
+  // text only matches EditedMainText outside of the edited body.
+  if (EditedFunction && Line && Column &&
+      File == SourceMgr->getFileEntryForID(SourceMgr->getMainFileID())) {
+    llvm::StringRef Text(EditedMainText);
+    size_t Offset = 0;
+    for (unsigned L = 1; L != Line && Offset != llvm::StringRef::npos; ++L) {
+      Offset = Text.find('\n', Offset);
+      if (Offset != llvm::StringRef::npos)
+        ++Offset;
+    }
+    if (Offset != llvm::StringRef::npos &&
+        Text.substr(Offset, Column - 1).find('\n') == llvm::StringRef::npos) {
+      Offset += Column - 1;
+      if (Offset >= EditedBodyBegin && Offset <= EditedBodyEnd)
+        return SourceMgr->getLocForStartOfFile(EditedBodyFID)
+                 .getFileLocWithOffset(Offset);
+    }
+  }
+
+  return SourceMgr->getLocation(File, Line, Column);
+}
+
 ASTUnit *ASTUnit::LoadFromPCHFile(const std::string &Filename,
                                   Diagnostic &Diags,
                                   bool OnlyLocalDecls,
@@ -250,8 +398,10 @@ public:
   TopLevelDeclTrackerConsumer(ASTUnit &_Unit) : Unit(_Unit) {}
 
   void HandleTopLevelDecl(DeclGroupRef D) {
-    for (DeclGroupRef::iterator it = D.begin(), ie = D.end(); it != ie; ++it)
+    for (DeclGroupRef::iterator it = D.begin(), ie = D.end(); it != ie; ++it) {
       Unit.getTopLevelDecls().push_back(*it);
+      Unit.addFileLevelDecl(*it);
+    }
   }
 };
 
@@ -259,15 +409,31 @@ class TopLevelDeclTrackerAction : public ASTFrontendAction {
 public:
   ASTUnit &Unit;
 
+  /// BodyParser - The parser of the skipped function bodies, if any.
+  SkippedBodyParser *BodyParser;
+
   virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
                                          llvm::StringRef InFile) {
     return new TopLevelDeclTrackerConsumer(Unit);
   }
 
 public:
-  TopLevelDeclTrackerAction(ASTUnit &_Unit) : Unit(_Unit) {}
+  TopLevelDeclTrackerAction(ASTUnit &_Unit) : Unit(_Unit), BodyParser(0) {}
 
   virtual bool hasCodeCompletionSupport() const { return false; }
+
+  virtual void ExecuteAction() {
+    CompilerInstance &CI = getCompilerInstance();
+    if (!CI.getFrontendOpts().SkipFunctionBodies)
+      return ASTFrontendAction::ExecuteAction();
+
+    // Keep the parser of the skipped bodies, so that they can be parsed when
+    // a client looks into them.
+    ParseAST(CI.getPreprocessor(), &CI.getASTConsumer(), CI.getASTContext(),
+             CI.getFrontendOpts().ShowStats, usesCompleteTranslationUnit(),
+             /*CompletionConsumer=*/0, /*SkipFunctionBodies=*/true,
+             &BodyParser);
+  }
 };
 
 }
@@ -275,10 +441,45 @@ public:
 ASTUnit *ASTUnit::LoadFromCompilerInvocation(CompilerInvocation *CI,
                                              Diagnostic &Diags,
                                              bool OnlyLocalDecls,
-                                             bool CaptureDiagnostics) {
+                                             bool CaptureDiagnostics,
+                                             bool PrecompilePreamble,
+                                             DiagnosticClient *DiagObserver) {
+  assert(CI->getFrontendOpts().Inputs.size() == 1 &&
+         "Invocation must have exactly one source file!");
+  assert(CI->getFrontendOpts().Inputs[0].first != FrontendOptions::IK_AST &&
+         "FIXME: AST inputs not yet supported here!");
+
+  // Create the AST unit.
+  llvm::OwningPtr<ASTUnit> AST(new ASTUnit(false));
+  AST->OnlyLocalDecls = OnlyLocalDecls;
+  AST->CaptureDiagnostics = CaptureDiagnostics;
+  AST->PrecompilePreamble = PrecompilePreamble;
+  AST->OriginalSourceFile = CI->getFrontendOpts().Inputs[0].second;
+  AST->Invocation.reset(CI);
+
+  // The remapped buffers belong to the source manager of the parse that uses
+  // them, so they are not kept in the invocation that later parses start
+  // from.
+  PreprocessorOptions &PPOpts = CI->getPreprocessorOpts();
+  std::vector<RemappedFile> RemappedFiles(PPOpts.RemappedFileBuffers.begin(),
+                                          PPOpts.RemappedFileBuffers.end());
+  PPOpts.RemappedFileBuffers.clear();
+
+  if (AST->Parse(Diags, RemappedFiles.empty() ? 0 : &RemappedFiles[0],
+                 RemappedFiles.size(), DiagObserver))
+    return 0;
+
+  return AST.take();
+}
+
+bool ASTUnit::Parse(Diagnostic &Diags, RemappedFile *RemappedFiles,
+                    unsigned NumRemappedFiles, DiagnosticClient *DiagObserver) {
+  CompilerInvocation *CI = new CompilerInvocation(*Invocation);
+  AddRemappedFiles(CI->getPreprocessorOpts(), RemappedFiles, NumRemappedFiles,
+                   PrecompilePreamble, 0, 0);
+
   // Create the compiler instance to use for building the AST.
   CompilerInstance Clang;
-  llvm::OwningPtr<ASTUnit> AST;
   llvm::OwningPtr<TopLevelDeclTrackerAction> Act;
 
   Clang.setInvocation(CI);
@@ -290,11 +491,9 @@ ASTUnit *ASTUnit::LoadFromCompilerInvocation(CompilerInvocation *CI,
   Clang.setTarget(TargetInfo::CreateTargetInfo(Clang.getDiagnostics(),
                                                Clang.getTargetOpts()));
   if (!Clang.hasTarget()) {
-    Clang.takeSourceManager();
-    Clang.takeFileManager();
     Clang.takeDiagnosticClient();
     Clang.takeDiagnostics();
-    return 0;
+    return true;
   }
 
   // Inform the target of the language options.
@@ -303,31 +502,21 @@ ASTUnit *ASTUnit::LoadFromCompilerInvocation(CompilerInvocation *CI,
   // created. This complexity should be lifted elsewhere.
   Clang.getTarget().setForcedLangOptions(Clang.getLangOpts());
 
-  assert(Clang.getFrontendOpts().Inputs.size() == 1 &&
-         "Invocation must have exactly one source file!");
-  assert(Clang.getFrontendOpts().Inputs[0].first != FrontendOptions::IK_AST &&
-         "FIXME: AST inputs not yet supported here!");
-
-  // Create the AST unit.
-  AST.reset(new ASTUnit(false));
-  AST->OnlyLocalDecls = OnlyLocalDecls;
-  AST->OriginalSourceFile = Clang.getFrontendOpts().Inputs[0].second;
-
   // Capture any diagnostics that would otherwise be dropped.
   CaptureDroppedDiagnostics Capture(CaptureDiagnostics, 
                                     Clang.getDiagnostics(),
-                                    AST->Diagnostics);
-
-  // Create a file manager object to provide access to and cache the filesystem.
-  Clang.setFileManager(&AST->getFileManager());
+                                    Diagnostics, DiagObserver);
 
-  // Create the source manager.
-  Clang.setSourceManager(&AST->getSourceManager());
+  // Use the file and source managers of the AST unit.
+  if (Clang.getFrontendOpts().CacheDirectoryListings)
+    FileMgr->setCacheDirectoryListings(true);
+  Clang.setFileManager(FileMgr.get());
+  Clang.setSourceManager(SourceMgr.get());
 
   // Create the preprocessor.
   Clang.createPreprocessor();
 
-  Act.reset(new TopLevelDeclTrackerAction(*AST));
+  Act.reset(new TopLevelDeclTrackerAction(*this));
   if (!Act->BeginSourceFile(Clang, Clang.getFrontendOpts().Inputs[0].second,
                            /*IsAST=*/false))
     goto error;
@@ -336,27 +525,28 @@ ASTUnit *ASTUnit::LoadFromCompilerInvocation(CompilerInvocation *CI,
 
   // Steal the created target, context, and preprocessor, and take back the
   // source and file managers.
-  AST->Ctx.reset(Clang.takeASTContext());
-  AST->PP.reset(Clang.takePreprocessor());
+  Ctx.reset(Clang.takeASTContext());
+  PP.reset(Clang.takePreprocessor());
   Clang.takeSourceManager();
   Clang.takeFileManager();
-  AST->Target.reset(Clang.takeTarget());
+  Target.reset(Clang.takeTarget());
+  if (Act->BodyParser) {
+    Consumer.reset(Clang.takeASTConsumer());
+    BodyParser.reset(Act->BodyParser);
+  }
 
   Act->EndSourceFile();
 
   Clang.takeDiagnosticClient();
   Clang.takeDiagnostics();
-  Clang.takeInvocation();
-
-  AST->Invocation.reset(Clang.takeInvocation());
-  return AST.take();
+  return false;
 
 error:
   Clang.takeSourceManager();
   Clang.takeFileManager();
   Clang.takeDiagnosticClient();
   Clang.takeDiagnostics();
-  return 0;
+  return true;
 }
 
 ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
@@ -366,7 +556,10 @@ ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
                                       bool OnlyLocalDecls,
                                       RemappedFile *RemappedFiles,
                                       unsigned NumRemappedFiles,
-                                      bool CaptureDiagnostics) {
+                                      bool CaptureDiagnostics,
+                                      bool SkipFunctionBodies,
+                                      bool PrecompilePreamble,
+                                      DiagnosticClient *DiagObserver) {
   llvm::SmallVector<const char *, 16> Args;
   Args.push_back("<clang>"); // FIXME: Remove dummy argument.
   Args.insert(Args.end(), ArgBegin, ArgEnd);
@@ -417,6 +610,592 @@ ASTUnit *ASTUnit::LoadFromCommandLine(const char **ArgBegin,
   CI->getHeaderSearchOpts().ResourceDir = ResourceFilesPath;
 
   CI->getFrontendOpts().DisableFree = true;
+  if (SkipFunctionBodies)
+    CI->getFrontendOpts().SkipFunctionBodies = true;
   return LoadFromCompilerInvocation(CI.take(), Diags, OnlyLocalDecls,
-                                    CaptureDiagnostics);
+                                    CaptureDiagnostics, PrecompilePreamble,
+                                    DiagObserver);
+}
+
+bool ASTUnit::Reparse(Diagnostic &Diags, RemappedFile *RemappedFiles,
+                      unsigned NumRemappedFiles) {
+  if (!Invocation) {
+    for (unsigned I = 0; I != NumRemappedFiles; ++I)
+      delete RemappedFiles[I].second;
+    return true;
+  }
+
+  // An edit within a function body only needs that body to be lexed again.
+  if (ReparseFunctionBody(RemappedFiles, NumRemappedFiles)) {
+    ++NumFunctionBodyReparses;
+    return false;
+  }
+
+  // Throw away the previous parse, users first.
+  clearClientData();
+  BodyParser.reset();
+  Consumer.reset();
+  Ctx.reset();
+  PP.reset();
+  Target.reset();
+  HeaderInfo.reset();
+  TopLevelDecls.clear();
+  FileDecls.clear();
+  FileDeclsHavePCHDecls = false;
+  Diagnostics.clear();
+  LastLoc = ASTLocation();
+  EditedMainText.clear();
+  EditedFunction = 0;
+  EditedBodyFID = FileID();
+
+  // New file and source managers see the files as they are now: the cached
+  // status of each file is what tells that it changed.  The previous ones are
+  // kept until the parse is done, so that the shared buffers of the files
+  // that did not change are reused instead of being read again.
+  llvm::OwningPtr<FileManager> OldFileMgr(FileMgr.take());
+  llvm::OwningPtr<SourceManager> OldSourceMgr(SourceMgr.take());
+  FileMgr.reset(new FileManager);
+  SourceMgr.reset(new SourceManager);
+  SourceMgr->setShareFileBuffers(true);
+
+  // The directories rarely change between parses, so keep their listings
+  // unless they did.
+  if (Invocation->getFrontendOpts().CacheDirectoryListings) {
+    FileMgr->setCacheDirectoryListings(true);
+    FileMgr->takeDirectoryListings(*OldFileMgr);
+  }
+
+  bool Failed = Parse(Diags, RemappedFiles, NumRemappedFiles, 0);
+  OldSourceMgr.reset();
+  return Failed;
+}
+
+namespace {
+
+/// \brief Parses the main file for code completion, reporting the results to
+/// a consumer owned by the client.
+class CodeCompletionAction : public SyntaxOnlyAction {
+  CodeCompleteConsumer &Consumer;
+
+public:
+  explicit CodeCompletionAction(CodeCompleteConsumer &Consumer)
+    : Consumer(Consumer) { }
+
+  virtual void ExecuteAction() {
+    CompilerInstance &CI = getCompilerInstance();
+    const ParsedSourceLocation &Loc = CI.getFrontendOpts().CodeCompletionAt;
+    const FileEntry *Entry = CI.getFileManager().getFile(Loc.FileName);
+    if (!Entry) {
+      CI.getDiagnostics().Report(diag::err_fe_invalid_code_complete_file)
+        << Loc.FileName;
+      return;
+    }
+
+    CI.getPreprocessor().SetCodeCompletionPoint(Entry, Loc.Line, Loc.Column);
+    ParseAST(CI.getPreprocessor(), &CI.getASTConsumer(), CI.getASTContext(),
+             /*PrintStats=*/false, usesCompleteTranslationUnit(), &Consumer);
+  }
+};
+
+}
+
+/// SkipToEndOfDirective - Return the end of the preprocessor directive line
+/// starting at \arg Cur, i.e., of its unescaped newline.
+static const char *SkipToEndOfDirective(const char *Cur, const char *End) {
+  while (Cur != End) {
+    if (*Cur == '\\' && Cur + 1 != End && (Cur[1] == '\n' || Cur[1] == '\r')) {
+      Cur += 2;
+      continue;
+    }
+    if (*Cur == '\n' || *Cur == '\r')
+      break;
+    if (*Cur == '/' && Cur + 1 != End && Cur[1] == '*') {
+      size_t CommentEnd = llvm::StringRef(Cur + 2, End - Cur - 2).find("*/");
+      if (CommentEnd == llvm::StringRef::npos)
+        return End;
+      Cur += CommentEnd + 4;
+      continue;
+    }
+    ++Cur;
+  }
+  return Cur;
+}
+
+/// ComputePreambleSize - Return the size of the preamble of \arg Buffer: the
+/// whitespace, comments and preprocessor directives it starts with, up to
+/// the end of the last directive that is not within a conditional.
+static unsigned ComputePreambleSize(llvm::StringRef Buffer) {
+  const char *Start = Buffer.begin(), *End = Buffer.end();
+  const char *Cur = Start, *PreambleEnd = Start;
+  unsigned ConditionalDepth = 0;
+  bool AtStartOfLine = true;
+  while (Cur != End) {
+    char C = *Cur;
+    if (C == '\n' || C == '\r') {
+      AtStartOfLine = true;
+      ++Cur;
+      continue;
+    }
+    if (C == ' ' || C == '\t' || C == '\f' || C == '\v') {
+      ++Cur;
+      continue;
+    }
+    if (C == '/' && Cur + 1 != End && Cur[1] == '/') {
+      while (Cur != End && *Cur != '\n' && *Cur != '\r')
+        ++Cur;
+      continue;
+    }
+    if (C == '/' && Cur + 1 != End && Cur[1] == '*') {
+      size_t CommentEnd = llvm::StringRef(Cur + 2, End - Cur - 2).find("*/");
+      if (CommentEnd == llvm::StringRef::npos)
+        break;
+      Cur += CommentEnd + 4;
+      continue;
+    }
+    if (C != '#' || !AtStartOfLine)
+      break;
+
+    const char *Name = Cur + 1;
+    while (Name != End && (*Name == ' ' || *Name == '\t'))
+      ++Name;
+    const char *NameEnd = Name;
+    while (NameEnd != End && (isalnum(*NameEnd) || *NameEnd == '_'))
+      ++NameEnd;
+    llvm::StringRef Directive(Name, NameEnd - Name);
+    Cur = SkipToEndOfDirective(NameEnd, End);
+
+    if (Directive == "if" || Directive == "ifdef" || Directive == "ifndef")
+      ++ConditionalDepth;
+    else if (Directive == "endif" && ConditionalDepth-- == 0)
+      break;
+    if (ConditionalDepth == 0)
+      PreambleEnd = Cur;
+  }
+
+  return PreambleEnd - Start;
+}
+
+/// GetOffsetOfLocation - Return the offset of \arg Line and \arg Column in
+/// \arg Buffer, or the size of the buffer if they are past its end.
+static unsigned GetOffsetOfLocation(llvm::StringRef Buffer, unsigned Line,
+                                    unsigned Column) {
+  unsigned Offset = 0;
+  for (unsigned CurLine = 1; CurLine < Line; ++CurLine) {
+    Offset = Buffer.find('\n', Offset);
+    if (Offset == llvm::StringRef::npos)
+      return Buffer.size();
+    ++Offset;
+  }
+  return std::min(Offset + Column - 1, unsigned(Buffer.size()));
+}
+
+/// getPreambleFileName - The preamble is parsed as a virtual file next to
+/// the main file, so that its quoted #includes are found the same way.
+static std::string getPreambleFileName(llvm::StringRef MainFile) {
+  return MainFile.str() + ".preamble";
+}
+
+bool ASTUnit::UpdatePreamble(llvm::StringRef Text) {
+  if (!PreamblePCH.empty() && Text == PreambleText) {
+    bool Changed = false;
+    for (unsigned I = 0, N = PreambleDependencies.size(); I != N && !Changed;
+         ++I) {
+      llvm::sys::PathWithStatus Dependency(PreambleDependencies[I].first);
+      const llvm::sys::FileStatus *Status = Dependency.getFileStatus();
+      Changed = !Status || Status->getTimestamp().toEpochTime() !=
+                           PreambleDependencies[I].second;
+    }
+    if (!Changed)
+      return true;
+  }
+
+  PreambleText.clear();
+  PreambleDependencies.clear();
+  if (PreamblePCH.empty()) {
+    std::string ErrMsg;
+    llvm::sys::Path Dir = llvm::sys::Path::GetTemporaryDirectory(&ErrMsg);
+    if (Dir.isEmpty())
+      return false;
+
+    // The PCH file is removed before its directory.
+    PreamblePCH = Dir;
+    PreamblePCH.appendComponent("preamble.pch");
+    TemporaryFiles.push_back(PreamblePCH);
+    TemporaryFiles.push_back(Dir);
+  }
+
+  std::string PreambleFile = getPreambleFileName(OriginalSourceFile);
+  CompilerInvocation *PreambleInvocation = new CompilerInvocation(*Invocation);
+  FrontendOptions &FrontendOpts = PreambleInvocation->getFrontendOpts();
+  FrontendOpts.Inputs[0].second = PreambleFile;
+  FrontendOpts.OutputFile = PreamblePCH.str();
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.SkipFunctionBodies = false;
+  PreprocessorOptions &PPOpts = PreambleInvocation->getPreprocessorOpts();
+  PPOpts.RemappedFiles.clear();
+  PPOpts.RemappedFileBuffers.clear();
+  PPOpts.addRemappedFile(PreambleFile,
+                         llvm::MemoryBuffer::getMemBufferCopy(Text.begin(),
+                                                              Text.end(),
+                                                        PreambleFile.c_str()));
+
+  // An error keeps the preamble from being used, so that parsing the whole
+  // main file reports it; warnings in the preamble are not reported.
+  DiagnosticOptions DiagOpts;
+  llvm::OwningPtr<Diagnostic> Diags(
+                         CompilerInstance::createDiagnostics(DiagOpts, 0, 0));
+  llvm::SmallVector<StoredDiagnostic, 4> IgnoredDiagnostics;
+  CaptureDroppedDiagnostics Capture(true, *Diags, IgnoredDiagnostics);
+
+  CompilerInstance Clang;
+  Clang.setInvocation(PreambleInvocation);
+  Clang.setDiagnostics(Diags.get());
+  Clang.setDiagnosticClient(Diags->getClient());
+  Clang.setTarget(TargetInfo::CreateTargetInfo(Clang.getDiagnostics(),
+                                               Clang.getTargetOpts()));
+  if (!Clang.hasTarget()) {
+    Clang.takeDiagnosticClient();
+    Clang.takeDiagnostics();
+    return false;
+  }
+  Clang.getTarget().setForcedLangOptions(Clang.getLangOpts());
+
+  Clang.createFileManager();
+  Clang.createSourceManager();
+  Clang.createPreprocessor();
+
+  GeneratePCHAction Act;
+  if (Act.BeginSourceFile(Clang, PreambleFile, /*IsAST=*/false)) {
+    Act.Execute();
+    Act.EndSourceFile();
+  }
+
+  bool Success = Diags->getNumErrors() == 0 && PreamblePCH.exists();
+  if (Success) {
+    PreambleText = Text.str();
+    SourceManager &SM = Clang.getSourceManager();
+    for (SourceManager::fileinfo_iterator F = SM.fileinfo_begin(),
+                                       FEnd = SM.fileinfo_end();
+         F != FEnd; ++F)
+      if (F->first->getName() != PreambleFile)
+        PreambleDependencies.push_back(std::make_pair(F->first->getName(),
+                                          F->first->getModificationTime()));
+  }
+
+  Clang.takeDiagnosticClient();
+  Clang.takeDiagnostics();
+  return Success;
+}
+
+void ASTUnit::AddRemappedFiles(PreprocessorOptions &PPOpts,
+                               RemappedFile *RemappedFiles,
+                               unsigned NumRemappedFiles, bool UsePreamble,
+                               unsigned Line, unsigned Column) {
+  const llvm::MemoryBuffer *MainBuffer = 0;
+  bool OnlyMainFileRemapped = true;
+  for (unsigned I = 0; I != NumRemappedFiles; ++I) {
+    PPOpts.addRemappedFile(RemappedFiles[I].first, RemappedFiles[I].second);
+    if (RemappedFiles[I].first == OriginalSourceFile)
+      MainBuffer = RemappedFiles[I].second;
+    else
+      OnlyMainFileRemapped = false;
+  }
+
+  // The preamble is only reused when the main file is the one file that
+  // differs from the disk, since the preamble would have to be rebuilt for
+  // every change to another file.  It cannot be combined with files included
+  // or remapped from the command line.
+  if (!UsePreamble || !OnlyMainFileRemapped || !PPOpts.RemappedFiles.empty() ||
+      !PPOpts.Includes.empty() ||
+      !PPOpts.MacroIncludes.empty() || !PPOpts.ImplicitPCHInclude.empty() ||
+      !PPOpts.ImplicitPTHInclude.empty())
+    return;
+
+  llvm::OwningPtr<llvm::MemoryBuffer> MainFileOnDisk;
+  if (!MainBuffer) {
+    MainFileOnDisk.reset(llvm::MemoryBuffer::getFile(OriginalSourceFile));
+    MainBuffer = MainFileOnDisk.get();
+    if (!MainBuffer)
+      return;
+  }
+
+  llvm::StringRef Contents = MainBuffer->getBuffer();
+  unsigned PreambleSize = ComputePreambleSize(Contents);
+  if (PreambleSize == 0 ||
+      (Line && GetOffsetOfLocation(Contents, Line, Column) <= PreambleSize) ||
+      !UpdatePreamble(Contents.substr(0, PreambleSize)))
+    return;
+
+  // Lex the main file from the end of its preamble, on top of the PCH file.
+  // The PCH file refers to the preamble by the name it was parsed as.
+  std::string PreambleFile = getPreambleFileName(OriginalSourceFile);
+  PPOpts.addRemappedFile(PreambleFile,
+          llvm::MemoryBuffer::getMemBufferCopy(PreambleText.data(),
+                                               PreambleText.data() +
+                                                 PreambleText.size(),
+                                               PreambleFile.c_str()));
+  PPOpts.ImplicitPCHInclude = PreamblePCH.str();
+  PPOpts.PrecompiledPreambleBytes = PreambleSize;
+}
+
+/// FindEditedFunction - Find the function definition, \arg D or one declared
+/// within it, whose body is in \arg FID and encloses the offsets [\arg Begin,
+/// \arg End) between its braces.
+static FunctionDecl *FindEditedFunction(Decl *D, SourceManager &SM, FileID FID,
+                                        unsigned Begin, unsigned End) {
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    CompoundStmt *Body = FD->isThisDeclarationADefinition() ?
+      dyn_cast<CompoundStmt>(FD->getBody()) : 0;
+    if (!Body || !Body->getLBracLoc().isFileID() ||
+        !Body->getRBracLoc().isFileID() ||
+        SM.getFileID(Body->getLBracLoc()) != FID ||
+        SM.getFileID(Body->getRBracLoc()) != FID)
+      return 0;
+    if (SM.getFileOffset(Body->getLBracLoc()) < Begin &&
+        End <= SM.getFileOffset(Body->getRBracLoc()))
+      return FD;
+    return 0;
+  }
+
+  DeclContext *DC = dyn_cast<DeclContext>(D);
+  if (!DC)
+    return 0;
+  for (DeclContext::decl_iterator I = DC->decls_begin(),
+                               IEnd = DC->decls_end();
+       I != IEnd; ++I)
+    if (FunctionDecl *FD = FindEditedFunction(*I, SM, FID, Begin, End))
+      return FD;
+  return 0;
+}
+
+/// HasDirectiveLine - Return true if a line of \arg Text starts with a '#', so
+/// that lexing it might change the state of the preprocessor.
+static bool HasDirectiveLine(llvm::StringRef Text) {
+  bool StartOfLine = false;
+  for (unsigned I = 0, N = Text.size(); I != N; ++I) {
+    if (Text[I] == '\n' || Text[I] == '\r')
+      StartOfLine = true;
+    else if (StartOfLine && Text[I] == '#')
+      return true;
+    else if (!isspace(Text[I]))
+      StartOfLine = false;
+  }
+  return false;
+}
+
+bool ASTUnit::ReparseFunctionBody(RemappedFile *RemappedFiles,
+                                  unsigned NumRemappedFiles) {
+  if (!BodyParser || NumRemappedFiles != 1 ||
+      RemappedFiles[0].first != OriginalSourceFile)
+    return false;
+
+  // The files the translation unit was built from, other than the main file,
+  // must not have changed since.
+  FileID MainFID = SourceMgr->getMainFileID();
+  const FileEntry *MainEntry = SourceMgr->getFileEntryForID(MainFID);
+  if (!MainEntry)
+    return false;
+  std::string PreambleFile = getPreambleFileName(OriginalSourceFile);
+  const PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  for (SourceManager::fileinfo_iterator F = SourceMgr->fileinfo_begin(),
+                                     FEnd = SourceMgr->fileinfo_end();
+       F != FEnd; ++F) {
+    const FileEntry *Entry = F->first;
+    if (Entry == MainEntry || Entry->getName() == PreambleFile)
+      continue;
+
+    // Remapped buffers only change when they are passed to Reparse().
+    bool IsRemapped = false;
+    for (unsigned I = 0, N = PPOpts.RemappedFileBuffers.size();
+         I != N && !IsRemapped; ++I)
+      IsRemapped = PPOpts.RemappedFileBuffers[I].first == Entry->getName();
+    if (IsRemapped)
+      continue;
+
+    llvm::sys::PathWithStatus Path(Entry->getName());
+    const llvm::sys::FileStatus *Status = Path.getFileStatus();
+    if (!Status ||
+        Status->getTimestamp().toEpochTime() != Entry->getModificationTime() ||
+        Status->getSize() != uint64_t(Entry->getSize()))
+      return false;
+  }
+  for (unsigned I = 0, N = PreambleDependencies.size(); I != N; ++I) {
+    llvm::sys::PathWithStatus Dependency(PreambleDependencies[I].first);
+    const llvm::sys::FileStatus *Status = Dependency.getFileStatus();
+    if (!Status ||
+        Status->getTimestamp().toEpochTime() != PreambleDependencies[I].second)
+      return false;
+  }
+
+  // Find the text that changed, between the longest common prefix and suffix
+  // of the main file as it was and as it is.
+  llvm::StringRef Old = EditedFunction ? llvm::StringRef(EditedMainText) :
+                          SourceMgr->getBuffer(MainFID)->getBuffer();
+  llvm::StringRef New = RemappedFiles[0].second->getBuffer();
+  unsigned Common = std::min(Old.size(), New.size());
+  unsigned Prefix = 0;
+  while (Prefix != Common && Old[Prefix] == New[Prefix])
+    ++Prefix;
+  unsigned Suffix = 0;
+  while (Suffix != Common - Prefix &&
+         Old[Old.size() - Suffix - 1] == New[New.size() - Suffix - 1])
+    ++Suffix;
+  unsigned EditEnd = Old.size() - Suffix;
+
+  // The change must be strictly within the braces of one function body.  Only
+  // the function edited last is found in the edited text.
+  FunctionDecl *FD = EditedFunction;
+  unsigned BodyBegin, BodyEnd;
+  if (FD) {
+    BodyBegin = EditedBodyBegin;
+    BodyEnd = EditedBodyEnd;
+    if (!(BodyBegin < Prefix && EditEnd <= BodyEnd))
+      return false;
+  } else {
+    llvm::DenseMap<FileID, std::vector<Decl*> >::iterator Decls
+      = FileDecls.find(MainFID);
+    if (Decls == FileDecls.end())
+      return false;
+    for (unsigned I = 0, N = Decls->second.size(); I != N && !FD; ++I)
+      FD = FindEditedFunction(Decls->second[I], *SourceMgr, MainFID, Prefix,
+                              EditEnd);
+    if (!FD)
+      return false;
+    CompoundStmt *Body = cast<CompoundStmt>(FD->getBody());
+    BodyBegin = SourceMgr->getFileOffset(Body->getLBracLoc());
+    BodyEnd = SourceMgr->getFileOffset(Body->getRBracLoc());
+  }
+
+  // Everything outside the body must stay on the line and column it was on,
+  // and the body must not hold anything the preprocessor would remember.
+  // Line directives are not carried over to the new version of the file.
+  unsigned NewBodyEnd = New.size() - (Old.size() - BodyEnd);
+  llvm::StringRef OldBody = Old.slice(BodyBegin, BodyEnd + 1);
+  llvm::StringRef NewBody = New.slice(BodyBegin, NewBodyEnd + 1);
+  if (SourceMgr->getSLocEntry(MainFID).getFile().hasLineDirectives() ||
+      std::count(OldBody.begin(), OldBody.end(), '\n') !=
+        std::count(NewBody.begin(), NewBody.end(), '\n') ||
+      HasDirectiveLine(OldBody) || HasDirectiveLine(NewBody))
+    return false;
+  for (unsigned I = NewBodyEnd + 1, N = New.size();
+       I != N && New[I] != '\n' && New[I] != '\r'; ++I)
+    if (!isspace(New[I]))
+      return false;
+
+  // Lex the new body from a new version of the main file, in which the text
+  // before the body is blanked out so that the body keeps the offsets, lines
+  // and columns it has in the edited text.
+  CompoundStmt *Body = cast<CompoundStmt>(FD->getBody());
+  SourceLocation LBraceLoc = Body->getLBracLoc();
+  SourceLocation RBraceLoc = Body->getRBracLoc();
+  std::string BodyText(New.begin(), New.begin() + BodyBegin);
+  for (unsigned I = 0, N = BodyText.size(); I != N; ++I)
+    if (BodyText[I] != '\n' && BodyText[I] != '\r')
+      BodyText[I] = ' ';
+  BodyText.append(NewBody.begin(), NewBody.end());
+  BodyText += '\n';
+  FileID BodyFID = SourceMgr->createFileIDForEditedFile(MainEntry,
+    llvm::MemoryBuffer::getMemBufferCopy(BodyText.data(),
+                                         BodyText.data() + BodyText.size(),
+                                         OriginalSourceFile.c_str()));
+
+  // The diagnostics of the old body no longer apply; those of the new one
+  // are reported as it is lexed and parsed.
+  FileID OldBodyFID = SourceMgr->getFileID(LBraceLoc);
+  unsigned OldBodyBegin = SourceMgr->getFileOffset(LBraceLoc);
+  unsigned OldBodyEnd = SourceMgr->getFileOffset(RBraceLoc);
+  unsigned NumDiagnostics = Diagnostics.size();
+  {
+    CaptureDroppedDiagnostics Capture(CaptureDiagnostics, PP->getDiagnostics(),
+                                      Diagnostics);
+    if (BodyParser->ReplaceBody(FD, BodyFID))
+      return false;
+  }
+
+  unsigned Kept = 0;
+  for (unsigned I = 0, N = Diagnostics.size(); I != N; ++I) {
+    SourceLocation Loc = Diagnostics[I].getLocation();
+    if (I < NumDiagnostics && Loc.isValid()) {
+      Loc = SourceMgr->getInstantiationLoc(Loc);
+      if (SourceMgr->getFileID(Loc) == OldBodyFID &&
+          SourceMgr->getFileOffset(Loc) >= OldBodyBegin &&
+          SourceMgr->getFileOffset(Loc) <= OldBodyEnd)
+        continue;
+    }
+    if (Kept != I)
+      Diagnostics[Kept] = Diagnostics[I];
+    ++Kept;
+  }
+  Diagnostics.erase(Diagnostics.begin() + Kept, Diagnostics.end());
+
+  EditedMainText = New.str();
+  EditedFunction = FD;
+  EditedBodyBegin = BodyBegin;
+  EditedBodyEnd = NewBodyEnd;
+  EditedBodyFID = BodyFID;
+  delete RemappedFiles[0].second;
+
+  // Cursors and client data may refer to the old body.
+  LastLoc = ASTLocation();
+  clearClientData();
+  return true;
+}
+
+bool ASTUnit::CodeComplete(llvm::StringRef File, unsigned Line,
+                           unsigned Column, RemappedFile *RemappedFiles,
+                           unsigned NumRemappedFiles,
+                           CodeCompleteConsumer &Consumer, Diagnostic &Diags,
+                           FileManager &FileMgr, SourceManager &SourceMgr,
+                   llvm::SmallVectorImpl<StoredDiagnostic> &StoredDiagnostics) {
+  if (!Invocation)
+    return false;
+
+  CompilerInvocation *CCInvocation = new CompilerInvocation(*Invocation);
+  FrontendOptions &FrontendOpts = CCInvocation->getFrontendOpts();
+  FrontendOpts.CodeCompletionAt.FileName = File.str();
+  FrontendOpts.CodeCompletionAt.Line = Line;
+  FrontendOpts.CodeCompletionAt.Column = Column;
+  FrontendOpts.ProgramAction = frontend::ParseSyntaxOnly;
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.SkipFunctionBodies = false;
+
+  // The buffers remapped when the translation unit was parsed belong to its
+  // source manager; the client passes the current ones.
+  PreprocessorOptions &PPOpts = CCInvocation->getPreprocessorOpts();
+  PPOpts.RemappedFiles.clear();
+  PPOpts.RemappedFileBuffers.clear();
+  AddRemappedFiles(PPOpts, RemappedFiles, NumRemappedFiles,
+                   File == OriginalSourceFile, Line, Column);
+
+  CompilerInstance Clang;
+  Clang.setInvocation(CCInvocation);
+  Clang.setDiagnostics(&Diags);
+  Clang.setDiagnosticClient(Diags.getClient());
+
+  // Capture the diagnostics of the completion for the client.
+  CaptureDroppedDiagnostics Capture(true, Diags, StoredDiagnostics);
+
+  Clang.setTarget(TargetInfo::CreateTargetInfo(Clang.getDiagnostics(),
+                                               Clang.getTargetOpts()));
+  if (Clang.hasTarget()) {
+    Clang.getTarget().setForcedLangOptions(Clang.getLangOpts());
+
+    Clang.setFileManager(&FileMgr);
+    Clang.setSourceManager(&SourceMgr);
+    Clang.createPreprocessor();
+
+    CodeCompletionAction Act(Consumer);
+    if (Act.BeginSourceFile(Clang, OriginalSourceFile, /*IsAST=*/false)) {
+      Act.Execute();
+      Act.EndSourceFile();
+    }
+
+    Clang.takeSourceManager();
+    Clang.takeFileManager();
+  }
+
+  Clang.takeDiagnosticClient();
+  Clang.takeDiagnostics();
+  return true;
 }
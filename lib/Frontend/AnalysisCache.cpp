@@ -0,0 +1,72 @@
+//===--- AnalysisCache.cpp - Cache of clean analysis results --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code looks up and records the declarations without analysis reports
+// in a cache directory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/AnalysisCache.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Frontend/PCHBitCodes.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace clang;
+
+/// \brief The version of the format of the entries of the cache.
+static const unsigned AnalysisCacheVersion = 1;
+
+/// \brief The contents of the entry of \p Key.
+static std::string getEntry(llvm::StringRef Key) {
+  std::string Entry;
+  llvm::raw_string_ostream OS(Entry);
+  uint64_t Version = AnalysisCacheVersion;
+  OS << "cfe-ana";
+  OS.write((const char *)&Version, sizeof(uint64_t));
+  OS << Key;
+  return OS.str();
+}
+
+llvm::sys::Path AnalysisCache::getEntryPath(llvm::StringRef Key) const {
+  char Name[32];
+  snprintf(Name, sizeof(Name), "ana-%016llx",
+           (unsigned long long)pch::HashBytes(Key.begin(), Key.end()));
+  llvm::sys::Path EntryPath(Dir);
+  EntryPath.appendComponent(Name);
+  return EntryPath;
+}
+
+bool AnalysisCache::lookup(llvm::StringRef Key) const {
+  llvm::OwningPtr<llvm::MemoryBuffer> Buffer(
+                         llvm::MemoryBuffer::getFile(getEntryPath(Key).str()));
+  if (!Buffer)
+    return false;
+
+  std::string Entry = getEntry(Key);
+  return Buffer->getBufferSize() == Entry.size() &&
+         !memcmp(Buffer->getBufferStart(), Entry.data(), Entry.size());
+}
+
+void AnalysisCache::store(llvm::StringRef Key) const {
+  // Write to a temporary file first so that concurrent analyzers reading the
+  // cache never see a partially written entry.
+  llvm::sys::Path EntryPath = getEntryPath(Key);
+  llvm::sys::Path(Dir).createDirectoryOnDisk(/*create_parents=*/true);
+  AtomicOutputFile File(EntryPath.str());
+  std::string ErrorInfo;
+  if (File.open(ErrorInfo))
+    return;
+
+  File.getStream() << getEntry(Key);
+  File.commit(ErrorInfo);
+}
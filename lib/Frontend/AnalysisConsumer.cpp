@@ -21,6 +21,7 @@
 #include "clang/Analysis/Analyses/UninitializedValues.h"
 #include "clang/Analysis/CFG.h"
 #include "clang/Checker/Checkers/LocalCheckers.h"
+#include "clang/Checker/DomainSpecific/RetainSummaryTable.h"
 #include "clang/Checker/ManagerRegistry.h"
 #include "clang/Checker/BugReporter/PathDiagnostic.h"
 #include "clang/Checker/PathSensitive/AnalysisManager.h"
@@ -29,12 +30,23 @@
 #include "clang/Checker/PathSensitive/GRTransferFuncs.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/AnalysisCache.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/PathDiagnosticClients.h"
+#include "clang/Frontend/PCHBitCodes.h"
 #include "clang/Lex/Preprocessor.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Path.h"
 #include "llvm/System/Program.h"
+#include "llvm/System/TimeValue.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace clang;
 
@@ -56,6 +68,92 @@ CreatePlistHTMLDiagnosticClient(const std::string& prefix,
   return CreatePlistDiagnosticClient(prefix, PP, PD);
 }
 
+//===----------------------------------------------------------------------===//
+// Analysis statistics.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// AnalysisStats - The summary of a translation unit's analysis written to
+///  the -analyzer-stats-file: the time and the exploded graph nodes spent on
+///  each declaration, the budget it ran out of, and the reports, each with a
+///  hash that identifies it across runs.  Comparing runs only needs these
+///  files, not the reports they summarize.
+class AnalysisStats {
+  struct FunctionStats {
+    const Decl *D;
+    unsigned Millis;
+    unsigned Nodes;
+    GRCoreEngine::BudgetKind Budget;
+  };
+
+  /// Functions - The declarations analyzed so far.
+  std::vector<FunctionStats> Functions;
+
+  /// Reports - The lines describing the reports, in the order they were made.
+  std::vector<std::string> Reports;
+
+  /// Current - The declaration under analysis, if any.
+  const Decl *Current;
+
+  /// Start - When the analysis of Current started.
+  llvm::sys::TimeValue Start;
+
+public:
+  AnalysisStats() : Current(0) {}
+
+  void StartDecl(const Decl *D);
+  void FinishDecl();
+  void NoteGraph(unsigned Nodes, GRCoreEngine::BudgetKind Budget);
+  void AddReport(const PathDiagnostic &PD);
+  void Write(llvm::raw_ostream &OS, SourceManager &SM);
+};
+
+/// StatsDiagnosticClient - Records the reports in the AnalysisStats on their
+///  way to the PathDiagnosticClient rendering them, if there is one.
+class StatsDiagnosticClient : public PathDiagnosticClient {
+  AnalysisStats &Stats;
+  llvm::OwningPtr<PathDiagnosticClient> Next;
+
+public:
+  StatsDiagnosticClient(AnalysisStats &stats, PathDiagnosticClient *next)
+    : Stats(stats), Next(next) {}
+
+  virtual void
+  FlushDiagnostics(llvm::SmallVectorImpl<std::string> *FilesMade) {
+    if (Next)
+      Next->FlushDiagnostics(FilesMade);
+  }
+
+  virtual llvm::StringRef getName() const {
+    return "StatsDiagnosticClient";
+  }
+
+  virtual void HandlePathDiagnostic(const PathDiagnostic *D) {
+    if (D)
+      Stats.AddReport(*D);
+    if (Next)
+      Next->HandlePathDiagnostic(D);
+    else
+      delete D;
+  }
+
+  virtual PathGenerationScheme getGenerationScheme() const {
+    return Next ? Next->getGenerationScheme() : Minimal;
+  }
+  virtual bool supportsLogicalOpControlFlow() const {
+    return Next && Next->supportsLogicalOpControlFlow();
+  }
+  virtual bool supportsAllBlockEdges() const {
+    return Next && Next->supportsAllBlockEdges();
+  }
+  virtual bool useVerboseDescription() const {
+    return !Next || Next->useVerboseDescription();
+  }
+};
+
+} // end anonymous namespace
+
 //===----------------------------------------------------------------------===//
 // AnalysisConsumer declaration.
 //===----------------------------------------------------------------------===//
@@ -84,12 +182,36 @@ public:
   AnalyzerOptions Opts;
   bool declDisplayed;
 
+  /// NumCodeDecls - The number of declarations handed to HandleCode so far,
+  /// which assigns each of them to a shard.
+  unsigned NumCodeDecls;
+
+  /// ExceededBudgets - The declarations whose path-sensitive analysis ran
+  /// out of budget, and the budgets they exceeded.
+  std::vector<std::pair<const Decl*, GRCoreEngine::BudgetKind> >
+    ExceededBudgets;
+
+  /// Cache - The record of the declarations found free of bugs by earlier
+  /// runs, if there is one.
+  llvm::OwningPtr<AnalysisCache> Cache;
+
+  /// Stats - The summary written to the stats file, if there is one.
+  llvm::OwningPtr<AnalysisStats> Stats;
+
+  /// RetainSummaries - The stored retain/release summaries shared by the
+  ///  retain/release checks of all the analyzed declarations, if there are.
+  llvm::OwningPtr<RetainSummaryTable> RetainSummaries;
+
+  /// DeferredCode - The declarations that HandleCode leaves for the end of
+  /// the translation unit, when their cache keys can be computed.
+  std::vector<std::pair<Decl*, Actions*> > DeferredCode;
 
   // PD is owned by AnalysisManager.
   PathDiagnosticClient *PD;
 
   StoreManagerCreator CreateStoreMgr;
   ConstraintManagerCreator CreateConstraintMgr;
+  GRWorkListCreator CreateWorkList;
 
   llvm::OwningPtr<AnalysisManager> Mgr;
 
@@ -97,11 +219,17 @@ public:
                    const std::string& outdir,
                    const AnalyzerOptions& opts)
     : Ctx(0), PP(pp), OutDir(outdir),
-      Opts(opts), declDisplayed(false), PD(0) {
+      Opts(opts), declDisplayed(false), NumCodeDecls(0), PD(0) {
     DigestAnalyzerOptions();
   }
 
   void DigestAnalyzerOptions() {
+    if (!Opts.CacheDir.empty())
+      Cache.reset(new AnalysisCache(Opts.CacheDir));
+
+    if (!Opts.RetainSummaryFile.empty())
+      RetainSummaries.reset(new RetainSummaryTable(Opts.RetainSummaryFile));
+
     // Create the PathDiagnosticClient.
     if (!OutDir.empty()) {
       switch (Opts.AnalysisDiagOpt) {
@@ -112,6 +240,12 @@ public:
       }
     }
 
+    // The reports are recorded for the stats file on their way to PD.
+    if (!Opts.StatsFile.empty()) {
+      Stats.reset(new AnalysisStats());
+      PD = new StatsDiagnosticClient(*Stats, PD);
+    }
+
     // Create the analyzer component creators.
     if (ManagerRegistry::StoreMgrCreator != 0) {
       CreateStoreMgr = ManagerRegistry::StoreMgrCreator;
@@ -137,6 +271,14 @@ public:
 #include "clang/Frontend/Analyses.def"
       }
     }
+
+    switch (Opts.AnalysisWorkListOpt) {
+    default:
+      assert(0 && "Unknown worklist.");
+#define ANALYSIS_WORKLIST(NAME, CMDFLAG, DESC, CREATEFN)        \
+      case NAME##WorkList: CreateWorkList = CREATEFN; break;
+#include "clang/Frontend/Analyses.def"
+    }
   }
 
   void DisplayFunction(const Decl *D) {
@@ -158,6 +300,27 @@ public:
     }
   }
 
+  /// DisplayCoverage - Print how many of the basic blocks of \arg D the
+  /// path-sensitive analysis by \arg Eng entered.
+  void DisplayCoverage(const Decl *D, GRExprEngine &Eng) {
+    if (!Opts.AnalyzerDisplayProgress)
+      return;
+
+    const LocationContext *LC = Mgr->getStackFrame(D);
+    CFG *C = LC->getCFG();
+    llvm::BitVector Entered(C->getNumBlockIDs());
+    ExplodedGraph &G = Eng.getGraph();
+    for (ExplodedGraph::node_iterator I = G.nodes_begin(), E = G.nodes_end();
+         I != E; ++I)
+      if (const BlockEntrance *BE = I->getLocationAs<BlockEntrance>())
+        if (BE->getLocationContext() == LC)
+          Entered.set(BE->getBlock()->getBlockID());
+
+    // The entry and exit blocks are never entered.
+    llvm::errs() << "ANALYZE: coverage: " << Entered.count() << " of "
+                 << C->getNumBlockIDs() - 2 << " blocks\n";
+  }
+
   void addCodeAction(CodeAction action) {
     FunctionActions.push_back(action);
     ObjCMethodActions.push_back(action);
@@ -178,9 +341,26 @@ public:
                                   CreateStoreMgr, CreateConstraintMgr,
                                   Opts.VisualizeEGDot, Opts.VisualizeEGUbi,
                                   Opts.PurgeDead, Opts.EagerlyAssume,
-                                  Opts.TrimGraph));
+                                  Opts.TrimGraph, Opts.MaxNodes, Opts.MaxTime,
+                                  Opts.MaxMemory,
+                                  // The visualizers want every node.
+                                  Opts.VisualizeEGDot || Opts.VisualizeEGUbi ?
+                                    0 : Opts.ReclaimInterval,
+                                  CreateWorkList));
+  }
+
+  /// NoteAnalysis - Record the outcome of the path-sensitive analysis of
+  /// \arg D by \arg Eng.
+  void NoteAnalysis(const Decl *D, const GRExprEngine &Eng) {
+    if (Eng.getExceededBudget() != GRCoreEngine::NoBudget)
+      ExceededBudgets.push_back(std::make_pair(D, Eng.getExceededBudget()));
+    if (Stats)
+      Stats->NoteGraph(Eng.getGraph().size(), Eng.getExceededBudget());
   }
 
+  void PrintExceededBudgets();
+  void WriteStats();
+
   virtual void HandleTopLevelDecl(DeclGroupRef D) {
     declDisplayed = false;
     for (DeclGroupRef::iterator I = D.begin(), E = D.end(); I != E; ++I)
@@ -191,6 +371,9 @@ public:
   virtual void HandleTranslationUnit(ASTContext &C);
 
   void HandleCode(Decl* D, Stmt* Body, Actions& actions);
+  void AnalyzeCode(Decl *D, Stmt *Body, Actions &actions);
+  void AnalyzeDeferredCode();
+  std::string getCacheKeyPrefix();
 };
 } // end anonymous namespace
 
@@ -258,6 +441,21 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
         HandleCode(ID, 0, ObjCImplementationActions);
   }
 
+  AnalyzeDeferredCode();
+  PrintExceededBudgets();
+  WriteStats();
+  if (RetainSummaries)
+    RetainSummaries->write();
+
+  if (Opts.AnalyzerDisplayProgress) {
+    AnalysisContextManager &ACM = Mgr->getAnalysisContextManager();
+    unsigned NumCFGs;
+    size_t Bytes = ACM.getTotalMemory(NumCFGs);
+    llvm::errs() << "ANALYZE: " << NumCFGs << " CFGs of "
+                 << ACM.getNumContexts() << " declarations cached, "
+                 << ACM.getNumReuses() << " reuses, " << Bytes << " bytes\n";
+  }
+
   // Explicitly destroy the PathDiagnosticClient.  This will flush its output.
   // FIXME: This should be replaced with something that doesn't rely on
   // side-effects in PathDiagnosticClient's destructor. This is required when
@@ -265,6 +463,53 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   Mgr.reset(NULL);
 }
 
+static const char *getBudgetName(GRCoreEngine::BudgetKind Kind) {
+  switch (Kind) {
+  default:
+    assert(0 && "Unknown budget.");
+    return "";
+  case GRCoreEngine::StepBudget: return "step";
+  case GRCoreEngine::NodeBudget: return "node";
+  case GRCoreEngine::TimeBudget: return "time";
+  case GRCoreEngine::MemoryBudget: return "memory";
+  }
+}
+
+/// PrintExceededBudgets - Print the declarations that were only partially
+/// analyzed, so that the user knows which results may be incomplete.
+void AnalysisConsumer::PrintExceededBudgets() {
+  if (ExceededBudgets.empty())
+    return;
+
+  SourceManager &SM = Ctx->getSourceManager();
+  llvm::errs() << "ANALYZE: " << ExceededBudgets.size()
+               << " declaration(s) exceeded the analysis budget:\n";
+  for (unsigned I = 0, N = ExceededBudgets.size(); I != N; ++I) {
+    const Decl *D = ExceededBudgets[I].first;
+    PresumedLoc Loc = SM.getPresumedLoc(D->getLocation());
+    llvm::errs() << "  " << Loc.getFilename() << ':' << Loc.getLine() << ':';
+    if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+      llvm::errs() << ' ' << ND->getNameAsString();
+    llvm::errs() << " (" << getBudgetName(ExceededBudgets[I].second)
+                 << " budget)\n";
+  }
+}
+
+/// WriteStats - Write the stats file, if one was requested.
+void AnalysisConsumer::WriteStats() {
+  if (!Stats)
+    return;
+
+  std::string Err;
+  llvm::raw_fd_ostream OS(Opts.StatsFile.c_str(), Err);
+  if (!Err.empty()) {
+    PP.getDiagnostics().Report(diag::err_fe_error_opening)
+      << Opts.StatsFile << Err;
+    return;
+  }
+  Stats->Write(OS, Ctx->getSourceManager());
+}
+
 static void FindBlocks(DeclContext *D, llvm::SmallVectorImpl<Decl*> &WL) {
   if (BlockDecl *BD = dyn_cast<BlockDecl>(D))
     WL.push_back(BD);
@@ -287,8 +532,31 @@ void AnalysisConsumer::HandleCode(Decl *D, Stmt* Body, Actions& actions) {
       !Ctx->getSourceManager().isFromMainFile(D->getLocation()))
     return;
 
-  // Clear the AnalysisManager of old AnalysisContexts.
-  Mgr->ClearContexts();
+  // Declarations are dealt out to the shards in turn.  Every compiler of a
+  // sharded analysis sees them in the same order, so each one is analyzed,
+  // and its bugs reported, by exactly one shard.
+  if (NumCodeDecls++ % Opts.AnalyzerShards != Opts.AnalyzerShardIndex)
+    return;
+
+  // The cache key of D covers the whole translation unit, which is only known
+  // at its end.
+  if (Cache) {
+    DeferredCode.push_back(std::make_pair(D, &actions));
+    return;
+  }
+
+  AnalyzeCode(D, Body, actions);
+}
+
+void AnalysisConsumer::AnalyzeCode(Decl *D, Stmt *Body, Actions &actions) {
+  // Clear the AnalysisManager of old LocationContexts.  The AnalysisContexts
+  // live until the end of the translation unit: the path-sensitive analysis
+  // of a caller may already have built the CFG of D, and the actions share
+  // the CFG and liveness of D.
+  Mgr->ClearLocationContexts();
+
+  if (Stats)
+    Stats->StartDecl(D);
 
   // Dispatch on the actions.
   llvm::SmallVector<Decl*, 10> WL;
@@ -301,6 +569,292 @@ void AnalysisConsumer::HandleCode(Decl *D, Stmt* Body, Actions& actions) {
     for (llvm::SmallVectorImpl<Decl*>::iterator WI=WL.begin(), WE=WL.end();
          WI != WE; ++WI)
       (*I)(*this, *Mgr, *WI);
+
+  if (Stats)
+    Stats->FinishDecl();
+}
+
+//===----------------------------------------------------------------------===//
+// Analysis statistics.
+//===----------------------------------------------------------------------===//
+
+void AnalysisStats::StartDecl(const Decl *D) {
+  FunctionStats S = { D, 0, 0, GRCoreEngine::NoBudget };
+  Functions.push_back(S);
+  Current = D;
+  Start = llvm::sys::TimeValue::now();
+}
+
+void AnalysisStats::FinishDecl() {
+  llvm::sys::TimeValue Elapsed = llvm::sys::TimeValue::now() - Start;
+  Functions.back().Millis = Elapsed.seconds() * 1000 +
+                            Elapsed.microseconds() / 1000;
+  Current = 0;
+}
+
+/// NoteGraph - Add an exploded graph of the declaration under analysis.
+///  There are several when more than one path-sensitive analysis runs.
+void AnalysisStats::NoteGraph(unsigned Nodes,
+                              GRCoreEngine::BudgetKind Budget) {
+  if (!Current)
+    return;
+  FunctionStats &S = Functions.back();
+  S.Nodes += Nodes;
+  if (S.Budget == GRCoreEngine::NoBudget)
+    S.Budget = Budget;
+}
+
+static std::string getDeclName(const Decl *D) {
+  if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+    return ND->getNameAsString();
+  return "block";
+}
+
+/// AddReport - Record a report of the declaration under analysis.  Its hash
+///  covers the file and the declaration it is in, its position relative to
+///  the declaration, and its text, so editing other parts of the file leaves
+///  it unchanged.
+void AnalysisStats::AddReport(const PathDiagnostic &PD) {
+  if (PD.empty())
+    return;
+
+  FullSourceLoc L = PD.getLocation().asLocation().getInstantiationLoc();
+  const SourceManager &SM = L.getManager();
+  PresumedLoc Loc = SM.getPresumedLoc(L);
+
+  std::string Key = Loc.getFilename();
+  unsigned Line = Loc.getLine();
+  if (Current) {
+    PresumedLoc DeclLoc =
+      SM.getPresumedLoc(SM.getInstantiationLoc(Current->getLocation()));
+    Key += '\0';
+    Key += getDeclName(Current);
+    if (!strcmp(DeclLoc.getFilename(), Loc.getFilename()) &&
+        DeclLoc.getLine() <= Line)
+      Line -= DeclLoc.getLine();
+  }
+  Key += '\0';
+  Key += llvm::utostr(Line);
+  Key += '\0';
+  Key += PD.getCategory();
+  Key += '\0';
+  Key += PD.getBugType();
+  Key += '\0';
+  Key += PD.getDescription();
+
+  std::string Report;
+  llvm::raw_string_ostream OS(Report);
+  OS << "report\t"
+     << llvm::utohexstr(pch::HashBytes(Key.data(), Key.data() + Key.size()))
+     << '\t' << Loc.getFilename() << ':' << Loc.getLine() << ':'
+     << Loc.getColumn() << '\t' << PD.getCategory() << '\t'
+     << PD.getBugType() << '\t' << PD.getDescription();
+  Reports.push_back(OS.str());
+}
+
+/// Write - Print one tab-separated line for each analyzed declaration,
+///  giving its location, name, milliseconds, nodes and the budget it ran out
+///  of, followed by one for each report, giving its hash, location, category,
+///  bug type and description.
+void AnalysisStats::Write(llvm::raw_ostream &OS, SourceManager &SM) {
+  for (unsigned I = 0, N = Functions.size(); I != N; ++I) {
+    const FunctionStats &S = Functions[I];
+    PresumedLoc Loc = SM.getPresumedLoc(SM.getInstantiationLoc(
+                                          S.D->getLocation()));
+    OS << "function\t" << Loc.getFilename() << ':' << Loc.getLine() << '\t'
+       << getDeclName(S.D) << '\t' << S.Millis << '\t' << S.Nodes << '\t'
+       << (S.Budget == GRCoreEngine::NoBudget ? "-" : getBudgetName(S.Budget))
+       << '\n';
+  }
+  for (unsigned I = 0, N = Reports.size(); I != N; ++I)
+    OS << Reports[I] << '\n';
+}
+
+//===----------------------------------------------------------------------===//
+// Analysis cache.
+//===----------------------------------------------------------------------===//
+
+/// getSourceRange - Find the source text of the declaration D with a body,
+///  as an offset range in the file FID.  Returns false if the text is not
+///  contiguous in one file.
+static bool getSourceRange(SourceManager &SM, const Decl *D, FileID &FID,
+                           unsigned &Begin, unsigned &End) {
+  const Stmt *Body = D->getBody();
+  if (!Body)
+    return false;
+
+  SourceLocation B = D->getLocStart(), E = Body->getLocEnd();
+  if (B.isInvalid() || E.isInvalid() || B.isMacroID() || E.isMacroID())
+    return false;
+
+  std::pair<FileID, unsigned> BeginLoc = SM.getDecomposedLoc(B);
+  std::pair<FileID, unsigned> EndLoc = SM.getDecomposedLoc(E);
+  if (BeginLoc.first != EndLoc.first || BeginLoc.second > EndLoc.second)
+    return false;
+
+  FID = BeginLoc.first;
+  Begin = BeginLoc.second;
+  End = EndLoc.second + 1;
+  return true;
+}
+
+/// AddSourceText - Append the source text of D to Key.  Returns false if it
+///  cannot be found.
+static bool AddSourceText(SourceManager &SM, const Decl *D, std::string &Key) {
+  FileID FID;
+  unsigned Begin, End;
+  if (!getSourceRange(SM, D, FID, Begin, End))
+    return false;
+
+  std::pair<const char*, const char*> Data = SM.getBufferData(FID);
+  if (End > unsigned(Data.second - Data.first))
+    return false;
+
+  Key += '\0';
+  Key.append(Data.first + Begin, Data.first + End);
+  return true;
+}
+
+static void FindCallees(Stmt *S, llvm::SmallVectorImpl<const Decl*> &WL) {
+  if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+    const FunctionDecl *Def;
+    if (FunctionDecl *FD = CE->getDirectCallee())
+      if (FD->getBody(Def))
+        WL.push_back(Def);
+  }
+
+  for (Stmt::child_iterator I = S->child_begin(), E = S->child_end(); I != E;
+       ++I)
+    if (*I)
+      FindCallees(*I, WL);
+}
+
+/// AddCalleeText - Append the source text of the functions called from D,
+///  directly or not, to Key.  Returns false if one of them cannot be found.
+static bool AddCalleeText(SourceManager &SM, const Decl *D, std::string &Key) {
+  llvm::SmallPtrSet<const Decl*, 16> Visited;
+  llvm::SmallVector<const Decl*, 16> WL;
+  Visited.insert(D);
+  FindCallees(D->getBody(), WL);
+
+  while (!WL.empty()) {
+    const Decl *Callee = WL.back();
+    WL.pop_back();
+    if (!Visited.insert(Callee))
+      continue;
+
+    if (!AddSourceText(SM, Callee, Key))
+      return false;
+    FindCallees(Callee->getBody(), WL);
+  }
+  return true;
+}
+
+/// getCacheKeyPrefix - Returns the part of the cache keys shared by the
+///  declarations of the translation unit: the compiler, the configuration of
+///  the analyzer, and the source of the translation unit without the text of
+///  the deferred declarations.  Each of the latter is in its own key, so
+///  editing one of them leaves the keys of the others unchanged.
+std::string AnalysisConsumer::getCacheKeyPrefix() {
+  std::string Prefix;
+  llvm::raw_string_ostream OS(Prefix);
+  OS << getClangFullRepositoryVersion() << '\0';
+  for (unsigned I = 0, N = Opts.AnalysisList.size(); I != N; ++I)
+    OS << Opts.AnalysisList[I] << ' ';
+  OS << Opts.AnalysisStoreOpt << ' ' << Opts.AnalysisConstraintsOpt << ' '
+     << Opts.AnalysisWorkListOpt << ' ' << Opts.AnalysisDiagOpt << ' '
+     << Opts.MaxNodes << ' ' << Opts.MaxTime << ' ' << Opts.MaxMemory << ' '
+     << Opts.ReclaimInterval << ' ' << Opts.AnalyzeNestedBlocks
+     << Opts.EagerlyAssume << Opts.PurgeDead << Opts.EnableExperimentalChecks
+     << Opts.EnableExperimentalInternalChecks << Opts.SummarizeCalls << '\0'
+     << PP.getPredefines() << '\0';
+
+  // Cut the deferred declarations out of the main file.
+  SourceManager &SM = Ctx->getSourceManager();
+  FileID MainFID = SM.getMainFileID();
+  std::vector<std::pair<unsigned, unsigned> > Ranges;
+  for (unsigned I = 0, N = DeferredCode.size(); I != N; ++I) {
+    FileID FID;
+    unsigned Begin, End;
+    if (getSourceRange(SM, DeferredCode[I].first, FID, Begin, End) &&
+        FID == MainFID)
+      Ranges.push_back(std::make_pair(Begin, End));
+  }
+  std::sort(Ranges.begin(), Ranges.end());
+
+  std::pair<const char*, const char*> Main = SM.getBufferData(MainFID);
+  std::string Text;
+  unsigned Offset = 0, Size = Main.second - Main.first;
+  for (unsigned I = 0, N = Ranges.size(); I != N; ++I) {
+    unsigned Begin = std::min(Ranges[I].first, Size);
+    if (Begin > Offset)
+      Text.append(Main.first + Offset, Main.first + Begin);
+    Offset = std::max(Offset, std::min(Ranges[I].second, Size));
+  }
+  Text.append(Main.first + Offset, Main.second);
+
+  // The other files are visited in no particular order, so their hashes are
+  // combined by a sum.
+  uint64_t Hash = pch::HashBytes(Text.data(), Text.data() + Text.size());
+  const FileEntry *MainFile = SM.getFileEntryForID(MainFID);
+  for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
+         E = SM.fileinfo_end(); I != E; ++I) {
+    if (I->first == MainFile)
+      continue;
+    std::string File = I->first->getName();
+    File += '\0';
+    const llvm::MemoryBuffer *Buffer = I->second->getBuffer();
+    File.append(Buffer->getBufferStart(), Buffer->getBufferEnd());
+    Hash += pch::HashBytes(File.data(), File.data() + File.size());
+  }
+  OS << Hash;
+  return OS.str();
+}
+
+/// AnalyzeDeferredCode - Analyze the declarations left by HandleCode,
+///  skipping the ones in which an earlier run with the same cache key found
+///  no bugs.  Only such results are cached, so that the reports of the other
+///  declarations never go stale.
+void AnalysisConsumer::AnalyzeDeferredCode() {
+  if (DeferredCode.empty() || PP.getDiagnostics().hasErrorOccurred())
+    return;
+
+  SourceManager &SM = Ctx->getSourceManager();
+  Diagnostic &Diags = PP.getDiagnostics();
+  std::string Prefix = getCacheKeyPrefix();
+  bool AddCallees = Opts.SummarizeCalls ||
+    std::find(Opts.AnalysisList.begin(), Opts.AnalysisList.end(),
+              InlineCall) != Opts.AnalysisList.end();
+
+  for (unsigned I = 0, N = DeferredCode.size(); I != N; ++I) {
+    Decl *D = DeferredCode[I].first;
+    std::string Key = Prefix;
+    bool Cacheable = AddSourceText(SM, D, Key) &&
+                     (!AddCallees || AddCalleeText(SM, D, Key));
+
+    if (Cacheable && Cache->lookup(Key)) {
+      if (Opts.AnalyzerDisplayProgress) {
+        PresumedLoc Loc = SM.getPresumedLoc(D->getLocation());
+        llvm::errs() << "ANALYZE: " << Loc.getFilename();
+        if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+          llvm::errs() << ' ' << ND->getNameAsString();
+        llvm::errs() << " (no bugs in an earlier run)\n";
+      }
+      continue;
+    }
+
+    unsigned NumReports = Mgr->getNumReports();
+    unsigned NumDiagnostics = Diags.getNumDiagnostics();
+    unsigned NumExceeded = ExceededBudgets.size();
+    declDisplayed = false;
+    AnalyzeCode(D, D->getBody(), *DeferredCode[I].second);
+
+    // A declaration only partially analyzed may have bugs left to find.
+    if (Cacheable && Mgr->getNumReports() == NumReports &&
+        Diags.getNumDiagnostics() == NumDiagnostics &&
+        ExceededBudgets.size() == NumExceeded)
+      Cache->store(Key);
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -350,6 +904,9 @@ static void ActionGRExprEngine(AnalysisConsumer &C, AnalysisManager& mgr,
   if (C.Opts.EnableExperimentalChecks)
     RegisterExperimentalChecks(Eng);
 
+  if (C.Opts.SummarizeCalls)
+    RegisterCallSummarizer(Eng);
+
   // Set the graph auditor.
   llvm::OwningPtr<ExplodedNode::Auditor> Auditor;
   if (mgr.shouldVisualizeUbigraph()) {
@@ -359,6 +916,10 @@ static void ActionGRExprEngine(AnalysisConsumer &C, AnalysisManager& mgr,
 
   // Execute the worklist algorithm.
   Eng.ExecuteWorkList(mgr.getStackFrame(D));
+  C.NoteAnalysis(D, Eng);
+  C.DisplayCoverage(D, Eng);
+  if (C.Opts.StateStats)
+    Eng.getStateManager().PrintStats();
 
   // Release the auditor (if any) so that it doesn't monitor the graph
   // created BugReporter.
@@ -377,7 +938,8 @@ static void ActionObjCMemCheckerAux(AnalysisConsumer &C, AnalysisManager& mgr,
 
   GRTransferFuncs* TF = MakeCFRefCountTF(mgr.getASTContext(),
                                          GCEnabled,
-                                         mgr.getLangOptions());
+                                         mgr.getLangOptions(),
+                                         C.RetainSummaries.get());
 
   ActionGRExprEngine(C, mgr, D, TF);
 }
@@ -514,6 +1076,9 @@ static void ActionInlineCall(AnalysisConsumer &C, AnalysisManager &mgr,
 
   // Execute the worklist algorithm.
   Eng.ExecuteWorkList(mgr.getStackFrame(D));
+  C.NoteExceededBudget(D, Eng);
+  if (C.Opts.StateStats)
+    Eng.getStateManager().PrintStats();
 
   // Visualize the exploded graph.
   if (mgr.shouldVisualizeGraphviz())
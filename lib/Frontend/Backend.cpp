@@ -11,14 +11,17 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/TargetOptions.h"
 #include "clang/CodeGen/CodeGenOptions.h"
 #include "clang/CodeGen/ModuleBuilder.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "llvm/Instructions.h"
 #include "llvm/Module.h"
 #include "llvm/PassManager.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/Verifier.h"
@@ -28,11 +31,13 @@
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/StandardPasses.h"
 #include "llvm/Support/Timer.h"
+#include "llvm/Support/ValueHandle.h"
 #include "llvm/Target/SubtargetFeature.h"
 #include "llvm/Target/TargetData.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/Target/TargetRegistry.h"
+#include "llvm/Transforms/Scalar.h"
 using namespace clang;
 using namespace llvm;
 
@@ -59,6 +64,10 @@ namespace {
     mutable PassManager *PerModulePasses;
     mutable FunctionPassManager *PerFunctionPasses;
 
+    /// HugeFunctionPasses - The cheaper per-function passes for functions
+    /// beyond CodeGenOpts.HugeFunctionThreshold, if there is such a limit.
+    FunctionPassManager *HugeFunctionPasses;
+
     FunctionPassManager *getCodeGenPasses() const;
     PassManager *getPerModulePasses() const;
     FunctionPassManager *getPerFunctionPasses() const;
@@ -70,6 +79,30 @@ namespace {
     /// \return True on success.
     bool AddEmitPasses();
 
+    /// PassesStarted, PassesFailed - Whether the passes have been created and
+    /// the function pass managers initialized, and whether that failed.
+    bool PassesStarted, PassesFailed;
+
+    /// StartPasses - Create and initialize the passes, unless that has been
+    /// done already.
+    ///
+    /// \return True on success.
+    bool StartPasses();
+
+    /// Streaming - Whether machine code is emitted for each function as soon
+    /// as IR generation has finished it, instead of for the whole module at
+    /// the end of the translation unit.
+    bool Streaming;
+
+    /// LastScannedFunction - The last function of the module when functions
+    /// were last streamed; only the functions after it are candidates.
+    llvm::WeakVH LastScannedFunction;
+
+    /// StreamedFunctions - The functions whose code has been emitted already.
+    llvm::SmallPtrSet<const llvm::Function *, 64> StreamedFunctions;
+
+    void StreamFunctions();
+
     void EmitAssembly();
 
   public:
@@ -88,7 +121,9 @@ namespace {
       CodeGenerationTime("Code Generation Time"),
       Gen(CreateLLVMCodeGen(Diags, infile, compopts, C)),
       TheModule(0), TheTargetData(0),
-      CodeGenPasses(0), PerModulePasses(0), PerFunctionPasses(0) {
+      CodeGenPasses(0), PerModulePasses(0), PerFunctionPasses(0),
+      HugeFunctionPasses(0),
+      PassesStarted(false), PassesFailed(false), Streaming(false) {
 
       if (AsmOutStream)
         FormattedOutStream.setStream(*AsmOutStream,
@@ -103,6 +138,7 @@ namespace {
       delete CodeGenPasses;
       delete PerModulePasses;
       delete PerFunctionPasses;
+      delete HugeFunctionPasses;
     }
 
     virtual void Initialize(ASTContext &Ctx) {
@@ -116,6 +152,14 @@ namespace {
       TheModule = Gen->GetModule();
       TheTargetData = new llvm::TargetData(Ctx.Target.getTargetDescription());
 
+      // Once a function has been emitted, nothing may change it any more.
+      // Only -O0 has no module passes but the always-inliner, and debug
+      // information is collected for the whole module before any function.
+      Streaming = CodeGenOpts.StreamingCodeGen &&
+        (Action == Backend_EmitAssembly || Action == Backend_EmitObj) &&
+        CodeGenOpts.OptimizationLevel == 0 && !CodeGenOpts.DebugInfo &&
+        CodeGenOpts.Inlining != CodeGenOptions::NormalInlining;
+
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.stopTimer();
     }
@@ -124,6 +168,7 @@ namespace {
       PrettyStackTraceDecl CrashInfo(*D.begin(), SourceLocation(),
                                      Context->getSourceManager(),
                                      "LLVM IR generation of declaration");
+      PhaseRegion Phase("IR generation");
 
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.startTimer();
@@ -132,11 +177,15 @@ namespace {
 
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.stopTimer();
+
+      if (Streaming)
+        StreamFunctions();
     }
 
     virtual void HandleTranslationUnit(ASTContext &C) {
       {
         PrettyStackTraceString CrashInfo("Per-file LLVM IR generation");
+        PhaseRegion Phase("IR generation");
         if (llvm::TimePassesIsEnabled)
           LLVMIRGeneration.startTimer();
 
@@ -164,6 +213,10 @@ namespace {
     virtual void CompleteTentativeDefinition(VarDecl *D) {
       Gen->CompleteTentativeDefinition(D);
     }
+
+    virtual void PrintStats() {
+      Gen->PrintStats();
+    }
   };
 }
 
@@ -336,6 +389,16 @@ void BackendConsumer::CreatePasses() {
   if (OptLevel > 0)
     llvm::createStandardFunctionPasses(getPerFunctionPasses(), OptLevel);
 
+  // Huge functions only get the passes whose cost is linear in their size.
+  if (OptLevel > 0 && CodeGenOpts.HugeFunctionThreshold) {
+    HugeFunctionPasses = new FunctionPassManager(TheModule);
+    HugeFunctionPasses->add(new TargetData(*TheTargetData));
+    if (CodeGenOpts.VerifyModule)
+      HugeFunctionPasses->add(createVerifierPass());
+    HugeFunctionPasses->add(createPromoteMemoryToRegisterPass());
+    HugeFunctionPasses->add(createCFGSimplificationPass());
+  }
+
   llvm::Pass *InliningPass = 0;
   switch (Inlining) {
   case CodeGenOptions::NoInlining: break;
@@ -366,6 +429,105 @@ void BackendConsumer::CreatePasses() {
                                    InliningPass);
 }
 
+bool BackendConsumer::StartPasses() {
+  if (PassesStarted)
+    return !PassesFailed;
+
+  PassesStarted = true;
+  CreatePasses();
+  if (!AddEmitPasses()) {
+    PassesFailed = true;
+    return false;
+  }
+
+  if (PerFunctionPasses)
+    PerFunctionPasses->doInitialization();
+  if (HugeFunctionPasses)
+    HugeFunctionPasses->doInitialization();
+  if (CodeGenPasses)
+    CodeGenPasses->doInitialization();
+  return true;
+}
+
+/// RunOnFunction - Run \p Passes over \p F, timed as the phase \p Name of
+/// the function.
+static void RunOnFunction(FunctionPassManager &Passes, Function &F,
+                          const char *Name) {
+  PhaseRegion Phase;
+  if (PhaseStatistics::getActive())
+    Phase.enter(Name, F.getName());
+  Passes.run(F);
+}
+
+/// isHugeFunction - Whether \p F has more than \p Threshold instructions.
+static bool isHugeFunction(const Function &F, unsigned Threshold) {
+  unsigned Size = 0;
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    Size += BB->size();
+    if (Size > Threshold)
+      return true;
+  }
+  return false;
+}
+
+/// CallsAlwaysInline - Whether \p F calls a function that must be inlined,
+/// which only happens in the module passes.
+static bool CallsAlwaysInline(const Function &F) {
+  for (Function::const_iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB)
+    for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+         I != IE; ++I) {
+      const Function *Callee = 0;
+      if (const CallInst *CI = dyn_cast<CallInst>(I))
+        Callee = CI->getCalledFunction();
+      else if (const InvokeInst *II = dyn_cast<InvokeInst>(I))
+        Callee = II->getCalledFunction();
+      if (Callee && Callee->hasFnAttr(Attribute::AlwaysInline))
+        return true;
+    }
+  return false;
+}
+
+/// StreamFunctions - Emit the code of the functions that IR generation has
+/// finished since the last call.
+///
+/// The functions created while generating the last top-level declaration
+/// are at the end of the module.  Those with a body are complete, and only
+/// their uses can still change, which does not affect their own code.
+/// Functions that were declared earlier and defined only now are left to
+/// the end of the translation unit, like those the always-inliner has to
+/// see.
+void BackendConsumer::StreamFunctions() {
+  if (Diags.hasErrorOccurred())
+    return;
+
+  Module::iterator I = TheModule->begin(), E = TheModule->end();
+  if (I == E)
+    return;
+  if (LastScannedFunction)
+    I = ++Module::iterator(cast<Function>(LastScannedFunction));
+  LastScannedFunction = &TheModule->back();
+
+  TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : 0);
+  PhaseRegion Phase("LLVM backend");
+  PrettyStackTraceString CrashInfo("Streaming code generation");
+  for (; I != E; ++I) {
+    if (I->isDeclaration() || StreamedFunctions.count(I) ||
+        I->hasFnAttr(Attribute::AlwaysInline) || CallsAlwaysInline(*I))
+      continue;
+
+    if (!StartPasses()) {
+      Streaming = false;
+      return;
+    }
+
+    if (PerFunctionPasses)
+      RunOnFunction(*PerFunctionPasses, *I, "Optimize function");
+    if (CodeGenPasses)
+      RunOnFunction(*CodeGenPasses, *I, "Generate machine code");
+    StreamedFunctions.insert(I);
+  }
+}
+
 /// EmitAssembly - Handle interaction with LLVM backend to generate
 /// actual machine code.
 void BackendConsumer::EmitAssembly() {
@@ -374,6 +536,7 @@ void BackendConsumer::EmitAssembly() {
     return;
 
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : 0);
+  PhaseRegion Phase("LLVM backend");
 
   // Make sure IR generation is happy with the module. This is
   // released by the module provider.
@@ -387,34 +550,44 @@ void BackendConsumer::EmitAssembly() {
 
   assert(TheModule == M && "Unexpected module change during IR generation");
 
-  CreatePasses();
-  if (!AddEmitPasses())
+  if (!StartPasses())
     return;
 
-  // Run passes. For now we do all passes at once, but eventually we
-  // would like to have the option of streaming code generation.
+  // Run passes.  With streaming code generation, the functions that have
+  // been emitted already are skipped.
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
 
-    PerFunctionPasses->doInitialization();
-    for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
-      if (!I->isDeclaration())
-        PerFunctionPasses->run(*I);
+    for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I) {
+      if (I->isDeclaration() || StreamedFunctions.count(I))
+        continue;
+
+      // Inlining a huge function would make its callers huge as well.
+      if (HugeFunctionPasses &&
+          isHugeFunction(*I, CodeGenOpts.HugeFunctionThreshold)) {
+        I->addFnAttr(Attribute::NoInline);
+        RunOnFunction(*HugeFunctionPasses, *I, "Optimize huge function");
+      } else {
+        RunOnFunction(*PerFunctionPasses, *I, "Optimize function");
+      }
+    }
     PerFunctionPasses->doFinalization();
+    if (HugeFunctionPasses)
+      HugeFunctionPasses->doFinalization();
   }
 
   if (PerModulePasses) {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    PhaseRegion Phase("Optimize module");
     PerModulePasses->run(*M);
   }
 
   if (CodeGenPasses) {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses->doInitialization();
     for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
-      if (!I->isDeclaration())
-        CodeGenPasses->run(*I);
+      if (!I->isDeclaration() && !StreamedFunctions.count(I))
+        RunOnFunction(*CodeGenPasses, *I, "Generate machine code");
     CodeGenPasses->doFinalization();
   }
 }
@@ -221,7 +221,7 @@ public:
     : Out(out), PP(pp), idcount(0), CurStrOffset(0) {}
 
   PTHMap &getPM() { return PM; }
-  void GeneratePTH(const std::string *MainFile = 0);
+  void GeneratePTH(const std::string *MainFile = 0, unsigned Flags = 0);
 };
 } // end anonymous namespace
 
@@ -443,15 +443,16 @@ Offset PTHWriter::EmitCachedSpellings() {
   return SpellingsOff;
 }
 
-void PTHWriter::GeneratePTH(const std::string *MainFile) {
+void PTHWriter::GeneratePTH(const std::string *MainFile, unsigned Flags) {
   // Generate the prologue.
   Out << "cfe-pth";
   Emit32(PTHManager::Version);
 
-  // Leave 4 words for the prologue.
+  // Leave 4 words for the prologue, followed by the flags.
   Offset PrologueOffset = Out.tell();
   for (unsigned i = 0; i < 4; ++i)
     Emit32(0);
+  Emit32(Flags);
 
   // Write the name of the MainFile.
   if (MainFile && !MainFile->empty()) {
@@ -535,7 +536,8 @@ public:
 } // end anonymous namespace
 
 
-void clang::CacheTokens(Preprocessor &PP, llvm::raw_fd_ostream* OS) {
+void clang::CacheTokens(Preprocessor &PP, llvm::raw_fd_ostream* OS,
+                        const std::vector<std::string> &MergedFiles) {
   // Get the name of the main file.
   const SourceManager &SrcMgr = PP.getSourceManager();
   const FileEntry *MainFile = SrcMgr.getFileEntryForID(SrcMgr.getMainFileID());
@@ -563,9 +565,22 @@ void clang::CacheTokens(Preprocessor &PP, llvm::raw_fd_ostream* OS) {
   PP.EnterMainSourceFile();
   do { PP.Lex(Tok); } while (Tok.isNot(tok::eof));
 
-  // Generate the PTH file.
   PP.getFileManager().removeStatCache(StatCache);
-  PW.GeneratePTH(&MainFileName);
+
+  // Carry over the files of the PTH file being merged.  Each is lexed again
+  // from disk, so files that changed since they were cached are brought up to
+  // date and files that no longer exist are dropped.
+  unsigned Flags = 0;
+  if (!MergedFiles.empty()) {
+    SourceManager &SM = PP.getSourceManager();
+    for (unsigned i = 0, e = MergedFiles.size(); i != e; ++i)
+      if (const FileEntry *FE = PP.getFileManager().getFile(MergedFiles[i]))
+        SM.createFileID(FE, SourceLocation(), SrcMgr::C_User);
+    Flags |= PTHManager::SharedStore;
+  }
+
+  // Generate the PTH file.
+  PW.GeneratePTH(&MainFileName, Flags);
 }
 
 //===----------------------------------------------------------------------===//
@@ -10,9 +10,12 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/Basic/Builtins.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Basic/StatSnapshot.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Version.h"
 #include "clang/Lex/HeaderSearch.h"
@@ -20,23 +23,28 @@
 #include "clang/Lex/PTHManager.h"
 #include "clang/Frontend/ChainedDiagnosticClient.h"
 #include "clang/Frontend/FrontendAction.h"
+#include "clang/Frontend/IncludeCostReport.h"
 #include "clang/Frontend/PCHReader.h"
+#include "clang/Frontend/SerializedDiagnostics.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Frontend/VerifyDiagnosticsClient.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
+#include "clang/Sema/InstantiationProfile.h"
 #include "llvm/LLVMContext.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/System/Host.h"
 #include "llvm/System/Path.h"
 #include "llvm/System/Program.h"
+#include <cstdio>
 using namespace clang;
 
 CompilerInstance::CompilerInstance()
-  : Invocation(new CompilerInvocation()) {
+  : Invocation(new CompilerInvocation()), IncludeCosts(0) {
 }
 
 CompilerInstance::~CompilerInstance() {
@@ -72,6 +80,29 @@ void CompilerInstance::setSourceManager(SourceManager *Value) {
 
 void CompilerInstance::setPreprocessor(Preprocessor *Value) {
   PP.reset(Value);
+  IncludeCosts = 0;
+}
+
+void CompilerInstance::WriteIncludeCostReport() {
+  assert(IncludeCosts && "Compiler instance has no include cost report!");
+
+  // Every translation unit appends its report to the same file.
+  if (!IncludeCostStream) {
+    const std::string &Path = getFrontendOpts().IncludeCostFile;
+    std::string Error;
+    IncludeCostStream.reset(new llvm::raw_fd_ostream(Path.c_str(), Error));
+    if (!Error.empty()) {
+      getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Path << Error;
+      IncludeCostStream.reset();
+      IncludeCosts = 0;
+      return;
+    }
+  }
+
+  IncludeCosts->WriteReport(*IncludeCostStream,
+                            hasASTContext() ? &getASTContext() : 0);
+  IncludeCostStream->flush();
 }
 
 void CompilerInstance::setASTContext(ASTContext *Value) {
@@ -87,24 +118,6 @@ void CompilerInstance::setCodeCompletionConsumer(CodeCompleteConsumer *Value) {
 }
 
 // Diagnostics
-namespace {
-  class BinaryDiagnosticSerializer : public DiagnosticClient {
-    llvm::raw_ostream &OS;
-    SourceManager *SourceMgr;
-  public:
-    explicit BinaryDiagnosticSerializer(llvm::raw_ostream &OS)
-      : OS(OS), SourceMgr(0) { }
-    
-    virtual void HandleDiagnostic(Diagnostic::Level DiagLevel,
-                                  const DiagnosticInfo &Info);
-  };
-}
-
-void BinaryDiagnosticSerializer::HandleDiagnostic(Diagnostic::Level DiagLevel,
-                                                  const DiagnosticInfo &Info) {
-  StoredDiagnostic(DiagLevel, Info).Serialize(OS);
-}
-
 static void SetUpBuildDumpLog(const DiagnosticOptions &DiagOpts,
                               unsigned argc, char **argv,
                               llvm::OwningPtr<DiagnosticClient> &DiagClient) {
@@ -155,7 +168,7 @@ Diagnostic *CompilerInstance::createDiagnostics(const DiagnosticOptions &Opts,
       Diags->Report(diag::err_fe_stderr_binary);
       return Diags.take();
     } else {
-      DiagClient.reset(new BinaryDiagnosticSerializer(llvm::errs()));
+      DiagClient.reset(new SerializedDiagnosticPrinter(llvm::errs()));
     }
   } else {
     DiagClient.reset(new TextDiagnosticPrinter(llvm::errs(), Opts));
@@ -182,10 +195,30 @@ void CompilerInstance::createFileManager() {
   FileMgr.reset(new FileManager());
 }
 
+void CompilerInstance::createVirtualFileOverlay() {
+  const std::vector<std::pair<std::string, std::string> > &Files
+    = getFrontendOpts().OverlayFiles;
+  VirtualFileOverlay *Overlay = new VirtualFileOverlay();
+  for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+    std::string ErrorStr;
+    const llvm::MemoryBuffer *Buffer
+      = llvm::MemoryBuffer::getFile(Files[i].second.c_str(), &ErrorStr);
+    if (!Buffer) {
+      getDiagnostics().Report(diag::err_fe_error_opening)
+        << Files[i].second << ErrorStr;
+      continue;
+    }
+    Overlay->addFile(Files[i].first, Buffer);
+  }
+  getFileManager().setVirtualFileOverlay(Overlay);
+}
+
 // Source Manager
 
 void CompilerInstance::createSourceManager() {
   SourceMgr.reset(new SourceManager());
+  if (hasFileManager())
+    SourceMgr->setFileOverlay(getFileManager().getVirtualFileOverlay());
 }
 
 // Preprocessor
@@ -196,6 +229,12 @@ void CompilerInstance::createPreprocessor() {
                               getDependencyOutputOpts(), getTarget(),
                               getFrontendOpts(), getSourceManager(),
                               getFileManager()));
+
+  IncludeCosts = 0;
+  if (!getFrontendOpts().IncludeCostFile.empty()) {
+    IncludeCosts = new IncludeCostReport(*PP);
+    PP->setPPCallbacks(IncludeCosts);
+  }
 }
 
 Preprocessor *
@@ -217,7 +256,8 @@ CompilerInstance::createPreprocessor(Diagnostic &Diags,
   HeaderSearch *HeaderInfo = new HeaderSearch(FileMgr);
   Preprocessor *PP = new Preprocessor(Diags, LangInfo, Target,
                                       SourceMgr, *HeaderInfo, PTHMgr,
-                                      /*OwnsHeaderSearch=*/true);
+                                      /*OwnsHeaderSearch=*/true,
+                                      PPOpts.SharedIdentifiers);
 
   // Note that this is different then passing PTHMgr to Preprocessor's ctor.
   // That argument is used as the IdentifierInfoLookup argument to
@@ -233,6 +273,17 @@ CompilerInstance::createPreprocessor(Diagnostic &Diags,
   if (!DepOpts.OutputFile.empty())
     AttachDependencyFileGen(*PP, DepOpts);
 
+  if (!DepOpts.HeaderManifestFile.empty())
+    AttachHeaderManifestGen(*PP, DepOpts);
+
+  if (!DepOpts.HeaderMacroDepsFile.empty())
+    AttachHeaderMacroDepsGen(*PP, DepOpts);
+
+  // This must come after the dependency file generator, which insists on being
+  // the first callback.
+  if (PPOpts.IncludePrefetchThreads)
+    AttachIncludePrefetcher(*PP, PPOpts.IncludePrefetchThreads);
+
   return PP;
 }
 
@@ -295,17 +346,110 @@ void CompilerInstance::createCodeCompletionConsumer() {
                                  getFrontendOpts().ShowMacrosInCodeCompletion,
                                  llvm::outs()));
 
+  if (!CompletionConsumer)
+    return;
+
+  CompletionConsumer->setResultFilter(getFrontendOpts().CodeCompletionPrefix,
+                                  getFrontendOpts().CodeCompletionMaxResults);
+
   if (CompletionConsumer->isOutputBinary() &&
       llvm::sys::Program::ChangeStdoutToBinary()) {
     getPreprocessor().getDiagnostics().Report(diag::err_fe_stdout_binary);
     CompletionConsumer.reset();
+    return;
   }
+
+  // The results for the global declarations of a PCH file are the same for
+  // every completion against it, so they are cached under a name derived from
+  // the identity of the PCH file.
+  const std::string &CacheDir = getFrontendOpts().CodeCompletionCacheDir;
+  const std::string &PCHInclude = getPreprocessorOpts().ImplicitPCHInclude;
+  if (CacheDir.empty() || PCHInclude.empty())
+    return;
+
+  const FileEntry *PCHFile = getFileManager().getFile(PCHInclude);
+  if (!PCHFile)
+    return;
+
+  std::string Key = PCHFile->getName();
+  Key += ':';
+  Key += llvm::utostr(PCHFile->getSize());
+  Key += ':';
+  Key += llvm::utostr(PCHFile->getModificationTime());
+
+  char Name[32];
+  snprintf(Name, sizeof(Name), "completions-%08x", llvm::HashString(Key));
+  llvm::sys::Path Path(CacheDir);
+  Path.appendComponent(Name);
+
+  // The cache is only an optimization; failing to create it is harmless.
+  llvm::sys::Path(CacheDir).createDirectoryOnDisk(/*create_parents=*/true);
+  CompletionConsumer->setGlobalResultsCache(Path.str(), Key);
 }
 
 void CompilerInstance::createFrontendTimer() {
   FrontendTimer.reset(new llvm::Timer("Clang front-end timer"));
 }
 
+void CompilerInstance::createSharedIdentifierTable() {
+  SharedIdentifiers.reset(new SharedIdentifierTable(getLangOpts()));
+
+  // The seed recognizes the builtins through this context, which only needs
+  // to live until the table is frozen.
+  Builtin::Context Builtins(getTarget());
+  Builtins.InitializeBuiltins(SharedIdentifiers->getSeed(),
+                              getLangOpts().NoBuiltin);
+  SharedIdentifiers->freeze();
+  getPreprocessorOpts().SharedIdentifiers = SharedIdentifiers.get();
+}
+
+void CompilerInstance::createPhaseStatistics() {
+  PhaseStats.reset(new PhaseStatistics());
+  PhaseStatistics::setActive(PhaseStats.get());
+}
+
+void CompilerInstance::WritePhaseStatistics() {
+  const std::string &Path = getFrontendOpts().PhaseStatsFile;
+  std::string Error;
+  llvm::raw_fd_ostream OS(Path.c_str(), Error);
+  if (!Error.empty()) {
+    getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+      << Path << Error;
+    return;
+  }
+
+  getPhaseStatistics().WriteJSON(OS);
+}
+
+void CompilerInstance::createInstantiationProfile() {
+  bool RecordTrace = !getFrontendOpts().TemplateProfileTraceFile.empty();
+  TemplateProfile.reset(new InstantiationProfile(RecordTrace));
+  InstantiationProfile::setActive(TemplateProfile.get());
+}
+
+void CompilerInstance::WriteInstantiationProfile() {
+  const FrontendOptions &Opts = getFrontendOpts();
+  std::string Error;
+  if (!Opts.TemplateProfileFile.empty()) {
+    llvm::raw_fd_ostream OS(Opts.TemplateProfileFile.c_str(), Error);
+    if (!Error.empty())
+      getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Opts.TemplateProfileFile << Error;
+    else
+      getInstantiationProfile().WriteReport(OS);
+  }
+
+  Error.clear();
+  if (!Opts.TemplateProfileTraceFile.empty()) {
+    llvm::raw_fd_ostream OS(Opts.TemplateProfileTraceFile.c_str(), Error);
+    if (!Error.empty())
+      getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Opts.TemplateProfileTraceFile << Error;
+    else
+      getInstantiationProfile().WriteTrace(OS);
+  }
+}
+
 CodeCompleteConsumer *
 CompilerInstance::createCodeCompletionConsumer(Preprocessor &PP,
                                                const std::string &Filename,
@@ -482,6 +626,21 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   if (getFrontendOpts().ShowTimers)
     createFrontendTimer();
 
+  if (!getFrontendOpts().PhaseStatsFile.empty())
+    createPhaseStatistics();
+
+  if (getFrontendOpts().ShareIdentifiers)
+    createSharedIdentifierTable();
+
+  if (!getFrontendOpts().TemplateProfileFile.empty() ||
+      !getFrontendOpts().TemplateProfileTraceFile.empty())
+    createInstantiationProfile();
+
+  // The stat caches reading and writing stat snapshots, if any.  They are
+  // owned by the file manager.
+  StatSnapshotCache *StatSnapshot = 0;
+  StatSnapshotRecorder *StatRecorder = 0;
+
   for (unsigned i = 0, e = getFrontendOpts().Inputs.size(); i != e; ++i) {
     const std::string &InFile = getFrontendOpts().Inputs[i].second;
 
@@ -493,6 +652,27 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
         // Create a file manager object to provide access to and cache the
         // filesystem.
         createFileManager();
+        if (getFrontendOpts().CacheDirectoryListings)
+          getFileManager().setCacheDirectoryListings(true);
+
+        // Answer stat() calls from the shared snapshot, if there is one.  It
+        // stays at the end of the chain, so the PCH and PTH stat caches
+        // installed later still take precedence.
+        if (!getFrontendOpts().StatSnapshotFile.empty()) {
+          StatSnapshot =
+            StatSnapshotCache::Create(getFrontendOpts().StatSnapshotFile);
+          if (StatSnapshot)
+            getFileManager().setFallbackStatCache(StatSnapshot);
+        }
+
+        if (!getFrontendOpts().StatSnapshotOutputFile.empty()) {
+          StatRecorder = new StatSnapshotRecorder();
+          getFileManager().addStatCache(StatRecorder, /*AtBeginning=*/true);
+        }
+
+        // Read the in-memory files once, up front.
+        if (!getFrontendOpts().OverlayFiles.empty())
+          createVirtualFileOverlay();
 
         // Create the source manager.
         createSourceManager();
@@ -505,12 +685,29 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
       createPreprocessor();
     }
 
+    if (hasPhaseStatistics())
+      getPhaseStatistics().beginTranslationUnit(InFile);
+
     if (Act.BeginSourceFile(*this, InFile, IsAST)) {
       Act.Execute();
       Act.EndSourceFile();
     }
+
+    if (hasPhaseStatistics())
+      getPhaseStatistics().endTranslationUnit();
   }
 
+  if (hasPhaseStatistics())
+    WritePhaseStatistics();
+
+  if (hasInstantiationProfile())
+    WriteInstantiationProfile();
+
+  if (StatRecorder &&
+      StatRecorder->getWriter().Write(getFrontendOpts().StatSnapshotOutputFile))
+    getDiagnostics().Report(diag::err_fe_unable_to_write_stat_snapshot)
+      << getFrontendOpts().StatSnapshotOutputFile;
+
   if (getDiagnosticOpts().ShowCarets)
     if (unsigned NumDiagnostics = getDiagnostics().getNumDiagnostics())
       OS << NumDiagnostics << " diagnostic"
@@ -519,6 +716,10 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
 
   if (getFrontendOpts().ShowStats) {
     getFileManager().PrintStats();
+    if (StatSnapshot)
+      OS << "\n*** Stat Snapshot Stats:\n"
+         << StatSnapshot->getNumHits() << " stat snapshot hits, "
+         << StatSnapshot->getNumMisses() << " stat snapshot misses.\n";
     OS << "\n";
   }
 
@@ -58,6 +58,16 @@ static const char *getAnalysisConstraintName(AnalysisConstraints Kind) {
   }
 }
 
+static const char *getAnalysisWorkListName(AnalysisWorkLists Kind) {
+  switch (Kind) {
+  default:
+    llvm_unreachable("Unknown analysis worklist!");
+#define ANALYSIS_WORKLIST(NAME, CMDFLAG, DESC, CREATFN) \
+  case NAME##WorkList: return CMDFLAG;
+#include "clang/Frontend/Analyses.def"
+  }
+}
+
 static const char *getAnalysisDiagClientName(AnalysisDiagClients Kind) {
   switch (Kind) {
   default:
@@ -84,6 +94,10 @@ static void AnalyzerOptsToArgs(const AnalyzerOptions &Opts,
     Res.push_back("-analyzer-constraints");
     Res.push_back(getAnalysisConstraintName(Opts.AnalysisConstraintsOpt));
   }
+  if (Opts.AnalysisWorkListOpt != BFSWorkList) {
+    Res.push_back("-analyzer-worklist");
+    Res.push_back(getAnalysisWorkListName(Opts.AnalysisWorkListOpt));
+  }
   if (Opts.AnalysisDiagOpt != PD_HTML) {
     Res.push_back("-analyzer-output");
     Res.push_back(getAnalysisDiagClientName(Opts.AnalysisDiagOpt));
@@ -92,6 +106,38 @@ static void AnalyzerOptsToArgs(const AnalyzerOptions &Opts,
     Res.push_back("-analyze-function");
     Res.push_back(Opts.AnalyzeSpecificFunction);
   }
+  if (Opts.AnalyzerShards != 1) {
+    Res.push_back("-analyzer-shards");
+    Res.push_back(llvm::utostr(Opts.AnalyzerShards));
+  }
+  if (Opts.AnalyzerShardIndex) {
+    Res.push_back("-analyzer-shard-index");
+    Res.push_back(llvm::utostr(Opts.AnalyzerShardIndex));
+  }
+  if (Opts.MaxNodes) {
+    Res.push_back("-analyzer-max-nodes");
+    Res.push_back(llvm::utostr(Opts.MaxNodes));
+  }
+  if (Opts.MaxTime) {
+    Res.push_back("-analyzer-max-time");
+    Res.push_back(llvm::utostr(Opts.MaxTime));
+  }
+  if (Opts.MaxMemory) {
+    Res.push_back("-analyzer-max-memory");
+    Res.push_back(llvm::utostr(Opts.MaxMemory));
+  }
+  if (!Opts.CacheDir.empty()) {
+    Res.push_back("-analyzer-cache-dir");
+    Res.push_back(Opts.CacheDir);
+  }
+  if (!Opts.StatsFile.empty()) {
+    Res.push_back("-analyzer-stats-file");
+    Res.push_back(Opts.StatsFile);
+  }
+  if (!Opts.RetainSummaryFile.empty()) {
+    Res.push_back("-analyzer-retain-summaries");
+    Res.push_back(Opts.RetainSummaryFile);
+  }
   if (Opts.AnalyzeAll)
     Res.push_back("-analyzer-opt-analyze-headers");
   if (Opts.AnalyzerDisplayProgress)
@@ -102,6 +148,14 @@ static void AnalyzerOptsToArgs(const AnalyzerOptions &Opts,
     Res.push_back("-analyzer-eagerly-assume");
   if (!Opts.PurgeDead)
     Res.push_back("-analyzer-no-purge-dead");
+  if (Opts.ReclaimInterval) {
+    Res.push_back("-analyzer-reclaim-interval");
+    Res.push_back(llvm::utostr(Opts.ReclaimInterval));
+  }
+  if (Opts.StateStats)
+    Res.push_back("-analyzer-state-stats");
+  if (Opts.SummarizeCalls)
+    Res.push_back("-analyzer-summarize-calls");
   if (Opts.TrimGraph)
     Res.push_back("-trim-egraph");
   if (Opts.VisualizeEGDot)
@@ -126,6 +180,18 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts,
     Res.push_back("-dwarf-debug-flags");
     Res.push_back(Opts.DwarfDebugFlags);
   }
+  if (!Opts.EmittedDefinitionsDir.empty()) {
+    Res.push_back("-emitted-definitions-dir");
+    Res.push_back(Opts.EmittedDefinitionsDir);
+  }
+  if (Opts.LazyRecordTypes)
+    Res.push_back("-lazy-record-types");
+  if (Opts.LimitDebugInfo)
+    Res.push_back("-flimit-debug-info");
+  if (Opts.HugeFunctionThreshold) {
+    Res.push_back("-huge-function-threshold");
+    Res.push_back(llvm::utostr(Opts.HugeFunctionThreshold));
+  }
   if (!Opts.MergeAllConstants)
     Res.push_back("-fno-merge-all-constants");
   if (Opts.NoCommon)
@@ -180,6 +246,10 @@ static void CodeGenOptsToArgs(const CodeGenOptions &Opts,
     Res.push_back("-mrelocation-model");
     Res.push_back(Opts.RelocationModel);
   }
+  if (Opts.ReleaseFunctionBodies)
+    Res.push_back("-release-function-bodies");
+  if (Opts.StreamingCodeGen)
+    Res.push_back("-streaming-codegen");
   if (!Opts.VerifyModule)
     Res.push_back("-disable-llvm-verifier");
 }
@@ -198,6 +268,14 @@ static void DependencyOutputOptsToArgs(const DependencyOutputOptions &Opts,
     Res.push_back("-MT");
     Res.push_back(Opts.Targets[i]);
   }
+  if (!Opts.HeaderManifestFile.empty()) {
+    Res.push_back("-header-manifest");
+    Res.push_back(Opts.HeaderManifestFile);
+  }
+  if (!Opts.HeaderMacroDepsFile.empty()) {
+    Res.push_back("-header-macro-deps");
+    Res.push_back(Opts.HeaderMacroDepsFile);
+  }
 }
 
 static void DiagnosticOptsToArgs(const DiagnosticOptions &Opts,
@@ -271,6 +349,7 @@ static const char *getActionName(frontend::ActionKind Kind) {
     llvm_unreachable("Invalid kind!");
 
   case frontend::ASTDump:                return "-ast-dump";
+  case frontend::ASTExport:              return "-ast-export";
   case frontend::ASTPrint:               return "-ast-print";
   case frontend::ASTPrintXML:            return "-ast-print-xml";
   case frontend::ASTView:                return "-ast-view";
@@ -279,6 +358,7 @@ static const char *getActionName(frontend::ActionKind Kind) {
   case frontend::DumpTokens:             return "-dump-tokens";
   case frontend::EmitAssembly:           return "-S";
   case frontend::EmitBC:                 return "-emit-llvm-bc";
+  case frontend::EmitCallEdges:          return "-emit-call-edges";
   case frontend::EmitHTML:               return "-emit-html";
   case frontend::EmitLLVM:               return "-emit-llvm";
   case frontend::EmitLLVMOnly:           return "-emit-llvm-only";
@@ -289,8 +369,10 @@ static const char *getActionName(frontend::ActionKind Kind) {
   case frontend::ParseNoop:              return "-parse-noop";
   case frontend::ParsePrintCallbacks:    return "-parse-print-callbacks";
   case frontend::ParseSyntaxOnly:        return "-fsyntax-only";
+  case frontend::PrintCallEdges:         return "-print-call-edges";
   case frontend::PrintDeclContext:       return "-print-decl-contexts";
   case frontend::PrintPreprocessedInput: return "-E";
+  case frontend::PrintUnusedIncludes:    return "-print-unused-includes";
   case frontend::RewriteMacros:          return "-rewrite-macros";
   case frontend::RewriteObjC:            return "-rewrite-objc";
   case frontend::RewriteTest:            return "-rewrite-test";
@@ -304,14 +386,22 @@ static const char *getActionName(frontend::ActionKind Kind) {
 
 static void FrontendOptsToArgs(const FrontendOptions &Opts,
                                std::vector<std::string> &Res) {
+  if (Opts.CacheDirectoryListings)
+    Res.push_back("-cache-directory-listings");
   if (!Opts.DebugCodeCompletionPrinter)
     Res.push_back("-no-code-completion-debug-printer");
   if (Opts.DisableFree)
     Res.push_back("-disable-free");
   if (Opts.EmptyInputOnly)
     Res.push_back("-empty-input-only");
+  if (Opts.PCHCacheReadOnly)
+    Res.push_back("-pch-cache-read-only");
+  if (Opts.PCHContentHashes)
+    Res.push_back("-pch-content-hashes");
   if (Opts.RelocatablePCH)
     Res.push_back("-relocatable-pch");
+  if (Opts.ShareIdentifiers)
+    Res.push_back("-share-identifiers");
   if (Opts.ShowHelp)
     Res.push_back("-help");
   if (Opts.ShowMacrosInCodeCompletion)
@@ -322,6 +412,10 @@ static void FrontendOptsToArgs(const FrontendOptions &Opts,
     Res.push_back("-ftime-report");
   if (Opts.ShowVersion)
     Res.push_back("-version");
+  if (Opts.SkipFunctionBodies)
+    Res.push_back("-skip-function-bodies");
+  if (Opts.FastSyntaxOnly)
+    Res.push_back("-fast-syntax-only");
 
   bool NeedLang = false;
   for (unsigned i = 0, e = Opts.Inputs.size(); i != e; ++i)
@@ -342,6 +436,39 @@ static void FrontendOptsToArgs(const FrontendOptions &Opts,
     Res.push_back("-o");
     Res.push_back(Opts.OutputFile);
   }
+  if (!Opts.StatSnapshotFile.empty()) {
+    Res.push_back("-stat-snapshot");
+    Res.push_back(Opts.StatSnapshotFile);
+  }
+  if (!Opts.StatSnapshotOutputFile.empty()) {
+    Res.push_back("-write-stat-snapshot");
+    Res.push_back(Opts.StatSnapshotOutputFile);
+  }
+  for (unsigned i = 0, e = Opts.OverlayFiles.size(); i != e; ++i) {
+    Res.push_back("-overlay-file");
+    Res.push_back(Opts.OverlayFiles[i].first + ";" +
+                  Opts.OverlayFiles[i].second);
+  }
+  if (!Opts.IncludeCostFile.empty()) {
+    Res.push_back("-include-cost-report");
+    Res.push_back(Opts.IncludeCostFile);
+  }
+  if (!Opts.PhaseStatsFile.empty()) {
+    Res.push_back("-phase-stats-file");
+    Res.push_back(Opts.PhaseStatsFile);
+  }
+  if (!Opts.TemplateProfileFile.empty()) {
+    Res.push_back("-template-profile");
+    Res.push_back(Opts.TemplateProfileFile);
+  }
+  if (!Opts.TemplateProfileTraceFile.empty()) {
+    Res.push_back("-template-profile-trace");
+    Res.push_back(Opts.TemplateProfileTraceFile);
+  }
+  if (!Opts.PTHMergeFile.empty()) {
+    Res.push_back("-pth-merge");
+    Res.push_back(Opts.PTHMergeFile);
+  }
   if (!Opts.ViewClassInheritance.empty()) {
     Res.push_back("-cxx-inheritance-view");
     Res.push_back(Opts.ViewClassInheritance);
@@ -352,12 +479,32 @@ static void FrontendOptsToArgs(const FrontendOptions &Opts,
                   llvm::utostr(Opts.FixItLocations[i].Line) + ":" +
                   llvm::utostr(Opts.FixItLocations[i].Column));
   }
+  if (!Opts.FixItRecordFile.empty()) {
+    Res.push_back("-fixit-record");
+    Res.push_back(Opts.FixItRecordFile);
+  }
   if (!Opts.CodeCompletionAt.FileName.empty()) {
     Res.push_back("-code-completion-at");
     Res.push_back(Opts.CodeCompletionAt.FileName + ":" +
                   llvm::utostr(Opts.CodeCompletionAt.Line) + ":" +
                   llvm::utostr(Opts.CodeCompletionAt.Column));
   }
+  if (!Opts.CodeCompletionPrefix.empty()) {
+    Res.push_back("-code-completion-prefix");
+    Res.push_back(Opts.CodeCompletionPrefix);
+  }
+  if (Opts.CodeCompletionMaxResults) {
+    Res.push_back("-code-completion-max-results");
+    Res.push_back(llvm::utostr(Opts.CodeCompletionMaxResults));
+  }
+  if (!Opts.CodeCompletionCacheDir.empty()) {
+    Res.push_back("-code-completion-cache");
+    Res.push_back(Opts.CodeCompletionCacheDir);
+  }
+  if (!Opts.PCHCacheDir.empty()) {
+    Res.push_back("-pch-cache");
+    Res.push_back(Opts.PCHCacheDir);
+  }
   if (Opts.ProgramAction != frontend::InheritanceView &&
       Opts.ProgramAction != frontend::PluginAction)
     Res.push_back(getActionName(Opts.ProgramAction));
@@ -431,6 +578,14 @@ static void HeaderSearchOptsToArgs(const HeaderSearchOptions &Opts,
     Res.push_back("-resource-dir");
     Res.push_back(Opts.ResourceDir);
   }
+  if (!Opts.LookupCacheFile.empty()) {
+    Res.push_back("-header-search-cache");
+    Res.push_back(Opts.LookupCacheFile);
+  }
+  if (!Opts.GuardDatabaseFile.empty()) {
+    Res.push_back("-header-guard-db");
+    Res.push_back(Opts.GuardDatabaseFile);
+  }
   if (!Opts.UseStandardIncludes)
     Res.push_back("-nostdinc");
   if (Opts.Verbose)
@@ -517,6 +672,12 @@ static void LangOptsToArgs(const LangOptions &Opts,
   // FIXME: Don't forget to update when the default changes!
   if (Opts.AccessControl)
     Res.push_back("-faccess-control");
+  if (Opts.NoSystemHeaderAccessControl)
+    Res.push_back("-fno-system-header-access-control");
+  if (Opts.NoSystemHeaderInstantiations)
+    Res.push_back("-fno-system-header-instantiations");
+  if (Opts.ElideTypeLocs)
+    Res.push_back("-felide-type-locs");
   if (!Opts.CharIsSigned)
     Res.push_back("-fno-signed-char");
   if (Opts.ShortWChar)
@@ -549,6 +710,14 @@ static void LangOptsToArgs(const LangOptions &Opts,
     Res.push_back("-ftemplate-depth");
     Res.push_back(llvm::utostr(Opts.InstantiationDepth));
   }
+  if (Opts.TypoCorrectionLimit != DefaultLangOpts.TypoCorrectionLimit) {
+    Res.push_back("-ftypo-correction-limit");
+    Res.push_back(llvm::utostr(Opts.TypoCorrectionLimit));
+  }
+  if (Opts.TypoCandidateLimit != DefaultLangOpts.TypoCandidateLimit) {
+    Res.push_back("-ftypo-candidate-limit");
+    Res.push_back(llvm::utostr(Opts.TypoCandidateLimit));
+  }
   if (!Opts.ObjCConstantStringClass.empty()) {
     Res.push_back("-fconstant-string-class");
     Res.push_back(Opts.ObjCConstantStringClass);
@@ -587,6 +756,14 @@ static void PreprocessorOptsToArgs(const PreprocessorOptions &Opts,
       assert(Opts.ImplicitPTHInclude == Opts.TokenCache &&
              "Unsupported option combination!");
   }
+  if (!Opts.PredefinesCacheDir.empty()) {
+    Res.push_back("-predefines-cache");
+    Res.push_back(Opts.PredefinesCacheDir);
+  }
+  if (Opts.IncludePrefetchThreads) {
+    Res.push_back("-include-prefetch-threads");
+    Res.push_back(llvm::utostr(Opts.IncludePrefetchThreads));
+  }
   for (unsigned i = 0, e = Opts.RemappedFiles.size(); i != e; ++i) {
     Res.push_back("-remap-file");
     Res.push_back(Opts.RemappedFiles[i].first + ";" +
@@ -719,6 +896,20 @@ static void ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
       Opts.AnalysisConstraintsOpt = Value;
   }
 
+  if (Arg *A = Args.getLastArg(OPT_analyzer_worklist)) {
+    llvm::StringRef Name = A->getValue(Args);
+    AnalysisWorkLists Value = llvm::StringSwitch<AnalysisWorkLists>(Name)
+#define ANALYSIS_WORKLIST(NAME, CMDFLAG, DESC, CREATFN) \
+      .Case(CMDFLAG, NAME##WorkList)
+#include "clang/Frontend/Analyses.def"
+      .Default(NumWorkLists);
+    if (Value == NumWorkLists)
+      Diags.Report(diag::err_drv_invalid_value)
+        << A->getAsString(Args) << Name;
+    else
+      Opts.AnalysisWorkListOpt = Value;
+  }
+
   if (Arg *A = Args.getLastArg(OPT_analyzer_output)) {
     llvm::StringRef Name = A->getValue(Args);
     AnalysisDiagClients Value = llvm::StringSwitch<AnalysisDiagClients>(Name)
@@ -742,10 +933,31 @@ static void ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
     Args.hasArg(OPT_analyzer_opt_analyze_nested_blocks);
   Opts.PurgeDead = !Args.hasArg(OPT_analyzer_no_purge_dead);
   Opts.EagerlyAssume = Args.hasArg(OPT_analyzer_eagerly_assume);
+  Opts.MaxNodes = getLastArgIntValue(Args, OPT_analyzer_max_nodes, 0, Diags);
+  Opts.MaxTime = getLastArgIntValue(Args, OPT_analyzer_max_time, 0, Diags);
+  Opts.MaxMemory = getLastArgIntValue(Args, OPT_analyzer_max_memory, 0, Diags);
   Opts.AnalyzeSpecificFunction = getLastArgValue(Args, OPT_analyze_function);
+  Opts.AnalyzerShards = getLastArgIntValue(Args, OPT_analyzer_shards, 1, Diags);
+  Opts.AnalyzerShardIndex = getLastArgIntValue(Args, OPT_analyzer_shard_index,
+                                               0, Diags);
+  if (Opts.AnalyzerShards == 0 ||
+      Opts.AnalyzerShardIndex >= Opts.AnalyzerShards) {
+    Diags.Report(diag::err_drv_invalid_value)
+      << "-analyzer-shard-index" << llvm::utostr(Opts.AnalyzerShardIndex);
+    Opts.AnalyzerShards = 1;
+    Opts.AnalyzerShardIndex = 0;
+  }
   Opts.EnableExperimentalChecks = Args.hasArg(OPT_analyzer_experimental_checks);
   Opts.EnableExperimentalInternalChecks =
     Args.hasArg(OPT_analyzer_experimental_internal_checks);
+  Opts.ReclaimInterval = getLastArgIntValue(Args, OPT_analyzer_reclaim_interval,
+                                            0, Diags);
+  Opts.CacheDir = getLastArgValue(Args, OPT_analyzer_cache_dir);
+  Opts.StatsFile = getLastArgValue(Args, OPT_analyzer_stats_file);
+  Opts.RetainSummaryFile = getLastArgValue(Args,
+                                           OPT_analyzer_retain_summaries);
+  Opts.StateStats = Args.hasArg(OPT_analyzer_state_stats);
+  Opts.SummarizeCalls = Args.hasArg(OPT_analyzer_summarize_calls);
   Opts.TrimGraph = Args.hasArg(OPT_trim_egraph);
 }
 
@@ -772,6 +984,13 @@ static void ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args,
   Opts.DisableLLVMOpts = Args.hasArg(OPT_disable_llvm_optzns);
   Opts.DisableRedZone = Args.hasArg(OPT_disable_red_zone);
   Opts.DwarfDebugFlags = getLastArgValue(Args, OPT_dwarf_debug_flags);
+  Opts.EmittedDefinitionsDir = getLastArgValue(Args,
+                                               OPT_emitted_definitions_dir);
+  Opts.HugeFunctionThreshold = getLastArgIntValue(Args,
+                                                  OPT_huge_function_threshold,
+                                                  0, Diags);
+  Opts.LazyRecordTypes = Args.hasArg(OPT_lazy_record_types);
+  Opts.LimitDebugInfo = Args.hasArg(OPT_flimit_debug_info);
   Opts.MergeAllConstants = !Args.hasArg(OPT_fno_merge_all_constants);
   Opts.NoCommon = Args.hasArg(OPT_fno_common);
   Opts.NoImplicitFloat = Args.hasArg(OPT_no_implicit_float);
@@ -789,6 +1008,8 @@ static void ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args,
   Opts.SoftFloat = Args.hasArg(OPT_msoft_float);
   Opts.UnwindTables = Args.hasArg(OPT_munwind_tables);
   Opts.RelocationModel = getLastArgValue(Args, OPT_mrelocation_model, "pic");
+  Opts.ReleaseFunctionBodies = Args.hasArg(OPT_release_function_bodies);
+  Opts.StreamingCodeGen = Args.hasArg(OPT_streaming_codegen);
 
   Opts.MainFileName = getLastArgValue(Args, OPT_main_file_name);
   Opts.VerifyModule = !Args.hasArg(OPT_disable_llvm_verifier);
@@ -801,6 +1022,8 @@ static void ParseDependencyOutputArgs(DependencyOutputOptions &Opts,
   Opts.Targets = getAllArgValues(Args, OPT_MT);
   Opts.IncludeSystemHeaders = Args.hasArg(OPT_sys_header_deps);
   Opts.UsePhonyTargets = Args.hasArg(OPT_MP);
+  Opts.HeaderManifestFile = getLastArgValue(Args, OPT_header_manifest);
+  Opts.HeaderMacroDepsFile = getLastArgValue(Args, OPT_header_macro_deps);
 }
 
 static void ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
@@ -841,6 +1064,8 @@ ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args, Diagnostic &Diags) {
       assert(0 && "Invalid option in group!");
     case OPT_ast_dump:
       Opts.ProgramAction = frontend::ASTDump; break;
+    case OPT_ast_export:
+      Opts.ProgramAction = frontend::ASTExport; break;
     case OPT_ast_print:
       Opts.ProgramAction = frontend::ASTPrint; break;
     case OPT_ast_print_xml:
@@ -857,6 +1082,8 @@ ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args, Diagnostic &Diags) {
       Opts.ProgramAction = frontend::EmitAssembly; break;
     case OPT_emit_llvm_bc:
       Opts.ProgramAction = frontend::EmitBC; break;
+    case OPT_emit_call_edges:
+      Opts.ProgramAction = frontend::EmitCallEdges; break;
     case OPT_emit_html:
       Opts.ProgramAction = frontend::EmitHTML; break;
     case OPT_emit_llvm:
@@ -877,10 +1104,14 @@ ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args, Diagnostic &Diags) {
       Opts.ProgramAction = frontend::ParsePrintCallbacks; break;
     case OPT_fsyntax_only:
       Opts.ProgramAction = frontend::ParseSyntaxOnly; break;
+    case OPT_print_call_edges:
+      Opts.ProgramAction = frontend::PrintCallEdges; break;
     case OPT_print_decl_contexts:
       Opts.ProgramAction = frontend::PrintDeclContext; break;
     case OPT_E:
       Opts.ProgramAction = frontend::PrintPreprocessedInput; break;
+    case OPT_print_unused_includes:
+      Opts.ProgramAction = frontend::PrintUnusedIncludes; break;
     case OPT_rewrite_macros:
       Opts.ProgramAction = frontend::RewriteMacros; break;
     case OPT_rewrite_objc:
@@ -905,6 +1136,12 @@ ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args, Diagnostic &Diags) {
       Diags.Report(diag::err_drv_invalid_value)
         << A->getAsString(Args) << A->getValue(Args);
   }
+  Opts.CodeCompletionPrefix = getLastArgValue(Args, OPT_code_completion_prefix);
+  Opts.CodeCompletionMaxResults =
+    getLastArgIntValue(Args, OPT_code_completion_max_results, 0, Diags);
+  Opts.CodeCompletionCacheDir = getLastArgValue(Args,
+                                                OPT_code_completion_cache);
+  Opts.CacheDirectoryListings = Args.hasArg(OPT_cache_directory_listings);
   Opts.DebugCodeCompletionPrinter =
     !Args.hasArg(OPT_no_code_completion_debug_printer);
   Opts.DisableFree = Args.hasArg(OPT_disable_free);
@@ -923,15 +1160,42 @@ ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args, Diagnostic &Diags) {
 
     Opts.FixItLocations.push_back(PSL);
   }
+  Opts.FixItRecordFile = getLastArgValue(Args, OPT_fixit_record);
 
   Opts.OutputFile = getLastArgValue(Args, OPT_o);
   Opts.Plugins = getAllArgValues(Args, OPT_load);
+  Opts.PTHMergeFile = getLastArgValue(Args, OPT_pth_merge);
+  Opts.PCHCacheDir = getLastArgValue(Args, OPT_pch_cache);
+  Opts.PCHCacheReadOnly = Args.hasArg(OPT_pch_cache_read_only);
+  Opts.PCHContentHashes = Args.hasArg(OPT_pch_content_hashes);
   Opts.RelocatablePCH = Args.hasArg(OPT_relocatable_pch);
+  Opts.ShareIdentifiers = Args.hasArg(OPT_share_identifiers);
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowMacrosInCodeCompletion = Args.hasArg(OPT_code_completion_macros);
+  Opts.IncludeCostFile = getLastArgValue(Args, OPT_include_cost_report);
+  Opts.PhaseStatsFile = getLastArgValue(Args, OPT_phase_stats_file);
+  Opts.TemplateProfileFile = getLastArgValue(Args, OPT_template_profile);
+  Opts.TemplateProfileTraceFile = getLastArgValue(Args,
+                                                  OPT_template_profile_trace);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
   Opts.ShowVersion = Args.hasArg(OPT_version);
+  Opts.SkipFunctionBodies = Args.hasArg(OPT_skip_function_bodies);
+  Opts.FastSyntaxOnly = Args.hasArg(OPT_fast_syntax_only);
+  Opts.StatSnapshotFile = getLastArgValue(Args, OPT_stat_snapshot);
+  Opts.StatSnapshotOutputFile = getLastArgValue(Args, OPT_write_stat_snapshot);
+  for (arg_iterator it = Args.filtered_begin(OPT_overlay_file),
+         ie = Args.filtered_end(); it != ie; ++it) {
+    std::pair<llvm::StringRef,llvm::StringRef> Split =
+      llvm::StringRef(it->getValue(Args)).split(';');
+
+    if (Split.second.empty()) {
+      Diags.Report(diag::err_drv_invalid_remap_file) << it->getAsString(Args);
+      continue;
+    }
+
+    Opts.OverlayFiles.push_back(std::make_pair(Split.first, Split.second));
+  }
   Opts.ViewClassInheritance = getLastArgValue(Args, OPT_cxx_inheritance_view);
   Opts.ASTMergeFiles = getAllArgValues(Args, OPT_ast_merge);
 
@@ -1005,6 +1269,8 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
   Opts.UseBuiltinIncludes = !Args.hasArg(OPT_nobuiltininc);
   Opts.UseStandardIncludes = !Args.hasArg(OPT_nostdinc);
   Opts.ResourceDir = getLastArgValue(Args, OPT_resource_dir);
+  Opts.LookupCacheFile = getLastArgValue(Args, OPT_header_search_cache);
+  Opts.GuardDatabaseFile = getLastArgValue(Args, OPT_header_guard_db);
 
   // Add -I... and -F... options in order.
   for (arg_iterator it = Args.filtered_begin(OPT_I, OPT_F),
@@ -1173,10 +1439,20 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args,
   Opts.AssumeSaneOperatorNew = !Args.hasArg(OPT_fno_assume_sane_operator_new);
   Opts.HeinousExtensions = Args.hasArg(OPT_fheinous_gnu_extensions);
   Opts.AccessControl = Args.hasArg(OPT_faccess_control);
+  Opts.NoSystemHeaderAccessControl =
+    Args.hasArg(OPT_fno_system_header_access_control);
+  Opts.NoSystemHeaderInstantiations =
+    Args.hasArg(OPT_fno_system_header_instantiations);
+  Opts.ElideTypeLocs = Args.hasArg(OPT_felide_type_locs);
   Opts.ElideConstructors = !Args.hasArg(OPT_fno_elide_constructors);
   Opts.MathErrno = Args.hasArg(OPT_fmath_errno);
   Opts.InstantiationDepth = getLastArgIntValue(Args, OPT_ftemplate_depth, 99,
                                                Diags);
+  Opts.TypoCorrectionLimit = getLastArgIntValue(Args,
+                                                OPT_ftypo_correction_limit,
+                                                20, Diags);
+  Opts.TypoCandidateLimit = getLastArgIntValue(Args, OPT_ftypo_candidate_limit,
+                                               0, Diags);
   Opts.NeXTRuntime = !Args.hasArg(OPT_fgnu_runtime);
   Opts.ObjCConstantStringClass = getLastArgValue(Args,
                                                  OPT_fconstant_string_class);
@@ -1226,6 +1502,9 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
   else
     Opts.TokenCache = Opts.ImplicitPTHInclude;
   Opts.UsePredefines = !Args.hasArg(OPT_undef);
+  Opts.PredefinesCacheDir = getLastArgValue(Args, OPT_predefines_cache);
+  Opts.IncludePrefetchThreads =
+    getLastArgIntValue(Args, OPT_include_prefetch_threads, 0, Diags);
 
   // Add macros from the command line.
   for (arg_iterator it = Args.filtered_begin(OPT_D, OPT_U),
@@ -1321,6 +1600,33 @@ void CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
   ParseHeaderSearchArgs(Res.getHeaderSearchOpts(), *Args);
   if (DashX != FrontendOptions::IK_AST)
     ParseLangArgs(Res.getLangOpts(), *Args, DashX, Diags);
+
+  // The throughput mode of -fsyntax-only implies the other savings that do
+  // not change its diagnostics, and is meaningless for any other action.
+  // Skipping instantiations would leave code generation with undefined
+  // functions, so only -fsyntax-only may do so.
+  if (Res.getFrontendOpts().ProgramAction == frontend::ParseSyntaxOnly) {
+    if (Res.getFrontendOpts().FastSyntaxOnly)
+      Res.getLangOpts().ElideTypeLocs = 1;
+  } else {
+    Res.getFrontendOpts().FastSyntaxOnly = 0;
+    Res.getLangOpts().NoSystemHeaderInstantiations = 0;
+  }
+
+  // Type locations may only be elided when nothing but the compiler itself
+  // looks at the AST; printers, rewriters and PCH files need all of them.
+  switch (Res.getFrontendOpts().ProgramAction) {
+  case frontend::EmitAssembly:
+  case frontend::EmitBC:
+  case frontend::EmitLLVM:
+  case frontend::EmitLLVMOnly:
+  case frontend::EmitObj:
+  case frontend::ParseSyntaxOnly:
+    break;
+  default:
+    Res.getLangOpts().ElideTypeLocs = 0;
+    break;
+  }
   ParsePreprocessorArgs(Res.getPreprocessorOpts(), *Args, Diags);
   ParsePreprocessorOutputArgs(Res.getPreprocessorOutputOpts(), *Args);
   ParseTargetArgs(Res.getTargetOpts(), *Args);
@@ -14,8 +14,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Frontend/FixItRewriter.h"
+#include "clang/Basic/JSONWriter.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Lex/Lexer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Path.h"
 #include "llvm/ADT/OwningPtr.h"
@@ -26,6 +28,8 @@ using namespace clang;
 FixItRewriter::FixItRewriter(Diagnostic &Diags, SourceManager &SourceMgr,
                              const LangOptions &LangOpts)
   : Diags(Diags), Rewrite(SourceMgr, LangOpts), NumFailures(0) {
+  // The fixed file is only read once all of the fix-its have been applied.
+  Rewrite.setBatchEdits(true);
   Client = Diags.getClient();
   Diags.setClient(this);
 }
@@ -73,6 +77,66 @@ bool FixItRewriter::WriteFixedFile(const std::string &InFileName,
   return false;
 }
 
+bool FixItRewriter::WriteFixItRecords(const std::string &RecordFileName) {
+  if (NumFailures > 0) {
+    Diag(FullSourceLoc(), diag::warn_fixit_no_changes);
+    return true;
+  }
+
+  std::string Text;
+  llvm::raw_string_ostream Out(Text);
+  for (unsigned i = 0, e = Records.size(); i != e; ++i) {
+    const EditRecord &Record = Records[i];
+    Out << "{\"file\": ";
+    WriteJSONString(Out, Record.File);
+    Out << ", \"offset\": " << Record.Offset
+        << ", \"length\": " << Record.Length << ", \"replacement\": ";
+    WriteJSONString(Out, Record.Replacement);
+    Out << "}\n";
+  }
+  Out.flush();
+  if (Text.empty())
+    return false;
+
+  std::string Err;
+  llvm::raw_fd_ostream OS(RecordFileName.c_str(), Err,
+                          llvm::raw_fd_ostream::F_Append |
+                          llvm::raw_fd_ostream::F_Binary);
+  if (!Err.empty()) {
+    Diags.Report(diag::err_fe_unable_to_write_fixit_records)
+      << RecordFileName << Err;
+    return true;
+  }
+  OS.SetUnbuffered();
+  OS << Text;
+  return false;
+}
+
+void FixItRewriter::AddEditRecord(std::vector<EditRecord> &Edits,
+                                  SourceLocation Loc, unsigned Length,
+                                  llvm::StringRef Replacement) {
+  SourceManager &SM = Rewrite.getSourceMgr();
+  std::pair<FileID, unsigned> Decomposed = SM.getDecomposedLoc(Loc);
+  const FileEntry *File = SM.getFileEntryForID(Decomposed.first);
+  if (!File)
+    return;
+
+  // Translation units compiled in different directories have to agree on
+  // the name of the file.
+  llvm::sys::Path Path(File->getName());
+  if (!Path.isAbsolute()) {
+    Path = llvm::sys::Path::GetCurrentDirectory();
+    Path.appendComponent(File->getName());
+  }
+
+  Edits.push_back(EditRecord());
+  EditRecord &Record = Edits.back();
+  Record.File = Path.str();
+  Record.Offset = Decomposed.second;
+  Record.Length = Length;
+  Record.Replacement = Replacement;
+}
+
 bool FixItRewriter::IncludeInDiagnosticCounts() const {
   return Client? Client->IncludeInDiagnosticCounts() : true;
 }
@@ -152,6 +216,7 @@ void FixItRewriter::HandleDiagnostic(Diagnostic::Level DiagLevel,
   }
 
   bool Failed = false;
+  std::vector<EditRecord> Edits;
   for (unsigned Idx = 0, Last = Info.getNumCodeModificationHints();
        Idx < Last; ++Idx) {
     const CodeModificationHint &Hint = Info.getCodeModificationHint(Idx);
@@ -159,14 +224,26 @@ void FixItRewriter::HandleDiagnostic(Diagnostic::Level DiagLevel,
       // We're adding code.
       if (Rewrite.InsertTextBefore(Hint.InsertionLoc, Hint.CodeToInsert))
         Failed = true;
+      else
+        AddEditRecord(Edits, Hint.InsertionLoc, 0, Hint.CodeToInsert);
       continue;
     }
 
+    // The records describe the original text, whatever the fix-its applied
+    // so far have done to it.
+    SourceManager &SM = Rewrite.getSourceMgr();
+    SourceLocation Begin = Hint.RemoveRange.getBegin();
+    SourceLocation End = Hint.RemoveRange.getEnd();
+    unsigned OrigLength = SM.getFileOffset(End) - SM.getFileOffset(Begin) +
+      Lexer::MeasureTokenLength(End, SM, Rewrite.getLangOpts());
+
     if (Hint.CodeToInsert.empty()) {
       // We're removing code.
       if (Rewrite.RemoveText(Hint.RemoveRange.getBegin(),
                              Rewrite.getRangeSize(Hint.RemoveRange)))
         Failed = true;
+      else
+        AddEditRecord(Edits, Begin, OrigLength, "");
       continue;
     }
 
@@ -175,6 +252,8 @@ void FixItRewriter::HandleDiagnostic(Diagnostic::Level DiagLevel,
                             Rewrite.getRangeSize(Hint.RemoveRange),
                             Hint.CodeToInsert))
       Failed = true;
+    else
+      AddEditRecord(Edits, Begin, OrigLength, Hint.CodeToInsert);
   }
 
   if (Failed) {
@@ -183,6 +262,8 @@ void FixItRewriter::HandleDiagnostic(Diagnostic::Level DiagLevel,
     return;
   }
 
+  Records.insert(Records.end(), Edits.begin(), Edits.end());
+
   Diag(Info.getLocation(), diag::note_fixit_applied);
 }
 
@@ -9,6 +9,7 @@
 
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Frontend/ASTUnit.h"
@@ -142,6 +143,7 @@ void FrontendAction::Execute() {
       return;
   }
 
+  PhaseRegion Phase("Execute action");
   if (CI.hasFrontendTimer()) {
     llvm::TimeRegion Timer(CI.getFrontendTimer());
     ExecuteAction();
@@ -155,6 +157,11 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  // Write the include cost report while the AST is still around to count the
+  // declarations in each file.
+  if (CI.hasIncludeCostReport())
+    CI.WriteIncludeCostReport();
+
   // Release the consumer and the AST, in that order since the consumer may
   // perform actions in its destructor which require the context.
   //
@@ -169,12 +176,34 @@ void FrontendAction::EndSourceFile() {
       CI.setASTContext(0);
   }
 
+  // Share the #include lookups performed and the include guards found for
+  // this file with later compilations.
+  if (CI.hasPreprocessor()) {
+    HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+    HS.WritePersistentLookupCache();
+    HS.WriteGuardDatabase();
+  }
+
+  if (PhaseStatistics *Stats = PhaseStatistics::getActive()) {
+    if (CI.hasPreprocessor()) {
+      Preprocessor &PP = CI.getPreprocessor();
+      Stats->addCounter("identifiers", PP.getIdentifierTable().size());
+      Stats->addCounter("source bytes", PP.getSourceManager().getNextOffset());
+      Stats->addCounter("source location entries",
+                        PP.getSourceManager().sloc_entry_size());
+      Stats->addCounter("backtracked tokens", PP.getNumBacktrackedTokens());
+    }
+    Stats->addCounter("diagnostics", CI.getDiagnostics().getNumDiagnostics());
+    Stats->addCounter("errors", CI.getDiagnostics().getNumErrors());
+  }
+
   if (CI.getFrontendOpts().ShowStats) {
     llvm::errs() << "\nSTATISTICS FOR '" << getCurrentFile() << "':\n";
     CI.getPreprocessor().PrintStats();
     CI.getPreprocessor().getIdentifierTable().PrintStats();
     CI.getPreprocessor().getHeaderSearchInfo().PrintStats();
     CI.getSourceManager().PrintStats();
+    CI.getDiagnostics().PrintStats();
     llvm::errs() << "\n";
   }
 
@@ -216,7 +245,9 @@ void ASTFrontendAction::ExecuteAction() {
 
   ParseAST(CI.getPreprocessor(), &CI.getASTConsumer(), CI.getASTContext(),
            CI.getFrontendOpts().ShowStats,
-           usesCompleteTranslationUnit(), CompletionConsumer);
+           usesCompleteTranslationUnit(), CompletionConsumer,
+           CI.getFrontendOpts().SkipFunctionBodies, /*BodyParser=*/0,
+           /*RecordComments=*/!CI.getFrontendOpts().FastSyntaxOnly);
 }
 
 ASTConsumer *
@@ -18,7 +18,9 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FixItRewriter.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/PCHCache.h"
 #include "clang/Frontend/Utils.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace clang;
 
@@ -52,6 +54,14 @@ ASTConsumer *ASTDumpAction::CreateASTConsumer(CompilerInstance &CI,
   return CreateASTDumper();
 }
 
+ASTConsumer *ASTExportAction::CreateASTConsumer(CompilerInstance &CI,
+                                                llvm::StringRef InFile) {
+  if (llvm::raw_ostream *OS = CI.createDefaultOutputFile(true, InFile,
+                                                         "astx"))
+    return CreateASTExporter(OS);
+  return 0;
+}
+
 ASTConsumer *ASTViewAction::CreateASTConsumer(CompilerInstance &CI,
                                               llvm::StringRef InFile) {
   return CreateASTViewer();
@@ -80,10 +90,36 @@ ASTConsumer *GeneratePCHAction::CreateASTConsumer(CompilerInstance &CI,
   if (!OS)
     return 0;
 
+  const char *isysroot = 0;
   if (CI.getFrontendOpts().RelocatablePCH)
-    return CreatePCHGenerator(CI.getPreprocessor(), OS, Sysroot.c_str());
+    isysroot = Sysroot.c_str();
+
+  // A PCH file that an identical invocation has already built is copied
+  // from the cache, and nothing has to be parsed.
+  UsedCachedPCH = false;
+  llvm::OwningPtr<PCHCache> Cache;
+  const FrontendOptions &FEOpts = CI.getFrontendOpts();
+  if (!FEOpts.PCHCacheDir.empty()) {
+    Cache.reset(new PCHCache(FEOpts.PCHCacheDir, CI.getInvocation(),
+                             FEOpts.PCHCacheReadOnly));
+    std::string PCH;
+    if (Cache->lookup(PCH)) {
+      OS->write(PCH.data(), PCH.size());
+      OS->flush();
+      UsedCachedPCH = true;
+      return new ASTConsumer();
+    }
+    if (Cache->isReadOnly())
+      Cache.reset();
+  }
+
+  return CreatePCHGenerator(CI.getPreprocessor(), OS, isysroot,
+                            FEOpts.PCHContentHashes, Cache.take());
+}
 
-  return CreatePCHGenerator(CI.getPreprocessor(), OS);
+void GeneratePCHAction::ExecuteAction() {
+  if (!UsedCachedPCH)
+    ASTFrontendAction::ExecuteAction();
 }
 
 ASTConsumer *HTMLPrintAction::CreateASTConsumer(CompilerInstance &CI,
@@ -142,7 +178,18 @@ bool FixItAction::BeginSourceFileAction(CompilerInstance &CI,
 
 void FixItAction::EndSourceFileAction() {
   const FrontendOptions &FEOpts = getCompilerInstance().getFrontendOpts();
-  Rewriter->WriteFixedFile(getCurrentFile(), FEOpts.OutputFile);
+  if (!FEOpts.FixItRecordFile.empty())
+    Rewriter->WriteFixItRecords(FEOpts.FixItRecordFile);
+  else
+    Rewriter->WriteFixedFile(getCurrentFile(), FEOpts.OutputFile);
+}
+
+ASTConsumer *
+PrintUnusedIncludesAction::CreateASTConsumer(CompilerInstance &CI,
+                                             llvm::StringRef InFile) {
+  if (llvm::raw_ostream *OS = CI.createDefaultOutputFile(false, InFile))
+    return CreateUnusedIncludesPrinter(OS, CI.getPreprocessor());
+  return 0;
 }
 
 ASTConsumer *RewriteObjCAction::CreateASTConsumer(CompilerInstance &CI,
@@ -243,11 +290,22 @@ void GeneratePTHAction::ExecuteAction() {
     // FIXME: Verify that we can actually seek in the given file.
     llvm::llvm_report_error("PTH requires a seekable file for output!");
   }
+
+  // Read the files to carry over before the output is opened, since the file
+  // being merged is commonly the one being overwritten.
+  std::vector<std::string> MergedFiles;
+  const std::string &MergeFile = CI.getFrontendOpts().PTHMergeFile;
+  if (!MergeFile.empty() &&
+      PTHManager::getCachedFiles(MergeFile, MergedFiles)) {
+    // A missing or unreadable store just starts out empty.
+    MergedFiles.clear();
+  }
+
   llvm::raw_fd_ostream *OS =
     CI.createDefaultOutputFile(true, getCurrentFile());
   if (!OS) return;
 
-  CacheTokens(CI.getPreprocessor(), OS);
+  CacheTokens(CI.getPreprocessor(), OS, MergedFiles);
 }
 
 void ParseOnlyAction::ExecuteAction() {
@@ -13,12 +13,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Frontend/ASTConsumers.h"
+#include "clang/Frontend/PCHCache.h"
 #include "clang/Frontend/PCHWriter.h"
 #include "clang/Sema/SemaConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/FileManager.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Support/raw_ostream.h"
 #include <string>
@@ -29,23 +31,32 @@ namespace {
   class PCHGenerator : public SemaConsumer {
     const Preprocessor &PP;
     const char *isysroot;
+    bool HashInputFiles;
     llvm::raw_ostream *Out;
+    llvm::OwningPtr<PCHCache> Cache;
     Sema *SemaPtr;
     MemorizeStatCalls *StatCalls; // owned by the FileManager
+    PCHRecordStats RecordStats;
 
   public:
     explicit PCHGenerator(const Preprocessor &PP,
                           const char *isysroot,
-                          llvm::raw_ostream *Out);
+                          bool HashInputFiles,
+                          llvm::raw_ostream *Out,
+                          PCHCache *Cache);
     virtual void InitializeSema(Sema &S) { SemaPtr = &S; }
     virtual void HandleTranslationUnit(ASTContext &Ctx);
+    virtual void PrintStats() { RecordStats.print(); }
   };
 }
 
 PCHGenerator::PCHGenerator(const Preprocessor &PP,
                            const char *isysroot,
-                           llvm::raw_ostream *OS)
-  : PP(PP), isysroot(isysroot), Out(OS), SemaPtr(0), StatCalls(0) {
+                           bool HashInputFiles,
+                           llvm::raw_ostream *OS,
+                           PCHCache *Cache)
+  : PP(PP), isysroot(isysroot), HashInputFiles(HashInputFiles), Out(OS),
+    Cache(Cache), SemaPtr(0), StatCalls(0) {
 
   // Install a stat() listener to keep track of all of the stat()
   // calls.
@@ -60,21 +71,28 @@ void PCHGenerator::HandleTranslationUnit(ASTContext &Ctx) {
   // Write the PCH contents into a buffer
   std::vector<unsigned char> Buffer;
   llvm::BitstreamWriter Stream(Buffer);
-  PCHWriter Writer(Stream);
+  PCHWriter Writer(Stream, HashInputFiles);
 
   // Emit the PCH file
   assert(SemaPtr && "No Sema?");
   Writer.WritePCH(*SemaPtr, StatCalls, isysroot);
+  RecordStats = Writer.getRecordStats();
 
   // Write the generated bitstream to "Out".
   Out->write((char *)&Buffer.front(), Buffer.size());
 
   // Make sure it hits disk now.
   Out->flush();
+
+  if (Cache)
+    Cache->store(PP.getSourceManager(),
+                 llvm::StringRef((char *)&Buffer.front(), Buffer.size()));
 }
 
 ASTConsumer *clang::CreatePCHGenerator(const Preprocessor &PP,
                                        llvm::raw_ostream *OS,
-                                       const char *isysroot) {
-  return new PCHGenerator(PP, isysroot, OS);
+                                       const char *isysroot,
+                                       bool HashInputFiles,
+                                       PCHCache *Cache) {
+  return new PCHGenerator(PP, isysroot, HashInputFiles, OS, Cache);
 }
@@ -24,6 +24,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Path.h"
+#include <map>
 
 using namespace clang;
 
@@ -38,6 +39,10 @@ class HTMLDiagnostics : public PathDiagnosticClient {
   bool createdDir, noDir;
   const Preprocessor &PP;
   std::vector<const PathDiagnostic*> BatchedDiags;
+
+  /// Highlights - The syntax and macro highlights of each file with reports,
+  ///  which are the same for all of them.
+  std::map<FileID, std::vector<html::Highlight> > Highlights;
 public:
   HTMLDiagnostics(const std::string& prefix, const Preprocessor &pp);
   
@@ -182,12 +187,20 @@ void HTMLDiagnostics::ReportDiag(const PathDiagnostic& D,
   html::EscapeText(R, FID);
   html::AddLineNumbers(R, FID);
 
-  // If we have a preprocessor, relex the file and syntax highlight.
-  // We might not have a preprocessor if we come from a deserialized AST file,
-  // for example.
-
-  html::SyntaxHighlight(R, FID, PP);
-  html::HighlightMacros(R, FID, PP);
+  // Relex the file and syntax highlight.  Preprocessing the file again to
+  // highlight the macros costs about as much as the rest of the report, so
+  // the highlights are found once per file.
+  std::map<FileID, std::vector<html::Highlight> >::iterator HI =
+    Highlights.find(FID);
+  if (HI == Highlights.end()) {
+    HI = Highlights.insert(std::make_pair(FID,
+                                  std::vector<html::Highlight>())).first;
+    std::vector<Token> RawTokens;
+    html::LexRawTokens(FID, PP, RawTokens);
+    html::FindSyntaxHighlights(FID, PP, RawTokens, HI->second);
+    html::FindMacroHighlights(FID, PP, RawTokens, HI->second);
+  }
+  html::ApplyHighlights(R, FID, HI->second);
 
   // Get the full directory name of the analyzed file.
 
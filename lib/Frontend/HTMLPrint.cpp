@@ -81,8 +81,16 @@ void HTMLPrinter::HandleTranslationUnit(ASTContext &Ctx) {
   // We might not have a preprocessor if we come from a deserialized AST file,
   // for example.
 
-  if (SyntaxHighlight) html::SyntaxHighlight(R, FID, PP);
-  if (HighlightMacros) html::HighlightMacros(R, FID, PP);
+  // Both kinds of highlights are found from the same raw tokens.
+  std::vector<Token> RawTokens;
+  std::vector<html::Highlight> Highlights;
+  if (SyntaxHighlight || HighlightMacros)
+    html::LexRawTokens(FID, PP, RawTokens);
+  if (SyntaxHighlight)
+    html::FindSyntaxHighlights(FID, PP, RawTokens, Highlights);
+  if (HighlightMacros)
+    html::FindMacroHighlights(FID, PP, RawTokens, Highlights);
+  html::ApplyHighlights(R, FID, Highlights);
   html::EscapeText(R, FID, false, true);
 
   // Emit the HTML.
@@ -0,0 +1,198 @@
+//===--- HeaderMacroDeps.cpp - List the macros each header depends on -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code lists, for every header guarded against multiple inclusion, the
+// macros defined outside of it that its contents depend on, with their state
+// when the header first used them.  Two #includes of a header whose macros
+// are all in the same state produce the same tokens, so the list is the key
+// under which the parsed header could be shared between translation units.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/DependencyOutputOptions.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+using namespace clang;
+
+namespace {
+class HeaderMacroDepsCallback : public PPCallbacks {
+  Preprocessor &PP;
+  llvm::raw_ostream *OS;
+
+  /// Visit - One time the preprocessor entered a file.
+  struct Visit {
+    FileID FID;
+
+    /// Defined - The macros defined since the file was entered.
+    llvm::SmallPtrSet<const IdentifierInfo *, 16> Defined;
+
+    /// Used - The macros from outside the file used since it was entered.
+    llvm::SmallPtrSet<const IdentifierInfo *, 16> Used;
+
+    /// Deps - The states of the macros in Used when the file first used
+    /// them, in that order.
+    std::vector<std::string> Deps;
+
+    explicit Visit(FileID FID) : FID(FID) {}
+  };
+
+  /// Stack - The visits of the files being lexed.
+  std::vector<Visit *> Stack;
+
+  /// Written - The headers whose dependencies were written already.
+  llvm::SmallPtrSet<const FileEntry *, 32> Written;
+
+  void UseMacro(const Token &Id, const MacroInfo *MI);
+  void PopVisit();
+
+public:
+  HeaderMacroDepsCallback(Preprocessor &_PP, llvm::raw_ostream *_OS)
+    : PP(_PP), OS(_OS) {}
+
+  ~HeaderMacroDepsCallback() {
+    for (unsigned I = 0, N = Stack.size(); I != N; ++I)
+      delete Stack[I];
+    OS->flush();
+    delete OS;
+  }
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType);
+
+  virtual void MacroExpands(const Token &Id, const MacroInfo *MI) {
+    UseMacro(Id, MI);
+  }
+
+  virtual void MacroTested(const Token &Id, const MacroInfo *MI) {
+    UseMacro(Id, MI);
+  }
+
+  virtual void MacroDefined(const IdentifierInfo *II, const MacroInfo *MI) {
+    for (unsigned I = 0, N = Stack.size(); I != N; ++I)
+      Stack[I]->Defined.insert(II);
+  }
+
+  virtual void MacroUndefined(const IdentifierInfo *II, const MacroInfo *MI) {
+    // What the file tests afterwards no longer depends on the includer.
+    MacroDefined(II, MI);
+  }
+};
+}
+
+void clang::AttachHeaderMacroDepsGen(Preprocessor &PP,
+                                     const DependencyOutputOptions &Opts) {
+  std::string Err;
+  llvm::raw_ostream *OS(new llvm::raw_fd_ostream(
+                                            Opts.HeaderMacroDepsFile.c_str(),
+                                            Err));
+  if (!Err.empty()) {
+    PP.getDiagnostics().Report(diag::err_fe_error_opening)
+      << Opts.HeaderMacroDepsFile << Err;
+    delete OS;
+    return;
+  }
+
+  PP.setPPCallbacks(new HeaderMacroDepsCallback(PP, OS));
+}
+
+/// UseMacro - Record the use of a macro by every file being lexed that did
+/// not define the macro itself.  Macros are described as "!NAME" when they
+/// are not defined, and by their definition otherwise.
+void HeaderMacroDepsCallback::UseMacro(const Token &Id, const MacroInfo *MI) {
+  const IdentifierInfo *II = Id.getIdentifierInfo();
+  if (MI && MI->isBuiltinMacro())
+    return;
+
+  llvm::StringRef Name = II->getName();
+  std::string Dep;
+  for (unsigned I = Stack.size(); I != 0; --I) {
+    Visit &V = *Stack[I - 1];
+    // The enclosing files saw the definition as well.
+    if (V.Defined.count(II))
+      return;
+    if (!V.Used.insert(II))
+      continue;
+
+    if (Dep.empty()) {
+      if (!MI) {
+        Dep = "!" + Name.str();
+      } else {
+        llvm::raw_string_ostream Out(Dep);
+        Out << Name;
+        if (MI->isFunctionLike()) {
+          Out << '(';
+          for (MacroInfo::arg_iterator A = MI->arg_begin(), E = MI->arg_end();
+               A != E; ++A) {
+            if (A != MI->arg_begin())
+              Out << ',';
+            if ((*A)->isStr("__VA_ARGS__"))
+              Out << "...";
+            else
+              Out << (*A)->getName();
+          }
+          if (MI->isGNUVarargs())
+            Out << "...";
+          Out << ')';
+        }
+        Out << '=';
+        for (MacroInfo::tokens_iterator T = MI->tokens_begin(),
+             E = MI->tokens_end(); T != E; ++T) {
+          if (T != MI->tokens_begin() && T->hasLeadingSpace())
+            Out << ' ';
+          Out << PP.getSpelling(*T);
+        }
+      }
+    }
+    V.Deps.push_back(Dep);
+  }
+}
+
+/// PopVisit - Leave the innermost file.  The first time a guarded header is
+/// left, write its name followed by its dependencies, one per line and
+/// indented.
+void HeaderMacroDepsCallback::PopVisit() {
+  Visit *V = Stack.back();
+  Stack.pop_back();
+
+  SourceManager &SM = PP.getSourceManager();
+  const FileEntry *FE = SM.getFileEntryForID(V->FID);
+  if (FE && PP.getHeaderSearchInfo().getFileControllingMacro(FE) &&
+      Written.insert(FE)) {
+    *OS << FE->getName() << ":\n";
+    for (unsigned I = 0, N = V->Deps.size(); I != N; ++I)
+      *OS << "  " << V->Deps[I] << '\n';
+  }
+  delete V;
+}
+
+void HeaderMacroDepsCallback::FileChanged(SourceLocation Loc,
+                                          FileChangeReason Reason,
+                                          SrcMgr::CharacteristicKind FileType) {
+  SourceManager &SM = PP.getSourceManager();
+  FileID FID = SM.getFileID(SM.getInstantiationLoc(Loc));
+  if (Reason == EnterFile) {
+    Stack.push_back(new Visit(FID));
+  } else if (Reason == ExitFile) {
+    // The preprocessor also reports leaving the buffer of a _Pragma, which it
+    // never reported entering.  Only pop a file when we are back in its
+    // includer.
+    if (Stack.size() >= 2 && Stack[Stack.size() - 2]->FID == FID)
+      PopVisit();
+  }
+}
@@ -0,0 +1,92 @@
+//===--- HeaderManifest.cpp - Generate a manifest of included files -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code generates header manifests: the files a translation unit reads,
+// each with the size and hash of the contents it was compiled with.  A
+// remote build node holding files by hash can rebuild the source tree of a
+// translation unit from its manifest, and only the files it lacks need to be
+// sent to it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/DependencyOutputOptions.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/PCHBitCodes.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+
+using namespace clang;
+
+namespace {
+class HeaderManifestCallback : public PPCallbacks {
+  const Preprocessor &PP;
+  llvm::raw_ostream *OS;
+  llvm::SmallPtrSet<const FileEntry *, 32> Seen;
+
+public:
+  HeaderManifestCallback(const Preprocessor &_PP, llvm::raw_ostream *_OS)
+    : PP(_PP), OS(_OS) {}
+
+  ~HeaderManifestCallback() {
+    OS->flush();
+    delete OS;
+  }
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType);
+};
+}
+
+void clang::AttachHeaderManifestGen(Preprocessor &PP,
+                                    const DependencyOutputOptions &Opts) {
+  std::string Err;
+  llvm::raw_ostream *OS(new llvm::raw_fd_ostream(
+                                            Opts.HeaderManifestFile.c_str(),
+                                            Err));
+  if (!Err.empty()) {
+    PP.getDiagnostics().Report(diag::err_fe_error_opening)
+      << Opts.HeaderManifestFile << Err;
+    delete OS;
+    return;
+  }
+
+  PP.setPPCallbacks(new HeaderManifestCallback(PP, OS));
+}
+
+/// FileChanged - Write the line of each file the first time it is entered:
+/// the hash of its contents in hex, its size and its name.  The contents are
+/// those the preprocessor reads, so the hash cannot disagree with them even
+/// if the file changes on disk during the compilation.
+void HeaderManifestCallback::FileChanged(SourceLocation Loc,
+                                         FileChangeReason Reason,
+                                         SrcMgr::CharacteristicKind FileType) {
+  if (Reason != PPCallbacks::EnterFile)
+    return;
+
+  SourceManager &SM = PP.getSourceManager();
+  FileID FID = SM.getFileID(SM.getInstantiationLoc(Loc));
+  const FileEntry *FE = SM.getFileEntryForID(FID);
+  if (!FE || !Seen.insert(FE))
+    return;
+
+  const llvm::MemoryBuffer *Buffer = SM.getBuffer(FID);
+  char Hash[32];
+  snprintf(Hash, sizeof(Hash), "%016llx",
+           (unsigned long long)pch::HashBytes(Buffer->getBufferStart(),
+                                              Buffer->getBufferEnd()));
+  *OS << Hash << ' ' << Buffer->getBufferSize() << ' ' << FE->getName()
+      << '\n';
+}
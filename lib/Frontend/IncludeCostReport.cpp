@@ -0,0 +1,218 @@
+//===--- IncludeCostReport.cpp - Measure the cost of each #include --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code measures the time, tokens, bytes and declarations that each file
+// entered by the preprocessor contributes to a translation unit.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/IncludeCostReport.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclBase.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/TimeValue.h"
+#include <algorithm>
+
+using namespace clang;
+
+static double GetWallTime() {
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  return Now.seconds() + Now.microseconds() / 1000000.0;
+}
+
+void IncludeCostReport::PopEntry(double Now) {
+  Entries[Stack.back()].EndTime = Now;
+  Stack.pop_back();
+}
+
+void IncludeCostReport::FileChanged(SourceLocation Loc,
+                                    FileChangeReason Reason,
+                                    SrcMgr::CharacteristicKind FileType) {
+  SourceManager &SM = PP.getSourceManager();
+  if (Reason == EnterFile) {
+    FileID FID = SM.getFileID(SM.getInstantiationLoc(Loc));
+    int Parent = Stack.empty() ? -1 : (int) Stack.back();
+    Stack.push_back(Entries.size());
+    Entries.push_back(Entry(FID, Parent, GetWallTime()));
+  } else if (Reason == ExitFile) {
+    // The preprocessor also reports leaving the buffer of a _Pragma, which it
+    // never reported entering.  Only pop a file when we are back in its
+    // includer.
+    FileID FID = SM.getFileID(SM.getInstantiationLoc(Loc));
+    if (Stack.size() >= 2 && Entries[Stack[Stack.size() - 2]].FID == FID)
+      PopEntry(GetWallTime());
+  }
+}
+
+/// CountDecls - Count the declarations written in each file, in the given
+/// declaration context and every context nested within it.
+static void CountDecls(const DeclContext *DC, SourceManager &SM,
+                       llvm::DenseMap<FileID, unsigned> &Counts) {
+  for (DeclContext::decl_iterator I = DC->decls_begin(), E = DC->decls_end();
+       I != E; ++I) {
+    Decl *D = *I;
+    if (!D->isImplicit() && D->getLocation().isValid())
+      ++Counts[SM.getFileID(SM.getInstantiationLoc(D->getLocation()))];
+
+    if (TemplateDecl *Template = dyn_cast<TemplateDecl>(D))
+      if (Template->getTemplatedDecl())
+        D = Template->getTemplatedDecl();
+
+    if (DeclContext *Inner = dyn_cast<DeclContext>(D))
+      CountDecls(Inner, SM, Counts);
+  }
+}
+
+/// CountRawTokens - Count the tokens in the given buffer, including those in
+/// blocks skipped by conditional directives.
+static unsigned CountRawTokens(SourceLocation FileLoc,
+                               const LangOptions &LangOpts,
+                               const llvm::MemoryBuffer *Buffer) {
+  Lexer RawLex(FileLoc, LangOpts, Buffer->getBufferStart(),
+               Buffer->getBufferStart(), Buffer->getBufferEnd());
+  unsigned NumTokens = 0;
+  Token Tok;
+  while (true) {
+    RawLex.LexFromRawLexer(Tok);
+    if (Tok.is(tok::eof))
+      break;
+    ++NumTokens;
+  }
+  return NumTokens;
+}
+
+namespace {
+/// Cost - What a file costs, exclusive or inclusive of its #includes.
+struct Cost {
+  double Time;
+  uint64_t Tokens, Decls, Bytes;
+
+  Cost() : Time(0), Tokens(0), Decls(0), Bytes(0) {}
+
+  Cost &operator+=(const Cost &RHS) {
+    Time += RHS.Time;
+    Tokens += RHS.Tokens;
+    Decls += RHS.Decls;
+    Bytes += RHS.Bytes;
+    return *this;
+  }
+};
+
+/// FileCost - The total cost of every visit to a file.
+struct FileCost {
+  const char *Name;
+  unsigned Count;
+  Cost Inclusive, Exclusive;
+
+  FileCost() : Name(0), Count(0) {}
+
+  bool operator<(const FileCost &RHS) const {
+    return Inclusive.Time > RHS.Inclusive.Time;
+  }
+};
+} // end anonymous namespace
+
+void IncludeCostReport::WriteReport(llvm::raw_ostream &OS, ASTContext *Ctx) {
+  SourceManager &SM = PP.getSourceManager();
+
+  // The preprocessor does not report leaving the main file.
+  double Now = GetWallTime();
+  while (!Stack.empty())
+    PopEntry(Now);
+
+  // Walking the declarations of an external AST source would deserialize
+  // all of them.
+  llvm::DenseMap<FileID, unsigned> DeclCounts;
+  if (Ctx && !Ctx->getExternalSource())
+    CountDecls(Ctx->getTranslationUnitDecl(), SM, DeclCounts);
+
+  // Measure each visit on its own, then fold every visit into the visit of
+  // the file that #included it.  Includers are entered before the files they
+  // #include, so walking backwards sees every visit before its includer.
+  std::vector<Cost> Exclusive(Entries.size()), Inclusive(Entries.size());
+  llvm::DenseMap<const llvm::MemoryBuffer *, unsigned> TokenCounts;
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    const Entry &E = Entries[i];
+    Exclusive[i].Time += E.EndTime - E.StartTime;
+    if (E.Parent >= 0)
+      Exclusive[E.Parent].Time -= E.EndTime - E.StartTime;
+
+    const llvm::MemoryBuffer *Buffer = SM.getBuffer(E.FID);
+    Exclusive[i].Bytes = Buffer->getBufferSize();
+    llvm::DenseMap<const llvm::MemoryBuffer *, unsigned>::iterator Known
+      = TokenCounts.find(Buffer);
+    if (Known == TokenCounts.end())
+      Known = TokenCounts.insert(std::make_pair(Buffer,
+                CountRawTokens(SM.getLocForStartOfFile(E.FID),
+                               PP.getLangOptions(), Buffer))).first;
+    Exclusive[i].Tokens = Known->second;
+    Exclusive[i].Decls = DeclCounts.lookup(E.FID);
+  }
+  for (unsigned i = Entries.size(); i != 0; --i) {
+    Inclusive[i-1] += Exclusive[i-1];
+    if (Entries[i-1].Parent >= 0)
+      Inclusive[Entries[i-1].Parent] += Inclusive[i-1];
+  }
+
+  // Sum up the visits to each file.
+  llvm::StringMap<FileCost> Files;
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    const char *Name;
+    if (const FileEntry *FE = SM.getFileEntryForID(Entries[i].FID))
+      Name = FE->getName();
+    else
+      Name = SM.getBuffer(Entries[i].FID)->getBufferIdentifier();
+
+    FileCost &FC = Files[Name];
+    FC.Name = Name;
+    ++FC.Count;
+    FC.Inclusive += Inclusive[i];
+    FC.Exclusive += Exclusive[i];
+  }
+
+  std::vector<FileCost> Sorted;
+  for (llvm::StringMap<FileCost>::iterator I = Files.begin(), E = Files.end();
+       I != E; ++I)
+    Sorted.push_back(I->getValue());
+  std::stable_sort(Sorted.begin(), Sorted.end());
+
+  const char *MainFile = "<none>";
+  if (const FileEntry *FE = SM.getFileEntryForID(SM.getMainFileID()))
+    MainFile = FE->getName();
+  OS << "Include costs for '" << MainFile << "':\n";
+  OS << "  count  incl ms  excl ms  incl tokens  excl tokens  incl decls"
+        "  excl decls  incl bytes  excl bytes  file\n";
+  for (unsigned i = 0, e = Sorted.size(); i != e; ++i) {
+    const FileCost &FC = Sorted[i];
+    OS << llvm::format("%7u %8.2f %8.2f", FC.Count,
+                       FC.Inclusive.Time * 1000, FC.Exclusive.Time * 1000)
+       << llvm::format(" %12llu %12llu",
+                       (unsigned long long) FC.Inclusive.Tokens,
+                       (unsigned long long) FC.Exclusive.Tokens)
+       << llvm::format(" %11llu %11llu",
+                       (unsigned long long) FC.Inclusive.Decls,
+                       (unsigned long long) FC.Exclusive.Decls)
+       << llvm::format(" %11llu %11llu  ",
+                       (unsigned long long) FC.Inclusive.Bytes,
+                       (unsigned long long) FC.Exclusive.Bytes)
+       << FC.Name << "\n";
+  }
+  OS << "\n";
+
+  Entries.clear();
+}
@@ -0,0 +1,291 @@
+//===--- IncludePrefetcher.cpp - Read #included files ahead of time -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code reads the files a translation unit is likely to #include on a pool
+// of worker threads, while the preprocessor is still busy with earlier ones.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/DirectoryLookup.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/System/Threading.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#if defined(LLVM_ON_UNIX) && defined(ENABLE_THREADS) && ENABLE_THREADS != 0
+#include <pthread.h>
+#define HAVE_INCLUDE_PREFETCH_THREADS 1
+#endif
+
+using namespace clang;
+
+#ifdef HAVE_INCLUDE_PREFETCH_THREADS
+
+/// ScanIncludes - Find the #include and #import directives in the given text
+/// by looking at it line by line.  This does not lex the file, so it sees
+/// directives in comments and in blocks that are #if'd out, and it misses
+/// computed includes.  That is good enough for guessing which files will be
+/// needed.
+static void ScanIncludes(const char *Cur, const char *End,
+                         std::vector<std::pair<std::string, bool> > &Includes){
+  while (Cur != End) {
+    while (Cur != End && (*Cur == ' ' || *Cur == '\t'))
+      ++Cur;
+
+    if (Cur != End && *Cur == '#') {
+      ++Cur;
+      while (Cur != End && (*Cur == ' ' || *Cur == '\t'))
+        ++Cur;
+
+      const char *DirectiveStart = Cur;
+      while (Cur != End && ((*Cur >= 'a' && *Cur <= 'z') || *Cur == '_'))
+        ++Cur;
+      llvm::StringRef Directive(DirectiveStart, Cur - DirectiveStart);
+
+      // #include_next depends on where the includer was found, so leave it
+      // alone.
+      if (Directive == "include" || Directive == "import") {
+        while (Cur != End && (*Cur == ' ' || *Cur == '\t'))
+          ++Cur;
+
+        if (Cur != End && (*Cur == '"' || *Cur == '<')) {
+          bool isAngled = *Cur == '<';
+          char Terminator = isAngled ? '>' : '"';
+          const char *FilenameStart = ++Cur;
+          while (Cur != End && *Cur != Terminator && *Cur != '\n' &&
+                 *Cur != '\r')
+            ++Cur;
+          if (Cur != End && *Cur == Terminator && Cur != FilenameStart)
+            Includes.push_back(std::make_pair(std::string(FilenameStart, Cur),
+                                              isAngled));
+        }
+      }
+    }
+
+    // Move on to the next line.
+    while (Cur != End && *Cur != '\n' && *Cur != '\r')
+      ++Cur;
+    while (Cur != End && (*Cur == '\n' || *Cur == '\r'))
+      ++Cur;
+  }
+}
+
+namespace {
+/// PrefetchJob - A file to read and scan on a worker thread.
+struct PrefetchJob {
+  const FileEntry *File;
+
+  /// Buffer - The reference the prefetcher holds to the contents of the file
+  /// in the shared file buffer pool, or null if it could not be read.
+  const llvm::MemoryBuffer *Buffer;
+
+  /// Includes - The files named by the #include directives in the file, and
+  /// whether each was written with angle brackets.
+  std::vector<std::pair<std::string, bool> > Includes;
+
+  explicit PrefetchJob(const FileEntry *FE) : File(FE), Buffer(0) {}
+};
+
+/// IncludePrefetcher - Loads the files that a translation unit is likely to
+/// #include into the shared file buffer pool before the preprocessor gets to
+/// them.  Every time a file is entered, the workers read it and scan it for
+/// the names of the files it #includes; the preprocessor thread then resolves
+/// those names against the header search paths and hands the results to the
+/// workers in turn.  When the preprocessor reaches one of these #includes,
+/// the SourceManager finds the file already in memory.
+///
+/// Only the reading and scanning happens off the preprocessor thread.  The
+/// tokens of a header depend on the macros defined when it is #included, so
+/// the preprocessor still lexes every file itself.
+class IncludePrefetcher : public PPCallbacks {
+  Preprocessor &PP;
+
+  /// Requested - The files that have been handed to the workers already.
+  llvm::SmallPtrSet<const FileEntry*, 64> Requested;
+
+  /// Jobs - Every job created so far, owned by the prefetcher.
+  std::vector<PrefetchJob*> Jobs;
+
+  std::vector<pthread_t> Threads;
+
+  /// Lock - Protects Pending, Finished and ShuttingDown.
+  pthread_mutex_t Lock;
+  pthread_cond_t WorkAvailable;
+
+  /// Pending - The jobs waiting for a worker.
+  std::deque<PrefetchJob*> Pending;
+
+  /// Finished - The jobs the workers are done with, whose #includes have not
+  /// been resolved yet.
+  std::vector<PrefetchJob*> Finished;
+
+  bool ShuttingDown;
+
+  static void *WorkerMain(void *Self);
+  void RunWorker();
+
+  /// Enqueue - Hand the given files to the workers, skipping those that were
+  /// requested before.
+  void Enqueue(const std::vector<const FileEntry*> &Files);
+
+  /// ResolveFinishedJobs - Look up the files #included by the files the
+  /// workers have scanned, and queue them up in turn.
+  void ResolveFinishedJobs();
+
+public:
+  IncludePrefetcher(Preprocessor &PP, unsigned NumThreads);
+  ~IncludePrefetcher();
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType);
+};
+} // end anonymous namespace
+
+IncludePrefetcher::IncludePrefetcher(Preprocessor &pp, unsigned NumThreads)
+  : PP(pp), ShuttingDown(false) {
+  pthread_mutex_init(&Lock, 0);
+  pthread_cond_init(&WorkAvailable, 0);
+
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    pthread_t Thread;
+    if (pthread_create(&Thread, 0, WorkerMain, this) != 0)
+      break;
+    Threads.push_back(Thread);
+  }
+}
+
+IncludePrefetcher::~IncludePrefetcher() {
+  pthread_mutex_lock(&Lock);
+  ShuttingDown = true;
+  pthread_cond_broadcast(&WorkAvailable);
+  pthread_mutex_unlock(&Lock);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    pthread_join(Threads[i], 0);
+
+  pthread_cond_destroy(&WorkAvailable);
+  pthread_mutex_destroy(&Lock);
+
+  // Drop our references to the prefetched files; any the SourceManager uses
+  // stay alive through its own references.
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+    if (Jobs[i]->Buffer)
+      SourceManager::releaseSharedFileBuffer(Jobs[i]->File, Jobs[i]->Buffer);
+    delete Jobs[i];
+  }
+}
+
+void *IncludePrefetcher::WorkerMain(void *Self) {
+  static_cast<IncludePrefetcher*>(Self)->RunWorker();
+  return 0;
+}
+
+void IncludePrefetcher::RunWorker() {
+  pthread_mutex_lock(&Lock);
+  while (true) {
+    while (Pending.empty() && !ShuttingDown)
+      pthread_cond_wait(&WorkAvailable, &Lock);
+    if (ShuttingDown)
+      break;
+
+    PrefetchJob *Job = Pending.front();
+    Pending.pop_front();
+    pthread_mutex_unlock(&Lock);
+
+    // Reading the file pulls it into memory; scanning it touches every page
+    // before the lexer does.
+    Job->Buffer = SourceManager::acquireSharedFileBuffer(Job->File);
+    if (Job->Buffer)
+      ScanIncludes(Job->Buffer->getBufferStart(), Job->Buffer->getBufferEnd(),
+                   Job->Includes);
+
+    pthread_mutex_lock(&Lock);
+    Finished.push_back(Job);
+  }
+  pthread_mutex_unlock(&Lock);
+}
+
+void IncludePrefetcher::Enqueue(const std::vector<const FileEntry*> &Files) {
+  std::vector<PrefetchJob*> NewJobs;
+  for (unsigned i = 0, e = Files.size(); i != e; ++i)
+    if (Requested.insert(Files[i])) {
+      NewJobs.push_back(new PrefetchJob(Files[i]));
+      Jobs.push_back(NewJobs.back());
+    }
+
+  if (NewJobs.empty())
+    return;
+
+  pthread_mutex_lock(&Lock);
+  Pending.insert(Pending.end(), NewJobs.begin(), NewJobs.end());
+  pthread_cond_broadcast(&WorkAvailable);
+  pthread_mutex_unlock(&Lock);
+}
+
+void IncludePrefetcher::ResolveFinishedJobs() {
+  std::vector<PrefetchJob*> Resolve;
+  pthread_mutex_lock(&Lock);
+  Resolve.swap(Finished);
+  pthread_mutex_unlock(&Lock);
+
+  // HeaderSearch is not thread-safe, so lookups happen on this thread.  They
+  // land in its lookup cache, which makes the real #include cheaper too.
+  HeaderSearch &HS = PP.getHeaderSearchInfo();
+  std::vector<const FileEntry*> Files;
+  for (unsigned i = 0, e = Resolve.size(); i != e; ++i) {
+    PrefetchJob &Job = *Resolve[i];
+    for (unsigned j = 0, je = Job.Includes.size(); j != je; ++j) {
+      const DirectoryLookup *CurDir;
+      if (const FileEntry *FE = HS.LookupFile(Job.Includes[j].first,
+                                              Job.Includes[j].second,
+                                              /*FromDir=*/0, CurDir, Job.File))
+        Files.push_back(FE);
+    }
+  }
+
+  Enqueue(Files);
+}
+
+void IncludePrefetcher::FileChanged(SourceLocation Loc,
+                                    FileChangeReason Reason,
+                                    SrcMgr::CharacteristicKind FileType) {
+  if (Reason == PPCallbacks::EnterFile) {
+    SourceManager &SM = PP.getSourceManager();
+    if (const FileEntry *FE =
+          SM.getFileEntryForID(SM.getFileID(SM.getInstantiationLoc(Loc))))
+      Enqueue(std::vector<const FileEntry*>(1, FE));
+  }
+
+  ResolveFinishedJobs();
+}
+
+#endif // HAVE_INCLUDE_PREFETCH_THREADS
+
+void clang::AttachIncludePrefetcher(Preprocessor &PP, unsigned NumThreads) {
+#ifdef HAVE_INCLUDE_PREFETCH_THREADS
+  // The shared file buffer pool is only thread-safe in multithreaded mode.
+  if (NumThreads == 0 ||
+      (!llvm::llvm_is_multithreaded() && !llvm::llvm_start_multithreaded()))
+    return;
+
+  // Only files taken from the shared pool benefit from being read ahead.
+  PP.getSourceManager().setShareFileBuffers(true);
+  PP.setPPCallbacks(new IncludePrefetcher(PP, NumThreads));
+#endif
+}
@@ -755,4 +755,9 @@ void clang::ApplyHeaderSearchOptions(HeaderSearch &HS,
     Init.AddDefaultSystemIncludePaths(Lang, Triple);
 
   Init.Realize();
+
+  // The persistent lookup cache is keyed by the final search path list, so it
+  // can only be opened once that list is known.
+  if (!HSOpts.LookupCacheFile.empty())
+    HS.SetPersistentLookupCache(HSOpts.LookupCacheFile);
 }
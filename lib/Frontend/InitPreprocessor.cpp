@@ -17,6 +17,7 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendOptions.h"
 #include "clang/Frontend/PreprocessorOptions.h"
+#include "clang/Lex/PrecomputedPredefines.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
@@ -487,6 +488,28 @@ static void InitializeFileRemapping(Diagnostic &Diags,
   }
 }
 
+/// UsePredefinesCache - Give \arg PP the macros defined by \arg Text, from
+/// the cache in \arg CacheDir if it has them, so that PP does not lex Text.
+/// The cache is filled in on a miss.
+static void UsePredefinesCache(Preprocessor &PP, llvm::StringRef CacheDir,
+                               llvm::StringRef Text) {
+  llvm::sys::Path Path(CacheDir);
+  Path.appendComponent(PrecomputedPredefines::getCacheFileName(Text));
+
+  PrecomputedPredefines *P = PrecomputedPredefines::Read(Path.str(), Text);
+  if (!P) {
+    P = PrecomputedPredefines::Compute(PP, Text);
+    if (!P)
+      return;
+
+    // The cache is only an optimization; failing to update it is harmless.
+    llvm::sys::Path(CacheDir).createDirectoryOnDisk(/*create_parents=*/true);
+    P->Write(Path.str());
+  }
+
+  PP.setPrecomputedPredefines(P);
+}
+
 /// InitializePreprocessor - Initialize the preprocessor getting it and the
 /// environment ready to process a single file. This returns true on error.
 ///
@@ -509,6 +532,11 @@ void clang::InitializePreprocessor(Preprocessor &PP,
     InitializePredefinedMacros(PP.getTargetInfo(), PP.getLangOptions(),
                                FEOpts, Builder);
 
+  // The text so far only depends on the target and the language options, so
+  // its macros can be shared with other compilations.
+  if (!InitOpts.PredefinesCacheDir.empty())
+    UsePredefinesCache(PP, InitOpts.PredefinesCacheDir, Predefines.str());
+
   // Add on the predefines from the driver.  Wrap in a #line directive to report
   // that they come from the command line.
   Builder.append("# 1 \"<command line>\" 1");
@@ -541,9 +569,16 @@ void clang::InitializePreprocessor(Preprocessor &PP,
 
   // Copy PredefinedBuffer into the Preprocessor.
   PP.setPredefines(Predefines.str());
+  PP.setSkipMainFilePreambleBytes(InitOpts.PrecompiledPreambleBytes);
 
   // Initialize the header search object.
   ApplyHeaderSearchOptions(PP.getHeaderSearchInfo(), HSOpts,
                            PP.getLangOptions(),
                            PP.getTargetInfo().getTriple());
+
+  // The guard database hands out identifiers, so it is set up here rather
+  // than with the rest of the header search options.
+  if (!HSOpts.GuardDatabaseFile.empty())
+    PP.getHeaderSearchInfo().SetGuardDatabase(HSOpts.GuardDatabaseFile,
+                                              PP.getIdentifierTable());
 }
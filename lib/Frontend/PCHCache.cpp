@@ -0,0 +1,175 @@
+//===--- PCHCache.cpp - Shared cache of generated PCH files ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code looks up and installs the PCH files of compiler invocations in a
+// cache directory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/PCHCache.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/PCHBitCodes.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace clang;
+
+/// \brief The version of the format of the entries of the cache.
+static const unsigned PCHCacheVersion = 2;
+
+static void WriteUInt64(llvm::raw_ostream &OS, uint64_t Value) {
+  OS.write((const char *)&Value, sizeof(uint64_t));
+}
+
+static bool ReadUInt64(const char *&Memory, const char *MemoryEnd,
+                       uint64_t &Value) {
+  if (MemoryEnd - Memory < (ptrdiff_t)sizeof(uint64_t))
+    return true;
+
+  memcpy(&Value, Memory, sizeof(uint64_t));
+  Memory += sizeof(uint64_t);
+  return false;
+}
+
+static void WriteString(llvm::raw_ostream &OS, llvm::StringRef Str) {
+  WriteUInt64(OS, Str.size());
+  OS << Str;
+}
+
+static bool ReadString(const char *&Memory, const char *MemoryEnd,
+                       std::string &Str) {
+  uint64_t Length;
+  if (ReadUInt64(Memory, MemoryEnd, Length) ||
+      Length > uint64_t(MemoryEnd - Memory))
+    return true;
+
+  Str.assign(Memory, Length);
+  Memory += Length;
+  return false;
+}
+
+static uint64_t HashBuffer(const llvm::MemoryBuffer *Buffer) {
+  return pch::HashBytes(Buffer->getBufferStart(), Buffer->getBufferEnd());
+}
+
+PCHCache::PCHCache(llvm::StringRef Dir, const CompilerInvocation &Invocation,
+                   bool ReadOnly)
+  : ReadOnly(ReadOnly) {
+  // The same invocation writing its PCH file elsewhere, or using the cache
+  // differently, builds the same PCH file.
+  CompilerInvocation Copy(Invocation);
+  Copy.getFrontendOpts().OutputFile.clear();
+  Copy.getFrontendOpts().PCHCacheDir.clear();
+  Copy.getFrontendOpts().PCHCacheReadOnly = 0;
+  std::vector<std::string> Args;
+  Copy.toArgs(Args);
+
+  Key = getClangFullRepositoryVersion();
+  for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+    Key += '\0';
+    Key += Args[I];
+  }
+
+  char Name[32];
+  snprintf(Name, sizeof(Name), "pch-%016llx",
+           (unsigned long long)pch::HashBytes(Key.data(),
+                                              Key.data() + Key.size()));
+  EntryPath = llvm::sys::Path(Dir);
+  EntryPath.appendComponent(Name);
+}
+
+bool PCHCache::lookup(std::string &PCH) const {
+  llvm::OwningPtr<llvm::MemoryBuffer> Buffer(
+                                llvm::MemoryBuffer::getFile(EntryPath.str()));
+  if (!Buffer)
+    return false;
+
+  const char *Memory = Buffer->getBufferStart();
+  const char *MemoryEnd = Buffer->getBufferEnd();
+  uint64_t Version, NumInputs;
+  std::string EntryKey;
+  if (MemoryEnd - Memory < 7 || memcmp(Memory, "cfe-pch", 7))
+    return false;
+  Memory += 7;
+  if (ReadUInt64(Memory, MemoryEnd, Version) || Version != PCHCacheVersion ||
+      ReadString(Memory, MemoryEnd, EntryKey) || EntryKey != Key ||
+      ReadUInt64(Memory, MemoryEnd, NumInputs))
+    return false;
+
+  // Every input file must still have the contents it had when the PCH file
+  // was built; a file that has changed makes the entry stale.
+  for (uint64_t I = 0; I != NumInputs; ++I) {
+    std::string Name;
+    uint64_t Size, Hash;
+    if (ReadString(Memory, MemoryEnd, Name) ||
+        ReadUInt64(Memory, MemoryEnd, Size) ||
+        ReadUInt64(Memory, MemoryEnd, Hash))
+      return false;
+
+    llvm::OwningPtr<llvm::MemoryBuffer> File(
+                                         llvm::MemoryBuffer::getFile(Name));
+    if (!File || File->getBufferSize() != Size ||
+        HashBuffer(File.get()) != Hash)
+      return false;
+  }
+
+  // An entry cut short, by a crash or a full disk, is not a PCH file.
+  uint64_t PCHSize;
+  if (ReadUInt64(Memory, MemoryEnd, PCHSize) ||
+      uint64_t(MemoryEnd - Memory) != PCHSize)
+    return false;
+
+  PCH.assign(Memory, MemoryEnd);
+  return true;
+}
+
+void PCHCache::store(const SourceManager &SM, llvm::StringRef PCH) const {
+  if (ReadOnly)
+    return;
+
+  // Write to a temporary file first so that concurrent compilers reading the
+  // cache never see a partially written entry.
+  llvm::sys::Path(EntryPath.getDirname()).createDirectoryOnDisk(
+                                                     /*create_parents=*/true);
+  AtomicOutputFile File(EntryPath.str());
+  std::string ErrorInfo;
+  if (File.open(ErrorInfo))
+    return;
+
+  uint64_t NumInputs = 0;
+  for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
+         E = SM.fileinfo_end(); I != E; ++I)
+    ++NumInputs;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << "cfe-pch";
+  WriteUInt64(Out, PCHCacheVersion);
+  WriteString(Out, Key);
+  WriteUInt64(Out, NumInputs);
+  for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
+         E = SM.fileinfo_end(); I != E; ++I) {
+    const llvm::MemoryBuffer *Buffer = I->second->getBuffer();
+    WriteString(Out, I->first->getName());
+    WriteUInt64(Out, Buffer->getBufferSize());
+    WriteUInt64(Out, HashBuffer(Buffer));
+  }
+  WriteUInt64(Out, PCH.size());
+  Out << PCH;
+
+  // A failed write leaves the previous entry, if any, in place.
+  File.commit(ErrorInfo);
+}
@@ -18,12 +18,14 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Expr.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/SourceManagerInternals.h"
 #include "clang/Basic/FileManager.h"
@@ -135,6 +137,17 @@ bool PCHValidator::ReadTargetTriple(llvm::StringRef Triple) {
   return true;
 }
 
+/// \brief Return the location of the given offset into the predefines of a
+/// PCH file, or an invalid location for the definitions that were added by
+/// the upper layers of a layered PCH file.
+static SourceLocation getPredefinesLoc(SourceManager &SourceMgr,
+                                       FileID PCHBufferID, unsigned Offset) {
+  if (Offset >= SourceMgr.getBuffer(PCHBufferID)->getBufferSize())
+    return SourceLocation();
+  return SourceMgr.getLocForStartOfFile(PCHBufferID)
+    .getFileLocWithOffset(Offset);
+}
+
 bool PCHValidator::ReadPredefinesBuffer(llvm::StringRef PCHPredef,
                                         FileID PCHBufferID,
                                         llvm::StringRef OriginalFileName,
@@ -229,8 +242,8 @@ bool PCHValidator::ReadPredefinesBuffer(llvm::StringRef PCHPredef,
       // Show the definition of this macro within the PCH file.
       llvm::StringRef::size_type Offset = PCHPredef.find(Missing);
       assert(Offset != llvm::StringRef::npos && "Unable to find macro!");
-      SourceLocation PCHMissingLoc = SourceMgr.getLocForStartOfFile(PCHBufferID)
-        .getFileLocWithOffset(Offset);
+      SourceLocation PCHMissingLoc
+        = getPredefinesLoc(SourceMgr, PCHBufferID, Offset);
       Reader.Diag(PCHMissingLoc, diag::note_pch_macro_defined_as) << MacroName;
 
       ConflictingDefines = true;
@@ -250,8 +263,8 @@ bool PCHValidator::ReadPredefinesBuffer(llvm::StringRef PCHPredef,
     // Show the definition of this macro within the PCH file.
     llvm::StringRef::size_type Offset = PCHPredef.find(Missing);
     assert(Offset != llvm::StringRef::npos && "Unable to find macro!");
-    SourceLocation PCHMissingLoc = SourceMgr.getLocForStartOfFile(PCHBufferID)
-      .getFileLocWithOffset(Offset);
+    SourceLocation PCHMissingLoc
+      = getPredefinesLoc(SourceMgr, PCHBufferID, Offset);
     Reader.Diag(PCHMissingLoc, diag::note_using_macro_def_from_pch);
   }
 
@@ -317,6 +330,7 @@ PCHReader::PCHReader(Preprocessor &PP, ASTContext *Context,
   : Listener(new PCHValidator(PP, *this)), SourceMgr(PP.getSourceManager()),
     FileMgr(PP.getFileManager()), Diags(PP.getDiagnostics()),
     SemaObj(0), PP(&PP), Context(Context), StatCache(0), Consumer(0),
+    Buffer(0), SharedBufferFile(0), SLocOffsets(0), TotalNumSLocEntries(0),
     IdentifierTableData(0), IdentifierLookupTable(0),
     IdentifierOffsets(0),
     MethodPoolLookupTable(0), MethodPoolLookupTableData(0),
@@ -324,8 +338,10 @@ PCHReader::PCHReader(Preprocessor &PP, ASTContext *Context,
     TotalNumSelectors(0), Comments(0), NumComments(0), isysroot(isysroot),
     NumStatHits(0), NumStatMisses(0),
     NumSLocEntriesRead(0), NumStatementsRead(0),
-    NumMacrosRead(0), NumMethodPoolSelectorsRead(0), NumMethodPoolMisses(0),
+    NumMacrosRead(0), NumMethodPoolListsRead(0), NumMethodPoolMisses(0),
     NumLexicalDeclContextsRead(0), NumVisibleDeclContextsRead(0),
+    NumFunctionBodiesRead(0), TotalNumFunctionBodies(0),
+    NumRecordLayoutsRead(0), TotalNumRecordLayouts(0),
     CurrentlyLoadingTypeOrDecl(0) {
   RelocatablePCH = false;
 }
@@ -334,6 +350,7 @@ PCHReader::PCHReader(SourceManager &SourceMgr, FileManager &FileMgr,
                      Diagnostic &Diags, const char *isysroot)
   : SourceMgr(SourceMgr), FileMgr(FileMgr), Diags(Diags),
     SemaObj(0), PP(0), Context(0), StatCache(0), Consumer(0),
+    Buffer(0), SharedBufferFile(0), SLocOffsets(0), TotalNumSLocEntries(0),
     IdentifierTableData(0), IdentifierLookupTable(0),
     IdentifierOffsets(0),
     MethodPoolLookupTable(0), MethodPoolLookupTableData(0),
@@ -341,13 +358,20 @@ PCHReader::PCHReader(SourceManager &SourceMgr, FileManager &FileMgr,
     TotalNumSelectors(0), Comments(0), NumComments(0), isysroot(isysroot),
     NumStatHits(0), NumStatMisses(0),
     NumSLocEntriesRead(0), NumStatementsRead(0),
-    NumMacrosRead(0), NumMethodPoolSelectorsRead(0), NumMethodPoolMisses(0),
+    NumMacrosRead(0), NumMethodPoolListsRead(0), NumMethodPoolMisses(0),
     NumLexicalDeclContextsRead(0), NumVisibleDeclContextsRead(0),
+    NumFunctionBodiesRead(0), TotalNumFunctionBodies(0),
+    NumRecordLayoutsRead(0), TotalNumRecordLayouts(0),
     CurrentlyLoadingTypeOrDecl(0) {
   RelocatablePCH = false;
 }
 
-PCHReader::~PCHReader() {}
+PCHReader::~PCHReader() {
+  if (SharedBufferFile)
+    SourceManager::releaseSharedFileBuffer(SharedBufferFile, Buffer);
+  else
+    delete Buffer;
+}
 
 Expr *PCHReader::ReadDeclExpr() {
   return dyn_cast_or_null<Expr>(ReadStmt(DeclsCursor));
@@ -363,7 +387,7 @@ class PCHMethodPoolLookupTrait {
   PCHReader &Reader;
 
 public:
-  typedef std::pair<ObjCMethodList, ObjCMethodList> data_type;
+  typedef const unsigned char *data_type;
 
   typedef Selector external_key_type;
   typedef external_key_type internal_key_type;
@@ -417,50 +441,10 @@ public:
     return SelTable.getSelector(N, Args.data());
   }
 
+  // The methods are only deserialized once it is known which of the
+  // instance and factory methods are needed, see PCHReader::ReadMethodPool.
   data_type ReadData(Selector, const unsigned char* d, unsigned DataLen) {
-    using namespace clang::io;
-    unsigned NumInstanceMethods = ReadUnalignedLE16(d);
-    unsigned NumFactoryMethods = ReadUnalignedLE16(d);
-
-    data_type Result;
-
-    // Load instance methods
-    ObjCMethodList *Prev = 0;
-    for (unsigned I = 0; I != NumInstanceMethods; ++I) {
-      ObjCMethodDecl *Method
-        = cast<ObjCMethodDecl>(Reader.GetDecl(ReadUnalignedLE32(d)));
-      if (!Result.first.Method) {
-        // This is the first method, which is the easy case.
-        Result.first.Method = Method;
-        Prev = &Result.first;
-        continue;
-      }
-
-      ObjCMethodList *Mem =
-        Reader.getSema()->BumpAlloc.Allocate<ObjCMethodList>();
-      Prev->Next = new (Mem) ObjCMethodList(Method, 0);
-      Prev = Prev->Next;
-    }
-
-    // Load factory methods
-    Prev = 0;
-    for (unsigned I = 0; I != NumFactoryMethods; ++I) {
-      ObjCMethodDecl *Method
-        = cast<ObjCMethodDecl>(Reader.GetDecl(ReadUnalignedLE32(d)));
-      if (!Result.second.Method) {
-        // This is the first method, which is the easy case.
-        Result.second.Method = Method;
-        Prev = &Result.second;
-        continue;
-      }
-
-      ObjCMethodList *Mem =
-        Reader.getSema()->BumpAlloc.Allocate<ObjCMethodList>();
-      Prev->Next = new (Mem) ObjCMethodList(Method, 0);
-      Prev = Prev->Next;
-    }
-
-    return Result;
+    return d;
   }
 };
 
@@ -495,8 +479,8 @@ public:
                                   : false;
   }
 
-  static unsigned ComputeHash(const internal_key_type& a) {
-    return llvm::HashString(llvm::StringRef(a.first, a.second));
+  static uint64_t ComputeHash(const internal_key_type& a) {
+    return pch::HashBytes(a.first, a.first + a.second);
   }
 
   // This hopefully will just get inlined and removed by the optimizer.
@@ -572,11 +556,11 @@ public:
            "Incorrect C++ operator keyword flag");
     (void)CPlusPlusOperatorKeyword;
 
-    // If this identifier is a macro, deserialize the macro
-    // definition.
+    // If this identifier is a macro, note where its definition is; it is
+    // only deserialized when the preprocessor looks for it.
     if (hasMacroDefinition) {
       uint32_t Offset = ReadUnalignedLE32(d);
-      Reader.ReadMacroRecord(Offset);
+      Reader.SetIdentifierIsMacro(II, Offset);
       DataLen -= 4;
     }
 
@@ -598,7 +582,7 @@ public:
 
 /// \brief The on-disk hash table used to contain information about
 /// all of the identifiers in the program.
-typedef OnDiskChainedHashTable<PCHIdentifierLookupTrait>
+typedef OnDiskPerfectHashTable<PCHIdentifierLookupTrait>
   PCHIdentifierLookupTable;
 
 bool PCHReader::Error(const char *Msg) {
@@ -870,6 +854,33 @@ PCHReader::PCHReadResult PCHReader::ReadSourceManagerBlock() {
   }
 }
 
+/// \brief Determine whether an input file of a PCH file has changed since the
+/// PCH file was built.
+///
+/// A file of the same size whose modification time differs (e.g. in another
+/// checkout) has only changed if the PCH file recorded a hash of its contents
+/// that no longer matches.
+static bool InputFileModified(const std::string &Filename, uint64_t Size,
+                              uint64_t ModTime, uint64_t Hash) {
+  // The stat cache of the PCH file answers with what was recorded when the
+  // PCH file was built, so ask the file system itself.  Files that are not
+  // on disk, such as virtual files, cannot be checked.
+  struct stat StatBuf;
+  if (::stat(Filename.c_str(), &StatBuf))
+    return false;
+  if ((uint64_t)StatBuf.st_size != Size)
+    return true;
+  if ((uint64_t)StatBuf.st_mtime == ModTime || !Hash)
+    return false;
+
+  llvm::OwningPtr<llvm::MemoryBuffer>
+    Buffer(llvm::MemoryBuffer::getFile(Filename.c_str()));
+  if (!Buffer)
+    return true;
+  return pch::HashBytes(Buffer->getBufferStart(),
+                        Buffer->getBufferEnd()) != Hash;
+}
+
 /// \brief Read in the source location entry with the given ID.
 PCHReader::PCHReadResult PCHReader::ReadSLocEntryRecord(unsigned ID) {
   if (ID == 0)
@@ -910,6 +921,15 @@ PCHReader::PCHReadResult PCHReader::ReadSLocEntryRecord(unsigned ID) {
       return Failure;
     }
 
+    if (Record.size() >= 7 &&
+        InputFileModified(Filename, Record[4], Record[5], Record[6])) {
+      std::string ErrorStr = "file '";
+      ErrorStr += Filename;
+      ErrorStr += "' has been modified since the PCH file was built";
+      Error(ErrorStr.c_str());
+      return Failure;
+    }
+
     FileID FID = SourceMgr.createFileID(File,
                                 SourceLocation::getFromRawEncoding(Record[1]),
                                        (SrcMgr::CharacteristicKind)Record[2],
@@ -918,6 +938,17 @@ PCHReader::PCHReadResult PCHReader::ReadSLocEntryRecord(unsigned ID) {
       const_cast<SrcMgr::FileInfo&>(SourceMgr.getSLocEntry(FID).getFile())
         .setHasLineDirectives();
 
+    // The lines of the file may follow its first entry.  They are only
+    // decoded if a line number in the file is asked for.
+    Code = SLocEntryCursor.ReadCode();
+    if (Code != llvm::bitc::END_BLOCK &&
+        Code != llvm::bitc::ENTER_SUBBLOCK &&
+        Code != llvm::bitc::DEFINE_ABBREV) {
+      Record.clear();
+      if (SLocEntryCursor.ReadRecord(Code, Record, &BlobStart, &BlobLen)
+            == pch::SM_SLOC_FILE_LINES)
+        FileLineOffsets[File] = std::make_pair(BlobStart, BlobLen);
+    }
     break;
   }
 
@@ -937,9 +968,21 @@ PCHReader::PCHReadResult PCHReader::ReadSLocEntryRecord(unsigned ID) {
     FileID BufferID = SourceMgr.createFileIDForMemBuffer(Buffer, ID, Offset);
 
     if (strcmp(Name, "<built-in>") == 0) {
-      PCHPredefinesBufferID = BufferID;
-      PCHPredefines = BlobStart;
-      PCHPredefinesLen = BlobLen - 1;
+      if (PCHPredefinesBufferID.isInvalid()) {
+        PCHPredefinesBufferID = BufferID;
+        PCHPredefines = BlobStart;
+        PCHPredefinesLen = BlobLen - 1;
+      } else {
+        // A PCH file built on top of another one has a predefines buffer
+        // per layer: the first holds the predefines of the bottom layer,
+        // the others the definitions added when building the layers above
+        // it.  They are checked as a whole.
+        if (LayeredPredefines.empty())
+          LayeredPredefines.assign(PCHPredefines, PCHPredefinesLen);
+        LayeredPredefines.append(BlobStart, BlobLen - 1);
+        PCHPredefines = LayeredPredefines.data();
+        PCHPredefinesLen = LayeredPredefines.size();
+      }
     }
 
     break;
@@ -1085,6 +1128,28 @@ void PCHReader::ReadMacroRecord(uint64_t Offset) {
   }
 }
 
+void PCHReader::SetIdentifierIsMacro(IdentifierInfo *II, uint64_t Offset) {
+  // A definition that replaces one the preprocessor already has cannot wait.
+  if (II->hasMacroDefinition()) {
+    ReadMacroRecord(Offset);
+    return;
+  }
+
+  UnreadMacroRecordOffsets[II] = Offset;
+  II->setHasMacroDefinition(true);
+}
+
+void PCHReader::LoadMacroDefinition(IdentifierInfo *II) {
+  llvm::DenseMap<IdentifierInfo *, uint64_t>::iterator Pos
+    = UnreadMacroRecordOffsets.find(II);
+  if (Pos == UnreadMacroRecordOffsets.end())
+    return;
+
+  uint64_t Offset = Pos->second;
+  UnreadMacroRecordOffsets.erase(Pos);
+  ReadMacroRecord(Offset);
+}
+
 void PCHReader::ReadDefinedMacros() {
   // If there was no preprocessor block, do nothing.
   if (!MacroCursor.getBitStreamReader())
@@ -1130,7 +1195,10 @@ void PCHReader::ReadDefinedMacros() {
         
     case pch::PP_MACRO_OBJECT_LIKE:
     case pch::PP_MACRO_FUNCTION_LIKE:
-        DecodeIdentifierInfo(Record[0]);
+      // Looking up the macro reads the definition unless the preprocessor
+      // has replaced or removed it in the meantime.
+      if (IdentifierInfo *II = DecodeIdentifierInfo(Record[0]))
+        PP->getMacroInfo(II);
       break;
 
     case pch::PP_TOKEN:
@@ -1322,6 +1390,8 @@ PCHReader::ReadPCHBlock() {
       TotalNumMacros = Record[1];
       TotalLexicalDeclContexts = Record[2];
       TotalVisibleDeclContexts = Record[3];
+      if (Record.size() > 4)
+        TotalNumFunctionBodies = Record[4];
       break;
 
     case pch::TENTATIVE_DEFINITIONS:
@@ -1376,6 +1446,14 @@ PCHReader::ReadPCHBlock() {
       SourceMgr.PreallocateSLocEntries(this, TotalNumSLocEntries, Record[1]);
       break;
 
+    case pch::SOURCE_LOCATION_ENTRY_STARTS:
+      if (!SLocOffsets || Record[0] != TotalNumSLocEntries) {
+        Error("malformed SOURCE_LOCATION_ENTRY_STARTS record in PCH file");
+        return Failure;
+      }
+      SourceMgr.setPreallocatedSLocOffsets((const uint32_t *)BlobStart);
+      break;
+
     case pch::SOURCE_LOCATION_PRELOADS:
       for (unsigned I = 0, N = Record.size(); I != N; ++I) {
         PCHReadResult Result = ReadSLocEntryRecord(Record[I]);
@@ -1402,6 +1480,23 @@ PCHReader::ReadPCHBlock() {
       ExtVectorDecls.swap(Record);
       break;
 
+    case pch::RECORD_LAYOUTS:
+      if (!RecordLayouts.empty()) {
+        Error("duplicate RECORD_LAYOUTS record in PCH file");
+        return Failure;
+      }
+      RecordLayouts.swap(Record);
+      for (unsigned I = 0, N = RecordLayouts.size(); I != N;
+           I += 2 + RecordLayouts[I + 1]) {
+        if (N - I < 2 || RecordLayouts[I + 1] > N - I - 2) {
+          Error("malformed RECORD_LAYOUTS record in PCH file");
+          return Failure;
+        }
+        RecordLayoutOffsets[RecordLayouts[I]] = I + 2;
+      }
+      TotalNumRecordLayouts = RecordLayoutOffsets.size();
+      break;
+
     case pch::ORIGINAL_FILE_NAME:
       ActualOriginalFileName.assign(BlobStart, BlobLen);
       OriginalFileName = ActualOriginalFileName;
@@ -1429,6 +1524,8 @@ PCHReader::ReadPCHBlock() {
 }
 
 PCHReader::PCHReadResult PCHReader::ReadPCH(const std::string &FileName) {
+  PhaseRegion Phase("PCH load");
+
   // Set the PCH file name.
   this->FileName = FileName;
 
@@ -1436,7 +1533,13 @@ PCHReader::PCHReadResult PCHReader::ReadPCH(const std::string &FileName) {
   //
   // FIXME: This shouldn't be here, we should just take a raw_ostream.
   std::string ErrStr;
-  Buffer.reset(llvm::MemoryBuffer::getFileOrSTDIN(FileName, &ErrStr));
+  if (const FileEntry *FE = FileMgr.getFile(FileName)) {
+    Buffer = SourceManager::acquireSharedFileBuffer(FE, &ErrStr);
+    if (Buffer)
+      SharedBufferFile = FE;
+  }
+  if (!Buffer)
+    Buffer = llvm::MemoryBuffer::getFileOrSTDIN(FileName, &ErrStr);
   if (!Buffer) {
     Error(ErrStr.c_str());
     return IgnorePCH;
@@ -2313,9 +2416,65 @@ Stmt *PCHReader::GetDeclStmt(uint64_t Offset) {
   // Since we know tha this statement is part of a decl, make sure to use the
   // decl cursor to read it.
   DeclsCursor.JumpToBit(Offset);
+  ++NumFunctionBodiesRead;
   return ReadStmt(DeclsCursor);
 }
 
+void PCHReader::PrefetchFunctionBodies(const FunctionDecl * const *Begin,
+                                       const FunctionDecl * const *End) {
+  // Reading the bodies front to back, rather than in the order in which
+  // they are requested, keeps the reads of the mapped PCH file local.
+  llvm::SmallVector<std::pair<uint64_t, const FunctionDecl *>, 16> Bodies;
+  for (; Begin != End; ++Begin)
+    if (uint64_t Offset = (*Begin)->getLazyBodyOffset())
+      Bodies.push_back(std::make_pair(Offset, *Begin));
+  if (Bodies.size() < 2)
+    return;
+
+  std::sort(Bodies.begin(), Bodies.end());
+  for (unsigned I = 0, N = Bodies.size(); I != N; ++I)
+    Bodies[I].second->getBody();
+}
+
+const ASTRecordLayout *PCHReader::GetRecordLayout(const RecordDecl *D) {
+  llvm::DenseMap<const RecordDecl *, unsigned>::iterator Pos
+    = LoadedRecordLayouts.find(D);
+  if (Pos == LoadedRecordLayouts.end())
+    return 0;
+
+  // The writer only stores the layouts whose bases it wrote as well.
+  const uint64_t *Record = RecordLayouts.begin() + Pos->second;
+  const uint64_t *FieldOffsets = Record + 4;
+  unsigned Idx = 4 + Record[3];
+  LoadedRecordLayouts.erase(Pos);
+  ++NumRecordLayoutsRead;
+  if (!Record[Idx++])
+    return new ASTRecordLayout(Record[0], Record[2], Record[1], FieldOffsets,
+                               Record[3]);
+
+  uint64_t NonVirtualSize = Record[Idx++];
+  unsigned NonVirtualAlign = Record[Idx++];
+  const CXXRecordDecl *PrimaryBaseDecl
+    = cast_or_null<CXXRecordDecl>(GetDecl(Record[Idx++]));
+  ASTRecordLayout::PrimaryBaseInfo PrimaryBase(PrimaryBaseDecl,
+                                               Record[Idx++]);
+
+  typedef std::pair<const CXXRecordDecl *, uint64_t> BaseOffset;
+  llvm::SmallVector<BaseOffset, 4> Offsets[2];
+  for (unsigned M = 0; M != 2; ++M) {
+    for (unsigned I = 0, N = Record[Idx++]; I != N; ++I) {
+      const CXXRecordDecl *Base = cast<CXXRecordDecl>(GetDecl(Record[Idx++]));
+      Offsets[M].push_back(BaseOffset(Base, Record[Idx++]));
+    }
+  }
+
+  return new ASTRecordLayout(Record[0], Record[2], Record[1], FieldOffsets,
+                             Record[3], NonVirtualSize, NonVirtualAlign,
+                             PrimaryBase,
+                             Offsets[0].begin(), Offsets[0].size(),
+                             Offsets[1].begin(), Offsets[1].size());
+}
+
 bool PCHReader::ReadDeclsLexicallyInContext(DeclContext *DC,
                                   llvm::SmallVectorImpl<pch::DeclID> &Decls) {
   assert(DC->hasExternalLexicalStorage() &&
@@ -2445,6 +2604,14 @@ void PCHReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u statements read (%f%%)\n",
                  NumStatementsRead, TotalNumStatements,
                  ((float)NumStatementsRead/TotalNumStatements * 100));
+  if (TotalNumFunctionBodies)
+    std::fprintf(stderr, "  %u/%u function bodies read (%f%%)\n",
+                 NumFunctionBodiesRead, TotalNumFunctionBodies,
+                 ((float)NumFunctionBodiesRead/TotalNumFunctionBodies * 100));
+  if (TotalNumRecordLayouts)
+    std::fprintf(stderr, "  %u/%u record layouts read (%f%%)\n",
+                 NumRecordLayoutsRead, TotalNumRecordLayouts,
+                 ((float)NumRecordLayoutsRead/TotalNumRecordLayouts * 100));
   if (TotalNumMacros)
     std::fprintf(stderr, "  %u/%u macros read (%f%%)\n",
                  NumMacrosRead, TotalNumMacros,
@@ -2460,15 +2627,26 @@ void PCHReader::PrintStats() {
                  ((float)NumVisibleDeclContextsRead/TotalVisibleDeclContexts
                   * 100));
   if (TotalSelectorsInMethodPool) {
-    std::fprintf(stderr, "  %u/%u method pool entries read (%f%%)\n",
-                 NumMethodPoolSelectorsRead, TotalSelectorsInMethodPool,
-                 ((float)NumMethodPoolSelectorsRead/TotalSelectorsInMethodPool
-                  * 100));
+    // Every selector has a list of instance methods and a list of factory
+    // methods, which are read separately.
+    unsigned TotalLists = 2 * TotalSelectorsInMethodPool;
+    std::fprintf(stderr, "  %u/%u method pool lists read (%f%%)\n",
+                 NumMethodPoolListsRead, TotalLists,
+                 ((float)NumMethodPoolListsRead/TotalLists * 100));
     std::fprintf(stderr, "  %u method pool misses\n", NumMethodPoolMisses);
   }
   std::fprintf(stderr, "\n");
 }
 
+size_t PCHReader::getMemoryUsage() const {
+  return (Buffer ? Buffer->getBufferSize() : 0) +
+         TypesLoaded.capacity() * sizeof(QualType) +
+         DeclsLoaded.capacity() * sizeof(Decl *) +
+         IdentifiersLoaded.capacity() * sizeof(IdentifierInfo *) +
+         SelectorsLoaded.capacity() * sizeof(Selector) +
+         DeclContextOffsets.size() * sizeof(DeclContextOffsetsMap::value_type);
+}
+
 void PCHReader::InitializeSema(Sema &S) {
   SemaObj = &S;
   S.ExternalSource = this;
@@ -2525,10 +2703,9 @@ IdentifierInfo* PCHReader::get(const char *NameStart, const char *NameEnd) {
   return *Pos;
 }
 
-std::pair<ObjCMethodList, ObjCMethodList>
-PCHReader::ReadMethodPool(Selector Sel) {
+ObjCMethodList PCHReader::ReadMethodPool(Selector Sel, bool isInstance) {
   if (!MethodPoolLookupTable)
-    return std::pair<ObjCMethodList, ObjCMethodList>();
+    return ObjCMethodList();
 
   // Try to find this selector within our on-disk hash table.
   PCHMethodPoolLookupTable *PoolTable
@@ -2536,11 +2713,51 @@ PCHReader::ReadMethodPool(Selector Sel) {
   PCHMethodPoolLookupTable::iterator Pos = PoolTable->find(Sel);
   if (Pos == PoolTable->end()) {
     ++NumMethodPoolMisses;
-    return std::pair<ObjCMethodList, ObjCMethodList>();;
+    return ObjCMethodList();
+  }
+
+  // The entry holds the IDs of the instance methods, then the IDs of the
+  // factory methods; only the requested ones are loaded.
+  using namespace clang::io;
+  const unsigned char *d = *Pos;
+  unsigned NumInstanceMethods = ReadUnalignedLE16(d);
+  unsigned NumFactoryMethods = ReadUnalignedLE16(d);
+  unsigned NumMethods = NumInstanceMethods;
+  if (!isInstance) {
+    d += 4 * NumInstanceMethods;
+    NumMethods = NumFactoryMethods;
+  }
+
+  ++NumMethodPoolListsRead;
+  ObjCMethodList Result;
+  ObjCMethodList *Prev = 0;
+  for (unsigned I = 0; I != NumMethods; ++I) {
+    ObjCMethodDecl *Method
+      = cast<ObjCMethodDecl>(GetDecl(ReadUnalignedLE32(d)));
+    if (!Result.Method) {
+      // This is the first method, which is the easy case.
+      Result.Method = Method;
+      Prev = &Result;
+      continue;
+    }
+
+    ObjCMethodList *Mem = SemaObj->BumpAlloc.Allocate<ObjCMethodList>();
+    Prev->Next = new (Mem) ObjCMethodList(Method, 0);
+    Prev = Prev->Next;
   }
 
-  ++NumMethodPoolSelectorsRead;
-  return *Pos;
+  return Result;
+}
+
+void PCHReader::ReadAllIdentifiersAndSelectors(
+                                     llvm::SmallVectorImpl<Selector> &Sels) {
+  // Decoding an identifier looks it up in the identifier table, which loads
+  // the declarations and macro definitions attached to it.
+  for (unsigned ID = 1, N = IdentifiersLoaded.size(); ID <= N; ++ID)
+    DecodeIdentifierInfo(ID);
+
+  for (unsigned ID = 1; ID <= TotalNumSelectors; ++ID)
+    Sels.push_back(DecodeSelector(ID));
 }
 
 void PCHReader::SetIdentifierInfo(unsigned ID, IdentifierInfo *II) {
@@ -2629,6 +2846,22 @@ void PCHReader::ReadSLocEntry(unsigned ID) {
   ReadSLocEntryRecord(ID);
 }
 
+bool PCHReader::ReadLineOffsets(const FileEntry *File,
+                                std::vector<unsigned> &Offsets) {
+  llvm::DenseMap<const FileEntry *, std::pair<const char *, unsigned> >
+    ::iterator Pos = FileLineOffsets.find(File);
+  if (Pos == FileLineOffsets.end())
+    return false;
+
+  using namespace clang::io;
+  const unsigned char *Data = (const unsigned char *)Pos->second.first;
+  unsigned NumLines = Pos->second.second / 4;
+  Offsets.reserve(NumLines);
+  for (unsigned I = 0; I != NumLines; ++I)
+    Offsets.push_back(ReadUnalignedLE32(Data));
+  return true;
+}
+
 Selector PCHReader::DecodeSelector(unsigned ID) {
   if (ID == 0)
     return Selector();
@@ -749,6 +749,16 @@ Decl *PCHReader::ReadDeclRecord(uint64_t Offset, unsigned Index) {
   LoadedDecl(Index, D);
   Reader.Visit(D);
 
+  // Remember where the layout of a record is stored, if it is.
+  if (RecordDecl *RD = dyn_cast<RecordDecl>(D)) {
+    llvm::DenseMap<pch::DeclID, unsigned>::iterator Pos
+      = RecordLayoutOffsets.find(Index + 1);
+    if (Pos != RecordLayoutOffsets.end()) {
+      LoadedRecordLayouts[RD] = Pos->second;
+      RecordLayoutOffsets.erase(Pos);
+    }
+  }
+
   // If this declaration is also a declaration context, get the
   // offsets for its tables of lexical and visible declarations.
   if (DeclContext *DC = dyn_cast<DeclContext>(D)) {
@@ -18,6 +18,7 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclContextInternals.h"
 #include "clang/AST/Expr.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLocVisitor.h"
 #include "clang/Lex/MacroInfo.h"
@@ -31,11 +32,14 @@
 #include "clang/Basic/Version.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/System/Path.h"
+#include <algorithm>
 #include <cstdio>
+#include <vector>
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -436,7 +440,11 @@ static void EmitBlockID(unsigned ID, const char *Name,
 
 static void EmitRecordID(unsigned ID, const char *Name,
                          llvm::BitstreamWriter &Stream,
-                         PCHWriter::RecordData &Record) {
+                         PCHWriter::RecordData &Record,
+                         PCHRecordStats *Stats = 0) {
+  if (Stats)
+    Stats->setName(ID, Name);
+
   Record.clear();
   Record.push_back(ID);
   while (*Name)
@@ -445,8 +453,9 @@ static void EmitRecordID(unsigned ID, const char *Name,
 }
 
 static void AddStmtsExprs(llvm::BitstreamWriter &Stream,
-                          PCHWriter::RecordData &Record) {
-#define RECORD(X) EmitRecordID(pch::X, #X, Stream, Record)
+                          PCHWriter::RecordData &Record,
+                          PCHRecordStats &Stats) {
+#define RECORD(X) EmitRecordID(pch::X, #X, Stream, Record, &Stats)
   RECORD(STMT_STOP);
   RECORD(STMT_NULL_PTR);
   RECORD(STMT_NULL);
@@ -552,10 +561,12 @@ void PCHWriter::WriteBlockInfoBlock() {
   RECORD(PP_COUNTER_VALUE);
   RECORD(SOURCE_LOCATION_OFFSETS);
   RECORD(SOURCE_LOCATION_PRELOADS);
+  RECORD(SOURCE_LOCATION_ENTRY_STARTS);
   RECORD(STAT_CACHE);
   RECORD(EXT_VECTOR_DECLS);
   RECORD(COMMENT_RANGES);
   RECORD(VERSION_CONTROL_BRANCH_REVISION);
+  RECORD(RECORD_LAYOUTS);
   
   // SourceManager Block.
   BLOCK(SOURCE_MANAGER_BLOCK);
@@ -565,6 +576,7 @@ void PCHWriter::WriteBlockInfoBlock() {
   RECORD(SM_SLOC_INSTANTIATION_ENTRY);
   RECORD(SM_LINE_TABLE);
   RECORD(SM_HEADER_FILE_INFO);
+  RECORD(SM_SLOC_FILE_LINES);
 
   // Preprocessor Block.
   BLOCK(PREPROCESSOR_BLOCK);
@@ -572,7 +584,10 @@ void PCHWriter::WriteBlockInfoBlock() {
   RECORD(PP_MACRO_FUNCTION_LIKE);
   RECORD(PP_TOKEN);
 
-  // Decls and Types block.
+  // Decls and Types block; its records are named in the record statistics
+  // as well.
+#undef RECORD
+#define RECORD(X) EmitRecordID(pch::X, #X, Stream, Record, &RecordStats)
   BLOCK(DECLTYPES_BLOCK);
   RECORD(TYPE_EXT_QUAL);
   RECORD(TYPE_COMPLEX);
@@ -624,7 +639,7 @@ void PCHWriter::WriteBlockInfoBlock() {
   RECORD(DECL_CONTEXT_LEXICAL);
   RECORD(DECL_CONTEXT_VISIBLE);
   // Statements and Exprs can occur in the Decls and Types block.
-  AddStmtsExprs(Stream, Record);
+  AddStmtsExprs(Stream, Record, RecordStats);
 #undef RECORD
 #undef BLOCK
   Stream.ExitBlock();
@@ -916,10 +931,22 @@ static unsigned CreateSLocFileAbbrev(llvm::BitstreamWriter &Stream) {
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Include location
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 2)); // Characteristic
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1)); // Line directives
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // Size
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // Modification time
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // Content hash
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // File name
   return Stream.EmitAbbrev(Abbrev);
 }
 
+/// \brief Create an abbreviation for the lines of a file.
+static unsigned CreateSLocFileLinesAbbrev(llvm::BitstreamWriter &Stream) {
+  using namespace llvm;
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(pch::SM_SLOC_FILE_LINES));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Line offsets
+  return Stream.EmitAbbrev(Abbrev);
+}
+
 /// \brief Create an abbreviation for the SLocEntry that refers to a
 /// buffer.
 static unsigned CreateSLocBufferAbbrev(llvm::BitstreamWriter &Stream) {
@@ -976,6 +1003,7 @@ void PCHWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
 
   // Abbreviations for the various kinds of source-location entries.
   unsigned SLocFileAbbrv = CreateSLocFileAbbrev(Stream);
+  unsigned SLocFileLinesAbbrv = CreateSLocFileLinesAbbrev(Stream);
   unsigned SLocBufferAbbrv = CreateSLocBufferAbbrev(Stream);
   unsigned SLocBufferBlobAbbrv = CreateSLocBufferBlobAbbrev(Stream);
   unsigned SLocInstantiationAbbrv = CreateSLocInstantiationAbbrev(Stream);
@@ -1034,14 +1062,18 @@ void PCHWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
   // Write out the source location entry table. We skip the first
   // entry, which is always the same dummy entry.
   std::vector<uint32_t> SLocEntryOffsets;
+  std::vector<uint32_t> SLocEntryStarts;
   RecordData PreloadSLocs;
+  llvm::SmallPtrSet<const SrcMgr::ContentCache *, 16> FilesWithLines;
   SLocEntryOffsets.reserve(SourceMgr.sloc_entry_size() - 1);
+  SLocEntryStarts.reserve(SourceMgr.sloc_entry_size() - 1);
   for (unsigned I = 1, N = SourceMgr.sloc_entry_size(); I != N; ++I) {
     // Get this source location entry.
     const SrcMgr::SLocEntry *SLoc = &SourceMgr.getSLocEntry(I);
     
     // Record the offset of this source-location entry.
     SLocEntryOffsets.push_back(Stream.GetCurrentBitNo());
+    SLocEntryStarts.push_back(SLoc->getOffset());
 
     // Figure out which record code to use.
     unsigned Code;
@@ -1079,8 +1111,36 @@ void PCHWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
         }
 
         Filename = adjustFilenameForRelocatablePCH(Filename, isysroot);
+
+        // Record what the reader validates the file against.
+        Record.push_back(Content->Entry->getSize());
+        Record.push_back(Content->Entry->getModificationTime());
+        uint64_t Hash = 0;
+        if (HashInputFiles) {
+          const llvm::MemoryBuffer *Buffer = Content->getBuffer();
+          Hash = pch::HashBytes(Buffer->getBufferStart(),
+                                Buffer->getBufferEnd());
+        }
+        Record.push_back(Hash);
         Stream.EmitRecordWithBlob(SLocFileAbbrv, Record, Filename);
 
+        // Store the lines of the file, so that a translation unit using the
+        // PCH file can report locations in it without reading and scanning
+        // it.  Contents that were overridden may not match the file on disk.
+        if (!Content->isBufferOverridden() && FilesWithLines.insert(Content)) {
+          unsigned NumLines;
+          const unsigned *Lines = SourceMgr.getLineOffsets(Content, NumLines);
+          std::string LineData;
+          llvm::raw_string_ostream Out(LineData);
+          for (unsigned L = 0; L != NumLines; ++L)
+            clang::io::Emit32(Out, Lines[L]);
+          Out.flush();
+
+          Record.clear();
+          Record.push_back(pch::SM_SLOC_FILE_LINES);
+          Stream.EmitRecordWithBlob(SLocFileLinesAbbrv, Record, LineData);
+        }
+
         // FIXME: For now, preload all file source locations, so that
         // we get the appropriate File entries in the reader. This is
         // a temporary measure.
@@ -1144,6 +1204,21 @@ void PCHWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
                             (const char *)&SLocEntryOffsets.front(),
                            SLocEntryOffsets.size()*sizeof(SLocEntryOffsets[0]));
 
+  // Write the table of the source location offsets at which the entries
+  // start, which is searched without loading the entries.
+  Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(pch::SOURCE_LOCATION_ENTRY_STARTS));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // # of slocs
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // starts
+  unsigned SLocStartsAbbrev = Stream.EmitAbbrev(Abbrev);
+
+  Record.clear();
+  Record.push_back(pch::SOURCE_LOCATION_ENTRY_STARTS);
+  Record.push_back(SLocEntryStarts.size());
+  Stream.EmitRecordWithBlob(SLocStartsAbbrev, Record,
+                            (const char *)&SLocEntryStarts.front(),
+                            SLocEntryStarts.size()*sizeof(SLocEntryStarts[0]));
+
   // Write the source location entry preloads array, telling the PCH
   // reader which source locations entries it should load eagerly.
   Stream.EmitRecord(pch::SOURCE_LOCATION_PRELOADS, PreloadSLocs);
@@ -1302,7 +1377,7 @@ void PCHWriter::WriteType(QualType T) {
   }
 
   // Emit the serialized record.
-  Stream.EmitRecord(W.Code, Record);
+  EmitDeclTypesRecord(W.Code, Record);
 
   // Flush any expressions that were written as part of this type.
   FlushStmts();
@@ -1329,7 +1404,7 @@ uint64_t PCHWriter::WriteDeclContextLexicalBlock(ASTContext &Context,
     AddDeclRef(*D, Record);
 
   ++NumLexicalDeclContexts;
-  Stream.EmitRecord(pch::DECL_CONTEXT_LEXICAL, Record);
+  EmitDeclTypesRecord(pch::DECL_CONTEXT_LEXICAL, Record);
   return Offset;
 }
 
@@ -1376,11 +1451,88 @@ uint64_t PCHWriter::WriteDeclContextVisibleBlock(ASTContext &Context,
   if (Record.size() == 0)
     return 0;
 
-  Stream.EmitRecord(pch::DECL_CONTEXT_VISIBLE, Record);
+  EmitDeclTypesRecord(pch::DECL_CONTEXT_VISIBLE, Record);
   ++NumVisibleDeclContexts;
   return Offset;
 }
 
+/// \brief Append the reference to \p D to \p Record, returning false if
+/// \p D has not been written to the PCH file.
+static bool AddWrittenDeclRef(const llvm::DenseMap<const Decl *,
+                                                   pch::DeclID> &DeclIDs,
+                              const Decl *D, PCHWriter::RecordData &Record) {
+  if (!D) {
+    Record.push_back(0);
+    return true;
+  }
+
+  llvm::DenseMap<const Decl *, pch::DeclID>::const_iterator Pos
+    = DeclIDs.find(D);
+  if (Pos == DeclIDs.end())
+    return false;
+  Record.push_back(Pos->second);
+  return true;
+}
+
+/// \brief Write the layouts of the records that have been laid out, so that
+/// the translation units using the PCH file need not lay them out again.
+///
+/// This must be called once all declarations have been written, since only
+/// the layouts of written records, whose bases have been written as well,
+/// can be stored.
+void PCHWriter::WriteRecordLayouts(ASTContext &Context) {
+  // Write the layouts in declaration ID order, so that the PCH file does not
+  // depend on the addresses of the records.
+  std::vector<std::pair<pch::DeclID, const ASTRecordLayout *> > Records;
+  for (ASTContext::record_layout_iterator I = Context.record_layouts_begin(),
+         E = Context.record_layouts_end(); I != E; ++I) {
+    llvm::DenseMap<const Decl *, pch::DeclID>::iterator Pos
+      = DeclIDs.find(I->first);
+    if (I->second && Pos != DeclIDs.end())
+      Records.push_back(std::make_pair(Pos->second, I->second));
+  }
+  std::sort(Records.begin(), Records.end());
+
+  RecordData Record, Layout;
+  for (unsigned I = 0, N = Records.size(); I != N; ++I) {
+    const ASTRecordLayout &L = *Records[I].second;
+    Layout.clear();
+    Layout.push_back(L.Size);
+    Layout.push_back(L.DataSize);
+    Layout.push_back(L.Alignment);
+    Layout.push_back(L.FieldCount);
+    Layout.append(L.FieldOffsets, L.FieldOffsets + L.FieldCount);
+    Layout.push_back(L.CXXInfo != 0);
+    if (const ASTRecordLayout::CXXRecordLayoutInfo *Info = L.CXXInfo) {
+      Layout.push_back(Info->NonVirtualSize);
+      Layout.push_back(Info->NonVirtualAlign);
+      bool Complete = AddWrittenDeclRef(DeclIDs, Info->PrimaryBase.getBase(),
+                                        Layout);
+      Layout.push_back(Info->PrimaryBase.isVirtual());
+
+      typedef llvm::DenseMap<const CXXRecordDecl *, uint64_t> OffsetMap;
+      const OffsetMap *Maps[2] = { &Info->BaseOffsets, &Info->VBaseOffsets };
+      for (unsigned M = 0; M != 2; ++M) {
+        Layout.push_back(Maps[M]->size());
+        for (OffsetMap::const_iterator B = Maps[M]->begin(),
+               BEnd = Maps[M]->end(); B != BEnd; ++B) {
+          Complete = AddWrittenDeclRef(DeclIDs, B->first, Layout) && Complete;
+          Layout.push_back(B->second);
+        }
+      }
+      if (!Complete)
+        continue;
+    }
+
+    Record.push_back(Records[I].first);
+    Record.push_back(Layout.size());
+    Record.append(Layout.begin(), Layout.end());
+  }
+
+  if (!Record.empty())
+    Stream.EmitRecord(pch::RECORD_LAYOUTS, Record);
+}
+
 //===----------------------------------------------------------------------===//
 // Global Method Pool and Selector Serialization
 //===----------------------------------------------------------------------===//
@@ -1614,8 +1766,9 @@ public:
   PCHIdentifierTableTrait(PCHWriter &Writer, Preprocessor &PP)
     : Writer(Writer), PP(PP) { }
 
-  static unsigned ComputeHash(const IdentifierInfo* II) {
-    return llvm::HashString(II->getName());
+  static uint64_t ComputeHash(const IdentifierInfo* II) {
+    return pch::HashBytes(II->getNameStart(),
+                          II->getNameStart() + II->getLength());
   }
 
   std::pair<unsigned,unsigned>
@@ -1698,7 +1851,7 @@ void PCHWriter::WriteIdentifierTable(Preprocessor &PP) {
   // Create and write out the blob that contains the identifier
   // strings.
   {
-    OnDiskChainedHashTableGenerator<PCHIdentifierTableTrait> Generator;
+    OnDiskPerfectHashTableGenerator<PCHIdentifierTableTrait> Generator;
 
     // Look for any identifiers that were named while processing the
     // headers, but are otherwise not needed. We add these to the hash
@@ -1721,13 +1874,13 @@ void PCHWriter::WriteIdentifierTable(Preprocessor &PP) {
 
     // Create the on-disk hash table in a buffer.
     llvm::SmallString<4096> IdentifierTable;
-    uint32_t BucketOffset;
+    uint32_t TableOffset;
     {
       PCHIdentifierTableTrait Trait(*this, PP);
       llvm::raw_svector_ostream Out(IdentifierTable);
-      // Make sure that no bucket is at offset 0
+      // Make sure that no slot is at offset 0
       clang::io::Emit32(Out, 0);
-      BucketOffset = Generator.Emit(Out, Trait);
+      TableOffset = Generator.Emit(Out, Trait);
     }
 
     // Create a blob abbreviation
@@ -1740,7 +1893,7 @@ void PCHWriter::WriteIdentifierTable(Preprocessor &PP) {
     // Write the identifier table
     RecordData Record;
     Record.push_back(pch::IDENTIFIER_TABLE);
-    Record.push_back(BucketOffset);
+    Record.push_back(TableOffset);
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable.str());
   }
 
@@ -1921,7 +2074,7 @@ void PCHWriter::WriteAttributeRecord(const Attr *Attr) {
     }
   }
 
-  Stream.EmitRecord(pch::DECL_ATTR, Record);
+  EmitDeclTypesRecord(pch::DECL_ATTR, Record);
 }
 
 void PCHWriter::AddString(const std::string &Str, RecordData &Record) {
@@ -1943,10 +2096,48 @@ void PCHWriter::SetSelectorOffset(Selector Sel, uint32_t Offset) {
   SelectorOffsets[ID - 1] = Offset;
 }
 
-PCHWriter::PCHWriter(llvm::BitstreamWriter &Stream)
-  : Stream(Stream), NextTypeID(pch::NUM_PREDEF_TYPE_IDS),
+void PCHWriter::EmitDeclTypesRecord(unsigned Code, RecordData &Record,
+                                    unsigned Abbrev) {
+  uint64_t StartBit = Stream.GetCurrentBitNo();
+  Stream.EmitRecord(Code, Record, Abbrev);
+  RecordStats.noteRecord(Code, Stream.GetCurrentBitNo() - StartBit,
+                         Abbrev != 0);
+}
+
+void PCHRecordStats::print() const {
+  std::vector<std::pair<uint64_t, unsigned> > BySize;
+  unsigned NumRecords = 0, NumAbbreviated = 0;
+  uint64_t NumBits = 0;
+  for (std::map<unsigned, CodeStats>::const_iterator I = Codes.begin(),
+         E = Codes.end(); I != E; ++I) {
+    if (!I->second.NumRecords)
+      continue;
+    BySize.push_back(std::make_pair(I->second.NumBits, I->first));
+    NumRecords += I->second.NumRecords;
+    NumAbbreviated += I->second.NumAbbreviated;
+    NumBits += I->second.NumBits;
+  }
+  std::sort(BySize.begin(), BySize.end());
+
+  std::fprintf(stderr, "*** PCH Record Stats:\n");
+  std::fprintf(stderr, "  %u/%u declarations and types block records "
+               "abbreviated, %llu bytes\n", NumAbbreviated, NumRecords,
+               (unsigned long long)(NumBits + 7) / 8);
+  for (unsigned I = BySize.size(); I != 0; --I) {
+    const CodeStats &Stats = Codes.find(BySize[I - 1].second)->second;
+    std::fprintf(stderr, "  %-34s %7u records, %9llu bytes, "
+                 "%7u abbreviated\n", Stats.Name ? Stats.Name : "<unnamed>",
+                 Stats.NumRecords, (unsigned long long)(Stats.NumBits + 7) / 8,
+                 Stats.NumAbbreviated);
+  }
+}
+
+PCHWriter::PCHWriter(llvm::BitstreamWriter &Stream, bool HashInputFiles)
+  : Stream(Stream), HashInputFiles(HashInputFiles),
+    NextTypeID(pch::NUM_PREDEF_TYPE_IDS),
     NumStatements(0), NumMacros(0), NumLexicalDeclContexts(0),
-    NumVisibleDeclContexts(0) { }
+    NumVisibleDeclContexts(0), NumFunctionBodies(0), ParmVarDeclAbbrev(0),
+    DeclRefExprAbbrev(0), ImplicitCastExprAbbrev(0) { }
 
 void PCHWriter::WritePCH(Sema &SemaRef, MemorizeStatCalls *StatCalls,
                          const char *isysroot) {
@@ -1955,6 +2146,22 @@ void PCHWriter::WritePCH(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   ASTContext &Context = SemaRef.Context;
   Preprocessor &PP = SemaRef.PP;
 
+  // When this PCH file is built on top of another one, load everything that
+  // the latter provides lazily, so that the new PCH file is complete.
+  if (ExternalSemaSource *Source = SemaRef.ExternalSource) {
+    llvm::SmallVector<Selector, 64> Sels;
+    Source->ReadAllIdentifiersAndSelectors(Sels);
+    for (unsigned I = 0, N = Sels.size(); I != N; ++I) {
+      if (SemaRef.InstanceMethodPool.find(Sels[I])
+            == SemaRef.InstanceMethodPool.end())
+        SemaRef.ReadMethodPool(Sels[I], /*isInstance=*/true);
+      if (SemaRef.FactoryMethodPool.find(Sels[I])
+            == SemaRef.FactoryMethodPool.end())
+        SemaRef.ReadMethodPool(Sels[I], /*isInstance=*/false);
+    }
+    Context.ReadExternalComments();
+  }
+
   // Emit the file header.
   Stream.Emit((unsigned)'C', 8);
   Stream.Emit((unsigned)'P', 8);
@@ -2105,12 +2312,15 @@ void PCHWriter::WritePCH(Sema &SemaRef, MemorizeStatCalls *StatCalls,
   if (!ExtVectorDecls.empty())
     Stream.EmitRecord(pch::EXT_VECTOR_DECLS, ExtVectorDecls);
 
+  WriteRecordLayouts(Context);
+
   // Some simple statistics
   Record.clear();
   Record.push_back(NumStatements);
   Record.push_back(NumMacros);
   Record.push_back(NumLexicalDeclContexts);
   Record.push_back(NumVisibleDeclContexts);
+  Record.push_back(NumFunctionBodies);
   Stream.EmitRecord(pch::STATISTICS, Record);
   Stream.ExitBlock();
 }
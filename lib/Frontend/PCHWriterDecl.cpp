@@ -391,16 +391,15 @@ void PCHDeclWriter::VisitParmVarDecl(ParmVarDecl *D) {
 
   // If the assumptions about the DECL_PARM_VAR abbrev are true, use it.  Here
   // we dynamically check for the properties that we optimize for, but don't
-  // know are true of all PARM_VAR_DECLs.
-  if (!D->getTypeSourceInfo() &&
-      !D->hasAttrs() &&
+  // know are true of all PARM_VAR_DECLs.  The fields that follow the type,
+  // starting with the type source info, are written as an array, so they
+  // need not be checked.
+  if (!D->hasAttrs() &&
       !D->isImplicit() &&
       !D->isUsed() &&
       D->getAccess() == AS_none &&
       D->getPCHLevel() == 0 &&
-      D->getStorageClass() == 0 &&
-      !D->hasCXXDirectInitializer() && // Can params have this ever?
-      D->getObjCDeclQualifier() == 0)
+      D->getDeclName().getNameKind() == DeclarationName::Identifier)
     AbbrevToUse = Writer.getParmVarDeclAbbrev();
 
   // Check things we know are true of *every* PARM_VAR_DECL, which is more than
@@ -473,19 +472,37 @@ void PCHWriter::WriteDeclsBlockAbbrevs() {
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Name
   // ValueDecl
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Type
-  // DeclaratorDecl
-  Abv->Add(BitCodeAbbrevOp(pch::PREDEF_TYPE_NULL_ID)); // InfoType
-  // VarDecl
-  Abv->Add(BitCodeAbbrevOp(0));                       // StorageClass
-  Abv->Add(BitCodeAbbrevOp(0));                       // isThreadSpecified
-  Abv->Add(BitCodeAbbrevOp(0));                       // hasCXXDirectInitializer
-  Abv->Add(BitCodeAbbrevOp(0));                       // isDeclaredInCondition
-  Abv->Add(BitCodeAbbrevOp(0));                       // PrevDecl
-  Abv->Add(BitCodeAbbrevOp(0));                       // HasInit
-  // ParmVarDecl
-  Abv->Add(BitCodeAbbrevOp(0));                       // ObjCDeclQualifier
+  // DeclaratorDecl, VarDecl and ParmVarDecl: the type source info, whose
+  // length varies, and the fields that follow it.
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
 
   ParmVarDeclAbbrev = Stream.EmitAbbrev(Abv);
+
+  // Abbreviation for EXPR_DECL_REF.
+  Abv = new BitCodeAbbrev();
+  Abv->Add(BitCodeAbbrevOp(pch::EXPR_DECL_REF));
+  // Expr
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Type
+  Abv->Add(BitCodeAbbrevOp(0));                       // isTypeDependent
+  Abv->Add(BitCodeAbbrevOp(0));                       // isValueDependent
+  // DeclRefExpr
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Decl
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Location
+  DeclRefExprAbbrev = Stream.EmitAbbrev(Abv);
+
+  // Abbreviation for EXPR_IMPLICIT_CAST.
+  Abv = new BitCodeAbbrev();
+  Abv->Add(BitCodeAbbrevOp(pch::EXPR_IMPLICIT_CAST));
+  // Expr
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Type
+  Abv->Add(BitCodeAbbrevOp(0));                       // isTypeDependent
+  Abv->Add(BitCodeAbbrevOp(0));                       // isValueDependent
+  // CastExpr
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // CastKind
+  // ImplicitCastExpr
+  Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1)); // isLvalueCast
+  ImplicitCastExprAbbrev = Stream.EmitAbbrev(Abv);
 }
 
 /// isRequiredDecl - Check if this is a "required" Decl, which must be seen by
@@ -593,7 +610,7 @@ void PCHWriter::WriteDecl(ASTContext &Context, Decl *D) {
   if (!W.Code)
     llvm::llvm_report_error(llvm::StringRef("unexpected declaration kind '") +
                             D->getDeclKindName() + "'");
-  Stream.EmitRecord(W.Code, Record, W.AbbrevToUse);
+  EmitDeclTypesRecord(W.Code, Record, W.AbbrevToUse);
 
   // If the declaration had any attributes, write them now.
   if (D->hasAttrs())
@@ -602,6 +619,11 @@ void PCHWriter::WriteDecl(ASTContext &Context, Decl *D) {
   // Flush any expressions that were written as part of this declaration.
   FlushStmts();
 
+  // The bodies of functions are the statements that are read lazily.
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+    if (FD->isThisDeclarationADefinition())
+      ++NumFunctionBodies;
+
   // Note "external" declarations so that we can add them to a record in the
   // PCH file later.
   //
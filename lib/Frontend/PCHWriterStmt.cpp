@@ -29,6 +29,7 @@ namespace {
 
   public:
     pch::StmtCode Code;
+    unsigned AbbrevToUse;
 
     PCHStmtWriter(PCHWriter &Writer, PCHWriter::RecordData &Record)
       : Writer(Writer), Record(Record) { }
@@ -330,6 +331,9 @@ void PCHStmtWriter::VisitDeclRefExpr(DeclRefExpr *E) {
   // FIXME: write qualifier
   // FIXME: write explicit template arguments
   Code = pch::EXPR_DECL_REF;
+
+  if (!E->isTypeDependent() && !E->isValueDependent())
+    AbbrevToUse = Writer.getDeclRefExprAbbrev();
 }
 
 void PCHStmtWriter::VisitIntegerLiteral(IntegerLiteral *E) {
@@ -481,6 +485,9 @@ void PCHStmtWriter::VisitImplicitCastExpr(ImplicitCastExpr *E) {
   VisitCastExpr(E);
   Record.push_back(E->isLvalueCast());
   Code = pch::EXPR_IMPLICIT_CAST;
+
+  if (!E->isTypeDependent() && !E->isValueDependent())
+    AbbrevToUse = Writer.getImplicitCastExprAbbrev();
 }
 
 void PCHStmtWriter::VisitExplicitCastExpr(ExplicitCastExpr *E) {
@@ -887,15 +894,16 @@ void PCHWriter::WriteSubStmt(Stmt *S) {
   ++NumStatements;
 
   if (!S) {
-    Stream.EmitRecord(pch::STMT_NULL_PTR, Record);
+    EmitDeclTypesRecord(pch::STMT_NULL_PTR, Record);
     return;
   }
 
   Writer.Code = pch::STMT_NULL_PTR;
+  Writer.AbbrevToUse = 0;
   Writer.Visit(S);
   assert(Writer.Code != pch::STMT_NULL_PTR &&
          "Unhandled expression writing PCH file");
-  Stream.EmitRecord(Writer.Code, Record);
+  EmitDeclTypesRecord(Writer.Code, Record, Writer.AbbrevToUse);
 }
 
 /// \brief Flush all of the statements that have been added to the
@@ -909,15 +917,16 @@ void PCHWriter::FlushStmts() {
     Stmt *S = StmtsToEmit[I];
 
     if (!S) {
-      Stream.EmitRecord(pch::STMT_NULL_PTR, Record);
+      EmitDeclTypesRecord(pch::STMT_NULL_PTR, Record);
       continue;
     }
 
     Writer.Code = pch::STMT_NULL_PTR;
+    Writer.AbbrevToUse = 0;
     Writer.Visit(S);
     assert(Writer.Code != pch::STMT_NULL_PTR &&
            "Unhandled expression writing PCH file");
-    Stream.EmitRecord(Writer.Code, Record);
+    EmitDeclTypesRecord(Writer.Code, Record, Writer.AbbrevToUse);
 
     assert(N == StmtsToEmit.size() &&
            "Substatement writen via AddStmt rather than WriteSubStmt!");
@@ -926,7 +935,7 @@ void PCHWriter::FlushStmts() {
     // expression records that follow this one are part of a different
     // expression.
     Record.clear();
-    Stream.EmitRecord(pch::STMT_STOP, Record);
+    EmitDeclTypesRecord(pch::STMT_STOP, Record);
   }
 
   StmtsToEmit.clear();
@@ -14,6 +14,7 @@
 
 #include "clang/Frontend/Utils.h"
 #include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/PreprocessorOutputOptions.h"
 #include "clang/Lex/MacroInfo.h"
@@ -96,6 +97,17 @@ private:
   bool DisableLineMarkers;
   bool DumpDefines;
   bool UseLineDirective;
+
+  /// SpanStart, SpanEnd - The source text of the tokens that are copied
+  /// straight from their buffer and have not been written out yet.
+  /// SpanEndLoc is the location just past that text.
+  const char *SpanStart, *SpanEnd;
+  SourceLocation SpanEndLoc;
+
+  bool isCopyableToken(const Token &Tok) const {
+    return Tok.getLocation().isFileID() && !Tok.needsCleaning() &&
+           Tok.isNot(tok::comment) && Tok.isNot(tok::eof);
+  }
 public:
   PrintPPOutputPPCallbacks(Preprocessor &pp, llvm::raw_ostream &os,
                            bool lineMarkers, bool defines)
@@ -107,12 +119,24 @@ public:
     EmittedMacroOnThisLine = false;
     FileType = SrcMgr::C_User;
     Initialized = false;
+    SpanStart = SpanEnd = 0;
          
     // If we're in microsoft mode, use normal #line instead of line markers.
     UseLineDirective = PP.getLangOptions().Microsoft;
   }
 
   void SetEmittedTokensOnThisLine() { EmittedTokensOnThisLine = true; }
+
+  /// FlushSourceSpan - Write out the source text collected by StartSourceSpan
+  /// and ExtendSourceSpan.  Everything that writes to OS does this first.
+  void FlushSourceSpan() {
+    if (SpanStart != SpanEnd)
+      OS.write(SpanStart, SpanEnd - SpanStart);
+    SpanStart = SpanEnd = 0;
+  }
+
+  bool StartSourceSpan(const Token &Tok);
+  bool ExtendSourceSpan(const Token &Tok);
   bool hasEmittedTokensOnThisLine() const { return EmittedTokensOnThisLine; }
 
   virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
@@ -137,9 +161,48 @@ public:
 };
 }  // end anonymous namespace
 
+/// StartSourceSpan - If the text of \arg Tok can be copied straight from its
+/// buffer, start a new span of source text with it and return true.
+bool PrintPPOutputPPCallbacks::StartSourceSpan(const Token &Tok) {
+  FlushSourceSpan();
+  if (!isCopyableToken(Tok))
+    return false;
+
+  SpanStart = PP.getSourceManager().getCharacterData(Tok.getLocation());
+  SpanEnd = SpanStart + Tok.getLength();
+  SpanEndLoc = Tok.getLocation().getFileLocWithOffset(Tok.getLength());
+  return true;
+}
+
+/// ExtendSourceSpan - If \arg Tok directly follows the current span in the
+/// same buffer, with nothing or a single space in between, add it and the
+/// space to the span and return true.  Tokens that were adjacent in the
+/// source lex the same way when they are read back, so this does not have to
+/// check whether they would concatenate.
+bool PrintPPOutputPPCallbacks::ExtendSourceSpan(const Token &Tok) {
+  if (SpanStart == SpanEnd || !isCopyableToken(Tok))
+    return false;
+
+  if (Tok.getLocation() == SpanEndLoc) {
+    if (Tok.hasLeadingSpace())
+      return false;
+  } else if (Tok.getLocation() == SpanEndLoc.getFileLocWithOffset(1)) {
+    if (!Tok.hasLeadingSpace() || *SpanEnd != ' ')
+      return false;
+    ++SpanEnd;
+  } else {
+    return false;
+  }
+
+  SpanEnd += Tok.getLength();
+  SpanEndLoc = Tok.getLocation().getFileLocWithOffset(Tok.getLength());
+  return true;
+}
+
 void PrintPPOutputPPCallbacks::WriteLineInfo(unsigned LineNo,
                                              const char *Extra,
                                              unsigned ExtraLen) {
+  FlushSourceSpan();
   if (EmittedTokensOnThisLine || EmittedMacroOnThisLine) {
     OS << '\n';
     EmittedTokensOnThisLine = false;
@@ -172,6 +235,7 @@ void PrintPPOutputPPCallbacks::WriteLineInfo(unsigned LineNo,
 /// #line directive.  This returns false if already at the specified line, true
 /// if some newlines were emitted.
 bool PrintPPOutputPPCallbacks::MoveToLine(SourceLocation Loc) {
+  FlushSourceSpan();
   unsigned LineNo = PP.getSourceManager().getInstantiationLineNumber(Loc);
 
   if (DisableLineMarkers) {
@@ -395,44 +459,43 @@ struct UnknownPragmaHandler : public PragmaHandler {
 static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
                                     PrintPPOutputPPCallbacks *Callbacks,
                                     llvm::raw_ostream &OS) {
-  char Buffer[256];
   Token PrevTok;
   while (1) {
+    bool Copied = false;
 
     // If this token is at the start of a line, emit newlines if needed.
     if (Tok.isAtStartOfLine() && Callbacks->HandleFirstTokOnLine(Tok)) {
       // done.
+    } else if (Callbacks->ExtendSourceSpan(Tok)) {
+      // Copied along with the tokens before it on this line.
+      Copied = true;
     } else if (Tok.hasLeadingSpace() ||
                // If we haven't emitted a token on this line yet, PrevTok isn't
                // useful to look at and no concatenation could happen anyway.
                (Callbacks->hasEmittedTokensOnThisLine() &&
                 // Don't print "-" next to "-", it would form "--".
                 Callbacks->AvoidConcat(PrevTok, Tok))) {
+      Callbacks->FlushSourceSpan();
       OS << ' ';
     }
 
-    if (IdentifierInfo *II = Tok.getIdentifierInfo()) {
+    // Tokens read straight from a file are collected into spans of source
+    // text, which are written out with a single write each.
+    if (Copied || Callbacks->StartSourceSpan(Tok)) {
+      // Nothing to print yet.
+    } else if (IdentifierInfo *II = Tok.getIdentifierInfo()) {
       OS << II->getName();
     } else if (Tok.isLiteral() && !Tok.needsCleaning() &&
                Tok.getLiteralData()) {
       OS.write(Tok.getLiteralData(), Tok.getLength());
-    } else if (Tok.getLength() < 256) {
-      const char *TokPtr = Buffer;
-      unsigned Len = PP.getSpelling(Tok, TokPtr);
-      OS.write(TokPtr, Len);
-
-      // Tokens that can contain embedded newlines need to adjust our current
-      // line number.
-      if (Tok.getKind() == tok::comment)
-        Callbacks->HandleNewlinesInToken(TokPtr, Len);
     } else {
-      std::string S = PP.getSpelling(Tok);
-      OS.write(&S[0], S.size());
+      llvm::StringRef Spelling = PP.getSpellingRef(Tok);
+      OS << Spelling;
 
       // Tokens that can contain embedded newlines need to adjust our current
       // line number.
       if (Tok.getKind() == tok::comment)
-        Callbacks->HandleNewlinesInToken(&S[0], S.size());
+        Callbacks->HandleNewlinesInToken(Spelling.data(), Spelling.size());
     }
     Callbacks->SetEmittedTokensOnThisLine();
 
@@ -441,6 +504,7 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
     PrevTok = Tok;
     PP.Lex(Tok);
   }
+  Callbacks->FlushSourceSpan();
 }
 
 typedef std::pair<IdentifierInfo*, MacroInfo*> id_macro_pair;
@@ -477,6 +541,8 @@ static void DoPrintMacros(Preprocessor &PP, llvm::raw_ostream *OS) {
 ///
 void clang::DoPrintPreprocessedInput(Preprocessor &PP, llvm::raw_ostream *OS,
                                      const PreprocessorOutputOptions &Opts) {
+  PhaseRegion Phase("Preprocess");
+
   // Show macros with no output is handled specially.
   if (!Opts.ShowCPP) {
     assert(Opts.ShowMacros && "Not yet implemented!");
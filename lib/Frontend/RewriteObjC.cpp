@@ -524,6 +524,7 @@ void RewriteObjC::Initialize(ASTContext &context) {
   MainFileEnd = MainBuf->getBufferEnd();
 
   Rewrite.setSourceMgr(Context->getSourceManager(), Context->getLangOptions());
+  Rewrite.setBatchEdits(true);
 
   // declaring objc_selector outside the parameter list removes a silly
   // scope related warning...
@@ -2613,7 +2614,8 @@ Stmt *RewriteObjC::SynthMessageExpr(ObjCMessageExpr *Exp) {
                                             CastExpr::CK_Unknown, SuperRep);
       } else {
         // (struct objc_super) { <exprs from above> }
-        InitListExpr *ILE = new (Context) InitListExpr(SourceLocation(),
+        InitListExpr *ILE = new (Context) InitListExpr(*Context,
+                                             SourceLocation(),
                                              &InitExprs[0], InitExprs.size(),
                                              SourceLocation());
         TypeSourceInfo *superTInfo
@@ -2698,7 +2700,8 @@ Stmt *RewriteObjC::SynthMessageExpr(ObjCMessageExpr *Exp) {
                                  CastExpr::CK_Unknown, SuperRep);
       } else {
         // (struct objc_super) { <exprs from above> }
-        InitListExpr *ILE = new (Context) InitListExpr(SourceLocation(),
+        InitListExpr *ILE = new (Context) InitListExpr(*Context,
+                                             SourceLocation(),
                                              &InitExprs[0], InitExprs.size(),
                                              SourceLocation());
         TypeSourceInfo *superTInfo
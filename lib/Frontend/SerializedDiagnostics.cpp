@@ -0,0 +1,452 @@
+//===--- SerializedDiagnostics.cpp - Binary diagnostic stream -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SerializedDiagnosticPrinter diagnostic client and
+// the reader for the streams it produces.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/SerializedDiagnostics.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace clang;
+using namespace clang::serialized_diags;
+
+//===----------------------------------------------------------------------===//
+// SerializedDiagnosticPrinter Implementation
+//===----------------------------------------------------------------------===//
+
+/// The number of bytes of complete diagnostics collected before they are
+/// written out.
+static const unsigned FlushThreshold = 4096;
+
+SerializedDiagnosticPrinter::SerializedDiagnosticPrinter(llvm::raw_ostream &os,
+                                                         bool Streaming)
+  : OS(os), Streaming(Streaming), Stream(Buffer) {
+  EmitPreamble();
+}
+
+SerializedDiagnosticPrinter::~SerializedDiagnosticPrinter() {
+  FlushBuffer(/*Force=*/true);
+}
+
+/// AddLocationAbbrevOps - Add the operands for a source location to an
+/// abbreviation.
+static void AddLocationAbbrevOps(llvm::BitCodeAbbrev *Abbrev) {
+  using llvm::BitCodeAbbrevOp;
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // File ID
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Line
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // Column
+}
+
+void SerializedDiagnosticPrinter::EmitPreamble() {
+  using llvm::BitCodeAbbrev;
+  using llvm::BitCodeAbbrevOp;
+
+  Stream.Emit((unsigned)'D', 8);
+  Stream.Emit((unsigned)'I', 8);
+  Stream.Emit((unsigned)'A', 8);
+  Stream.Emit((unsigned)'G', 8);
+
+  // The abbreviations for the records of a DIAG block are shared by all of
+  // them, so they live in the block info block.
+  Stream.EnterSubblock(llvm::bitc::BLOCKINFO_BLOCK_ID, 3);
+
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_DIAG));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 3)); // Level
+  AddLocationAbbrevOps(Abbrev);
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Message
+  DiagAbbrev = Stream.EmitBlockInfoAbbrev(DIAG_BLOCK_ID, Abbrev);
+
+  Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_SOURCE_RANGE));
+  AddLocationAbbrevOps(Abbrev);
+  AddLocationAbbrevOps(Abbrev);
+  RangeAbbrev = Stream.EmitBlockInfoAbbrev(DIAG_BLOCK_ID, Abbrev);
+
+  Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_FIXIT));
+  AddLocationAbbrevOps(Abbrev);
+  AddLocationAbbrevOps(Abbrev);
+  AddLocationAbbrevOps(Abbrev);
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Code to insert
+  FixItAbbrev = Stream.EmitBlockInfoAbbrev(DIAG_BLOCK_ID, Abbrev);
+
+  Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_FILENAME));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // File ID
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // File name
+  FileNameAbbrev = Stream.EmitBlockInfoAbbrev(DIAG_BLOCK_ID, Abbrev);
+
+  Stream.ExitBlock();
+
+  RecordData Record;
+  Stream.EnterSubblock(META_BLOCK_ID, 3);
+  Record.push_back(VERSION_MAJOR);
+  Stream.EmitRecord(RECORD_VERSION, Record);
+  Stream.ExitBlock();
+}
+
+/// AddLocation - Add the file, line and column of the instantiation location
+/// of \p Loc to \p Record, naming the file first if it is new to the stream.
+void SerializedDiagnosticPrinter::AddLocation(const SourceManager *SM,
+                                              SourceLocation Loc,
+                                              RecordData &Record) {
+  const FileEntry *File = 0;
+  unsigned Line = 0, Column = 0;
+  if (SM && Loc.isValid()) {
+    std::pair<FileID, unsigned> Decomposed =
+      SM->getDecomposedLoc(SM->getInstantiationLoc(Loc));
+    File = SM->getFileEntryForID(Decomposed.first);
+    if (File) {
+      Line = SM->getLineNumber(Decomposed.first, Decomposed.second);
+      Column = SM->getColumnNumber(Decomposed.first, Decomposed.second);
+    }
+  }
+
+  if (!File) {
+    Record.push_back(0);
+    Record.push_back(0);
+    Record.push_back(0);
+    return;
+  }
+
+  unsigned &ID = FileIDs[File];
+  if (ID == 0) {
+    ID = FileIDs.size();
+    RecordData FileRecord;
+    FileRecord.push_back(RECORD_FILENAME);
+    FileRecord.push_back(ID);
+    Stream.EmitRecordWithBlob(FileNameAbbrev, FileRecord, File->getName());
+  }
+
+  Record.push_back(ID);
+  Record.push_back(Line);
+  Record.push_back(Column);
+}
+
+void SerializedDiagnosticPrinter::HandleDiagnostic(Diagnostic::Level DiagLevel,
+                                                   const DiagnosticInfo &Info) {
+  llvm::SmallString<256> Message;
+  Info.FormatDiagnostic(Message);
+
+  const SourceManager *SM = 0;
+  if (Info.getLocation().isValid())
+    SM = &Info.getLocation().getManager();
+
+  Stream.EnterSubblock(DIAG_BLOCK_ID, 4);
+
+  RecordData Record;
+  if (SM) {
+    // Only ranges and fix-its in plain files serialize well.
+    for (unsigned I = 0, N = Info.getNumRanges(); I != N; ++I) {
+      const SourceRange &R = Info.getRange(I);
+      if (R.getBegin().isMacroID() || R.getEnd().isMacroID())
+        continue;
+
+      Record.clear();
+      Record.push_back(RECORD_SOURCE_RANGE);
+      AddLocation(SM, R.getBegin(), Record);
+      AddLocation(SM, R.getEnd(), Record);
+      Stream.EmitRecordWithAbbrev(RangeAbbrev, Record);
+    }
+
+    // Fix-its only make sense as a whole, so drop all of them if any of them
+    // touches a macro instantiation.
+    bool FixItsInMacros = false;
+    for (unsigned I = 0, N = Info.getNumCodeModificationHints(); I != N; ++I) {
+      const CodeModificationHint &Hint = Info.getCodeModificationHint(I);
+      if ((Hint.RemoveRange.isValid() &&
+           (Hint.RemoveRange.getBegin().isMacroID() ||
+            Hint.RemoveRange.getEnd().isMacroID())) ||
+          (Hint.InsertionLoc.isValid() && Hint.InsertionLoc.isMacroID()))
+        FixItsInMacros = true;
+    }
+
+    for (unsigned I = 0, N = Info.getNumCodeModificationHints();
+         !FixItsInMacros && I != N; ++I) {
+      const CodeModificationHint &Hint = Info.getCodeModificationHint(I);
+      Record.clear();
+      Record.push_back(RECORD_FIXIT);
+      AddLocation(SM, Hint.RemoveRange.getBegin(), Record);
+      AddLocation(SM, Hint.RemoveRange.getEnd(), Record);
+      AddLocation(SM, Hint.InsertionLoc, Record);
+      Stream.EmitRecordWithBlob(FixItAbbrev, Record, Hint.CodeToInsert);
+    }
+  }
+
+  Record.clear();
+  Record.push_back(RECORD_DIAG);
+  Record.push_back(DiagLevel);
+  AddLocation(SM, Info.getLocation(), Record);
+  Stream.EmitRecordWithBlob(DiagAbbrev, Record, Message.str());
+
+  Stream.ExitBlock();
+
+  FlushBuffer(/*Force=*/Streaming);
+}
+
+void SerializedDiagnosticPrinter::EndSourceFile() {
+  FlushBuffer(/*Force=*/true);
+}
+
+/// FlushBuffer - Write the diagnostics collected so far to the output stream,
+/// if there are enough of them or \p Force is set.  This is only called
+/// between blocks, where the bitstream is word-aligned and nothing refers
+/// back into the buffer.
+void SerializedDiagnosticPrinter::FlushBuffer(bool Force) {
+  if (Buffer.empty() || (!Force && Buffer.size() < FlushThreshold))
+    return;
+
+  OS.write((const char *)&Buffer.front(), Buffer.size());
+  OS.flush();
+  Buffer.clear();
+}
+
+//===----------------------------------------------------------------------===//
+// Reader Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// SerializedDiagnosticReader - Turns the records of a serialized diagnostics
+/// stream back into StoredDiagnostics.
+class SerializedDiagnosticReader {
+  FileManager &FM;
+  SourceManager &SM;
+
+  /// Files - The files named in the stream so far, indexed by file ID.  Null
+  /// entries are files that could not be found.
+  std::vector<const FileEntry *> &Files;
+
+  typedef llvm::SmallVector<uint64_t, 32> RecordData;
+
+  SourceLocation ReadLocation(const RecordData &Record, unsigned &Idx);
+  bool ReadDiagBlock(llvm::BitstreamCursor &Stream,
+                     llvm::SmallVectorImpl<StoredDiagnostic> &Diags);
+
+public:
+  SerializedDiagnosticReader(FileManager &FM, SourceManager &SM,
+                             std::vector<const FileEntry *> &Files)
+    : FM(FM), SM(SM), Files(Files) {}
+
+  /// Read - Read the diagnostics of the stream in \p Buffer.  Returns true
+  /// if the stream is malformed or cut short.  If given, \p HeaderEnd
+  /// receives the offset of the first diagnostic if there is one, and
+  /// \p End the offset right after the last complete diagnostic.
+  bool Read(llvm::StringRef Buffer,
+            llvm::SmallVectorImpl<StoredDiagnostic> &Diags,
+            unsigned *HeaderEnd = 0, unsigned *End = 0);
+};
+} // end anonymous namespace
+
+SourceLocation
+SerializedDiagnosticReader::ReadLocation(const RecordData &Record,
+                                         unsigned &Idx) {
+  if (Idx + 3 > Record.size()) {
+    Idx = Record.size();
+    return SourceLocation();
+  }
+
+  unsigned ID = Record[Idx++];
+  unsigned Line = Record[Idx++];
+  unsigned Column = Record[Idx++];
+  if (ID == 0 || ID >= Files.size() || !Files[ID])
+    return SourceLocation();
+
+  const FileEntry *File = Files[ID];
+
+  // Make sure that this file has an entry in the source manager.
+  if (!SM.hasFileInfo(File))
+    SM.createFileID(File, SourceLocation(), SrcMgr::C_User);
+
+  return SM.getLocation(File, Line, Column);
+}
+
+/// ReadDiagBlock - Read a DIAG block and add its diagnostic to \p Diags.
+/// Returns true if the block is malformed.
+bool SerializedDiagnosticReader::ReadDiagBlock(llvm::BitstreamCursor &Stream,
+                              llvm::SmallVectorImpl<StoredDiagnostic> &Diags) {
+  if (Stream.EnterSubBlock(DIAG_BLOCK_ID))
+    return true;
+
+  std::vector<SourceRange> Ranges;
+  std::vector<CodeModificationHint> FixIts;
+  RecordData Record;
+  // The diagnostic is only added once its block is complete.
+  llvm::SmallVector<StoredDiagnostic, 1> Diag;
+  while (true) {
+    // A stream that ends inside a block was cut short.
+    if (Stream.AtEndOfStream())
+      return true;
+
+    unsigned Code = Stream.ReadCode();
+    if (Code == llvm::bitc::END_BLOCK) {
+      if (Stream.ReadBlockEnd() || Diag.empty())
+        return true;
+      Diags.push_back(Diag[0]);
+      return false;
+    }
+
+    if (Code == llvm::bitc::ENTER_SUBBLOCK) {
+      // No known subblocks, always skip them.
+      Stream.ReadSubBlockID();
+      if (Stream.SkipBlock())
+        return true;
+      continue;
+    }
+
+    if (Code == llvm::bitc::DEFINE_ABBREV) {
+      Stream.ReadAbbrevRecord();
+      continue;
+    }
+
+    Record.clear();
+    const char *BlobStart = 0;
+    unsigned BlobLen = 0;
+    unsigned Idx = 0;
+    switch (Stream.ReadRecord(Code, Record, &BlobStart, &BlobLen)) {
+    default:  // Default behavior: ignore unknown records.
+      break;
+
+    case RECORD_FILENAME: {
+      if (Record.empty() || !BlobStart)
+        return true;
+      unsigned ID = Record[0];
+      if (ID >= Files.size())
+        Files.resize(ID + 1);
+      Files[ID] = FM.getFile(llvm::StringRef(BlobStart, BlobLen));
+      break;
+    }
+
+    case RECORD_SOURCE_RANGE: {
+      SourceLocation Begin = ReadLocation(Record, Idx);
+      SourceLocation End = ReadLocation(Record, Idx);
+      if (Begin.isValid() && End.isValid())
+        Ranges.push_back(SourceRange(Begin, End));
+      break;
+    }
+
+    case RECORD_FIXIT: {
+      CodeModificationHint Hint;
+      SourceLocation RemoveBegin = ReadLocation(Record, Idx);
+      SourceLocation RemoveEnd = ReadLocation(Record, Idx);
+      Hint.RemoveRange = SourceRange(RemoveBegin, RemoveEnd);
+      Hint.InsertionLoc = ReadLocation(Record, Idx);
+      if (BlobStart)
+        Hint.CodeToInsert.assign(BlobStart, BlobStart + BlobLen);
+      FixIts.push_back(Hint);
+      break;
+    }
+
+    case RECORD_DIAG: {
+      if (Record.empty() || Record[0] > Diagnostic::Fatal || !BlobStart)
+        return true;
+      Diagnostic::Level Level = (Diagnostic::Level)Record[0];
+      Idx = 1;
+      SourceLocation Loc = ReadLocation(Record, Idx);
+      Diag.clear();
+      Diag.push_back(StoredDiagnostic(Level, FullSourceLoc(Loc, SM),
+                                      llvm::StringRef(BlobStart, BlobLen),
+                                      Ranges.empty() ? 0 : &Ranges[0],
+                                      Ranges.size(),
+                                      FixIts.empty() ? 0 : &FixIts[0],
+                                      FixIts.size()));
+      break;
+    }
+    }
+  }
+}
+
+bool SerializedDiagnosticReader::Read(llvm::StringRef Buffer,
+                              llvm::SmallVectorImpl<StoredDiagnostic> &Diags,
+                                      unsigned *HeaderEnd, unsigned *End) {
+  // The bitstream reader only deals in whole words; anything after the last
+  // one is part of a diagnostic that was cut short anyway.
+  unsigned Size = Buffer.size() & ~3U;
+  if (Size < 4)
+    return true;
+
+  llvm::BitstreamReader StreamFile;
+  StreamFile.init((const unsigned char *)Buffer.data(),
+                  (const unsigned char *)Buffer.data() + Size);
+  llvm::BitstreamCursor Stream;
+  Stream.init(StreamFile);
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'D' ||
+      Stream.Read(8) != 'I' ||
+      Stream.Read(8) != 'A' ||
+      Stream.Read(8) != 'G')
+    return true;
+
+  bool SawDiag = false;
+  while (!Stream.AtEndOfStream()) {
+    // Top-level blocks start and end on word boundaries.
+    unsigned BlockStart = Stream.GetCurrentBitNo() / 8;
+    unsigned Code = Stream.ReadCode();
+    if (Code != llvm::bitc::ENTER_SUBBLOCK)
+      return true;
+
+    switch (Stream.ReadSubBlockID()) {
+    case llvm::bitc::BLOCKINFO_BLOCK_ID:
+      if (Stream.ReadBlockInfoBlock())
+        return true;
+      break;
+
+    case DIAG_BLOCK_ID:
+      if (!SawDiag && HeaderEnd)
+        *HeaderEnd = BlockStart;
+      SawDiag = true;
+      if (ReadDiagBlock(Stream, Diags))
+        return true;
+      break;
+
+    default:
+      // The META block, and anything added in later versions.
+      if (Stream.SkipBlock())
+        return true;
+      break;
+    }
+
+    if (End)
+      *End = Stream.GetCurrentBitNo() / 8;
+  }
+
+  return false;
+}
+
+bool clang::ReadSerializedDiagnostics(llvm::StringRef Buffer, FileManager &FM,
+                                      SourceManager &SM,
+                              llvm::SmallVectorImpl<StoredDiagnostic> &Diags) {
+  std::vector<const FileEntry *> Files;
+  return SerializedDiagnosticReader(FM, SM, Files).Read(Buffer, Diags);
+}
+
+void SerializedDiagnosticStreamReader::Append(llvm::StringRef Data,
+                              llvm::SmallVectorImpl<StoredDiagnostic> &Diags) {
+  // Read the header again before the new data, since the abbreviations of
+  // the diagnostics are defined in it.
+  Pending.append(Data.begin(), Data.end());
+  std::string Buffer = Header + Pending;
+  unsigned HeaderEnd = 0, End = 0;
+  SerializedDiagnosticReader(FM, SM, Files).Read(Buffer, Diags, &HeaderEnd,
+                                                 &End);
+  if (Header.empty()) {
+    // Wait for the first diagnostic to know where the header ends.
+    if (!HeaderEnd)
+      return;
+    Header = Buffer.substr(0, HeaderEnd);
+  }
+  Pending = Buffer.substr(std::max<size_t>(End, Header.size()));
+}
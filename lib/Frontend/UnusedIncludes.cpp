@@ -0,0 +1,360 @@
+//===--- UnusedIncludes.cpp - Find the #includes a file does not need -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code lists the #includes of the main file that nothing in the
+// translation unit needs: no declaration, type or macro from the included
+// file, or from the files it includes in turn, is referenced from outside
+// them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/ASTConsumers.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+using namespace clang;
+
+namespace {
+
+/// IncludeUseTracker - Records the files the main file #includes, and which
+/// of them are used.  Every file entered by the preprocessor belongs to the
+/// #include of the main file it was reached through; a use of a macro or
+/// declaration from outside that #include's files marks it as used.
+class IncludeUseTracker : public PPCallbacks {
+  SourceManager &SM;
+
+  /// Includes - The files #included by the main file, in order.
+  std::vector<FileID> Includes;
+
+  /// Groups - The #include of the main file each file belongs to.
+  llvm::DenseMap<FileID, FileID> Groups;
+
+  /// Used - The #includes of the main file something needs.
+  llvm::DenseSet<FileID> Used;
+
+  FileID getIncluder(FileID FID) {
+    const SrcMgr::SLocEntry &Entry = SM.getSLocEntry(FID);
+    if (!Entry.isFile() || Entry.getFile().getIncludeLoc().isInvalid())
+      return FileID();
+    return SM.getFileID(Entry.getFile().getIncludeLoc());
+  }
+
+public:
+  explicit IncludeUseTracker(SourceManager &SM) : SM(SM) {}
+
+  /// getGroup - The file #included by the main file through which the
+  /// location was reached.  This is the main file for its own contents, and
+  /// the outermost file otherwise, e.g. for the predefines buffer and for the
+  /// files of -include options.
+  FileID getGroup(SourceLocation Loc) {
+    if (Loc.isInvalid())
+      return FileID();
+    FileID FID = SM.getFileID(SM.getInstantiationLoc(Loc));
+    FileID &Group = Groups[FID];
+    if (Group.isInvalid()) {
+      Group = FID;
+      for (FileID Includer = getIncluder(Group);
+           !Includer.isInvalid() && Includer != SM.getMainFileID();
+           Includer = getIncluder(Group))
+        Group = Includer;
+    }
+    return Group;
+  }
+
+  /// MarkUse - Note that the code at \arg From uses the entity declared or
+  /// defined at \arg To.
+  void MarkUse(FileID From, SourceLocation To) {
+    FileID ToGroup = getGroup(To);
+    if (!ToGroup.isInvalid() && ToGroup != From)
+      Used.insert(ToGroup);
+  }
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType) {
+    if (Reason != EnterFile)
+      return;
+    FileID FID = SM.getFileID(SM.getInstantiationLoc(Loc));
+    if (getIncluder(FID) == SM.getMainFileID() && SM.getFileEntryForID(FID))
+      Includes.push_back(FID);
+  }
+
+  virtual void MacroExpands(const Token &Id, const MacroInfo *MI) {
+    MarkUse(getGroup(Id.getLocation()), MI->getDefinitionLoc());
+  }
+
+  virtual void MacroTested(const Token &Id, const MacroInfo *MI) {
+    if (MI)
+      MarkUse(getGroup(Id.getLocation()), MI->getDefinitionLoc());
+  }
+
+  /// WriteUnused - Write the #includes of the main file nothing uses to
+  /// \arg OS, one per line, as the line of the #include and the file it
+  /// names.
+  void WriteUnused(llvm::raw_ostream &OS) {
+    const FileEntry *Main = SM.getFileEntryForID(SM.getMainFileID());
+    for (unsigned I = 0, N = Includes.size(); I != N; ++I) {
+      if (Used.count(Includes[I]))
+        continue;
+      SourceLocation IncludeLoc =
+        SM.getSLocEntry(Includes[I]).getFile().getIncludeLoc();
+      OS << (Main ? Main->getName() : "<main>") << ':'
+         << SM.getInstantiationLineNumber(IncludeLoc) << ": "
+         << SM.getFileEntryForID(Includes[I])->getName() << '\n';
+    }
+  }
+};
+
+/// UnusedIncludesPrinter - Walks the declarations of the translation unit,
+/// marking the files of everything they refer to as used, and writes the
+/// #includes of the main file that nothing refers to.
+class UnusedIncludesPrinter : public ASTConsumer {
+  llvm::raw_ostream *Out;
+  IncludeUseTracker *Tracker;
+
+  /// From - The #include of the main file the declaration being walked
+  /// belongs to.
+  FileID From;
+
+  void Use(const Decl *D) {
+    if (!D)
+      return;
+    Tracker->MarkUse(From, D->getLocation());
+    // A tag may only be complete, and a function may only be inline, because
+    // of its definition.
+    if (const TagDecl *Tag = dyn_cast<TagDecl>(D)) {
+      if (const TagDecl *Def = Tag->getDefinition())
+        Tracker->MarkUse(From, Def->getLocation());
+    }
+  }
+
+  void VisitType(QualType T);
+  void VisitTemplateArgument(const TemplateArgument &Arg);
+  void VisitStmt(Stmt *S);
+  void VisitDecl(Decl *D);
+  void VisitDeclContext(DeclContext *DC);
+
+public:
+  UnusedIncludesPrinter(llvm::raw_ostream *OS, Preprocessor &PP)
+    : Out(OS), Tracker(new IncludeUseTracker(PP.getSourceManager())) {
+    // The preprocessor owns the tracker.
+    PP.setPPCallbacks(Tracker);
+  }
+
+  virtual void HandleTranslationUnit(ASTContext &Ctx) {
+    VisitDeclContext(Ctx.getTranslationUnitDecl());
+    Tracker->WriteUnused(*Out);
+  }
+};
+
+} // end anonymous namespace
+
+void UnusedIncludesPrinter::VisitType(QualType T) {
+  while (!T.isNull()) {
+    Type *Ty = T.getTypePtr();
+    // Naming a typedef or a tag only needs its declaration.
+    if (TypedefType *TT = dyn_cast<TypedefType>(Ty)) {
+      Use(TT->getDecl());
+      return;
+    }
+    if (TagType *TT = dyn_cast<TagType>(Ty)) {
+      Use(TT->getDecl());
+      return;
+    }
+    if (ObjCInterfaceType *IT = dyn_cast<ObjCInterfaceType>(Ty)) {
+      Use(IT->getDecl());
+      return;
+    }
+    if (TemplateSpecializationType *TST =
+          dyn_cast<TemplateSpecializationType>(Ty)) {
+      Use(TST->getTemplateName().getAsTemplateDecl());
+      for (unsigned I = 0, N = TST->getNumArgs(); I != N; ++I)
+        VisitTemplateArgument(TST->getArg(I));
+      return;
+    }
+    if (FunctionType *FT = dyn_cast<FunctionType>(Ty)) {
+      if (FunctionProtoType *FPT = dyn_cast<FunctionProtoType>(FT))
+        for (FunctionProtoType::arg_type_iterator I = FPT->arg_type_begin(),
+             E = FPT->arg_type_end(); I != E; ++I)
+          VisitType(*I);
+      T = FT->getResultType();
+    } else if (const PointerType *PT = dyn_cast<PointerType>(Ty))
+      T = PT->getPointeeType();
+    else if (const ReferenceType *RT = dyn_cast<ReferenceType>(Ty))
+      T = RT->getPointeeType();
+    else if (const BlockPointerType *BT = dyn_cast<BlockPointerType>(Ty))
+      T = BT->getPointeeType();
+    else if (const ObjCObjectPointerType *OT =
+               dyn_cast<ObjCObjectPointerType>(Ty))
+      T = OT->getPointeeType();
+    else if (const MemberPointerType *MT = dyn_cast<MemberPointerType>(Ty)) {
+      VisitType(QualType(MT->getClass(), 0));
+      T = MT->getPointeeType();
+    } else if (const ArrayType *AT = dyn_cast<ArrayType>(Ty)) {
+      if (const VariableArrayType *VT = dyn_cast<VariableArrayType>(AT))
+        VisitStmt(VT->getSizeExpr());
+      T = AT->getElementType();
+    } else if (const ElaboratedType *ET = dyn_cast<ElaboratedType>(Ty))
+      T = ET->getUnderlyingType();
+    else if (const QualifiedNameType *QT = dyn_cast<QualifiedNameType>(Ty))
+      T = QT->getNamedType();
+    else if (const SubstTemplateTypeParmType *ST =
+               dyn_cast<SubstTemplateTypeParmType>(Ty))
+      T = ST->getReplacementType();
+    else if (const TypeOfType *TT = dyn_cast<TypeOfType>(Ty))
+      T = TT->getUnderlyingType();
+    else {
+      if (const TypeOfExprType *TE = dyn_cast<TypeOfExprType>(Ty))
+        VisitStmt(TE->getUnderlyingExpr());
+      else if (const DecltypeType *DT = dyn_cast<DecltypeType>(Ty))
+        VisitStmt(DT->getUnderlyingExpr());
+      return;
+    }
+  }
+}
+
+void UnusedIncludesPrinter::VisitTemplateArgument(const TemplateArgument &Arg) {
+  switch (Arg.getKind()) {
+  case TemplateArgument::Type:
+    VisitType(Arg.getAsType());
+    break;
+  case TemplateArgument::Declaration:
+    Use(Arg.getAsDecl());
+    break;
+  case TemplateArgument::Template:
+    Use(Arg.getAsTemplate().getAsTemplateDecl());
+    break;
+  case TemplateArgument::Expression:
+    VisitStmt(Arg.getAsExpr());
+    break;
+  default:
+    break;
+  }
+}
+
+void UnusedIncludesPrinter::VisitStmt(Stmt *S) {
+  if (!S)
+    return;
+
+  if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S))
+    Use(DRE->getDecl());
+  else if (MemberExpr *ME = dyn_cast<MemberExpr>(S))
+    Use(ME->getMemberDecl());
+  else if (ExplicitCastExpr *CE = dyn_cast<ExplicitCastExpr>(S))
+    VisitType(CE->getTypeAsWritten());
+  else if (SizeOfAlignOfExpr *SE = dyn_cast<SizeOfAlignOfExpr>(S)) {
+    if (SE->isArgumentType())
+      VisitType(SE->getArgumentType());
+  } else if (CompoundLiteralExpr *CLE = dyn_cast<CompoundLiteralExpr>(S))
+    VisitType(CLE->getType());
+  else if (CXXConstructExpr *CE = dyn_cast<CXXConstructExpr>(S))
+    Use(CE->getConstructor());
+  else if (CXXNewExpr *NE = dyn_cast<CXXNewExpr>(S)) {
+    VisitType(NE->getAllocatedType());
+    Use(NE->getOperatorNew());
+    Use(NE->getConstructor());
+  } else if (CXXDeleteExpr *DE = dyn_cast<CXXDeleteExpr>(S))
+    Use(DE->getOperatorDelete());
+  else if (ObjCMessageExpr *ME = dyn_cast<ObjCMessageExpr>(S))
+    Use(ME->getMethodDecl());
+  else if (ObjCIvarRefExpr *IRE = dyn_cast<ObjCIvarRefExpr>(S))
+    Use(IRE->getDecl());
+  else if (DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+    for (DeclStmt::decl_iterator I = DS->decl_begin(), E = DS->decl_end();
+         I != E; ++I)
+      VisitDecl(*I);
+  }
+
+  for (Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+       I != E; ++I)
+    VisitStmt(*I);
+}
+
+void UnusedIncludesPrinter::VisitDecl(Decl *D) {
+  if (ValueDecl *VD = dyn_cast<ValueDecl>(D))
+    VisitType(VD->getType());
+
+  if (VarDecl *Var = dyn_cast<VarDecl>(D))
+    VisitStmt(Var->getInit());
+  else if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    // Only walk the body with the declaration it belongs to.
+    if (FD->isThisDeclarationADefinition())
+      VisitStmt(FD->getBody());
+    if (CXXConstructorDecl *Ctor = dyn_cast<CXXConstructorDecl>(FD))
+      for (CXXConstructorDecl::init_iterator I = Ctor->init_begin(),
+           E = Ctor->init_end(); I != E; ++I)
+        VisitStmt((*I)->getInit());
+  } else if (EnumConstantDecl *ECD = dyn_cast<EnumConstantDecl>(D))
+    VisitStmt(ECD->getInitExpr());
+  else if (TypedefDecl *TD = dyn_cast<TypedefDecl>(D))
+    VisitType(TD->getUnderlyingType());
+  else if (CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(D)) {
+    if (RD->isDefinition())
+      for (CXXRecordDecl::base_class_iterator I = RD->bases_begin(),
+           E = RD->bases_end(); I != E; ++I)
+        VisitType(I->getType());
+  } else if (UsingDecl *UD = dyn_cast<UsingDecl>(D)) {
+    for (UsingDecl::shadow_iterator I = UD->shadow_begin(),
+         E = UD->shadow_end(); I != E; ++I)
+      Use((*I)->getTargetDecl());
+  } else if (NamespaceAliasDecl *NAD = dyn_cast<NamespaceAliasDecl>(D))
+    Use(NAD->getNamespace());
+  else if (ObjCInterfaceDecl *ID = dyn_cast<ObjCInterfaceDecl>(D))
+    Use(ID->getSuperClass());
+  else if (ObjCCategoryDecl *CD = dyn_cast<ObjCCategoryDecl>(D))
+    Use(CD->getClassInterface());
+  else if (ObjCImplDecl *ID = dyn_cast<ObjCImplDecl>(D))
+    Use(ID->getClassInterface());
+  else if (ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(D)) {
+    VisitType(MD->getResultType());
+    for (ObjCMethodDecl::param_iterator I = MD->param_begin(),
+         E = MD->param_end(); I != E; ++I)
+      VisitType((*I)->getType());
+    VisitStmt(MD->getBody());
+  }
+}
+
+void UnusedIncludesPrinter::VisitDeclContext(DeclContext *DC) {
+  for (DeclContext::decl_iterator I = DC->decls_begin(), E = DC->decls_end();
+       I != E; ++I) {
+    Decl *D = *I;
+    if (D->isImplicit())
+      continue;
+
+    From = Tracker->getGroup(D->getLocation());
+    VisitDecl(D);
+
+    if (TemplateDecl *Template = dyn_cast<TemplateDecl>(D))
+      if (Template->getTemplatedDecl()) {
+        D = Template->getTemplatedDecl();
+        VisitDecl(D);
+      }
+
+    if (DeclContext *Inner = dyn_cast<DeclContext>(D))
+      VisitDeclContext(Inner);
+  }
+}
+
+ASTConsumer *clang::CreateUnusedIncludesPrinter(llvm::raw_ostream *OS,
+                                                Preprocessor &PP) {
+  return new UnusedIncludesPrinter(OS, PP);
+}
@@ -0,0 +1,777 @@
+//===--- CallEdges.cpp - Persistent whole-program call graphs -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements call edge files, their merging into a persistent call
+// graph, and the PersistentCallGraph class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Index/CallEdges.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/StmtVisitor.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+
+#if defined(LLVM_ON_UNIX) && defined(ENABLE_THREADS) && ENABLE_THREADS != 0
+#include <pthread.h>
+#define HAVE_CALL_EDGE_THREADS 1
+#endif
+
+using namespace clang;
+using namespace clang::io;
+using namespace idx;
+
+namespace {
+/// The version of call edge files and call graph files.  Bump it whenever
+/// the format of either changes.
+const unsigned Version = 1;
+
+/// The largest number of name bytes a merge run holds before it is sorted
+/// and written out.
+const unsigned RunSizeLimit = 32 * 1024 * 1024;
+
+const char EdgeFileMagic[] = "cfe-cge";
+const char GraphFileMagic[] = "cfe-cgr";
+const unsigned MagicLen = sizeof(EdgeFileMagic) - 1;
+}
+
+/// ReadEntry - Read the 32-bit value at the given index of a table.
+static unsigned ReadEntry(const unsigned char *Table, unsigned I) {
+  const unsigned char *P = Table + I * 4;
+  return ReadUnalignedLE32(P);
+}
+
+/// FinishOutput - Flush the given output file and check whether anything
+/// written to it was lost.
+///
+/// \returns true on error, with a description in \p ErrorInfo.
+static bool FinishOutput(llvm::raw_fd_ostream &Out, llvm::StringRef Path,
+                         std::string &ErrorInfo) {
+  Out.flush();
+  if (!Out.has_error())
+    return false;
+
+  Out.clear_error();
+  ErrorInfo = "error writing '" + Path.str() + "'";
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Call edge extraction
+//===----------------------------------------------------------------------===//
+
+std::string idx::getCallGraphName(const FunctionDecl *FD, ASTContext &Ctx) {
+  std::string Name;
+  if (FD->getLinkage() != ExternalLinkage) {
+    SourceManager &SM = Ctx.getSourceManager();
+    if (const FileEntry *Main = SM.getFileEntryForID(SM.getMainFileID()))
+      Name = Main->getName();
+    Name += '@';
+  }
+
+  Name += FD->getQualifiedNameAsString();
+
+  if (Ctx.getLangOptions().CPlusPlus) {
+    PrintingPolicy Policy(Ctx.getLangOptions());
+    Name += '(';
+    for (unsigned i = 0, e = FD->getNumParams(); i != e; ++i) {
+      if (i)
+        Name += ',';
+      Name += Ctx.getCanonicalType(FD->getParamDecl(i)->getType())
+                .getAsString(Policy);
+    }
+    Name += ')';
+
+    if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(FD))
+      if (MD->getTypeQualifiers() & Qualifiers::Const)
+        Name += " const";
+  }
+
+  return Name;
+}
+
+namespace {
+class CallEdgeBuilder : public StmtVisitor<CallEdgeBuilder> {
+  CallEdgeWriter &Writer;
+  ASTContext &Ctx;
+  unsigned Caller;
+
+public:
+  CallEdgeBuilder(CallEdgeWriter &W, ASTContext &C, unsigned caller)
+    : Writer(W), Ctx(C), Caller(caller) {}
+
+  void VisitStmt(Stmt *S) { VisitChildren(S); }
+
+  void VisitCallExpr(CallExpr *CE) {
+    if (FunctionDecl *Callee = CE->getDirectCallee())
+      Writer.addEdge(Caller,
+                     Writer.getNameID(getCallGraphName(Callee, Ctx)));
+    VisitChildren(CE);
+  }
+
+  void VisitChildren(Stmt *S) {
+    for (Stmt::child_iterator I=S->child_begin(), E=S->child_end(); I != E;++I)
+      if (*I)
+        Visit(*I);
+  }
+};
+
+class CallEdgeConsumer : public ASTConsumer {
+  llvm::raw_fd_ostream *OS;
+  std::string OutFile;
+  Diagnostic &Diags;
+
+public:
+  CallEdgeConsumer(llvm::raw_fd_ostream *os, llvm::StringRef F,
+                   Diagnostic &D)
+    : OS(os), OutFile(F.str()), Diags(D) {}
+
+  virtual void HandleTranslationUnit(ASTContext &Ctx) {
+    CallEdgeWriter Writer;
+    Writer.addTU(Ctx);
+    Writer.write(*OS);
+
+    OS->flush();
+    if (OS->has_error()) {
+      Diags.Report(Diags.getCustomDiagID(Diagnostic::Error,
+                                        "unable to write call edges to '%0'"))
+        << OutFile;
+      OS->clear_error();
+    }
+  }
+};
+
+class CallEdgePrinter : public ASTConsumer {
+  llvm::raw_ostream *OS;
+
+public:
+  explicit CallEdgePrinter(llvm::raw_ostream *os) : OS(os) {}
+
+  virtual void HandleTranslationUnit(ASTContext &Ctx) {
+    CallEdgeWriter Writer;
+    Writer.addTU(Ctx);
+    Writer.print(*OS);
+  }
+};
+} // end anonymous namespace
+
+unsigned CallEdgeWriter::getNameID(llvm::StringRef Name) {
+  llvm::StringMapEntry<unsigned> &Entry = NameIDs.GetOrCreateValue(Name, ~0U);
+  if (Entry.getValue() == ~0U) {
+    Entry.setValue(Names.size());
+    Names.push_back(Name.str());
+  }
+  return Entry.getValue();
+}
+
+void CallEdgeWriter::addFunction(FunctionDecl *FD, ASTContext &Ctx) {
+  if (!FD->isThisDeclarationADefinition() || FD->isDependentContext())
+    return;
+
+  Stmt *Body = FD->getBody();
+  if (!Body)
+    return;
+
+  // Functions with no calls are still recorded, so that the graph knows
+  // they are defined.
+  CallEdgeBuilder Builder(*this, Ctx, getNameID(getCallGraphName(FD, Ctx)));
+  Builder.Visit(Body);
+}
+
+void CallEdgeWriter::addDeclContext(DeclContext *DC, ASTContext &Ctx) {
+  for (DeclContext::decl_iterator I = DC->decls_begin(), E = DC->decls_end();
+       I != E; ++I) {
+    if (FunctionDecl *FD = dyn_cast<FunctionDecl>(*I)) {
+      addFunction(FD, Ctx);
+      continue;
+    }
+
+    // Instantiations of templates are not members of any DeclContext, so
+    // reach them through their templates.  Explicit specializations are
+    // members of the template's DeclContext and are seen there as well;
+    // duplicate edges are removed when the edges are written.
+    if (FunctionTemplateDecl *FTD = dyn_cast<FunctionTemplateDecl>(*I)) {
+      typedef llvm::FoldingSet<FunctionTemplateSpecializationInfo> SpecSet;
+      SpecSet &Specs = FTD->getSpecializations();
+      for (SpecSet::iterator S = Specs.begin(), SEnd = Specs.end();
+           S != SEnd; ++S)
+        addFunction(S->Function, Ctx);
+      continue;
+    }
+
+    if (ClassTemplateDecl *CTD = dyn_cast<ClassTemplateDecl>(*I)) {
+      typedef llvm::FoldingSet<ClassTemplateSpecializationDecl> SpecSet;
+      SpecSet &Specs = CTD->getSpecializations();
+      for (SpecSet::iterator S = Specs.begin(), SEnd = Specs.end();
+           S != SEnd; ++S)
+        if (S->getSpecializationKind() != TSK_ExplicitSpecialization)
+          addDeclContext(&*S, Ctx);
+      continue;
+    }
+
+    if (!isa<NamespaceDecl>(*I) && !isa<LinkageSpecDecl>(*I) &&
+        !isa<RecordDecl>(*I))
+      continue;
+
+    DeclContext *Inner = cast<DeclContext>(*I);
+    if (!Inner->isDependentContext())
+      addDeclContext(Inner, Ctx);
+  }
+}
+
+void CallEdgeWriter::addTU(ASTContext &Ctx) {
+  addDeclContext(Ctx.getTranslationUnitDecl(), Ctx);
+}
+
+void CallEdgeWriter::write(llvm::raw_ostream &Out) {
+  std::sort(Edges.begin(), Edges.end());
+  Edges.erase(std::unique(Edges.begin(), Edges.end()), Edges.end());
+
+  Out << EdgeFileMagic;
+  Emit32(Out, Version);
+  Emit32(Out, Names.size());
+  Emit32(Out, Edges.size());
+  for (unsigned i = 0, e = Names.size(); i != e; ++i) {
+    Emit32(Out, Names[i].size());
+    Out << Names[i];
+  }
+  for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+    Emit32(Out, Edges[i].first);
+    Emit32(Out, Edges[i].second);
+  }
+}
+
+bool CallEdgeWriter::write(llvm::StringRef Path, std::string &ErrorInfo) {
+  llvm::raw_fd_ostream Out(Path.str().c_str(), ErrorInfo,
+                           llvm::raw_fd_ostream::F_Binary);
+  if (!ErrorInfo.empty())
+    return true;
+
+  write(Out);
+  return FinishOutput(Out, Path, ErrorInfo);
+}
+
+void CallEdgeWriter::print(llvm::raw_ostream &Out) const {
+  std::vector<std::pair<llvm::StringRef, llvm::StringRef> > Named;
+  for (unsigned i = 0, e = Edges.size(); i != e; ++i)
+    Named.push_back(std::make_pair(llvm::StringRef(Names[Edges[i].first]),
+                                   llvm::StringRef(Names[Edges[i].second])));
+  std::sort(Named.begin(), Named.end());
+  Named.erase(std::unique(Named.begin(), Named.end()), Named.end());
+
+  for (unsigned i = 0, e = Named.size(); i != e; ++i)
+    Out << Named[i].first << " -> " << Named[i].second << '\n';
+}
+
+ASTConsumer *idx::CreateCallEdgeWriter(llvm::raw_fd_ostream *OS,
+                                       llvm::StringRef OutFile,
+                                       Diagnostic &Diags) {
+  return new CallEdgeConsumer(OS, OutFile, Diags);
+}
+
+ASTConsumer *idx::CreateCallEdgePrinter(llvm::raw_ostream *OS) {
+  return new CallEdgePrinter(OS);
+}
+
+//===----------------------------------------------------------------------===//
+// Merging
+//===----------------------------------------------------------------------===//
+
+namespace {
+typedef std::pair<std::string, std::string> NamedEdge;
+
+/// MergeWorker - The state of one thread of the first merge phase, which
+/// turns a share of the edge files into sorted runs.
+struct MergeWorker {
+  /// InFiles - The edge files this worker reads.
+  std::vector<std::string> InFiles;
+
+  /// RunPrefix - The prefix of the names of the run files.
+  std::string RunPrefix;
+
+  /// RunFiles - The runs written so far.
+  std::vector<std::string> RunFiles;
+
+  /// Names - Every function name seen in the edge files.
+  llvm::StringMap<char> Names;
+
+  /// Edges, EdgeBytes - The edges of the current run and the number of name
+  /// bytes they hold.
+  std::vector<NamedEdge> Edges;
+  unsigned EdgeBytes;
+
+  /// ErrorInfo - A description of the first error, if any.
+  std::string ErrorInfo;
+
+  MergeWorker() : EdgeBytes(0) {}
+
+  bool readEdgeFile(const std::string &Path);
+  bool flushRun();
+  void run();
+};
+} // end anonymous namespace
+
+/// readEdgeFile - Add the names and edges of the given edge file.  Returns
+/// true on error.
+bool MergeWorker::readEdgeFile(const std::string &Path) {
+  llvm::OwningPtr<llvm::MemoryBuffer> Buf(
+    llvm::MemoryBuffer::getFile(Path.c_str(), &ErrorInfo));
+  if (!Buf) {
+    ErrorInfo = "unable to read '" + Path + "': " + ErrorInfo;
+    return true;
+  }
+
+  const unsigned char *P = (const unsigned char*) Buf->getBufferStart();
+  const unsigned char *End = (const unsigned char*) Buf->getBufferEnd();
+  if (End - P < (signed) (MagicLen + 3 * 4) ||
+      memcmp(P, EdgeFileMagic, MagicLen) != 0) {
+    ErrorInfo = "'" + Path + "' is not a call edge file";
+    return true;
+  }
+
+  P += MagicLen;
+  unsigned FileVersion = ReadUnalignedLE32(P);
+  unsigned NumNames = ReadUnalignedLE32(P);
+  unsigned NumEdges = ReadUnalignedLE32(P);
+  if (FileVersion != Version) {
+    ErrorInfo = "'" + Path + "' was written by a different version";
+    return true;
+  }
+
+  std::vector<llvm::StringRef> FileNames;
+  FileNames.reserve(NumNames);
+  for (unsigned i = 0; i != NumNames; ++i) {
+    if (End - P < 4)
+      break;
+    unsigned Len = ReadUnalignedLE32(P);
+    if ((unsigned) (End - P) < Len)
+      break;
+    FileNames.push_back(llvm::StringRef((const char*) P, Len));
+    P += Len;
+    Names[FileNames.back()] = 0;
+  }
+
+  if (FileNames.size() != NumNames ||
+      (unsigned) (End - P) / 8 < NumEdges) {
+    ErrorInfo = "'" + Path + "' is truncated";
+    return true;
+  }
+
+  for (unsigned i = 0; i != NumEdges; ++i) {
+    unsigned Caller = ReadUnalignedLE32(P);
+    unsigned Callee = ReadUnalignedLE32(P);
+    if (Caller >= NumNames || Callee >= NumNames) {
+      ErrorInfo = "'" + Path + "' is corrupt";
+      return true;
+    }
+
+    Edges.push_back(NamedEdge(FileNames[Caller].str(),
+                              FileNames[Callee].str()));
+    EdgeBytes += FileNames[Caller].size() + FileNames[Callee].size();
+    if (EdgeBytes >= RunSizeLimit && flushRun())
+      return true;
+  }
+
+  return false;
+}
+
+/// flushRun - Sort the edges of the current run and write them out.  Returns
+/// true on error.
+bool MergeWorker::flushRun() {
+  if (Edges.empty())
+    return false;
+
+  std::sort(Edges.begin(), Edges.end());
+  Edges.erase(std::unique(Edges.begin(), Edges.end()), Edges.end());
+
+  std::string RunFile = RunPrefix + llvm::utostr(RunFiles.size());
+  {
+    llvm::raw_fd_ostream Out(RunFile.c_str(), ErrorInfo,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!ErrorInfo.empty())
+      return true;
+
+    RunFiles.push_back(RunFile);
+    for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+      Emit32(Out, Edges[i].first.size());
+      Out << Edges[i].first;
+      Emit32(Out, Edges[i].second.size());
+      Out << Edges[i].second;
+    }
+    if (FinishOutput(Out, RunFile, ErrorInfo))
+      return true;
+  }
+
+  std::vector<NamedEdge>().swap(Edges);
+  EdgeBytes = 0;
+  return false;
+}
+
+void MergeWorker::run() {
+  for (unsigned i = 0, e = InFiles.size(); i != e; ++i)
+    if (readEdgeFile(InFiles[i]))
+      return;
+  flushRun();
+}
+
+#ifdef HAVE_CALL_EDGE_THREADS
+static void *MergeWorkerMain(void *Arg) {
+  static_cast<MergeWorker *>(Arg)->run();
+  return 0;
+}
+#endif
+
+namespace {
+/// RunReader - Reads the edges of a run file one at a time.
+class RunReader {
+  FILE *File;
+
+  bool readString(std::string &S) {
+    unsigned char Len[4];
+    if (fread(Len, 1, 4, File) != 4)
+      return false;
+    const unsigned char *P = Len;
+    S.resize(ReadUnalignedLE32(P));
+    return S.empty() || fread(&S[0], 1, S.size(), File) == S.size();
+  }
+
+public:
+  NamedEdge Edge;
+
+  explicit RunReader(const std::string &Path)
+    : File(fopen(Path.c_str(), "rb")) {}
+  ~RunReader() {
+    if (File)
+      fclose(File);
+  }
+
+  bool isOpen() const { return File != 0; }
+
+  /// next - Read the next edge into Edge.  Returns false at the end of the
+  /// run.
+  bool next() {
+    return readString(Edge.first) && readString(Edge.second);
+  }
+};
+
+/// RunOrder - Orders runs so that the run with the smallest current edge is
+/// on top of a priority queue.
+struct RunOrder {
+  bool operator()(const RunReader *LHS, const RunReader *RHS) const {
+    return RHS->Edge < LHS->Edge;
+  }
+};
+} // end anonymous namespace
+
+/// FindName - Find the index of a name in a sorted list of names.
+static unsigned FindName(const std::vector<std::string> &Names,
+                         const std::string &Name) {
+  std::vector<std::string>::const_iterator I =
+    std::lower_bound(Names.begin(), Names.end(), Name);
+  assert(I != Names.end() && *I == Name && "Edge with an unknown name!");
+  return I - Names.begin();
+}
+
+/// MergeRuns - Merge the sorted runs into the callee lists of the graph.
+static bool MergeRuns(const std::vector<std::string> &RunFiles,
+                      const std::vector<std::string> &Names,
+                      std::vector<unsigned> &CalleeOffsets,
+                      std::vector<unsigned> &Callees,
+                      std::string &ErrorInfo) {
+  std::vector<RunReader *> Readers;
+  std::priority_queue<RunReader *, std::vector<RunReader *>, RunOrder> Queue;
+  bool Failed = false;
+  for (unsigned i = 0, e = RunFiles.size(); i != e; ++i) {
+    RunReader *R = new RunReader(RunFiles[i]);
+    Readers.push_back(R);
+    if (!R->isOpen()) {
+      ErrorInfo = "unable to read '" + RunFiles[i] + "'";
+      Failed = true;
+      break;
+    }
+    if (R->next())
+      Queue.push(R);
+  }
+
+  // Runs are sorted by (caller, callee) and functions are numbered in the
+  // order of their names, so the merged edges come out in callee list order.
+  CalleeOffsets.assign(Names.size() + 1, 0);
+  NamedEdge Last;
+  bool HaveLast = false;
+  unsigned Caller = 0, Callee = 0;
+  while (!Failed && !Queue.empty()) {
+    RunReader *R = Queue.top();
+    Queue.pop();
+
+    // The same edge can appear in several runs.
+    if (!HaveLast || R->Edge != Last) {
+      if (!HaveLast || R->Edge.first != Last.first)
+        Caller = FindName(Names, R->Edge.first);
+      Callee = FindName(Names, R->Edge.second);
+      ++CalleeOffsets[Caller + 1];
+      Callees.push_back(Callee);
+      Last = R->Edge;
+      HaveLast = true;
+    }
+
+    if (R->next())
+      Queue.push(R);
+  }
+
+  for (unsigned i = 0, e = Readers.size(); i != e; ++i)
+    delete Readers[i];
+
+  for (unsigned i = 1, e = CalleeOffsets.size(); i != e; ++i)
+    CalleeOffsets[i] += CalleeOffsets[i - 1];
+  return Failed;
+}
+
+bool idx::MergeCallEdgeFiles(const std::vector<std::string> &InFiles,
+                             llvm::StringRef OutFile, unsigned NumThreads,
+                             std::string &ErrorInfo) {
+  if (NumThreads == 0)
+    NumThreads = 1;
+  if (NumThreads > InFiles.size())
+    NumThreads = InFiles.size() ? InFiles.size() : 1;
+
+  // Phase 1: read the edge files and write them out as sorted runs, on up to
+  // NumThreads threads.
+  std::vector<MergeWorker *> Workers;
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    Workers.push_back(new MergeWorker());
+    Workers[i]->RunPrefix = OutFile.str() + ".run" + llvm::utostr(i) + ".";
+  }
+  for (unsigned i = 0, e = InFiles.size(); i != e; ++i)
+    Workers[i % NumThreads]->InFiles.push_back(InFiles[i]);
+
+#ifdef HAVE_CALL_EDGE_THREADS
+  std::vector<pthread_t> Threads;
+  for (unsigned i = 1; i < NumThreads; ++i) {
+    pthread_t Thread;
+    if (pthread_create(&Thread, 0, MergeWorkerMain, Workers[i]) != 0)
+      break;
+    Threads.push_back(Thread);
+  }
+  // Any worker a thread could not be created for runs on this one.
+  Workers[0]->run();
+  for (unsigned i = Threads.size() + 1; i < NumThreads; ++i)
+    Workers[i]->run();
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    pthread_join(Threads[i], 0);
+#else
+  for (unsigned i = 0; i != NumThreads; ++i)
+    Workers[i]->run();
+#endif
+
+  std::vector<std::string> RunFiles;
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    RunFiles.insert(RunFiles.end(), Workers[i]->RunFiles.begin(),
+                    Workers[i]->RunFiles.end());
+    if (ErrorInfo.empty() && !Workers[i]->ErrorInfo.empty())
+      ErrorInfo = Workers[i]->ErrorInfo;
+  }
+
+  // Number the functions in the order of their names.
+  std::vector<std::string> Names;
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    llvm::StringMap<char> &WorkerNames = Workers[i]->Names;
+    if (ErrorInfo.empty())
+      for (llvm::StringMap<char>::iterator I = WorkerNames.begin(),
+           E = WorkerNames.end(); I != E; ++I)
+        Names.push_back(I->getKey().str());
+    delete Workers[i];
+  }
+  std::sort(Names.begin(), Names.end());
+  Names.erase(std::unique(Names.begin(), Names.end()), Names.end());
+
+  // Phase 2: merge the runs into the callee lists.
+  std::vector<unsigned> CalleeOffsets, Callees;
+  bool Failed = !ErrorInfo.empty() ||
+    MergeRuns(RunFiles, Names, CalleeOffsets, Callees, ErrorInfo);
+
+  for (unsigned i = 0, e = RunFiles.size(); i != e; ++i)
+    llvm::sys::Path(RunFiles[i]).eraseFromDisk();
+  if (Failed)
+    return true;
+
+  // Build the caller lists by counting sort.
+  unsigned NumFunctions = Names.size();
+  std::vector<unsigned> CallerOffsets(NumFunctions + 1, 0);
+  for (unsigned i = 0, e = Callees.size(); i != e; ++i)
+    ++CallerOffsets[Callees[i] + 1];
+  for (unsigned i = 1; i <= NumFunctions; ++i)
+    CallerOffsets[i] += CallerOffsets[i - 1];
+
+  std::vector<unsigned> Callers(Callees.size());
+  std::vector<unsigned> Next(CallerOffsets.begin(), CallerOffsets.end() - 1);
+  for (unsigned Caller = 0; Caller != NumFunctions; ++Caller)
+    for (unsigned i = CalleeOffsets[Caller], e = CalleeOffsets[Caller + 1];
+         i != e; ++i)
+      Callers[Next[Callees[i]]++] = Caller;
+
+  // Write the graph to a temporary file first, so that readers never see a
+  // partially written graph.
+  AtomicOutputFile File(OutFile);
+  if (File.open(ErrorInfo))
+    return true;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << GraphFileMagic;
+  Emit32(Out, Version);
+  Emit32(Out, NumFunctions);
+  Emit32(Out, Callees.size());
+
+  unsigned NameOffset = 0;
+  for (unsigned i = 0; i != NumFunctions; ++i) {
+    Emit32(Out, NameOffset);
+    NameOffset += Names[i].size();
+  }
+  Emit32(Out, NameOffset);
+
+  for (unsigned i = 0; i <= NumFunctions; ++i)
+    Emit32(Out, CalleeOffsets[i]);
+  for (unsigned i = 0, e = Callees.size(); i != e; ++i)
+    Emit32(Out, Callees[i]);
+  for (unsigned i = 0; i <= NumFunctions; ++i)
+    Emit32(Out, CallerOffsets[i]);
+  for (unsigned i = 0, e = Callers.size(); i != e; ++i)
+    Emit32(Out, Callers[i]);
+
+  for (unsigned i = 0; i != NumFunctions; ++i)
+    Out << Names[i];
+  return File.commit(ErrorInfo);
+}
+
+//===----------------------------------------------------------------------===//
+// PersistentCallGraph Implementation
+//===----------------------------------------------------------------------===//
+
+PersistentCallGraph::PersistentCallGraph()
+  : NumFunctions(0), NumEdges(0), NameOffsets(0), CalleeOffsets(0),
+    Callees(0), CallerOffsets(0), Callers(0), Names(0) {}
+
+PersistentCallGraph::~PersistentCallGraph() {}
+
+PersistentCallGraph *PersistentCallGraph::Load(llvm::StringRef Path,
+                                               std::string &ErrorInfo) {
+  llvm::OwningPtr<PersistentCallGraph> G(new PersistentCallGraph());
+  G->Buffer.reset(llvm::MemoryBuffer::getFile(Path.str().c_str(),
+                                              &ErrorInfo));
+  if (!G->Buffer)
+    return 0;
+
+  const unsigned char *BufBeg =
+    (const unsigned char*) G->Buffer->getBufferStart();
+  const unsigned char *BufEnd =
+    (const unsigned char*) G->Buffer->getBufferEnd();
+  if (BufEnd - BufBeg < (signed) (MagicLen + 3 * 4) ||
+      memcmp(BufBeg, GraphFileMagic, MagicLen) != 0) {
+    ErrorInfo = "not a call graph file";
+    return 0;
+  }
+
+  const unsigned char *P = BufBeg + MagicLen;
+  unsigned FileVersion = ReadUnalignedLE32(P);
+  G->NumFunctions = ReadUnalignedLE32(P);
+  G->NumEdges = ReadUnalignedLE32(P);
+  if (FileVersion != Version) {
+    ErrorInfo = "call graph file was written by a different version";
+    return 0;
+  }
+
+  // The tables are laid out one after another; check that they fit before
+  // pointing into them.
+  uint64_t TableSize = (3 * (uint64_t) G->NumFunctions + 3 +
+                        2 * (uint64_t) G->NumEdges) * 4;
+  if ((uint64_t) (BufEnd - P) < TableSize) {
+    ErrorInfo = "call graph file is truncated";
+    return 0;
+  }
+
+  G->NameOffsets = P;
+  P += (G->NumFunctions + 1) * 4;
+  G->CalleeOffsets = P;
+  P += (G->NumFunctions + 1) * 4;
+  G->Callees = P;
+  P += G->NumEdges * 4;
+  G->CallerOffsets = P;
+  P += (G->NumFunctions + 1) * 4;
+  G->Callers = P;
+  P += G->NumEdges * 4;
+  G->Names = (const char*) P;
+
+  if ((unsigned) (BufEnd - P) < ReadEntry(G->NameOffsets, G->NumFunctions)) {
+    ErrorInfo = "call graph file is truncated";
+    return 0;
+  }
+
+  return G.take();
+}
+
+llvm::StringRef PersistentCallGraph::getName(unsigned Function) const {
+  assert(Function < NumFunctions && "Invalid function!");
+  unsigned Begin = ReadEntry(NameOffsets, Function);
+  unsigned End = ReadEntry(NameOffsets, Function + 1);
+  return llvm::StringRef(Names + Begin, End - Begin);
+}
+
+bool PersistentCallGraph::lookup(llvm::StringRef Name,
+                                 unsigned &Function) const {
+  // Functions are numbered in the order of their names.
+  unsigned Lo = 0, Hi = NumFunctions;
+  while (Lo < Hi) {
+    unsigned Mid = Lo + (Hi - Lo) / 2;
+    if (getName(Mid) < Name)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+
+  if (Lo == NumFunctions || getName(Lo) != Name)
+    return false;
+  Function = Lo;
+  return true;
+}
+
+unsigned PersistentCallGraph::getNumCallees(unsigned Function) const {
+  assert(Function < NumFunctions && "Invalid function!");
+  return ReadEntry(CalleeOffsets, Function + 1) -
+         ReadEntry(CalleeOffsets, Function);
+}
+
+unsigned PersistentCallGraph::getCallee(unsigned Function, unsigned I) const {
+  assert(I < getNumCallees(Function) && "Invalid callee index!");
+  return ReadEntry(Callees, ReadEntry(CalleeOffsets, Function) + I);
+}
+
+unsigned PersistentCallGraph::getNumCallers(unsigned Function) const {
+  assert(Function < NumFunctions && "Invalid function!");
+  return ReadEntry(CallerOffsets, Function + 1) -
+         ReadEntry(CallerOffsets, Function);
+}
+
+unsigned PersistentCallGraph::getCaller(unsigned Function, unsigned I) const {
+  assert(I < getNumCallers(Function) && "Invalid caller index!");
+  return ReadEntry(Callers, ReadEntry(CallerOffsets, Function) + I);
+}
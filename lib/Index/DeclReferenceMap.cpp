@@ -15,6 +15,7 @@
 #include "clang/Index/DeclReferenceMap.h"
 #include "clang/Index/ASTLocation.h"
 #include "ASTVisitor.h"
+#include <algorithm>
 using namespace clang;
 using namespace idx;
 
@@ -42,26 +43,29 @@ public:
 
 void RefMapper::VisitDeclRefExpr(DeclRefExpr *Node) {
   NamedDecl *PrimD = cast<NamedDecl>(Node->getDecl()->getCanonicalDecl());
-  Map.insert(std::make_pair(PrimD, ASTLocation(CurrentDecl, Node)));
+  Map.push_back(std::make_pair(PrimD, ASTLocation(CurrentDecl, Node)));
 }
 
 void RefMapper::VisitMemberExpr(MemberExpr *Node) {
   NamedDecl *PrimD = cast<NamedDecl>(Node->getMemberDecl()->getCanonicalDecl());
-  Map.insert(std::make_pair(PrimD, ASTLocation(CurrentDecl, Node)));
+  Map.push_back(std::make_pair(PrimD, ASTLocation(CurrentDecl, Node)));
 }
 
 void RefMapper::VisitObjCIvarRefExpr(ObjCIvarRefExpr *Node) {
-  Map.insert(std::make_pair(Node->getDecl(), ASTLocation(CurrentDecl, Node)));
+  Map.push_back(std::make_pair(Node->getDecl(),
+                               ASTLocation(CurrentDecl, Node)));
 }
 
 void RefMapper::VisitTypedefTypeLoc(TypedefTypeLoc TL) {
   NamedDecl *ND = TL.getTypedefDecl();
-  Map.insert(std::make_pair(ND, ASTLocation(CurrentDecl, ND, TL.getNameLoc())));
+  Map.push_back(std::make_pair(ND,
+                               ASTLocation(CurrentDecl, ND, TL.getNameLoc())));
 }
 
 void RefMapper::VisitObjCInterfaceTypeLoc(ObjCInterfaceTypeLoc TL) {
   NamedDecl *ND = TL.getIFaceDecl();
-  Map.insert(std::make_pair(ND, ASTLocation(CurrentDecl, ND, TL.getNameLoc())));
+  Map.push_back(std::make_pair(ND,
+                               ASTLocation(CurrentDecl, ND, TL.getNameLoc())));
 }
 
 //===----------------------------------------------------------------------===//
@@ -70,21 +74,26 @@ void RefMapper::VisitObjCInterfaceTypeLoc(ObjCInterfaceTypeLoc TL) {
 
 DeclReferenceMap::DeclReferenceMap(ASTContext &Ctx) {
   RefMapper(Map).Visit(Ctx.getTranslationUnitDecl());
+  std::stable_sort(Map.begin(), Map.end(), CompareTy());
+}
+
+std::pair<DeclReferenceMap::MapTy::iterator, DeclReferenceMap::MapTy::iterator>
+DeclReferenceMap::getRefs(NamedDecl *D) const {
+  NamedDecl *Prim = cast<NamedDecl>(D->getCanonicalDecl());
+  return std::equal_range(Map.begin(), Map.end(), Prim, CompareTy());
 }
 
 DeclReferenceMap::astlocation_iterator
 DeclReferenceMap::refs_begin(NamedDecl *D) const {
-  NamedDecl *Prim = cast<NamedDecl>(D->getCanonicalDecl());
-  return astlocation_iterator(Map.lower_bound(Prim));
+  return astlocation_iterator(getRefs(D).first);
 }
 
 DeclReferenceMap::astlocation_iterator
 DeclReferenceMap::refs_end(NamedDecl *D) const {
-  NamedDecl *Prim = cast<NamedDecl>(D->getCanonicalDecl());
-  return astlocation_iterator(Map.upper_bound(Prim));
+  return astlocation_iterator(getRefs(D).second);
 }
 
 bool DeclReferenceMap::refs_empty(NamedDecl *D) const {
-  NamedDecl *Prim = cast<NamedDecl>(D->getCanonicalDecl());
-  return refs_begin(Prim) == refs_end(Prim);
+  std::pair<MapTy::iterator, MapTy::iterator> Refs = getRefs(D);
+  return Refs.first == Refs.second;
 }
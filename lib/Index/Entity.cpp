@@ -103,8 +103,8 @@ Entity EntityGetter::VisitNamedDecl(NamedDecl *D) {
     return Entity(Ent);
 
   void *Buf = ProgImpl.Allocate(sizeof(EntityImpl));
-  EntityImpl *New =
-      new (Buf) EntityImpl(Parent, GlobName, IdNS, isObjCInstanceMethod);
+  EntityImpl *New = new (Buf) EntityImpl(ProgImpl, Parent, GlobName, IdNS,
+                                         isObjCInstanceMethod);
   Entities.InsertNode(New, InsertPos);
 
   return Entity(New);
@@ -131,6 +131,21 @@ Entity EntityGetter::VisitFunctionDecl(FunctionDecl *D) {
 //===----------------------------------------------------------------------===//
 
 Decl *EntityImpl::getDecl(ASTContext &AST) {
+  // Cross-TU clients ask for the same entities over and over, and looking
+  // one up walks all of its parents by name.
+  Decl *D;
+  if (ProgImpl.getCachedDecl(AST, this, D))
+    return D;
+
+  // Don't remember failed lookups: the entity may still be declared later
+  // in a translation unit that is being parsed.
+  D = lookupDecl(AST);
+  if (D)
+    ProgImpl.setCachedDecl(AST, this, D);
+  return D;
+}
+
+Decl *EntityImpl::lookupDecl(ASTContext &AST) {
   DeclContext *DC =
     Parent.isInvalid() ? AST.getTranslationUnitDecl()
                        : cast<DeclContext>(Parent.getDecl(AST));
@@ -218,6 +233,7 @@ Entity Entity::get(Decl *D, Program &Prog) {
   if (D == 0)
     return Entity();
   ProgramImpl &ProgImpl = *static_cast<ProgramImpl*>(Prog.Impl);
+  llvm::sys::ScopedLock Guard(ProgImpl.getLock());
   return EntityImpl::get(D, Prog, ProgImpl);
 }
 
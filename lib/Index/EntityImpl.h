@@ -25,6 +25,10 @@ namespace idx {
   class ProgramImpl;
 
 class EntityImpl : public llvm::FoldingSetNode {
+  /// \brief The program that owns this entity, which caches the Decls it was
+  /// resolved to.
+  ProgramImpl &ProgImpl;
+
   Entity Parent;
   DeclarationName Name;
 
@@ -36,14 +40,19 @@ class EntityImpl : public llvm::FoldingSetNode {
   bool IsObjCInstanceMethod;
 
 public:
-  EntityImpl(Entity parent, DeclarationName name, unsigned idNS,
-             bool isObjCInstanceMethod)
-    : Parent(parent), Name(name), IdNS(idNS),
+  EntityImpl(ProgramImpl &progImpl, Entity parent, DeclarationName name,
+             unsigned idNS, bool isObjCInstanceMethod)
+    : ProgImpl(progImpl), Parent(parent), Name(name), IdNS(idNS),
       IsObjCInstanceMethod(isObjCInstanceMethod) { }
 
-  /// \brief Find the Decl that can be referred to by this entity.
+  /// \brief Find the Decl that can be referred to by this entity.  The
+  /// result is looked up by name once per ASTContext and then remembered.
   Decl *getDecl(ASTContext &AST);
 
+  /// \brief Look up the Decl that can be referred to by this entity by name,
+  /// starting from the Decl of the parent entity.
+  Decl *lookupDecl(ASTContext &AST);
+
   /// \brief Get an Entity associated with the given Decl.
   /// \returns Null if an Entity cannot refer to this Decl.
   static Entity get(Decl *D, Program &Prog, ProgramImpl &ProgImpl);
@@ -53,6 +53,7 @@ GlobalSelector GlobalSelector::get(Selector Sel, Program &Prog) {
     return GlobalSelector();
 
   ProgramImpl &ProgImpl = *static_cast<ProgramImpl*>(Prog.Impl);
+  llvm::sys::ScopedLock Guard(ProgImpl.getLock());
 
   llvm::SmallVector<IdentifierInfo *, 8> Ids;
   for (unsigned i = 0, e = Sel.isUnarySelector() ? 1 : Sel.getNumArgs();
@@ -17,41 +17,62 @@
 #include "clang/Index/TranslationUnit.h"
 #include "ASTVisitor.h"
 #include "clang/AST/DeclBase.h"
+#include "llvm/ADT/SmallVector.h"
+#include <vector>
 using namespace clang;
 using namespace idx;
 
+static unsigned getShard(Entity Ent) {
+  return llvm::DenseMapInfo<Entity>::getHashValue(Ent) % Indexer::NumShards;
+}
+
+static unsigned getShard(GlobalSelector Sel) {
+  return llvm::DenseMapInfo<GlobalSelector>::getHashValue(Sel) %
+           Indexer::NumShards;
+}
+
 namespace {
 
+/// \brief The entities and selectors found in one translation unit, grouped
+/// by shard so that each shard only has to be locked once.
+struct ShardedEntries {
+  std::vector<Entity> Entities[Indexer::NumShards];
+  std::vector<GlobalSelector> Selectors[Indexer::NumShards];
+};
+
 class EntityIndexer : public EntityHandler {
-  TranslationUnit *TU;
-  Indexer::MapTy &Map;
+  ShardedEntries &Entries;
 
 public:
-  EntityIndexer(TranslationUnit *tu, Indexer::MapTy &map) : TU(tu), Map(map) { }
+  EntityIndexer(ShardedEntries &entries) : Entries(entries) { }
 
   virtual void Handle(Entity Ent) {
     if (Ent.isInternalToTU())
       return;
-    Map[Ent].insert(TU);
+    Entries.Entities[getShard(Ent)].push_back(Ent);
   }
 };
 
 class SelectorIndexer : public ASTVisitor<SelectorIndexer> {
   Program &Prog;
-  TranslationUnit *TU;
-  Indexer::SelMapTy &Map;
+  ShardedEntries &Entries;
+
+  void Add(Selector Sel) {
+    GlobalSelector GlobSel = GlobalSelector::get(Sel, Prog);
+    Entries.Selectors[getShard(GlobSel)].push_back(GlobSel);
+  }
 
 public:
-  SelectorIndexer(Program &prog, TranslationUnit *tu, Indexer::SelMapTy &map)
-    : Prog(prog), TU(tu), Map(map) { }
+  SelectorIndexer(Program &prog, ShardedEntries &entries)
+    : Prog(prog), Entries(entries) { }
 
   void VisitObjCMethodDecl(ObjCMethodDecl *D) {
-    Map[GlobalSelector::get(D->getSelector(), Prog)].insert(TU);
+    Add(D->getSelector());
     Base::VisitObjCMethodDecl(D);
   }
 
   void VisitObjCMessageExpr(ObjCMessageExpr *Node) {
-    Map[GlobalSelector::get(Node->getSelector(), Prog)].insert(TU);
+    Add(Node->getSelector());
     Base::VisitObjCMessageExpr(Node);
   }
 };
@@ -61,12 +82,44 @@ public:
 void Indexer::IndexAST(TranslationUnit *TU) {
   assert(TU && "Passed null TranslationUnit");
   ASTContext &Ctx = TU->getASTContext();
-  CtxTUMap[&Ctx] = TU;
-  EntityIndexer Idx(TU, Map);
+  {
+    llvm::sys::ScopedLock Guard(CtxLock);
+    CtxTUMap[&Ctx] = TU;
+    TUCtxMap[TU] = &Ctx;
+  }
+
+  // Walk the AST without holding any of the locks of the tables.
+  ShardedEntries Entries;
+  EntityIndexer Idx(Entries);
   Prog.FindEntities(Ctx, Idx);
 
-  SelectorIndexer SelIdx(Prog, TU, SelMap);
+  SelectorIndexer SelIdx(Prog, Entries);
   SelIdx.Visit(Ctx.getTranslationUnitDecl());
+
+  for (unsigned i = 0; i != NumShards; ++i) {
+    std::vector<Entity> &Ents = Entries.Entities[i];
+    std::vector<GlobalSelector> &Sels = Entries.Selectors[i];
+    if (Ents.empty() && Sels.empty())
+      continue;
+
+    Shard &S = Shards[i];
+    llvm::sys::ScopedLock Guard(S.Lock);
+    for (unsigned j = 0, e = Ents.size(); j != e; ++j)
+      S.Map[Ents[j]].insert(TU);
+    for (unsigned j = 0, e = Sels.size(); j != e; ++j)
+      S.SelMap[Sels[j]].insert(TU);
+  }
+}
+
+void Indexer::UnloadAST(TranslationUnit *TU) {
+  llvm::sys::ScopedLock Guard(CtxLock);
+  TUCtxMapTy::iterator I = TUCtxMap.find(TU);
+  if (I == TUCtxMap.end())
+    return;
+
+  Prog.ForgetASTContext(*I->second);
+  CtxTUMap.erase(I->second);
+  TUCtxMap.erase(I);
 }
 
 void Indexer::GetTranslationUnitsFor(Entity Ent,
@@ -75,30 +128,48 @@ void Indexer::GetTranslationUnitsFor(Entity Ent,
 
   if (Ent.isInternalToTU()) {
     Decl *D = Ent.getInternalDecl();
-    CtxTUMapTy::iterator I = CtxTUMap.find(&D->getASTContext());
-    if (I != CtxTUMap.end())
-      Handler.Handle(I->second);
+    TranslationUnit *TU = 0;
+    {
+      llvm::sys::ScopedLock Guard(CtxLock);
+      CtxTUMapTy::iterator I = CtxTUMap.find(&D->getASTContext());
+      if (I != CtxTUMap.end())
+        TU = I->second;
+    }
+    if (TU)
+      Handler.Handle(TU);
     return;
   }
 
-  MapTy::iterator I = Map.find(Ent);
-  if (I == Map.end())
-    return;
+  // Copy the set so that the handler runs without the lock of the shard; it
+  // may well index or look up other translation units.
+  llvm::SmallVector<TranslationUnit *, 4> TUs;
+  {
+    Shard &S = Shards[getShard(Ent)];
+    llvm::sys::ScopedLock Guard(S.Lock);
+    MapTy::iterator I = S.Map.find(Ent);
+    if (I == S.Map.end())
+      return;
+    TUs.append(I->second.begin(), I->second.end());
+  }
 
-  TUSetTy &Set = I->second;
-  for (TUSetTy::iterator I = Set.begin(), E = Set.end(); I != E; ++I)
-    Handler.Handle(*I);
+  for (unsigned i = 0, e = TUs.size(); i != e; ++i)
+    Handler.Handle(TUs[i]);
 }
 
 void Indexer::GetTranslationUnitsFor(GlobalSelector Sel,
                                     TranslationUnitHandler &Handler) {
   assert(Sel.isValid() && "Expected valid GlobalSelector");
 
-  SelMapTy::iterator I = SelMap.find(Sel);
-  if (I == SelMap.end())
-    return;
+  llvm::SmallVector<TranslationUnit *, 4> TUs;
+  {
+    Shard &S = Shards[getShard(Sel)];
+    llvm::sys::ScopedLock Guard(S.Lock);
+    SelMapTy::iterator I = S.SelMap.find(Sel);
+    if (I == S.SelMap.end())
+      return;
+    TUs.append(I->second.begin(), I->second.end());
+  }
 
-  TUSetTy &Set = I->second;
-  for (TUSetTy::iterator I = Set.begin(), E = Set.end(); I != E; ++I)
-    Handler.Handle(*I);
+  for (unsigned i = 0, e = TUs.size(); i != e; ++i)
+    Handler.Handle(TUs[i]);
 }
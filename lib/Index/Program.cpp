@@ -30,6 +30,65 @@ Program::~Program() {
   delete static_cast<ProgramImpl *>(Impl);
 }
 
+void Program::ForgetASTContext(ASTContext &Ctx) {
+  static_cast<ProgramImpl *>(Impl)->forgetDecls(Ctx);
+}
+
+ProgramImpl::~ProgramImpl() {
+  for (llvm::DenseMap<ASTContext *, ContextDecls *>::iterator
+         I = DeclMaps.begin(), E = DeclMaps.end(); I != E; ++I)
+    delete I->second;
+}
+
+bool ProgramImpl::getCachedDecl(ASTContext &Ctx, EntityImpl *Ent, Decl *&D) {
+  llvm::sys::ScopedLock Guard(DeclMapLock);
+  llvm::DenseMap<ASTContext *, ContextDecls *>::iterator
+    I = DeclMaps.find(&Ctx);
+  if (I == DeclMaps.end())
+    return false;
+
+  if (I->second->ContextID != Ctx.getUniqueID()) {
+    // The Decls were those of an ASTContext that has since been destroyed.
+    delete I->second;
+    DeclMaps.erase(I);
+    return false;
+  }
+
+  DeclMapTy &Decls = I->second->Decls;
+  DeclMapTy::iterator Known = Decls.find(Ent);
+  if (Known == Decls.end())
+    return false;
+
+  D = Known->second;
+  return true;
+}
+
+void ProgramImpl::setCachedDecl(ASTContext &Ctx, EntityImpl *Ent, Decl *D) {
+  assert(D && "Caching an unresolved entity");
+  llvm::sys::ScopedLock Guard(DeclMapLock);
+  ContextDecls *&Map = DeclMaps[&Ctx];
+  if (Map && Map->ContextID != Ctx.getUniqueID()) {
+    delete Map;
+    Map = 0;
+  }
+  if (!Map) {
+    Map = new ContextDecls();
+    Map->ContextID = Ctx.getUniqueID();
+  }
+  Map->Decls[Ent] = D;
+}
+
+void ProgramImpl::forgetDecls(ASTContext &Ctx) {
+  llvm::sys::ScopedLock Guard(DeclMapLock);
+  llvm::DenseMap<ASTContext *, ContextDecls *>::iterator
+    I = DeclMaps.find(&Ctx);
+  if (I == DeclMaps.end())
+    return;
+
+  delete I->second;
+  DeclMaps.erase(I);
+}
+
 static void FindEntitiesInDC(DeclContext *DC, Program &Prog,
                              EntityHandler &Handler) {
   for (DeclContext::decl_iterator
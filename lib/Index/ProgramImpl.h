@@ -17,8 +17,12 @@
 #include "EntityImpl.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LangOptions.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/System/Mutex.h"
 
 namespace clang {
+  class ASTContext;
+  class Decl;
 
 namespace idx {
   class EntityListener;
@@ -26,27 +30,61 @@ namespace idx {
 class ProgramImpl {
 public:
   typedef llvm::FoldingSet<EntityImpl> EntitySetTy;
+  typedef llvm::DenseMap<EntityImpl *, Decl *> DeclMapTy;
 
 private:
+  /// \brief The Decls that the entities were resolved to in one ASTContext.
+  struct ContextDecls {
+    /// \brief The unique ID of the ASTContext.  An ASTContext that is
+    /// destroyed without being forgotten may leave its address to a new
+    /// one, and this tells the two apart.
+    unsigned ContextID;
+    DeclMapTy Decls;
+  };
+
   EntitySetTy Entities;
   llvm::BumpPtrAllocator BumpAlloc;
 
   IdentifierTable Identifiers;
   SelectorTable Selectors;
 
+  /// \brief Guards the entities, identifiers and selectors, so that
+  /// translation units can be indexed on several threads at once.
+  llvm::sys::Mutex Lock;
+
+  /// \brief The Decls that the entities were resolved to so far, for each
+  /// ASTContext.
+  llvm::DenseMap<ASTContext *, ContextDecls *> DeclMaps;
+
+  /// \brief Guards DeclMaps.  This is separate from Lock so that resolving
+  /// entities does not contend with indexing.
+  llvm::sys::Mutex DeclMapLock;
+
   ProgramImpl(const ProgramImpl&); // do not implement
   ProgramImpl &operator=(const ProgramImpl &); // do not implement
 
 public:
   ProgramImpl() : Identifiers(LangOptions()) { }
+  ~ProgramImpl();
 
   EntitySetTy &getEntities() { return Entities; }
   IdentifierTable &getIdents() { return Identifiers; }
   SelectorTable &getSelectors() { return Selectors; }
+  llvm::sys::Mutex &getLock() { return Lock; }
 
   void *Allocate(unsigned Size, unsigned Align = 8) {
     return BumpAlloc.Allocate(Size, Align);
   }
+
+  /// \brief Find the Decl that \p Ent was resolved to in \p Ctx.  Returns
+  /// false if it was not resolved in \p Ctx yet.
+  bool getCachedDecl(ASTContext &Ctx, EntityImpl *Ent, Decl *&D);
+
+  /// \brief Remember that \p Ent resolves to \p D in \p Ctx.
+  void setCachedDecl(ASTContext &Ctx, EntityImpl *Ent, Decl *D);
+
+  /// \brief Forget the Decls of \p Ctx, which is about to be destroyed.
+  void forgetDecls(ASTContext &Ctx);
 };
 
 } // namespace idx
@@ -14,6 +14,7 @@
 
 #include "clang/Index/SelectorMap.h"
 #include "ASTVisitor.h"
+#include <algorithm>
 using namespace clang;
 using namespace idx;
 
@@ -41,18 +42,18 @@ public:
 
 void SelMapper::VisitObjCMethodDecl(ObjCMethodDecl *D) {
   if (D->getCanonicalDecl() == D)
-    SelMethMap.insert(std::make_pair(D->getSelector(), D));
+    SelMethMap.push_back(std::make_pair(D->getSelector(), D));
   Base::VisitObjCMethodDecl(D);
 }
 
 void SelMapper::VisitObjCMessageExpr(ObjCMessageExpr *Node) {
   ASTLocation ASTLoc(CurrentDecl, Node);
-  SelRefMap.insert(std::make_pair(Node->getSelector(), ASTLoc));
+  SelRefMap.push_back(std::make_pair(Node->getSelector(), ASTLoc));
 }
 
 void SelMapper::VisitObjCSelectorExpr(ObjCSelectorExpr *Node) {
   ASTLocation ASTLoc(CurrentDecl, Node);
-  SelRefMap.insert(std::make_pair(Node->getSelector(), ASTLoc));
+  SelRefMap.push_back(std::make_pair(Node->getSelector(), ASTLoc));
 }
 
 //===----------------------------------------------------------------------===//
@@ -61,24 +62,32 @@ void SelMapper::VisitObjCSelectorExpr(ObjCSelectorExpr *Node) {
 
 SelectorMap::SelectorMap(ASTContext &Ctx) {
   SelMapper(SelMethMap, SelRefMap).Visit(Ctx.getTranslationUnitDecl());
+  std::stable_sort(SelMethMap.begin(), SelMethMap.end(), MethCompareTy());
+  std::stable_sort(SelRefMap.begin(), SelRefMap.end(), RefCompareTy());
 }
 
 SelectorMap::method_iterator
 SelectorMap::methods_begin(Selector Sel) const {
-  return method_iterator(SelMethMap.lower_bound(Sel));
+  return method_iterator(std::lower_bound(SelMethMap.begin(), SelMethMap.end(),
+                                          Sel, MethCompareTy()));
 }
 
 SelectorMap::method_iterator
 SelectorMap::methods_end(Selector Sel) const {
-  return method_iterator(SelMethMap.upper_bound(Sel));
+  return method_iterator(std::upper_bound(SelMethMap.begin(), SelMethMap.end(),
+                                          Sel, MethCompareTy()));
 }
 
 SelectorMap::astlocation_iterator
 SelectorMap::refs_begin(Selector Sel) const {
-  return astlocation_iterator(SelRefMap.lower_bound(Sel));
+  return astlocation_iterator(std::lower_bound(SelRefMap.begin(),
+                                               SelRefMap.end(), Sel,
+                                               RefCompareTy()));
 }
 
 SelectorMap::astlocation_iterator
 SelectorMap::refs_end(Selector Sel) const {
-  return astlocation_iterator(SelRefMap.upper_bound(Sel));
+  return astlocation_iterator(std::upper_bound(SelRefMap.begin(),
+                                               SelRefMap.end(), Sel,
+                                               RefCompareTy()));
 }
@@ -0,0 +1,241 @@
+//===--- HeaderGuardDatabase.cpp - Persistent header guard table ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the HeaderGuardDatabase interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderGuardDatabase.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+using namespace clang;
+using namespace clang::io;
+
+typedef HeaderGuardDatabase::FileKey FileKey;
+
+HeaderGuardDatabase::FileKey::FileKey(const FileEntry *FE)
+  : Device(FE->getDevice()), Inode(FE->getInode()),
+    ModTime(FE->getModificationTime()), Size(FE->getSize()) {}
+
+//===----------------------------------------------------------------------===//
+// On-disk hash table traits.
+//===----------------------------------------------------------------------===//
+//
+// The database file is laid out as follows:
+//
+//   "cfe-hgd" <version:32> <hash table payload> <hash table buckets>
+//   <bucket table offset:32>
+//
+// Keys are the 64-bit device, inode, modification time and size of a header;
+// the data is the name of its controlling macro.
+
+namespace {
+class HeaderGuardTraitBase {
+public:
+  typedef FileKey internal_key_type;
+
+  static unsigned ComputeHash(const internal_key_type &K) {
+    uint64_t H = K.Inode;
+    H = H * 37 + K.Device;
+    H = H * 37 + K.ModTime;
+    H = H * 37 + K.Size;
+    return (unsigned) (H ^ (H >> 32));
+  }
+};
+
+class HeaderGuardLookupTrait : public HeaderGuardTraitBase {
+public:
+  typedef internal_key_type external_key_type;
+  typedef llvm::StringRef data_type;
+
+  static const internal_key_type &GetInternalKey(const external_key_type &K) {
+    return K;
+  }
+
+  static bool EqualKey(const internal_key_type &A, const internal_key_type &B){
+    return A.Device == B.Device && A.Inode == B.Inode &&
+           A.ModTime == B.ModTime && A.Size == B.Size;
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = ReadUnalignedLE16(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    assert(n == 4 * 8 && "Malformed key");
+    uint64_t Device = ReadUnalignedLE64(d);
+    uint64_t Inode = ReadUnalignedLE64(d);
+    uint64_t ModTime = ReadUnalignedLE64(d);
+    uint64_t Size = ReadUnalignedLE64(d);
+    return FileKey(Device, Inode, ModTime, Size);
+  }
+
+  static data_type ReadData(const internal_key_type &, const unsigned char *d,
+                            unsigned n) {
+    return llvm::StringRef((const char*) d, n);
+  }
+};
+
+class HeaderGuardWriterTrait : public HeaderGuardTraitBase {
+public:
+  typedef internal_key_type key_type;
+  typedef const key_type &key_type_ref;
+  typedef llvm::StringRef data_type;
+  typedef llvm::StringRef data_type_ref;
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(llvm::raw_ostream &Out, key_type_ref, data_type_ref D) {
+    Emit16(Out, 4 * 8);
+    Emit16(Out, D.size());
+    return std::make_pair(4 * 8, D.size());
+  }
+
+  static void EmitKey(llvm::raw_ostream &Out, key_type_ref K, unsigned) {
+    Emit64(Out, K.Device);
+    Emit64(Out, K.Inode);
+    Emit64(Out, K.ModTime);
+    Emit64(Out, K.Size);
+  }
+
+  static void EmitData(llvm::raw_ostream &Out, key_type_ref, data_type_ref D,
+                       unsigned) {
+    Out.write(D.data(), D.size());
+  }
+};
+} // end anonymous namespace
+
+typedef OnDiskChainedHashTable<HeaderGuardLookupTrait> HeaderGuardTable;
+
+//===----------------------------------------------------------------------===//
+// HeaderGuardDatabase Implementation
+//===----------------------------------------------------------------------===//
+
+HeaderGuardDatabase::HeaderGuardDatabase(llvm::StringRef Path) : Table(0) {
+  Buf.reset(llvm::MemoryBuffer::getFile(Path.str().c_str()));
+  if (!Buf)
+    return;
+
+  const unsigned char *BufBeg = (const unsigned char*) Buf->getBufferStart();
+  const unsigned char *BufEnd = (const unsigned char*) Buf->getBufferEnd();
+  const unsigned MagicLen = sizeof("cfe-hgd") - 1;
+
+  // A damaged or outdated database is simply ignored; it will be rewritten.
+  if (BufEnd - BufBeg < (signed) (MagicLen + 4 + 8 + 4) ||
+      memcmp(BufBeg, "cfe-hgd", MagicLen) != 0) {
+    Buf.reset();
+    return;
+  }
+
+  const unsigned char *p = BufBeg + MagicLen;
+  if (ReadUnalignedLE32(p) != Version) {
+    Buf.reset();
+    return;
+  }
+
+  const unsigned char *Trailer = BufEnd - 4;
+  const unsigned char *Buckets = BufBeg + ReadUnalignedLE32(Trailer);
+  if (Buckets < p || Buckets + 8 > BufEnd - 4 ||
+      ((uintptr_t) Buckets & 0x3) != 0) {
+    Buf.reset();
+    return;
+  }
+
+  Table = HeaderGuardTable::Create(Buckets, BufBeg);
+}
+
+HeaderGuardDatabase::~HeaderGuardDatabase() {
+  delete (HeaderGuardTable*) Table;
+}
+
+llvm::StringRef HeaderGuardDatabase::lookup(const FileEntry *File) {
+  FileKey Key(File);
+  std::map<FileKey, std::string>::iterator NI = NewEntries.find(Key);
+  if (NI != NewEntries.end())
+    return NI->second;
+
+  if (!Table)
+    return llvm::StringRef();
+
+  HeaderGuardTable &T = *(HeaderGuardTable*) Table;
+  HeaderGuardTable::iterator I = T.find(Key);
+  if (I == T.end())
+    return llvm::StringRef();
+  return *I;
+}
+
+void HeaderGuardDatabase::record(const FileEntry *File,
+                                 llvm::StringRef Macro) {
+  // Don't rewrite the database just to repeat what it already says.
+  if (Table) {
+    HeaderGuardTable &T = *(HeaderGuardTable*) Table;
+    HeaderGuardTable::iterator I = T.find(FileKey(File));
+    if (I != T.end() && *I == Macro)
+      return;
+  }
+
+  NewEntries[FileKey(File)] = Macro;
+}
+
+bool HeaderGuardDatabase::Write(llvm::StringRef Path) {
+  OnDiskChainedHashTableGenerator<HeaderGuardWriterTrait> Generator;
+
+  // Carry over the entries of the on-disk table that this compilation did not
+  // supersede.  The table has no iterator, so walk its buckets directly.
+  if (Table) {
+    HeaderGuardTable &T = *(HeaderGuardTable*) Table;
+    const unsigned char *Bucket = T.getBuckets();
+    for (unsigned i = 0, e = T.getNumBuckets(); i != e; ++i) {
+      unsigned Offset = ReadLE32(Bucket);
+      if (Offset == 0)
+        continue;
+
+      const unsigned char *Items = T.getBase() + Offset;
+      unsigned NumItems = ReadUnalignedLE16(Items);
+      for (unsigned j = 0; j != NumItems; ++j) {
+        Items += 4; // Skip the hash.
+        std::pair<unsigned, unsigned> L =
+          HeaderGuardLookupTrait::ReadKeyDataLength(Items);
+        FileKey Key = HeaderGuardLookupTrait::ReadKey(Items, L.first);
+        llvm::StringRef Macro =
+          HeaderGuardLookupTrait::ReadData(Key, Items + L.first, L.second);
+        Items += L.first + L.second;
+
+        if (!NewEntries.count(Key))
+          Generator.insert(Key, Macro);
+      }
+    }
+  }
+
+  for (std::map<FileKey, std::string>::iterator I = NewEntries.begin(),
+       E = NewEntries.end(); I != E; ++I)
+    Generator.insert(I->first, I->second);
+
+  AtomicOutputFile File(Path);
+  std::string ErrMsg;
+  if (File.open(ErrMsg))
+    return true;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << "cfe-hgd";
+  Emit32(Out, Version);
+  Offset TableOff = Generator.Emit(Out);
+  Emit32(Out, TableOff);
+  if (File.commit(ErrMsg))
+    return true;
+
+  NewEntries.clear();
+  return false;
+}
@@ -12,7 +12,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderGuardDatabase.h"
 #include "clang/Lex/HeaderMap.h"
+#include "clang/Lex/HeaderSearchCache.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "llvm/System/Path.h"
@@ -40,6 +42,9 @@ HeaderSearch::HeaderSearch(FileManager &FM) : FileMgr(FM), FrameworkMap(64) {
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+  NumPersistentCacheHits = NumPersistentCacheMisses = 0;
+  NumGuardDatabaseHits = NumGuardDatabaseOptzn = 0;
+  GuardIdentifiers = 0;
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -68,6 +73,49 @@ void HeaderSearch::PrintStats() {
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+
+  if (PersistentLookupCache) {
+    fprintf(stderr, "%d persistent lookup cache hits.\n",
+            NumPersistentCacheHits);
+    fprintf(stderr, "%d persistent lookup cache misses.\n",
+            NumPersistentCacheMisses);
+  }
+
+  if (GuardDatabase) {
+    fprintf(stderr, "%d include guards found in the guard database.\n",
+            NumGuardDatabaseHits);
+    fprintf(stderr, "  %d #includes skipped due to the guard database.\n",
+            NumGuardDatabaseOptzn);
+  }
+}
+
+void HeaderSearch::SetPersistentLookupCache(llvm::StringRef Path) {
+  PersistentLookupCacheFile = Path;
+  PersistentLookupCache.reset(
+    new HeaderSearchCache(Path,
+                          HeaderSearchCache::ComputeConfiguration(SearchDirs,
+                                                                 SystemDirIdx)));
+}
+
+void HeaderSearch::WritePersistentLookupCache() {
+  // Failing to update the cache is harmless; the next compilation will just
+  // redo the lookups.
+  if (PersistentLookupCache && PersistentLookupCache->hasNewEntries())
+    PersistentLookupCache->Write(PersistentLookupCacheFile);
+}
+
+void HeaderSearch::SetGuardDatabase(llvm::StringRef Path,
+                                    IdentifierTable &Idents) {
+  GuardDatabaseFile = Path;
+  GuardDatabase.reset(new HeaderGuardDatabase(Path));
+  GuardIdentifiers = &Idents;
+}
+
+void HeaderSearch::WriteGuardDatabase() {
+  // As with the lookup cache, failing to update the database only costs
+  // later compilations the chance to skip a header.
+  if (GuardDatabase && GuardDatabase->hasNewEntries())
+    GuardDatabase->Write(GuardDatabaseFile);
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -167,10 +215,10 @@ const FileEntry *DirectoryLookup::DoFrameworkLookup(llvm::StringRef Filename,
   if (FrameworkDirCache == 0) {
     HS.IncrementFrameworkLookupCount();
 
-    // If the framework dir doesn't exist, we fail.
-    // FIXME: It's probably more efficient to query this with FileMgr.getDir.
-    if (!llvm::sys::Path(std::string(FrameworkName.begin(),
-                                     FrameworkName.end())).exists())
+    // If the framework dir doesn't exist, we fail.  Asking the file manager
+    // caches the answer, and lets a cached listing of the framework directory
+    // answer it without a stat call.
+    if (!FileMgr.getDirectory(FrameworkName.begin(), FrameworkName.end()))
       return 0;
 
     // Otherwise, if it does, remember that this is the right direntry for this
@@ -256,6 +304,7 @@ const FileEntry *HeaderSearch::LookupFile(llvm::StringRef Filename,
   // file was found in.
   if (FromDir)
     i = FromDir-&SearchDirs[0];
+  unsigned StartIdx = i;
 
   // Cache all of the lookups performed by this method.  Many headers are
   // multiply included, and the "pragma once" optimization prevents them from
@@ -267,6 +316,8 @@ const FileEntry *HeaderSearch::LookupFile(llvm::StringRef Filename,
   // If the entry has been previously looked up, the first value will be
   // non-zero.  If the value is equal to i (the start point of our search), then
   // this is a matching hit.
+  bool RecordInPersistentCache = false;
+  unsigned PersistentIdx = ~0U;
   if (CacheLookup.first == i+1) {
     // Skip querying potentially lots of directories for this lookup.
     i = CacheLookup.second;
@@ -275,6 +326,21 @@ const FileEntry *HeaderSearch::LookupFile(llvm::StringRef Filename,
     // our search start.  We will fill in our found location below, so prime the
     // start point value.
     CacheLookup.first = i+1;
+
+    // If another compilation with the same search paths already performed
+    // this lookup, start at the directory it found the file in.  If the file
+    // has since disappeared from there, the search just continues with the
+    // following directories.
+    if (PersistentLookupCache) {
+      RecordInPersistentCache = true;
+      if (PersistentLookupCache->lookup(Filename, i, PersistentIdx) &&
+          PersistentIdx >= i && PersistentIdx <= SearchDirs.size()) {
+        ++NumPersistentCacheHits;
+        i = PersistentIdx;
+      } else {
+        ++NumPersistentCacheMisses;
+      }
+    }
   }
 
   // Check each directory in sequence to see if it contains this file.
@@ -290,11 +356,15 @@ const FileEntry *HeaderSearch::LookupFile(llvm::StringRef Filename,
 
     // Remember this location for the next lookup we do.
     CacheLookup.second = i;
+    if (RecordInPersistentCache && i != PersistentIdx)
+      PersistentLookupCache->record(Filename, StartIdx, i);
     return FE;
   }
 
   // Otherwise, didn't find it. Remember we didn't find this.
   CacheLookup.second = SearchDirs.size();
+  if (RecordInPersistentCache && PersistentIdx != SearchDirs.size())
+    PersistentLookupCache->record(Filename, StartIdx, SearchDirs.size());
   return 0;
 }
 
@@ -398,6 +468,17 @@ void HeaderSearch::setHeaderFileInfoForUID(HeaderFileInfo HFI, unsigned UID) {
   FileInfo[UID] = HFI;
 }
 
+/// SetFileControllingMacro - Mark the specified file as having a controlling
+/// macro.  This is used by the multiple-include optimization to eliminate
+/// no-op #includes.
+void HeaderSearch::SetFileControllingMacro(const FileEntry *File,
+                                       const IdentifierInfo *ControllingMacro) {
+  getFileInfo(File).ControllingMacro = ControllingMacro;
+
+  if (GuardDatabase)
+    GuardDatabase->record(File, ControllingMacro->getName());
+}
+
 /// ShouldEnterIncludeFile - Mark the specified file as a target of of a
 /// #include, #include_next, or #import directive.  Return false if #including
 /// the file will have no effect or true if we should include it.
@@ -422,12 +503,27 @@ bool HeaderSearch::ShouldEnterIncludeFile(const FileEntry *File, bool isImport){
       return false;
   }
 
+  // If we have never seen this file before, an earlier compilation may still
+  // have found out that it is wrapped with #ifndef guards.
+  bool FromGuardDatabase = false;
+  if (GuardDatabase && !FileInfo.ControllingMacro &&
+      !FileInfo.ControllingMacroID && !FileInfo.NumIncludes) {
+    llvm::StringRef Name = GuardDatabase->lookup(File);
+    if (!Name.empty()) {
+      FileInfo.ControllingMacro = &GuardIdentifiers->get(Name);
+      FromGuardDatabase = true;
+      ++NumGuardDatabaseHits;
+    }
+  }
+
   // Next, check to see if the file is wrapped with #ifndef guards.  If so, and
   // if the macro that guards it is defined, we know the #include has no effect.
   if (const IdentifierInfo *ControllingMacro
       = FileInfo.getControllingMacro(ExternalLookup))
     if (ControllingMacro->hasMacroDefinition()) {
       ++NumMultiIncludeFileOptzn;
+      if (FromGuardDatabase)
+        ++NumGuardDatabaseOptzn;
       return false;
     }
 
@@ -0,0 +1,280 @@
+//===--- HeaderSearchCache.cpp - Persistent #include lookup cache ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the HeaderSearchCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderSearchCache.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Lex/DirectoryLookup.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+using namespace clang;
+using namespace clang::io;
+
+//===----------------------------------------------------------------------===//
+// On-disk hash table traits.
+//===----------------------------------------------------------------------===//
+//
+// The cache file is laid out as follows:
+//
+//   "cfe-hsc" <version:32> <config length:32> <config bytes>
+//   <hash table payload> <hash table buckets> <bucket table offset:32>
+//
+// Keys are a 32-bit start index followed by the filename; the data is the
+// 32-bit index of the directory that satisfied the lookup.
+
+namespace {
+class HeaderSearchCacheTraitBase {
+public:
+  typedef std::pair<unsigned, llvm::StringRef> internal_key_type;
+
+  static unsigned ComputeHash(const internal_key_type &K) {
+    return llvm::HashString(K.second, K.first);
+  }
+};
+
+class HeaderSearchCacheLookupTrait : public HeaderSearchCacheTraitBase {
+public:
+  typedef internal_key_type external_key_type;
+  typedef unsigned data_type;
+
+  static const internal_key_type &GetInternalKey(const external_key_type &K) {
+    return K;
+  }
+
+  static bool EqualKey(const internal_key_type &A, const internal_key_type &B){
+    return A.first == B.first && A.second == B.second;
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = ReadUnalignedLE16(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    assert(n >= 4 && "Malformed key");
+    unsigned StartIdx = ReadUnalignedLE32(d);
+    return std::make_pair(StartIdx, llvm::StringRef((const char*) d, n - 4));
+  }
+
+  static data_type ReadData(const internal_key_type &, const unsigned char *d,
+                            unsigned) {
+    return ReadUnalignedLE32(d);
+  }
+};
+
+class HeaderSearchCacheWriterTrait : public HeaderSearchCacheTraitBase {
+public:
+  typedef internal_key_type key_type;
+  typedef const key_type &key_type_ref;
+  typedef unsigned data_type;
+  typedef unsigned data_type_ref;
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(llvm::raw_ostream &Out, key_type_ref K, data_type_ref) {
+    unsigned KeyLen = 4 + K.second.size();
+    Emit16(Out, KeyLen);
+    Emit16(Out, 4);
+    return std::make_pair(KeyLen, 4);
+  }
+
+  static void EmitKey(llvm::raw_ostream &Out, key_type_ref K, unsigned) {
+    Emit32(Out, K.first);
+    Out.write(K.second.data(), K.second.size());
+  }
+
+  static void EmitData(llvm::raw_ostream &Out, key_type_ref, data_type_ref D,
+                       unsigned) {
+    Emit32(Out, D);
+  }
+};
+} // end anonymous namespace
+
+typedef OnDiskChainedHashTable<HeaderSearchCacheLookupTrait>
+  HeaderSearchCacheTable;
+
+/// MakeEntryKey - Form the key used for NewEntries.
+static std::string MakeEntryKey(unsigned StartIdx, llvm::StringRef Filename) {
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  Emit32(OS, StartIdx);
+  OS << Filename;
+  return OS.str();
+}
+
+//===----------------------------------------------------------------------===//
+// HeaderSearchCache Implementation
+//===----------------------------------------------------------------------===//
+
+HeaderSearchCache::HeaderSearchCache(llvm::StringRef Path,
+                                     llvm::StringRef Config)
+  : Table(0), Configuration(Config) {
+  Buf.reset(llvm::MemoryBuffer::getFile(Path.str().c_str()));
+  if (!Buf)
+    return;
+
+  const unsigned char *BufBeg = (const unsigned char*) Buf->getBufferStart();
+  const unsigned char *BufEnd = (const unsigned char*) Buf->getBufferEnd();
+  const unsigned MagicLen = sizeof("cfe-hsc") - 1;
+
+  // Check the prologue and the configuration the file was written for.  A
+  // stale or damaged cache is simply ignored; it will be rewritten.
+  if (BufEnd - BufBeg < (signed) (MagicLen + 4 + 4 + 4) ||
+      memcmp(BufBeg, "cfe-hsc", MagicLen) != 0) {
+    Buf.reset();
+    return;
+  }
+
+  const unsigned char *p = BufBeg + MagicLen;
+  unsigned FileVersion = ReadUnalignedLE32(p);
+  unsigned ConfigLen = ReadUnalignedLE32(p);
+  if (FileVersion != Version || ConfigLen > (unsigned) (BufEnd - p - 4) ||
+      llvm::StringRef((const char*) p, ConfigLen) != Configuration) {
+    Buf.reset();
+    return;
+  }
+
+  const unsigned char *Trailer = BufEnd - 4;
+  unsigned TableOff = ReadUnalignedLE32(Trailer);
+  const unsigned char *Buckets = BufBeg + TableOff;
+  if (Buckets <= p + ConfigLen || Buckets + 8 > BufEnd - 4 ||
+      ((uintptr_t) Buckets & 0x3) != 0) {
+    Buf.reset();
+    return;
+  }
+
+  Table = HeaderSearchCacheTable::Create(Buckets, BufBeg);
+}
+
+HeaderSearchCache::~HeaderSearchCache() {
+  delete (HeaderSearchCacheTable*) Table;
+}
+
+std::string
+HeaderSearchCache::ComputeConfiguration(
+                               const std::vector<DirectoryLookup> &SearchDirs,
+                               unsigned SystemDirIdx) {
+  std::string Result;
+  llvm::raw_string_ostream OS(Result);
+
+  // Relative search directories mean different things in different working
+  // directories.
+  OS << llvm::sys::Path::GetCurrentDirectory().str() << '\0';
+  OS << SystemDirIdx << '\0';
+
+  for (unsigned i = 0, e = SearchDirs.size(); i != e; ++i) {
+    const DirectoryLookup &DL = SearchDirs[i];
+    OS << (unsigned) DL.getLookupType() << ':'
+       << (unsigned) DL.getDirCharacteristic() << ':' << DL.getName() << ':';
+
+    // The modification time of a directory changes whenever an entry is added
+    // to or removed from it, which is what can change the result of a lookup.
+    struct stat StatBuf;
+    if (::stat(DL.getName(), &StatBuf) == 0)
+      OS << (uint64_t) StatBuf.st_mtime;
+    else
+      OS << '-';
+    OS << '\0';
+  }
+
+  return OS.str();
+}
+
+bool HeaderSearchCache::lookup(llvm::StringRef Filename, unsigned StartIdx,
+                               unsigned &FoundIdx) {
+  if (!Table)
+    return false;
+
+  HeaderSearchCacheTable &T = *(HeaderSearchCacheTable*) Table;
+  HeaderSearchCacheTable::iterator I = T.find(std::make_pair(StartIdx,
+                                                             Filename));
+  if (I == T.end())
+    return false;
+
+  FoundIdx = *I;
+  return true;
+}
+
+void HeaderSearchCache::record(llvm::StringRef Filename, unsigned StartIdx,
+                               unsigned FoundIdx) {
+  NewEntries[MakeEntryKey(StartIdx, Filename)] = FoundIdx;
+}
+
+bool HeaderSearchCache::Write(llvm::StringRef Path) {
+  OnDiskChainedHashTableGenerator<HeaderSearchCacheWriterTrait> Generator;
+
+  // Carry over the entries of the on-disk table that this compilation did not
+  // supersede.  The table has no iterator, so walk its buckets directly.
+  if (Table) {
+    HeaderSearchCacheTable &T = *(HeaderSearchCacheTable*) Table;
+    const unsigned char *Bucket = T.getBuckets();
+    for (unsigned i = 0, e = T.getNumBuckets(); i != e; ++i) {
+      unsigned Offset = ReadLE32(Bucket);
+      if (Offset == 0)
+        continue;
+
+      const unsigned char *Items = T.getBase() + Offset;
+      unsigned NumItems = ReadUnalignedLE16(Items);
+      for (unsigned j = 0; j != NumItems; ++j) {
+        Items += 4; // Skip the hash.
+        std::pair<unsigned, unsigned> L =
+          HeaderSearchCacheLookupTrait::ReadKeyDataLength(Items);
+        HeaderSearchCacheLookupTrait::internal_key_type Key =
+          HeaderSearchCacheLookupTrait::ReadKey(Items, L.first);
+        unsigned FoundIdx =
+          HeaderSearchCacheLookupTrait::ReadData(Key, Items + L.first,
+                                                 L.second);
+        Items += L.first + L.second;
+
+        if (!NewEntries.count(MakeEntryKey(Key.first, Key.second)))
+          Generator.insert(Key, FoundIdx);
+      }
+    }
+  }
+
+  for (llvm::StringMap<unsigned>::iterator I = NewEntries.begin(),
+       E = NewEntries.end(); I != E; ++I) {
+    const unsigned char *Key = (const unsigned char*) I->getKeyData();
+    unsigned StartIdx = ReadUnalignedLE32(Key);
+    Generator.insert(std::make_pair(StartIdx,
+                                    llvm::StringRef((const char*) Key,
+                                                    I->getKeyLength() - 4)),
+                     I->getValue());
+  }
+
+  // Write to a temporary file first so that concurrent compilations reading
+  // the cache never see a partially written file.
+  AtomicOutputFile File(Path);
+  std::string ErrMsg;
+  if (File.open(ErrMsg))
+    return true;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << "cfe-hsc";
+  Emit32(Out, Version);
+  Emit32(Out, Configuration.size());
+  Out << Configuration;
+
+  Offset TableOff = Generator.Emit(Out);
+  Emit32(Out, TableOff);
+  if (File.commit(ErrMsg))
+    return true;
+
+  NewEntries.clear();
+  return false;
+}
@@ -29,8 +29,21 @@
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cctype>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
 static void InitCharacterInfo();
@@ -212,6 +225,21 @@ void Lexer::Stringify(llvm::SmallVectorImpl<char> &Str) {
 
 static bool isWhitespace(unsigned char c);
 
+/// getTokenLengthOptions - Summarize the language options that the raw lexer
+/// consults, which are all that the length of a token can depend on, for
+/// keying the token lengths cached by the SourceManager.  An option that the
+/// raw lexer starts to depend on has to be added here.
+static unsigned getTokenLengthOptions(const LangOptions &LangOpts) {
+  return LangOpts.AsmPreprocessor |
+         LangOpts.BCPLComment << 1 |
+         LangOpts.CPlusPlus << 2 |
+         LangOpts.Digraphs << 3 |
+         LangOpts.DollarIdents << 4 |
+         LangOpts.Microsoft << 5 |
+         LangOpts.ObjC1 << 6 |
+         LangOpts.Trigraphs << 7;
+}
+
 /// MeasureTokenLength - Relex the token at the specified location and return
 /// its length in bytes in the input file.  If the token needs cleaning (e.g.
 /// includes a trigraph or an escaped newline) then this count includes bytes
@@ -228,6 +256,11 @@ unsigned Lexer::MeasureTokenLength(SourceLocation Loc,
   // If this comes from a macro expansion, we really do want the macro name, not
   // the token this macro expanded to.
   Loc = SM.getInstantiationLoc(Loc);
+  unsigned Options = getTokenLengthOptions(LangOpts);
+  unsigned Length;
+  if (SM.getCachedTokenLength(Loc, Options, Length))
+    return Length;
+
   std::pair<FileID, unsigned> LocInfo = SM.getDecomposedLoc(Loc);
   std::pair<const char *,const char *> Buffer = SM.getBufferData(LocInfo.first);
   const char *StrData = Buffer.first+LocInfo.second;
@@ -240,6 +273,7 @@ unsigned Lexer::MeasureTokenLength(SourceLocation Loc,
   TheLexer.SetCommentRetentionState(true);
   Token TheTok;
   TheLexer.LexFromRawLexer(TheTok);
+  SM.setCachedTokenLength(Loc, Options, TheTok.getLength());
   return TheTok.getLength();
 }
 
@@ -376,6 +410,165 @@ static inline bool isNumberBody(unsigned char c) {
 }
 
 
+//===----------------------------------------------------------------------===//
+// Vectorized scanning helpers.
+//===----------------------------------------------------------------------===//
+//
+// Each of these routines skips a run of characters 16 bytes at a time and
+// returns a pointer to where the caller should resume its scalar loop.  They
+// never read at or past BufferEnd, so the callers still see the nul terminator
+// and the tail of the buffer through the CharInfo-based loops.  When no vector
+// unit is available they return CurPtr unchanged.
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+/// AllBytesSet - Return true if every lane of the comparison result V is set.
+static inline bool AllBytesSet(uint8x16_t V) {
+  uint64x2_t W = vreinterpretq_u64_u8(V);
+  return (vgetq_lane_u64(W, 0) & vgetq_lane_u64(W, 1)) == ~0ULL;
+}
+#endif
+
+/// SkipIdentifierBodyFast - Skip over [a-zA-Z0-9_] characters starting at
+/// CurPtr.
+static inline const char *SkipIdentifierBodyFast(const char *CurPtr,
+                                                 const char *BufferEnd) {
+#ifdef __SSE4_2__
+  static const char Ranges[16] = "azAZ09__";
+  const __m128i RangeVec = _mm_loadu_si128((const __m128i*)Ranges);
+  while (CurPtr+16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)CurPtr);
+    int Idx = _mm_cmpistri(RangeVec, Chunk, _SIDD_UBYTE_OPS |
+                           _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY);
+    CurPtr += Idx;
+    if (Idx != 16)
+      break;
+  }
+#elif defined(__SSE2__)
+  // Setting bit 0x20 maps [A-Z] onto [a-z] and leaves [a-z] alone, so one
+  // range check covers both cases.  Bytes >= 0x80 compare as negative.
+  const __m128i CaseBit = _mm_set1_epi8(0x20);
+  const __m128i BeforeA = _mm_set1_epi8('a'-1), AfterZ = _mm_set1_epi8('z'+1);
+  const __m128i Before0 = _mm_set1_epi8('0'-1), After9 = _mm_set1_epi8('9'+1);
+  const __m128i Underscore = _mm_set1_epi8('_');
+  while (CurPtr+16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)CurPtr);
+    __m128i Folded = _mm_or_si128(Chunk, CaseBit);
+    __m128i Letter = _mm_and_si128(_mm_cmpgt_epi8(Folded, BeforeA),
+                                   _mm_cmplt_epi8(Folded, AfterZ));
+    __m128i Digit = _mm_and_si128(_mm_cmpgt_epi8(Chunk, Before0),
+                                  _mm_cmplt_epi8(Chunk, After9));
+    __m128i Under = _mm_cmpeq_epi8(Chunk, Underscore);
+    unsigned Mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(Letter, Digit),
+                                                   Under));
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::CountTrailingZeros_32(~Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  const uint8x16_t CaseBit = vdupq_n_u8(0x20);
+  while (CurPtr+16 <= BufferEnd) {
+    uint8x16_t Chunk = vld1q_u8((const uint8_t*)CurPtr);
+    uint8x16_t Folded = vorrq_u8(Chunk, CaseBit);
+    uint8x16_t Letter = vandq_u8(vcgeq_u8(Folded, vdupq_n_u8('a')),
+                                 vcleq_u8(Folded, vdupq_n_u8('z')));
+    uint8x16_t Digit = vandq_u8(vcgeq_u8(Chunk, vdupq_n_u8('0')),
+                                vcleq_u8(Chunk, vdupq_n_u8('9')));
+    uint8x16_t Under = vceqq_u8(Chunk, vdupq_n_u8('_'));
+    if (!AllBytesSet(vorrq_u8(vorrq_u8(Letter, Digit), Under)))
+      break;
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// SkipSpacesAndTabsFast - Skip over ' ' and '\t' characters starting at
+/// CurPtr.  The rarer forms of horizontal whitespace are left to the caller.
+static inline const char *SkipSpacesAndTabsFast(const char *CurPtr,
+                                                const char *BufferEnd) {
+#ifdef __SSE4_2__
+  static const char Blanks[16] = " \t";
+  const __m128i BlankVec = _mm_loadu_si128((const __m128i*)Blanks);
+  while (CurPtr+16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)CurPtr);
+    int Idx = _mm_cmpistri(BlankVec, Chunk, _SIDD_UBYTE_OPS |
+                           _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY);
+    CurPtr += Idx;
+    if (Idx != 16)
+      break;
+  }
+#elif defined(__SSE2__)
+  const __m128i Space = _mm_set1_epi8(' '), Tab = _mm_set1_epi8('\t');
+  while (CurPtr+16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)CurPtr);
+    unsigned Mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(Chunk, Space),
+                                                   _mm_cmpeq_epi8(Chunk, Tab)));
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::CountTrailingZeros_32(~Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  const uint8x16_t Space = vdupq_n_u8(' '), Tab = vdupq_n_u8('\t');
+  while (CurPtr+16 <= BufferEnd) {
+    uint8x16_t Chunk = vld1q_u8((const uint8_t*)CurPtr);
+    if (!AllBytesSet(vorrq_u8(vceqq_u8(Chunk, Space), vceqq_u8(Chunk, Tab))))
+      break;
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// SkipPlainLineChars - Skip over characters that cannot end a line or change
+/// its meaning, stopping at the first nul, '\n', '\r', '\\' (potential
+/// escaped newline) or '?' (potential trigraph).
+static inline const char *SkipPlainLineChars(const char *CurPtr,
+                                             const char *BufferEnd) {
+#ifdef __SSE4_2__
+  // Use the explicit-length form so that an embedded nul is found as a match
+  // instead of terminating the comparison.
+  static const char Stops[16] = { 0, '\\', '?', '\n', '\r' };
+  const __m128i StopVec = _mm_loadu_si128((const __m128i*)Stops);
+  while (CurPtr+16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)CurPtr);
+    int Idx = _mm_cmpestri(StopVec, 5, Chunk, 16,
+                           _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY);
+    CurPtr += Idx;
+    if (Idx != 16)
+      break;
+  }
+#elif defined(__SSE2__)
+  const __m128i Zero = _mm_setzero_si128();
+  const __m128i Backslash = _mm_set1_epi8('\\'), Question = _mm_set1_epi8('?');
+  const __m128i NewLine = _mm_set1_epi8('\n'), Return = _mm_set1_epi8('\r');
+  while (CurPtr+16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i*)CurPtr);
+    __m128i Stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Chunk, Zero),
+                                             _mm_cmpeq_epi8(Chunk, Backslash)),
+                                _mm_or_si128(_mm_cmpeq_epi8(Chunk, Question),
+                                             _mm_cmpeq_epi8(Chunk, NewLine)));
+    Stop = _mm_or_si128(Stop, _mm_cmpeq_epi8(Chunk, Return));
+    if (unsigned Mask = _mm_movemask_epi8(Stop))
+      return CurPtr + llvm::CountTrailingZeros_32(Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  while (CurPtr+16 <= BufferEnd) {
+    uint8x16_t Chunk = vld1q_u8((const uint8_t*)CurPtr);
+    uint8x16_t Stop = vorrq_u8(vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8(0)),
+                                        vceqq_u8(Chunk, vdupq_n_u8('\\'))),
+                               vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8('?')),
+                                        vceqq_u8(Chunk, vdupq_n_u8('\n'))));
+    Stop = vorrq_u8(Stop, vceqq_u8(Chunk, vdupq_n_u8('\r')));
+    // Any set lane means the 16 bytes are not all plain characters.
+    if (!AllBytesSet(vmvnq_u8(Stop)))
+      break;
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
 //===----------------------------------------------------------------------===//
 // Diagnostics forwarding code.
 //===----------------------------------------------------------------------===//
@@ -646,6 +839,7 @@ Slash:
 void Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = SkipIdentifierBodyFast(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -868,6 +1062,8 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr) {
   unsigned char Char = *CurPtr;  // Skip consequtive spaces efficiently.
   while (1) {
     // Skip horizontal whitespace very aggressively.
+    CurPtr = SkipSpacesAndTabsFast(CurPtr, BufferEnd);
+    Char = *CurPtr;
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -926,12 +1122,9 @@ bool Lexer::SkipBCPLComment(Token &Result, const char *CurPtr) {
   // them.  As such, optimize for this case with the inner loop.
   char C;
   do {
-    C = *CurPtr;
-    // FIXME: Speedup BCPL comment lexing.  Just scan for a \n or \r character.
-    // If we find a \n character, scan backwards, checking to see if it's an
-    // escaped newline, like we do for block comments.
-
     // Skip over characters in the fast loop.
+    CurPtr = SkipPlainLineChars(CurPtr, BufferEnd);
+    C = *CurPtr;
     while (C != 0 &&                // Potentially EOF.
            C != '\\' &&             // Potentially escaped newline.
            C != '?' &&              // Potentially trigraph.
@@ -1104,13 +1297,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// SkipBlockComment - We have just read the /* characters from input.  Read
 /// until we find the */ characters that terminate the comment.  Note that we
 /// don't bother decoding trigraphs or escaped newlines in block comments,
@@ -1281,6 +1467,11 @@ std::string Lexer::ReadToEndOfLine() {
   // CurPtr - Cache BufferPtr in an automatic variable.
   const char *CurPtr = BufferPtr;
   while (1) {
+    // Copy runs of characters that need no decoding in one go.
+    const char *RunEnd = SkipPlainLineChars(CurPtr, BufferEnd);
+    Result.append(CurPtr, RunEnd);
+    CurPtr = RunEnd;
+
     char Char = getAndAdvanceChar(CurPtr, Tmp);
     switch (Char) {
     default:
@@ -1310,6 +1501,157 @@ std::string Lexer::ReadToEndOfLine() {
   }
 }
 
+/// isPossibleDirectiveLine - Return true if the line starting at LinePtr
+/// could hold a preprocessor directive: its first non-blank character is a
+/// '#', or something that the lexer could skip over on the way to one (a
+/// comment, an escaped newline, a digraph, a trigraph or a null).
+static bool isPossibleDirectiveLine(const char *LinePtr,
+                                    const char *BufferEnd) {
+  while (isHorizontalWhitespace(*LinePtr))
+    ++LinePtr;
+
+  switch (*LinePtr) {
+  case '#':
+  case '%':
+  case '/':
+  case '\\':
+  case '?':
+    return true;
+  case 0:
+    return LinePtr != BufferEnd;
+  default:
+    return false;
+  }
+}
+
+/// SkipExcludedLines - Advance past the text of a skipped conditional block
+/// without forming tokens, stopping at the start of the first line that could
+/// hold a preprocessor directive.  Comments, string and character literals and
+/// escaped newlines are tracked so that the scan never steps over a '#' that
+/// the lexer would see at the start of a line.  Whenever something cannot be
+/// handled exactly, the lexer is left at the last position known to be right.
+void Lexer::SkipExcludedLines() {
+  assert(LexingRawMode && !ParsingPreprocessorDirective &&
+         "Can only skip excluded text in raw mode, between tokens!");
+
+  // Trigraphs can spell '#' and '\'; leave them to the lexer.
+  if (Features.Trigraphs)
+    return;
+
+  if (IsAtStartOfLine && isPossibleDirectiveLine(BufferPtr, BufferEnd))
+    return;
+
+  // SafePtr is the last position that the lexer can resume from, and
+  // SafeAtStartOfLine is the value that IsAtStartOfLine should have there.
+  const char *SafePtr = BufferPtr;
+  bool SafeAtStartOfLine = IsAtStartOfLine;
+
+  const char *CurPtr = BufferPtr;
+  while (CurPtr != BufferEnd) {
+    char Char = *CurPtr;
+    switch (Char) {
+    case '\n':
+    case '\r':
+      // Skip the newline, treating \r\n and \n\r as one.
+      ++CurPtr;
+      if ((*CurPtr == '\n' || *CurPtr == '\r') && *CurPtr != Char)
+        ++CurPtr;
+
+      // The start of a line is a point that the lexer can resume from.
+      SafePtr = CurPtr;
+      SafeAtStartOfLine = true;
+      if (isPossibleDirectiveLine(CurPtr, BufferEnd))
+        goto Done;
+      break;
+
+    case '\\':
+      // An escaped newline joins the next line onto this one.
+      if (unsigned Size = getEscapedNewLineSize(CurPtr+1))
+        CurPtr += Size+1;
+      else
+        ++CurPtr;
+      break;
+
+    case '"':
+    case '\'':
+      // Skip a string or character literal, which ends at the matching quote
+      // or at the end of the line.
+      ++CurPtr;
+      while (CurPtr != BufferEnd && *CurPtr != Char &&
+             *CurPtr != '\n' && *CurPtr != '\r') {
+        if (*CurPtr == '\\') {
+          if (unsigned Size = getEscapedNewLineSize(CurPtr+1)) {
+            CurPtr += Size+1;
+            continue;
+          }
+          // Skip the escaped character, which may itself follow escaped
+          // newlines.
+          ++CurPtr;
+          while (*CurPtr == '\\')
+            if (unsigned Size = getEscapedNewLineSize(CurPtr+1))
+              CurPtr += Size+1;
+            else
+              break;
+          if (CurPtr == BufferEnd)
+            break;
+        }
+        ++CurPtr;
+      }
+      if (CurPtr != BufferEnd && *CurPtr == Char)
+        ++CurPtr;
+      break;
+
+    case '/':
+      // An escaped newline could join the characters of "//" or "/*", or
+      // hide the '*' that makes "//*" a '/' in C89.
+      if (CurPtr[1] == '\\' ||
+          (CurPtr[1] == '/' && !Features.BCPLComment && CurPtr[2] == '\\'))
+        goto Done;
+
+      if (CurPtr[1] == '/' && (Features.BCPLComment || CurPtr[2] != '*')) {
+        // Skip a // comment, which escaped newlines may continue.
+        CurPtr += 2;
+        while (CurPtr != BufferEnd && *CurPtr != '\n' && *CurPtr != '\r') {
+          if (*CurPtr == '\\')
+            if (unsigned Size = getEscapedNewLineSize(CurPtr+1)) {
+              CurPtr += Size+1;
+              continue;
+            }
+          ++CurPtr;
+        }
+        break;
+      }
+
+      if (CurPtr[1] == '*') {
+        // Skip a block comment.  An escaped newline could hide its end, so
+        // leave comments containing one to the lexer.
+        const char *CommentPtr = CurPtr+2;
+        while (CommentPtr != BufferEnd &&
+               (CommentPtr[0] != '*' || CommentPtr[1] != '/')) {
+          if (*CommentPtr == '\\' && getEscapedNewLineSize(CommentPtr+1))
+            goto Done;
+          ++CommentPtr;
+        }
+        if (CommentPtr == BufferEnd)
+          goto Done;
+        CurPtr = CommentPtr+2;
+        break;
+      }
+
+      ++CurPtr;
+      break;
+
+    default:
+      ++CurPtr;
+      break;
+    }
+  }
+
+Done:
+  BufferPtr = SafePtr;
+  IsAtStartOfLine = SafeAtStartOfLine;
+}
+
 /// LexEndOfFile - CurPtr points to the end of this file.  Handle this
 /// condition, reporting diagnostics and handling other edge cases as required.
 /// This returns true if Result contains a token, false if PP.Lex should be
@@ -1522,6 +1864,8 @@ LexNextToken:
   // Small amounts of horizontal whitespace is very common between tokens.
   if ((*CurPtr == ' ') || (*CurPtr == '\t')) {
     ++CurPtr;
+    if ((*CurPtr == ' ') || (*CurPtr == '\t'))
+      CurPtr = SkipSpacesAndTabsFast(CurPtr, BufferEnd);
     while ((*CurPtr == ' ') || (*CurPtr == '\t'))
       ++CurPtr;
 
@@ -18,6 +18,7 @@
 #include "clang/Basic/TargetInfo.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringExtras.h"
+#include <cstring>
 using namespace clang;
 
 /// HexDigitValue - Return the value of the specified hex digit, or -1 if it's
@@ -744,25 +745,28 @@ CharLiteralParser::CharLiteralParser(const char *begin, const char *end,
 StringLiteralParser::
 StringLiteralParser(const Token *StringToks, unsigned NumStringToks,
                     Preprocessor &pp) : PP(pp) {
-  // Scan all of the string portions, remember the max individual token length,
-  // computing a bound on the concatenated string length, and see whether any
-  // piece is a wide-string.  If any of the string portions is a wide-string
-  // literal, the result is a wide-string literal [C99 6.4.5p4].
-  MaxTokenLength = StringToks[0].getLength();
-  SizeBound = StringToks[0].getLength()-2;  // -2 for "".
-  AnyWide = StringToks[0].is(tok::wide_string_literal);
+  // Scan all of the string portions, remember the max length of the tokens
+  // that need cleaning, computing a bound on the concatenated string length,
+  // and see whether any piece is a wide-string.  If any of the string portions
+  // is a wide-string literal, the result is a wide-string literal
+  // [C99 6.4.5p4].
+  MaxTokenLength = 0;
+  SizeBound = 0;
+  AnyWide = false;
 
   hadError = false;
 
   // Implement Translation Phase #6: concatenation of string literals
   /// (C99 5.1.1.2p1).  The common case is only one string fragment.
-  for (unsigned i = 1; i != NumStringToks; ++i) {
+  for (unsigned i = 0; i != NumStringToks; ++i) {
     // The string could be shorter than this if it needs cleaning, but this is a
     // reasonable bound, which is all we need.
     SizeBound += StringToks[i].getLength()-2;  // -2 for "".
 
-    // Remember maximum string piece length.
-    if (StringToks[i].getLength() > MaxTokenLength)
+    // Remember maximum length of the pieces that have to be copied to be
+    // cleaned; the spelling of the others is used in place.
+    if (StringToks[i].needsCleaning() &&
+        StringToks[i].getLength() > MaxTokenLength)
       MaxTokenLength = StringToks[i].getLength();
 
     // Remember if we see any wide strings.
@@ -788,10 +792,11 @@ StringLiteralParser(const Token *StringToks, unsigned NumStringToks,
   if (AnyWide)
     SizeBound *= wchar_tByteWidth;
 
-  // Size the temporary buffer to hold the result string data.
+  // Size the temporary buffer to hold the result string data.  This is the
+  // only allocation, however many pieces there are.
   ResultBuf.resize(SizeBound);
 
-  // Likewise, but for each string piece.
+  // Likewise, but for the string pieces that need cleaning.
   llvm::SmallString<512> TokenBuf;
   TokenBuf.resize(MaxTokenLength);
 
@@ -802,10 +807,11 @@ StringLiteralParser(const Token *StringToks, unsigned NumStringToks,
   Pascal = false;
 
   for (unsigned i = 0, e = NumStringToks; i != e; ++i) {
-    const char *ThisTokBuf = &TokenBuf[0];
+    const char *ThisTokBuf = TokenBuf.begin();
     // Get the spelling of the token, which eliminates trigraphs, etc.  We know
     // that ThisTokBuf points to a buffer that is big enough for the whole token
-    // and 'spelled' tokens can only shrink.
+    // if it needs cleaning, and 'spelled' tokens can only shrink.  Otherwise,
+    // ThisTokBuf is pointed at the token in the source buffer.
     unsigned ThisTokLen = PP.getSpelling(StringToks[i], ThisTokBuf);
     const char *ThisTokEnd = ThisTokBuf+ThisTokLen-1;  // Skip end quote.
 
@@ -837,10 +843,13 @@ StringLiteralParser(const Token *StringToks, unsigned NumStringToks,
     while (ThisTokBuf != ThisTokEnd) {
       // Is this a span of non-escape characters?
       if (ThisTokBuf[0] != '\\') {
+        // Find the end of the span with memchr, which is much faster than a
+        // byte loop on the long escape-free runs of generated string tables.
         const char *InStart = ThisTokBuf;
-        do {
-          ++ThisTokBuf;
-        } while (ThisTokBuf != ThisTokEnd && ThisTokBuf[0] != '\\');
+        ThisTokBuf = static_cast<const char *>(
+                       memchr(InStart, '\\', ThisTokEnd-InStart));
+        if (!ThisTokBuf)
+          ThisTokBuf = ThisTokEnd;
 
         // Copy the character span over.
         unsigned Len = ThisTokBuf-InStart;
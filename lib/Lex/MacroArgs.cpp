@@ -15,6 +15,7 @@
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/LexDiagnostic.h"
+#include "llvm/Support/MathExtras.h"
 using namespace clang;
 
 /// MacroArgs ctor function - This destroys the vector passed in.
@@ -24,36 +25,27 @@ MacroArgs *MacroArgs::create(const MacroInfo *MI,
                              Preprocessor &PP) {
   assert(MI->isFunctionLike() &&
          "Can't have args for an object-like macro!");
-  MacroArgs **ResultEnt = 0;
-  unsigned ClosestMatch = ~0U;
-  
-  // See if we have an entry with a big enough argument list to reuse on the
-  // free list.  If so, reuse it.
-  for (MacroArgs **Entry = &PP.MacroArgCache; *Entry;
-       Entry = &(*Entry)->ArgCache)
-    if ((*Entry)->NumUnexpArgTokens >= NumToks &&
-        (*Entry)->NumUnexpArgTokens < ClosestMatch) {
-      ResultEnt = Entry;
-      
-      // If we have an exact match, use it.
-      if ((*Entry)->NumUnexpArgTokens == NumToks)
-        break;
-      // Otherwise, use the best fit.
-      ClosestMatch = (*Entry)->NumUnexpArgTokens;
-    }
-  
-  MacroArgs *Result;
-  if (ResultEnt == 0) {
+  // Round the number of tokens up to a power of two; every object in that
+  // bucket of the free list is big enough.
+  unsigned Bucket = NumToks <= 1 ? 0 : llvm::Log2_32_Ceil(NumToks);
+  assert(Bucket < Preprocessor::NumMacroArgBuckets && "Too many tokens!");
+
+  MacroArgs *Result = PP.MacroArgCache[Bucket];
+  if (Result == 0) {
     // Allocate memory for a MacroArgs object with the lexer tokens at the end.
-    Result = (MacroArgs*)malloc(sizeof(MacroArgs) + NumToks*sizeof(Token));
+    unsigned Capacity = 1U << Bucket;
+    Result = (MacroArgs*)PP.MacroArgAllocator.Allocate(sizeof(MacroArgs) +
+                                                       Capacity*sizeof(Token),
+                                                  llvm::alignof<MacroArgs>());
     // Construct the MacroArgs object.
-    new (Result) MacroArgs(NumToks, VarargsElided);
+    new (Result) MacroArgs(NumToks, Bucket, VarargsElided);
+    ++PP.NumMacroArgsAllocated;
   } else {
-    Result = *ResultEnt;
     // Unlink this node from the preprocessors singly linked list.
-    *ResultEnt = Result->ArgCache;
+    PP.MacroArgCache[Bucket] = Result->ArgCache;
     Result->NumUnexpArgTokens = NumToks;
     Result->VarargsElided = VarargsElided;
+    ++PP.NumMacroArgsReused;
   }
 
   // Copy the actual unexpanded tokens to immediately after the result ptr.
@@ -75,8 +67,8 @@ void MacroArgs::destroy(Preprocessor &PP) {
     PreExpArgTokens[i].clear();
   
   // Add this to the preprocessor's free list.
-  ArgCache = PP.MacroArgCache;
-  PP.MacroArgCache = this;
+  ArgCache = PP.MacroArgCache[Bucket];
+  PP.MacroArgCache[Bucket] = this;
 }
 
 /// deallocate - This should only be called by the Preprocessor when managing
@@ -84,10 +76,9 @@ void MacroArgs::destroy(Preprocessor &PP) {
 MacroArgs *MacroArgs::deallocate() {
   MacroArgs *Next = ArgCache;
   
-  // Run the dtor to deallocate the vectors.
+  // Run the dtor to deallocate the vectors.  The memory for the object itself
+  // is owned by the preprocessor's MacroArgAllocator.
   this->~MacroArgs();
-  // Release the memory for the object.
-  free(this);
   
   return Next;
 }
@@ -30,6 +30,10 @@ class MacroArgs {
   /// concatenated together, with 'EOF' markers at the end of each argument.
   unsigned NumUnexpArgTokens;
 
+  /// Bucket - The Preprocessor::MacroArgCache bucket this object belongs to.
+  /// There is room for 2^Bucket unexpanded tokens after the object.
+  unsigned Bucket;
+
   /// VarargsElided - True if this is a C99 style varargs macro invocation and
   /// there was no argument specified for the "..." argument.  If the argument
   /// was specified (even empty) or this isn't a C99 style varargs function, or
@@ -47,11 +51,13 @@ class MacroArgs {
   std::vector<Token> StringifiedArgs;
 
   /// ArgCache - This is a linked list of MacroArgs objects that the
-  /// Preprocessor owns which we use to avoid thrashing malloc/free.
+  /// Preprocessor owns which we use to avoid thrashing malloc/free.  The
+  /// vectors above keep their storage while the object sits on the list.
   MacroArgs *ArgCache;
   
-  MacroArgs(unsigned NumToks, bool varargsElided)
-    : NumUnexpArgTokens(NumToks), VarargsElided(varargsElided), ArgCache(0) {}
+  MacroArgs(unsigned NumToks, unsigned bucket, bool varargsElided)
+    : NumUnexpArgTokens(NumToks), Bucket(bucket), VarargsElided(varargsElided),
+      ArgCache(0) {}
   ~MacroArgs() {}
 public:
   /// MacroArgs ctor function - Create a new MacroArgs object with the specified
@@ -13,6 +13,7 @@
 
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Basic/SourceManager.h"
 using namespace clang;
 
 MacroInfo::MacroInfo(SourceLocation DefLoc) : Location(DefLoc) {
@@ -20,11 +21,35 @@ MacroInfo::MacroInfo(SourceLocation DefLoc) : Location(DefLoc) {
   IsC99Varargs = false;
   IsGNUVarargs = false;
   IsBuiltinMacro = false;
+  IsDefinitionLengthCached = false;
   IsDisabled = false;
   IsUsed = true;
 
   ArgumentList = 0;
   NumArguments = 0;
+  DefinitionLength = 0;
+}
+
+unsigned MacroInfo::getDefinitionLengthSlow(SourceManager &SM) const {
+  assert(!IsDefinitionLengthCached && "Definition length already computed!");
+  IsDefinitionLengthCached = true;
+  DefinitionLength = 0;
+
+  if (ReplacementTokens.empty())
+    return 0;
+
+  // The replacement list can only be described by a single range of source
+  // locations if its first and last tokens come from the same file.
+  SourceLocation StartLoc = ReplacementTokens.front().getLocation();
+  SourceLocation LastLoc = ReplacementTokens.back().getLocation();
+  if (!StartLoc.isFileID() || !LastLoc.isFileID() ||
+      LastLoc.getRawEncoding() < StartLoc.getRawEncoding() ||
+      SM.getFileID(StartLoc) != SM.getFileID(LastLoc))
+    return 0;
+
+  DefinitionLength = LastLoc.getRawEncoding() - StartLoc.getRawEncoding() +
+                     ReplacementTokens.back().getLength();
+  return DefinitionLength;
 }
 
 /// isIdenticalTo - Return true if the specified macro definition is equal to
@@ -67,7 +92,7 @@ bool MacroInfo::isIdenticalTo(const MacroInfo &Other, Preprocessor &PP) const {
     }
 
     // Otherwise, check the spelling.
-    if (PP.getSpelling(A) != PP.getSpelling(B))
+    if (PP.getSpellingRef(A) != PP.getSpellingRef(B))
       return false;
   }
 
@@ -24,6 +24,8 @@ using namespace clang;
 /// be called multiple times and CommitBacktrackedTokens/Backtrack calls will
 /// be combined with the EnableBacktrackAtThisPos calls in reverse order.
 void Preprocessor::EnableBacktrackAtThisPos() {
+  if (!isBacktrackEnabled())
+    TrimCachedTokens();
   BacktrackPositions.push_back(CachedLexPos);
   EnterCachingLexMode();
 }
@@ -40,10 +42,28 @@ void Preprocessor::CommitBacktrackedTokens() {
 void Preprocessor::Backtrack() {
   assert(!BacktrackPositions.empty()
          && "EnableBacktrackAtThisPos was not called!");
+  ++NumBacktracks;
+  NumBacktrackedTokens += CachedLexPos - BacktrackPositions.back();
   CachedLexPos = BacktrackPositions.back();
   BacktrackPositions.pop_back();
 }
 
+/// TrimCachedTokens - Drop the cached tokens before CachedLexPos, which can
+/// no longer be re-lexed once backtracking is disabled.  Otherwise, while a
+/// lookahead token stays cached between tentative parses, the tokens of
+/// every earlier tentative parse are kept too.  The tokens still to be lexed
+/// are moved to the front, so this waits until they are outnumbered by the
+/// dead ones.
+void Preprocessor::TrimCachedTokens() {
+  assert(!isBacktrackEnabled() && "Cached tokens are still needed!");
+  if (CachedLexPos == 0 || CachedLexPos < CachedTokens.size() - CachedLexPos)
+    return;
+
+  CachedTokens.erase(CachedTokens.begin(),
+                     CachedTokens.begin() + CachedLexPos);
+  CachedLexPos = 0;
+}
+
 void Preprocessor::CachingLex(Token &Result) {
   if (CachedLexPos < CachedTokens.size()) {
     Result = CachedTokens[CachedLexPos++];
@@ -57,6 +77,7 @@ void Preprocessor::CachingLex(Token &Result) {
     // All cached tokens were consumed.
     CachedTokens.clear();
     CachedLexPos = 0;
+    DisambiguationMemo.clear();
     return;
   }
 
@@ -66,6 +87,7 @@ void Preprocessor::CachingLex(Token &Result) {
   if (Result.isNot(tok::eof)) {
     CachedTokens.push_back(Result);
     ++CachedLexPos;
+    noteCachedTokens();
   }
 }
 
@@ -79,11 +101,14 @@ void Preprocessor::EnterCachingLexMode() {
 
 const Token &Preprocessor::PeekAhead(unsigned N) {
   assert(CachedLexPos + N > CachedTokens.size() && "Confused caching.");
+  if (!isBacktrackEnabled())
+    TrimCachedTokens();
   ExitCachingLexMode();
   for (unsigned C = CachedLexPos + N - CachedTokens.size(); C > 0; --C) {
     CachedTokens.push_back(Token());
     Lex(CachedTokens.back());
   }
+  noteCachedTokens();
   EnterCachingLexMode();
   return CachedTokens.back();
 }
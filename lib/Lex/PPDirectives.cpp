@@ -71,7 +71,7 @@ void Preprocessor::ReadMacroName(Token &MacroNameTok, char isDefineUndef) {
 
   IdentifierInfo *II = MacroNameTok.getIdentifierInfo();
   if (II == 0) {
-    std::string Spelling = getSpelling(MacroNameTok);
+    llvm::StringRef Spelling = getSpellingRef(MacroNameTok);
     const IdentifierInfo &Info = Identifiers.get(Spelling);
     if (Info.isCPlusPlusOperatorKeyword())
       // C++ 2.5p2: Alternative tokens behave the same as its primary token
@@ -160,6 +160,8 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
   CurPPLexer->LexingRawMode = true;
   Token Tok;
   while (1) {
+    // Jump over the lines that cannot hold a directive without lexing them.
+    CurLexer->SkipExcludedLines();
     CurLexer->Lex(Tok);
 
     // If this is the end of the buffer, we have an error.
@@ -217,21 +219,16 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
     // Get the identifier name without trigraphs or embedded newlines.  Note
     // that we can't use Tok.getIdentifierInfo() because its lookup is disabled
     // when skipping.
-    char DirectiveBuf[20];
     llvm::StringRef Directive;
-    if (!Tok.needsCleaning() && Tok.getLength() < 20) {
+    if (!Tok.needsCleaning())
       Directive = llvm::StringRef(RawCharData, Tok.getLength());
-    } else {
-      std::string DirectiveStr = getSpelling(Tok);
-      unsigned IdLen = DirectiveStr.size();
-      if (IdLen >= 20) {
-        CurPPLexer->ParsingPreprocessorDirective = false;
-        // Restore comment saving mode.
-        if (CurLexer) CurLexer->SetCommentRetentionState(KeepComments);
-        continue;
-      }
-      memcpy(DirectiveBuf, &DirectiveStr[0], IdLen);
-      Directive = llvm::StringRef(DirectiveBuf, IdLen);
+    else
+      Directive = getSpellingRef(Tok);
+    if (Directive.size() >= 20) {
+      CurPPLexer->ParsingPreprocessorDirective = false;
+      // Restore comment saving mode.
+      if (CurLexer) CurLexer->SetCommentRetentionState(KeepComments);
+      continue;
     }
 
     if (Directive.startswith("if")) {
@@ -1516,6 +1513,9 @@ void Preprocessor::HandleIfdefDirective(Token &Result, bool isIfndef,
 
   IdentifierInfo *MII = MacroNameTok.getIdentifierInfo();
   MacroInfo *MI = getMacroInfo(MII);
+
+  if (Callbacks)
+    Callbacks->MacroTested(MacroNameTok, MI);
   
   if (CurPPLexer->getConditionalStackDepth() == 0) {
     // If the start of a top-level #ifdef and if the macro is not defined,
@@ -104,6 +104,9 @@ static bool EvaluateDefined(PPValue &Result, Token &PeekTok, DefinedTracker &DT,
     Macro->setIsUsed(true);
   }
 
+  if (ValueLive && PP.getPPCallbacks())
+    PP.getPPCallbacks()->MacroTested(PeekTok, PP.getMacroInfo(II));
+
   // Consume identifier.
   Result.setEnd(PeekTok.getLocation());
   PP.LexNonComment(PeekTok);
@@ -150,8 +153,11 @@ static bool EvaluateValue(PPValue &Result, Token &PeekTok, DefinedTracker &DT,
     // preprocessor keywords and it wasn't macro expanded, it turns
     // into a simple 0, unless it is the C++ keyword "true", in which case it
     // turns into "1".
-    if (ValueLive)
+    if (ValueLive) {
       PP.Diag(PeekTok, diag::warn_pp_undef_identifier) << II;
+      if (PeekTok.is(tok::identifier) && PP.getPPCallbacks())
+        PP.getPPCallbacks()->MacroTested(PeekTok, 0);
+    }
     Result.Val = II->getTokenID() == tok::kw_true;
     Result.Val.setIsUnsigned(false);  // "0" is signed intmax_t 0.
     Result.setRange(PeekTok.getLocation());
@@ -169,11 +175,8 @@ static bool EvaluateValue(PPValue &Result, Token &PeekTok, DefinedTracker &DT,
     PP.Diag(PeekTok, diag::err_pp_expected_value_in_expr);
     return true;
   case tok::numeric_constant: {
-    llvm::SmallString<64> IntegerBuffer;
-    IntegerBuffer.resize(PeekTok.getLength());
-    const char *ThisTokBegin = &IntegerBuffer[0];
-    unsigned ActualLength = PP.getSpelling(PeekTok, ThisTokBegin);
-    NumericLiteralParser Literal(ThisTokBegin, ThisTokBegin+ActualLength,
+    llvm::StringRef Spelling = PP.getSpellingRef(PeekTok);
+    NumericLiteralParser Literal(Spelling.begin(), Spelling.end(),
                                  PeekTok.getLocation(), PP);
     if (Literal.hadError)
       return true; // a diagnostic was already reported.
@@ -217,11 +220,8 @@ static bool EvaluateValue(PPValue &Result, Token &PeekTok, DefinedTracker &DT,
     return false;
   }
   case tok::char_constant: {   // 'x'
-    llvm::SmallString<32> CharBuffer;
-    CharBuffer.resize(PeekTok.getLength());
-    const char *ThisTokBegin = &CharBuffer[0];
-    unsigned ActualLength = PP.getSpelling(PeekTok, ThisTokBegin);
-    CharLiteralParser Literal(ThisTokBegin, ThisTokBegin+ActualLength,
+    llvm::StringRef Spelling = PP.getSpellingRef(PeekTok);
+    CharLiteralParser Literal(Spelling.begin(), Spelling.end(),
                               PeekTok.getLocation(), PP);
     if (Literal.hadError())
       return true;  // A diagnostic was already emitted.
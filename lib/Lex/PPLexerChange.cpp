@@ -16,6 +16,8 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/LexDiagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/Support/MemoryBuffer.h"
 using namespace clang;
@@ -62,6 +64,18 @@ PreprocessorLexer *Preprocessor::getCurrentFileLexer() const {
 // Methods for Entering and Callbacks for leaving various contexts
 //===----------------------------------------------------------------------===//
 
+/// EnterSourceFilePhase - Start a phase for the file \arg FID, if phase
+/// statistics are enabled, so the time spent on each header is recorded.
+static void EnterSourceFilePhase(SourceManager &SM, FileID FID) {
+  if (PhaseStatistics *Stats = PhaseStatistics::getActive()) {
+    if (const FileEntry *FE = SM.getFileEntryForID(FID))
+      Stats->enterPhase("Source file", FE->getName());
+    else
+      Stats->enterPhase("Source file",
+                        SM.getBuffer(FID)->getBufferIdentifier());
+  }
+}
+
 /// EnterSourceFile - Add a source file to the top of the include stack and
 /// start lexing tokens from it instead of the current buffer.
 bool Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
@@ -75,6 +89,7 @@ bool Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
   if (PTH) {
     if (PTHLexer *PL = PTH->CreateLexer(FID)) {
       EnterSourceFileWithPTH(PL, CurDir);
+      EnterSourceFilePhase(SourceMgr, FID);
       return false;
     }
   }
@@ -86,6 +101,7 @@ bool Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
     return true;
   
   EnterSourceFileWithLexer(new Lexer(FID, InputFile, *this), CurDir);
+  EnterSourceFilePhase(SourceMgr, FID);
   return false;
 }
 
@@ -141,11 +157,14 @@ void Preprocessor::EnterMacro(Token &Tok, SourceLocation ILEnd,
   PushIncludeMacroStack();
   CurDirLookup = 0;
 
-  if (NumCachedTokenLexers == 0) {
+  if (TokenLexerCache.empty()) {
     CurTokenLexer.reset(new TokenLexer(Tok, ILEnd, Args, *this));
+    ++NumTokenLexersAllocated;
   } else {
-    CurTokenLexer.reset(TokenLexerCache[--NumCachedTokenLexers]);
+    CurTokenLexer.reset(TokenLexerCache.back());
+    TokenLexerCache.pop_back();
     CurTokenLexer->Init(Tok, ILEnd, Args);
+    ++NumTokenLexersReused;
   }
 }
 
@@ -169,12 +188,15 @@ void Preprocessor::EnterTokenStream(const Token *Toks, unsigned NumToks,
   CurDirLookup = 0;
 
   // Create a macro expander to expand from the specified token stream.
-  if (NumCachedTokenLexers == 0) {
+  if (TokenLexerCache.empty()) {
     CurTokenLexer.reset(new TokenLexer(Toks, NumToks, DisableMacroExpansion,
                                        OwnsTokens, *this));
+    ++NumTokenLexersAllocated;
   } else {
-    CurTokenLexer.reset(TokenLexerCache[--NumCachedTokenLexers]);
+    CurTokenLexer.reset(TokenLexerCache.back());
+    TokenLexerCache.pop_back();
     CurTokenLexer->Init(Toks, NumToks, DisableMacroExpansion, OwnsTokens);
+    ++NumTokenLexersReused;
   }
 }
 
@@ -196,6 +218,11 @@ bool Preprocessor::HandleEndOfFile(Token &Result, bool isEndOfMacro) {
     }
   }
 
+  // Stop the phase of a file entered with EnterSourceFile.
+  if (!isEndOfMacro && CurPPLexer && !(CurLexer && CurLexer->Is_PragmaLexer))
+    if (PhaseStatistics *Stats = PhaseStatistics::getActive())
+      Stats->exitPhase("Source file");
+
   // If this is a #include'd file, pop it off the include stack and continue
   // lexing the #includer file.
   if (!IncludeMacroStack.empty()) {
@@ -263,11 +290,8 @@ bool Preprocessor::HandleEndOfTokenLexer(Token &Result) {
   assert(CurTokenLexer && !CurPPLexer &&
          "Ending a macro when currently in a #include file!");
 
-  // Delete or cache the now-dead macro expander.
-  if (NumCachedTokenLexers == TokenLexerCacheSize)
-    CurTokenLexer.reset();
-  else
-    TokenLexerCache[NumCachedTokenLexers++] = CurTokenLexer.take();
+  // Cache the now-dead macro expander.
+  TokenLexerCache.push_back(CurTokenLexer.take());
 
   // Handle this like a #include file being popped off the stack.
   return HandleEndOfFile(Result, true);
@@ -280,11 +304,8 @@ void Preprocessor::RemoveTopOfLexerStack() {
   assert(!IncludeMacroStack.empty() && "Ran out of stack entries to load");
 
   if (CurTokenLexer) {
-    // Delete or cache the now-dead macro expander.
-    if (NumCachedTokenLexers == TokenLexerCacheSize)
-      CurTokenLexer.reset();
-    else
-      TokenLexerCache[NumCachedTokenLexers++] = CurTokenLexer.take();
+    // Cache the now-dead macro expander.
+    TokenLexerCache.push_back(CurTokenLexer.take());
   }
 
   PopIncludeMacroStack();
@@ -15,6 +15,7 @@
 #include "clang/Lex/Preprocessor.h"
 #include "MacroArgs.h"
 #include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/ExternalPreprocessorSource.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Lex/LexDiagnostic.h"
@@ -36,6 +37,18 @@ void Preprocessor::setMacroInfo(IdentifierInfo *II, MacroInfo *MI) {
   }
 }
 
+/// LoadExternalMacro - Have the external source read the definition of a
+/// macro that it marked as defined without reading it.
+MacroInfo *Preprocessor::LoadExternalMacro(IdentifierInfo *II) const {
+  assert(ExternalSource && "Macro definition without a MacroInfo!");
+  ExternalSource->LoadMacroDefinition(II);
+
+  llvm::DenseMap<IdentifierInfo*, MacroInfo*>::const_iterator Pos
+    = Macros.find(II);
+  assert(Pos != Macros.end() && "External source did not define the macro!");
+  return Pos == Macros.end() ? 0 : Pos->second;
+}
+
 /// RegisterBuiltinMacro - Register the specified identifier in the identifier
 /// table and mark it as a builtin macro to be expanded.
 static IdentifierInfo *RegisterBuiltinMacro(Preprocessor &PP, const char *Name){
@@ -25,6 +25,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <cstdio>
 #include <sys/stat.h>
 using namespace clang;
 using namespace clang::io;
@@ -288,12 +289,21 @@ namespace {
 class PTHFileData {
   const uint32_t TokenOff;
   const uint32_t PPCondOff;
+  const uint64_t ModTime;
+  const uint64_t Size;
 public:
-  PTHFileData(uint32_t tokenOff, uint32_t ppCondOff)
-    : TokenOff(tokenOff), PPCondOff(ppCondOff) {}
+  PTHFileData(uint32_t tokenOff, uint32_t ppCondOff, uint64_t modTime,
+              uint64_t size)
+    : TokenOff(tokenOff), PPCondOff(ppCondOff), ModTime(modTime),
+      Size(size) {}
 
   uint32_t getTokenOffset() const { return TokenOff; }
   uint32_t getPPCondOffset() const { return PPCondOff; }
+
+  /// getModTime/getSize - The stat information of the file at the time its
+  /// tokens were cached.
+  uint64_t getModTime() const { return ModTime; }
+  uint64_t getSize() const { return Size; }
 };
 
 
@@ -336,7 +346,10 @@ public:
     assert(k.first == 0x1 && "Only file lookups can match!");
     uint32_t x = ::ReadUnalignedLE32(d);
     uint32_t y = ::ReadUnalignedLE32(d);
-    return PTHFileData(x, y);
+    d += 4 + 4 + 2; // Skip the inode, device and mode.
+    uint64_t mtime = ::ReadUnalignedLE64(d);
+    uint64_t size = ::ReadUnalignedLE64(d);
+    return PTHFileData(x, y, mtime, size);
   }
 };
 
@@ -395,11 +408,13 @@ PTHManager::PTHManager(const llvm::MemoryBuffer* buf, void* fileLookup,
                        IdentifierInfo** perIDCache,
                        void* stringIdLookup, unsigned numIds,
                        const unsigned char* spellingBase,
-                       const char* originalSourceFile)
+                       const char* originalSourceFile,
+                       unsigned flags)
 : Buf(buf), PerIDCache(perIDCache), FileLookup(fileLookup),
   IdDataTable(idDataTable), StringIdLookup(stringIdLookup),
   NumIds(numIds), PP(0), SpellingBase(spellingBase),
-  OriginalSourceFile(originalSourceFile) {}
+  OriginalSourceFile(originalSourceFile), Flags(flags), NumLexers(0),
+  NumLexerMisses(0) {}
 
 PTHManager::~PTHManager() {
   delete Buf;
@@ -517,15 +532,19 @@ PTHManager* PTHManager::Create(const std::string& file, Diagnostic &Diags) {
     }
   }
 
+  // Read the flags.
+  const unsigned char* FlagsOffset = PrologueOffset + sizeof(uint32_t)*4;
+  unsigned Flags = ReadLE32(FlagsOffset);
+
   // Compute the address of the original source file.
-  const unsigned char* originalSourceBase = PrologueOffset + sizeof(uint32_t)*4;
+  const unsigned char* originalSourceBase = PrologueOffset + sizeof(uint32_t)*5;
   unsigned len = ReadUnalignedLE16(originalSourceBase);
   if (!len) originalSourceBase = 0;
 
   // Create the new PTHManager.
   return new PTHManager(File.take(), FL.take(), IData, PerIDCache,
                         SL.take(), NumIds, spellingBase,
-                        (const char*) originalSourceBase);
+                        (const char*) originalSourceBase, Flags);
 }
 
 IdentifierInfo* PTHManager::LazilyCreateIdentifierInfo(unsigned PersistentID) {
@@ -574,11 +593,22 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
   PTHFileLookup& PFL = *((PTHFileLookup*)FileLookup);
   PTHFileLookup::iterator I = PFL.find(FE);
 
-  if (I == PFL.end()) // No tokens available?
+  if (I == PFL.end()) { // No tokens available?
+    ++NumLexerMisses;
     return 0;
+  }
 
   const PTHFileData& FileData = *I;
 
+  // A shared store may outlive some of the files it caches.  If this file has
+  // changed since its tokens were cached, lex it from source instead.
+  if ((Flags & SharedStore) &&
+      (FileData.getModTime() != (uint64_t) FE->getModificationTime() ||
+       FileData.getSize() != (uint64_t) FE->getSize())) {
+    ++NumLexerMisses;
+    return 0;
+  }
+
   const unsigned char *BufStart = (const unsigned char *)Buf->getBufferStart();
   // Compute the offset of the token data within the buffer.
   const unsigned char* data = BufStart + FileData.getTokenOffset();
@@ -589,9 +619,23 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
   if (Len == 0) ppcond = 0;
 
   assert(PP && "No preprocessor set yet!");
+  ++NumLexers;
   return new PTHLexer(*PP, FID, data, ppcond, *this);
 }
 
+void PTHManager::PrintStats() const {
+  unsigned NumResolvedIds = 0;
+  for (unsigned i = 0; i != NumIds; ++i)
+    NumResolvedIds += PerIDCache[i] != 0;
+
+  fprintf(stderr, "\n*** PTH Stats:\n");
+  fprintf(stderr, "%u bytes of cached tokens and identifiers.\n",
+          (unsigned) Buf->getBufferSize());
+  fprintf(stderr, "%u identifiers, %u resolved.\n", NumIds, NumResolvedIds);
+  fprintf(stderr, "%u files lexed from cached tokens.\n", NumLexers);
+  fprintf(stderr, "%u files without cached tokens.\n", NumLexerMisses);
+}
+
 //===----------------------------------------------------------------------===//
 // 'stat' caching.
 //===----------------------------------------------------------------------===//
@@ -681,5 +725,62 @@ public:
 } // end anonymous namespace
 
 StatSysCallCache *PTHManager::createStatCache() {
+  // The stat data of a shared store is only used to validate its tokens.
+  if (Flags & SharedStore)
+    return 0;
   return new PTHStatCache(*((PTHFileLookup*) FileLookup));
 }
+
+//===----------------------------------------------------------------------===//
+// Enumerating cached files.
+//===----------------------------------------------------------------------===//
+
+bool PTHManager::getCachedFiles(const std::string &file,
+                                std::vector<std::string> &Files) {
+  llvm::OwningPtr<llvm::MemoryBuffer>
+    File(llvm::MemoryBuffer::getFile(file.c_str()));
+  if (!File)
+    return true;
+
+  const unsigned char* BufBeg = (unsigned char*)File->getBufferStart();
+  const unsigned char* BufEnd = (unsigned char*)File->getBufferEnd();
+  if ((BufEnd - BufBeg) < (signed) (sizeof("cfe-pth") + 3 + 4 * 6) ||
+      memcmp(BufBeg, "cfe-pth", sizeof("cfe-pth") - 1) != 0)
+    return true;
+
+  const unsigned char *p = BufBeg + (sizeof("cfe-pth") - 1);
+  if (ReadLE32(p) != PTHManager::Version)
+    return true;
+
+  const unsigned char* FileTableOffset = p + sizeof(uint32_t)*2;
+  const unsigned char* FileTable = BufBeg + ReadLE32(FileTableOffset);
+  if (!(FileTable > BufBeg && FileTable < BufEnd))
+    return true;
+
+  // The table has no iterator, so walk its buckets directly.
+  llvm::OwningPtr<PTHFileLookup> FL(PTHFileLookup::Create(FileTable, BufBeg));
+  const unsigned char *Bucket = FL->getBuckets();
+  for (unsigned i = 0, e = FL->getNumBuckets(); i != e; ++i) {
+    unsigned Offset = ReadLE32(Bucket);
+    if (Offset == 0)
+      continue;
+
+    const unsigned char *Items = FL->getBase() + Offset;
+    unsigned NumItems = ReadUnalignedLE16(Items);
+    for (unsigned j = 0; j != NumItems; ++j) {
+      Items += 4; // Skip the hash.
+      std::pair<unsigned, unsigned> L =
+        PTHFileLookupTrait::ReadKeyDataLength(Items);
+      PTHFileLookupTrait::internal_key_type Key =
+        PTHFileLookupTrait::ReadKey(Items, L.first);
+      Items += L.first + L.second;
+
+      // Only files have cached tokens; the other entries record the results
+      // of stat() calls on directories and missing files.
+      if (Key.first == 0x1)
+        Files.push_back(Key.second);
+    }
+  }
+
+  return false;
+}
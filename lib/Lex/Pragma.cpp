@@ -32,8 +32,9 @@ PragmaHandler::~PragmaHandler() {
 
 
 PragmaNamespace::~PragmaNamespace() {
-  for (unsigned i = 0, e = Handlers.size(); i != e; ++i)
-    delete Handlers[i];
+  for (llvm::DenseMap<const IdentifierInfo *, PragmaHandler *>::iterator
+         I = Handlers.begin(), E = Handlers.end(); I != E; ++I)
+    delete I->second;
 }
 
 /// FindHandler - Check to see if there is already a handler for the
@@ -42,33 +43,33 @@ PragmaNamespace::~PragmaNamespace() {
 /// the null handler isn't returned on failure to match.
 PragmaHandler *PragmaNamespace::FindHandler(const IdentifierInfo *Name,
                                             bool IgnoreNull) const {
-  PragmaHandler *NullHandler = 0;
-  for (unsigned i = 0, e = Handlers.size(); i != e; ++i) {
-    if (Handlers[i]->getName() == Name)
-      return Handlers[i];
-
-    if (Handlers[i]->getName() == 0)
-      NullHandler = Handlers[i];
-  }
-  return IgnoreNull ? 0 : NullHandler;
+  llvm::DenseMap<const IdentifierInfo *, PragmaHandler *>::const_iterator
+    I = Handlers.find(Name);
+  if (I != Handlers.end())
+    return I->second;
+  if (IgnoreNull)
+    return 0;
+
+  I = Handlers.find(0);
+  return I != Handlers.end() ? I->second : 0;
 }
 
 void PragmaNamespace::RemovePragmaHandler(PragmaHandler *Handler) {
-  for (unsigned i = 0, e = Handlers.size(); i != e; ++i) {
-    if (Handlers[i] == Handler) {
-      Handlers[i] = Handlers.back();
-      Handlers.pop_back();
-      return;
-    }
-  }
-  assert(0 && "Handler not registered in this namespace");
+  llvm::DenseMap<const IdentifierInfo *, PragmaHandler *>::iterator
+    I = Handlers.find(Handler->getName());
+  assert(I != Handlers.end() && I->second == Handler &&
+         "Handler not registered in this namespace");
+  Handlers.erase(I);
 }
 
 void PragmaNamespace::HandlePragma(Preprocessor &PP, Token &Tok) {
   // Read the 'namespace' that the directive is in, e.g. STDC.  Do not macro
   // expand it, the user can have a STDC #define, that should not affect this.
   PP.LexUnexpandedToken(Tok);
+  DispatchPragma(PP, Tok);
+}
 
+void PragmaNamespace::DispatchPragma(Preprocessor &PP, Token &Tok) {
   // Get the handler for this token.  If there is no handler, ignore the pragma.
   PragmaHandler *Handler = FindHandler(Tok.getIdentifierInfo(), false);
   if (Handler == 0) {
@@ -89,9 +90,23 @@ void PragmaNamespace::HandlePragma(Preprocessor &PP, Token &Tok) {
 void Preprocessor::HandlePragmaDirective() {
   ++NumPragma;
 
-  // Invoke the first level of pragma handlers which reads the namespace id.
+  // Read the namespace id, without macro expanding it.
   Token Tok;
-  PragmaHandlers->HandlePragma(*this, Tok);
+  LexUnexpandedToken(Tok);
+
+  // "#pragma once" and "#pragma mark" are by far the most common pragmas in
+  // headers, so handle them here while their builtin handlers are installed
+  // instead of going through the handler tables.
+  IdentifierInfo *II = Tok.getIdentifierInfo();
+  if (II && II == Ident_Pragma_once) {
+    CheckEndOfDirective("pragma once");
+    HandlePragmaOnce(Tok);
+  } else if (II && II == Ident_Pragma_mark) {
+    HandlePragmaMark();
+  } else {
+    // Invoke the first level of pragma handlers.
+    PragmaHandlers->DispatchPragma(*this, Tok);
+  }
 
   // If the pragma handler didn't read the rest of the line, consume it now.
   if (CurPPLexer && CurPPLexer->ParsingPreprocessorDirective)
@@ -466,6 +481,15 @@ void Preprocessor::RemovePragmaHandler(const char *Namespace,
 
   NS->RemovePragmaHandler(Handler);
 
+  // Once a builtin handler is removed, HandlePragmaDirective must not handle
+  // its pragma on its own any more.
+  if (NS == PragmaHandlers) {
+    if (Handler->getName() == Ident_Pragma_once)
+      Ident_Pragma_once = 0;
+    else if (Handler->getName() == Ident_Pragma_mark)
+      Ident_Pragma_mark = 0;
+  }
+
   // If this is a non-default namespace and it is now empty, remove
   // it.
   if (NS != PragmaHandlers && NS->IsEmpty())
@@ -703,8 +727,10 @@ struct PragmaSTDC_UnknownHandler : public PragmaHandler {
 /// RegisterBuiltinPragmas - Install the standard preprocessor pragmas:
 /// #pragma GCC poison/system_header/dependency and #pragma once.
 void Preprocessor::RegisterBuiltinPragmas() {
-  AddPragmaHandler(0, new PragmaOnceHandler(getIdentifierInfo("once")));
-  AddPragmaHandler(0, new PragmaMarkHandler(getIdentifierInfo("mark")));
+  Ident_Pragma_once = getIdentifierInfo("once");
+  Ident_Pragma_mark = getIdentifierInfo("mark");
+  AddPragmaHandler(0, new PragmaOnceHandler(Ident_Pragma_once));
+  AddPragmaHandler(0, new PragmaMarkHandler(Ident_Pragma_mark));
 
   // #pragma GCC ...
   AddPragmaHandler("GCC", new PragmaPoisonHandler(getIdentifierInfo("poison")));
@@ -0,0 +1,487 @@
+//===--- PrecomputedPredefines.cpp - Predefined macros without lexing -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the PrecomputedPredefines interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/PrecomputedPredefines.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/SourceManagerInternals.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+using namespace clang;
+using namespace clang::io;
+
+//===----------------------------------------------------------------------===//
+// Computing the macros
+//===----------------------------------------------------------------------===//
+
+namespace clang {
+/// PredefinesRecorder - Records the FileChanged callbacks made by the line
+/// markers of the text, and keeps the scratch preprocessor from warning
+/// about unused macros when it leaves the text.
+class PredefinesRecorder : public PPCallbacks {
+  PrecomputedPredefines &Result;
+  SourceManager &SM;
+  FileID FID;
+
+public:
+  PredefinesRecorder(PrecomputedPredefines &Result, SourceManager &SM,
+                     FileID FID)
+    : Result(Result), SM(SM), FID(FID) {}
+
+  virtual void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                           SrcMgr::CharacteristicKind FileType) {
+    std::pair<FileID, unsigned> LocInfo = SM.getDecomposedLoc(Loc);
+    if (LocInfo.first != FID)
+      return;
+
+    PrecomputedPredefines::FileChange FC;
+    FC.Offset = LocInfo.second;
+    FC.Reason = Reason;
+    FC.FileKind = FileType;
+    Result.FileChanges.push_back(FC);
+  }
+
+  virtual void MacroDefined(const IdentifierInfo *II, const MacroInfo *MI) {
+    const_cast<MacroInfo*>(MI)->setIsUsed(true);
+  }
+};
+} // end namespace clang
+
+static bool MacroOffsetLess(const PrecomputedPredefines::Macro &LHS,
+                            const PrecomputedPredefines::Macro &RHS) {
+  return LHS.Offset < RHS.Offset;
+}
+
+PrecomputedPredefines *PrecomputedPredefines::Compute(Preprocessor &PP,
+                                                      llvm::StringRef Text) {
+  Diagnostic &Diags = PP.getDiagnostics();
+
+  // Lex the text as the only file of a scratch preprocessor, so that nothing
+  // but the text can contribute to the macro table.  The scratch source
+  // manager keeps the real one free of extra entries, which a PCH file
+  // loaded later relies on.
+  SourceManager SM;
+  Preprocessor Scratch(Diags, PP.getLangOptions(), PP.getTargetInfo(), SM,
+                       PP.getHeaderSearchInfo());
+  llvm::MemoryBuffer *SB =
+    llvm::MemoryBuffer::getMemBufferCopy(Text.begin(), Text.end(),
+                                         "<built-in>");
+  FileID FID = SM.createFileIDForMemBuffer(SB);
+  std::string ErrorStr;
+  if (Scratch.EnterSourceFile(FID, 0, ErrorStr))
+    return 0;
+
+  llvm::OwningPtr<PrecomputedPredefines>
+    Result(new PrecomputedPredefines(Text));
+  Scratch.setPPCallbacks(new PredefinesRecorder(*Result, SM, FID));
+
+  unsigned NumErrors = Diags.getNumErrors();
+  Token Tok;
+  do Scratch.Lex(Tok);
+  while (Tok.isNot(tok::eof));
+  if (Diags.getNumErrors() != NumErrors)
+    return 0;
+
+  for (Preprocessor::macro_iterator I = Scratch.macro_begin(),
+       E = Scratch.macro_end(); I != E; ++I) {
+    const MacroInfo &MI = *I->second;
+    if (MI.isBuiltinMacro())
+      continue;
+
+    std::pair<FileID, unsigned> Def =
+      SM.getDecomposedLoc(MI.getDefinitionLoc());
+    std::pair<FileID, unsigned> End =
+      SM.getDecomposedLoc(MI.getDefinitionEndLoc());
+    if (Def.first != FID || End.first != FID)
+      return 0;
+
+    Macro M;
+    M.Name = I->first->getName();
+    M.Offset = Def.second;
+    M.EndOffset = End.second;
+    M.IsFunctionLike = MI.isFunctionLike();
+    M.IsC99Varargs = MI.isC99Varargs();
+    M.IsGNUVarargs = MI.isGNUVarargs();
+    for (MacroInfo::arg_iterator A = MI.arg_begin(), AE = MI.arg_end();
+         A != AE; ++A)
+      M.Args.push_back((*A)->getName());
+
+    for (MacroInfo::tokens_iterator T = MI.tokens_begin(),
+         TE = MI.tokens_end(); T != TE; ++T) {
+      std::pair<FileID, unsigned> Loc = SM.getDecomposedLoc(T->getLocation());
+      if (Loc.first != FID)
+        return 0;
+
+      BodyToken BT;
+      BT.Offset = Loc.second;
+      BT.Length = T->getLength();
+      BT.Kind = T->getKind();
+      BT.Flags = T->getFlags();
+      if (IdentifierInfo *II = T->getIdentifierInfo())
+        BT.Identifier = II->getName();
+      M.Body.push_back(BT);
+    }
+    Result->Macros.push_back(M);
+  }
+
+  // Install the macros in the order the text defines them, so callbacks see
+  // them in the same order as when the text is lexed.
+  std::sort(Result->Macros.begin(), Result->Macros.end(), MacroOffsetLess);
+
+  if (SM.hasLineTable()) {
+    LineTableInfo &LineTable = SM.getLineTable();
+    for (LineTableInfo::iterator L = LineTable.begin(), LEnd = LineTable.end();
+         L != LEnd; ++L) {
+      if (L->first != FID.getHashValue())
+        continue;
+
+      for (std::vector<LineEntry>::iterator LE = L->second.begin(),
+           LEEnd = L->second.end(); LE != LEEnd; ++LE) {
+        LineNote Note;
+        Note.Offset = LE->FileOffset;
+        Note.LineNo = LE->LineNo;
+        Note.IncludeOffset = LE->IncludeOffset;
+        Note.FileKind = LE->FileKind;
+        Note.HasFilename = LE->FilenameID != -1;
+        if (Note.HasFilename)
+          Note.Filename = LineTable.getFilename(LE->FilenameID);
+        Result->LineNotes.push_back(Note);
+      }
+    }
+  }
+
+  return Result.take();
+}
+
+//===----------------------------------------------------------------------===//
+// Installing the macros
+//===----------------------------------------------------------------------===//
+
+bool PrecomputedPredefines::canInstall(Preprocessor &PP) const {
+  if (!llvm::StringRef(PP.getPredefines()).startswith(Text))
+    return false;
+
+  for (unsigned i = 0, e = Macros.size(); i != e; ++i)
+    if (PP.getIdentifierInfo(Macros[i].Name)->hasMacroDefinition())
+      return false;
+  return true;
+}
+
+void PrecomputedPredefines::Install(Preprocessor &PP, FileID FID) const {
+  SourceManager &SM = PP.getSourceManager();
+  SourceLocation Start = SM.getLocForStartOfFile(FID);
+  const char *BufStart = SM.getBuffer(FID)->getBufferStart();
+
+  // The line markers of the text have to be in place before any callback
+  // asks for a presumed location within it.
+  if (!LineNotes.empty()) {
+    std::vector<LineEntry> Entries;
+    for (unsigned i = 0, e = LineNotes.size(); i != e; ++i) {
+      const LineNote &Note = LineNotes[i];
+      int FilenameID = -1;
+      if (Note.HasFilename)
+        FilenameID = SM.getLineTableFilenameID(Note.Filename.data(),
+                                               Note.Filename.size());
+      Entries.push_back(LineEntry::get(Note.Offset, Note.LineNo, FilenameID,
+                                   (SrcMgr::CharacteristicKind) Note.FileKind,
+                                       Note.IncludeOffset));
+    }
+    SM.AddLineEntries(FID, Entries);
+  }
+
+  PPCallbacks *Callbacks = PP.getPPCallbacks();
+  llvm::BumpPtrAllocator &Allocator = PP.getPreprocessorAllocator();
+  llvm::SmallVector<IdentifierInfo*, 8> Args;
+  unsigned NextChange = 0;
+  for (unsigned i = 0, e = Macros.size(); i != e; ++i) {
+    const Macro &M = Macros[i];
+
+    for (; Callbacks && NextChange != FileChanges.size() &&
+           FileChanges[NextChange].Offset < M.Offset; ++NextChange)
+      Callbacks->FileChanged(
+        Start.getFileLocWithOffset(FileChanges[NextChange].Offset),
+        (PPCallbacks::FileChangeReason) FileChanges[NextChange].Reason,
+        (SrcMgr::CharacteristicKind) FileChanges[NextChange].FileKind);
+
+    MacroInfo *MI = PP.AllocateMacroInfo(Start.getFileLocWithOffset(M.Offset));
+    if (M.IsFunctionLike)
+      MI->setIsFunctionLike();
+    if (M.IsC99Varargs)
+      MI->setIsC99Varargs();
+    if (M.IsGNUVarargs)
+      MI->setIsGNUVarargs();
+
+    if (!M.Args.empty()) {
+      Args.clear();
+      for (unsigned a = 0, ae = M.Args.size(); a != ae; ++a)
+        Args.push_back(PP.getIdentifierInfo(M.Args[a]));
+      MI->setArgumentList(Args.data(), Args.size(), Allocator);
+    }
+
+    for (unsigned t = 0, te = M.Body.size(); t != te; ++t) {
+      const BodyToken &BT = M.Body[t];
+      Token Tok;
+      Tok.startToken();
+      Tok.setKind((tok::TokenKind) BT.Kind);
+      Tok.setLocation(Start.getFileLocWithOffset(BT.Offset));
+      Tok.setLength(BT.Length);
+      if (BT.Flags)
+        Tok.setFlag((Token::TokenFlags) BT.Flags);
+      if (!BT.Identifier.empty())
+        Tok.setIdentifierInfo(PP.getIdentifierInfo(BT.Identifier));
+      else if (Tok.isLiteral())
+        Tok.setLiteralData(BufStart + BT.Offset);
+      MI->AddTokenToBody(Tok);
+    }
+    MI->setDefinitionEndLoc(Start.getFileLocWithOffset(M.EndOffset));
+
+    IdentifierInfo *II = PP.getIdentifierInfo(M.Name);
+    PP.setMacroInfo(II, MI);
+    if (Callbacks)
+      Callbacks->MacroDefined(II, MI);
+  }
+
+  for (; Callbacks && NextChange != FileChanges.size(); ++NextChange)
+    Callbacks->FileChanged(
+      Start.getFileLocWithOffset(FileChanges[NextChange].Offset),
+      (PPCallbacks::FileChangeReason) FileChanges[NextChange].Reason,
+      (SrcMgr::CharacteristicKind) FileChanges[NextChange].FileKind);
+}
+
+//===----------------------------------------------------------------------===//
+// The cache file
+//===----------------------------------------------------------------------===//
+//
+// The cache file is laid out as follows:
+//
+//   "cfe-ppd" <version:32> <text length:32> <text>
+//   <line note count:32> <line notes>
+//   <file change count:32> <file changes>
+//   <macro count:32> <macros>
+//
+// Strings are a 32-bit length followed by their bytes.  A line note is its
+// offset, line, include offset and file kind, then a flag byte telling
+// whether a filename string follows.  A file change is its offset, reason and
+// file kind.  A macro is its name, definition and end offsets, a flag byte,
+// its argument names and its body tokens; a body token is its offset,
+// length, kind, flags and identifier name.
+
+static void EmitString(llvm::raw_ostream &Out, llvm::StringRef Str) {
+  Emit32(Out, Str.size());
+  Out << Str;
+}
+
+namespace {
+/// CacheReader - Reads the cache file, checking every read against the end
+/// of the file.
+class CacheReader {
+  const unsigned char *Ptr, *End;
+  bool Failed;
+
+public:
+  CacheReader(const unsigned char *Ptr, const unsigned char *End)
+    : Ptr(Ptr), End(End), Failed(false) {}
+
+  bool hasFailed() const { return Failed; }
+  bool atEnd() const { return Ptr == End; }
+
+  unsigned read32() {
+    if (Failed || End - Ptr < 4) {
+      Failed = true;
+      return 0;
+    }
+    return ReadUnalignedLE32(Ptr);
+  }
+
+  unsigned char read8() {
+    if (Failed || Ptr == End) {
+      Failed = true;
+      return 0;
+    }
+    return *Ptr++;
+  }
+
+  llvm::StringRef readString() {
+    unsigned Len = read32();
+    if (Failed || (unsigned) (End - Ptr) < Len) {
+      Failed = true;
+      return llvm::StringRef();
+    }
+    llvm::StringRef Str((const char*) Ptr, Len);
+    Ptr += Len;
+    return Str;
+  }
+};
+} // end anonymous namespace
+
+std::string PrecomputedPredefines::getCacheFileName(llvm::StringRef Text) {
+  char Name[32];
+  snprintf(Name, sizeof(Name), "predefines-%08x.cache",
+           llvm::HashString(Text));
+  return Name;
+}
+
+PrecomputedPredefines *PrecomputedPredefines::Read(llvm::StringRef Path,
+                                                   llvm::StringRef Text) {
+  llvm::OwningPtr<llvm::MemoryBuffer>
+    Buf(llvm::MemoryBuffer::getFile(Path.str().c_str()));
+  if (!Buf.get())
+    return 0;
+
+  const unsigned char *BufBeg = (const unsigned char*) Buf->getBufferStart();
+  const unsigned char *BufEnd = (const unsigned char*) Buf->getBufferEnd();
+  const unsigned MagicLen = sizeof("cfe-ppd") - 1;
+  if (BufEnd - BufBeg < (signed) MagicLen ||
+      memcmp(BufBeg, "cfe-ppd", MagicLen) != 0)
+    return 0;
+
+  // A stale or damaged cache is simply ignored; it will be rewritten.
+  CacheReader R(BufBeg + MagicLen, BufEnd);
+  if (R.read32() != Version || R.readString() != Text || R.hasFailed())
+    return 0;
+
+  llvm::OwningPtr<PrecomputedPredefines>
+    Result(new PrecomputedPredefines(Text));
+
+  for (unsigned i = 0, e = R.read32(); i != e && !R.hasFailed(); ++i) {
+    LineNote Note;
+    Note.Offset = R.read32();
+    Note.LineNo = R.read32();
+    Note.IncludeOffset = R.read32();
+    Note.FileKind = R.read8();
+    Note.HasFilename = R.read8();
+    if (Note.HasFilename)
+      Note.Filename = R.readString();
+    Result->LineNotes.push_back(Note);
+  }
+
+  for (unsigned i = 0, e = R.read32(); i != e && !R.hasFailed(); ++i) {
+    FileChange FC;
+    FC.Offset = R.read32();
+    FC.Reason = R.read8();
+    FC.FileKind = R.read8();
+    Result->FileChanges.push_back(FC);
+  }
+
+  for (unsigned i = 0, e = R.read32(); i != e && !R.hasFailed(); ++i) {
+    Result->Macros.push_back(Macro());
+    Macro &M = Result->Macros.back();
+    M.Name = R.readString();
+    M.Offset = R.read32();
+    M.EndOffset = R.read32();
+    unsigned char Flags = R.read8();
+    M.IsFunctionLike = Flags & 1;
+    M.IsC99Varargs = Flags & 2;
+    M.IsGNUVarargs = Flags & 4;
+    for (unsigned a = 0, ae = R.read32(); a != ae && !R.hasFailed(); ++a)
+      M.Args.push_back(R.readString());
+    for (unsigned t = 0, te = R.read32(); t != te && !R.hasFailed(); ++t) {
+      BodyToken BT;
+      BT.Offset = R.read32();
+      BT.Length = R.read32();
+      BT.Kind = R.read8();
+      BT.Flags = R.read8();
+      BT.Identifier = R.readString();
+      M.Body.push_back(BT);
+    }
+  }
+
+  if (R.hasFailed() || !R.atEnd())
+    return 0;
+
+  // Every location must lie within the text.
+  for (unsigned i = 0, e = Result->LineNotes.size(); i != e; ++i)
+    if (Result->LineNotes[i].Offset >= Text.size())
+      return 0;
+  for (unsigned i = 0, e = Result->FileChanges.size(); i != e; ++i)
+    if (Result->FileChanges[i].Offset >= Text.size())
+      return 0;
+  for (unsigned i = 0, e = Result->Macros.size(); i != e; ++i) {
+    const Macro &M = Result->Macros[i];
+    if (M.Name.empty() || M.Offset >= Text.size() || M.EndOffset >= Text.size())
+      return 0;
+    for (unsigned t = 0, te = M.Body.size(); t != te; ++t)
+      if (M.Body[t].Offset + M.Body[t].Length > Text.size() ||
+          M.Body[t].Kind >= tok::NUM_TOKENS)
+        return 0;
+  }
+
+  return Result.take();
+}
+
+bool PrecomputedPredefines::Write(llvm::StringRef Path) const {
+  // Write to a temporary file first so that concurrent compilations reading
+  // the cache never see a partially written file.
+  AtomicOutputFile File(Path);
+  std::string ErrMsg;
+  if (File.open(ErrMsg))
+    return true;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << "cfe-ppd";
+  Emit32(Out, Version);
+  EmitString(Out, Text);
+
+  Emit32(Out, LineNotes.size());
+  for (unsigned i = 0, e = LineNotes.size(); i != e; ++i) {
+    const LineNote &Note = LineNotes[i];
+    Emit32(Out, Note.Offset);
+    Emit32(Out, Note.LineNo);
+    Emit32(Out, Note.IncludeOffset);
+    Emit8(Out, Note.FileKind);
+    Emit8(Out, Note.HasFilename);
+    if (Note.HasFilename)
+      EmitString(Out, Note.Filename);
+  }
+
+  Emit32(Out, FileChanges.size());
+  for (unsigned i = 0, e = FileChanges.size(); i != e; ++i) {
+    Emit32(Out, FileChanges[i].Offset);
+    Emit8(Out, FileChanges[i].Reason);
+    Emit8(Out, FileChanges[i].FileKind);
+  }
+
+  Emit32(Out, Macros.size());
+  for (unsigned i = 0, e = Macros.size(); i != e; ++i) {
+    const Macro &M = Macros[i];
+    EmitString(Out, M.Name);
+    Emit32(Out, M.Offset);
+    Emit32(Out, M.EndOffset);
+    Emit8(Out, (M.IsFunctionLike ? 1 : 0) | (M.IsC99Varargs ? 2 : 0) |
+               (M.IsGNUVarargs ? 4 : 0));
+    Emit32(Out, M.Args.size());
+    for (unsigned a = 0, ae = M.Args.size(); a != ae; ++a)
+      EmitString(Out, M.Args[a]);
+    Emit32(Out, M.Body.size());
+    for (unsigned t = 0, te = M.Body.size(); t != te; ++t) {
+      const BodyToken &BT = M.Body[t];
+      Emit32(Out, BT.Offset);
+      Emit32(Out, BT.Length);
+      Emit8(Out, BT.Kind);
+      Emit8(Out, BT.Flags);
+      EmitString(Out, BT.Identifier);
+    }
+  }
+
+  // A truncated buffer would be reused as the predefines of later runs.
+  return File.commit(ErrMsg);
+}
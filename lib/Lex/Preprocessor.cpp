@@ -31,6 +31,7 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Pragma.h"
+#include "clang/Lex/PrecomputedPredefines.h"
 #include "clang/Lex/ScratchBuffer.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Basic/SourceManager.h"
@@ -40,6 +41,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cstdio>
 using namespace clang;
 
@@ -50,13 +52,15 @@ Preprocessor::Preprocessor(Diagnostic &diags, const LangOptions &opts,
                            const TargetInfo &target, SourceManager &SM,
                            HeaderSearch &Headers,
                            IdentifierInfoLookup* IILookup,
-                           bool OwnsHeaders)
+                           bool OwnsHeaders,
+                           const SharedIdentifierTable *SharedIdentifiers)
   : Diags(&diags), Features(opts), Target(target),FileMgr(Headers.getFileMgr()),
     SourceMgr(SM), HeaderInfo(Headers), ExternalSource(0),
-    Identifiers(opts, IILookup), BuiltinInfo(Target), CodeCompletionFile(0), 
-    CurPPLexer(0), CurDirLookup(0), Callbacks(0), MacroArgCache(0) {
+    Identifiers(opts, IILookup, SharedIdentifiers), BuiltinInfo(Target),
+    CodeCompletionFile(0), CurPPLexer(0), CurDirLookup(0), Callbacks(0) {
   ScratchBuf = new ScratchBuffer(SourceMgr);
   CounterValue = 0; // __COUNTER__ starts at 0.
+  SkipMainFilePreambleBytes = 0;
   OwnsHeaderSearch = OwnsHeaders;
 
   // Clear stats.
@@ -67,6 +71,12 @@ Preprocessor::Preprocessor(Diagnostic &diags, const LangOptions &opts,
   NumFastMacroExpanded = NumTokenPaste = NumFastTokenPaste = 0;
   MaxIncludeStackDepth = 0;
   NumSkipped = 0;
+  NumMacroArgsAllocated = NumMacroArgsReused = 0;
+  NumTokenLexersAllocated = NumTokenLexersReused = 0;
+  NumBacktracks = NumBacktrackedTokens = MaxCachedTokens = 0;
+  NumDisambiguations = NumMemoizedDisambiguations = 0;
+  NumCleanedSpellings = 0;
+  memset(MacroArgCache, 0, sizeof(MacroArgCache));
 
   // Default to discarding comments.
   KeepComments = false;
@@ -75,7 +85,6 @@ Preprocessor::Preprocessor(Diagnostic &diags, const LangOptions &opts,
   // Macro expansion is enabled.
   DisableMacroExpansion = false;
   InMacroArgs = false;
-  NumCachedTokenLexers = 0;
 
   CachedLexPos = 0;
 
@@ -115,12 +124,14 @@ Preprocessor::~Preprocessor() {
   }
 
   // Free any cached macro expanders.
-  for (unsigned i = 0, e = NumCachedTokenLexers; i != e; ++i)
+  for (unsigned i = 0, e = TokenLexerCache.size(); i != e; ++i)
     delete TokenLexerCache[i];
-  
-  // Free any cached MacroArgs.
-  for (MacroArgs *ArgList = MacroArgCache; ArgList; )
-    ArgList = ArgList->deallocate();
+
+  // Free any cached MacroArgs.  Their memory is released with
+  // MacroArgAllocator.
+  for (unsigned i = 0; i != NumMacroArgBuckets; ++i)
+    for (MacroArgs *ArgList = MacroArgCache[i]; ArgList; )
+      ArgList = ArgList->deallocate();
 
   // Release pragma information.
   delete PragmaHandlers;
@@ -135,9 +146,14 @@ Preprocessor::~Preprocessor() {
   delete Callbacks;
 }
 
+void Preprocessor::setPrecomputedPredefines(PrecomputedPredefines *P) {
+  Precomputed.reset(P);
+}
+
 void Preprocessor::setPTHManager(PTHManager* pm) {
   PTH.reset(pm);
-  FileMgr.addStatCache(PTH->createStatCache());
+  if (StatSysCallCache *StatCache = PTH->createStatCache())
+    FileMgr.addStatCache(StatCache);
 }
 
 void Preprocessor::DumpToken(const Token &Tok, bool DumpFlags) const {
@@ -197,6 +213,57 @@ void Preprocessor::PrintStats() {
   llvm::errs() << (NumFastTokenPaste+NumTokenPaste)
              << " token paste (##) operations performed, "
              << NumFastTokenPaste << " on the fast path.\n";
+  llvm::errs() << (NumMacroArgsAllocated+NumMacroArgsReused)
+             << " macro argument lists created, "
+             << NumMacroArgsReused << " reused from the cache.\n";
+  llvm::errs() << (NumTokenLexersAllocated+NumTokenLexersReused)
+             << " token lexers entered, "
+             << NumTokenLexersReused << " reused from the cache.\n";
+  llvm::errs() << NumBacktracks << " backtracks, re-lexing "
+             << NumBacktrackedTokens << " cached tokens.\n";
+  llvm::errs() << MaxCachedTokens << " tokens cached at most.\n";
+  llvm::errs() << NumDisambiguations << " tentative parses, "
+             << NumMemoizedDisambiguations << " answered from the memo.\n";
+  llvm::errs() << MacroArgAllocator.getTotalMemory()
+             << " bytes allocated for macro argument lists.\n";
+  llvm::errs() << NumCleanedSpellings << " token spellings cleaned, using "
+             << CleanedSpellingAllocator.getTotalMemory() << " bytes.\n";
+}
+
+size_t Preprocessor::getTotalMemory() const {
+  return BP.getTotalMemory() + MacroArgAllocator.getTotalMemory() +
+         CleanedSpellingAllocator.getTotalMemory() +
+         Macros.size() * sizeof(std::pair<IdentifierInfo*, MacroInfo*>) +
+         MICache.capacity() * sizeof(MacroInfo*) +
+         TokenLexerCache.size() * sizeof(TokenLexer) +
+         CachedTokens.capacity() * sizeof(Token) +
+         DisambiguationMemo.size() *
+           sizeof(std::pair<std::pair<unsigned, unsigned>,
+                            std::pair<unsigned, unsigned> >);
+}
+
+void Preprocessor::releaseCaches() {
+  for (unsigned i = 0, e = TokenLexerCache.size(); i != e; ++i)
+    delete TokenLexerCache[i];
+  std::vector<TokenLexer*>().swap(TokenLexerCache);
+
+  for (unsigned i = 0; i != NumMacroArgBuckets; ++i) {
+    for (MacroArgs *ArgList = MacroArgCache[i]; ArgList; )
+      ArgList = ArgList->deallocate();
+    MacroArgCache[i] = 0;
+  }
+
+  // Argument lists only live while a macro is expanded; with no expansion
+  // under way, all of them were on the free lists just released.
+  if (!CurTokenLexer && IncludeMacroStack.empty())
+    MacroArgAllocator.Reset();
+
+  if (!isBacktrackEnabled() && CachedLexPos == CachedTokens.size()) {
+    CachedTokensTy().swap(CachedTokens);
+    CachedLexPos = 0;
+    llvm::DenseMap<std::pair<unsigned, unsigned>,
+                   std::pair<unsigned, unsigned> >().swap(DisambiguationMemo);
+  }
 }
 
 Preprocessor::macro_iterator 
@@ -365,6 +432,36 @@ unsigned Preprocessor::getSpelling(const Token &Tok,
   return OutBuf-Buffer;
 }
 
+/// getSpellingRef - Return the spelling of the Tok token without copying it
+/// whenever possible.  Only tokens that need cleaning are copied, into
+/// CleanedSpellingAllocator.
+llvm::StringRef Preprocessor::getSpellingRef(const Token &Tok) const {
+  assert((int)Tok.getLength() >= 0 && "Token character range is bogus!");
+
+  if (const IdentifierInfo *II = Tok.getIdentifierInfo())
+    return II->getName();
+
+  if (!Tok.needsCleaning()) {
+    const char *TokStart = 0;
+    if (Tok.isLiteral())
+      TokStart = Tok.getLiteralData();
+    if (TokStart == 0)
+      TokStart = SourceMgr.getCharacterData(Tok.getLocation());
+    return llvm::StringRef(TokStart, Tok.getLength());
+  }
+
+  // The cleaned spelling is never longer than the token.  Terminate it so the
+  // result can be overread by one, just like a reference into the source.
+  ++NumCleanedSpellings;
+  char *Buf = static_cast<char*>(
+    CleanedSpellingAllocator.Allocate(Tok.getLength()+1, 1));
+  const char *Spelling = Buf;
+  unsigned Len = getSpelling(Tok, Spelling);
+  assert(Spelling == Buf && "Cleaned token not copied into the buffer?");
+  Buf[Len] = 0;
+  return llvm::StringRef(Buf, Len);
+}
+
 /// CreateString - Plop the specified string into a scratch buffer and return a
 /// location for it.  If specified, the source location provides a source
 /// location for the token.
@@ -464,6 +561,12 @@ void Preprocessor::EnterMainSourceFile() {
   bool Res = EnterSourceFile(MainFileID, 0, ErrorStr);
   assert(!Res && "Entering main file should not fail!");
 
+  // Skip the preamble of the main file; the implicit PCH already provided it.
+  // Locations in the rest of the file are unaffected.
+  if (SkipMainFilePreambleBytes && CurLexer)
+    CurLexer->BufferPtr += std::min(SkipMainFilePreambleBytes,
+                      unsigned(CurLexer->BufferEnd - CurLexer->BufferPtr));
+
   // Tell the header info that the main file was entered.  If the file is later
   // #imported, it won't be re-entered.
   if (const FileEntry *FE = SourceMgr.getFileEntryForID(MainFileID))
@@ -481,6 +584,14 @@ void Preprocessor::EnterMainSourceFile() {
   // Start parsing the predefines.
   Res = EnterSourceFile(FID, 0, ErrorStr);
   assert(!Res && "Entering predefines should not fail!");
+
+  // Install the macros precomputed for the start of the predefines and skip
+  // over their definitions.
+  if (Precomputed && Precomputed->canInstall(*this)) {
+    assert(CurLexer && "Predefines are not lexed by a Lexer?");
+    Precomputed->Install(*this, FID);
+    CurLexer->BufferPtr += Precomputed->getText().size();
+  }
 }
 
 
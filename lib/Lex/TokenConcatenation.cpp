@@ -23,14 +23,7 @@ bool TokenConcatenation::StartsWithL(const Token &Tok) const {
     return *SM.getCharacterData(SM.getSpellingLoc(Tok.getLocation())) == 'L';
   }
 
-  if (Tok.getLength() < 256) {
-    char Buffer[256];
-    const char *TokPtr = Buffer;
-    PP.getSpelling(Tok, TokPtr);
-    return TokPtr[0] == 'L';
-  }
-
-  return PP.getSpelling(Tok)[0] == 'L';
+  return PP.getSpellingRef(Tok)[0] == 'L';
 }
 
 /// IsIdentifierL - Return true if the spelling of this token is literally
@@ -43,15 +36,7 @@ bool TokenConcatenation::IsIdentifierL(const Token &Tok) const {
     return *SM.getCharacterData(SM.getSpellingLoc(Tok.getLocation())) == 'L';
   }
 
-  if (Tok.getLength() < 256) {
-    char Buffer[256];
-    const char *TokPtr = Buffer;
-    if (PP.getSpelling(Tok, TokPtr) != 1)
-      return false;
-    return TokPtr[0] == 'L';
-  }
-
-  return PP.getSpelling(Tok) == "L";
+  return PP.getSpellingRef(Tok) == "L";
 }
 
 TokenConcatenation::TokenConcatenation(Preprocessor &pp) : PP(pp) {
@@ -103,13 +88,8 @@ static char GetFirstChar(Preprocessor &PP, const Token &Tok) {
       SourceManager &SM = PP.getSourceManager();
       return *SM.getCharacterData(SM.getSpellingLoc(Tok.getLocation()));
     }
-  } else if (Tok.getLength() < 256) {
-    char Buffer[256];
-    const char *TokPtr = Buffer;
-    PP.getSpelling(Tok, TokPtr);
-    return TokPtr[0];
   } else {
-    return PP.getSpelling(Tok)[0];
+    return PP.getSpellingRef(Tok)[0];
   }
 }
 
@@ -41,6 +41,21 @@ void TokenLexer::Init(Token &Tok, SourceLocation ILEnd, MacroArgs *Actuals) {
   DisableMacroExpansion = false;
   NumTokens = Macro->tokens_end()-Macro->tokens_begin();
 
+  // Create a single instantiation entry that covers the whole replacement
+  // list, so that tokens from the macro body share it.  Tokens that come from
+  // elsewhere (arguments, pastes) still get an entry of their own.
+  SourceManager &SM = PP.getSourceManager();
+  MacroDefLength = Macro->getDefinitionLength(SM);
+  if (MacroDefLength) {
+    MacroDefStart = Macro->tokens_begin()->getLocation();
+    MacroExpansionStart = SM.createInstantiationLoc(MacroDefStart,
+                                                    InstantiateLocStart,
+                                                    InstantiateLocEnd,
+                                                    MacroDefLength);
+  } else {
+    MacroDefStart = MacroExpansionStart = SourceLocation();
+  }
+
   // If this is a function-like macro, expand the arguments and change
   // Tokens to point to the expanded tokens.
   if (Macro->isFunctionLike() && Macro->getNumArgs())
@@ -70,6 +85,8 @@ void TokenLexer::Init(const Token *TokArray, unsigned NumToks,
   NumTokens = NumToks;
   CurToken = 0;
   InstantiateLocStart = InstantiateLocEnd = SourceLocation();
+  MacroDefStart = MacroExpansionStart = SourceLocation();
+  MacroDefLength = 0;
   AtStartOfLine = false;
   HasLeadingSpace = false;
 
@@ -335,11 +352,18 @@ void TokenLexer::Lex(Token &Tok) {
   // InstantiationLoc.  Pull this information together into a new SourceLocation
   // that captures all of this.
   if (InstantiateLocStart.isValid()) {   // Don't do this for token streams.
-    SourceManager &SM = PP.getSourceManager();
-    Tok.setLocation(SM.createInstantiationLoc(Tok.getLocation(),
-                                              InstantiateLocStart,
-                                              InstantiateLocEnd,
-                                              Tok.getLength()));
+    SourceLocation Loc = Tok.getLocation();
+    unsigned RelOffset = Loc.getRawEncoding() - MacroDefStart.getRawEncoding();
+    if (MacroDefLength && Loc.isFileID() && RelOffset < MacroDefLength) {
+      // The token was spelled in the macro body; locate it within the
+      // instantiation entry of the whole body.
+      Tok.setLocation(MacroExpansionStart.getFileLocWithOffset(RelOffset));
+    } else {
+      SourceManager &SM = PP.getSourceManager();
+      Tok.setLocation(SM.createInstantiationLoc(Loc, InstantiateLocStart,
+                                                InstantiateLocEnd,
+                                                Tok.getLength()));
+    }
   }
 
   // If this is the first token, set the lexical properties of the token to
@@ -374,6 +398,45 @@ void TokenLexer::Lex(Token &Tok) {
   // Otherwise, return a normal token.
 }
 
+/// isPlainIdentifierBody - Return true if Str only contains letters, digits
+/// and underscores, which continue both an identifier and a pp-number.
+static bool isPlainIdentifierBody(const char *Str, unsigned Len) {
+  for (const char *End = Str + Len; Str != End; ++Str) {
+    char C = *Str;
+    if (!((C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') ||
+          (C >= '0' && C <= '9') || C == '_'))
+      return false;
+  }
+  return true;
+}
+
+/// getFastPasteKind - Return the kind of the token formed by pasting RHS
+/// (spelled RHSStr) onto LHS when it can be decided from the spellings
+/// alone, or tok::unknown if the pasted spelling has to be lexed.
+static tok::TokenKind getFastPasteKind(const Token &LHS, const Token &RHS,
+                                       const char *RHSStr, unsigned RHSLen) {
+  // Keywords (and C++ alternative operator names) carry identifier info and
+  // are spelled like identifiers, so only the spelling matters here.
+  bool LHSIsIdent = LHS.is(tok::identifier) || LHS.getIdentifierInfo();
+  bool RHSIsIdent = RHS.is(tok::identifier) || RHS.getIdentifierInfo();
+
+  if (LHSIsIdent) {
+    // identifier ## identifier and identifier ## 123 form an identifier.
+    // Numbers like 1.0 or 1e+2 do not continue an identifier.
+    if (RHSIsIdent ||
+        (RHS.is(tok::numeric_constant) &&
+         isPlainIdentifierBody(RHSStr, RHSLen)))
+      return tok::identifier;
+  } else if (LHS.is(tok::numeric_constant)) {
+    // A pp-number absorbs a following number, and a following identifier
+    // as long as it has no '$' or other extended characters.
+    if (RHS.is(tok::numeric_constant) ||
+        (RHSIsIdent && isPlainIdentifierBody(RHSStr, RHSLen)))
+      return tok::numeric_constant;
+  }
+  return tok::unknown;
+}
+
 /// PasteTokens - Tok is the LHS of a ## operator, and CurToken is the ##
 /// operator.  Read the ## and RHS, and paste the LHS/RHS together.  If there
 /// are more ## after it, chomp them iteratively.  Return the result as Tok.
@@ -423,14 +486,19 @@ bool TokenLexer::PasteTokens(Token &Tok) {
     // Lex the resultant pasted token into Result.
     Token Result;
 
-    if (Tok.is(tok::identifier) && RHS.is(tok::identifier)) {
-      // Common paste case: identifier+identifier = identifier.  Avoid creating
-      // a lexer and other overhead.
+    tok::TokenKind FastKind = getFastPasteKind(Tok, RHS, &Buffer[LHSLen],
+                                               RHSLen);
+    if (FastKind != tok::unknown) {
+      // Common paste cases: identifier+identifier and identifier+number form
+      // an identifier, number+identifier and number+number form a number.
+      // Avoid creating a lexer and other overhead.
       PP.IncrementPasteCounter(true);
       Result.startToken();
-      Result.setKind(tok::identifier);
+      Result.setKind(FastKind);
       Result.setLocation(ResultTokLoc);
       Result.setLength(LHSLen+RHSLen);
+      if (FastKind == tok::numeric_constant)
+        Result.setLiteralData(ResultTokStrPtr);
     } else {
       PP.IncrementPasteCounter(false);
 
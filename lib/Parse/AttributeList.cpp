@@ -14,8 +14,76 @@
 #include "clang/Parse/AttributeList.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
 using namespace clang;
 
+AttributeListPool::AttributeListPool()
+  : NumAttrAllocations(0), NumAttrsReused(0), NumArgAllocations(0),
+    NumArgsReused(0) {
+  for (unsigned I = 0; I <= MaxPooledArgs; ++I)
+    FreeLists[I] = 0;
+}
+
+AttributeListPool::~AttributeListPool() {
+  for (unsigned I = 0; I <= MaxPooledArgs; ++I)
+    while (FreeNode *N = FreeLists[I]) {
+      FreeLists[I] = N->Next;
+      free(N);
+    }
+}
+
+void *AttributeListPool::allocate(unsigned Slot, size_t Size) {
+  if (FreeNode *N = FreeLists[Slot]) {
+    FreeLists[Slot] = N->Next;
+    return N;
+  }
+  return malloc(Size < sizeof(FreeNode) ? sizeof(FreeNode) : Size);
+}
+
+void AttributeListPool::deallocate(unsigned Slot, void *Ptr) {
+  FreeNode *N = static_cast<FreeNode*>(Ptr);
+  N->Next = FreeLists[Slot];
+  FreeLists[Slot] = N;
+}
+
+void *AttributeListPool::AllocateAttr(size_t Size) {
+  assert(Size == sizeof(AttributeList) && "Pool only holds AttributeLists!");
+  ++NumAttrAllocations;
+  if (FreeLists[0])
+    ++NumAttrsReused;
+  AttributeListPool **Mem = static_cast<AttributeListPool **>(
+    allocate(0, sizeof(AttributeListPool *) + Size));
+  *Mem = this;
+  return Mem + 1;
+}
+
+ActionBase::ExprTy **AttributeListPool::AllocateArgs(unsigned NumArgs) {
+  ++NumArgAllocations;
+  if (NumArgs > MaxPooledArgs)
+    return new ActionBase::ExprTy*[NumArgs];
+
+  if (FreeLists[NumArgs])
+    ++NumArgsReused;
+  return static_cast<ActionBase::ExprTy **>(
+    allocate(NumArgs, NumArgs * sizeof(ActionBase::ExprTy*)));
+}
+
+void AttributeListPool::DeallocateArgs(ActionBase::ExprTy **Args,
+                                       unsigned NumArgs) {
+  if (NumArgs > MaxPooledArgs)
+    delete [] Args;
+  else
+    deallocate(NumArgs, Args);
+}
+
+void AttributeListPool::PrintStats() const {
+  llvm::errs() << NumAttrAllocations << " attribute lists allocated, "
+               << NumAttrsReused << " reused from the pool.\n";
+  llvm::errs() << NumArgAllocations << " attribute argument arrays allocated, "
+               << NumArgsReused << " reused from the pool.\n";
+}
+
 AttributeList::AttributeList(IdentifierInfo *aName, SourceLocation aLoc,
                              IdentifierInfo *sName, SourceLocation sLoc,
                              IdentifierInfo *pName, SourceLocation pLoc,
@@ -28,7 +96,7 @@ AttributeList::AttributeList(IdentifierInfo *aName, SourceLocation aLoc,
   if (numArgs == 0)
     Args = 0;
   else {
-    Args = new ActionBase::ExprTy*[numArgs];
+    Args = getPool().AllocateArgs(numArgs);
     memcpy(Args, ExprList, numArgs*sizeof(Args[0]));
   }
 }
@@ -42,7 +110,7 @@ AttributeList::~AttributeList() {
     // ParseField, ParseTag. Once these routines have freed the expression,
     // they should zero out the Args slot (to indicate the memory has been
     // freed). If any element of the vector is non-null, we should assert.
-    delete [] Args;
+    getPool().DeallocateArgs(Args, NumArgs);
   }
   delete Next;
 }
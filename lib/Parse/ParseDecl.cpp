@@ -121,8 +121,9 @@ AttributeList *Parser::ParseGNUAttributes(SourceLocation *EndLoc) {
           if (Tok.is(tok::r_paren)) {
             // __attribute__(( mode(byte) ))
             ConsumeParen(); // ignore the right paren loc for now
-            CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc,
-                                         ParmName, ParmLoc, 0, 0, CurrAttr);
+            CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                    AttrNameLoc, ParmName,
+                                                    ParmLoc, 0, 0, CurrAttr);
           } else if (Tok.is(tok::comma)) {
             ConsumeToken();
             // __attribute__(( format(printf, 1, 2) ))
@@ -145,10 +146,11 @@ AttributeList *Parser::ParseGNUAttributes(SourceLocation *EndLoc) {
             }
             if (ArgExprsOk && Tok.is(tok::r_paren)) {
               ConsumeParen(); // ignore the right paren loc for now
-              CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0,
-                                           AttrNameLoc, ParmName, ParmLoc,
-                                           ArgExprs.take(), ArgExprs.size(),
-                                           CurrAttr);
+              CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                      AttrNameLoc, ParmName,
+                                                      ParmLoc, ArgExprs.take(),
+                                                      ArgExprs.size(),
+                                                      CurrAttr);
             }
           }
         } else { // not an identifier
@@ -157,8 +159,10 @@ AttributeList *Parser::ParseGNUAttributes(SourceLocation *EndLoc) {
           // parse a possibly empty comma separated list of expressions
             // __attribute__(( nonnull() ))
             ConsumeParen(); // ignore the right paren loc for now
-            CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc,
-                                         0, SourceLocation(), 0, 0, CurrAttr);
+            CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                    AttrNameLoc, 0,
+                                                    SourceLocation(), 0, 0,
+                                                    CurrAttr);
             break;
           case tok::kw_char:
           case tok::kw_wchar_t:
@@ -177,8 +181,10 @@ AttributeList *Parser::ParseGNUAttributes(SourceLocation *EndLoc) {
             // If it's a builtin type name, eat it and expect a rparen
             // __attribute__(( vec_type_hint(char) ))
             ConsumeToken();
-            CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc,
-                                         0, SourceLocation(), 0, 0, CurrAttr);
+            CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                    AttrNameLoc, 0,
+                                                    SourceLocation(), 0, 0,
+                                                    CurrAttr);
             if (Tok.is(tok::r_paren))
               ConsumeParen();
             break;
@@ -204,17 +210,21 @@ AttributeList *Parser::ParseGNUAttributes(SourceLocation *EndLoc) {
             // Match the ')'.
             if (ArgExprsOk && Tok.is(tok::r_paren)) {
               ConsumeParen(); // ignore the right paren loc for now
-              CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0,
-                           AttrNameLoc, 0, SourceLocation(), ArgExprs.take(),
-                           ArgExprs.size(),
-                           CurrAttr);
+              CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                      AttrNameLoc, 0,
+                                                      SourceLocation(),
+                                                      ArgExprs.take(),
+                                                      ArgExprs.size(),
+                                                      CurrAttr);
             }
             break;
           }
         }
       } else {
-        CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc,
-                                     0, SourceLocation(), 0, 0, CurrAttr);
+        CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                AttrNameLoc, 0,
+                                                SourceLocation(), 0, 0,
+                                                CurrAttr);
       }
     }
     if (ExpectAndConsume(tok::r_paren, diag::err_expected_rparen))
@@ -257,15 +267,17 @@ AttributeList* Parser::ParseMicrosoftDeclSpec(AttributeList *CurrAttr) {
       OwningExprResult ArgExpr(ParseAssignmentExpression());
       if (!ArgExpr.isInvalid()) {
         ExprTy* ExprList = ArgExpr.take();
-        CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc, 0,
-                                     SourceLocation(), &ExprList, 1,
-                                     CurrAttr, true);
+        CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                                AttrNameLoc, 0,
+                                                SourceLocation(), &ExprList, 1,
+                                                CurrAttr, true);
       }
       if (ExpectAndConsume(tok::r_paren, diag::err_expected_rparen))
         SkipUntil(tok::r_paren, false);
     } else {
-      CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc,
-                                   0, SourceLocation(), 0, 0, CurrAttr, true);
+      CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                              AttrNameLoc, 0, SourceLocation(),
+                                              0, 0, CurrAttr, true);
     }
   }
   if (ExpectAndConsume(tok::r_paren, diag::err_expected_rparen))
@@ -284,8 +296,9 @@ AttributeList* Parser::ParseMicrosoftTypeAttributes(AttributeList *CurrAttr) {
     if (Tok.is(tok::kw___ptr64) || Tok.is(tok::kw___w64))
       // FIXME: Support these properly!
       continue;
-    CurrAttr = new AttributeList(AttrName, AttrNameLoc, 0, AttrNameLoc, 0,
-                                 SourceLocation(), 0, 0, CurrAttr, true);
+    CurrAttr = new (AttrPool) AttributeList(AttrName, AttrNameLoc, 0,
+                                            AttrNameLoc, 0, SourceLocation(), 0,
+                                            0, CurrAttr, true);
   }
   return CurrAttr;
 }
@@ -1898,9 +1898,9 @@ CXX0XAttributeList Parser::ParseCXX0XAttributes(SourceLocation *EndLoc) {
           break;
         }
 
-        CurrAttr = new AttributeList(AttrName, AttrLoc, 0, AttrLoc, 0,
-                                     SourceLocation(), 0, 0, CurrAttr, false,
-                                     true);
+        CurrAttr = new (AttrPool) AttributeList(AttrName, AttrLoc, 0, AttrLoc,
+                                                0, SourceLocation(), 0, 0,
+                                                CurrAttr, false, true);
         AttrParsed = true;
         break;
       }
@@ -1920,9 +1920,9 @@ CXX0XAttributeList Parser::ParseCXX0XAttributes(SourceLocation *EndLoc) {
 
         ExprVector ArgExprs(Actions);
         ArgExprs.push_back(ArgExpr.release());
-        CurrAttr = new AttributeList(AttrName, AttrLoc, 0, AttrLoc,
-                                     0, ParamLoc, ArgExprs.take(), 1, CurrAttr,
-                                     false, true);
+        CurrAttr = new (AttrPool) AttributeList(AttrName, AttrLoc, 0, AttrLoc,
+                                                0, ParamLoc, ArgExprs.take(), 1,
+                                                CurrAttr, false, true);
 
         AttrParsed = true;
         break;
@@ -1426,6 +1426,28 @@ Parser::DeclPtrTy Parser::ParseFunctionStatementBody(DeclPtrTy Decl) {
                                         PP.getSourceManager(),
                                         "parsing function body");
 
+  // Skip over the body, leaving the braces balanced, if it isn't wanted.
+  if (SkipFunctionBodies) {
+    if (!CacheSkippedFunctionBodies || !Decl) {
+      ConsumeBrace();
+      SkipUntil(tok::r_brace, /*StopAtSemi=*/false, /*DontConsume=*/true);
+    } else {
+      CachedTokens *Toks = new CachedTokens;
+      Toks->push_back(Tok);
+      ConsumeBrace();
+      ConsumeAndStoreUntil(tok::r_brace, tok::unknown, *Toks, tok::unknown,
+                           /*ConsumeFinalToken=*/false);
+      if (Tok.is(tok::r_brace)) {
+        Toks->push_back(Tok);
+        delete SkippedBodyTokens[Decl.get()];
+        SkippedBodyTokens[Decl.get()] = Toks;
+      } else
+        delete Toks;
+    }
+    SourceLocation RBraceLoc = MatchRHSPunctuation(tok::r_brace, LBraceLoc);
+    return Actions.ActOnSkippedFunctionBody(Decl, LBraceLoc, RBraceLoc);
+  }
+
   // Do not enter a scope for the brace, as the arguments are in the same scope
   // (the function body) as the body itself.  Instead, just read the statement
   // list and put it into a CompoundStmt for safe keeping.
@@ -1439,6 +1461,76 @@ Parser::DeclPtrTy Parser::ParseFunctionStatementBody(DeclPtrTy Decl) {
   return Actions.ActOnFinishFunctionBody(Decl, move(FnBody));
 }
 
+bool Parser::ParseSkippedFunctionBody(DeclPtrTy Decl) {
+  llvm::DenseMap<void *, CachedTokens *>::iterator Pos
+    = SkippedBodyTokens.find(Decl.get());
+  if (Pos == SkippedBodyTokens.end())
+    return true;
+  llvm::OwningPtr<CachedTokens> Toks(Pos->second);
+  SkippedBodyTokens.erase(Pos);
+
+  ParseScope FnScope(this, Scope::FnScope|Scope::DeclScope);
+  if (!Actions.ActOnStartOfSkippedFunctionBody(CurScope, Decl))
+    return true;
+
+  // Append the current token, the end of the translation unit, so that the
+  // parser stops right after the body.  The token stream owns its copy of the
+  // tokens, since it stays on the lexer stack once it is exhausted.
+  assert(Tok.is(tok::eof) && "Translation unit not parsed yet!");
+  Toks->push_back(Tok);
+  Token *Buffer = new Token[Toks->size()];
+  std::copy(Toks->begin(), Toks->end(), Buffer);
+  PP.EnterTokenStream(Buffer, Toks->size(), true, true);
+  ConsumeAnyToken();
+  assert(Tok.is(tok::l_brace) && "Skipped body not starting with '{'");
+
+  bool WasSkipping = SkipFunctionBodies;
+  SkipFunctionBodies = false;
+  ParseFunctionStatementBody(Decl);
+  SkipFunctionBodies = WasSkipping;
+  assert(Tok.is(tok::eof) && "Skipped body not parsed completely");
+
+  FnScope.Exit();
+  Actions.ActOnFinishSkippedFunctionBody(Decl);
+  return false;
+}
+
+bool Parser::ReplaceSkippedFunctionBody(DeclPtrTy Decl, FileID BodyFile,
+                                        SourceRange &BodyRange) {
+  // Lex the file on top of a stream holding the end of the translation unit,
+  // so that the end of the file pops back to a lexer that yields it again.
+  assert(Tok.is(tok::eof) && "Translation unit not parsed yet!");
+  Token *EofTok = new Token[1];
+  EofTok[0] = Tok;
+  PP.EnterTokenStream(EofTok, 1, true, true);
+  std::string ErrorStr;
+  if (PP.EnterSourceFile(BodyFile, 0, ErrorStr))
+    return true;
+
+  llvm::OwningPtr<CachedTokens> Toks(new CachedTokens);
+  unsigned Depth = 0;
+  bool IsBody = true;
+  Token BodyTok;
+  for (PP.Lex(BodyTok); BodyTok.isNot(tok::eof); PP.Lex(BodyTok)) {
+    // Every token but the last must be within the outermost braces.
+    if (Toks->empty() ? BodyTok.isNot(tok::l_brace) : Depth == 0)
+      IsBody = false;
+    if (BodyTok.is(tok::l_brace))
+      ++Depth;
+    else if (BodyTok.is(tok::r_brace) && Depth)
+      --Depth;
+    Toks->push_back(BodyTok);
+  }
+  if (!IsBody || Toks->empty() || Depth != 0)
+    return true;
+
+  BodyRange = SourceRange(Toks->front().getLocation(),
+                          Toks->back().getLocation());
+  delete SkippedBodyTokens[Decl.get()];
+  SkippedBodyTokens[Decl.get()] = Toks.take();
+  return false;
+}
+
 /// ParseFunctionTryBlock - Parse a C++ function-try-block.
 ///
 ///       function-try-block:
@@ -109,6 +109,12 @@ bool Parser::isCXXSimpleDeclaration() {
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '('.
   // We need tentative parsing...
 
+  SourceLocation StartLoc = Tok.getLocation();
+  unsigned Generation = Actions.getNameLookupGeneration();
+  unsigned Memo;
+  if (PP.LookupDisambiguation(TPK_SimpleDeclaration, StartLoc, Generation, Memo))
+    return Memo;
+
   TentativeParsingAction PA(*this);
 
   TPR = TryParseSimpleDeclaration();
@@ -117,14 +123,13 @@ bool Parser::isCXXSimpleDeclaration() {
   PA.Revert();
 
   // In case of an error, let the declaration parsing code handle it.
-  if (TPR == TPResult::Error())
-    return true;
-
   // Declarations take precedence over expressions.
-  if (TPR == TPResult::Ambiguous())
+  if (TPR == TPResult::Error() || TPR == TPResult::Ambiguous())
     TPR = TPResult::True();
 
   assert(TPR == TPResult::True() || TPR == TPResult::False());
+  PP.RecordDisambiguation(TPK_SimpleDeclaration, StartLoc, Generation,
+                          TPR == TPResult::True());
   return TPR == TPResult::True();
 }
 
@@ -237,6 +242,12 @@ bool Parser::isCXXConditionDeclaration() {
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '('.
   // We need tentative parsing...
 
+  SourceLocation StartLoc = Tok.getLocation();
+  unsigned Generation = Actions.getNameLookupGeneration();
+  unsigned Memo;
+  if (PP.LookupDisambiguation(TPK_ConditionDeclaration, StartLoc, Generation, Memo))
+    return Memo;
+
   TentativeParsingAction PA(*this);
 
   // type-specifier-seq
@@ -266,6 +277,8 @@ bool Parser::isCXXConditionDeclaration() {
   PA.Revert();
 
   assert(TPR == TPResult::True() || TPR == TPResult::False());
+  PP.RecordDisambiguation(TPK_ConditionDeclaration, StartLoc, Generation,
+                          TPR == TPResult::True());
   return TPR == TPResult::True();
 }
 
@@ -308,6 +321,18 @@ bool Parser::isCXXTypeId(TentativeCXXTypeIdContext Context, bool &isAmbiguous) {
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '('.
   // We need tentative parsing...
 
+  // The memo holds whether this is a type-id in bit 0, and whether that was
+  // ambiguous in bit 1.
+  TentativeParseKind Kind = Context == TypeIdInParens
+    ? TPK_TypeIdInParens : TPK_TypeIdAsTemplateArgument;
+  SourceLocation StartLoc = Tok.getLocation();
+  unsigned Generation = Actions.getNameLookupGeneration();
+  unsigned Memo;
+  if (PP.LookupDisambiguation(Kind, StartLoc, Generation, Memo)) {
+    isAmbiguous = Memo & 2;
+    return Memo & 1;
+  }
+
   TentativeParsingAction PA(*this);
 
   // type-specifier-seq
@@ -347,6 +372,8 @@ bool Parser::isCXXTypeId(TentativeCXXTypeIdContext Context, bool &isAmbiguous) {
   PA.Revert();
 
   assert(TPR == TPResult::True() || TPR == TPResult::False());
+  PP.RecordDisambiguation(Kind, StartLoc, Generation,
+                          (TPR == TPResult::True()) | (isAmbiguous << 1));
   return TPR == TPResult::True();
 }
 
@@ -885,6 +912,13 @@ bool Parser::isCXXFunctionDeclarator(bool warnIfAmbiguous) {
   // ambiguities mentioned in 6.8, the resolution is to consider any construct
   // that could possibly be a declaration a declaration.
 
+  // Ambiguous results are not memoized, so that the warning is still given.
+  SourceLocation StartLoc = Tok.getLocation();
+  unsigned Generation = Actions.getNameLookupGeneration();
+  unsigned Memo;
+  if (PP.LookupDisambiguation(TPK_FunctionDeclarator, StartLoc, Generation, Memo))
+    return Memo;
+
   TentativeParsingAction PA(*this);
 
   ConsumeParen();
@@ -897,7 +931,7 @@ bool Parser::isCXXFunctionDeclarator(bool warnIfAmbiguous) {
 
   // In case of an error, let the declaration parsing code handle it.
   if (TPR == TPResult::Error())
-    return true;
+    TPR = TPResult::True();
 
   if (TPR == TPResult::Ambiguous()) {
     // Function declarator has precedence over constructor-style initializer.
@@ -908,6 +942,8 @@ bool Parser::isCXXFunctionDeclarator(bool warnIfAmbiguous) {
     return true;
   }
 
+  PP.RecordDisambiguation(TPK_FunctionDeclarator, StartLoc, Generation,
+                          TPR == TPResult::True());
   return TPR == TPResult::True();
 }
 
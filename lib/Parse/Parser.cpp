@@ -35,10 +35,11 @@ public:
   }
 };
 
-Parser::Parser(Preprocessor &pp, Action &actions)
+Parser::Parser(Preprocessor &pp, Action &actions, bool skipFunctionBodies)
   : CrashInfo(*this), PP(pp), Actions(actions), Diags(PP.getDiagnostics()),
     GreaterThanIsOperator(true), ColonIsSacred(false),
-    TemplateParameterDepth(0) {
+    TemplateParameterDepth(0), SkipFunctionBodies(skipFunctionBodies),
+    CacheSkippedFunctionBodies(false), NonTypeNamesGeneration(0) {
   Tok.setKind(tok::eof);
   CurScope = 0;
   NumCachedScopes = 0;
@@ -64,6 +65,15 @@ Parser::Parser(Preprocessor &pp, Action &actions)
   PP.AddCommentHandler(CommentHandler.get());
 }
 
+/// ignoreComments - Stop passing comments to the action.  The lexer then
+/// skips comments without calling out for each one.
+void Parser::ignoreComments() {
+  if (!CommentHandler)
+    return;
+  PP.RemoveCommentHandler(CommentHandler.get());
+  CommentHandler.reset();
+}
+
 /// If a crash happens while the parser is active, print out a line indicating
 /// what the current token is.
 void PrettyStackTraceParserEntry::print(llvm::raw_ostream &OS) const {
@@ -287,6 +297,7 @@ void Parser::ExitScope() {
 
   Scope *OldScope = CurScope;
   CurScope = OldScope->getParent();
+  NonTypeNames.clear();
 
   if (NumCachedScopes == ScopeCacheSize)
     delete OldScope;
@@ -316,7 +327,18 @@ Parser::~Parser() {
   UnusedHandler.reset();
   PP.RemovePragmaHandler(0, WeakHandler.get());
   WeakHandler.reset();
-  PP.RemoveCommentHandler(CommentHandler.get());
+  if (CommentHandler)
+    PP.RemoveCommentHandler(CommentHandler.get());
+
+  for (llvm::DenseMap<void *, CachedTokens *>::iterator
+         I = SkippedBodyTokens.begin(), E = SkippedBodyTokens.end();
+       I != E; ++I)
+    delete I->second;
+}
+
+void Parser::PrintStats() const {
+  llvm::errs() << "\n*** Parser Stats:\n";
+  AttrPool.PrintStats();
 }
 
 /// Initialize - Warm up the parser.
@@ -872,6 +894,15 @@ Parser::OwningExprResult Parser::ParseSimpleAsm(SourceLocation *EndLoc) {
   return move(Result);
 }
 
+bool Parser::isKnownNonTypeName(const NonTypeName &Name) {
+  unsigned Generation = Actions.getNameLookupGeneration();
+  if (Generation != NonTypeNamesGeneration) {
+    NonTypeNames.clear();
+    NonTypeNamesGeneration = Generation;
+  }
+  return NonTypeNames.count(Name);
+}
+
 /// TryAnnotateTypeOrScopeToken - If the current token position is on a
 /// typename (possibly qualified in C++) or a C++ scope specifier not followed
 /// by a typename, TryAnnotateTypeOrScopeToken will replace one or more tokens
@@ -961,9 +992,24 @@ bool Parser::TryAnnotateTypeOrScopeToken(bool EnteringContext) {
     ParseOptionalCXXScopeSpecifier(SS, /*ObjectType=*/0, EnteringContext);
 
   if (Tok.is(tok::identifier)) {
-    // Determine whether the identifier is a type name.
-    if (TypeTy *Ty = Actions.getTypeName(*Tok.getIdentifierInfo(),
-                                         Tok.getLocation(), CurScope, &SS)) {
+    // Determine whether the identifier is a type name.  Type names are
+    // remembered by annotating the cached tokens below; other names are
+    // remembered in NonTypeNames.
+    NonTypeName Name(std::make_pair(Tok.getIdentifierInfo(), CurScope),
+                     SS.getScopeRep());
+    TypeTy *Ty = 0;
+    if (SS.isInvalid() || !isKnownNonTypeName(Name)) {
+      // A lookup that diagnosed something, such as an incomplete class in
+      // the nested-name-specifier, has to run again to diagnose it again.
+      unsigned NumDiagnostics = Diags.getNumDiagnostics();
+      Ty = Actions.getTypeName(*Tok.getIdentifierInfo(), Tok.getLocation(),
+                               CurScope, &SS);
+      if (!Ty && !SS.isInvalid() && NonTypeNamesGeneration &&
+          Diags.getNumDiagnostics() == NumDiagnostics)
+        NonTypeNames.insert(Name);
+    }
+
+    if (Ty) {
       // This is a typename. Replace the current token in-place with an
       // annotation type token.
       Tok.setKind(tok::annot_typename);
@@ -350,12 +350,27 @@ void html::AddHeaderFooterInternalBuiltinCSS(Rewriter& R, FileID FID,
 /// table state from the end of the file, so it won't be perfectly perfect,
 /// but it will be reasonably close.
 void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
-  RewriteBuffer &RB = R.getEditBuffer(FID);
+  std::vector<Highlight> Highlights;
+  FindSyntaxHighlights(FID, PP, Highlights);
+  ApplyHighlights(R, FID, Highlights);
+}
+
+static void AddHighlight(std::vector<html::Highlight> &Highlights,
+                         unsigned B, unsigned E,
+                         const char *StartTag, const char *EndTag) {
+  html::Highlight H;
+  H.Begin = B;
+  H.End = E;
+  H.StartTag = StartTag;
+  H.EndTag = EndTag;
+  Highlights.push_back(H);
+}
 
+void html::LexRawTokens(FileID FID, const Preprocessor &PP,
+                        std::vector<Token> &Tokens) {
   const SourceManager &SM = PP.getSourceManager();
   const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
   Lexer L(FID, FromFile, SM, PP.getLangOptions());
-  const char *BufferStart = L.getBufferStart();
 
   // Inform the preprocessor that we want to retain comments as tokens, so we
   // can highlight them.
@@ -364,8 +379,27 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
   // Lex all the tokens in raw mode, to avoid entering #includes or expanding
   // macros.
   Token Tok;
-  L.LexFromRawLexer(Tok);
+  do {
+    L.LexFromRawLexer(Tok);
+    Tokens.push_back(Tok);
+  } while (Tok.isNot(tok::eof));
+}
+
+void html::FindSyntaxHighlights(FileID FID, const Preprocessor &PP,
+                                std::vector<Highlight> &Highlights) {
+  std::vector<Token> RawTokens;
+  LexRawTokens(FID, PP, RawTokens);
+  FindSyntaxHighlights(FID, PP, RawTokens, Highlights);
+}
 
+void html::FindSyntaxHighlights(FileID FID, const Preprocessor &PP,
+                                const std::vector<Token> &RawTokens,
+                                std::vector<Highlight> &Highlights) {
+  const SourceManager &SM = PP.getSourceManager();
+  const char *BufferStart = SM.getBufferData(FID).first;
+
+  unsigned Idx = 0;
+  Token Tok = RawTokens[Idx];
   while (Tok.isNot(tok::eof)) {
     // Since we are lexing unexpanded tokens, all tokens are from the main
     // FileID.
@@ -381,13 +415,13 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
 
       // If this is a pp-identifier, for a keyword, highlight it as such.
       if (II->getTokenID() != tok::identifier)
-        HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                       "<span class='keyword'>", "</span>");
+        AddHighlight(Highlights, TokOffs, TokOffs+TokLen,
+                     "<span class='keyword'>", "</span>");
       break;
     }
     case tok::comment:
-      HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                     "<span class='comment'>", "</span>");
+      AddHighlight(Highlights, TokOffs, TokOffs+TokLen,
+                   "<span class='comment'>", "</span>");
       break;
     case tok::wide_string_literal:
       // Chop off the L prefix
@@ -395,8 +429,8 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
       --TokLen;
       // FALL THROUGH.
     case tok::string_literal:
-      HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                     "<span class='string_literal'>", "</span>");
+      AddHighlight(Highlights, TokOffs, TokOffs+TokLen,
+                   "<span class='string_literal'>", "</span>");
       break;
     case tok::hash: {
       // If this is a preprocessor directive, all tokens to end of line are too.
@@ -406,22 +440,22 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
       // Eat all of the tokens until we get to the next one at the start of
       // line.
       unsigned TokEnd = TokOffs+TokLen;
-      L.LexFromRawLexer(Tok);
+      Tok = RawTokens[++Idx];
       while (!Tok.isAtStartOfLine() && Tok.isNot(tok::eof)) {
         TokEnd = SM.getFileOffset(Tok.getLocation())+Tok.getLength();
-        L.LexFromRawLexer(Tok);
+        Tok = RawTokens[++Idx];
       }
 
       // Find end of line.  This is a hack.
-      HighlightRange(RB, TokOffs, TokEnd, BufferStart,
-                     "<span class='directive'>", "</span>");
+      AddHighlight(Highlights, TokOffs, TokEnd,
+                   "<span class='directive'>", "</span>");
 
       // Don't skip the next token.
       continue;
     }
     }
 
-    L.LexFromRawLexer(Tok);
+    Tok = RawTokens[++Idx];
   }
 }
 
@@ -441,18 +475,45 @@ class IgnoringDiagClient : public DiagnosticClient {
 /// macro expansions.  This won't be perfectly perfect, but it will be
 /// reasonably close.
 void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP) {
-  // Re-lex the raw token stream into a token buffer.
-  const SourceManager &SM = PP.getSourceManager();
-  std::vector<Token> TokenStream;
+  std::vector<Highlight> Highlights;
+  FindMacroHighlights(FID, PP, Highlights);
+  ApplyHighlights(R, FID, Highlights);
+}
 
-  const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
-  Lexer L(FID, FromFile, SM, PP.getLangOptions());
+void html::FindMacroHighlights(FileID FID, const Preprocessor &PP,
+                               std::vector<Highlight> &Highlights) {
+  std::vector<Token> RawTokens;
+  LexRawTokens(FID, PP, RawTokens);
+  FindMacroHighlights(FID, PP, RawTokens, Highlights);
+}
 
-  // Lex all the tokens in raw mode, to avoid entering #includes or expanding
-  // macros.
-  while (1) {
-    Token Tok;
-    L.LexFromRawLexer(Tok);
+void html::FindMacroHighlights(FileID FID, const Preprocessor &PP,
+                               const std::vector<Token> &RawTokens,
+                               std::vector<Highlight> &Highlights) {
+  // Copy the raw token stream into a token buffer.
+  const SourceManager &SM = PP.getSourceManager();
+  std::vector<Token> TokenStream;
+  TokenStream.reserve(RawTokens.size());
+
+  bool AfterComment = false, CommentAtStartOfLine = false;
+  for (unsigned Idx = 0; ; ++Idx) {
+    Token Tok = RawTokens[Idx];
+
+    // The comments are whitespace to the preprocessor: drop them, and give
+    // the next token the flags it would have had without them.  A comment is
+    // leading space unless a newline follows it.
+    if (Tok.is(tok::comment)) {
+      CommentAtStartOfLine |= Tok.isAtStartOfLine();
+      AfterComment = true;
+      continue;
+    }
+    if (AfterComment) {
+      if (!Tok.isAtStartOfLine())
+        Tok.setFlag(Token::LeadingSpace);
+      if (CommentAtStartOfLine)
+        Tok.setFlag(Token::StartOfLine);
+      AfterComment = CommentAtStartOfLine = false;
+    }
 
     // If this is a # at the start of a line, discard it from the token stream.
     // We don't want the re-preprocess step to see #defines, #includes or other
@@ -564,10 +625,25 @@ void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP) {
     // highlighted.
     Expansion = "<span class='expansion'>" + Expansion + "</span></span>";
 
-    HighlightRange(R, LLoc.first, LLoc.second,
-                   "<span class='macro'>", Expansion.c_str());
+    // Include the whole end token in the range.
+    unsigned EOffset = SM.getFileOffset(LLoc.second) +
+      Lexer::MeasureTokenLength(LLoc.second, SM, PP.getLangOptions());
+    AddHighlight(Highlights, SM.getFileOffset(LLoc.first), EOffset,
+                 "<span class='macro'>", "");
+    Highlights.back().EndTag.swap(Expansion);
   }
 
   // Restore diagnostics object back to its own thing.
   TmpPP.setDiagnostics(*OldDiags);
 }
+
+void html::ApplyHighlights(Rewriter &R, FileID FID,
+                           const std::vector<Highlight> &Highlights) {
+  RewriteBuffer &RB = R.getEditBuffer(FID);
+  const char *BufferStart = R.getSourceMgr().getBufferData(FID).first;
+  for (unsigned I = 0, N = Highlights.size(); I != N; ++I) {
+    const Highlight &H = Highlights[I];
+    HighlightRange(RB, H.Begin, H.End, BufferStart, H.StartTag,
+                   H.EndTag.c_str());
+  }
+}
@@ -18,6 +18,7 @@
 #include "clang/Lex/Lexer.h"
 #include "clang/Basic/SourceManager.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 using namespace clang;
 
 void RewriteBuffer::RemoveText(unsigned OrigOffset, unsigned Size) {
@@ -25,10 +26,13 @@ void RewriteBuffer::RemoveText(unsigned OrigOffset, unsigned Size) {
   if (Size == 0) return;
 
   unsigned RealOffset = getMappedOffset(OrigOffset, true);
-  assert(RealOffset+Size < Buffer.size() && "Invalid location");
+  assert(RealOffset+Size < size() && "Invalid location");
 
   // Remove the dead characters.
-  Buffer.erase(RealOffset, Size);
+  if (BatchEdits)
+    AddPendingEdit(PendingEdit::Replace, OrigOffset, RealOffset, Size, "");
+  else
+    Buffer.erase(RealOffset, Size);
 
   // Add a delta so that future changes are offset correctly.
   AddReplaceDelta(OrigOffset, -Size);
@@ -41,7 +45,12 @@ void RewriteBuffer::InsertText(unsigned OrigOffset, const llvm::StringRef &Str,
   if (Str.empty()) return;
 
   unsigned RealOffset = getMappedOffset(OrigOffset, InsertAfter);
-  Buffer.insert(RealOffset, Str.begin(), Str.end());
+  if (BatchEdits)
+    AddPendingEdit(InsertAfter ? PendingEdit::InsertAfter
+                               : PendingEdit::InsertBefore,
+                   OrigOffset, RealOffset, 0, Str);
+  else
+    Buffer.insert(RealOffset, Str.begin(), Str.end());
 
   // Add a delta so that future changes are offset correctly.
   AddInsertDelta(OrigOffset, Str.size());
@@ -53,12 +62,138 @@ void RewriteBuffer::InsertText(unsigned OrigOffset, const llvm::StringRef &Str,
 void RewriteBuffer::ReplaceText(unsigned OrigOffset, unsigned OrigLength,
                                 const llvm::StringRef &NewStr) {
   unsigned RealOffset = getMappedOffset(OrigOffset, true);
-  Buffer.erase(RealOffset, OrigLength);
-  Buffer.insert(RealOffset, NewStr.begin(), NewStr.end());
+  if (BatchEdits)
+    AddPendingEdit(PendingEdit::Replace, OrigOffset, RealOffset, OrigLength,
+                   NewStr);
+  else {
+    Buffer.erase(RealOffset, OrigLength);
+    Buffer.insert(RealOffset, NewStr.begin(), NewStr.end());
+  }
   if (OrigLength != NewStr.size())
     AddReplaceDelta(OrigOffset, NewStr.size() - OrigLength);
 }
 
+void RewriteBuffer::AddPendingEdit(PendingEdit::EditKind Kind,
+                                   unsigned OrigOffset, unsigned RealOffset,
+                                   unsigned RemoveLength,
+                                   const llvm::StringRef &Str) {
+  PendingEdits.push_back(PendingEdit());
+  PendingEdit &Edit = PendingEdits.back();
+  Edit.Kind = Kind;
+  Edit.OrigOffset = OrigOffset;
+  Edit.RealOffset = RealOffset;
+  Edit.RemoveLength = RemoveLength;
+  Edit.Text = Str;
+  PendingSizeChange += int(Str.size()) - int(RemoveLength);
+}
+
+void RewriteBuffer::setBatchEdits(bool Batch) {
+  if (!Batch)
+    CommitPendingEdits();
+  BatchEdits = Batch;
+}
+
+void RewriteBuffer::CommitPendingEdits() {
+  if (PendingEdits.empty())
+    return;
+
+  // Rebuilding the buffer copies all of it, so it only beats the rope
+  // operations of the edits when there are enough of them.  Otherwise, apply
+  // them in the order they were made, at the offsets they were made at.
+  if (PendingEdits.size() < Buffer.size() / 64 || !RebuildWithPendingEdits())
+    for (unsigned i = 0, e = PendingEdits.size(); i != e; ++i) {
+      const PendingEdit &Edit = PendingEdits[i];
+      if (Edit.RemoveLength)
+        Buffer.erase(Edit.RealOffset, Edit.RemoveLength);
+      if (!Edit.Text.empty())
+        Buffer.insert(Edit.RealOffset, Edit.Text.begin(), Edit.Text.end());
+    }
+
+  PendingEdits.clear();
+  PendingSizeChange = 0;
+}
+
+bool RewriteBuffer::RebuildWithPendingEdits() {
+  // Visit the edits by original offset, and the edits at the same offset in
+  // the order they were made.
+  std::vector<std::pair<unsigned, unsigned> > Order;
+  Order.reserve(PendingEdits.size());
+  for (unsigned i = 0, e = PendingEdits.size(); i != e; ++i)
+    Order.push_back(std::make_pair(PendingEdits[i].OrigOffset, i));
+  std::sort(Order.begin(), Order.end());
+
+  std::string Result;
+  Result.reserve(size());
+  iterator In = Buffer.begin();
+  unsigned InOffset = 0;
+
+  // The deltas already include the pending edits, so the offsets in Buffer
+  // are found by taking away the size changes of the pending edits before
+  // each offset.
+  int PendingDelta = 0;
+  for (unsigned i = 0, e = Order.size(); i != e; ) {
+    unsigned OrigOffset = Order[i].first;
+    unsigned GroupEnd = i;
+    int Inserted = 0;
+    const PendingEdit *Replace = 0;
+    for (; GroupEnd != e && Order[GroupEnd].first == OrigOffset; ++GroupEnd) {
+      const PendingEdit &Edit = PendingEdits[Order[GroupEnd].second];
+      if (Edit.Kind != PendingEdit::Replace)
+        Inserted += Edit.Text.size();
+      else if (Replace)
+        return false; // The second removal would remove the first's text.
+      else
+        Replace = &Edit;
+    }
+
+    // The offsets in Buffer before and after the text inserted at OrigOffset
+    // before the pending edits were made.
+    unsigned Before = getMappedOffset(OrigOffset) - PendingDelta;
+    unsigned After = getMappedOffset(OrigOffset, true) - PendingDelta -
+                     Inserted;
+    unsigned RemoveLength = Replace ? Replace->RemoveLength : 0;
+    if (Before < InOffset || After + RemoveLength > Buffer.size())
+      return false;
+
+    for (; InOffset != Before; ++InOffset, ++In)
+      Result += *In;
+
+    // Each insertion before the offset goes in front of all of the text
+    // inserted there so far.
+    for (unsigned j = GroupEnd; j != i; --j) {
+      const PendingEdit &Edit = PendingEdits[Order[j-1].second];
+      if (Edit.Kind == PendingEdit::InsertBefore)
+        Result += Edit.Text;
+    }
+
+    for (; InOffset != After; ++InOffset, ++In)
+      Result += *In;
+
+    // Insertions after the offset go in front of replacement text made at
+    // the same offset, whichever came first.
+    for (unsigned j = i; j != GroupEnd; ++j) {
+      const PendingEdit &Edit = PendingEdits[Order[j].second];
+      if (Edit.Kind == PendingEdit::InsertAfter)
+        Result += Edit.Text;
+    }
+
+    if (Replace) {
+      Result += Replace->Text;
+      std::advance(In, RemoveLength);
+      InOffset += RemoveLength;
+      PendingDelta += int(Replace->Text.size()) - int(RemoveLength);
+    }
+    PendingDelta += Inserted;
+    i = GroupEnd;
+  }
+
+  for (iterator End = Buffer.end(); In != End; ++In)
+    Result += *In;
+
+  Buffer.assign(Result.data(), Result.data() + Result.size());
+  return true;
+}
+
 
 //===----------------------------------------------------------------------===//
 // Rewriter class
@@ -167,10 +302,18 @@ RewriteBuffer &Rewriter::getEditBuffer(FileID FID) {
 
   std::pair<const char*, const char*> MB = SourceMgr->getBufferData(FID);
   I->second.Initialize(MB.first, MB.second);
+  I->second.setBatchEdits(BatchEdits);
 
   return I->second;
 }
 
+void Rewriter::setBatchEdits(bool Batch) {
+  BatchEdits = Batch;
+  for (std::map<FileID, RewriteBuffer>::iterator I = RewriteBuffers.begin(),
+         E = RewriteBuffers.end(); I != E; ++I)
+    I->second.setBatchEdits(Batch);
+}
+
 /// InsertText - Insert the specified string at the specified location in the
 /// original buffer.
 bool Rewriter::InsertText(SourceLocation Loc, const llvm::StringRef &Str,
@@ -22,6 +22,12 @@ TokenRewriter::TokenRewriter(FileID FID, SourceManager &SM,
                              const LangOptions &LangOpts) {
   ScratchBuf.reset(new ScratchBuffer(SM));
 
+  // Start out with the sentinel alone, linked to itself.
+  TokenEntry Sentinel;
+  Sentinel.Tok.startToken();
+  Sentinel.Prev = Sentinel.Next = 0;
+  Entries.push_back(Sentinel);
+
   // Create a lexer to lex all the tokens of the main file in raw mode.
   const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
   Lexer RawLex(FID, FromFile, SM, LangOpts);
@@ -41,7 +47,7 @@ TokenRewriter::TokenRewriter(FileID FID, SourceManager &SM,
     }
 #endif
 
-    AddToken(RawTok, TokenList.end());
+    AddToken(RawTok, 0);
     RawLex.LexFromRawLexer(RawTok);
   }
 }
@@ -50,31 +56,19 @@ TokenRewriter::~TokenRewriter() {
 }
 
 
-/// RemapIterator - Convert from token_iterator (a const iterator) to
-/// TokenRefTy (a non-const iterator).
-TokenRewriter::TokenRefTy TokenRewriter::RemapIterator(token_iterator I) {
-  if (I == token_end()) return TokenList.end();
-
-  // FIXME: This is horrible, we should use our own list or something to avoid
-  // this.
-  std::map<SourceLocation, TokenRefTy>::iterator MapIt =
-    TokenAtLoc.find(I->getLocation());
-  assert(MapIt != TokenAtLoc.end() && "iterator not in rewriter?");
-  return MapIt->second;
-}
-
-
-/// AddToken - Add the specified token into the Rewriter before the other
-/// position.
-TokenRewriter::TokenRefTy
-TokenRewriter::AddToken(const Token &T, TokenRefTy Where) {
-  Where = TokenList.insert(Where, T);
+/// AddToken - Add the specified token into the Rewriter before the entry
+/// with index Where, and return its index.
+unsigned TokenRewriter::AddToken(const Token &T, unsigned Where) {
+  unsigned Idx = Entries.size();
+  TokenEntry Entry;
+  Entry.Tok = T;
+  Entry.Prev = Entries[Where].Prev;
+  Entry.Next = Where;
+  Entries.push_back(Entry);
 
-  bool InsertSuccess = TokenAtLoc.insert(std::make_pair(T.getLocation(),
-                                                        Where)).second;
-  assert(InsertSuccess && "Token location already in rewriter!");
-  InsertSuccess = InsertSuccess;
-  return Where;
+  Entries[Entry.Prev].Next = Idx;
+  Entries[Where].Prev = Idx;
+  return Idx;
 }
 
 
@@ -94,6 +88,6 @@ TokenRewriter::AddTokenBefore(token_iterator I, const char *Val) {
   // set kind to tok::unknown.
   Tok.setKind(tok::unknown);
 
-  return AddToken(Tok, RemapIterator(I));
+  return token_iterator(this, AddToken(Tok, I.Idx));
 }
 
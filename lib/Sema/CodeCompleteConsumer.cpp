@@ -12,12 +12,17 @@
 //===----------------------------------------------------------------------===//
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/AST/DeclCXX.h"
+#include "clang/Basic/AtomicOutputFile.h"
 #include "clang/Parse/Scope.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang-c/Index.h"
 #include "Sema.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
@@ -486,117 +491,259 @@ PrintingCodeCompleteConsumer::ProcessOverloadCandidates(Sema &SemaRef,
   SemaRef.PP.getDiagnostics().setSuppressAllDiagnostics();
 }
 
+/// \brief Determine the kind of cursor that describes the given result.
+static CXCursorKind
+getCursorKindForResult(const CodeCompleteConsumer::Result &R) {
+  typedef CodeCompleteConsumer::Result Result;
+  switch (R.Kind) {
+  case Result::RK_Declaration:
+    switch (R.Declaration->getKind()) {
+    case Decl::Record:
+    case Decl::CXXRecord:
+    case Decl::ClassTemplateSpecialization: {
+      RecordDecl *Record = cast<RecordDecl>(R.Declaration);
+      if (Record->isStruct())
+        return CXCursor_StructDecl;
+      else if (Record->isUnion())
+        return CXCursor_UnionDecl;
+      else
+        return CXCursor_ClassDecl;
+    }
+      
+    case Decl::ObjCMethod: {
+      ObjCMethodDecl *Method = cast<ObjCMethodDecl>(R.Declaration);
+      if (Method->isInstanceMethod())
+        return CXCursor_ObjCInstanceMethodDecl;
+      else
+        return CXCursor_ObjCClassMethodDecl;
+    }
+      
+    case Decl::Typedef:
+      return CXCursor_TypedefDecl;
+      
+    case Decl::Enum:
+      return CXCursor_EnumDecl;
+      
+    case Decl::Field:
+      return CXCursor_FieldDecl;
+      
+    case Decl::EnumConstant:
+      return CXCursor_EnumConstantDecl;
+      
+    case Decl::Function:
+    case Decl::CXXMethod:
+    case Decl::CXXConstructor:
+    case Decl::CXXDestructor:
+    case Decl::CXXConversion:
+      return CXCursor_FunctionDecl;
+      
+    case Decl::Var:
+      return CXCursor_VarDecl;
+      
+    case Decl::ParmVar:
+      return CXCursor_ParmDecl;
+      
+    case Decl::ObjCInterface:
+      return CXCursor_ObjCInterfaceDecl;
+      
+    case Decl::ObjCCategory:
+      return CXCursor_ObjCCategoryDecl;
+      
+    case Decl::ObjCProtocol:
+      return CXCursor_ObjCProtocolDecl;
+      
+    case Decl::ObjCProperty:
+      return CXCursor_ObjCPropertyDecl;
+      
+    case Decl::ObjCIvar:
+      return CXCursor_ObjCIvarDecl;
+      
+    case Decl::ObjCImplementation:
+      return CXCursor_ObjCImplementationDecl;
+      
+    case Decl::ObjCCategoryImpl:
+      return CXCursor_ObjCCategoryImplDecl;
+      
+    default:
+      break;
+    }
+    break;
+      
+  case Result::RK_Keyword:
+  case Result::RK_Macro:
+  case Result::RK_Pattern:
+    return CXCursor_NotImplemented;
+  }
+
+
+
+  return CXCursor_NotImplemented;
+}
+
+static void WriteString(llvm::raw_ostream &OS, llvm::StringRef Str) {
+  WriteUnsigned(OS, Str.size());
+  OS << Str;
+}
+
+static bool ReadString(const char *&Memory, const char *MemoryEnd,
+                       std::string &Str) {
+  unsigned Length;
+  if (ReadUnsigned(Memory, MemoryEnd, Length) ||
+      Length > unsigned(MemoryEnd - Memory))
+    return true;
+
+  Str.assign(Memory, Length);
+  Memory += Length;
+  return false;
+}
+
+/// \brief The version of the format of the files that the results for the
+/// global declarations of a PCH file are cached in.
+static const unsigned GlobalResultsCacheVersion = 1;
+
+CodeCompleteConsumer::GlobalResultsCacheState
+CIndexCodeCompleteConsumer::getGlobalResultsCacheState(
+                                                  unsigned CompletionContext) {
+  CachedGlobalResults.clear();
+  if (GlobalResultsCachePath.empty())
+    return GRC_None;
+
+  // Which global declarations are results, and how they are printed, depends
+  // on the completion context, so each context has a file of its own.
+  GlobalResultsCacheFile = GlobalResultsCachePath + "-" +
+                           llvm::utostr(CompletionContext) + ".cache";
+  llvm::OwningPtr<llvm::MemoryBuffer> Buffer(
+                     llvm::MemoryBuffer::getFile(GlobalResultsCacheFile));
+  if (!Buffer)
+    return GRC_Missing;
+
+  // A stale file, or one for a different PCH file whose key hashes to the
+  // same name, is recomputed.
+  const char *Memory = Buffer->getBufferStart();
+  const char *MemoryEnd = Buffer->getBufferEnd();
+  unsigned Version, NumResults;
+  std::string Key;
+  if (MemoryEnd - Memory < 7 || memcmp(Memory, "cfe-ccr", 7))
+    return GRC_Missing;
+  Memory += 7;
+  if (ReadUnsigned(Memory, MemoryEnd, Version) ||
+      Version != GlobalResultsCacheVersion ||
+      ReadString(Memory, MemoryEnd, Key) || Key != GlobalResultsCacheKey ||
+      ReadUnsigned(Memory, MemoryEnd, NumResults))
+    return GRC_Missing;
+
+  for (unsigned I = 0; I != NumResults; ++I) {
+    CachedResult R;
+    if (ReadString(Memory, MemoryEnd, R.Name) ||
+        ReadUnsigned(Memory, MemoryEnd, R.CursorKind) ||
+        ReadString(Memory, MemoryEnd, R.Completion)) {
+      CachedGlobalResults.clear();
+      return GRC_Missing;
+    }
+    CachedGlobalResults.push_back(R);
+  }
+
+  return GRC_Cached;
+}
+
+void CIndexCodeCompleteConsumer::CacheGlobalResults(Sema &SemaRef,
+                                                    Result *Results,
+                                                    unsigned NumResults) {
+  CachedGlobalResults.clear();
+  for (unsigned I = 0; I != NumResults; ++I) {
+    assert(Results[I].Kind == Result::RK_Declaration &&
+           "Only declarations are cached");
+    CachedResult R;
+    R.Name = Results[I].Declaration->getDeclName().getAsString();
+    R.CursorKind = getCursorKindForResult(Results[I]);
+
+    CodeCompletionString *CCS = Results[I].CreateCodeCompletionString(SemaRef);
+    assert(CCS && "No code-completion string?");
+    llvm::raw_string_ostream Out(R.Completion);
+    CCS->Serialize(Out);
+    Out.flush();
+    delete CCS;
+
+    CachedGlobalResults.push_back(R);
+  }
+
+  // The cache is only an optimization; failing to update it is harmless.
+  WriteGlobalResultsCache();
+}
+
+bool CIndexCodeCompleteConsumer::WriteGlobalResultsCache() const {
+  // Write to a temporary file first so that concurrent completions reading
+  // the cache never see a partially written file.
+  AtomicOutputFile File(GlobalResultsCacheFile);
+  std::string ErrMsg;
+  if (File.open(ErrMsg))
+    return true;
+
+  llvm::raw_ostream &Out = File.getStream();
+  Out << "cfe-ccr";
+  WriteUnsigned(Out, GlobalResultsCacheVersion);
+  WriteString(Out, GlobalResultsCacheKey);
+  WriteUnsigned(Out, CachedGlobalResults.size());
+  for (unsigned I = 0, N = CachedGlobalResults.size(); I != N; ++I) {
+    const CachedResult &R = CachedGlobalResults[I];
+    WriteString(Out, R.Name);
+    WriteUnsigned(Out, R.CursorKind);
+    WriteString(Out, R.Completion);
+  }
+  return File.commit(ErrMsg);
+}
+
 void 
 CIndexCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &SemaRef,
                                                        Result *Results, 
                                                        unsigned NumResults) {
+  // A cached result for a global declaration is left out if a declaration in
+  // a nested scope hides it, or if it was printed already, e.g., because the
+  // main file redeclares it.
+  bool HaveCachedResults = !CachedGlobalResults.empty();
+  llvm::StringSet<> HidingNames, GlobalCompletions;
+
   // Print the results.
   for (unsigned I = 0; I != NumResults; ++I) {
-    CXCursorKind Kind = CXCursor_NotImplemented;
-
-    switch (Results[I].Kind) {
-    case Result::RK_Declaration:
-      switch (Results[I].Declaration->getKind()) {
-      case Decl::Record:
-      case Decl::CXXRecord:
-      case Decl::ClassTemplateSpecialization: {
-        RecordDecl *Record = cast<RecordDecl>(Results[I].Declaration);
-        if (Record->isStruct())
-          Kind = CXCursor_StructDecl;
-        else if (Record->isUnion())
-          Kind = CXCursor_UnionDecl;
-        else
-          Kind = CXCursor_ClassDecl;
-        break;
-      }
-        
-      case Decl::ObjCMethod: {
-        ObjCMethodDecl *Method = cast<ObjCMethodDecl>(Results[I].Declaration);
-        if (Method->isInstanceMethod())
-            Kind = CXCursor_ObjCInstanceMethodDecl;
-        else
-          Kind = CXCursor_ObjCClassMethodDecl;
-        break;
-      }
-        
-      case Decl::Typedef:
-        Kind = CXCursor_TypedefDecl;
-        break;
-        
-      case Decl::Enum:
-        Kind = CXCursor_EnumDecl;
-        break;
-        
-      case Decl::Field:
-        Kind = CXCursor_FieldDecl;
-        break;
-        
-      case Decl::EnumConstant:
-        Kind = CXCursor_EnumConstantDecl;
-        break;
-        
-      case Decl::Function:
-      case Decl::CXXMethod:
-      case Decl::CXXConstructor:
-      case Decl::CXXDestructor:
-      case Decl::CXXConversion:
-        Kind = CXCursor_FunctionDecl;
-        break;
-        
-      case Decl::Var:
-        Kind = CXCursor_VarDecl;
-        break;
-        
-      case Decl::ParmVar:
-        Kind = CXCursor_ParmDecl;
-        break;
-        
-      case Decl::ObjCInterface:
-        Kind = CXCursor_ObjCInterfaceDecl;
-        break;
-        
-      case Decl::ObjCCategory:
-        Kind = CXCursor_ObjCCategoryDecl;
-        break;
-        
-      case Decl::ObjCProtocol:
-        Kind = CXCursor_ObjCProtocolDecl;
-        break;
-        
-      case Decl::ObjCProperty:
-        Kind = CXCursor_ObjCPropertyDecl;
-        break;
-        
-      case Decl::ObjCIvar:
-        Kind = CXCursor_ObjCIvarDecl;
-        break;
-        
-      case Decl::ObjCImplementation:
-        Kind = CXCursor_ObjCImplementationDecl;
-        break;
-        
-      case Decl::ObjCCategoryImpl:
-        Kind = CXCursor_ObjCCategoryImplDecl;
-        break;
-        
-      default:
-        break;
-      }
-      break;
-        
-    case Result::RK_Keyword:
-    case Result::RK_Macro:
-    case Result::RK_Pattern:
-      Kind = CXCursor_NotImplemented;
-      break;
-    }
-
-    WriteUnsigned(OS, Kind);
+    WriteUnsigned(OS, getCursorKindForResult(Results[I]));
     CodeCompletionString *CCS = Results[I].CreateCodeCompletionString(SemaRef);
     assert(CCS && "No code-completion string?");
-    CCS->Serialize(OS);
+    if (!HaveCachedResults || Results[I].Kind != Result::RK_Declaration) {
+      CCS->Serialize(OS);
+      delete CCS;
+      continue;
+    }
+
+    std::string Completion;
+    llvm::raw_string_ostream Out(Completion);
+    CCS->Serialize(Out);
+    Out.flush();
     delete CCS;
+    OS << Completion;
+
+    NamedDecl *ND = Results[I].Declaration;
+    if (ND->getDeclContext()->getLookupContext()->isTranslationUnit())
+      GlobalCompletions.insert(Completion);
+    else
+      HidingNames.insert(ND->getDeclName().getAsString());
+  }
+
+  // The cached results are not filtered by Sema, and come after its results
+  // when the number of results is limited.
+  unsigned NumPrinted = NumResults;
+  for (unsigned I = 0, N = CachedGlobalResults.size(); I != N; ++I) {
+    const CachedResult &R = CachedGlobalResults[I];
+    if (MaxResults && NumPrinted >= MaxResults)
+      break;
+    if (HidingNames.count(R.Name) || GlobalCompletions.count(R.Completion) ||
+        !matchesFilterPrefix(R.Name))
+      continue;
+    ++NumPrinted;
+
+    WriteUnsigned(OS, R.CursorKind);
+    OS << R.Completion;
   }
+  CachedGlobalResults.clear();
   
   // Once we've printed the code-completion results, suppress remaining
   // diagnostics.
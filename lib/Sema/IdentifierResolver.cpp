@@ -14,6 +14,7 @@
 
 #include "IdentifierResolver.h"
 #include "clang/Basic/LangOptions.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 
@@ -61,21 +62,95 @@ public:
 // IdDeclInfo Implementation
 //===----------------------------------------------------------------------===//
 
+void IdentifierResolver::IdDeclInfo::AddDecl(NamedDecl *D) {
+  Decls.push_back(D);
+  if (Decls.size() > LongestChain)
+    LongestChain = Decls.size();
+
+  if (Index)
+    (*Index)[D] = Decls.size() - 1;
+  else if (Decls.size() > IndexThreshold)
+    Rebuild();
+}
+
+void IdentifierResolver::IdDeclInfo::Rebuild() {
+  if (NumRemoved) {
+    DeclsTy::iterator Out = Decls.begin();
+    for (DeclsTy::iterator I = Decls.begin(), E = Decls.end(); I != E; ++I)
+      if (*I)
+        *Out++ = *I;
+    Decls.erase(Out, Decls.end());
+    NumRemoved = 0;
+  }
+
+  if (Decls.size() <= IndexThreshold / 2) {
+    delete Index;
+    Index = 0;
+    return;
+  }
+
+  if (!Index)
+    Index = new IndexTy();
+  Index->clear();
+  for (unsigned i = 0, e = Decls.size(); i != e; ++i)
+    (*Index)[Decls[i]] = i;
+}
+
 /// RemoveDecl - Remove the decl from the scope chain.
 /// The decl must already be part of the decl chain.
 void IdentifierResolver::IdDeclInfo::RemoveDecl(NamedDecl *D) {
-  for (DeclsTy::iterator I = Decls.end(); I != Decls.begin(); --I) {
-    if (D == *(I-1)) {
-      Decls.erase(I-1);
-      return;
+  if (!Index) {
+    for (DeclsTy::iterator I = Decls.end(); I != Decls.begin(); --I) {
+      if (D == *(I-1)) {
+        Decls.erase(I-1);
+        return;
+      }
     }
+
+    assert(0 && "Didn't find this decl on its identifier's chain!");
+    return;
+  }
+
+  // The index only knows the most recent entry of a decl that was added to
+  // the chain twice; find the older one by searching.
+  unsigned i = Decls.size();
+  IndexTy::iterator Pos = Index->find(D);
+  if (Pos != Index->end()) {
+    i = Pos->second;
+    Index->erase(Pos);
+  } else {
+    while (i != 0 && Decls[i-1] != D)
+      --i;
+    assert(i != 0 && "Didn't find this decl on its identifier's chain!");
+    --i;
+  }
+  Decls[i] = 0;
+  ++NumRemoved;
+
+  // Keep the last entry non-null, so iteration can start there.
+  while (!Decls.empty() && !Decls.back()) {
+    Decls.pop_back();
+    --NumRemoved;
   }
 
-  assert(0 && "Didn't find this decl on its identifier's chain!");
+  // Compact the chain once most of it is gone.
+  if (NumRemoved > Decls.size() / 2 || Decls.size() <= IndexThreshold / 2)
+    Rebuild();
 }
 
 bool
 IdentifierResolver::IdDeclInfo::ReplaceDecl(NamedDecl *Old, NamedDecl *New) {
+  if (Index) {
+    IndexTy::iterator Pos = Index->find(Old);
+    if (Pos == Index->end())
+      return false;
+    unsigned i = Pos->second;
+    Index->erase(Pos);
+    Decls[i] = New;
+    (*Index)[New] = i;
+    return true;
+  }
+
   for (DeclsTy::iterator I = Decls.end(); I != Decls.begin(); --I) {
     if (Old == *(I-1)) {
       *(I - 1) = New;
@@ -91,8 +166,21 @@ IdentifierResolver::IdDeclInfo::ReplaceDecl(NamedDecl *Old, NamedDecl *New) {
 // IdentifierResolver Implementation
 //===----------------------------------------------------------------------===//
 
+unsigned IdentifierResolver::NumChainWalks = 0;
+unsigned IdentifierResolver::NumChainSteps = 0;
+unsigned IdentifierResolver::LongestChain = 0;
+
+void IdentifierResolver::PrintStats() {
+  llvm::errs() << NumChainWalks << " identifier chain walks, visiting "
+               << NumChainWalks + NumChainSteps << " decls";
+  if (NumChainWalks)
+    llvm::errs() << " (" << double(NumChainWalks + NumChainSteps) /
+                            NumChainWalks << " per walk)";
+  llvm::errs() << ".\n" << LongestChain << " decls in the longest chain.\n";
+}
+
 IdentifierResolver::IdentifierResolver(const LangOptions &langOpt)
-    : LangOpt(langOpt), IdDeclInfos(new IdDeclInfoMap) {
+    : LangOpt(langOpt), IdDeclInfos(new IdDeclInfoMap), Generation(0) {
 }
 IdentifierResolver::~IdentifierResolver() {
   delete IdDeclInfos;
@@ -138,6 +226,7 @@ bool IdentifierResolver::isDeclInScope(Decl *D, DeclContext *Ctx,
 
 /// AddDecl - Link the decl to its shadowed decl chain.
 void IdentifierResolver::AddDecl(NamedDecl *D) {
+  ++Generation;
   DeclarationName Name = D->getDeclName();
   void *Ptr = Name.getFETokenInfo<void>();
 
@@ -163,6 +252,7 @@ void IdentifierResolver::AddDecl(NamedDecl *D) {
 /// The decl must already be part of the decl chain.
 void IdentifierResolver::RemoveDecl(NamedDecl *D) {
   assert(D && "null param passed");
+  ++Generation;
   DeclarationName Name = D->getDeclName();
   void *Ptr = Name.getFETokenInfo<void>();
 
@@ -180,6 +270,7 @@ void IdentifierResolver::RemoveDecl(NamedDecl *D) {
 bool IdentifierResolver::ReplaceDecl(NamedDecl *Old, NamedDecl *New) {
   assert(Old->getDeclName() == New->getDeclName() &&
          "Cannot replace a decl with another decl of a different name");
+  ++Generation;
 
   DeclarationName Name = Old->getDeclName();
   void *Ptr = Name.getFETokenInfo<void>();
@@ -204,6 +295,7 @@ IdentifierResolver::begin(DeclarationName Name) {
   void *Ptr = Name.getFETokenInfo<void>();
   if (!Ptr) return end();
 
+  ++NumChainWalks;
   if (isDeclPtr(Ptr))
     return iterator(static_cast<NamedDecl*>(Ptr));
 
@@ -218,6 +310,7 @@ IdentifierResolver::begin(DeclarationName Name) {
 
 void IdentifierResolver::AddDeclToIdentifierChain(IdentifierInfo *II,
                                                   NamedDecl *D) {
+  ++Generation;
   void *Ptr = II->getFETokenInfo<void>();
 
   if (!Ptr) {
@@ -20,6 +20,7 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclarationName.h"
 #include "clang/AST/DeclCXX.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace clang {
 
@@ -32,14 +33,27 @@ class IdentifierResolver {
   /// to a particular declaration name. IdDeclInfos are lazily
   /// constructed and assigned to a declaration name the first time a
   /// decl with that declaration name is shadowed in some scope.
+  ///
+  /// Chains are usually short, and are searched from the most recent decl.
+  /// Once a chain grows past IndexThreshold decls, as it does for a name with
+  /// thousands of overloads in one namespace, it also gets an index from each
+  /// decl to its position, and decls removed from the middle of the chain
+  /// leave a null entry behind instead of shifting the decls after them.
+  /// Popping such a scope then takes time linear in the number of decls.
   class IdDeclInfo {
   public:
     typedef llvm::SmallVector<NamedDecl*, 2> DeclsTy;
+    typedef llvm::DenseMap<NamedDecl*, unsigned> IndexTy;
+
+    enum { IndexThreshold = 32 };
+
+    IdDeclInfo() : Index(0), NumRemoved(0) {}
+    ~IdDeclInfo() { delete Index; }
 
     inline DeclsTy::iterator decls_begin() { return Decls.begin(); }
     inline DeclsTy::iterator decls_end() { return Decls.end(); }
 
-    void AddDecl(NamedDecl *D) { Decls.push_back(D); }
+    void AddDecl(NamedDecl *D);
 
     /// RemoveDecl - Remove the decl from the scope chain.
     /// The decl must already be part of the decl chain.
@@ -51,7 +65,21 @@ class IdentifierResolver {
     bool ReplaceDecl(NamedDecl *Old, NamedDecl *New);
 
   private:
+    /// Decls - The decls of the chain, oldest first.  Entries in the middle
+    /// may be null once the chain is indexed, but the last one never is.
     DeclsTy Decls;
+
+    /// Index - The position of each decl in Decls, if the chain is long.
+    IndexTy *Index;
+
+    /// NumRemoved - The number of null entries in Decls.
+    unsigned NumRemoved;
+
+    /// Rebuild - Drop the null entries from Decls and rebuild the index.
+    void Rebuild();
+
+    IdDeclInfo(const IdDeclInfo&);    // DO NOT IMPLEMENT
+    void operator=(const IdDeclInfo&); // DO NOT IMPLEMENT
   };
 
 public:
@@ -117,16 +145,22 @@ public:
       if (!isIterator()) // common case.
         Ptr = 0;
       else {
+        ++NumChainSteps;
         NamedDecl *D = **this;
         void *InfoPtr = D->getDeclName().getFETokenInfo<void>();
         assert(!isDeclPtr(InfoPtr) && "Decl with wrong id ?");
         IdDeclInfo *Info = toIdDeclInfo(InfoPtr);
 
+        // Skip the entries of decls removed from an indexed chain.
         BaseIter I = getIterator();
-        if (I != Info->decls_begin())
-          *this = iterator(I-1);
-        else // No more decls.
-          *this = iterator();
+        do {
+          if (I == Info->decls_begin()) { // No more decls.
+            *this = iterator();
+            return *this;
+          }
+          --I;
+        } while (!*I);
+        *this = iterator(I);
       }
       return *this;
     }
@@ -174,6 +208,13 @@ public:
   /// declaration actually has a name.
   void AddDeclToIdentifierChain(IdentifierInfo *II, NamedDecl *D);
 
+  /// PrintStats - Print how often identifier chains were walked, and how far.
+  static void PrintStats();
+
+  /// getGeneration - Return a number that changes whenever a declaration is
+  /// added to, or removed from, an identifier chain.
+  unsigned getGeneration() const { return Generation; }
+
   explicit IdentifierResolver(const LangOptions &LangOpt);
   ~IdentifierResolver();
 
@@ -183,6 +224,11 @@ private:
   class IdDeclInfoMap;
   IdDeclInfoMap *IdDeclInfos;
 
+  unsigned Generation;
+
+  // Statistics about walks of the identifier chains.
+  static unsigned NumChainWalks, NumChainSteps, LongestChain;
+
   /// FETokenInfo contains a Decl pointer if lower bit == 0.
   static inline bool isDeclPtr(void *Ptr) {
     return (reinterpret_cast<uintptr_t>(Ptr) & 0x1) == 0;
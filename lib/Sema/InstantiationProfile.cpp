@@ -0,0 +1,149 @@
+//===--- InstantiationProfile.cpp - Per-template instantiation cost -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This code measures how often each template pattern is instantiated and how
+// much time instantiation and template argument deduction spend on it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/InstantiationProfile.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/JSONWriter.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/TimeValue.h"
+#include <algorithm>
+
+using namespace clang;
+
+InstantiationProfile *InstantiationProfile::Active = 0;
+
+static double GetWallTime() {
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  return Now.seconds() + Now.microseconds() / 1000000.0;
+}
+
+static const char *getActivityName(InstantiationProfile::Activity Kind) {
+  switch (Kind) {
+  case InstantiationProfile::Instantiation: return "instantiate";
+  case InstantiationProfile::Deduction: return "deduce";
+  case InstantiationProfile::PendingInstantiations: return "pending";
+  }
+  return "";
+}
+
+/// getPatternName - Return the name the report uses for \arg Pattern.
+static std::string getPatternName(const NamedDecl *Pattern) {
+  if (!Pattern)
+    return "<pending implicit instantiations>";
+
+  std::string Name = Pattern->getQualifiedNameAsString();
+  if (const ClassTemplatePartialSpecializationDecl *Partial
+        = dyn_cast<ClassTemplatePartialSpecializationDecl>(Pattern)) {
+    const TemplateArgumentList &Args = Partial->getTemplateArgs();
+    Name += TemplateSpecializationType::PrintTemplateArgumentList(
+                                       Args.getFlatArgumentList(),
+                                       Args.flat_size(),
+                                       Partial->getASTContext().PrintingPolicy);
+  }
+  return Name;
+}
+
+InstantiationProfile::InstantiationProfile(bool RecordTrace)
+  : RecordTrace(RecordTrace), TraceStart(GetWallTime()) {
+}
+
+InstantiationProfile::~InstantiationProfile() {
+  if (Active == this)
+    Active = 0;
+}
+
+void InstantiationProfile::enter(Activity Kind, const NamedDecl *Pattern) {
+  std::pair<unsigned, const NamedDecl *> Key(Kind, Pattern);
+  llvm::DenseMap<std::pair<unsigned, const NamedDecl *>, unsigned>::iterator
+    Known = EntryMap.find(Key);
+  if (Known == EntryMap.end()) {
+    Entry E;
+    E.Kind = Kind;
+    E.Name = getPatternName(Pattern);
+    E.Count = 0;
+    E.Inclusive = E.Exclusive = 0;
+    E.Depth = 0;
+    Known = EntryMap.insert(std::make_pair(Key, Entries.size())).first;
+    Entries.push_back(E);
+  }
+
+  Entry &E = Entries[Known->second];
+  ++E.Count;
+  ++E.Depth;
+
+  Activation A;
+  A.Index = Known->second;
+  A.ChildTime = 0;
+  A.Start = GetWallTime();
+  Running.push_back(A);
+}
+
+void InstantiationProfile::exit() {
+  assert(!Running.empty() && "No entry is running!");
+  Activation A = Running.back();
+  Running.pop_back();
+
+  double Duration = GetWallTime() - A.Start;
+  Entry &E = Entries[A.Index];
+  E.Exclusive += Duration - A.ChildTime;
+  if (--E.Depth == 0)
+    E.Inclusive += Duration;
+  if (!Running.empty())
+    Running.back().ChildTime += Duration;
+
+  if (RecordTrace) {
+    TraceEvent Event;
+    Event.Index = A.Index;
+    Event.Start = A.Start - TraceStart;
+    Event.Duration = Duration;
+    Trace.push_back(Event);
+  }
+}
+
+void InstantiationProfile::WriteReport(llvm::raw_ostream &OS) const {
+  // Sort by decreasing inclusive time, keeping the order the entries were
+  // first entered in for ties.
+  std::vector<std::pair<double, unsigned> > Sorted;
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i)
+    Sorted.push_back(std::make_pair(-Entries[i].Inclusive, i));
+  std::sort(Sorted.begin(), Sorted.end());
+
+  OS << "Template instantiation profile:\n";
+  OS << "  count  incl ms  excl ms  activity     template\n";
+  for (unsigned i = 0, e = Sorted.size(); i != e; ++i) {
+    const Entry &E = Entries[Sorted[i].second];
+    OS << llvm::format("%7u %8.2f %8.2f  %-12s ", E.Count,
+                       E.Inclusive * 1000, E.Exclusive * 1000,
+                       getActivityName(E.Kind))
+       << E.Name << "\n";
+  }
+  OS << "\n";
+}
+
+void InstantiationProfile::WriteTrace(llvm::raw_ostream &OS) const {
+  OS << "{\"traceEvents\":[";
+  for (unsigned i = 0, e = Trace.size(); i != e; ++i) {
+    const TraceEvent &Event = Trace[i];
+    const Entry &E = Entries[Event.Index];
+    OS << (i ? ",\n" : "\n") << "{\"name\":";
+    WriteJSONString(OS, E.Name);
+    OS << ",\"cat\":\"" << getActivityName(E.Kind) << "\",\"ph\":\"X\""
+       << llvm::format(",\"ts\":%.0f,\"dur\":%.0f", Event.Start * 1000000,
+                       Event.Duration * 1000000)
+       << ",\"pid\":1,\"tid\":1}";
+  }
+  OS << "\n]}\n";
+}
@@ -16,6 +16,7 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/StmtObjC.h"
 #include "clang/AST/StmtCXX.h"
+#include "clang/Basic/PhaseStatistics.h"
 using namespace clang;
 
 namespace {
@@ -45,8 +46,14 @@ class JumpScopeChecker {
     /// Loc - Location to emit the diagnostic.
     SourceLocation Loc;
 
+    /// End - One past the index in ScopeMap of the last scope nested within
+    /// this one.  Scopes are numbered in the order the AST walk opens them,
+    /// so the scopes nested within this one are exactly those in
+    /// [this scope, End).
+    unsigned End;
+
     GotoScope(unsigned parentScope, unsigned diag, SourceLocation L)
-    : ParentScope(parentScope), Diag(diag), Loc(L) {}
+    : ParentScope(parentScope), Diag(diag), Loc(L), End(0) {}
   };
 
   llvm::SmallVector<GotoScope, 48> Scopes;
@@ -56,6 +63,14 @@ public:
   JumpScopeChecker(Stmt *Body, Sema &S);
 private:
   void BuildScopeInformation(Stmt *S, unsigned ParentScope);
+  void ComputeScopeRanges();
+
+  /// isWithinScope - Return true if \p Inner is \p Outer or is nested
+  /// within it.
+  bool isWithinScope(unsigned Inner, unsigned Outer) const {
+    return Outer <= Inner && Inner < Scopes[Outer].End;
+  }
+
   void VerifyJumps();
   void CheckJump(Stmt *From, Stmt *To,
                  SourceLocation DiagLoc, unsigned JumpDiag);
@@ -70,6 +85,7 @@ JumpScopeChecker::JumpScopeChecker(Stmt *Body, Sema &s) : S(s) {
   // Build information for the top level compound statement, so that we have a
   // defined scope record for every "goto" and label.
   BuildScopeInformation(Body, 0);
+  ComputeScopeRanges();
 
   // Check that all jumps we saw are kosher.
   VerifyJumps();
@@ -212,6 +228,22 @@ void JumpScopeChecker::BuildScopeInformation(Stmt *S, unsigned ParentScope) {
   }
 }
 
+/// ComputeScopeRanges - Compute the range of nested scopes of each scope, so
+/// that checking a jump does not need to walk the chains of parent scopes,
+/// which are as long as the number of protected declarations in a block.
+void JumpScopeChecker::ComputeScopeRanges() {
+  // A scope is always opened after its parent, so visiting the scopes in
+  // reverse order finishes a scope's range before its parent's.
+  for (unsigned I = Scopes.size(); I != 0; --I) {
+    GotoScope &Scope = Scopes[I - 1];
+    if (Scope.End < I)
+      Scope.End = I;
+    if (Scope.ParentScope != ~0U &&
+        Scopes[Scope.ParentScope].End < Scope.End)
+      Scopes[Scope.ParentScope].End = Scope.End;
+  }
+}
+
 /// VerifyJumps - Verify each element of the Jumps array to see if they are
 /// valid, emitting diagnostics if not.
 void JumpScopeChecker::VerifyJumps() {
@@ -287,43 +319,21 @@ void JumpScopeChecker::CheckJump(Stmt *From, Stmt *To,
   if (FromScope == ToScope) return;
 
   // The only valid mismatch jump case happens when the jump is more deeply
-  // nested inside the jump target.  Do a quick scan to see if the jump is valid
-  // because valid code is more common than invalid code.
-  unsigned TestScope = Scopes[FromScope].ParentScope;
-  while (TestScope != ~0U) {
-    // If we found the jump target, then we're jumping out of our current scope,
-    // which is perfectly fine.
-    if (TestScope == ToScope) return;
-
-    // Otherwise, scan up the hierarchy.
-    TestScope = Scopes[TestScope].ParentScope;
-  }
+  // nested inside the jump target, which is fine: we're jumping out of our
+  // current scope.
+  if (isWithinScope(FromScope, ToScope)) return;
 
   // If we get here, then we know we have invalid code.  Diagnose the bad jump,
-  // and then emit a note at each VLA being jumped out of.
+  // and then emit a note at each VLA being jumped into, that is, at each scope
+  // of the target up to the innermost one that also contains the jump.
   S.Diag(DiagLoc, JumpDiag);
 
-  // Eliminate the common prefix of the jump and the target.  Start by
-  // linearizing both scopes, reversing them as we go.
-  std::vector<unsigned> FromScopes, ToScopes;
-  for (TestScope = FromScope; TestScope != ~0U;
-       TestScope = Scopes[TestScope].ParentScope)
-    FromScopes.push_back(TestScope);
-  for (TestScope = ToScope; TestScope != ~0U;
+  for (unsigned TestScope = ToScope; !isWithinScope(FromScope, TestScope);
        TestScope = Scopes[TestScope].ParentScope)
-    ToScopes.push_back(TestScope);
-
-  // Remove any common entries (such as the top-level function scope).
-  while (!FromScopes.empty() && FromScopes.back() == ToScopes.back()) {
-    FromScopes.pop_back();
-    ToScopes.pop_back();
-  }
-
-  // Emit diagnostics for whatever is left in ToScopes.
-  for (unsigned i = 0, e = ToScopes.size(); i != e; ++i)
-    S.Diag(Scopes[ToScopes[i]].Loc, Scopes[ToScopes[i]].Diag);
+    S.Diag(Scopes[TestScope].Loc, Scopes[TestScope].Diag);
 }
 
 void Sema::DiagnoseInvalidJumps(Stmt *Body) {
+  PhaseRegion Phase("Jump scope checking");
   (void)JumpScopeChecker(Body, *this);
 }
@@ -19,11 +19,61 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ExternalASTSource.h"
 #include "clang/AST/Stmt.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Parse/Parser.h"
+#include "llvm/ADT/OwningPtr.h"
 #include <cstdio>
 
 using namespace clang;
 
+SkippedBodyParser::~SkippedBodyParser() {}
+
+namespace {
+class SemaSkippedBodyParser : public SkippedBodyParser {
+  // The parser refers to Sema, so it is declared last to be destroyed first.
+  llvm::OwningPtr<Sema> S;
+  llvm::OwningPtr<Parser> P;
+
+public:
+  SemaSkippedBodyParser(Sema *S, Parser *P) : S(S), P(P) {}
+
+  virtual void ParseBody(FunctionDecl *FD) {
+    P->ParseSkippedFunctionBody(Parser::DeclPtrTy::make(FD));
+  }
+
+  virtual bool ReplaceBody(FunctionDecl *FD, FileID BodyFile) {
+    // Templates and their instantiations are built from the body of the
+    // pattern, which is only parsed once.
+    Stmt *Body = FD->getBody();
+    if (!Body || !isa<CompoundStmt>(Body) || FD->isDependentContext() ||
+        FD->getTemplateInstantiationPattern())
+      return true;
+
+    SourceRange BodyRange;
+    if (P->ReplaceSkippedFunctionBody(Parser::DeclPtrTy::make(FD), BodyFile,
+                                      BodyRange))
+      return true;
+
+    // Forget the local declarations of the previous body, if it was parsed;
+    // parsing the new body declares them again.
+    llvm::SmallVector<Decl *, 8> Locals;
+    for (DeclContext::decl_iterator D = FD->decls_begin(),
+                                 DEnd = FD->decls_end();
+         D != DEnd; ++D)
+      if (!isa<ParmVarDecl>(*D))
+        Locals.push_back(*D);
+    for (unsigned I = 0, N = Locals.size(); I != N; ++I)
+      FD->removeDecl(Locals[I]);
+
+    ASTContext &Ctx = S->Context;
+    FD->setBody(new (Ctx) CompoundStmt(Ctx, 0, 0, BodyRange.getBegin(),
+                                       BodyRange.getEnd()));
+    Ctx.setSkippedFunctionBody(FD, BodyRange);
+    return false;
+  }
+};
+} // end anonymous namespace
+
 //===----------------------------------------------------------------------===//
 // Public interface to the file
 //===----------------------------------------------------------------------===//
@@ -35,15 +85,30 @@ using namespace clang;
 void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
                      ASTContext &Ctx, bool PrintStats,
                      bool CompleteTranslationUnit,
-                     CodeCompleteConsumer *CompletionConsumer) {
+                     CodeCompleteConsumer *CompletionConsumer,
+                     bool SkipFunctionBodies,
+                     SkippedBodyParser **BodyParser,
+                     bool RecordComments) {
   // Collect global stats on Decls/Stmts (until we have a module streamer).
   if (PrintStats) {
     Decl::CollectingStats(true);
     Stmt::CollectingStats(true);
   }
 
-  Sema S(PP, Ctx, *Consumer, CompleteTranslationUnit, CompletionConsumer);
-  Parser P(PP, S);
+  llvm::OwningPtr<Sema> SemaPtr(new Sema(PP, Ctx, *Consumer,
+                                         CompleteTranslationUnit,
+                                         CompletionConsumer));
+  Sema &S = *SemaPtr;
+  llvm::OwningPtr<Parser> ParserPtr(new Parser(PP, S, SkipFunctionBodies));
+  Parser &P = *ParserPtr;
+  if (SkipFunctionBodies && BodyParser)
+    P.setCacheSkippedFunctionBodies(true);
+  if (!RecordComments)
+    P.ignoreComments();
+
+  // Preprocessing, parsing, semantic analysis and the consumer all run in
+  // lockstep, so their phases nest within this one.
+  PhaseRegion ParsePhase("Parse");
   PP.EnterMainSourceFile();
 
   // Initialize the parser.
@@ -81,6 +146,8 @@ void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
         E = S.WeakTopLevelDecls().end(); I != E; ++I)
     Consumer->HandleTopLevelDecl(DeclGroupRef(*I));
 
+  ParsePhase.exit();
+
   Consumer->HandleTranslationUnit(Ctx);
 
   if (ExternalSemaSource *ESS =
@@ -92,10 +159,14 @@ void clang::ParseAST(Preprocessor &PP, ASTConsumer *Consumer,
 
   if (PrintStats) {
     fprintf(stderr, "\nSTATISTICS:\n");
+    P.PrintStats();
     P.getActions().PrintStats();
     Ctx.PrintStats();
     Decl::PrintStats();
     Stmt::PrintStats();
     Consumer->PrintStats();
   }
+
+  if (SkipFunctionBodies && BodyParser)
+    *BodyParser = new SemaSkippedBodyParser(SemaPtr.take(), ParserPtr.take());
 }
@@ -17,6 +17,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/APFloat.h"
+#include "llvm/Support/raw_ostream.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
@@ -24,6 +25,7 @@
 #include "clang/AST/Expr.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/PartialDiagnostic.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/TargetInfo.h"
 using namespace clang;
                                        
@@ -117,15 +119,29 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
     Diags(PP.getDiagnostics()), SourceMgr(PP.getSourceManager()),
     ExternalSource(0), CodeCompleter(CodeCompleter), CurContext(0), 
     CurBlock(0), PackContext(0), ParsingDeclDepth(0),
-    IdResolver(pp.getLangOptions()), StdNamespace(0), StdBadAlloc(0),
+    IdResolver(pp.getLangOptions()), BaseMemberLookupsGeneration(0),
+    NumBaseMemberLookups(0), NumCachedBaseMemberLookups(0),
+    StandardConversionsGeneration(0), NumStandardConversions(0),
+    NumCachedStandardConversions(0), NumFormatStrings(0),
+    NumCachedFormatStrings(0), NumFormatArgTypeChecks(0),
+    NumCachedFormatArgTypeChecks(0),
+    StdNamespace(0), StdBadAlloc(0),
     GlobalNewDeleteDeclared(false), 
     CompleteTranslationUnit(CompleteTranslationUnit),
-    NumSFINAEErrors(0), NonInstantiationEntries(0), 
+    NumSFINAEErrors(0), ImplicitMemberDecls(*this),
+    NumDeferredImplicitMembers(0), NumDeclaredImplicitMembers(0),
+    DeducedCallsNamespaceGeneration(0),
+    DeducedCallsRecordGeneration(0), NumCallDeductions(0),
+    NumCachedCallDeductions(0), NonInstantiationEntries(0), 
+    NumInstantiationScratchResets(0), MaxInstantiationScratchBytes(0),
+    CFGScratchInUse(false), NumCFGScratchResets(0), MaxCFGScratchBytes(0),
     CurrentInstantiationScope(0), TyposCorrected(0)
 {
   TUScope = 0;
-  if (getLangOptions().CPlusPlus)
+  if (getLangOptions().CPlusPlus) {
     FieldCollector.reset(new CXXFieldCollector());
+    Context.ImplicitMembers = &ImplicitMemberDecls;
+  }
 
   // Tell diagnostics how to render things from the AST library.
   PP.getDiagnostics().SetArgToStringFn(&FormatASTNodeDiagnosticArgument, 
@@ -136,8 +152,13 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
 }
 
 Sema::~Sema() {
+  // Lookups into classes that deferred their implicit members will no
+  // longer find them.
+  if (Context.ImplicitMembers == &ImplicitMemberDecls)
+    Context.ImplicitMembers = 0;
   if (PackContext) FreePackedContext();
   delete TheTargetAttributesSema;
+  ClearDeducedCalls();
 }
 
 /// ImpCastExprToType - If Expr is not of type 'Type', insert an implicit cast.
@@ -173,6 +194,33 @@ void Sema::ImpCastExprToType(Expr *&Expr, QualType Ty,
   Expr = new (Context) ImplicitCastExpr(Ty, Kind, Expr, isLvalue);
 }
 
+void Sema::PrintStats() const {
+  llvm::errs() << "\n*** Semantic Analysis Stats:\n";
+  IdentifierResolver::PrintStats();
+  llvm::errs() << NumBaseMemberLookups << " member lookups into base classes, "
+               << NumCachedBaseMemberLookups << " answered from the cache.\n";
+  llvm::errs() << NumCallDeductions << " deductions from call arguments, "
+               << NumCachedCallDeductions << " answered from the cache.\n";
+  llvm::errs() << NumStandardConversions << " standard conversions, "
+               << NumCachedStandardConversions << " answered from the cache, "
+               << NumStandardConversions - NumCachedStandardConversions
+               << " computed.\n";
+  llvm::errs() << NumFormatStrings << " format strings checked, "
+               << NumCachedFormatStrings << " parsed before.\n";
+  llvm::errs() << NumFormatArgTypeChecks << " format argument type checks, "
+               << NumCachedFormatArgTypeChecks
+               << " answered from the cache.\n";
+  llvm::errs() << NumDeferredImplicitMembers
+               << " classes deferred their implicit members, "
+               << NumDeclaredImplicitMembers << " declared them later.\n";
+  llvm::errs() << NumInstantiationScratchResets
+               << " outermost template instantiations, using at most "
+               << MaxInstantiationScratchBytes
+               << " bytes of scratch memory.\n";
+  llvm::errs() << NumCFGScratchResets << " bodies checked with a CFG, using at "
+               << "most " << MaxCFGScratchBytes << " bytes of CFG memory.\n";
+}
+
 void Sema::DeleteExpr(ExprTy *E) {
   if (E) static_cast<Expr*>(E)->Destroy(Context);
 }
@@ -184,7 +232,8 @@ void Sema::DeleteStmt(StmtTy *S) {
 /// translation unit when EOF is reached and all but the top-level scope is
 /// popped.
 void Sema::ActOnEndOfTranslationUnit() {
-  
+  PhaseRegion Phase("Sema end of translation unit");
+
   // Remove functions that turned out to be used.
   UnusedStaticFuncs.erase(std::remove_if(UnusedStaticFuncs.begin(), 
                                          UnusedStaticFuncs.end(), 
@@ -25,12 +25,16 @@
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/FullExpr.h"
+#include "clang/Analysis/Analyses/PrintfFormatString.h"
 #include "clang/Parse/Action.h"
 #include "clang/Sema/SemaDiagnostic.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
 #include <deque>
 #include <list>
 #include <map>
@@ -429,6 +433,59 @@ public:
 
   IdentifierResolver IdResolver;
 
+  /// \brief The result of looking up a member through the base classes of a
+  /// class, in LookupQualifiedName.
+  struct BaseMemberLookup {
+    /// \brief Whether the member was found in some base class.
+    bool Found;
+
+    /// \brief The most permissive access to the subobject it was found in.
+    AccessSpecifier SubobjectAccess;
+
+    /// \brief The declarations found.
+    llvm::SmallVector<NamedDecl *, 2> Decls;
+  };
+
+  /// \brief Unambiguous results of member lookups through the base classes
+  /// of a class, keyed by the class, the name and the kind of lookup.  The
+  /// cache only holds results for the current record lookup generation of the
+  /// ASTContext, which changes whenever the members or the bases of any class
+  /// change.
+  typedef std::pair<CXXRecordDecl *, std::pair<void *, unsigned> >
+    BaseMemberLookupKey;
+  llvm::DenseMap<BaseMemberLookupKey, BaseMemberLookup> BaseMemberLookups;
+  unsigned BaseMemberLookupsGeneration;
+  unsigned NumBaseMemberLookups, NumCachedBaseMemberLookups;
+
+  /// \brief A standard conversion sequence computed by IsStandardConversion,
+  /// and whether the conversion exists.
+  struct CachedStandardConversion {
+    bool Success;
+    StandardConversionSequence SCS;
+  };
+
+  /// \brief Standard conversions that only depend on the types involved,
+  /// keyed by the source and target types and the flags that affect the
+  /// result.  Derived-to-base pointer conversions depend on the bases of
+  /// classes, so the cache only holds results for the current record lookup
+  /// generation of the ASTContext.
+  typedef std::pair<std::pair<void *, void *>, unsigned> StandardConversionKey;
+  llvm::DenseMap<StandardConversionKey, CachedStandardConversion>
+    StandardConversions;
+  unsigned StandardConversionsGeneration;
+  unsigned NumStandardConversions, NumCachedStandardConversions;
+
+  /// \brief The format strings of printf-like calls, parsed, keyed by their
+  /// characters.  The specifiers of an entry point into its key.
+  llvm::StringMap<analyze_printf::ParsedFormatString> ParsedFormatStrings;
+  unsigned NumFormatStrings, NumCachedFormatStrings;
+
+  /// \brief Whether arguments of a type match the type a format specifier
+  /// expects, keyed by the expected type, its kind and the argument type.
+  typedef std::pair<std::pair<void *, void *>, unsigned> FormatArgTypeKey;
+  llvm::DenseMap<FormatArgTypeKey, bool> FormatArgTypeResults;
+  unsigned NumFormatArgTypeChecks, NumCachedFormatArgTypeChecks;
+
   /// Translation Unit Scope - useful to Objective-C actions that need
   /// to lookup file scope declarations in the "ordinary" C decl namespace.
   /// For example, user-defined classes, built-in "id" type, etc.
@@ -606,6 +663,8 @@ public:
 
   virtual void ActOnEndOfTranslationUnit();
 
+  virtual void PrintStats() const;
+
   /// getLabelMap() - Return the current label map.  If we're in a block, we
   /// return it.
   llvm::DenseMap<IdentifierInfo*, LabelStmt*> &getLabelMap() {
@@ -703,6 +762,7 @@ public:
                               Scope *S, const CXXScopeSpec *SS,
                               bool isClassName = false,
                               TypeTy *ObjectType = 0);
+  virtual unsigned getNameLookupGeneration();
   virtual DeclSpec::TST isTagName(IdentifierInfo &II, Scope *S);
   virtual bool DiagnoseUnknownTypeName(const IdentifierInfo &II, 
                                        SourceLocation IILoc,
@@ -777,6 +837,12 @@ public:
   virtual DeclPtrTy ActOnFinishFunctionBody(DeclPtrTy Decl, StmtArg Body);
   DeclPtrTy ActOnFinishFunctionBody(DeclPtrTy Decl, StmtArg Body,
                                     bool IsInstantiation);
+  virtual DeclPtrTy ActOnSkippedFunctionBody(DeclPtrTy Decl,
+                                             SourceLocation LBraceLoc,
+                                             SourceLocation RBraceLoc);
+  virtual DeclPtrTy ActOnStartOfSkippedFunctionBody(Scope *FnBodyScope,
+                                                    DeclPtrTy D);
+  virtual void ActOnFinishSkippedFunctionBody(DeclPtrTy D);
 
   /// \brief Diagnose any unused parameters in the given sequence of
   /// ParmVarDecl pointers.
@@ -995,6 +1061,9 @@ public:
   bool IsStandardConversion(Expr *From, QualType ToType,
                             bool InOverloadResolution,
                             StandardConversionSequence& SCS);
+  bool ComputeStandardConversion(Expr *From, QualType ToType,
+                                 bool InOverloadResolution,
+                                 StandardConversionSequence& SCS);
   bool IsIntegralPromotion(Expr *From, QualType FromType, QualType ToType);
   bool IsFloatingPointPromotion(QualType FromType, QualType ToType);
   bool IsComplexPromotion(QualType FromType, QualType ToType);
@@ -2382,6 +2451,23 @@ public:
   
   void AddImplicitlyDeclaredMembersToClass(CXXRecordDecl *ClassDecl);
 
+  /// \brief Declares the deferred implicit members of classes for the
+  /// ASTContext.
+  class DeferredImplicitMembers : public ImplicitMemberDeclarator {
+    Sema &S;
+
+  public:
+    explicit DeferredImplicitMembers(Sema &S) : S(S) {}
+
+    virtual void DeclareImplicitMembers(CXXRecordDecl *Record);
+  };
+
+  DeferredImplicitMembers ImplicitMemberDecls;
+
+  /// \brief The number of classes that deferred their implicit members, and
+  /// that had them declared later.
+  unsigned NumDeferredImplicitMembers, NumDeclaredImplicitMembers;
+
   virtual void ActOnMemInitializers(DeclPtrTy ConstructorDecl,
                                     SourceLocation ColonLoc,
                                     MemInitTy **MemInits, unsigned NumMemInits,
@@ -2522,7 +2608,8 @@ public:
                             
   void CheckLookupAccess(const LookupResult &R);
 
-  void HandleDelayedAccessCheck(DelayedDiagnostic &DD, Decl *Ctx);
+  void HandleDelayedAccessChecks(DelayedDiagnostic *Begin,
+                                 DelayedDiagnostic *End, Decl *Ctx);
 
   enum AbstractDiagSelID {
     AbstractNone = -1,
@@ -2984,6 +3071,40 @@ public:
     TemplateArgument SecondArg;
   };
 
+  /// \brief The outcome of deducing the template arguments of a function
+  /// template from the arguments of a call.
+  struct DeducedCall : public llvm::FoldingSetNode {
+    /// \brief The function template, and the canonical type and value
+    /// category of each argument.
+    llvm::FoldingSetNodeID Key;
+
+    TemplateDeductionResult Result;
+
+    /// \brief The specialization produced, if deduction succeeded.
+    FunctionDecl *Specialization;
+
+    /// \brief What TemplateDeductionInfo said about a failure.
+    TemplateParameter Param;
+    TemplateArgument FirstArg, SecondArg;
+
+    void Profile(llvm::FoldingSetNodeID &ID) { ID = Key; }
+  };
+
+  /// \brief Deductions from the arguments of calls without explicit template
+  /// arguments, so overload resolution does not repeat them for every call
+  /// with the same argument types.
+  ///
+  /// Deduction substitutes into the function template under a SFINAE trap,
+  /// so its outcome only depends on the argument types and on the classes
+  /// and namespace-scope declarations it can see.  The cache is emptied when
+  /// any of those change, and deductions that emitted a hard error are not
+  /// cached at all.
+  llvm::FoldingSet<DeducedCall> DeducedCalls;
+  unsigned DeducedCallsNamespaceGeneration, DeducedCallsRecordGeneration;
+  unsigned NumCallDeductions, NumCachedCallDeductions;
+
+  void ClearDeducedCalls();
+
   TemplateDeductionResult
   DeduceTemplateArguments(ClassTemplatePartialSpecializationDecl *Partial,
                           const TemplateArgumentList &TemplateArgs,
@@ -3010,6 +3131,13 @@ public:
                           FunctionDecl *&Specialization,
                           TemplateDeductionInfo &Info);
 
+  TemplateDeductionResult
+  DeduceCallTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
+                          const TemplateArgumentListInfo *ExplicitTemplateArgs,
+                              Expr **Args, unsigned NumArgs,
+                              FunctionDecl *&Specialization,
+                              TemplateDeductionInfo &Info);
+
   TemplateDeductionResult
   DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
                           const TemplateArgumentListInfo *ExplicitTemplateArgs,
@@ -3182,6 +3310,68 @@ public:
   /// \c ActiveTemplateInstantiations that are not actual instantiations and,
   /// therefore, should not be counted as part of the instantiation depth.
   unsigned NonInstantiationEntries;
+
+  /// \brief Scratch memory for the temporaries built while instantiating
+  /// templates, such as the buffers of TypeLocBuilders.  It is reset when the
+  /// outermost template instantiation ends.
+  llvm::BumpPtrAllocator InstantiationScratch;
+
+  /// \brief The number of times InstantiationScratch was reset, and the
+  /// most memory it held at one of those times.
+  unsigned NumInstantiationScratchResets;
+  size_t MaxInstantiationScratchBytes;
+
+  /// \brief Return the scratch allocator for template instantiation, or
+  /// null if no template is being instantiated.
+  llvm::BumpPtrAllocator *getInstantiationScratch() {
+    if (ActiveTemplateInstantiations.empty())
+      return 0;
+    return &InstantiationScratch;
+  }
+
+  /// \brief Release the scratch memory of the template instantiation that
+  /// just ended.
+  void ResetInstantiationScratch();
+
+  /// \brief Memory for the CFGs built to check function and block bodies.
+  /// The CFGs only live until the body is checked, so one allocator serves
+  /// them all.
+  llvm::BumpPtrAllocator CFGScratch;
+  bool CFGScratchInUse;
+
+  /// \brief The number of times CFGScratch was reset, and the most memory
+  /// it held at one of those times.
+  unsigned NumCFGScratchResets;
+  size_t MaxCFGScratchBytes;
+
+  /// \brief Hands out CFGScratch for the CFG of one body, and resets it
+  /// when that body is done.  Declare it before the AnalysisContext using
+  /// it.  A body checked while another one is being checked gets no
+  /// scratch, and its CFG allocates its own memory.
+  class CFGScratchRegion {
+    Sema &S;
+    bool Owner;
+
+    CFGScratchRegion(const CFGScratchRegion &); // DO NOT IMPLEMENT
+    void operator=(const CFGScratchRegion &); // DO NOT IMPLEMENT
+
+  public:
+    explicit CFGScratchRegion(Sema &S) : S(S), Owner(!S.CFGScratchInUse) {
+      S.CFGScratchInUse = true;
+    }
+
+    ~CFGScratchRegion() {
+      if (!Owner)
+        return;
+      ++S.NumCFGScratchResets;
+      S.MaxCFGScratchBytes = std::max(S.MaxCFGScratchBytes,
+                                      S.CFGScratch.getTotalMemory());
+      S.CFGScratch.Reset();
+      S.CFGScratchInUse = false;
+    }
+
+    llvm::BumpPtrAllocator *get() const { return Owner ? &S.CFGScratch : 0; }
+  };
   
   /// \brief The last template from which a template instantiation
   /// error or warning was produced.
@@ -3442,6 +3632,10 @@ public:
                             const MultiLevelTemplateArgumentList &TemplateArgs,
                             SourceLocation Loc, DeclarationName Entity);
 
+  TypeSourceInfo *SubstDeclType(TypeSourceInfo *T,
+                            const MultiLevelTemplateArgumentList &TemplateArgs,
+                                SourceLocation Loc, DeclarationName Entity);
+
   QualType SubstType(QualType T,
                      const MultiLevelTemplateArgumentList &TemplateArgs,
                      SourceLocation Loc, DeclarationName Entity);
@@ -4124,6 +4318,9 @@ public:
   SourceLocation getLocationOfStringLiteralByte(const StringLiteral *SL,
                                                 unsigned ByteNo) const;
 
+  bool FormatArgTypeMatches(const analyze_printf::ArgTypeResult &ATR,
+                            QualType ArgTy);
+
 private:
   bool CheckFunctionCall(FunctionDecl *FDecl, CallExpr *TheCall);
   bool CheckBlockCall(NamedDecl *NDecl, CallExpr *TheCall);
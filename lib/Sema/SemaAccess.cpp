@@ -17,6 +17,8 @@
 #include "clang/AST/CXXInheritance.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
 
 using namespace clang;
 
@@ -50,10 +52,16 @@ bool Sema::SetMemberAccessSpecifier(NamedDecl *MemberDecl,
 }
 
 namespace {
+/// PathAccessMap - The friend-adjusted access along the best path from a
+/// derived class to a base, or none if friendship was dependent, for the
+/// access checks made from a single effective context.
+typedef llvm::DenseMap<std::pair<CXXRecordDecl *, CXXRecordDecl *>,
+                       std::pair<bool, AccessSpecifier> > PathAccessMap;
+
 struct EffectiveContext {
-  EffectiveContext() : Record(0), Function(0) {}
+  EffectiveContext() : Record(0), Function(0), PathAccess(0) {}
 
-  explicit EffectiveContext(DeclContext *DC) {
+  explicit EffectiveContext(DeclContext *DC) : PathAccess(0) {
     if (isa<FunctionDecl>(DC)) {
       Function = cast<FunctionDecl>(DC);
       DC = Function->getDeclContext();
@@ -72,6 +80,10 @@ struct EffectiveContext {
 
   CXXRecordDecl *Record;
   FunctionDecl *Function;
+
+  /// PathAccess - If non-null, the accesses along base paths computed so
+  /// far from this context.
+  PathAccessMap *PathAccess;
 };
 }
 
@@ -143,6 +155,33 @@ static CXXBasePath *FindBestPath(Sema &S,
   return BestPath;
 }
 
+/// Computes the best access along the paths from Derived to Base, reusing
+/// the computation of an earlier check from the same context if possible.
+///
+/// \return false if friendship is dependent
+static bool FindBestPathAccess(Sema &S,
+                               const EffectiveContext &EC,
+                               CXXRecordDecl *Derived,
+                               CXXRecordDecl *Base,
+                               AccessSpecifier &Access) {
+  std::pair<CXXRecordDecl *, CXXRecordDecl *> Key(Derived, Base);
+  if (EC.PathAccess) {
+    PathAccessMap::iterator Known = EC.PathAccess->find(Key);
+    if (Known != EC.PathAccess->end()) {
+      Access = Known->second.second;
+      return Known->second.first;
+    }
+  }
+
+  CXXBasePaths Paths;
+  CXXBasePath *Path = FindBestPath(S, EC, Derived, Base, Paths);
+  if (Path)
+    Access = Path->Access;
+  if (EC.PathAccess)
+    (*EC.PathAccess)[Key] = std::make_pair(Path != 0, Access);
+  return Path != 0;
+}
+
 /// Diagnose the path which caused the given declaration or base class
 /// to become inaccessible.
 static void DiagnoseAccessPath(Sema &S,
@@ -323,16 +362,14 @@ static void TryElevateAccess(Sema &S,
   assert(DeclaringClass != NamingClass);
 
   // Append the declaration's access if applicable.
-  CXXBasePaths Paths;
-  CXXBasePath *Path = FindBestPath(S, EC, Entity.getNamingClass(),
-                                   DeclaringClass, Paths);
-  if (!Path) {
+  AccessSpecifier NewAccess = AS_none;
+  if (!FindBestPathAccess(S, EC, Entity.getNamingClass(), DeclaringClass,
+                          NewAccess)) {
     // FIXME: delay dependent friendship
     return;
   }
 
   // Grab the access along the best path.
-  AccessSpecifier NewAccess = Path->Access;
   if (Entity.isMemberAccess())
     NewAccess = CXXRecordDecl::MergeAccess(NewAccess, DeclAccess);
   
@@ -406,6 +443,13 @@ static Sema::AccessResult CheckAccess(Sema &S, SourceLocation Loc,
   if (Entity.getAccess() == AS_public)
     return Sema::AR_accessible;
 
+  // Don't bother checking code in system headers if we were asked not to
+  // complain about it.
+  if (S.getLangOptions().NoSystemHeaderAccessControl &&
+      ADK == Sema::ADK_normal && Loc.isValid() &&
+      S.SourceMgr.isInSystemHeader(Loc))
+    return Sema::AR_accessible;
+
   // If we're currently parsing a top-level declaration, delay
   // diagnostics.  This is the only case where parsing a declaration
   // can actually change our effective context for the purposes of
@@ -421,13 +465,24 @@ static Sema::AccessResult CheckAccess(Sema &S, SourceLocation Loc,
                               Loc, Entity, ADK);
 }
 
-void Sema::HandleDelayedAccessCheck(DelayedDiagnostic &DD, Decl *Ctx) {
+/// Perform the access checks that were delayed while parsing the
+/// declaration Ctx.  The checks all happen from the same context, so they
+/// share the paths they find through the bases of the classes involved.
+void Sema::HandleDelayedAccessChecks(DelayedDiagnostic *Begin,
+                                     DelayedDiagnostic *End, Decl *Ctx) {
   // Pretend we did this from the context of the newly-parsed
   // declaration.
   EffectiveContext EC(Ctx->getDeclContext());
+  PathAccessMap PathAccess;
+  EC.PathAccess = &PathAccess;
+
+  for (DelayedDiagnostic *DD = Begin; DD != End; ++DD) {
+    if (DD->Triggered || DD->Kind != DelayedDiagnostic::Access)
+      continue;
 
-  if (CheckEffectiveAccess(*this, EC, DD.Loc, DD.AccessData, ADK_normal))
-    DD.Triggered = true;
+    if (CheckEffectiveAccess(*this, EC, DD->Loc, DD->AccessData, ADK_normal))
+      DD->Triggered = true;
+  }
 }
 
 Sema::AccessResult Sema::CheckUnresolvedLookupAccess(UnresolvedLookupExpr *E,
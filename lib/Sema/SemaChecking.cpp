@@ -1181,7 +1181,7 @@ CheckPrintfHandler::HandleAmount(const analyze_printf::OptionalAmount &Amt,
       const analyze_printf::ArgTypeResult &ATR = Amt.getArgType(S.Context);
       assert(ATR.isValid());
 
-      if (!ATR.matchesType(S.Context, T)) {
+      if (!S.FormatArgTypeMatches(ATR, T)) {
         S.Diag(getLocationOfByte(Amt.getStart()), BadTypeDiag)
           << ATR.getRepresentativeType(S.Context) << T
           << getFormatSpecifierRange(startSpecifier, specifierLen)
@@ -1281,13 +1281,13 @@ CheckPrintfHandler::HandleFormatSpecifier(const analyze_printf::FormatSpecifier
   // format specifier.
   const Expr *Ex = getDataArg(NumConversions);
   const analyze_printf::ArgTypeResult &ATR = FS.getArgType(S.Context);
-  if (ATR.isValid() && !ATR.matchesType(S.Context, Ex->getType())) {
+  if (ATR.isValid() && !S.FormatArgTypeMatches(ATR, Ex->getType())) {
     // Check if we didn't match because of an implicit cast from a 'char'
     // or 'short' to an 'int'.  This is done because printf is a varargs
     // function.
     if (const ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(Ex))
       if (ICE->getType() == S.Context.IntTy)
-        if (ATR.matchesType(S.Context, ICE->getSubExpr()->getType()))
+        if (S.FormatArgTypeMatches(ATR, ICE->getSubExpr()->getType()))
           return true;
 
     S.Diag(getLocationOfByte(CS.getStart()),
@@ -1334,15 +1334,50 @@ void Sema::CheckPrintfString(const StringLiteral *FExpr,
     return;
   }
 
+  // Parse each distinct format string once.  The specifiers of the parse
+  // point into the copy of the characters kept by the cache, so the handler
+  // measures offsets from there.
+  ++NumFormatStrings;
+  llvm::StringMapEntry<analyze_printf::ParsedFormatString> &Entry =
+    ParsedFormatStrings.GetOrCreateValue(llvm::StringRef(Str, StrLen));
+  bool Parsed = Entry.getValue().isParsed();
+  if (Parsed)
+    ++NumCachedFormatStrings;
+  else
+    Entry.getValue().Parse(Entry.getKeyData(),
+                           Entry.getKeyData() + Entry.getKeyLength());
+
   CheckPrintfHandler H(*this, FExpr, OrigFormatExpr,
                        TheCall->getNumArgs() - firstDataArg,
-                       isa<ObjCStringLiteral>(OrigFormatExpr), Str,
-                       HasVAListArg, TheCall, format_idx);
+                       isa<ObjCStringLiteral>(OrigFormatExpr),
+                       Entry.getKeyData(), HasVAListArg, TheCall, format_idx);
 
-  if (!analyze_printf::ParseFormatString(H, Str, Str + StrLen))
+  if (!Entry.getValue().Replay(H))
     H.DoneProcessing();
 }
 
+/// FormatArgTypeMatches - Whether an argument of type ArgTy matches the type
+/// expected by a format specifier.  The answer only depends on the types, so
+/// it is cached for the rest of the translation unit.
+bool Sema::FormatArgTypeMatches(const analyze_printf::ArgTypeResult &ATR,
+                                QualType ArgTy) {
+  ++NumFormatArgTypeChecks;
+  const QualType *Expected = ATR.getSpecificType();
+  void *ExpectedPtr = Expected ? Expected->getAsOpaquePtr() : 0;
+  FormatArgTypeKey Key(std::make_pair(ExpectedPtr, ArgTy.getAsOpaquePtr()),
+                       ATR.getKind());
+  llvm::DenseMap<FormatArgTypeKey, bool>::iterator Known =
+    FormatArgTypeResults.find(Key);
+  if (Known != FormatArgTypeResults.end()) {
+    ++NumCachedFormatArgTypeChecks;
+    return Known->second;
+  }
+
+  bool Matches = ATR.matchesType(Context, ArgTy);
+  FormatArgTypeResults[Key] = Matches;
+  return Matches;
+}
+
 //===--- CHECK: Return Address of Stack Variable --------------------------===//
 
 static DeclRefExpr* EvalVal(Expr *E);
@@ -117,13 +117,19 @@ namespace {
     /// nested-name-specifiers that would otherwise be filtered out.
     bool AllowNestedNameSpecifiers;
 
+    /// \brief Whether results whose names do not start with the prefix
+    /// given to the code-completion consumer are dropped.
+    bool FilterByPrefix;
+
     /// \brief A list of shadow maps, which is used to model name hiding at
     /// different levels of, e.g., the inheritance hierarchy.
     std::list<ShadowMap> ShadowMaps;
     
   public:
     explicit ResultBuilder(Sema &SemaRef, LookupFilter Filter = 0)
-      : SemaRef(SemaRef), Filter(Filter), AllowNestedNameSpecifiers(false) { }
+      : SemaRef(SemaRef), Filter(Filter), AllowNestedNameSpecifiers(false),
+        FilterByPrefix(SemaRef.CodeCompleter &&
+                       !SemaRef.CodeCompleter->getFilterPrefix().empty()) { }
     
     /// \brief Set the filter used for code-completion results.
     void setFilter(LookupFilter Filter) {
@@ -143,6 +149,14 @@ namespace {
       AllowNestedNameSpecifiers = Allow;
     }
 
+    /// \brief Keep the results whose names do not start with the prefix
+    /// given to the code-completion consumer.
+    void ignoreFilterPrefix() { FilterByPrefix = false; }
+
+    /// \brief Determine whether the name of the given result does not start
+    /// with the prefix given to the code-completion consumer.
+    bool isFilteredOut(const Result &R) const;
+
     /// \brief Determine whether the given declaration is at all interesting
     /// as a code-completion result.
     ///
@@ -352,6 +366,51 @@ getRequiredQualification(ASTContext &Context,
   return Result;
 }
 
+/// \brief Retrieve the name that should be used to order and filter a result.
+///
+/// If the name needs to be constructed as a string, that string will be
+/// saved into Saved and the returned StringRef will refer to it.
+static llvm::StringRef getResultName(const CodeCompleteConsumer::Result &R,
+                                     std::string &Saved) {
+  typedef CodeCompleteConsumer::Result Result;
+  switch (R.Kind) {
+  case Result::RK_Keyword:
+    return R.Keyword;
+      
+  case Result::RK_Pattern:
+    return R.Pattern->getTypedText();
+      
+  case Result::RK_Macro:
+    return R.Macro->getName();
+      
+  case Result::RK_Declaration:
+    // Handle declarations below.
+    break;
+  }
+        
+  DeclarationName Name = R.Declaration->getDeclName();
+  
+  // If the name is a simple identifier (by far the common case), or a
+  // zero-argument selector, just return a reference to that identifier.
+  if (IdentifierInfo *Id = Name.getAsIdentifierInfo())
+    return Id->getName();
+  if (Name.isObjCZeroArgSelector())
+    if (IdentifierInfo *Id
+                      = Name.getObjCSelector().getIdentifierInfoForSlot(0))
+      return Id->getName();
+  
+  Saved = Name.getAsString();
+  return Saved;
+}
+
+bool ResultBuilder::isFilteredOut(const Result &R) const {
+  if (!FilterByPrefix)
+    return false;
+
+  std::string Saved;
+  return !SemaRef.CodeCompleter->matchesFilterPrefix(getResultName(R, Saved));
+}
+
 bool ResultBuilder::isInterestingDecl(NamedDecl *ND, 
                                       bool &AsNestedNameSpecifier) const {
   AsNestedNameSpecifier = false;
@@ -449,6 +508,13 @@ bool ResultBuilder::CheckHiddenResult(Result &R, DeclContext *CurContext,
 
 void ResultBuilder::MaybeAddResult(Result R, DeclContext *CurContext) {
   assert(!ShadowMaps.empty() && "Must enter into a results scope");
+
+  // Results that do not match the typed prefix would be dropped by the
+  // client anyway, so there is no need to build them.
+  if (isFilteredOut(R)) {
+    R.Destroy();
+    return;
+  }
   
   if (R.Kind != Result::RK_Declaration) {
     // For non-declaration results, just add the result.
@@ -552,6 +618,11 @@ void ResultBuilder::MaybeAddResult(Result R, DeclContext *CurContext) {
 
 void ResultBuilder::AddResult(Result R, DeclContext *CurContext, 
                               NamedDecl *Hiding, bool InBaseClass = false) {
+  if (isFilteredOut(R)) {
+    R.Destroy();
+    return;
+  }
+
   if (R.Kind != Result::RK_Declaration) {
     // For non-declaration results, just add the result.
     Results.push_back(R);
@@ -604,6 +675,10 @@ void ResultBuilder::AddResult(Result R, DeclContext *CurContext,
 void ResultBuilder::AddResult(Result R) {
   assert(R.Kind != Result::RK_Declaration && 
           "Declaration results need more context");
+  if (isFilteredOut(R)) {
+    R.Destroy();
+    return;
+  }
   Results.push_back(R);
 }
 
@@ -719,21 +794,53 @@ bool ResultBuilder::IsObjCIvar(NamedDecl *ND) const {
   return isa<ObjCIvarDecl>(ND);
 }
 
+/// \brief Determine whether the given declaration is a global declaration of
+/// the PCH file, whose code-completion results the consumer may cache.
+static bool isCacheableGlobalDecl(NamedDecl *ND) {
+  // The target of a using declaration is found through the using
+  // declaration, in a context of its own.
+  return ND->getPCHLevel() > 0 && !isa<UsingShadowDecl>(ND) &&
+         ND->getDeclContext()->getLookupContext()->isTranslationUnit();
+}
+
 namespace {
   /// \brief Visible declaration consumer that adds a code-completion result
   /// for each visible declaration.
   class CodeCompletionDeclConsumer : public VisibleDeclConsumer {
     ResultBuilder &Results;
     DeclContext *CurContext;
+
+    /// \brief Whether to leave out the global declarations of the PCH file,
+    /// because the code-completion consumer caches them.
+    bool SkipCacheableGlobals;
     
   public:
-    CodeCompletionDeclConsumer(ResultBuilder &Results, DeclContext *CurContext)
-      : Results(Results), CurContext(CurContext) { }
+    CodeCompletionDeclConsumer(ResultBuilder &Results, DeclContext *CurContext,
+                               bool SkipCacheableGlobals = false)
+      : Results(Results), CurContext(CurContext),
+        SkipCacheableGlobals(SkipCacheableGlobals) { }
     
     virtual void FoundDecl(NamedDecl *ND, NamedDecl *Hiding, bool InBaseClass) {
+      if (SkipCacheableGlobals && isCacheableGlobalDecl(ND))
+        return;
       Results.AddResult(ND, CurContext, Hiding, InBaseClass);
     }
   };
+
+  /// \brief Collects the global declarations of the PCH file.
+  class CacheableGlobalDeclConsumer : public VisibleDeclConsumer {
+    ResultBuilder &Results;
+    DeclContext *TU;
+
+  public:
+    CacheableGlobalDeclConsumer(ResultBuilder &Results, DeclContext *TU)
+      : Results(Results), TU(TU) { }
+
+    virtual void FoundDecl(NamedDecl *ND, NamedDecl *Hiding, bool InBaseClass) {
+      if (isCacheableGlobalDecl(ND))
+        Results.AddResult(ND, TU, Hiding, InBaseClass);
+    }
+  };
 }
 
 /// \brief Add type specifiers for the current language as keyword results.
@@ -1825,46 +1932,10 @@ namespace {
                                                  Y.getAsString()) < 0;
     }
     
-    /// \brief Retrieve the name that should be used to order a result.
-    ///
-    /// If the name needs to be constructed as a string, that string will be
-    /// saved into Saved and the returned StringRef will refer to it.
-    static llvm::StringRef getOrderedName(const Result &R,
-                                          std::string &Saved) {
-      switch (R.Kind) {
-      case Result::RK_Keyword:
-        return R.Keyword;
-          
-      case Result::RK_Pattern:
-        return R.Pattern->getTypedText();
-          
-      case Result::RK_Macro:
-        return R.Macro->getName();
-          
-      case Result::RK_Declaration:
-        // Handle declarations below.
-        break;
-      }
-            
-      DeclarationName Name = R.Declaration->getDeclName();
-      
-      // If the name is a simple identifier (by far the common case), or a
-      // zero-argument selector, just return a reference to that identifier.
-      if (IdentifierInfo *Id = Name.getAsIdentifierInfo())
-        return Id->getName();
-      if (Name.isObjCZeroArgSelector())
-        if (IdentifierInfo *Id
-                          = Name.getObjCSelector().getIdentifierInfoForSlot(0))
-          return Id->getName();
-      
-      Saved = Name.getAsString();
-      return Saved;
-    }
-    
     bool operator()(const Result &X, const Result &Y) const {
       std::string XSaved, YSaved;
-      llvm::StringRef XStr = getOrderedName(X, XSaved);
-      llvm::StringRef YStr = getOrderedName(Y, YSaved);
+      llvm::StringRef XStr = getResultName(X, XSaved);
+      llvm::StringRef YStr = getResultName(Y, YSaved);
       int cmp = XStr.compare_lower(YStr);
       if (cmp)
         return cmp < 0;
@@ -1891,19 +1962,98 @@ static void AddMacroResults(Preprocessor &PP, ResultBuilder &Results) {
   Results.ExitScope();
 }
 
+namespace {
+  /// \brief Orders code-completion results by a cheap estimate of their
+  /// relevance, most relevant first.
+  struct RankCodeCompleteResult {
+    typedef CodeCompleteConsumer::Result Result;
+
+    llvm::StringRef Prefix;
+
+    explicit RankCodeCompleteResult(llvm::StringRef Prefix) : Prefix(Prefix) { }
+
+    /// \brief Compute the rank of a result; lower ranks are more relevant.
+    ///
+    /// Names that match the typed prefix with the same case come first.
+    /// Then come local declarations, members, global declarations, macros
+    /// and finally keywords and patterns; hidden results come last.
+    unsigned getRank(const Result &R) const {
+      unsigned Rank;
+      switch (R.Kind) {
+      case Result::RK_Declaration: {
+        DeclContext *DC = R.Declaration->getDeclContext()->getLookupContext();
+        if (DC->isFunctionOrMethod())
+          Rank = 0;
+        else if (!DC->isTranslationUnit())
+          Rank = 1;
+        else
+          Rank = 2;
+        break;
+      }
+      case Result::RK_Macro:
+        Rank = 3;
+        break;
+      default:
+        Rank = 4;
+        break;
+      }
+
+      std::string Saved;
+      if (!getResultName(R, Saved).startswith(Prefix))
+        Rank += 5;
+      if (R.Hidden)
+        Rank += 10;
+      return Rank;
+    }
+
+    bool operator()(const Result &X, const Result &Y) const {
+      return getRank(X) < getRank(Y);
+    }
+  };
+}
+
 static void HandleCodeCompleteResults(Sema *S,
                                       CodeCompleteConsumer *CodeCompleter,
                                      CodeCompleteConsumer::Result *Results,
                                      unsigned NumResults) {
-  std::stable_sort(Results, Results + NumResults, SortCodeCompleteResult());
+  // When the consumer only wants the most relevant results, keep them and
+  // drop the rest before any completion string is built.
+  unsigned NumKept = NumResults;
+  if (CodeCompleter && CodeCompleter->getMaxResults() &&
+      NumResults > CodeCompleter->getMaxResults()) {
+    NumKept = CodeCompleter->getMaxResults();
+    std::stable_sort(Results, Results + NumResults,
+                     RankCodeCompleteResult(CodeCompleter->getFilterPrefix()));
+  }
+
+  std::stable_sort(Results, Results + NumKept, SortCodeCompleteResult());
 
   if (CodeCompleter)
-    CodeCompleter->ProcessCodeCompleteResults(*S, Results, NumResults);
+    CodeCompleter->ProcessCodeCompleteResults(*S, Results, NumKept);
   
   for (unsigned I = 0; I != NumResults; ++I)
     Results[I].Destroy();
 }
 
+/// \brief Hand the results for the global declarations of the PCH file that
+/// pass \p Filter to the code-completion consumer, to be cached.
+static void CacheGlobalResults(Sema &S, ResultBuilder::LookupFilter Filter,
+                               CodeCompleteConsumer *CodeCompleter) {
+  // The cached results serve completions with any prefix.
+  ResultBuilder Results(S, Filter);
+  Results.ignoreFilterPrefix();
+  TranslationUnitDecl *TU = S.Context.getTranslationUnitDecl();
+  CacheableGlobalDeclConsumer Consumer(Results, TU);
+  S.LookupVisibleDecls(TU, Sema::LookupOrdinaryName, Consumer);
+
+  std::stable_sort(Results.begin(), Results.end(), SortCodeCompleteResult());
+  CodeCompleter->CacheGlobalResults(S, Results.data(), Results.size());
+
+  for (ResultBuilder::iterator R = Results.begin(), REnd = Results.end();
+       R != REnd; ++R)
+    R->Destroy();
+}
+
 void Sema::CodeCompleteOrdinaryName(Scope *S, 
                                     CodeCompletionContext CompletionContext) {
   typedef CodeCompleteConsumer::Result Result;
@@ -1912,6 +2062,7 @@ void Sema::CodeCompleteOrdinaryName(Scope *S,
   // Determine how to filter results, e.g., so that the names of
   // values (functions, enumerators, function templates, etc.) are
   // only allowed where we can have an expression.
+  ResultBuilder::LookupFilter Filter = 0;
   switch (CompletionContext) {
   case CCC_Namespace:
   case CCC_Class:
@@ -1920,18 +2071,27 @@ void Sema::CodeCompleteOrdinaryName(Scope *S,
   case CCC_ObjCInstanceVariableList:
   case CCC_Template:
   case CCC_MemberTemplate:
-    Results.setFilter(&ResultBuilder::IsOrdinaryNonValueName);
+    Filter = &ResultBuilder::IsOrdinaryNonValueName;
     break;
 
   case CCC_Expression:
   case CCC_Statement:
   case CCC_ForInit:
   case CCC_Condition:
-    Results.setFilter(&ResultBuilder::IsOrdinaryName);
+    Filter = &ResultBuilder::IsOrdinaryName;
     break;
   }
+  Results.setFilter(Filter);
 
-  CodeCompletionDeclConsumer Consumer(Results, CurContext);
+  // The results for the global declarations of the PCH file are the same for
+  // every completion in this context, so the consumer may have them cached.
+  CodeCompleteConsumer::GlobalResultsCacheState CacheState
+    = CodeCompleter->getGlobalResultsCacheState(CompletionContext);
+  if (CacheState == CodeCompleteConsumer::GRC_Missing)
+    CacheGlobalResults(*this, Filter, CodeCompleter);
+
+  CodeCompletionDeclConsumer Consumer(Results, CurContext,
+                            CacheState != CodeCompleteConsumer::GRC_None);
   LookupVisibleDecls(S, LookupOrdinaryName, Consumer);
 
   Results.EnterNewScope();
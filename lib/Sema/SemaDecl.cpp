@@ -221,6 +221,12 @@ Sema::TypeTy *Sema::getTypeName(IdentifierInfo &II, SourceLocation NameLoc,
   return T.getAsOpaquePtr();
 }
 
+unsigned Sema::getNameLookupGeneration() {
+  // Both counters only ever grow, so their sum changes whenever either does.
+  // Never return 0, which tells the parser not to reuse lookups at all.
+  return Context.getLookupGeneration() + IdResolver.getGeneration() + 1;
+}
+
 /// isTagName() - This method is called *for error recovery purposes only*
 /// to determine if the specified name is a valid tag name ("struct foo").  If
 /// so, this returns the TST for the tag corresponding to it (TST_enum,
@@ -446,6 +452,20 @@ void Sema::PushOnScopeChains(NamedDecl *D, Scope *S, bool AddToContext) {
       (isa<VarDecl>(D) && cast<VarDecl>(D)->isOutOfLine()))
     return;
 
+  // A function can only replace its previous declaration, so there is no
+  // need to walk what may be a long chain of overloads.
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    if (FunctionDecl *Prev = FD->getPreviousDeclaration())
+      if (S->isDeclScope(DeclPtrTy::make(Prev))) {
+        S->RemoveDecl(DeclPtrTy::make(Prev));
+        IdResolver.RemoveDecl(Prev);
+      }
+
+    S->AddDecl(DeclPtrTy::make(D));
+    IdResolver.AddDecl(D);
+    return;
+  }
+
   // If this replaces anything in the current scope, 
   IdentifierResolver::iterator I = IdResolver.begin(D->getDeclName()),
                                IEnd = IdResolver.end();
@@ -4073,6 +4093,7 @@ Sema::DeclPtrTy Sema::ActOnStartOfFunctionDef(Scope *FnBodyScope, DeclPtrTy D) {
     FD = cast<FunctionDecl>(D.getAs<Decl>());
 
   CurFunctionNeedsScopeChecking = false;
+  Context.StartFunctionBody();
 
   // See if this is a redefinition.
   // But don't complain if we're in GNU89 mode and the previous definition
@@ -4159,7 +4180,8 @@ Sema::DeclPtrTy Sema::ActOnFinishFunctionBody(DeclPtrTy D, StmtArg BodyArg,
 
   // Don't generate EH edges for CallExprs as we'd like to avoid the n^2
   // explosion for destrutors that can result and the compile time hit.
-  AnalysisContext AC(dcl, false);
+  CFGScratchRegion CFGScratch(*this);
+  AnalysisContext AC(dcl, false, CFGScratch.get());
   FunctionDecl *FD = 0;
   FunctionTemplateDecl *FunTmpl = dyn_cast_or_null<FunctionTemplateDecl>(dcl);
   if (FunTmpl)
@@ -4167,13 +4189,23 @@ Sema::DeclPtrTy Sema::ActOnFinishFunctionBody(DeclPtrTy D, StmtArg BodyArg,
   else
     FD = dyn_cast_or_null<FunctionDecl>(dcl);
 
+  // Statements created from here on live as long as the context does.
+  Context.FinishFunctionBody(FD);
+
   if (FD) {
+    // An instantiation of a function whose body was skipped gets the same
+    // empty body, which must not be checked either.
+    const FunctionDecl *Pattern
+      = IsInstantiation? FD->getTemplateInstantiationPattern() : 0;
+    bool SkippedBody
+      = Pattern && Context.getSkippedFunctionBody(Pattern).isValid();
+
     FD->setBody(Body);
     if (FD->isMain())
       // C and C++ allow for main to automagically return 0.
       // Implements C++ [basic.start.main]p5 and C99 5.1.2.2.3.
       FD->setHasImplicitReturnZero(true);
-    else
+    else if (!SkippedBody)
       CheckFallThroughForFunctionDef(FD, Body, AC);
 
     if (!FD->isInvalidDecl())
@@ -4269,6 +4301,70 @@ Sema::DeclPtrTy Sema::ActOnFinishFunctionBody(DeclPtrTy D, StmtArg BodyArg,
   return D;
 }
 
+Sema::DeclPtrTy Sema::ActOnSkippedFunctionBody(DeclPtrTy D,
+                                               SourceLocation LBraceLoc,
+                                               SourceLocation RBraceLoc) {
+  Decl *dcl = D.getAs<Decl>();
+  FunctionDecl *FD = 0;
+  if (FunctionTemplateDecl *FunTmpl
+        = dyn_cast_or_null<FunctionTemplateDecl>(dcl))
+    FD = FunTmpl->getTemplatedDecl();
+  else
+    FD = dyn_cast_or_null<FunctionDecl>(dcl);
+  if (!FD)
+    return DeclPtrTy();
+  Context.FinishFunctionBody(FD);
+
+  // Give the function an empty body, so that it is still a definition, and
+  // remember where the real body is so that it can be parsed later.  None of
+  // the checks of a parsed body apply.
+  FD->setBody(new (Context) CompoundStmt(Context, 0, 0, LBraceLoc, RBraceLoc));
+  if (FD->isMain())
+    FD->setHasImplicitReturnZero(true);
+  Context.setSkippedFunctionBody(FD, SourceRange(LBraceLoc, RBraceLoc));
+
+  if (CXXMethodDecl *Method = dyn_cast<CXXMethodDecl>(FD))
+    MaybeMarkVirtualMembersReferenced(Method->getLocation(), Method);
+
+  assert(FD == getCurFunctionDecl() && "Function parsing confused");
+  PopDeclContext();
+
+  if (PP.getDiagnostics().hasErrorOccurred())
+    ExprTemporaries.clear();
+  return D;
+}
+
+Sema::DeclPtrTy Sema::ActOnStartOfSkippedFunctionBody(Scope *FnBodyScope,
+                                                      DeclPtrTy D) {
+  // The template parameter scopes of templates are gone by now, so their
+  // bodies can't be parsed.
+  FunctionDecl *FD = dyn_cast_or_null<FunctionDecl>(D.getAs<Decl>());
+  if (!FD || FD->isDependentContext() ||
+      Context.getSkippedFunctionBody(FD).isInvalid())
+    return DeclPtrTy();
+  Context.setSkippedFunctionBody(FD, SourceRange());
+
+  CurFunctionNeedsScopeChecking = false;
+
+  // Enter the context the function was written in.  Unqualified lookup in
+  // C++ searches it and its enclosing contexts up to the translation unit.
+  CurContext = getContainingDC(FD);
+  PushDeclContext(FnBodyScope, FD);
+
+  for (unsigned p = 0, NumParams = FD->getNumParams(); p < NumParams; ++p) {
+    ParmVarDecl *Param = FD->getParamDecl(p);
+    if (Param->getIdentifier())
+      PushOnScopeChains(Param, FnBodyScope);
+  }
+  return D;
+}
+
+void Sema::ActOnFinishSkippedFunctionBody(DeclPtrTy D) {
+  // ActOnFinishFunctionBody left us in the context the function was written
+  // in; skipped bodies are parsed at the end of the translation unit.
+  CurContext = Context.getTranslationUnitDecl();
+}
+
 /// ImplicitlyDefineFunction - An undeclared identifier was used in a function
 /// call, forming a call to an implicitly defined function (per C99 6.5.1p2).
 NamedDecl *Sema::ImplicitlyDefineFunction(SourceLocation Loc,
@@ -1957,6 +1957,7 @@ void Sema::PopParsingDeclaration(ParsingDeclStackState S, DeclPtrTy Ctx) {
     // only the declarator pops will be passed decls.  This is correct;
     // we really do need to consider delayed diagnostics from the decl spec
     // for each of the different declarations.
+    bool HasAccessChecks = false;
     for (unsigned I = 0, E = DelayedDiagnostics.size(); I != E; ++I) {
       if (DelayedDiagnostics[I].Triggered)
         continue;
@@ -1967,10 +1968,15 @@ void Sema::PopParsingDeclaration(ParsingDeclStackState S, DeclPtrTy Ctx) {
         break;
 
       case DelayedDiagnostic::Access:
-        HandleDelayedAccessCheck(DelayedDiagnostics[I], D);
+        HasAccessChecks = true;
         break;
       }
     }
+
+    // Resolve the access checks together, after the deprecation checks.
+    if (HasAccessChecks)
+      HandleDelayedAccessChecks(DelayedDiagnostics.begin(),
+                                DelayedDiagnostics.end(), D);
   }
 
   DelayedDiagnostics.set_size(SavedIndex);
@@ -2109,8 +2109,19 @@ void Sema::CheckCompletedCXXClass(CXXRecordDecl *Record) {
   if (!Record || Record->isInvalidDecl())
     return;
 
-  if (!Record->isDependentType())
-    AddImplicitlyDeclaredMembersToClass(Record);
+  if (!Record->isDependentType()) {
+    // Most classes never have their special members looked up, so only
+    // declare the implicit ones when they are.  The implicit destructor and
+    // copy assignment operator of a dynamic class may be virtual, though,
+    // and the vtable walks the methods of the class instead of looking them
+    // up.
+    if (Record->isDynamicClass() || !Context.ImplicitMembers) {
+      AddImplicitlyDeclaredMembersToClass(Record);
+    } else {
+      Record->setDeferredImplicitMembers(true);
+      ++NumDeferredImplicitMembers;
+    }
+  }
   
   if (Record->isInvalidDecl())
     return;
@@ -2149,6 +2160,13 @@ void Sema::ActOnFinishCXXMemberSpecification(Scope* S, SourceLocation RLoc,
                       dyn_cast_or_null<CXXRecordDecl>(TagDecl.getAs<Decl>()));
 }
 
+void Sema::DeferredImplicitMembers::DeclareImplicitMembers(
+                                                       CXXRecordDecl *Record) {
+  Record->setDeferredImplicitMembers(false);
+  ++S.NumDeclaredImplicitMembers;
+  S.AddImplicitlyDeclaredMembersToClass(Record);
+}
+
 /// AddImplicitlyDeclaredMembersToClass - Adds any implicitly-declared
 /// special functions, such as the default constructor, copy
 /// constructor, or destructor, to the given C++ class (C++
@@ -3030,10 +3048,12 @@ void Sema::PushUsingDirective(Scope *S, UsingDirectiveDecl *UDir) {
   // it's lookup structure.
   if (DeclContext *Ctx = static_cast<DeclContext*>(S->getEntity()))
     Ctx->addDecl(UDir);
-  else
+  else {
     // Otherwise it is block-sope. using-directives will affect lookup
     // only to the end of scope.
     S->PushUsingDirective(DeclPtrTy::make(UDir));
+    Context.bumpLookupGeneration();
+  }
 }
 
 
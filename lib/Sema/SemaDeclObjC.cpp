@@ -1457,40 +1457,28 @@ bool Sema::MatchTwoMethodDeclarations(const ObjCMethodDecl *Method,
   return true;
 }
 
-/// \brief Read the contents of the instance and factory method pools
-/// for a given selector from external storage.
+/// \brief Read the instance or the factory methods with a given selector
+/// from external storage.
 ///
-/// This routine should only be called once, when neither the instance
-/// nor the factory method pool has an entry for this selector.
+/// This routine should only be called once per pool, when that pool has no
+/// entry for this selector.
 Sema::MethodPool::iterator Sema::ReadMethodPool(Selector Sel,
                                                 bool isInstance) {
   assert(ExternalSource && "We need an external AST source");
-  assert(InstanceMethodPool.find(Sel) == InstanceMethodPool.end() &&
-         "Selector data already loaded into the instance method pool");
-  assert(FactoryMethodPool.find(Sel) == FactoryMethodPool.end() &&
-         "Selector data already loaded into the factory method pool");
+  MethodPool &Pool = isInstance ? InstanceMethodPool : FactoryMethodPool;
+  assert(Pool.find(Sel) == Pool.end() &&
+         "Selector data already loaded into the method pool");
 
   // Read the method list from the external source.
-  std::pair<ObjCMethodList, ObjCMethodList> Methods
-    = ExternalSource->ReadMethodPool(Sel);
-
-  if (isInstance) {
-    if (Methods.second.Method)
-      FactoryMethodPool[Sel] = Methods.second;
-    return InstanceMethodPool.insert(std::make_pair(Sel, Methods.first)).first;
-  }
-
-  if (Methods.first.Method)
-    InstanceMethodPool[Sel] = Methods.first;
-
-  return FactoryMethodPool.insert(std::make_pair(Sel, Methods.second)).first;
+  ObjCMethodList Methods = ExternalSource->ReadMethodPool(Sel, isInstance);
+  return Pool.insert(std::make_pair(Sel, Methods)).first;
 }
 
 void Sema::AddInstanceMethodToGlobalPool(ObjCMethodDecl *Method) {
   llvm::DenseMap<Selector, ObjCMethodList>::iterator Pos
     = InstanceMethodPool.find(Method->getSelector());
   if (Pos == InstanceMethodPool.end()) {
-    if (ExternalSource && !FactoryMethodPool.count(Method->getSelector()))
+    if (ExternalSource)
       Pos = ReadMethodPool(Method->getSelector(), /*isInstance=*/true);
     else
       Pos = InstanceMethodPool.insert(std::make_pair(Method->getSelector(),
@@ -1524,7 +1512,7 @@ ObjCMethodDecl *Sema::LookupInstanceMethodInGlobalPool(Selector Sel,
   llvm::DenseMap<Selector, ObjCMethodList>::iterator Pos
     = InstanceMethodPool.find(Sel);
   if (Pos == InstanceMethodPool.end()) {
-    if (ExternalSource && !FactoryMethodPool.count(Sel))
+    if (ExternalSource)
       Pos = ReadMethodPool(Sel, /*isInstance=*/true);
     else
       return 0;
@@ -1554,7 +1542,7 @@ void Sema::AddFactoryMethodToGlobalPool(ObjCMethodDecl *Method) {
   llvm::DenseMap<Selector, ObjCMethodList>::iterator Pos
     = FactoryMethodPool.find(Method->getSelector());
   if (Pos == FactoryMethodPool.end()) {
-    if (ExternalSource && !InstanceMethodPool.count(Method->getSelector()))
+    if (ExternalSource)
       Pos = ReadMethodPool(Method->getSelector(), /*isInstance=*/false);
     else
       Pos = FactoryMethodPool.insert(std::make_pair(Method->getSelector(),
@@ -1589,7 +1577,7 @@ ObjCMethodDecl *Sema::LookupFactoryMethodInGlobalPool(Selector Sel,
   llvm::DenseMap<Selector, ObjCMethodList>::iterator Pos
     = FactoryMethodPool.find(Sel);
   if (Pos == FactoryMethodPool.end()) {
-    if (ExternalSource && !InstanceMethodPool.count(Sel))
+    if (ExternalSource)
       Pos = ReadMethodPool(Sel, /*isInstance=*/false);
     else
       return 0;
@@ -33,6 +33,7 @@
 #include <iterator>
 #include <utility>
 #include <algorithm>
+#include <cstring>
 
 using namespace clang;
 
@@ -947,6 +948,19 @@ static bool LookupQualifiedNameInUsingDirectives(Sema &S, LookupResult &R,
   return Found;
 }
 
+/// \brief Add the declarations found by a lookup through the base classes of
+/// the naming class to a lookup result.
+static void AddBaseMemberLookupResults(LookupResult &R,
+                                       const Sema::BaseMemberLookup &Lookup) {
+  for (unsigned I = 0, N = Lookup.Decls.size(); I != N; ++I) {
+    NamedDecl *D = Lookup.Decls[I];
+    AccessSpecifier AS = CXXRecordDecl::MergeAccess(Lookup.SubobjectAccess,
+                                                    D->getAccess());
+    R.addDecl(D, AS);
+  }
+  R.resolveKind();
+}
+
 /// \brief Perform qualified name lookup into a given context.
 ///
 /// Qualified name lookup (C++ [basic.lookup.qual]) is used to find
@@ -1057,9 +1071,32 @@ bool Sema::LookupQualifiedName(LookupResult &R, DeclContext *LookupCtx,
       break;
   }
   
-  if (!LookupRec->lookupInBases(BaseCallback,
-                                R.getLookupName().getAsOpaquePtr(), Paths))
-    return false;
+  // Reuse the result of an earlier lookup of this name through the same
+  // bases, unless some class has changed since.
+  if (BaseMemberLookupsGeneration != Context.getRecordLookupGeneration()) {
+    BaseMemberLookups.clear();
+    BaseMemberLookupsGeneration = Context.getRecordLookupGeneration();
+  }
+  ++NumBaseMemberLookups;
+  BaseMemberLookupKey Key(LookupRec,
+                          std::make_pair(R.getLookupName().getAsOpaquePtr(),
+                                         (unsigned) R.getLookupKind()));
+  llvm::DenseMap<BaseMemberLookupKey, BaseMemberLookup>::iterator Cached
+    = BaseMemberLookups.find(Key);
+  if (Cached == BaseMemberLookups.end()) {
+    if (!LookupRec->lookupInBases(BaseCallback,
+                                  R.getLookupName().getAsOpaquePtr(), Paths)) {
+      BaseMemberLookups[Key].Found = false;
+      return false;
+    }
+  } else {
+    ++NumCachedBaseMemberLookups;
+    if (!Cached->second.Found)
+      return false;
+    R.setNamingClass(LookupRec);
+    AddBaseMemberLookupResults(R, Cached->second);
+    return true;
+  }
 
   R.setNamingClass(LookupRec);
 
@@ -1132,16 +1169,12 @@ bool Sema::LookupQualifiedName(LookupResult &R, DeclContext *LookupCtx,
     }
   }
 
-  // Lookup in a base class succeeded; return these results.
-
-  DeclContext::lookup_iterator I, E;
-  for (llvm::tie(I,E) = Paths.front().Decls; I != E; ++I) {
-    NamedDecl *D = *I;
-    AccessSpecifier AS = CXXRecordDecl::MergeAccess(SubobjectAccess,
-                                                    D->getAccess());
-    R.addDecl(D, AS);
-  }
-  R.resolveKind();
+  // Lookup in a base class succeeded; remember and return these results.
+  BaseMemberLookup &Result = BaseMemberLookups[Key];
+  Result.Found = true;
+  Result.SubobjectAccess = SubobjectAccess;
+  Result.Decls.append(Paths.front().Decls.first, Paths.front().Decls.second);
+  AddBaseMemberLookupResults(R, Result);
   return true;
 }
 
@@ -2295,16 +2328,31 @@ class TypoCorrectionConsumer : public VisibleDeclConsumer {
   /// \brief The name written that is a typo in the source.
   llvm::StringRef Typo;
 
+  /// \brief The number of characters of the typo that fall into each
+  /// bucket, used to bound the edit distance of a candidate from below.
+  int TypoHistogram[32];
+
   /// \brief The results found that have the smallest edit distance
   /// found (so far) with the typo name.
   llvm::SmallVector<NamedDecl *, 4> BestResults;
 
   /// \brief The best edit distance found so far.
   unsigned BestEditDistance;
-  
+
+  /// \brief The number of candidates whose edit distance may still be
+  /// computed, or ~0U if there is no limit.
+  unsigned CandidatesLeft;
+
+  unsigned getMinEditDistance(llvm::StringRef Name) const;
+
 public:
-  explicit TypoCorrectionConsumer(IdentifierInfo *Typo)
-    : Typo(Typo->getName()) { }
+  TypoCorrectionConsumer(IdentifierInfo *Typo, unsigned MaxCandidates)
+    : Typo(Typo->getName()),
+      CandidatesLeft(MaxCandidates ? MaxCandidates : ~0U) {
+    std::memset(TypoHistogram, 0, sizeof(TypoHistogram));
+    for (unsigned I = 0, N = this->Typo.size(); I != N; ++I)
+      ++TypoHistogram[this->Typo[I] & 31];
+  }
 
   virtual void FoundDecl(NamedDecl *ND, NamedDecl *Hiding, bool InBaseClass);
 
@@ -2318,6 +2366,28 @@ public:
 
 }
 
+/// \brief Compute a lower bound on the edit distance between the typo and
+/// \p Name that is much cheaper than the edit distance itself.
+///
+/// Each insertion or deletion changes the length by one, and each edit
+/// changes the histogram of characters by at most two, so the edit distance
+/// is at least the length difference and half the histogram difference.
+unsigned TypoCorrectionConsumer::getMinEditDistance(llvm::StringRef Name)
+  const {
+  int Histogram[32];
+  std::memcpy(Histogram, TypoHistogram, sizeof(Histogram));
+  for (unsigned I = 0, N = Name.size(); I != N; ++I)
+    --Histogram[Name[I] & 31];
+
+  unsigned HistogramDiff = 0;
+  for (unsigned I = 0; I != 32; ++I)
+    HistogramDiff += Histogram[I] < 0 ? -Histogram[I] : Histogram[I];
+
+  unsigned LengthDiff = Name.size() > Typo.size() ? Name.size() - Typo.size()
+                                                  : Typo.size() - Name.size();
+  return std::max(LengthDiff, (HistogramDiff + 1) / 2);
+}
+
 void TypoCorrectionConsumer::FoundDecl(NamedDecl *ND, NamedDecl *Hiding, 
                                        bool InBaseClass) {
   // Don't consider hidden names for typo correction.
@@ -2331,6 +2401,17 @@ void TypoCorrectionConsumer::FoundDecl(NamedDecl *ND, NamedDecl *Hiding,
   if (!Name)
     return;
 
+  // Skip names that cannot be as close to the typo as the best results,
+  // without computing their edit distance.
+  if (!BestResults.empty() &&
+      getMinEditDistance(Name->getName()) > BestEditDistance)
+    return;
+
+  // Give up on the remaining names once we have examined enough of them.
+  if (CandidatesLeft == 0)
+    return;
+  --CandidatesLeft;
+
   // Compute the edit distance between the typo and the name of this
   // entity. If this edit distance is not worse than the best edit
   // distance we've seen so far, add it to the list of results.
@@ -2387,8 +2468,8 @@ bool Sema::CorrectTypo(LookupResult &Res, Scope *S, const CXXScopeSpec *SS,
   // Provide a stop gap for files that are just seriously broken.  Trying
   // to correct all typos can turn into a HUGE performance penalty, causing
   // some files to take minutes to get rejected by the parser.
-  // FIXME: Is this the right solution?
-  if (TyposCorrected == 20)
+  unsigned TypoLimit = getLangOptions().TypoCorrectionLimit;
+  if (TypoLimit && TyposCorrected == TypoLimit)
     return false;
   ++TyposCorrected;
   
@@ -2407,7 +2488,8 @@ bool Sema::CorrectTypo(LookupResult &Res, Scope *S, const CXXScopeSpec *SS,
   if (!ActiveTemplateInstantiations.empty())
     return false;
 
-  TypoCorrectionConsumer Consumer(Typo);
+  TypoCorrectionConsumer Consumer(Typo,
+                                  getLangOptions().TypoCandidateLimit);
   if (MemberContext) {
     LookupVisibleDecls(MemberContext, Res.getLookupKind(), Consumer);
 
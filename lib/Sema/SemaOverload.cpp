@@ -275,6 +275,41 @@ AmbiguousConversionSequence::copyFrom(const AmbiguousConversionSequence &O) {
   new (&conversions()) ConversionSet(O.conversions());
 }
 
+OverloadCandidate &
+OverloadCandidateSet::addCandidate(unsigned NumConversions) {
+  typedef ImplicitConversionSequence ICS;
+  ICS *Conversions = 0;
+  if (NumConversions) {
+    if (NumInlineConversionsUsed + NumConversions <= NumInlineConversions) {
+      Conversions = reinterpret_cast<ICS *>(InlineSpace.Buffer) +
+                    NumInlineConversionsUsed;
+      NumInlineConversionsUsed += NumConversions;
+    } else {
+      if (!ConversionArena)
+        ConversionArena.reset(new llvm::BumpPtrAllocator());
+      Conversions = ConversionArena->Allocate<ICS>(NumConversions);
+    }
+
+    for (unsigned I = 0; I != NumConversions; ++I)
+      new (&Conversions[I]) ICS();
+  }
+
+  push_back(OverloadCandidate());
+  OverloadCandidate &Candidate = back();
+  Candidate.Conversions = Conversions;
+  Candidate.NumConversions = NumConversions;
+  return Candidate;
+}
+
+void OverloadCandidateSet::destroyCandidates() {
+  for (iterator Cand = begin(), CandEnd = end(); Cand != CandEnd; ++Cand)
+    for (unsigned I = 0; I != Cand->NumConversions; ++I)
+      Cand->Conversions[I].~ImplicitConversionSequence();
+  NumInlineConversionsUsed = 0;
+  if (ConversionArena)
+    ConversionArena->Reset();
+}
+
 
 // IsOverload - Determine whether the given New declaration is an
 // overload of the declarations in Old. This routine returns false if
@@ -452,7 +487,11 @@ Sema::TryImplicitConversion(Expr* From, QualType ToType,
     return ICS;
   }
 
-  if (!getLangOptions().CPlusPlus) {
+  // Only a conversion from or to a class type can be user-defined, so don't
+  // go looking for constructors and conversion functions otherwise.
+  if (!getLangOptions().CPlusPlus ||
+      (!From->getType()->getAs<RecordType>() &&
+       !ToType->getAs<RecordType>())) {
     ICS.setBad();
     ICS.Bad.init(BadConversionSequence::no_conversion, From, ToType);
     return ICS;
@@ -536,6 +575,45 @@ static bool IsNoReturnConversion(ASTContext &Context, QualType FromType,
   return true;
 }
   
+/// isTypeOnlyStandardConversion - Determine whether the standard conversion
+/// from the expression From to ToType only depends on the types involved and
+/// on whether From is an lvalue, so that it can be cached.
+static bool isTypeOnlyStandardConversion(Sema &S, Expr *From,
+                                         QualType ToType) {
+  // There are no standard conversions for class types in C++, and the
+  // Objective-C conversions depend on the class hierarchy.
+  const LangOptions &LangOpts = S.getLangOptions();
+  if (!LangOpts.CPlusPlus || LangOpts.ObjC1)
+    return false;
+
+  QualType FromType = From->getType();
+  if (FromType->isRecordType() || ToType->isRecordType() ||
+      S.Context.getCanonicalType(FromType) == S.Context.OverloadTy)
+    return false;
+
+  // Integral promotions of bit-fields depend on the width of the field.
+  if (From->getBitField())
+    return false;
+
+  // String literals have their own, deprecated, conversion to pointers.
+  if (FromType->isArrayType() && isa<StringLiteral>(From->IgnoreParenCasts()))
+    return false;
+
+  // So do null pointer constants.
+  if ((FromType->isIntegralType() || FromType->isEnumeralType() ||
+       FromType->isNullPtrType()) &&
+      (ToType->isAnyPointerType() || ToType->isBlockPointerType() ||
+       ToType->isMemberPointerType()))
+    return false;
+
+  // The promoted type of an enumeration is only known once it is complete.
+  if (const EnumType *Enum = FromType->getAs<EnumType>())
+    if (!Enum->getDecl()->isDefinition())
+      return false;
+
+  return true;
+}
+
 /// IsStandardConversion - Determines whether there is a standard
 /// conversion sequence (C++ [conv], C++ [over.ics.scs]) from the
 /// expression From to the type ToType. Standard conversion sequences
@@ -544,10 +622,64 @@ static bool IsNoReturnConversion(ASTContext &Context, QualType FromType,
 /// contain the standard conversion sequence required to perform this
 /// conversion and this routine will return true. Otherwise, this
 /// routine will return false and the value of SCS is unspecified.
+///
+/// Conversions that only depend on the types involved are cached for the
+/// rest of the translation unit.
 bool
 Sema::IsStandardConversion(Expr* From, QualType ToType,
                            bool InOverloadResolution,
                            StandardConversionSequence &SCS) {
+  if (!isTypeOnlyStandardConversion(*this, From, ToType))
+    return ComputeStandardConversion(From, ToType, InOverloadResolution, SCS);
+
+  if (StandardConversionsGeneration != Context.getRecordLookupGeneration()) {
+    StandardConversions.clear();
+    StandardConversionsGeneration = Context.getRecordLookupGeneration();
+  }
+  ++NumStandardConversions;
+
+  // The types are the ones written, not the canonical ones, so that the
+  // conversion sequence and the diagnostics that mention it keep their sugar.
+  unsigned Flags = (From->isLvalue(Context) == Expr::LV_Valid) |
+                   (InOverloadResolution << 1);
+  StandardConversionKey Key(std::make_pair(From->getType().getAsOpaquePtr(),
+                                           ToType.getAsOpaquePtr()),
+                            Flags);
+  llvm::DenseMap<StandardConversionKey, CachedStandardConversion>::iterator
+    Known = StandardConversions.find(Key);
+  if (Known != StandardConversions.end()) {
+    ++NumCachedStandardConversions;
+    SCS = Known->second.SCS;
+    return Known->second.Success;
+  }
+
+  unsigned NumErrors = Diags.getNumErrors();
+  unsigned PrevSFINAEErrors = NumSFINAEErrors;
+  bool Success = ComputeStandardConversion(From, ToType, InOverloadResolution,
+                                           SCS);
+
+  // Completing a pointee type may have instantiated a class and changed what
+  // is cached; an instantiation that failed may give a different answer the
+  // next time around.
+  if (StandardConversionsGeneration != Context.getRecordLookupGeneration()) {
+    StandardConversions.clear();
+    StandardConversionsGeneration = Context.getRecordLookupGeneration();
+  }
+  if (Diags.getNumErrors() == NumErrors &&
+      NumSFINAEErrors == PrevSFINAEErrors) {
+    CachedStandardConversion &Entry = StandardConversions[Key];
+    Entry.Success = Success;
+    Entry.SCS = SCS;
+  }
+  return Success;
+}
+
+/// ComputeStandardConversion - Compute the standard conversion sequence
+/// for IsStandardConversion, without looking in the cache.
+bool
+Sema::ComputeStandardConversion(Expr* From, QualType ToType,
+                                bool InOverloadResolution,
+                                StandardConversionSequence &SCS) {
   QualType FromType = From->getType();
 
   // Standard conversions (C++ [conv])
@@ -2383,6 +2515,21 @@ bool Sema::PerformContextuallyConvertToBool(Expr *&From) {
   return true;
 }
 
+/// AddNonViableCandidate - Add a candidate that was rejected before any of
+/// its conversion sequences was computed.
+static void AddNonViableCandidate(FunctionDecl *Function,
+                                  AccessSpecifier Access,
+                                  OverloadFailureKind FailureKind,
+                                  OverloadCandidateSet &CandidateSet) {
+  OverloadCandidate &Candidate = CandidateSet.addCandidate();
+  Candidate.Function = Function;
+  Candidate.Access = Access;
+  Candidate.Viable = false;
+  Candidate.FailureKind = FailureKind;
+  Candidate.IsSurrogate = false;
+  Candidate.IgnoreObjectArgument = false;
+}
+
 /// AddOverloadCandidate - Adds the given function to the set of
 /// candidate functions, using the given function call arguments.  If
 /// @p SuppressUserConversions, then don't allow user-defined
@@ -2443,15 +2590,6 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
       return;
   }
   
-  // Add this candidate
-  CandidateSet.push_back(OverloadCandidate());
-  OverloadCandidate& Candidate = CandidateSet.back();
-  Candidate.Function = Function;
-  Candidate.Access = Access;
-  Candidate.Viable = true;
-  Candidate.IsSurrogate = false;
-  Candidate.IgnoreObjectArgument = false;
-
   unsigned NumArgsInProto = Proto->getNumArgs();
 
   // (C++ 13.3.2p2): A candidate function having fewer than m
@@ -2459,8 +2597,8 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
   // list (8.3.5).
   if ((NumArgs + (PartialOverloading && NumArgs)) > NumArgsInProto && 
       !Proto->isVariadic()) {
-    Candidate.Viable = false;
-    Candidate.FailureKind = ovl_fail_too_many_arguments;
+    AddNonViableCandidate(Function, Access, ovl_fail_too_many_arguments,
+                          CandidateSet);
     return;
   }
 
@@ -2472,14 +2610,21 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
   unsigned MinRequiredArgs = Function->getMinRequiredArguments();
   if (NumArgs < MinRequiredArgs && !PartialOverloading) {
     // Not enough arguments.
-    Candidate.Viable = false;
-    Candidate.FailureKind = ovl_fail_too_few_arguments;
+    AddNonViableCandidate(Function, Access, ovl_fail_too_few_arguments,
+                          CandidateSet);
     return;
   }
 
+  // Add this candidate
+  OverloadCandidate& Candidate = CandidateSet.addCandidate(NumArgs);
+  Candidate.Function = Function;
+  Candidate.Access = Access;
+  Candidate.Viable = true;
+  Candidate.IsSurrogate = false;
+  Candidate.IgnoreObjectArgument = false;
+
   // Determine the implicit conversion sequences for each of the
   // arguments.
-  Candidate.Conversions.resize(NumArgs);
   for (unsigned ArgIdx = 0; ArgIdx < NumArgs; ++ArgIdx) {
     if (ArgIdx < NumArgsInProto) {
       // (C++ 13.3.2p3): for F to be a viable function, there shall
@@ -2596,22 +2741,14 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, AccessSpecifier Access,
   // Overload resolution is always an unevaluated context.
   EnterExpressionEvaluationContext Unevaluated(*this, Action::Unevaluated);
 
-  // Add this candidate
-  CandidateSet.push_back(OverloadCandidate());
-  OverloadCandidate& Candidate = CandidateSet.back();
-  Candidate.Function = Method;
-  Candidate.Access = Access;
-  Candidate.IsSurrogate = false;
-  Candidate.IgnoreObjectArgument = false;
-
   unsigned NumArgsInProto = Proto->getNumArgs();
 
   // (C++ 13.3.2p2): A candidate function having fewer than m
   // parameters is viable only if it has an ellipsis in its parameter
   // list (8.3.5).
   if (NumArgs > NumArgsInProto && !Proto->isVariadic()) {
-    Candidate.Viable = false;
-    Candidate.FailureKind = ovl_fail_too_many_arguments;
+    AddNonViableCandidate(Method, Access, ovl_fail_too_many_arguments,
+                          CandidateSet);
     return;
   }
 
@@ -2623,13 +2760,18 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, AccessSpecifier Access,
   unsigned MinRequiredArgs = Method->getMinRequiredArguments();
   if (NumArgs < MinRequiredArgs) {
     // Not enough arguments.
-    Candidate.Viable = false;
-    Candidate.FailureKind = ovl_fail_too_few_arguments;
+    AddNonViableCandidate(Method, Access, ovl_fail_too_few_arguments,
+                          CandidateSet);
     return;
   }
 
+  // Add this candidate
+  OverloadCandidate& Candidate = CandidateSet.addCandidate(NumArgs + 1);
+  Candidate.Function = Method;
+  Candidate.Access = Access;
+  Candidate.IsSurrogate = false;
+  Candidate.IgnoreObjectArgument = false;
   Candidate.Viable = true;
-  Candidate.Conversions.resize(NumArgs + 1);
 
   if (Method->isStatic() || ObjectType.isNull())
     // The implicit object argument is ignored.
@@ -2747,8 +2889,7 @@ Sema::AddTemplateOverloadCandidate(FunctionTemplateDecl *FunctionTemplate,
   if (TemplateDeductionResult Result
         = DeduceTemplateArguments(FunctionTemplate, ExplicitTemplateArgs,
                                   Args, NumArgs, Specialization, Info)) {
-    CandidateSet.push_back(OverloadCandidate());
-    OverloadCandidate &Candidate = CandidateSet.back();
+    OverloadCandidate &Candidate = CandidateSet.addCandidate();
     Candidate.Function = FunctionTemplate->getTemplatedDecl();
     Candidate.Access = Access;
     Candidate.Viable = false;
@@ -2791,8 +2932,7 @@ Sema::AddConversionCandidate(CXXConversionDecl *Conversion,
   EnterExpressionEvaluationContext Unevaluated(*this, Action::Unevaluated);
 
   // Add this candidate
-  CandidateSet.push_back(OverloadCandidate());
-  OverloadCandidate& Candidate = CandidateSet.back();
+  OverloadCandidate& Candidate = CandidateSet.addCandidate(1);
   Candidate.Function = Conversion;
   Candidate.Access = Access;
   Candidate.IsSurrogate = false;
@@ -2804,7 +2944,6 @@ Sema::AddConversionCandidate(CXXConversionDecl *Conversion,
   // Determine the implicit conversion sequence for the implicit
   // object parameter.
   Candidate.Viable = true;
-  Candidate.Conversions.resize(1);
   Candidate.Conversions[0]
     = TryObjectArgumentInitialization(From->getType(), Conversion,
                                       ActingContext);
@@ -2927,15 +3066,13 @@ void Sema::AddSurrogateCandidate(CXXConversionDecl *Conversion,
   // Overload resolution is always an unevaluated context.
   EnterExpressionEvaluationContext Unevaluated(*this, Action::Unevaluated);
 
-  CandidateSet.push_back(OverloadCandidate());
-  OverloadCandidate& Candidate = CandidateSet.back();
+  OverloadCandidate& Candidate = CandidateSet.addCandidate(NumArgs + 1);
   Candidate.Function = 0;
   Candidate.Access = Access;
   Candidate.Surrogate = Conversion;
   Candidate.Viable = true;
   Candidate.IsSurrogate = true;
   Candidate.IgnoreObjectArgument = false;
-  Candidate.Conversions.resize(NumArgs + 1);
 
   // Determine the implicit conversion sequence for the implicit
   // object parameter.
@@ -3101,8 +3238,7 @@ void Sema::AddBuiltinCandidate(QualType ResultTy, QualType *ParamTys,
   EnterExpressionEvaluationContext Unevaluated(*this, Action::Unevaluated);
 
   // Add this candidate
-  CandidateSet.push_back(OverloadCandidate());
-  OverloadCandidate& Candidate = CandidateSet.back();
+  OverloadCandidate& Candidate = CandidateSet.addCandidate(NumArgs);
   Candidate.Function = 0;
   Candidate.Access = AS_none;
   Candidate.IsSurrogate = false;
@@ -3114,7 +3250,6 @@ void Sema::AddBuiltinCandidate(QualType ResultTy, QualType *ParamTys,
   // Determine the implicit conversion sequences for each of the
   // arguments.
   Candidate.Viable = true;
-  Candidate.Conversions.resize(NumArgs);
   for (unsigned ArgIdx = 0; ArgIdx < NumArgs; ++ArgIdx) {
     // C++ [over.match.oper]p4:
     //   For the built-in assignment operators, conversions of the
@@ -4231,8 +4366,8 @@ Sema::isBetterOverloadCandidate(const OverloadCandidate& Cand1,
   //   A viable function F1 is defined to be a better function than another
   //   viable function F2 if for all arguments i, ICSi(F1) is not a worse
   //   conversion sequence than ICSi(F2), and then...
-  unsigned NumArgs = Cand1.Conversions.size();
-  assert(Cand2.Conversions.size() == NumArgs && "Overload candidate mismatch");
+  unsigned NumArgs = Cand1.NumConversions;
+  assert(Cand2.NumConversions == NumArgs && "Overload candidate mismatch");
   bool HasBetterConversion = false;
   for (unsigned ArgIdx = StartArg; ArgIdx < NumArgs; ++ArgIdx) {
     switch (CompareImplicitConversionSequences(Cand1.Conversions[ArgIdx],
@@ -4666,7 +4801,7 @@ void NoteFunctionCandidate(Sema &S, OverloadCandidate *Cand,
     return S.NoteOverloadCandidate(Fn);
 
   case ovl_fail_bad_conversion:
-    for (unsigned I = 0, N = Cand->Conversions.size(); I != N; ++I)
+    for (unsigned I = 0, N = Cand->NumConversions; I != N; ++I)
       if (Cand->Conversions[I].isBad())
         return DiagnoseBadConversion(S, Cand, I);
     
@@ -4713,12 +4848,12 @@ void NoteBuiltinOperatorCandidate(Sema &S,
                                   const char *Opc,
                                   SourceLocation OpLoc,
                                   OverloadCandidate *Cand) {
-  assert(Cand->Conversions.size() <= 2 && "builtin operator is not binary");
+  assert(Cand->NumConversions <= 2 && "builtin operator is not binary");
   std::string TypeStr("operator");
   TypeStr += Opc;
   TypeStr += "(";
   TypeStr += Cand->BuiltinTypes.ParamTypes[0].getAsString();
-  if (Cand->Conversions.size() == 1) {
+  if (Cand->NumConversions == 1) {
     TypeStr += ")";
     S.Diag(OpLoc, diag::note_ovl_builtin_unary_candidate) << TypeStr;
   } else {
@@ -4731,7 +4866,7 @@ void NoteBuiltinOperatorCandidate(Sema &S,
 
 void NoteAmbiguousUserConversions(Sema &S, SourceLocation OpLoc,
                                   OverloadCandidate *Cand) {
-  unsigned NoOperands = Cand->Conversions.size();
+  unsigned NoOperands = Cand->NumConversions;
   for (unsigned ArgIdx = 0; ArgIdx < NoOperands; ++ArgIdx) {
     const ImplicitConversionSequence &ICS = Cand->Conversions[ArgIdx];
     if (ICS.isBad()) break; // all meaningless after first invalid
@@ -4791,10 +4926,10 @@ struct CompareOverloadCandidatesForDisplay {
 
         // If there's any ordering between the defined conversions...
         // FIXME: this might not be transitive.
-        assert(L->Conversions.size() == R->Conversions.size());
+        assert(L->NumConversions == R->NumConversions);
 
         int leftBetter = 0;
-        for (unsigned I = 0, E = L->Conversions.size(); I != E; ++I) {
+        for (unsigned I = 0, E = L->NumConversions; I != E; ++I) {
           switch (S.CompareImplicitConversionSequences(L->Conversions[I],
                                                        R->Conversions[I])) {
           case ImplicitConversionSequence::Better:
@@ -4841,7 +4976,7 @@ void CompleteNonViableCandidate(Sema &S, OverloadCandidate *Cand,
 
   // Skip forward to the first bad conversion.
   unsigned ConvIdx = 0;
-  unsigned ConvCount = Cand->Conversions.size();
+  unsigned ConvCount = Cand->NumConversions;
   while (true) {
     assert(ConvIdx != ConvCount && "no bad conversion in candidate");
     ConvIdx++;
@@ -18,8 +18,10 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/Type.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 
 namespace clang {
   class ASTContext;
@@ -433,8 +435,12 @@ namespace clang {
     CXXConversionDecl *Surrogate;
 
     /// Conversions - The conversion sequences used to convert the
-    /// function arguments to the function parameters.
-    llvm::SmallVector<ImplicitConversionSequence, 4> Conversions;
+    /// function arguments to the function parameters.  The candidate set
+    /// owns them.
+    ImplicitConversionSequence *Conversions;
+
+    /// NumConversions - The number of elements in Conversions.
+    unsigned NumConversions;
 
     /// Viable - True to indicate that this overload candidate is viable.
     bool Viable;
@@ -488,9 +494,8 @@ namespace clang {
     /// hasAmbiguousConversion - Returns whether this overload
     /// candidate requires an ambiguous conversion or not.
     bool hasAmbiguousConversion() const {
-      for (llvm::SmallVectorImpl<ImplicitConversionSequence>::const_iterator
-             I = Conversions.begin(), E = Conversions.end(); I != E; ++I) {
-        if (I->isAmbiguous()) return true;
+      for (unsigned I = 0; I != NumConversions; ++I) {
+        if (Conversions[I].isAmbiguous()) return true;
       }
       return false;
     }
@@ -498,13 +503,43 @@ namespace clang {
 
   /// OverloadCandidateSet - A set of overload candidates, used in C++
   /// overload resolution (C++ 13.3).
+  ///
+  /// The conversion sequences of the candidates are allocated by the set,
+  /// from a buffer inside the set and then from an arena, so candidates are
+  /// cheap to copy and adding one to a large set does not allocate.
   class OverloadCandidateSet : public llvm::SmallVector<OverloadCandidate, 16> {
     typedef llvm::SmallVector<OverloadCandidate, 16> inherited;
     llvm::SmallPtrSet<Decl *, 16> Functions;
 
     SourceLocation Loc;    
+
+    /// NumInlineConversions - The number of conversion sequences that fit in
+    /// InlineSpace.
+    enum { NumInlineConversions = 16 };
+
+    /// InlineSpace - Storage for the first conversion sequences of the set.
+    union {
+      char Buffer[NumInlineConversions * sizeof(ImplicitConversionSequence)];
+      void *Align;
+      double AlignDouble;
+    } InlineSpace;
+
+    /// NumInlineConversionsUsed - The number of conversion sequences
+    /// allocated from InlineSpace.
+    unsigned NumInlineConversionsUsed;
+
+    /// ConversionArena - Storage for the conversion sequences that did not
+    /// fit into InlineSpace, created on first use.
+    llvm::OwningPtr<llvm::BumpPtrAllocator> ConversionArena;
+
+    void destroyCandidates();
+
+    OverloadCandidateSet(const OverloadCandidateSet &); // DO NOT IMPLEMENT
+    void operator=(const OverloadCandidateSet &);       // DO NOT IMPLEMENT
   public:
-    OverloadCandidateSet(SourceLocation Loc) : Loc(Loc) {}
+    OverloadCandidateSet(SourceLocation Loc)
+      : Loc(Loc), NumInlineConversionsUsed(0) {}
+    ~OverloadCandidateSet() { destroyCandidates(); }
 
     SourceLocation getLocation() const { return Loc; }
 
@@ -514,8 +549,13 @@ namespace clang {
       return Functions.insert(F->getCanonicalDecl()); 
     }
 
+    /// \brief Add a new candidate with \p NumConversions conversion
+    /// sequences, each of them initially bad, and return it.
+    OverloadCandidate &addCandidate(unsigned NumConversions = 0);
+
     /// \brief Clear out all of the candidates.
     void clear() {
+      destroyCandidates();
       inherited::clear();
       Functions.clear();
     }
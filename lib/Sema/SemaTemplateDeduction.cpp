@@ -17,6 +17,7 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/Parse/DeclSpec.h"
+#include "clang/Sema/InstantiationProfile.h"
 #include <algorithm>
 
 namespace clang {
@@ -948,6 +949,8 @@ Sema::TemplateDeductionResult
 Sema::DeduceTemplateArguments(ClassTemplatePartialSpecializationDecl *Partial,
                               const TemplateArgumentList &TemplateArgs,
                               TemplateDeductionInfo &Info) {
+  InstantiationProfileRegion Profile(InstantiationProfile::Deduction, Partial);
+
   // C++ [temp.class.spec.match]p2:
   //   A partial specialization matches a given actual template
   //   argument list if the template arguments of the partial
@@ -1429,6 +1432,103 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
                               Expr **Args, unsigned NumArgs,
                               FunctionDecl *&Specialization,
                               TemplateDeductionInfo &Info) {
+  // Reject a template with the wrong number of parameters before looking at
+  // any argument.
+  FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
+  if (NumArgs < Function->getMinRequiredArguments())
+    return TDK_TooFewArguments;
+  if (NumArgs > Function->getNumParams() &&
+      !Function->getType()->getAs<FunctionProtoType>()->isVariadic())
+    return TDK_TooManyArguments;
+
+  // Explicit template arguments are substituted with their source locations,
+  // so only deductions without them are cached.
+  if (ExplicitTemplateArgs)
+    return DeduceCallTemplateArguments(FunctionTemplate, ExplicitTemplateArgs,
+                                       Args, NumArgs, Specialization, Info);
+
+  // Deduction only looks at the type of each argument and, for a T&&
+  // parameter, whether it is an lvalue.  Overload sets are resolved against
+  // the parameter types, so they are not cached either.
+  llvm::FoldingSetNodeID Key;
+  Key.AddPointer(FunctionTemplate);
+  Key.AddInteger(NumArgs);
+  for (unsigned I = 0; I != NumArgs; ++I) {
+    QualType ArgType = Args[I]->getType();
+    if (ArgType == Context.OverloadTy)
+      return DeduceCallTemplateArguments(FunctionTemplate, 0, Args, NumArgs,
+                                         Specialization, Info);
+    Key.AddPointer(Context.getCanonicalType(ArgType).getAsOpaquePtr());
+    Key.AddBoolean(getLangOptions().CPlusPlus0x &&
+                   Args[I]->isLvalue(Context) == Expr::LV_Valid);
+  }
+
+  if (DeducedCallsNamespaceGeneration
+        != Context.getNamespaceLookupGeneration() ||
+      DeducedCallsRecordGeneration != Context.getRecordLookupGeneration())
+    ClearDeducedCalls();
+
+  ++NumCallDeductions;
+  void *InsertPos = 0;
+  if (DeducedCall *Known = DeducedCalls.FindNodeOrInsertPos(Key, InsertPos)) {
+    ++NumCachedCallDeductions;
+    Specialization = Known->Specialization;
+    Info.Param = Known->Param;
+    Info.FirstArg = Known->FirstArg;
+    Info.SecondArg = Known->SecondArg;
+    return Known->Result;
+  }
+
+  unsigned NumErrors = Diags.getNumErrors();
+  TemplateDeductionResult Result
+    = DeduceCallTemplateArguments(FunctionTemplate, 0, Args, NumArgs,
+                                  Specialization, Info);
+
+  // An error that was not trapped may not be repeated by a later deduction.
+  if (Diags.getNumErrors() != NumErrors)
+    return Result;
+
+  // Deduction may have instantiated classes on its way; its outcome holds
+  // for the state it left them in.
+  if (DeducedCallsNamespaceGeneration
+        != Context.getNamespaceLookupGeneration() ||
+      DeducedCallsRecordGeneration != Context.getRecordLookupGeneration())
+    ClearDeducedCalls();
+
+  DeducedCall *Call = new DeducedCall;
+  Call->Key = Key;
+  Call->Result = Result;
+  Call->Specialization = Result ? 0 : Specialization;
+  Call->Param = Info.Param;
+  Call->FirstArg = Info.FirstArg;
+  Call->SecondArg = Info.SecondArg;
+  DeducedCalls.InsertNode(Call);
+  return Result;
+}
+
+/// \brief Empty the cache of deductions from call arguments and tie it to
+/// the current classes and namespaces.
+void Sema::ClearDeducedCalls() {
+  for (llvm::FoldingSet<DeducedCall>::iterator I = DeducedCalls.begin(),
+         E = DeducedCalls.end(); I != E; ) {
+    DeducedCall *Call = &*I++;
+    delete Call;
+  }
+  DeducedCalls.clear();
+  DeducedCallsNamespaceGeneration = Context.getNamespaceLookupGeneration();
+  DeducedCallsRecordGeneration = Context.getRecordLookupGeneration();
+}
+
+/// \brief Perform template argument deduction from a function call, without
+/// consulting the cache of earlier deductions.
+Sema::TemplateDeductionResult
+Sema::DeduceCallTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
+                          const TemplateArgumentListInfo *ExplicitTemplateArgs,
+                                  Expr **Args, unsigned NumArgs,
+                                  FunctionDecl *&Specialization,
+                                  TemplateDeductionInfo &Info) {
+  InstantiationProfileRegion Profile(InstantiationProfile::Deduction,
+                                     FunctionTemplate);
   FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
 
   // C++ [temp.deduct.call]p1:
@@ -1597,6 +1697,8 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
                               QualType ArgFunctionType,
                               FunctionDecl *&Specialization,
                               TemplateDeductionInfo &Info) {
+  InstantiationProfileRegion Profile(InstantiationProfile::Deduction,
+                                     FunctionTemplate);
   FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
   TemplateParameterList *TemplateParams
     = FunctionTemplate->getTemplateParameters();
@@ -1641,6 +1743,8 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
                               QualType ToType,
                               CXXConversionDecl *&Specialization,
                               TemplateDeductionInfo &Info) {
+  InstantiationProfileRegion Profile(InstantiationProfile::Deduction,
+                                     FunctionTemplate);
   CXXConversionDecl *Conv
     = cast<CXXConversionDecl>(FunctionTemplate->getTemplatedDecl());
   QualType FromType = Conv->getConversionType();
@@ -19,6 +19,8 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/Parse/DeclSpec.h"
 #include "clang/Basic/LangOptions.h"
+#include "clang/Basic/PhaseStatistics.h"
+#include "clang/Sema/InstantiationProfile.h"
 
 using namespace clang;
 
@@ -314,9 +316,21 @@ void Sema::InstantiatingTemplate::Clear() {
     
     SemaRef.ActiveTemplateInstantiations.pop_back();
     Invalid = true;
+
+    // Nothing built by the outermost instantiation needs its scratch
+    // memory any longer.
+    if (SemaRef.ActiveTemplateInstantiations.empty())
+      SemaRef.ResetInstantiationScratch();
   }
 }
 
+void Sema::ResetInstantiationScratch() {
+  ++NumInstantiationScratchResets;
+  MaxInstantiationScratchBytes = std::max(MaxInstantiationScratchBytes,
+                                          InstantiationScratch.getTotalMemory());
+  InstantiationScratch.Reset();
+}
+
 bool Sema::InstantiatingTemplate::CheckInstantiationDepth(
                                         SourceLocation PointOfInstantiation,
                                            SourceRange InstantiationRange) {
@@ -967,6 +981,29 @@ QualType Sema::SubstType(QualType T,
   return Instantiator.TransformType(T);
 }
 
+/// \brief Perform substitution on the type of an instantiated declaration.
+///
+/// Unlike SubstType, the type locations of the result are elided when
+/// LangOptions::ElideTypeLocs is set.
+TypeSourceInfo *Sema::SubstDeclType(TypeSourceInfo *T,
+                                const MultiLevelTemplateArgumentList &Args,
+                                    SourceLocation Loc,
+                                    DeclarationName Entity) {
+  if (!getLangOptions().ElideTypeLocs || !T->getType()->isDependentType())
+    return SubstType(T, Args, Loc, Entity);
+
+  // Transform the type locations of the pattern without allocating a copy of
+  // them; the instantiation shares the location-free ones of its type.
+  TemplateInstantiator Instantiator(*this, Args, Loc, Entity);
+  TypeLocBuilder TLB(getInstantiationScratch());
+  TypeLoc TL = T->getTypeLoc();
+  TLB.reserve(TL.getFullDataSize());
+  QualType Result = Instantiator.TransformType(TLB, TL, QualType());
+  if (Result.isNull())
+    return 0;
+  return Context.getElidedTypeSourceInfo(Result);
+}
+
 /// \brief Perform substitution on the base class specifiers of the
 /// given class template specialization.
 ///
@@ -1089,6 +1126,13 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
   if (Inst)
     return true;
 
+  PhaseRegion Phase;
+  if (PhaseStatistics::getActive())
+    Phase.enter("Instantiate class",
+                Context.getTypeDeclType(Instantiation).getAsString());
+  InstantiationProfileRegion Profile(InstantiationProfile::Instantiation,
+                                     Pattern);
+
   // Enter the scope of this instantiation. We don't use
   // PushDeclContext because we don't have a scope.
   DeclContext *PreviousContext = CurContext;
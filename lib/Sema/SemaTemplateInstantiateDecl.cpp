@@ -17,7 +17,9 @@
 #include "clang/AST/DeclVisitor.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/Basic/PhaseStatistics.h"
 #include "clang/Basic/PrettyStackTrace.h"
+#include "clang/Sema/InstantiationProfile.h"
 #include "clang/Lex/Preprocessor.h"
 
 using namespace clang;
@@ -146,8 +148,8 @@ Decl *TemplateDeclInstantiator::VisitTypedefDecl(TypedefDecl *D) {
   bool Invalid = false;
   TypeSourceInfo *DI = D->getTypeSourceInfo();
   if (DI->getType()->isDependentType()) {
-    DI = SemaRef.SubstType(DI, TemplateArgs,
-                           D->getLocation(), D->getDeclName());
+    DI = SemaRef.SubstDeclType(DI, TemplateArgs,
+                               D->getLocation(), D->getDeclName());
     if (!DI) {
       Invalid = true;
       DI = SemaRef.Context.getTrivialTypeSourceInfo(SemaRef.Context.IntTy);
@@ -203,10 +205,10 @@ static bool InstantiateInitializationArguments(Sema &SemaRef,
 
 Decl *TemplateDeclInstantiator::VisitVarDecl(VarDecl *D) {
   // Do substitution on the type of the declaration
-  TypeSourceInfo *DI = SemaRef.SubstType(D->getTypeSourceInfo(),
-                                         TemplateArgs,
-                                         D->getTypeSpecStartLoc(),
-                                         D->getDeclName());
+  TypeSourceInfo *DI = SemaRef.SubstDeclType(D->getTypeSourceInfo(),
+                                             TemplateArgs,
+                                             D->getTypeSpecStartLoc(),
+                                             D->getDeclName());
   if (!DI)
     return 0;
 
@@ -342,8 +344,8 @@ Decl *TemplateDeclInstantiator::VisitFieldDecl(FieldDecl *D) {
   bool Invalid = false;
   TypeSourceInfo *DI = D->getTypeSourceInfo();
   if (DI->getType()->isDependentType())  {
-    DI = SemaRef.SubstType(DI, TemplateArgs,
-                           D->getLocation(), D->getDeclName());
+    DI = SemaRef.SubstDeclType(DI, TemplateArgs,
+                               D->getLocation(), D->getDeclName());
     if (!DI) {
       DI = D->getTypeSourceInfo();
       Invalid = true;
@@ -1031,8 +1033,8 @@ ParmVarDecl *TemplateDeclInstantiator::VisitParmVarDecl(ParmVarDecl *D) {
   QualType T;
   TypeSourceInfo *DI = D->getTypeSourceInfo();
   if (DI) {
-    DI = SemaRef.SubstType(DI, TemplateArgs, D->getLocation(),
-                           D->getDeclName());
+    DI = SemaRef.SubstDeclType(DI, TemplateArgs, D->getLocation(),
+                               D->getDeclName());
     if (DI) T = DI->getType();
   } else {
     T = SemaRef.SubstType(D->getType(), TemplateArgs, D->getLocation(),
@@ -1693,6 +1695,20 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
   if (Inst)
     return;
 
+  PhaseRegion Phase;
+  if (PhaseStatistics::getActive()) {
+    std::string Name = Function->getQualifiedNameAsString();
+    if (const TemplateArgumentList *Args
+          = Function->getTemplateSpecializationArgs())
+      Name += TemplateSpecializationType::PrintTemplateArgumentList(
+                                                   Args->getFlatArgumentList(),
+                                                   Args->flat_size(),
+                                                   Context.PrintingPolicy);
+    Phase.enter("Instantiate function", Name);
+  }
+  InstantiationProfileRegion Profile(InstantiationProfile::Instantiation,
+                                     PatternDecl);
+
   // If we're performing recursive template instantiation, create our own
   // queue of pending implicit instantiations that we will instantiate later,
   // while we're still within our own instantiation context.
@@ -1824,6 +1840,11 @@ void Sema::InstantiateStaticDataMemberDefinition(
   if (Inst)
     return;
 
+  PhaseRegion Phase;
+  if (PhaseStatistics::getActive())
+    Phase.enter("Instantiate variable", Var->getQualifiedNameAsString());
+  InstantiationProfileRegion Profile(InstantiationProfile::Instantiation, Def);
+
   // If we're performing recursive template instantiation, create our own
   // queue of pending implicit instantiations that we will instantiate later,
   // while we're still within our own instantiation context.
@@ -2311,9 +2332,19 @@ NamedDecl *Sema::FindInstantiatedDecl(NamedDecl *D,
   return D;
 }
 
+/// \brief Whether the given pattern of an implicit instantiation is defined
+/// in a system header and -fno-system-header-instantiations asks to leave
+/// such instantiations alone.
+static bool SkipSystemHeaderInstantiation(Sema &S, const Decl *Pattern) {
+  return Pattern && S.getLangOptions().NoSystemHeaderInstantiations &&
+    S.Context.getSourceManager().isInSystemHeader(Pattern->getLocation());
+}
+
 /// \brief Performs template instantiation for all implicit template
 /// instantiations we have seen until this point.
 void Sema::PerformPendingImplicitInstantiations(bool LocalOnly) {
+  InstantiationProfileRegion
+    Profile(InstantiationProfile::PendingInstantiations, 0);
   while (!PendingLocalImplicitInstantiations.empty() ||
          (!LocalOnly && !PendingImplicitInstantiations.empty())) {
     PendingImplicitInstantiation Inst;
@@ -2328,6 +2359,12 @@ void Sema::PerformPendingImplicitInstantiations(bool LocalOnly) {
 
     // Instantiate function definitions
     if (FunctionDecl *Function = dyn_cast<FunctionDecl>(Inst.first)) {
+      // Only errors could come from instantiating a system header template,
+      // and the caller chose to trade those for time.
+      FunctionDecl *Pattern = Function->getTemplateInstantiationPattern();
+      if (SkipSystemHeaderInstantiation(*this, Pattern))
+        continue;
+
       PrettyStackTraceActionsDecl CrashInfo(DeclPtrTy::make(Function),
                                             Function->getLocation(), *this,
                                             Context.getSourceManager(),
@@ -2342,6 +2379,10 @@ void Sema::PerformPendingImplicitInstantiations(bool LocalOnly) {
     VarDecl *Var = cast<VarDecl>(Inst.first);
     assert(Var->isStaticDataMember() && "Not a static data member?");
 
+    VarDecl *Pattern = Var->getInstantiatedFromStaticDataMember();
+    if (SkipSystemHeaderInstantiation(*this, Pattern))
+      continue;
+
     // Don't try to instantiate declarations if the most recent redeclaration
     // is invalid.
     if (Var->getMostRecentDeclaration()->isInvalidDecl())
@@ -1528,6 +1528,13 @@ namespace {
 /// \param T QualType referring to the type as written in source code.
 TypeSourceInfo *
 Sema::GetTypeSourceInfoForDeclarator(Declarator &D, QualType T) {
+  // Nobody asks for the type locations of system header declarations when
+  // they are elided.
+  SourceLocation Loc = D.getSourceRange().getBegin();
+  if (getLangOptions().ElideTypeLocs && Loc.isValid() &&
+      SourceMgr.isInSystemHeader(Loc))
+    return Context.getElidedTypeSourceInfo(T);
+
   TypeSourceInfo *TInfo = Context.CreateTypeSourceInfo(T);
   UnqualTypeLoc CurrTL = TInfo->getTypeLoc().getUnqualifiedLoc();
 
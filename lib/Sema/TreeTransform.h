@@ -2075,7 +2075,7 @@ TypeSourceInfo *TreeTransform<Derived>::TransformType(TypeSourceInfo *DI,
   if (getDerived().AlreadyTransformed(DI->getType()))
     return DI;
 
-  TypeLocBuilder TLB;
+  TypeLocBuilder TLB(SemaRef.getInstantiationScratch());
 
   TypeLoc TL = DI->getTypeLoc();
   TLB.reserve(TL.getFullDataSize());
@@ -2856,7 +2856,7 @@ QualType TreeTransform<Derived>::TransformTemplateSpecializationType(
   // should be rewritten to provide real type locs.
 
   // Fake up a TemplateSpecializationTypeLoc.
-  TypeLocBuilder TLB;
+  TypeLocBuilder TLB(SemaRef.getInstantiationScratch());
   TemplateSpecializationTypeLoc TL
     = TLB.push<TemplateSpecializationTypeLoc>(QualType(TST, 0));
 
@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-cache-dir %t -analyzer-display-progress %s 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-cache-dir %t -analyzer-display-progress %s 2>&1 | FileCheck -check-prefix=SECOND %s
+
+// Only 'clean' is skipped by the second run; the bug in 'buggy' is reported
+// again.
+
+int clean(int x) {
+  return x + 1;
+}
+
+void buggy(void) {
+  int x = 1;
+  x = 2;
+}
+
+// FIRST: ANALYZE: {{.*}}analysis-cache.c clean
+// FIRST-NOT: earlier run
+// FIRST: warning: Value stored to 'x' is never read
+
+// SECOND: ANALYZE: {{.*}}analysis-cache.c clean (no bugs in an earlier run)
+// SECOND: ANALYZE: {{.*}}analysis-cache.c buggy
+// SECOND-NOT: earlier run
+// SECOND: warning: Value stored to 'x' is never read
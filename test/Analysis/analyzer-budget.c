@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -analyze -analyzer-check-objc-mem -analyzer-max-nodes 20 %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -analyze -analyzer-check-objc-mem %s 2>&1 | not grep "exceeded the analysis budget"
+
+// A function whose graph outgrows the node budget is reported in the summary;
+// one that fits in it is not.
+
+int many_paths(int *p, int n) {
+  int i, sum = 0;
+  for (i = 0; i < n; ++i)
+    if (p[i] > 0)
+      sum += p[i];
+    else
+      sum -= p[i];
+  return sum;
+}
+
+int few_paths(int x) {
+  return x;
+}
+
+// CHECK: ANALYZE: 1 declaration(s) exceeded the analysis budget:
+// CHECK-NEXT: analyzer-budget.c:7: many_paths (node budget)
+// CHECK-NOT: few_paths
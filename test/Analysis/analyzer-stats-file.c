@@ -0,0 +1,32 @@
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-check-objc-mem -analyzer-max-nodes 20 -analyzer-stats-file %t.1 %s
+// RUN: FileCheck %s < %t.1
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-check-objc-mem -analyzer-max-nodes 20 -analyzer-stats-file %t.2 -DSHIFT %s
+// RUN: grep '^report' %t.1 | cut -f 1,2 > %t.1.hashes
+// RUN: grep '^report' %t.2 | cut -f 1,2 > %t.2.hashes
+// RUN: diff %t.1.hashes %t.2.hashes
+
+// Moving the functions down the file moves their reports, but does not change
+// the hashes identifying them.
+#ifdef SHIFT
+
+
+#endif
+
+int many_paths(int *p, int n) {
+  int i, sum = 0;
+  for (i = 0; i < n; ++i)
+    if (p[i] > 0)
+      sum += p[i];
+    else
+      sum -= p[i];
+  return sum;
+}
+
+void dead_store(void) {
+  int x;
+  x = 1;
+}
+
+// CHECK: function	{{.*}}analyzer-stats-file.c:15	many_paths	{{[0-9]+}}	{{[0-9]+}}	node
+// CHECK: function	{{.*}}analyzer-stats-file.c:25	dead_store	{{[0-9]+}}	{{[0-9]+}}	-
+// CHECK: report	{{[0-9A-F]+}}	{{.*}}analyzer-stats-file.c:27:{{[0-9]+}}	Dead store	Dead assignment	Value stored to 'x' is never read
@@ -0,0 +1,14 @@
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-check-objc-mem -analyzer-summarize-calls -analyzer-display-progress %s 2>&1 | FileCheck %s
+
+// The CFG of 'callee' is built once, although it is both analyzed and
+// summarized at its call.
+
+int callee(int x) {
+  return x + 1;
+}
+
+int caller(void) {
+  return callee(1);
+}
+
+// CHECK: ANALYZE: 2 CFGs of 2 declarations cached, {{[0-9]+}} reuses, {{[0-9]+}} bytes
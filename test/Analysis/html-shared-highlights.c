@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -analyze -analyzer-output=html -analyzer-check-objc-mem -o %t %s
+// RUN: cat %t/*.html | FileCheck %s
+
+// The highlights of the file are found once and applied to both reports.
+
+#define NULL_PTR ((int *)0)
+
+void first(void) {
+  int *p = NULL_PTR;
+  *p = 1;
+}
+
+void second(void) {
+  int *q = NULL_PTR;
+  *q = 2;
+}
+
+// CHECK: <h3>Annotated Source Code</h3>
+// CHECK: <span class='keyword'>void</span>
+// CHECK: <span class='macro'>NULL_PTR<span class='expansion'>
+// CHECK: <h3>Annotated Source Code</h3>
+// CHECK: <span class='keyword'>void</span>
+// CHECK: <span class='macro'>NULL_PTR<span class='expansion'>
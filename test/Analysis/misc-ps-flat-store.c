@@ -8,3 +8,53 @@ void f1() {
   if (x != 1)
     *p = 1; // no-warning
 }
+
+struct point { int x, y; };
+
+void f2() {
+  struct point p;
+  int *q = 0;
+  p.x = 1;
+  p.y = 2;
+  if (p.x != 1 || p.y != 2)
+    *q = 1; // no-warning
+}
+
+// Parts left out of an init list are zero.
+void f3() {
+  struct point p = { 1 };
+  int a[4] = { 1, 2 };
+  int *q = 0;
+  a[3] = 5;
+  if (p.y != 0 || a[0] != 1 || a[2] != 0 || a[3] != 5)
+    *q = 1; // no-warning
+}
+
+// Copies of aggregates are read from their source.
+void f4(struct point *s) {
+  struct point t;
+  int *q = 0;
+  s->x = 7;
+  t = *s;
+  if (t.x != 7)
+    *q = 1; // no-warning
+}
+
+// Fields that are never written are uninitialized.
+int f5() {
+  struct point p;
+  p.x = 1;
+  return p.y + 1; // expected-warning{{The left operand of '+' is a garbage value}}
+}
+
+// Passing the address of a struct invalidates all of its fields.
+void g(struct point *);
+void f6() {
+  struct point p;
+  int *q = 0;
+  p.x = 1;
+  g(&p);
+  if (p.x == 1)
+    return;
+  *q = 1; // expected-warning{{Dereference of null pointer}}
+}
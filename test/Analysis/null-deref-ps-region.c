@@ -1,4 +1,5 @@
 // RUN: %clang_cc1 -analyze -analyzer-experimental-internal-checks -std=gnu99 -analyzer-check-objc-mem -analyzer-store=region -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-experimental-internal-checks -std=gnu99 -analyzer-check-objc-mem -analyzer-store=flat -verify %s
 
 
 // The store for 'a[1]' should not be removed mistakenly. SymbolicRegions may
@@ -0,0 +1,45 @@
+// RUN: %clang_cc1 -analyze -analyzer-experimental-internal-checks -analyzer-check-objc-mem -analyzer-store=region -verify %s
+
+// Elements and fields initialized to zero are read back through the default
+// value of the array or struct.
+
+struct s { int a; int *p; int b; };
+
+void f1(void) {
+  int buf[1024] = { 0, 1, 0, 0, 2 };
+  if (buf[0] == 0 && buf[1] == 1 && buf[3] == 0 && buf[4] == 2 &&
+      buf[1000] == 0) {
+    int *q = 0;
+    *q = 1; // expected-warning{{Dereference of null pointer}}
+  }
+}
+
+void f2(void) {
+  char str[16] = "a\0b";
+  if (str[0] == 'a' && str[1] == 0 && str[2] == 'b' && str[10] == 0) {
+    int *q = 0;
+    *q = 1; // expected-warning{{Dereference of null pointer}}
+  }
+}
+
+void f3(void) {
+  struct s x = { 0, 0, 3 };
+  if (x.a == 0 && !x.p && x.b == 3) {
+    int *q = 0;
+    *q = 1; // expected-warning{{Dereference of null pointer}}
+  }
+}
+
+// A binding left from an earlier initialization of the same array is
+// overwritten by the zero element.
+void f4(int n) {
+  int i;
+  for (i = 0; i < 2; ++i) {
+    int buf[4] = { 0 };
+    if (buf[0] != 0) {
+      int *q = 0;
+      *q = 1; // no-warning
+    }
+    buf[0] = 5;
+  }
+}
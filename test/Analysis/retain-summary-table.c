@@ -0,0 +1,29 @@
+// RUN: rm -f %t
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -analyze -analyzer-check-objc-mem -analyzer-retain-summaries %t -isystem %S/Inputs -verify %s
+// RUN: test -f %t
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -analyze -analyzer-check-objc-mem -analyzer-retain-summaries %t -isystem %S/Inputs -verify %s
+
+// The second run uses the summaries of the system functions stored by the
+// first one, and must find the same bugs.
+
+#include <retain-summaries.h>
+
+CFAbsoluteTime balanced(CFAbsoluteTime t) {
+  CFDateRef date = CFDateCreate(0, t);
+  CFRetain(date);
+  CFRelease(date);
+  t = CFDateGetAbsoluteTime(date);
+  CFRelease(date);
+  return t;
+}
+
+CFAbsoluteTime leaked(CFAbsoluteTime t) {
+  CFDateRef date = CFDateCreate(0, t); // expected-warning{{leak}}
+  return CFDateGetAbsoluteTime(date);
+}
+
+CFAbsoluteTime released(CFAbsoluteTime t) {
+  CFDateRef date = CFDateCreate(0, t);
+  CFRelease(date);
+  return CFDateGetAbsoluteTime(date); // expected-warning{{Reference-counted object is used after it is released.}}
+}
@@ -0,0 +1,26 @@
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-shards 2 -analyzer-shard-index 0 %s 2>&1 | FileCheck -check-prefix=SHARD0 %s
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores -analyzer-shards 2 -analyzer-shard-index 1 %s 2>&1 | FileCheck -check-prefix=SHARD1 %s
+// RUN: %clang_cc1 -analyze -analyzer-check-dead-stores %s 2>&1 | FileCheck -check-prefix=ALL %s
+
+// Each function is analyzed by exactly one shard.
+
+int f0(void) {
+  int x = 0;
+  x = 1; // Dead store.
+  return 0;
+}
+
+int f1(void) {
+  int y = 0;
+  y = 2; // Dead store.
+  return 0;
+}
+
+// SHARD0: Value stored to 'x' is never read
+// SHARD0-NOT: Value stored to 'y'
+
+// SHARD1-NOT: Value stored to 'x'
+// SHARD1: Value stored to 'y' is never read
+
+// ALL: Value stored to 'x' is never read
+// ALL: Value stored to 'y' is never read
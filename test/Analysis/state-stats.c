@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -analyze -analyzer-check-objc-mem -analyzer-state-stats %s 2>&1 | FileCheck %s
+
+int f(int *p, int n) {
+  int x = 0;
+  if (n)
+    x = *p;
+  return x;
+}
+
+// CHECK: *** GRState Stats:
+// CHECK-NEXT: {{[0-9]+}} states created, {{[0-9]+}} state lookups, {{[0-9.]+}} lookups per state.
+// CHECK-NEXT: {{[0-9]+}} bytes of states, {{[0-9]+}} environment bindings.
+// CHECK-NEXT: {{[0-9]+}} distinct stores, {{[0-9]+}} distinct generic data maps.
@@ -0,0 +1,52 @@
+// RUN: %clang_cc1 -analyze -analyzer-experimental-internal-checks -analyzer-check-objc-mem -analyzer-store=region -analyzer-summarize-calls -verify %s
+
+// The values returned by functions defined in the file constrain the values
+// of the calls to them.
+
+static int get_five(void) { return 5; }
+
+static int get_either(int x) {
+  if (x)
+    return 1;
+  return 2;
+}
+
+static int *get_global(void) {
+  static int g;
+  return &g;
+}
+
+static int *get_null(void) { return 0; }
+
+extern int get_unknown(void);
+
+void test_constant(void) {
+  int *p = 0;
+  if (get_five() != 5)
+    *p = 1; // no-warning
+}
+
+void test_nonzero(int x) {
+  int *p = 0;
+  if (!get_either(x))
+    *p = 1; // no-warning
+}
+
+void test_nonnull(void) {
+  int *q = get_global();
+  if (!q) {
+    int *p = 0;
+    *p = 1; // no-warning
+  }
+}
+
+void test_null(void) {
+  int *q = get_null();
+  *q = 1; // expected-warning{{Dereference of null pointer}}
+}
+
+void test_unknown(void) {
+  int *p = 0;
+  if (get_unknown() != 5)
+    *p = 1; // expected-warning{{Dereference of null pointer}}
+}
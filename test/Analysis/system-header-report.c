@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -analyze -analyzer-check-objc-mem -analyzer-output=plist -o - %s | FileCheck %s
+
+// No path is built for a bug in a system header, whose warning is
+// suppressed.
+
+# 1 "system.h" 1 3
+static inline int system_deref(int *p) {
+  if (p)
+    return 0;
+  return *p;
+}
+# 13 "system-header-report.c" 2
+
+int user_deref(int *q) {
+  if (q)
+    return 0;
+  return *q;
+}
+
+// CHECK: <key>description</key><string>Dereference of null pointer loaded from variable &apos;q&apos;</string>
+// CHECK-NOT: <key>description</key>
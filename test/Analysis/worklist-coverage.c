@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -analyze -analyzer-experimental-internal-checks -analyzer-check-objc-mem -analyzer-store=region -analyzer-worklist=coverage -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-experimental-internal-checks -analyzer-check-objc-mem -analyzer-store=region -analyzer-worklist=dfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-check-objc-mem -analyzer-worklist=coverage -analyzer-display-progress %s 2>&1 | FileCheck %s
+
+int loop_then_null(int n) {
+  int i, sum = 0;
+  for (i = 0; i < n; ++i)
+    sum += i;
+  if (sum == 3) {
+    int *p = 0;
+    return *p; // expected-warning{{Dereference of null pointer}}
+  }
+  return sum;
+}
+
+// CHECK: ANALYZE: {{.*}}worklist-coverage.c loop_then_null
+// CHECK-NEXT: ANALYZE: coverage: {{[0-9]+}} of {{[0-9]+}} blocks
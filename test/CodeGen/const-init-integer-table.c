@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -o - %s | FileCheck %s
+
+// Tables of integer literals are converted element by element as the
+// implicit conversions to the element type require.
+
+// CHECK: @t = global [5 x i32] [i32 1, i32 -2, i32 97, i32 2147483647, i32 -294967296]
+int t[] = { 1, -2, 'a', 0x7fffffff, 4000000000u };
+
+// CHECK: @c = global [3 x i8] c"\FF\00\FF"
+unsigned char c[] = { 255, 256, -1 };
+
+// CHECK: @s = global [4 x i16] [i16 1, i16 2, i16 0, i16 0]
+short s[4] = { 1, (2) };
+
+// CHECK: @ll = global [3 x i64] [i64 -1, i64 4294967295, i64 4294967295]
+long long ll[] = { -1, 0xffffffffu, -1u };
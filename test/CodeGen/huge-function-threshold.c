@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -O2 -huge-function-threshold 20 -emit-llvm -o - %s | FileCheck %s
+
+// A function beyond the threshold is never inlined, while small functions
+// still are.
+
+// CHECK: define i32 @big({{.*}}noinline
+int big(int *p) {
+  p[0] = 1; p[1] = 2; p[2] = 3; p[3] = 4; p[4] = 5;
+  p[5] = 6; p[6] = 7; p[7] = 8; p[8] = 9; p[9] = 10;
+  return p[0] + p[9];
+}
+
+int small(int x) { return x + 1; }
+
+// CHECK: define i32 @caller
+// CHECK: call i32 @big
+// CHECK-NOT: call i32 @small
+// CHECK: ret i32
+int caller(int *p) {
+  return big(p) + small(p[1]);
+}
@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -triple i386-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+
+// Elements that already have the element type are copied into the
+// initializer directly; the others are still converted.
+
+// CHECK: @a = global [5 x i32] [i32 1, i32 2, i32 99, i32 3, i32 0]
+int a[5] = { 1, 2, 'c', 3.5 };
+
+// CHECK: @b = global [4 x double] [double 1.000000e+00, double 2.000000e+00, double 0.000000e+00, double 4.000000e+00]
+double b[] = { 1.0, 2, [3] = 4.0 };
+
+// CHECK: @c = global [3 x i8] c"\01\02\03"
+const char c[] = { (char)1, (char)2, (char)3 };
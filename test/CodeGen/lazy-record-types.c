@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -emit-llvm -o - %s | FileCheck -check-prefix=EAGER %s
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -lazy-record-types -emit-llvm -o - %s | FileCheck -check-prefix=LAZY %s
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -lazy-record-types -emit-llvm -print-stats -o /dev/null %s 2>&1 | FileCheck -check-prefix=STATS %s
+
+// A record that is only pointed to is never laid out.
+struct Unused { int a[100]; };
+struct Holder { struct Unused *u; int x; };
+
+int get(struct Holder *h) { return h->x; }
+
+// EAGER: %struct.Holder = type { %struct.Unused*, i32 }
+// EAGER: %struct.Unused = type { [100 x i32] }
+
+// LAZY: %struct.Holder = type { %struct.Unused*, i32 }
+// LAZY: %struct.Unused = type opaque
+
+// STATS: CodeGen Type Stats:
+// STATS: records kept opaque (1 still opaque)
@@ -0,0 +1,10 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -O1 -S -o /dev/null -phase-stats-file %t %s
+// RUN: grep '"name": "Generate function", "detail": "f"' %t
+// RUN: grep '"name": "Body"' %t
+// RUN: grep '"name": "Optimize function", "detail": "f"' %t
+// RUN: grep '"name": "Optimize module"' %t
+// RUN: grep '"name": "Generate machine code", "detail": "f"' %t
+
+int f(int x) {
+  return x * 2;
+}
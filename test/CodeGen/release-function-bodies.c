@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -disable-free -release-function-bodies -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -disable-free -release-function-bodies -emit-llvm -print-stats %s -o /dev/null 2>&1 | FileCheck --check-prefix=STATS %s
+
+// The bodies of the three functions that are emitted are released; the
+// static function that is never used keeps its body.
+// STATS: 3 function bodies released
+
+static int twice(int x) { return 2 * x; }
+static int unused(int x) { return x; }
+
+// CHECK: define i32 @counter(
+int counter(int n) {
+  static int calls = sizeof(int[4]);
+  int vla[n];
+  vla[0] = calls++;
+  if (n > 1)
+    goto done;
+  return twice(vla[0]);
+done:
+  return 0;
+}
+
+// CHECK: define i32 @uses_counter(
+// CHECK: call i32 @counter(i32 3)
+int uses_counter(void) { return counter(1 + 2); }
+
+// CHECK: define internal i32 @twice(
+// CHECK-NOT: @unused
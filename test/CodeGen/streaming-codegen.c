@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 -triple x86_64-apple-darwin10 -streaming-codegen -S -o - %s | FileCheck %s
+
+// Functions are emitted as soon as they are generated, except for those
+// that call always_inline functions and those whose bodies are deferred,
+// which wait for the end of the file.
+
+static inline __attribute__((always_inline)) int twice(int x) {
+  return 2 * x;
+}
+
+static int helper(int x) {
+  return x - 1;
+}
+
+// CHECK: _leaf:
+int leaf(int x) {
+  return x + 1;
+}
+
+int caller(int x) {
+  return leaf(x) * twice(x);
+}
+
+// CHECK: _user:
+int user(int x) {
+  return helper(x);
+}
+
+// CHECK: _caller:
+// CHECK-NOT: twice
+// CHECK: _helper:
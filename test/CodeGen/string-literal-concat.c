@@ -0,0 +1,10 @@
+// RUN: %clang_cc1 -triple i386-unknown-unknown -trigraphs -emit-llvm %s -o - | FileCheck %s
+
+// Escape-free runs, escapes at either end of a piece, and pieces that need
+// cleaning are all concatenated into one string.
+// CHECK: @a = global [19 x i8] c"abc\0Adef\09ghiXjkl?\5Cm\00"
+char a[] = "abc\n" "def\tghi" "\x58" "jk\
+l" "??/?" "??/\m";
+
+// CHECK: @b = global [4 x i32] [i32 120, i32 10, i32 65, i32 0]
+int b[] = L"x" "\n" L"\101";
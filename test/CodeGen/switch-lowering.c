@@ -0,0 +1,38 @@
+// RUN: %clang_cc1 -triple i386-unknown-unknown %s -emit-llvm -o - | FileCheck %s
+
+// A switch that only picks the value to return is a table lookup; the holes
+// hold the default.
+// CHECK: @switch.table = internal constant [5 x i32] [i32 10, i32 20, i32 7, i32 40, i32 50]
+int table(int x) {
+  switch (x) {
+  case 1: return 10;
+  case 2: return 20;
+  case 4: return 40;
+  case 5: return 50;
+  default: return 7;
+  }
+}
+
+// CHECK: define i32 @table
+// CHECK: sub i32 {{.*}}, 1
+// CHECK: icmp ult i32 {{.*}}, 5
+// CHECK: switch.lookup:
+// CHECK: getelementptr inbounds [5 x i32]* @switch.table
+// CHECK-NOT: switch i32
+
+// Big case ranges are found by a binary search.
+int ranges(int x) {
+  switch (x) {
+  case 0 ... 99: return 1;
+  case 100 ... 199: return 2;
+  case 200 ... 299: return 3;
+  case 300 ... 399: return 4;
+  case 400 ... 499: return 5;
+  }
+  return 0;
+}
+
+// CHECK: define i32 @ranges
+// CHECK: switch i32
+// CHECK: sw.caserange.split:
+// CHECK: icmp slt i32 {{.*}}, 200
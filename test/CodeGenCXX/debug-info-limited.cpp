@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -emit-llvm -g -flimit-debug-info %s -o %t
+// RUN: not grep 'elsewhere_field' %t
+// RUN: grep 'here_field' %t
+// RUN: grep 'called_method' %t
+// RUN: not grep 'never_called_method' %t
+// RUN: %clang_cc1 -emit-llvm -g %s -o - | grep 'elsewhere_field'
+
+// The vtable of Elsewhere is emitted by the translation unit defining its key
+// function, which describes the class; this one only declares it.
+struct Elsewhere {
+  virtual void key();
+  int elsewhere_field;
+};
+
+// Here is used before its key function is defined, and is described in full
+// once it is.
+struct Here {
+  virtual void key();
+  int here_field;
+  void called_method();
+  void never_called_method(int);
+};
+
+void use(Elsewhere *e, Here *h) {
+  h->called_method();
+}
+
+void Here::key() { }
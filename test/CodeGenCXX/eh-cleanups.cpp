@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 %s -triple=x86_64-apple-darwin10 -emit-llvm -o - -fexceptions | FileCheck %s
+
+struct A { A(); ~A(); };
+struct B { ~B() throw(); };
+void f();
+void g() throw();
+
+// Nothing in the scope of the locals can unwind, so they need no landing pad.
+// CHECK: define void @_Z5test1v()
+// CHECK-NOT: @llvm.eh.selector
+// CHECK: ret void
+void test1() {
+  B a, b;
+  g();
+}
+
+// The landing pad of the inner local branches to the cleanup of the outer
+// one, which rethrows for both.
+// CHECK: define void @_Z5test2v()
+// CHECK: call void @_Unwind_Resume_or_Rethrow
+// CHECK-NOT: @_Unwind_Resume_or_Rethrow
+// CHECK: br label %ehcleanup.rest{{$}}
+// CHECK-NOT: @_Unwind_Resume_or_Rethrow
+// CHECK: ret void
+void test2() {
+  A a, b;
+  f();
+}
@@ -0,0 +1,27 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -emit-llvm -triple x86_64-apple-darwin10 -emitted-definitions-dir %t %s -o - | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -emit-llvm -triple x86_64-apple-darwin10 -emitted-definitions-dir %t %s -o - | FileCheck -check-prefix=FIRST %s
+// RUN: cp %s %t/other.cpp
+// RUN: %clang_cc1 -emit-llvm -triple x86_64-apple-darwin10 -emitted-definitions-dir %t %t/other.cpp -o - | FileCheck -check-prefix=OTHER %s
+
+template<typename T> T add(T a, T b) { return a + b; }
+
+inline int twice(int x) { return add(x, x); }
+
+struct S {
+  int get() { return 17; }
+};
+
+int f(S &s) { return twice(1) + s.get(); }
+
+// The first translation unit claims the definitions, and keeps claiming
+// them when it is rebuilt.
+// FIRST: define weak_odr i32 @_Z5twicei
+// FIRST: define weak_odr i32 @_ZN1S3getEv
+// FIRST: define weak_odr i32 @_Z3addIiET_S0_S0_
+
+// Another translation unit only declares them.
+// OTHER: define i32 @_Z1fR1S
+// OTHER: declare i32 @_Z5twicei
+// OTHER: declare i32 @_ZN1S3getEv
+// OTHER-NOT: _Z3addIiET_S0_S0_
@@ -0,0 +1,20 @@
+// RUN: rm -rf %t.db %t.dir
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -ccc-record-commands %t.db -c %s -o %t.o -MD -MF %t.d 2> /dev/null
+// RUN: %clang -ccc-run-commands %t.db -ccc-analyze-commands %t.dir --analyzer-output plist -### 2>&1 | FileCheck %s
+// RUN: %clang -ccc-run-commands %t.db -ccc-analyze-commands %t.dir --analyzer-output plist
+// RUN: FileCheck -check-prefix=REPORT %s < %t.dir/report-0.plist
+
+// CHECK: "-cc1"
+// CHECK-NOT: "-emit-obj"
+// CHECK-NOT: "-dependency-file"
+// CHECK: "-analyze"
+// CHECK: "-analyzer-check-dead-stores"
+// CHECK: "-analyzer-output" "plist"
+// CHECK: "-o" "{{.*}}report-0.plist"
+
+void f(void) {
+  int x = 0;
+  x = 1;
+}
+
+// REPORT: Value stored to 'x' is never read
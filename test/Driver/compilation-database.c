@@ -0,0 +1,18 @@
+// RUN: rm -f %t.db
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -ccc-record-commands %t.db -fsyntax-only %s 2> /dev/null
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -ccc-record-commands %t.db -c %s -o %t.o 2> /dev/null
+// RUN: FileCheck -check-prefix=RECORD %s < %t.db
+// RUN: rm -f %t.o
+// RUN: %clang -ccc-run-commands %t.db -j 2 2>&1 | FileCheck -check-prefix=REPLAY %s
+// RUN: test -f %t.o
+// RUN: echo '{"arguments": [' > %t.bad
+// RUN: not %clang -ccc-run-commands %t.bad 2>&1 | FileCheck -check-prefix=BAD %s
+
+// RECORD: {"directory": "{{.*}}", "executable": "{{.*}}clang{{.*}}", "arguments": ["-cc1", {{.*}}"-fsyntax-only"{{.*}}], "inputs": ["{{.*}}compilation-database.c"], "output": ""}
+// RECORD: {"directory": "{{.*}}", "executable": "{{.*}}clang{{.*}}", "arguments": ["-cc1", {{.*}}], "inputs": ["{{.*}}compilation-database.c"], "output": "{{.*}}compilation-database.c.tmp.o"}
+
+#warning replayed from the database
+// REPLAY: warning: replayed from the database
+// REPLAY: warning: replayed from the database
+
+// BAD: malformed compilation database '{{.*}}' at line 1
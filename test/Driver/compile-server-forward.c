@@ -0,0 +1,24 @@
+// RUN: cd `dirname %t` && rm -f cs-forward.sock cs-forward.log; %clang -ccc-compile-server cs-forward.sock 2> cs-forward.log & echo $! > %t.pid
+// RUN: trap 'kill `cat %t.pid`' EXIT
+// RUN: for i in 1 2 3 4 5 6 7 8 9 10; do test -S cs-forward.sock && break; sleep 1; done
+// RUN: test -S cs-forward.sock
+
+// A compile forwarded to the server reports its diagnostics on the client's
+// stderr and its exit status as the client's.
+// RUN: env CLANG_COMPILE_SERVER=cs-forward.sock %clang -ccc-host-triple i386-unknown-unknown -fsyntax-only %s 2>&1 | FileCheck %s
+// RUN: not env CLANG_COMPILE_SERVER=cs-forward.sock %clang -ccc-host-triple i386-unknown-unknown -fsyntax-only -DFAIL %s 2> %t.err
+// RUN: FileCheck -check-prefix=FAIL %s < %t.err
+// RUN: FileCheck -check-prefix=SERVER %s < cs-forward.log
+
+// XFAIL: win32
+
+#ifdef FAIL
+#error failed in the server
+#else
+#warning compiled in the server
+#endif
+
+// CHECK: warning: compiled in the server
+// FAIL: error: failed in the server
+// SERVER: compile server: running '{{.*}}' in '{{.*}}'
+// SERVER: compile server: running '{{.*}}' in '{{.*}}'
@@ -0,0 +1,9 @@
+// RUN: env CLANG_COMPILE_SERVER=%t.missing.sock %clang -ccc-host-triple i386-unknown-unknown -fsyntax-only %s 2>&1 | FileCheck %s
+// RUN: not %clang -ccc-compile-server 2>&1 | FileCheck -check-prefix=USAGE %s
+
+// Without a server listening on the socket, the driver compiles on its own.
+
+#warning compiled without a server
+// CHECK: warning: compiled without a server
+
+// USAGE: error: usage: {{.*}} -ccc-compile-server <socket>
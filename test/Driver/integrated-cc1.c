@@ -0,0 +1,13 @@
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -ccc-integrated-cc1 -fsyntax-only %s 2>&1 | FileCheck %s
+// RUN: not %clang -ccc-host-triple i386-unknown-unknown -ccc-integrated-cc1 -fsyntax-only -DFAIL %s 2>&1 | FileCheck -check-prefix=FAIL %s
+
+// The first clang -cc1 command runs in the driver's process, with the same
+// diagnostics and result.
+
+#warning compiled in process
+// CHECK: warning: compiled in process
+
+#ifdef FAIL
+#error failed in process
+#endif
+// FAIL: error: failed in process
@@ -0,0 +1,11 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: echo '#warning first input' > %t/a.c
+// RUN: echo '#warning second input' > %t/b.c
+// RUN: echo '#warning third input' > %t/c.c
+
+// With -j, the diagnostics of the inputs come out in order.
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -fsyntax-only -j 3 %t/a.c %t/b.c %t/c.c 2>&1 | FileCheck %s
+
+// CHECK: first input
+// CHECK: second input
+// CHECK: third input
@@ -0,0 +1,14 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: echo 'int a;' > %t/a.c
+// RUN: echo 'int b;' > %t/b.c
+
+// With -j, each preprocessed input is written to its own file.
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -ccc-print-bindings -E -j 2 %t/a.c %t/b.c 2> %t/bindings
+// RUN: grep '"clang", inputs: \[".*a.c"\], output: "a.i"' %t/bindings
+// RUN: grep '"clang", inputs: \[".*b.c"\], output: "b.i"' %t/bindings
+
+// A single input still goes to stdout.
+// RUN: %clang -ccc-host-triple i386-unknown-unknown -ccc-print-bindings -E -j 2 %t/a.c 2> %t/bindings
+// RUN: grep '"clang", inputs: \[".*a.c"\], output: (pipe)' %t/bindings
+
+// RUN: not %clang -ccc-host-triple i386-unknown-unknown -E -j 0 %t/a.c 2>&1 | grep "invalid integral value '0'"
@@ -0,0 +1,8 @@
+// RUN: rm -f %t.cache
+// RUN: env CCC_PATH_CACHE=%t.cache %clang -print-prog-name=clang > %t.1
+// RUN: FileCheck %s < %t.cache
+// RUN: env CCC_PATH_CACHE=%t.cache %clang -print-prog-name=clang > %t.2
+// RUN: diff %t.1 %t.2
+
+// CHECK: cfe-pathcache 1
+// CHECK: {{[0-9]+}} ? 1 {{.*}}clang
@@ -0,0 +1,90 @@
+// RUN: %clang_cc1 -pedantic -fixit %s -o - | grep -v CHECK > %t
+// RUN: %clang_cc1 -pedantic -Werror -x c %t
+// RUN: FileCheck -input-file=%t %s
+
+// Enough fix-its for the rewriter to apply them in one pass over the file.
+
+struct s { int x, y; };
+
+// CHECK: struct s s0 = { .x = 0, .y = 0 };
+struct s s0 = { x: 0, y: 0 };
+struct s s1 = { x: 1, y: 1 };
+struct s s2 = { x: 2, y: 2 };
+struct s s3 = { x: 3, y: 3 };
+struct s s4 = { x: 4, y: 4 };
+struct s s5 = { x: 5, y: 5 };
+struct s s6 = { x: 6, y: 6 };
+struct s s7 = { x: 7, y: 7 };
+struct s s8 = { x: 8, y: 8 };
+struct s s9 = { x: 9, y: 9 };
+struct s s10 = { x: 10, y: 10 };
+struct s s11 = { x: 11, y: 11 };
+struct s s12 = { x: 12, y: 12 };
+struct s s13 = { x: 13, y: 13 };
+struct s s14 = { x: 14, y: 14 };
+struct s s15 = { x: 15, y: 15 };
+struct s s16 = { x: 16, y: 16 };
+struct s s17 = { x: 17, y: 17 };
+struct s s18 = { x: 18, y: 18 };
+struct s s19 = { x: 19, y: 19 };
+struct s s20 = { x: 20, y: 20 };
+struct s s21 = { x: 21, y: 21 };
+struct s s22 = { x: 22, y: 22 };
+struct s s23 = { x: 23, y: 23 };
+struct s s24 = { x: 24, y: 24 };
+struct s s25 = { x: 25, y: 25 };
+struct s s26 = { x: 26, y: 26 };
+struct s s27 = { x: 27, y: 27 };
+struct s s28 = { x: 28, y: 28 };
+struct s s29 = { x: 29, y: 29 };
+struct s s30 = { x: 30, y: 30 };
+struct s s31 = { x: 31, y: 31 };
+struct s s32 = { x: 32, y: 32 };
+struct s s33 = { x: 33, y: 33 };
+struct s s34 = { x: 34, y: 34 };
+struct s s35 = { x: 35, y: 35 };
+struct s s36 = { x: 36, y: 36 };
+struct s s37 = { x: 37, y: 37 };
+struct s s38 = { x: 38, y: 38 };
+struct s s39 = { x: 39, y: 39 };
+struct s s40 = { x: 40, y: 40 };
+struct s s41 = { x: 41, y: 41 };
+struct s s42 = { x: 42, y: 42 };
+struct s s43 = { x: 43, y: 43 };
+struct s s44 = { x: 44, y: 44 };
+struct s s45 = { x: 45, y: 45 };
+struct s s46 = { x: 46, y: 46 };
+struct s s47 = { x: 47, y: 47 };
+struct s s48 = { x: 48, y: 48 };
+struct s s49 = { x: 49, y: 49 };
+struct s s50 = { x: 50, y: 50 };
+struct s s51 = { x: 51, y: 51 };
+struct s s52 = { x: 52, y: 52 };
+struct s s53 = { x: 53, y: 53 };
+struct s s54 = { x: 54, y: 54 };
+struct s s55 = { x: 55, y: 55 };
+struct s s56 = { x: 56, y: 56 };
+struct s s57 = { x: 57, y: 57 };
+struct s s58 = { x: 58, y: 58 };
+struct s s59 = { x: 59, y: 59 };
+struct s s60 = { x: 60, y: 60 };
+struct s s61 = { x: 61, y: 61 };
+struct s s62 = { x: 62, y: 62 };
+struct s s63 = { x: 63, y: 63 };
+struct s s64 = { x: 64, y: 64 };
+struct s s65 = { x: 65, y: 65 };
+struct s s66 = { x: 66, y: 66 };
+struct s s67 = { x: 67, y: 67 };
+struct s s68 = { x: 68, y: 68 };
+struct s s69 = { x: 69, y: 69 };
+struct s s70 = { x: 70, y: 70 };
+struct s s71 = { x: 71, y: 71 };
+struct s s72 = { x: 72, y: 72 };
+struct s s73 = { x: 73, y: 73 };
+struct s s74 = { x: 74, y: 74 };
+struct s s75 = { x: 75, y: 75 };
+struct s s76 = { x: 76, y: 76 };
+struct s s77 = { x: 77, y: 77 };
+struct s s78 = { x: 78, y: 78 };
+// CHECK: struct s s79 = { .x = 79, .y = 79 };
+struct s s79 = { x: 79, y: 79 };
@@ -0,0 +1,17 @@
+// RUN: rm -rf %t.dir && mkdir %t.dir
+// RUN: echo 'struct s { int x; }; static struct s h = { x: 1 };' > %t.dir/h.h
+// RUN: cp %s %t.dir/a.c
+// RUN: echo '#include "h.h"' > %t.dir/b.c
+// RUN: %clang_cc1 -pedantic -fixit -fixit-record %t.dir/records %t.dir/a.c
+// RUN: %clang_cc1 -pedantic -fixit -fixit-record %t.dir/records %t.dir/b.c
+// RUN: FileCheck -input-file=%t.dir/records %s
+// RUN: test ! -e %t.dir/a.fixit.c
+
+#include "h.h"
+
+struct s s0 = { x: 0 };
+
+// The header's edit is recorded by both translation units.
+// CHECK: {"file": "{{.*}}h.h", "offset": 43, "length": 2, "replacement": ".x = "}
+// CHECK: {"file": "{{.*}}a.c", "offset": {{[0-9]+}}, "length": 2, "replacement": ".x = "}
+// CHECK: {"file": "{{.*}}h.h", "offset": 43, "length": 2, "replacement": ".x = "}
@@ -0,0 +1,2 @@
+#define OVERLAY_VALUE 42
+int overlay_function(void);
@@ -0,0 +1 @@
+int snapshot_header;
@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -ast-export -o %t %s
+// RUN: head -c 4 %t | grep ASTX
+// RUN: grep "compute_total" %t
+// RUN: grep "int (int \*, int)" %t
+// RUN: grep "CallExpr" %t
+
+struct item { int weight; };
+
+int lookup(int *table, int index);
+
+int compute_total(int *table, int count) {
+  int total = 0;
+  for (int i = 0; i < count; ++i)
+    total += lookup(table, i);
+  return total;
+}
@@ -0,0 +1,6 @@
+// RUN: echo 'int x; int y;' > %t.h
+// RUN: %clang_cc1 -fsyntax-only -include-cost-report %t.txt -include %t.h %s
+// RUN: grep "Include costs for '.*include-cost-report.c'" %t.txt
+// RUN: grep ' 6 *6 *2 *2 *14 *14  .*\.h$' %t.txt
+
+int z = 0;
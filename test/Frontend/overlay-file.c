@@ -0,0 +1,18 @@
+// RUN: rm -rf %t.dir
+// RUN: %clang_cc1 -E -I %t.dir/include \
+// RUN:   -overlay-file "%t.dir/include/sys/inmem.h;%S/Inputs/overlay-header.h" \
+// RUN:   %s | FileCheck %s
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t.dir/include \
+// RUN:   -overlay-file "%t.dir/include/sys/inmem.h;%S/Inputs/overlay-header.h" %s
+// RUN: not %clang_cc1 -fsyntax-only \
+// RUN:   -overlay-file "%t.dir/inmem.h;%t.dir/missing.h" %s 2>&1 | \
+// RUN:   FileCheck -check-prefix=MISSING %s
+
+// The header and its directories only exist in memory.
+#include <sys/inmem.h>
+
+int value = OVERLAY_VALUE;
+
+// CHECK: int overlay_function(void);
+// CHECK: int value = 42;
+// MISSING: error opening '{{.*}}missing.h'
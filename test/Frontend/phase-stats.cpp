@@ -0,0 +1,15 @@
+// RUN: %clang_cc1 -fsyntax-only -phase-stats-file %t %s
+// RUN: grep '"name": "Parse"' %t
+// RUN: grep '"name": "Source file", "detail": ".*phase-stats.cpp"' %t
+// RUN: grep '"name": "Instantiate class", "detail": ".*S<int>"' %t
+// RUN: grep '"name": "Instantiate function", "detail": "f<int>"' %t
+
+template<typename T> struct S { T x; };
+
+template<typename T> T f(T t) { return t; }
+
+int g() {
+  S<int> s;
+  s.x = 0;
+  return f(s.x);
+}
@@ -0,0 +1,5 @@
+// RUN: %clang_cc1 -rewrite-test %s -o - | FileCheck %s
+
+/* first */ int x; // second
+
+// CHECK: <i>/* first */</i> int x; <i>// second</i>
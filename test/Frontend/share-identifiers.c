@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -fsyntax-only -share-identifiers -print-stats %s %s 2>&1 \
+// RUN:   | FileCheck %s
+
+// Both inputs take their keywords and builtins from the shared table.
+// CHECK: Identifiers created from the shared base: {{[1-9][0-9]*}} of
+// CHECK: Identifiers created from the shared base: {{[1-9][0-9]*}} of
+// CHECK-NOT: error
+
+int constant[__builtin_constant_p(1) ? 1 : -1];
+
+static inline unsigned f(unsigned x) {
+  return __builtin_popcount(x);
+}
@@ -0,0 +1,10 @@
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -write-stat-snapshot %t.snap %s
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -stat-snapshot %t.snap \
+// RUN:   -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Stat Snapshot Stats:
+// CHECK-NEXT: {{[1-9][0-9]*}} stat snapshot hits, {{[0-9]+}} stat snapshot misses.
+
+#include "stat-snapshot.h"
+
+int x = snapshot_header;
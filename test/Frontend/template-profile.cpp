@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -fsyntax-only -template-profile %t -template-profile-trace %t.json %s
+// RUN: grep 'count  incl ms  excl ms  activity' %t
+// RUN: grep '^      3 .* instantiate  S$' %t
+// RUN: grep '^      2 .* instantiate  f$' %t
+// RUN: grep '^      2 .* deduce       f$' %t
+// RUN: grep '^      1 .* instantiate  S<T \*>$' %t
+// RUN: grep '"name":"f","cat":"deduce","ph":"X"' %t.json
+
+template<typename T> struct S { T x; };
+template<typename T> struct S<T*> { T *p; };
+
+template<typename T> T f(T t) { return t; }
+
+int g() {
+  S<int> a;
+  S<char> b;
+  S<long> c;
+  S<int*> d;
+  return f(a.x) + f(b.x);
+}
@@ -0,0 +1,22 @@
+// RUN: rm -rf %t.dir && mkdir -p %t.dir
+// RUN: echo 'struct used_tag { int f; };' > %t.dir/tag.h
+// RUN: echo 'typedef int used_typedef;' > %t.dir/typedef.h
+// RUN: echo '#define USED_MACRO 1' > %t.dir/macro.h
+// RUN: echo 'int used_func(void);' > %t.dir/inner.h
+// RUN: echo '#include "inner.h"' > %t.dir/outer.h
+// RUN: echo 'int unused_func(void);' > %t.dir/unused.h
+// RUN: %clang_cc1 -print-unused-includes -I %t.dir %s -o - | FileCheck %s
+
+#include "tag.h"
+#include "typedef.h"
+#include "macro.h"
+#include "outer.h"
+#include "unused.h"
+
+// CHECK-NOT: {{tag|typedef|macro|outer|inner}}.h
+// CHECK: unused-includes.c:14: {{.*}}unused.h
+// CHECK-NOT: .h
+
+used_typedef g(struct used_tag *p) {
+  return p->f + used_func() + USED_MACRO;
+}
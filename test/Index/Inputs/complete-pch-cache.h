@@ -0,0 +1,4 @@
+float wonka_shadow;
+void wonka(float);
+struct Point { int x, y; };
+typedef struct Point Point;
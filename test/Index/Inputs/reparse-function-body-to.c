@@ -0,0 +1,22 @@
+// RUN: env CINDEXTEST_SKIP_FUNCTION_BODIES=1 CINDEXTEST_REMAP_AFTER_LOAD=1 c-index-test -test-reparse-source 1 local -remap-file="%s;%S/Inputs/reparse-function-body-to.c" %s | FileCheck %s
+// RUN: env CINDEXTEST_SKIP_FUNCTION_BODIES=1 CINDEXTEST_REMAP_AFTER_LOAD=1 c-index-test -cursor-at=%s:5:14 -cursor-at=%s:5:10 -cursor-at=%s:4:13 -cursor-at=%s:8:24 -remap-file="%s;%S/Inputs/reparse-function-body-to.c" %s | FileCheck -check-prefix=CHECK-CURSOR %s
+
+int foo(int parm) {
+  return 2 * parm;
+}
+
+int bar(void) { return foo(3); }
+
+// Only the body of foo changes, so it is the only one lexed again.
+// CHECK: Function body reparses: 1
+// CHECK: reparse-function-body.c:4:5: FunctionDecl=foo:4:5 (Definition) Extent=[4:5 - 6:2]
+// CHECK: reparse-function-body.c:5:14: DeclRefExpr=parm:4:13 Extent=[5:14 - 5:18]
+// CHECK: reparse-function-body.c:8:5: FunctionDecl=bar:8:5 (Definition) Extent=[8:5 - 8:33]
+// CHECK: reparse-function-body.c:8:24: DeclRefExpr=foo:4:5 Extent=[8:24 - 8:27]
+
+// Positions in the new body are found in it, the others where they were.
+// CHECK-CURSOR: Function body reparses: 1
+// CHECK-CURSOR: DeclRefExpr=parm:4:13
+// CHECK-CURSOR: UnexposedExpr=
+// CHECK-CURSOR: ParmDecl=parm:4:13 (Definition)
+// CHECK-CURSOR: DeclRefExpr=foo:4:5
@@ -0,0 +1,2 @@
+extern int header_value;
+int header_function(int);
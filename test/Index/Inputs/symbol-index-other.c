@@ -0,0 +1,3 @@
+#include "symbol-index.h"
+
+int other(void) { return shared_function(1); }
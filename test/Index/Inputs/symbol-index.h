@@ -0,0 +1,2 @@
+int shared_function(int);
+struct Shared { int field; };
@@ -0,0 +1,2 @@
+int in_header(int);
+struct HeaderStruct { int field; };
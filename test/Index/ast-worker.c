@@ -0,0 +1,19 @@
+// RUN: env CINDEXTEST_USE_EXTERNAL_AST_GENERATION=1 c-index-test -test-load-source local %s | FileCheck -check-prefix=CHECK-LOAD %s
+// RUN: env CINDEXTEST_USE_EXTERNAL_AST_GENERATION=1 not c-index-test -test-load-source local %s -DBROKEN 2> %t.err
+// RUN: FileCheck -check-prefix=CHECK-FAIL %s < %t.err
+// XFAIL: win32
+
+int f(int x) {
+#ifdef BROKEN
+  return y;
+#else
+  return x;
+#endif
+}
+
+// CHECK-LOAD: ast-worker.c:5:5: FunctionDecl=f:5:5 (Definition) Extent=[5:5 - 11:2]
+// CHECK-LOAD: ast-worker.c:5:11: ParmDecl=x:5:11 (Definition) Extent=[5:7 - 5:12]
+
+// CHECK-FAIL: error invoking{{.*}}: AST worker failed to compile the translation unit (status 1)
+// CHECK-FAIL: ast-worker.c:7:10: error: use of undeclared identifier 'y'
+// CHECK-FAIL: Unable to load translation unit!
@@ -0,0 +1,49 @@
+// RUN: %clang_cc1 -print-call-edges %s -o - | FileCheck %s
+// RUN: %clang_cc1 -emit-call-edges %s -o %t.cge
+// RUN: head -c 7 %t.cge | grep cfe-cge
+
+void leaf(int);
+
+namespace N {
+  void inner() { leaf(1); }
+
+  struct A {
+    void method() { inner(); }
+    static void smethod();
+  };
+
+  void A::smethod() { leaf(2); }
+}
+
+template<typename T> T pass(T t) { leaf(0); return t; }
+
+template<typename T> struct Box {
+  void get() { leaf(3); }
+};
+
+extern "C" {
+  void cfunc() { N::inner(); }
+}
+
+void user() {
+  N::A a;
+  a.method();
+  N::A::smethod();
+  pass(1);
+  Box<int> b;
+  b.get();
+  cfunc();
+}
+
+// CHECK: Box{{.*}}::get() -> leaf(int)
+// CHECK-NEXT: N::A::method() -> N::inner()
+// CHECK-NEXT: N::A::smethod() -> leaf(int)
+// CHECK-NEXT: N::inner() -> leaf(int)
+// CHECK-NEXT: cfunc() -> N::inner()
+// CHECK-NEXT: pass{{.*}}(int) -> leaf(int)
+// CHECK-NEXT: user() -> Box{{.*}}::get()
+// CHECK-NEXT: user() -> N::A::method()
+// CHECK-NEXT: user() -> N::A::smethod()
+// CHECK-NEXT: user() -> cfunc()
+// CHECK-NEXT: user() -> pass{{.*}}(int)
+// CHECK-NOT: ->
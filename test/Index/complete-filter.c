@@ -0,0 +1,24 @@
+// Code completion that only produces the results matching the typed prefix.
+struct Point { int xcoord, ycoord, xval; };
+
+int xglobal;
+
+void f(struct Point *p, int xlocal) {
+  p->xcoord = xlocal;
+}
+
+// RUN: env CINDEXTEST_COMPLETION_PREFIX=x c-index-test -code-completion-at=%s:7:6 %s | FileCheck -check-prefix=CHECK-MEMBER %s
+// CHECK-MEMBER-NOT: ycoord
+// CHECK-MEMBER: FieldDecl:{ResultType int}{TypedText xcoord}
+// CHECK-MEMBER: FieldDecl:{ResultType int}{TypedText xval}
+// CHECK-MEMBER-NOT: ycoord
+
+// RUN: env CINDEXTEST_COMPLETION_PREFIX=X c-index-test -code-completion-at=%s:7:15 %s | FileCheck -check-prefix=CHECK-EXPR %s
+// CHECK-EXPR: VarDecl:{ResultType int}{TypedText xglobal}
+// CHECK-EXPR: ParmDecl:{ResultType int}{TypedText xlocal}
+
+// The local declaration is the most relevant result.
+// RUN: env CINDEXTEST_COMPLETION_PREFIX=x CINDEXTEST_COMPLETION_MAX_RESULTS=1 c-index-test -code-completion-in-process-at=%s:7:15 %s | FileCheck -check-prefix=CHECK-MAX %s
+// CHECK-MAX-NOT: xglobal
+// CHECK-MAX: ParmDecl:{ResultType int}{TypedText xlocal}
+// CHECK-MAX-NOT: xglobal
@@ -0,0 +1,25 @@
+// Code completion in-process, reusing the precompiled preamble.
+#include "Inputs/complete-in-process.h"
+#define LOCAL_MACRO 1
+
+struct Point { int x, y; };
+
+void f(struct Point *p) {
+  p->x = 0;
+}
+
+int g(void) {
+  return 0;
+}
+
+// RUN: c-index-test -code-completion-in-process-at=%s:8:6 %s | FileCheck -check-prefix=CHECK-MEMBER %s
+// CHECK-MEMBER: FieldDecl:{ResultType int}{TypedText x}
+// CHECK-MEMBER: FieldDecl:{ResultType int}{TypedText y}
+
+// RUN: c-index-test -code-completion-in-process-at=%s:12:10 %s > %t
+// RUN: FileCheck -check-prefix=CHECK-EXPR %s < %t
+// CHECK-EXPR: FunctionDecl:{ResultType void}{TypedText f}{LeftParen (}
+// CHECK-EXPR: FunctionDecl:{ResultType int}{TypedText g}{LeftParen (}{RightParen )}
+// CHECK-EXPR: FunctionDecl:{ResultType int}{TypedText header_function}{LeftParen (}{Placeholder float}{RightParen )}
+// RUN: FileCheck -check-prefix=CHECK-MACRO %s < %t
+// CHECK-MACRO: NotImplemented:{TypedText LOCAL_MACRO}
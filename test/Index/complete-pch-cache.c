@@ -0,0 +1,25 @@
+// Code completion with the results for the global declarations of the PCH
+// file cached across completions.
+void local_function(int);
+
+void f(int wonka_shadow) {
+  
+}
+
+// RUN: rm -rf %t.cache
+// RUN: cp %S/Inputs/complete-pch-cache.h %t.h
+// RUN: %clang_cc1 -emit-pch -x c -o %t.h.pch %t.h
+// RUN: c-index-test -code-completion-at=%s:6:3 %s -include %t.h | sort > %t.uncached
+// RUN: c-index-test -code-completion-at=%s:6:3 %s -include %t.h -Xclang -code-completion-cache -Xclang %t.cache | sort > %t.miss
+// RUN: ls %t.cache | grep 'completions-.*\.cache'
+// RUN: c-index-test -code-completion-at=%s:6:3 %s -include %t.h -Xclang -code-completion-cache -Xclang %t.cache | sort > %t.hit
+// RUN: diff %t.uncached %t.miss
+// RUN: diff %t.uncached %t.hit
+// RUN: FileCheck %s < %t.hit
+// XFAIL: win32
+
+// CHECK: FunctionDecl:{ResultType void}{TypedText local_function}{LeftParen (}{Placeholder int}{RightParen )}
+// CHECK: FunctionDecl:{ResultType void}{TypedText wonka}{LeftParen (}{Placeholder float}{RightParen )}
+// CHECK: ParmDecl:{ResultType int}{TypedText wonka_shadow}
+// CHECK: TypedefDecl:{TypedText Point}
+// CHECK-NOT: VarDecl:{ResultType float}{TypedText wonka_shadow}
@@ -0,0 +1,20 @@
+// RUN: env CINDEXTEST_DIAGNOSTIC_QUEUE=1 c-index-test -test-load-source local %s -pedantic 2> %t
+// RUN: FileCheck %s < %t
+// RUN: env CINDEXTEST_DIAGNOSTIC_QUEUE=1 CINDEXTEST_USE_EXTERNAL_AST_GENERATION=1 c-index-test -test-load-source local %s -pedantic 2> %t
+// RUN: FileCheck %s < %t
+
+_Complex cd;
+
+struct s {
+  int x, y;;
+};
+
+int f(int *ptr1, float *ptr2) {
+  return ptr1 != ptr2;
+}
+
+// CHECK: Queued: diagnostic-queue.c:6:1: warning: plain '_Complex' requires a type specifier; assuming '_Complex double'
+// CHECK: FIX-IT: Insert " double" at 6:9
+// CHECK: Queued: diagnostic-queue.c:9:12: warning: extra ';' inside a struct or union
+// CHECK: FIX-IT: Remove [9:12 - 9:13]
+// CHECK: Queued: diagnostic-queue.c:13:15:{13:10-13:14}{13:18-13:22}: warning: comparison of distinct pointer types ('int *' and 'float *')
@@ -0,0 +1,11 @@
+struct X { int a, b; };
+int f(int p) { return p; }
+
+// RUN: c-index-test -test-export-tree %s | FileCheck %s
+
+// CHECK: StructDecl=X [@S^X] export-cursor-tree.c:1:1-1:23 parent TranslationUnit=
+// CHECK: FieldDecl=a [@S^X@^FI^a] export-cursor-tree.c:1:{{[0-9]+}}-1:17 parent StructDecl=X
+// CHECK: FieldDecl=b [@S^X@^FI^b] export-cursor-tree.c:1:{{[0-9]+}}-1:20 parent StructDecl=X
+// CHECK: FunctionDecl=f [@F^f] export-cursor-tree.c:2:1-2:27 parent TranslationUnit=
+// CHECK: ParmDecl=p [{{.*}}] export-cursor-tree.c:2:7-2:12 parent FunctionDecl=f
+// CHECK: DeclRefExpr=p [] export-cursor-tree.c:2:23-2:24 parent
@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -fblocks -emit-pch -o %t-1.ast %S/Inputs/t1.c
+// RUN: %clang_cc1 -fblocks -emit-pch -o %t-2.ast %S/Inputs/t2.c
+// RUN: %clang_cc1 -emit-pch -o %t-3.ast %S/Inputs/remap-load-to.c
+// RUN: index-test -find bar_func %t-1.ast %t-2.ast %t-3.ast | FileCheck %s
+// RUN: index-test -j 2 -unload -find bar_func %t-3.ast %t-2.ast %t-1.ast \
+// RUN:   | FileCheck %s
+
+// The declaration seen by t1.c comes from foo.h; t2.c defines bar_func.
+// CHECK: {{.*}}foo.h:4:6: Function{{$}}
+// CHECK-NEXT: {{.*}}t2.c:5:6: Function (definition)
+// CHECK-NOT: remap-load-to.c
@@ -0,0 +1,17 @@
+#warning this warning is stored with the translation unit
+int f(int x) { return x; }
+
+// RUN: c-index-test -test-memory-usage %s | FileCheck %s
+// CHECK: memory usage:
+// CHECK:   AST: {{[1-9][0-9]*}}
+// CHECK:   SourceFiles: {{[1-9][0-9]*}}
+// CHECK:   LineTables: {{[1-9][0-9]*}}
+// CHECK:   Diagnostics: {{[1-9][0-9]*}}
+// CHECK: memory usage after trimming:
+// CHECK:   AST: {{[1-9][0-9]*}}
+// CHECK:   SourceFiles: 0
+// CHECK:   LineTables: 0
+// CHECK:   Diagnostics: 0
+// CHECK: cursor after trimming: FunctionDecl=f:2:5 (Definition) Extent=[2:1 - 2:{{[0-9]+}}]
+// CHECK: memory usage after reloading:
+// CHECK:   SourceFiles: {{[1-9][0-9]*}}
@@ -0,0 +1,16 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/inc
+// RUN: echo 'int created_after_load;' > %t/inc/late.h.in
+// RUN: env CINDEXTEST_CREATE_BEFORE_REPARSE=%t/inc/late.h \
+// RUN:   c-index-test -test-reparse-source 1 local %s -I%t/inc \
+// RUN:     -Xclang -cache-directory-listings 2> %t.err | FileCheck %s
+// RUN: FileCheck -check-prefix=CHECK-LOAD %s < %t.err
+
+// The header does not exist yet when the translation unit is loaded, so the
+// listing of its directory read then lacks it.  The reparse must find it.
+
+int before_include;
+#include <late.h>
+
+// CHECK-LOAD: 'late.h' file not found
+// CHECK: late.h:1:5: VarDecl=created_after_load:1:5
@@ -0,0 +1,15 @@
+// RUN: c-index-test -test-load-source local %s | FileCheck %s
+// RUN: c-index-test -test-reparse-source 2 local %s | FileCheck %s
+#include "Inputs/reparse-preamble.h"
+#define TWICE(x) ((x) * 2)
+
+int use_header(int parm) {
+  return header_function(TWICE(parm)) + header_value;
+}
+
+// The preamble, the #include and #define above, comes from a PCH file when
+// the translation unit is reparsed; the rest of the file must not change.
+// CHECK: reparse-preamble.c:6:5: FunctionDecl=use_header:6:5 (Definition) Extent=[6:5 - 8:2]
+// CHECK: reparse-preamble.c:6:20: ParmDecl=parm:6:20 (Definition) Extent=[6:16 - 6:24]
+// CHECK: reparse-preamble.c:7:10: DeclRefExpr=header_function:2:5 Extent=[7:10 - 7:25]
+// CHECK: reparse-preamble.c:7:41: DeclRefExpr=header_value:1:12 Extent=[7:41 - 7:53]
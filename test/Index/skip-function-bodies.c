@@ -0,0 +1,15 @@
+int helper(int x);
+
+int foo(int parm) {
+  return helper(parm) + 1;
+}
+
+// Skipped bodies are parsed when their children are visited.
+// RUN: env CINDEXTEST_SKIP_FUNCTION_BODIES=1 c-index-test -test-load-source local %s | FileCheck %s
+// CHECK: skip-function-bodies.c:3:5: FunctionDecl=foo:3:5 (Definition) Extent=[3:5 - 5:2]
+// CHECK: skip-function-bodies.c:3:13: ParmDecl=parm:3:13 (Definition) Extent=[3:9 - 3:17]
+// CHECK: skip-function-bodies.c:3:5: UnexposedStmt= Extent=[3:19 - 5:2]
+// CHECK: skip-function-bodies.c:4:17: DeclRefExpr=parm:3:13 Extent=[4:17 - 4:21]
+
+// RUN: env CINDEXTEST_SKIP_FUNCTION_BODIES=1 c-index-test -cursor-at=%s:4:17 %s | FileCheck -check-prefix=CURSOR %s
+// CURSOR: DeclRefExpr=parm:3:13
@@ -0,0 +1,16 @@
+namespace N {
+  int global;
+
+  struct S {
+    int member;
+    int get() { return member + global; }
+  };
+}
+
+int use(N::S s) { return s.get(); }
+
+// Bodies of inline methods are parsed in the scope of their class.
+// RUN: env CINDEXTEST_SKIP_FUNCTION_BODIES=1 c-index-test -cursor-at=%s:6:24 -cursor-at=%s:6:33 -cursor-at=%s:10:28 %s | FileCheck %s
+// CHECK: MemberRefExpr=member:5:9
+// CHECK: DeclRefExpr=global:2:7
+// CHECK: MemberRefExpr=get:6:9
@@ -0,0 +1,30 @@
+@interface A
+- (int)method;
+- (void)method:(int)x with:(int)y;
+@end
+
+struct S { int field; };
+
+void f(A *a, struct S *s) {
+  [a method:s->field with:[a method]];
+}
+
+// RUN: c-index-test -test-load-source-usrs all %s | FileCheck %s
+// RUN: env CINDEXTEST_STRING_ARENA=1 c-index-test -test-load-source-usrs all %s | FileCheck %s
+// RUN: env CINDEXTEST_STRING_ARENA=1 c-index-test -test-load-source all %s | FileCheck -check-prefix=CHECK-LOAD %s
+// RUN: env CINDEXTEST_STRING_ARENA=reset c-index-test -test-load-source all %s | FileCheck -check-prefix=CHECK-RESET %s
+
+// CHECK: string-arena.m objc(cs)A Extent=[1:1 - 4:5]
+// CHECK: string-arena.m objc(cs)A(im)method Extent=[2:1 - 2:{{[0-9]+}}]
+// CHECK: string-arena.m objc(cs)A(im)method:with: Extent=[3:1 - 3:{{[0-9]+}}]
+// CHECK: string-arena.m @S^S Extent=[6:1 - 6:23]
+
+// CHECK-LOAD: string-arena.m:2:1: ObjCInstanceMethodDecl=method:2:1 Extent=[2:1 - 2:{{[0-9]+}}]
+// CHECK-LOAD: string-arena.m:3:1: ObjCInstanceMethodDecl=method:with::3:1 Extent=[3:1 - 3:{{[0-9]+}}]
+// CHECK-LOAD: string-arena.m:8:6: FunctionDecl=f:8:6 (Definition) Extent=[8:1 - 10:2]
+
+// The strings of the second visit are allocated after the arena was reset.
+// CHECK-RESET: string-arena.m:3:1: ObjCInstanceMethodDecl=method:with::3:1 Extent=[3:1 - 3:{{[0-9]+}}]
+// CHECK-RESET: string-arena.m:8:6: FunctionDecl=f:8:6 (Definition) Extent=[8:1 - 10:2]
+// CHECK-RESET: string-arena.m:3:1: ObjCInstanceMethodDecl=method:with::3:1 Extent=[3:1 - 3:{{[0-9]+}}]
+// CHECK-RESET: string-arena.m:8:6: FunctionDecl=f:8:6 (Definition) Extent=[8:1 - 10:2]
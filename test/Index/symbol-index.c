@@ -0,0 +1,32 @@
+#include "symbol-index.h"
+
+int shared_function(int x) { return x; }
+
+int use(struct Shared *s) {
+  int local = s->field;
+  return shared_function(local);
+}
+
+// RUN: c-index-test -write-symbol-index %t.main.idx %s -I%S/Inputs
+// RUN: c-index-test -write-symbol-index %t.other.idx %S/Inputs/symbol-index-other.c -I%S/Inputs
+// RUN: rm -f %t.idx
+// RUN: c-index-test -merge-symbol-index %t.idx %t.main.idx %t.other.idx
+// RUN: c-index-test -find-symbol %t.idx "@F^shared_function" "@S^Shared" "@S^Shared@^FI^field" "@F^use@^local" | FileCheck %s
+
+// Merging a translation unit again replaces its occurrences.
+// RUN: c-index-test -merge-symbol-index %t.idx %t.other.idx
+// RUN: c-index-test -find-symbol %t.idx "@F^shared_function" "@S^Shared" "@S^Shared@^FI^field" "@F^use@^local" | FileCheck %s
+
+// CHECK: USR @F^shared_function:
+// CHECK-NEXT: Reference symbol-index-other.c:52
+// CHECK-NEXT: Declaration symbol-index.h:4
+// CHECK-NEXT: Definition symbol-index.c:31
+// CHECK-NEXT: Reference symbol-index.c:130
+// CHECK-NEXT: USR @S^Shared:
+// CHECK-NEXT: Definition symbol-index.h:33
+// CHECK-NEXT: Reference symbol-index.c:{{[0-9]+}}
+// CHECK-NEXT: USR @S^Shared@^FI^field:
+// CHECK-NEXT: Definition symbol-index.h:46
+// CHECK-NEXT: Reference symbol-index.c:114
+// CHECK-NEXT: USR @F^use@^local:
+// CHECK-NOT: symbol-index
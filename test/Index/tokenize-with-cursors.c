@@ -0,0 +1,13 @@
+int g(int);
+int f(int x) {
+  return g(x);
+}
+
+// Every token gets the cursor clang_getCursor would return at its location.
+// RUN: env CINDEXTEST_TOKENIZE_WITH_CURSORS=1 c-index-test -test-annotate-tokens=%s:3:3:3:15 %s | FileCheck %s
+// CHECK: Keyword: "return" [3:3 - 3:9] UnexposedStmt=
+// CHECK: Identifier: "g" [3:10 - 3:11] DeclRefExpr=g:1:5
+// CHECK: Punctuation: "(" [3:11 - 3:12] CallExpr=g
+// CHECK: Identifier: "x" [3:12 - 3:13] DeclRefExpr=x:2:11
+// CHECK: Punctuation: ")" [3:13 - 3:14] CallExpr=g
+// CHECK: Punctuation: ";" [3:14 - 3:15] UnexposedStmt=
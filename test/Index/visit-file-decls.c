@@ -0,0 +1,16 @@
+// RUN: env CINDEXTEST_VISIT_FILE=%S/Inputs/visit-file-decls.h c-index-test -test-load-source all %s | FileCheck -check-prefix=HEADER %s
+// RUN: env CINDEXTEST_VISIT_FILE=%s c-index-test -test-load-source all %s | FileCheck -check-prefix=MAIN %s
+#include "Inputs/visit-file-decls.h"
+
+int in_main(struct HeaderStruct *S) {
+  return in_header(S->field);
+}
+
+// HEADER-NOT: FunctionDecl=in_main
+// HEADER: visit-file-decls.h:1:5: FunctionDecl=in_header:1:5
+// HEADER: visit-file-decls.h:2:8: StructDecl=HeaderStruct:2:8
+// HEADER: visit-file-decls.h:2:26: FieldDecl=field:2:26
+// HEADER-NOT: FunctionDecl=in_main
+
+// MAIN-NOT: FunctionDecl=in_header
+// MAIN: visit-file-decls.c:5:5: FunctionDecl=in_main:5:5
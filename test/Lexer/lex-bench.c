@@ -0,0 +1,16 @@
+// RUN: lex-bench -runs=1 -mode=raw -mode=pp %s | FileCheck %s
+// RUN: %clang_cc1 -emit-pth -o %t.pth %s
+// RUN: lex-bench -runs=1 -cold -mode=pth -pth %t.pth -print-stats %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=PTH %s
+
+#define LIST 1, 2, 3
+int a[] = { LIST };
+
+// CHECK: raw (warm): 17 tokens in
+// CHECK: pp (warm): 13 tokens in
+
+// PTH: *** PTH Stats:
+// PTH: 1 files lexed from cached tokens.
+// PTH: 0 files without cached tokens.
+// PTH: *** Source Manager Stats:
+// PTH: pth (cold): 13 tokens in
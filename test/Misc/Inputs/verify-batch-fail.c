@@ -0,0 +1 @@
+int z; // expected-error {{redefinition of 'z'}}
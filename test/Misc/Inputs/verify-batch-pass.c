@@ -0,0 +1,3 @@
+void f(void) {
+  return 1; // expected-warning {{void function 'f' should not return a value}}
+}
@@ -33,3 +33,11 @@ void baz(char *Msg) {
   sprintf(Msg,  "  sizeof FoooLib            : =%3u\n",   12LL);
 }
 
+// Tokens after the first one in a macro body keep their own columns.
+// RUN: grep ":38:21: note: instantiated from:" %t
+#define M3 (void)0; 42;
+
+void qux() {
+  // RUN: grep ":42:3: warning: expression result unused" %t
+  M3
+}
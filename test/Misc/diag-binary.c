@@ -0,0 +1,7 @@
+// RUN: %clang_cc1 -fsyntax-only -fdiagnostics-binary %s 2> %t
+// RUN: head -c 4 %t | grep DIAG
+// RUN: grep "use of undeclared identifier" %t
+
+int f(void) {
+  return undeclared_variable;
+}
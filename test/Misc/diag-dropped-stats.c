@@ -0,0 +1,7 @@
+// Warnings silenced by -w are dropped when they are reported.
+// RUN: %clang_cc1 -fsyntax-only -w -print-stats %s 2>&1 | grep "^  [1-9][0-9]* diagnostics constructed but dropped"
+// RUN: %clang_cc1 -fsyntax-only -w %s 2>&1 | not grep warning
+
+#if 1
+#endif foo
+
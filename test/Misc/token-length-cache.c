@@ -0,0 +1,10 @@
+// RUN: %clang_cc1 -fsyntax-only -fdiagnostics-print-source-range-info -print-stats %s 2>&1 | FileCheck %s
+
+// The end of each highlighted range is measured for the caret line and
+// again for the range info; the second measurement comes from the cache.
+int f(int *ptr1, float *ptr2) {
+  return ptr1 != ptr2;
+}
+
+// CHECK: warning: comparison of distinct pointer types
+// CHECK: {{[1-9][0-9]*}} token lengths measured, {{[1-9][0-9]*}} answered from the cache.
@@ -0,0 +1,12 @@
+// RUN: not %clang_cc1 -verify-batch -fsyntax-only %s %S/Inputs/verify-batch-pass.c %S/Inputs/verify-batch-fail.c > %t 2> %t.err
+// RUN: FileCheck %s < %t
+// RUN: FileCheck -check-prefix=ERR %s < %t.err
+// RUN: %clang_cc1 -verify-batch -fsyntax-only %s %S/Inputs/verify-batch-pass.c
+
+int x = y; // expected-error {{use of undeclared identifier 'y'}}
+
+// CHECK: PASS: {{.*}}verify-batch.c
+// CHECK-NEXT: PASS: {{.*}}verify-batch-pass.c
+// CHECK-NEXT: FAIL: {{.*}}verify-batch-fail.c
+// ERR: 'error' diagnostics expected but not seen:
+// ERR-NOT: seen but not expected
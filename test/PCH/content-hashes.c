@@ -0,0 +1,12 @@
+// RUN: cp %S/content-hashes.h %t.h
+// RUN: %clang_cc1 -pch-content-hashes -emit-pch -o %t.pch %t.h
+
+// A header whose modification time changed is checked by its contents.
+// RUN: touch -t 200001010000 %t.h
+// RUN: %clang_cc1 -include-pch %t.pch -fsyntax-only -verify %s
+
+// RUN: sed -e 's/17/18/' %S/content-hashes.h > %t.h
+// RUN: not %clang_cc1 -include-pch %t.pch -fsyntax-only %s 2>&1 | FileCheck %s
+// CHECK: content-hashes.c{{.*}}.h' has been modified since the PCH file was built
+
+int a[VALUE == 17 ? 1 : -1];
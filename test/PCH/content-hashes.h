@@ -0,0 +1,3 @@
+// Header for PCH test content-hashes.c
+
+#define VALUE 17
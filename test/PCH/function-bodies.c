@@ -0,0 +1,18 @@
+// Test this without pch.
+// RUN: %clang_cc1 -include %S/function-bodies.h -emit-llvm -o - %s | FileCheck -check-prefix=IR %s
+
+// Test with pch.
+// RUN: %clang_cc1 -emit-pch -o %t %S/function-bodies.h
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o - %s | FileCheck -check-prefix=IR %s
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o /dev/null -print-stats %s 2>&1 | FileCheck %s
+
+// Only the bodies of the functions that are emitted are read from the PCH
+// file, whether they are prefetched or read on demand.
+// CHECK: 2/4 function bodies read
+
+// IR: define i32 @f()
+// IR: define internal i32 @two()
+// IR: define internal i32 @one()
+// IR-NOT: three
+// IR-NOT: four
+int f(void) { return two(); }
@@ -0,0 +1,6 @@
+// Header for PCH test function-bodies.c
+
+static inline int one(void) { return 1; }
+static inline int two(void) { return one() + one(); }
+static inline int three(void) { return two() + one(); }
+static inline int four(void) { return two() + two(); }
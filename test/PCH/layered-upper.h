@@ -0,0 +1,9 @@
+// Header for PCH test layered.c, the upper layer
+
+#define UPPER_MACRO (LOWER_MACRO + 1)
+
+struct upper { struct lower l; int y; };
+
+int upper_function(struct lower *);
+
+typedef enum lower_enum upper_enum;
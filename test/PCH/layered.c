@@ -0,0 +1,21 @@
+// Test this without pch.
+// RUN: %clang_cc1 -include %S/layered.h -include %S/layered-upper.h -fsyntax-only -verify %s
+
+// Test with a PCH built on top of another PCH.
+// RUN: %clang_cc1 -emit-pch -o %t.lower %S/layered.h
+// RUN: %clang_cc1 -include-pch %t.lower -emit-pch -o %t.upper %S/layered-upper.h
+// RUN: %clang_cc1 -include-pch %t.upper -fsyntax-only -verify %s
+
+// Declarations of the lower layer that the upper one does not use are still
+// in the upper PCH.
+int a[LOWER_MACRO == 17 ? 1 : -1];
+int b[UPPER_MACRO == 18 ? 1 : -1];
+
+struct upper u;
+int c(void) {
+  return lower_function(u.l.x) + upper_function(&u.l) + lower_var +
+         lower_inline(Lower2);
+}
+
+upper_enum e = Lower1;
+float *f = &lower_var; // expected-warning{{incompatible pointer types}}
@@ -0,0 +1,12 @@
+// Header for PCH test layered.c, the lower layer
+
+#define LOWER_MACRO 17
+
+struct lower { int x; };
+
+int lower_function(int);
+extern int lower_var;
+
+static inline int lower_inline(int i) { return i + 1; }
+
+enum lower_enum { Lower1, Lower2 };
@@ -0,0 +1,13 @@
+// Test this without pch.
+// RUN: %clang_cc1 -include %S/lazy-macros.h -fsyntax-only -verify %s
+
+// Test with pch.
+// RUN: %clang_cc1 -emit-pch -o %t %S/lazy-macros.h
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -verify %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// Naming a parameter of TWICE loads the identifier HIDDEN, but only the
+// macros that are expanded are read from the PCH file.
+// CHECK: 1/{{[0-9]+}} macros read
+
+int a[TWICE(2) == 4 ? 1 : -1];
@@ -0,0 +1,5 @@
+// Header for PCH test lazy-macros.c
+
+#define HIDDEN 3
+#define TWICE(HIDDEN) ((HIDDEN) * 2)
+#define UNUSED 5
@@ -0,0 +1,16 @@
+// Test this without pch.
+// RUN: %clang_cc1 -include %S/line-offsets.h -fsyntax-only %s 2> %t.nopch
+// RUN: FileCheck %s < %t.nopch
+
+// Test with pch, which stores the lines of the header.
+// RUN: %clang_cc1 -emit-pch -o %t %S/line-offsets.h
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only %s 2> %t.pch
+// RUN: FileCheck %s < %t.pch
+
+double f(int);
+double g(int);
+
+// CHECK: line-offsets.c:10:8: error: conflicting types for 'f'
+// CHECK: line-offsets.h:7:6: note: previous declaration is here
+// CHECK: line-offsets.c:11:8: error: conflicting types for 'g'
+// CHECK: line-offsets.h:10:5: note: previous declaration is here
@@ -0,0 +1,10 @@
+// Header for PCH test line-offsets.c
+
+struct S {
+  int x;
+};
+
+	int f(int);
+
+// A line ending in a carriage return.
+int g(int);
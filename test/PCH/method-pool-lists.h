@@ -0,0 +1,10 @@
+/* For use with the method-pool-lists.m test */
+
+@interface A
++ (A *)make;
+- (int)value:(int)x;
+@end
+
+@interface B
++ (B *)value:(int)x;
+@end
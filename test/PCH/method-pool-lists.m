@@ -0,0 +1,15 @@
+// Test this without pch.
+// RUN: %clang_cc1 -include %S/method-pool-lists.h -fsyntax-only -verify %s
+
+// Test with pch.
+// RUN: %clang_cc1 -x objective-c -emit-pch -o %t %S/method-pool-lists.h
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -verify %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// Only the instance methods named value: are read from the PCH file; its
+// factory methods and the factory method make stay in the file.
+// CHECK: 1/4 method pool lists read
+
+int f(id x) {
+  return [x value:17];
+}
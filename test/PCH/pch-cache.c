@@ -0,0 +1,26 @@
+// RUN: rm -rf %t.cache
+// RUN: cp %S/pch-cache.h %t.h
+
+// The first invocation builds the PCH file and installs it in the cache.
+// RUN: %clang_cc1 -emit-pch -pch-cache %t.cache -o %t.1 %t.h 2>&1 | FileCheck %s
+// CHECK: warning: parsing the header
+
+// An identical invocation, writing elsewhere, copies it without parsing.
+// RUN: %clang_cc1 -emit-pch -pch-cache %t.cache -o %t.2 %t.h 2>&1 | count 0
+// RUN: cmp %t.1 %t.2
+// RUN: %clang_cc1 -include-pch %t.2 -fsyntax-only -verify %s
+
+// An entry that lost its tail is not used, and is replaced.
+// RUN: for f in %t.cache/pch-*; do head -c $(($(wc -c < $f) - 1)) $f > %t.cut; mv %t.cut $f; done
+// RUN: %clang_cc1 -emit-pch -pch-cache %t.cache -o %t.4 %t.h 2>&1 | FileCheck %s
+// RUN: cmp %t.1 %t.4
+// RUN: %clang_cc1 -emit-pch -pch-cache %t.cache -o %t.5 %t.h 2>&1 | count 0
+
+// Once the header changes, the entry is stale; a read-only cache is not
+// updated.
+// RUN: echo 'int another_variable;' >> %t.h
+// RUN: %clang_cc1 -emit-pch -pch-cache %t.cache -pch-cache-read-only -o %t.3 %t.h 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -emit-pch -pch-cache %t.cache -pch-cache-read-only -o %t.3 %t.h 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -include-pch %t.3 -fsyntax-only -verify %s
+
+int *p = &cached_variable;
@@ -0,0 +1,4 @@
+// Header for PCH test pch-cache.c
+
+#warning parsing the header
+int cached_variable;
@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-pch -o %t %S/record-layouts.h
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -fsyntax-only -verify %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// Only the layout computed while building the PCH file is stored, and it
+// is read instead of being computed again.
+// CHECK: 1/1 record layouts read
+
+int check_laid[sizeof(struct Laid) == 16 ? 1 : -1];
+int check_offset[__builtin_offsetof(struct Laid, d) == 8 ? 1 : -1];
+int check_not_laid[sizeof(struct NotLaid) == 4 ? 1 : -1];
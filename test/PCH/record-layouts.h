@@ -0,0 +1,6 @@
+// Header for PCH test record-layouts.c
+
+struct Laid { char c; int i; double d; };
+int laid_size = sizeof(struct Laid);
+
+struct NotLaid { char c; short s; };
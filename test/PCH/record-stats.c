@@ -0,0 +1,14 @@
+// RUN: %clang_cc1 -emit-pch -print-stats -o %t %S/record-stats.h 2>&1 | FileCheck -check-prefix=PARM %s
+// RUN: %clang_cc1 -emit-pch -print-stats -o %t %S/record-stats.h 2>&1 | FileCheck -check-prefix=DECLREF %s
+// RUN: %clang_cc1 -emit-pch -print-stats -o %t %S/record-stats.h 2>&1 | FileCheck -check-prefix=CAST %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only %s
+
+// The parameters that are used are not abbreviated.
+// PARM: *** PCH Record Stats:
+// PARM: DECL_PARM_VAR {{ *}}4 records, {{ *}}{{[0-9]+}} bytes, {{ *}}2 abbreviated
+
+// DECLREF: EXPR_DECL_REF {{ *}}3 records, {{ *}}{{[0-9]+}} bytes, {{ *}}3 abbreviated
+
+// CAST: EXPR_IMPLICIT_CAST {{ *}}1 records, {{ *}}{{[0-9]+}} bytes, {{ *}}1 abbreviated
+
+long f(void) { return add(1, 2) + twice(3) + narrow(4); }
@@ -0,0 +1,7 @@
+// Header for PCH test record-stats.c
+
+long add(int x, int y);
+
+long twice(long z) { return z + z; }
+
+int narrow(long v) { return v; }
@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "attribute lists allocated, [1-9][0-9]* reused from the pool"
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "argument arrays allocated, [1-9][0-9]* reused from the pool"
+
+// The attributes of each declaration are recycled for the next one.
+void f0(const char *, ...) __attribute__((nothrow, format(printf, 1, 2)));
+void f1(const char *, ...) __attribute__((nothrow, format(printf, 1, 2)));
+void f2(void *) __attribute__((nonnull(1), visibility("default")));
+void f3(void *) __attribute__((nonnull(1), visibility("default")));
+void f4(void *, void *, void *, void *, void *)
+  __attribute__((nonnull(1, 2, 3, 4, 5)));
+
+void g(void) {
+  f0("%d", 1);
+  f1("%s", "x");
+}
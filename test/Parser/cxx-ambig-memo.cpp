@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "[1-9][0-9]* backtracks"
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "[1-9][0-9]* answered from the memo"
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "[1-9][0-9]* tokens cached at most"
+
+// Nested declarators revisit the same '(' in every enclosing tentative parse
+// and again when the declaration is parsed; the answers must not change.
+typedef int T;
+struct S { S(int); int get(); };
+
+void f(int i) {
+  T (*(*(*fp)(int))(int))(int);
+  T (*(*(*(*gp)(T))(T))(T))(T) = 0;
+  T (x)(i);
+  T (y) = (T)(i);
+  int *p = &x;
+  fp = 0;
+  (T(i));
+  S(i).get();
+  S (z)(T(i)); // expected-warning {{disambiguated as a function declarator}}
+  S (w)(T(i)); // expected-warning {{disambiguated as a function declarator}}
+  if (T (c) = i)
+    return;
+}
+
+// The tentative parse of the whole declaration does not know V as a type in
+// the parentheses after k, but by the time they are parsed for real the
+// parameter of g has declared struct V, so k is a function.
+struct U { };
+
+void h() {
+  U (x), g(struct V *), k(V);
+  U (*p)(V) = k;
+}
@@ -0,0 +1,37 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// A name that was not a type must be looked up again once a declaration
+// makes it one.
+int T;
+
+void f() {
+  (void)(T * 2);
+  typedef int T;
+  T *p = 0;
+  (void)p;
+}
+
+namespace N {
+  typedef int U;
+  struct S { typedef int V; };
+}
+
+void g() {
+  U * 2; // expected-error {{use of undeclared identifier 'U'}}
+  using namespace N;
+  U *p = 0;
+  (void)p;
+}
+
+struct S {
+  void h() {
+    (void)(W * 2); // expected-error {{use of undeclared identifier 'W'}}
+  }
+};
+
+void k() {
+  N::S::V *q = 0;
+  for (N::S::V i = 0; i < 2; ++i)
+    (void)(i * 2);
+  (void)q;
+}
@@ -0,0 +1,19 @@
+// RUN: %clang_cc1 -fsyntax-only -skip-function-bodies -verify %s
+
+int f() {
+  return undeclared;
+}
+
+struct S {
+  int g() { if (true) { return also_undeclared; } ) }
+  void h();
+};
+
+void S::h() {
+  { int x = 1 }
+}
+
+template<typename T> T tmpl(T t) { return t.missing(); }
+
+int i = tmpl(1) + f();
+int j = still_undeclared; // expected-error {{use of undeclared identifier}}
@@ -0,0 +1,7 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/a %t/b
+// RUN: echo 'int found_in_b;' > %t/b/cdl.h
+// RUN: %clang_cc1 -E -cache-directory-listings -I %t/a -I %t/b %s | grep 'int found_in_b;'
+// RUN: %clang_cc1 -E -cache-directory-listings -I %t/a -I %t/b %s -o /dev/null -print-stats 2>&1 | grep 'lookups answered from them'
+
+#include "cdl.h"
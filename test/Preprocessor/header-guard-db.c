@@ -0,0 +1,9 @@
+// RUN: rm -f %t.hgd
+// RUN: %clang_cc1 -header-guard-db %t.hgd -E %s | grep 'header_guard_db' | count 1
+// RUN: test -f %t.hgd
+// RUN: %clang_cc1 -header-guard-db %t.hgd -E %s | grep 'header_guard_db' | count 1
+// RUN: %clang_cc1 -header-guard-db %t.hgd -Eonly %s -DHEADER_GUARD_DB_H -print-stats 2>&1 | FileCheck -check-prefix=STATS %s
+
+#include "header-guard-db.h"
+
+// STATS: {{^  1 #includes skipped due to the guard database\.$}}
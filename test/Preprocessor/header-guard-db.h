@@ -0,0 +1,4 @@
+#ifndef HEADER_GUARD_DB_H
+#define HEADER_GUARD_DB_H
+int header_guard_db;
+#endif
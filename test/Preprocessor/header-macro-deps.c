@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -E -header-macro-deps %t.deps %s -o /dev/null
+// RUN: FileCheck %s < %t.deps
+
+// A guarded header is listed once, with the state of each macro from outside
+// it that it used, in order.  Macros it defines itself are left out.
+
+#define CONFIG_A
+#define CONFIG_VALUE (1 + 2)
+#include "header-macro-deps.h"
+#include "header-macro-deps.h"
+
+// CHECK: header-macro-deps.h:
+// CHECK-NEXT: {{^  !HEADER_MACRO_DEPS_H$}}
+// CHECK-NEXT: {{^  CONFIG_A=$}}
+// CHECK-NEXT: {{^  CONFIG_VALUE=\(1 \+ 2\)$}}
+// CHECK-NEXT: {{^  !CONFIG_MISSING$}}
+// CHECK-NEXT: {{^  !CONFIG_ZERO$}}
+// CHECK-NOT: header-macro-deps.h
@@ -0,0 +1,17 @@
+#ifndef HEADER_MACRO_DEPS_H
+#define HEADER_MACRO_DEPS_H
+
+#define LOCAL 1
+
+#if defined(CONFIG_A) && LOCAL
+int a = CONFIG_VALUE;
+#endif
+
+#ifdef CONFIG_MISSING
+int missing;
+#endif
+
+#if CONFIG_ZERO
+#endif
+
+#endif
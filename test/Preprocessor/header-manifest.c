@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -E -header-manifest %t.manifest %s -o /dev/null
+// RUN: FileCheck %s < %t.manifest
+
+// Each file read is listed once, when it is first entered, with the hash
+// and size of its contents.
+
+#include "file_to_include.h"
+#include "file_to_include.h"
+
+// CHECK: {{^[0-9a-f]{16} [0-9]+ .*header-manifest.c$}}
+// CHECK-NEXT: {{^[0-9a-f]{16} [0-9]+ .*file_to_include.h$}}
+// CHECK-NOT: file_to_include.h
@@ -0,0 +1,15 @@
+// RUN: rm -f %t.hsc
+// RUN: %clang_cc1 -header-search-cache %t.hsc -I %S -E %s | grep 'file_to_include' | count 2
+// RUN: test -f %t.hsc
+// RUN: %clang_cc1 -header-search-cache %t.hsc -I %S -E %s | grep 'file_to_include' | count 2
+// RUN: %clang_cc1 -header-search-cache %t.hsc -I %S -E %s -DMISSING 2>&1 | grep 'file not found'
+
+#include <file_to_include.h>
+
+#if __has_include(<header-search-cache-missing.h>)
+#error "found a header that does not exist"
+#endif
+
+#ifdef MISSING
+#include <header-search-cache-missing.h>
+#endif
@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -include-prefetch-threads 2 -I %S -E %s | grep 'file_to_include' | count 2
+// RUN: %clang_cc1 -include-prefetch-threads 2 -I %S -Eonly %s -dependency-file %t.d -MT %s.o
+// RUN: grep 'file_to_include.h' %t.d
+// RUN: grep 'mi_opt.h' %t.d
+
+#include <file_to_include.h>
+#include "mi_opt.h"
+
+#if 0
+#include <include-prefetch-missing.h>
+#endif
@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -E %s | FileCheck -strict-whitespace %s
+
+#define CAT(a, b) a ## b
+#define XCAT(a, b) CAT(a, b)
+#define x1 expanded
+
+// CHECK: 1: x12 expanded
+1: CAT(x, 12) XCAT(x, 1)
+// CHECK: 2: 12 0x1f 1.5e+3 1e
+2: CAT(1, 2) CAT(0x, 1f) CAT(1., 5e+3) CAT(1, e)
+// CHECK: 3: int3 3int
+3: CAT(int, 3) CAT(3, int)
@@ -0,0 +1,17 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -E -dM -predefines-cache %t %s > %t.miss
+// RUN: ls %t | grep 'predefines-.*\.cache'
+// RUN: %clang_cc1 -E -dM -predefines-cache %t %s > %t.hit
+// RUN: %clang_cc1 -E -dM %s > %t.lexed
+// RUN: diff %t.lexed %t.miss
+// RUN: diff %t.lexed %t.hit
+
+// Line markers and -dD output match lexing the predefines.
+// RUN: %clang_cc1 -E -dD -predefines-cache %t %s > %t.dd.hit
+// RUN: %clang_cc1 -E -dD %s > %t.dd.lexed
+// RUN: diff %t.dd.lexed %t.dd.hit
+
+// RUN: %clang_cc1 -E -predefines-cache %t %s | grep 'int x = 1;'
+// RUN: %clang_cc1 -fsyntax-only -predefines-cache %t -D__STDC__=2 %s 2>&1 | grep '<built-in>:.*previous definition'
+
+int x = __STDC__;
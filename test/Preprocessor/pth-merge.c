@@ -0,0 +1,13 @@
+// RUN: rm -f %t.pth
+// RUN: %clang_cc1 -emit-pth -pth-merge %t.pth -o %t.pth -I %S %s
+// RUN: %clang_cc1 -emit-pth -pth-merge %t.pth -o %t.pth -I %S %s -DSECOND
+// RUN: grep 'file_to_include.h' %t.pth
+// RUN: grep 'mi_opt.h' %t.pth
+// RUN: %clang_cc1 -token-cache %t.pth -I %S -E %s | grep 'file_to_include' | count 2
+// RUN: %clang_cc1 -token-cache %t.pth -I %S -E %s -DSECOND | grep 'int x = 2'
+
+#ifdef SECOND
+#include "mi_opt.h"
+#else
+#include "file_to_include.h"
+#endif
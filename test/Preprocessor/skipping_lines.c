@@ -0,0 +1,40 @@
+// RUN: %clang_cc1 -E %s | FileCheck %s
+
+// Directive-looking lines inside comments and literals of a skipped block
+// must not end it.
+#if 0
+/* a comment
+#else
+   spanning lines */
+"a string \
+#else
+"
+'unterminated
+// a comment \
+#else
+skipped1
+#endif
+// CHECK-NOT: skipped1
+
+// Directives can follow a comment or be split across escaped newlines.
+#if 0
+/* comment */ #else
+// CHECK: after_comment
+after_comment
+#endif
+
+#if 0
+  #\
+  endif
+// CHECK: after_escape
+after_escape
+
+#if 0
+x /* a comment
+*/ #else
+skipped2
+  %:else
+// CHECK-NOT: skipped2
+// CHECK: digraph
+digraph
+#endif
@@ -0,0 +1,15 @@
+// RUN: %clang_cc1 -fsyntax-only -disable-free -verify %s
+
+// Sema evaluates an implicit conversion while checking it and then gives the
+// same ImplicitCastExpr a new type; later evaluations must see the new type.
+int a1[(char)-1 + 0ULL == 0xFFFFFFFFFFFFFFFFULL ? 1 : -1];
+int a2[(short)-1 + 0U == 0xFFFFFFFFU ? 1 : -1];
+int a3[(unsigned char)200 + 0LL == 200 ? 1 : -1];
+int a4[sizeof((char)1 + 0ULL) == sizeof(unsigned long long) ? 1 : -1];
+
+void f(void) {
+  switch (0ULL) {
+  case (char)-1 + 0ULL: break; // expected-note {{previous case}}
+  case 0xFFFFFFFFFFFFFFFFULL: break; // expected-error {{duplicate case value}}
+  }
+}
@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// Each distinct format string is parsed once; the calls that share it must
+// still get their own diagnostics, at their own locations.
+int printf(const char *restrict, ...);
+
+void f(int i, long l, const char *s) {
+  printf("%d %s\n", i, s);
+  printf("%d %s\n", l, s); // expected-warning {{conversion specifies type 'int' but the argument has type 'long'}}
+  printf("%d %s\n", i, i); // expected-warning {{conversion specifies type 'char *' but the argument has type 'int'}}
+  printf("%d %s\n", i); // expected-warning {{more '%' conversions than data arguments}}
+  printf("%d %b", i, i); // expected-warning {{invalid conversion specifier 'b'}}
+  printf("%d %b", l, i); // expected-warning {{conversion specifies type 'int' but the argument has type 'long'}} expected-warning {{invalid conversion specifier 'b'}}
+  printf("%d\0%d", i, i); // expected-warning {{format string contains '\0' within the string body}}
+  printf("%d\0%d", i, i); // expected-warning {{format string contains '\0' within the string body}}
+}
+
+// CHECK: format-strings-cache.c:10:12: warning: conversion specifies type 'int'
+// CHECK: format-strings-cache.c:11:15: warning: conversion specifies type 'char *'
+// CHECK: format-strings-cache.c:13:16: warning: invalid conversion specifier 'b'
+// CHECK: format-strings-cache.c:14:12: warning: conversion specifies type 'int'
+// CHECK: format-strings-cache.c:14:16: warning: invalid conversion specifier 'b'
+// CHECK: 8 format strings checked, 4 parsed before.
+// CHECK: format argument type checks, {{[1-9][0-9]*}} answered from the cache.
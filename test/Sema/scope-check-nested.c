@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Jumps between sibling and nested protected scopes.
+
+void f(int n, int k) {
+  switch (k) {
+  case 0: {
+    int a[n]; // expected-note {{jump bypasses initialization of variable length array}}
+    a[0] = 0;
+    {
+      int b[n];
+      goto out; // ok: leaves both scopes
+      b[0] = 0;
+    }
+  inner:
+    break;
+  }
+  case 1: {
+    int c[n]; // expected-note {{jump bypasses initialization of variable length array}}
+    int d[n]; // expected-note {{jump bypasses initialization of variable length array}}
+  case 2: // expected-error {{illegal switch case into protected scope}}
+    c[0] = d[0] = 0;
+    goto inner; // expected-error {{illegal goto into protected scope}}
+  }
+  }
+out:
+  ;
+}
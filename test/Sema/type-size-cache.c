@@ -0,0 +1,19 @@
+// RUN: %clang_cc1 -fsyntax-only -triple i386-apple-darwin9 -verify %s
+// RUN: %clang_cc1 -fsyntax-only -triple i386-apple-darwin9 -print-stats %s 2>&1 | grep "type size queries, [0-9]* answered from the cache"
+
+// Sizes and alignments are cached per type; sugar that changes the
+// alignment must not share the entry of its underlying type.
+typedef int aligned_int __attribute__((aligned(16)));
+int a1[__alignof(int) == 4 ? 1 : -1];
+int a2[__alignof(aligned_int) == 16 ? 1 : -1];
+int a3[__alignof(int) == 4 ? 1 : -1];
+
+struct S { char c; aligned_int i; };
+int s1[sizeof(struct S) == 32 ? 1 : -1];
+int s2[sizeof(struct S[3]) == 96 ? 1 : -1];
+int s3[sizeof(struct S[3]) == 96 ? 1 : -1];
+
+struct Incomplete;
+int i1 = sizeof(struct Incomplete); // expected-error {{invalid application of 'sizeof' to an incomplete type 'struct Incomplete'}}
+struct Incomplete { double d[2]; };
+int i2[sizeof(struct Incomplete) == 16 ? 1 : -1];
@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -fsyntax-only -ftypo-correction-limit 1 -verify %s
+
+int counter; // expected-note{{'counter' declared here}}
+int totals;
+
+int f() {
+  return countr; // expected-error{{use of undeclared identifier 'countr'; did you mean 'counter'?}}
+}
+
+int g() {
+  return totls; // expected-error{{use of undeclared identifier 'totls'}}
+}
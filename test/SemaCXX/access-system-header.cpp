@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -fsyntax-only -faccess-control -fno-system-header-access-control -verify %s
+// RUN: %clang_cc1 -fsyntax-only -faccess-control %s 2>&1 | grep "sys.h:.*'secret' is a private member of 'A'"
+
+class A {
+  int secret; // expected-note 4 {{declared private here}}
+public:
+  A();
+};
+
+class D : public A { };
+
+# 1 "sys.h" 1 3
+inline int peek(A &a) { return a.secret; }
+static D global_d;
+int peeked = global_d.secret;
+# 16 "access-system-header.cpp" 2
+
+inline int poke(A &a) { return a.secret; } // expected-error {{'secret' is a private member of 'A'}}
+
+// Access checks delayed until the end of a declaration are still made, and
+// share the path they find from D to A.
+int poked = global_d.secret + // expected-error {{'secret' is a private member of 'A'}}
+            global_d.secret + // expected-error {{'secret' is a private member of 'A'}}
+            global_d.secret; // expected-error {{'secret' is a private member of 'A'}}
@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 -fsyntax-only -disable-free -verify %s
+
+// The values of enumerators and variables declared after an expression was
+// first evaluated must still be seen.
+template<unsigned N> struct Fib {
+  enum { value = Fib<N-1>::value + Fib<N-2>::value };
+};
+template<> struct Fib<0> { enum { value = 0 }; };
+template<> struct Fib<1> { enum { value = 1 }; };
+
+int fib20[Fib<20>::value == 6765 ? 1 : -1];
+int fib20_again[Fib<20>::value == 6765 ? 1 : -1];
+
+extern const int n;
+int bad[n == 4 ? 1 : -1]; // expected-error {{variable length array declaration not allowed at file scope}}
+const int n = 4;
+int good[n == 4 ? 1 : -1];
+
+enum E { A = 1, B = A + 1, C = B * 2 };
+int c[C == 4 ? 1 : -1];
+
+int classify(int i) {
+  switch (i) {
+  case A: return 1;
+  case B: return 2;
+  case A + B: return 3;
+  case C: return 4; // expected-note {{previous case}}
+  case A + A + B: return 5; // expected-error {{duplicate case value}}
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "standard conversions, [1-9][0-9]* answered from the cache"
+
+// Standard conversions that only depend on the types are cached; the ones
+// that depend on the expression or on the bases of a class must not be.
+typedef char One[1];
+typedef char Two[2];
+
+One &f(int*);
+Two &f(...);
+
+void null_pointers(int i) {
+  int a1[sizeof(f(0)) == 1 ? 1 : -1];
+  int a2[sizeof(f(i)) == 2 ? 1 : -1];
+  int a3[sizeof(f(0)) == 1 ? 1 : -1];
+  int a4[sizeof(f(i)) == 2 ? 1 : -1];
+}
+
+One &g(char*);
+Two &g(...);
+
+void literals(const char (&ca)[4]) {
+  int a1[sizeof(g("abc")) == 1 ? 1 : -1];
+  int a2[sizeof(g(ca)) == 2 ? 1 : -1];
+  int a3[sizeof(g("abc")) == 1 ? 1 : -1];
+  int a4[sizeof(g(ca)) == 2 ? 1 : -1];
+}
+
+struct A;
+struct B;
+One &h(A*);
+Two &h(...);
+
+void before(B *b) {
+  int a1[sizeof(h(b)) == 2 ? 1 : -1];
+  int a2[sizeof(h(b)) == 2 ? 1 : -1];
+}
+
+struct A { };
+struct B : A { };
+
+void after(B *b) {
+  int a1[sizeof(h(b)) == 1 ? 1 : -1];
+  int a2[sizeof(h(b)) == 1 ? 1 : -1];
+}
+
+struct S { unsigned x : 3; };
+One &k(int);
+Two &k(unsigned);
+
+void bit_fields(S s, unsigned u) {
+  int a1[sizeof(k(s.x)) == 1 ? 1 : -1];
+  int a2[sizeof(k(u)) == 2 ? 1 : -1];
+  int a3[sizeof(k(s.x)) == 1 ? 1 : -1];
+  int a4[sizeof(k(u)) == 2 ? 1 : -1];
+}
@@ -0,0 +1,39 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "[1-9][0-9]* decls in the longest chain"
+
+// Long identifier chains are indexed; redeclaring, shadowing and popping
+// the overloads must behave as for short chains.
+template<int N> struct I { };
+
+#define F1(N) void f(I<N>);
+#define F4(N) F1(N) F1(N+1) F1(N+2) F1(N+3)
+#define F16(N) F4(N) F4(N+4) F4(N+8) F4(N+12)
+
+namespace N {
+  F16(0) F16(16) F16(32)
+
+  void f(I<3>);
+  void f(I<40>) { }
+  int f(I<3>, int);
+
+  void g() {
+    f(I<3>());
+    f(I<47>());
+    int r = f(I<3>(), 1);
+    {
+      int f = r;
+      int *p = &f;
+    }
+    f(I<40>());
+  }
+}
+
+void k() {
+  N::f(I<5>());
+  using namespace N;
+  f(I<6>());
+  int r = f(I<3>(), 1);
+}
+
+void f(I<3>, int) { } // expected-note {{previous definition is here}}
+void f(I<3>, int) { } // expected-error {{redefinition of 'f'}}
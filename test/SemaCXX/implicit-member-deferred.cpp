@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// The implicit special members of classes that are not dynamic are only
+// declared when they are first looked up.
+struct Trivial { int x; };
+struct Member { Trivial t; ~Member(); };
+struct Derived : Member { };
+
+void f(Derived d, const Trivial &t) {
+  Derived copy(d);
+  copy = d;
+  Trivial t2 = t;
+  t2 = t;
+  copy.~Derived();
+}
+
+// Dynamic classes still declare them up front.
+struct Base { virtual ~Base(); };
+struct Dynamic : Base { Trivial t; };
+
+void g(Dynamic &d) {
+  Dynamic copy(d);
+  copy = d;
+}
@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// A namespace with enough declarations that its lookup table is sized before
+// it is built; names from reopened namespaces and transparent contexts must
+// all be found, and redeclarations must not be found twice.
+#define DECLS4(P) int P##0(); int P##1(); int P##2(); int P##3();
+#define DECLS16(P) DECLS4(P##0) DECLS4(P##1) DECLS4(P##2) DECLS4(P##3)
+
+namespace big {
+  DECLS16(f)
+  DECLS16(g)
+  enum E { e0, e1, e2, e3 };
+  extern "C" { int c(); }
+}
+
+namespace big {
+  DECLS16(h)
+  int f00();
+  int h33(int);
+}
+
+int use() {
+  return big::f00() + big::g33() + big::h00() + big::h33(1) + big::e3 +
+         big::c();
+}
+
+int missing() {
+  return big::undeclared_function(); // expected-error {{no member named 'undeclared_function' in namespace 'big'}}
+}
@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -fsyntax-only -faccess-control -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "[1-9][0-9]* answered from the cache"
+
+// Member lookups through the bases of a class are cached; repeated lookups
+// must still see the right declarations and access.
+class L0 {
+public:
+  int m;
+  static int s;
+  void f(int);
+  int f(double);
+private:
+  int p; // expected-note 2 {{declared private here}}
+};
+
+template<class B> struct L : B { };
+
+typedef L<L<L<L<L<L<L<L<L<L<L<L<L<L<L<L0> > > > > > > > > > > > > > > Deep;
+
+void test(Deep *d) {
+  d->m = 1;
+  d->m = 2;
+  d->f(1);
+  int i = d->f(1.0);
+  Deep::s = i;
+  d->p = 0; // expected-error {{'p' is a private member of 'class L0'}}
+  d->p = 1; // expected-error {{'p' is a private member of 'class L0'}}
+}
+
+struct Base { int x; };
+struct Derived : Base {
+  void g() { x = 1; }
+  int h() { return x; }
+};
@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Large overload sets keep the conversion sequences of their candidates out
+// of line; candidates with the wrong number of parameters never get any.
+struct A { };
+struct B { };
+
+int *h(int, int, int, int); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+double *h(double, double, double, double); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+char *h(char, char, char, char); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+A *h(A, A, A, A); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+B *h(B, B, B, B); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+float *h(float, float, float, float); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+long *h(long, long, long, long); // expected-note {{candidate function not viable: requires 4 arguments, but 3 were provided}}
+void h(int); // expected-note {{candidate function not viable: requires 1 argument, but 3 were provided}}
+void h(int, int, int, int, int = 0, int = 0); // expected-note {{candidate function not viable: requires at least 4 arguments, but 3 were provided}}
+template<class T> void h(T, T); // expected-note {{candidate template ignored: failed template argument deduction}}
+
+void test() {
+  int *i = h(1, 2, 3, 4);
+  double *d = h(1.0, 2.0, 3.0, 4.0);
+  char *c = h('a', 'b', 'c', 'd');
+  A *a = h(A(), A(), A(), A());
+  B *b = h(B(), B(), B(), B());
+  float *f = h(1.0f, 2.0f, 3.0f, 4.0f);
+  long *l = h(1L, 2L, 3L, 4L);
+  h(1, 2, 3); // expected-error {{no matching function for call to 'h'}}
+}
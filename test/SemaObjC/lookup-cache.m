@@ -0,0 +1,40 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Lookups through a class are cached; adding a category, protocol or
+// superclass must make later lookups see the new declarations.
+
+@protocol P
+- (void)fromProtocol;
+@end
+
+@interface Base { int baseIvar; }
+@end
+
+@interface A
+@end
+
+@interface Other
+- (void)fromCategory;
+@end
+
+void f0(A *a) {
+  [a fromCategory]; // expected-warning {{A may not respond to 'fromCategory'}}
+}
+
+@interface A (Cat) <P>
+- (void)fromCategory;
+@property int prop;
+@end
+
+void f1(A *a) {
+  [a fromCategory];
+  [a fromProtocol];
+  [a setProp:a.prop];
+}
+
+@interface B : Base
+@end
+
+@implementation B
+- (int)m { return baseIvar; }
+@end
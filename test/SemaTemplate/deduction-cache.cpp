@@ -0,0 +1,37 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "deductions from call arguments, [1-9][0-9]* answered from the cache"
+
+// Deductions from call arguments are cached; repeated calls must still see
+// the same successes and failures, and the cache must notice new classes.
+struct Stream { };
+template<class T> struct Box { T v; };
+template<class T> Stream &operator<<(Stream &, const Box<T> &);
+template<class T> Stream &operator<<(Stream &, T *);
+template<class T, class U> Stream &operator<<(Stream &, U (T::*)());
+Stream &operator<<(Stream &, int);
+
+void log(Stream &s, Box<int> b, char *p) {
+  s << b << p << 1;
+  s << b << p << 1;
+  s << b << p << 1;
+}
+
+template<class T, class U> void h(T); // expected-note 2 {{candidate template ignored: couldn't infer template argument 'U'}}
+
+void test_failures() {
+  h(1); // expected-error {{no matching function for call to 'h'}}
+  h(1); // expected-error {{no matching function for call to 'h'}}
+}
+
+template<class T> struct B { };
+template<class T> int d(B<T> *); // expected-note {{candidate template ignored: failed template argument deduction}}
+
+struct D;
+void test_incomplete(D *p) {
+  d(p); // expected-error {{no matching function for call to 'd'}}
+}
+
+struct D : B<int> { };
+void test_complete(D *p) {
+  int i = d(p);
+}
@@ -0,0 +1,32 @@
+// RUN: %clang_cc1 -fsyntax-only -felide-type-locs -verify %s
+// RUN: %clang_cc1 -fsyntax-only -felide-type-locs -print-stats %s 2>&1 | grep "[1-9][0-9]* declarations with elided type locations"
+
+// Declarations whose type locations are elided must still be instantiated
+// normally, and diagnostics fall back to the location of the declaration.
+# 1 "sys.h" 1 3
+template<class T> struct vec {
+  T *data;
+  unsigned size;
+  vec(const T *p, unsigned n);
+  T &at(unsigned i) { return data[i]; }
+  template<class U> void append(const U *p, void (*f)(T &, const U &));
+};
+# 15 "elide-type-locs.cpp" 2
+
+struct Incomplete; // expected-note {{forward declaration of 'Incomplete'}}
+
+template<class T> struct Holder {
+  typedef T *pointer;
+  T value; // expected-error {{field has incomplete type 'Incomplete'}}
+  void set(const T &v, pointer p = 0) { T copy = v; value = copy; }
+};
+
+void convert(int &, const char &);
+
+void test(vec<int> &v, const char *s, Holder<double> &h) {
+  v.at(0) = 1;
+  v.append(s, convert);
+  h.set(1.0);
+}
+
+Holder<Incomplete> bad; // expected-note {{in instantiation of template class 'struct Holder<Incomplete>' requested here}}
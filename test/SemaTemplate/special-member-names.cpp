@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | grep "special member name lookups, [1-9][0-9]* names created"
+
+// The names of constructors, destructors and conversion functions are kept
+// per type; each kind of name must still be distinct.
+template<class T> struct Holder {
+  Holder();
+  Holder(const Holder &);
+  ~Holder();
+  operator T() const;
+  operator const T *() const;
+};
+
+template<class T> Holder<T>::Holder() { }
+template<class T> Holder<T>::~Holder() { }
+
+void test(Holder<int> h, Holder<float> f) {
+  int i = h;
+  const int *p = h;
+  float x = f;
+  const float *q = f;
+  h.~Holder<int>();
+  f.~Holder<float>();
+}
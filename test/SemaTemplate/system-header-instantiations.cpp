@@ -0,0 +1,26 @@
+// RUN: %clang_cc1 -fsyntax-only -fast-syntax-only -fno-system-header-instantiations -verify %s
+
+// Bodies of system header templates are not instantiated at the end of the
+// translation unit, so the error in sort() is not diagnosed; the bodies of
+// templates in the main file still are.
+# 1 "sys.h" 1 3
+template<class T> void sort(T *first, T *last) {
+  first->compare(*last);
+}
+
+template<class T> struct box {
+  static T empty;
+  T get() { return empty.value(); }
+};
+template<class T> T box<T>::empty = T::make();
+# 16 "system-header-instantiations.cpp" 2
+
+template<class T> void check(T t) {
+  t.validate(); // expected-error {{member reference base type 'int' is not a structure or union}}
+}
+
+void test(int *p, box<int> &b) {
+  sort(p, p + 1);
+  b.get();
+  check(*p); // expected-note {{in instantiation of function template specialization 'check<int>' requested here}}
+}
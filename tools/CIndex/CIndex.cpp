@@ -25,9 +25,16 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/System/Mutex.h"
 #include "llvm/System/Program.h"
 #include "llvm/System/Signals.h"
+#include "llvm/System/ThreadLocal.h"
+#include "llvm/System/Threading.h"
+#include <algorithm>
+#include <queue>
 
 // Needed to define L_TMPNAM on some systems.
 #include <cstdio>
@@ -52,8 +59,13 @@ static unsigned crashtracer_counter_id[NUM_CRASH_STRINGS] = { 0 };
 static const char *crashtracer_strings[NUM_CRASH_STRINGS] = { 0 };
 static const char *agg_crashtracer_strings[NUM_CRASH_STRINGS] = { 0 };
 
+/// Guards the crash tracer slots, which translation units created on
+/// different threads share.
+static llvm::ManagedStatic<llvm::sys::Mutex> crashtracer_lock;
+
 static unsigned SetCrashTracerInfo(const char *str,
                                    llvm::SmallString<1024> &AggStr) {
+  llvm::sys::ScopedLock Guard(*crashtracer_lock);
 
   unsigned slot = 0;
   while (crashtracer_strings[slot]) {
@@ -64,10 +76,8 @@ static unsigned SetCrashTracerInfo(const char *str,
   crashtracer_counter_id[slot] = ++crashtracer_counter;
 
   // We need to create an aggregate string because multiple threads
-  // may be in this method at one time.  The crash reporter string
-  // will attempt to overapproximate the set of in-flight invocations
-  // of this function.  Race conditions can still cause this goal
-  // to not be achieved.
+  // may be parsing at one time.  The crash reporter string overapproximates
+  // the set of in-flight invocations of this function.
   {
     llvm::raw_svector_ostream Out(AggStr);
     for (unsigned i = 0; i < NUM_CRASH_STRINGS; ++i)
@@ -78,6 +88,8 @@ static unsigned SetCrashTracerInfo(const char *str,
 }
 
 static void ResetCrashTracerInfo(unsigned slot) {
+  llvm::sys::ScopedLock Guard(*crashtracer_lock);
+
   unsigned max_slot = 0;
   unsigned max_value = 0;
 
@@ -253,6 +265,7 @@ public:
 
   bool Visit(CXCursor Cursor, bool CheckedRegionOfInterest = false);
   bool VisitChildren(CXCursor Parent);
+  bool VisitTopLevelDecls(const llvm::SmallVectorImpl<Decl*> &Decls);
 
   // Declaration visitors
   bool VisitAttributes(Decl *D);
@@ -435,6 +448,22 @@ bool CursorVisitor::VisitChildren(CXCursor Cursor) {
   return false;
 }
 
+/// \brief Visit the given top-level declarations, as children of the
+/// translation unit.
+///
+/// \returns true if the visitation should be aborted, false if it
+/// should continue.
+bool CursorVisitor::VisitTopLevelDecls(
+                                   const llvm::SmallVectorImpl<Decl*> &Decls) {
+  CXCursor OldParent = Parent;
+  Parent = clang_getTranslationUnitCursor(TU);
+  bool Aborted = false;
+  for (unsigned I = 0, N = Decls.size(); I != N && !Aborted; ++I)
+    Aborted = Visit(MakeCXCursor(Decls[I], TU));
+  Parent = OldParent;
+  return Aborted;
+}
+
 bool CursorVisitor::VisitDeclContext(DeclContext *DC) {
   for (DeclContext::decl_iterator
        I = DC->decls_begin(), E = DC->decls_end(); I != E; ++I) {
@@ -503,9 +532,12 @@ bool CursorVisitor::VisitFunctionDecl(FunctionDecl *ND) {
   if (VisitDeclaratorDecl(ND))
     return true;
 
-  if (ND->isThisDeclarationADefinition() &&
-      Visit(MakeCXCursor(ND->getBody(), StmtParent, TU)))
-    return true;
+  if (ND->isThisDeclarationADefinition()) {
+    // Parse the body now if it was skipped.
+    TU->ParseSkippedFunctionBody(ND);
+    if (Visit(MakeCXCursor(ND->getBody(), StmtParent, TU)))
+      return true;
+  }
 
   return false;
 }
@@ -915,6 +947,13 @@ CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
     CIdxr->setOnlyLocalDecls();
   if (displayDiagnostics)
     CIdxr->setDisplayDiagnostics();
+
+  // Translation units may be created from this index on several threads;
+  // make the lazily created LLVM and Clang globals safe for that, and compute
+  // the path to clang now so that those threads only read it.
+  if (!llvm::llvm_is_multithreaded())
+    llvm::llvm_start_multithreaded();
+  CIdxr->getClangPath();
   return CIdxr;
 }
 
@@ -930,6 +969,20 @@ void clang_setUseExternalASTGeneration(CXIndex CIdx, int value) {
   }
 }
 
+void clang_setSkipFunctionBodies(CXIndex CIdx, int value) {
+  if (CIdx) {
+    CIndexer *CXXIdx = static_cast<CIndexer *>(CIdx);
+    CXXIdx->setSkipFunctionBodies(value);
+  }
+}
+
+void clang_setPrecompilePreamble(CXIndex CIdx, int value) {
+  if (CIdx) {
+    CIndexer *CXXIdx = static_cast<CIndexer *>(CIdx);
+    CXXIdx->setPrecompilePreamble(value);
+  }
+}
+
 CXTranslationUnit clang_createTranslationUnit(CXIndex CIdx,
                                               const char *ast_filename) {
   if (!CIdx)
@@ -990,6 +1043,11 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
     ArgsCrashTracerInfo ACTI(Args);
 #endif
 
+    llvm::OwningPtr<DiagnosticClient> QueueClient;
+    if (DiagnosticQueue *Queue = CXXIdx->getDiagnosticQueue())
+      QueueClient.reset(createQueueDiagnosticClient(*Queue, num_unsaved_files,
+                                                    unsaved_files));
+
     llvm::OwningPtr<ASTUnit> Unit(
       ASTUnit::LoadFromCommandLine(Args.data(), Args.data() + Args.size(),
                                    *Diags,
@@ -997,7 +1055,10 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
                                    CXXIdx->getOnlyLocalDecls(),
                                    RemappedFiles.data(),
                                    RemappedFiles.size(),
-                                   /*CaptureDiagnostics=*/true));
+                                   /*CaptureDiagnostics=*/true,
+                                   CXXIdx->getSkipFunctionBodies(),
+                                   CXXIdx->getPrecompilePreamble(),
+                                   QueueClient.get()));
 
     // FIXME: Until we have broader testing, just drop the entire AST if we
     // encountered an error.
@@ -1027,6 +1088,11 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
   // Add the '-emit-ast' option as our execution mode for 'clang'.
   argv.push_back("-emit-ast");
 
+  if (CXXIdx->getSkipFunctionBodies()) {
+    argv.push_back("-Xclang");
+    argv.push_back("-skip-function-bodies");
+  }
+
   // The 'source_filename' argument is optional.  If the caller does not
   // specify it then it is assumed that the source file is specified
   // in the actual argument list.
@@ -1035,8 +1101,8 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
 
   // Generate a temporary name for the AST file.
   argv.push_back("-o");
-  char astTmpFile[L_tmpnam];
-  argv.push_back(tmpnam(astTmpFile));
+  std::string astTmpFile = ASTWorkerPool::getTemporaryASTPath();
+  argv.push_back(astTmpFile.c_str());
 
   // Remap any unsaved files to temporary files.
   std::vector<llvm::sys::Path> TemporaryFiles;
@@ -1066,25 +1132,55 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
       argv.push_back(arg);
     }
 
-  // Generate a temporary name for the diagnostics file.
-  char tmpFileResults[L_tmpnam];
-  char *tmpResultsFileName = tmpnam(tmpFileResults);
-  llvm::sys::Path DiagnosticsFile(tmpResultsFileName);
-  TemporaryFiles.push_back(DiagnosticsFile);
   argv.push_back("-fdiagnostics-binary");
 
   // Add the null terminator.
   argv.push_back(NULL);
 
-  // Invoke 'clang'.
-  llvm::sys::Path DevNull; // leave empty, causes redirection to /dev/null
-                           // on Unix or NUL (Windows).
+  // The serialized diagnostics of the compilation.
+  std::string Diagnostics;
+
+  DiagnosticQueue *Queue = CXXIdx->getDiagnosticQueue();
+  unsigned StreamID = 0;
+  if (Queue) {
+    StreamID = Queue->createStream();
+    for (unsigned I = 0; I != num_unsaved_files; ++I)
+      Queue->pushUnsavedFile(StreamID, unsaved_files[I]);
+  }
+
   std::string ErrMsg;
-  const llvm::sys::Path *Redirects[] = { &DevNull, &DevNull, &DiagnosticsFile,
-                                         NULL };
-  llvm::sys::Program::ExecuteAndWait(ClangPath, &argv[0], /* env */ NULL,
-      /* redirects */ &Redirects[0],
-      /* secondsToWait */ 0, /* memoryLimits */ 0, &ErrMsg);
+  if (ASTWorkerPool *Pool = CXXIdx->getASTWorkerPool()) {
+    // Hand the compilation to a clang process that is already running, which
+    // sends the diagnostics back on its socket as they are produced.
+    Pool->Run(&argv[1], &argv[argv.size() - 1], Diagnostics, ErrMsg, Queue,
+              StreamID);
+  } else {
+    // Generate a temporary name for the diagnostics file.
+    char tmpFileResults[L_tmpnam];
+    char *tmpResultsFileName = tmpnam(tmpFileResults);
+    llvm::sys::Path DiagnosticsFile(tmpResultsFileName);
+    TemporaryFiles.push_back(DiagnosticsFile);
+
+    // Invoke 'clang'.
+    llvm::sys::Path DevNull; // leave empty, causes redirection to /dev/null
+                             // on Unix or NUL (Windows).
+    const llvm::sys::Path *Redirects[] = { &DevNull, &DevNull,
+                                           &DiagnosticsFile, NULL };
+    llvm::sys::Program::ExecuteAndWait(ClangPath, &argv[0], /* env */ NULL,
+        /* redirects */ &Redirects[0],
+        /* secondsToWait */ 0, /* memoryLimits */ 0, &ErrMsg);
+
+    if (llvm::MemoryBuffer *F
+          = llvm::MemoryBuffer::getFile(DiagnosticsFile.c_str())) {
+      Diagnostics = F->getBuffer();
+      delete F;
+    }
+    if (Queue)
+      Queue->pushData(StreamID, Diagnostics);
+  }
+
+  if (Queue)
+    Queue->pushEnd(StreamID);
 
   if (!ErrMsg.empty()) {
     std::string AllArgs;
@@ -1104,7 +1200,7 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
                                           RemappedFiles.size(),
                                           /*CaptureDiagnostics=*/true);
   if (ATU) {
-    LoadSerializedDiagnostics(DiagnosticsFile, 
+    LoadSerializedDiagnostics(Diagnostics,
                               num_unsaved_files, unsaved_files,
                               ATU->getFileManager(),
                               ATU->getSourceManager(),
@@ -1117,7 +1213,7 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
     // FIXME: Faked LangOpts!
     LangOptions LangOpts;
     llvm::SmallVector<StoredDiagnostic, 4> Diags;
-    LoadSerializedDiagnostics(DiagnosticsFile, 
+    LoadSerializedDiagnostics(Diagnostics,
                               num_unsaved_files, unsaved_files,
                               FileMgr, SourceMgr, Diags);
     for (llvm::SmallVector<StoredDiagnostic, 4>::iterator D = Diags.begin(), 
@@ -1150,12 +1246,81 @@ void clang_disposeTranslationUnit(CXTranslationUnit CTUnit) {
     delete static_cast<ASTUnit *>(CTUnit);
 }
 
+int clang_reparseTranslationUnit(CXTranslationUnit TU,
+                                 unsigned num_unsaved_files,
+                                 struct CXUnsavedFile *unsaved_files) {
+  if (!TU)
+    return 1;
+
+  // Configure the diagnostics.
+  DiagnosticOptions DiagOpts;
+  llvm::OwningPtr<Diagnostic> Diags;
+  Diags.reset(CompilerInstance::createDiagnostics(DiagOpts, 0, 0));
+
+  llvm::SmallVector<ASTUnit::RemappedFile, 4> RemappedFiles;
+  for (unsigned I = 0; I != num_unsaved_files; ++I) {
+    const llvm::MemoryBuffer *Buffer
+      = llvm::MemoryBuffer::getMemBufferCopy(unsaved_files[I].Contents,
+                          unsaved_files[I].Contents + unsaved_files[I].Length,
+                                             unsaved_files[I].Filename);
+    RemappedFiles.push_back(std::make_pair(unsaved_files[I].Filename,
+                                           Buffer));
+  }
+
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
+  return CXXUnit->Reparse(*Diags, RemappedFiles.data(), RemappedFiles.size());
+}
+
+unsigned clang_getNumFunctionBodyReparses(CXTranslationUnit TU) {
+  if (!TU)
+    return 0;
+  return static_cast<ASTUnit *>(TU)->getNumFunctionBodyReparses();
+}
+
+unsigned long clang_getTranslationUnitMemoryUsage(CXTranslationUnit TU,
+                                              enum CXTUMemoryUsageKind Kind) {
+  if (!TU)
+    return 0;
+
+  ASTUnit::MemoryUsage Usage;
+  static_cast<ASTUnit *>(TU)->getMemoryUsage(Usage);
+  switch (Kind) {
+  case CXTUMemoryUsage_AST: return Usage.AST;
+  case CXTUMemoryUsage_SourceFiles: return Usage.SourceFiles;
+  case CXTUMemoryUsage_LineTables: return Usage.LineTables;
+  case CXTUMemoryUsage_SourceManager: return Usage.SourceManager;
+  case CXTUMemoryUsage_Preprocessor: return Usage.Preprocessor;
+  case CXTUMemoryUsage_PCH: return Usage.PCH;
+  case CXTUMemoryUsage_Diagnostics: return Usage.Diagnostics;
+  }
+  return 0;
+}
+
+CXString clang_getTUMemoryUsageKindSpelling(enum CXTUMemoryUsageKind Kind) {
+  switch (Kind) {
+  case CXTUMemoryUsage_AST: return createCXString("AST");
+  case CXTUMemoryUsage_SourceFiles: return createCXString("SourceFiles");
+  case CXTUMemoryUsage_LineTables: return createCXString("LineTables");
+  case CXTUMemoryUsage_SourceManager: return createCXString("SourceManager");
+  case CXTUMemoryUsage_Preprocessor: return createCXString("Preprocessor");
+  case CXTUMemoryUsage_PCH: return createCXString("PCH");
+  case CXTUMemoryUsage_Diagnostics: return createCXString("Diagnostics");
+  }
+  return createCXString("<unknown>");
+}
+
+void clang_trimTranslationUnitMemory(CXTranslationUnit TU) {
+  if (TU)
+    static_cast<ASTUnit *>(TU)->releaseCaches();
+}
+
 CXString clang_getTranslationUnitSpelling(CXTranslationUnit CTUnit) {
   if (!CTUnit)
     return createCXString("");
 
+  // The name lives as long as the translation unit does.
   ASTUnit *CXXUnit = static_cast<ASTUnit *>(CTUnit);
-  return createCXString(CXXUnit->getOriginalSourceFileName(), true);
+  return createCXString(CXXUnit->getOriginalSourceFileName().c_str());
 }
 
 CXCursor clang_getTranslationUnitCursor(CXTranslationUnit TU) {
@@ -1190,9 +1355,7 @@ CXSourceLocation clang_getLocation(CXTranslationUnit tu,
 
   ASTUnit *CXXUnit = static_cast<ASTUnit *>(tu);
   SourceLocation SLoc
-    = CXXUnit->getSourceManager().getLocation(
-                                        static_cast<const FileEntry *>(file),
-                                              line, column);
+    = CXXUnit->getLocation(static_cast<const FileEntry *>(file), line, column);
 
   return cxloc::translateSourceLocation(CXXUnit->getASTContext(), SLoc);
 }
@@ -1329,11 +1492,9 @@ static SourceLocation getLocationFromExpr(Expr *E) {
 
 extern "C" {
 
-unsigned clang_visitChildren(CXCursor parent,
-                             CXCursorVisitor visitor,
-                             CXClientData client_data) {
-  ASTUnit *CXXUnit = getCursorASTUnit(parent);
-
+/// \brief Return the highest PCH level of the declarations that visiting
+/// \p CXXUnit reports.
+static unsigned getVisitPCHLevel(ASTUnit *CXXUnit) {
   unsigned PCHLevel = Decl::MaxPCHLevel;
 
   // Set the PCHLevel to filter out unwanted decls if requested.
@@ -1344,18 +1505,45 @@ unsigned clang_visitChildren(CXCursor parent,
     if (CXXUnit->isMainFileAST())
       ++PCHLevel;
   }
+  return PCHLevel;
+}
 
-  CursorVisitor CursorVis(CXXUnit, visitor, client_data, PCHLevel);
+unsigned clang_visitChildren(CXCursor parent,
+                             CXCursorVisitor visitor,
+                             CXClientData client_data) {
+  ASTUnit *CXXUnit = getCursorASTUnit(parent);
+  CursorVisitor CursorVis(CXXUnit, visitor, client_data,
+                          getVisitPCHLevel(CXXUnit));
   return CursorVis.VisitChildren(parent);
 }
 
+unsigned clang_visitChildrenInFile(CXTranslationUnit tu, CXFile file,
+                                   CXCursorVisitor visitor,
+                                   CXClientData client_data) {
+  if (!tu || !file)
+    return 0;
+
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(tu);
+  llvm::SmallVector<Decl *, 64> Decls;
+  CXXUnit->getFileLevelDecls(static_cast<const FileEntry *>(file), Decls);
+
+  CursorVisitor CursorVis(CXXUnit, visitor, client_data,
+                          getVisitPCHLevel(CXXUnit));
+  return CursorVis.VisitTopLevelDecls(Decls);
+}
+
 static CXString getDeclSpelling(Decl *D) {
   NamedDecl *ND = dyn_cast_or_null<NamedDecl>(D);
   if (!ND)
     return createCXString("");
 
-  if (ObjCMethodDecl *OMD = dyn_cast<ObjCMethodDecl>(ND))
-    return createCXString(OMD->getSelector().getAsString());
+  if (ObjCMethodDecl *OMD = dyn_cast<ObjCMethodDecl>(ND)) {
+    // The spelling of a selector without arguments is that of its identifier.
+    Selector Sel = OMD->getSelector();
+    if (Sel.isUnarySelector())
+      return createCXString(Sel.getIdentifierInfoForSlot(0)->getNameStart());
+    return createCXString(Sel.getAsString());
+  }
 
   if (ObjCCategoryImplDecl *CIMP = dyn_cast<ObjCCategoryImplDecl>(ND))
     // No, this isn't the same as the code below. getIdentifier() is non-virtual
@@ -1504,6 +1692,211 @@ enum CXChildVisitResult GetCursorVisitor(CXCursor cursor,
   return CXChildVisit_Recurse;
 }
 
+namespace {
+
+/// \brief The innermost cursor at each position of the files of a
+/// translation unit, so that clang_getCursor() does not walk the AST from the
+/// top for every lookup.
+///
+/// The index of a file is built the first time a cursor is looked up in it,
+/// by a single walk over the cursors that overlap the file.  It is kept with
+/// the ASTUnit, which drops it when the AST changes.
+class CursorIndex : public ASTUnitClientData {
+public:
+  /// \brief The key of the cursor index in the client data of an ASTUnit.
+  static char Key;
+
+  /// \brief The cursors of one file, as a list of contiguous segments.
+  struct FileIndex {
+    /// \brief The sorted offsets at which each segment starts.
+    std::vector<unsigned> Starts;
+
+    /// \brief The innermost cursor of each segment, or a CXCursor_NoDeclFound
+    /// cursor for the segments not covered by any cursor.
+    std::vector<CXCursor> Cursors;
+  };
+
+private:
+  llvm::DenseMap<FileID, FileIndex *> Files;
+
+public:
+  ~CursorIndex();
+
+  /// \brief Return the index of the file \p FID, or null if it has not been
+  /// built yet.
+  FileIndex *getFileIndex(FileID FID) const {
+    llvm::DenseMap<FileID, FileIndex *>::const_iterator Pos = Files.find(FID);
+    return Pos == Files.end() ? 0 : Pos->second;
+  }
+
+  /// \brief Record the index of the file \p FID, taking ownership of it.
+  void setFileIndex(FileID FID, FileIndex *Index) {
+    assert(!Files.count(FID) && "File already indexed!");
+    Files[FID] = Index;
+  }
+};
+
+/// \brief A cursor visited while a file is indexed, with the part of the file
+/// it covers.
+struct CursorIndexEntry {
+  CXCursor Cursor;
+  int Begin, End;
+};
+
+/// \brief The state of the walk that builds the index of one file.
+struct CursorIndexBuilder {
+  SourceManager &SM;
+  FileID FID;
+  SourceLocation FileStart;
+  unsigned FileSize;
+
+  /// \brief The visited cursors, in the order they were visited.
+  std::vector<CursorIndexEntry> Entries;
+
+  /// \brief The entries of the last visited cursor and of its ancestors.
+  llvm::SmallVector<unsigned, 16> Stack;
+
+  CursorIndexBuilder(SourceManager &SM, FileID FID)
+    : SM(SM), FID(FID), FileStart(SM.getLocForStartOfFile(FID)),
+      FileSize(SM.getBuffer(FID)->getBufferSize()) { }
+
+  /// \brief Return the position of \p Loc relative to the file, in the order
+  /// of the translation unit: its offset if it is within the file, -1 if it
+  /// comes before it, or one past the end of the file if it comes after it.
+  int getPosition(SourceLocation Loc) {
+    std::pair<FileID, unsigned> Decomposed
+      = SM.getDecomposedLoc(SM.getInstantiationLoc(Loc));
+    if (Decomposed.first == FID)
+      return Decomposed.second;
+    return SM.isBeforeInTranslationUnit(Loc, FileStart) ? -1 : FileSize + 1;
+  }
+};
+
+}
+
+char CursorIndex::Key;
+
+CursorIndex::~CursorIndex() {
+  for (llvm::DenseMap<FileID, FileIndex *>::iterator I = Files.begin(),
+                                                     E = Files.end();
+       I != E; ++I)
+    delete I->second;
+}
+
+static enum CXChildVisitResult CursorIndexVisitor(CXCursor cursor,
+                                                  CXCursor parent,
+                                                  CXClientData client_data) {
+  CursorIndexBuilder *Builder = static_cast<CursorIndexBuilder *>(client_data);
+  while (!Builder->Stack.empty() &&
+         !clang_equalCursors(Builder->Entries[Builder->Stack.back()].Cursor,
+                             parent))
+    Builder->Stack.pop_back();
+
+  SourceRange Range = cxloc::translateCXSourceRange(
+                                                clang_getCursorExtent(cursor));
+  CursorIndexEntry Entry;
+  Entry.Cursor = cursor;
+  Entry.Begin = Builder->getPosition(Range.getBegin());
+  Entry.End = Builder->getPosition(Range.getEnd());
+
+  // A search for a location only visits a cursor if its ancestors cover that
+  // location too.
+  if (!Builder->Stack.empty()) {
+    const CursorIndexEntry &Parent = Builder->Entries[Builder->Stack.back()];
+    Entry.Begin = std::max(Entry.Begin, Parent.Begin);
+    Entry.End = std::min(Entry.End, Parent.End);
+  }
+
+  Builder->Stack.push_back(Builder->Entries.size());
+  Builder->Entries.push_back(Entry);
+  return CXChildVisit_Recurse;
+}
+
+namespace {
+/// \brief Orders index entries by the position they begin at.
+struct CursorIndexEntryBeginLess {
+  const std::vector<CursorIndexEntry> &Entries;
+  explicit CursorIndexEntryBeginLess(
+                                 const std::vector<CursorIndexEntry> &Entries)
+    : Entries(Entries) { }
+  bool operator()(unsigned LHS, unsigned RHS) const {
+    return Entries[LHS].Begin < Entries[RHS].Begin;
+  }
+};
+}
+
+/// \brief Build the cursor index of the file \p FID.
+static CursorIndex::FileIndex *BuildFileCursorIndex(ASTUnit *CXXUnit,
+                                                    FileID FID) {
+  CursorIndexBuilder Builder(CXXUnit->getSourceManager(), FID);
+  SourceRange File(Builder.FileStart,
+                   Builder.FileStart.getFileLocWithOffset(Builder.FileSize));
+  CursorVisitor CursorVis(CXXUnit, CursorIndexVisitor, &Builder,
+                          Decl::MaxPCHLevel, File);
+  CursorVis.VisitChildren(clang_getTranslationUnitCursor(CXXUnit));
+
+  // The cursor at a position is the last one visited that covers it.  Sweep
+  // over the points where an entry begins or ends, keeping the entries that
+  // cover the current point in a heap ordered by visitation.
+  const std::vector<CursorIndexEntry> &Entries = Builder.Entries;
+  std::vector<unsigned> Order;
+  std::vector<unsigned> Points(1, 0);
+  for (unsigned I = 0, N = Entries.size(); I != N; ++I) {
+    if (Entries[I].Begin >= Entries[I].End || Entries[I].End <= 0 ||
+        Entries[I].Begin >= int(Builder.FileSize))
+      continue;
+    Order.push_back(I);
+    Points.push_back(std::max(Entries[I].Begin, 0));
+    if (Entries[I].End < int(Builder.FileSize))
+      Points.push_back(Entries[I].End);
+  }
+  std::sort(Points.begin(), Points.end());
+  Points.erase(std::unique(Points.begin(), Points.end()), Points.end());
+  std::sort(Order.begin(), Order.end(), CursorIndexEntryBeginLess(Entries));
+
+  CursorIndex::FileIndex *Index = new CursorIndex::FileIndex;
+  CXCursor NoCursor = MakeCXCursorInvalid(CXCursor_NoDeclFound);
+  std::priority_queue<unsigned> Covering;
+  unsigned Next = 0;
+  for (unsigned P = 0, NumPoints = Points.size(); P != NumPoints; ++P) {
+    int Point = Points[P];
+    for (; Next != Order.size() && Entries[Order[Next]].Begin <= Point; ++Next)
+      Covering.push(Order[Next]);
+    while (!Covering.empty() && Entries[Covering.top()].End <= Point)
+      Covering.pop();
+
+    const CXCursor &Cursor
+      = Covering.empty() ? NoCursor : Entries[Covering.top()].Cursor;
+    if (!Index->Cursors.empty() && clang_equalCursors(Index->Cursors.back(),
+                                                      Cursor))
+      continue;
+    Index->Starts.push_back(Point);
+    Index->Cursors.push_back(Cursor);
+  }
+  return Index;
+}
+
+/// \brief Return the cursor index of the file \p FID, building it if needed.
+static CursorIndex::FileIndex *getFileCursorIndex(ASTUnit *CXXUnit,
+                                                  FileID FID) {
+  CursorIndex *Index = static_cast<CursorIndex *>(
+                                   CXXUnit->getClientData(&CursorIndex::Key));
+  if (CursorIndex::FileIndex *FileIdx = Index ? Index->getFileIndex(FID) : 0)
+    return FileIdx;
+
+  // Building the index may parse skipped function bodies, which drops the
+  // client data, so only attach the index afterwards.
+  CursorIndex::FileIndex *FileIdx = BuildFileCursorIndex(CXXUnit, FID);
+  Index = static_cast<CursorIndex *>(
+                                   CXXUnit->getClientData(&CursorIndex::Key));
+  if (!Index) {
+    Index = new CursorIndex;
+    CXXUnit->setClientData(&CursorIndex::Key, Index);
+  }
+  Index->setFileIndex(FID, FileIdx);
+  return FileIdx;
+}
+
 CXCursor clang_getCursor(CXTranslationUnit TU, CXSourceLocation Loc) {
   if (!TU)
     return clang_getNullCursor();
@@ -1512,12 +1905,19 @@ CXCursor clang_getCursor(CXTranslationUnit TU, CXSourceLocation Loc) {
 
   SourceLocation SLoc = cxloc::translateSourceLocation(Loc);
   CXCursor Result = MakeCXCursorInvalid(CXCursor_NoDeclFound);
-  if (SLoc.isValid()) {
+  if (SLoc.isValid() && SLoc.isFileID()) {
+    std::pair<FileID, unsigned> Decomposed
+      = CXXUnit->getSourceManager().getDecomposedLoc(SLoc);
+
+    CursorIndex::FileIndex *FileIdx
+      = getFileCursorIndex(CXXUnit, Decomposed.first);
+    std::vector<unsigned>::const_iterator Pos
+      = std::upper_bound(FileIdx->Starts.begin(), FileIdx->Starts.end(),
+                         Decomposed.second);
+    if (Pos != FileIdx->Starts.begin())
+      Result = FileIdx->Cursors[Pos - FileIdx->Starts.begin() - 1];
+  } else if (SLoc.isValid()) {
     SourceRange RegionOfInterest(SLoc, SLoc.getFileLocWithOffset(1));
-
-    // FIXME: Would be great to have a "hint" cursor, then walk from that
-    // hint cursor upward until we find a cursor whose source range encloses
-    // the region of interest, rather than starting from the translation unit.
     CXCursor Parent = clang_getTranslationUnitCursor(CXXUnit);
     CursorVisitor CursorVis(CXXUnit, GetCursorVisitor, &Result,
                             Decl::MaxPCHLevel, RegionOfInterest);
@@ -2024,17 +2424,9 @@ CXSourceRange clang_getTokenExtent(CXTranslationUnit TU, CXToken CXTok) {
                         SourceLocation::getFromRawEncoding(CXTok.int_data[1]));
 }
 
-void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
-                    CXToken **Tokens, unsigned *NumTokens) {
-  if (Tokens)
-    *Tokens = 0;
-  if (NumTokens)
-    *NumTokens = 0;
-
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
-  if (!CXXUnit || !Tokens || !NumTokens)
-    return;
-
+/// \brief Lex the tokens of the source range \p Range.
+static void getTokens(ASTUnit *CXXUnit, CXSourceRange Range,
+                      llvm::SmallVectorImpl<CXToken> &CXTokens) {
   SourceRange R = cxloc::translateCXSourceRange(Range);
   if (R.isInvalid())
     return;
@@ -2059,7 +2451,6 @@ void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
 
   // Lex tokens until we hit the end of the range.
   const char *EffectiveBufferEnd = Buffer.first + EndLocInfo.second;
-  llvm::SmallVector<CXToken, 32> CXTokens;
   Token Tok;
   do {
     // Lex the next token
@@ -2101,7 +2492,21 @@ void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
     }
     CXTokens.push_back(CXTok);
   } while (Lex.getBufferLocation() <= EffectiveBufferEnd);
+}
+
+void clang_tokenize(CXTranslationUnit TU, CXSourceRange Range,
+                    CXToken **Tokens, unsigned *NumTokens) {
+  if (Tokens)
+    *Tokens = 0;
+  if (NumTokens)
+    *NumTokens = 0;
 
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
+  if (!CXXUnit || !Tokens || !NumTokens)
+    return;
+
+  llvm::SmallVector<CXToken, 32> CXTokens;
+  getTokens(CXXUnit, Range, CXTokens);
   if (CXTokens.empty())
     return;
 
@@ -2185,6 +2590,53 @@ void clang_annotateTokens(CXTranslationUnit TU,
   }
 }
 
+void clang_tokenizeWithCursors(CXTranslationUnit TU, CXSourceRange Range,
+                               CXToken **Tokens, CXCursor **Cursors,
+                               unsigned *NumTokens) {
+  if (Tokens)
+    *Tokens = 0;
+  if (Cursors)
+    *Cursors = 0;
+  if (NumTokens)
+    *NumTokens = 0;
+
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
+  if (!CXXUnit || !Tokens || !Cursors || !NumTokens)
+    return;
+
+  llvm::SmallVector<CXToken, 32> CXTokens;
+  getTokens(CXXUnit, Range, CXTokens);
+  if (CXTokens.empty())
+    return;
+
+  // The tokens all come from one file and are in order, so walk the cursor
+  // index of that file alongside them.  Both arrays live in one block, so
+  // that clang_disposeTokens() releases the cursors as well.
+  unsigned N = CXTokens.size();
+  void *Mem = malloc(sizeof(CXToken) * N + sizeof(CXCursor) * N);
+  CXToken *TokArray = static_cast<CXToken *>(Mem);
+  CXCursor *CursorArray = reinterpret_cast<CXCursor *>(TokArray + N);
+  memmove(TokArray, CXTokens.data(), sizeof(CXToken) * N);
+
+  SourceManager &SM = CXXUnit->getSourceManager();
+  FileID FID
+    = SM.getFileID(SourceLocation::getFromRawEncoding(CXTokens[0].int_data[1]));
+  CursorIndex::FileIndex *FileIdx = getFileCursorIndex(CXXUnit, FID);
+  unsigned Segment = 0, NumSegments = FileIdx->Starts.size();
+  for (unsigned I = 0; I != N; ++I) {
+    unsigned Offset = SM.getFileOffset(
+                  SourceLocation::getFromRawEncoding(CXTokens[I].int_data[1]));
+    while (Segment != NumSegments && FileIdx->Starts[Segment] <= Offset)
+      ++Segment;
+    CursorArray[I] = Segment ? FileIdx->Cursors[Segment - 1]
+                             : MakeCXCursorInvalid(CXCursor_NoDeclFound);
+  }
+
+  *Tokens = TokArray;
+  *Cursors = CursorArray;
+  *NumTokens = N;
+}
+
 void clang_disposeTokens(CXTranslationUnit TU,
                          CXToken *Tokens, unsigned NumTokens) {
   free(Tokens);
@@ -2208,31 +2660,77 @@ void clang_disposeString(CXString string) {
 
 } // end: extern "C"
 
+namespace {
+/// StringArena - The storage behind a CXStringArena.
+struct StringArena {
+  llvm::BumpPtrAllocator Allocator;
+};
+}
+
+/// CurrentStringArena - The string arena installed on each thread, if any.
+static llvm::sys::ThreadLocal<StringArena> CurrentStringArena;
+
+extern "C" {
+CXStringArena clang_createStringArena(void) {
+  return new StringArena();
+}
+
+CXStringArena clang_setStringArena(CXStringArena arena) {
+  StringArena *Previous = CurrentStringArena.get();
+  CurrentStringArena.set(static_cast<StringArena *>(arena));
+  return Previous;
+}
+
+void clang_resetStringArena(CXStringArena arena) {
+  if (arena)
+    static_cast<StringArena *>(arena)->Allocator.Reset();
+}
+
+void clang_disposeStringArena(CXStringArena arena) {
+  // Don't leave the calling thread allocating from the disposed arena.
+  if (CurrentStringArena.get() == arena)
+    CurrentStringArena.set(0);
+  delete static_cast<StringArena *>(arena);
+}
+} // end: extern "C"
+
 namespace clang { namespace cxstring {
-CXString createCXString(const char *String, bool DupString){
-  CXString Str;
-  if (DupString) {
-    Str.Spelling = strdup(String);
-    Str.MustFreeString = 1;
+/// CopyString - Copy a string into storage owned by the result: the string
+/// arena of the thread if there is one, or a buffer of its own otherwise.
+static CXString CopyString(llvm::StringRef String) {
+  CXString Result;
+  char *Spelling;
+  if (StringArena *Arena = CurrentStringArena.get()) {
+    Spelling = static_cast<char *>(
+      Arena->Allocator.Allocate(String.size() + 1, 1));
+    Result.MustFreeString = 0;
   } else {
-    Str.Spelling = String;
-    Str.MustFreeString = 0;
+    Spelling = (char *)malloc(String.size() + 1);
+    Result.MustFreeString = 1;
   }
+  memmove(Spelling, String.data(), String.size());
+  Spelling[String.size()] = 0;
+  Result.Spelling = Spelling;
+  return Result;
+}
+
+CXString createCXString(const char *String, bool DupString){
+  if (DupString)
+    return CopyString(String);
+
+  CXString Str;
+  Str.Spelling = String;
+  Str.MustFreeString = 0;
   return Str;
 }
 
 CXString createCXString(llvm::StringRef String, bool DupString) {
+  if (DupString || (!String.empty() && String.data()[String.size()] != 0))
+    return CopyString(String);
+
   CXString Result;
-  if (DupString || (!String.empty() && String.data()[String.size()] != 0)) {
-    char *Spelling = (char *)malloc(String.size() + 1);
-    memmove(Spelling, String.data(), String.size());
-    Spelling[String.size()] = 0;
-    Result.Spelling = Spelling;
-    Result.MustFreeString = 1;
-  } else {
-    Result.Spelling = String.data();
-    Result.MustFreeString = 0;
-  }
+  Result.Spelling = String.data();
+  Result.MustFreeString = 0;
   return Result;
 }
 }}
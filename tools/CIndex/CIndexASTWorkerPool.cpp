@@ -0,0 +1,276 @@
+//===- CIndexASTWorkerPool.cpp - Pool of AST generating processes ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the pool of clang processes that generate ASTs for
+// clang_createTranslationUnitFromSourceFile.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CIndexASTWorkerPool.h"
+#include "CIndexDiagnostic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/DataTypes.h"
+#include <cstdio>
+
+#ifndef LLVM_ON_WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace clang;
+
+#ifndef LLVM_ON_WIN32
+/// \brief Write all of the given data to a worker's socket, without raising
+/// SIGPIPE in the host if the worker has exited.
+static bool WriteAll(int Socket, const char *Data, size_t Size) {
+  while (Size) {
+#ifdef MSG_NOSIGNAL
+    ssize_t Written = ::send(Socket, Data, Size, MSG_NOSIGNAL);
+#else
+    ssize_t Written = ::send(Socket, Data, Size, 0);
+#endif
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    Data += Written;
+    Size -= Written;
+  }
+  return true;
+}
+
+/// \brief Read exactly Size bytes from a worker's socket.
+static bool ReadAll(int Socket, char *Data, size_t Size) {
+  while (Size) {
+    ssize_t Read = ::read(Socket, Data, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      return false;
+    Data += Read;
+    Size -= Read;
+  }
+  return true;
+}
+#endif
+
+ASTWorkerPool::ASTWorkerPool(const llvm::sys::Path &ClangPath)
+  : ClangPath(ClangPath) {
+  Worker W;
+  std::string ErrMsg;
+  if (isSupported() && !Spawn(W, ErrMsg))
+    IdleWorkers.push_back(W);
+}
+
+ASTWorkerPool::~ASTWorkerPool() {
+  for (unsigned I = 0, N = IdleWorkers.size(); I != N; ++I)
+    Terminate(IdleWorkers[I]);
+}
+
+bool ASTWorkerPool::isSupported() {
+#ifdef LLVM_ON_WIN32
+  return false;
+#else
+  return true;
+#endif
+}
+
+bool ASTWorkerPool::Spawn(Worker &W, std::string &ErrMsg) {
+#ifdef LLVM_ON_WIN32
+  ErrMsg = "AST workers are not supported on this host";
+  return true;
+#else
+  int Sockets[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, Sockets)) {
+    ErrMsg = std::string("cannot create the socket of an AST worker: ") +
+             strerror(errno);
+    return true;
+  }
+
+  // Neither end may be inherited by the workers started later, which would
+  // keep this worker from seeing the end of its input.
+  ::fcntl(Sockets[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(Sockets[1], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int One = 1;
+  ::setsockopt(Sockets[0], SOL_SOCKET, SO_NOSIGPIPE, &One, sizeof(One));
+#endif
+
+  // The worker is given the number of its end of the socket, and its standard
+  // streams are pointed at /dev/null, so that nothing the compiler prints can
+  // be taken for an answer.
+  std::string SocketArg = llvm::utostr(Sockets[1]);
+  const char *Argv[] = { ClangPath.c_str(), "-cc1", "-ast-worker",
+                         SocketArg.c_str(), 0 };
+  pid_t Pid = ::fork();
+  if (Pid == 0) {
+    // Other threads of the host may hold locks, so only make async-signal-safe
+    // calls until the exec.
+    int DevNull = ::open("/dev/null", O_RDWR);
+    if (DevNull == -1 || ::dup2(DevNull, 0) == -1 || ::dup2(DevNull, 1) == -1 ||
+        ::dup2(DevNull, 2) == -1 || ::fcntl(Sockets[1], F_SETFD, 0) == -1)
+      ::_exit(127);
+    if (DevNull > 2)
+      ::close(DevNull);
+    ::execv(Argv[0], const_cast<char **>(Argv));
+    ::_exit(127);
+  }
+
+  ::close(Sockets[1]);
+  if (Pid == -1) {
+    ErrMsg = std::string("cannot start an AST worker: ") + strerror(errno);
+    ::close(Sockets[0]);
+    return true;
+  }
+
+  W.Pid = Pid;
+  W.Socket = Sockets[0];
+  return false;
+#endif
+}
+
+void ASTWorkerPool::Terminate(Worker &W) {
+#ifndef LLVM_ON_WIN32
+  // Workers exit at the end of their input.
+  ::close(W.Socket);
+  int Status;
+  while (::waitpid(W.Pid, &Status, 0) == -1 && errno == EINTR)
+    ;
+#endif
+}
+
+bool ASTWorkerPool::Run(const char * const *ArgBegin,
+                        const char * const *ArgEnd,
+                        std::string &Diagnostics, std::string &ErrMsg,
+                        DiagnosticQueue *Queue, unsigned StreamID) {
+#ifdef LLVM_ON_WIN32
+  ErrMsg = "AST workers are not supported on this host";
+  return true;
+#else
+  // A request is the number of strings followed by the NUL-terminated
+  // strings, the driver arguments.
+  std::string Request;
+  uint32_t NumStrings = ArgEnd - ArgBegin;
+  Request.append(reinterpret_cast<const char *>(&NumStrings),
+                 sizeof(NumStrings));
+  for (const char * const *Arg = ArgBegin; Arg != ArgEnd; ++Arg) {
+    Request += *Arg;
+    Request += '\0';
+  }
+
+  // An idle worker may have exited since its last request; that shows when
+  // the request cannot be sent, and the next worker is tried.
+  Worker W;
+  while (true) {
+    bool Fresh = false;
+    {
+      llvm::sys::ScopedLock L(Lock);
+      if (IdleWorkers.empty())
+        Fresh = true;
+      else {
+        W = IdleWorkers.back();
+        IdleWorkers.pop_back();
+      }
+    }
+
+    if (Fresh && Spawn(W, ErrMsg))
+      return true;
+    if (WriteAll(W.Socket, Request.data(), Request.size()))
+      break;
+
+    Terminate(W);
+    if (Fresh) {
+      ErrMsg = "cannot send a request to an AST worker";
+      return true;
+    }
+  }
+
+  // The worker answers with any number of chunks of serialized diagnostics,
+  // each a tag of 1 and its size followed by its bytes, and then with a tag
+  // of 0 and the status of the compilation.
+  bool Answered = false;
+  uint32_t Message[2] = { 0, 0 };
+  while (ReadAll(W.Socket, reinterpret_cast<char *>(Message),
+                 sizeof(Message))) {
+    if (Message[0] == 0) {
+      Answered = true;
+      break;
+    }
+
+    unsigned Start = Diagnostics.size();
+    Diagnostics.resize(Start + Message[1]);
+    if (Message[1] && !ReadAll(W.Socket, &Diagnostics[Start], Message[1])) {
+      Diagnostics.resize(Start);
+      break;
+    }
+    if (Queue)
+      Queue->pushData(StreamID, llvm::StringRef(Diagnostics).substr(Start));
+  }
+
+  if (!Answered) {
+    // The compiler crashed, or the worker could not be executed at all.
+    ::close(W.Socket);
+    int WaitStatus = 0;
+    while (::waitpid(W.Pid, &WaitStatus, 0) == -1 && errno == EINTR)
+      ;
+    if (WIFSIGNALED(WaitStatus))
+      ErrMsg = "AST worker terminated by signal " +
+               llvm::utostr(WTERMSIG(WaitStatus));
+    else
+      ErrMsg = "AST worker exited with status " +
+               llvm::utostr(WEXITSTATUS(WaitStatus));
+    return true;
+  }
+
+  // The worker survives a failed compilation and can serve the next request.
+  uint32_t Status = Message[1];
+  bool Kept = false;
+  {
+    llvm::sys::ScopedLock L(Lock);
+    if (IdleWorkers.size() < MaxIdleWorkers) {
+      IdleWorkers.push_back(W);
+      Kept = true;
+    }
+  }
+  if (!Kept)
+    Terminate(W);
+
+  if (Status) {
+    ErrMsg = "AST worker failed to compile the translation unit (status " +
+             llvm::utostr(Status) + ")";
+    return true;
+  }
+  return false;
+#endif
+}
+
+std::string ASTWorkerPool::getTemporaryASTPath() {
+#ifndef LLVM_ON_WIN32
+  // /dev/shm is memory-backed where it exists: the AST never reaches the
+  // disk, and loading it maps the pages that the worker wrote.
+  llvm::sys::Path P("/dev/shm");
+  if (P.isDirectory()) {
+    P.appendComponent("cindex-ast");
+    if (!P.makeUnique(/*reuse_current=*/false, 0))
+      return P.str();
+  }
+#endif
+
+  char TmpFile[L_tmpnam];
+  if (const char *Name = tmpnam(TmpFile))
+    return Name;
+  return std::string();
+}
@@ -0,0 +1,89 @@
+//===- CIndexASTWorkerPool.h - Pool of AST generating processes -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ASTWorkerPool, the clang processes that generate ASTs for
+// clang_createTranslationUnitFromSourceFile when external AST generation is
+// enabled.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_CINDEXASTWORKERPOOL_H
+#define LLVM_CLANG_CINDEXASTWORKERPOOL_H
+
+#include "llvm/System/Mutex.h"
+#include "llvm/System/Path.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class DiagnosticQueue;
+
+/// \brief A pool of "clang -cc1 -ast-worker" processes.
+///
+/// Each worker is connected to CIndex by a socket on which it reads requests
+/// (the arguments of a driver invocation) and answers with the serialized
+/// diagnostics of the compilation, as they are produced, then its status.  A
+/// worker serves any number of requests, so the cost of starting clang is
+/// paid once per worker rather than once per translation unit, while a crash
+/// of the compiler still only takes down the worker.
+///
+/// Workers write the AST to a file in shared memory when the host provides a
+/// memory-backed temporary directory, see getTemporaryASTPath().
+class ASTWorkerPool {
+  struct Worker {
+    int Pid;
+    int Socket;
+  };
+
+  llvm::sys::Path ClangPath;
+
+  /// \brief Protects IdleWorkers; a worker that is taken out of the pool is
+  /// only used by the thread that took it.
+  llvm::sys::Mutex Lock;
+  std::vector<Worker> IdleWorkers;
+
+  /// \brief The number of idle workers kept for later requests.
+  enum { MaxIdleWorkers = 4 };
+
+  bool Spawn(Worker &W, std::string &ErrMsg);
+  static void Terminate(Worker &W);
+
+public:
+  /// \brief Create a pool of the given clang binary, starting one worker so
+  /// that it is ready by the time the first request is made.
+  explicit ASTWorkerPool(const llvm::sys::Path &ClangPath);
+  ~ASTWorkerPool();
+
+  /// \brief Whether workers can be run on this host; when they cannot, clang
+  /// has to be executed for every translation unit.
+  static bool isSupported();
+
+  /// \brief Run a driver invocation with the given arguments (which do not
+  /// include the name of the program) in a worker.
+  ///
+  /// The serialized diagnostics of the compilation are appended to
+  /// Diagnostics.  If Queue is given, each chunk of them is also pushed onto
+  /// it, with the given stream ID, as soon as the worker sends it.
+  ///
+  /// \returns true, with a message in ErrMsg, if the worker could not be
+  /// started, exited before answering, or answered with the nonzero status of
+  /// a failed compilation.
+  bool Run(const char * const *ArgBegin, const char * const *ArgEnd,
+           std::string &Diagnostics, std::string &ErrMsg,
+           DiagnosticQueue *Queue = 0, unsigned StreamID = 0);
+
+  /// \brief Return the name of a new temporary file for an AST, in shared
+  /// memory when possible.
+  static std::string getTemporaryASTPath();
+};
+
+} // end namespace clang
+
+#endif
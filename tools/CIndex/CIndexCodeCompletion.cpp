@@ -18,6 +18,7 @@
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/System/Program.h"
 
 using namespace clang;
@@ -214,6 +215,40 @@ AllocatedCXCodeCompleteResults::~AllocatedCXCodeCompleteResults() {
     TemporaryFiles[I].eraseFromDisk();
 }
   
+/// \brief Vend the code-completion results serialized in \p Buffer to the
+/// caller, through \p Results, which takes ownership of the buffer.
+static void ReadCodeCompleteResults(AllocatedCXCodeCompleteResults *Results,
+                                    llvm::MemoryBuffer *Buffer) {
+  llvm::SmallVector<CXCompletionResult, 4> CompletionResults;
+  for (const char *Str = Buffer->getBufferStart(),
+                  *StrEnd = Buffer->getBufferEnd();
+       Str < StrEnd;) {
+    unsigned KindValue;
+    if (ReadUnsigned(Str, StrEnd, KindValue))
+      break;
+
+    CodeCompletionString *CCStr 
+      = CodeCompletionString::Deserialize(Str, StrEnd);
+    if (!CCStr)
+      continue;
+
+    if (!CCStr->empty()) {
+      // Vend the code-completion result to the caller.
+      CXCompletionResult Result;
+      Result.CursorKind = (CXCursorKind)KindValue;
+      Result.CompletionString = CCStr;
+      CompletionResults.push_back(Result);
+    }
+  };
+
+  // Allocate the results.
+  Results->Results = new CXCompletionResult [CompletionResults.size()];
+  Results->NumResults = CompletionResults.size();
+  memcpy(Results->Results, CompletionResults.data(),
+         CompletionResults.size() * sizeof(CXCompletionResult));
+  Results->Buffer = Buffer;
+}
+  
 CXCodeCompleteResults *clang_codeComplete(CXIndex CIdx,
                                           const char *source_filename,
                                           int num_command_line_args,
@@ -223,6 +258,24 @@ CXCodeCompleteResults *clang_codeComplete(CXIndex CIdx,
                                           const char *complete_filename,
                                           unsigned complete_line,
                                           unsigned complete_column) {
+  return clang_codeCompleteWithFilter(CIdx, source_filename,
+                                      num_command_line_args,
+                                      command_line_args, num_unsaved_files,
+                                      unsaved_files, complete_filename,
+                                      complete_line, complete_column, 0, 0);
+}
+
+CXCodeCompleteResults *clang_codeCompleteWithFilter(CXIndex CIdx,
+                                          const char *source_filename,
+                                          int num_command_line_args,
+                                          const char **command_line_args,
+                                          unsigned num_unsaved_files,
+                                          struct CXUnsavedFile *unsaved_files,
+                                          const char *complete_filename,
+                                          unsigned complete_line,
+                                          unsigned complete_column,
+                                          const char *prefix,
+                                          unsigned max_results) {
   // The indexer, which is mainly used to determine where diagnostics go.
   CIndexer *CXXIdx = static_cast<CIndexer *>(CIdx);
 
@@ -263,6 +316,21 @@ CXCodeCompleteResults *clang_codeComplete(CXIndex CIdx,
   argv.push_back("-code-completion-macros");
   argv.push_back("-fdiagnostics-binary");
 
+  // Let Sema drop the results the client would filter out.
+  std::string max_results_str = llvm::utostr(max_results);
+  if (prefix && *prefix) {
+    argv.push_back("-Xclang");
+    argv.push_back("-code-completion-prefix");
+    argv.push_back("-Xclang");
+    argv.push_back(prefix);
+  }
+  if (max_results) {
+    argv.push_back("-Xclang");
+    argv.push_back("-code-completion-max-results");
+    argv.push_back("-Xclang");
+    argv.push_back(max_results_str.c_str());
+  }
+
   // Remap any unsaved files to temporary files.
   std::vector<std::string> RemapArgs;
   if (RemapFiles(num_unsaved_files, unsaved_files, RemapArgs, TemporaryFiles))
@@ -334,43 +402,13 @@ CXCodeCompleteResults *clang_codeComplete(CXIndex CIdx,
   }
 
   // Parse the resulting source file to find code-completion results.
-  using llvm::MemoryBuffer;
-  using llvm::StringRef;
   AllocatedCXCodeCompleteResults *Results = new AllocatedCXCodeCompleteResults;
   Results->Results = 0;
   Results->NumResults = 0;
   Results->Buffer = 0;
   // FIXME: Set Results->LangOpts!
-  if (MemoryBuffer *F = MemoryBuffer::getFile(ResultsFile.c_str())) {
-    llvm::SmallVector<CXCompletionResult, 4> CompletionResults;
-    StringRef Buffer = F->getBuffer();
-    for (const char *Str = Buffer.data(), *StrEnd = Str + Buffer.size();
-         Str < StrEnd;) {
-      unsigned KindValue;
-      if (ReadUnsigned(Str, StrEnd, KindValue))
-        break;
-
-      CodeCompletionString *CCStr 
-        = CodeCompletionString::Deserialize(Str, StrEnd);
-      if (!CCStr)
-        continue;
-
-      if (!CCStr->empty()) {
-        // Vend the code-completion result to the caller.
-        CXCompletionResult Result;
-        Result.CursorKind = (CXCursorKind)KindValue;
-        Result.CompletionString = CCStr;
-        CompletionResults.push_back(Result);
-      }
-    };
-
-    // Allocate the results.
-    Results->Results = new CXCompletionResult [CompletionResults.size()];
-    Results->NumResults = CompletionResults.size();
-    memcpy(Results->Results, CompletionResults.data(),
-           CompletionResults.size() * sizeof(CXCompletionResult));
-    Results->Buffer = F;
-  }
+  if (llvm::MemoryBuffer *F = llvm::MemoryBuffer::getFile(ResultsFile.c_str()))
+    ReadCodeCompleteResults(Results, F);
 
   LoadSerializedDiagnostics(DiagnosticsFile, num_unsaved_files, unsaved_files,
                             Results->FileMgr, Results->SourceMgr, 
@@ -383,6 +421,74 @@ CXCodeCompleteResults *clang_codeComplete(CXIndex CIdx,
   return Results;
 }
 
+CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
+                                            const char *complete_filename,
+                                            unsigned complete_line,
+                                            unsigned complete_column,
+                                           struct CXUnsavedFile *unsaved_files,
+                                            unsigned num_unsaved_files) {
+  return clang_codeCompleteAtWithFilter(TU, complete_filename, complete_line,
+                                        complete_column, unsaved_files,
+                                        num_unsaved_files, 0, 0);
+}
+
+CXCodeCompleteResults *clang_codeCompleteAtWithFilter(CXTranslationUnit TU,
+                                            const char *complete_filename,
+                                            unsigned complete_line,
+                                            unsigned complete_column,
+                                           struct CXUnsavedFile *unsaved_files,
+                                            unsigned num_unsaved_files,
+                                            const char *prefix,
+                                            unsigned max_results) {
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
+  if (!CXXUnit || !complete_filename)
+    return 0;
+
+  // Configure the diagnostics.
+  DiagnosticOptions DiagOpts;
+  llvm::OwningPtr<Diagnostic> Diags;
+  Diags.reset(CompilerInstance::createDiagnostics(DiagOpts, 0, 0));
+
+  // The source manager of the results owns the remapped buffers, so they
+  // outlive the caller's copies of the unsaved files.
+  llvm::SmallVector<ASTUnit::RemappedFile, 4> RemappedFiles;
+  for (unsigned I = 0; I != num_unsaved_files; ++I) {
+    const llvm::MemoryBuffer *Buffer
+      = llvm::MemoryBuffer::getMemBufferCopy(unsaved_files[I].Contents,
+                          unsaved_files[I].Contents + unsaved_files[I].Length,
+                                             unsaved_files[I].Filename);
+    RemappedFiles.push_back(std::make_pair(unsaved_files[I].Filename,
+                                           Buffer));
+  }
+
+  AllocatedCXCodeCompleteResults *Results = new AllocatedCXCodeCompleteResults;
+  Results->Results = 0;
+  Results->NumResults = 0;
+  Results->Buffer = 0;
+  Results->LangOpts = CXXUnit->getASTContext().getLangOptions();
+
+  std::string Output;
+  llvm::raw_string_ostream OS(Output);
+  CIndexCodeCompleteConsumer Consumer(/*IncludeMacros=*/true, OS);
+  Consumer.setResultFilter(prefix ? prefix : "", max_results);
+  if (!CXXUnit->CodeComplete(complete_filename, complete_line,
+                             complete_column, RemappedFiles.data(),
+                             RemappedFiles.size(), Consumer, *Diags,
+                             Results->FileMgr, Results->SourceMgr,
+                             Results->Diagnostics)) {
+    for (unsigned I = 0, N = RemappedFiles.size(); I != N; ++I)
+      delete RemappedFiles[I].second;
+    delete Results;
+    return 0;
+  }
+
+  OS.flush();
+  ReadCodeCompleteResults(Results,
+                          llvm::MemoryBuffer::getMemBufferCopy(Output.data(),
+                                                 Output.data() + Output.size()));
+  return Results;
+}
+
 void clang_disposeCodeCompleteResults(CXCodeCompleteResults *ResultsIn) {
   if (!ResultsIn)
     return;
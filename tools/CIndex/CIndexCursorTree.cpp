@@ -0,0 +1,196 @@
+//===- CIndexCursorTree.cpp - Clang-C Source Indexing Library -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements clang_exportCursorTree(), which gathers a whole cursor
+// subtree into one flat buffer for clients that pay for every call into
+// CIndex.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CIndexer.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+/// CursorTree - The layout of an exported tree.  The nodes and then the
+/// string table follow this header in the same allocation.
+struct CursorTree {
+  unsigned NumNodes;
+  unsigned StringsSize;
+
+  CXCursorTreeNode *getNodes() {
+    return reinterpret_cast<CXCursorTreeNode *>(this + 1);
+  }
+
+  char *getStrings() {
+    return reinterpret_cast<char *>(getNodes() + NumNodes);
+  }
+};
+
+class CursorTreeBuilder {
+  /// Parents - The cursors whose children are being visited and the indices
+  /// of their nodes, innermost last.
+  std::vector<std::pair<CXCursor, unsigned> > Parents;
+
+  /// StringOffsets - The offset of each string in Strings.
+  llvm::StringMap<unsigned> StringOffsets;
+
+  /// FileOffsets - The offset of the name of each file in Strings.
+  llvm::DenseMap<CXFile, unsigned> FileOffsets;
+
+  unsigned addString(llvm::StringRef Str);
+  unsigned addString(CXString Str);
+  unsigned addFile(CXFile File);
+
+public:
+  std::vector<CXCursorTreeNode> Nodes;
+  std::string Strings;
+
+  /// Start the tree at the given cursor, with no parent.
+  explicit CursorTreeBuilder(CXCursor Root) : Strings(1, '\0') {
+    Parents.push_back(std::make_pair(Root, addNode(Root, ~0U)));
+  }
+
+  unsigned addNode(CXCursor Cursor, unsigned Parent);
+
+  /// Visit - Add a cursor visited by clang_visitChildren().
+  void Visit(CXCursor Cursor, CXCursor Parent) {
+    // Cursors are visited depth-first, so the parent is on the stack.
+    while (!clang_equalCursors(Parents.back().first, Parent))
+      Parents.pop_back();
+    Parents.push_back(std::make_pair(Cursor,
+                                     addNode(Cursor, Parents.back().second)));
+  }
+};
+} // end anonymous namespace
+
+unsigned CursorTreeBuilder::addString(llvm::StringRef Str) {
+  if (Str.empty())
+    return 0;
+
+  unsigned &Offset = StringOffsets[Str];
+  if (!Offset) {
+    Offset = Strings.size();
+    Strings.append(Str.begin(), Str.end());
+    Strings.push_back('\0');
+  }
+  return Offset;
+}
+
+unsigned CursorTreeBuilder::addString(CXString Str) {
+  const char *CStr = clang_getCString(Str);
+  unsigned Offset = addString(llvm::StringRef(CStr ? CStr : ""));
+  clang_disposeString(Str);
+  return Offset;
+}
+
+unsigned CursorTreeBuilder::addFile(CXFile File) {
+  if (!File)
+    return 0;
+
+  llvm::DenseMap<CXFile, unsigned>::iterator Pos = FileOffsets.find(File);
+  if (Pos != FileOffsets.end())
+    return Pos->second;
+
+  unsigned Offset = addString(clang_getFileName(File));
+  FileOffsets[File] = Offset;
+  return Offset;
+}
+
+unsigned CursorTreeBuilder::addNode(CXCursor Cursor, unsigned Parent) {
+  CXCursorTreeNode Node;
+  Node.kind = Cursor.kind;
+  Node.parent = Parent;
+  // Only declarations have USRs; the USR of any other cursor would be that
+  // of the declaration it is found in.
+  Node.usr = clang_isDeclaration(Cursor.kind) ?
+    addString(clang_getCursorUSR(Cursor)) : 0;
+  Node.spelling = addString(clang_getCursorSpelling(Cursor));
+
+  CXSourceRange Extent = clang_getCursorExtent(Cursor);
+  CXFile File, EndFile;
+  clang_getInstantiationLocation(clang_getRangeStart(Extent), &File,
+                                 &Node.begin_line, &Node.begin_column,
+                                 &Node.begin_offset);
+  clang_getInstantiationLocation(clang_getRangeEnd(Extent), &EndFile,
+                                 &Node.end_line, &Node.end_column,
+                                 &Node.end_offset);
+  Node.file = addFile(File);
+
+  Nodes.push_back(Node);
+  return Nodes.size() - 1;
+}
+
+static enum CXChildVisitResult CursorTreeVisitor(CXCursor Cursor,
+                                                 CXCursor Parent,
+                                                 CXClientData ClientData) {
+  static_cast<CursorTreeBuilder *>(ClientData)->Visit(Cursor, Parent);
+  return CXChildVisit_Recurse;
+}
+
+extern "C" {
+
+CXCursorTree clang_exportCursorTree(CXCursor Root) {
+  if (clang_equalCursors(Root, clang_getNullCursor()))
+    return 0;
+
+  // The strings of each cursor are copied into the tree right away, so carve
+  // them from a scratch arena instead of allocating and freeing each one.
+  CXStringArena Scratch = clang_createStringArena();
+  CXStringArena Previous = clang_setStringArena(Scratch);
+  CursorTreeBuilder Builder(Root);
+  clang_visitChildren(Root, CursorTreeVisitor, &Builder);
+  clang_setStringArena(Previous);
+  clang_disposeStringArena(Scratch);
+
+  // Copy the tree into a single buffer, so that it is freed in one go and
+  // clients can map it without further calls.
+  unsigned NumNodes = Builder.Nodes.size();
+  unsigned StringsSize = Builder.Strings.size();
+  CursorTree *Tree = static_cast<CursorTree *>(
+    malloc(sizeof(CursorTree) + NumNodes * sizeof(CXCursorTreeNode) +
+           StringsSize));
+  Tree->NumNodes = NumNodes;
+  Tree->StringsSize = StringsSize;
+  memcpy(Tree->getNodes(), &Builder.Nodes[0],
+         NumNodes * sizeof(CXCursorTreeNode));
+  memcpy(Tree->getStrings(), Builder.Strings.data(), StringsSize);
+  return Tree;
+}
+
+unsigned clang_getCursorTreeNumNodes(CXCursorTree Tree) {
+  return Tree ? static_cast<CursorTree *>(Tree)->NumNodes : 0;
+}
+
+const CXCursorTreeNode *clang_getCursorTreeNodes(CXCursorTree Tree) {
+  return Tree ? static_cast<CursorTree *>(Tree)->getNodes() : 0;
+}
+
+const char *clang_getCursorTreeStrings(CXCursorTree Tree, unsigned *Size) {
+  if (!Tree) {
+    if (Size)
+      *Size = 0;
+    return 0;
+  }
+
+  CursorTree *T = static_cast<CursorTree *>(Tree);
+  if (Size)
+    *Size = T->StringsSize;
+  return T->getStrings();
+}
+
+void clang_disposeCursorTree(CXCursorTree Tree) {
+  free(Tree);
+}
+
+} // end extern "C"
@@ -15,8 +15,15 @@
 #include "CXSourceLocation.h"
 
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/SerializedDiagnostics.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Config/config.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if defined(_MSC_VER) && LLVM_MULTITHREADED!=0
+#include <windows.h>
+#endif
 
 using namespace clang;
 using namespace clang::cxloc;
@@ -255,6 +262,32 @@ CXString clang_getDiagnosticFixItReplacement(CXDiagnostic Diag,
   return createCXString(Hint.CodeToInsert);
 }
 
+CXDiagnosticQueue clang_createDiagnosticQueue(void) {
+  return new DiagnosticQueue;
+}
+
+void clang_disposeDiagnosticQueue(CXDiagnosticQueue Queue) {
+  delete static_cast<DiagnosticQueue *>(Queue);
+}
+
+void clang_setDiagnosticQueue(CXIndex CIdx, CXDiagnosticQueue Queue) {
+  if (CIdx) {
+    CIndexer *CXXIdx = static_cast<CIndexer *>(CIdx);
+    CXXIdx->setDiagnosticQueue(static_cast<DiagnosticQueue *>(Queue));
+  }
+}
+
+CXDiagnostic clang_takeQueuedDiagnostic(CXDiagnosticQueue Queue) {
+  DiagnosticQueue *DQ = static_cast<DiagnosticQueue *>(Queue);
+  if (!DQ)
+    return 0;
+
+  const StoredDiagnostic *Diag = DQ->take();
+  if (!Diag)
+    return 0;
+  return new CXStoredDiagnostic(*Diag, DQ->getLangOptions());
+}
+
 } // end extern "C"
 
 void clang::LoadSerializedDiagnostics(const llvm::sys::Path &DiagnosticsPath,
@@ -264,11 +297,23 @@ void clang::LoadSerializedDiagnostics(const llvm::sys::Path &DiagnosticsPath,
                                       SourceManager &SourceMgr,
                                      SmallVectorImpl<StoredDiagnostic> &Diags) {
   using llvm::MemoryBuffer;
-  using llvm::StringRef;
   MemoryBuffer *F = MemoryBuffer::getFile(DiagnosticsPath.c_str());
   if (!F)
     return;
 
+  LoadSerializedDiagnostics(F->getBuffer(), num_unsaved_files, unsaved_files,
+                            FileMgr, SourceMgr, Diags);
+  delete F;
+}
+
+void clang::LoadSerializedDiagnostics(llvm::StringRef Buffer,
+                                      unsigned num_unsaved_files,
+                                      struct CXUnsavedFile *unsaved_files,
+                                      FileManager &FileMgr,
+                                      SourceManager &SourceMgr,
+                                     SmallVectorImpl<StoredDiagnostic> &Diags) {
+  using llvm::MemoryBuffer;
+
   // Enter the unsaved files into the file manager.
   for (unsigned I = 0; I != num_unsaved_files; ++I) {
     const FileEntry *File = FileMgr.getVirtualFile(unsaved_files[I].Filename,
@@ -279,32 +324,170 @@ void clang::LoadSerializedDiagnostics(const llvm::sys::Path &DiagnosticsPath,
       Diags.push_back(StoredDiagnostic(Diagnostic::Fatal,
                             (Twine("could not remap from missing file ") +
                                    unsaved_files[I].Filename).str()));
-      delete F;
       return;
     }
 
-    MemoryBuffer *Buffer
+    MemoryBuffer *Contents
       = MemoryBuffer::getMemBuffer(unsaved_files[I].Contents,
                            unsaved_files[I].Contents + unsaved_files[I].Length);
-    if (!Buffer) {
-      delete F;
+    if (!Contents)
       return;
-    }
     
-    SourceMgr.overrideFileContents(File, Buffer);
+    SourceMgr.overrideFileContents(File, Contents);
   }
 
-  // Parse the diagnostics, emitting them one by one until we've
-  // exhausted the data.
-  StringRef Buffer = F->getBuffer();
-  const char *Memory = Buffer.data(), *MemoryEnd = Memory + Buffer.size();
-  while (Memory != MemoryEnd) {
-    StoredDiagnostic Stored = StoredDiagnostic::Deserialize(FileMgr, SourceMgr,
-                                                            Memory, MemoryEnd);
-    if (!Stored)
+  // Parse the diagnostics.  A truncated stream still yields the diagnostics
+  // that were written out before the compiler stopped.
+  ReadSerializedDiagnostics(Buffer, FileMgr, SourceMgr, Diags);
+}
+
+//-----------------------------------------------------------------------------
+// Diagnostic queue
+//-----------------------------------------------------------------------------
+
+/// CompareAndSwapPointer - Replace *Ptr with New if it is Old, atomically.
+/// Returns true if it was replaced.
+static bool CompareAndSwapPointer(void *volatile *Ptr, void *New, void *Old) {
+#if LLVM_MULTITHREADED==0
+  if (*Ptr != Old)
+    return false;
+  *Ptr = New;
+  return true;
+#elif defined(__GNUC__)
+  return __sync_bool_compare_and_swap(Ptr, Old, New);
+#elif defined(_MSC_VER)
+  return InterlockedCompareExchangePointer(Ptr, New, Old) == Old;
+#else
+#  error No compare-and-swap implementation for your platform!
+#endif
+}
+
+DiagnosticQueue::DiagnosticQueue() : Head(0), LastStreamID(0), NextDiag(0) {}
+
+DiagnosticQueue::~DiagnosticQueue() {
+  for (Chunk *C = Head; C; ) {
+    Chunk *Next = C->Next;
+    delete C;
+    C = Next;
+  }
+  for (llvm::DenseMap<unsigned, SerializedDiagnosticStreamReader *>::iterator
+         R = Readers.begin(), REnd = Readers.end(); R != REnd; ++R)
+    delete R->second;
+}
+
+void DiagnosticQueue::Push(unsigned StreamID, ChunkKind Kind,
+                           llvm::StringRef Name, llvm::StringRef Bytes) {
+  Chunk *C = new Chunk;
+  C->StreamID = StreamID;
+  C->Kind = Kind;
+  C->Name = Name;
+  C->Bytes = Bytes;
+  do
+    C->Next = Head;
+  while (!CompareAndSwapPointer(reinterpret_cast<void *volatile *>(&Head),
+                                C, C->Next));
+}
+
+/// ReadChunks - Take all of the chunks pushed so far and read the
+/// diagnostics they complete.  Returns false if there were none.
+bool DiagnosticQueue::ReadChunks() {
+  Chunk *List;
+  do
+    List = Head;
+  while (List &&
+         !CompareAndSwapPointer(reinterpret_cast<void *volatile *>(&Head),
+                                0, List));
+  if (!List)
+    return false;
+
+  // The chunks were pushed onto the front of the list; read them in the
+  // order they were pushed.
+  Chunk *Reversed = 0;
+  while (List) {
+    Chunk *Next = List->Next;
+    List->Next = Reversed;
+    Reversed = List;
+    List = Next;
+  }
+
+  llvm::SmallVector<StoredDiagnostic, 4> NewDiags;
+  for (Chunk *C = Reversed; C; ) {
+    switch (C->Kind) {
+    case CK_UnsavedFile:
+      // Files that several streams remap get the contents pushed last.
+      if (const FileEntry *File = FileMgr.getVirtualFile(C->Name,
+                                                         C->Bytes.size(), 0))
+        SourceMgr.overrideFileContents(File,
+                          llvm::MemoryBuffer::getMemBufferCopy(C->Bytes.data(),
+                                         C->Bytes.data() + C->Bytes.size()));
       break;
 
-    Diags.push_back(Stored);
+    case CK_Data: {
+      SerializedDiagnosticStreamReader *&Reader = Readers[C->StreamID];
+      if (!Reader)
+        Reader = new SerializedDiagnosticStreamReader(FileMgr, SourceMgr);
+      NewDiags.clear();
+      Reader->Append(C->Bytes, NewDiags);
+      Diags.insert(Diags.end(), NewDiags.begin(), NewDiags.end());
+      break;
+    }
+
+    case CK_End:
+      delete Readers.lookup(C->StreamID);
+      Readers.erase(C->StreamID);
+      break;
+    }
+
+    Chunk *Next = C->Next;
+    delete C;
+    C = Next;
   }
-  delete F;
+  return true;
+}
+
+const StoredDiagnostic *DiagnosticQueue::take() {
+  while (NextDiag == Diags.size())
+    if (!ReadChunks())
+      return 0;
+  return &Diags[NextDiag++];
+}
+
+namespace {
+/// QueueDiagnosticClient - Serializes the diagnostics it is shown and pushes
+/// each of them onto a DiagnosticQueue as soon as it is complete.
+class QueueDiagnosticClient : public DiagnosticClient {
+  DiagnosticQueue &Queue;
+  unsigned StreamID;
+  std::string Data;
+  llvm::raw_string_ostream OS;
+  SerializedDiagnosticPrinter Printer;
+
+public:
+  QueueDiagnosticClient(DiagnosticQueue &Queue, unsigned num_unsaved_files,
+                        struct CXUnsavedFile *unsaved_files)
+    : Queue(Queue), StreamID(Queue.createStream()), OS(Data),
+      Printer(OS, /*Streaming=*/true) {
+    for (unsigned I = 0; I != num_unsaved_files; ++I)
+      Queue.pushUnsavedFile(StreamID, unsaved_files[I]);
+  }
+
+  ~QueueDiagnosticClient() {
+    Queue.pushEnd(StreamID);
+  }
+
+  virtual void HandleDiagnostic(Diagnostic::Level Level,
+                                const DiagnosticInfo &Info) {
+    Printer.HandleDiagnostic(Level, Info);
+    OS.flush();
+    Queue.pushData(StreamID, Data);
+    Data.clear();
+  }
+};
+} // end anonymous namespace
+
+DiagnosticClient *
+clang::createQueueDiagnosticClient(DiagnosticQueue &Queue,
+                                   unsigned num_unsaved_files,
+                                   struct CXUnsavedFile *unsaved_files) {
+  return new QueueDiagnosticClient(Queue, num_unsaved_files, unsaved_files);
 }
@@ -15,8 +15,15 @@
 
 #include "clang-c/Index.h"
 #include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
 #include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/Atomic.h"
+#include <deque>
+#include <string>
 
 namespace llvm { namespace sys {
 class Path;
@@ -27,6 +34,7 @@ namespace clang {
 class Diagnostic;
 class LangOptions;
 class Preprocessor;
+class SerializedDiagnosticStreamReader;
 
 /// \brief The storage behind a CXDiagnostic
 struct CXStoredDiagnostic {
@@ -47,6 +55,113 @@ void LoadSerializedDiagnostics(const llvm::sys::Path &DiagnosticsPath,
                                SourceManager &SourceMgr,
                                llvm::SmallVectorImpl<StoredDiagnostic> &Diags);
 
+/// \brief Load the binary, serialized diagnostics in \p Buffer, as produced
+/// by Clang.
+void LoadSerializedDiagnostics(llvm::StringRef Buffer,
+                               unsigned num_unsaved_files,
+                               struct CXUnsavedFile *unsaved_files,
+                               FileManager &FileMgr,
+                               SourceManager &SourceMgr,
+                               llvm::SmallVectorImpl<StoredDiagnostic> &Diags);
+
+/// \brief The storage behind a CXDiagnosticQueue.
+///
+/// The translation units parsed on any number of threads stream their
+/// serialized diagnostics onto the queue as they are produced.  Producers
+/// push chunks of the streams onto a list with compare-and-swap, without
+/// taking a lock; the one consumer takes the whole list at once and reads
+/// the diagnostics back in the order their chunks were pushed.
+class DiagnosticQueue {
+  enum ChunkKind {
+    /// \brief The contents of an unsaved file that the locations of the
+    /// stream refer to.
+    CK_UnsavedFile,
+
+    /// \brief The next bytes of the stream.
+    CK_Data,
+
+    /// \brief The end of the stream.
+    CK_End
+  };
+
+  struct Chunk {
+    Chunk *Next;
+    unsigned StreamID;
+    ChunkKind Kind;
+    std::string Name;
+    std::string Bytes;
+  };
+
+  /// \brief The chunks pushed and not taken yet, the last one first.
+  Chunk *volatile Head;
+
+  volatile llvm::sys::cas_flag LastStreamID;
+
+  // The consumer's state; only the thread taking diagnostics touches it.
+  FileManager FileMgr;
+  SourceManager SourceMgr;
+  // FIXME: Faked LangOpts!
+  LangOptions LangOpts;
+  llvm::DenseMap<unsigned, SerializedDiagnosticStreamReader *> Readers;
+
+  /// \brief The diagnostics read so far.  They are kept until the queue is
+  /// destroyed, since the CXDiagnostics handed out refer to them.
+  std::deque<StoredDiagnostic> Diags;
+  unsigned NextDiag;
+
+  void Push(unsigned StreamID, ChunkKind Kind, llvm::StringRef Name,
+            llvm::StringRef Bytes);
+  bool ReadChunks();
+
+  DiagnosticQueue(const DiagnosticQueue &); // DO NOT IMPLEMENT
+  void operator=(const DiagnosticQueue &); // DO NOT IMPLEMENT
+
+public:
+  DiagnosticQueue();
+  ~DiagnosticQueue();
+
+  /// \brief Start a new stream of serialized diagnostics.
+  ///
+  /// \returns the ID that the chunks of the stream are pushed with.
+  unsigned createStream() {
+    return llvm::sys::AtomicIncrement(&LastStreamID);
+  }
+
+  /// \brief Record the contents of an unsaved file that locations of the
+  /// given stream refer to, before they are pushed.
+  void pushUnsavedFile(unsigned StreamID, const CXUnsavedFile &File) {
+    Push(StreamID, CK_UnsavedFile, File.Filename,
+         llvm::StringRef(File.Contents, File.Length));
+  }
+
+  /// \brief Push the next bytes of the given stream.
+  void pushData(unsigned StreamID, llvm::StringRef Bytes) {
+    Push(StreamID, CK_Data, llvm::StringRef(), Bytes);
+  }
+
+  /// \brief Mark the end of the given stream.
+  void pushEnd(unsigned StreamID) {
+    Push(StreamID, CK_End, llvm::StringRef(), llvm::StringRef());
+  }
+
+  /// \brief Take the next diagnostic pushed onto the queue.  Only one
+  /// thread at a time may take diagnostics.
+  ///
+  /// \returns the diagnostic, which lives as long as the queue, or null if
+  /// no complete diagnostic has been pushed since the last one taken.
+  const StoredDiagnostic *take();
+
+  const LangOptions &getLangOptions() const { return LangOpts; }
+};
+
+/// \brief Create a diagnostic client that streams the diagnostics it is
+/// shown onto \p Queue, as a stream of its own whose locations may refer
+/// to the given unsaved files.  The end of the stream is pushed when the
+/// client is destroyed.
+DiagnosticClient *createQueueDiagnosticClient(DiagnosticQueue &Queue,
+                                              unsigned num_unsaved_files,
+                                          struct CXUnsavedFile *unsaved_files);
+
 } // end namespace clang
 
 #endif // LLVM_CLANG_CINDEX_DIAGNOSTIC_H
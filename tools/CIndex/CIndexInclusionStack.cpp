@@ -17,16 +17,40 @@
 #include "clang/AST/DeclVisitor.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/raw_ostream.h"
+#include <vector>
 
-extern "C" {
-void clang_getInclusions(CXTranslationUnit TU, CXInclusionVisitor CB,
-                         CXClientData clientData) {
-  
-  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
+namespace {
+/// \brief The files of a translation unit and the stack of locations each
+/// was included from, so that clang_getInclusions() does not rebuild the
+/// stacks on every call.
+///
+/// The stacks of all the files are stored one after the other in a single
+/// vector.  The graph is kept with the ASTUnit, which drops it when the
+/// translation unit is reparsed.
+class InclusionGraph : public ASTUnitClientData {
+public:
+  /// \brief The key of the graph in the client data of an ASTUnit.
+  static char Key;
+
+  struct Inclusion {
+    const FileEntry *File;
+
+    /// \brief The range of Locations holding the inclusion stack of File.
+    unsigned StackBegin, StackEnd;
+  };
+
+  std::vector<Inclusion> Inclusions;
+  std::vector<CXSourceLocation> Locations;
+};
+}
+
+char InclusionGraph::Key;
+
+static InclusionGraph *BuildInclusionGraph(ASTUnit *CXXUnit) {
   SourceManager &SM = CXXUnit->getSourceManager();
   ASTContext &Ctx = CXXUnit->getASTContext();
+  InclusionGraph *Graph = new InclusionGraph;
 
-  llvm::SmallVector<CXSourceLocation, 10> InclusionStack;
   unsigned i = SM.sloc_loaded_entry_size();
   unsigned n =  SM.sloc_entry_size();
 
@@ -35,31 +59,59 @@ void clang_getInclusions(CXTranslationUnit TU, CXInclusionVisitor CB,
   // at the inclusion stack of an AST/PCH file.
   if (i >= n)
     i = 0;
-  
+
   for ( ; i < n ; ++i) {
 
     const SrcMgr::SLocEntry &SL = SM.getSLocEntry(i);
-    
+
     if (!SL.isFile())
       continue;
 
     const SrcMgr::FileInfo &FI = SL.getFile();
     if (!FI.getContentCache()->Entry)
       continue;
-    
+
     // Build the inclusion stack.
+    InclusionGraph::Inclusion Inc;
+    Inc.File = FI.getContentCache()->Entry;
+    Inc.StackBegin = Graph->Locations.size();
     SourceLocation L = FI.getIncludeLoc();
-    InclusionStack.clear();
     while (L.isValid()) {
       PresumedLoc PLoc = SM.getPresumedLoc(L);
-      InclusionStack.push_back(cxloc::translateSourceLocation(Ctx, L));
+      Graph->Locations.push_back(cxloc::translateSourceLocation(Ctx, L));
       L = PLoc.getIncludeLoc();
     }
-            
-    // Callback to the client.
+    Inc.StackEnd = Graph->Locations.size();
+    Graph->Inclusions.push_back(Inc);
+  }
+
+  return Graph;
+}
+
+extern "C" {
+void clang_getInclusions(CXTranslationUnit TU, CXInclusionVisitor CB,
+                         CXClientData clientData) {
+  
+  ASTUnit *CXXUnit = static_cast<ASTUnit *>(TU);
+  InclusionGraph *Graph
+    = static_cast<InclusionGraph *>(CXXUnit->getClientData(
+                                                        &InclusionGraph::Key));
+  if (!Graph) {
+    Graph = BuildInclusionGraph(CXXUnit);
+    CXXUnit->setClientData(&InclusionGraph::Key, Graph);
+  }
+
+  for (unsigned i = 0, e = Graph->Inclusions.size(); i != e; ++i) {
+    const InclusionGraph::Inclusion &Inc = Graph->Inclusions[i];
+
+    // Callback to the client.  The visitor takes a non-const stack, so hand
+    // it a copy rather than the graph's own locations.
     // FIXME: We should have a function to construct CXFiles.
-    CB((CXFile) FI.getContentCache()->Entry, 
-       InclusionStack.data(), InclusionStack.size(), clientData);
-  }    
+    llvm::SmallVector<CXSourceLocation, 10> InclusionStack(
+                                   Graph->Locations.begin() + Inc.StackBegin,
+                                   Graph->Locations.begin() + Inc.StackEnd);
+    CB((CXFile) Inc.File, InclusionStack.data(), InclusionStack.size(),
+       clientData);
+  }
 }
 } // end extern C
@@ -0,0 +1,552 @@
+//===- CIndexSymbolIndex.cpp - Clang-C Source Indexing Library ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the on-disk symbol index, which maps USRs to the
+// declarations, definitions and references of the entities they name.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CIndexer.h"
+#include "CXCursor.h"
+#include "clang/AST/DeclBase.h"
+#include "clang/Basic/AtomicOutputFile.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include <algorithm>
+
+using namespace clang::io;
+
+//===----------------------------------------------------------------------===//
+// On-disk hash table traits.
+//===----------------------------------------------------------------------===//
+//
+// The symbol index file is laid out as follows:
+//
+//   "cfe-syi" <version:32>
+//   <hash table payload> <hash table buckets> <file table>
+//   <number of files:32> <file table offset:32> <bucket table offset:32>
+//
+// Keys are USRs.  The data of a key is the list of its occurrences, each a
+// kind:8, a file index:32 and an offset:32 into that file.  The file table
+// lists, for each file index, the modification time:64 the file had when it
+// was indexed and its name:16 length-prefixed and NUL-terminated.
+
+namespace {
+enum { SymbolIndexVersion = 1, OccurrenceSize = 1 + 4 + 4 };
+
+struct SymbolOccurrence {
+  unsigned Kind, File, Offset;
+
+  SymbolOccurrence(unsigned Kind, unsigned File, unsigned Offset)
+    : Kind(Kind), File(File), Offset(Offset) {}
+
+  bool operator<(const SymbolOccurrence &RHS) const {
+    if (File != RHS.File)
+      return File < RHS.File;
+    if (Offset != RHS.Offset)
+      return Offset < RHS.Offset;
+    return Kind < RHS.Kind;
+  }
+
+  bool operator==(const SymbolOccurrence &RHS) const {
+    return Kind == RHS.Kind && File == RHS.File && Offset == RHS.Offset;
+  }
+};
+
+class SymbolIndexLookupTrait {
+public:
+  typedef llvm::StringRef external_key_type;
+  typedef llvm::StringRef internal_key_type;
+
+  /// The first occurrence of the symbol and the number of occurrences.
+  typedef std::pair<const unsigned char *, unsigned> data_type;
+
+  static unsigned ComputeHash(llvm::StringRef USR) {
+    return llvm::HashString(USR);
+  }
+
+  static const internal_key_type &GetInternalKey(const external_key_type &K) {
+    return K;
+  }
+
+  static bool EqualKey(const internal_key_type &A, const internal_key_type &B){
+    return A == B;
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    unsigned KeyLen = ReadUnalignedLE16(d);
+    unsigned DataLen = ReadUnalignedLE32(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    return llvm::StringRef((const char*) d, n);
+  }
+
+  static data_type ReadData(const internal_key_type &, const unsigned char *d,
+                            unsigned n) {
+    return std::make_pair(d, n / OccurrenceSize);
+  }
+};
+
+class SymbolIndexWriterTrait {
+public:
+  typedef llvm::StringRef key_type;
+  typedef key_type key_type_ref;
+  typedef const std::vector<SymbolOccurrence> *data_type;
+  typedef data_type data_type_ref;
+
+  static unsigned ComputeHash(llvm::StringRef USR) {
+    return llvm::HashString(USR);
+  }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(llvm::raw_ostream &Out, key_type_ref USR,
+                    data_type_ref Occurrences) {
+    unsigned DataLen = Occurrences->size() * OccurrenceSize;
+    Emit16(Out, USR.size());
+    Emit32(Out, DataLen);
+    return std::make_pair(USR.size(), DataLen);
+  }
+
+  static void EmitKey(llvm::raw_ostream &Out, key_type_ref USR, unsigned) {
+    Out.write(USR.data(), USR.size());
+  }
+
+  static void EmitData(llvm::raw_ostream &Out, key_type_ref,
+                       data_type_ref Occurrences, unsigned) {
+    for (unsigned i = 0, e = Occurrences->size(); i != e; ++i) {
+      Emit8(Out, (*Occurrences)[i].Kind);
+      Emit32(Out, (*Occurrences)[i].File);
+      Emit32(Out, (*Occurrences)[i].Offset);
+    }
+  }
+};
+} // end anonymous namespace
+
+typedef clang::OnDiskChainedHashTable<SymbolIndexLookupTrait> SymbolIndexTable;
+
+static SymbolOccurrence ReadOccurrence(const unsigned char *&d) {
+  unsigned Kind = *d++;
+  unsigned File = ReadUnalignedLE32(d);
+  unsigned Offset = ReadUnalignedLE32(d);
+  return SymbolOccurrence(Kind, File, Offset);
+}
+
+//===----------------------------------------------------------------------===//
+// Writing symbol indexes.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// SymbolIndexBuilder - Collects the occurrences of symbols in memory and
+/// writes them out as a symbol index file.
+class SymbolIndexBuilder {
+  llvm::StringMap<unsigned> FileIDs;
+  std::vector<std::pair<std::string, uint64_t> > Files;
+  llvm::StringMap<std::vector<SymbolOccurrence> > Symbols;
+
+public:
+  /// getFileID - Return the index of the file named \arg Name, which was
+  /// last modified at \arg ModTime.
+  unsigned getFileID(llvm::StringRef Name, uint64_t ModTime) {
+    llvm::StringMapEntry<unsigned> &Entry =
+      FileIDs.GetOrCreateValue(Name, Files.size());
+    if (Entry.getValue() == Files.size())
+      Files.push_back(std::make_pair(Name.str(), ModTime));
+    return Entry.getValue();
+  }
+
+  void addOccurrence(llvm::StringRef USR, unsigned Kind, unsigned File,
+                     unsigned Offset) {
+    // USRs are written with a 16-bit length.
+    if (USR.size() > 0xFFFF)
+      return;
+    Symbols[USR].push_back(SymbolOccurrence(Kind, File, Offset));
+  }
+
+  /// Write - Write the symbol index to \arg Path.  Returns true on error.
+  bool Write(llvm::StringRef Path);
+};
+
+/// CompareFileNames - Orders file indices by the names of their files.
+class CompareFileNames {
+  const std::vector<std::pair<std::string, uint64_t> > &Files;
+public:
+  explicit CompareFileNames(
+                    const std::vector<std::pair<std::string, uint64_t> > &F)
+    : Files(F) {}
+
+  bool operator()(unsigned LHS, unsigned RHS) const {
+    return Files[LHS].first < Files[RHS].first;
+  }
+};
+} // end anonymous namespace
+
+bool SymbolIndexBuilder::Write(llvm::StringRef Path) {
+  // Number the files in the order of their names and sort the occurrences of
+  // each symbol, so that the same symbols produce the same file no matter in
+  // which order they were found.
+  std::vector<unsigned> Order;
+  for (unsigned i = 0, e = Files.size(); i != e; ++i)
+    Order.push_back(i);
+  std::sort(Order.begin(), Order.end(), CompareFileNames(Files));
+  std::vector<unsigned> NewFileID(Files.size());
+  for (unsigned i = 0, e = Order.size(); i != e; ++i)
+    NewFileID[Order[i]] = i;
+
+  OnDiskChainedHashTableGenerator<SymbolIndexWriterTrait> Generator;
+  for (llvm::StringMap<std::vector<SymbolOccurrence> >::iterator
+         I = Symbols.begin(), E = Symbols.end(); I != E; ++I) {
+    std::vector<SymbolOccurrence> &Occurrences = I->getValue();
+    for (unsigned i = 0, e = Occurrences.size(); i != e; ++i)
+      Occurrences[i].File = NewFileID[Occurrences[i].File];
+    std::sort(Occurrences.begin(), Occurrences.end());
+    Occurrences.erase(std::unique(Occurrences.begin(), Occurrences.end()),
+                      Occurrences.end());
+    Generator.insert(I->getKey(), &Occurrences);
+  }
+
+  // Write to a temporary file first so that clients reading the index never
+  // see a partially written file.
+  AtomicOutputFile IndexFile(Path);
+  std::string ErrMsg;
+  if (IndexFile.open(ErrMsg))
+    return true;
+
+  llvm::raw_ostream &Out = IndexFile.getStream();
+  Out << "cfe-syi";
+  Emit32(Out, SymbolIndexVersion);
+
+  Offset TableOff = Generator.Emit(Out);
+  Offset FileTableOff = Out.tell();
+  for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+    const std::pair<std::string, uint64_t> &File = Files[Order[i]];
+    Emit64(Out, File.second);
+    Emit16(Out, File.first.size());
+    Out << File.first << '\0';
+  }
+
+  Emit32(Out, Files.size());
+  Emit32(Out, FileTableOff);
+  Emit32(Out, TableOff);
+  return IndexFile.commit(ErrMsg);
+}
+
+//===----------------------------------------------------------------------===//
+// Reading symbol indexes.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// SymbolIndexReader - A symbol index file mapped into memory.
+class SymbolIndexReader {
+  llvm::OwningPtr<const llvm::MemoryBuffer> Buf;
+  llvm::OwningPtr<SymbolIndexTable> Table;
+
+  /// Files - The name and modification time of each file in the index.
+  std::vector<std::pair<llvm::StringRef, uint64_t> > Files;
+
+  SymbolIndexReader() {}
+  bool ReadFile(llvm::StringRef Path);
+
+public:
+  /// Open - Read the symbol index at \arg Path.  Returns null if it does not
+  /// exist or is not a valid symbol index.
+  static SymbolIndexReader *Open(llvm::StringRef Path);
+
+  unsigned getNumFiles() const { return Files.size(); }
+  llvm::StringRef getFileName(unsigned File) const {
+    return Files[File].first;
+  }
+  uint64_t getFileTime(unsigned File) const { return Files[File].second; }
+
+  /// lookup - Return the occurrences of the symbol with the given \arg USR.
+  SymbolIndexLookupTrait::data_type lookup(llvm::StringRef USR);
+
+  /// addOccurrencesTo - Add the occurrences in every file \arg FileMap maps
+  /// to a file of \arg Builder to that file.  Files mapped to ~0U are
+  /// skipped.
+  void addOccurrencesTo(SymbolIndexBuilder &Builder,
+                        const std::vector<unsigned> &FileMap);
+};
+} // end anonymous namespace
+
+SymbolIndexReader *SymbolIndexReader::Open(llvm::StringRef Path) {
+  SymbolIndexReader *Reader = new SymbolIndexReader;
+  if (!Reader->ReadFile(Path)) {
+    delete Reader;
+    return 0;
+  }
+  return Reader;
+}
+
+bool SymbolIndexReader::ReadFile(llvm::StringRef Path) {
+  Buf.reset(llvm::MemoryBuffer::getFile(Path.str().c_str()));
+  if (!Buf)
+    return false;
+
+  const unsigned char *BufBeg = (const unsigned char*) Buf->getBufferStart();
+  const unsigned char *BufEnd = (const unsigned char*) Buf->getBufferEnd();
+  const unsigned MagicLen = sizeof("cfe-syi") - 1;
+  if (BufEnd - BufBeg < (signed) (MagicLen + 4 + 12) ||
+      memcmp(BufBeg, "cfe-syi", MagicLen) != 0)
+    return false;
+
+  const unsigned char *p = BufBeg + MagicLen;
+  if (ReadUnalignedLE32(p) != SymbolIndexVersion)
+    return false;
+
+  const unsigned char *TrailerBeg = BufEnd - 12, *Trailer = TrailerBeg;
+  unsigned NumFiles = ReadUnalignedLE32(Trailer);
+  unsigned FileTableOff = ReadUnalignedLE32(Trailer);
+  unsigned TableOff = ReadUnalignedLE32(Trailer);
+  const unsigned char *Buckets = BufBeg + TableOff;
+  if (TableOff >= FileTableOff ||
+      FileTableOff > (unsigned) (TrailerBeg - BufBeg) ||
+      Buckets < p || Buckets + 8 > BufBeg + FileTableOff ||
+      ((uintptr_t) Buckets & 0x3) != 0)
+    return false;
+
+  p = BufBeg + FileTableOff;
+  for (unsigned i = 0; i != NumFiles; ++i) {
+    if (TrailerBeg - p < 8 + 2)
+      return false;
+    uint64_t ModTime = ReadUnalignedLE64(p);
+    unsigned Len = ReadUnalignedLE16(p);
+    if (TrailerBeg - p < (signed) Len + 1)
+      return false;
+    Files.push_back(std::make_pair(llvm::StringRef((const char*) p, Len),
+                                   ModTime));
+    p += Len + 1;
+  }
+
+  Table.reset(SymbolIndexTable::Create(Buckets, BufBeg));
+  return true;
+}
+
+SymbolIndexLookupTrait::data_type
+SymbolIndexReader::lookup(llvm::StringRef USR) {
+  SymbolIndexTable::iterator I = Table->find(USR);
+  if (I == Table->end())
+    return SymbolIndexLookupTrait::data_type(0, 0);
+  return *I;
+}
+
+void SymbolIndexReader::addOccurrencesTo(SymbolIndexBuilder &Builder,
+                                         const std::vector<unsigned> &FileMap) {
+  // The table has no iterator, so walk its buckets directly.
+  const unsigned char *Bucket = Table->getBuckets();
+  for (unsigned i = 0, e = Table->getNumBuckets(); i != e; ++i) {
+    unsigned Offset = ReadLE32(Bucket);
+    if (Offset == 0)
+      continue;
+
+    const unsigned char *Items = Table->getBase() + Offset;
+    unsigned NumItems = ReadUnalignedLE16(Items);
+    for (unsigned j = 0; j != NumItems; ++j) {
+      Items += 4; // Skip the hash.
+      std::pair<unsigned, unsigned> L =
+        SymbolIndexLookupTrait::ReadKeyDataLength(Items);
+      llvm::StringRef USR = SymbolIndexLookupTrait::ReadKey(Items, L.first);
+      SymbolIndexLookupTrait::data_type Data =
+        SymbolIndexLookupTrait::ReadData(USR, Items + L.first, L.second);
+      Items += L.first + L.second;
+
+      const unsigned char *d = Data.first;
+      for (unsigned k = 0; k != Data.second; ++k) {
+        SymbolOccurrence O = ReadOccurrence(d);
+        if (O.File < FileMap.size() && FileMap[O.File] != ~0U)
+          Builder.addOccurrence(USR, O.Kind, FileMap[O.File], O.Offset);
+      }
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Collecting the symbols of a translation unit.
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct SymbolIndexCollector {
+  SymbolIndexBuilder &Builder;
+  llvm::DenseMap<CXFile, unsigned> FileIDs;
+
+  explicit SymbolIndexCollector(SymbolIndexBuilder &Builder)
+    : Builder(Builder) {}
+
+  unsigned getFileID(CXFile File);
+};
+} // end anonymous namespace
+
+unsigned SymbolIndexCollector::getFileID(CXFile File) {
+  llvm::DenseMap<CXFile, unsigned>::iterator Known = FileIDs.find(File);
+  if (Known != FileIDs.end())
+    return Known->second;
+
+  // Translation units built in different directories must agree on the
+  // names of the files they share.
+  FileEntry *FEnt = static_cast<FileEntry *>(File);
+  llvm::sys::Path Name(FEnt->getName());
+  Name.makeAbsolute();
+  unsigned ID = Builder.getFileID(Name.str(), FEnt->getModificationTime());
+  FileIDs[File] = ID;
+  return ID;
+}
+
+/// isIndexedDecl - Whether the occurrences of \arg D are recorded in the
+/// symbol index.  The USRs of declarations local to a function do not
+/// identify them across translation units.
+static bool isIndexedDecl(Decl *D) {
+  return D && !D->getDeclContext()->isFunctionOrMethod();
+}
+
+static enum CXChildVisitResult SymbolIndexVisitor(CXCursor C, CXCursor Parent,
+                                                  CXClientData ClientData) {
+  SymbolIndexCollector *Collector
+    = static_cast<SymbolIndexCollector *>(ClientData);
+
+  CXCursor Entity;
+  enum CXSymbolOccurrenceKind Kind;
+  if (clang_isDeclaration(C.kind)) {
+    Entity = C;
+    Kind = clang_isCursorDefinition(C) ? CXSymbolOccurrence_Definition
+                                       : CXSymbolOccurrence_Declaration;
+  } else if (clang_isReference(C.kind) || C.kind == CXCursor_DeclRefExpr ||
+             C.kind == CXCursor_MemberRefExpr) {
+    Entity = clang_getCursorReferenced(C);
+    Kind = CXSymbolOccurrence_Reference;
+  } else
+    return CXChildVisit_Recurse;
+
+  if (!clang_isDeclaration(Entity.kind) ||
+      !isIndexedDecl(cxcursor::getCursorDecl(Entity)))
+    return CXChildVisit_Recurse;
+
+  CXFile File;
+  unsigned Offset;
+  clang_getInstantiationLocation(clang_getCursorLocation(C), &File, 0, 0,
+                                 &Offset);
+  if (!File)
+    return CXChildVisit_Recurse;
+
+  CXString USR = clang_getCursorUSR(Entity);
+  if (const char *S = clang_getCString(USR))
+    Collector->Builder.addOccurrence(S, Kind, Collector->getFileID(File),
+                                     Offset);
+  clang_disposeString(USR);
+  return CXChildVisit_Recurse;
+}
+
+extern "C" {
+
+int clang_writeSymbolIndex(CXTranslationUnit TU, const char *index_path) {
+  if (!TU || !index_path)
+    return 1;
+
+  SymbolIndexBuilder Builder;
+  SymbolIndexCollector Collector(Builder);
+  clang_visitChildren(clang_getTranslationUnitCursor(TU), SymbolIndexVisitor,
+                      &Collector);
+  return Builder.Write(index_path) ? 1 : 0;
+}
+
+int clang_mergeSymbolIndexes(const char *index_path, unsigned num_inputs,
+                             const char * const *inputs) {
+  if (!index_path)
+    return 1;
+
+  // The index being updated takes part in the merge as the oldest input.
+  std::vector<SymbolIndexReader *> Readers;
+  if (SymbolIndexReader *Existing = SymbolIndexReader::Open(index_path))
+    Readers.push_back(Existing);
+  for (unsigned i = 0; i != num_inputs; ++i) {
+    SymbolIndexReader *Input = SymbolIndexReader::Open(inputs[i]);
+    if (!Input) {
+      for (unsigned j = 0, e = Readers.size(); j != e; ++j)
+        delete Readers[j];
+      return 1;
+    }
+    Readers.push_back(Input);
+  }
+
+  // The occurrences in each file come from the input that indexed the most
+  // recent version of it, or from the last of the inputs that indexed that
+  // version.  Re-indexing a translation unit thus replaces the occurrences
+  // it contributed to each of its files, while the files it no longer
+  // includes keep theirs.
+  llvm::StringMap<std::pair<uint64_t, unsigned> > Owners;
+  for (unsigned r = 0, e = Readers.size(); r != e; ++r)
+    for (unsigned f = 0, fe = Readers[r]->getNumFiles(); f != fe; ++f) {
+      uint64_t ModTime = Readers[r]->getFileTime(f);
+      llvm::StringMapEntry<std::pair<uint64_t, unsigned> > &Owner
+        = Owners.GetOrCreateValue(Readers[r]->getFileName(f),
+                                  std::make_pair(ModTime, r));
+      if (Owner.getValue().first <= ModTime)
+        Owner.setValue(std::make_pair(ModTime, r));
+    }
+
+  SymbolIndexBuilder Builder;
+  for (unsigned r = 0, e = Readers.size(); r != e; ++r) {
+    std::vector<unsigned> FileMap(Readers[r]->getNumFiles(), ~0U);
+    for (unsigned f = 0, fe = FileMap.size(); f != fe; ++f)
+      if (Owners[Readers[r]->getFileName(f)].second == r)
+        FileMap[f] = Builder.getFileID(Readers[r]->getFileName(f),
+                                       Readers[r]->getFileTime(f));
+    Readers[r]->addOccurrencesTo(Builder, FileMap);
+  }
+
+  // The builder owns copies of everything it needs; let go of the inputs
+  // before the index they may include is replaced.
+  for (unsigned r = 0, e = Readers.size(); r != e; ++r)
+    delete Readers[r];
+
+  return Builder.Write(index_path) ? 1 : 0;
+}
+
+CXSymbolIndex clang_loadSymbolIndex(const char *index_path) {
+  if (!index_path)
+    return 0;
+  return SymbolIndexReader::Open(index_path);
+}
+
+void clang_disposeSymbolIndex(CXSymbolIndex index) {
+  delete static_cast<SymbolIndexReader *>(index);
+}
+
+unsigned clang_findSymbolOccurrences(CXSymbolIndex index, const char *usr,
+                                     CXSymbolOccurrenceVisitor visitor,
+                                     CXClientData client_data) {
+  if (!index || !usr)
+    return 0;
+
+  SymbolIndexReader *Reader = static_cast<SymbolIndexReader *>(index);
+  SymbolIndexLookupTrait::data_type Data = Reader->lookup(usr);
+  const unsigned char *d = Data.first;
+  unsigned NumVisited = 0;
+  for (unsigned i = 0; i != Data.second; ++i) {
+    SymbolOccurrence O = ReadOccurrence(d);
+    if (O.File >= Reader->getNumFiles())
+      continue;
+
+    // File names are stored NUL-terminated.
+    visitor((enum CXSymbolOccurrenceKind) O.Kind,
+            Reader->getFileName(O.File).data(), O.Offset, client_data);
+    ++NumVisited;
+  }
+  return NumVisited;
+}
+
+} // end extern "C"
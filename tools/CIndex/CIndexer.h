@@ -15,9 +15,11 @@
 #ifndef LLVM_CLANG_CINDEXER_H
 #define LLVM_CLANG_CINDEXER_H
 
+#include "CIndexASTWorkerPool.h"
 #include "clang-c/Index.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/ASTUnit.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/System/Path.h"
 #include <vector>
@@ -25,6 +27,8 @@
 using namespace clang;
 
 namespace clang {
+  class DiagnosticQueue;
+
 namespace cxstring {
   CXString createCXString(const char *String, bool DupString = false);
   CXString createCXString(llvm::StringRef String, bool DupString = true);  
@@ -35,13 +39,26 @@ class CIndexer {
   bool UseExternalASTGeneration;
   bool OnlyLocalDecls;
   bool DisplayDiagnostics;
+  bool SkipFunctionBodies;
+  bool PrecompilePreamble;
 
+  /// The path to clang, computed when the index is created so that threads
+  /// creating translation units from it only read it.
   llvm::sys::Path ClangPath;
+
+  /// The clang processes generating ASTs when UseExternalASTGeneration is
+  /// set, created along with it.
+  llvm::OwningPtr<ASTWorkerPool> WorkerPool;
+
+  /// The queue that the diagnostics of translation units created from source
+  /// are streamed onto while they are parsed, if any.
+  DiagnosticQueue *DiagQueue;
   
 public:
  CIndexer() 
    : UseExternalASTGeneration(false), OnlyLocalDecls(false),
-     DisplayDiagnostics(false) { }
+     DisplayDiagnostics(false), SkipFunctionBodies(false),
+     PrecompilePreamble(false), DiagQueue(0) { }
   
   /// \brief Whether we only want to see "local" declarations (that did not
   /// come from a previous precompiled header). If false, we want to see all
@@ -54,10 +71,31 @@ public:
     DisplayDiagnostics = Display;
   }
 
+  /// \brief Whether translation units parsed from source skip over function
+  /// bodies, building only declarations.
+  bool getSkipFunctionBodies() const { return SkipFunctionBodies; }
+  void setSkipFunctionBodies(bool Skip = true) { SkipFunctionBodies = Skip; }
+
+  /// \brief Whether translation units parsed from source precompile the
+  /// preamble of their main file for reparsing.
+  bool getPrecompilePreamble() const { return PrecompilePreamble; }
+  void setPrecompilePreamble(bool Precompile = true) {
+    PrecompilePreamble = Precompile;
+  }
+
   bool getUseExternalASTGeneration() const { return UseExternalASTGeneration; }
   void setUseExternalASTGeneration(bool Value) {
     UseExternalASTGeneration = Value;
+    if (Value && !WorkerPool && ASTWorkerPool::isSupported())
+      WorkerPool.reset(new ASTWorkerPool(getClangPath()));
   }
+
+  DiagnosticQueue *getDiagnosticQueue() const { return DiagQueue; }
+  void setDiagnosticQueue(DiagnosticQueue *Queue) { DiagQueue = Queue; }
+
+  /// \brief Get the pool of AST workers, or null when clang has to be
+  /// executed for every translation unit.
+  ASTWorkerPool *getASTWorkerPool() const { return WorkerPool.get(); }
   
   /// \brief Get the path of the clang binary.
   const llvm::sys::Path& getClangPath();
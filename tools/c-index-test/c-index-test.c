@@ -436,6 +436,81 @@ void PrintInclusionStack(CXTranslationUnit TU) {
   clang_getInclusions(TU, InclusionVisitor, NULL);
 }
 
+/******************************************************************************/
+/* Memory usage testing.                                                      */
+/******************************************************************************/
+
+static void PrintTUMemoryUsage(CXTranslationUnit TU) {
+  unsigned kind;
+  for (kind = CXTUMemoryUsage_First; kind <= CXTUMemoryUsage_Last; ++kind) {
+    CXString name =
+      clang_getTUMemoryUsageKindSpelling((enum CXTUMemoryUsageKind)kind);
+    printf("  %s: %lu\n", clang_getCString(name),
+           clang_getTranslationUnitMemoryUsage(TU,
+                                               (enum CXTUMemoryUsageKind)kind));
+    clang_disposeString(name);
+  }
+}
+
+void PrintMemoryUsage(CXTranslationUnit TU) {
+  /* Printing the diagnostics computes the line tables of the files. */
+  PrintDiagnostics(TU);
+  printf("memory usage:\n");
+  PrintTUMemoryUsage(TU);
+  clang_trimTranslationUnitMemory(TU);
+  printf("memory usage after trimming:\n");
+  PrintTUMemoryUsage(TU);
+
+  /* Finding and printing a cursor brings the main file back in. */
+  {
+    CXString name = clang_getTranslationUnitSpelling(TU);
+    CXFile file = clang_getFile(TU, clang_getCString(name));
+    CXCursor cursor = clang_getCursor(TU, clang_getLocation(TU, file, 2, 5));
+    printf("cursor after trimming: ");
+    PrintCursor(cursor);
+    PrintCursorExtent(cursor);
+    printf("\n");
+    clang_disposeString(name);
+  }
+  printf("memory usage after reloading:\n");
+  PrintTUMemoryUsage(TU);
+}
+
+/******************************************************************************/
+/* Cursor tree export testing.                                                */
+/******************************************************************************/
+
+static void PrintCursorTreeNode(const CXCursorTreeNode *node,
+                                const char *strings) {
+  CXString kind = clang_getCursorKindSpelling(node->kind);
+  printf("%s=%s", clang_getCString(kind), strings + node->spelling);
+  clang_disposeString(kind);
+}
+
+void PrintCursorTree(CXTranslationUnit TU) {
+  CXCursorTree tree =
+    clang_exportCursorTree(clang_getTranslationUnitCursor(TU));
+  const CXCursorTreeNode *nodes = clang_getCursorTreeNodes(tree);
+  const char *strings = clang_getCursorTreeStrings(tree, 0);
+  unsigned i, n = clang_getCursorTreeNumNodes(tree);
+
+  /* Skip the translation unit and the builtins, which are in no file. */
+  for (i = 1; i < n; ++i) {
+    const CXCursorTreeNode *node = &nodes[i];
+    if (!node->file)
+      continue;
+
+    PrintCursorTreeNode(node, strings);
+    printf(" [%s] %s:%d:%d-%d:%d parent ", strings + node->usr,
+           basename(strings + node->file), node->begin_line,
+           node->begin_column, node->end_line, node->end_column);
+    PrintCursorTreeNode(&nodes[node->parent], strings);
+    printf("\n");
+  }
+
+  clang_disposeCursorTree(tree);
+}
+
 /******************************************************************************/
 /* Loading ASTs/source.                                                       */
 /******************************************************************************/
@@ -444,10 +519,25 @@ static int perform_test_load(CXIndex Idx, CXTranslationUnit TU,
                              const char *filter, const char *prefix,
                              CXCursorVisitor Visitor,
                              PostVisitTU PV) {
+  const char *VisitFile = getenv("CINDEXTEST_VISIT_FILE");
+  const char *UseStringArena = getenv("CINDEXTEST_STRING_ARENA");
+  CXStringArena Arena = 0;
+  int NumPasses = 1;
+  int Pass;
 
   if (prefix)
     FileCheckPrefix = prefix;
 
+  /* With CINDEXTEST_STRING_ARENA=reset, the cursors are visited twice and
+     the arena is reset in between, so that the strings of the second visit
+     reuse the memory of those of the first. */
+  if (UseStringArena && strlen(UseStringArena)) {
+    Arena = clang_createStringArena();
+    clang_setStringArena(Arena);
+    if (!strcmp(UseStringArena, "reset"))
+      NumPasses = 2;
+  }
+
   if (Visitor) {
     enum CXCursorKind K = CXCursor_NotImplemented;
     enum CXCursorKind *ck = &K;
@@ -464,12 +554,25 @@ static int perform_test_load(CXIndex Idx, CXTranslationUnit TU,
     else if (!strcmp(filter, "scan-function")) Visitor = FunctionScanVisitor;
     else {
       fprintf(stderr, "Unknown filter for -test-load-tu: %s\n", filter);
+      if (Arena) {
+        clang_setStringArena(0);
+        clang_disposeStringArena(Arena);
+      }
       return 1;
     }
 
     Data.TU = TU;
     Data.Filter = ck;
-    clang_visitChildren(clang_getTranslationUnitCursor(TU), Visitor, &Data);
+    for (Pass = 0; Pass < NumPasses; ++Pass) {
+      if (Pass)
+        clang_resetStringArena(Arena);
+      if (VisitFile && strlen(VisitFile))
+        clang_visitChildrenInFile(TU, clang_getFile(TU, VisitFile), Visitor,
+                                  &Data);
+      else
+        clang_visitChildren(clang_getTranslationUnitCursor(TU), Visitor,
+                            &Data);
+    }
   }
 
   if (PV)
@@ -477,6 +580,11 @@ static int perform_test_load(CXIndex Idx, CXTranslationUnit TU,
 
   PrintDiagnostics(TU);
   clang_disposeTranslationUnit(TU);
+
+  if (Arena) {
+    clang_setStringArena(0);
+    clang_disposeStringArena(Arena);
+  }
   return 0;
 }
 
@@ -505,7 +613,11 @@ int perform_test_load_source(int argc, const char **argv,
                              PostVisitTU PV) {
   const char *UseExternalASTs =
     getenv("CINDEXTEST_USE_EXTERNAL_AST_GENERATION");
+  const char *SkipFunctionBodies = getenv("CINDEXTEST_SKIP_FUNCTION_BODIES");
+  const char *UseDiagnosticQueue = getenv("CINDEXTEST_DIAGNOSTIC_QUEUE");
   CXIndex Idx;
+  CXDiagnosticQueue Queue = 0;
+  CXDiagnostic Diag;
   CXTranslationUnit TU;
   struct CXUnsavedFile *unsaved_files = 0;
   int num_unsaved_files = 0;
@@ -517,9 +629,16 @@ int perform_test_load_source(int argc, const char **argv,
 
   if (UseExternalASTs && strlen(UseExternalASTs))
     clang_setUseExternalASTGeneration(Idx, 1);
+  if (SkipFunctionBodies && strlen(SkipFunctionBodies))
+    clang_setSkipFunctionBodies(Idx, 1);
+  if (UseDiagnosticQueue && strlen(UseDiagnosticQueue)) {
+    Queue = clang_createDiagnosticQueue();
+    clang_setDiagnosticQueue(Idx, Queue);
+  }
 
   if (parse_remapped_files(argc, argv, 0, &unsaved_files, &num_unsaved_files)) {
     clang_disposeIndex(Idx);
+    clang_disposeDiagnosticQueue(Queue);
     return -1;
   }
 
@@ -528,12 +647,99 @@ int perform_test_load_source(int argc, const char **argv,
                                                  argv + num_unsaved_files,
                                                  num_unsaved_files,
                                                  unsaved_files);
+
+  /* Print the diagnostics that were streamed onto the queue while parsing. */
+  if (Queue) {
+    while ((Diag = clang_takeQueuedDiagnostic(Queue))) {
+      fprintf(stderr, "Queued: ");
+      PrintDiagnostic(Diag);
+      clang_disposeDiagnostic(Diag);
+    }
+  }
+
+  if (!TU) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    clang_disposeIndex(Idx);
+    clang_disposeDiagnosticQueue(Queue);
+    return 1;
+  }
+
+  result = perform_test_load(Idx, TU, filter, NULL, Visitor, PV);
+  free_remapped_files(unsaved_files, num_unsaved_files);
+  clang_disposeIndex(Idx);
+  clang_disposeDiagnosticQueue(Queue);
+  return result;
+}
+
+int perform_test_reparse_source(int argc, const char **argv, int trials,
+                                const char *filter, CXCursorVisitor Visitor,
+                                PostVisitTU PV) {
+  const char *SkipFunctionBodies = getenv("CINDEXTEST_SKIP_FUNCTION_BODIES");
+  const char *RemapAfterLoad = getenv("CINDEXTEST_REMAP_AFTER_LOAD");
+  const char *CreateBeforeReparse = getenv("CINDEXTEST_CREATE_BEFORE_REPARSE");
+  CXIndex Idx;
+  CXTranslationUnit TU;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  int result;
+  int trial;
+
+  Idx = clang_createIndex(/* excludeDeclsFromPCH */
+                          !strcmp(filter, "local") ? 1 : 0,
+                          /* displayDiagnosics=*/1);
+  clang_setPrecompilePreamble(Idx, 1);
+  if (SkipFunctionBodies && strlen(SkipFunctionBodies))
+    clang_setSkipFunctionBodies(Idx, 1);
+
+  if (parse_remapped_files(argc, argv, 0, &unsaved_files, &num_unsaved_files)) {
+    clang_disposeIndex(Idx);
+    return -1;
+  }
+
+  /* With CINDEXTEST_REMAP_AFTER_LOAD, the files are loaded as they are on
+     disk and only the reparses see the remapped files, as if they had been
+     edited in between. */
+  TU = clang_createTranslationUnitFromSourceFile(Idx, 0,
+                                                 argc - num_unsaved_files,
+                                                 argv + num_unsaved_files,
+                                                 RemapAfterLoad ? 0 :
+                                                   num_unsaved_files,
+                                                 unsaved_files);
   if (!TU) {
     fprintf(stderr, "Unable to load translation unit!\n");
+    free_remapped_files(unsaved_files, num_unsaved_files);
     clang_disposeIndex(Idx);
     return 1;
   }
 
+  /* With CINDEXTEST_CREATE_BEFORE_REPARSE=<file>, <file>.in is renamed to
+     <file> after the translation unit was loaded, so that the reparses see a
+     file that did not exist before. */
+  if (CreateBeforeReparse && strlen(CreateBeforeReparse)) {
+    char *Source = (char *)malloc(strlen(CreateBeforeReparse) + 4);
+    sprintf(Source, "%s.in", CreateBeforeReparse);
+    if (rename(Source, CreateBeforeReparse)) {
+      fprintf(stderr, "Unable to create '%s'\n", CreateBeforeReparse);
+      free(Source);
+      clang_disposeTranslationUnit(TU);
+      free_remapped_files(unsaved_files, num_unsaved_files);
+      clang_disposeIndex(Idx);
+      return 1;
+    }
+    free(Source);
+  }
+
+  for (trial = 0; trial < trials; ++trial) {
+    if (clang_reparseTranslationUnit(TU, num_unsaved_files, unsaved_files)) {
+      fprintf(stderr, "Unable to reparse translation unit!\n");
+      clang_disposeTranslationUnit(TU);
+      free_remapped_files(unsaved_files, num_unsaved_files);
+      clang_disposeIndex(Idx);
+      return 1;
+    }
+  }
+  printf("Function body reparses: %u\n", clang_getNumFunctionBodyReparses(TU));
+
   result = perform_test_load(Idx, TU, filter, NULL, Visitor, PV);
   free_remapped_files(unsaved_files, num_unsaved_files);
   clang_disposeIndex(Idx);
@@ -750,6 +956,24 @@ void print_completion_result(CXCompletionResult *completion_result,
   fprintf(file, "\n");
 }
 
+void print_completion_results(CXCodeCompleteResults *results) {
+  unsigned i, n = results->NumResults;
+  for (i = 0; i != n; ++i)
+    print_completion_result(results->Results + i, stdout);
+  n = clang_codeCompleteGetNumDiagnostics(results);
+  for (i = 0; i != n; ++i) {
+    CXDiagnostic diag = clang_codeCompleteGetDiagnostic(results, i);
+    PrintDiagnostic(diag);
+    clang_disposeDiagnostic(diag);
+  }
+}
+
+/* The maximum number of completion results, from the environment. */
+static unsigned get_completion_max_results(void) {
+  const char *max_results = getenv("CINDEXTEST_COMPLETION_MAX_RESULTS");
+  return max_results ? (unsigned)atoi(max_results) : 0;
+}
+
 int perform_code_completion(int argc, const char **argv) {
   const char *input = argv[1];
   char *filename = 0;
@@ -770,22 +994,16 @@ int perform_code_completion(int argc, const char **argv) {
     return -1;
 
   CIdx = clang_createIndex(0, 1);
-  results = clang_codeComplete(CIdx,
+  results = clang_codeCompleteWithFilter(CIdx,
                                argv[argc - 1], argc - num_unsaved_files - 3,
                                argv + num_unsaved_files + 2,
                                num_unsaved_files, unsaved_files,
-                               filename, line, column);
+                               filename, line, column,
+                               getenv("CINDEXTEST_COMPLETION_PREFIX"),
+                               get_completion_max_results());
 
   if (results) {
-    unsigned i, n = results->NumResults;
-    for (i = 0; i != n; ++i)
-      print_completion_result(results->Results + i, stdout);
-    n = clang_codeCompleteGetNumDiagnostics(results);
-    for (i = 0; i != n; ++i) {
-      CXDiagnostic diag = clang_codeCompleteGetDiagnostic(results, i);
-      PrintDiagnostic(diag);
-      clang_disposeDiagnostic(diag);
-    }
+    print_completion_results(results);
     clang_disposeCodeCompleteResults(results);
   }
 
@@ -797,6 +1015,67 @@ int perform_code_completion(int argc, const char **argv) {
   return 0;
 }
 
+/* Completes twice in the same translation unit, so that the second
+   completion reuses the precompiled preamble, and prints the results of the
+   second. */
+int perform_in_process_code_completion(int argc, const char **argv) {
+  const char *input = argv[1];
+  char *filename = 0;
+  unsigned line;
+  unsigned column;
+  CXIndex CIdx;
+  CXTranslationUnit TU;
+  int errorCode;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  CXCodeCompleteResults *results = 0;
+  int pass;
+
+  input += strlen("-code-completion-in-process-at=");
+  if ((errorCode = parse_file_line_column(input, &filename, &line, &column,
+                                          0, 0)))
+    return errorCode;
+
+  if (parse_remapped_files(argc, argv, 2, &unsaved_files, &num_unsaved_files))
+    return -1;
+
+  CIdx = clang_createIndex(0, 1);
+  TU = clang_createTranslationUnitFromSourceFile(CIdx, argv[argc - 1],
+                                                 argc - num_unsaved_files - 3,
+                                                 argv + num_unsaved_files + 2,
+                                                 num_unsaved_files,
+                                                 unsaved_files);
+  if (!TU) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    clang_disposeIndex(CIdx);
+    free(filename);
+    free_remapped_files(unsaved_files, num_unsaved_files);
+    return 1;
+  }
+
+  for (pass = 0; pass != 2; ++pass) {
+    if (results)
+      clang_disposeCodeCompleteResults(results);
+    results = clang_codeCompleteAtWithFilter(TU, filename, line, column,
+                                   unsaved_files, num_unsaved_files,
+                                   getenv("CINDEXTEST_COMPLETION_PREFIX"),
+                                   get_completion_max_results());
+  }
+
+  if (results) {
+    print_completion_results(results);
+    clang_disposeCodeCompleteResults(results);
+  }
+
+  clang_disposeTranslationUnit(TU);
+  clang_disposeIndex(CIdx);
+  free(filename);
+
+  free_remapped_files(unsaved_files, num_unsaved_files);
+
+  return 0;
+}
+
 typedef struct {
   char *filename;
   unsigned line;
@@ -812,6 +1091,8 @@ int inspect_cursor_at(int argc, const char **argv) {
   CXCursor Cursor;
   CursorSourceLocation *Locations = 0;
   unsigned NumLocations = 0, Loc;
+  const char *SkipFunctionBodies = getenv("CINDEXTEST_SKIP_FUNCTION_BODIES");
+  const char *RemapAfterLoad = getenv("CINDEXTEST_REMAP_AFTER_LOAD");
 
   /* Count the number of locations. */
   while (strstr(argv[NumLocations+1], "-cursor-at=") == argv[NumLocations+1])
@@ -834,16 +1115,33 @@ int inspect_cursor_at(int argc, const char **argv) {
     return -1;
 
   CIdx = clang_createIndex(0, 1);
+  if (SkipFunctionBodies && strlen(SkipFunctionBodies))
+    clang_setSkipFunctionBodies(CIdx, 1);
+  /* With CINDEXTEST_REMAP_AFTER_LOAD, the cursors are looked up after a
+     reparse that sees the remapped files, as if they had been edited after
+     the translation unit was loaded. */
   TU = clang_createTranslationUnitFromSourceFile(CIdx, argv[argc - 1],
                                   argc - num_unsaved_files - 2 - NumLocations,
                                    argv + num_unsaved_files + 1 + NumLocations,
-                                                 num_unsaved_files,
+                                                 RemapAfterLoad ? 0 :
+                                                   num_unsaved_files,
                                                  unsaved_files);
   if (!TU) {
     fprintf(stderr, "unable to parse input\n");
     return -1;
   }
 
+  if (RemapAfterLoad) {
+    if (clang_reparseTranslationUnit(TU, num_unsaved_files, unsaved_files)) {
+      fprintf(stderr, "Unable to reparse translation unit!\n");
+      clang_disposeTranslationUnit(TU);
+      clang_disposeIndex(CIdx);
+      return -1;
+    }
+    printf("Function body reparses: %u\n",
+           clang_getNumFunctionBodyReparses(TU));
+  }
+
   for (Loc = 0; Loc < NumLocations; ++Loc) {
     CXFile file = clang_getFile(TU, Locations[Loc].filename);
     if (!file)
@@ -881,6 +1179,7 @@ int perform_token_annotation(int argc, const char **argv) {
   CXSourceLocation startLoc, endLoc;
   CXFile file = 0;
   CXCursor *cursors = 0;
+  int owns_cursors = 0;
   unsigned i;
 
   input += strlen("-test-annotate-tokens=");
@@ -930,9 +1229,14 @@ int perform_token_annotation(int argc, const char **argv) {
   }
 
   range = clang_getRange(startLoc, endLoc);
-  clang_tokenize(TU, range, &tokens, &num_tokens);
-  cursors = (CXCursor *)malloc(num_tokens * sizeof(CXCursor));
-  clang_annotateTokens(TU, tokens, num_tokens, cursors);
+  if (getenv("CINDEXTEST_TOKENIZE_WITH_CURSORS"))
+    clang_tokenizeWithCursors(TU, range, &tokens, &cursors, &num_tokens);
+  else {
+    clang_tokenize(TU, range, &tokens, &num_tokens);
+    cursors = (CXCursor *)malloc(num_tokens * sizeof(CXCursor));
+    clang_annotateTokens(TU, tokens, num_tokens, cursors);
+    owns_cursors = 1;
+  }
   for (i = 0; i != num_tokens; ++i) {
     const char *kind = "<unknown>";
     CXString spelling = clang_getTokenSpelling(TU, tokens[i]);
@@ -958,7 +1262,9 @@ int perform_token_annotation(int argc, const char **argv) {
     }
     printf("\n");
   }
-  free(cursors);
+  clang_disposeTokens(TU, tokens, num_tokens);
+  if (owns_cursors)
+    free(cursors);
 
  teardown:
   PrintDiagnostics(TU);
@@ -969,6 +1275,84 @@ int perform_token_annotation(int argc, const char **argv) {
   return errorCode;
 }
 
+/******************************************************************************/
+/* Symbol index testing.                                                      */
+/******************************************************************************/
+
+int write_symbol_index(const char *index_path, int argc, const char **argv) {
+  CXIndex Idx;
+  CXTranslationUnit TU;
+  struct CXUnsavedFile *unsaved_files = 0;
+  int num_unsaved_files = 0;
+  int result = 0;
+
+  Idx = clang_createIndex(/* excludeDeclsFromPCH */0,
+                          /* displayDiagnosics=*/1);
+  if (parse_remapped_files(argc, argv, 0, &unsaved_files, &num_unsaved_files)) {
+    clang_disposeIndex(Idx);
+    return -1;
+  }
+
+  TU = clang_createTranslationUnitFromSourceFile(Idx, 0,
+                                                 argc - num_unsaved_files,
+                                                 argv + num_unsaved_files,
+                                                 num_unsaved_files,
+                                                 unsaved_files);
+  if (!TU) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    result = 1;
+  } else {
+    if (clang_writeSymbolIndex(TU, index_path)) {
+      fprintf(stderr, "Unable to write symbol index %s\n", index_path);
+      result = 1;
+    }
+    clang_disposeTranslationUnit(TU);
+  }
+
+  free_remapped_files(unsaved_files, num_unsaved_files);
+  clang_disposeIndex(Idx);
+  return result;
+}
+
+int merge_symbol_index(const char *index_path, int num_inputs,
+                       const char **inputs) {
+  if (clang_mergeSymbolIndexes(index_path, num_inputs, inputs)) {
+    fprintf(stderr, "Unable to merge into symbol index %s\n", index_path);
+    return 1;
+  }
+  return 0;
+}
+
+void SymbolOccurrenceVisitor(enum CXSymbolOccurrenceKind kind,
+                             const char *filename, unsigned offset,
+                             CXClientData client_data) {
+  const char *kind_name = "<unknown>";
+  switch (kind) {
+  case CXSymbolOccurrence_Declaration: kind_name = "Declaration"; break;
+  case CXSymbolOccurrence_Definition: kind_name = "Definition"; break;
+  case CXSymbolOccurrence_Reference: kind_name = "Reference"; break;
+  }
+  printf("%s %s:%d\n", kind_name, basename(filename), offset);
+}
+
+int find_symbol(const char *index_path, int num_usrs, const char **usrs) {
+  CXSymbolIndex Index = clang_loadSymbolIndex(index_path);
+  int i;
+
+  if (!Index) {
+    fprintf(stderr, "Unable to load symbol index %s\n", index_path);
+    return 1;
+  }
+
+  for (i = 0; i != num_usrs; ++i) {
+    printf("USR %s:\n", usrs[i]);
+    clang_findSymbolOccurrences(Index, usrs[i], SymbolOccurrenceVisitor, 0);
+  }
+
+  clang_disposeSymbolIndex(Index);
+  return 0;
+}
+
 /******************************************************************************/
 /* Command line processing.                                                   */
 /******************************************************************************/
@@ -984,6 +1368,8 @@ static CXCursorVisitor GetVisitor(const char *s) {
 static void print_usage(void) {
   fprintf(stderr,
     "usage: c-index-test -code-completion-at=<site> <compiler arguments>\n"
+    "       c-index-test -code-completion-in-process-at=<site> "
+          "<compiler arguments>\n"
     "       c-index-test -cursor-at=<site> <compiler arguments>\n"
     "       c-index-test -test-file-scan <AST file> <source file> "
           "[FileCheck prefix]\n"
@@ -992,11 +1378,18 @@ static void print_usage(void) {
     "       c-index-test -test-load-tu-usrs <AST file> <symbol filter> "
            "[FileCheck prefix]\n"
     "       c-index-test -test-load-source <symbol filter> {<args>}*\n"
-    "       c-index-test -test-load-source-usrs <symbol filter> {<args>}*\n");
+    "       c-index-test -test-load-source-usrs <symbol filter> {<args>}*\n"
+    "       c-index-test -test-reparse-source <trials> <symbol filter> "
+          "{<args>}*\n");
   fprintf(stderr,
     "       c-index-test -test-annotate-tokens=<range> {<args>}*\n"
     "       c-index-test -test-inclusion-stack-source {<args>}*\n"
-    "       c-index-test -test-inclusion-stack-tu <AST file>\n\n"
+    "       c-index-test -test-inclusion-stack-tu <AST file>\n"
+    "       c-index-test -test-memory-usage {<args>}*\n"
+    "       c-index-test -test-export-tree {<args>}*\n"
+    "       c-index-test -write-symbol-index <index file> {<args>}*\n"
+    "       c-index-test -merge-symbol-index <index file> {<index file>}*\n"
+    "       c-index-test -find-symbol <index file> {<USR>}*\n\n"
     " <symbol filter> values:\n%s",
     "   all - load all symbols, including those from PCH\n"
     "   local - load all symbols except those in PCH\n"
@@ -1012,6 +1405,8 @@ int main(int argc, const char **argv) {
   clang_enableStackTraces();
   if (argc > 2 && strstr(argv[1], "-code-completion-at=") == argv[1])
     return perform_code_completion(argc, argv);
+  if (argc > 2 && strstr(argv[1], "-code-completion-in-process-at=") == argv[1])
+    return perform_in_process_code_completion(argc, argv);
   if (argc > 2 && strstr(argv[1], "-cursor-at=") == argv[1])
     return inspect_cursor_at(argc, argv);
   else if (argc >= 4 && strncmp(argv[1], "-test-load-tu", 13) == 0) {
@@ -1025,6 +1420,12 @@ int main(int argc, const char **argv) {
     if (I)
       return perform_test_load_source(argc - 3, argv + 3, argv[2], I, NULL);
   }
+  else if (argc >= 5 && strncmp(argv[1], "-test-reparse-source", 20) == 0) {
+    CXCursorVisitor I = GetVisitor(argv[1] + 20);
+    if (I)
+      return perform_test_reparse_source(argc - 4, argv + 4, atoi(argv[2]),
+                                         argv[3], I, NULL);
+  }
   else if (argc >= 4 && strcmp(argv[1], "-test-file-scan") == 0)
     return perform_file_scan(argv[2], argv[3],
                              argc >= 5 ? argv[4] : 0);
@@ -1036,6 +1437,18 @@ int main(int argc, const char **argv) {
   else if (argc > 2 && strcmp(argv[1], "-test-inclusion-stack-tu") == 0)
     return perform_test_load_tu(argv[2], "all", NULL, NULL,
                                 PrintInclusionStack);
+  else if (argc > 2 && strcmp(argv[1], "-test-memory-usage") == 0)
+    return perform_test_load_source(argc - 2, argv + 2, "all", NULL,
+                                    PrintMemoryUsage);
+  else if (argc > 2 && strcmp(argv[1], "-test-export-tree") == 0)
+    return perform_test_load_source(argc - 2, argv + 2, "all", NULL,
+                                    PrintCursorTree);
+  else if (argc > 3 && strcmp(argv[1], "-write-symbol-index") == 0)
+    return write_symbol_index(argv[2], argc - 3, argv + 3);
+  else if (argc > 2 && strcmp(argv[1], "-merge-symbol-index") == 0)
+    return merge_symbol_index(argv[2], argc - 3, argv + 3);
+  else if (argc > 2 && strcmp(argv[1], "-find-symbol") == 0)
+    return find_symbol(argv[2], argc - 3, argv + 3);
 
   print_usage();
   return 1;
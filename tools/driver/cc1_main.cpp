@@ -17,25 +17,39 @@
 #include "clang/Driver/Arg.h"
 #include "clang/Driver/ArgList.h"
 #include "clang/Driver/CC1Options.h"
+#include "clang/Driver/Compilation.h"
+#include "clang/Driver/Driver.h"
 #include "clang/Driver/DriverDiagnostic.h"
+#include "clang/Driver/Job.h"
 #include "clang/Driver/OptTable.h"
+#include "clang/Driver/Tool.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Frontend/SerializedDiagnostics.h"
 #include "clang/Frontend/TextDiagnosticBuffer.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Index/CallEdges.h"
 #include "llvm/LLVMContext.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/config.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/System/DynamicLibrary.h"
+#include "llvm/System/Host.h"
+#include "llvm/System/Path.h"
 #include "llvm/System/Signals.h"
 #include "llvm/Target/TargetSelect.h"
 #include <cstdio>
+#ifndef LLVM_ON_WIN32
+#include <unistd.h>
+#endif
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -51,6 +65,40 @@ void LLVMErrorHandler(void *UserData, const std::string &Message) {
   exit(1);
 }
 
+namespace {
+// The call edge actions live here rather than in FrontendActions, since
+// clangFrontend does not depend on clangIndex.
+class EmitCallEdgesAction : public ASTFrontendAction {
+protected:
+  virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
+                                         llvm::StringRef InFile) {
+    llvm::raw_fd_ostream *OS = CI.createDefaultOutputFile(true, InFile, "cge");
+    if (!OS)
+      return 0;
+
+    // Name the output the way createDefaultOutputFile chose it.
+    std::string OutFile = CI.getFrontendOpts().OutputFile;
+    if (OutFile.empty()) {
+      llvm::sys::Path Path(InFile);
+      Path.eraseSuffix();
+      Path.appendSuffix("cge");
+      OutFile = InFile == "-" ? "-" : Path.str();
+    }
+    return idx::CreateCallEdgeWriter(OS, OutFile, CI.getDiagnostics());
+  }
+};
+
+class PrintCallEdgesAction : public ASTFrontendAction {
+protected:
+  virtual ASTConsumer *CreateASTConsumer(CompilerInstance &CI,
+                                         llvm::StringRef InFile) {
+    if (llvm::raw_ostream *OS = CI.createDefaultOutputFile(false, InFile))
+      return idx::CreateCallEdgePrinter(OS);
+    return 0;
+  }
+};
+}
+
 static FrontendAction *CreateFrontendBaseAction(CompilerInstance &CI) {
   using namespace clang::frontend;
 
@@ -59,6 +107,7 @@ static FrontendAction *CreateFrontendBaseAction(CompilerInstance &CI) {
     llvm_unreachable("Invalid program action!");
 
   case ASTDump:                return new ASTDumpAction();
+  case ASTExport:              return new ASTExportAction();
   case ASTPrint:               return new ASTPrintAction();
   case ASTPrintXML:            return new ASTPrintXMLAction();
   case ASTView:                return new ASTViewAction();
@@ -67,6 +116,7 @@ static FrontendAction *CreateFrontendBaseAction(CompilerInstance &CI) {
   case DumpTokens:             return new DumpTokensAction();
   case EmitAssembly:           return new EmitAssemblyAction();
   case EmitBC:                 return new EmitBCAction();
+  case EmitCallEdges:          return new EmitCallEdgesAction();
   case EmitHTML:               return new HTMLPrintAction();
   case EmitLLVM:               return new EmitLLVMAction();
   case EmitLLVMOnly:           return new EmitLLVMOnlyAction();
@@ -102,8 +152,10 @@ static FrontendAction *CreateFrontendBaseAction(CompilerInstance &CI) {
     return 0;
   }
 
+  case PrintCallEdges:         return new PrintCallEdgesAction();
   case PrintDeclContext:       return new DeclContextPrintAction();
   case PrintPreprocessedInput: return new PrintPreprocessedAction();
+  case PrintUnusedIncludes:    return new PrintUnusedIncludesAction();
   case RewriteMacros:          return new RewriteMacrosAction();
   case RewriteObjC:            return new RewriteObjCAction();
   case RewriteTest:            return new RewriteTestAction();
@@ -193,6 +245,211 @@ static int cc1_test(Diagnostic &Diags,
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+// AST worker
+//===----------------------------------------------------------------------===//
+
+/// ReadWorkerRequest - Read the next request of an AST worker from its
+/// socket: the number of strings, then that many NUL-terminated strings.
+/// Returns false at the end of the input.
+static bool ReadWorkerRequest(FILE *In, std::vector<std::string> &Strings) {
+  uint32_t NumStrings;
+  if (fread(&NumStrings, sizeof(NumStrings), 1, In) != 1)
+    return false;
+
+  Strings.clear();
+  for (uint32_t I = 0; I != NumStrings; ++I) {
+    Strings.push_back(std::string());
+    for (int C = getc(In); C != 0; C = getc(In)) {
+      if (C == EOF)
+        return false;
+      Strings.back() += char(C);
+    }
+  }
+  return !Strings.empty();
+}
+
+namespace {
+/// WorkerDiagnosticClient - Sends the diagnostics of an AST worker's
+/// compilation to CIndex as soon as each of them is complete: the serialized
+/// diagnostics stream is written to the worker's socket in chunks, each a tag
+/// of 1 and its size followed by its bytes.
+class WorkerDiagnosticClient : public DiagnosticClient {
+  FILE *Out;
+  std::string Data;
+  llvm::raw_string_ostream OS;
+  SerializedDiagnosticPrinter Printer;
+
+public:
+  explicit WorkerDiagnosticClient(FILE *Out)
+    : Out(Out), OS(Data), Printer(OS, /*Streaming=*/true) {}
+
+  virtual void HandleDiagnostic(Diagnostic::Level Level,
+                                const DiagnosticInfo &Info) {
+    Printer.HandleDiagnostic(Level, Info);
+    OS.flush();
+
+    uint32_t Header[2] = { 1, uint32_t(Data.size()) };
+    fwrite(Header, sizeof(Header), 1, Out);
+    fwrite(Data.data(), 1, Data.size(), Out);
+    fflush(Out);
+    Data.clear();
+  }
+};
+} // end anonymous namespace
+
+/// RunWorkerRequest - Compile one request of an AST worker, the arguments of
+/// a driver invocation with a single clang job.
+static bool RunWorkerRequest(const std::vector<std::string> &Request,
+                             FILE *Out, const char *Argv0, void *MainAddr) {
+  CompilerInstance Clang;
+  Clang.setLLVMContext(new llvm::LLVMContext);
+  Clang.setDiagnosticClient(new WorkerDiagnosticClient(Out));
+  Clang.setDiagnostics(new Diagnostic(&Clang.getDiagnosticClient()));
+  Diagnostic &Diags = Clang.getDiagnostics();
+
+  llvm::SmallVector<const char *, 16> Args;
+  Args.push_back(Argv0);
+  for (unsigned I = 0, E = Request.size(); I != E; ++I)
+    Args.push_back(Request[I].c_str());
+
+  llvm::sys::Path Path = llvm::sys::Path::GetMainExecutable(Argv0, MainAddr);
+  driver::Driver TheDriver(Path.getBasename(), Path.getDirname(),
+                           llvm::sys::getHostTriple(), "a.out", false, Diags);
+  llvm::OwningPtr<driver::Compilation> C(
+    TheDriver.BuildCompilation(Args.size(), Args.data()));
+  if (!C || Diags.getNumErrors())
+    return false;
+
+  const driver::JobList &Jobs = C->getJobs();
+  if (Jobs.size() != 1 || !llvm::isa<driver::Command>(*Jobs.begin())) {
+    llvm::SmallString<256> Msg;
+    llvm::raw_svector_ostream OS(Msg);
+    C->PrintJob(OS, C->getJobs(), "; ", true);
+    Diags.Report(diag::err_fe_expected_compiler_job) << OS.str();
+    return false;
+  }
+
+  const driver::Command *Cmd = llvm::cast<driver::Command>(*Jobs.begin());
+  if (llvm::StringRef(Cmd->getCreator().getName()) != "clang") {
+    Diags.Report(diag::err_fe_expected_clang_command);
+    return false;
+  }
+
+  const driver::ArgStringList &CCArgs = Cmd->getArguments();
+  CompilerInvocation::CreateFromArgs(Clang.getInvocation(),
+                                     (const char**) CCArgs.data(),
+                                     (const char**) CCArgs.data() +
+                                       CCArgs.size(),
+                                     Diags);
+  if (Clang.getHeaderSearchOpts().UseBuiltinIncludes &&
+      Clang.getHeaderSearchOpts().ResourceDir.empty())
+    Clang.getHeaderSearchOpts().ResourceDir =
+      CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
+
+  // The worker outlives this compilation, so it has to free what it built.
+  Clang.getFrontendOpts().DisableFree = false;
+
+  if (ProcessWarningOptions(Diags, Clang.getDiagnosticOpts()) ||
+      Diags.getNumErrors())
+    return false;
+
+  llvm::OwningPtr<FrontendAction> Act(CreateFrontendAction(Clang));
+  return Act && Clang.ExecuteAction(*Act);
+}
+
+/// cc1_ast_worker - Serve the requests of CIndex's pool of AST workers until
+/// the end of the input on the socket whose descriptor is given, answering
+/// each one on the socket with its diagnostics and then a tag of 0 and a
+/// 32-bit status (zero on success).  Running in its own process, a worker
+/// isolates CIndex from crashes of the compiler, and serving many requests it
+/// only pays for starting up once.
+static int cc1_ast_worker(const char **ArgBegin, const char **ArgEnd,
+                          const char *Argv0, void *MainAddr) {
+#ifdef LLVM_ON_WIN32
+  return 1;
+#else
+  int Socket;
+  if (ArgEnd - ArgBegin != 1 ||
+      llvm::StringRef(ArgBegin[0]).getAsInteger(10, Socket))
+    return 1;
+
+  // Reading and writing go through separate streams, which a socket cannot
+  // share.
+  FILE *In = fdopen(Socket, "rb");
+  FILE *Out = In ? fdopen(dup(Socket), "wb") : 0;
+  if (!Out)
+    return 1;
+
+  std::vector<std::string> Request;
+  int Result = 0;
+  while (ReadWorkerRequest(In, Request)) {
+    uint32_t Status = RunWorkerRequest(Request, Out, Argv0, MainAddr) ? 0 : 1;
+    uint32_t Answer[2] = { 0, Status };
+    if (fwrite(Answer, sizeof(Answer), 1, Out) != 1 || fflush(Out)) {
+      Result = 1;
+      break;
+    }
+  }
+  fclose(Out);
+  fclose(In);
+  return Result;
+#endif
+}
+
+/// cc1_verify_batch - Check the -verify expectations of each input file in
+/// turn, compiling each one with the same options in a fresh compiler
+/// instance, and print a PASS or FAIL line per file on standard output.
+/// Batching the -verify tests that share their options saves the suite from
+/// starting up a compiler process for every one of them.
+static int cc1_verify_batch(const char **ArgBegin, const char **ArgEnd,
+                            const char *Argv0, void *MainAddr) {
+  TextDiagnosticPrinter ArgsClient(llvm::errs(), DiagnosticOptions());
+  Diagnostic ArgsDiags(&ArgsClient);
+  CompilerInvocation Base;
+  CompilerInvocation::CreateFromArgs(Base, ArgBegin, ArgEnd, ArgsDiags);
+  if (ArgsDiags.getNumErrors())
+    return 1;
+
+  if (Base.getHeaderSearchOpts().UseBuiltinIncludes &&
+      Base.getHeaderSearchOpts().ResourceDir.empty())
+    Base.getHeaderSearchOpts().ResourceDir =
+      CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
+  Base.getDiagnosticOpts().VerifyDiagnostics = true;
+
+  // Each file is compiled after the previous one's memory is released.
+  Base.getFrontendOpts().DisableFree = false;
+
+  std::vector<std::pair<FrontendOptions::InputKind, std::string> > Inputs;
+  Inputs.swap(Base.getFrontendOpts().Inputs);
+
+  unsigned NumFailed = 0;
+  for (unsigned I = 0, E = Inputs.size(); I != E; ++I) {
+    CompilerInstance Clang;
+    Clang.setLLVMContext(new llvm::LLVMContext);
+    Clang.setInvocation(new CompilerInvocation(Base));
+    Clang.getFrontendOpts().Inputs.push_back(Inputs[I]);
+
+    bool Success = false;
+    Clang.createDiagnostics(ArgEnd - ArgBegin, const_cast<char**>(ArgBegin));
+    if (Clang.hasDiagnostics()) {
+      llvm::llvm_install_error_handler(LLVMErrorHandler,
+                                    static_cast<void*>(&Clang.getDiagnostics()));
+      llvm::OwningPtr<FrontendAction> Act(CreateFrontendAction(Clang));
+      Success = Act && Clang.ExecuteAction(*Act);
+      llvm::llvm_remove_error_handler();
+    }
+
+    if (!Success)
+      ++NumFailed;
+    llvm::outs() << (Success ? "PASS: " : "FAIL: ") << Inputs[I].second
+                 << '\n';
+    llvm::outs().flush();
+  }
+
+  return NumFailed != 0;
+}
+
 int cc1_main(const char **ArgBegin, const char **ArgEnd,
              const char *Argv0, void *MainAddr) {
   CompilerInstance Clang;
@@ -210,6 +467,14 @@ int cc1_main(const char **ArgBegin, const char **ArgEnd,
   llvm::InitializeAllTargets();
   llvm::InitializeAllAsmPrinters();
 
+  // Serve AST generation requests from CIndex.
+  if (ArgBegin != ArgEnd && llvm::StringRef(ArgBegin[0]) == "-ast-worker")
+    return cc1_ast_worker(ArgBegin + 1, ArgEnd, Argv0, MainAddr);
+
+  // Check the -verify expectations of a batch of input files.
+  if (ArgBegin != ArgEnd && llvm::StringRef(ArgBegin[0]) == "-verify-batch")
+    return cc1_verify_batch(ArgBegin + 1, ArgEnd, Argv0, MainAddr);
+
   // Buffer diagnostics from argument parsing so that we can output them using a
   // well formed diagnostic object.
   TextDiagnosticBuffer DiagsBuffer;
@@ -269,9 +534,9 @@ int cc1_main(const char **ArgBegin, const char **ArgEnd,
       Success = Clang.ExecuteAction(*Act);
   }
 
-  // Managed static deconstruction. Useful for making things like
-  // -time-passes usable.
-  llvm::llvm_shutdown();
+  // The error handler refers to the diagnostics engine, which goes away with
+  // Clang; the driver may keep running after calling into cc1_main.
+  llvm::llvm_remove_error_handler();
 
   return !Success;
 }
@@ -0,0 +1,381 @@
+//===-- compile_server.cpp - Clang Compile Server -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the compile server started by clang
+// -ccc-compile-server, and the client side used by driver invocations when
+// CLANG_COMPILE_SERVER names the socket of a server.
+//
+// A request is sent over a Unix domain socket as the client's standard input,
+// output and error descriptors, followed by the 32-bit number of arguments,
+// the 32-bit number of environment entries, the 32-bit size of the strings and
+// the NUL-terminated strings themselves: the working directory, the arguments
+// and the environment.  The server answers with the 32-bit exit status of the
+// driver.
+//
+// The socket is only accessible to the user running the server, and requests
+// from other users are refused: a request runs arbitrary compiles, plugins
+// included, with the rights of the server.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Config/config.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetSelect.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifndef LLVM_ON_WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+#ifndef LLVM_ON_WIN32
+/// WriteAll - Write all of the given data to a socket, without raising
+/// SIGPIPE if the other end has gone away.
+static bool WriteAll(int Socket, const char *Data, size_t Size) {
+  while (Size) {
+#ifdef MSG_NOSIGNAL
+    ssize_t Written = ::send(Socket, Data, Size, MSG_NOSIGNAL);
+#else
+    ssize_t Written = ::send(Socket, Data, Size, 0);
+#endif
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    Data += Written;
+    Size -= Written;
+  }
+  return true;
+}
+
+/// ReadAll - Read exactly Size bytes from a socket.
+static bool ReadAll(int Socket, char *Data, size_t Size) {
+  while (Size) {
+    ssize_t Read = ::read(Socket, Data, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      return false;
+    Data += Read;
+    Size -= Read;
+  }
+  return true;
+}
+
+/// The descriptors of a client that a request hands over to the server.
+static const unsigned NumClientDescriptors = 3;
+
+/// The largest size of the strings of a request that the server accepts.
+static const uint32_t MaxRequestStringsSize = 16 * 1024 * 1024;
+
+/// SendDescriptors - Send this process's standard input, output and error
+/// descriptors over a socket.
+static bool SendDescriptors(int Socket) {
+  int FDs[NumClientDescriptors] = { 0, 1, 2 };
+  char Byte = 0;
+  struct iovec IOV;
+  IOV.iov_base = &Byte;
+  IOV.iov_len = 1;
+
+  char Control[CMSG_SPACE(sizeof(FDs))];
+  struct msghdr Msg;
+  memset(&Msg, 0, sizeof(Msg));
+  Msg.msg_iov = &IOV;
+  Msg.msg_iovlen = 1;
+  Msg.msg_control = Control;
+  Msg.msg_controllen = sizeof(Control);
+
+  struct cmsghdr *CMsg = CMSG_FIRSTHDR(&Msg);
+  CMsg->cmsg_level = SOL_SOCKET;
+  CMsg->cmsg_type = SCM_RIGHTS;
+  CMsg->cmsg_len = CMSG_LEN(sizeof(FDs));
+  memcpy(CMSG_DATA(CMsg), FDs, sizeof(FDs));
+
+  ssize_t Sent;
+  do
+    Sent = ::sendmsg(Socket, &Msg, 0);
+  while (Sent < 0 && errno == EINTR);
+  return Sent == 1;
+}
+
+/// ReceiveDescriptors - Receive the descriptors sent by SendDescriptors.
+static bool ReceiveDescriptors(int Socket, int (&FDs)[NumClientDescriptors]) {
+  char Byte;
+  struct iovec IOV;
+  IOV.iov_base = &Byte;
+  IOV.iov_len = 1;
+
+  char Control[CMSG_SPACE(sizeof(FDs))];
+  struct msghdr Msg;
+  memset(&Msg, 0, sizeof(Msg));
+  Msg.msg_iov = &IOV;
+  Msg.msg_iovlen = 1;
+  Msg.msg_control = Control;
+  Msg.msg_controllen = sizeof(Control);
+
+  ssize_t Received;
+  do
+    Received = ::recvmsg(Socket, &Msg, 0);
+  while (Received < 0 && errno == EINTR);
+  if (Received != 1)
+    return false;
+
+  struct cmsghdr *CMsg = CMSG_FIRSTHDR(&Msg);
+  if (!CMsg || CMsg->cmsg_level != SOL_SOCKET ||
+      CMsg->cmsg_type != SCM_RIGHTS || CMsg->cmsg_len != CMSG_LEN(sizeof(FDs)))
+    return false;
+  memcpy(FDs, CMSG_DATA(CMsg), sizeof(FDs));
+  return true;
+}
+
+/// GetSocketAddress - Fill in the address of the socket at Path.
+static bool GetSocketAddress(const char *Path, struct sockaddr_un &Addr) {
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (strlen(Path) >= sizeof(Addr.sun_path))
+    return false;
+  strcpy(Addr.sun_path, Path);
+  return true;
+}
+
+/// IsPeerSameUser - Return true if the process connected to Socket runs as
+/// the same user as this one.  Fails closed where the peer's credentials
+/// cannot be checked.
+static bool IsPeerSameUser(int Socket) {
+#if defined(SO_PEERCRED)
+  struct ucred Cred;
+  socklen_t Len = sizeof(Cred);
+  if (::getsockopt(Socket, SOL_SOCKET, SO_PEERCRED, &Cred, &Len))
+    return false;
+  return Cred.uid == ::geteuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__)
+  uid_t UID;
+  gid_t GID;
+  if (::getpeereid(Socket, &UID, &GID))
+    return false;
+  return UID == ::geteuid();
+#else
+  return false;
+#endif
+}
+
+/// AddString - Append a NUL-terminated string to the strings of a request.
+static void AddString(std::string &Strings, const char *Str) {
+  Strings += Str;
+  Strings += '\0';
+}
+
+/// ServeRequest - Run the request of the client on Socket, in a process of its
+/// own forked from the server.
+static void ServeRequest(int Socket, int (*Driver)(int, const char **)) {
+  int FDs[NumClientDescriptors];
+  uint32_t Header[3];
+  if (!ReceiveDescriptors(Socket, FDs))
+    ::_exit(1);
+  if (!ReadAll(Socket, (char*) Header, sizeof(Header)))
+    ::_exit(1);
+
+  // Every string is NUL-terminated, so there cannot be more of them than
+  // there are bytes.
+  if (Header[2] > MaxRequestStringsSize ||
+      uint64_t(Header[0]) + Header[1] + 1 > Header[2])
+    ::_exit(1);
+
+  std::vector<char> Strings(Header[2] + 1);
+  if (!ReadAll(Socket, &Strings[0], Header[2]))
+    ::_exit(1);
+  Strings[Header[2]] = '\0';
+
+  // Split the strings into the working directory, the arguments and the
+  // environment; missing strings are empty.
+  std::vector<char*> Ptrs;
+  for (unsigned I = 0, Pos = 0; I != 1 + Header[0] + Header[1]; ++I) {
+    Ptrs.push_back(&Strings[Pos]);
+    if (Pos < Header[2])
+      Pos += strlen(&Strings[Pos]) + 1;
+  }
+  if (Header[0] == 0)
+    ::_exit(1);
+
+  // Keep a trace of the request on the server's own error stream, before it
+  // is replaced by the client's.
+  llvm::errs() << "compile server: running '" << Ptrs[1] << "' in '"
+               << Ptrs[0] << "'\n";
+
+  // The driver works on behalf of the client: in its directory, with its
+  // environment, writing to its terminal or pipes.
+  for (unsigned I = 0; I != NumClientDescriptors; ++I) {
+    if (::dup2(FDs[I], I) == -1)
+      ::_exit(1);
+  }
+  for (unsigned I = 0; I != NumClientDescriptors; ++I)
+    if (FDs[I] >= (int) NumClientDescriptors)
+      ::close(FDs[I]);
+  if (::chdir(Ptrs[0]))
+    ::_exit(1);
+
+  std::vector<char*> Env(Ptrs.begin() + 1 + Header[0], Ptrs.end());
+  Env.push_back(0);
+  environ = &Env[0];
+
+  // The forked process is used for a single compilation, so its first clang
+  // -cc1 job may as well run in process.
+  std::vector<const char*> Args;
+  Args.push_back(Ptrs[1]);
+  Args.push_back("-ccc-integrated-cc1");
+  Args.insert(Args.end(), Ptrs.begin() + 2, Ptrs.begin() + 1 + Header[0]);
+  Args.push_back(0);
+
+  uint32_t Status = Driver(Args.size() - 1, &Args[0]);
+  llvm::outs().flush();
+  llvm::errs().flush();
+  fflush(0);
+  WriteAll(Socket, (const char*) &Status, sizeof(Status));
+  ::_exit(0);
+}
+#endif
+
+/// RunCompileServer - Serve the requests of clients connecting to the socket
+/// at SocketPath until the server is killed.  Each request runs the driver in
+/// a process forked from the server, which has already paid for loading the
+/// executable and initializing the targets; a crash only fails its request.
+int RunCompileServer(const char *SocketPath,
+                     int (*Driver)(int, const char **)) {
+#ifdef LLVM_ON_WIN32
+  llvm::errs() << "error: the compile server is not supported on this host\n";
+  return 1;
+#else
+  struct sockaddr_un Addr;
+  if (!GetSocketAddress(SocketPath, Addr)) {
+    llvm::errs() << "error: compile server socket path too long: '"
+                 << SocketPath << "'\n";
+    return 1;
+  }
+
+  // Create the socket with no access for other users; connecting to it is
+  // as good as running programs as this user.
+  int Listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ::unlink(SocketPath);
+  mode_t OldMask = ::umask(0177);
+  bool Bound = Listener != -1 &&
+               !::bind(Listener, (struct sockaddr*) &Addr, sizeof(Addr));
+  ::umask(OldMask);
+  if (!Bound || ::chmod(SocketPath, 0600) || ::listen(Listener, SOMAXCONN)) {
+    llvm::errs() << "error: cannot listen on compile server socket '"
+                 << SocketPath << "': " << strerror(errno) << "\n";
+    return 1;
+  }
+
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllAsmPrinters();
+  ::signal(SIGPIPE, SIG_IGN);
+
+  for (;;) {
+    // Reap the processes of the requests that have finished.
+    while (::waitpid(-1, 0, WNOHANG) > 0)
+      ;
+
+    int Socket = ::accept(Listener, 0, 0);
+    if (Socket == -1) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      llvm::errs() << "error: cannot accept compile server request: "
+                   << strerror(errno) << "\n";
+      return 1;
+    }
+
+    if (!IsPeerSameUser(Socket)) {
+      llvm::errs() << "compile server: refused a request from another user\n";
+      ::close(Socket);
+      continue;
+    }
+
+    pid_t Pid = ::fork();
+    if (Pid == 0) {
+      ::close(Listener);
+      ::signal(SIGPIPE, SIG_DFL);
+      ServeRequest(Socket, Driver);
+    }
+    ::close(Socket);
+  }
+#endif
+}
+
+/// ForwardToCompileServer - Run the driver invocation argv in the compile
+/// server listening on SocketPath.
+///
+/// \returns true if there is no server to run it, in which case the client
+/// should run it itself; false with the exit status of the invocation in Res
+/// otherwise.
+bool ForwardToCompileServer(const char *SocketPath, int argc,
+                            const char **argv, int &Res) {
+#ifdef LLVM_ON_WIN32
+  return true;
+#else
+  struct sockaddr_un Addr;
+  if (!GetSocketAddress(SocketPath, Addr))
+    return true;
+
+  int Socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Socket == -1)
+    return true;
+  if (::connect(Socket, (struct sockaddr*) &Addr, sizeof(Addr))) {
+    ::close(Socket);
+    return true;
+  }
+
+  std::vector<char> Cwd(4096);
+  while (!::getcwd(&Cwd[0], Cwd.size()) && errno == ERANGE)
+    Cwd.resize(Cwd.size() * 2);
+
+  std::string Strings;
+  AddString(Strings, &Cwd[0]);
+  for (int I = 0; I != argc; ++I)
+    AddString(Strings, argv[I]);
+  uint32_t NumEnv = 0;
+  for (char **Env = environ; *Env; ++Env, ++NumEnv)
+    AddString(Strings, *Env);
+
+  // Nothing has been run yet if the request cannot be sent, so the client
+  // can still fall back to running the invocation itself.
+  uint32_t Header[3] = { uint32_t(argc), NumEnv, uint32_t(Strings.size()) };
+  if (!SendDescriptors(Socket) ||
+      !WriteAll(Socket, (const char*) Header, sizeof(Header)) ||
+      !WriteAll(Socket, Strings.data(), Strings.size())) {
+    ::close(Socket);
+    return true;
+  }
+
+  uint32_t Status;
+  if (!ReadAll(Socket, (char*) &Status, sizeof(Status))) {
+    llvm::errs() << "error: compile server request for '" << argv[0]
+                 << "' terminated abnormally\n";
+    Status = 1;
+  }
+  ::close(Socket);
+  Res = Status;
+  return false;
+#endif
+}
@@ -199,15 +199,21 @@ void ApplyQAOverride(std::vector<const char*> &Args, const char *OverrideStr,
 extern int cc1_main(const char **ArgBegin, const char **ArgEnd,
                     const char *Argv0, void *MainAddr);
 
-int main(int argc, const char **argv) {
-  llvm::sys::PrintStackTraceOnErrorSignal();
-  llvm::PrettyStackTraceProgram X(argc, argv);
+/// The argv[0] of the driver, for cc1_main called from the driver.
+static const char *DriverArgv0;
 
-  // Dispatch to cc1_main if appropriate.
-  if (argc > 1 && llvm::StringRef(argv[1]) == "-cc1")
-    return cc1_main(argv+2, argv+argc, argv[0],
-                    (void*) (intptr_t) GetExecutablePath);
+static int ExecuteCC1InProcess(const char **ArgBegin, const char **ArgEnd) {
+  return cc1_main(ArgBegin, ArgEnd, DriverArgv0,
+                  (void*) (intptr_t) GetExecutablePath);
+}
 
+extern int RunCompileServer(const char *SocketPath,
+                            int (*Driver)(int, const char **));
+extern bool ForwardToCompileServer(const char *SocketPath, int argc,
+                                   const char **argv, int &Res);
+
+/// ExecuteDriver - Build and run the compilation of a driver invocation.
+static int ExecuteDriver(int argc, const char **argv) {
   bool CanonicalPrefixes = true;
   for (int i = 1; i < argc; ++i) {
     if (llvm::StringRef(argv[i]) == "-no-canonical-prefixes") {
@@ -230,6 +236,8 @@ int main(int argc, const char **argv) {
   Driver TheDriver(Path.getBasename(), Path.getDirname(),
                    llvm::sys::getHostTriple(),
                    "a.out", IsProduction, Diags);
+  DriverArgv0 = argv[0];
+  TheDriver.CC1Main = ExecuteCC1InProcess;
 
   // Check for ".*++" or ".*++-[^-]*" to determine if we are a C++
   // compiler. This matches things like "c++", "clang++", and "clang++-1.1".
@@ -288,6 +296,41 @@ int main(int argc, const char **argv) {
   int Res = 0;
   if (C.get())
     Res = TheDriver.ExecuteCompilation(*C);
+  return Res;
+}
+
+int main(int argc, const char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram X(argc, argv);
+
+  // Dispatch to cc1_main if appropriate.
+  if (argc > 1 && llvm::StringRef(argv[1]) == "-cc1") {
+    int Res = cc1_main(argv+2, argv+argc, argv[0],
+                       (void*) (intptr_t) GetExecutablePath);
+
+    // Managed static deconstruction. Useful for making things like
+    // -time-passes usable.
+    llvm::llvm_shutdown();
+    return Res;
+  }
+
+  // Serve driver invocations forwarded by clients, or forward this one if
+  // CLANG_COMPILE_SERVER names the socket of a server.
+  if (argc > 1 && llvm::StringRef(argv[1]) == "-ccc-compile-server") {
+    if (argc != 3) {
+      llvm::errs() << "error: usage: " << argv[0]
+                   << " -ccc-compile-server <socket>\n";
+      return 1;
+    }
+    return RunCompileServer(argv[2], ExecuteDriver);
+  }
+  if (const char *SocketPath = ::getenv("CLANG_COMPILE_SERVER")) {
+    int Res;
+    if (*SocketPath && !ForwardToCompileServer(SocketPath, argc, argv, Res))
+      return Res;
+  }
+
+  int Res = ExecuteDriver(argc, argv);
 
   llvm::llvm_shutdown();
 
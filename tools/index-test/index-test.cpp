@@ -0,0 +1,285 @@
+//===--- index-test.cpp - Indexing test bed -------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This utility indexes a set of AST files with idx::Indexer and reports the
+// translation units that an entity is found in.
+//
+// The AST files are indexed on the number of threads given by -j.  With
+// -unload, the AST of each translation unit is unloaded as soon as it has
+// been indexed, and loaded again only to resolve the entity in it, so that
+// only a few ASTs are in memory at any time.
+//
+// Usage:
+//   index-test [-j <threads>] [-unload] -find <name> <AST files>
+//
+// prints, for each translation unit that declares the global <name>, the
+// location and kind of the declaration found in it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Index/DeclReferenceMap.h"
+#include "clang/Index/Entity.h"
+#include "clang/Index/Handlers.h"
+#include "clang/Index/Indexer.h"
+#include "clang/Index/Program.h"
+#include "clang/Index/SelectorMap.h"
+#include "clang/Index/TranslationUnit.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Mutex.h"
+#include "llvm/System/Signals.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(LLVM_ON_UNIX) && defined(ENABLE_THREADS) && ENABLE_THREADS != 0
+#include <pthread.h>
+#define HAVE_INDEX_THREADS 1
+#endif
+
+using namespace clang;
+using namespace idx;
+
+static llvm::cl::list<std::string>
+InputFilenames(llvm::cl::Positional, llvm::cl::desc("<AST files>"));
+
+static llvm::cl::opt<std::string>
+FindName("find", llvm::cl::desc("Print the declarations of the given global "
+                                "name in the translation units it is in"),
+         llvm::cl::value_desc("name"));
+
+static llvm::cl::opt<unsigned>
+NumThreads("j", llvm::cl::desc("Number of threads to index with"),
+           llvm::cl::init(1));
+
+static llvm::cl::opt<bool>
+Unload("unload",
+       llvm::cl::desc("Unload each AST once it has been indexed"));
+
+namespace {
+
+/// \brief A translation unit whose AST is loaded from an AST file on demand.
+class IndexedTU : public TranslationUnit {
+  std::string FileName;
+  llvm::OwningPtr<Diagnostic> Diags;
+  llvm::OwningPtr<ASTUnit> AST;
+  llvm::OwningPtr<DeclReferenceMap> DeclRefMap;
+  llvm::OwningPtr<SelectorMap> SelMap;
+
+public:
+  explicit IndexedTU(const std::string &F) : FileName(F) { }
+
+  const std::string &getFileName() const { return FileName; }
+
+  /// \brief Load the AST, unless it is loaded already.  Returns true on
+  /// error.
+  bool load() {
+    if (AST)
+      return false;
+
+    DiagnosticOptions DiagOpts;
+    if (!Diags)
+      Diags.reset(CompilerInstance::createDiagnostics(DiagOpts, 0, 0));
+    AST.reset(ASTUnit::LoadFromPCHFile(FileName, *Diags));
+    return !AST;
+  }
+
+  /// \brief Destroy the AST, after telling the indexer to forget it.
+  void unload(Indexer &Idxer) {
+    if (!AST)
+      return;
+
+    Idxer.UnloadAST(this);
+    DeclRefMap.reset();
+    SelMap.reset();
+    AST.reset();
+  }
+
+  virtual ASTContext &getASTContext() {
+    assert(AST && "AST is not loaded");
+    return AST->getASTContext();
+  }
+
+  virtual DeclReferenceMap &getDeclReferenceMap() {
+    if (!DeclRefMap)
+      DeclRefMap.reset(new DeclReferenceMap(getASTContext()));
+    return *DeclRefMap;
+  }
+
+  virtual SelectorMap &getSelectorMap() {
+    if (!SelMap)
+      SelMap.reset(new SelectorMap(getASTContext()));
+    return *SelMap;
+  }
+};
+
+/// \brief The state shared by the threads indexing the translation units.
+struct IndexState {
+  Program Prog;
+  Indexer Idxer;
+  std::vector<IndexedTU *> TUs;
+
+  /// \brief Guards the members below.
+  llvm::sys::Mutex Lock;
+
+  /// \brief The index of the next translation unit to index.
+  unsigned Next;
+
+  /// \brief The entity named by -find, once found in a translation unit.
+  Entity Found;
+
+  bool Failed;
+
+  IndexState() : Idxer(Prog), Next(0), Failed(false) { }
+};
+
+bool CompareFileNames(const IndexedTU *LHS, const IndexedTU *RHS) {
+  return LHS->getFileName() < RHS->getFileName();
+}
+
+} // end anonymous namespace
+
+/// FindGlobal - Get the entity of the global declaration of \p Name in \p TU.
+static Entity FindGlobal(IndexedTU &TU, llvm::StringRef Name, Program &Prog) {
+  ASTContext &Ctx = TU.getASTContext();
+  DeclarationName DN(&Ctx.Idents.get(Name));
+  DeclContext::lookup_result R = Ctx.getTranslationUnitDecl()->lookup(DN);
+  if (R.first == R.second)
+    return Entity();
+
+  Entity Ent = Entity::get(*R.first, Prog);
+  if (Ent.isInvalid() || Ent.isInternalToTU())
+    return Entity();
+  return Ent;
+}
+
+/// IndexInputs - Index translation units until there are none left.
+static void IndexInputs(IndexState &S) {
+  for (;;) {
+    IndexedTU *TU;
+    {
+      llvm::sys::ScopedLock Guard(S.Lock);
+      if (S.Next == S.TUs.size())
+        return;
+      TU = S.TUs[S.Next++];
+    }
+
+    if (TU->load()) {
+      llvm::sys::ScopedLock Guard(S.Lock);
+      llvm::errs() << "error: unable to load '" << TU->getFileName() << "'\n";
+      S.Failed = true;
+      continue;
+    }
+
+    S.Idxer.IndexAST(TU);
+
+    if (!FindName.empty()) {
+      Entity Ent = FindGlobal(*TU, FindName, S.Prog);
+      llvm::sys::ScopedLock Guard(S.Lock);
+      if (Ent.isValid() && S.Found.isInvalid())
+        S.Found = Ent;
+    }
+
+    if (Unload)
+      TU->unload(S.Idxer);
+  }
+}
+
+#ifdef HAVE_INDEX_THREADS
+static void *IndexThreadMain(void *Arg) {
+  IndexInputs(*static_cast<IndexState *>(Arg));
+  return 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram X(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "clang index test\n");
+  llvm::llvm_shutdown_obj Y;
+
+  IndexState S;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i)
+    S.TUs.push_back(new IndexedTU(InputFilenames[i]));
+
+#ifdef HAVE_INDEX_THREADS
+  std::vector<pthread_t> Threads;
+  for (unsigned i = 1; i < NumThreads; ++i) {
+    pthread_t Thread;
+    if (pthread_create(&Thread, 0, IndexThreadMain, &S) != 0)
+      break;
+    Threads.push_back(Thread);
+  }
+  IndexInputs(S);
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    pthread_join(Threads[i], 0);
+#else
+  IndexInputs(S);
+#endif
+
+  if (!FindName.empty()) {
+    if (S.Found.isInvalid()) {
+      llvm::errs() << "error: no global named '" << FindName << "'\n";
+      S.Failed = true;
+    } else {
+      Storing<TranslationUnitHandler> TURes;
+      S.Idxer.GetTranslationUnitsFor(S.Found, TURes);
+
+      std::vector<IndexedTU *> Found;
+      for (Storing<TranslationUnitHandler>::iterator
+             I = TURes.begin(), E = TURes.end(); I != E; ++I)
+        Found.push_back(static_cast<IndexedTU *>(*I));
+      std::sort(Found.begin(), Found.end(), CompareFileNames);
+
+      for (unsigned i = 0, e = Found.size(); i != e; ++i) {
+        IndexedTU *TU = Found[i];
+        if (TU->load()) {
+          llvm::errs() << "error: unable to load '" << TU->getFileName()
+                       << "'\n";
+          S.Failed = true;
+          continue;
+        }
+
+        ASTContext &Ctx = TU->getASTContext();
+        Decl *D = S.Found.getDecl(Ctx);
+        if (!D) {
+          llvm::outs() << TU->getFileName() << ": <not found>\n";
+        } else {
+          PresumedLoc PLoc =
+            Ctx.getSourceManager().getPresumedLoc(D->getLocation());
+          llvm::outs() << PLoc.getFilename() << ':' << PLoc.getLine() << ':'
+                       << PLoc.getColumn() << ": " << D->getDeclKindName();
+          if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+            if (FD->isThisDeclarationADefinition())
+              llvm::outs() << " (definition)";
+          llvm::outs() << '\n';
+        }
+
+        if (Unload)
+          TU->unload(S.Idxer);
+      }
+    }
+  }
+
+  for (unsigned i = 0, e = S.TUs.size(); i != e; ++i) {
+    S.TUs[i]->unload(S.Idxer);
+    delete S.TUs[i];
+  }
+
+  return S.Failed;
+}
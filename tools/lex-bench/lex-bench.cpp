@@ -0,0 +1,400 @@
+//===-- lex-bench.cpp - Lexer and Preprocessor Benchmark ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool measures the throughput of the lexer and the preprocessor over a
+// set of files, in tokens per second: raw lexing with
+// Lexer::LexFromRawLexer, full preprocessing, and preprocessing from the
+// tokens cached in a PTH file.
+//
+// With warm caches, a run that is not timed first reads the files, and the
+// timed runs reuse the file manager and source manager it filled.  With
+// -cold, each run starts with new managers, and the operating system is
+// asked to evict the files read by the previous runs from its cache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Lex/DirectoryLookup.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/PTHManager.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Host.h"
+#include "llvm/System/Signals.h"
+#include "llvm/System/TimeValue.h"
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef LLVM_ON_WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace clang;
+
+enum BenchMode {
+  RawLex, Preprocess, PTHPreprocess
+};
+
+enum InputLanguage {
+  LangC, LangCXX, LangObjC
+};
+
+static llvm::cl::list<std::string>
+InputFiles(llvm::cl::Positional, llvm::cl::OneOrMore,
+           llvm::cl::desc("<input files>"));
+
+static llvm::cl::list<BenchMode>
+Modes("mode", llvm::cl::desc("Benchmark to run (default: raw and pp, and pth "
+                             "with -pth):"),
+      llvm::cl::values(
+        clEnumValN(RawLex, "raw", "Raw lexing with Lexer::LexFromRawLexer"),
+        clEnumValN(Preprocess, "pp", "Full preprocessing"),
+        clEnumValN(PTHPreprocess, "pth",
+                   "Preprocessing from the tokens cached in -pth"),
+        clEnumValEnd));
+
+static llvm::cl::opt<InputLanguage>
+Language("x", llvm::cl::desc("Language of the input files:"),
+         llvm::cl::init(LangC),
+         llvm::cl::values(
+           clEnumValN(LangC, "c", "C99"),
+           clEnumValN(LangCXX, "c++", "C++"),
+           clEnumValN(LangObjC, "objective-c", "Objective-C"),
+           clEnumValEnd));
+
+static llvm::cl::list<std::string>
+IncludePaths("I", llvm::cl::Prefix,
+             llvm::cl::desc("Add a directory to the include search path"),
+             llvm::cl::value_desc("directory"));
+
+static llvm::cl::list<std::string>
+MacroDefinitions("D", llvm::cl::Prefix,
+                 llvm::cl::desc("Define a macro, as <name> or <name>=<value>"),
+                 llvm::cl::value_desc("macro"));
+
+static llvm::cl::opt<std::string>
+TokenCache("pth", llvm::cl::desc("PTH file to preprocess from"),
+           llvm::cl::value_desc("file"));
+
+static llvm::cl::opt<unsigned>
+NumRuns("runs", llvm::cl::desc("Number of timed runs of each benchmark"),
+        llvm::cl::init(5));
+
+static llvm::cl::opt<bool>
+Cold("cold", llvm::cl::desc("Start each run with cold file caches"));
+
+static llvm::cl::opt<bool>
+PrintStats("print-stats",
+           llvm::cl::desc("Print the statistics of the source manager, "
+                          "header search and PTH manager after the last run "
+                          "of each benchmark"));
+
+static double GetWallTime() {
+  llvm::sys::TimeValue Now = llvm::sys::TimeValue::now();
+  return Now.seconds() + Now.microseconds() / 1000000.0;
+}
+
+/// DropFileCache - Ask the operating system to evict the contents of a file
+/// from its cache, so that the next read of the file goes to the disk.
+static void DropFileCache(const std::string &Path) {
+#if !defined(LLVM_ON_WIN32) && defined(POSIX_FADV_DONTNEED)
+  int FD = ::open(Path.c_str(), O_RDONLY);
+  if (FD == -1)
+    return;
+  ::posix_fadvise(FD, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(FD);
+#endif
+}
+
+namespace {
+/// BenchDiagnosticClient - Print the warnings and errors of the benchmarked
+/// preprocessor, without their source lines, and count the errors.
+class BenchDiagnosticClient : public DiagnosticClient {
+public:
+  unsigned NumErrors;
+
+  BenchDiagnosticClient() : NumErrors(0) {}
+
+  virtual void HandleDiagnostic(Diagnostic::Level Level,
+                                const DiagnosticInfo &Info) {
+    if (Level < Diagnostic::Warning)
+      return;
+    if (Level >= Diagnostic::Error)
+      ++NumErrors;
+
+    llvm::SmallString<100> Message;
+    Info.FormatDiagnostic(Message);
+    llvm::errs() << (Level >= Diagnostic::Error ? "error: " : "warning: ")
+                 << Message.str() << "\n";
+  }
+};
+
+/// LexBench - The state of the benchmarks that is shared by all of their
+/// runs.
+class LexBench {
+  Diagnostic &Diags;
+  const LangOptions &LangOpts;
+  const TargetInfo &Target;
+  std::string Predefines;
+
+  /// FilesRead - The files read by the runs so far, whose contents are
+  /// evicted from the operating system's cache before a cold run.
+  std::set<std::string> FilesRead;
+
+  /// FileMgr, SourceMgr - The managers of the current run, which are kept
+  /// from one run to the next when the caches are warm.
+  llvm::OwningPtr<FileManager> FileMgr;
+  llvm::OwningPtr<SourceManager> SourceMgr;
+
+  void ResetManagers() {
+    SourceMgr.reset();
+    FileMgr.reset(new FileManager());
+    SourceMgr.reset(new SourceManager());
+  }
+
+  void RecordFilesRead() {
+    for (SourceManager::fileinfo_iterator I = SourceMgr->fileinfo_begin(),
+           E = SourceMgr->fileinfo_end(); I != E; ++I)
+      FilesRead.insert(I->first->getName());
+  }
+
+  const FileEntry *getInputFile(const std::string &Name) {
+    const FileEntry *File = FileMgr->getFile(Name);
+    if (!File)
+      llvm::errs() << "error: cannot open '" << Name << "'\n";
+    return File;
+  }
+
+  bool LexRaw(uint64_t &NumTokens);
+  bool LexPreprocessed(BenchMode Mode, bool IsLastRun, uint64_t &NumTokens);
+
+public:
+  LexBench(Diagnostic &diags, const LangOptions &langOpts,
+           const TargetInfo &target);
+
+  /// Run - Run a benchmark, and print the number of tokens it produced and
+  /// their rate.  Returns true on error.
+  bool Run(BenchMode Mode);
+};
+}
+
+LexBench::LexBench(Diagnostic &diags, const LangOptions &langOpts,
+                   const TargetInfo &target)
+  : Diags(diags), LangOpts(langOpts), Target(target) {
+  for (unsigned i = 0, e = MacroDefinitions.size(); i != e; ++i) {
+    std::string Macro = MacroDefinitions[i];
+    std::string::size_type Equal = Macro.find('=');
+    if (Equal == std::string::npos)
+      Macro += " 1";
+    else
+      Macro[Equal] = ' ';
+    Predefines += "#define " + Macro + "\n";
+  }
+}
+
+/// LexRaw - Lex each input file with Lexer::LexFromRawLexer.
+bool LexBench::LexRaw(uint64_t &NumTokens) {
+  for (unsigned i = 0, e = InputFiles.size(); i != e; ++i) {
+    const FileEntry *File = getInputFile(InputFiles[i]);
+    if (!File)
+      return true;
+
+    FileID FID = SourceMgr->createFileID(File, SourceLocation(),
+                                         SrcMgr::C_User);
+    Lexer RawLex(FID, SourceMgr->getBuffer(FID), *SourceMgr, LangOpts);
+    Token Tok;
+    for (RawLex.LexFromRawLexer(Tok); Tok.isNot(tok::eof);
+         RawLex.LexFromRawLexer(Tok))
+      ++NumTokens;
+  }
+  return false;
+}
+
+/// LexPreprocessed - Preprocess each input file as a translation unit of its
+/// own.
+bool LexBench::LexPreprocessed(BenchMode Mode, bool IsLastRun,
+                               uint64_t &NumTokens) {
+  for (unsigned i = 0, e = InputFiles.size(); i != e; ++i) {
+    // The stat cache that the PTH manager installs in the file manager goes
+    // away with the manager, so the file manager cannot outlive it.
+    if (Mode == PTHPreprocess && i != 0) {
+      RecordFilesRead();
+      ResetManagers();
+    }
+
+    const FileEntry *File = getInputFile(InputFiles[i]);
+    if (!File)
+      return true;
+
+    HeaderSearch HeaderInfo(*FileMgr);
+    std::vector<DirectoryLookup> SearchDirs;
+    for (unsigned j = 0, je = IncludePaths.size(); j != je; ++j) {
+      if (const DirectoryEntry *Dir = FileMgr->getDirectory(IncludePaths[j]))
+        SearchDirs.push_back(DirectoryLookup(Dir, SrcMgr::C_User,
+                                             /*isUser=*/true,
+                                             /*isFramework=*/false));
+    }
+    HeaderInfo.SetSearchPaths(SearchDirs, SearchDirs.size(),
+                              /*noCurDirSearch=*/false);
+
+    PTHManager *PTHMgr = 0;
+    if (Mode == PTHPreprocess) {
+      PTHMgr = PTHManager::Create(TokenCache, Diags);
+      if (!PTHMgr)
+        return true;
+    }
+
+    SourceMgr->clearIDTables();
+    Preprocessor PP(Diags, LangOpts, Target, *SourceMgr, HeaderInfo, PTHMgr);
+    if (PTHMgr) {
+      PTHMgr->setPreprocessor(&PP);
+      PP.setPTHManager(PTHMgr);
+    }
+    PP.setPredefines(Predefines);
+
+    SourceMgr->createMainFileID(File, SourceLocation());
+    PP.EnterMainSourceFile();
+    Token Tok;
+    for (PP.Lex(Tok); Tok.isNot(tok::eof); PP.Lex(Tok))
+      ++NumTokens;
+
+    if (PrintStats && IsLastRun && i == e - 1) {
+      HeaderInfo.PrintStats();
+      if (PTHMgr)
+        PTHMgr->PrintStats();
+    }
+  }
+  return false;
+}
+
+bool LexBench::Run(BenchMode Mode) {
+  const char *Name = Mode == RawLex ? "raw" :
+                     Mode == Preprocess ? "pp" : "pth";
+  if (Mode == PTHPreprocess) {
+    if (TokenCache.empty()) {
+      llvm::errs() << "error: -mode=pth requires -pth\n";
+      return true;
+    }
+    FilesRead.insert(TokenCache);
+  }
+
+  // The untimed run that fills the caches.
+  ResetManagers();
+  uint64_t NumTokens = 0;
+  if (!Cold && (Mode == RawLex ? LexRaw(NumTokens)
+                               : LexPreprocessed(Mode, false, NumTokens)))
+    return true;
+
+  double BestTime = 0;
+  for (unsigned Run = 0; Run != NumRuns; ++Run) {
+    bool IsLastRun = Run == NumRuns - 1;
+    RecordFilesRead();
+    if (Cold) {
+      ResetManagers();
+      for (std::set<std::string>::iterator I = FilesRead.begin(),
+             E = FilesRead.end(); I != E; ++I)
+        DropFileCache(*I);
+    } else if (Mode == PTHPreprocess)
+      ResetManagers();
+    else
+      SourceMgr->clearIDTables();
+
+    NumTokens = 0;
+    double Start = GetWallTime();
+    if (Mode == RawLex ? LexRaw(NumTokens)
+                       : LexPreprocessed(Mode, IsLastRun, NumTokens))
+      return true;
+    double Time = GetWallTime() - Start;
+    if (Run == 0 || Time < BestTime)
+      BestTime = Time;
+  }
+
+  if (PrintStats) {
+    FileMgr->PrintStats();
+    SourceMgr->PrintStats();
+  }
+
+  llvm::outs() << Name << " (" << (Cold ? "cold" : "warm") << "): "
+               << NumTokens << " tokens in "
+               << llvm::format("%.3f", BestTime * 1000) << " ms";
+  if (BestTime > 0)
+    llvm::outs() << ", "
+                 << llvm::format("%.0f", NumTokens / BestTime) << " tokens/s";
+  llvm::outs() << "\n";
+  llvm::outs().flush();
+  return false;
+}
+
+static void InitializeLangOptions(LangOptions &Opts) {
+  Opts.BCPLComment = 1;
+  Opts.Digraphs = 1;
+  Opts.C99 = 1;
+  Opts.DollarIdents = 1;
+  switch (Language) {
+  case LangC:
+    break;
+  case LangCXX:
+    Opts.CPlusPlus = 1;
+    Opts.Bool = 1;
+    break;
+  case LangObjC:
+    Opts.ObjC1 = Opts.ObjC2 = 1;
+    break;
+  }
+}
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::llvm_shutdown_obj Y;
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "clang lexer and preprocessor benchmark\n");
+
+  BenchDiagnosticClient DiagClient;
+  Diagnostic Diags(&DiagClient);
+
+  TargetOptions TargetOpts;
+  TargetOpts.Triple = llvm::sys::getHostTriple();
+  llvm::OwningPtr<TargetInfo> Target(TargetInfo::CreateTargetInfo(Diags,
+                                                                  TargetOpts));
+  if (!Target)
+    return 1;
+
+  LangOptions LangOpts;
+  InitializeLangOptions(LangOpts);
+
+  std::vector<BenchMode> BenchModes(Modes.begin(), Modes.end());
+  if (BenchModes.empty()) {
+    BenchModes.push_back(RawLex);
+    BenchModes.push_back(Preprocess);
+    if (!TokenCache.empty())
+      BenchModes.push_back(PTHPreprocess);
+  }
+
+  LexBench Bench(Diags, LangOpts, *Target);
+  for (unsigned i = 0, e = BenchModes.size(); i != e; ++i)
+    if (Bench.Run(BenchModes[i]))
+      return 1;
+
+  return DiagClient.NumErrors != 0;
+}
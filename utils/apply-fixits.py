@@ -0,0 +1,172 @@
+#!/usr/bin/env python
+
+"""
+Apply the fix-it records written by 'clang -cc1 -fixit -fixit-record <file>'.
+
+Compiling each translation unit of a project with -fixit-record appends the
+edits its fix-its make, to the main file and to every header, to a shared
+record file.  This script merges the records: an edit recorded by several
+translation units, as the edits to a common header are, is made once, and
+each file is rewritten once, with the files rewritten in parallel:
+
+  apply-fixits.py [-j <jobs>] [--dry-run] <record file>...
+
+Edits that overlap a different edit to the same text are reported and not
+made.  Each file is rewritten by renaming a new file over it, so an
+interrupted run never leaves a file half-written.
+"""
+
+import json
+import multiprocessing
+import optparse
+import os
+import shutil
+import sys
+import tempfile
+
+###
+
+def readRecords(paths):
+    """Return a map from each file to its distinct edits, in the order they
+    were first recorded, and the number of duplicate records."""
+    edits = {}
+    seen = set()
+    duplicates = 0
+    for path in paths:
+        f = open(path)
+        for lineNo, line in enumerate(f):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                r = json.loads(line)
+                edit = (r['file'], int(r['offset']), int(r['length']),
+                        r['replacement'].encode('utf-8'))
+            except (ValueError, KeyError, TypeError):
+                raise SystemExit('%s:%d: invalid fix-it record' %
+                                 (path, lineNo + 1))
+            if edit in seen:
+                duplicates += 1
+                continue
+            seen.add(edit)
+            edits.setdefault(edit[0], []).append(edit[1:])
+        f.close()
+    return edits, duplicates
+
+def orderEdits(edits):
+    """Order the edits to a file by offset, dropping the edits that conflict
+    with an edit recorded before them.  Returns the ordered edits and the
+    dropped ones."""
+    kept, dropped = [], []
+    for index, (offset, length, text) in enumerate(edits):
+        conflict = False
+        for (o, l, t, i) in kept:
+            if length and l:
+                # Two replacements of overlapping text.
+                conflict = offset < o + l and o < offset + length
+            elif length:
+                conflict = offset < o < offset + length
+            elif l:
+                conflict = o < offset < o + l
+            if conflict:
+                break
+        if conflict:
+            dropped.append((offset, length, text))
+        else:
+            kept.append((offset, length, text, index))
+
+    # An insertion goes before the text inserted at the same offset by the
+    # records before it, and before the text replacing what follows.
+    def key(edit):
+        offset, length, text, index = edit
+        if length:
+            return (offset, 1, index)
+        return (offset, 0, -index)
+    kept.sort(key=key)
+    return [e[:3] for e in kept], dropped
+
+def applyEdits(item):
+    """Rewrite one file.  Returns the number of edits made and a list of
+    messages for the user."""
+    path, edits, dryRun = item
+    messages = []
+    ordered, dropped = orderEdits(edits)
+    for (offset, length, text) in dropped:
+        messages.append('%s: edit of %d characters at offset %d conflicts '
+                        'with another edit; not made' % (path, length, offset))
+
+    try:
+        f = open(path, 'rb')
+        data = f.read()
+        f.close()
+    except IOError, e:
+        return 0, messages + ['%s: %s; not rewritten' % (path, e.strerror)]
+
+    if [e for e in ordered if e[0] + e[1] > len(data)]:
+        return 0, messages + ['%s: the file changed since its fix-its were '
+                              'recorded; not rewritten' % path]
+
+    pieces = []
+    pos = 0
+    for (offset, length, text) in ordered:
+        pieces.append(data[pos:offset])
+        pieces.append(text)
+        pos = max(pos, offset + length)
+    pieces.append(data[pos:])
+    result = ''.join(pieces)
+
+    if dryRun or result == data:
+        return len(ordered), messages
+
+    fd, temp = tempfile.mkstemp(dir=os.path.dirname(path) or '.',
+                                prefix=os.path.basename(path) + '.')
+    try:
+        os.write(fd, result)
+        os.close(fd)
+        shutil.copymode(path, temp)
+        os.rename(temp, path)
+    except OSError, e:
+        os.unlink(temp)
+        return 0, messages + ['%s: %s; not rewritten' % (path, e.strerror)]
+    return len(ordered), messages
+
+def main():
+    parser = optparse.OptionParser("usage: %prog [options] <record file>...")
+    parser.add_option("-j", "--jobs", dest="jobs", type="int",
+                      help="Number of files to rewrite at once",
+                      default=multiprocessing.cpu_count())
+    parser.add_option("-n", "--dry-run", dest="dryRun", action="store_true",
+                      help="Only report the edits and their conflicts",
+                      default=False)
+    opts, args = parser.parse_args()
+    if not args:
+        parser.error("no record files given")
+
+    edits, duplicates = readRecords(args)
+    items = [(path, fileEdits, opts.dryRun)
+             for path, fileEdits in sorted(edits.items())]
+
+    if opts.jobs > 1 and len(items) > 1:
+        pool = multiprocessing.Pool(opts.jobs)
+        results = pool.map(applyEdits, items)
+        pool.close()
+        pool.join()
+    else:
+        results = map(applyEdits, items)
+
+    failed = False
+    numEdits = 0
+    for count, messages in results:
+        numEdits += count
+        for message in messages:
+            print >>sys.stderr, 'apply-fixits: %s' % message
+            failed = True
+
+    print '%s %d edits to %d files (%d duplicate records)' % (
+        opts.dryRun and 'would make' or 'made', numEdits, len(items),
+        duplicates)
+    if failed:
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,312 @@
+#!/usr/bin/env python
+
+"""
+Compile-time performance benchmarks.
+
+Generates a fixed corpus of synthetic translation units, one per workload
+(preprocessor-heavy C, template-heavy C++, Objective-C, building and loading
+a PCH file, code completion and the static analyzer), and times 'clang -cc1'
+over each of them with -phase-stats-file.  For every benchmark it reports the
+best wall time of the whole translation unit and of its top-level phases, and
+the largest heap growth.
+
+Save the results of a trusted build as a baseline, then compare other builds
+against it; regressions beyond the tolerance make the script exit with 1:
+
+  clang-perf.py --clang=/path/to/old/clang --save-baseline=perf.json
+  clang-perf.py --clang=/path/to/new/clang --baseline=perf.json
+
+The corpus is generated from fixed seeds, so results are only comparable
+between runs with the same --scale.
+"""
+
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+###
+
+def generatePreprocessorC(out, n):
+    print >>out, '#define CAT_(a, b) a ## b'
+    print >>out, '#define CAT(a, b) CAT_(a, b)'
+    print >>out, '#define STR_(a) #a'
+    print >>out, '#define STR(a) STR_(a)'
+    print >>out, '#define MAX(a, b) ((a) > (b) ? (a) : (b))'
+    print >>out, '#define MAX4(a, b, c, d) MAX(MAX(a, b), MAX(c, d))'
+    print >>out, '#define MAX16(a, b, c, d) \\'
+    print >>out, '  MAX4(MAX4(a, b, c, d), MAX4(b, c, d, a), \\'
+    print >>out, '       MAX4(c, d, a, b), MAX4(d, a, b, c))'
+    print >>out, '#define FIELD(T, name, i) T CAT(name, i);'
+    for i in range(n):
+        print >>out, '#if %d %% 3 == 0 && defined(CAT)' % i
+        print >>out, ('struct CAT(s, %d) { FIELD(int, f, 0) '
+                      'FIELD(long, f, 1) };' % i)
+        print >>out, '#elif %d %% 3 == 1' % i
+        print >>out, 'struct CAT(s, %d) { FIELD(char, g, 0) };' % i
+        print >>out, '#else'
+        print >>out, 'struct CAT(s, %d) { FIELD(short, h, 0) };' % i
+        print >>out, '#endif'
+        print >>out, ('int CAT(f, %d)(int a, int b, int c, int d) '
+                      '{ return MAX16(a, b, c, d) + sizeof(STR(%d)); }'
+                      % (i, i))
+
+def generateTemplatesCXX(out, n):
+    print >>out, 'template<int N> struct Fib {'
+    print >>out, '  enum { value = Fib<N-1>::value + Fib<N-2>::value };'
+    print >>out, '};'
+    print >>out, 'template<> struct Fib<0> { enum { value = 0 }; };'
+    print >>out, 'template<> struct Fib<1> { enum { value = 1 }; };'
+    print >>out, 'template<typename T, int N> struct Array {'
+    print >>out, '  T data[N];'
+    print >>out, '  T &operator[](int i) { return data[i]; }'
+    print >>out, '  template<typename U> U sum() const {'
+    print >>out, '    U s = U(); for (int i = 0; i != N; ++i) s += data[i];'
+    print >>out, '    return s;'
+    print >>out, '  }'
+    print >>out, '};'
+    print >>out, 'template<typename T> struct Wrap { T value; };'
+    for i in range(n):
+        print >>out, 'struct T%d { int x; };' % i
+        print >>out, ('long g%d() { Array<Wrap<long>, %d> a; '
+                      'Array<int, Fib<%d>::value + 1> b; '
+                      'return a[0].value + b.sum<long>(); }'
+                      % (i, i % 16 + 1, i % 20))
+
+def generateObjC(out, n):
+    print >>out, '@interface Root { Class isa; }'
+    print >>out, '+ (id)alloc;'
+    print >>out, '- (id)init;'
+    print >>out, '@end'
+    for i in range(n):
+        print >>out, '@interface C%d : Root {' % i
+        print >>out, '  int count;'
+        print >>out, '  id next;'
+        print >>out, '}'
+        print >>out, '- (int)count;'
+        print >>out, '- (void)setCount:(int)c;'
+        print >>out, '- (id)combine:(id)other with:(int)k;'
+        print >>out, '@end'
+        print >>out, '@implementation C%d' % i
+        print >>out, '- (int)count { return count; }'
+        print >>out, '- (void)setCount:(int)c { count = c; }'
+        print >>out, '- (id)combine:(id)other with:(int)k {'
+        print >>out, '  C%d *o = [[C%d alloc] init];' % (i, i)
+        print >>out, '  [o setCount:[o count] + k];'
+        print >>out, '  return k ? [self combine:o with:k - 1] : other;'
+        print >>out, '}'
+        print >>out, '@end'
+
+def generatePCHHeader(out, n):
+    for i in range(n):
+        print >>out, ('typedef struct S%d { int a; double b; '
+                      'struct S%d *n; } S%d;' % (i, i, i))
+        print >>out, 'extern S%d v%d;' % (i, i)
+        print >>out, 'int fn%d(S%d *s, int k);' % (i, i)
+        print >>out, ('static inline int in%d(int x) '
+                      '{ return x * %d + 1; }' % (i, i))
+        print >>out, 'enum E%d { E%d_A, E%d_B = %d };' % (i, i, i, i)
+
+def generatePCHUser(out, n):
+    for i in range(0, n, 7):
+        print >>out, ('int use%d(void) { return fn%d(&v%d, in%d(E%d_B)); }'
+                      % (i, i, i, i, i))
+
+def generateAnalyzer(out, n):
+    print >>out, 'void *malloc(unsigned long);'
+    print >>out, 'void free(void *);'
+    for i in range(n):
+        print >>out, 'int a%d(int *p, int x, int y) {' % i
+        print >>out, '  int r = 0, dead;'
+        print >>out, '  char *m = malloc(x);'
+        print >>out, '  if (x > y) r = *p; else if (x < 0) r = -x;'
+        print >>out, '  for (int i = 0; i < y; ++i)'
+        print >>out, '    if (i == x) break; else r += i;'
+        print >>out, '  switch (r & 3) {'
+        print >>out, '  case 0: dead = r; r = 1; break;'
+        print >>out, '  case 1: r = 2; break;'
+        print >>out, '  default: break;'
+        print >>out, '  }'
+        print >>out, '  if (m) free(m);'
+        print >>out, '  return r;'
+        print >>out, '}'
+
+###
+
+class Benchmark:
+    def __init__(self, name, files, args):
+        # files: [(file name, generator, scale multiplier)]
+        self.name = name
+        self.files = files
+        self.args = args
+
+BENCHMARKS = [
+    Benchmark('preprocessor-c',
+              [('pp.c', generatePreprocessorC, 400)],
+              ['-fsyntax-only', 'pp.c']),
+    Benchmark('templates-cxx',
+              [('templates.cpp', generateTemplatesCXX, 200)],
+              ['-fsyntax-only', '-x', 'c++', 'templates.cpp']),
+    Benchmark('objc',
+              [('objc.m', generateObjC, 300)],
+              ['-fsyntax-only', '-x', 'objective-c', 'objc.m']),
+    Benchmark('pch-build',
+              [('pch.h', generatePCHHeader, 600)],
+              ['-x', 'c-header', '-emit-pch', '-o', 'pch.h.pch', 'pch.h']),
+    Benchmark('pch-load',
+              [('user.c', generatePCHUser, 600)],
+              ['-include-pch', 'pch.h.pch', '-fsyntax-only', 'user.c']),
+    Benchmark('code-completion',
+              [('templates.cpp', generateTemplatesCXX, 200)],
+              ['-fsyntax-only', '-x', 'c++',
+               '-code-completion-at=templates.cpp:14:1', 'templates.cpp']),
+    Benchmark('analyzer',
+              [('analyze.c', generateAnalyzer, 150)],
+              ['-analyze', '-analyzer-check-dead-stores',
+               '-analyzer-check-objc-mem', '-std=c99', 'analyze.c']),
+]
+
+###
+
+def collectPhases(phase, name, times, memory):
+    # Record the translation unit and its top-level phases, whose names do
+    # not depend on the corpus.
+    times[name] = times.get(name, 0.0) + phase['wall']
+    memory[name] = max(memory.get(name, 0), phase['memory'])
+
+def runBenchmark(clang, dir, b, runs):
+    statsPath = os.path.join(dir, b.name + '.stats')
+    best = None
+    for i in range(runs):
+        args = [clang, '-cc1', '-phase-stats-file', statsPath] + b.args
+        p = subprocess.Popen(args, cwd=dir,
+                             stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out, err = p.communicate()
+        if p.returncode != 0:
+            raise SystemExit('error: benchmark %r failed:\n%s' % (b.name, err))
+
+        times, memory = {}, {}
+        for record in json.load(open(statsPath)):
+            root = record['phases']
+            collectPhases(root, 'total', times, memory)
+            for child in root.get('children', []):
+                collectPhases(child, child['name'], times, memory)
+
+        # Keep the fastest run, which has the least noise from the system.
+        if best is None or times['total'] < best['time']['total']:
+            best = { 'time' : times, 'memory' : memory }
+    return best
+
+def compare(results, baseline, timeTolerance, memoryTolerance):
+    regressions = []
+    for name in sorted(results):
+        if name not in baseline:
+            continue
+        for kind, tolerance in (('time', timeTolerance),
+                                ('memory', memoryTolerance)):
+            for phase, value in sorted(results[name][kind].items()):
+                old = baseline[name][kind].get(phase)
+                if old is None or old <= 0:
+                    continue
+                change = (value - old) / float(old)
+                if change > tolerance:
+                    regressions.append((name, phase, kind, old, value, change))
+    return regressions
+
+def formatValue(kind, value):
+    if kind == 'time':
+        return '%.3fs' % value
+    return '%.1f MB' % (value / (1024.0 * 1024.0))
+
+def main():
+    from optparse import OptionParser
+    parser = OptionParser("usage: %prog [options] [benchmarks]")
+    parser.add_option("", "--clang", dest="clang",
+                      help="clang binary to time [%default]",
+                      default='clang')
+    parser.add_option("", "--runs", dest="runs", type=int,
+                      help="number of timed runs per benchmark [%default]",
+                      default=5)
+    parser.add_option("", "--scale", dest="scale", type=float,
+                      help="scale of the generated corpus [%default]",
+                      default=1.0)
+    parser.add_option("", "--baseline", dest="baseline",
+                      help="compare the results against this baseline",
+                      default=None)
+    parser.add_option("", "--save-baseline", dest="saveBaseline",
+                      help="save the results as a baseline",
+                      default=None)
+    parser.add_option("", "--time-tolerance", dest="timeTolerance",
+                      type=float, default=0.05,
+                      help="allowed relative slowdown of a phase [%default]")
+    parser.add_option("", "--memory-tolerance", dest="memoryTolerance",
+                      type=float, default=0.05,
+                      help="allowed relative memory growth of a phase "
+                           "[%default]")
+    parser.add_option("", "--list", dest="list", action="store_true",
+                      help="list the benchmarks and exit", default=False)
+    opts, args = parser.parse_args()
+
+    if opts.list:
+        for b in BENCHMARKS:
+            print b.name
+        return
+
+    benchmarks = BENCHMARKS
+    if args:
+        benchmarks = [b for b in BENCHMARKS if b.name in args]
+        unknown = set(args) - set([b.name for b in benchmarks])
+        if unknown:
+            parser.error("unknown benchmarks: %s" % ', '.join(sorted(unknown)))
+
+    # pch-load needs the PCH file built by pch-build.
+    names = [b.name for b in benchmarks]
+    if 'pch-load' in names and 'pch-build' not in names:
+        benchmarks.insert(0, [b for b in BENCHMARKS
+                              if b.name == 'pch-build'][0])
+
+    dir = tempfile.mkdtemp(prefix='clang-perf-')
+    results = {}
+    try:
+        for b in benchmarks:
+            for fileName, generate, size in b.files:
+                out = open(os.path.join(dir, fileName), 'w')
+                generate(out, max(1, int(size * opts.scale)))
+                out.close()
+            results[b.name] = runBenchmark(opts.clang, dir, b, opts.runs)
+            r = results[b.name]
+            print '%-20s %8s %10s' % (b.name,
+                                      formatValue('time', r['time']['total']),
+                                      formatValue('memory',
+                                                  r['memory']['total']))
+            for phase, value in sorted(r['time'].items()):
+                if phase != 'total':
+                    print '  %-18s %8s' % (phase, formatValue('time', value))
+    finally:
+        shutil.rmtree(dir)
+
+    if opts.saveBaseline:
+        f = open(opts.saveBaseline, 'w')
+        json.dump({ 'scale' : opts.scale, 'results' : results }, f,
+                  indent=2, sort_keys=True)
+        f.close()
+
+    if opts.baseline:
+        baseline = json.load(open(opts.baseline))
+        if baseline.get('scale') != opts.scale:
+            raise SystemExit('error: baseline was recorded with --scale=%s' %
+                             baseline.get('scale'))
+        regressions = compare(results, baseline['results'],
+                              opts.timeTolerance, opts.memoryTolerance)
+        for name, phase, kind, old, new, change in regressions:
+            print 'REGRESSION: %s: %s %s: %s -> %s (+%.1f%%)' % (
+                name, phase, kind, formatValue(kind, old),
+                formatValue(kind, new), change * 100)
+        if regressions:
+            sys.exit(1)
+        print 'No regressions against %s.' % opts.baseline
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+
+"""
+Lexer microbenchmark.
+
+Generates a synthetic translation unit that stresses the lexer's hot loops
+(long identifiers, deep indentation, '//' comments and '#pragma mark' lines)
+and times 'clang -cc1 -Eonly' over it.  Run it against two builds of clang to
+compare them:
+
+  lexer-bench.py --clang=/path/to/old/clang --clang=/path/to/new/clang
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+###
+
+def generateSource(out, lines, identLength, indent):
+    ident = ('abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789'
+             * (1 + identLength // 64))[:identLength]
+    pad = ' ' * indent
+    for i in range(lines):
+        kind = i % 4
+        if kind == 0:
+            print >>out, '%sint %s_%d = %s_%d;' % (pad, ident, i, ident, i)
+        elif kind == 1:
+            print >>out, '%s// %s %s %s' % (pad, ident, ident, ident)
+        elif kind == 2:
+            print >>out, '%s\t\t/* %s */ int x_%d;' % (pad, ident, i)
+        else:
+            print >>out, '#pragma mark %s %s' % (ident, ident)
+
+def timeRun(clang, path, runs):
+    best = None
+    for i in range(runs):
+        start = time.time()
+        p = subprocess.Popen([clang, '-cc1', '-Eonly', path],
+                             stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        p.communicate()
+        elapsed = time.time() - start
+        if p.returncode != 0:
+            raise SystemExit('error: %r failed on %r' % (clang, path))
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+def main():
+    from optparse import OptionParser
+    parser = OptionParser("usage: %prog [options]")
+    parser.add_option("", "--clang", dest="clangs", action="append",
+                      help="clang binary to time (may be repeated)",
+                      default=[])
+    parser.add_option("", "--lines", dest="lines", type=int,
+                      help="number of generated source lines [%default]",
+                      default=200000)
+    parser.add_option("", "--ident-length", dest="identLength", type=int,
+                      help="length of generated identifiers [%default]",
+                      default=48)
+    parser.add_option("", "--indent", dest="indent", type=int,
+                      help="columns of leading indentation [%default]",
+                      default=24)
+    parser.add_option("", "--runs", dest="runs", type=int,
+                      help="number of timed runs per binary [%default]",
+                      default=5)
+    opts, args = parser.parse_args()
+    if args:
+        parser.error("unexpected arguments")
+    if not opts.clangs:
+        opts.clangs = ['clang']
+
+    fd, path = tempfile.mkstemp(suffix='.c')
+    try:
+        out = os.fdopen(fd, 'w')
+        generateSource(out, opts.lines, opts.identLength, opts.indent)
+        out.close()
+
+        size = os.path.getsize(path)
+        print '%d lines, %.1f MB' % (opts.lines, size / (1024.0 * 1024.0))
+        for clang in opts.clangs:
+            t = timeRun(clang, path, opts.runs)
+            print '%-40s %8.3fs  %8.1f MB/s' % (clang, t,
+                                                size / (1024.0 * 1024.0) / t)
+    finally:
+        os.remove(path)
+
+if __name__ == '__main__':
+    main()